@@ -34,6 +34,10 @@ pub enum DataError {
     /// Hex contains invalid characters, odd length, etc.
     #[error("Invalid hex: {0}")]
     InvalidHex(hex::FromHexError),
+
+    /// A VARINT doesn't fit in 64 bits.
+    #[error("VARINT is too large")]
+    VarIntTooLarge,
 }
 
 impl Eq for DataError {}
@@ -1,6 +1,8 @@
 use bytes::{BufMut, Bytes, BytesMut};
 
 use crate::{
+    bytes::read_array,
+    error::DataError,
     hash::Hashed,
     script::{PubKey, PubKeyVariant, ScriptVariant, UncompressedPubKey},
 };
@@ -71,6 +73,25 @@ pub fn write_var_int(bytes: &mut BytesMut, mut n: u64) {
     }
 }
 
+/// Read a VARINT, as written by [`write_var_int`].
+pub fn read_var_int(bytes: &mut Bytes) -> Result<u64, DataError> {
+    let mut n = 0u64;
+    loop {
+        let ch = read_array::<1>(bytes)?[0];
+        if n > u64::MAX >> 7 {
+            return Err(DataError::VarIntTooLarge);
+        }
+        n = (n << 7) | (ch & 0x7F) as u64;
+        if ch & 0x80 == 0 {
+            return Ok(n);
+        }
+        if n == u64::MAX {
+            return Err(DataError::VarIntTooLarge);
+        }
+        n += 1;
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use bytes::{Bytes, BytesMut};
@@ -79,8 +100,9 @@ mod tests {
         error::DataError,
         hash::{Hashed, ShaRmd160},
         script::{
-            compress::write_var_int, compress_script_variant, PubKey,
-            PubKeyVariant, Script, ScriptVariant, UncompressedPubKey,
+            compress::{read_var_int, write_var_int},
+            compress_script_variant, PubKey, PubKeyVariant, Script,
+            ScriptVariant, UncompressedPubKey,
         },
     };
 
@@ -102,6 +124,24 @@ mod tests {
         assert_eq!(varint_hex(0xffffffff), "8efefefe7f");
         assert_eq!(varint_hex(0x7fffffffffffffff), "fefefefefefefefe7f");
         assert_eq!(varint_hex(0xffffffffffffffff), "80fefefefefefefefe7f");
+
+        for n in [0, 0x7f, 0x80, 0x1234, 0xffffffff, 0xffffffffffffffff] {
+            let mut bytes = BytesMut::new();
+            write_var_int(&mut bytes, n);
+            assert_eq!(read_var_int(&mut bytes.freeze()), Ok(n));
+        }
+        let mut bytes = Bytes::from_static(&[
+            0x80, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xff, 0x00,
+        ]);
+        assert_eq!(read_var_int(&mut bytes), Err(DataError::VarIntTooLarge));
+        let mut bytes = Bytes::from(vec![0x80]);
+        assert_eq!(
+            read_var_int(&mut bytes),
+            Err(DataError::InvalidLength {
+                expected: 1,
+                actual: 0,
+            }),
+        );
     }
 
     #[test]
@@ -58,6 +58,36 @@ mod ffi_inner {
         pub txs: Vec<BlockTx>,
     }
 
+    /// Block as stored on disk by the node, so Chronik can parse the txs
+    /// without having the node build and bridge a CBlock and CBlockUndo.
+    #[derive(Clone, Debug, Default, Eq, PartialEq)]
+    pub struct RawBlock {
+        /// Block hash
+        pub hash: [u8; 32],
+        /// hashPrevBlock, hash of the previous block in the chain
+        pub prev_hash: [u8; 32],
+        /// nBits, difficulty of the header
+        pub n_bits: u32,
+        /// Timestamp of the block
+        pub timestamp: i64,
+        /// Height of the block in the chain.
+        pub height: i32,
+        /// File number of the block file this block is stored in.
+        pub file_num: u32,
+        /// Position of the block within the block file, starting at the block
+        /// header.
+        pub data_pos: u32,
+        /// Position of the undo data within the undo file.
+        pub undo_pos: u32,
+        /// Size of the serialized header (including any AuxPoW), i.e. the
+        /// offset of the tx count within `data`.
+        pub header_size: u32,
+        /// Serialized block
+        pub data: Vec<u8>,
+        /// Serialized CBlockUndo, empty for the genesis block.
+        pub undo: Vec<u8>,
+    }
+
     /// Tx in a block
     #[derive(Clone, Debug, Default, Eq, PartialEq)]
     pub struct BlockTx {
@@ -246,6 +276,13 @@ mod ffi_inner {
             block_index: &CBlockIndex,
         ) -> Result<UniquePtr<CBlockUndo>>;
 
+        /// Load the serialized block and undo data of this CBlockIndex from
+        /// the disk, without deserializing the txs.
+        fn load_raw_block(
+            self: &ChronikBridge,
+            block_index: &CBlockIndex,
+        ) -> Result<RawBlock>;
+
         /// Load the CTransaction and CTxUndo data from disk and turn it into a
         /// bridged Tx, containing spent coins etc.
         fn load_tx(
@@ -202,10 +202,12 @@ ChronikBridge::lookup_block_index(std::array<uint8_t, 32> hash) const {
 
 const CBlockIndex &
 ChronikBridge::lookup_block_index_by_height(int height) const {
-    // The boundary check is performed in the CChain::operator[](int nHeight)
-    // method, a nullptr is returned if height is out of bounds.
-    const CBlockIndex *pindex =
-        WITH_LOCK(cs_main, return m_node.chainman->ActiveChain()[height]);
+    // The boundary check is performed in the
+    // ActiveChainSnapshot::operator[](int nHeight) method, a nullptr is
+    // returned if height is out of bounds. The snapshot indexes the chain by
+    // height, so this doesn't need cs_main.
+    const auto snapshot = m_node.chainman->GetActiveChainSnapshot();
+    const CBlockIndex *pindex = snapshot ? (*snapshot)[height] : nullptr;
     if (!pindex) {
         throw block_index_not_found();
     }
@@ -271,6 +273,41 @@ ChronikBridge::load_block_undo(const CBlockIndex &bindex) const {
     return std::make_unique<CBlockUndo>(std::move(block_undo));
 }
 
+RawBlock ChronikBridge::load_raw_block(const CBlockIndex &bindex) const {
+    const node::BlockManager &blockman = m_node.chainman->m_blockman;
+    std::vector<uint8_t> data;
+    // This also checks the block hash (and PoW, if needed) against the index
+    if (!blockman.ReadRawBlockFromDisk(data, bindex)) {
+        throw std::runtime_error("Reading block data failed");
+    }
+    // Only the header is deserialized, its size depends on the AuxPoW
+    CBlockHeader header;
+    SpanReader reader{SER_DISK, CLIENT_VERSION, data};
+    reader >> header;
+    const size_t header_size = data.size() - reader.size();
+
+    std::vector<uint8_t> undo;
+    // Read undo data (genesis block doesn't have undo data)
+    if (bindex.nHeight > 0 && !blockman.ReadRawUndoFromDisk(undo, bindex)) {
+        throw std::runtime_error("Reading block undo data failed");
+    }
+
+    LOCK(cs_main);
+    return {
+        .hash = chronik::util::HashToArray(bindex.GetBlockHash()),
+        .prev_hash = chronik::util::HashToArray(header.hashPrevBlock),
+        .n_bits = header.nBits,
+        .timestamp = header.GetBlockTime(),
+        .height = bindex.nHeight,
+        .file_num = uint32_t(bindex.nFile),
+        .data_pos = bindex.nDataPos,
+        .undo_pos = bindex.nUndoPos,
+        .header_size = uint32_t(header_size),
+        .data = chronik::util::ToRustVec<uint8_t>(data),
+        .undo = chronik::util::ToRustVec<uint8_t>(undo),
+    };
+}
+
 Tx ChronikBridge::load_tx(uint32_t file_num, uint32_t data_pos,
                           uint32_t undo_pos) const {
     CMutableTransaction tx;
@@ -80,6 +80,8 @@ public:
     std::unique_ptr<CBlockUndo>
     load_block_undo(const CBlockIndex &bindex) const;
 
+    RawBlock load_raw_block(const CBlockIndex &bindex) const;
+
     Tx load_tx(uint32_t file_num, uint32_t data_pos, uint32_t undo_pos) const;
 
     rust::Vec<uint8_t> load_raw_tx(uint32_t file_num, uint32_t data_pos) const;
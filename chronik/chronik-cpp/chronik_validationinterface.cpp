@@ -66,6 +66,8 @@ private:
                           const std::shared_ptr<const CBlock> &block) override {
         m_chronik->handle_block_invalidated(*block, *pindex);
     }
+
+    std::string GetSubscriberName() const override { return "chronik"; }
 };
 
 std::unique_ptr<ChronikValidationInterface> g_chronik_validation_interface;
@@ -12,7 +12,7 @@ use bitcoinsuite_core::{
     tx::{Tx, TxId},
 };
 use bytes::Bytes;
-use chronik_bridge::{ffi, util::expect_unique_ptr};
+use chronik_bridge::ffi;
 use chronik_db::{
     db::{Db, WriteBatch},
     groups::{
@@ -45,6 +45,7 @@ use crate::{
     avalanche::Avalanche,
     indexer::ChronikIndexerError::*,
     merkle::BlockMerkleTree,
+    raw_block::parse_raw_block_txs,
     query::{
         QueryBlocks, QueryBroadcast, QueryGroupHistory, QueryGroupUtxos,
         QueryPlugins, QueryTxs, UtxoProtobufOutput, UtxoProtobufValue,
@@ -1080,19 +1081,62 @@ impl ChronikIndexer {
         }
     }
 
+    /// Build a ChronikBlock from a ffi::RawBlock, parsing the txs from the
+    /// serialized block and undo data.
+    pub fn make_chronik_block_from_raw(
+        &self,
+        block: ffi::RawBlock,
+    ) -> Result<ChronikBlock> {
+        let db_block = DbBlock {
+            hash: BlockHash::from(block.hash),
+            prev_hash: BlockHash::from(block.prev_hash),
+            height: block.height,
+            n_bits: block.n_bits,
+            timestamp: block.timestamp,
+            file_num: block.file_num,
+            data_pos: block.data_pos,
+        };
+        let size = block.data.len() as u64;
+        let raw_txs = parse_raw_block_txs(block, self.decompress_script_fn)?;
+        let block_txs = BlockTxs {
+            block_height: db_block.height,
+            txs: raw_txs
+                .iter()
+                .map(|raw_tx| {
+                    let txid = raw_tx.tx.txid();
+                    TxEntry {
+                        txid,
+                        data_pos: raw_tx.data_pos,
+                        undo_pos: raw_tx.undo_pos,
+                        time_first_seen: match self.mempool.tx(&txid) {
+                            Some(tx) => tx.time_first_seen,
+                            None => 0,
+                        },
+                        is_coinbase: raw_tx.undo_pos == 0,
+                    }
+                })
+                .collect(),
+        };
+        let txs = raw_txs.into_iter().map(|raw_tx| raw_tx.tx).collect();
+        Ok(ChronikBlock {
+            db_block,
+            block_txs,
+            size,
+            txs,
+        })
+    }
+
     /// Load a ChronikBlock from the node given the CBlockIndex.
+    ///
+    /// The node only reads the block and undo data from disk, the txs are
+    /// parsed here, so it doesn't have to build and bridge a CBlock first.
     pub fn load_chronik_block(
         &self,
         bridge: &ffi::ChronikBridge,
         block_index: &ffi::CBlockIndex,
     ) -> Result<ChronikBlock> {
-        let ffi_block = bridge.load_block(block_index)?;
-        let ffi_block = expect_unique_ptr("load_block", &ffi_block);
-        let ffi_block_undo = bridge.load_block_undo(block_index)?;
-        let ffi_block_undo =
-            expect_unique_ptr("load_block_undo", &ffi_block_undo);
-        let block = ffi::bridge_block(ffi_block, ffi_block_undo, block_index)?;
-        Ok(self.make_chronik_block(block))
+        let raw_block = bridge.load_raw_block(block_index)?;
+        self.make_chronik_block_from_raw(raw_block)
     }
 }
 
@@ -10,6 +10,7 @@ abc_rust_lint::lint! {
     pub mod indexer;
     pub mod pause;
     pub mod query;
+    pub mod raw_block;
     pub mod subs;
     pub mod merkle;
 }
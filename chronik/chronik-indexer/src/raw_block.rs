@@ -0,0 +1,410 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+//! Module for parsing the [`ffi::RawBlock`]s loaded from the node's block and
+//! undo files.
+//!
+//! This way, the node only has to read the files, and we build the [`Tx`]s
+//! directly from the serialized data, with the scripts referencing the block
+//! data rather than being copied around.
+
+use abc_rust_error::Result;
+use bitcoinsuite_core::{
+    bytes::{read_array, read_bytes},
+    hash::{Hashed, Sha256d, ShaRmd160},
+    script::{
+        opcode::OP_RETURN, read_var_int, PubKey, Script, ScriptMut,
+        COMPRESS_NUM_SPECIAL_SCRIPTS,
+    },
+    ser::{read_compact_size, BitcoinSer},
+    tx::{Coin, Tx, TxId, TxMut, TxOutput},
+};
+use bytes::Bytes;
+use chronik_bridge::ffi;
+use thiserror::Error;
+
+use crate::{indexer::DecompressScriptFn, raw_block::RawBlockError::*};
+
+/// MAX_SCRIPT_SIZE from script/script.h, longer scripts in the undo data
+/// have been replaced by OP_RETURN.
+const MAX_SCRIPT_SIZE: usize = 10_000;
+
+/// Tx parsed from a [`ffi::RawBlock`].
+#[derive(Clone, Debug, Default, Eq, PartialEq)]
+pub struct RawBlockTx {
+    /// Tx, with the coins spent by its inputs.
+    pub tx: Tx,
+    /// Where the tx is stored within the block file.
+    pub data_pos: u32,
+    /// Where the tx's undo data is stored within the undo file, 0 for the
+    /// coinbase tx.
+    pub undo_pos: u32,
+}
+
+/// Errors for [`parse_raw_block_txs`].
+#[derive(Debug, Error, PartialEq, Eq)]
+pub enum RawBlockError {
+    /// The header size is larger than the block itself
+    #[error("Invalid header size {header_size} for block of size {size}")]
+    InvalidHeaderSize {
+        /// Size of the header
+        header_size: usize,
+        /// Size of the block
+        size: usize,
+    },
+
+    /// A block must at least have a coinbase tx
+    #[error("Block has no txs")]
+    NoTxs,
+
+    /// Undo data doesn't match the txs of the block
+    #[error("Undo data has {actual} txs, expected {expected}")]
+    UndoTxCountMismatch {
+        /// Number of non-coinbase txs in the block
+        expected: usize,
+        /// Number of txs in the undo data
+        actual: usize,
+    },
+
+    /// Undo data doesn't match the inputs of a tx
+    #[error("Undo data of tx {tx_idx} has {actual} coins, expected {expected}")]
+    UndoCoinCountMismatch {
+        /// Index of the tx in the block
+        tx_idx: usize,
+        /// Number of inputs of the tx
+        expected: usize,
+        /// Number of coins in the undo data
+        actual: usize,
+    },
+}
+
+/// Parse the txs of the block, and fill in the spent coins from the undo data.
+pub fn parse_raw_block_txs(
+    block: ffi::RawBlock,
+    decompress_script: DecompressScriptFn,
+) -> Result<Vec<RawBlockTx>> {
+    let data = Bytes::from(block.data);
+    let header_size = block.header_size as usize;
+    if header_size > data.len() {
+        return Err(InvalidHeaderSize {
+            header_size,
+            size: data.len(),
+        }
+        .into());
+    }
+    let mut remaining = data.slice(header_size..);
+    let num_txs = read_compact_size(&mut remaining)? as usize;
+    if num_txs == 0 {
+        return Err(NoTxs.into());
+    }
+
+    // The coinbase tx has no undo data, neither does the genesis block
+    let mut undo = Bytes::from(block.undo);
+    let undo_size = undo.len();
+    let num_undo_txs = match block.height {
+        0 => 0,
+        _ => read_compact_size(&mut undo)? as usize,
+    };
+    if num_undo_txs != num_txs - 1 {
+        return Err(UndoTxCountMismatch {
+            expected: num_txs - 1,
+            actual: num_undo_txs,
+        }
+        .into());
+    }
+
+    let mut txs = Vec::with_capacity(num_txs.min(remaining.len()));
+    for tx_idx in 0..num_txs {
+        let data_offset = data.len() - remaining.len();
+        let mut tx = TxMut::deser(&mut remaining)?;
+        // Hash the tx as it is serialized in the block, no need to
+        // re-serialize it
+        let txid = TxId::from(Sha256d::digest(
+            data.slice(data_offset..data.len() - remaining.len()),
+        ));
+
+        let mut undo_pos = 0;
+        if tx_idx == 0 {
+            for input in &mut tx.inputs {
+                input.coin = Some(Coin::default());
+            }
+        } else {
+            undo_pos = block.undo_pos + (undo_size - undo.len()) as u32;
+            let num_coins = read_compact_size(&mut undo)? as usize;
+            if num_coins != tx.inputs.len() {
+                return Err(UndoCoinCountMismatch {
+                    tx_idx,
+                    expected: tx.inputs.len(),
+                    actual: num_coins,
+                }
+                .into());
+            }
+            for input in &mut tx.inputs {
+                let coin = read_undo_coin(&mut undo, decompress_script)?;
+                input.coin = Some(coin);
+            }
+        }
+
+        txs.push(RawBlockTx {
+            tx: Tx::with_txid(txid, tx),
+            data_pos: block.data_pos + data_offset as u32,
+            undo_pos,
+        });
+    }
+    Ok(txs)
+}
+
+/// Read a coin as serialized by TxInUndoFormatter in undo.h.
+fn read_undo_coin(
+    undo: &mut Bytes,
+    decompress_script: DecompressScriptFn,
+) -> Result<Coin> {
+    let code = read_var_int(undo)?;
+    let height = code / 2;
+    if height > 0 {
+        // Dummy tx version, kept for compatibility
+        read_var_int(undo)?;
+    }
+    let value = decompress_amount(read_var_int(undo)?);
+    let script = read_compressed_script(undo, decompress_script)?;
+    Ok(Coin {
+        output: TxOutput { value, script },
+        height: height as i32,
+        is_coinbase: code & 1 == 1,
+    })
+}
+
+/// Same as DecompressAmount in compressor.cpp.
+fn decompress_amount(mut x: u64) -> i64 {
+    // x = 0  OR  x = 1+10*(9*n + d - 1) + e  OR  x = 1+10*(n - 1) + 9
+    if x == 0 {
+        return 0;
+    }
+    x -= 1;
+    // x = 10*(9*n + d - 1) + e
+    let mut e = x % 10;
+    x /= 10;
+    let mut n = if e < 9 {
+        // x = 9*n + d - 1
+        let d = (x % 9) + 1;
+        x /= 9;
+        // x = n
+        x.wrapping_mul(10).wrapping_add(d)
+    } else {
+        x + 1
+    };
+    while e > 0 {
+        n = n.wrapping_mul(10);
+        e -= 1;
+    }
+    n as i64
+}
+
+/// Read a script as serialized by ScriptCompression in compressor.h.
+fn read_compressed_script(
+    undo: &mut Bytes,
+    decompress_script: DecompressScriptFn,
+) -> Result<Script> {
+    let size = read_var_int(undo)?;
+    let script = match size {
+        0x00 => Script::p2pkh(&ShaRmd160(read_array(undo)?)),
+        0x01 => Script::p2sh(&ShaRmd160(read_array(undo)?)),
+        0x02 | 0x03 => {
+            let mut pubkey = [0; PubKey::SIZE];
+            pubkey[0] = size as u8;
+            pubkey[1..].copy_from_slice(&read_array::<32>(undo)?);
+            Script::p2pk(&PubKey(pubkey))
+        }
+        0x04 | 0x05 => {
+            // Uncompressing the pubkey needs secp256k1, leave it to the node
+            let mut compressed = [0; 33];
+            compressed[0] = size as u8;
+            compressed[1..].copy_from_slice(&read_array::<32>(undo)?);
+            Script::new(decompress_script(&compressed)?.into())
+        }
+        _ => {
+            let size = (size - COMPRESS_NUM_SPECIAL_SCRIPTS as u64) as usize;
+            let bytecode = read_bytes(undo, size)?;
+            if size > MAX_SCRIPT_SIZE {
+                let mut script = ScriptMut::with_capacity(1);
+                script.put_opcodes([OP_RETURN]);
+                script.freeze()
+            } else {
+                Script::new(bytecode)
+            }
+        }
+    };
+    Ok(script)
+}
+
+#[cfg(test)]
+mod tests {
+    use abc_rust_error::Result;
+    use bitcoinsuite_core::{
+        hash::{Hashed, ShaRmd160},
+        script::{write_var_int, Script},
+        ser::BitcoinSer,
+        tx::{Coin, OutPoint, Tx, TxId, TxInput, TxMut, TxOutput},
+    };
+    use bytes::{BufMut, BytesMut};
+    use chronik_bridge::ffi;
+
+    use crate::raw_block::{
+        decompress_amount, parse_raw_block_txs, RawBlockError, RawBlockTx,
+    };
+
+    fn no_decompress(_: &[u8]) -> Result<Vec<u8>> {
+        unreachable!("Test doesn't use uncompressed pubkeys")
+    }
+
+    #[test]
+    fn test_decompress_amount() {
+        // see src/test/compress_tests.cpp
+        assert_eq!(decompress_amount(0x0), 0);
+        assert_eq!(decompress_amount(0x1), 1);
+        assert_eq!(decompress_amount(0x7), 1_000_000);
+        assert_eq!(decompress_amount(0x9), 100_000_000);
+        assert_eq!(decompress_amount(0x32), 5_000_000_000);
+        assert_eq!(decompress_amount(0x1406f40), 2_100_000_000_000_000);
+    }
+
+    #[test]
+    fn test_parse_raw_block_txs() -> Result<()> {
+        let coinbase = TxMut {
+            version: 1,
+            inputs: vec![TxInput {
+                prev_out: OutPoint {
+                    txid: TxId::default(),
+                    out_idx: u32::MAX,
+                },
+                script: Script::new(vec![0x51].into()),
+                sequence: u32::MAX,
+                coin: None,
+            }],
+            outputs: vec![TxOutput {
+                value: 5_000_000_000,
+                script: Script::new(vec![0x51].into()),
+            }],
+            locktime: 0,
+        };
+        let tx = TxMut {
+            version: 1,
+            inputs: vec![
+                TxInput {
+                    prev_out: OutPoint {
+                        txid: TxId::from([4; 32]),
+                        out_idx: 0,
+                    },
+                    ..Default::default()
+                },
+                TxInput {
+                    prev_out: OutPoint {
+                        txid: TxId::from([5; 32]),
+                        out_idx: 7,
+                    },
+                    ..Default::default()
+                },
+            ],
+            outputs: vec![TxOutput {
+                value: 1234,
+                script: Script::new(vec![0x6a].into()),
+            }],
+            locktime: 0,
+        };
+
+        // Fake header, only its size matters
+        let header = [0u8; 80];
+        let mut data = BytesMut::new();
+        data.put_slice(&header);
+        data.put_u8(2);
+        data.put_slice(&coinbase.ser());
+        data.put_slice(&tx.ser());
+
+        let p2pkh_hash = ShaRmd160::digest([1]);
+        let mut undo = BytesMut::new();
+        undo.put_u8(1); // undo txs
+        undo.put_u8(2); // coins
+        // 100_000_000 sats from height 10, coinbase, P2PKH
+        write_var_int(&mut undo, 10 * 2 + 1);
+        write_var_int(&mut undo, 0);
+        write_var_int(&mut undo, 0x9);
+        write_var_int(&mut undo, 0x00);
+        undo.put_slice(p2pkh_hash.as_le_bytes());
+        // 1 sat from height 0, non-coinbase, other script
+        write_var_int(&mut undo, 0);
+        write_var_int(&mut undo, 0x1);
+        write_var_int(&mut undo, 2 + 6);
+        undo.put_slice(&[0x51, 0x87]);
+
+        let raw_block = ffi::RawBlock {
+            height: 11,
+            data_pos: 1000,
+            undo_pos: 2000,
+            header_size: header.len() as u32,
+            data: data.to_vec(),
+            undo: undo.to_vec(),
+            ..Default::default()
+        };
+        let txs = parse_raw_block_txs(raw_block.clone(), no_decompress)?;
+
+        let mut expected_coinbase = coinbase.clone();
+        expected_coinbase.inputs[0].coin = Some(Coin::default());
+        let mut expected_tx = tx.clone();
+        expected_tx.inputs[0].coin = Some(Coin {
+            output: TxOutput {
+                value: 100_000_000,
+                script: Script::p2pkh(&p2pkh_hash),
+            },
+            height: 10,
+            is_coinbase: true,
+        });
+        expected_tx.inputs[1].coin = Some(Coin {
+            output: TxOutput {
+                value: 1,
+                script: Script::new(vec![0x51, 0x87].into()),
+            },
+            height: 0,
+            is_coinbase: false,
+        });
+        let coinbase_pos = 1000 + header.len() as u32 + 1;
+        assert_eq!(
+            txs,
+            vec![
+                RawBlockTx {
+                    tx: Tx::with_txid(
+                        TxId::from_tx(&coinbase),
+                        expected_coinbase,
+                    ),
+                    data_pos: coinbase_pos,
+                    undo_pos: 0,
+                },
+                RawBlockTx {
+                    tx: Tx::with_txid(TxId::from_tx(&tx), expected_tx),
+                    data_pos: coinbase_pos + coinbase.ser_len() as u32,
+                    undo_pos: 2000 + 1,
+                },
+            ],
+        );
+
+        // Undo data of the wrong block
+        let mut bad_block = raw_block.clone();
+        bad_block.undo = vec![0];
+        assert_eq!(
+            parse_raw_block_txs(bad_block, no_decompress)
+                .unwrap_err()
+                .downcast::<RawBlockError>()?,
+            RawBlockError::UndoTxCountMismatch {
+                expected: 1,
+                actual: 0,
+            },
+        );
+
+        // Truncated undo data
+        let mut bad_block = raw_block;
+        bad_block.undo.pop();
+        assert!(parse_raw_block_txs(bad_block, no_decompress).is_err());
+
+        Ok(())
+    }
+}
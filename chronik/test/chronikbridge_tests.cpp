@@ -214,6 +214,51 @@ BOOST_FIXTURE_TEST_CASE(test_load_block, TestChain100Setup) {
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(test_load_raw_block, TestChain100Setup) {
+    const chronik_bridge::ChronikBridge bridge(m_node);
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    const CBlockIndex &tip =
+        WITH_LOCK(chainman.GetMutex(), return *chainman.ActiveTip());
+
+    for (const CBlockIndex *pindex : {&tip, tip.GetAncestor(0)}) {
+        const std::unique_ptr<CBlock> block = bridge.load_block(*pindex);
+        const std::unique_ptr<CBlockUndo> block_undo =
+            bridge.load_block_undo(*pindex);
+        const chronik_bridge::Block bridged =
+            chronik_bridge::bridge_block(*block, *block_undo, *pindex);
+        const chronik_bridge::RawBlock raw_block =
+            bridge.load_raw_block(*pindex);
+
+        BOOST_CHECK(raw_block.hash == bridged.hash);
+        BOOST_CHECK(raw_block.prev_hash == bridged.prev_hash);
+        BOOST_CHECK_EQUAL(raw_block.n_bits, bridged.n_bits);
+        BOOST_CHECK_EQUAL(raw_block.timestamp, bridged.timestamp);
+        BOOST_CHECK_EQUAL(raw_block.height, bridged.height);
+        BOOST_CHECK_EQUAL(raw_block.file_num, bridged.file_num);
+        BOOST_CHECK_EQUAL(raw_block.data_pos, bridged.data_pos);
+        BOOST_CHECK_EQUAL(raw_block.undo_pos, bridged.undo_pos);
+        BOOST_CHECK_EQUAL(raw_block.data.size(), bridged.size);
+        BOOST_REQUIRE(!bridged.txs.empty());
+        // The first tx follows the header and the tx count
+        BOOST_CHECK_EQUAL(bridged.txs[0].data_pos,
+                          raw_block.data_pos + raw_block.header_size + 1);
+
+        CDataStream expected(SER_NETWORK, PROTOCOL_VERSION);
+        expected << *block;
+        BOOST_CHECK_EQUAL(
+            HexStr({raw_block.data.data(), raw_block.data.size()}),
+            HexStr(expected));
+
+        CDataStream expected_undo(SER_NETWORK, PROTOCOL_VERSION);
+        if (pindex->nHeight > 0) {
+            expected_undo << *block_undo;
+        }
+        BOOST_CHECK_EQUAL(
+            HexStr({raw_block.undo.data(), raw_block.undo.size()}),
+            HexStr(expected_undo));
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE(test_get_block_ancestor, TestChain100Setup) {
     ChainstateManager &chainman = *Assert(m_node.chainman);
     const CBlockIndex &tip =
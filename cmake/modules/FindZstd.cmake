@@ -0,0 +1,68 @@
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#.rst
+# FindZstd
+# --------
+#
+# Find the zstd library. The following
+# components are available::
+#   zstd
+#
+# This will define the following variables::
+#
+#   Zstd_FOUND - system has zstd lib
+#   Zstd_INCLUDE_DIRS - the zstd include directories
+#   Zstd_LIBRARIES - Libraries needed to use zstd
+#   Zstd_VERSION - The library version MAJOR.MINOR.RELEASE
+#
+# And the following imported target::
+#
+#   Zstd::zstd
+
+include(BrewHelper)
+find_brew_prefix(_Zstd_BREW_HINT zstd)
+
+find_package(PkgConfig)
+pkg_check_modules(PC_Zstd QUIET libzstd)
+
+find_path(Zstd_INCLUDE_DIR
+	NAMES zstd.h
+	HINTS ${_Zstd_BREW_HINT}
+	PATHS ${PC_Zstd_INCLUDE_DIRS}
+)
+
+set(Zstd_INCLUDE_DIRS "${Zstd_INCLUDE_DIR}")
+mark_as_advanced(Zstd_INCLUDE_DIR)
+
+if(Zstd_INCLUDE_DIR)
+	include(ExternalLibraryHelper)
+	find_component(Zstd zstd
+		NAMES zstd
+		HINTS ${_Zstd_BREW_HINT}
+		PATHS ${PC_Zstd_LIBRARY_DIRS}
+		INCLUDE_DIRS ${Zstd_INCLUDE_DIRS}
+	)
+
+	file(STRINGS "${Zstd_INCLUDE_DIR}/zstd.h" _Zstd_VERSION_LINES
+		REGEX "^#define ZSTD_VERSION_(MAJOR|MINOR|RELEASE)[ \t]+[0-9]+"
+	)
+	foreach(_part MAJOR MINOR RELEASE)
+		string(REGEX REPLACE ".*ZSTD_VERSION_${_part}[ \t]+([0-9]+).*" "\\1"
+			_Zstd_VERSION_${_part} "${_Zstd_VERSION_LINES}"
+		)
+	endforeach()
+	set(Zstd_VERSION
+		"${_Zstd_VERSION_MAJOR}.${_Zstd_VERSION_MINOR}.${_Zstd_VERSION_RELEASE}"
+	)
+endif()
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Zstd
+	REQUIRED_VARS
+		Zstd_INCLUDE_DIR
+	VERSION_VAR Zstd_VERSION
+	REASON_FAILURE_MESSAGE "if the compressed block storage is not required, it can be skipped by passing -DENABLE_ZSTD=OFF to the cmake command line"
+	HANDLE_COMPONENTS
+)
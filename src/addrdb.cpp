@@ -42,9 +42,9 @@ bool SerializeDB(const CChainParams &chainParams, Stream &stream,
     return true;
 }
 
-template <typename Data>
-bool SerializeFileDB(const CChainParams &chainParams, const std::string &prefix,
-                     const fs::path &path, const Data &data, int version) {
+// Write serialized data to path, through a temporary file
+bool WriteFileDB(const std::string &prefix, const fs::path &path,
+                 const CDataStream &stream) {
     // Generate random temporary filename
     const uint16_t randv{GetRand<uint16_t>()};
     std::string tmpfn = strprintf("%s.%04x", prefix, randv);
@@ -52,7 +52,7 @@ bool SerializeFileDB(const CChainParams &chainParams, const std::string &prefix,
     // open temp output file, and associate with CAutoFile
     fs::path pathTmp = gArgs.GetDataDirNet() / tmpfn;
     FILE *file = fsbridge::fopen(pathTmp, "wb");
-    CAutoFile fileout(file, SER_DISK, version);
+    CAutoFile fileout(file, stream.GetType(), stream.GetVersion());
     if (fileout.IsNull()) {
         fileout.fclose();
         remove(pathTmp);
@@ -60,11 +60,12 @@ bool SerializeFileDB(const CChainParams &chainParams, const std::string &prefix,
                      fs::PathToString(pathTmp));
     }
 
-    // Serialize
-    if (!SerializeDB(chainParams, fileout, data)) {
+    try {
+        fileout.write(MakeByteSpan(stream));
+    } catch (const std::exception &e) {
         fileout.fclose();
         remove(pathTmp);
-        return false;
+        return error("%s: I/O error - %s", __func__, e.what());
     }
     if (!FileCommit(fileout.Get())) {
         fileout.fclose();
@@ -83,6 +84,18 @@ bool SerializeFileDB(const CChainParams &chainParams, const std::string &prefix,
     return true;
 }
 
+template <typename Data>
+bool SerializeFileDB(const CChainParams &chainParams, const std::string &prefix,
+                     const fs::path &path, const Data &data, int version) {
+    // Serialize in memory first, so that data is only accessed for as long as
+    // it takes to copy it, not for the file I/O.
+    CDataStream stream{SER_DISK, version};
+    if (!SerializeDB(chainParams, stream, data)) {
+        return false;
+    }
+    return WriteFileDB(prefix, path, stream);
+}
+
 template <typename Stream, typename Data>
 void DeserializeDB(const CChainParams &chainParams, Stream &stream, Data &data,
                    bool fCheckSum = true) {
@@ -150,9 +163,18 @@ bool CBanDB::Read(banmap_t &banSet) {
 
 bool DumpPeerAddresses(const CChainParams &chainParams, const ArgsManager &args,
                        const AddrMan &addr) {
-    const auto pathAddr = args.GetDataDirNet() / "peers.dat";
-    return SerializeFileDB(chainParams, "peers", pathAddr, addr,
-                           CLIENT_VERSION);
+    CDataStream peers{SER_DISK, CLIENT_VERSION};
+    return SerializePeerAddresses(chainParams, addr, peers) &&
+           WritePeerAddresses(args, peers);
+}
+
+bool SerializePeerAddresses(const CChainParams &chainParams,
+                            const AddrMan &addr, CDataStream &peers) {
+    return SerializeDB(chainParams, peers, addr);
+}
+
+bool WritePeerAddresses(const ArgsManager &args, const CDataStream &peers) {
+    return WriteFileDB("peers", args.GetDataDirNet() / "peers.dat", peers);
 }
 
 void ReadFromStream(const CChainParams &chainParams, AddrMan &addr,
@@ -23,6 +23,14 @@ class CChainParams;
 
 bool DumpPeerAddresses(const CChainParams &chainParams, const ArgsManager &args,
                        const AddrMan &addr);
+/**
+ * DumpPeerAddresses() in two steps: serializing addrman in memory, which is
+ * all that holds its lock, then writing peers.dat, which can be done from
+ * another thread.
+ */
+bool SerializePeerAddresses(const CChainParams &chainParams,
+                            const AddrMan &addr, CDataStream &peers);
+bool WritePeerAddresses(const ArgsManager &args, const CDataStream &peers);
 /** Only used by tests. */
 void ReadFromStream(const CChainParams &chainParams, AddrMan &addr,
                     CDataStream &ssPeers);
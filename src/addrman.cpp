@@ -578,8 +578,17 @@ void AddrManImpl::MakeTried(AddrInfo &info, int nId) {
     info.fInTried = true;
 }
 
+AddrManImpl::BucketPosition
+AddrManImpl::GetNewBucketPosition(const uint256 &key, const CAddress &addr,
+                                  const CNetAddr &source) const {
+    const AddrInfo info{addr, source};
+    const int bucket{info.GetNewBucket(key, source, m_asmap)};
+    return {bucket, info.GetBucketPosition(key, true, bucket)};
+}
+
 bool AddrManImpl::AddSingle(const CAddress &addr, const CNetAddr &source,
-                            std::chrono::seconds time_penalty) {
+                            std::chrono::seconds time_penalty,
+                            const BucketPosition *new_position) {
     AssertLockHeld(cs);
 
     if (!addr.IsRoutable()) {
@@ -636,8 +645,9 @@ bool AddrManImpl::AddSingle(const CAddress &addr, const CNetAddr &source,
         nNew++;
     }
 
-    int nUBucket = pinfo->GetNewBucket(nKey, source, m_asmap);
-    int nUBucketPos = pinfo->GetBucketPosition(nKey, true, nUBucket);
+    const auto [nUBucket, nUBucketPos] =
+        new_position ? *new_position
+                     : GetNewBucketPosition(nKey, addr, source);
     bool fInsert = vvNew[nUBucket][nUBucketPos] == -1;
     if (vvNew[nUBucket][nUBucketPos] != nId) {
         if (!fInsert) {
@@ -726,11 +736,15 @@ void AddrManImpl::Good_(const CService &addr, bool test_before_evict,
 
 bool AddrManImpl::Add_(const std::vector<CAddress> &vAddr,
                        const CNetAddr &source,
-                       std::chrono::seconds time_penalty) {
+                       std::chrono::seconds time_penalty,
+                       const std::vector<BucketPosition> &new_positions) {
+    Assume(new_positions.empty() || new_positions.size() == vAddr.size());
     int added{0};
-    for (std::vector<CAddress>::const_iterator it = vAddr.begin();
-         it != vAddr.end(); it++) {
-        added += AddSingle(*it, source, time_penalty) ? 1 : 0;
+    for (size_t i = 0; i < vAddr.size(); ++i) {
+        const BucketPosition *new_position{
+            new_positions.empty() ? nullptr : &new_positions[i]};
+        added +=
+            AddSingle(vAddr[i], source, time_penalty, new_position) ? 1 : 0;
     }
     if (added > 0) {
         LogPrint(BCLog::ADDRMAN,
@@ -1178,9 +1192,22 @@ size_t AddrManImpl::size() const {
 bool AddrManImpl::Add(const std::vector<CAddress> &vAddr,
                       const CNetAddr &source,
                       std::chrono::seconds time_penalty) {
+    // Hashing the addresses to their position in the new table is most of the
+    // work of adding them, so it is done before taking the lock. This is
+    // wasted if the key changes meanwhile, which only Clear() does.
+    const uint256 key{WITH_LOCK(cs, return nKey)};
+    std::vector<BucketPosition> new_positions;
+    new_positions.reserve(vAddr.size());
+    for (const CAddress &addr : vAddr) {
+        new_positions.push_back(GetNewBucketPosition(key, addr, source));
+    }
+
     LOCK(cs);
     Check();
-    auto ret = Add_(vAddr, source, time_penalty);
+    if (key != nKey) {
+        new_positions.clear();
+    }
+    auto ret = Add_(vAddr, source, time_penalty, new_positions);
     Check();
     return ret;
 }
@@ -1306,6 +1333,7 @@ template <typename Stream> void AddrMan::Unserialize(Stream &s_) {
 // explicit instantiation
 template void AddrMan::Serialize(HashedSourceWriter<CAutoFile> &s) const;
 template void AddrMan::Serialize(CDataStream &s) const;
+template void AddrMan::Serialize(HashedSourceWriter<CDataStream> &s) const;
 template void AddrMan::Unserialize(CAutoFile &s);
 template void AddrMan::Unserialize(CHashVerifier<CAutoFile> &s);
 template void AddrMan::Unserialize(CDataStream &s);
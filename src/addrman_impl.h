@@ -277,19 +277,38 @@ private:
     //! Move an entry from the "new" table(s) to the "tried" table
     void MakeTried(AddrInfo &info, int nId) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    //! A bucket and a position in it
+    struct BucketPosition {
+        int bucket;
+        int position;
+    };
+
+    /**
+     * Where an address from a source goes in the new table, given the key.
+     * This is most of the work of adding an address, and doesn't need cs.
+     */
+    BucketPosition GetNewBucketPosition(const uint256 &key,
+                                        const CAddress &addr,
+                                        const CNetAddr &source) const;
+
     /**
      * Attempt to add a single address to addrman's new table.
      * @see AddrMan::Add() for parameters.
+     * new_position is where the address goes in the new table, if it was
+     * computed with the current key beforehand.
      */
     bool AddSingle(const CAddress &addr, const CNetAddr &source,
-                   std::chrono::seconds time_penalty)
+                   std::chrono::seconds time_penalty,
+                   const BucketPosition *new_position = nullptr)
         EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     void Good_(const CService &addr, bool test_before_evict, NodeSeconds time)
         EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     bool Add_(const std::vector<CAddress> &vAddr, const CNetAddr &source,
-              std::chrono::seconds time_penalty) EXCLUSIVE_LOCKS_REQUIRED(cs);
+              std::chrono::seconds time_penalty,
+              const std::vector<BucketPosition> &new_positions = {})
+        EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     void Attempt_(const CService &addr, bool fCountFailure, NodeSeconds time)
         EXCLUSIVE_LOCKS_REQUIRED(cs);
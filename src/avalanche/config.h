@@ -6,14 +6,20 @@
 #define BITCOIN_AVALANCHE_CONFIG_H
 
 #include <chrono>
+#include <cstddef>
 
 namespace avalanche {
 
 struct Config {
     const std::chrono::milliseconds queryTimeoutDuration;
+    const size_t maxPollsPerTick;
+    const bool adaptiveQueryTimeout;
 
-    Config(std::chrono::milliseconds queryTimeoutDurationIn)
-        : queryTimeoutDuration(queryTimeoutDurationIn) {}
+    Config(std::chrono::milliseconds queryTimeoutDurationIn,
+           size_t maxPollsPerTickIn, bool adaptiveQueryTimeoutIn)
+        : queryTimeoutDuration(queryTimeoutDurationIn),
+          maxPollsPerTick(maxPollsPerTickIn),
+          adaptiveQueryTimeout(adaptiveQueryTimeoutIn) {}
 };
 
 } // namespace avalanche
@@ -79,6 +79,24 @@ bool Delegation::verify(DelegationState &state, CPubKey &auth) const {
                              "too-many-levels");
     }
 
+    if (levels.size() > 1) {
+        // Verify the signatures of all the levels at once, and only walk them
+        // one by one to find the invalid one.
+        std::vector<SchnorrSigCheck> checks;
+        checks.reserve(levels.size());
+        uint256 batchHash = hash;
+        reduceLevels(batchHash, levels, [&](const Level &l) {
+            checks.push_back({batchHash, l.sig, *pauth});
+            pauth = &l.pubkey;
+            return true;
+        });
+        if (VerifySchnorrBatch(checks)) {
+            auth = *pauth;
+            return true;
+        }
+        pauth = &proofMaster;
+    }
+
     bool ret = reduceLevels(hash, levels, [&](const Level &l) {
         if (!pauth->VerifySchnorr(hash, l.sig)) {
             return state.Invalid(DelegationResult::INVALID_SIGNATURE,
@@ -26,7 +26,7 @@
 #include <limits>
 
 namespace avalanche {
-static constexpr uint64_t PEERS_DUMP_VERSION{1};
+static constexpr uint64_t PEERS_DUMP_VERSION{2};
 
 bool PeerManager::addNode(NodeId nodeid, const ProofId &proofid) {
     auto &pview = peers.get<by_proofid>();
@@ -98,6 +98,7 @@ bool PeerManager::addNodeToPeer(const PeerSet::iterator &it) {
         const uint64_t start = slotCount;
         slots.emplace_back(start, score, it->peerid);
         slotCount = start + score;
+        appendSlotScore(score);
 
         // Add to our allocated score when we allocate a new peer in the slots
         connectedPeersScore += score;
@@ -171,8 +172,12 @@ bool PeerManager::removeNodeFromPeer(const PeerSet::iterator &it,
     if (i + 1 == slots.size()) {
         slots.pop_back();
         slotCount = slots.empty() ? 0 : slots.back().getStop();
+        // The tree nodes only cover slots before them, so the last slot can
+        // be dropped as is.
+        slotScoreTree.pop_back();
     } else {
         fragmentation += slots[i].getScore();
+        clearSlotScore(i, slots[i].getScore());
         slots[i] = slots[i].withPeerId(NO_PEER);
     }
 
@@ -529,8 +534,8 @@ NodeId PeerManager::selectNode() {
     for (int retry = 0; retry < SELECT_NODE_MAX_RETRY; retry++) {
         const PeerId p = selectPeer();
 
-        // If we cannot find a peer, it may be due to the fact that it is
-        // unlikely due to high fragmentation, so compact and retry.
+        // If we cannot find a peer, there is no connected one left. Compact
+        // to release the dead slots.
         if (p == NO_PEER) {
             compact();
             continue;
@@ -555,6 +560,19 @@ std::unordered_set<ProofRef, SaltedProofHasher> PeerManager::updatedBlockTip() {
     std::vector<ProofId> invalidProofIds;
     std::vector<ProofRef> newImmatures;
 
+    {
+        // Only the proofs added since the last tip have their signatures to
+        // check, do it in batches before the sequential verification.
+        std::vector<ProofRef> proofs;
+        proofs.reserve(peers.size());
+        for (const auto &p : peers) {
+            proofs.push_back(p.proof);
+        }
+        danglingProofPool.forEachProof(
+            [&](const ProofRef &proof) { proofs.push_back(proof); });
+        Proof::preverifySignatures(proofs);
+    }
+
     {
         LOCK(cs_main);
 
@@ -743,19 +761,68 @@ bool PeerManager::removePeer(const PeerId peerid) {
 }
 
 PeerId PeerManager::selectPeer() const {
-    if (slots.empty() || slotCount == 0) {
+    // Draw among the live slots only, so there is no need to retry when
+    // hitting a dead one.
+    if (slots.empty() || connectedPeersScore == 0) {
         return NO_PEER;
     }
 
-    const uint64_t max = slotCount;
-    for (int retry = 0; retry < SELECT_PEER_MAX_RETRY; retry++) {
-        size_t i = selectPeerImpl(slots, GetRand(max), max);
-        if (i != NO_PEER) {
-            return i;
+    const size_t i = findSlotByScore(GetRand(uint64_t(connectedPeersScore)));
+    assert(i < slots.size());
+    return slots[i].getPeerId();
+}
+
+void PeerManager::appendSlotScore(Score score) {
+    // The new node covers the slots (n - lowbit(n), n], which are the sum of
+    // its score and of the nodes right below it.
+    const size_t n = slotScoreTree.size() + 1;
+    uint64_t sum = score;
+    for (size_t j = n - 1; j > n - (n & -n); j -= j & -j) {
+        sum += slotScoreTree[j - 1];
+    }
+    slotScoreTree.push_back(sum);
+}
+
+void PeerManager::clearSlotScore(size_t index, Score score) {
+    for (size_t j = index + 1; j <= slotScoreTree.size(); j += j & -j) {
+        assert(slotScoreTree[j - 1] >= score);
+        slotScoreTree[j - 1] -= score;
+    }
+}
+
+void PeerManager::rebuildSlotScoreTree() {
+    const size_t n = slots.size();
+    slotScoreTree.assign(n, 0);
+    for (size_t j = 1; j <= n; j++) {
+        if (slots[j - 1].getPeerId() != NO_PEER) {
+            slotScoreTree[j - 1] += slots[j - 1].getScore();
+        }
+
+        const size_t parent = j + (j & -j);
+        if (parent <= n) {
+            slotScoreTree[parent - 1] += slotScoreTree[j - 1];
         }
     }
+}
 
-    return NO_PEER;
+size_t PeerManager::findSlotByScore(uint64_t position) const {
+    // Descend the tree, skipping over the subtrees ending before the
+    // position.
+    const size_t n = slotScoreTree.size();
+    size_t step = 1;
+    while ((step << 1) <= n) {
+        step <<= 1;
+    }
+
+    size_t pos = 0;
+    for (; step > 0; step >>= 1) {
+        if (pos + step <= n && slotScoreTree[pos + step - 1] <= position) {
+            pos += step;
+            position -= slotScoreTree[pos - 1];
+        }
+    }
+
+    return pos;
 }
 
 uint64_t PeerManager::compact() {
@@ -782,6 +849,7 @@ uint64_t PeerManager::compact() {
     }
 
     slots = std::move(newslots);
+    rebuildSlotScoreTree();
 
     const uint64_t saved = slotCount - prevStop;
     slotCount = prevStop;
@@ -823,6 +891,22 @@ bool PeerManager::verify() const {
         return false;
     }
 
+    // The slot score tree must match the slots.
+    if (slotScoreTree.size() != slots.size()) {
+        return false;
+    }
+    for (size_t j = 1; j <= slots.size(); j++) {
+        uint64_t sum = 0;
+        for (size_t k = j - (j & -j); k < j; k++) {
+            if (slots[k].getPeerId() != NO_PEER) {
+                sum += slots[k].getScore();
+            }
+        }
+        if (slotScoreTree[j - 1] != sum) {
+            return false;
+        }
+    }
+
     Score scoreFromAllPeers = 0;
     Score scoreFromPeersWithNodes = 0;
 
@@ -1022,80 +1106,75 @@ bool PeerManager::selectStakingRewardWinner(
 
     const BlockHash prevblockhash = pprev->GetBlockHash();
 
-    std::vector<ProofRef> selectedProofs;
-    ProofRef firstCompliantProof = ProofRef();
-    while (selectedProofs.size() < peers.size()) {
-        double bestRewardRank = std::numeric_limits<double>::max();
-        ProofRef selectedProof = ProofRef();
-        int64_t selectedProofRegistrationTime{0};
-        uint256 bestRewardHash;
-
-        for (const Peer &peer : peers) {
-            if (!peer.proof) {
-                // Should never happen, continue
-                continue;
-            }
+    // Compute the reward rank of each eligible proof once, then pick them by
+    // increasing rank from a heap: the selection usually stops after a few
+    // proofs so there is no point sorting them all.
+    struct RankedProof {
+        double rewardRank;
+        StakeContenderId rewardHash;
+        ProofRef proof;
+        int64_t registrationTime;
+    };
+    std::vector<RankedProof> rankedProofs;
+    rankedProofs.reserve(peers.size());
 
-            if (!peer.hasFinalized ||
-                peer.registration_time.count() >= maxRegistrationTime) {
-                continue;
-            }
+    for (const Peer &peer : peers) {
+        if (!peer.proof) {
+            // Should never happen, continue
+            continue;
+        }
 
-            if (std::find_if(selectedProofs.begin(), selectedProofs.end(),
-                             [&peer](const ProofRef &proof) {
-                                 return peer.getProofId() == proof->getId();
-                             }) != selectedProofs.end()) {
-                continue;
-            }
+        if (!peer.hasFinalized ||
+            peer.registration_time.count() >= maxRegistrationTime) {
+            continue;
+        }
 
-            StakeContenderId proofRewardHash(prevblockhash, peer.getProofId());
-            if (proofRewardHash == uint256::ZERO) {
-                // This either the result of an incredibly unlikely lucky hash,
-                // or a the hash is getting abused. In this case, skip the
-                // proof.
-                LogPrintf(
-                    "Staking reward hash has a suspicious value of zero for "
-                    "proof %s and blockhash %s, skipping\n",
-                    peer.getProofId().ToString(), prevblockhash.ToString());
-                continue;
-            }
+        StakeContenderId proofRewardHash(prevblockhash, peer.getProofId());
+        if (proofRewardHash == uint256::ZERO) {
+            // This either the result of an incredibly unlikely lucky hash, or
+            // a the hash is getting abused. In this case, skip the proof.
+            LogPrintf("Staking reward hash has a suspicious value of zero for "
+                      "proof %s and blockhash %s, skipping\n",
+                      peer.getProofId().ToString(), prevblockhash.ToString());
+            continue;
+        }
 
-            // The best ranking is the lowest ranking value
-            double proofRewardRank =
-                proofRewardHash.ComputeProofRewardRank(peer.getScore());
-            if (proofRewardRank < bestRewardRank) {
-                bestRewardRank = proofRewardRank;
-                selectedProof = peer.proof;
-                selectedProofRegistrationTime = peer.registration_time.count();
-                bestRewardHash = proofRewardHash;
-            }
+        // The best ranking is the lowest ranking value
+        rankedProofs.push_back(
+            {proofRewardHash.ComputeProofRewardRank(peer.getScore()),
+             proofRewardHash, peer.proof, peer.registration_time.count()});
+    }
 
-            // Select the lowest reward hash then proofid in the unlikely case
-            // of a collision.
-            if (proofRewardRank == bestRewardRank &&
-                (proofRewardHash < bestRewardHash ||
-                 (proofRewardHash == bestRewardHash &&
-                  peer.getProofId() < selectedProof->getId()))) {
-                selectedProof = peer.proof;
-                selectedProofRegistrationTime = peer.registration_time.count();
-                bestRewardHash = proofRewardHash;
-            }
+    // Select the lowest reward rank, then the lowest reward hash then proofid
+    // in the unlikely case of a collision. The heap puts the greatest element
+    // first, so the comparison is reversed.
+    const auto isWorseRanked = [](const RankedProof &lhs,
+                                  const RankedProof &rhs) {
+        if (lhs.rewardRank != rhs.rewardRank) {
+            return lhs.rewardRank > rhs.rewardRank;
         }
-
-        if (!selectedProof) {
-            // No winner
-            break;
+        if (lhs.rewardHash != rhs.rewardHash) {
+            return rhs.rewardHash < lhs.rewardHash;
         }
+        return rhs.proof->getId() < lhs.proof->getId();
+    };
+    std::make_heap(rankedProofs.begin(), rankedProofs.end(), isWorseRanked);
+
+    std::vector<ProofRef> selectedProofs;
+    ProofRef firstCompliantProof = ProofRef();
+    for (auto end = rankedProofs.end(); end != rankedProofs.begin(); end--) {
+        std::pop_heap(rankedProofs.begin(), end, isWorseRanked);
+        const RankedProof &selected = *(end - 1);
 
         if (!firstCompliantProof &&
-            selectedProofRegistrationTime < targetRegistrationTime) {
-            firstCompliantProof = selectedProof;
+            selected.registrationTime < targetRegistrationTime) {
+            firstCompliantProof = selected.proof;
         }
 
-        selectedProofs.push_back(selectedProof);
+        selectedProofs.push_back(selected.proof);
 
-        if (selectedProofRegistrationTime < minRegistrationTime &&
-            !isFlaky(selectedProof->getId())) {
+        if (selected.registrationTime < minRegistrationTime &&
+            !isFlaky(selected.proof->getId())) {
             break;
         }
     }
@@ -1300,6 +1379,12 @@ bool PeerManager::dumpPeersToFile(const fs::path &dumpPath) const {
             file << int64_t(peer.nextPossibleConflictTime.count());
         }
 
+        // The immature proofs are kept as well, they don't need to be
+        // downloaded again once their stakes mature.
+        file << uint64_t(immatureProofPool.countProofs());
+        immatureProofPool.forEachProof(
+            [&](const ProofRef &proof) { file << proof; });
+
         if (!FileCommit(file.Get())) {
             throw std::runtime_error(strprintf("Failed to commit to file %s",
                                                PathToString(dumpPathTmp)));
@@ -1336,11 +1421,22 @@ bool PeerManager::loadPeersFromFile(
         return false;
     }
 
+    struct LoadedPeer {
+        ProofRef proof;
+        bool hasFinalized;
+        int64_t registrationTime;
+        int64_t nextPossibleConflictTime;
+    };
+    std::vector<LoadedPeer> loadedPeers;
+    std::vector<ProofRef> immatureProofs;
+    bool success{true};
+
     try {
         uint64_t version;
         file >> version;
 
-        if (version != PEERS_DUMP_VERSION) {
+        // The version 1 files have no immature proofs.
+        if (version != 1 && version != PEERS_DUMP_VERSION) {
             LogPrint(BCLog::AVALANCHE,
                      "Unsupported avalanche peers file version.\n");
             return false;
@@ -1349,49 +1445,79 @@ bool PeerManager::loadPeersFromFile(
         uint64_t numPeers;
         file >> numPeers;
 
-        auto &peersByProofId = peers.get<by_proofid>();
-
         for (uint64_t i = 0; i < numPeers; i++) {
-            ProofRef proof;
-            bool hasFinalized;
-            int64_t registrationTime;
-            int64_t nextPossibleConflictTime;
-
-            file >> proof;
-            file >> hasFinalized;
-            file >> registrationTime;
-            file >> nextPossibleConflictTime;
-
-            if (registerProof(proof)) {
-                auto it = peersByProofId.find(proof->getId());
-                if (it == peersByProofId.end()) {
-                    // Should never happen
-                    continue;
-                }
+            LoadedPeer peer;
+            file >> peer.proof;
+            file >> peer.hasFinalized;
+            file >> peer.registrationTime;
+            file >> peer.nextPossibleConflictTime;
+            loadedPeers.push_back(std::move(peer));
+        }
+
+        if (version >= 2) {
+            uint64_t numImmatureProofs;
+            file >> numImmatureProofs;
 
-                // We don't modify any key so we don't need to rehash.
-                // If the modify fails, it means we don't get the full benefit
-                // from the file but we still added our peer to the set. The
-                // non-overridden fields will be set the normal way.
-                peersByProofId.modify(it, [&](Peer &p) {
-                    p.hasFinalized = hasFinalized;
-                    p.registration_time =
-                        std::chrono::seconds{registrationTime};
-                    p.nextPossibleConflictTime =
-                        std::chrono::seconds{nextPossibleConflictTime};
-                });
-
-                registeredProofs.insert(proof);
+            for (uint64_t i = 0; i < numImmatureProofs; i++) {
+                ProofRef proof;
+                file >> proof;
+                immatureProofs.push_back(std::move(proof));
             }
         }
     } catch (const std::exception &e) {
         LogPrint(BCLog::AVALANCHE,
                  "Failed to read the avalanche peers file data on disk: %s.\n",
                  e.what());
-        return false;
+        // Keep the entries read so far.
+        success = false;
     }
 
-    return true;
+    // There are typically thousands of proofs, verify their signatures in
+    // batches before registering them one by one.
+    std::vector<ProofRef> proofs;
+    proofs.reserve(loadedPeers.size() + immatureProofs.size());
+    for (const LoadedPeer &peer : loadedPeers) {
+        proofs.push_back(peer.proof);
+    }
+    proofs.insert(proofs.end(), immatureProofs.begin(), immatureProofs.end());
+    Proof::preverifySignatures(proofs);
+
+    auto &peersByProofId = peers.get<by_proofid>();
+    for (const LoadedPeer &peer : loadedPeers) {
+        if (!registerProof(peer.proof)) {
+            continue;
+        }
+
+        auto it = peersByProofId.find(peer.proof->getId());
+        if (it == peersByProofId.end()) {
+            // Should never happen
+            continue;
+        }
+
+        // We don't modify any key so we don't need to rehash.
+        // If the modify fails, it means we don't get the full benefit
+        // from the file but we still added our peer to the set. The
+        // non-overridden fields will be set the normal way.
+        peersByProofId.modify(it, [&](Peer &p) {
+            p.hasFinalized = peer.hasFinalized;
+            p.registration_time = std::chrono::seconds{peer.registrationTime};
+            p.nextPossibleConflictTime =
+                std::chrono::seconds{peer.nextPossibleConflictTime};
+        });
+
+        registeredProofs.insert(peer.proof);
+    }
+
+    // The stakes are checked against the UTXO set again: the proofs which are
+    // still immature go back to the immature pool, where they are checked at
+    // every new tip, and the ones that matured meanwhile make new peers.
+    for (const ProofRef &proof : immatureProofs) {
+        if (registerProof(proof)) {
+            registeredProofs.insert(proof);
+        }
+    }
+
+    return success;
 }
 
 } // namespace avalanche
@@ -164,6 +164,13 @@ class PeerManager {
     uint64_t slotCount = 0;
     uint64_t fragmentation = 0;
 
+    /**
+     * Binary indexed (Fenwick) tree over the scores of the slots, with zero
+     * for the dead ones. It makes drawing a peer logarithmic in the number of
+     * slots and unaffected by fragmentation.
+     */
+    std::vector<uint64_t> slotScoreTree;
+
     /**
      * Several nodes can make an avalanche peer. In this case, all nodes are
      * considered interchangeable parts of the same peer.
@@ -224,7 +231,6 @@ class PeerManager {
                 bmi::member<PendingNode, NodeId, &PendingNode::nodeid>>>>;
     PendingNodeSet pendingNodes;
 
-    static constexpr int SELECT_PEER_MAX_RETRY = 3;
     static constexpr int SELECT_NODE_MAX_RETRY = 3;
 
     /**
@@ -558,6 +564,13 @@ private:
 
     bool isFlaky(const ProofId &proofid) const;
 
+    /** Maintenance of the slot score tree, see slotScoreTree. */
+    void appendSlotScore(Score score);
+    void clearSlotScore(size_t index, Score score);
+    void rebuildSlotScoreTree();
+    /** Return the index of the slot containing the score position. */
+    size_t findSlotByScore(uint64_t position) const;
+
     friend struct ::avalanche::TestPeerManager;
 };
 
@@ -24,6 +24,7 @@
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <chrono>
 #include <limits>
 #include <tuple>
@@ -33,8 +34,21 @@
  */
 static constexpr std::chrono::milliseconds AVALANCHE_TIME_STEP{10};
 
+/**
+ * The adaptive query timeout is this many times the smoothed response time,
+ * once enough responses have been received to estimate it.
+ */
+static constexpr int64_t AVALANCHE_QUERY_TIMEOUT_RESPONSE_TIME_FACTOR{8};
+static constexpr uint64_t AVALANCHE_MIN_RESPONSE_TIME_SAMPLES{16};
+
 static const std::string AVAPEERS_FILE_NAME{"avapeers.dat"};
 
+/**
+ * How often the avalanche peers are dumped, so they are not lost if the node
+ * does not shut down cleanly.
+ */
+static constexpr std::chrono::minutes AVALANCHE_PEERS_DUMP_INTERVAL{15};
+
 namespace avalanche {
 static const uint256 GetVoteItemId(const AnyVoteItem &item) {
     return std::visit(variant::overloaded{
@@ -200,6 +214,16 @@ Processor::Processor(Config avaconfigIn, interfaces::Chain &chain,
 
     LogPrint(BCLog::AVALANCHE, "Loaded %d peers from the %s file\n",
              registeredProofs.size(), PathToString(dumpPath));
+
+    scheduler.scheduleEvery(
+        [this, dumpPath]() -> bool {
+            // Discard the status output: a failure is logged and the next
+            // attempt might succeed.
+            WITH_LOCK(cs_peerManager,
+                      return peerManager->dumpPeersToFile(dumpPath));
+            return true;
+        },
+        AVALANCHE_PEERS_DUMP_INTERVAL, CScheduler::Priority::LOW);
 }
 
 Processor::~Processor() {
@@ -394,7 +418,18 @@ Processor::MakeProcessor(const ArgsManager &argsman, interfaces::Chain &chain,
         return nullptr;
     }
 
-    Config avaconfig(queryTimeoutDuration);
+    const int64_t maxPollsPerTick = argsman.GetIntArg(
+        "-avamaxpollspertick", AVALANCHE_DEFAULT_MAX_POLLS_PER_TICK);
+    if (maxPollsPerTick <= 0) {
+        error = _("The avalanche max polls per tick must be greater than 0");
+        return nullptr;
+    }
+
+    const bool adaptiveQueryTimeout = argsman.GetBoolArg(
+        "-avaadaptivetimeout", AVALANCHE_DEFAULT_ADAPTIVE_QUERY_TIMEOUT);
+
+    Config avaconfig(queryTimeoutDuration, maxPollsPerTick,
+                     adaptiveQueryTimeout);
 
     // We can't use std::make_unique with a private constructor
     return std::unique_ptr<Processor>(new Processor(
@@ -554,6 +589,15 @@ bool Processor::registerVotes(NodeId nodeid, const Response &response,
             return false;
         }
 
+        // Smooth the response time the same way TCP does for the RTT.
+        const int64_t responseTime = count_microseconds(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                Now<SteadyMilliseconds>() - it->sent));
+        const int64_t smoothed = smoothedResponseTime;
+        smoothedResponseTime = responsesReceived++ == 0
+                                   ? responseTime
+                                   : smoothed + (responseTime - smoothed) / 8;
+
         invs = std::move(it->invs);
         w->erase(it);
     }
@@ -579,8 +623,9 @@ bool Processor::registerVotes(NodeId nodeid, const Response &response,
 
     // At this stage we are certain that invs[i] matches votes[i], so we can use
     // the inv type to retrieve what is being voted on.
+    std::vector<AnyVoteItem> items = getVoteItemsFromInvs(invs);
     for (size_t i = 0; i < size; i++) {
-        auto item = getVoteItemFromInv(invs[i]);
+        auto &item = items[i];
 
         if (isNull(item)) {
             // This should not happen, but just in case...
@@ -756,8 +801,11 @@ ProofRegistrationState Processor::getLocalProofRegistrationState() const {
 }
 
 bool Processor::startEventLoop(CScheduler &scheduler) {
+    // The polls are latency sensitive, don't let them wait behind the slow
+    // tasks.
     return eventLoop.startEventLoop(
-        scheduler, [this]() { this->runEventLoop(); }, AVALANCHE_TIME_STEP);
+        scheduler, [this]() { this->runEventLoop(); }, AVALANCHE_TIME_STEP,
+        CScheduler::Priority::HIGH);
 }
 
 bool Processor::stopEventLoop() {
@@ -1102,16 +1150,31 @@ void Processor::runEventLoop() {
     // them.
     clearTimedoutRequests();
 
-    // Make sure there is at least one suitable node to query before gathering
-    // invs.
-    NodeId nodeid = WITH_LOCK(cs_peerManager, return peerManager->selectNode());
-    if (nodeid == NO_NODE) {
-        return;
-    }
-    std::vector<CInv> invs = getInvsForNextPoll();
-    if (invs.empty()) {
-        return;
+    // When more items are waiting than a single poll can carry, the next ones
+    // are sent to other nodes right away rather than at the next iteration.
+    for (size_t i = 0; i < avaconfig.maxPollsPerTick; i++) {
+        // Make sure there is at least one suitable node to query before
+        // gathering invs.
+        NodeId nodeid =
+            WITH_LOCK(cs_peerManager, return peerManager->selectNode());
+        if (nodeid == NO_NODE) {
+            return;
+        }
+        std::vector<CInv> invs =
+            getInvsForNextPoll(true, i * AVALANCHE_MAX_ELEMENT_POLL);
+        if (invs.empty()) {
+            return;
+        }
+
+        const bool isFull = invs.size() == AVALANCHE_MAX_ELEMENT_POLL;
+        if (!sendPoll(nodeid, std::move(invs)) || !isFull) {
+            return;
+        }
     }
+}
+
+bool Processor::sendPoll(NodeId nodeid, std::vector<CInv> invs) {
+    const std::chrono::milliseconds queryTimeout = getQueryTimeout();
 
     LOCK(cs_peerManager);
 
@@ -1122,17 +1185,17 @@ void Processor::runEventLoop() {
          * up over time.
          */
         bool hasSent = connman->ForNode(
-            nodeid, [this, &invs](CNode *pnode) EXCLUSIVE_LOCKS_REQUIRED(
-                        cs_peerManager) {
+            nodeid, [this, &invs, &queryTimeout](CNode *pnode)
+                        EXCLUSIVE_LOCKS_REQUIRED(cs_peerManager) {
                 uint64_t current_round = round++;
 
                 {
                     // Compute the time at which this requests times out.
-                    auto timeout = Now<SteadyMilliseconds>() +
-                                   avaconfig.queryTimeoutDuration;
+                    auto now = Now<SteadyMilliseconds>();
+                    auto timeout = now + queryTimeout;
                     // Register the query.
                     queries.getWriteView()->insert(
-                        {pnode->GetId(), current_round, timeout, invs});
+                        {pnode->GetId(), current_round, now, timeout, invs});
                     // Set the timeout.
                     peerManager->updateNextRequestTime(pnode->GetId(), timeout);
                 }
@@ -1149,7 +1212,8 @@ void Processor::runEventLoop() {
 
         // Success!
         if (hasSent) {
-            return;
+            pollsSent++;
+            return true;
         }
 
         // This node is obsolete, delete it.
@@ -1158,6 +1222,38 @@ void Processor::runEventLoop() {
         // Get next suitable node to try again
         nodeid = peerManager->selectNode();
     } while (nodeid != NO_NODE);
+
+    return false;
+}
+
+std::chrono::milliseconds Processor::getQueryTimeout() const {
+    if (!avaconfig.adaptiveQueryTimeout ||
+        responsesReceived < AVALANCHE_MIN_RESPONSE_TIME_SAMPLES) {
+        return avaconfig.queryTimeoutDuration;
+    }
+
+    const auto adaptiveTimeout =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::microseconds{
+                smoothedResponseTime *
+                AVALANCHE_QUERY_TIMEOUT_RESPONSE_TIME_FACTOR});
+    return std::min(avaconfig.queryTimeoutDuration,
+                    std::max(AVALANCHE_MIN_ADAPTIVE_QUERY_TIMEOUT,
+                             adaptiveTimeout));
+}
+
+Processor::PollingStats Processor::getPollingStats() const {
+    PollingStats stats;
+    stats.pollsSent = pollsSent;
+    stats.responsesReceived = responsesReceived;
+    stats.pollsTimedOut = pollsTimedOut;
+    stats.inflightQueries = queries.getReadView()->size();
+    stats.pendingItems = voteRecords.getReadView()->size();
+    stats.averageResponseTime =
+        std::chrono::microseconds{smoothedResponseTime.load()};
+    stats.queryTimeout = getQueryTimeout();
+    stats.maxPollsPerTick = avaconfig.maxPollsPerTick;
+    return stats;
 }
 
 void Processor::clearTimedoutRequests() {
@@ -1173,6 +1269,7 @@ void Processor::clearTimedoutRequests() {
                 timedout_items[i]++;
             }
 
+            pollsTimedOut++;
             w->get<query_timeout>().erase(it++);
         }
     }
@@ -1181,10 +1278,19 @@ void Processor::clearTimedoutRequests() {
         return;
     }
 
+    // Look the items up before taking the vote records lock.
+    std::vector<CInv> invs;
+    invs.reserve(timedout_items.size());
+    for (const auto &p : timedout_items) {
+        invs.push_back(p.first);
+    }
+    const std::vector<AnyVoteItem> items = getVoteItemsFromInvs(invs);
+
     // In flight request accounting.
     auto voteRecordsWriteView = voteRecords.getWriteView();
+    size_t i = 0;
     for (const auto &p : timedout_items) {
-        auto item = getVoteItemFromInv(p.first);
+        const AnyVoteItem &item = items[i++];
 
         if (isNull(item)) {
             continue;
@@ -1199,17 +1305,27 @@ void Processor::clearTimedoutRequests() {
     }
 }
 
-std::vector<CInv> Processor::getInvsForNextPoll(bool forPoll) {
+std::vector<CInv> Processor::getInvsForNextPoll(bool forPoll, size_t skip) {
     std::vector<CInv> invs;
 
     {
-        // First remove all items that are not worth polling.
-        auto w = voteRecords.getWriteView();
-        for (auto it = w->begin(); it != w->end();) {
-            if (!isWorthPolling(it->first)) {
-                it = w->erase(it);
-            } else {
-                ++it;
+        // First remove all items that are not worth polling. They are looked
+        // for with the read lock, so the vote records are only locked for
+        // writing when there is something to remove.
+        std::vector<AnyVoteItem> notWorthPolling;
+        {
+            auto r = voteRecords.getReadView();
+            for (const auto &[item, voteRecord] : r) {
+                if (!isWorthPolling(item)) {
+                    notWorthPolling.push_back(item);
+                }
+            }
+        }
+
+        if (!notWorthPolling.empty()) {
+            auto w = voteRecords.getWriteView();
+            for (const auto &item : notWorthPolling) {
+                w->erase(item);
             }
         }
     }
@@ -1232,6 +1348,11 @@ std::vector<CInv> Processor::getInvsForNextPoll(bool forPoll) {
             return invs;
         }
 
+        if (skip > 0) {
+            skip -= voteRecord.shouldPoll();
+            continue;
+        }
+
         const bool shouldPoll =
             forPoll ? voteRecord.registerPoll() : voteRecord.shouldPoll();
 
@@ -1245,31 +1366,73 @@ std::vector<CInv> Processor::getInvsForNextPoll(bool forPoll) {
     return invs;
 }
 
-AnyVoteItem Processor::getVoteItemFromInv(const CInv &inv) const {
-    if (inv.IsMsgBlk()) {
-        return WITH_LOCK(cs_main, return chainman.m_blockman.LookupBlockIndex(
-                                      BlockHash(inv.hash)));
+std::vector<AnyVoteItem>
+Processor::getVoteItemsFromInvs(const std::vector<CInv> &invs) const {
+    const size_t size = invs.size();
+    std::vector<const CBlockIndex *> blocks(size, nullptr);
+    std::vector<ProofRef> proofs(size);
+    std::vector<CTransactionRef> txs(size);
+
+    const auto hasInv = [&](bool (CInv::*isType)() const) {
+        return std::any_of(invs.begin(), invs.end(),
+                           [&](const CInv &inv) { return (inv.*isType)(); });
+    };
+
+    if (hasInv(&CInv::IsMsgBlk)) {
+        LOCK(cs_main);
+        for (size_t i = 0; i < size; i++) {
+            if (invs[i].IsMsgBlk()) {
+                blocks[i] = chainman.m_blockman.LookupBlockIndex(
+                    BlockHash(invs[i].hash));
+            }
+        }
     }
 
-    if (inv.IsMsgProof()) {
-        return WITH_LOCK(cs_peerManager,
-                         return peerManager->getProof(ProofId(inv.hash)));
+    if (hasInv(&CInv::IsMsgProof)) {
+        LOCK(cs_peerManager);
+        for (size_t i = 0; i < size; i++) {
+            if (invs[i].IsMsgProof()) {
+                proofs[i] = peerManager->getProof(ProofId(invs[i].hash));
+            }
+        }
     }
 
-    if (mempool && inv.IsMsgTx()) {
+    if (mempool && hasInv(&CInv::IsMsgTx)) {
         LOCK(mempool->cs);
-        if (CTransactionRef tx = mempool->get(TxId(inv.hash))) {
-            return tx;
-        }
-        if (CTransactionRef tx = mempool->withConflicting(
-                [&inv](const TxConflicting &conflicting) {
-                    return conflicting.GetTx(TxId(inv.hash));
-                })) {
-            return tx;
+        for (size_t i = 0; i < size; i++) {
+            if (!invs[i].IsMsgTx()) {
+                continue;
+            }
+            const TxId txid(invs[i].hash);
+            txs[i] = mempool->get(txid);
+            if (!txs[i]) {
+                txs[i] = mempool->withConflicting(
+                    [&txid](const TxConflicting &conflicting) {
+                        return conflicting.GetTx(txid);
+                    });
+            }
         }
     }
 
-    return {nullptr};
+    const auto makeVoteItem = [&](size_t i) -> AnyVoteItem {
+        if (invs[i].IsMsgBlk()) {
+            return blocks[i];
+        }
+        if (invs[i].IsMsgProof()) {
+            return proofs[i];
+        }
+        if (txs[i]) {
+            return txs[i];
+        }
+        return {nullptr};
+    };
+
+    std::vector<AnyVoteItem> items;
+    items.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+        items.push_back(makeVoteItem(i));
+    }
+    return items;
 }
 
 bool Processor::IsWorthPolling::operator()(const CBlockIndex *pindex) const {
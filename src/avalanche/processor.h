@@ -58,6 +58,25 @@ static constexpr size_t AVALANCHE_MAX_ELEMENT_POLL = 16;
 static constexpr std::chrono::milliseconds AVALANCHE_DEFAULT_QUERY_TIMEOUT{
     10000};
 
+/**
+ * Whether the query timeout is shortened to a multiple of the time the nodes
+ * take to respond, so that polls sent to unresponsive nodes expire sooner.
+ */
+static constexpr bool AVALANCHE_DEFAULT_ADAPTIVE_QUERY_TIMEOUT{true};
+
+/**
+ * The adaptive query timeout is never shorter than this, nor longer than the
+ * configured query timeout.
+ */
+static constexpr std::chrono::milliseconds AVALANCHE_MIN_ADAPTIVE_QUERY_TIMEOUT{
+    2000};
+
+/**
+ * How many polls can be sent per event loop iteration when there are more
+ * items to poll than a single poll can carry.
+ */
+static constexpr size_t AVALANCHE_DEFAULT_MAX_POLLS_PER_TICK{4};
+
 /**
  * The size of the finalized items filter. It should be large enough that an
  * influx of inventories cannot roll any particular item out of the filter on
@@ -171,6 +190,7 @@ class Processor final : public NetEventsInterface {
     struct Query {
         NodeId nodeid;
         uint64_t round;
+        SteadyMilliseconds sent;
         SteadyMilliseconds timeout;
 
         /**
@@ -198,6 +218,16 @@ class Processor final : public NetEventsInterface {
 
     RWCollection<QuerySet> queries;
 
+    /** Polling statistics. */
+    std::atomic<uint64_t> pollsSent{0};
+    std::atomic<uint64_t> pollsTimedOut{0};
+    std::atomic<uint64_t> responsesReceived{0};
+    /**
+     * Smoothed time the nodes take to respond to our polls, in microseconds.
+     * It is only written from the message handler thread.
+     */
+    std::atomic<int64_t> smoothedResponseTime{0};
+
     /** Data required to participate. */
     struct PeerData;
     std::unique_ptr<PeerData> peerData;
@@ -329,6 +359,18 @@ public:
     bool startEventLoop(CScheduler &scheduler);
     bool stopEventLoop();
 
+    struct PollingStats {
+        uint64_t pollsSent;
+        uint64_t responsesReceived;
+        uint64_t pollsTimedOut;
+        size_t inflightQueries;
+        size_t pendingItems;
+        std::chrono::microseconds averageResponseTime;
+        std::chrono::milliseconds queryTimeout;
+        size_t maxPollsPerTick;
+    };
+    PollingStats getPollingStats() const;
+
     void avaproofsSent(NodeId nodeid) LOCKS_EXCLUDED(cs_main)
         EXCLUSIVE_LOCKS_REQUIRED(!cs_peerManager);
     int64_t getAvaproofsNodeCounter() const {
@@ -392,11 +434,28 @@ private:
         EXCLUSIVE_LOCKS_REQUIRED(!cs_peerManager, !cs_stakingRewards,
                                  !cs_finalizedItems);
     void clearTimedoutRequests() EXCLUSIVE_LOCKS_REQUIRED(!cs_peerManager);
-    std::vector<CInv> getInvsForNextPoll(bool forPoll = true)
+    /**
+     * Get the invs to poll next, ignoring the first skip items that could be
+     * polled because they are carried by another poll sent meanwhile.
+     */
+    std::vector<CInv> getInvsForNextPoll(bool forPoll = true, size_t skip = 0)
         EXCLUSIVE_LOCKS_REQUIRED(!cs_peerManager, !cs_finalizedItems);
+    /**
+     * Send a poll for the invs to the node, or to the next suitable one if it
+     * is gone. Return false if no node is left to poll.
+     */
+    bool sendPoll(NodeId nodeid, std::vector<CInv> invs)
+        EXCLUSIVE_LOCKS_REQUIRED(!cs_peerManager);
+    /** The time after which the polls sent now time out. */
+    std::chrono::milliseconds getQueryTimeout() const;
     bool sendHelloInternal(CNode *pfrom)
         EXCLUSIVE_LOCKS_REQUIRED(cs_delayedAvahelloNodeIds);
-    AnyVoteItem getVoteItemFromInv(const CInv &inv) const
+    /**
+     * Look up the items of the invs, in the same order. Each lock is taken
+     * once for all the items of its kind, rather than once per item.
+     */
+    std::vector<AnyVoteItem>
+    getVoteItemsFromInvs(const std::vector<CInv> &invs) const
         EXCLUSIVE_LOCKS_REQUIRED(!cs_peerManager);
 
     /**
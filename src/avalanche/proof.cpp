@@ -13,6 +13,7 @@
 #include <streams.h>
 #include <util/strencodings.h>
 #include <util/translation.h>
+#include <validationthreadpool.h>
 
 #include <tinyformat.h>
 
@@ -136,7 +137,8 @@ bool Proof::verify(const Amount &stakeUtxoDustThreshold,
                              "payout-script-non-standard");
     }
 
-    if (!master.VerifySchnorr(limitedProofId, signature)) {
+    const bool checkSignatures{!signaturesVerified};
+    if (checkSignatures && !master.VerifySchnorr(limitedProofId, signature)) {
         return state.Invalid(ProofValidationResult::INVALID_PROOF_SIGNATURE,
                              "invalid-proof-signature");
     }
@@ -163,7 +165,7 @@ bool Proof::verify(const Amount &stakeUtxoDustThreshold,
                                  "duplicated-stake");
         }
 
-        if (!ss.verify(getStakeCommitment())) {
+        if (checkSignatures && !ss.verify(getStakeCommitment())) {
             return state.Invalid(
                 ProofValidationResult::INVALID_STAKE_SIGNATURE,
                 "invalid-stake-signature",
@@ -171,9 +173,50 @@ bool Proof::verify(const Amount &stakeUtxoDustThreshold,
         }
     }
 
+    signaturesVerified = true;
     return true;
 }
 
+void Proof::preverifySignatures(const std::vector<ProofRef> &proofs) {
+    // Group the proofs so that each batch holds about SCHNORR_BATCH_SIZE
+    // signatures, without splitting a proof across batches so a valid batch
+    // vouches for all its proofs.
+    struct Batch {
+        std::vector<const Proof *> proofs;
+        std::vector<SchnorrSigCheck> checks;
+    };
+    std::vector<Batch> batches;
+    for (const ProofRef &proof : proofs) {
+        if (proof->signaturesVerified || proof->stakes.empty() ||
+            proof->stakes.size() > AVALANCHE_MAX_PROOF_STAKES) {
+            continue;
+        }
+        if (batches.empty() ||
+            batches.back().checks.size() >= SCHNORR_BATCH_SIZE) {
+            batches.emplace_back();
+        }
+        Batch &batch = batches.back();
+        batch.proofs.push_back(proof.get());
+        batch.checks.push_back(
+            {proof->limitedProofId, proof->signature, proof->master});
+        const StakeCommitment commitment{proof->getStakeCommitment()};
+        for (const SignedStake &ss : proof->stakes) {
+            const Stake &s = ss.getStake();
+            batch.checks.push_back(
+                {s.getHash(commitment), ss.getSignature(), s.getPubkey()});
+        }
+    }
+
+    GetValidationThreadPool().ParallelFor(batches.size(), [&](size_t i) {
+        if (!VerifySchnorrBatch(batches[i].checks)) {
+            return;
+        }
+        for (const Proof *proof : batches[i].proofs) {
+            proof->signaturesVerified = true;
+        }
+    });
+}
+
 bool Proof::verify(const Amount &stakeUtxoDustThreshold,
                    const ChainstateManager &chainman,
                    ProofValidationState &state) const {
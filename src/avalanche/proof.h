@@ -16,6 +16,7 @@
 #include <validation.h> // For ChainstateManager and cs_main
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <optional>
 #include <vector>
@@ -115,6 +116,12 @@ class Proof {
     Score score;
     void computeScore();
 
+    /**
+     * Set once all the signatures are known to be valid, so they are not
+     * checked again each time the proof is verified against a new tip.
+     */
+    mutable std::atomic<bool> signaturesVerified{false};
+
     IMPLEMENT_RCU_REFCOUNT(uint64_t);
 
 public:
@@ -152,6 +159,7 @@ public:
         READWRITE(obj.payoutScriptPubKey, obj.signature);
         SER_READ(obj, obj.computeProofId());
         SER_READ(obj, obj.computeScore());
+        SER_READ(obj, obj.signaturesVerified = false);
     }
 
     static bool FromHex(Proof &proof, const std::string &hexProof,
@@ -181,6 +189,14 @@ public:
                 const ChainstateManager &chainman,
                 ProofValidationState &state) const
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Batch verify the signatures of the proofs on the validation workers, so
+     * that verifying them afterwards skips the signature checks. The proofs
+     * in a failing batch are left to be checked one by one by verify().
+     */
+    static void
+    preverifySignatures(const std::vector<RCUPtr<const Proof>> &proofs);
 };
 
 using ProofRef = RCUPtr<const Proof>;
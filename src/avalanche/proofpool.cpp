@@ -17,36 +17,36 @@ ProofPool::addProofIfNoConflict(const ProofRef &proof,
     // Make sure the set is empty before we add items
     conflictingProofs.clear();
 
-    auto &poolView = pool.get<by_proofid>();
-    if (poolView.find(proofid) != poolView.end()) {
+    if (proofs.find(proofid) != proofs.end()) {
         return AddProofStatus::DUPLICATED;
     }
 
-    // Attach UTXOs to this proof.
-    for (size_t i = 0; i < proof->getStakes().size(); i++) {
-        auto p = pool.emplace(i, proof);
-        if (!p.second) {
-            // We have a collision with an existing proof.
-            conflictingProofs.insert(p.first->proof);
+    // Look for collisions with the existing proofs before attaching anything.
+    for (const auto &s : proof->getStakes()) {
+        auto it = pool.find(s.getStake().getUTXO());
+        if (it != pool.end()) {
+            conflictingProofs.insert(it->proof);
         }
     }
 
-    // If there is a conflict, just cleanup the mess.
     if (conflictingProofs.size() > 0) {
-        for (const auto &s : proof->getStakes()) {
-            auto it = pool.find(s.getStake().getUTXO());
-            assert(it != pool.end());
+        return AddProofStatus::REJECTED;
+    }
 
-            // We need to delete that one.
-            if (it->proof->getId() == proofid) {
-                pool.erase(it);
+    // Attach UTXOs to this proof.
+    for (size_t i = 0; i < proof->getStakes().size(); i++) {
+        if (!pool.emplace(i, proof).second) {
+            // The proof stakes the same UTXO twice, just cleanup the mess.
+            conflictingProofs.insert(proof);
+            for (size_t j = 0; j < i; j++) {
+                pool.erase(proof->getStakes()[j].getStake().getUTXO());
             }
-        }
 
-        return AddProofStatus::REJECTED;
+            return AddProofStatus::REJECTED;
+        }
     }
 
-    cacheClean = false;
+    proofs.insert(proof);
     return AddProofStatus::SUCCEED;
 }
 
@@ -69,7 +69,6 @@ ProofPool::addProofIfPreferred(const ProofRef &proof,
     status = addProofIfNoConflict(proof);
     assert(status == AddProofStatus::SUCCEED);
 
-    cacheClean = false;
     return AddProofStatus::SUCCEED;
 }
 
@@ -77,22 +76,29 @@ ProofPool::addProofIfPreferred(const ProofRef &proof,
 // reference to a proof member. This proof will be deleted during the erasure
 // loop so we pass it by value.
 bool ProofPool::removeProof(ProofId proofid) {
-    cacheClean = false;
-    auto &poolView = pool.get<by_proofid>();
-    return poolView.erase(proofid);
+    auto it = proofs.find(proofid);
+    if (it == proofs.end()) {
+        return false;
+    }
+
+    for (const auto &s : (*it)->getStakes()) {
+        pool.erase(s.getStake().getUTXO());
+    }
+
+    proofs.erase(it);
+    return true;
 }
 
 std::unordered_set<ProofRef, SaltedProofHasher>
 ProofPool::rescan(PeerManager &peerManager) {
-    auto previousPool = std::move(pool);
+    auto previousProofs = std::move(proofs);
+    proofs.clear();
     pool.clear();
-    cacheClean = false;
 
     std::unordered_set<ProofRef, SaltedProofHasher> registeredProofs;
-    for (auto &entry : previousPool) {
-        if (registeredProofs.insert(entry.proof).second) {
-            peerManager.registerProof(entry.proof);
-        }
+    for (const ProofRef &proof : previousProofs) {
+        registeredProofs.insert(proof);
+        peerManager.registerProof(proof);
     }
 
     return registeredProofs;
@@ -100,19 +106,18 @@ ProofPool::rescan(PeerManager &peerManager) {
 
 ProofIdSet ProofPool::getProofIds() const {
     ProofIdSet proofIds;
+    proofIds.reserve(proofs.size());
 
-    auto &poolView = pool.get<by_proofid>();
-    for (auto it = poolView.begin(); it != poolView.end(); it++) {
-        proofIds.insert(it->proof->getId());
+    for (const ProofRef &proof : proofs) {
+        proofIds.insert(proof->getId());
     }
 
     return proofIds;
 }
 
 ProofRef ProofPool::getProof(const ProofId &proofid) const {
-    auto &poolView = pool.get<by_proofid>();
-    auto it = poolView.find(proofid);
-    return it == poolView.end() ? ProofRef() : it->proof;
+    auto it = proofs.find(proofid);
+    return it == proofs.end() ? ProofRef() : *it;
 }
 
 ProofRef ProofPool::getProof(const COutPoint &outpoint) const {
@@ -121,22 +126,9 @@ ProofRef ProofPool::getProof(const COutPoint &outpoint) const {
 }
 
 ProofRef ProofPool::getLowestScoreProof() const {
-    auto &poolView = pool.get<by_proof_score>();
-    return poolView.rbegin() == poolView.rend() ? ProofRef()
-                                                : poolView.rbegin()->proof;
-}
-
-size_t ProofPool::countProofs() const {
-    if (cacheClean) {
-        return cacheProofCount;
-    }
-
-    size_t count = 0;
-    forEachProof([&](const ProofRef &proof) { count++; });
-
-    cacheProofCount = count;
-    cacheClean = true;
-    return cacheProofCount;
+    auto &proofsView = proofs.get<by_proof_score>();
+    return proofsView.rbegin() == proofsView.rend() ? ProofRef()
+                                                    : *proofsView.rbegin();
 }
 
 } // namespace avalanche
@@ -12,8 +12,8 @@
 #include <primitives/transaction.h>
 
 #include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/mem_fun.hpp>
-#include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
 
@@ -40,10 +40,10 @@ struct by_utxo;
 struct by_proofid;
 struct by_proof_score;
 
-struct ProofPoolEntryProofIdKeyExtractor {
+struct ProofRefProofIdKeyExtractor {
     using result_type = ProofId;
-    result_type operator()(const ProofPoolEntry &entry) const {
-        return entry.proof->getId();
+    result_type operator()(const ProofRef &proof) const {
+        return proof->getId();
     }
 };
 
@@ -53,6 +53,9 @@ using ProofIdSet = std::unordered_set<ProofId, SaltedProofIdHasher>;
 
 /**
  * Map a proof to each utxo. A proof can be mapped with several utxos.
+ *
+ * The utxos and the proofs are indexed separately, so the proof id and score
+ * indexes get a single entry per proof rather than one per staked utxo.
  */
 class ProofPool {
     boost::multi_index_container<
@@ -63,20 +66,21 @@ class ProofPool {
                 bmi::tag<by_utxo>,
                 bmi::const_mem_fun<ProofPoolEntry, const COutPoint &,
                                    &ProofPoolEntry::getUTXO>,
-                SaltedOutpointHasher>,
-            // index by proofid
-            bmi::hashed_non_unique<bmi::tag<by_proofid>,
-                                   ProofPoolEntryProofIdKeyExtractor,
-                                   SaltedProofIdHasher>,
-            // index by proof score
-            bmi::ordered_non_unique<
-                bmi::tag<by_proof_score>,
-                bmi::member<ProofPoolEntry, ProofRef, &ProofPoolEntry::proof>,
-                ProofComparatorByScore>>>
+                SaltedOutpointHasher>>>
         pool;
 
-    mutable bool cacheClean = true;
-    mutable size_t cacheProofCount = 0;
+    boost::multi_index_container<
+        ProofRef,
+        bmi::indexed_by<
+            // index by proofid
+            bmi::hashed_unique<bmi::tag<by_proofid>,
+                               ProofRefProofIdKeyExtractor,
+                               SaltedProofIdHasher>,
+            // index by proof score
+            bmi::ordered_non_unique<bmi::tag<by_proof_score>,
+                                    bmi::identity<ProofRef>,
+                                    ProofComparatorByScore>>>
+        proofs;
 
 public:
     enum AddProofStatus {
@@ -116,14 +120,8 @@ public:
     rescan(PeerManager &peerManager);
 
     template <typename Callable> void forEachProof(Callable &&func) const {
-        ProofId lastProofId;
-        auto &poolView = pool.get<by_proofid>();
-        for (auto it = poolView.begin(); it != poolView.end(); it++) {
-            const ProofId &proofId = it->proof->getId();
-            if (lastProofId != proofId) {
-                func(it->proof);
-                lastProofId = proofId;
-            }
+        for (const ProofRef &proof : proofs) {
+            func(proof);
         }
     }
 
@@ -132,8 +130,9 @@ public:
     ProofRef getProof(const COutPoint &outpoint) const;
     ProofRef getLowestScoreProof() const;
 
+    /** The number of utxos staked by the proofs in the pool. */
     size_t size() const { return pool.size(); }
-    size_t countProofs() const;
+    size_t countProofs() const { return proofs.size(); }
 };
 
 } // namespace avalanche
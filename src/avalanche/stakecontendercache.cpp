@@ -164,20 +164,22 @@ int StakeContenderCache::getVoteStatus(const StakeContenderId &contenderId,
 
 bool StakeContenderCache::getWinners(const BlockHash &prevblockhash,
                                      std::vector<CScript> &payouts) const {
-    // Winners determined by avalanche are sorted by reward rank
-    std::vector<const StakeContenderCacheEntry *> rankedWinners;
+    // Winners determined by avalanche are sorted by reward rank. The rank is
+    // computed once per winner rather than for every comparison, as it
+    // involves hashing.
+    std::vector<std::pair<double, const StakeContenderCacheEntry *>>
+        rankedWinners;
     auto &view = contenders.get<by_prevblockhash>();
     auto [begin, end] = view.equal_range(prevblockhash);
     for (auto it = begin; it != end; it++) {
         if (it->isInWinnerSet()) {
-            rankedWinners.push_back(&(*it));
+            rankedWinners.emplace_back(it->computeRewardRank(), &(*it));
         }
     }
 
     std::sort(rankedWinners.begin(), rankedWinners.end(),
-              [](const StakeContenderCacheEntry *left,
-                 const StakeContenderCacheEntry *right) {
-                  return left->computeRewardRank() < right->computeRewardRank();
+              [](const auto &left, const auto &right) {
+                  return left.first < right.first;
               });
 
     payouts.clear();
@@ -196,7 +198,7 @@ bool StakeContenderCache::getWinners(const BlockHash &prevblockhash,
     }
 
     // Add ranked winners, preserving reward rank order
-    for (const auto &rankedWinner : rankedWinners) {
+    for (const auto &[rank, rankedWinner] : rankedWinners) {
         payouts.push_back(rankedWinner->payoutScriptPubkey);
     }
 
@@ -53,6 +53,18 @@ BOOST_AUTO_TEST_CASE(verify_random) {
 
     dgb.addLevel(l1key, l2key.GetPubKey());
     CheckDelegation(dgb.build(), p, l2key.GetPubKey());
+
+    // An invalid signature at the last level is caught, even though the
+    // signatures of the levels are checked all at once.
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << dgb.build();
+    ss[ss.size() - 1] ^= std::byte{1};
+    Delegation dg;
+    ss >> dg;
+    DelegationState state;
+    CPubKey pubkey;
+    BOOST_CHECK(!dg.verify(state, pubkey));
+    BOOST_CHECK(state.GetResult() == DelegationResult::INVALID_SIGNATURE);
 }
 
 // Proof master priv:
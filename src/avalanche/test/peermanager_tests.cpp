@@ -28,6 +28,7 @@
 
 #include <limits>
 #include <optional>
+#include <set>
 #include <unordered_map>
 
 using namespace avalanche;
@@ -496,6 +497,51 @@ BOOST_AUTO_TEST_CASE(compact_slots) {
     BOOST_CHECK_EQUAL(pm.getFragmentation(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(select_peer_fragmented) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    avalanche::PeerManager pm(PROOF_DUST_THRESHOLD, chainman);
+
+    // Add peers with various scores.
+    std::vector<PeerId> peerids;
+    for (int i = 0; i < 20; i++) {
+        auto p = buildRandomProof(chainman.ActiveChainstate(),
+                                  (i % 3 + 1) * MIN_VALID_PROOF_SCORE);
+        peerids.push_back(TestPeerManager::registerAndGetPeerId(pm, p));
+        BOOST_CHECK(pm.addNode(InsecureRand32(), p->getId()));
+    }
+
+    // Remove most of them, leaving dead slots all around.
+    std::set<PeerId> remaining;
+    for (size_t i = 0; i < peerids.size(); i++) {
+        if (i % 5 == 3) {
+            remaining.insert(peerids[i]);
+            continue;
+        }
+        BOOST_CHECK(pm.removePeer(peerids[i]));
+        BOOST_CHECK(pm.verify());
+    }
+    BOOST_CHECK_GT(pm.getFragmentation(), 0);
+
+    // A live peer is always drawn, without compacting.
+    for (int i = 0; i < 1000; i++) {
+        BOOST_CHECK_EQUAL(remaining.count(pm.selectPeer()), 1);
+    }
+
+    // The dead slots are filled again after compaction.
+    pm.compact();
+    BOOST_CHECK(pm.verify());
+    for (int i = 0; i < 5; i++) {
+        auto p = buildRandomProof(chainman.ActiveChainstate(),
+                                  MIN_VALID_PROOF_SCORE);
+        remaining.insert(TestPeerManager::registerAndGetPeerId(pm, p));
+        BOOST_CHECK(pm.addNode(InsecureRand32(), p->getId()));
+        BOOST_CHECK(pm.verify());
+    }
+    for (int i = 0; i < 1000; i++) {
+        BOOST_CHECK_EQUAL(remaining.count(pm.selectPeer()), 1);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(node_crud) {
     ChainstateManager &chainman = *Assert(m_node.chainman);
     avalanche::PeerManager pm(PROOF_DUST_THRESHOLD, chainman);
@@ -3152,6 +3198,60 @@ BOOST_AUTO_TEST_CASE(avapeers_dump) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(avapeers_dump_immature) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    gArgs.ForceSetArg("-avaproofstakeutxoconfirmations", "2");
+    avalanche::PeerManager pm(PROOF_DUST_THRESHOLD, chainman);
+
+    auto key = CKey::MakeCompressedKey();
+    const int immatureHeight = 100;
+
+    std::vector<ProofRef> immatureProofs;
+    for (size_t i = 0; i < 5; i++) {
+        COutPoint outpoint = COutPoint(TxId(GetRandHash()), 0);
+        auto proof = buildProofWithOutpoints(
+            key, {outpoint}, PROOF_DUST_THRESHOLD, key, 0, immatureHeight);
+        addCoin(chainman.ActiveChainstate(), outpoint, key,
+                PROOF_DUST_THRESHOLD, immatureHeight);
+        BOOST_CHECK(!pm.registerProof(proof));
+        BOOST_CHECK(pm.isImmature(proof->getId()));
+        immatureProofs.push_back(proof);
+    }
+
+    auto matureProof = buildRandomProof(chainman.ActiveChainstate(),
+                                        MIN_VALID_PROOF_SCORE,
+                                        immatureHeight - 1);
+    BOOST_CHECK(pm.registerProof(matureProof));
+
+    const fs::path testDumpPath = "test_avapeers_dump_immature.dat";
+    BOOST_CHECK(pm.dumpPeersToFile(testDumpPath));
+
+    // The immature proofs are loaded back in the immature pool.
+    {
+        avalanche::PeerManager loadedPm(PROOF_DUST_THRESHOLD, chainman);
+        std::unordered_set<ProofRef, SaltedProofHasher> registeredProofs;
+        BOOST_CHECK(loadedPm.loadPeersFromFile(testDumpPath, registeredProofs));
+        BOOST_CHECK_EQUAL(registeredProofs.size(), 1);
+        BOOST_CHECK_EQUAL(registeredProofs.count(matureProof), 1);
+        for (const auto &proof : immatureProofs) {
+            BOOST_CHECK(loadedPm.isImmature(proof->getId()));
+        }
+    }
+
+    // The proofs which matured meanwhile make new peers.
+    gArgs.ForceSetArg("-avaproofstakeutxoconfirmations", "1");
+    {
+        avalanche::PeerManager loadedPm(PROOF_DUST_THRESHOLD, chainman);
+        std::unordered_set<ProofRef, SaltedProofHasher> registeredProofs;
+        BOOST_CHECK(loadedPm.loadPeersFromFile(testDumpPath, registeredProofs));
+        BOOST_CHECK_EQUAL(registeredProofs.size(), immatureProofs.size() + 1);
+        for (const auto &proof : immatureProofs) {
+            BOOST_CHECK(loadedPm.isBoundToPeer(proof->getId()));
+            BOOST_CHECK_EQUAL(registeredProofs.count(proof), 1);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(dangling_proof_invalidation) {
     ChainstateManager &chainman = *Assert(m_node.chainman);
     avalanche::PeerManager pm(PROOF_DUST_THRESHOLD, chainman);
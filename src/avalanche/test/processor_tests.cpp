@@ -1116,6 +1116,58 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(poll_inflight_count, P, VoteItemProviders) {
     BOOST_CHECK(invs[0].hash == itemid);
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(poll_several_per_tick, P, VoteItemProviders) {
+    P provider(this);
+
+    setArg("-avamaxpollspertick", "0");
+    bilingual_str error;
+    BOOST_CHECK(!Processor::MakeProcessor(
+        *m_node.args, *m_node.chain, m_node.connman.get(),
+        *Assert(m_node.chainman), m_node.mempool.get(), *m_node.scheduler,
+        error));
+
+    setArg("-avamaxpollspertick", "3");
+    m_processor = Processor::MakeProcessor(
+        *m_node.args, *m_node.chain, m_node.connman.get(),
+        *Assert(m_node.chainman), m_node.mempool.get(), *m_node.scheduler,
+        error);
+    BOOST_CHECK(m_processor);
+
+    ConnectNodes();
+
+    // A few items fit in a single poll.
+    std::vector<uint256> itemids;
+    const auto addItems = [&](size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            const auto item = provider.buildVoteItem();
+            itemids.push_back(provider.getVoteItemId(item));
+            BOOST_CHECK(addToReconcile(item));
+        }
+    };
+    addItems(AVALANCHE_MAX_ELEMENT_POLL);
+
+    uint64_t round = getRound();
+    runEventLoop();
+    BOOST_CHECK_EQUAL(getRound(), round + 1);
+    BOOST_CHECK_EQUAL(m_processor->getPollingStats().pollsSent, 1);
+    BOOST_CHECK_EQUAL(m_processor->getPollingStats().inflightQueries, 1);
+
+    // More items are split across several polls, up to the limit.
+    addItems(2 * AVALANCHE_MAX_ELEMENT_POLL + 1);
+
+    round = getRound();
+    runEventLoop();
+    BOOST_CHECK_EQUAL(getRound(), round + 3);
+
+    const Processor::PollingStats stats = m_processor->getPollingStats();
+    BOOST_CHECK_EQUAL(stats.pollsSent, 4);
+    BOOST_CHECK_EQUAL(stats.inflightQueries, 4);
+    BOOST_CHECK_EQUAL(stats.pendingItems, itemids.size());
+    BOOST_CHECK_EQUAL(stats.maxPollsPerTick, 3);
+    BOOST_CHECK_EQUAL(stats.responsesReceived, 0);
+    BOOST_CHECK_EQUAL(stats.pollsTimedOut, 0);
+}
+
 BOOST_AUTO_TEST_CASE(quorum_diversity) {
     std::vector<VoteItemUpdate> updates;
 
@@ -873,6 +873,58 @@ BOOST_AUTO_TEST_CASE(verify) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(preverify_signatures) {
+    Chainstate &active_chainstate = Assert(m_node.chainman)->ActiveChainstate();
+
+    std::vector<ProofRef> proofs;
+    for (int i = 0; i < 100; i++) {
+        proofs.push_back(buildRandomProof(active_chainstate,
+                                          MIN_VALID_PROOF_SCORE + i));
+    }
+
+    // Reuse the stakes of a valid proof under another master, so the master
+    // signature is valid but the stake signatures are not.
+    const ProofRef &stolen = proofs[42];
+    const auto masterKey = CKey::MakeCompressedKey();
+    const Proof unsigned_proof(0, stolen->getExpirationTime(),
+                               masterKey.GetPubKey(), stolen->getStakes(),
+                               UNSPENDABLE_ECREG_PAYOUT_SCRIPT, SchnorrSig{});
+    SchnorrSig signature;
+    BOOST_CHECK(
+        masterKey.SignSchnorr(unsigned_proof.getLimitedId(), signature));
+    const auto badStakeSigProof = ProofRef::make(
+        0, stolen->getExpirationTime(), masterKey.GetPubKey(),
+        stolen->getStakes(), UNSPENDABLE_ECREG_PAYOUT_SCRIPT, signature);
+    proofs.insert(proofs.begin() + 50, badStakeSigProof);
+
+    const auto badMasterSigProof = ProofRef::make(
+        0, stolen->getExpirationTime(), masterKey.GetPubKey(),
+        stolen->getStakes(), UNSPENDABLE_ECREG_PAYOUT_SCRIPT, SchnorrSig{});
+    proofs.push_back(badMasterSigProof);
+
+    // Preverifying twice is harmless, and the outcome of the verification
+    // doesn't depend on the batch the proof was in.
+    for (int i = 0; i < 2; i++) {
+        Proof::preverifySignatures(proofs);
+
+        for (const ProofRef &p : proofs) {
+            ProofValidationResult expected_state =
+                hasDustStake(p) ? ProofValidationResult::DUST_THRESHOLD
+                                : ProofValidationResult::NONE;
+            if (p == badStakeSigProof) {
+                expected_state = ProofValidationResult::INVALID_STAKE_SIGNATURE;
+            } else if (p == badMasterSigProof) {
+                expected_state = ProofValidationResult::INVALID_PROOF_SIGNATURE;
+            }
+
+            ProofValidationState state;
+            BOOST_CHECK_EQUAL(p->verify(PROOF_DUST_THRESHOLD, state),
+                              expected_state == ProofValidationResult::NONE);
+            BOOST_CHECK(state.GetResult() == expected_state);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(deterministic_proofid) {
     auto key = CKey::MakeCompressedKey();
 
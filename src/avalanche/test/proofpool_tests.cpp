@@ -105,6 +105,56 @@ BOOST_AUTO_TEST_CASE(add_remove_proof_no_conflict) {
     BOOST_CHECK_EQUAL(testPool.getProofIds().size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(multi_utxo_proofs) {
+    ProofPool testPool;
+
+    const CKey key = CKey::MakeCompressedKey();
+    std::vector<COutPoint> outpoints;
+    for (size_t i = 0; i < 3; i++) {
+        outpoints.emplace_back(TxId(GetRandHash()), 0);
+    }
+
+    auto buildProof = [&](uint64_t sequence,
+                          const std::vector<COutPoint> &stakedOutpoints) {
+        ProofBuilder pb(sequence, 0, key, UNSPENDABLE_ECREG_PAYOUT_SCRIPT);
+        for (const COutPoint &outpoint : stakedOutpoints) {
+            BOOST_CHECK(pb.addUTXO(outpoint, 10 * COIN, 123456, false, key));
+        }
+        return pb.build();
+    };
+
+    // A proof is counted once, whatever the number of utxos it stakes.
+    auto proof = buildProof(10, outpoints);
+    BOOST_CHECK_EQUAL(testPool.addProofIfNoConflict(proof),
+                      ProofPool::AddProofStatus::SUCCEED);
+    BOOST_CHECK_EQUAL(testPool.countProofs(), 1);
+    BOOST_CHECK_EQUAL(testPool.size(), 3);
+    for (const COutPoint &outpoint : outpoints) {
+        BOOST_CHECK_EQUAL(testPool.getProof(outpoint), proof);
+    }
+
+    // A conflict on the last utxo leaves the pool untouched.
+    const COutPoint otherOutpoint{TxId(GetRandHash()), 0};
+    ProofPool::ConflictingProofSet conflictingProofs;
+    BOOST_CHECK_EQUAL(
+        testPool.addProofIfNoConflict(
+            buildProof(20, {otherOutpoint, outpoints.back()}),
+            conflictingProofs),
+        ProofPool::AddProofStatus::REJECTED);
+    BOOST_CHECK_EQUAL(conflictingProofs.size(), 1);
+    BOOST_CHECK_EQUAL(*conflictingProofs.begin(), proof);
+    BOOST_CHECK_EQUAL(testPool.countProofs(), 1);
+    BOOST_CHECK_EQUAL(testPool.size(), 3);
+    BOOST_CHECK(!testPool.getProof(otherOutpoint));
+
+    // Removing the proof releases all its utxos.
+    BOOST_CHECK(testPool.removeProof(proof->getId()));
+    BOOST_CHECK(!testPool.removeProof(proof->getId()));
+    BOOST_CHECK_EQUAL(testPool.countProofs(), 0);
+    BOOST_CHECK_EQUAL(testPool.size(), 0);
+    BOOST_CHECK(!testPool.getLowestScoreProof());
+}
+
 BOOST_AUTO_TEST_CASE(rescan) {
     gArgs.ForceSetArg("-avaproofstakeutxoconfirmations", "1");
     ProofPool testPool;
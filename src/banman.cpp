@@ -72,6 +72,8 @@ void BanMan::ClearBanned() {
         LOCK(m_cs_banned);
         m_discouraged.reset();
         m_banned.clear();
+        m_ban_prefixes.fill(0);
+        m_non_prefix_bans = 0;
         m_is_dirty = true;
     }
     // store banlist to disk
@@ -89,6 +91,22 @@ bool BanMan::IsDiscouraged(const CNetAddr &net_addr) {
 bool BanMan::IsBanned(const CNetAddr &net_addr) {
     auto current_time = GetTime();
     LOCK(m_cs_banned);
+    if (net_addr.IsIPv4() || net_addr.IsIPv6()) {
+        const size_t max_length{net_addr.IsIPv4() ? ADDR_IPV4_SIZE * 8
+                                                  : ADDR_IPV6_SIZE * 8};
+        for (size_t length = 0; length <= max_length; ++length) {
+            if (m_ban_prefixes[length] == 0) {
+                continue;
+            }
+            auto it = m_banned.find(CSubNet(net_addr, length));
+            if (it != m_banned.end() && current_time < it->second.nBanUntil) {
+                return true;
+            }
+        }
+    }
+    if (m_non_prefix_bans == 0) {
+        return false;
+    }
     for (const auto &it : m_banned) {
         CSubNet sub_net = it.first;
         CBanEntry ban_entry = it.second;
@@ -139,8 +157,12 @@ void BanMan::Ban(const CSubNet &sub_net, int64_t ban_time_offset,
 
     {
         LOCK(m_cs_banned);
-        if (m_banned[sub_net].nBanUntil < ban_entry.nBanUntil) {
-            m_banned[sub_net] = ban_entry;
+        auto [it, inserted] = m_banned.try_emplace(sub_net);
+        if (inserted) {
+            UpdateBanPrefixes(sub_net, /*added=*/true);
+        }
+        if (it->second.nBanUntil < ban_entry.nBanUntil) {
+            it->second = ban_entry;
             m_is_dirty = true;
         } else {
             return;
@@ -165,6 +187,7 @@ bool BanMan::Unban(const CSubNet &sub_net) {
         if (m_banned.erase(sub_net) == 0) {
             return false;
         }
+        UpdateBanPrefixes(sub_net, /*added=*/false);
         m_is_dirty = true;
     }
     if (m_client_interface) {
@@ -187,9 +210,29 @@ void BanMan::GetBanned(banmap_t &banmap) {
 void BanMan::SetBanned(const banmap_t &banmap) {
     LOCK(m_cs_banned);
     m_banned = banmap;
+    m_ban_prefixes.fill(0);
+    m_non_prefix_bans = 0;
+    for (const auto &[sub_net, ban_entry] : m_banned) {
+        UpdateBanPrefixes(sub_net, /*added=*/true);
+    }
     m_is_dirty = true;
 }
 
+void BanMan::UpdateBanPrefixes(const CSubNet &sub_net, bool added) {
+    AssertLockHeld(m_cs_banned);
+    if (!sub_net.IsValid()) {
+        // Invalid subnets match nothing.
+        return;
+    }
+    const auto length{sub_net.GetPrefixLength()};
+    uint32_t &count{length ? m_ban_prefixes.at(*length) : m_non_prefix_bans};
+    if (added) {
+        ++count;
+    } else {
+        --count;
+    }
+}
+
 void BanMan::SweepBanned() {
     int64_t now = GetTime();
     bool notify_ui = false;
@@ -201,6 +244,7 @@ void BanMan::SweepBanned() {
             CBanEntry ban_entry = (*it).second;
             if (!sub_net.IsValid() || now > ban_entry.nBanUntil) {
                 m_banned.erase(it++);
+                UpdateBanPrefixes(sub_net, /*added=*/false);
                 m_is_dirty = true;
                 notify_ui = true;
                 LogPrint(
@@ -11,6 +11,7 @@
 #include <sync.h>
 #include <util/fs.h>
 
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <memory>
@@ -88,9 +89,19 @@ private:
     void SetBannedSetDirty(bool dirty = true);
     //! clean unused entries (if bantime has expired)
     void SweepBanned();
+    //! account for sub_net being added to or removed from m_banned
+    void UpdateBanPrefixes(const CSubNet &sub_net, bool added)
+        EXCLUSIVE_LOCKS_REQUIRED(m_cs_banned);
 
     RecursiveMutex m_cs_banned;
     banmap_t m_banned GUARDED_BY(m_cs_banned);
+    //! The number of banned subnets by prefix length. An address can only be
+    //! banned by the subnets of the lengths in use, so IsBanned() looks those
+    //! up rather than matching the address against the whole ban list.
+    std::array<uint32_t, 16 * 8 + 1> m_ban_prefixes GUARDED_BY(m_cs_banned){};
+    //! The number of banned subnets with a netmask that is not a prefix, which
+    //! only older ban lists can contain. They are matched one by one.
+    uint32_t m_non_prefix_bans GUARDED_BY(m_cs_banned){0};
     bool m_is_dirty GUARDED_BY(m_cs_banned);
     CClientUIInterface *m_client_interface = nullptr;
     CBanDB m_ban_db;
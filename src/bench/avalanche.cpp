@@ -0,0 +1,295 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <avalanche/compactproofs.h>
+#include <avalanche/peermanager.h>
+#include <avalanche/processor.h>
+#include <avalanche/proofbuilder.h>
+#include <avalanche/stakecontendercache.h>
+#include <avalanche/validation.h>
+#include <bench/bench.h>
+#include <chain.h>
+#include <key.h>
+#include <primitives/blockhash.h>
+#include <random.h>
+#include <script/standard.h>
+#include <util/time.h>
+#include <util/translation.h>
+#include <validation.h>
+
+#include <test/util/setup_common.h>
+
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace avalanche;
+
+namespace avalanche {
+namespace {
+    struct AvalancheTest {
+        static void addQuery(Processor &p, NodeId nodeid, uint64_t round,
+                             std::vector<CInv> invs) {
+            const auto now = Now<SteadyMilliseconds>();
+            p.queries.getWriteView()->insert(
+                {nodeid, round, now, now + std::chrono::minutes{1},
+                 std::move(invs)});
+        }
+
+        static void addVoteRecord(Processor &p, const AnyVoteItem &item) {
+            p.voteRecords.getWriteView()->insert(
+                std::make_pair(item, VoteRecord(true)));
+        }
+    };
+} // namespace
+} // namespace avalanche
+
+namespace {
+// The stakes are confirmed at the genesis block, which is the tip.
+std::unique_ptr<const TestingSetup> MakeSetup() {
+    return MakeNoLogFileContext<const TestingSetup>(
+        CBaseChainParams::REGTEST, {"-avaproofstakeutxoconfirmations=1"});
+}
+
+/** Build proofs with a stake each, which are added to the UTXO set. */
+std::vector<ProofRef> BuildProofs(const TestingSetup &setup,
+                                  size_t num_proofs) {
+    Chainstate &chainstate = setup.m_node.chainman->ActiveChainstate();
+    FastRandomContext rng(/*fDeterministic=*/true);
+    std::vector<ProofRef> proofs;
+    proofs.reserve(num_proofs);
+    for (size_t i = 0; i < num_proofs; ++i) {
+        const CKey key = CKey::MakeCompressedKey();
+        const COutPoint outpoint(TxId(rng.rand256()), 0);
+        const CScript script =
+            GetScriptForDestination(PKHash(key.GetPubKey()));
+        {
+            LOCK(cs_main);
+            chainstate.CoinsTip().AddCoin(
+                outpoint,
+                Coin(CTxOut(PROOF_DUST_THRESHOLD, script), 0, false), false);
+        }
+
+        // The payout scripts are unique, like the winners of the contenders
+        ProofBuilder pb(0, 0, CKey::MakeCompressedKey(), script);
+        const bool added =
+            pb.addUTXO(outpoint, PROOF_DUST_THRESHOLD, 0, false, key);
+        assert(added);
+        proofs.push_back(pb.build());
+    }
+    return proofs;
+}
+
+std::unique_ptr<avalanche::PeerManager>
+MakePeerManager(const TestingSetup &setup,
+                const std::vector<ProofRef> &proofs) {
+    auto pm = std::make_unique<avalanche::PeerManager>(
+        PROOF_DUST_THRESHOLD, *setup.m_node.chainman);
+    for (const ProofRef &proof : proofs) {
+        const bool registered = pm->registerProof(proof);
+        assert(registered);
+    }
+    return pm;
+}
+} // namespace
+
+static void AvalancheVerifyProof(benchmark::Bench &bench) {
+    const auto setup = MakeSetup();
+    const std::vector<ProofRef> proofs = BuildProofs(*setup, 1000);
+    const ChainstateManager &chainman = *setup->m_node.chainman;
+
+    size_t i = 0;
+    bench.run([&] {
+        ProofValidationState state;
+        LOCK(cs_main);
+        const bool valid = proofs[i++ % proofs.size()]->verify(
+            PROOF_DUST_THRESHOLD, chainman, state);
+        assert(valid);
+    });
+}
+
+static void RegisterProofs(benchmark::Bench &bench, size_t num_proofs) {
+    const auto setup = MakeSetup();
+    const std::vector<ProofRef> proofs = BuildProofs(*setup, num_proofs);
+
+    bench.batch(num_proofs).unit("proof").run(
+        [&] { MakePeerManager(*setup, proofs); });
+}
+
+static void AvalancheRegisterProofs1k(benchmark::Bench &bench) {
+    RegisterProofs(bench, 1000);
+}
+static void AvalancheRegisterProofs10k(benchmark::Bench &bench) {
+    RegisterProofs(bench, 10000);
+}
+
+static void SelectNode(benchmark::Bench &bench, size_t num_proofs) {
+    const auto setup = MakeSetup();
+    const std::vector<ProofRef> proofs = BuildProofs(*setup, num_proofs);
+    const auto pm = MakePeerManager(*setup, proofs);
+    NodeId nodeid = 0;
+    for (const ProofRef &proof : proofs) {
+        const bool added = pm->addNode(nodeid++, proof->getId());
+        assert(added);
+    }
+
+    bench.run([&] {
+        const NodeId selected = pm->selectNode();
+        assert(selected != NO_NODE);
+    });
+}
+
+static void AvalancheSelectNode1k(benchmark::Bench &bench) {
+    SelectNode(bench, 1000);
+}
+static void AvalancheSelectNode10k(benchmark::Bench &bench) {
+    SelectNode(bench, 10000);
+}
+
+// The proofs are polled by 64 nodes in turn, with the most items per poll.
+// The finalized proofs are voted on again, so it stays in a steady state.
+static void AvalancheRegisterVotes(benchmark::Bench &bench) {
+    constexpr NodeId NUM_NODES{64};
+    const auto setup = MakeSetup();
+    const std::vector<ProofRef> proofs = BuildProofs(*setup, 1000);
+
+    const node::NodeContext &node = setup->m_node;
+    bilingual_str error;
+    const auto processor = Processor::MakeProcessor(
+        *node.args, *node.chain, node.connman.get(), *node.chainman,
+        node.mempool.get(), *node.scheduler, error);
+    assert(processor);
+    for (const ProofRef &proof : proofs) {
+        const bool added =
+            processor->withPeerManager([&](avalanche::PeerManager &pm) {
+                return pm.registerProof(proof);
+            }) &&
+            processor->addToReconcile(proof);
+        assert(added);
+    }
+
+    uint64_t round = 0;
+    size_t next_proof = 0;
+    std::vector<VoteItemUpdate> updates;
+    bench.batch(AVALANCHE_MAX_ELEMENT_POLL).unit("vote").run([&] {
+        std::vector<CInv> invs;
+        std::vector<Vote> votes;
+        for (size_t i = 0; i < AVALANCHE_MAX_ELEMENT_POLL; ++i) {
+            const ProofId &proofid =
+                proofs[next_proof++ % proofs.size()]->getId();
+            invs.emplace_back(MSG_AVA_PROOF, proofid);
+            votes.emplace_back(0, proofid);
+        }
+        const NodeId nodeid = round % NUM_NODES;
+        AvalancheTest::addQuery(*processor, nodeid, round, std::move(invs));
+
+        int banscore;
+        std::string vote_error;
+        const bool registered = processor->registerVotes(
+            nodeid, Response(round++, 0, std::move(votes)), updates, banscore,
+            vote_error);
+        assert(registered);
+
+        for (const VoteItemUpdate &update : updates) {
+            if (update.getStatus() == VoteStatus::Finalized) {
+                AvalancheTest::addVoteRecord(*processor,
+                                             update.getVoteItem());
+            }
+        }
+        updates.clear();
+    });
+}
+
+// Add the proofs as contenders for the next block, vote on them and get the
+// winners, then clean the cache up.
+static void StakeContenderCacheUpdate(benchmark::Bench &bench,
+                                      size_t num_proofs) {
+    const auto setup = MakeSetup();
+    const std::vector<ProofRef> proofs = BuildProofs(*setup, num_proofs);
+
+    FastRandomContext rng(/*fDeterministic=*/true);
+    BlockHash blockhash{rng.rand256()};
+    CBlockIndex pindex;
+    pindex.nHeight = 1;
+    pindex.phashBlock = &blockhash;
+
+    bench.batch(num_proofs).unit("proof").run([&] {
+        StakeContenderCache cache;
+        for (const ProofRef &proof : proofs) {
+            cache.add(&pindex, proof);
+        }
+        for (size_t i = 0; i < proofs.size(); ++i) {
+            const StakeContenderId contenderid(blockhash,
+                                               proofs[i]->getId());
+            if (i % 2) {
+                cache.accept(contenderid);
+                cache.finalize(contenderid);
+            } else {
+                cache.reject(contenderid);
+            }
+        }
+        std::vector<CScript> payouts;
+        const bool found = cache.getWinners(blockhash, payouts);
+        assert(found && !payouts.empty());
+        cache.cleanup(pindex.nHeight + 1);
+    });
+}
+
+static void AvalancheStakeContenderCache1k(benchmark::Bench &bench) {
+    StakeContenderCacheUpdate(bench, 1000);
+}
+static void AvalancheStakeContenderCache10k(benchmark::Bench &bench) {
+    StakeContenderCacheUpdate(bench, 10000);
+}
+
+// Build the compact proofs of a peer, then reconstruct them on our side where
+// 90% of the proofs are already known, as when processing an avaproofs
+// message.
+static void CompactProofsReconstruct(benchmark::Bench &bench,
+                                     size_t num_proofs) {
+    const auto setup = MakeSetup();
+    const std::vector<ProofRef> proofs = BuildProofs(*setup, num_proofs);
+
+    RadixTree<const Proof, ProofRadixTreeAdapter> shared_proofs;
+    for (const ProofRef &proof : proofs) {
+        shared_proofs.insert(proof);
+    }
+    const std::vector<ProofRef> known_proofs(
+        proofs.begin(), proofs.begin() + num_proofs * 9 / 10);
+
+    bench.batch(num_proofs).unit("proof").run([&] {
+        const CompactProofs compact_proofs(shared_proofs);
+        ProofShortIdProcessor processor(compact_proofs.getPrefilledProofs(),
+                                        compact_proofs.getShortIDs(), 15);
+        for (const ProofRef &proof : known_proofs) {
+            processor.matchKnownItem(
+                compact_proofs.getShortID(proof->getId()), proof);
+        }
+
+        size_t missing = 0;
+        for (size_t i = 0; i < compact_proofs.size(); ++i) {
+            missing += processor.getItem(i) == nullptr;
+        }
+        assert(missing == proofs.size() - known_proofs.size());
+    });
+}
+
+static void AvalancheCompactProofsReconstruct1k(benchmark::Bench &bench) {
+    CompactProofsReconstruct(bench, 1000);
+}
+static void AvalancheCompactProofsReconstruct10k(benchmark::Bench &bench) {
+    CompactProofsReconstruct(bench, 10000);
+}
+
+BENCHMARK(AvalancheVerifyProof);
+BENCHMARK(AvalancheRegisterProofs1k);
+BENCHMARK(AvalancheRegisterProofs10k);
+BENCHMARK(AvalancheSelectNode1k);
+BENCHMARK(AvalancheSelectNode10k);
+BENCHMARK(AvalancheRegisterVotes);
+BENCHMARK(AvalancheStakeContenderCache1k);
+BENCHMARK(AvalancheStakeContenderCache10k);
+BENCHMARK(AvalancheCompactProofsReconstruct1k);
+BENCHMARK(AvalancheCompactProofsReconstruct10k);
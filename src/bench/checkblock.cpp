@@ -6,11 +6,14 @@
 #include <bench/data.h>
 
 #include <chainparams.h>
+#include <common/system.h>
 #include <config.h>
 #include <consensus/validation.h>
 #include <streams.h>
 #include <validation.h>
 
+#include <algorithm>
+
 // These are the two major time-sinks which happen after we have fully received
 // a block off the wire, but before we can relay the block on to peers using
 // compact block relay.
@@ -30,6 +33,24 @@ static void DeserializeBlockTest(benchmark::Bench &bench) {
     });
 }
 
+// Same as DeserializeBlockTest, but hashing the transactions one at a time as
+// they are deserialized rather than all of them together, for comparison.
+static void DeserializeBlockHashingEachTxTest(benchmark::Bench &bench) {
+    CDataStream stream(benchmark::data::block413567, SER_NETWORK,
+                       PROTOCOL_VERSION);
+    std::byte a{0};
+    // Prevent compaction
+    stream.write({&a, 1});
+
+    bench.unit("block").run([&] {
+        CBlockHeader header;
+        std::vector<CTransactionRef> vtx;
+        stream >> header >> vtx;
+        bool rewound = stream.Rewind(benchmark::data::block413567.size());
+        assert(rewound);
+    });
+}
+
 static void DeserializeAndCheckBlockTest(benchmark::Bench &bench) {
     CDataStream stream(benchmark::data::block413567, SER_NETWORK,
                        PROTOCOL_VERSION);
@@ -54,5 +75,15 @@ static void DeserializeAndCheckBlockTest(benchmark::Bench &bench) {
     });
 }
 
+// Same as DeserializeAndCheckBlockTest, with the transactions checked on all
+// the cores
+static void DeserializeAndCheckBlockParallelTest(benchmark::Bench &bench) {
+    StartValidationWorkerThreads(std::max(GetNumCores() - 1, 1));
+    DeserializeAndCheckBlockTest(bench);
+    StopValidationWorkerThreads();
+}
+
 BENCHMARK(DeserializeBlockTest);
+BENCHMARK(DeserializeBlockHashingEachTxTest);
 BENCHMARK(DeserializeAndCheckBlockTest);
+BENCHMARK(DeserializeAndCheckBlockParallelTest);
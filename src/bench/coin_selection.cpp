@@ -75,6 +75,55 @@ static void CoinSelection(benchmark::Bench &bench) {
     });
 }
 
+// Coin selection from a pool of many small coins, like the one of a wallet
+// receiving mining payouts, with both BnB and the knapsack solver.
+static void CoinSelectionLargePool(benchmark::Bench &bench, bool use_bnb) {
+    SelectParams(CBaseChainParams::REGTEST);
+
+    NodeContext node;
+    auto chain = interfaces::MakeChain(node, Params());
+    CWallet wallet(chain.get(), "", CreateDummyWalletDatabase());
+    wallet.SetupLegacyScriptPubKeyMan();
+    std::vector<std::unique_ptr<CWalletTx>> wtxs;
+    LOCK(wallet.cs_wallet);
+
+    for (int i = 0; i < 100000; ++i) {
+        addCoin((10 * COIN) + (i % 1000) * (COIN / 1000), wallet, wtxs);
+    }
+
+    std::vector<COutput> coins;
+    for (const auto &wtx : wtxs) {
+        coins.emplace_back(wallet, *wtx, 0 /* iIn */, 6 * 24 /* nDepthIn */,
+                           true /* spendable */, true /* solvable */,
+                           true /* safe */);
+    }
+
+    // The value of the 100 largest coins, so that BnB finds an exact match
+    // right away and the grouping and sorting of the pool dominate
+    const Amount target = 10999 * (COIN / 10);
+    const CoinEligibilityFilter filter_standard(1, 6);
+    const CoinSelectionParams coin_selection_params(
+        use_bnb, 34, 148, CFeeRate(Amount::zero()), 0, false);
+    bench.run([&] {
+        std::set<CInputCoin> setCoinsRet;
+        Amount nValueRet;
+        bool bnb_used;
+        bool success = SelectCoinsMinConf(wallet, target, filter_standard,
+                                          coins, setCoinsRet, nValueRet,
+                                          coin_selection_params, bnb_used);
+        assert(success);
+        assert(nValueRet >= target);
+    });
+}
+
+static void CoinSelectionLargePoolBnB(benchmark::Bench &bench) {
+    CoinSelectionLargePool(bench, /*use_bnb=*/true);
+}
+
+static void CoinSelectionLargePoolKnapsack(benchmark::Bench &bench) {
+    CoinSelectionLargePool(bench, /*use_bnb=*/false);
+}
+
 typedef std::set<CInputCoin> CoinSet;
 std::vector<std::unique_ptr<CWalletTx>> wtxn;
 
@@ -137,4 +186,6 @@ static void BnBExhaustion(benchmark::Bench &bench) {
 }
 
 BENCHMARK(CoinSelection);
+BENCHMARK(CoinSelectionLargePoolBnB);
+BENCHMARK(CoinSelectionLargePoolKnapsack);
 BENCHMARK(BnBExhaustion);
@@ -59,6 +59,22 @@ static void SHA256D64_1024(benchmark::Bench &bench) {
         [&] { SHA256D64(in.data(), in.data(), 1024); });
 }
 
+static void SHA256DMulti_1000(benchmark::Bench &bench) {
+    // About the size of a typical transaction
+    std::vector<std::vector<uint8_t>> messages(1000, std::vector<uint8_t>(250));
+    std::vector<const uint8_t *> inputs;
+    std::vector<size_t> lengths;
+    for (const std::vector<uint8_t> &message : messages) {
+        inputs.push_back(message.data());
+        lengths.push_back(message.size());
+    }
+    std::vector<uint8_t> out(32 * messages.size());
+    bench.batch(messages.size() * 250).unit("byte").run([&] {
+        SHA256DMulti(out.data(), inputs.data(), lengths.data(),
+                     messages.size());
+    });
+}
+
 static void SHA512(benchmark::Bench &bench) {
     uint8_t hash[CSHA512::OUTPUT_SIZE];
     std::vector<uint8_t> in(BUFFER_SIZE, 0);
@@ -128,6 +144,7 @@ BENCHMARK(SHA3_256_1M);
 BENCHMARK(SHA256_32b);
 BENCHMARK(SipHash_32b);
 BENCHMARK(SHA256D64_1024);
+BENCHMARK(SHA256DMulti_1000);
 BENCHMARK(FastRandom_32bit);
 BENCHMARK(FastRandom_1bit);
 
@@ -0,0 +1,49 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <invrequest.h>
+#include <primitives/txid.h>
+#include <random.h>
+
+#include <chrono>
+#include <deque>
+
+// Every tx is announced by all the peers, and is forgotten once a thousand
+// more were announced, so the tracker holds 125k announcements.
+static void InvRequestAnnounce(benchmark::Bench &bench) {
+    constexpr NodeId NUM_PEERS{125};
+    constexpr NodeId NUM_PREFERRED_PEERS{8};
+    constexpr size_t NUM_TRACKED_TXS{1000};
+
+    InvRequestTracker<TxId> tracker(/*deterministic=*/true);
+    FastRandomContext rng(/*fDeterministic=*/true);
+    std::deque<TxId> txids;
+    std::chrono::microseconds now{1s};
+
+    bench.run([&] {
+        const TxId txid{rng.rand256()};
+        for (NodeId peer = 0; peer < NUM_PEERS; ++peer) {
+            tracker.ReceivedInv(
+                peer, txid, peer < NUM_PREFERRED_PEERS,
+                now + std::chrono::microseconds{rng.randrange(2000000)});
+        }
+        txids.push_back(txid);
+        now += 10ms;
+
+        const NodeId peer = rng.randrange(NUM_PEERS);
+        for (const TxId &requestable :
+             tracker.GetRequestable(peer, now, nullptr)) {
+            tracker.RequestedData(peer, requestable, now + 60s);
+        }
+
+        if (txids.size() > NUM_TRACKED_TXS) {
+            tracker.ReceivedResponse(peer, txids.front());
+            tracker.ForgetInvId(txids.front());
+            txids.pop_front();
+        }
+    });
+}
+
+BENCHMARK(InvRequestAnnounce);
@@ -4,9 +4,13 @@
 
 #include <bench/bench.h>
 
+#include <common/system.h>
 #include <consensus/merkle.h>
 #include <random.h>
 #include <uint256.h>
+#include <validationthreadpool.h>
+
+#include <algorithm>
 
 static void MerkleRoot(benchmark::Bench &bench) {
     FastRandomContext rng(true);
@@ -23,4 +27,45 @@ static void MerkleRoot(benchmark::Bench &bench) {
     });
 }
 
+// A big block's worth of transactions, hashed on all the cores
+static void MerkleRootParallel(benchmark::Bench &bench) {
+    FastRandomContext rng(true);
+    std::vector<uint256> leaves;
+    leaves.resize(100000);
+    for (auto &item : leaves) {
+        item = rng.rand256();
+    }
+
+    ValidationThreadPool pool;
+    pool.Start(std::max(GetNumCores() - 1, 1));
+    const MerkleParallelFor parallel_for =
+        [&pool](size_t count, const std::function<void(size_t)> &job) {
+            pool.ParallelFor(count, job);
+        };
+    bench.batch(leaves.size()).unit("leaf").run([&] {
+        bool mutation = false;
+        uint256 hash = ComputeMerkleRoot(std::vector<uint256>(leaves),
+                                         &mutation, parallel_for);
+        leaves[mutation] = hash;
+    });
+    pool.Stop();
+}
+
+// Successive templates for different payouts, which share all but the coinbase
+static void MerkleRootCached(benchmark::Bench &bench) {
+    FastRandomContext rng(true);
+    std::vector<uint256> leaves;
+    leaves.resize(9001);
+    for (auto &item : leaves) {
+        item = rng.rand256();
+    }
+    MerkleTreeCache cache;
+    bench.batch(leaves.size()).unit("leaf").run([&] {
+        uint256 hash = cache.ComputeRoot(std::vector<uint256>(leaves));
+        leaves[0] = hash;
+    });
+}
+
 BENCHMARK(MerkleRoot);
+BENCHMARK(MerkleRootParallel);
+BENCHMARK(MerkleRootCached);
@@ -0,0 +1,198 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chainparams.h>
+#include <common/system.h>
+#include <crypto/scrypt.h>
+#include <pow/auxpow.h>
+#include <pow/pow.h>
+#include <primitives/auxpow.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <util/strencodings.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+// Number of headers in a full HEADERS message
+static const size_t HEADERS_BATCH_SIZE = 2000;
+
+// Number of headers hashed per iteration by the hashing benchmarks, a multiple
+// of SCRYPT_MULTI_MAX_LANES.
+static const size_t HASH_BATCH_SIZE = 64;
+
+// Merge-mined Dogecoin block
+// eac853ae22d59a498386241a3de69a36739ccc9e0a6acfd617b64c5ea4a0f4b3 (height
+// 700000)
+static const char *HEX_AUXPOW_HEADER_700000 =
+    "020162000c1194ac4c5d3826887eb8d97dc4ae02a25af30d5b504720febe4e047627217ec9"
+    "224c3a9a91e4018801d1da0b981e0445b3812413e32ef891e3d7772a5ef17ea43e4e5566d7"
+    "051b0000000001000000010000000000000000000000000000000000000000000000000000"
+    "000000000000ffffffff57034bdd0be4b883e5bda9e7a59ee4bb99e9b1bcfabe6d6d1f0e6e"
+    "c774ba83111dfe17e85be8e292092395050340aee13909bb5169f949114000000000000000"
+    "031f881c0000000f4d696e65642062792061327468726565ffffffff0100f2052a01000000"
+    "1976a914aa3750aa18b8a0f3f0590731e1fab934856680cf88ac0000000010ba25eadde6eb"
+    "39add569420d1fcb08df83df645f7f148a2d230500000000000346f64bde86fb0444949f57"
+    "4b2752ec82bafd7aa3599365e810638f87b2032e8d4124586ac0c16abc93a866107624236c"
+    "a8ec933991e0f1db424e1f5cac260e412515793c469236b0f308345ef47b28ae0c45d4f953"
+    "02a0e3ba84a970cf8252630000000006eb27cdf762126701d420dae67f9e0117751b098bc7"
+    "9f207d505edb385ec73ae46c4127661ba7d68c453b449868e6135a6ac0d9351a3e40d7dd58"
+    "767531de67ee31284c19194806e9c00943e05a9d1a79e17fa0c9b79bef9027ad2ca0bdf99e"
+    "abfe2d8f99be8b35640357d1af6ec9884840d0a9d91dbac1a8334df680016151ffc154ad6a"
+    "9b6e61c74b83dedd12a907e63a9c425fa1b199388196cb078c44d0c3a9a43398b7a93b294a"
+    "6c16b6e352b15a50cd7ce001de6d0cc82cb3e6c179f908380000000200000016e121811e18"
+    "8728f2aa586df32525412d76f9777cb7395ba20b5c40b3210711365ad72ba0e3d75af58431"
+    "d47bb16febd0366b775faf384128e7740a99edd898c73e4e558ab0011b19215530";
+
+static CBlockHeader AuxPowHeader() {
+    CDataStream ss{ParseHex(HEX_AUXPOW_HEADER_700000), SER_NETWORK,
+                   PROTOCOL_VERSION};
+    CBlockHeader header;
+    ss >> header;
+    return header;
+}
+
+/**
+ * Distinct legacy headers meeting the regtest target, so neither the PoW cache
+ * nor any other shortcut can skip the hashing.
+ */
+static std::vector<CBlockHeader> RegtestHeaders(size_t count) {
+    const Consensus::Params params = CChainParams::RegTest({})->GetConsensus();
+    std::vector<CBlockHeader> headers;
+    headers.reserve(count);
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.nTime = 1386325540;
+    header.nBits = 0x207fffff;
+    while (headers.size() < count) {
+        ++header.nNonce;
+        if (CheckProofOfWork(header.GetPowHash(), header.nBits, params)) {
+            headers.push_back(header);
+        }
+    }
+    return headers;
+}
+
+static std::vector<uint8_t> ScryptInputs(size_t count) {
+    std::vector<uint8_t> inputs(80 * count);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        inputs[i] = uint8_t(i * 7);
+    }
+    return inputs;
+}
+
+static void Scrypt_Generic(benchmark::Bench &bench) {
+    std::vector<uint8_t> input = ScryptInputs(1);
+    uint8_t output[32];
+    uint8_t *scratchpad = scrypt_thread_scratchpad();
+    bench.unit("hash").run([&] {
+        scrypt_1024_1_1_256_sp_generic(input.data(), output, scratchpad);
+        input[0] = output[0];
+    });
+}
+
+/** Uses the SIMD implementation selected for this CPU, if any. */
+static void Scrypt_Multi(benchmark::Bench &bench) {
+    std::vector<uint8_t> inputs = ScryptInputs(HASH_BATCH_SIZE);
+    std::vector<uint8_t> outputs(32 * HASH_BATCH_SIZE);
+    bench.batch(HASH_BATCH_SIZE).unit("hash").run([&] {
+        scrypt_1024_1_1_256_multi(inputs.data(), outputs.data(),
+                                  HASH_BATCH_SIZE);
+        inputs[0] = outputs[0];
+    });
+}
+
+static void PowHash_Single(benchmark::Bench &bench) {
+    const std::vector<CBlockHeader> headers = RegtestHeaders(HASH_BATCH_SIZE);
+    bench.batch(headers.size()).unit("header").run([&] {
+        for (const CBlockHeader &header : headers) {
+            ankerl::nanobench::doNotOptimizeAway(header.GetPowHash());
+        }
+    });
+}
+
+static void PowHash_Batched(benchmark::Bench &bench) {
+    const std::vector<CBlockHeader> headers = RegtestHeaders(HASH_BATCH_SIZE);
+    std::vector<const CBaseBlockHeader *> powHeaders;
+    for (const CBlockHeader &header : headers) {
+        powHeaders.push_back(&header);
+    }
+    bench.batch(headers.size()).unit("header").run([&] {
+        ankerl::nanobench::doNotOptimizeAway(
+            CBaseBlockHeader::GetPowHashes(powHeaders));
+    });
+}
+
+static void CheckAuxProofOfWork_Legacy(benchmark::Bench &bench) {
+    const auto chainParams = CChainParams::Main({});
+    const CBlockHeader header = chainParams->GenesisBlock().GetBlockHeader();
+    const Consensus::Params &params = chainParams->GetConsensus();
+    bench.unit("header").run(
+        [&] { assert(CheckAuxProofOfWork(header, params)); });
+}
+
+static void CheckAuxProofOfWork_MergeMined(benchmark::Bench &bench) {
+    const CBlockHeader header = AuxPowHeader();
+    const Consensus::Params params = CChainParams::Main({})->GetConsensus();
+    bench.unit("header").run(
+        [&] { assert(CheckAuxProofOfWork(header, params)); });
+}
+
+static void CheckAuxBlockHash(benchmark::Bench &bench) {
+    const CBlockHeader header = AuxPowHeader();
+    const BlockHash hash = header.GetHash();
+    const int32_t chainId = VersionChainId(header.nVersion);
+    const Consensus::Params params = CChainParams::Main({})->GetConsensus();
+    bench.unit("header").run([&] {
+        assert(header.auxpow->CheckAuxBlockHash(hash, chainId, params));
+    });
+}
+
+/**
+ * Check a full HEADERS message worth of headers on the PoW check queue. The
+ * calling thread takes part in the checks, so worker_threads + 1 threads are
+ * hashing.
+ */
+static void HasValidProofOfWork_Headers(benchmark::Bench &bench,
+                                        int worker_threads) {
+    const std::vector<CBlockHeader> headers =
+        RegtestHeaders(HEADERS_BATCH_SIZE);
+    const Consensus::Params params = CChainParams::RegTest({})->GetConsensus();
+    StartValidationWorkerThreads(worker_threads);
+    bench.batch(headers.size()).unit("header").run(
+        [&] { assert(HasValidProofOfWork(headers, params)); });
+    StopValidationWorkerThreads();
+}
+
+static void HasValidProofOfWork_1Thread(benchmark::Bench &bench) {
+    HasValidProofOfWork_Headers(bench, 0);
+}
+
+static void HasValidProofOfWork_2Threads(benchmark::Bench &bench) {
+    HasValidProofOfWork_Headers(bench, 1);
+}
+
+static void HasValidProofOfWork_4Threads(benchmark::Bench &bench) {
+    HasValidProofOfWork_Headers(bench, 3);
+}
+
+static void HasValidProofOfWork_AllCores(benchmark::Bench &bench) {
+    HasValidProofOfWork_Headers(bench, std::max(GetNumCores() - 1, 0));
+}
+
+BENCHMARK(Scrypt_Generic);
+BENCHMARK(Scrypt_Multi);
+BENCHMARK(PowHash_Single);
+BENCHMARK(PowHash_Batched);
+BENCHMARK(CheckAuxProofOfWork_Legacy);
+BENCHMARK(CheckAuxProofOfWork_MergeMined);
+BENCHMARK(CheckAuxBlockHash);
+BENCHMARK(HasValidProofOfWork_1Thread);
+BENCHMARK(HasValidProofOfWork_2Threads);
+BENCHMARK(HasValidProofOfWork_4Threads);
+BENCHMARK(HasValidProofOfWork_AllCores);
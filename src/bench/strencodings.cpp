@@ -14,4 +14,13 @@ static void HexStrBench(benchmark::Bench &bench) {
     });
 }
 
+static void ParseHexBench(benchmark::Bench &bench) {
+    const std::string hex = HexStr(benchmark::data::block413567);
+    bench.batch(hex.size()).unit("byte").run([&] {
+        auto data = ParseHex(hex);
+        ankerl::nanobench::doNotOptimizeAway(data);
+    });
+}
+
 BENCHMARK(HexStrBench);
+BENCHMARK(ParseHexBench);
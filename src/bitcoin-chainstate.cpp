@@ -24,10 +24,10 @@
 #include <node/blockstorage.h>
 #include <node/caches.h>
 #include <node/chainstate.h>
+#include <pow/powcache.h>
 #include <scheduler.h>
 #include <script/scriptcache.h>
 #include <script/sigcache.h>
-#include <util/thread.h>
 #include <util/translation.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -75,12 +75,12 @@ int main(int argc, char *argv[]) {
     Assert(InitSignatureCache(validation_cache_sizes.signature_cache_bytes));
     Assert(InitScriptExecutionCache(
         validation_cache_sizes.script_execution_cache_bytes));
+    Assert(InitPowCache(validation_cache_sizes.pow_cache_bytes));
 
     // SETUP: Scheduling and Background Signals
     CScheduler scheduler{};
-    // Start the lightweight task scheduler thread
-    scheduler.m_service_thread = std::thread(util::TraceThread, "scheduler",
-                                             [&] { scheduler.serviceQueue(); });
+    // Start the lightweight task scheduler threads
+    scheduler.StartServiceThreads();
 
     // Gather some entropy once per minute.
     scheduler.scheduleEvery(
@@ -314,8 +314,7 @@ epilogue:
     if (chainman.m_load_block.joinable()) {
         chainman.m_load_block.join();
     }
-    StopScriptCheckWorkerThreads();
-    StopPowCheckWorkerThreads();
+    StopValidationWorkerThreads();
 
     GetMainSignals().FlushBackgroundCallbacks();
     {
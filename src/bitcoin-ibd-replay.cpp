@@ -0,0 +1,454 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// The doge-ibd-replay executable replays the blocks of blk*.dat files into a
+// chainstate, the same way they are connected during the initial block
+// download, and reports where the time went. It is meant to measure the IBD
+// performance reproducibly on real blocks, without the network.
+//
+// It is part of the libbitcoinkernel project, like doge-chainstate.
+
+#include <kernel/chainparams.h>
+#include <kernel/chainstatemanager_opts.h>
+#include <kernel/validation_cache_sizes.h>
+
+#include <chainparams.h>
+#include <chainparamsbase.h>
+#include <clientversion.h>
+#include <common/args.h>
+#include <config.h>
+#include <consensus/validation.h>
+#include <init/common.h>
+#include <node/blockcompression.h>
+#include <node/blockstorage.h>
+#include <node/caches.h>
+#include <node/chainstate.h>
+#include <pow/powcache.h>
+#include <protocol.h>
+#include <scheduler.h>
+#include <script/scriptcache.h>
+#include <script/sigcache.h>
+#include <serialize.h>
+#include <streams.h>
+#include <tinyformat.h>
+#include <util/fs.h>
+#include <util/metrics.h>
+#include <util/strencodings.h>
+#include <util/time.h>
+#include <util/translation.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+/** Where a block is stored in the blk files. */
+struct BlockLocation {
+    size_t file;
+    uint64_t pos;
+    uint32_t size;
+    bool compressed;
+};
+
+/**
+ * Index the blocks of the files by their parent, as the blocks are not stored
+ * in height order.
+ */
+std::multimap<BlockHash, BlockLocation>
+IndexBlocks(const CChainParams &params,
+            const std::vector<std::filesystem::path> &files) {
+    std::multimap<BlockHash, BlockLocation> blocks;
+    for (size_t i = 0; i < files.size(); ++i) {
+        FILE *file = fsbridge::fopen(files[i], "rb");
+        if (!file) {
+            throw std::runtime_error("Cannot open " + files[i].string());
+        }
+        CBufferedFile blkdat(file, 2 * MAX_TX_SIZE, MAX_TX_SIZE + 8, SER_DISK,
+                             CLIENT_VERSION);
+        while (!blkdat.eof()) {
+            uint32_t size;
+            try {
+                uint8_t magic[CMessageHeader::MESSAGE_START_SIZE];
+                blkdat.FindByte(std::byte(params.DiskMagic()[0]));
+                blkdat >> magic;
+                if (memcmp(magic, params.DiskMagic().data(),
+                           CMessageHeader::MESSAGE_START_SIZE)) {
+                    continue;
+                }
+                blkdat >> size;
+            } catch (const std::exception &) {
+                // The end of the file
+                break;
+            }
+            const bool compressed{(size & node::BLOCK_COMPRESSED_FLAG) != 0};
+            size &= ~node::BLOCK_COMPRESSED_FLAG;
+            const uint64_t pos{blkdat.GetPos()};
+            try {
+                CBlockHeader header;
+                if (compressed) {
+                    std::vector<uint8_t> stored(size), block_data;
+                    blkdat >> Span{stored};
+                    if (!node::DecompressBlock(stored, block_data)) {
+                        continue;
+                    }
+                    SpanReader{SER_DISK, CLIENT_VERSION, block_data} >> header;
+                } else {
+                    blkdat >> header;
+                }
+                blocks.emplace(header.hashPrevBlock,
+                               BlockLocation{i, pos, size, compressed});
+                blkdat.SkipTo(pos + size);
+            } catch (const std::exception &) {
+                // A truncated block
+                break;
+            }
+        }
+    }
+    return blocks;
+}
+
+std::shared_ptr<CBlock>
+ReadBlock(const std::vector<std::filesystem::path> &files,
+          const BlockLocation &location) {
+    FILE *file = fsbridge::fopen(files[location.file], "rb");
+    if (!file || fseek(file, location.pos, SEEK_SET)) {
+        if (file) {
+            fclose(file);
+        }
+        throw std::runtime_error("Cannot read " +
+                                 files[location.file].string());
+    }
+    CAutoFile filein{file, SER_DISK, CLIENT_VERSION};
+    std::vector<uint8_t> data(location.size);
+    filein >> Span{data};
+    if (location.compressed) {
+        std::vector<uint8_t> stored{std::move(data)};
+        if (!node::DecompressBlock(stored, data)) {
+            throw std::runtime_error("Cannot decompress a block");
+        }
+    }
+    auto block = std::make_shared<CBlock>();
+    SpanReader{SER_DISK, CLIENT_VERSION, data} >> *block;
+    return block;
+}
+
+/** The time recorded by the metrics, in microseconds, by name and label. */
+std::map<std::pair<std::string, std::string>, uint64_t> MetricsTime() {
+    std::map<std::pair<std::string, std::string>, uint64_t> times;
+    metrics::ForEachHistogram(
+        [&](const std::string &name, const std::string &help,
+            const metrics::Label &label, const metrics::Histogram &histogram) {
+            times[{name, label.value}] = histogram.GetSnapshot().sum;
+        });
+    return times;
+}
+
+/** The peak resident set size in bytes, if known. */
+std::optional<uint64_t> PeakRSS() {
+#ifndef WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return uint64_t(usage.ru_maxrss);
+#else
+        return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    return std::nullopt;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+    // SETUP: Argument parsing and handling
+    std::string chain{CBaseChainParams::MAIN};
+    int start_height{0};
+    std::optional<int> count;
+    int64_t dbcache_mib{450};
+    int argi{1};
+    for (; argi < argc && argv[argi][0] == '-'; ++argi) {
+        const std::string arg{argv[argi]};
+        const size_t eq{arg.find('=')};
+        const std::string name{arg.substr(0, eq)};
+        const std::string value{eq == std::string::npos ? ""
+                                                        : arg.substr(eq + 1)};
+        int64_t number{0};
+        if (name == "-chain") {
+            chain = value;
+        } else if (name == "-start" && ParseInt64(value, &number) &&
+                   number >= 0) {
+            start_height = number;
+        } else if (name == "-count" && ParseInt64(value, &number) &&
+                   number >= 0) {
+            count = number;
+        } else if (name == "-dbcache" && ParseInt64(value, &number) &&
+                   number >= 8) {
+            dbcache_mib = number;
+        } else {
+            std::cerr << "Invalid option " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (argc - argi < 2) {
+        std::cerr
+            << "Usage: " << argv[0]
+            << " [options] DATADIR BLKFILE..." << std::endl
+            << "Connect the blocks of the BLKFILEs on top of the DATADIR "
+               "chainstate and report"
+            << std::endl
+            << "the time spent in each phase of the validation." << std::endl
+            << std::endl
+            << "Options:" << std::endl
+            << "  -chain=<chain>  main, test or regtest (default: main)"
+            << std::endl
+            << "  -start=<n>      Only measure the blocks above height n, the "
+               "blocks up to n"
+            << std::endl
+            << "                  are connected first (default: 0)"
+            << std::endl
+            << "  -count=<n>      Stop after measuring n blocks (default: all)"
+            << std::endl
+            << "  -dbcache=<n>    Database cache size in MiB (default: 450)"
+            << std::endl
+            << std::endl
+            << "IMPORTANT: THIS EXECUTABLE IS EXPERIMENTAL, FOR TESTING "
+               "ONLY. DO NOT USE ON YOUR"
+            << std::endl
+            << "           ACTUAL DATADIR." << std::endl;
+        return 1;
+    }
+    std::filesystem::path abs_datadir = std::filesystem::absolute(argv[argi]);
+    std::filesystem::create_directories(abs_datadir);
+    gArgs.ForceSetArg("-datadir", abs_datadir.string());
+    std::vector<std::filesystem::path> blk_files(argv + argi + 1, argv + argc);
+
+    // SETUP: Misc Globals
+    try {
+        SelectParams(chain);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    auto &config = const_cast<Config &>(GetConfig());
+    config.SetChainParams(Params());
+
+    // ECC_Start, etc.
+    init::SetGlobals();
+
+    kernel::ValidationCacheSizes validation_cache_sizes{};
+    Assert(InitSignatureCache(validation_cache_sizes.signature_cache_bytes));
+    Assert(InitScriptExecutionCache(
+        validation_cache_sizes.script_execution_cache_bytes));
+    Assert(InitPowCache(validation_cache_sizes.pow_cache_bytes));
+
+    // SETUP: Scheduling and Background Signals
+    CScheduler scheduler{};
+    scheduler.StartServiceThreads();
+    GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+
+    class KernelNotifications : public kernel::Notifications {
+    public:
+        void blockTip(SynchronizationState, CBlockIndex &) override {}
+        void headerTip(SynchronizationState, int64_t height, int64_t timestamp,
+                       bool presync) override {}
+        void progress(const bilingual_str &title, int progress_percent,
+                      bool resume_possible) override {}
+        void warning(const std::string &warning) override {
+            std::cerr << "Warning: " << warning << std::endl;
+        }
+    };
+    auto notifications = std::make_unique<KernelNotifications>();
+
+    // SETUP: Chainstate
+    const ChainstateManager::Options chainman_opts{
+        .config = config,
+        .datadir = gArgs.GetDataDirNet(),
+        .adjusted_time_callback = NodeClock::now,
+        .notifications = *notifications,
+    };
+    const node::BlockManager::Options blockman_opts{
+        .chainparams = chainman_opts.config.GetChainParams(),
+        .blocks_dir = gArgs.GetBlocksDirPath(),
+    };
+    ChainstateManager chainman{chainman_opts, blockman_opts};
+
+    node::CacheSizes cache_sizes;
+    cache_sizes.block_tree_db = 2 << 20;
+    cache_sizes.coins_db = 2 << 22;
+    cache_sizes.coins = (dbcache_mib << 20) - (2 << 20) - (2 << 22);
+    node::ChainstateLoadOptions options;
+    options.check_interrupt = [] { return false; };
+    int exit_status{1};
+    std::multimap<BlockHash, BlockLocation> blocks;
+    auto [status, error] = node::LoadChainstate(chainman, cache_sizes, options);
+    if (status != node::ChainstateLoadStatus::SUCCESS) {
+        std::cerr << "Failed to load Chain state from your datadir."
+                  << std::endl;
+        goto epilogue;
+    }
+    {
+        BlockValidationState state;
+        if (!chainman.ActiveChainstate().ActivateBestChain(state, nullptr)) {
+            std::cerr << "Failed to connect best block (" << state.ToString()
+                      << ")" << std::endl;
+            goto epilogue;
+        }
+    }
+
+    try {
+        std::cout << "Indexing the blocks of " << blk_files.size()
+                  << " files..." << std::endl;
+        blocks = IndexBlocks(chainman.GetParams(), blk_files);
+        std::cout << "Found " << blocks.size() << " blocks" << std::endl;
+
+        // Replay the blocks in height order from the tip, including the
+        // stale ones.
+        const CBlockIndex *tip{WITH_LOCK(cs_main, return chainman.ActiveTip())};
+        std::deque<std::pair<BlockHash, int>> queue{
+            {tip->GetBlockHash(), tip->nHeight}};
+        const int end_height{count ? start_height + *count
+                                   : std::numeric_limits<int>::max()};
+        std::optional<SteadyClock::time_point> measure_start;
+        int measure_start_height{0};
+        uint64_t measured_txs{0};
+        auto metrics_start{MetricsTime()};
+        while (!queue.empty()) {
+            const auto [prev_hash, prev_height] = queue.front();
+            queue.pop_front();
+            if (prev_height >= end_height) {
+                continue;
+            }
+            if (!measure_start && prev_height >= start_height) {
+                measure_start = SteadyClock::now();
+                measure_start_height =
+                    WITH_LOCK(cs_main, return chainman.ActiveHeight());
+                metrics_start = MetricsTime();
+            }
+            auto [begin, end] = blocks.equal_range(prev_hash);
+            for (auto it = begin; it != end; ++it) {
+                std::shared_ptr<CBlock> block{ReadBlock(blk_files, it->second)};
+                if (!chainman.ProcessNewBlock(block,
+                                              /*force_processing=*/true,
+                                              /*min_pow_checked=*/true,
+                                              /*new_block=*/nullptr)) {
+                    std::cerr << "Block " << block->GetHash().ToString()
+                              << " rejected" << std::endl;
+                    continue;
+                }
+                if (measure_start) {
+                    measured_txs += block->vtx.size();
+                }
+                queue.emplace_back(block->GetHash(), prev_height + 1);
+                if ((prev_height + 1) % 10000 == 0) {
+                    std::cout << "Height " << prev_height + 1 << std::endl;
+                }
+            }
+        }
+        if (!measure_start) {
+            std::cerr << "No block above height " << start_height
+                      << " to measure" << std::endl;
+            goto epilogue;
+        }
+
+        // Make the flush of the remaining coins part of the measure, as it
+        // would eventually happen during the IBD.
+        {
+            static metrics::Histogram &final_flush{metrics::GetHistogram(
+                "ibdreplay_final_flush", "Time spent flushing at the end")};
+            metrics::ScopedTimer timer{final_flush};
+            LOCK(cs_main);
+            chainman.ActiveChainstate().ForceFlushStateToDisk();
+        }
+
+        const double elapsed{CountSecondsDouble(SteadyClock::now() -
+                                                *measure_start)};
+        const int measured_blocks{
+            WITH_LOCK(cs_main, return chainman.ActiveHeight()) -
+            measure_start_height};
+        const auto metrics_end{MetricsTime()};
+        auto seconds = [&](const std::string &name, const std::string &label) {
+            const std::pair<std::string, std::string> key{name, label};
+            const auto it_end{metrics_end.find(key)};
+            if (it_end == metrics_end.end()) {
+                return 0.;
+            }
+            const auto it_start{metrics_start.find(key)};
+            return (it_end->second -
+                    (it_start == metrics_start.end() ? 0 : it_start->second)) /
+                   1e6;
+        };
+        auto print = [&](const std::string &title, double time) {
+            std::cout << strprintf("  %-36s %10.3fs %5.1f%%", title, time,
+                                   elapsed > 0 ? 100 * time / elapsed : 0.)
+                      << std::endl;
+        };
+
+        std::cout << strprintf("Connected %d blocks and %u txs in %.3fs: "
+                               "%.2f blocks/s, %.2f txs/s",
+                               measured_blocks, measured_txs, elapsed,
+                               measured_blocks / elapsed,
+                               measured_txs / elapsed)
+                  << std::endl;
+        print("PoW and auxpow checks", seconds("checkpow", "block"));
+        print("Block checks", seconds("connectblock", "check"));
+        print("Coin fetch and tx checks", seconds("connectblock", "connect"));
+        print("Script checks wait", seconds("connectblock", "verify") -
+                                        seconds("connectblock", "connect"));
+        print("Block index update", seconds("connectblock", "index"));
+        print("Block read from disk", seconds("connecttip", "load"));
+        print("Coins cache flush to the view",
+              seconds("connecttip", "flush"));
+        print("Chainstate flush to disk", seconds("flushstatetodisk", "") +
+                                              seconds("ibdreplay_final_flush",
+                                                      ""));
+        print("Block connection total", seconds("connecttip", "total"));
+        if (const auto rss{PeakRSS()}) {
+            std::cout << strprintf("Peak RSS: %.1f MiB", *rss / 1048576.)
+                      << std::endl;
+        }
+        exit_status = 0;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+
+epilogue:
+    // Without this precise shutdown sequence, there will be a lot of nullptr
+    // dereferencing and UB.
+    scheduler.stop();
+    if (chainman.m_load_block.joinable()) {
+        chainman.m_load_block.join();
+    }
+    StopValidationWorkerThreads();
+
+    GetMainSignals().FlushBackgroundCallbacks();
+    {
+        LOCK(cs_main);
+        for (Chainstate *chainstate : chainman.GetAll()) {
+            if (chainstate->CanFlushToDisk()) {
+                chainstate->ForceFlushStateToDisk();
+                chainstate->ResetCoinsViews();
+            }
+        }
+    }
+    GetMainSignals().UnregisterBackgroundSignalScheduler();
+
+    init::UnsetGlobals();
+    return exit_status;
+}
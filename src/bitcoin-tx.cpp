@@ -32,9 +32,11 @@
 
 #include <cstdio>
 #include <functional>
+#include <iostream>
 #include <memory>
 
 static bool fCreateBlank;
+static bool fBatch;
 static std::map<std::string, UniValue> registers;
 static const int CONTINUE_EXECUTION = -1;
 
@@ -48,6 +50,11 @@ static void SetupBitcoinTxArgs(ArgsManager &argsman) {
                    OptionsCategory::OPTIONS);
     argsman.AddArg("-create", "Create new, empty TX.", ArgsManager::ALLOW_ANY,
                    OptionsCategory::OPTIONS);
+    argsman.AddArg("-batch",
+                   "Read hex-encoded transactions from standard input, one "
+                   "per line, and apply the commands to each of them. The "
+                   "results are output one per line, in the same order.",
+                   ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-json", "Select JSON output", ArgsManager::ALLOW_ANY,
                    OptionsCategory::OPTIONS);
     argsman.AddArg(
@@ -130,6 +137,7 @@ static int AppInitRawTx(int argc, char *argv[]) {
     }
 
     fCreateBlank = gArgs.GetBoolArg("-create", false);
+    fBatch = gArgs.GetBoolArg("-batch", false);
 
     if (argc < 2 || HelpRequested(gArgs) || gArgs.IsArgSet("-version")) {
         // First part of help message is specific to this utility
@@ -145,6 +153,8 @@ static int AppInitRawTx(int argc, char *argv[]) {
                 "hex-encoded bitcoin transaction\n"
                 "or:     doge-tx [options] -create [commands]   Create "
                 "hex-encoded bitcoin transaction\n"
+                "or:     doge-tx [options] -batch [commands]    Update "
+                "hex-encoded bitcoin transactions read from stdin\n"
                 "\n";
             strUsage += gArgs.GetHelpMessage();
         }
@@ -802,6 +812,67 @@ static std::string readStdin() {
     return TrimString(ret);
 }
 
+static void MutateTxWithArgs(CMutableTransaction &tx, int argc, char *argv[],
+                             int startArg, const CChainParams &chainParams) {
+    for (int i = startArg; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string key, value;
+        size_t eqpos = arg.find('=');
+        if (eqpos == std::string::npos) {
+            key = arg;
+        } else {
+            key = arg.substr(0, eqpos);
+            value = arg.substr(eqpos + 1);
+        }
+
+        MutateTx(tx, key, value, chainParams);
+    }
+}
+
+/**
+ * Apply the commands to each transaction read from stdin. A transaction that
+ * fails is reported on stderr with its line number, and the next ones are
+ * still processed.
+ */
+static int CommandLineRawTxBatch(int argc, char *argv[],
+                                 const CChainParams &chainParams) {
+    if (fCreateBlank) {
+        throw std::runtime_error("-batch can't be used with -create");
+    }
+
+    int nRet = 0;
+    std::string line;
+    for (size_t line_number = 1; std::getline(std::cin, line); ++line_number) {
+        const std::string strHexTx = TrimString(line);
+        if (strHexTx.empty()) {
+            continue;
+        }
+        std::string strError;
+        try {
+            CMutableTransaction tx;
+            if (!DecodeHexTx(tx, strHexTx)) {
+                throw std::runtime_error("invalid transaction encoding");
+            }
+            MutateTxWithArgs(tx, argc, argv, 1, chainParams);
+            OutputTx(CTransaction(tx));
+        } catch (const std::exception &e) {
+            strError = std::string("error: ") + e.what();
+        } catch (const UniValue &e) {
+            strError = std::string("error code: ") + e["code"].getValStr() +
+                       " message: " + e["message"].getValStr();
+        }
+        if (!strError.empty()) {
+            tfm::format(std::cerr, "line %u: %s\n", line_number, strError);
+            nRet = EXIT_FAILURE;
+        }
+    }
+    if (std::cin.bad()) {
+        throw std::runtime_error("error reading stdin");
+    }
+
+    return nRet;
+}
+
 static int CommandLineRawTx(int argc, char *argv[],
                             const CChainParams &chainParams) {
     std::string strPrint;
@@ -813,6 +884,10 @@ static int CommandLineRawTx(int argc, char *argv[],
             argv++;
         }
 
+        if (fBatch) {
+            return CommandLineRawTxBatch(argc, argv, chainParams);
+        }
+
         CMutableTransaction tx;
         int startArg;
 
@@ -839,19 +914,7 @@ static int CommandLineRawTx(int argc, char *argv[],
             startArg = 1;
         }
 
-        for (int i = startArg; i < argc; i++) {
-            std::string arg = argv[i];
-            std::string key, value;
-            size_t eqpos = arg.find('=');
-            if (eqpos == std::string::npos) {
-                key = arg;
-            } else {
-                key = arg.substr(0, eqpos);
-                value = arg.substr(eqpos + 1);
-            }
-
-            MutateTx(tx, key, value, chainParams);
-        }
+        MutateTxWithArgs(tx, argc, argv, startArg, chainParams);
 
         OutputTx(CTransaction(tx));
     } catch (const std::exception &e) {
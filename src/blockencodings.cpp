@@ -16,7 +16,12 @@
 #include <txmempool.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <unordered_map>
+#include <vector>
+
+//! How many mempool txs a thread computes the short id of at once
+static constexpr size_t SHORTID_CHUNK_SIZE{4096};
 
 CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock &block)
     : nonce(GetRand<uint64_t>()), shorttxids(block.vtx.size() - 1),
@@ -31,6 +36,16 @@ CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock &block)
     }
 }
 
+CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const BlockView &block)
+    : nonce(GetRand<uint64_t>()), shorttxids(block.vtx.size() - 1),
+      prefilledtxn(1), header(block.header) {
+    FillShortTxIDSelector();
+    prefilledtxn[0] = {0, block.vtx[0].ToTransactionRef()};
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        shorttxids[i - 1] = GetShortID(block.vtx[i].GetHash());
+    }
+}
+
 void CBlockHeaderAndShortTxIDs::FillShortTxIDSelector() const {
     CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
     stream << header << nonce;
@@ -100,13 +115,29 @@ ReadStatus PartiallyDownloadedBlock::InitData(
 
     {
         LOCK(pool->cs);
-        auto it = pool->mapTx.begin();
-        while (it != pool->mapTx.end()) {
-            uint64_t shortid = cmpctblock.GetShortID((*it)->GetTx().GetHash());
+        // The short ids depend on the salt of the block, so they can't be
+        // computed in advance. With a large mempool, computing them is most of
+        // the work, so it is done in parallel before matching them in order.
+        std::vector<const CTxMemPoolEntry *> entries;
+        entries.reserve(pool->mapTx.size());
+        for (const auto &entry : pool->mapTx) {
+            entries.push_back(&*entry);
+        }
+        std::vector<uint64_t> shortids(entries.size());
+        const size_t num_chunks{(entries.size() + SHORTID_CHUNK_SIZE - 1) /
+                                SHORTID_CHUNK_SIZE};
+        GetValidationThreadPool().ParallelFor(num_chunks, [&](size_t chunk) {
+            const size_t end{
+                std::min((chunk + 1) * SHORTID_CHUNK_SIZE, entries.size())};
+            for (size_t i = chunk * SHORTID_CHUNK_SIZE; i < end; ++i) {
+                shortids[i] =
+                    cmpctblock.GetShortID(entries[i]->GetTx().GetHash());
+            }
+        });
 
-            mempool_count +=
-                shortidProcessor->matchKnownItem(shortid, (*it)->GetSharedTx());
-            it++;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            mempool_count += shortidProcessor->matchKnownItem(
+                shortids[i], entries[i]->GetSharedTx());
 
             if (mempool_count == shortidProcessor->getShortIdCount()) {
                 break;
@@ -206,3 +237,26 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(
 
     return READ_STATUS_OK;
 }
+
+std::vector<uint8_t>
+CompactAuxPowHeaders::SerializeCoinbase(const CAuxPow &auxpow) {
+    std::vector<uint8_t> bytes;
+    CVectorWriter(SER_NETWORK, PROTOCOL_VERSION, bytes, 0) << auxpow.coinbaseTx;
+    return bytes;
+}
+
+CTransactionRef
+CompactAuxPowHeaders::UnserializeCoinbase(const std::vector<uint8_t> &bytes) {
+    CDataStream stream(bytes, SER_NETWORK, PROTOCOL_VERSION);
+    CTransactionRef tx;
+    stream >> tx;
+    if (!stream.empty()) {
+        throw std::ios_base::failure("compact auxpow coinbase has extra data");
+    }
+    return tx;
+}
+
+uint256 CompactAuxPowHeaders::ComputeParentRoot(const CAuxPow &auxpow) {
+    return ComputeMerkleRootForBranch(auxpow.coinbaseTx->GetHash(),
+                                      auxpow.vMerkleBranch, auxpow.nIndex);
+}
@@ -5,10 +5,14 @@
 #ifndef BITCOIN_BLOCKENCODINGS_H
 #define BITCOIN_BLOCKENCODINGS_H
 
+#include <primitives/auxpow.h>
 #include <primitives/block.h>
+#include <primitives/blockview.h>
 #include <serialize.h>
 #include <shortidprocessor.h>
+#include <tinyformat.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -99,6 +103,8 @@ public:
     CBlockHeaderAndShortTxIDs() {}
 
     explicit CBlockHeaderAndShortTxIDs(const CBlock &block);
+    /** Build from a block read from disk, only the coinbase is deserialized. */
+    explicit CBlockHeaderAndShortTxIDs(const BlockView &block);
 
     uint64_t GetShortID(const TxHash &txhash) const;
 
@@ -138,6 +144,184 @@ public:
     }
 };
 
+/**
+ * Maximum total size of the parent coinbase txs decoded from an AUXHEADERS
+ * message. Coinbase txs are rebuilt from the previous one, so without a limit a
+ * small message could decode to a lot of memory. This matches the
+ * MAX_PROTOCOL_MESSAGE_LENGTH bound on the size of a HEADERS message.
+ */
+static constexpr size_t MAX_AUXHEADERS_COINBASE_BYTES = 2 * 1024 * 1024;
+
+/**
+ * Dogecoin: the headers of an AUXHEADERS message.
+ *
+ * Merge-mined headers carry a full CAuxPow, which makes them many times larger
+ * than 80 bytes. This encoding is lossless, but shrinks the auxpow:
+ * - An nIndex of 0, the parent block merkle root when it matches the coinbase
+ *   merkle branch, and the auxpow hashBlock when it is null or the parent
+ *   block hash are not sent, since the receiver can recompute them.
+ * - Consecutive blocks are usually mined by the same pool, so only the bytes
+ *   of the parent coinbase tx that differ from the previous merge-mined
+ *   header's coinbase tx in the message are sent; the common prefix and
+ *   suffix are copied from it.
+ */
+class CompactAuxPowHeaders {
+private:
+    enum : uint8_t {
+        HASH_BLOCK_NULL = 1 << 0,
+        HASH_BLOCK_PARENT = 1 << 1,
+        INDEX_ZERO = 1 << 2,
+        PARENT_ROOT_DERIVED = 1 << 3,
+        ALL_FLAGS = (1 << 4) - 1,
+    };
+
+    static std::vector<uint8_t> SerializeCoinbase(const CAuxPow &auxpow);
+    static CTransactionRef
+    UnserializeCoinbase(const std::vector<uint8_t> &bytes);
+    static uint256 ComputeParentRoot(const CAuxPow &auxpow);
+
+public:
+    std::vector<CBlockHeader> headers;
+
+    CompactAuxPowHeaders() {}
+    explicit CompactAuxPowHeaders(std::vector<CBlockHeader> headersIn)
+        : headers(std::move(headersIn)) {}
+
+    template <typename Stream> void Serialize(Stream &s) const {
+        WriteCompactSize(s, headers.size());
+        std::vector<uint8_t> prevCoinbase;
+        for (const CBlockHeader &header : headers) {
+            s << static_cast<const CBaseBlockHeader &>(header);
+            if (!VersionHasAuxPow(header.nVersion)) {
+                continue;
+            }
+            if (!header.auxpow) {
+                throw std::ios_base::failure(
+                    strprintf("Missing auxpow in header %s",
+                              header.GetHash().ToString()));
+            }
+            const CAuxPow &auxpow = *header.auxpow;
+            const CBaseBlockHeader &parent = auxpow.parentBlock;
+
+            std::vector<uint8_t> coinbase = SerializeCoinbase(auxpow);
+            const size_t maxCommon =
+                std::min(coinbase.size(), prevCoinbase.size());
+            size_t prefix = 0;
+            while (prefix < maxCommon &&
+                   coinbase[prefix] == prevCoinbase[prefix]) {
+                ++prefix;
+            }
+            size_t suffix = 0;
+            while (prefix + suffix < maxCommon &&
+                   coinbase[coinbase.size() - suffix - 1] ==
+                       prevCoinbase[prevCoinbase.size() - suffix - 1]) {
+                ++suffix;
+            }
+
+            uint8_t flags = 0;
+            if (auxpow.hashBlock.IsNull()) {
+                flags |= HASH_BLOCK_NULL;
+            } else if (auxpow.hashBlock == parent.GetHash()) {
+                flags |= HASH_BLOCK_PARENT;
+            }
+            if (auxpow.nIndex == 0) {
+                flags |= INDEX_ZERO;
+            }
+            if (parent.hashMerkleRoot == ComputeParentRoot(auxpow)) {
+                flags |= PARENT_ROOT_DERIVED;
+            }
+
+            s << flags;
+            WriteCompactSize(s, prefix);
+            WriteCompactSize(s, suffix);
+            const size_t diffSize = coinbase.size() - prefix - suffix;
+            WriteCompactSize(s, diffSize);
+            s << Span{coinbase}.subspan(prefix, diffSize);
+            if (!(flags & (HASH_BLOCK_NULL | HASH_BLOCK_PARENT))) {
+                s << auxpow.hashBlock;
+            }
+            s << auxpow.vMerkleBranch;
+            if (!(flags & INDEX_ZERO)) {
+                s << auxpow.nIndex;
+            }
+            s << auxpow.vChainMerkleBranch << auxpow.nChainIndex;
+            s << parent.nVersion << parent.hashPrevBlock;
+            if (!(flags & PARENT_ROOT_DERIVED)) {
+                s << parent.hashMerkleRoot;
+            }
+            s << parent.nTime << parent.nBits << parent.nNonce;
+
+            prevCoinbase = std::move(coinbase);
+        }
+    }
+
+    template <typename Stream> void Unserialize(Stream &s) {
+        // Headers are read one by one rather than allocated upfront, so a
+        // bogus count can't make us allocate a lot of memory.
+        const uint64_t count = ReadCompactSize(s);
+        headers.clear();
+        std::vector<uint8_t> prevCoinbase;
+        size_t coinbaseBytes = 0;
+        for (uint64_t i = 0; i < count; ++i) {
+            CBlockHeader &header = headers.emplace_back();
+            s >> static_cast<CBaseBlockHeader &>(header);
+            if (!VersionHasAuxPow(header.nVersion)) {
+                continue;
+            }
+            header.auxpow = std::make_shared<CAuxPow>();
+            CAuxPow &auxpow = *header.auxpow;
+            CBaseBlockHeader &parent = auxpow.parentBlock;
+
+            uint8_t flags;
+            s >> flags;
+            if ((flags & ~ALL_FLAGS) ||
+                ((flags & HASH_BLOCK_NULL) && (flags & HASH_BLOCK_PARENT))) {
+                throw std::ios_base::failure("invalid compact auxpow flags");
+            }
+            const uint64_t prefix = ReadCompactSize(s);
+            const uint64_t suffix = ReadCompactSize(s);
+            if (prefix + suffix > prevCoinbase.size()) {
+                throw std::ios_base::failure(
+                    "compact auxpow coinbase out of range");
+            }
+            std::vector<uint8_t> diff;
+            s >> diff;
+            std::vector<uint8_t> coinbase(prevCoinbase.begin(),
+                                          prevCoinbase.begin() + prefix);
+            coinbase.insert(coinbase.end(), diff.begin(), diff.end());
+            coinbase.insert(coinbase.end(), prevCoinbase.end() - suffix,
+                            prevCoinbase.end());
+            coinbaseBytes += coinbase.size();
+            if (coinbaseBytes > MAX_AUXHEADERS_COINBASE_BYTES) {
+                throw std::ios_base::failure("compact auxpow coinbases too large");
+            }
+            auxpow.coinbaseTx = UnserializeCoinbase(coinbase);
+
+            if (!(flags & (HASH_BLOCK_NULL | HASH_BLOCK_PARENT))) {
+                s >> auxpow.hashBlock;
+            }
+            s >> auxpow.vMerkleBranch;
+            auxpow.nIndex = 0;
+            if (!(flags & INDEX_ZERO)) {
+                s >> auxpow.nIndex;
+            }
+            s >> auxpow.vChainMerkleBranch >> auxpow.nChainIndex;
+            s >> parent.nVersion >> parent.hashPrevBlock;
+            if (flags & PARENT_ROOT_DERIVED) {
+                parent.hashMerkleRoot = ComputeParentRoot(auxpow);
+            } else {
+                s >> parent.hashMerkleRoot;
+            }
+            s >> parent.nTime >> parent.nBits >> parent.nNonce;
+            if (flags & HASH_BLOCK_PARENT) {
+                auxpow.hashBlock = parent.GetHash();
+            }
+
+            prevCoinbase = std::move(coinbase);
+        }
+    }
+};
+
 class PartiallyDownloadedBlock {
     struct CTransactionRefCompare {
         bool operator()(const CTransactionRef &lhs,
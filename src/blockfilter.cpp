@@ -34,10 +34,14 @@ uint64_t GCSFilter::HashToRange(const Element &element) const {
 
 std::vector<uint64_t>
 GCSFilter::BuildHashedSet(const ElementSet &elements) const {
+    // The hasher is keyed once, and copied for each element.
+    const CSipHasher hasher(m_params.m_siphash_k0, m_params.m_siphash_k1);
     std::vector<uint64_t> hashed_elements;
     hashed_elements.reserve(elements.size());
     for (const Element &element : elements) {
-        hashed_elements.push_back(HashToRange(element));
+        hashed_elements.push_back(FastRange64(
+            CSipHasher(hasher).Write(element.data(), element.size()).Finalize(),
+            m_F));
     }
     std::sort(hashed_elements.begin(), hashed_elements.end());
     return hashed_elements;
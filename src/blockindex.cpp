@@ -35,11 +35,15 @@ std::string CBlockIndex::ToString() const {
 CBlockHeader
 CBlockIndex::GetBlockHeader(const node::BlockManager &blockman) const {
     CBlockHeader block;
-    if (VersionHasAuxPow(nVersion)) {
+    if (VersionHasAuxPow(nVersion) &&
+        !blockman.ReadAuxPow(*this, block.auxpow)) {
+        // The auxpow isn't in the block tree DB (the entry predates it), fall
+        // back to reading the header from the block files.
         if (!blockman.ReadBlockHeaderFromDisk(block, *this)) {
             throw std::ios_base::failure(
                 "Failed reading AuxPow CBlockIndex header from disk");
         }
+        blockman.CacheAuxPow(*this, block.auxpow);
         return block;
     }
     block.nVersion = nVersion;
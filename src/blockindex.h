@@ -80,6 +80,9 @@ public:
     //! @sa ActivateSnapshot
     unsigned int nChainTx{0};
 
+    //! (memory only) Maximum nTime in the chain up to and including this block.
+    unsigned int nTimeMax{0};
+
 private:
     //! (memory only) Size of all blocks in the chain up to and including this
     //! block. This value will be non-zero only if and only if transactions for
@@ -90,6 +93,10 @@ public:
     //! Verification status of this block. See enum BlockStatus
     BlockStatus nStatus GUARDED_BY(::cs_main){};
 
+    //! The script flags the block scripts were verified with, only meaningful
+    //! if nStatus.hasCheckedScripts().
+    uint32_t nScriptFlags GUARDED_BY(::cs_main){0};
+
     //! block header
     int32_t nVersion{0};
     uint256 hashMerkleRoot{};
@@ -104,9 +111,6 @@ public:
     //! (memory only) block header metadata
     int64_t nTimeReceived{0};
 
-    //! (memory only) Maximum nTime in the chain up to and including this block.
-    unsigned int nTimeMax{0};
-
     explicit CBlockIndex() = default;
 
     explicit CBlockIndex(const CBlockHeader &block)
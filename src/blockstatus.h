@@ -48,6 +48,20 @@ private:
      */
     static const uint32_t ASSUMED_VALID_FLAG = 0x200;
 
+    /**
+     * Dogecoin: the block data stored in blk*.dat has passed the (aux)PoW
+     * check when it was accepted, so reading it back from disk doesn't need to
+     * recompute the scrypt hash.
+     */
+    static const uint32_t POW_CHECKED_FLAG = 0x400;
+
+    /**
+     * The scripts of the block have been verified when it was connected, with
+     * the script flags stored alongside in the block index. Connecting the
+     * block again on top of the same parent doesn't need to run them again.
+     */
+    static const uint32_t SCRIPTS_CHECKED_FLAG = 0x800;
+
 public:
     explicit constexpr BlockStatus() : status(0) {}
 
@@ -116,6 +130,18 @@ public:
         return BlockStatus(status & ~ASSUMED_VALID_FLAG);
     }
 
+    bool hasCheckedPoW() const { return status & POW_CHECKED_FLAG; }
+    BlockStatus withCheckedPoW(bool checked = true) const {
+        return BlockStatus((status & ~POW_CHECKED_FLAG) |
+                           (checked ? POW_CHECKED_FLAG : 0));
+    }
+
+    bool hasCheckedScripts() const { return status & SCRIPTS_CHECKED_FLAG; }
+    BlockStatus withCheckedScripts(bool checked = true) const {
+        return BlockStatus((status & ~SCRIPTS_CHECKED_FLAG) |
+                           (checked ? SCRIPTS_CHECKED_FLAG : 0));
+    }
+
     bool isInvalid() const { return status & INVALID_MASK; }
     BlockStatus withClearedFailureFlags() const {
         return BlockStatus(status & ~INVALID_MASK);
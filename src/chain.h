@@ -111,6 +111,22 @@ public:
         READWRITE(obj.nTime);
         READWRITE(obj.nBits);
         READWRITE(obj.nNonce);
+
+        // Serialized last so older versions, which don't know about the flag,
+        // can still read the entry and ignore the trailing bytes. An older
+        // version rewriting the entry keeps the status bit but drops the
+        // flags, in which case the scripts are treated as not checked.
+        if (obj.nStatus.hasCheckedScripts()) {
+            SER_WRITE(obj, s << VARINT(obj.nScriptFlags));
+            SER_READ(obj, {
+                try {
+                    s >> VARINT(obj.nScriptFlags);
+                } catch (const std::ios_base::failure &) {
+                    obj.nStatus = obj.nStatus.withCheckedScripts(false);
+                    obj.nScriptFlags = 0;
+                }
+            });
+        }
     }
 
     BlockHash ConstructBlockHash() const {
@@ -7,10 +7,16 @@
 
 #include <sync.h>
 #include <tinyformat.h>
+#include <util/metrics.h>
 #include <util/threadnames.h>
+#include <util/time.h>
+#include <validationthreadpool.h>
+#include <workstealingdeque.h>
 
 #include <algorithm>
+#include <atomic>
 #include <iterator>
+#include <memory>
 #include <vector>
 
 template <typename T> class CCheckQueueControl;
@@ -24,6 +30,14 @@ template <typename T> class CCheckQueueControl;
  * queue, where they are processed by N-1 worker threads. When the master is
  * done adding work, it temporarily joins the worker pool as an N'th worker,
  * until all jobs are done.
+ *
+ * In work-stealing mode, the master splits the verifications into chunks and
+ * pushes them onto a lock-free deque it owns, from which the workers steal
+ * without taking the queue mutex. The mutex is then only used to put idle
+ * workers to sleep and to wake the master up once the last chunk completes.
+ *
+ * Instead of starting its own worker threads, the queue can also be served by
+ * the threads of a shared ValidationThreadPool.
  */
 template <typename T> class CCheckQueue {
 private:
@@ -62,6 +76,201 @@ private:
     std::vector<std::thread> m_worker_threads;
     bool m_request_stop GUARDED_BY(m_mutex){false};
 
+    //! Whether the queue operates in work-stealing mode. Only changed while
+    //! there is no worker thread.
+    bool m_work_stealing{false};
+
+    //! The shared pool providing the worker threads, if any. Only changed
+    //! while the pool is stopped.
+    ValidationThreadPool *m_pool{nullptr};
+
+    //! The number of worker threads, excluding the master.
+    int NumWorkers() const {
+        return m_pool ? m_pool->Size() : int(m_worker_threads.size());
+    }
+
+    //! The chunks of verifications in work-stealing mode. The deque is owned
+    //! by the master, the workers steal from it.
+    WorkStealingDeque<std::vector<T> *> m_deque;
+
+    //! Storage for the chunks of the current run, only accessed by the master.
+    std::vector<std::unique_ptr<std::vector<T>>> m_chunks;
+
+    //! Number of chunks that haven't completed yet in work-stealing mode.
+    std::atomic<unsigned int> m_chunks_todo{0};
+
+    //! Set as soon as a verification fails, so all the threads stop checking
+    //! the remaining ones. This is also the evaluation result in
+    //! work-stealing mode.
+    std::atomic<bool> m_abort{false};
+
+    //! Number of verifications that were skipped because another one failed.
+    std::atomic<size_t> m_skipped{0};
+
+    /**
+     * Execute a batch of verifications, stopping early if any verification
+     * failed in any thread, and return whether the batch succeeded. The
+     * verifications that were not executed are counted as skipped.
+     */
+    bool RunChecks(std::vector<T> &vChecks, bool fOk) {
+        size_t nRun = 0;
+        for (T &check : vChecks) {
+            if (!fOk || m_abort.load(std::memory_order_relaxed)) {
+                break;
+            }
+            fOk = check();
+            ++nRun;
+        }
+        if (!fOk) {
+            m_abort.store(true, std::memory_order_relaxed);
+        }
+        if (nRun < vChecks.size()) {
+            m_skipped.fetch_add(vChecks.size() - nRun,
+                                std::memory_order_relaxed);
+        }
+        return fOk;
+    }
+
+    /**
+     * After a failure, drop the verifications still in the queue rather than
+     * letting the workers skip them one batch at a time.
+     */
+    void DropQueue() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        if (!fAllOk && !queue.empty()) {
+            m_skipped.fetch_add(queue.size(), std::memory_order_relaxed);
+            nTodo -= queue.size();
+            queue.clear();
+        }
+    }
+
+    /** Execute a chunk of verifications in work-stealing mode. */
+    void RunChunk(std::vector<T> &chunk) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        RunChecks(chunk, true);
+        // Destroy the checks now, so they are all gone by the time the
+        // master returns.
+        chunk.clear();
+        if (m_chunks_todo.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // We processed the last chunk; inform the master it can exit and
+            // return the result. Notify under the lock so the wake up can't
+            // be missed.
+            LOCK(m_mutex);
+            m_master_cv.notify_one();
+        }
+    }
+
+    /** Worker loop in work-stealing mode. */
+    void StealLoop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        while (true) {
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_worker_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(
+                                           m_mutex) {
+                    return m_request_stop || !m_deque.Empty();
+                });
+                if (m_request_stop) {
+                    return;
+                }
+            }
+            while (auto chunk = m_deque.Steal()) {
+                RunChunk(**chunk);
+            }
+        }
+    }
+
+    /** Master side of Wait() in work-stealing mode. */
+    bool WaitStealing() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        while (auto chunk = m_deque.Pop()) {
+            RunChunk(**chunk);
+        }
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_master_cv.wait(lock, [&]() {
+                return m_chunks_todo.load(std::memory_order_acquire) == 0;
+            });
+        }
+        m_chunks.clear();
+        return !m_abort.load(std::memory_order_relaxed);
+    }
+
+    /** Master side of Add() in work-stealing mode. */
+    void AddStealing(std::vector<T> &&vChecks)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        if (vChecks.empty()) {
+            return;
+        }
+        // Aim for a few chunks per worker so the load balances, without
+        // exceeding nBatchSize.
+        const size_t nChunkSize = std::clamp<size_t>(
+            vChecks.size() / (4 * NumWorkers() + 1), 1, nBatchSize);
+        for (auto it = vChecks.begin(); it != vChecks.end();) {
+            const size_t nNow =
+                std::min<size_t>(nChunkSize, std::distance(it, vChecks.end()));
+            auto &chunk = m_chunks.emplace_back(
+                std::make_unique<std::vector<T>>(
+                    std::make_move_iterator(it),
+                    std::make_move_iterator(it + nNow)));
+            m_chunks_todo.fetch_add(1, std::memory_order_relaxed);
+            m_deque.Push(chunk.get());
+            it += nNow;
+        }
+        // Take the lock so a worker can't miss the wake up between checking
+        // the deque and going to sleep.
+        { LOCK(m_mutex); }
+        m_worker_cv.notify_all();
+        if (m_pool) {
+            m_pool->Notify();
+        }
+    }
+
+    /**
+     * Run one batch of verifications on behalf of a pool worker, without
+     * blocking. Return whether there was some work to do.
+     */
+    bool TryRunBatch() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        if (m_work_stealing) {
+            if (auto chunk = m_deque.Steal()) {
+                RunChunk(**chunk);
+                return true;
+            }
+            // A steal can fail spuriously, retry while there is work left.
+            return !m_deque.Empty();
+        }
+
+        std::vector<T> vChecks;
+        unsigned int nNow;
+        bool fOk;
+        {
+            LOCK(m_mutex);
+            if (queue.empty()) {
+                return false;
+            }
+            // Same batch sizing as in Loop(), accounting for the pool workers
+            // that can help.
+            nNow = std::max(
+                1U, std::min(nBatchSize,
+                             (unsigned int)queue.size() /
+                                 (nTotal + nIdle + NumWorkers() + 1)));
+            auto start_it = queue.end() - nNow;
+            vChecks.assign(std::make_move_iterator(start_it),
+                           std::make_move_iterator(queue.end()));
+            queue.erase(start_it, queue.end());
+            fOk = fAllOk;
+        }
+        fOk = RunChecks(vChecks, fOk);
+        vChecks.clear();
+
+        LOCK(m_mutex);
+        fAllOk &= fOk;
+        nTodo -= nNow;
+        DropQueue();
+        if (nTodo == 0) {
+            // We processed the last element; inform the master it can exit
+            // and return the result
+            m_master_cv.notify_one();
+        }
+        return true;
+    }
+
     /** Internal function that does bulk of the verification work. */
     bool Loop(bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
         std::condition_variable &cond = fMaster ? m_master_cv : m_worker_cv;
@@ -77,6 +286,7 @@ private:
                 if (nNow) {
                     fAllOk &= fOk;
                     nTodo -= nNow;
+                    DropQueue();
                     if (nTodo == 0 && !fMaster) {
                         // We processed the last element; inform the master it
                         // can exit and return the result
@@ -123,11 +333,7 @@ private:
                 fOk = fAllOk;
             }
             // execute work
-            for (T &check : vChecks) {
-                if (fOk) {
-                    fOk = check();
-                }
-            }
+            fOk = RunChecks(vChecks, fOk);
             vChecks.clear();
         } while (true);
     }
@@ -140,8 +346,10 @@ public:
     explicit CCheckQueue(unsigned int nBatchSizeIn)
         : nBatchSize(nBatchSizeIn) {}
 
-    //! Create a pool of new worker threads.
-    void StartWorkerThreads(const int threads_num)
+    //! Create a pool of new worker threads. If work_stealing is set, the
+    //! workers steal chunks of checks from a lock-free deque instead of
+    //! sharing a mutex-protected queue.
+    void StartWorkerThreads(const int threads_num, bool work_stealing = false)
         EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
         {
             LOCK(m_mutex);
@@ -150,30 +358,83 @@ public:
             fAllOk = true;
         }
         assert(m_worker_threads.empty());
+        m_work_stealing = work_stealing;
         for (int n = 0; n < threads_num; ++n) {
             m_worker_threads.emplace_back([this, n]() {
                 util::ThreadRename(strprintf("scriptch.%i", n));
-                Loop(false /* worker thread */);
+                if (m_work_stealing) {
+                    StealLoop();
+                } else {
+                    Loop(false /* worker thread */);
+                }
             });
         }
     }
 
+    //! Let the threads of a shared pool process the checks instead of
+    //! dedicated worker threads. This must be called before the pool starts.
+    void StartWorkerPool(ValidationThreadPool &pool,
+                         ValidationThreadPool::Priority priority,
+                         bool work_stealing = false)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        assert(m_worker_threads.empty() && m_pool == nullptr);
+        {
+            LOCK(m_mutex);
+            nIdle = 0;
+            nTotal = 0;
+            fAllOk = true;
+        }
+        m_work_stealing = work_stealing;
+        m_pool = &pool;
+        pool.AddWorkSource(priority, [this]() { return TryRunBatch(); });
+    }
+
+    //! Stop using the shared pool, which must have been stopped already.
+    void StopWorkerPool() {
+        m_pool = nullptr;
+        m_work_stealing = false;
+    }
+
     //! Wait until execution finishes, and return whether all evaluations were
-    //! successful.
-    bool Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
-        return Loop(true /* master thread */);
+    //! successful. As soon as an evaluation fails the remaining ones are
+    //! skipped; if pnSkipped is not null it is set to how many were skipped.
+    bool Wait(size_t *pnSkipped = nullptr) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        const bool fRet =
+            m_work_stealing ? WaitStealing() : Loop(true /* master thread */);
+        // reset the status for new work later
+        m_abort.store(false, std::memory_order_relaxed);
+        const size_t nSkipped = m_skipped.exchange(0);
+        if (pnSkipped) {
+            *pnSkipped = nSkipped;
+        }
+        return fRet;
     }
 
     //! Add a batch of checks to the queue
     void Add(std::vector<T> &&vChecks) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
-        LOCK(m_mutex);
-        queue.insert(queue.end(), std::make_move_iterator(vChecks.begin()),
-                     std::make_move_iterator(vChecks.end()));
-        nTodo += vChecks.size();
-        if (vChecks.size() == 1) {
-            m_worker_cv.notify_one();
-        } else if (vChecks.size() > 1) {
-            m_worker_cv.notify_all();
+        if (m_abort.load(std::memory_order_relaxed)) {
+            // A check already failed, don't bother queueing more
+            m_skipped.fetch_add(vChecks.size(), std::memory_order_relaxed);
+            return;
+        }
+        if (m_work_stealing) {
+            AddStealing(std::move(vChecks));
+            return;
+        }
+        {
+            LOCK(m_mutex);
+            queue.insert(queue.end(),
+                         std::make_move_iterator(vChecks.begin()),
+                         std::make_move_iterator(vChecks.end()));
+            nTodo += vChecks.size();
+            if (vChecks.size() == 1) {
+                m_worker_cv.notify_one();
+            } else if (vChecks.size() > 1) {
+                m_worker_cv.notify_all();
+            }
+        }
+        if (m_pool && !vChecks.empty()) {
+            m_pool->Notify();
         }
     }
 
@@ -186,6 +447,7 @@ public:
         }
         m_worker_threads.clear();
         WITH_LOCK(m_mutex, m_request_stop = false);
+        m_work_stealing = false;
     }
 
     ~CCheckQueue() { assert(m_worker_threads.empty()); }
@@ -199,25 +461,46 @@ template <typename T> class CCheckQueueControl {
 private:
     CCheckQueue<T> *const pqueue;
     bool fDone;
+    const SteadyClock::time_point m_start;
+
+    static metrics::Histogram &PhaseTime(const std::string &phase) {
+        return metrics::GetHistogram(
+            "checkqueue", "Time spent running the checks of a check queue",
+            {"phase", phase});
+    }
 
 public:
     CCheckQueueControl() = delete;
     CCheckQueueControl(const CCheckQueueControl &) = delete;
     CCheckQueueControl &operator=(const CCheckQueueControl &) = delete;
     explicit CCheckQueueControl(CCheckQueue<T> *const pqueueIn)
-        : pqueue(pqueueIn), fDone(false) {
+        : pqueue(pqueueIn), fDone(false), m_start(SteadyClock::now()) {
         // passed queue is supposed to be unused, or nullptr
         if (pqueue != nullptr) {
             ENTER_CRITICAL_SECTION(pqueue->m_control_mutex);
         }
     }
 
-    bool Wait() {
+    bool Wait(size_t *pnSkipped = nullptr) {
         if (pqueue == nullptr) {
+            if (pnSkipped) {
+                *pnSkipped = 0;
+            }
             return true;
         }
-        bool fRet = pqueue->Wait();
+        // The run time also covers queueing the checks, the wait time is what
+        // is left for the workers once the master has queued all of them.
+        static metrics::Histogram &wait_time{PhaseTime("wait")};
+        static metrics::Histogram &run_time{PhaseTime("run")};
+        const SteadyClock::time_point wait_start{SteadyClock::now()};
+        bool fRet = pqueue->Wait(pnSkipped);
         fDone = true;
+        const SteadyClock::time_point end{SteadyClock::now()};
+        wait_time.Record(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                end - wait_start));
+        run_time.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+            end - m_start));
         return fRet;
     }
 
@@ -10,6 +10,8 @@
 #include <util/trace.h>
 #include <version.h>
 
+#include <algorithm>
+
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return false;
 }
@@ -23,9 +25,21 @@ bool CCoinsView::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
                             bool erase) {
     return false;
 }
+bool CCoinsView::BatchWritePartial(CCoinsMap &mapCoins,
+                                   const BlockHash &hashBlock) {
+    return false;
+}
 CCoinsViewCursor *CCoinsView::Cursor() const {
     return nullptr;
 }
+std::vector<std::unique_ptr<CCoinsViewCursor>>
+CCoinsView::ShardedCursors(size_t num_shards) const {
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    if (CCoinsViewCursor *cursor = Cursor()) {
+        cursors.emplace_back(cursor);
+    }
+    return cursors;
+}
 bool CCoinsView::HaveCoin(const COutPoint &outpoint) const {
     Coin coin;
     return GetCoin(outpoint, coin);
@@ -51,9 +65,17 @@ bool CCoinsViewBacked::BatchWrite(CCoinsMap &mapCoins,
                                   const BlockHash &hashBlock, bool erase) {
     return base->BatchWrite(mapCoins, hashBlock, erase);
 }
+bool CCoinsViewBacked::BatchWritePartial(CCoinsMap &mapCoins,
+                                         const BlockHash &hashBlock) {
+    return base->BatchWritePartial(mapCoins, hashBlock);
+}
 CCoinsViewCursor *CCoinsViewBacked::Cursor() const {
     return base->Cursor();
 }
+std::vector<std::unique_ptr<CCoinsViewCursor>>
+CCoinsViewBacked::ShardedCursors(size_t num_shards) const {
+    return base->ShardedCursors(num_shards);
+}
 size_t CCoinsViewBacked::EstimateSize() const {
     return base->EstimateSize();
 }
@@ -65,13 +87,15 @@ CCoinsViewCache::CCoinsViewCache(CCoinsView *baseIn, bool deterministic)
       cachedCoinsUsage(0) {}
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
-    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
+    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage +
+           memusage::DynamicUsage(m_dirty_order);
 }
 
 CCoinsMap::iterator
 CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
     if (it != cacheCoins.end()) {
+        it->second.recently_used = true;
         return it;
     }
     Coin tmp;
@@ -136,6 +160,7 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin coin,
         // DIRTY, then it can be marked FRESH.
         fresh = !(it->second.flags & CCoinsCacheEntry::DIRTY);
     }
+    OnMarkDirty(outpoint, it->second);
     it->second.coin = std::move(coin);
     it->second.flags |=
         CCoinsCacheEntry::DIRTY | (fresh ? CCoinsCacheEntry::FRESH : 0);
@@ -148,11 +173,23 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin coin,
 void CCoinsViewCache::EmplaceCoinInternalDANGER(COutPoint &&outpoint,
                                                 Coin &&coin) {
     cachedCoinsUsage += coin.DynamicMemoryUsage();
+    if (m_track_dirty) {
+        m_dirty_order.push_back(outpoint);
+    }
     cacheCoins.emplace(
         std::piecewise_construct, std::forward_as_tuple(std::move(outpoint)),
         std::forward_as_tuple(std::move(coin), CCoinsCacheEntry::DIRTY));
 }
 
+void CCoinsViewCache::EmplaceFetchedCoin(const COutPoint &outpoint,
+                                         Coin &&coin) {
+    assert(!coin.IsSpent());
+    auto [it, inserted] = cacheCoins.try_emplace(outpoint, std::move(coin));
+    if (inserted) {
+        cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+    }
+}
+
 void AddCoins(CCoinsViewCache &cache, const CTransaction &tx, int nHeight,
               bool check_for_overwrite) {
     bool fCoinbase = tx.IsCoinBase();
@@ -185,6 +222,7 @@ bool CCoinsViewCache::SpendCoin(const COutPoint &outpoint, Coin *moveout) {
     if (it->second.flags & CCoinsCacheEntry::FRESH) {
         cacheCoins.erase(it);
     } else {
+        OnMarkDirty(outpoint, it->second);
         it->second.flags |= CCoinsCacheEntry::DIRTY;
         it->second.coin.Clear();
     }
@@ -211,6 +249,11 @@ bool CCoinsViewCache::HaveCoinInCache(const COutPoint &outpoint) const {
     return (it != cacheCoins.end() && !it->second.coin.IsSpent());
 }
 
+const Coin *CCoinsViewCache::PeekCoinInCache(const COutPoint &outpoint) const {
+    CCoinsMap::const_iterator it = cacheCoins.find(outpoint);
+    return it != cacheCoins.end() ? &it->second.coin : nullptr;
+}
+
 BlockHash CCoinsViewCache::GetBestBlock() const {
     if (hashBlock.IsNull()) {
         hashBlock = base->GetBestBlock();
@@ -248,6 +291,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins,
                     entry.coin = it->second.coin;
                 }
                 cachedCoinsUsage += entry.coin.DynamicMemoryUsage();
+                OnMarkDirty(it->first, entry);
                 entry.flags = CCoinsCacheEntry::DIRTY;
                 // We can mark it FRESH in the parent if it was FRESH in the
                 // child. Otherwise it might have just been flushed from the
@@ -286,6 +330,7 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins,
                     itUs->second.coin = it->second.coin;
                 }
                 cachedCoinsUsage += itUs->second.coin.DynamicMemoryUsage();
+                OnMarkDirty(it->first, itUs->second);
                 itUs->second.flags |= CCoinsCacheEntry::DIRTY;
                 // NOTE: It isn't safe to mark the coin as FRESH in the parent
                 // cache. If it already existed and was spent in the parent
@@ -298,6 +343,16 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins,
     return true;
 }
 
+bool CCoinsViewCache::BatchWritePartial(CCoinsMap &mapCoins,
+                                        const BlockHash &hashBlockIn) {
+    // The changes are merged as usual, but this cache is not any closer to
+    // hashBlockIn as a whole.
+    const BlockHash best_block = hashBlock;
+    const bool ok = BatchWrite(mapCoins, hashBlockIn, /*erase=*/true);
+    hashBlock = best_block;
+    return ok;
+}
+
 bool CCoinsViewCache::Flush() {
     bool fOk = base->BatchWrite(cacheCoins, hashBlock, /*erase=*/true);
     if (fOk) {
@@ -308,6 +363,7 @@ bool CCoinsViewCache::Flush() {
         ReallocateCache();
     }
     cachedCoinsUsage = 0;
+    ClearDirtyOrder();
     return fOk;
 }
 
@@ -324,9 +380,124 @@ bool CCoinsViewCache::Sync() {
             ++it;
         }
     }
+    ClearDirtyOrder();
     return fOk;
 }
 
+void CCoinsViewCache::SetTrackDirty(bool track_dirty) {
+    m_track_dirty = track_dirty;
+    ClearDirtyOrder();
+}
+
+void CCoinsViewCache::ClearDirtyOrder() {
+    m_dirty_order.clear();
+    m_dirty_order.shrink_to_fit();
+    m_dirty_begin = 0;
+}
+
+bool CCoinsViewCache::SyncPartial(size_t max_bytes) {
+    assert(m_track_dirty);
+    CCoinsMapMemoryResource resource;
+    CCoinsMap batch{0, SaltedOutpointHasher{/*deterministic=*/m_deterministic},
+                    CCoinsMap::key_equal{}, &resource};
+
+    // Copy the oldest dirty entries, so this cache is left untouched if the
+    // write fails.
+    size_t pos = m_dirty_begin;
+    size_t batch_bytes = 0;
+    for (; pos < m_dirty_order.size() && batch_bytes < max_bytes; ++pos) {
+        const COutPoint &outpoint = m_dirty_order[pos];
+        CCoinsMap::const_iterator it = cacheCoins.find(outpoint);
+        if (it == cacheCoins.end() ||
+            !(it->second.flags & CCoinsCacheEntry::DIRTY)) {
+            // Erased or written back already.
+            continue;
+        }
+        if (batch.emplace(outpoint, it->second).second) {
+            batch_bytes += sizeof(CCoinsMap::value_type) +
+                           it->second.coin.DynamicMemoryUsage();
+        }
+    }
+
+    std::vector<COutPoint> written;
+    written.reserve(batch.size());
+    for (const auto &[outpoint, _] : batch) {
+        written.push_back(outpoint);
+    }
+    if (!batch.empty() && !base->BatchWritePartial(batch, hashBlock)) {
+        return false;
+    }
+
+    for (const COutPoint &outpoint : written) {
+        CCoinsMap::iterator it = cacheCoins.find(outpoint);
+        assert(it != cacheCoins.end());
+        if (it->second.coin.IsSpent()) {
+            cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+            cacheCoins.erase(it);
+        } else {
+            it->second.flags = 0;
+        }
+    }
+
+    m_dirty_begin = pos;
+    if (m_dirty_begin == m_dirty_order.size()) {
+        m_dirty_order.clear();
+        m_dirty_begin = 0;
+    } else if (2 * m_dirty_begin >= m_dirty_order.size()) {
+        m_dirty_order.erase(m_dirty_order.begin(),
+                            m_dirty_order.begin() + m_dirty_begin);
+        m_dirty_begin = 0;
+    }
+    return true;
+}
+
+//! The memory used by a cache entry, besides the one of its coin.
+static size_t EntryMemoryUsage() {
+    return memusage::MallocUsage(sizeof(CCoinsMap::value_type) +
+                                 sizeof(void *));
+}
+
+size_t CCoinsViewCache::EntriesMemoryUsage() const {
+    return cacheCoins.size() * EntryMemoryUsage() + cachedCoinsUsage +
+           memusage::DynamicUsage(m_dirty_order);
+}
+
+size_t CCoinsViewCache::EvictCoins(size_t target_usage) {
+    size_t usage = EntriesMemoryUsage();
+    const size_t buckets = cacheCoins.bucket_count();
+    size_t evicted = 0;
+    std::vector<COutPoint> bucket_evicted;
+    // Two sweeps at most, as the first one may only clear the recently used
+    // flags.
+    for (size_t swept = 0; swept < 2 * buckets && usage > target_usage;
+         ++swept) {
+        if (m_evict_hand >= buckets) {
+            m_evict_hand = 0;
+        }
+        const size_t bucket = m_evict_hand++;
+        for (auto it = cacheCoins.begin(bucket); it != cacheCoins.end(bucket);
+             ++it) {
+            CCoinsCacheEntry &entry = it->second;
+            if (entry.flags != 0) {
+                continue;
+            }
+            if (entry.recently_used) {
+                entry.recently_used = false;
+                continue;
+            }
+            bucket_evicted.push_back(it->first);
+            usage -= std::min(
+                usage, EntryMemoryUsage() + entry.coin.DynamicMemoryUsage());
+        }
+        for (const COutPoint &outpoint : bucket_evicted) {
+            Uncache(outpoint);
+        }
+        evicted += bucket_evicted.size();
+        bucket_evicted.clear();
+    }
+    return evicted;
+}
+
 void CCoinsViewCache::Uncache(const COutPoint &outpoint) {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
     if (it != cacheCoins.end() && it->second.flags == 0) {
@@ -6,7 +6,12 @@
 #ifndef BITCOIN_COINS_H
 #define BITCOIN_COINS_H
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <compressor.h>
+#include <flathashmap.h>
 #include <memusage.h>
 #include <primitives/blockhash.h>
 #include <serialize.h>
@@ -16,7 +21,9 @@
 #include <cassert>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 /**
  * A UTXO entry.
@@ -92,6 +99,9 @@ struct CCoinsCacheEntry {
     // The actual cached data.
     Coin coin;
     uint8_t flags;
+    //! Whether the coin was accessed since the eviction last went over it.
+    //! @sa CCoinsViewCache::EvictCoins()
+    bool recently_used{false};
 
     enum Flags {
         /**
@@ -131,6 +141,16 @@ struct CCoinsCacheEntry {
  * thus be sufficient so that all implementations can allocate the nodes from
  * the PoolAllocator.
  */
+#ifdef ENABLE_FLAT_COINS_MAP
+/**
+ * With ENABLE_FLAT_COINS_MAP, the coins are stored inline in an open addressing
+ * table instead. Note that inserting a coin then moves the other ones.
+ */
+using CCoinsMap = FlatHashMap<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher,
+                              std::equal_to<COutPoint>>;
+
+using CCoinsMapMemoryResource = CCoinsMap::ResourceType;
+#else
 using CCoinsMap = std::unordered_map<
     COutPoint, CCoinsCacheEntry, SaltedOutpointHasher, std::equal_to<COutPoint>,
     PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
@@ -138,6 +158,7 @@ using CCoinsMap = std::unordered_map<
                       sizeof(void *) * 4>>;
 
 using CCoinsMapMemoryResource = CCoinsMap::allocator_type::ResourceType;
+#endif
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor {
@@ -187,9 +208,26 @@ public:
     virtual bool BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
                             bool erase = true);
 
+    //! Write back some of the Coin changes up to hashBlock, without the
+    //! BestBlock change. The view is only consistent with hashBlock again
+    //! after a BatchWrite of the remaining changes. The passed mapCoins is
+    //! emptied.
+    virtual bool BatchWritePartial(CCoinsMap &mapCoins,
+                                   const BlockHash &hashBlock);
+
     //! Get a cursor to iterate over the whole state
     virtual CCoinsViewCursor *Cursor() const;
 
+    /**
+     * Get cursors over disjoint ranges of keys, which can be iterated in
+     * parallel and together cover the whole state as of the same time. The
+     * ranges are in key order, and all the outputs of a transaction are in the
+     * same range. At most num_shards cursors are returned, a single one if
+     * the view can not be split.
+     */
+    virtual std::vector<std::unique_ptr<CCoinsViewCursor>>
+    ShardedCursors(size_t num_shards) const;
+
     //! As we use CCoinsViews polymorphically, have a virtual destructor
     virtual ~CCoinsView() {}
 
@@ -211,7 +249,11 @@ public:
     void SetBackend(CCoinsView &viewIn);
     bool BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
                     bool erase = true) override;
+    bool BatchWritePartial(CCoinsMap &mapCoins,
+                           const BlockHash &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
+    std::vector<std::unique_ptr<CCoinsViewCursor>>
+    ShardedCursors(size_t num_shards) const override;
     size_t EstimateSize() const override;
 };
 
@@ -234,6 +276,20 @@ protected:
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage;
 
+    //! Whether the outpoints of the entries getting dirty are recorded, so
+    //! they can be written back incrementally by SyncPartial().
+    bool m_track_dirty{false};
+
+    /**
+     * The outpoints of the entries that got dirty, oldest first, starting at
+     * m_dirty_begin. An entry may have been erased or written back since.
+     */
+    std::vector<COutPoint> m_dirty_order;
+    size_t m_dirty_begin{0};
+
+    //! The bucket of cacheCoins the eviction resumes from.
+    size_t m_evict_hand{0};
+
 public:
     CCoinsViewCache(CCoinsView *baseIn, bool deterministic = false);
 
@@ -250,6 +306,8 @@ public:
     void SetBestBlock(const BlockHash &hashBlock);
     bool BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
                     bool erase = true) override;
+    bool BatchWritePartial(CCoinsMap &mapCoins,
+                           const BlockHash &hashBlock) override;
     CCoinsViewCursor *Cursor() const override {
         throw std::logic_error(
             "CCoinsViewCache cursor iteration not supported.");
@@ -262,6 +320,12 @@ public:
      */
     bool HaveCoinInCache(const COutPoint &outpoint) const;
 
+    /**
+     * Return the coin loaded in this cache, which may be spent, or nullptr if
+     * it is not loaded. No calls to the backing CCoinsView are made.
+     */
+    const Coin *PeekCoinInCache(const COutPoint &outpoint) const;
+
     /**
      * Return a reference to Coin in the cache, or coinEmpty if not found.
      * This is more efficient than GetCoin.
@@ -289,6 +353,16 @@ public:
      */
     void EmplaceCoinInternalDANGER(COutPoint &&outpoint, Coin &&coin);
 
+    /**
+     * Add an unspent coin read from the backing view outside of this cache,
+     * unless the cache already has an entry for the outpoint. The coin is not
+     * marked dirty, as if it had been fetched by AccessCoin.
+     *
+     * Used to warm the cache with coins read from the database in parallel.
+     * @sa InputFetcher
+     */
+    void EmplaceFetchedCoin(const COutPoint &outpoint, Coin &&coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call has no
@@ -313,6 +387,39 @@ public:
      */
     bool Sync();
 
+    /**
+     * Record the order in which the entries get dirty, which SyncPartial()
+     * requires. This must be set while the cache has no dirty entry.
+     */
+    void SetTrackDirty(bool track_dirty);
+
+    /**
+     * Push the oldest modifications applied to this cache to its base, up to
+     * about max_bytes of coins, and mark them as not modified. The contents of
+     * this cache are retained, except for the spent coins written back. The
+     * base is not consistent with the best block of this cache until the next
+     * Sync() or Flush(). Failure to call one of these before destruction will
+     * cause the remaining changes to be forgotten. If false is returned, the
+     * state of this cache is unchanged and the state of its backing view is
+     * undefined.
+     */
+    bool SyncPartial(size_t max_bytes);
+
+    /**
+     * Evict coins which are not modified, the least recently used first, until
+     * the memory used by the cache entries gets below target_usage. This is
+     * not DynamicMemoryUsage(), as the memory of the map is reused for the
+     * next entries rather than freed. Return the number of coins evicted.
+     *
+     * The recency is approximated with the CLOCK algorithm: the buckets of the
+     * map are swept in a circle, evicting the coins not accessed since the
+     * previous sweep.
+     */
+    size_t EvictCoins(size_t target_usage);
+
+    //! The memory used by the cache entries, as if they were allocated anew.
+    size_t EntriesMemoryUsage() const;
+
     /**
      * Removes the UTXO with the given outpoint from the cache, if it is not
      * modified.
@@ -346,6 +453,15 @@ private:
      * increasing memory usage.
      */
     CCoinsMap::iterator FetchCoin(const COutPoint &outpoint) const;
+
+    /** Called before the entry for outpoint is marked dirty. */
+    void OnMarkDirty(const COutPoint &outpoint, const CCoinsCacheEntry &entry) {
+        if (m_track_dirty && !(entry.flags & CCoinsCacheEntry::DIRTY)) {
+            m_dirty_order.push_back(outpoint);
+        }
+    }
+
+    void ClearDirtyOrder();
 };
 
 //! Utility function to add all of a transaction's outputs to a cache.
@@ -14,6 +14,7 @@
 
 #include <cmath>
 #include <cstdlib>
+#include <utility>
 
 #include <algorithm>
 
@@ -212,6 +213,18 @@ static inline uint32_t RollingBloomHash(uint32_t nHashNum, uint32_t nTweak,
     return MurmurHash3(nHashNum * 0xFBA4C795 + nTweak, vDataToHash);
 }
 
+/**
+ * The nHashFuncs positions of a key are derived from two of its hashes as
+ * h1 + n * h2 (Kirsch and Mitzenmacher), which keeps the false positive rate
+ * of independent hash functions but only hashes the key twice. h2 is odd so
+ * the bits selected by the low 6 bits of the first 64 positions all differ.
+ */
+static inline std::pair<uint32_t, uint32_t>
+RollingBloomHashes(uint32_t nTweak, Span<const uint8_t> vKey) {
+    return {RollingBloomHash(0, nTweak, vKey),
+            RollingBloomHash(1, nTweak, vKey) | 1};
+}
+
 void CRollingBloomFilter::insert(Span<const uint8_t> vKey) {
     if (nEntriesThisGeneration == nEntriesPerGeneration) {
         nEntriesThisGeneration = 0;
@@ -231,8 +244,9 @@ void CRollingBloomFilter::insert(Span<const uint8_t> vKey) {
     }
     nEntriesThisGeneration++;
 
-    for (int n = 0; n < nHashFuncs; n++) {
-        uint32_t h = RollingBloomHash(n, nTweak, vKey);
+    const auto [h1, h2] = RollingBloomHashes(nTweak, vKey);
+    uint32_t h = h1;
+    for (int n = 0; n < nHashFuncs; n++, h += h2) {
         int bit = h & 0x3F;
         /* FastMod works with the upper bits of h, so it is safe to ignore that
          * the lower bits of h are already used for bit. */
@@ -247,8 +261,9 @@ void CRollingBloomFilter::insert(Span<const uint8_t> vKey) {
 }
 
 bool CRollingBloomFilter::contains(Span<const uint8_t> vKey) const {
-    for (int n = 0; n < nHashFuncs; n++) {
-        uint32_t h = RollingBloomHash(n, nTweak, vKey);
+    const auto [h1, h2] = RollingBloomHashes(nTweak, vKey);
+    uint32_t h = h1;
+    for (int n = 0; n < nHashFuncs; n++, h += h2) {
         int bit = h & 0x3F;
         uint32_t pos = FastRange32(h, data.size());
         /* If the relevant bit is not set in either data[pos & ~1] or data[pos |
@@ -5,6 +5,8 @@
 #include <consensus/merkle.h>
 #include <hash.h>
 
+#include <algorithm>
+
 /*     WARNING! If you're reading this because you're learning about crypto
        and/or designing a new system that will use merkle trees, keep in mind
        that the following merkle tree algorithm has a serious flaw related to
@@ -66,11 +68,126 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated) {
     return hashes[0];
 }
 
-uint256 BlockMerkleRoot(const CBlock &block, bool *mutated) {
+/** The number of levels hashed within each subtree by the parallel path. */
+static constexpr int MERKLE_SUBTREE_LEVELS{9};
+static constexpr size_t MERKLE_SUBTREE_LEAVES{size_t{1}
+                                              << MERKLE_SUBTREE_LEVELS};
+/** Below this, splitting the work costs more than it saves. */
+static constexpr size_t MERKLE_PARALLEL_MIN_LEAVES{4 * MERKLE_SUBTREE_LEAVES};
+
+uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated,
+                          const MerkleParallelFor &parallel_for) {
+    if (!parallel_for || hashes.size() < MERKLE_PARALLEL_MIN_LEAVES) {
+        return ComputeMerkleRoot(std::move(hashes), mutated);
+    }
+
+    // Each aligned run of MERKLE_SUBTREE_LEAVES leaves hashes to one node
+    // MERKLE_SUBTREE_LEVELS levels up, regardless of the rest of the tree. The
+    // last, partial, run gets its odd entries duplicated at the same levels as
+    // it would in the whole tree, as it starts at an even position on each of
+    // these levels. No pair spans two runs, so the mutation check holds too.
+    const size_t num_subtrees{(hashes.size() + MERKLE_SUBTREE_LEAVES - 1) /
+                              MERKLE_SUBTREE_LEAVES};
+    std::vector<uint256> roots(num_subtrees);
+    std::vector<uint8_t> subtree_mutated(num_subtrees, false);
+    parallel_for(num_subtrees, [&](size_t n) {
+        const size_t begin{n * MERKLE_SUBTREE_LEAVES};
+        const size_t end{
+            std::min(begin + MERKLE_SUBTREE_LEAVES, hashes.size())};
+        std::vector<uint256> level(hashes.begin() + begin,
+                                   hashes.begin() + end);
+        level.reserve(MERKLE_SUBTREE_LEAVES);
+        for (int i = 0; i < MERKLE_SUBTREE_LEVELS; ++i) {
+            if (mutated) {
+                for (size_t pos = 0; pos + 1 < level.size(); pos += 2) {
+                    if (level[pos] == level[pos + 1]) {
+                        subtree_mutated[n] = true;
+                    }
+                }
+            }
+            if (level.size() & 1) {
+                level.push_back(level.back());
+            }
+            SHA256D64(level[0].begin(), level[0].begin(), level.size() / 2);
+            level.resize(level.size() / 2);
+        }
+        roots[n] = level[0];
+    });
+
+    bool mutation{false};
+    const uint256 root{
+        ComputeMerkleRoot(std::move(roots), mutated ? &mutation : nullptr)};
+    if (mutated) {
+        *mutated = mutation ||
+                   std::any_of(subtree_mutated.begin(), subtree_mutated.end(),
+                               [](uint8_t m) { return m; });
+    }
+    return root;
+}
+
+static std::vector<uint256> BlockLeaves(const CBlock &block) {
     std::vector<uint256> leaves;
     leaves.resize(block.vtx.size());
     for (size_t s = 0; s < block.vtx.size(); s++) {
         leaves[s] = block.vtx[s]->GetId();
     }
-    return ComputeMerkleRoot(std::move(leaves), mutated);
+    return leaves;
+}
+
+uint256 BlockMerkleRoot(const CBlock &block, bool *mutated) {
+    return ComputeMerkleRoot(BlockLeaves(block), mutated);
+}
+
+uint256 BlockMerkleRoot(const CBlock &block, bool *mutated,
+                        const MerkleParallelFor &parallel_for) {
+    return ComputeMerkleRoot(BlockLeaves(block), mutated, parallel_for);
+}
+
+uint256 MerkleTreeCache::ComputeRoot(std::vector<uint256> leaves) {
+    std::vector<std::vector<uint256>> levels;
+    levels.push_back(std::move(leaves));
+    while (levels.back().size() > 1) {
+        const size_t depth{levels.size() - 1};
+        std::vector<uint256> &level = levels.back();
+        if (level.size() & 1) {
+            level.push_back(level.back());
+        }
+
+        // A node is unchanged if both its children are, which only needs
+        // comparing them to the previous tree.
+        const bool has_cached{depth + 1 < m_levels.size()};
+        std::vector<uint256> next(level.size() / 2);
+        std::vector<size_t> stale;
+        for (size_t i = 0; i < next.size(); ++i) {
+            if (has_cached && 2 * i + 1 < m_levels[depth].size() &&
+                m_levels[depth][2 * i] == level[2 * i] &&
+                m_levels[depth][2 * i + 1] == level[2 * i + 1]) {
+                next[i] = m_levels[depth + 1][i];
+            } else {
+                stale.push_back(i);
+            }
+        }
+
+        // Hash the stale nodes in one go for the multi-buffer SHA256D64
+        if (!stale.empty()) {
+            std::vector<uint256> pairs(2 * stale.size());
+            for (size_t k = 0; k < stale.size(); ++k) {
+                pairs[2 * k] = level[2 * stale[k]];
+                pairs[2 * k + 1] = level[2 * stale[k] + 1];
+            }
+            SHA256D64(pairs[0].begin(), pairs[0].begin(), stale.size());
+            for (size_t k = 0; k < stale.size(); ++k) {
+                next[stale[k]] = pairs[k];
+            }
+        }
+        levels.push_back(std::move(next));
+    }
+
+    const uint256 root{levels.back().empty() ? uint256() : levels.back()[0]};
+    m_levels = std::move(levels);
+    return root;
+}
+
+uint256 MerkleTreeCache::BlockMerkleRoot(const CBlock &block) {
+    return ComputeRoot(BlockLeaves(block));
 }
@@ -5,17 +5,55 @@
 #ifndef BITCOIN_CONSENSUS_MERKLE_H
 #define BITCOIN_CONSENSUS_MERKLE_H
 
+#include <cstddef>
+#include <functional>
 #include <vector>
 
 #include <primitives/block.h>
 #include <uint256.h>
 
+/**
+ * Call job(i) for each i below count, possibly in parallel, and return once
+ * all the calls are done.
+ */
+using MerkleParallelFor = std::function<void(
+    size_t count, const std::function<void(size_t)> &job)>;
+
 uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated = nullptr);
 
+/**
+ * Same as above, but for large trees the lower levels are hashed as
+ * independent subtrees through parallel_for.
+ */
+uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool *mutated,
+                          const MerkleParallelFor &parallel_for);
+
 /**
  * Compute the Merkle root of the transactions in a block.
  * *mutated is set to true if a duplicated subtree was found.
  */
 uint256 BlockMerkleRoot(const CBlock &block, bool *mutated = nullptr);
+uint256 BlockMerkleRoot(const CBlock &block, bool *mutated,
+                        const MerkleParallelFor &parallel_for);
+
+/**
+ * Computes Merkle roots, keeping the hashed levels of the last tree so that
+ * only the nodes above changed leaves are hashed again for the next one.
+ * Successive block templates share most of their transactions, and the
+ * templates for different payouts only differ by their coinbase, which makes
+ * their roots cost a handful of hashes rather than the whole tree.
+ *
+ * It gives the same roots as ComputeMerkleRoot, but assumes trusted leaves
+ * and does not check for mutations.
+ */
+class MerkleTreeCache {
+public:
+    uint256 ComputeRoot(std::vector<uint256> leaves);
+    uint256 BlockMerkleRoot(const CBlock &block);
+
+private:
+    //! The levels of the last tree, leaves first, padded to an even size.
+    std::vector<std::vector<uint256>> m_levels;
+};
 
 #endif // BITCOIN_CONSENSUS_MERKLE_H
@@ -116,12 +116,83 @@ inline void addnextract2(limb_t &c0, limb_t &c1, const limb_t &a, limb_t &n) {
     c1 = c2;
 }
 
-/** in_out = in_out^(2^sq) * mul */
-inline void square_n_mul(Num3072 &in_out, const int sq, const Num3072 &mul) {
-    for (int j = 0; j < sq; ++j) {
-        in_out.Square();
+/** a += b, returning the carry */
+inline limb_t add(Num3072 &a, const Num3072 &b) {
+    limb_t carry = 0;
+    for (int i = 0; i < Num3072::LIMBS; ++i) {
+        double_limb_t t = (double_limb_t)a.limbs[i] + b.limbs[i] + carry;
+        a.limbs[i] = t;
+        carry = t >> LIMB_SIZE;
+    }
+    return carry;
+}
+
+/** a -= b, returning the borrow */
+inline limb_t sub(Num3072 &a, const Num3072 &b) {
+    limb_t borrow = 0;
+    for (int i = 0; i < Num3072::LIMBS; ++i) {
+        double_limb_t t = (double_limb_t)a.limbs[i] - b.limbs[i] - borrow;
+        a.limbs[i] = t;
+        borrow = (t >> LIMB_SIZE) & 1;
+    }
+    return borrow;
+}
+
+/** a >= b */
+inline bool greater_or_equal(const Num3072 &a, const Num3072 &b) {
+    for (int i = Num3072::LIMBS - 1; i >= 0; --i) {
+        if (a.limbs[i] != b.limbs[i]) {
+            return a.limbs[i] > b.limbs[i];
+        }
+    }
+    return true;
+}
+
+/** a = (a + top * 2^3072) / 2, a being even */
+inline void halve(Num3072 &a, limb_t top) {
+    for (int i = 0; i < Num3072::LIMBS - 1; ++i) {
+        a.limbs[i] = (a.limbs[i] >> 1) | (a.limbs[i + 1] << (LIMB_SIZE - 1));
+    }
+    a.limbs[Num3072::LIMBS - 1] =
+        (a.limbs[Num3072::LIMBS - 1] >> 1) | (top << (LIMB_SIZE - 1));
+}
+
+inline bool is_one(const Num3072 &a) {
+    if (a.limbs[0] != 1) {
+        return false;
+    }
+    for (int i = 1; i < Num3072::LIMBS; ++i) {
+        if (a.limbs[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** The modulus, 2^3072 - MAX_PRIME_DIFF */
+Num3072 modulus() {
+    Num3072 p;
+    p.limbs[0] = std::numeric_limits<limb_t>::max() - MAX_PRIME_DIFF + 1;
+    for (int i = 1; i < Num3072::LIMBS; ++i) {
+        p.limbs[i] = std::numeric_limits<limb_t>::max();
+    }
+    return p;
+}
+
+/** a = a / 2 mod p, for a < p */
+inline void halve_mod(Num3072 &a, const Num3072 &p) {
+    limb_t top = 0;
+    if (a.limbs[0] & 1) {
+        top = add(a, p);
+    }
+    halve(a, top);
+}
+
+/** a = a - b mod p, for a, b < p */
+inline void sub_mod(Num3072 &a, const Num3072 &b, const Num3072 &p) {
+    if (sub(a, b)) {
+        add(a, p);
     }
-    in_out.Multiply(mul);
 }
 
 } // namespace
@@ -148,43 +219,45 @@ void Num3072::FullReduce() {
 }
 
 Num3072 Num3072::GetInverse() const {
-    // For fast exponentiation a sliding window exponentiation with repunit
-    // precomputation is utilized. See "Fast Point Decompression for Standard
-    // Elliptic Curves" (Brumley, Järvinen, 2008).
-
-    // p[i] = a^(2^(2^i)-1)
-    Num3072 p[12];
+    // The binary extended Euclidean algorithm only takes shifts and
+    // subtractions, several times faster than the about LIMB_SIZE * LIMBS
+    // squarings of a Fermat exponentiation. The elements of a MuHash are
+    // public, so it does not need to run in constant time.
+    // Invariants: u = x1 * this and v = x2 * this, modulo p.
+    const Num3072 p = modulus();
+    Num3072 u = *this, v = p, x1, x2;
+    for (int i = 0; i < LIMBS; ++i) {
+        x2.limbs[i] = 0;
+    }
 
-    p[0] = *this;
+    bool zero = true;
+    for (int i = 0; i < LIMBS; ++i) {
+        zero = zero && u.limbs[i] == 0;
+    }
+    if (zero) {
+        // As 0^(p-2), zero has no inverse.
+        return u;
+    }
 
-    for (int i = 0; i < 11; ++i) {
-        p[i + 1] = p[i];
-        for (int j = 0; j < (1 << i); ++j) {
-            p[i + 1].Square();
+    while (!is_one(u) && !is_one(v)) {
+        while (!(u.limbs[0] & 1)) {
+            halve(u, 0);
+            halve_mod(x1, p);
+        }
+        while (!(v.limbs[0] & 1)) {
+            halve(v, 0);
+            halve_mod(x2, p);
+        }
+        if (greater_or_equal(u, v)) {
+            sub(u, v);
+            sub_mod(x1, x2, p);
+        } else {
+            sub(v, u);
+            sub_mod(x2, x1, p);
         }
-        p[i + 1].Multiply(p[i]);
     }
 
-    Num3072 out;
-
-    out = p[11];
-
-    square_n_mul(out, 512, p[9]);
-    square_n_mul(out, 256, p[8]);
-    square_n_mul(out, 128, p[7]);
-    square_n_mul(out, 64, p[6]);
-    square_n_mul(out, 32, p[5]);
-    square_n_mul(out, 8, p[3]);
-    square_n_mul(out, 2, p[1]);
-    square_n_mul(out, 1, p[0]);
-    square_n_mul(out, 5, p[2]);
-    square_n_mul(out, 3, p[0]);
-    square_n_mul(out, 2, p[0]);
-    square_n_mul(out, 4, p[0]);
-    square_n_mul(out, 4, p[1]);
-    square_n_mul(out, 3, p[0]);
-
-    return out;
+    return is_one(u) ? x1 : x2;
 }
 
 void Num3072::Multiply(const Num3072 &a) {
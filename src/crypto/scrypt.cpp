@@ -29,10 +29,27 @@
 
 #include <crypto/hmac_sha256.h>
 #include <crypto/scrypt.h>
+
+#include <compat/cpuid.h>
+
+#include <memory>
+#include <new>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+
+namespace scrypt_sse2 {
+void ROMix_4way(uint32_t *X, uint32_t *V);
+}
+
+namespace scrypt_avx2 {
+void ROMix_8way(uint32_t *X, uint32_t *V);
+}
+
 #if defined(USE_SSE2) && !defined(USE_SSE2_ALWAYS)
 #ifdef _MSC_VER
 // MSVC 64bit is unable to use inline asm
@@ -278,8 +295,190 @@ void scrypt_detect_sse2() {
 }
 #endif
 
+namespace {
+
+/**
+ * The scratchpads are aligned to and sized in multiples of the (transparent)
+ * huge page size, so the kernel can map each of them with a single TLB entry.
+ */
+constexpr size_t SCRATCHPAD_ALIGNMENT = 2 << 20;
+
+inline size_t AlignUp(size_t x, size_t align) {
+    return (x + align - 1) & ~(align - 1);
+}
+
+/**
+ * Per-thread scrypt scratchpad, allocated the first time a thread computes a
+ * scrypt hash and reused by every following hash on that thread. It is large
+ * enough for the multi-lane kernels.
+ */
+class ScryptScratchpadArena {
+public:
+    static constexpr size_t SIZE =
+        (SCRYPT_SCRATCHPAD_SIZE * SCRYPT_MULTI_MAX_LANES +
+         SCRATCHPAD_ALIGNMENT - 1) &
+        ~(SCRATCHPAD_ALIGNMENT - 1);
+
+    ScryptScratchpadArena() {
+#ifndef WIN32
+        // Over-allocate so the mapping can be trimmed to an aligned range.
+        const size_t len = SIZE + SCRATCHPAD_ALIGNMENT;
+        void *addr = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        const uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+        const uintptr_t aligned = AlignUp(start, SCRATCHPAD_ALIGNMENT);
+        if (aligned > start) {
+            munmap(addr, aligned - start);
+        }
+        if (start + len > aligned + SIZE) {
+            munmap(reinterpret_cast<void *>(aligned + SIZE),
+                   start + len - (aligned + SIZE));
+        }
+        m_data = reinterpret_cast<uint8_t *>(aligned);
+#if defined(MADV_HUGEPAGE)
+        madvise(m_data, SIZE, MADV_HUGEPAGE);
+#endif
+#else
+        m_alloc.reset(new uint8_t[SIZE + 63]);
+        m_data = reinterpret_cast<uint8_t *>(
+            AlignUp(reinterpret_cast<uintptr_t>(m_alloc.get()), 64));
+#endif
+    }
+
+    ~ScryptScratchpadArena() {
+#ifndef WIN32
+        munmap(m_data, SIZE);
+#endif
+    }
+
+    ScryptScratchpadArena(const ScryptScratchpadArena &) = delete;
+    ScryptScratchpadArena &operator=(const ScryptScratchpadArena &) = delete;
+
+    uint8_t *Get() const { return m_data; }
+
+private:
+    uint8_t *m_data{nullptr};
+#ifdef WIN32
+    std::unique_ptr<uint8_t[]> m_alloc;
+#endif
+};
+
+} // namespace
+
+uint8_t *scrypt_thread_scratchpad() {
+    thread_local ScryptScratchpadArena arena;
+    return arena.Get();
+}
+
 void scrypt_1024_1_1_256(const uint8_t *input, uint8_t *output) {
-    thread_local uint8_t scratchpad[SCRYPT_SCRATCHPAD_SIZE];
-    memset(scratchpad, 0, sizeof(scratchpad));
-    scrypt_1024_1_1_256_sp(input, output, scratchpad);
+    // The scratchpad doesn't need to be cleared: every entry is written before
+    // it is read.
+    scrypt_1024_1_1_256_sp(input, output, scrypt_thread_scratchpad());
+}
+
+namespace {
+
+using ROMixFn = void (*)(uint32_t *X, uint32_t *V);
+
+struct ScryptMultiImpl {
+    ROMixFn romix{nullptr};
+    size_t lanes{1};
+    const char *name{"generic(1way)"};
+};
+
+#if defined(USE_ASM) &&                                                        \
+    (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled() {
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+
+ScryptMultiImpl DetectScryptMulti() {
+    ScryptMultiImpl impl;
+#if defined(USE_ASM) && defined(HAVE_GETCPUID)
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_sse2 = (edx >> 26) & 1;
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    bool have_avx2 = false;
+    if (have_xsave && have_avx && AVXEnabled()) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+    (void)have_sse2;
+    (void)have_avx2;
+
+#if defined(ENABLE_SSE2)
+    if (have_sse2) {
+        impl = {scrypt_sse2::ROMix_4way, 4, "sse2(4way)"};
+    }
+#endif
+#if defined(ENABLE_AVX2)
+    if (have_avx2) {
+        impl = {scrypt_avx2::ROMix_8way, 8, "avx2(8way)"};
+    }
+#endif
+#endif
+    return impl;
+}
+
+const ScryptMultiImpl &GetScryptMulti() {
+    static const ScryptMultiImpl impl{DetectScryptMulti()};
+    return impl;
+}
+
+} // namespace
+
+const char *ScryptMultiImplementation() {
+    return GetScryptMulti().name;
+}
+
+void scrypt_1024_1_1_256_multi(const uint8_t *inputs, uint8_t *outputs,
+                               size_t n) {
+    const ScryptMultiImpl &impl = GetScryptMulti();
+    const size_t lanes = impl.lanes;
+    if (!impl.romix || n < lanes) {
+        for (size_t i = 0; i < n; i++) {
+            scrypt_1024_1_1_256(&inputs[80 * i], &outputs[32 * i]);
+        }
+        return;
+    }
+
+    // The interleaved scratchpad is lanes times the size of a single one.
+    uint32_t *V = (uint32_t *)scrypt_thread_scratchpad();
+
+    uint8_t B[128];
+    uint32_t X[SCRYPT_MULTI_MAX_LANES * 32];
+    size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+        for (size_t l = 0; l < lanes; l++) {
+            const uint8_t *input = &inputs[80 * (i + l)];
+            PBKDF2_SHA256(input, 80, input, 80, 1, B, 128);
+            for (size_t k = 0; k < 32; k++) {
+                X[l * 32 + k] = le32dec(&B[4 * k]);
+            }
+        }
+
+        impl.romix(X, V);
+
+        for (size_t l = 0; l < lanes; l++) {
+            for (size_t k = 0; k < 32; k++) {
+                le32enc(&B[4 * k], X[l * 32 + k]);
+            }
+            const uint8_t *input = &inputs[80 * (i + l)];
+            PBKDF2_SHA256(input, 80, B, 128, 1, &outputs[32 * (i + l)], 32);
+        }
+    }
+
+    // Hash the remaining inputs that don't fill all the lanes one by one.
+    for (; i < n; i++) {
+        scrypt_1024_1_1_256(&inputs[80 * i], &outputs[32 * i]);
+    }
 }
@@ -11,6 +11,10 @@
 
 static const int SCRYPT_SCRATCHPAD_SIZE = 131072 + 63;
 
+/**
+ * Compute the scrypt hash of an 80-byte input, using the calling thread's
+ * scratchpad (see scrypt_thread_scratchpad).
+ */
 void scrypt_1024_1_1_256(const uint8_t *input, uint8_t *output);
 void scrypt_1024_1_1_256_sp_generic(const uint8_t *input, uint8_t *output,
                                     uint8_t *scratchpad);
@@ -39,6 +43,31 @@ extern void (*scrypt_1024_1_1_256_sp_detected)(const uint8_t *input,
 
 #endif // defined(USE_SSE2)
 
+/** Maximum number of hashes computed at once by scrypt_1024_1_1_256_multi. */
+static const size_t SCRYPT_MULTI_MAX_LANES = 8;
+
+/**
+ * Compute n independent scrypt hashes. inputs points to n consecutive 80-byte
+ * inputs and outputs to room for n consecutive 32-byte hashes.
+ *
+ * On x86 the salsa20/8 cores of 4 (SSE2) or 8 (AVX2) hashes are interleaved
+ * in SIMD registers; other platforms fall back to hashing one at a time.
+ */
+void scrypt_1024_1_1_256_multi(const uint8_t *inputs, uint8_t *outputs,
+                               size_t n);
+
+/**
+ * Scratchpad owned by the calling thread, suitable for
+ * scrypt_1024_1_1_256_sp and large enough for SCRYPT_MULTI_MAX_LANES
+ * interleaved hashes. It is allocated on first use, aligned to the huge page
+ * size and reused for the lifetime of the thread, so PoW worker threads don't
+ * touch fresh memory for every hash.
+ */
+uint8_t *scrypt_thread_scratchpad();
+
+/** Name of the multi-lane implementation selected for this CPU. */
+const char *ScryptMultiImplementation();
+
 void PBKDF2_SHA256(const uint8_t *passwd, size_t passwdlen, const uint8_t *salt,
                    size_t saltlen, uint64_t c, uint8_t *buf, size_t dkLen);
 
@@ -0,0 +1,155 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_SSE2
+
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+namespace scrypt_sse2 {
+namespace {
+
+    __m128i inline Add(__m128i x, __m128i y) {
+        return _mm_add_epi32(x, y);
+    }
+    __m128i inline Xor(__m128i x, __m128i y) {
+        return _mm_xor_si128(x, y);
+    }
+    __m128i inline Rotl(__m128i x, int n) {
+        return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n));
+    }
+
+    /**
+     * Salsa20/8 core applied to 4 independent lanes. Each vector holds the
+     * same 32-bit word of the 4 lanes.
+     */
+    void inline XorSalsa8(__m128i *B, const __m128i *Bx) {
+        __m128i x00 = (B[0] = Xor(B[0], Bx[0]));
+        __m128i x01 = (B[1] = Xor(B[1], Bx[1]));
+        __m128i x02 = (B[2] = Xor(B[2], Bx[2]));
+        __m128i x03 = (B[3] = Xor(B[3], Bx[3]));
+        __m128i x04 = (B[4] = Xor(B[4], Bx[4]));
+        __m128i x05 = (B[5] = Xor(B[5], Bx[5]));
+        __m128i x06 = (B[6] = Xor(B[6], Bx[6]));
+        __m128i x07 = (B[7] = Xor(B[7], Bx[7]));
+        __m128i x08 = (B[8] = Xor(B[8], Bx[8]));
+        __m128i x09 = (B[9] = Xor(B[9], Bx[9]));
+        __m128i x10 = (B[10] = Xor(B[10], Bx[10]));
+        __m128i x11 = (B[11] = Xor(B[11], Bx[11]));
+        __m128i x12 = (B[12] = Xor(B[12], Bx[12]));
+        __m128i x13 = (B[13] = Xor(B[13], Bx[13]));
+        __m128i x14 = (B[14] = Xor(B[14], Bx[14]));
+        __m128i x15 = (B[15] = Xor(B[15], Bx[15]));
+        for (int i = 0; i < 8; i += 2) {
+            /* Operate on columns. */
+            x04 = Xor(x04, Rotl(Add(x00, x12), 7));
+            x09 = Xor(x09, Rotl(Add(x05, x01), 7));
+            x14 = Xor(x14, Rotl(Add(x10, x06), 7));
+            x03 = Xor(x03, Rotl(Add(x15, x11), 7));
+
+            x08 = Xor(x08, Rotl(Add(x04, x00), 9));
+            x13 = Xor(x13, Rotl(Add(x09, x05), 9));
+            x02 = Xor(x02, Rotl(Add(x14, x10), 9));
+            x07 = Xor(x07, Rotl(Add(x03, x15), 9));
+
+            x12 = Xor(x12, Rotl(Add(x08, x04), 13));
+            x01 = Xor(x01, Rotl(Add(x13, x09), 13));
+            x06 = Xor(x06, Rotl(Add(x02, x14), 13));
+            x11 = Xor(x11, Rotl(Add(x07, x03), 13));
+
+            x00 = Xor(x00, Rotl(Add(x12, x08), 18));
+            x05 = Xor(x05, Rotl(Add(x01, x13), 18));
+            x10 = Xor(x10, Rotl(Add(x06, x02), 18));
+            x15 = Xor(x15, Rotl(Add(x11, x07), 18));
+
+            /* Operate on rows. */
+            x01 = Xor(x01, Rotl(Add(x00, x03), 7));
+            x06 = Xor(x06, Rotl(Add(x05, x04), 7));
+            x11 = Xor(x11, Rotl(Add(x10, x09), 7));
+            x12 = Xor(x12, Rotl(Add(x15, x14), 7));
+
+            x02 = Xor(x02, Rotl(Add(x01, x00), 9));
+            x07 = Xor(x07, Rotl(Add(x06, x05), 9));
+            x08 = Xor(x08, Rotl(Add(x11, x10), 9));
+            x13 = Xor(x13, Rotl(Add(x12, x15), 9));
+
+            x03 = Xor(x03, Rotl(Add(x02, x01), 13));
+            x04 = Xor(x04, Rotl(Add(x07, x06), 13));
+            x09 = Xor(x09, Rotl(Add(x08, x11), 13));
+            x14 = Xor(x14, Rotl(Add(x13, x12), 13));
+
+            x00 = Xor(x00, Rotl(Add(x03, x02), 18));
+            x05 = Xor(x05, Rotl(Add(x04, x07), 18));
+            x10 = Xor(x10, Rotl(Add(x09, x08), 18));
+            x15 = Xor(x15, Rotl(Add(x14, x13), 18));
+        }
+        B[0] = Add(B[0], x00);
+        B[1] = Add(B[1], x01);
+        B[2] = Add(B[2], x02);
+        B[3] = Add(B[3], x03);
+        B[4] = Add(B[4], x04);
+        B[5] = Add(B[5], x05);
+        B[6] = Add(B[6], x06);
+        B[7] = Add(B[7], x07);
+        B[8] = Add(B[8], x08);
+        B[9] = Add(B[9], x09);
+        B[10] = Add(B[10], x10);
+        B[11] = Add(B[11], x11);
+        B[12] = Add(B[12], x12);
+        B[13] = Add(B[13], x13);
+        B[14] = Add(B[14], x14);
+        B[15] = Add(B[15], x15);
+    }
+
+} // namespace
+
+/**
+ * ROMix core of scrypt(N=1024, r=1, p=1) on 4 lanes at once.
+ * X holds the 4 lanes' 32-word states one after the other, V must point to a
+ * 16-byte aligned scratchpad of 4 * 128KiB.
+ */
+void ROMix_4way(uint32_t *X, uint32_t *V) {
+    constexpr int LANES = 4;
+    __m128i x[32];
+    for (int k = 0; k < 32; k++) {
+        x[k] = _mm_set_epi32(X[3 * 32 + k], X[2 * 32 + k], X[1 * 32 + k],
+                             X[0 * 32 + k]);
+    }
+
+    __m128i *v = reinterpret_cast<__m128i *>(V);
+    for (int i = 0; i < 1024; i++) {
+        memcpy(&v[i * 32], x, sizeof(x));
+        XorSalsa8(&x[0], &x[16]);
+        XorSalsa8(&x[16], &x[0]);
+    }
+    for (int i = 0; i < 1024; i++) {
+        // Each lane reads from its own position in V.
+        alignas(16) uint32_t j[LANES];
+        _mm_store_si128(reinterpret_cast<__m128i *>(j), x[16]);
+        for (int l = 0; l < LANES; l++) {
+            j[l] = 32 * LANES * (j[l] & 1023) + l;
+        }
+        for (int k = 0; k < 32; k++) {
+            x[k] = Xor(x[k], _mm_set_epi32(V[j[3] + k * LANES],
+                                           V[j[2] + k * LANES],
+                                           V[j[1] + k * LANES],
+                                           V[j[0] + k * LANES]));
+        }
+        XorSalsa8(&x[0], &x[16]);
+        XorSalsa8(&x[16], &x[0]);
+    }
+
+    for (int k = 0; k < 32; k++) {
+        alignas(16) uint32_t lanes[LANES];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), x[k]);
+        for (int l = 0; l < LANES; l++) {
+            X[l * 32 + k] = lanes[l];
+        }
+    }
+}
+
+} // namespace scrypt_sse2
+
+#endif
@@ -20,11 +20,13 @@ void Transform(uint32_t *s, const uint8_t *chunk, size_t blocks);
 
 namespace sha256d64_sse41 {
 void Transform_4way(uint8_t *out, const uint8_t *in);
-}
+void TransformMulti_4way(uint32_t *s, const uint8_t *const *chunks);
+} // namespace sha256d64_sse41
 
 namespace sha256d64_avx2 {
 void Transform_8way(uint8_t *out, const uint8_t *in);
-}
+void TransformMulti_8way(uint32_t *s, const uint8_t *const *chunks);
+} // namespace sha256d64_avx2
 
 namespace sha256d64_shani {
 void Transform_2way(uint8_t *out, const uint8_t *in);
@@ -32,7 +34,8 @@ void Transform_2way(uint8_t *out, const uint8_t *in);
 
 namespace sha256_shani {
 void Transform(uint32_t *s, const uint8_t *chunk, size_t blocks);
-}
+void TransformMulti_2way(uint32_t *s, const uint8_t *const *chunks);
+} // namespace sha256_shani
 
 // Internal implementation code.
 namespace {
@@ -578,6 +581,7 @@ namespace sha256 {
 
 typedef void (*TransformType)(uint32_t *, const uint8_t *, size_t);
 typedef void (*TransformD64Type)(uint8_t *, const uint8_t *);
+typedef void (*TransformMultiType)(uint32_t *, const uint8_t *const *);
 
 template <TransformType tr>
 void TransformD64Wrapper(uint8_t *out, const uint8_t *in) {
@@ -618,6 +622,31 @@ TransformD64Type TransformD64 = sha256::TransformD64;
 TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
+TransformMultiType TransformMulti_2way = nullptr;
+TransformMultiType TransformMulti_4way = nullptr;
+TransformMultiType TransformMulti_8way = nullptr;
+
+/**
+ * Run a multi-way transform on the lanes chained states of the result table,
+ * lane i advancing from the state after i chunks with chunk i.
+ */
+template <size_t lanes>
+bool SelfTestMulti(TransformMultiType tr, const uint8_t *data,
+                   const uint32_t (*result)[8]) {
+    uint32_t states[8 * lanes];
+    const uint8_t *chunks[lanes];
+    for (size_t i = 0; i < lanes; ++i) {
+        std::copy(result[i], result[i] + 8, states + 8 * i);
+        chunks[i] = data + 64 * i;
+    }
+    tr(states, chunks);
+    for (size_t i = 0; i < lanes; ++i) {
+        if (!std::equal(states + 8 * i, states + 8 * (i + 1), result[i + 1])) {
+            return false;
+        }
+    }
+    return true;
+}
 
 bool SelfTest() {
     // Input state (equal to the initial SHA256 state)
@@ -729,6 +758,20 @@ bool SelfTest() {
         }
     }
 
+    // Test the multi-way transforms, if available.
+    if (TransformMulti_2way &&
+        !SelfTestMulti<2>(TransformMulti_2way, data + 1, result)) {
+        return false;
+    }
+    if (TransformMulti_4way &&
+        !SelfTestMulti<4>(TransformMulti_4way, data + 1, result)) {
+        return false;
+    }
+    if (TransformMulti_8way &&
+        !SelfTestMulti<8>(TransformMulti_8way, data + 1, result)) {
+        return false;
+    }
+
     return true;
 }
 
@@ -741,6 +784,114 @@ bool AVXEnabled() {
     return (a & 6) == 6;
 }
 #endif
+
+/**
+ * Compute the double-SHA256's of messages of any length with a multi-way
+ * transform. Each lane hashes one message at a time and picks the next one as
+ * soon as it is done, so the lanes are kept busy whatever the lengths.
+ */
+template <size_t lanes>
+void SHA256DMultiWay(TransformMultiType tr, uint8_t *out,
+                     const uint8_t *const *in, const size_t *lengths,
+                     size_t count) {
+    struct Lane {
+        // The message being hashed, count if the lane is idle
+        size_t msg;
+        // Whether this is the second hash, of the 32 bytes digest
+        bool second;
+        const uint8_t *data;
+        // The chunks read from the data, the last ones are read from the tail
+        size_t full_chunks;
+        size_t chunks;
+        size_t pos;
+        // The remaining bytes of the message followed by the padding
+        uint8_t tail[128];
+    };
+
+    static const uint8_t idle_chunk[64] = {};
+    uint32_t states[8 * lanes] = {};
+    const uint8_t *chunks[lanes];
+    Lane lane[lanes];
+    size_t next = 0;
+
+    auto start = [&](size_t i) {
+        Lane &l = lane[i];
+        l.msg = next;
+        if (next == count) {
+            return;
+        }
+        ++next;
+        const size_t len = lengths[l.msg];
+        const size_t remaining = len % 64;
+        const size_t tail_size = remaining < 56 ? 64 : 128;
+        l.second = false;
+        l.data = in[l.msg];
+        l.full_chunks = len / 64;
+        l.chunks = l.full_chunks + tail_size / 64;
+        l.pos = 0;
+        if (remaining) {
+            memcpy(l.tail, l.data + 64 * l.full_chunks, remaining);
+        }
+        l.tail[remaining] = 0x80;
+        memset(l.tail + remaining + 1, 0, tail_size - remaining - 9);
+        WriteBE64(l.tail + tail_size - 8, uint64_t(len) << 3);
+        sha256::Initialize(states + 8 * i);
+    };
+
+    for (size_t i = 0; i < lanes; ++i) {
+        start(i);
+    }
+
+    while (true) {
+        bool active = false;
+        for (size_t i = 0; i < lanes; ++i) {
+            const Lane &l = lane[i];
+            if (l.msg == count) {
+                chunks[i] = idle_chunk;
+                continue;
+            }
+            active = true;
+            chunks[i] = l.pos < l.full_chunks
+                            ? l.data + 64 * l.pos
+                            : l.tail + 64 * (l.pos - l.full_chunks);
+        }
+        if (!active) {
+            break;
+        }
+
+        tr(states, chunks);
+
+        for (size_t i = 0; i < lanes; ++i) {
+            Lane &l = lane[i];
+            if (l.msg == count || ++l.pos < l.chunks) {
+                continue;
+            }
+
+            uint32_t *s = states + 8 * i;
+            if (l.second) {
+                for (int j = 0; j < 8; ++j) {
+                    WriteBE32(out + 32 * l.msg + 4 * j, s[j]);
+                }
+                start(i);
+                continue;
+            }
+
+            // Hash the digest again, it fits a single padded chunk.
+            for (int j = 0; j < 8; ++j) {
+                WriteBE32(l.tail + 4 * j, s[j]);
+            }
+            l.tail[32] = 0x80;
+            memset(l.tail + 33, 0, 31);
+            WriteBE64(l.tail + 56, 32 << 3);
+            l.second = true;
+            l.data = nullptr;
+            l.full_chunks = 0;
+            l.chunks = 1;
+            l.pos = 0;
+            sha256::Initialize(s);
+        }
+    }
+}
 } // namespace
 
 std::string SHA256AutoDetect() {
@@ -780,6 +931,7 @@ std::string SHA256AutoDetect() {
         Transform = sha256_shani::Transform;
         TransformD64 = TransformD64Wrapper<sha256_shani::Transform>;
         TransformD64_2way = sha256d64_shani::Transform_2way;
+        TransformMulti_2way = sha256_shani::TransformMulti_2way;
         ret = "shani(1way,2way)";
         have_sse4 = false; // Disable SSE4/AVX2;
         have_avx2 = false;
@@ -794,6 +946,7 @@ std::string SHA256AutoDetect() {
 #endif
 #if defined(ENABLE_SSE41) && !defined(BUILD_BITCOIN_INTERNAL)
         TransformD64_4way = sha256d64_sse41::Transform_4way;
+        TransformMulti_4way = sha256d64_sse41::TransformMulti_4way;
         ret += ",sse41(4way)";
 #endif
     }
@@ -801,6 +954,7 @@ std::string SHA256AutoDetect() {
 #if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
+        TransformMulti_8way = sha256d64_avx2::TransformMulti_8way;
         ret += ",avx2(8way)";
     }
 #endif
@@ -895,3 +1049,31 @@ void SHA256D64(uint8_t *out, const uint8_t *in, size_t blocks) {
         --blocks;
     }
 }
+
+void SHA256DMulti(uint8_t *output, const uint8_t *const *inputs,
+                  const size_t *lengths, size_t count) {
+    // Hashing a single message is faster without the unused lanes.
+    if (count > 1) {
+        if (TransformMulti_8way) {
+            SHA256DMultiWay<8>(TransformMulti_8way, output, inputs, lengths,
+                               count);
+            return;
+        }
+        if (TransformMulti_4way) {
+            SHA256DMultiWay<4>(TransformMulti_4way, output, inputs, lengths,
+                               count);
+            return;
+        }
+        if (TransformMulti_2way) {
+            SHA256DMultiWay<2>(TransformMulti_2way, output, inputs, lengths,
+                               count);
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t hash[CSHA256::OUTPUT_SIZE];
+        CSHA256().Write(inputs[i], lengths[i]).Finalize(hash);
+        CSHA256().Write(hash, sizeof(hash)).Finalize(output + 32 * i);
+    }
+}
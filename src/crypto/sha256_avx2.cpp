@@ -118,6 +118,55 @@ namespace {
         WriteLE32(out + 192 + offset, _mm256_extract_epi32(v, 1));
         WriteLE32(out + 224 + offset, _mm256_extract_epi32(v, 0));
     }
+
+    /** Round constants of SHA-256. */
+    const uint32_t ROUND_CONSTANTS[64] = {
+        0x428a2f98ul, 0x71374491ul, 0xb5c0fbcful, 0xe9b5dba5ul, 0x3956c25bul,
+        0x59f111f1ul, 0x923f82a4ul, 0xab1c5ed5ul, 0xd807aa98ul, 0x12835b01ul,
+        0x243185beul, 0x550c7dc3ul, 0x72be5d74ul, 0x80deb1feul, 0x9bdc06a7ul,
+        0xc19bf174ul, 0xe49b69c1ul, 0xefbe4786ul, 0x0fc19dc6ul, 0x240ca1ccul,
+        0x2de92c6ful, 0x4a7484aaul, 0x5cb0a9dcul, 0x76f988daul, 0x983e5152ul,
+        0xa831c66dul, 0xb00327c8ul, 0xbf597fc7ul, 0xc6e00bf3ul, 0xd5a79147ul,
+        0x06ca6351ul, 0x14292967ul, 0x27b70a85ul, 0x2e1b2138ul, 0x4d2c6dfcul,
+        0x53380d13ul, 0x650a7354ul, 0x766a0abbul, 0x81c2c92eul, 0x92722c85ul,
+        0xa2bfe8a1ul, 0xa81a664bul, 0xc24b8b70ul, 0xc76c51a3ul, 0xd192e819ul,
+        0xd6990624ul, 0xf40e3585ul, 0x106aa070ul, 0x19a4c116ul, 0x1e376c08ul,
+        0x2748774cul, 0x34b0bcb5ul, 0x391c0cb3ul, 0x4ed8aa4aul, 0x5b9cca4ful,
+        0x682e6ff3ul, 0x748f82eeul, 0x78a5636ful, 0x84c87814ul, 0x8cc70208ul,
+        0x90befffaul, 0xa4506cebul, 0xbef9a3f7ul, 0xc67178f2ul};
+
+    /** Read the big endian word at offset in each of the 8 chunks. */
+    __m256i inline ReadLanes8(const uint8_t *const *chunks, int offset) {
+        return _mm256_set_epi32(
+            ReadBE32(chunks[0] + offset), ReadBE32(chunks[1] + offset),
+            ReadBE32(chunks[2] + offset), ReadBE32(chunks[3] + offset),
+            ReadBE32(chunks[4] + offset), ReadBE32(chunks[5] + offset),
+            ReadBE32(chunks[6] + offset), ReadBE32(chunks[7] + offset));
+    }
+
+    /** Write word j of each lane to its state. */
+    inline void WriteLanes8(uint32_t *s, int j, __m256i v) {
+        s[j] = _mm256_extract_epi32(v, 7);
+        s[8 + j] = _mm256_extract_epi32(v, 6);
+        s[16 + j] = _mm256_extract_epi32(v, 5);
+        s[24 + j] = _mm256_extract_epi32(v, 4);
+        s[32 + j] = _mm256_extract_epi32(v, 3);
+        s[40 + j] = _mm256_extract_epi32(v, 2);
+        s[48 + j] = _mm256_extract_epi32(v, 1);
+        s[56 + j] = _mm256_extract_epi32(v, 0);
+    }
+
+    /**
+     * Compute the word i of the message schedule, the last 16 words are kept
+     * in a ring.
+     */
+    __m256i inline Schedule(__m256i *w, int i) {
+        if (i >= 16) {
+            Inc(w[i & 15], sigma1(w[(i - 2) & 15]), w[(i - 7) & 15],
+                sigma0(w[(i - 15) & 15]));
+        }
+        return w[i & 15];
+    }
 } // namespace
 
 void Transform_8way(uint8_t *out, const uint8_t *in) {
@@ -466,6 +515,59 @@ void Transform_8way(uint8_t *out, const uint8_t *in) {
     Write8(out, 24, Add(g, K(0x1f83d9abul)));
     Write8(out, 28, Add(h, K(0x5be0cd19ul)));
 }
+
+/**
+ * Run the compression function on 8 independent states, each with its own
+ * 64 bytes chunk. s holds the 8 states of 8 words one after the other.
+ */
+void TransformMulti_8way(uint32_t *s, const uint8_t *const *chunks) {
+    __m256i state[8];
+    for (int j = 0; j < 8; ++j) {
+        state[j] = _mm256_set_epi32(s[j], s[8 + j], s[16 + j], s[24 + j],
+                                    s[32 + j], s[40 + j], s[48 + j], s[56 + j]);
+    }
+    __m256i a = state[0];
+    __m256i b = state[1];
+    __m256i c = state[2];
+    __m256i d = state[3];
+    __m256i e = state[4];
+    __m256i f = state[5];
+    __m256i g = state[6];
+    __m256i h = state[7];
+
+    __m256i w[16];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = ReadLanes8(chunks, 4 * i);
+    }
+
+    for (int i = 0; i < 64; i += 8) {
+        Round(a, b, c, d, e, f, g, h,
+              Add(K(ROUND_CONSTANTS[i]), Schedule(w, i)));
+        Round(h, a, b, c, d, e, f, g,
+              Add(K(ROUND_CONSTANTS[i + 1]), Schedule(w, i + 1)));
+        Round(g, h, a, b, c, d, e, f,
+              Add(K(ROUND_CONSTANTS[i + 2]), Schedule(w, i + 2)));
+        Round(f, g, h, a, b, c, d, e,
+              Add(K(ROUND_CONSTANTS[i + 3]), Schedule(w, i + 3)));
+        Round(e, f, g, h, a, b, c, d,
+              Add(K(ROUND_CONSTANTS[i + 4]), Schedule(w, i + 4)));
+        Round(d, e, f, g, h, a, b, c,
+              Add(K(ROUND_CONSTANTS[i + 5]), Schedule(w, i + 5)));
+        Round(c, d, e, f, g, h, a, b,
+              Add(K(ROUND_CONSTANTS[i + 6]), Schedule(w, i + 6)));
+        Round(b, c, d, e, f, g, h, a,
+              Add(K(ROUND_CONSTANTS[i + 7]), Schedule(w, i + 7)));
+    }
+
+    WriteLanes8(s, 0, Add(a, state[0]));
+    WriteLanes8(s, 1, Add(b, state[1]));
+    WriteLanes8(s, 2, Add(c, state[2]));
+    WriteLanes8(s, 3, Add(d, state[3]));
+    WriteLanes8(s, 4, Add(e, state[4]));
+    WriteLanes8(s, 5, Add(f, state[5]));
+    WriteLanes8(s, 6, Add(g, state[6]));
+    WriteLanes8(s, 7, Add(h, state[7]));
+}
 } // namespace sha256d64_avx2
 
 #endif
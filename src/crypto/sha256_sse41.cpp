@@ -108,6 +108,49 @@ namespace {
         WriteLE32(out + 64 + offset, _mm_extract_epi32(v, 1));
         WriteLE32(out + 96 + offset, _mm_extract_epi32(v, 0));
     }
+
+    /** Round constants of SHA-256. */
+    const uint32_t ROUND_CONSTANTS[64] = {
+        0x428a2f98ul, 0x71374491ul, 0xb5c0fbcful, 0xe9b5dba5ul, 0x3956c25bul,
+        0x59f111f1ul, 0x923f82a4ul, 0xab1c5ed5ul, 0xd807aa98ul, 0x12835b01ul,
+        0x243185beul, 0x550c7dc3ul, 0x72be5d74ul, 0x80deb1feul, 0x9bdc06a7ul,
+        0xc19bf174ul, 0xe49b69c1ul, 0xefbe4786ul, 0x0fc19dc6ul, 0x240ca1ccul,
+        0x2de92c6ful, 0x4a7484aaul, 0x5cb0a9dcul, 0x76f988daul, 0x983e5152ul,
+        0xa831c66dul, 0xb00327c8ul, 0xbf597fc7ul, 0xc6e00bf3ul, 0xd5a79147ul,
+        0x06ca6351ul, 0x14292967ul, 0x27b70a85ul, 0x2e1b2138ul, 0x4d2c6dfcul,
+        0x53380d13ul, 0x650a7354ul, 0x766a0abbul, 0x81c2c92eul, 0x92722c85ul,
+        0xa2bfe8a1ul, 0xa81a664bul, 0xc24b8b70ul, 0xc76c51a3ul, 0xd192e819ul,
+        0xd6990624ul, 0xf40e3585ul, 0x106aa070ul, 0x19a4c116ul, 0x1e376c08ul,
+        0x2748774cul, 0x34b0bcb5ul, 0x391c0cb3ul, 0x4ed8aa4aul, 0x5b9cca4ful,
+        0x682e6ff3ul, 0x748f82eeul, 0x78a5636ful, 0x84c87814ul, 0x8cc70208ul,
+        0x90befffaul, 0xa4506cebul, 0xbef9a3f7ul, 0xc67178f2ul};
+
+    /** Read the big endian word at offset in each of the 4 chunks. */
+    __m128i inline ReadLanes4(const uint8_t *const *chunks, int offset) {
+        return _mm_set_epi32(
+            ReadBE32(chunks[0] + offset), ReadBE32(chunks[1] + offset),
+            ReadBE32(chunks[2] + offset), ReadBE32(chunks[3] + offset));
+    }
+
+    /** Write word j of each lane to its state. */
+    inline void WriteLanes4(uint32_t *s, int j, __m128i v) {
+        s[j] = _mm_extract_epi32(v, 3);
+        s[8 + j] = _mm_extract_epi32(v, 2);
+        s[16 + j] = _mm_extract_epi32(v, 1);
+        s[24 + j] = _mm_extract_epi32(v, 0);
+    }
+
+    /**
+     * Compute the word i of the message schedule, the last 16 words are kept
+     * in a ring.
+     */
+    __m128i inline Schedule(__m128i *w, int i) {
+        if (i >= 16) {
+            Inc(w[i & 15], sigma1(w[(i - 2) & 15]), w[(i - 7) & 15],
+                sigma0(w[(i - 15) & 15]));
+        }
+        return w[i & 15];
+    }
 } // namespace
 
 void Transform_4way(uint8_t *out, const uint8_t *in) {
@@ -456,6 +499,58 @@ void Transform_4way(uint8_t *out, const uint8_t *in) {
     Write4(out, 24, Add(g, K(0x1f83d9abul)));
     Write4(out, 28, Add(h, K(0x5be0cd19ul)));
 }
+
+/**
+ * Run the compression function on 4 independent states, each with its own
+ * 64 bytes chunk. s holds the 4 states of 8 words one after the other.
+ */
+void TransformMulti_4way(uint32_t *s, const uint8_t *const *chunks) {
+    __m128i state[8];
+    for (int j = 0; j < 8; ++j) {
+        state[j] = _mm_set_epi32(s[j], s[8 + j], s[16 + j], s[24 + j]);
+    }
+    __m128i a = state[0];
+    __m128i b = state[1];
+    __m128i c = state[2];
+    __m128i d = state[3];
+    __m128i e = state[4];
+    __m128i f = state[5];
+    __m128i g = state[6];
+    __m128i h = state[7];
+
+    __m128i w[16];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = ReadLanes4(chunks, 4 * i);
+    }
+
+    for (int i = 0; i < 64; i += 8) {
+        Round(a, b, c, d, e, f, g, h,
+              Add(K(ROUND_CONSTANTS[i]), Schedule(w, i)));
+        Round(h, a, b, c, d, e, f, g,
+              Add(K(ROUND_CONSTANTS[i + 1]), Schedule(w, i + 1)));
+        Round(g, h, a, b, c, d, e, f,
+              Add(K(ROUND_CONSTANTS[i + 2]), Schedule(w, i + 2)));
+        Round(f, g, h, a, b, c, d, e,
+              Add(K(ROUND_CONSTANTS[i + 3]), Schedule(w, i + 3)));
+        Round(e, f, g, h, a, b, c, d,
+              Add(K(ROUND_CONSTANTS[i + 4]), Schedule(w, i + 4)));
+        Round(d, e, f, g, h, a, b, c,
+              Add(K(ROUND_CONSTANTS[i + 5]), Schedule(w, i + 5)));
+        Round(c, d, e, f, g, h, a, b,
+              Add(K(ROUND_CONSTANTS[i + 6]), Schedule(w, i + 6)));
+        Round(b, c, d, e, f, g, h, a,
+              Add(K(ROUND_CONSTANTS[i + 7]), Schedule(w, i + 7)));
+    }
+
+    WriteLanes4(s, 0, Add(a, state[0]));
+    WriteLanes4(s, 1, Add(b, state[1]));
+    WriteLanes4(s, 2, Add(c, state[2]));
+    WriteLanes4(s, 3, Add(d, state[3]));
+    WriteLanes4(s, 4, Add(e, state[4]));
+    WriteLanes4(s, 5, Add(f, state[5]));
+    WriteLanes4(s, 6, Add(g, state[6]));
+    WriteLanes4(s, 7, Add(h, state[7]));
+}
 } // namespace sha256d64_sse41
 
 #endif
@@ -100,12 +100,40 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize) {
+static leveldb::Options GetOptions(size_t nCacheSize,
+                                   const DBOptions &db_options) {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    // up to two write buffers may be held in memory simultaneously
-    options.write_buffer_size = nCacheSize / 4;
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    // The cache is shared by the blocks read and the up to two write buffers
+    // held in memory simultaneously.
+    size_t block_cache_size{nCacheSize / 2};
+    size_t write_buffer_size{nCacheSize / 4};
+    int bloom_bits{10};
+    switch (db_options.profile) {
+        case DBProfile::DEFAULT:
+            break;
+        case DBProfile::IBD:
+            block_cache_size = nCacheSize / 4;
+            write_buffer_size = nCacheSize * 3 / 8;
+            options.max_file_size = 32 << 20;
+            options.block_size = 16 << 10;
+            break;
+        case DBProfile::STEADY_STATE:
+            block_cache_size = nCacheSize * 3 / 4;
+            write_buffer_size = nCacheSize / 8;
+            bloom_bits = 16;
+            break;
+    }
+    options.block_cache = leveldb::NewLRUCache(block_cache_size);
+    options.write_buffer_size =
+        db_options.write_buffer_size.value_or(write_buffer_size);
+    options.max_file_size =
+        db_options.max_file_size.value_or(options.max_file_size);
+    options.block_size = db_options.block_size.value_or(options.block_size);
+    bloom_bits = db_options.bloom_bits.value_or(bloom_bits);
+    // The filters are per table, so changing this only affects the tables
+    // written from now on.
+    options.filter_policy =
+        bloom_bits > 0 ? leveldb::NewBloomFilterPolicy(bloom_bits) : nullptr;
     options.compression = leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 ||
@@ -115,6 +143,11 @@ static leveldb::Options GetOptions(size_t nCacheSize) {
         options.paranoid_checks = true;
     }
     SetMaxOpenFiles(&options);
+    LogPrint(BCLog::LEVELDB,
+             "LevelDB using write_buffer_size=%d max_file_size=%d "
+             "block_size=%d bloom_bits=%d\n",
+             options.write_buffer_size, options.max_file_size,
+             options.block_size, bloom_bits);
     return options;
 }
 
@@ -126,7 +159,7 @@ CDBWrapper::CDBWrapper(const DBParams &params)
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(params.cache_bytes);
+    options = GetOptions(params.cache_bytes, params.options);
     options.create_if_missing = true;
     if (params.memory_only) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -193,6 +226,23 @@ CDBWrapper::~CDBWrapper() {
     options.env = nullptr;
 }
 
+void CDBBatch::Append(const CDBBatch &other) {
+    // The values are obfuscated with the key of the parent.
+    assert(&other.parent == &parent);
+    struct Appender : public leveldb::WriteBatch::Handler {
+        leveldb::WriteBatch &batch;
+        explicit Appender(leveldb::WriteBatch &batch_in) : batch{batch_in} {}
+        void Put(const leveldb::Slice &key,
+                 const leveldb::Slice &value) override {
+            batch.Put(key, value);
+        }
+        void Delete(const leveldb::Slice &key) override { batch.Delete(key); }
+    };
+    Appender appender{batch};
+    dbwrapper_private::HandleError(other.batch.Iterate(&appender));
+    size_estimate += other.size_estimate;
+}
+
 bool CDBWrapper::WriteBatch(CDBBatch &batch, bool fSync) {
     const bool log_memory =
         LogAcceptCategory(BCLog::LEVELDB, BCLog::Level::Debug);
@@ -22,10 +22,34 @@
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 
+//! Built-in sets of LevelDB settings, tuned for how a database is used.
+enum class DBProfile {
+    //! The settings derived from the cache size alone.
+    DEFAULT,
+    //! For bulk writes, as the chainstate gets during the initial block
+    //! download: large write buffers and table files, so fewer and larger
+    //! compactions are done.
+    IBD,
+    //! For random reads, as the chainstate gets at the tip: most of the cache
+    //! for the blocks read, and more bloom filter bits so fewer reads miss.
+    STEADY_STATE,
+};
+
 //! User-controlled performance and debug options.
 struct DBOptions {
     //! Compact database on startup.
     bool force_compact = false;
+    //! The profile the settings below default to.
+    DBProfile profile{DBProfile::DEFAULT};
+    //! If set, the size of the in-memory write buffer, of which up to two are
+    //! held at once.
+    std::optional<size_t> write_buffer_size;
+    //! If set, the size of the table files written.
+    std::optional<size_t> max_file_size;
+    //! If set, the bits per key of the bloom filters, 0 for none.
+    std::optional<int> bloom_bits;
+    //! If set, the size of the blocks the tables are read and cached by.
+    std::optional<size_t> block_size;
 };
 
 //! Application-specific storage settings.
@@ -139,6 +163,13 @@ public:
         ssKey.clear();
     }
 
+    /**
+     * Queue the changes of another batch of the same database after the ones
+     * of this batch. This lets batches be filled in parallel, then written in
+     * order.
+     */
+    void Append(const CDBBatch &other);
+
     size_t SizeEstimate() const { return size_estimate; }
 };
 
@@ -252,13 +283,19 @@ public:
     CDBWrapper &operator=(const CDBWrapper &) = delete;
 
     template <typename K, typename V> bool Read(const K &key, V &value) const {
+        return Read(readoptions, key, value);
+    }
+
+    template <typename K, typename V>
+    bool Read(const leveldb::ReadOptions &read_options, const K &key,
+              V &value) const {
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
         ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
         ssKey << key;
         leveldb::Slice slKey((const char *)ssKey.data(), ssKey.size());
 
         std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::Status status = pdb->Get(read_options, slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound()) return false;
             LogPrintf("LevelDB read failure: %s\n", status.ToString());
@@ -357,6 +394,40 @@ public:
         leveldb::Slice slKey2((const char *)ssKey2.data(), ssKey2.size());
         pdb->CompactRange(&slKey1, &slKey2);
     }
+
+    friend class CDBSnapshot;
+};
+
+/**
+ * Read-only view of a database as of when the snapshot was taken, unaffected
+ * by later writes. It must not outlive the database.
+ */
+class CDBSnapshot {
+private:
+    const CDBWrapper &parent;
+    leveldb::ReadOptions readoptions;
+    leveldb::ReadOptions iteroptions;
+
+public:
+    explicit CDBSnapshot(const CDBWrapper &_parent)
+        : parent(_parent), readoptions(_parent.readoptions),
+          iteroptions(_parent.iteroptions) {
+        readoptions.snapshot = parent.pdb->GetSnapshot();
+        iteroptions.snapshot = readoptions.snapshot;
+    }
+    ~CDBSnapshot() { parent.pdb->ReleaseSnapshot(readoptions.snapshot); }
+
+    CDBSnapshot(const CDBSnapshot &) = delete;
+    CDBSnapshot &operator=(const CDBSnapshot &) = delete;
+
+    template <typename K, typename V> bool Read(const K &key, V &value) const {
+        return parent.Read(readoptions, key, value);
+    }
+
+    //! The iterator must be deleted before the snapshot.
+    CDBIterator *NewIterator() const {
+        return new CDBIterator(parent, parent.pdb->NewIterator(iteroptions));
+    }
 };
 
 #endif // BITCOIN_DBWRAPPER_H
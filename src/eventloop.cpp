@@ -12,7 +12,8 @@ EventLoop::~EventLoop() {
 
 bool EventLoop::startEventLoop(CScheduler &scheduler,
                                std::function<void()> runEventLoop,
-                               std::chrono::milliseconds delta) {
+                               std::chrono::milliseconds delta,
+                               CScheduler::Priority priority) {
     LOCK(cs_running);
     if (running) {
         // Do not start the event loop twice.
@@ -37,7 +38,7 @@ bool EventLoop::startEventLoop(CScheduler &scheduler,
             // A stop request was made.
             return false;
         },
-        delta);
+        delta, priority);
 
     return true;
 }
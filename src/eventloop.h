@@ -5,6 +5,7 @@
 #ifndef BITCOIN_EVENTLOOP_H
 #define BITCOIN_EVENTLOOP_H
 
+#include <scheduler.h>
 #include <sync.h>
 #include <threadsafety.h>
 
@@ -13,8 +14,6 @@
 #include <condition_variable>
 #include <functional>
 
-class CScheduler;
-
 struct EventLoop {
 public:
     EventLoop() {}
@@ -22,7 +21,9 @@ public:
 
     bool startEventLoop(CScheduler &scheduler,
                         std::function<void()> runEventLoop,
-                        std::chrono::milliseconds delta)
+                        std::chrono::milliseconds delta,
+                        CScheduler::Priority priority =
+                            CScheduler::Priority::NORMAL)
         EXCLUSIVE_LOCKS_REQUIRED(!cs_running);
     bool stopEventLoop() EXCLUSIVE_LOCKS_REQUIRED(!cs_running);
 
@@ -3,11 +3,28 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <flatfile.h>
 #include <logging.h>
+#include <streams.h>
 #include <tinyformat.h>
 #include <util/fs_helpers.h>
+#include <util/thread.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ios>
 #include <stdexcept>
 
 FlatFileSeq::FlatFileSeq(fs::path dir, const char *prefix, size_t chunk_size)
@@ -96,3 +113,318 @@ bool FlatFileSeq::Flush(const FlatFilePos &pos, bool finalize) {
     fclose(file);
     return true;
 }
+
+class FlatFileMapper::Mapping {
+public:
+    const std::byte *const m_data;
+    const size_t m_size;
+
+    Mapping(const std::byte *data, size_t size) : m_data(data), m_size(size) {}
+    Mapping(const Mapping &) = delete;
+    Mapping &operator=(const Mapping &) = delete;
+
+    ~Mapping() {
+#ifndef WIN32
+        munmap(const_cast<std::byte *>(m_data), m_size);
+#endif
+    }
+
+    /** Map the file at path, or return nullptr. */
+    static std::shared_ptr<const Mapping> Map(const fs::path &path) {
+#ifndef WIN32
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            return nullptr;
+        }
+        struct stat st;
+        void *addr = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        // The mapping keeps the file open.
+        close(fd);
+        if (addr == MAP_FAILED) {
+            return nullptr;
+        }
+        return std::make_shared<const Mapping>(
+            static_cast<const std::byte *>(addr), size_t(st.st_size));
+#else
+        return nullptr;
+#endif
+    }
+};
+
+std::optional<FlatFileMapper::View>
+FlatFileMapper::Read(const FlatFileSeq &seq, const FlatFilePos &pos,
+                     size_t size) {
+    if (pos.IsNull()) {
+        return std::nullopt;
+    }
+    const size_t end = size_t(pos.nPos) + size;
+
+    LOCK(m_mutex);
+    auto it = m_files.find(pos.nFile);
+    if (it == m_files.end() || it->second.mapping->m_size < end) {
+        // Not mapped yet, or the file grew since.
+        auto mapping = Mapping::Map(seq.FileName(pos));
+        if (!mapping) {
+            LogPrint(BCLog::BLOCKSTORE, "Unable to map file %s\n",
+                     fs::PathToString(seq.FileName(pos)));
+            return std::nullopt;
+        }
+        if (it == m_files.end()) {
+            if (m_files.size() >= m_max_mapped_files) {
+                m_files.erase(std::min_element(
+                    m_files.begin(), m_files.end(),
+                    [](const auto &a, const auto &b) {
+                        return a.second.last_read < b.second.last_read;
+                    }));
+            }
+            it = m_files.emplace(pos.nFile, Entry{nullptr, 0}).first;
+        }
+        it->second.mapping = std::move(mapping);
+    }
+    it->second.last_read = ++m_reads;
+
+    const Mapping &mapping = *it->second.mapping;
+    if (mapping.m_size < end) {
+        return std::nullopt;
+    }
+    return View{it->second.mapping,
+                Span<const std::byte>{mapping.m_data + pos.nPos, size}};
+}
+
+void FlatFileMapper::Unmap(int file) {
+    LOCK(m_mutex);
+    m_files.erase(file);
+}
+
+class FlatFileReadCache::Handle {
+public:
+    const int m_fd;
+
+    explicit Handle(int fd) : m_fd(fd) {}
+    Handle(const Handle &) = delete;
+    Handle &operator=(const Handle &) = delete;
+
+    ~Handle() {
+#ifndef WIN32
+        close(m_fd);
+#endif
+    }
+
+    /**
+     * Read up to dst.size() bytes at the given offset, returning how many
+     * were read, which is less only at the end of the file or on error.
+     */
+    size_t Read(uint64_t offset, Span<std::byte> dst) const {
+        size_t done = 0;
+#ifndef WIN32
+        while (done < dst.size()) {
+            const ssize_t ret = pread(m_fd, dst.data() + done,
+                                      dst.size() - done, off_t(offset + done));
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                break;
+            }
+            done += size_t(ret);
+        }
+#endif
+        return done;
+    }
+};
+
+std::shared_ptr<const FlatFileReadCache::Handle>
+FlatFileReadCache::Open(const FlatFileSeq &seq, int file) {
+#ifndef WIN32
+    if (m_max_open_files == 0) {
+        return nullptr;
+    }
+
+    LOCK(m_mutex);
+    auto it = m_files.find(file);
+    if (it == m_files.end()) {
+        const fs::path path{seq.FileName(FlatFilePos(file, 0))};
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            LogPrint(BCLog::BLOCKSTORE, "Unable to open file %s for reading\n",
+                     fs::PathToString(path));
+            return nullptr;
+        }
+        if (m_files.size() >= m_max_open_files) {
+            m_files.erase(std::min_element(
+                m_files.begin(), m_files.end(),
+                [](const auto &a, const auto &b) {
+                    return a.second.last_open < b.second.last_open;
+                }));
+        }
+        it = m_files
+                 .emplace(file, Entry{std::make_shared<const Handle>(fd), 0})
+                 .first;
+    }
+    it->second.last_open = ++m_opens;
+    return it->second.handle;
+#else
+    return nullptr;
+#endif
+}
+
+void FlatFileReadCache::Close(int file) {
+    LOCK(m_mutex);
+    m_files.erase(file);
+}
+
+FlatFileReader::FlatFileReader(
+    std::shared_ptr<const FlatFileReadCache::Handle> handle, uint64_t pos,
+    int type, int version, size_t buffer_size)
+    : m_handle(std::move(handle)), m_type(type), m_version(version),
+      m_file_pos(pos), m_buf(buffer_size) {}
+
+void FlatFileReader::read(Span<std::byte> dst) {
+    const size_t buffered = std::min(dst.size(), m_buf_end - m_buf_pos);
+    if (buffered > 0) {
+        std::memcpy(dst.data(), m_buf.data() + m_buf_pos, buffered);
+        m_buf_pos += buffered;
+        dst = dst.subspan(buffered);
+    }
+    if (dst.empty()) {
+        return;
+    }
+
+    // The buffer is exhausted.
+    if (dst.size() >= m_buf.size()) {
+        if (m_handle->Read(m_file_pos, dst) != dst.size()) {
+            throw std::ios_base::failure(
+                "FlatFileReader::read: end of file");
+        }
+        m_file_pos += dst.size();
+        return;
+    }
+    m_buf_pos = 0;
+    m_buf_end = m_handle->Read(m_file_pos, m_buf);
+    m_file_pos += m_buf_end;
+    if (m_buf_end < dst.size()) {
+        throw std::ios_base::failure("FlatFileReader::read: end of file");
+    }
+    std::memcpy(dst.data(), m_buf.data(), dst.size());
+    m_buf_pos = dst.size();
+}
+
+void FlatFileReader::ignore(size_t size) {
+    const size_t buffered = std::min(size, m_buf_end - m_buf_pos);
+    m_buf_pos += buffered;
+    // Past the buffer, there is nothing to read: the end of the file is only
+    // noticed by the next read.
+    m_file_pos += size - buffered;
+}
+
+FlatFileWriter::FlatFileWriter(FlatFileSeq seq, const char *thread_name,
+                               size_t max_queued_bytes)
+    : m_seq(std::move(seq)), m_max_queued_bytes(max_queued_bytes) {
+    m_thread = std::thread(&util::TraceThread, thread_name,
+                           [this] { ThreadWrite(); });
+}
+
+FlatFileWriter::~FlatFileWriter() {
+    {
+        LOCK(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+bool FlatFileWriter::Write(const FlatFilePos &pos, std::vector<uint8_t> data) {
+    {
+        WAIT_LOCK(m_mutex, lock);
+        // A write larger than the queue still goes through on its own.
+        while (!m_failed && m_queued_bytes > 0 &&
+               m_queued_bytes + data.size() > m_max_queued_bytes) {
+            m_cv.wait(lock);
+        }
+        if (m_failed) {
+            return false;
+        }
+        m_queued_bytes += data.size();
+        ++m_pending[pos.nFile];
+        m_unflushed.insert(pos.nFile);
+        m_queue.push_back({pos, std::move(data)});
+    }
+    m_cv.notify_all();
+    return true;
+}
+
+bool FlatFileWriter::WaitForWrites(int file) {
+    WAIT_LOCK(m_mutex, lock);
+    while (m_pending.count(file) > 0) {
+        m_cv.wait(lock);
+    }
+    return !m_failed;
+}
+
+bool FlatFileWriter::WaitForAllWrites() {
+    WAIT_LOCK(m_mutex, lock);
+    while (!m_pending.empty()) {
+        m_cv.wait(lock);
+    }
+    return !m_failed;
+}
+
+bool FlatFileWriter::Flush(const FlatFilePos &pos, bool finalize) {
+    {
+        WAIT_LOCK(m_mutex, lock);
+        while (m_pending.count(pos.nFile) > 0) {
+            m_cv.wait(lock);
+        }
+        if (m_failed) {
+            return false;
+        }
+        // Writes queued from now on mark the file as unflushed again.
+        if (m_unflushed.erase(pos.nFile) == 0 && !finalize) {
+            return true;
+        }
+    }
+    return m_seq.Flush(pos, finalize);
+}
+
+void FlatFileWriter::ThreadWrite() {
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        if (m_queue.empty()) {
+            if (m_stop) {
+                return;
+            }
+            m_cv.wait(lock);
+            continue;
+        }
+        PendingWrite write{std::move(m_queue.front())};
+        m_queue.pop_front();
+
+        bool ok{false};
+        {
+            REVERSE_LOCK(lock);
+            try {
+                AutoFile file{m_seq.Open(write.pos)};
+                if (!file.IsNull()) {
+                    file.write(MakeByteSpan(write.data));
+                    ok = file.fclose() == 0;
+                }
+            } catch (const std::exception &e) {
+                LogPrintf("%s: Failed to write to %s: %s\n", __func__,
+                          fs::PathToString(m_seq.FileName(write.pos)),
+                          e.what());
+            }
+        }
+
+        if (!ok) {
+            m_failed = true;
+        }
+        m_queued_bytes -= write.data.size();
+        if (--m_pending[write.pos.nFile] == 0) {
+            m_pending.erase(write.pos.nFile);
+        }
+        m_cv.notify_all();
+    }
+}
@@ -7,9 +7,22 @@
 #define BITCOIN_FLATFILE_H
 
 #include <serialize.h>
+#include <span.h>
+#include <sync.h>
+#include <threadsafety.h>
 #include <util/fs.h>
 
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 struct FlatFilePos {
     int nFile;
@@ -94,4 +107,195 @@ public:
     bool Flush(const FlatFilePos &pos, bool finalize = false);
 };
 
+/**
+ * Read-only memory mappings of the files of a FlatFileSeq, shared by the
+ * reader threads, so data can be deserialized straight from the page cache.
+ *
+ * The files are mapped whole, and mapped again once they grew past a read.
+ * Up to a number of files are kept mapped, the least recently read ones being
+ * unmapped once they are not read from anymore. Files which data is removed,
+ * either pruned or truncated, must be unmapped first.
+ *
+ * Not available on Windows, where reads always fail.
+ */
+class FlatFileMapper {
+public:
+    class Mapping;
+
+    /** A range of a mapped file, which stays mapped as long as this exists. */
+    struct View {
+        std::shared_ptr<const Mapping> mapping;
+        Span<const std::byte> data;
+    };
+
+    explicit FlatFileMapper(size_t max_mapped_files)
+        : m_max_mapped_files(max_mapped_files) {}
+    FlatFileMapper(const FlatFileMapper &) = delete;
+    FlatFileMapper &operator=(const FlatFileMapper &) = delete;
+
+    /**
+     * Return the size bytes at the given position of a file of seq, or
+     * std::nullopt if the file can not be mapped or is too short.
+     */
+    std::optional<View> Read(const FlatFileSeq &seq, const FlatFilePos &pos,
+                             size_t size) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Stop mapping the given file for new reads. */
+    void Unmap(int file) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Entry {
+        std::shared_ptr<const Mapping> mapping;
+        uint64_t last_read;
+    };
+
+    const size_t m_max_mapped_files;
+    Mutex m_mutex;
+    std::map<int, Entry> m_files GUARDED_BY(m_mutex);
+    uint64_t m_reads GUARDED_BY(m_mutex){0};
+};
+
+/**
+ * Read-only descriptors of the files of a FlatFileSeq, kept open across reads
+ * and shared by the reader threads, which read at their own offsets.
+ *
+ * Up to a number of files are kept open, the least recently opened ones being
+ * closed once they are not read from anymore. Files which are removed must be
+ * closed first.
+ *
+ * Not available on Windows, where opening always fails.
+ */
+class FlatFileReadCache {
+public:
+    class Handle;
+
+    explicit FlatFileReadCache(size_t max_open_files)
+        : m_max_open_files(max_open_files) {}
+    FlatFileReadCache(const FlatFileReadCache &) = delete;
+    FlatFileReadCache &operator=(const FlatFileReadCache &) = delete;
+
+    /**
+     * Return a handle to the given file of seq, or nullptr if it can not be
+     * opened or the cache is disabled.
+     */
+    std::shared_ptr<const Handle> Open(const FlatFileSeq &seq, int file)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Stop using the descriptor of the given file for new reads. */
+    void Close(int file) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Entry {
+        std::shared_ptr<const Handle> handle;
+        uint64_t last_open;
+    };
+
+    const size_t m_max_open_files;
+    Mutex m_mutex;
+    std::map<int, Entry> m_files GUARDED_BY(m_mutex);
+    uint64_t m_opens GUARDED_BY(m_mutex){0};
+};
+
+/**
+ * Stream reading a file from a FlatFileReadCache handle, from a given offset
+ * on. Reads go through a buffer of the given size, larger ones directly to
+ * their destination. Throws std::ios_base::failure past the end of the file.
+ */
+class FlatFileReader {
+private:
+    const std::shared_ptr<const FlatFileReadCache::Handle> m_handle;
+    const int m_type;
+    const int m_version;
+    //! The offset in the file of the end of the buffer.
+    uint64_t m_file_pos;
+    std::vector<std::byte> m_buf;
+    size_t m_buf_pos{0};
+    size_t m_buf_end{0};
+
+public:
+    FlatFileReader(std::shared_ptr<const FlatFileReadCache::Handle> handle,
+                   uint64_t pos, int type, int version, size_t buffer_size);
+
+    template <typename T> FlatFileReader &operator>>(T &&obj) {
+        ::Unserialize(*this, obj);
+        return *this;
+    }
+
+    int GetType() const { return m_type; }
+    int GetVersion() const { return m_version; }
+
+    void read(Span<std::byte> dst);
+    void ignore(size_t size);
+};
+
+/**
+ * Writes to the files of a FlatFileSeq on a background thread, so the callers
+ * do not wait for the disk.
+ *
+ * The writes are done in the order they are queued. Once a number of bytes
+ * are queued, queuing more waits for the thread to catch up. Readers of a file
+ * must first wait for the writes queued to it. Flushing a file waits for them
+ * too, and only syncs the file if it was written to since it was last flushed,
+ * so that repeated flushes of the same files cost nothing.
+ */
+class FlatFileWriter {
+public:
+    FlatFileWriter(FlatFileSeq seq, const char *thread_name,
+                   size_t max_queued_bytes);
+    FlatFileWriter(const FlatFileWriter &) = delete;
+    FlatFileWriter &operator=(const FlatFileWriter &) = delete;
+
+    /** Do the queued writes, then stop the thread. */
+    ~FlatFileWriter();
+
+    /**
+     * Queue writing data at pos. Return false, without queuing it, if a
+     * previous write failed.
+     */
+    bool Write(const FlatFilePos &pos, std::vector<uint8_t> data)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Wait for the writes queued so far to the given file. Return false if a
+     * write failed.
+     */
+    bool WaitForWrites(int file) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Wait for all the writes queued so far, as WaitForWrites(). */
+    bool WaitForAllWrites() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Wait for the writes queued so far to the file at pos, then flush it as
+     * FlatFileSeq::Flush() does, unless it was not written to since the last
+     * flush and is not finalized.
+     */
+    bool Flush(const FlatFilePos &pos, bool finalize = false)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct PendingWrite {
+        FlatFilePos pos;
+        std::vector<uint8_t> data;
+    };
+
+    FlatFileSeq m_seq;
+    const size_t m_max_queued_bytes;
+
+    Mutex m_mutex;
+    //! Notified when a write is queued or done, and on stop.
+    std::condition_variable m_cv;
+    std::deque<PendingWrite> m_queue GUARDED_BY(m_mutex);
+    size_t m_queued_bytes GUARDED_BY(m_mutex){0};
+    //! For each file, the number of writes to it that are not done yet.
+    std::map<int, size_t> m_pending GUARDED_BY(m_mutex);
+    //! The files written to since they were last flushed.
+    std::set<int> m_unflushed GUARDED_BY(m_mutex);
+    bool m_failed GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+
+    std::thread m_thread;
+
+    void ThreadWrite() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
 #endif // BITCOIN_FLATFILE_H
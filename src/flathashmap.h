@@ -0,0 +1,454 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_FLATHASHMAP_H
+#define BITCOIN_FLATHASHMAP_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * An open addressing hash map storing its elements inline, in the style of
+ * the SwissTable.
+ *
+ * The slots are split into groups of 16, each one having a control byte which
+ * is either empty, deleted, or holds 7 bits of the hash of the key in the
+ * slot. A lookup probes the groups in turn, comparing the 16 control bytes of
+ * a group at once (with SSE2 when available), and only compares the keys of
+ * the slots whose bits match. Compared to std::unordered_map, a lookup
+ * typically touches a single cache line of control bytes and the slot itself,
+ * instead of chasing a bucket pointer then a node pointer, and there is no
+ * per-node allocation.
+ *
+ * The interface is the subset of std::unordered_map used for the coins cache,
+ * with the same semantics, except that:
+ *  - inserting an element can move the other elements, invalidating all the
+ *    iterators and references to them;
+ *  - erasing an element only invalidates the iterators and references to the
+ *    erased element, like std::unordered_map, so erasing while iterating is
+ *    fine;
+ *  - the memory is allocated as a whole, and only shrinks on clear().
+ *
+ * The hash must be of good quality in all its bits, e.g. a salted SipHash.
+ */
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+
+    //! Stand-in for the memory resource of a pool allocated map, so both can
+    //! be constructed the same way. The flat map doesn't need one.
+    struct ResourceType {};
+
+private:
+    static constexpr size_t GROUP_SIZE{16};
+
+    //! The control byte values for the slots without an element. Full slots
+    //! have their top bit unset.
+    static constexpr int8_t CTRL_EMPTY{-128};
+    static constexpr int8_t CTRL_DELETED{-2};
+
+    using Slot =
+        std::aligned_storage_t<sizeof(value_type), alignof(value_type)>;
+
+    Hash m_hash;
+    KeyEqual m_equal;
+
+    //! The number of slots, a power of 2 multiple of GROUP_SIZE, or 0.
+    size_t m_capacity{0};
+    size_t m_size{0};
+    size_t m_deleted{0};
+    std::unique_ptr<int8_t[]> m_ctrl;
+    std::unique_ptr<Slot[]> m_slots;
+
+    static int8_t H2(size_t hash) { return int8_t(hash & 0x7f); }
+    static size_t H1(size_t hash) { return hash >> 7; }
+
+    static bool IsFull(int8_t ctrl) { return ctrl >= 0; }
+
+    //! The maximum number of used (full or deleted) slots for a capacity.
+    static size_t MaxUsed(size_t capacity) { return capacity - capacity / 8; }
+
+    value_type *SlotPtr(size_t i) const {
+        return std::launder(reinterpret_cast<value_type *>(&m_slots[i]));
+    }
+
+    //! Bitmask of the slots of the group starting at pos whose control byte
+    //! is ctrl.
+    uint32_t Match(size_t pos, int8_t ctrl) const {
+#if defined(__SSE2__)
+        const __m128i group = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(m_ctrl.get() + pos));
+        return uint32_t(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(ctrl))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i) {
+            mask |= uint32_t(m_ctrl[pos + i] == ctrl) << i;
+        }
+        return mask;
+#endif
+    }
+
+    //! Bitmask of the slots of the group starting at pos that are empty or
+    //! deleted.
+    uint32_t MatchFree(size_t pos) const {
+#if defined(__SSE2__)
+        const __m128i group = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(m_ctrl.get() + pos));
+        return uint32_t(_mm_movemask_epi8(group));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i) {
+            mask |= uint32_t(!IsFull(m_ctrl[pos + i])) << i;
+        }
+        return mask;
+#endif
+    }
+
+    static int LowestBit(uint32_t mask) {
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        int n = 0;
+        while ((mask & 1) == 0) {
+            mask >>= 1;
+            ++n;
+        }
+        return n;
+#endif
+    }
+
+    /**
+     * Visits the groups of the probe sequence for a hash, which is
+     * triangular so it visits every group exactly once.
+     */
+    class ProbeSeq {
+    private:
+        size_t m_mask;
+        size_t m_pos;
+        size_t m_step{0};
+
+    public:
+        ProbeSeq(size_t hash, size_t capacity)
+            : m_mask(capacity / GROUP_SIZE - 1),
+              m_pos(H1(hash) & m_mask) {}
+        size_t Pos() const { return m_pos * GROUP_SIZE; }
+        void Next() {
+            ++m_step;
+            m_pos = (m_pos + m_step) & m_mask;
+        }
+    };
+
+    //! The index of the slot holding key, or m_capacity if missing.
+    size_t FindIndex(const Key &key, size_t hash) const {
+        if (m_capacity == 0) {
+            return 0;
+        }
+        for (ProbeSeq seq(hash, m_capacity);; seq.Next()) {
+            const size_t pos = seq.Pos();
+            for (uint32_t mask = Match(pos, H2(hash)); mask;
+                 mask &= mask - 1) {
+                const size_t i = pos + LowestBit(mask);
+                if (m_equal(SlotPtr(i)->first, key)) {
+                    return i;
+                }
+            }
+            // An empty slot ends the probe sequence of any key inserted
+            // after it was emptied.
+            if (Match(pos, CTRL_EMPTY)) {
+                return m_capacity;
+            }
+        }
+    }
+
+    //! The index of the first free slot in the probe sequence of a hash. The
+    //! table must have a free slot.
+    size_t FindFree(size_t hash) const {
+        for (ProbeSeq seq(hash, m_capacity);; seq.Next()) {
+            const size_t pos = seq.Pos();
+            if (const uint32_t mask = MatchFree(pos)) {
+                return pos + LowestBit(mask);
+            }
+        }
+    }
+
+    //! Swap the elements but not the hashers, which must be equivalent.
+    void SwapStorage(FlatHashMap &other) noexcept {
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_size, other.m_size);
+        std::swap(m_deleted, other.m_deleted);
+        std::swap(m_ctrl, other.m_ctrl);
+        std::swap(m_slots, other.m_slots);
+    }
+
+    void Rehash(size_t capacity) {
+        FlatHashMap other(0, m_hash, m_equal);
+        other.Allocate(capacity);
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (IsFull(m_ctrl[i])) {
+                value_type *value = SlotPtr(i);
+                const size_t hash = m_hash(value->first);
+                const size_t j = other.FindFree(hash);
+                other.m_ctrl[j] = H2(hash);
+                ::new (&other.m_slots[j]) value_type(std::move(*value));
+                value->~value_type();
+                m_ctrl[i] = CTRL_EMPTY;
+            }
+        }
+        other.m_size = m_size;
+        m_size = 0;
+        SwapStorage(other);
+    }
+
+    void Allocate(size_t capacity) {
+        assert(m_capacity == 0);
+        m_ctrl.reset(new int8_t[capacity]);
+        std::memset(m_ctrl.get(), CTRL_EMPTY, capacity);
+        // The slots are left uninitialized until an element is put there.
+        m_slots.reset(new Slot[capacity]);
+        m_capacity = capacity;
+    }
+
+    //! Make room for one more element.
+    void Reserve1() {
+        if (m_size + m_deleted < MaxUsed(m_capacity)) {
+            return;
+        }
+        // Reclaim the deleted slots when they take a good share of the table,
+        // otherwise grow it.
+        Rehash(m_deleted > m_capacity / 4 ? m_capacity
+                                          : std::max(2 * m_capacity,
+                                                     2 * GROUP_SIZE));
+    }
+
+    //! Insert the element if its key is missing, building it in place.
+    template <typename... Args>
+    std::pair<size_t, bool> TryEmplaceIndex(const Key &key, Args &&...args) {
+        const size_t hash = m_hash(key);
+        const size_t found = FindIndex(key, hash);
+        if (found != m_capacity) {
+            return {found, false};
+        }
+        Reserve1();
+        const size_t i = FindFree(hash);
+        if (m_ctrl[i] == CTRL_DELETED) {
+            --m_deleted;
+        }
+        ::new (&m_slots[i]) value_type(std::forward<Args>(args)...);
+        m_ctrl[i] = H2(hash);
+        ++m_size;
+        return {i, true};
+    }
+
+    size_t NextFull(size_t i) const {
+        while (i < m_capacity && !IsFull(m_ctrl[i])) {
+            ++i;
+        }
+        return i;
+    }
+
+    void EraseIndex(size_t i) {
+        SlotPtr(i)->~value_type();
+        --m_size;
+        // If the group has an empty slot, no probe sequence went past it and
+        // the slot can be made empty again rather than deleted.
+        const size_t pos = i - i % GROUP_SIZE;
+        if (Match(pos, CTRL_EMPTY)) {
+            m_ctrl[i] = CTRL_EMPTY;
+        } else {
+            m_ctrl[i] = CTRL_DELETED;
+            ++m_deleted;
+        }
+    }
+
+    template <bool IsConst> class Iterator {
+    private:
+        using Map = std::conditional_t<IsConst, const FlatHashMap, FlatHashMap>;
+        Map *m_map{nullptr};
+        size_t m_index{0};
+
+        friend class FlatHashMap;
+        template <bool> friend class Iterator;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer =
+            std::conditional_t<IsConst, const value_type *, value_type *>;
+        using reference =
+            std::conditional_t<IsConst, const value_type &, value_type &>;
+
+        Iterator() = default;
+        Iterator(Map *map, size_t index) : m_map(map), m_index(index) {}
+
+        //! An iterator converts to a const_iterator.
+        template <bool C = IsConst, std::enable_if_t<C, int> = 0>
+        Iterator(const Iterator<false> &other)
+            : m_map(other.m_map), m_index(other.m_index) {}
+
+        reference operator*() const { return *m_map->SlotPtr(m_index); }
+        pointer operator->() const { return m_map->SlotPtr(m_index); }
+
+        Iterator &operator++() {
+            m_index = m_map->NextFull(m_index + 1);
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+
+        friend bool operator==(const Iterator &a, const Iterator &b) {
+            return a.m_index == b.m_index;
+        }
+        friend bool operator!=(const Iterator &a, const Iterator &b) {
+            return a.m_index != b.m_index;
+        }
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit FlatHashMap(size_t capacity = 0, const Hash &hash = Hash(),
+                         const KeyEqual &equal = KeyEqual(),
+                         ResourceType * = nullptr)
+        : m_hash(hash), m_equal(equal) {
+        reserve(capacity);
+    }
+
+    FlatHashMap(const FlatHashMap &) = delete;
+    FlatHashMap &operator=(const FlatHashMap &) = delete;
+
+    FlatHashMap(FlatHashMap &&other) noexcept
+        : m_hash(other.m_hash), m_equal(other.m_equal) {
+        SwapStorage(other);
+    }
+
+    //! Not assignable, as the salted hashers are not.
+    FlatHashMap &operator=(FlatHashMap &&other) = delete;
+
+    ~FlatHashMap() { clear(); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    //! The number of slots. There is no bucket as such, this is named after
+    //! std::unordered_map for the memory usage estimation.
+    size_t bucket_count() const { return m_capacity; }
+
+    //! The bucket interface of std::unordered_map, where each slot is a
+    //! bucket of at most one element.
+    using local_iterator = value_type *;
+    using const_local_iterator = const value_type *;
+    local_iterator begin(size_t n) {
+        return IsFull(m_ctrl[n]) ? SlotPtr(n) : nullptr;
+    }
+    local_iterator end(size_t n) {
+        return IsFull(m_ctrl[n]) ? SlotPtr(n) + 1 : nullptr;
+    }
+    const_local_iterator begin(size_t n) const {
+        return IsFull(m_ctrl[n]) ? SlotPtr(n) : nullptr;
+    }
+    const_local_iterator end(size_t n) const {
+        return IsFull(m_ctrl[n]) ? SlotPtr(n) + 1 : nullptr;
+    }
+
+    iterator begin() { return {this, NextFull(0)}; }
+    iterator end() { return {this, m_capacity}; }
+    const_iterator begin() const { return {this, NextFull(0)}; }
+    const_iterator end() const { return {this, m_capacity}; }
+
+    iterator find(const Key &key) {
+        return {this, FindIndex(key, m_hash(key))};
+    }
+    const_iterator find(const Key &key) const {
+        return {this, FindIndex(key, m_hash(key))};
+    }
+    size_t count(const Key &key) const { return find(key) != end(); }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+        const auto [i, inserted] =
+            TryEmplaceIndex(key, std::piecewise_construct,
+                            std::forward_as_tuple(key),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+        return {iterator(this, i), inserted};
+    }
+
+    //! Like std::unordered_map::emplace, the element is built before looking
+    //! up its key.
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args &&...args) {
+        value_type value(std::forward<Args>(args)...);
+        const auto [i, inserted] =
+            TryEmplaceIndex(value.first, std::move(value));
+        return {iterator(this, i), inserted};
+    }
+
+    T &operator[](const Key &key) { return try_emplace(key).first->second; }
+
+    iterator erase(const_iterator pos) {
+        EraseIndex(pos.m_index);
+        return {this, NextFull(pos.m_index + 1)};
+    }
+
+    size_t erase(const Key &key) {
+        const size_t i = FindIndex(key, m_hash(key));
+        if (i == m_capacity) {
+            return 0;
+        }
+        EraseIndex(i);
+        return 1;
+    }
+
+    //! Make room for at least n elements without growing.
+    void reserve(size_t n) {
+        size_t capacity = std::max(m_capacity, 2 * GROUP_SIZE);
+        while (MaxUsed(capacity) <= n) {
+            capacity *= 2;
+        }
+        if (n > 0 && capacity != m_capacity) {
+            Rehash(capacity);
+        }
+    }
+
+    //! Erase all elements and free the memory.
+    void clear() {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (IsFull(m_ctrl[i])) {
+                SlotPtr(i)->~value_type();
+            }
+        }
+        m_ctrl.reset();
+        m_slots.reset();
+        m_capacity = 0;
+        m_size = 0;
+        m_deleted = 0;
+    }
+};
+
+#endif // BITCOIN_FLATHASHMAP_H
@@ -197,6 +197,45 @@ public:
     }
 };
 
+/**
+ * Reads data from an underlying source stream, while appending the read bytes
+ * to a buffer so they can be hashed afterwards, e.g. together with others.
+ */
+template <typename Source> class RecordingReader {
+private:
+    Source &m_source;
+    std::vector<uint8_t> &m_data;
+
+public:
+    RecordingReader(Source &source LIFETIMEBOUND,
+                    std::vector<uint8_t> &data LIFETIMEBOUND)
+        : m_source{source}, m_data{data} {}
+
+    int GetType() const { return m_source.GetType(); }
+    int GetVersion() const { return m_source.GetVersion(); }
+
+    void read(Span<std::byte> dst) {
+        m_source.read(dst);
+        m_data.insert(m_data.end(), UCharCast(dst.data()),
+                      UCharCast(dst.data()) + dst.size());
+    }
+
+    void ignore(size_t nSize) {
+        std::byte data[1024];
+        while (nSize > 0) {
+            size_t now = std::min<size_t>(nSize, 1024);
+            read({data, now});
+            nSize -= now;
+        }
+    }
+
+    template <typename T> RecordingReader<Source> &operator>>(T &&obj) {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+};
+
 /**
  * Writes data to an underlying source stream, while hashing the written data.
  */
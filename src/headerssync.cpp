@@ -368,6 +368,29 @@ std::vector<CBlockHeader> HeadersSyncState::PopHeadersReadyForAcceptance() {
     return ret;
 }
 
+std::optional<CBlockLocator> HeadersSyncState::PipelinedHeadersRequestLocator(
+    const std::vector<CBlockHeader> &headers, bool full_headers_message) const {
+    if (m_download_state != State::PRESYNC || !full_headers_message ||
+        headers.empty() ||
+        headers.front().hashPrevBlock != m_last_header_received.GetHash()) {
+        return std::nullopt;
+    }
+
+    arith_uint256 chain_work{m_current_chain_work};
+    for (const CBlockHeader &header : headers) {
+        chain_work += GetBlockProof(CBlockIndex(header));
+    }
+    if (chain_work >= m_minimum_required_work) {
+        return std::nullopt;
+    }
+
+    std::vector<BlockHash> locator{headers.back().GetHash()};
+    auto chain_start_locator = LocatorEntries(m_chain_start);
+    locator.insert(locator.end(), chain_start_locator.begin(),
+                   chain_start_locator.end());
+    return CBlockLocator{std::move(locator)};
+}
+
 CBlockLocator HeadersSyncState::NextHeadersRequestLocator() const {
     Assume(m_download_state != State::FINAL);
     if (m_download_state == State::FINAL) {
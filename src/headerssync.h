@@ -15,6 +15,7 @@
 #include <util/hasher.h>
 
 #include <deque>
+#include <optional>
 #include <vector>
 
 // A compressed CBlockHeader, which leaves out the prevhash
@@ -200,6 +201,20 @@ public:
      */
     CBlockLocator NextHeadersRequestLocator() const;
 
+    /**
+     * Return the locator that NextHeadersRequestLocator will return once these
+     * headers are processed, if it is already known. The next headers can then
+     * be requested while these ones are being checked.
+     *
+     * This is only the case for a full PRESYNC message which continues the
+     * headers received so far, and can't make the chain reach the minimum
+     * required work (which would start the REDOWNLOAD phase instead). If
+     * these headers turn out to be invalid, the sync is aborted anyway.
+     */
+    std::optional<CBlockLocator>
+    PipelinedHeadersRequestLocator(const std::vector<CBlockHeader> &headers,
+                                   bool full_headers_message) const;
+
 private:
     /**
      * Clear out all download state that might be in progress (freeing any used
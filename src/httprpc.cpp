@@ -75,6 +75,8 @@ static std::unique_ptr<HTTPRPCTimerInterface> httpRPCTimerInterface;
 /* RPC Auth Whitelist */
 static std::map<std::string, std::set<std::string>> g_rpc_whitelist;
 static bool g_rpc_whitelist_default = false;
+/* How the batches are executed */
+static RPCBatchOptions g_rpc_batch_options;
 
 static void JSONErrorReply(HTTPRequest *req, const UniValue &objError,
                            const UniValue &id) {
@@ -315,6 +317,16 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
     JSONRPCRequest jreq;
     jreq.context = context;
     jreq.peerAddr = req->GetPeer().ToString();
+    // Large results are sent while they are serialized
+    bool reply_started = false;
+    JSONRPCReplyStream stream([req, &reply_started](std::string &&chunk) {
+        if (!reply_started) {
+            req->WriteHeader("Content-Type", "application/json");
+            req->WriteReplyStart(HTTP_OK);
+            reply_started = true;
+        }
+        req->WriteReplyChunk(std::move(chunk));
+    });
     if (!RPCAuthorized(authHeader.second, jreq.authUser)) {
         LogPrintf("ThreadRPCServer incorrect password attempt from %s\n",
                   jreq.peerAddr);
@@ -360,7 +372,13 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
+            jreq.stream = &stream;
             UniValue result = rpcServer.ExecuteCommand(config, jreq);
+            if (stream.IsStarted()) {
+                stream.Finish(jreq.id);
+                req->WriteReplyEnd();
+                return true;
+            }
 
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
@@ -389,7 +407,8 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
                 }
             }
             strReply = JSONRPCExecBatch(config, rpcServer, jreq,
-                                        valRequest.get_array());
+                                        valRequest.get_array(),
+                                        g_rpc_batch_options);
         } else {
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
         }
@@ -397,9 +416,22 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue &objError) {
+        if (reply_started) {
+            // Too late for an error reply, the client gets a truncated result
+            LogPrintf("RPC %s failed while sending the result: %s\n",
+                      jreq.strMethod, objError.write());
+            req->WriteReplyEnd();
+            return false;
+        }
         JSONErrorReply(req, objError, jreq.id);
         return false;
     } catch (const std::exception &e) {
+        if (reply_started) {
+            LogPrintf("RPC %s failed while sending the result: %s\n",
+                      jreq.strMethod, e.what());
+            req->WriteReplyEnd();
+            return false;
+        }
         JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
         return false;
     }
@@ -453,19 +485,76 @@ static bool InitRPCAuthentication() {
     return true;
 }
 
+/** The methods which are queued in the mining lane. */
+static const std::set<std::string> MINING_RPC_METHODS{
+    "getblocktemplate", "submitblock",    "submitheader",
+    "createauxblock",   "submitauxblock",
+};
+
+/**
+ * Only this much of the request body is scanned for the method name. Clients
+ * usually send it first, before a potentially large list of parameters.
+ */
+static constexpr size_t RPC_METHOD_PEEK_SIZE{256};
+
+/**
+ * Find the method of a JSON-RPC request without parsing the whole body. This
+ * is only a hint for the request priority, so it doesn't need to be exact.
+ */
+static std::string PeekRPCMethod(const std::string &body) {
+    static const std::string METHOD_KEY{"\"method\""};
+    size_t pos = body.find(METHOD_KEY);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos = body.find_first_not_of(" \t\r\n:", pos + METHOD_KEY.size());
+    if (pos == std::string::npos || body[pos] != '"') {
+        return "";
+    }
+    const size_t end = body.find('"', pos + 1);
+    if (end == std::string::npos) {
+        return "";
+    }
+    return body.substr(pos + 1, end - pos - 1);
+}
+
+static HTTPRequestPriority ClassifyHTTPRPCRequest(const HTTPRequest *req,
+                                                  const std::string &path) {
+    if (MINING_RPC_METHODS.count(
+            PeekRPCMethod(req->PeekBody(RPC_METHOD_PEEK_SIZE)))) {
+        return HTTPRequestPriority::MINING;
+    }
+    return HTTPRequestPriority::DEFAULT;
+}
+
 bool StartHTTPRPC(HTTPRPCRequestProcessor &httpRPCRequestProcessor) {
     LogPrint(BCLog::RPC, "Starting HTTP RPC server\n");
     if (!InitRPCAuthentication()) {
         return false;
     }
 
+    g_rpc_batch_options.max_helpers = std::max<int64_t>(
+        gArgs.GetIntArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), 0);
+    g_rpc_batch_options.max_reply_size =
+        size_t(std::max<int64_t>(gArgs.GetIntArg("-rpcbatchmaxsize",
+                                                 DEFAULT_RPC_BATCH_MAX_SIZE),
+                                 1))
+        << 20;
+    g_rpc_batch_options.executor = [](std::function<void()> task) {
+        return QueueHTTPWork(std::move(task), HTTPRequestPriority::DEFAULT);
+    };
+
     const std::function<bool(Config &, HTTPRequest *, const std::string &)>
         &rpcFunction =
             std::bind(&HTTPRPCRequestProcessor::DelegateHTTPRequest,
                       &httpRPCRequestProcessor, std::placeholders::_2);
-    RegisterHTTPHandler("/", true, rpcFunction);
+    RegisterHTTPHandler("/", true, rpcFunction, ClassifyHTTPRPCRequest);
     if (g_wallet_init_interface.HasWalletSupport()) {
-        RegisterHTTPHandler("/wallet/", false, rpcFunction);
+        RegisterHTTPHandler(
+            "/wallet/", false, rpcFunction,
+            [](const HTTPRequest *req, const std::string &path) {
+                return HTTPRequestPriority::WALLET;
+            });
     }
     struct event_base *eventBase = EventBase();
     assert(eventBase);
@@ -62,4 +62,13 @@ void InterruptREST();
  */
 void StopREST();
 
+/**
+ * Start serving the performance metrics to Prometheus on /metrics.
+ * Precondition; HTTP has been started.
+ */
+void StartHTTPMetrics();
+
+/** Stop serving the performance metrics. */
+void StopHTTPMetrics();
+
 #endif // BITCOIN_HTTPRPC_H
@@ -10,18 +10,22 @@
 #include <compat.h>
 #include <config.h>
 #include <logging.h>
+#include <mpmcqueue.h>
 #include <netbase.h>
 #include <node/ui_interface.h>
 #include <rpc/protocol.h> // For HTTP status codes
 #include <shutdown.h>
 #include <sync.h>
 #include <util/strencodings.h>
+#include <util/fs.h>
 #include <util/threadnames.h>
+#include <util/time.h>
 #include <util/translation.h>
 
 #include <event2/buffer.h>
 #include <event2/bufferevent.h>
 #include <event2/keyvalq_struct.h>
+#include <event2/listener.h>
 #include <event2/thread.h>
 #include <event2/util.h>
 
@@ -29,12 +33,20 @@
 
 #include <sys/stat.h>
 #include <sys/types.h>
+#ifndef WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <deque>
+#include <future>
 #include <memory>
+#include <optional>
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
@@ -63,70 +75,118 @@ private:
 };
 
 /**
- * Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+ * Work queue for distributing work over multiple threads, with a lane per
+ * request priority. Work items are simply callable objects.
+ *
+ * The lanes are lock-free bounded queues, the workers only use the semaphores
+ * to sleep while there is no work. The general workers serve the lanes in
+ * order of priority, and the mining workers only serve the mining lane, so
+ * that a mining request never waits for the slow requests being processed.
  */
 template <typename WorkItem> class WorkQueue {
 private:
-    /** Mutex protects entire object */
-    Mutex cs;
-    std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
-    bool running;
-    size_t maxDepth;
+    std::vector<std::unique_ptr<BoundedMPMCQueue<std::unique_ptr<WorkItem>>>>
+        m_lanes;
+    //! Posted once for every queued item
+    CSemaphore m_pending{0};
+    //! Posted once for every item queued in the mining lane
+    CSemaphore m_mining_pending{0};
+    std::atomic<bool> m_running{true};
+    //! Number of threads running Run(), to wake them all up on Interrupt()
+    std::atomic<int> m_num_workers{0};
+
+    std::unique_ptr<WorkItem> Pop(bool mining_only) {
+        const size_t num_lanes{mining_only ? 1 : m_lanes.size()};
+        for (size_t i = 0; i < num_lanes; ++i) {
+            if (auto item = m_lanes[i]->TryPop()) {
+                return std::move(*item);
+            }
+        }
+        return nullptr;
+    }
 
 public:
-    explicit WorkQueue(size_t _maxDepth) : running(true), maxDepth(_maxDepth) {}
+    explicit WorkQueue(size_t maxDepth) {
+        for (size_t i = 0; i < NUM_HTTP_REQUEST_PRIORITIES; ++i) {
+            m_lanes.push_back(
+                std::make_unique<BoundedMPMCQueue<std::unique_ptr<WorkItem>>>(
+                    maxDepth));
+        }
+    }
     /**
      * Precondition: worker threads have all stopped (they have all been joined)
      */
     ~WorkQueue() {}
 
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem *item) EXCLUSIVE_LOCKS_REQUIRED(!cs) {
-        LOCK(cs);
-        if (queue.size() >= maxDepth) {
+    /**
+     * Enqueue a work item. Each lane holds at most maxDepth items, if the
+     * lane is full the item is left to the caller.
+     */
+    bool Enqueue(std::unique_ptr<WorkItem> &item,
+                 HTTPRequestPriority priority) {
+        if (!m_lanes[size_t(priority)]->TryPush(std::move(item))) {
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
-        cond.notify_one();
+        if (priority == HTTPRequestPriority::MINING) {
+            m_mining_pending.post();
+        }
+        // Spurious wake ups are fine, so the general workers are notified
+        // even if a mining worker might get the mining item first.
+        m_pending.post();
         return true;
     }
 
     /** Thread function */
-    void Run() EXCLUSIVE_LOCKS_REQUIRED(!cs) {
+    void Run(bool mining_only) {
+        ++m_num_workers;
+        CSemaphore &pending{mining_only ? m_mining_pending : m_pending};
+        // Interrupt() only wakes the workers it could count
+        if (!m_running) {
+            return;
+        }
         while (true) {
-            std::unique_ptr<WorkItem> i;
-            {
-                WAIT_LOCK(cs, lock);
-                while (running && queue.empty()) {
-                    cond.wait(lock);
-                }
-                if (!running) {
-                    break;
-                }
-                i = std::move(queue.front());
-                queue.pop_front();
+            pending.wait();
+            if (!m_running) {
+                break;
+            }
+            if (std::unique_ptr<WorkItem> i = Pop(mining_only)) {
+                (*i)();
             }
-            (*i)();
         }
     }
 
     /** Interrupt and exit loops */
-    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!cs) {
-        LOCK(cs);
-        running = false;
-        cond.notify_all();
+    void Interrupt() {
+        m_running = false;
+        for (int i = 0; i < m_num_workers; ++i) {
+            m_pending.post();
+            m_mining_pending.post();
+        }
     }
 };
 
+/** Work queued by QueueHTTPWork */
+class HTTPWorkFunction final : public HTTPClosure {
+public:
+    explicit HTTPWorkFunction(std::function<void()> _work)
+        : work(std::move(_work)) {}
+
+    void operator()() override { work(); }
+
+private:
+    std::function<void()> work;
+};
+
 struct HTTPPathHandler {
     HTTPPathHandler(std::string _prefix, bool _exactMatch,
-                    HTTPRequestHandler _handler)
-        : prefix(_prefix), exactMatch(_exactMatch), handler(_handler) {}
+                    HTTPRequestHandler _handler,
+                    HTTPRequestClassifier _classifier)
+        : prefix(_prefix), exactMatch(_exactMatch), handler(_handler),
+          classifier(_classifier) {}
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPRequestClassifier classifier;
 };
 
 /** HTTP module state */
@@ -143,6 +203,8 @@ static WorkQueue<HTTPClosure> *workQueue = nullptr;
 static std::vector<HTTPPathHandler> pathHandlers;
 //! Bound listening sockets
 static std::vector<evhttp_bound_socket *> boundSockets;
+//! Path of the unix socket listener, removed when the server stops
+static std::optional<fs::path> rpc_unix_socket_path;
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr &netaddr) {
@@ -157,6 +219,28 @@ static bool ClientAllowed(const CNetAddr &netaddr) {
     return false;
 }
 
+/**
+ * Whether the request came through the unix socket listener. Access to the
+ * socket is controlled by its file permissions, so the IP allow list doesn't
+ * apply to these requests. They are still authenticated as usual.
+ */
+static bool IsUnixSocketRequest(evhttp_request *req) {
+#ifndef WIN32
+    evhttp_connection *conn = evhttp_request_get_connection(req);
+    bufferevent *bev = conn ? evhttp_connection_get_bufferevent(conn) : nullptr;
+    if (!bev) {
+        return false;
+    }
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    return getsockname(bufferevent_getfd(bev), (struct sockaddr *)&addr,
+                       &addr_len) == 0 &&
+           addr.ss_family == AF_UNIX;
+#else
+    return false;
+#endif
+}
+
 /** Initialize ACL list for HTTP server */
 static bool InitHTTPAllowList() {
     rpc_allow_subnets.clear();
@@ -228,7 +312,7 @@ static void http_request_cb(struct evhttp_request *req, void *arg) {
     auto hreq = std::make_unique<HTTPRequest>(req);
 
     // Early address-based allow check
-    if (!ClientAllowed(hreq->GetPeer())) {
+    if (!IsUnixSocketRequest(req) && !ClientAllowed(hreq->GetPeer())) {
         LogPrint(BCLog::HTTP,
                  "HTTP request from %s rejected: Client network is not allowed "
                  "RPC access\n",
@@ -271,17 +355,18 @@ static void http_request_cb(struct evhttp_request *req, void *arg) {
 
     // Dispatch to worker thread.
     if (i != iend) {
-        std::unique_ptr<HTTPWorkItem> item(
+        const HTTPRequestPriority priority{
+            i->classifier ? i->classifier(hreq.get(), path)
+                          : HTTPRequestPriority::DEFAULT};
+        std::unique_ptr<HTTPClosure> item(
             new HTTPWorkItem(config, std::move(hreq), path, i->handler));
         assert(workQueue);
-        if (workQueue->Enqueue(item.get())) {
-            /* if true, queue took ownership */
-            item.release();
-        } else {
+        if (!workQueue->Enqueue(item, priority)) {
             LogPrintf("WARNING: request rejected because http work queue depth "
                       "exceeded, it can be increased with the -rpcworkqueue= "
                       "setting\n");
-            item->req->WriteReply(HTTP_SERVICE_UNAVAILABLE,
+            static_cast<HTTPWorkItem *>(item.get())
+                ->req->WriteReply(HTTP_SERVICE_UNAVAILABLE,
                                   "Work queue depth exceeded");
         }
     } else {
@@ -306,7 +391,52 @@ static bool ThreadHTTP(struct event_base *base) {
 }
 
 /** Bind HTTP server to specified addresses */
-static bool HTTPBindAddresses(struct evhttp *http) {
+#ifndef WIN32
+/**
+ * Listen for RPC connections on a unix domain socket at path, only accessible
+ * to the user running the node.
+ */
+static evhttp_bound_socket *HTTPBindUnixSocket(struct event_base *base,
+                                               struct evhttp *http,
+                                               const fs::path &path) {
+    const std::string path_str{fs::PathToString(path)};
+    struct sockaddr_un addr {};
+    if (path_str.size() >= sizeof(addr.sun_path)) {
+        LogPrintf("RPC unix socket path %s is too long\n", path_str);
+        return nullptr;
+    }
+    addr.sun_family = AF_UNIX;
+    std::copy(path_str.begin(), path_str.end(), addr.sun_path);
+
+    // Remove the socket left over by a previous run, but never another file
+    std::error_code ec;
+    if (fs::status(path, ec).type() == fs::file_type::socket) {
+        fs::remove(path, ec);
+    }
+
+    evconnlistener *listener = evconnlistener_new_bind(
+        base, nullptr, nullptr, LEV_OPT_CLOSE_ON_FREE | LEV_OPT_CLOSE_ON_EXEC,
+        -1, (struct sockaddr *)&addr, sizeof(addr));
+    if (!listener) {
+        LogPrintf("Binding RPC on unix socket %s failed.\n", path_str);
+        return nullptr;
+    }
+    if (chmod(path_str.c_str(), S_IRUSR | S_IWUSR) != 0) {
+        LogPrintf("Unable to restrict the permissions of the RPC unix socket "
+                  "%s.\n",
+                  path_str);
+        evconnlistener_free(listener);
+        return nullptr;
+    }
+    evhttp_bound_socket *bind_handle = evhttp_bind_listener(http, listener);
+    if (!bind_handle) {
+        evconnlistener_free(listener);
+    }
+    return bind_handle;
+}
+#endif
+
+static bool HTTPBindAddresses(struct event_base *base, struct evhttp *http) {
     uint16_t http_port{static_cast<uint16_t>(
         gArgs.GetIntArg("-rpcport", BaseParams().RPCPort()))};
     std::vector<std::pair<std::string, uint16_t>> endpoints;
@@ -356,13 +486,29 @@ static bool HTTPBindAddresses(struct evhttp *http) {
                       i->second);
         }
     }
+
+#ifndef WIN32
+    if (gArgs.IsArgSet("-rpcunixsocket")) {
+        const fs::path path{
+            AbsPathForConfigVal(gArgs, gArgs.GetPathArg("-rpcunixsocket"))};
+        LogPrint(BCLog::HTTP, "Binding RPC on unix socket %s\n",
+                 fs::PathToString(path));
+        if (evhttp_bound_socket *bind_handle =
+                HTTPBindUnixSocket(base, http, path)) {
+            boundSockets.push_back(bind_handle);
+            rpc_unix_socket_path = path;
+        }
+    }
+#endif
     return !boundSockets.empty();
 }
 
 /** Simple wrapper to set thread name and run work queue */
-static void HTTPWorkQueueRun(WorkQueue<HTTPClosure> *queue, int worker_num) {
-    util::ThreadRename(strprintf("httpworker.%i", worker_num));
-    queue->Run();
+static void HTTPWorkQueueRun(WorkQueue<HTTPClosure> *queue, int worker_num,
+                             bool mining_only) {
+    util::ThreadRename(strprintf(
+        mining_only ? "httpmining.%i" : "httpworker.%i", worker_num));
+    queue->Run(mining_only);
 }
 
 /** libevent event log callback */
@@ -433,7 +579,7 @@ bool InitHTTPServer(Config &config) {
         http, EVHTTP_REQ_GET | EVHTTP_REQ_POST | EVHTTP_REQ_HEAD |
                   EVHTTP_REQ_PUT | EVHTTP_REQ_DELETE | EVHTTP_REQ_OPTIONS);
 
-    if (!HTTPBindAddresses(http)) {
+    if (!HTTPBindAddresses(base_ctr.get(), http)) {
         LogPrintf("Unable to bind any endpoint for RPC server\n");
         return false;
     }
@@ -441,7 +587,8 @@ bool InitHTTPServer(Config &config) {
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max(
         (long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogPrintfCategory(BCLog::HTTP, "creating work queue of depth %d\n",
+    LogPrintfCategory(BCLog::HTTP,
+                      "creating work queue of depth %d per priority\n",
                       workQueueDepth);
 
     workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
@@ -476,8 +623,11 @@ void StartHTTPServer() {
     g_thread_http = std::thread(ThreadHTTP, eventBase);
 
     for (int i = 0; i < rpcThreads; i++) {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue, i);
+        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue, i,
+                                           /*mining_only=*/false);
     }
+    g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue, 0,
+                                       /*mining_only=*/true);
 }
 
 void InterruptHTTPServer() {
@@ -508,6 +658,11 @@ void StopHTTPServer() {
         evhttp_del_accept_socket(eventHTTP, socket);
     }
     boundSockets.clear();
+    if (rpc_unix_socket_path) {
+        std::error_code ec;
+        fs::remove(*rpc_unix_socket_path, ec);
+        rpc_unix_socket_path.reset();
+    }
     if (eventBase) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP event thread to exit\n");
         if (g_thread_http.joinable()) {
@@ -559,6 +714,11 @@ void HTTPEvent::trigger(struct timeval *tv) {
 HTTPRequest::HTTPRequest(struct evhttp_request *_req, bool _replySent)
     : req(_req), replySent(_replySent) {}
 HTTPRequest::~HTTPRequest() {
+    if (m_reply_started && !replySent) {
+        // The body of a chunked reply can't be replaced by an error anymore
+        LogPrintf("%s: Unterminated reply\n", __func__);
+        WriteReplyEnd();
+    }
     if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
@@ -579,6 +739,17 @@ HTTPRequest::GetHeader(const std::string &hdr) const {
     }
 }
 
+std::string HTTPRequest::PeekBody(size_t max_size) const {
+    struct evbuffer *buf = evhttp_request_get_input_buffer(req);
+    if (!buf) {
+        return "";
+    }
+    std::string rv(std::min(max_size, evbuffer_get_length(buf)), '\0');
+    const ev_ssize_t copied{evbuffer_copyout(buf, rv.data(), rv.size())};
+    rv.resize(std::max<ev_ssize_t>(copied, 0));
+    return rv;
+}
+
 std::string HTTPRequest::ReadBody() {
     struct evbuffer *buf = evhttp_request_get_input_buffer(req);
     if (!buf) {
@@ -610,13 +781,30 @@ void HTTPRequest::WriteHeader(const std::string &hdr,
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+/**
+ * Re-enable reading from the socket once the reply is sent. This is the second
+ * part of the libevent workaround in http_request_cb.
+ */
+static void ReenableReading(evhttp_request *req) {
+    if (event_get_version_number() >= 0x02010600 &&
+        event_get_version_number() < 0x02020001) {
+        evhttp_connection *conn = evhttp_request_get_connection(req);
+        if (conn) {
+            bufferevent *bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 /**
  * Closure sent to main thread to request a reply to be sent to a HTTP request.
  * Replies must be sent in the main loop in the main http thread, this cannot be
  * done from worker threads.
  */
 void HTTPRequest::WriteReply(int nStatus, const std::string &strReply) {
-    assert(!replySent && req);
+    assert(!replySent && req && !m_reply_started);
     if (ShutdownRequested()) {
         WriteHeader("Connection", "close");
     }
@@ -627,18 +815,96 @@ void HTTPRequest::WriteReply(int nStatus, const std::string &strReply) {
     auto req_copy = req;
     HTTPEvent *ev = new HTTPEvent(eventBase, true, [req_copy, nStatus] {
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the
-        // libevent workaround above.
-        if (event_get_version_number() >= 0x02010600 &&
-            event_get_version_number() < 0x02020001) {
-            evhttp_connection *conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent *bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
-            }
+        ReenableReading(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    // transferred back to main thread.
+    req = nullptr;
+}
+
+void HTTPRequest::WriteReplyStart(int nStatus) {
+    assert(!replySent && req && !m_reply_started);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    auto req_copy = req;
+    HTTPEvent *ev = new HTTPEvent(eventBase, true, [req_copy, nStatus] {
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+    m_reply_started = true;
+}
+
+void HTTPRequest::WriteReplyChunk(std::string chunk) {
+    assert(!replySent && req && m_reply_started);
+    // If the client goes away before the end of the reply, libevent detaches
+    // the request from the connection and ignores the remaining chunks. The
+    // request is kept alive until WriteReplyEnd.
+    auto req_copy = req;
+    HTTPEvent *ev = new HTTPEvent(
+        eventBase, true, [req_copy, chunk = std::move(chunk)] {
+            struct evbuffer *evb = evbuffer_new();
+            assert(evb);
+            evbuffer_add(evb, chunk.data(), chunk.size());
+            evhttp_send_reply_chunk(req_copy, evb);
+            evbuffer_free(evb);
+        });
+    ev->trigger(nullptr);
+}
+
+bool HTTPRequest::WaitReplyBacklog(size_t max_backlog) {
+    assert(!replySent && req && m_reply_started);
+#if LIBEVENT_VERSION_NUMBER >= 0x02010200
+    while (!ShutdownRequested()) {
+        // The connection can only be looked at from the event thread. The
+        // backlog is unknown if the request was detached from it.
+        auto backlog = std::make_shared<std::promise<std::optional<size_t>>>();
+        auto req_copy = req;
+        HTTPEvent *ev = new HTTPEvent(eventBase, true, [req_copy, backlog] {
+            evhttp_connection *evcon = evhttp_request_get_connection(req_copy);
+            bufferevent *bev =
+                evcon ? evhttp_connection_get_bufferevent(evcon) : nullptr;
+            backlog->set_value(bev ? std::make_optional(evbuffer_get_length(
+                                         bufferevent_get_output(bev)))
+                                   : std::nullopt);
+        });
+        auto future = backlog->get_future();
+        backlog.reset();
+        ev->trigger(nullptr);
+        if (future.wait_for(std::chrono::seconds{1}) !=
+            std::future_status::ready) {
+            // The event loop is busy or being stopped; check for shutdown.
+            continue;
+        }
+        std::optional<size_t> pending;
+        try {
+            pending = future.get();
+        } catch (const std::future_error &) {
+            // The event was freed along with the event loop.
+        }
+        if (!pending) {
+            return false;
+        }
+        if (*pending <= max_backlog) {
+            return true;
         }
+        UninterruptibleSleep(std::chrono::milliseconds{10});
+    }
+    return false;
+#else
+    return true;
+#endif
+}
+
+void HTTPRequest::WriteReplyEnd() {
+    assert(!replySent && req && m_reply_started);
+    auto req_copy = req;
+    HTTPEvent *ev = new HTTPEvent(eventBase, true, [req_copy] {
+        // The request might be freed by evhttp_send_reply_end, and no other
+        // event can be processed in between.
+        ReenableReading(req_copy);
+        evhttp_send_reply_end(req_copy);
     });
     ev->trigger(nullptr);
     replySent = true;
@@ -681,10 +947,21 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod() const {
 }
 
 void RegisterHTTPHandler(const std::string &prefix, bool exactMatch,
-                         const HTTPRequestHandler &handler) {
+                         const HTTPRequestHandler &handler,
+                         const HTTPRequestClassifier &classifier) {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n",
              prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(
+        HTTPPathHandler(prefix, exactMatch, handler, classifier));
+}
+
+bool QueueHTTPWork(std::function<void()> work, HTTPRequestPriority priority) {
+    if (!workQueue) {
+        return false;
+    }
+    std::unique_ptr<HTTPClosure> item =
+        std::make_unique<HTTPWorkFunction>(std::move(work));
+    return workQueue->Enqueue(item, priority);
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch) {
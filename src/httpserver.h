@@ -6,6 +6,8 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 
@@ -50,17 +52,47 @@ typedef std::function<bool(Config &config, HTTPRequest *req,
                            const std::string &)>
     HTTPRequestHandler;
 
+/**
+ * Priority of a HTTP request. Each priority has its own lane in the work
+ * queue, served in this order.
+ */
+enum class HTTPRequestPriority : uint8_t {
+    //! Block template and block submission requests, which also have a
+    //! dedicated worker.
+    MINING,
+    DEFAULT,
+    //! Wallet requests
+    WALLET,
+};
+static constexpr size_t NUM_HTTP_REQUEST_PRIORITIES{3};
+
+/**
+ * Pick the priority of a request to a certain HTTP path. This is called from
+ * the event loop thread, so it should be cheap.
+ */
+typedef std::function<HTTPRequestPriority(const HTTPRequest *req,
+                                          const std::string &)>
+    HTTPRequestClassifier;
+
 /**
  * Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. The requests are queued with the priority returned by the
+ * classifier, or the default priority if there is none.
  */
 void RegisterHTTPHandler(const std::string &prefix, bool exactMatch,
-                         const HTTPRequestHandler &handler);
+                         const HTTPRequestHandler &handler,
+                         const HTTPRequestClassifier &classifier = nullptr);
 
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/**
+ * Queue some work for the HTTP worker threads with the given priority.
+ * Returns false if the work queue is full or the server is not running.
+ */
+bool QueueHTTPWork(std::function<void()> work, HTTPRequestPriority priority);
+
 /**
  * Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
@@ -75,6 +107,8 @@ class HTTPRequest {
 private:
     struct evhttp_request *req;
     bool replySent;
+    //! Whether a chunked reply was started with WriteReplyStart.
+    bool m_reply_started{false};
 
 public:
     explicit HTTPRequest(struct evhttp_request *req, bool replySent = false);
@@ -105,6 +139,12 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Get the first max_size bytes of the request body without consuming
+     * them.
+     */
+    std::string PeekBody(size_t max_size) const;
+
     /**
      * Write output header.
      *
@@ -123,6 +163,37 @@ public:
      * this.
      */
     void WriteReply(int nStatus, const std::string &strReply = "");
+
+    /**
+     * Start a HTTP reply whose body is sent in several parts with
+     * WriteReplyChunk, using chunked transfer encoding. nStatus is the HTTP
+     * status code to send.
+     *
+     * @note Call this instead of WriteReply, and terminate the reply with
+     * WriteReplyEnd.
+     */
+    void WriteReplyStart(int nStatus);
+
+    /** Send a part of the body of a reply started with WriteReplyStart. */
+    void WriteReplyChunk(std::string chunk);
+
+    /**
+     * Wait until at most max_backlog bytes of the reply started with
+     * WriteReplyStart are waiting to be sent to the client, so that a long
+     * reply is produced no faster than it is consumed. Returns false if the
+     * client went away, in which case the rest of the reply can be skipped.
+     *
+     * @note With libevent versions older than 2.1.2, this does not wait.
+     */
+    bool WaitReplyBacklog(size_t max_backlog);
+
+    /**
+     * Complete a reply started with WriteReplyStart.
+     *
+     * @note Like WriteReply, this gives the request back to the main thread,
+     * do not call any other HTTPRequest methods after calling this.
+     */
+    void WriteReplyEnd();
 };
 
 /** Event handler closure */
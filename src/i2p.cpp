@@ -176,6 +176,8 @@ namespace sam {
 
         std::string session_id;
         std::unique_ptr<Sock> sock;
+        std::string dest;
+        const std::string name{to.ToStringIP()};
         conn.peer = to;
 
         try {
@@ -185,12 +187,18 @@ namespace sam {
                 session_id = m_session_id;
                 conn.me = m_my_addr;
                 sock = Hello();
+                if (auto it = m_destinations.find(name);
+                    it != m_destinations.end()) {
+                    dest = it->second;
+                }
             }
 
-            const Reply &lookup_reply = SendRequestAndGetReply(
-                *sock, strprintf("NAMING LOOKUP NAME=%s", to.ToStringIP()));
+            if (dest.empty()) {
+                const Reply &lookup_reply = SendRequestAndGetReply(
+                    *sock, strprintf("NAMING LOOKUP NAME=%s", name));
 
-            const std::string &dest = lookup_reply.Get("VALUE");
+                dest = lookup_reply.Get("VALUE");
+            }
 
             const Reply &connect_reply = SendRequestAndGetReply(
                 *sock,
@@ -202,6 +210,10 @@ namespace sam {
 
             if (result == "OK") {
                 conn.sock = std::move(sock);
+                LOCK(m_mutex);
+                if (m_destinations.size() < MAX_DESTINATION_CACHE_SIZE) {
+                    m_destinations.emplace(name, std::move(dest));
+                }
                 return true;
             }
 
@@ -51,6 +51,12 @@ namespace sam {
      */
     static constexpr size_t MAX_MSG_SIZE{65536};
 
+    /**
+     * The maximum number of peer destinations remembered to skip their lookup
+     * when reconnecting to them. A destination is about 400 bytes.
+     */
+    static constexpr size_t MAX_DESTINATION_CACHE_SIZE{1000};
+
     /**
      * I2P SAM session.
      */
@@ -276,6 +282,14 @@ namespace sam {
          * SAM session id.
          */
         std::string m_session_id GUARDED_BY(m_mutex);
+
+        /**
+         * The full destinations of the peers we connected to, by their b32
+         * address. A b32 address is the hash of its destination, so they never
+         * change, and looking them up again can take the router seconds.
+         */
+        std::unordered_map<std::string, std::string>
+            m_destinations GUARDED_BY(m_mutex);
     };
 
 } // namespace sam
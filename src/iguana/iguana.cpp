@@ -6,8 +6,10 @@
 #include <common/args.h>
 #include <iguana_formatter.h>
 #include <iguana_interpreter.h>
+#include <iguana_profile.h>
 #include <memory>
 #include <policy/policy.h>
+#include <primitives/block.h>
 #include <span.h>
 #include <streams.h>
 #include <tinyformat.h>
@@ -15,12 +17,15 @@
 #include <util/string.h>
 #include <util/translation.h>
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 
 const std::function<std::string(const char *)> G_TRANSLATION_FUN = nullptr;
 
 const int64_t DEFAULT_INPUT_INDEX = 0;
 const std::string DEFAULT_FORMAT = "human";
+const int64_t DEFAULT_TOP_INPUTS = 10;
 
 void SetupIguanaArgs(ArgsManager &args) {
     args.AddArg("-version", "Print version and exit", ArgsManager::ALLOW_ANY,
@@ -42,6 +47,165 @@ void SetupIguanaArgs(ArgsManager &args) {
                           "csv. Default: %d)",
                           DEFAULT_FORMAT),
                 ArgsManager::ALLOW_STRING, OptionsCategory::OPTIONS);
+    args.AddArg("-batch",
+                "File of transactions to profile all the inputs of, instead of "
+                "running the debugger for -tx. Each line has a raw tx hex, "
+                "followed by <value>:<scriptPubKey hex> of the output spent by "
+                "each input, separated by spaces",
+                ArgsManager::ALLOW_STRING, OptionsCategory::OPTIONS);
+    args.AddArg("-block",
+                "File with a raw block hex on its first line, to profile all "
+                "the inputs of. Each next line has the spent outputs of a "
+                "non-coinbase transaction of the block, as for -batch",
+                ArgsManager::ALLOW_STRING, OptionsCategory::OPTIONS);
+    args.AddArg("-top",
+                strprintf("Number of the slowest inputs to show in the "
+                          "profile (default: %d)",
+                          DEFAULT_TOP_INPUTS),
+                ArgsManager::ALLOW_INT, OptionsCategory::OPTIONS);
+}
+
+/** Read the non-empty lines of the file, skipping the # comments. */
+static bool ReadLines(const std::string &path,
+                      std::vector<std::pair<size_t, std::string>> &lines) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Could not open file " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        line = TrimString(line);
+        if (!line.empty() && line[0] != '#') {
+            lines.emplace_back(lineNumber, line);
+        }
+    }
+    return true;
+}
+
+/** Deserialize the hex, which must be fully consumed. */
+template <typename T> static bool DecodeHex(const std::string &hex, T &obj) {
+    const std::optional<std::vector<uint8_t>> raw = TryParseHex<uint8_t>(hex);
+    if (!raw) {
+        return false;
+    }
+    CDataStream stream(MakeByteSpan(*raw), 0, 0);
+    try {
+        stream >> obj;
+    } catch (const std::exception &) {
+        return false;
+    }
+    return stream.empty();
+}
+
+/** Parse the <value>:<scriptPubKey hex> spent outputs of the transaction. */
+static bool ParseSpentOutputs(const std::vector<std::string> &items,
+                              size_t numInputs,
+                              std::vector<CTxOut> &spentOutputs,
+                              std::string &error) {
+    if (items.size() != numInputs) {
+        error = strprintf("Expected %d spent outputs, got %d", numInputs,
+                          items.size());
+        return false;
+    }
+    for (const std::string &item : items) {
+        const std::vector<std::string> parts = SplitString(item, ':');
+        int64_t value;
+        if (parts.size() != 2 || !ParseInt64(parts[0], &value) ||
+            (!parts[1].empty() && !IsHex(parts[1]))) {
+            error = strprintf("Invalid spent output %s", item);
+            return false;
+        }
+        const std::vector<uint8_t> scriptPubKey = ParseHex(parts[1]);
+        spentOutputs.emplace_back(
+            value * Amount::satoshi(),
+            CScript(scriptPubKey.begin(), scriptPubKey.end()));
+    }
+    return true;
+}
+
+static void ProfileTransaction(const CMutableTransaction &tx,
+                               const std::vector<CTxOut> &spentOutputs,
+                               uint32_t flags, IguanaProfile &profile) {
+    const TxId txid = tx.GetId();
+    for (size_t inputIndex = 0; inputIndex < tx.vin.size(); ++inputIndex) {
+        IguanaInterpreter iguana(tx, inputIndex, spentOutputs[inputIndex],
+                                 flags);
+        profile.AddResult(strprintf("%s:%d", txid.GetHex(), inputIndex),
+                          iguana.Run());
+    }
+}
+
+/**
+ * Run all the inputs of the -batch transactions or of the -block through the
+ * interpreter, and format the aggregated profile.
+ */
+static int RunBatch(const ArgsManager &args, IguanaFormatter &formatter,
+                    uint32_t flags) {
+    const bool isBlock = args.IsArgSet("-block");
+    std::vector<std::pair<size_t, std::string>> lines;
+    if (!ReadLines(args.GetArg(isBlock ? "-block" : "-batch", ""), lines)) {
+        return -1;
+    }
+
+    std::vector<CMutableTransaction> txs;
+    // Index of the first line with spent outputs
+    size_t firstLine = 0;
+    if (isBlock) {
+        CBlock block;
+        if (lines.empty() || !DecodeHex(lines[0].second, block)) {
+            std::cerr << "Invalid block" << std::endl;
+            return -1;
+        }
+        // The coinbase doesn't spend any output
+        for (size_t txIndex = 1; txIndex < block.vtx.size(); ++txIndex) {
+            txs.emplace_back(*block.vtx[txIndex]);
+        }
+        firstLine = 1;
+        if (lines.size() - firstLine != txs.size()) {
+            std::cerr << strprintf("Expected spent outputs for %d "
+                                   "transactions, got %d",
+                                   txs.size(), lines.size() - firstLine)
+                      << std::endl;
+            return -1;
+        }
+    }
+
+    IguanaProfile profile;
+    for (size_t lineIndex = firstLine; lineIndex < lines.size(); ++lineIndex) {
+        const auto &[lineNumber, line] = lines[lineIndex];
+        std::vector<std::string> items = SplitString(line, ' ');
+        items.erase(std::remove(items.begin(), items.end(), ""), items.end());
+
+        CMutableTransaction tx;
+        if (isBlock) {
+            tx = txs[lineIndex - firstLine];
+        } else {
+            if (!DecodeHex(items[0], tx)) {
+                std::cerr << strprintf("Line %d: Invalid transaction",
+                                       lineNumber)
+                          << std::endl;
+                return -1;
+            }
+            items.erase(items.begin());
+        }
+
+        std::vector<CTxOut> spentOutputs;
+        std::string error;
+        if (!ParseSpentOutputs(items, tx.vin.size(), spentOutputs, error)) {
+            std::cerr << strprintf("Line %d: %s", lineNumber, error)
+                      << std::endl;
+            return -1;
+        }
+        ProfileTransaction(tx, spentOutputs, flags, profile);
+    }
+
+    const int64_t numTopInputs = args.GetIntArg("-top", DEFAULT_TOP_INPUTS);
+    if (!formatter.FormatProfile(profile, std::max<int64_t>(0, numTopInputs))) {
+        return -1;
+    }
+
+    return 0;
 }
 
 int main(int argc, char *argv[]) {
@@ -78,6 +242,14 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 
+    const uint32_t flags = STANDARD_SCRIPT_VERIFY_FLAGS_LEGACY;
+
+    ECCVerifyHandle ecc_handle;
+
+    if (args.IsArgSet("-batch") || args.IsArgSet("-block")) {
+        return RunBatch(args, *formatter, flags);
+    }
+
     std::vector<std::string> missingArgs;
     if (!args.IsArgSet("-tx")) {
         missingArgs.push_back("-tx");
@@ -116,10 +288,6 @@ int main(int argc, char *argv[]) {
     CScript scriptPubKey(scriptPubKeyRaw.begin(), scriptPubKeyRaw.end());
     CTxOut txout(value, scriptPubKey);
 
-    const uint32_t flags = STANDARD_SCRIPT_VERIFY_FLAGS_LEGACY;
-
-    ECCVerifyHandle ecc_handle;
-
     IguanaInterpreter iguana(tx, inputIndex, txout, flags);
     IguanaResult result = iguana.Run();
 
@@ -4,6 +4,7 @@
 
 #include <iguana_formatter.h>
 #include <iguana_interpreter.h>
+#include <iguana_profile.h>
 #include <iostream>
 #include <tinyformat.h>
 #include <util/strencodings.h>
@@ -126,6 +127,44 @@ void FormatterHumanReadable::FormatStacks(const IguanaStacks &stacks) {
     }
 }
 
+bool FormatterHumanReadable::FormatProfile(const IguanaProfile &profile,
+                                           size_t numTopInputs) {
+    const IguanaOpcodeProfile total = profile.GetTotal();
+    std::cout << "======= Profile =======" << std::endl;
+    std::cout << strprintf("Inputs: %d (%d failed)", profile.GetInputs().size(),
+                           profile.NumFailedInputs())
+              << std::endl;
+    std::cout << strprintf("Opcodes: %d, sigChecks: %d, time: %d ns",
+                           total.count, total.sigChecks,
+                           total.duration.count())
+              << std::endl;
+    std::cout << strprintf("%-22s %10s %10s %14s %10s", "Opcode", "Count",
+                           "SigChecks", "Time (ns)", "Avg (ns)")
+              << std::endl;
+    for (const auto &[opcode, opcodeProfile] : profile.GetOpcodes()) {
+        std::cout << strprintf("%-22s %10d %10d %14d %10d",
+                               FormatOpcode(opcode), opcodeProfile.count,
+                               opcodeProfile.sigChecks,
+                               opcodeProfile.duration.count(),
+                               opcodeProfile.duration.count() /
+                                   int64_t(opcodeProfile.count))
+                  << std::endl;
+    }
+
+    std::cout << "======= Slowest inputs =======" << std::endl;
+    for (const IguanaInputProfile &input :
+         profile.GetSlowestInputs(numTopInputs)) {
+        std::cout << strprintf("%s: %d ns, %d sigChecks", input.name,
+                               input.duration.count(), input.sigChecks);
+        if (!input.error.empty()) {
+            std::cout << ", failed execution: " << input.error;
+        }
+        std::cout << std::endl;
+    }
+
+    return true;
+}
+
 void FormatterHumanReadable::FormatExecutionMetrics(
     const ScriptExecutionMetrics &metrics) {
     std::cout << "Number of sigChecks: " << metrics.nSigChecks << std::endl;
@@ -240,6 +279,25 @@ void FormatterCsv::FormatStack(const std::vector<std::vector<uint8_t>> &stack) {
     }
 }
 
+bool FormatterCsv::FormatProfile(const IguanaProfile &profile,
+                                 size_t numTopInputs) {
+    std::cout << "opcode,count,sigChecks,timeNs" << std::endl;
+    for (const auto &[opcode, opcodeProfile] : profile.GetOpcodes()) {
+        std::cout << FormatOpcode(opcode) << "," << opcodeProfile.count << ","
+                  << opcodeProfile.sigChecks << ","
+                  << opcodeProfile.duration.count() << std::endl;
+    }
+
+    std::cout << "input,timeNs,sigChecks,error" << std::endl;
+    for (const IguanaInputProfile &input :
+         profile.GetSlowestInputs(numTopInputs)) {
+        std::cout << input.name << "," << input.duration.count() << ","
+                  << input.sigChecks << "," << input.error << std::endl;
+    }
+
+    return true;
+}
+
 void FormatterCsv::FormatExecutionMetrics(
     const ScriptExecutionMetrics &metrics) {
     std::cout << "#sigChecks"
@@ -5,10 +5,12 @@
 #ifndef BITCOIN_IGUANA_IGUANA_FORMATTER_H
 #define BITCOIN_IGUANA_IGUANA_FORMATTER_H
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+class IguanaProfile;
 struct IguanaResult;
 struct IguanaStacks;
 struct IguanaTrace;
@@ -17,12 +19,17 @@ struct ScriptExecutionMetrics;
 class IguanaFormatter {
 public:
     virtual bool Format(const IguanaResult &) = 0;
+    /** Format the profile and the numTopInputs slowest inputs. */
+    virtual bool FormatProfile(const IguanaProfile &profile,
+                               size_t numTopInputs) = 0;
     virtual ~IguanaFormatter(){};
 };
 
 class FormatterHumanReadable : public IguanaFormatter {
 public:
     virtual bool Format(const IguanaResult &result) override;
+    virtual bool FormatProfile(const IguanaProfile &profile,
+                               size_t numTopInputs) override;
 
 private:
     bool FormatTrace(const std::string &title, const IguanaTrace &trace,
@@ -34,6 +41,8 @@ private:
 class FormatterCsv : public IguanaFormatter {
 public:
     virtual bool Format(const IguanaResult &result) override;
+    virtual bool FormatProfile(const IguanaProfile &profile,
+                               size_t numTopInputs) override;
 
 private:
     bool FormatTrace(const std::string &title, const IguanaTrace &trace,
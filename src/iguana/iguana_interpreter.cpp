@@ -8,6 +8,7 @@
 #include <streams.h>
 
 #include <tinyformat.h>
+#include <util/time.h>
 
 IguanaResult IguanaInterpreter::Run() const {
     const CTxIn &txin = tx.vin[inputIndex];
@@ -20,7 +21,8 @@ IguanaResult IguanaInterpreter::Run() const {
     {
         ScriptInterpreter interpreter(stack, txin.scriptSig, flags, sigChecker,
                                       result.metrics);
-        result.traceScriptSig = RunScript(interpreter, isSigPushOnly);
+        result.traceScriptSig = RunScript(interpreter, isSigPushOnly,
+                                          result.metrics);
         if (result.traceScriptSig.scriptError != ScriptError::OK) {
             return result;
         }
@@ -31,7 +33,8 @@ IguanaResult IguanaInterpreter::Run() const {
     {
         ScriptInterpreter interpreter(stack, scriptPubKey, flags, sigChecker,
                                       result.metrics);
-        result.traceScriptPubKey = RunScript(interpreter, false);
+        result.traceScriptPubKey =
+            RunScript(interpreter, false, result.metrics);
         if (result.traceScriptPubKey.scriptError != ScriptError::OK) {
             return result;
         }
@@ -65,7 +68,8 @@ IguanaResult IguanaInterpreter::Run() const {
 
         ScriptInterpreter interpreter(stack, redeemScript, flags, sigChecker,
                                       result.metrics);
-        result.traceRedeemScript = RunScript(interpreter, false);
+        result.traceRedeemScript =
+            RunScript(interpreter, false, result.metrics);
 
         if (result.traceRedeemScript->scriptError != ScriptError::OK) {
             return result;
@@ -95,8 +99,9 @@ IguanaResult IguanaInterpreter::Run() const {
     return result;
 }
 
-IguanaTrace IguanaInterpreter::RunScript(ScriptInterpreter &interpreter,
-                                         bool isPushOnly) const {
+IguanaTrace
+IguanaInterpreter::RunScript(ScriptInterpreter &interpreter, bool isPushOnly,
+                             const ScriptExecutionMetrics &metrics) const {
     IguanaTrace trace;
     trace.scriptError = ScriptError::UNKNOWN;
     trace.initialStacks.stack = interpreter.GetStack();
@@ -118,7 +123,12 @@ IguanaTrace IguanaInterpreter::RunScript(ScriptInterpreter &interpreter,
                 trace.scriptError = ScriptError::SIG_PUSHONLY;
                 return trace;
             }
-            if (!interpreter.RunNextOp()) {
+            const int sigChecksBefore = metrics.nSigChecks;
+            const auto start = SteadyClock::now();
+            const bool success = interpreter.RunNextOp();
+            entry.duration = SteadyClock::now() - start;
+            entry.sigChecks = metrics.nSigChecks - sigChecksBefore;
+            if (!success) {
                 trace.scriptError = interpreter.GetScriptError();
                 return trace;
             }
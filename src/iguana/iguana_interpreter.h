@@ -8,6 +8,7 @@
 #include <script/interpreter.h>
 #include <script/script.h>
 
+#include <chrono>
 #include <optional>
 #include <string>
 #include <vector>
@@ -23,6 +24,10 @@ struct IguanaTraceEntry {
     opcodetype opcode;
     std::vector<uint8_t> pushdata;
     IguanaStacks stacks;
+    // Time spent executing the opcode
+    std::chrono::nanoseconds duration{0};
+    // Number of sigChecks the opcode added
+    int sigChecks = 0;
 };
 
 struct IguanaTrace {
@@ -67,8 +72,8 @@ public:
     IguanaResult Run() const;
 
 private:
-    IguanaTrace RunScript(ScriptInterpreter &interpreter,
-                          bool isPushOnly) const;
+    IguanaTrace RunScript(ScriptInterpreter &interpreter, bool isPushOnly,
+                          const ScriptExecutionMetrics &metrics) const;
 };
 
 #endif // BITCOIN_IGUANA_IGUANA_INTERPRETER_H
@@ -0,0 +1,82 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <iguana_interpreter.h>
+#include <iguana_profile.h>
+#include <script/script_error.h>
+
+#include <algorithm>
+
+void IguanaProfile::AddResult(std::string name, const IguanaResult &result) {
+    IguanaInputProfile &input = inputs.emplace_back();
+    input.name = std::move(name);
+    AddTrace(result.traceScriptSig, input);
+    AddTrace(result.traceScriptPubKey, input);
+    if (result.traceRedeemScript) {
+        AddTrace(*result.traceRedeemScript, input);
+    }
+}
+
+void IguanaProfile::AddTrace(const IguanaTrace &trace,
+                             IguanaInputProfile &input) {
+    for (const IguanaTraceEntry &entry : trace.entries) {
+        IguanaOpcodeProfile &opcode = opcodes[entry.opcode];
+        ++opcode.count;
+        opcode.sigChecks += entry.sigChecks;
+        opcode.duration += entry.duration;
+        input.sigChecks += entry.sigChecks;
+        input.duration += entry.duration;
+    }
+
+    // Only the first failure is reported, the later scripts are not run
+    if (input.error.empty() && (!trace.errorMsg.empty() ||
+                                trace.scriptError != ScriptError::OK)) {
+        input.error = trace.errorMsg.empty()
+                          ? ScriptErrorString(trace.scriptError)
+                          : trace.errorMsg;
+    }
+}
+
+std::vector<std::pair<opcodetype, IguanaOpcodeProfile>>
+IguanaProfile::GetOpcodes() const {
+    std::vector<std::pair<opcodetype, IguanaOpcodeProfile>> result;
+    for (size_t opcode = 0; opcode < opcodes.size(); ++opcode) {
+        if (opcodes[opcode].count > 0) {
+            result.emplace_back(opcodetype(opcode), opcodes[opcode]);
+        }
+    }
+    std::stable_sort(result.begin(), result.end(),
+                     [](const auto &a, const auto &b) {
+                         return a.second.duration > b.second.duration;
+                     });
+    return result;
+}
+
+std::vector<IguanaInputProfile>
+IguanaProfile::GetSlowestInputs(size_t n) const {
+    std::vector<IguanaInputProfile> result = inputs;
+    std::stable_sort(result.begin(), result.end(),
+                     [](const IguanaInputProfile &a,
+                        const IguanaInputProfile &b) {
+                         return a.duration > b.duration;
+                     });
+    result.resize(std::min(n, result.size()));
+    return result;
+}
+
+size_t IguanaProfile::NumFailedInputs() const {
+    return std::count_if(
+        inputs.begin(), inputs.end(),
+        [](const IguanaInputProfile &input) { return !input.error.empty(); });
+}
+
+IguanaOpcodeProfile IguanaProfile::GetTotal() const {
+    IguanaOpcodeProfile total;
+    for (const IguanaOpcodeProfile &opcode : opcodes) {
+        total.count += opcode.count;
+        total.sigChecks += opcode.sigChecks;
+        total.duration += opcode.duration;
+    }
+    return total;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_IGUANA_IGUANA_PROFILE_H
+#define BITCOIN_IGUANA_IGUANA_PROFILE_H
+
+#include <script/script.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct IguanaResult;
+struct IguanaTrace;
+
+struct IguanaOpcodeProfile {
+    uint64_t count = 0;
+    int64_t sigChecks = 0;
+    std::chrono::nanoseconds duration{0};
+};
+
+struct IguanaInputProfile {
+    // Name of the input, as <txid>:<input index>
+    std::string name;
+    std::chrono::nanoseconds duration{0};
+    int sigChecks = 0;
+    // Empty if the input executed without errors
+    std::string error;
+};
+
+/**
+ * Aggregate the traces of many inputs, to find which opcodes and scripts are
+ * expensive to validate.
+ */
+class IguanaProfile {
+private:
+    std::array<IguanaOpcodeProfile, 256> opcodes{};
+    std::vector<IguanaInputProfile> inputs;
+
+public:
+    void AddResult(std::string name, const IguanaResult &result);
+
+    /** The executed opcodes, the most time consuming first. */
+    std::vector<std::pair<opcodetype, IguanaOpcodeProfile>>
+    GetOpcodes() const;
+
+    /** The n most time consuming inputs, the slowest first. */
+    std::vector<IguanaInputProfile> GetSlowestInputs(size_t n) const;
+
+    const std::vector<IguanaInputProfile> &GetInputs() const {
+        return inputs;
+    }
+    size_t NumFailedInputs() const;
+    IguanaOpcodeProfile GetTotal() const;
+
+private:
+    void AddTrace(const IguanaTrace &trace, IguanaInputProfile &input);
+};
+
+#endif // BITCOIN_IGUANA_IGUANA_PROFILE_H
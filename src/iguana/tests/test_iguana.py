@@ -8,8 +8,9 @@ import subprocess
 
 from test_framework.hash import hash160
 from test_framework.key import ECKey
-from test_framework.messages import COutPoint, CTransaction, CTxIn
+from test_framework.messages import CBlock, COutPoint, CTransaction, CTxIn
 from test_framework.script import (
+    OP_1,
     OP_2DUP,
     OP_ADD,
     OP_CHECKSIG,
@@ -17,6 +18,7 @@ from test_framework.script import (
     OP_DROP,
     OP_DUP,
     OP_EQUAL,
+    OP_EQUALVERIFY,
     OP_HASH160,
     OP_NOP,
     OP_NOT,
@@ -796,3 +798,154 @@ OP  6: OP_CHECKSIG
 Script executed without errors
 """
     )
+
+
+def parse_profile_csv(stdout):
+    """Split the CSV profile into the opcode rows by opcode and the input rows,
+    without the timings."""
+    opcode_lines, input_lines = stdout.split("input,timeNs,sigChecks,error\n")
+    opcode_rows = opcode_lines.splitlines()
+    assert opcode_rows[0] == "opcode,count,sigChecks,timeNs"
+    opcodes = {}
+    for row in opcode_rows[1:]:
+        opcode, count, sig_checks, time_ns = row.split(",")
+        assert int(time_ns) >= 0
+        opcodes[opcode] = (int(count), int(sig_checks))
+    inputs = []
+    for row in input_lines.splitlines():
+        name, time_ns, sig_checks, error = row.split(",")
+        assert int(time_ns) >= 0
+        inputs.append((name, int(sig_checks), error))
+    return opcodes, inputs
+
+
+def test_batch_profile(tmp_path):
+    key = ECKey()
+    key.set(b"12345678" * 4, True)
+    pubkey = key.get_pubkey().get_bytes()
+    script_pub_key = CScript(
+        [OP_DUP, OP_HASH160, hash160(pubkey), OP_EQUALVERIFY, OP_CHECKSIG]
+    )
+    signed_tx = CTransaction()
+    signed_tx.vin = [CTxIn(COutPoint())]
+    (sighash, _) = SignatureHash(script_pub_key, signed_tx, 0, SIGHASH_ALL)
+    sig = key.sign_ecdsa(sighash) + b"\x01"
+    signed_tx.vin[0].scriptSig = CScript([sig, pubkey])
+    signed_tx.rehash()
+    failing_tx = CTransaction()
+    failing_tx.vin = [
+        CTxIn(COutPoint(), CScript([b"\x31"])),
+        CTxIn(COutPoint(), CScript([b"\x32"])),
+    ]
+    failing_tx.rehash()
+    batch_file = tmp_path / "batch.txt"
+    batch_file.write_text(
+        f"""\
+# A comment
+{signed_tx.serialize().hex()} 0:{script_pub_key.hex()}
+
+{failing_tx.serialize().hex()} 0:{CScript([OP_NOT]).hex()} 0:
+"""
+    )
+
+    opcodes, inputs = parse_profile_csv(
+        iguana(f"-batch={batch_file}", "-format=csv")
+    )
+    assert opcodes == {
+        f"0x{len(sig):02x}": (1, 0),
+        "0x21": (1, 0),
+        "OP_DUP": (1, 0),
+        "OP_HASH160": (1, 0),
+        "0x14": (1, 0),
+        "OP_EQUALVERIFY": (1, 0),
+        "OP_CHECKSIG": (1, 1),
+        "0x01": (2, 0),
+        "OP_NOT": (1, 0),
+    }
+    assert sorted(inputs) == sorted(
+        [
+            (f"{signed_tx.hash}:0", 1, ""),
+            (
+                f"{failing_tx.hash}:0",
+                0,
+                "Script evaluated without error but finished with a "
+                "false/empty top stack element",
+            ),
+            (f"{failing_tx.hash}:1", 0, ""),
+        ]
+    )
+
+    # Only the slowest input is shown
+    _, inputs = parse_profile_csv(
+        iguana(f"-batch={batch_file}", "-format=csv", "-top=1")
+    )
+    assert len(inputs) == 1
+
+    stdout = iguana(f"-batch={batch_file}")
+    assert stdout.startswith(
+        """\
+======= Profile =======
+Inputs: 3 (1 failed)
+Opcodes: 10, sigChecks: 1, time: """
+    )
+    assert "\nOP_CHECKSIG " in stdout
+    assert "\n======= Slowest inputs =======\n" in stdout
+    assert f"\n{signed_tx.hash}:0: " in stdout
+    assert (
+        f"\n{failing_tx.hash}:0: " in stdout
+        and ", 0 sigChecks, failed execution: Script evaluated without error "
+        "but finished with a false/empty top stack element\n" in stdout
+    )
+
+
+def test_batch_invalid(tmp_path):
+    tx = CTransaction()
+    tx.vin = [CTxIn(COutPoint(), CScript([b"\x31"]))]
+
+    def run(content, expected_stderr):
+        batch_file = tmp_path / "batch.txt"
+        batch_file.write_text(content)
+        iguana(f"-batch={batch_file}", expected_stderr=expected_stderr)
+
+    iguana(
+        f"-batch={tmp_path / 'doesntexist.txt'}",
+        expected_stderr=f"Could not open file {tmp_path / 'doesntexist.txt'}\n",
+    )
+    run("\n\nnothex 0:\n", "Line 3: Invalid transaction\n")
+    run(f"{tx.serialize().hex()}\n", "Line 1: Expected 1 spent outputs, got 0\n")
+    run(f"{tx.serialize().hex()} 0:51 0:51\n", "Line 1: Expected 1 spent outputs, got 2\n")
+    run(f"{tx.serialize().hex()} 0\n", "Line 1: Invalid spent output 0\n")
+    run(f"{tx.serialize().hex()} x:51\n", "Line 1: Invalid spent output x:51\n")
+    run(f"{tx.serialize().hex()} 0:5\n", "Line 1: Invalid spent output 0:5\n")
+
+
+def test_block_profile(tmp_path):
+    coinbase = CTransaction()
+    coinbase.vin = [CTxIn(COutPoint(), CScript([b"\x01"]))]
+    coinbase.rehash()
+    tx = CTransaction()
+    tx.vin = [
+        CTxIn(COutPoint(coinbase.sha256, 0), CScript([b"\x31"])),
+        CTxIn(COutPoint(coinbase.sha256, 1), CScript([b"\x32"])),
+    ]
+    tx.rehash()
+    block = CBlock()
+    block.vtx = [coinbase, tx]
+    block_file = tmp_path / "block.txt"
+    block_file.write_text(
+        f"{block.serialize().hex()}\n0:{CScript([OP_DROP, OP_1]).hex()} 0:\n"
+    )
+
+    opcodes, inputs = parse_profile_csv(
+        iguana(f"-block={block_file}", "-format=csv")
+    )
+    assert opcodes == {"0x01": (2, 0), "OP_DROP": (1, 0), "OP_1": (1, 0)}
+    assert sorted(inputs) == [(f"{tx.hash}:0", 0, ""), (f"{tx.hash}:1", 0, "")]
+
+    block_file.write_text(f"{block.serialize().hex()}\n")
+    iguana(
+        f"-block={block_file}",
+        expected_stderr="Expected spent outputs for 1 transactions, got 0\n",
+    )
+    block_file.write_text("00\n")
+    iguana(f"-block={block_file}", expected_stderr="Invalid block\n")
@@ -16,14 +16,20 @@
 #include <util/thread.h>
 #include <util/translation.h>
 #include <validation.h> // For Chainstate
+#include <validationthreadpool.h>
 #include <warnings.h>
 
+#include <deque>
+#include <exception>
 #include <functional>
+#include <future>
 
 constexpr uint8_t DB_BEST_BLOCK{'B'};
 
 constexpr int64_t SYNC_LOG_INTERVAL = 30;           // secon
 constexpr int64_t SYNC_LOCATOR_WRITE_INTERVAL = 30; // seconds
+//! How many blocks the sync reads ahead of the one being indexed.
+constexpr size_t SYNC_READ_AHEAD_BLOCKS{16};
 
 template <typename... Args>
 static void FatalError(const char *fmt, const Args &...args) {
@@ -34,16 +40,89 @@ static void FatalError(const char *fmt, const Args &...args) {
     StartShutdown();
 }
 
-BaseIndex::DB::DB(const fs::path &path, size_t n_cache_size, bool f_memory,
-                  bool f_wipe, bool f_obfuscate)
+namespace {
+/**
+ * The blocks being read ahead of the sync on the validation thread pool, in
+ * chain order.
+ */
+class BlockReadAhead {
+public:
+    using PrepareFn =
+        std::function<void(const CBlock &block, const CBlockIndex *pindex)>;
+
+    BlockReadAhead(const node::BlockManager &blockman, PrepareFn prepare)
+        : m_blockman{blockman}, m_prepare{std::move(prepare)} {}
+    ~BlockReadAhead() { Clear(); }
+
+    bool Empty() const { return m_reads.empty(); }
+    size_t Size() const { return m_reads.size(); }
+    const CBlockIndex *Front() const { return m_reads.front().pindex; }
+    const CBlockIndex *Back() const { return m_reads.back().pindex; }
+
+    void Schedule(const CBlockIndex *pindex, ValidationThreadPool &pool) {
+        auto block{std::make_shared<CBlock>()};
+        // If the pool drops the task, the future reports a broken promise.
+        auto task{std::make_shared<std::packaged_task<bool()>>(
+            [&blockman = m_blockman, &prepare = m_prepare, block, pindex]() {
+                if (!blockman.ReadBlockFromDisk(*block, *pindex)) {
+                    return false;
+                }
+                prepare(*block, pindex);
+                return true;
+            })};
+        m_reads.push_back({pindex, block, task->get_future()});
+        pool.Submit([task]() { (*task)(); });
+    }
+
+    /** Wait for the first block to be read, and take it. */
+    bool Take(CBlock &block) {
+        Read read{std::move(m_reads.front())};
+        m_reads.pop_front();
+        try {
+            if (!read.done.get()) {
+                return false;
+            }
+        } catch (const std::exception &) {
+            return false;
+        }
+        block = std::move(*read.block);
+        return true;
+    }
+
+    /** Wait for the pending reads, and drop the blocks. */
+    void Clear() {
+        for (Read &read : m_reads) {
+            read.done.wait();
+        }
+        m_reads.clear();
+    }
+
+private:
+    struct Read {
+        const CBlockIndex *pindex;
+        std::shared_ptr<CBlock> block;
+        std::future<bool> done;
+    };
+
+    const node::BlockManager &m_blockman;
+    const PrepareFn m_prepare;
+    std::deque<Read> m_reads;
+};
+} // namespace
+
+BaseIndex::DB::DB(const fs::path &path, const std::string &name,
+                  size_t n_cache_size, bool f_memory, bool f_wipe,
+                  bool f_obfuscate)
     : CDBWrapper{DBParams{.path = path,
                           .cache_bytes = n_cache_size,
                           .memory_only = f_memory,
                           .wipe_data = f_wipe,
                           .obfuscate = f_obfuscate,
-                          .options = [] {
+                          .options = [&] {
+                              // The arguments are checked at startup.
                               DBOptions options;
-                              node::ReadDatabaseArgs(gArgs, options);
+                              (void)node::ReadDatabaseArgs(gArgs, options,
+                                                           name);
                               return options;
                           }()}} {}
 
@@ -146,6 +225,13 @@ void BaseIndex::ThreadSync() {
     if (!m_synced) {
         int64_t last_log_time = 0;
         int64_t last_locator_write_time = 0;
+        ValidationThreadPool &pool{GetValidationThreadPool()};
+        BlockReadAhead read_ahead{
+            m_chainstate->m_blockman,
+            [this](const CBlock &block, const CBlockIndex *pindex_read) {
+                PrepareBlock(block, pindex_read);
+            }};
+        std::vector<const CBlockIndex *> to_read;
         while (true) {
             if (m_interrupt) {
                 SetBestBlockIndex(pindex);
@@ -176,7 +262,34 @@ void BaseIndex::ThreadSync() {
                     return;
                 }
                 pindex = pindex_next;
+
+                // Read the next blocks of the chain in the background, while
+                // this one is indexed. The blocks read ahead are dropped if
+                // the chain changed since.
+                if (!read_ahead.Empty() && read_ahead.Front() != pindex) {
+                    read_ahead.Clear();
+                }
+                if (pool.Size() > 0) {
+                    const CBlockIndex *pindex_read{
+                        read_ahead.Empty() ? nullptr : read_ahead.Back()};
+                    if (!pindex_read) {
+                        to_read.push_back(pindex);
+                        pindex_read = pindex;
+                    }
+                    while (read_ahead.Size() + to_read.size() <
+                           SYNC_READ_AHEAD_BLOCKS) {
+                        pindex_read = m_chainstate->m_chain.Next(pindex_read);
+                        if (!pindex_read) {
+                            break;
+                        }
+                        to_read.push_back(pindex_read);
+                    }
+                }
+            }
+            for (const CBlockIndex *pindex_read : to_read) {
+                read_ahead.Schedule(pindex_read, pool);
             }
+            to_read.clear();
 
             int64_t current_time = GetTime();
             if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
@@ -194,7 +307,10 @@ void BaseIndex::ThreadSync() {
             }
 
             CBlock block;
-            if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
+            if (!(read_ahead.Empty()
+                      ? m_chainstate->m_blockman.ReadBlockFromDisk(block,
+                                                                   *pindex)
+                      : read_ahead.Take(block))) {
                 FatalError("%s: Failed to read block %s from disk", __func__,
                            pindex->GetBlockHash().ToString());
                 return;
@@ -254,19 +370,14 @@ bool BaseIndex::Rewind(const CBlockIndex *current_tip,
     return true;
 }
 
-void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock> &block,
-                               const CBlockIndex *pindex) {
-    if (!m_synced) {
-        return;
-    }
-
+bool BaseIndex::PrepareConnect(const CBlockIndex *pindex) {
     const CBlockIndex *best_block_index = m_best_block_index.load();
     if (!best_block_index) {
         if (pindex->nHeight != 0) {
             FatalError("%s: First block connected is not the genesis block "
                        "(height=%d)",
                        __func__, pindex->nHeight);
-            return;
+            return false;
         }
     } else {
         // Ensure block connects to an ancestor of the current best block. This
@@ -282,15 +393,23 @@ void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock> &block,
                       "of known best chain (tip=%s); not updating index\n",
                       __func__, pindex->GetBlockHash().ToString(),
                       best_block_index->GetBlockHash().ToString());
-            return;
+            return false;
         }
         if (best_block_index != pindex->pprev &&
             !Rewind(best_block_index, pindex->pprev)) {
             FatalError("%s: Failed to rewind index %s to a previous chain tip",
                        __func__, GetName());
-            return;
+            return false;
         }
     }
+    return true;
+}
+
+void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock> &block,
+                               const CBlockIndex *pindex) {
+    if (!m_synced || !PrepareConnect(pindex)) {
+        return;
+    }
 
     if (WriteBlock(*block, pindex)) {
         // Setting the best block index is intentionally the last step of this
@@ -305,6 +424,46 @@ void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock> &block,
     }
 }
 
+void BaseIndex::BlocksConnected(const std::vector<ConnectedBlock> &blocks) {
+    if (!m_synced) {
+        return;
+    }
+
+    // The blocks are only written at once if they extend each other, the
+    // checks of the first one then apply to all of them.
+    bool is_chain = true;
+    for (size_t i = 1; i < blocks.size(); ++i) {
+        is_chain &= blocks[i].pindex->pprev == blocks[i - 1].pindex;
+    }
+    if (!is_chain || blocks.size() < 2) {
+        for (const ConnectedBlock &connected : blocks) {
+            BlockConnected(connected.block, connected.pindex);
+        }
+        return;
+    }
+
+    if (!PrepareConnect(blocks.front().pindex)) {
+        return;
+    }
+
+    if (WriteBlocks(blocks)) {
+        SetBestBlockIndex(blocks.back().pindex);
+    } else {
+        FatalError("%s: Failed to write blocks %s to %s to index", __func__,
+                   blocks.front().pindex->GetBlockHash().ToString(),
+                   blocks.back().pindex->GetBlockHash().ToString());
+    }
+}
+
+bool BaseIndex::WriteBlocks(const std::vector<ConnectedBlock> &blocks) {
+    for (const ConnectedBlock &connected : blocks) {
+        if (!WriteBlock(*connected.block, connected.pindex)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void BaseIndex::ChainStateFlushed(const CBlockLocator &locator) {
     if (!m_synced) {
         return;
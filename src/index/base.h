@@ -35,8 +35,9 @@ protected:
      */
     class DB : public CDBWrapper {
     public:
-        DB(const fs::path &path, size_t n_cache_size, bool f_memory = false,
-           bool f_wipe = false, bool f_obfuscate = false);
+        DB(const fs::path &path, const std::string &name, size_t n_cache_size,
+           bool f_memory = false, bool f_wipe = false,
+           bool f_obfuscate = false);
 
         /// Read block locator of the chain that the index is in sync with.
         bool ReadBestBlock(CBlockLocator &locator) const;
@@ -84,10 +85,18 @@ protected:
     void BlockConnected(const std::shared_ptr<const CBlock> &block,
                         const CBlockIndex *pindex) override;
 
+    void BlocksConnected(const std::vector<ConnectedBlock> &blocks) override;
+
     void ChainStateFlushed(const CBlockLocator &locator) override;
 
+    std::string GetSubscriberName() const override { return GetName(); }
+
     const CBlockIndex *CurrentIndex() { return m_best_block_index.load(); };
 
+    /// Whether the blocks are written from the notifications, as opposed to
+    /// by the sync thread catching up.
+    bool IsSynced() const { return m_synced; }
+
     /// Initialize internal state from the database and block index.
     [[nodiscard]] virtual bool Init();
 
@@ -96,6 +105,16 @@ protected:
         return true;
     }
 
+    /// Write the index entries for several connected blocks, in chain order.
+    /// This calls WriteBlock for each of them by default.
+    virtual bool WriteBlocks(const std::vector<ConnectedBlock> &blocks);
+
+    /// Called from the validation thread pool, in no particular order, for
+    /// the blocks read ahead of the sync. This lets the work only depending on
+    /// the block be done ahead of WriteBlock, which is still called for each
+    /// of them in chain order, unless the chain changed in between.
+    virtual void PrepareBlock(const CBlock &block, const CBlockIndex *pindex) {}
+
     /// Virtual method called internally by Commit that can be overridden to
     /// atomically commit more index state.
     virtual bool CommitInternal(CDBBatch &batch);
@@ -110,6 +129,10 @@ protected:
     /// Get the name of the index for display in logs.
     virtual const char *GetName() const = 0;
 
+    /// Check that the block connects to the best block, rewinding the index if
+    /// needed. Returns false if the block must not be written.
+    bool PrepareConnect(const CBlockIndex *pindex);
+
     /// Update the internal best block index as well as the prune lock.
     void SetBestBlockIndex(const CBlockIndex *block);
 
@@ -10,7 +10,9 @@
 #include <util/fs_helpers.h>
 #include <validation.h>
 
+#include <cstdio>
 #include <map>
+#include <optional>
 
 /**
  * The index database stores three items for each block: the disk location of
@@ -50,6 +52,9 @@ constexpr unsigned int FLTR_FILE_CHUNK_SIZE = 0x100000;
  */
 constexpr size_t CF_HEADERS_CACHE_MAX_SZ{2000};
 
+/** Maximum memory used by the cache of the filters served recently (8 MiB) */
+constexpr size_t FILTER_CACHE_MAX_BYTES{8 << 20};
+
 namespace {
 
 struct DBVal {
@@ -116,8 +121,8 @@ BlockFilterIndex::BlockFilterIndex(BlockFilterType filter_type,
     fs::create_directories(path);
 
     m_name = filter_name + " block filter index";
-    m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory,
-                                           f_wipe);
+    m_db = std::make_unique<BaseIndex::DB>(path / "db", "blockfilterindex",
+                                           n_cache_size, f_memory, f_wipe);
     m_filter_fileseq = std::make_unique<FlatFileSeq>(std::move(path), "fltr",
                                                      FLTR_FILE_CHUNK_SIZE);
 }
@@ -158,19 +163,15 @@ bool BlockFilterIndex::CommitInternal(CDBBatch &batch) {
     return BaseIndex::CommitInternal(batch);
 }
 
-bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos &pos,
-                                          BlockFilter &filter) const {
-    AutoFile filein{m_filter_fileseq->Open(pos, true)};
-    if (filein.IsNull()) {
-        return false;
-    }
-
+/** Read a filter at the current position of a filter file. */
+static bool ReadFilter(AutoFile &filein, BlockFilterType filter_type,
+                       BlockFilter &filter) {
     BlockHash block_hash;
     std::vector<uint8_t> encoded_filter;
     try {
         filein >> block_hash >> encoded_filter;
         filter =
-            BlockFilter(GetFilterType(), block_hash, std::move(encoded_filter));
+            BlockFilter(filter_type, block_hash, std::move(encoded_filter));
     } catch (const std::exception &e) {
         return error("%s: Failed to deserialize block filter from disk: %s",
                      __func__, e.what());
@@ -179,6 +180,52 @@ bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos &pos,
     return true;
 }
 
+bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos &pos,
+                                          BlockFilter &filter) const {
+    AutoFile filein{m_filter_fileseq->Open(pos, true)};
+    if (filein.IsNull()) {
+        return false;
+    }
+
+    return ReadFilter(filein, GetFilterType(), filter);
+}
+
+bool BlockFilterIndex::LookupCachedFilter(const uint256 &filter_hash,
+                                          BlockFilter &filter_out) const {
+    LOCK(m_filter_cache_mutex);
+    auto it = m_filter_cache.find(filter_hash);
+    if (it == m_filter_cache.end()) {
+        return false;
+    }
+    filter_out = it->second;
+    return true;
+}
+
+void BlockFilterIndex::CacheFilter(const uint256 &filter_hash,
+                                   const BlockFilter &filter) const {
+    // The filters are content addressed, so an entry never gets stale, even
+    // when the index is rewound and the filter files overwritten.
+    const size_t filter_bytes{sizeof(BlockFilter) +
+                              filter.GetEncodedFilter().size()};
+    if (filter_bytes > FILTER_CACHE_MAX_BYTES) {
+        return;
+    }
+
+    LOCK(m_filter_cache_mutex);
+    if (!m_filter_cache.emplace(filter_hash, filter).second) {
+        return;
+    }
+    m_filter_cache_order.push_back(filter_hash);
+    m_filter_cache_bytes += filter_bytes;
+    while (m_filter_cache_bytes > FILTER_CACHE_MAX_BYTES) {
+        auto it = m_filter_cache.find(m_filter_cache_order.front());
+        m_filter_cache_bytes -=
+            sizeof(BlockFilter) + it->second.GetEncodedFilter().size();
+        m_filter_cache.erase(it);
+        m_filter_cache_order.pop_front();
+    }
+}
+
 size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos &pos,
                                            const BlockFilter &filter) {
     assert(filter.GetFilterType() == GetFilterType());
@@ -229,13 +276,43 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos &pos,
     return data_size;
 }
 
+void BlockFilterIndex::PrepareBlock(const CBlock &block,
+                                    const CBlockIndex *pindex) {
+    // Building the filter only needs the block and its undo data, so it can be
+    // done for many blocks concurrently. Any failure is left to WriteBlock.
+    CBlockUndo block_undo;
+    if (pindex->nHeight > 0 &&
+        !m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+        return;
+    }
+    BlockFilter filter(m_filter_type, block, block_undo);
+
+    LOCK(m_prepared_mutex);
+    m_prepared.try_emplace(pindex->GetBlockHash(), pindex->nHeight,
+                           std::move(filter));
+}
+
 bool BlockFilterIndex::WriteBlock(const CBlock &block,
                                   const CBlockIndex *pindex) {
+    std::optional<BlockFilter> filter;
+    {
+        LOCK(m_prepared_mutex);
+        for (auto it = m_prepared.begin(); it != m_prepared.end();) {
+            if (it->first == pindex->GetBlockHash()) {
+                filter = std::move(it->second.second);
+            }
+            // The others at this height or below were for another chain.
+            it = it->second.first <= pindex->nHeight ? m_prepared.erase(it)
+                                                     : std::next(it);
+        }
+    }
+
     CBlockUndo block_undo;
     uint256 prev_header;
 
     if (pindex->nHeight > 0) {
-        if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+        if (!filter &&
+            !m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
             return false;
         }
 
@@ -255,17 +332,19 @@ bool BlockFilterIndex::WriteBlock(const CBlock &block,
         prev_header = read_out.second.header;
     }
 
-    BlockFilter filter(m_filter_type, block, block_undo);
+    if (!filter) {
+        filter.emplace(m_filter_type, block, block_undo);
+    }
 
-    size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
+    size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, *filter);
     if (bytes_written == 0) {
         return false;
     }
 
     std::pair<BlockHash, DBVal> value;
     value.first = pindex->GetBlockHash();
-    value.second.hash = filter.GetHash();
-    value.second.header = filter.ComputeHeader(prev_header);
+    value.second.hash = filter->GetHash();
+    value.second.header = filter->ComputeHeader(prev_header);
     value.second.pos = m_next_filter_pos;
 
     if (!m_db->Write(DBHeightKey(pindex->nHeight), value)) {
@@ -413,7 +492,14 @@ bool BlockFilterIndex::LookupFilter(const CBlockIndex *block_index,
         return false;
     }
 
-    return ReadFilterFromDisk(entry.pos, filter_out);
+    if (LookupCachedFilter(entry.hash, filter_out)) {
+        return true;
+    }
+    if (!ReadFilterFromDisk(entry.pos, filter_out)) {
+        return false;
+    }
+    CacheFilter(entry.hash, filter_out);
+    return true;
 }
 
 bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex *block_index,
@@ -455,12 +541,31 @@ bool BlockFilterIndex::LookupFilterRange(
     }
 
     filters_out.resize(entries.size());
-    auto filter_pos_it = filters_out.begin();
-    for (const auto &entry : entries) {
-        if (!ReadFilterFromDisk(entry.pos, *filter_pos_it)) {
+    // The filters of consecutive blocks are usually stored one after the
+    // other, so a file is kept open and only seeked when there is a gap.
+    std::optional<AutoFile> filein;
+    int file_num{-1};
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const DBVal &entry{entries[i]};
+        if (LookupCachedFilter(entry.hash, filters_out[i])) {
+            continue;
+        }
+
+        if (!filein || file_num != entry.pos.nFile) {
+            filein.emplace(m_filter_fileseq->Open(entry.pos, true));
+            if (filein->IsNull()) {
+                return false;
+            }
+            file_num = entry.pos.nFile;
+        } else if (std::ftell(filein->Get()) != long(entry.pos.nPos) &&
+                   std::fseek(filein->Get(), entry.pos.nPos, SEEK_SET) != 0) {
+            return false;
+        }
+
+        if (!ReadFilter(*filein, GetFilterType(), filters_out[i])) {
             return false;
         }
-        ++filter_pos_it;
+        CacheFilter(entry.hash, filters_out[i]);
     }
 
     return true;
@@ -11,6 +11,8 @@
 #include <index/base.h>
 #include <util/hasher.h>
 
+#include <deque>
+
 static const char *const DEFAULT_BLOCKFILTERINDEX = "0";
 
 /** Interval between compact filter checkpoints. See BIP 157. */
@@ -33,7 +35,8 @@ private:
     FlatFilePos m_next_filter_pos;
     std::unique_ptr<FlatFileSeq> m_filter_fileseq;
 
-    bool ReadFilterFromDisk(const FlatFilePos &pos, BlockFilter &filter) const;
+    bool ReadFilterFromDisk(const FlatFilePos &pos, BlockFilter &filter) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_filter_cache_mutex);
     size_t WriteFilterToDisk(FlatFilePos &pos, const BlockFilter &filter);
 
     Mutex m_cs_headers_cache;
@@ -44,6 +47,34 @@ private:
     std::unordered_map<BlockHash, uint256, FilterHeaderHasher>
         m_headers_cache GUARDED_BY(m_cs_headers_cache);
 
+    mutable Mutex m_filter_cache_mutex;
+    /**
+     * The filters served most recently, by filter hash, so that the filters
+     * near the tip requested by many light clients are only read from disk
+     * once. The hashes are also queued oldest first, to evict them when the
+     * cache grows over its memory limit.
+     */
+    mutable std::unordered_map<uint256, BlockFilter, SaltedUint256Hasher>
+        m_filter_cache GUARDED_BY(m_filter_cache_mutex);
+    mutable std::deque<uint256> m_filter_cache_order
+        GUARDED_BY(m_filter_cache_mutex);
+    mutable size_t m_filter_cache_bytes GUARDED_BY(m_filter_cache_mutex){0};
+
+    bool LookupCachedFilter(const uint256 &filter_hash,
+                            BlockFilter &filter_out) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_filter_cache_mutex);
+    void CacheFilter(const uint256 &filter_hash,
+                     const BlockFilter &filter) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_filter_cache_mutex);
+
+    Mutex m_prepared_mutex;
+    /**
+     * The filters built ahead of the sync, with the height of their block.
+     * There are only a few, for the blocks read ahead.
+     */
+    std::unordered_map<BlockHash, std::pair<int, BlockFilter>, BlockHasher>
+        m_prepared GUARDED_BY(m_prepared_mutex);
+
     bool AllowPrune() const override { return true; }
 
 protected:
@@ -51,7 +82,11 @@ protected:
 
     bool CommitInternal(CDBBatch &batch) override;
 
-    bool WriteBlock(const CBlock &block, const CBlockIndex *pindex) override;
+    bool WriteBlock(const CBlock &block, const CBlockIndex *pindex) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_mutex);
+
+    void PrepareBlock(const CBlock &block, const CBlockIndex *pindex) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_mutex);
 
     bool Rewind(const CBlockIndex *current_tip,
                 const CBlockIndex *new_tip) override;
@@ -69,7 +104,8 @@ public:
 
     /** Get a single filter by block. */
     bool LookupFilter(const CBlockIndex *block_index,
-                      BlockFilter &filter_out) const;
+                      BlockFilter &filter_out) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_filter_cache_mutex);
 
     /** Get a single filter header by block. */
     bool LookupFilterHeader(const CBlockIndex *block_index, uint256 &header_out)
@@ -77,7 +113,8 @@ public:
 
     /** Get a range of filters between two heights on a chain. */
     bool LookupFilterRange(int start_height, const CBlockIndex *stop_index,
-                           std::vector<BlockFilter> &filters_out) const;
+                           std::vector<BlockFilter> &filters_out) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_filter_cache_mutex);
 
     /** Get a range of filter hashes between two heights on a chain. */
     bool LookupFilterHashRange(int start_height, const CBlockIndex *stop_index,
@@ -17,6 +17,9 @@
 #include <undo.h>
 #include <util/check.h>
 #include <validation.h>
+#include <validationthreadpool.h>
+
+#include <optional>
 
 using kernel::CCoinsStats;
 using kernel::GetBogoSize;
@@ -97,6 +100,69 @@ struct DBHashKey {
     }
 };
 
+//! The number of transactions of a block hashed by a thread at a time.
+constexpr size_t MUHASH_CHUNK_TXS{32};
+
+// TODO: Deduplicate BIP30 related code
+bool IsBIP30Block(const CBlockIndex *pindex) {
+    return (pindex->nHeight == 91722 &&
+            pindex->GetBlockHash() ==
+                BlockHash{uint256S("0x00000000000271a2dc26e7667f8419f2e15416dc"
+                                   "6955e5a6c6cdf3f2574dd08e")}) ||
+           (pindex->nHeight == 91812 &&
+            pindex->GetBlockHash() ==
+                BlockHash{uint256S("0x00000000000af0aed4792b1acee3d966af36cf5d"
+                                   "ef14935db8de83d6f9306f2f")});
+}
+
+/**
+ * The change made by a block to the MuHash of the UTXO set: its spendable
+ * outputs are inserted and the coins it spends removed. As the updates can be
+ * done in any order, the transactions are hashed in parallel, into partial
+ * sets that are then combined with a couple of multiplications each.
+ */
+MuHash3072 BlockMuHash(const CBlock &block, const CBlockUndo &block_undo,
+                       const CBlockIndex *pindex) {
+    const bool is_bip30_block{IsBIP30Block(pindex)};
+    std::vector<MuHash3072> partial(
+        (block.vtx.size() + MUHASH_CHUNK_TXS - 1) / MUHASH_CHUNK_TXS);
+    GetValidationThreadPool().ParallelFor(partial.size(), [&](size_t chunk) {
+        MuHash3072 &muhash{partial[chunk]};
+        const size_t end{
+            std::min(block.vtx.size(), (chunk + 1) * MUHASH_CHUNK_TXS)};
+        for (size_t i = chunk * MUHASH_CHUNK_TXS; i < end; ++i) {
+            const auto &tx{block.vtx[i]};
+
+            // Skip duplicate txid coinbase transactions (BIP30).
+            if (!is_bip30_block || !tx->IsCoinBase()) {
+                for (uint32_t j = 0; j < tx->vout.size(); ++j) {
+                    Coin coin{tx->vout[j], uint32_t(pindex->nHeight),
+                              tx->IsCoinBase()};
+                    if (!coin.GetTxOut().scriptPubKey.IsUnspendable()) {
+                        muhash.Insert(MakeUCharSpan(
+                            TxOutSer(COutPoint{tx->GetId(), j}, coin)));
+                    }
+                }
+            }
+
+            // The coinbase tx has no undo data since no former output is spent
+            if (!tx->IsCoinBase()) {
+                const auto &tx_undo{block_undo.vtxundo.at(i - 1)};
+                for (size_t j = 0; j < tx_undo.vprevout.size(); ++j) {
+                    muhash.Remove(MakeUCharSpan(
+                        TxOutSer(tx->vin[j].prevout, tx_undo.vprevout[j])));
+                }
+            }
+        }
+    });
+
+    MuHash3072 muhash;
+    for (const MuHash3072 &chunk : partial) {
+        muhash *= chunk;
+    }
+    return muhash;
+}
+
 }; // namespace
 
 std::unique_ptr<CoinStatsIndex> g_coin_stats_index;
@@ -106,12 +172,42 @@ CoinStatsIndex::CoinStatsIndex(size_t n_cache_size, bool f_memory,
     fs::path path{gArgs.GetDataDirNet() / "indexes" / "coinstats"};
     fs::create_directories(path);
 
-    m_db = std::make_unique<CoinStatsIndex::DB>(path / "db", n_cache_size,
-                                                f_memory, f_wipe);
+    m_db = std::make_unique<CoinStatsIndex::DB>(
+        path / "db", "coinstatsindex", n_cache_size, f_memory, f_wipe);
+}
+
+void CoinStatsIndex::PrepareBlock(const CBlock &block,
+                                  const CBlockIndex *pindex) {
+    // Any failure is left to WriteBlock.
+    if (pindex->nHeight == 0) {
+        return;
+    }
+    PreparedBlock prepared;
+    if (!m_chainstate->m_blockman.UndoReadFromDisk(prepared.undo, *pindex)) {
+        return;
+    }
+    prepared.muhash = BlockMuHash(block, prepared.undo, pindex);
+
+    LOCK(m_prepared_mutex);
+    m_prepared.try_emplace(pindex->GetBlockHash(), pindex->nHeight,
+                           std::move(prepared));
 }
 
 bool CoinStatsIndex::WriteBlock(const CBlock &block,
                                 const CBlockIndex *pindex) {
+    std::optional<PreparedBlock> prepared;
+    {
+        LOCK(m_prepared_mutex);
+        for (auto it = m_prepared.begin(); it != m_prepared.end();) {
+            if (it->first == pindex->GetBlockHash()) {
+                prepared = std::move(it->second.second);
+            }
+            // The others at this height or below were for another chain.
+            it = it->second.first <= pindex->nHeight ? m_prepared.erase(it)
+                                                     : std::next(it);
+        }
+    }
+
     CBlockUndo block_undo;
     const Amount block_subsidy{GetBlockSubsidy(
         pindex->nHeight, Params().GetConsensus(), block.hashPrevBlock)};
@@ -119,8 +215,15 @@ bool CoinStatsIndex::WriteBlock(const CBlock &block,
 
     // Ignore genesis block
     if (pindex->nHeight > 0) {
-        if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
-            return false;
+        if (prepared) {
+            block_undo = std::move(prepared->undo);
+            m_muhash *= prepared->muhash;
+        } else {
+            if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo,
+                                                           *pindex)) {
+                return false;
+            }
+            m_muhash *= BlockMuHash(block, block_undo, pindex);
         }
 
         std::pair<BlockHash, DBVal> read_out;
@@ -141,16 +244,7 @@ bool CoinStatsIndex::WriteBlock(const CBlock &block,
             }
         }
 
-        // TODO: Deduplicate BIP30 related code
-        bool is_bip30_block{
-            (pindex->nHeight == 91722 &&
-             pindex->GetBlockHash() ==
-                 BlockHash{uint256S("0x00000000000271a2dc26e7667f8419f2e15416dc"
-                                    "6955e5a6c6cdf3f2574dd08e")}) ||
-            (pindex->nHeight == 91812 &&
-             pindex->GetBlockHash() ==
-                 BlockHash{uint256S("0x00000000000af0aed4792b1acee3d966af36cf5d"
-                                    "ef14935db8de83d6f9306f2f")})};
+        const bool is_bip30_block{IsBIP30Block(pindex)};
 
         // Add the new utxos created from the block
         for (size_t i = 0; i < block.vtx.size(); ++i) {
@@ -167,7 +261,6 @@ bool CoinStatsIndex::WriteBlock(const CBlock &block,
                 const CTxOut &out{tx->vout[j]};
                 Coin coin{out, static_cast<uint32_t>(pindex->nHeight),
                           tx->IsCoinBase()};
-                COutPoint outpoint{tx->GetId(), j};
 
                 // Skip unspendable coins
                 if (coin.GetTxOut().scriptPubKey.IsUnspendable()) {
@@ -176,8 +269,6 @@ bool CoinStatsIndex::WriteBlock(const CBlock &block,
                     continue;
                 }
 
-                m_muhash.Insert(MakeUCharSpan(TxOutSer(outpoint, coin)));
-
                 if (tx->IsCoinBase()) {
                     m_total_coinbase_amount += coin.GetTxOut().nValue;
                 } else {
@@ -195,11 +286,7 @@ bool CoinStatsIndex::WriteBlock(const CBlock &block,
                 const auto &tx_undo{block_undo.vtxundo.at(i - 1)};
 
                 for (size_t j = 0; j < tx_undo.vprevout.size(); ++j) {
-                    Coin coin{tx_undo.vprevout[j]};
-                    COutPoint outpoint{tx->vin[j].prevout.GetTxId(),
-                                       tx->vin[j].prevout.GetN()};
-
-                    m_muhash.Remove(MakeUCharSpan(TxOutSer(outpoint, coin)));
+                    const Coin &coin{tx_undo.vprevout[j]};
 
                     m_total_prevout_spent_amount += coin.GetTxOut().nValue;
 
@@ -10,6 +10,11 @@
 #include <flatfile.h>
 #include <index/base.h>
 #include <kernel/coinstats.h>
+#include <sync.h>
+#include <undo.h>
+#include <util/hasher.h>
+
+#include <unordered_map>
 
 struct Amount;
 
@@ -37,6 +42,18 @@ private:
     Amount m_total_unspendables_scripts{Amount::zero()};
     Amount m_total_unspendables_unclaimed_rewards{Amount::zero()};
 
+    //! The work done ahead of the sync for a block.
+    struct PreparedBlock {
+        CBlockUndo undo;
+        //! The change made by the block to the UTXO set hash.
+        MuHash3072 muhash;
+    };
+
+    Mutex m_prepared_mutex;
+    //! The blocks prepared ahead of the sync, with their height.
+    std::unordered_map<BlockHash, std::pair<int, PreparedBlock>, BlockHasher>
+        m_prepared GUARDED_BY(m_prepared_mutex);
+
     bool ReverseBlock(const CBlock &block, const CBlockIndex *pindex);
 
     bool AllowPrune() const override { return true; }
@@ -46,7 +63,11 @@ protected:
 
     bool CommitInternal(CDBBatch &batch) override;
 
-    bool WriteBlock(const CBlock &block, const CBlockIndex *pindex) override;
+    bool WriteBlock(const CBlock &block, const CBlockIndex *pindex) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_mutex);
+
+    void PrepareBlock(const CBlock &block, const CBlockIndex *pindex) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_prepared_mutex);
 
     bool Rewind(const CBlockIndex *current_tip,
                 const CBlockIndex *new_tip) override;
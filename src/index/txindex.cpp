@@ -9,10 +9,15 @@
 #include <index/disktxpos.h>
 #include <logging.h>
 #include <node/blockstorage.h>
+#include <sync.h>
 #include <validation.h>
 
 constexpr uint8_t DB_TXINDEX{'t'};
 
+//! How many transaction positions are queued before being written while
+//! syncing.
+static constexpr size_t SYNC_BATCH_TXS{1 << 16};
+
 std::unique_ptr<TxIndex> g_txindex;
 
 /** Access to the txindex database (indexes/txindex/) */
@@ -27,11 +32,25 @@ public:
 
     /// Write a batch of transaction positions to the DB.
     bool WriteTxs(const std::vector<std::pair<TxId, CDiskTxPos>> &v_pos);
+
+    /// Queue transaction positions, which are written once enough are queued
+    /// or along with the next commit.
+    bool QueueTxs(const std::vector<std::pair<TxId, CDiskTxPos>> &v_pos)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_queued_mutex);
+
+    /// Add the queued transaction positions to the batch.
+    void WriteQueuedTxs(CDBBatch &batch)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_queued_mutex);
+
+private:
+    Mutex m_queued_mutex;
+    std::vector<std::pair<TxId, CDiskTxPos>>
+        m_queued GUARDED_BY(m_queued_mutex);
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe)
-    : BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size,
-                    f_memory, f_wipe) {}
+    : BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", "txindex",
+                    n_cache_size, f_memory, f_wipe) {}
 
 bool TxIndex::DB::ReadTxPos(const TxId &txid, CDiskTxPos &pos) const {
     return Read(std::make_pair(DB_TXINDEX, txid), pos);
@@ -46,26 +65,75 @@ bool TxIndex::DB::WriteTxs(
     return WriteBatch(batch);
 }
 
+bool TxIndex::DB::QueueTxs(
+    const std::vector<std::pair<TxId, CDiskTxPos>> &v_pos) {
+    std::vector<std::pair<TxId, CDiskTxPos>> queued;
+    {
+        LOCK(m_queued_mutex);
+        m_queued.insert(m_queued.end(), v_pos.begin(), v_pos.end());
+        if (m_queued.size() < SYNC_BATCH_TXS) {
+            return true;
+        }
+        queued.swap(m_queued);
+    }
+    return WriteTxs(queued);
+}
+
+void TxIndex::DB::WriteQueuedTxs(CDBBatch &batch) {
+    LOCK(m_queued_mutex);
+    for (const auto &[txid, pos] : m_queued) {
+        batch.Write(std::make_pair(DB_TXINDEX, txid), pos);
+    }
+    m_queued.clear();
+}
+
 TxIndex::TxIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
     : m_db(std::make_unique<TxIndex::DB>(n_cache_size, f_memory, f_wipe)) {}
 
 TxIndex::~TxIndex() {}
 
-bool TxIndex::WriteBlock(const CBlock &block, const CBlockIndex *pindex) {
+static void AddTxPositions(const CBlock &block, const CBlockIndex *pindex,
+                           std::vector<std::pair<TxId, CDiskTxPos>> &vPos) {
     // Exclude genesis block transaction because outputs are not spendable.
     if (pindex->nHeight == 0) {
-        return true;
+        return;
     }
 
     CDiskTxPos pos(WITH_LOCK(::cs_main, return pindex->GetBlockPos()),
                    GetSizeOfCompactSize(block.vtx.size()));
-    std::vector<std::pair<TxId, CDiskTxPos>> vPos;
-    vPos.reserve(block.vtx.size());
+    vPos.reserve(vPos.size() + block.vtx.size());
     for (const auto &tx : block.vtx) {
         vPos.emplace_back(tx->GetId(), pos);
         pos.nTxOffset += ::GetSerializeSize(*tx, CLIENT_VERSION);
     }
-    return m_db->WriteTxs(vPos);
+}
+
+bool TxIndex::WriteBlock(const CBlock &block, const CBlockIndex *pindex) {
+    std::vector<std::pair<TxId, CDiskTxPos>> vPos;
+    AddTxPositions(block, pindex, vPos);
+    if (vPos.empty()) {
+        return true;
+    }
+    // While catching up, the positions of many blocks are written at once.
+    // They only need to be there when the locator moves past their blocks.
+    return IsSynced() ? m_db->WriteTxs(vPos) : m_db->QueueTxs(vPos);
+}
+
+bool TxIndex::WriteBlocks(const std::vector<ConnectedBlock> &blocks) {
+    // A single database write for the whole batch
+    std::vector<std::pair<TxId, CDiskTxPos>> vPos;
+    for (const ConnectedBlock &connected : blocks) {
+        AddTxPositions(*connected.block, connected.pindex, vPos);
+    }
+    return IsSynced() ? m_db->WriteTxs(vPos) : m_db->QueueTxs(vPos);
+}
+
+bool TxIndex::CommitInternal(CDBBatch &batch) {
+    if (!BaseIndex::CommitInternal(batch)) {
+        return false;
+    }
+    m_db->WriteQueuedTxs(batch);
+    return true;
 }
 
 BaseIndex::DB &TxIndex::GetDB() const {
@@ -79,21 +147,14 @@ bool TxIndex::FindTx(const TxId &txid, BlockHash &block_hash,
         return false;
     }
 
-    CAutoFile file(m_chainstate->m_blockman.OpenBlockFile(postx, true),
-                   SER_DISK, CLIENT_VERSION);
-    if (file.IsNull()) {
-        return error("%s: OpenBlockFile failed", __func__);
-    }
+    // The transaction is stored nTxOffset bytes after the block header.
     CBlockHeader header;
-    try {
-        file >> header;
-        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
-            return error("%s: fseek(...) failed", __func__);
-        }
-        file >> tx;
-    } catch (const std::exception &e) {
-        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    CMutableTransaction mtx;
+    if (!m_chainstate->m_blockman.ReadBlockTxFromDisk(header, mtx, postx,
+                                                      postx.nTxOffset)) {
+        return false;
     }
+    tx = MakeTransactionRef(std::move(mtx));
     if (tx->GetId() != txid) {
         return error("%s: txid mismatch", __func__);
     }
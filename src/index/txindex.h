@@ -31,6 +31,10 @@ private:
 protected:
     bool WriteBlock(const CBlock &block, const CBlockIndex *pindex) override;
 
+    bool WriteBlocks(const std::vector<ConnectedBlock> &blocks) override;
+
+    bool CommitInternal(CDBBatch &batch) override;
+
     BaseIndex::DB &GetDB() const override;
 
     const char *GetName() const override { return "txindex"; }
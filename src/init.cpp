@@ -27,6 +27,7 @@
 #include <config.h>
 #include <consensus/amount.h>
 #include <currencyunit.h>
+#include <dbwrapper.h>
 #include <flatfile.h>
 #include <hash.h>
 #include <httprpc.h>
@@ -43,12 +44,15 @@
 #include <net_permissions.h>
 #include <net_processing.h>
 #include <netbase.h>
+#include <netcompression.h>
+#include <node/blockcompression.h>
 #include <node/blockmanager_args.h>
 #include <node/blockstorage.h>
 #include <node/caches.h>
 #include <node/chainstate.h>
 #include <node/chainstatemanager_args.h>
 #include <node/context.h>
+#include <node/database_args.h>
 #include <node/kernel_notifications.h>
 #include <node/mempool_persist_args.h>
 #include <node/miner.h>
@@ -56,8 +60,10 @@
 #include <node/ui_interface.h>
 #include <node/validation_cache_args.h>
 #include <policy/block/rtt.h>
+#include <policy/fees.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
+#include <pow/powcache.h>
 #include <rpc/blockchain.h>
 #include <rpc/register.h>
 #include <rpc/server.h>
@@ -67,6 +73,7 @@
 #include <script/sigcache.h>
 #include <script/standard.h>
 #include <shutdown.h>
+#include <support/allocators/pool.h>
 #include <sync.h>
 #include <timedata.h>
 #include <torcontrol.h>
@@ -80,6 +87,7 @@
 #include <util/string.h>
 #include <util/syserror.h>
 #include <util/thread.h>
+#include <util/threadaffinity.h>
 #include <util/threadnames.h>
 #include <util/translation.h>
 #include <validation.h>
@@ -114,27 +122,41 @@
 #include <thread>
 #include <vector>
 
+using kernel::DEFAULT_BLOCK_COMPRESSION_LEVEL;
+using kernel::DEFAULT_BLOCK_FILE_MMAP;
+using kernel::DEFAULT_BLOCK_READ_HANDLES;
+using kernel::DEFAULT_BLOCK_WRITE_QUEUE_MB;
+using kernel::DEFAULT_CHECK_BLOCK_READ_POW;
+using kernel::DEFAULT_PRUNE_UNDO_DEPTH;
+using kernel::DEFAULT_REINDEX_READ_AHEAD;
 using kernel::DEFAULT_STOPAFTERBLOCKIMPORT;
 using kernel::DumpMempool;
 using kernel::ValidationCacheSizes;
 
 using node::ApplyArgsManOptions;
 using node::BlockManager;
+using node::BlockTemplateBuilder;
 using node::CacheSizes;
+using node::CBlockTemplate;
 using node::CalculateCacheSizes;
+using node::DEFAULT_BLOCK_TEMPLATE_REFRESH;
 using node::DEFAULT_PERSIST_MEMPOOL;
 using node::fReindex;
 using node::KernelNotifications;
 using node::LoadChainstate;
 using node::MempoolPath;
 using node::NodeContext;
+using node::ReadDatabaseArgs;
 using node::ShouldPersistMempool;
 using node::ThreadImport;
 using node::VerifyLoadedChainstate;
 
 static const bool DEFAULT_PROXYRANDOMIZE = true;
 static const bool DEFAULT_REST_ENABLE = false;
+static const bool DEFAULT_METRICS_ENABLE = false;
+static const bool DEFAULT_PROFILE_LOCK_CONTENTION = false;
 static constexpr bool DEFAULT_CHRONIK = false;
+static constexpr bool DEFAULT_HUGE_PAGES = false;
 
 #ifdef WIN32
 // Win32 LevelDB doesn't use filedescriptors, and the ones used for accessing
@@ -148,6 +170,8 @@ static const char *DEFAULT_ASMAP_FILENAME = "ip_asn.map";
 
 static const std::string HEADERS_TIME_FILE_NAME{"headerstime.dat"};
 
+static const char *FEE_ESTIMATES_FILENAME = "fee_estimates.dat";
+
 /**
  * The PID file facilities.
  */
@@ -242,6 +266,7 @@ void Shutdown(NodeContext &node) {
 
     StopHTTPRPC();
     StopREST();
+    StopHTTPMetrics();
     StopRPC();
     StopHTTPServer();
     for (const auto &client : node.chain_clients) {
@@ -263,6 +288,14 @@ void Shutdown(NodeContext &node) {
     // using the other before destroying them.
     if (node.peerman) {
         UnregisterValidationInterface(node.peerman.get());
+        node.peerman->StopTxValidation();
+        node.peerman->StopBlockConnection();
+    }
+    if (node.template_builder) {
+        UnregisterValidationInterface(node.template_builder.get());
+    }
+    if (node.fee_estimator) {
+        UnregisterValidationInterface(node.fee_estimator.get());
     }
     if (node.connman) {
         node.connman->Stop();
@@ -278,12 +311,12 @@ void Shutdown(NodeContext &node) {
     if (node.chainman && node.chainman->m_load_block.joinable()) {
         node.chainman->m_load_block.join();
     }
-    StopScriptCheckWorkerThreads();
-    StopPowCheckWorkerThreads();
+    StopValidationWorkerThreads();
 
     // After the threads that potentially access these pointers have been
     // stopped, destruct and reset all to nullptr.
     node.peerman.reset();
+    node.template_builder.reset();
 
     // Destroy various global instances
     node.avalanche.reset();
@@ -296,6 +329,19 @@ void Shutdown(NodeContext &node) {
         DumpMempool(*node.mempool, MempoolPath(*node.args));
     }
 
+    if (node.fee_estimator) {
+        CAutoFile est_fileout(
+            fsbridge::fopen(
+                node.args->GetDataDirNet() / FEE_ESTIMATES_FILENAME, "wb"),
+            SER_DISK, CLIENT_VERSION);
+        if (est_fileout.IsNull() || !node.fee_estimator->Write(est_fileout)) {
+            LogPrintf("Failed to write fee estimates to %s\n",
+                      fs::PathToString(node.args->GetDataDirNet() /
+                                       FEE_ESTIMATES_FILENAME));
+        }
+        node.fee_estimator.reset();
+    }
+
     // FlushStateToDisk generates a ChainStateFlushed callback, which we should
     // avoid missing
     if (node.chainman) {
@@ -377,6 +423,8 @@ void Shutdown(NodeContext &node) {
     }
 
     LogPrintf("%s: done\n", __func__);
+    // Write the last messages before exiting
+    LogInstance().StopAsyncLogging();
 }
 
 /**
@@ -551,6 +599,55 @@ void SetupServerArgs(NodeContext &node) {
         strprintf("Set database cache size in MiB (%d to %d, default: %d)",
                   MIN_DB_CACHE_MB, MAX_DB_CACHE_MB, DEFAULT_DB_CACHE_MB),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-hugepages",
+        strprintf("Back the coins cache, the block index and the mempool with "
+                  "transparent huge pages once they grow, which saves TLB "
+                  "misses with a large -dbcache. The kernel must allow them "
+                  "(madvise or always in "
+                  "/sys/kernel/mm/transparent_hugepage/enabled) (default: %d)",
+                  DEFAULT_HUGE_PAGES),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-threadaffinity=<thread>:<cpus>",
+        "Pin the threads named <thread> to the CPUs <cpus>, a list of CPU "
+        "numbers and ranges like 0-3,8. The numbered threads, like the script "
+        "check workers scriptch.<n> or the validation workers valcheck.<n>, "
+        "are matched by the name without their number. Memory is allocated "
+        "on the NUMA node of the thread first touching it, so pinning the "
+        "threads of a node also keeps their memory local. Can be specified "
+        "multiple times (Linux only)",
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-dbprofile=<[db:]profile>",
+        "Tune the LevelDB settings of the databases: default, ibd for the bulk "
+        "writes of the initial block download, or steady for the random "
+        "reads at the tip. This and the other -db* tuning options apply to "
+        "the database named by the prefix, one of blockfilterindex, "
+        "blockindex, chainstate, coinstatsindex or txindex, else to all of "
+        "them (default: default)",
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbwritebuffer=<[db:]n>",
+                   "Set the size of the LevelDB write buffers in MiB (1 to "
+                   "1024, default: derived from the cache size)",
+                   ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+                   OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbmaxfilesize=<[db:]n>",
+                   "Set the size of the LevelDB table files in MiB (1 to "
+                   "1024, default: set by the profile)",
+                   ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+                   OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbblocksize=<[db:]n>",
+                   "Set the size of the blocks LevelDB reads and caches the "
+                   "tables by in KiB (1 to 4096, default: set by the profile)",
+                   ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+                   OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbbloombits=<[db:]n>",
+                   "Set the bits per key of the LevelDB bloom filters, 0 to "
+                   "not use any (0 to 64, default: set by the profile)",
+                   ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+                   OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-includeconf=<file>",
         "Specify additional configuration file, relative to the -datadir path "
@@ -569,11 +666,41 @@ void SetupServerArgs(NodeContext &node) {
                              "memory (default: %u)",
                              DEFAULT_MAX_ORPHAN_TRANSACTIONS),
                    ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-txbatchsize=<n>",
+        strprintf("Validate up to <n> incoming transactions together, with "
+                  "their scripts checked in parallel, or each of them as it "
+                  "is received if 0 (default: %u)",
+                  DEFAULT_TX_BATCH_SIZE),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-txvalidationthread",
+        strprintf("Validate incoming transactions on a dedicated thread, "
+                  "serving the peers in turn, rather than on the message "
+                  "handler threads (default: %d)",
+                  DEFAULT_TX_VALIDATION_THREAD),
+        ArgsManager::ALLOW_BOOL | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-blockconnectthread",
+        strprintf("During the initial block download, connect the received "
+                  "blocks on a dedicated thread, so the message handler "
+                  "keeps downloading blocks meanwhile (default: %d)",
+                  DEFAULT_BLOCK_CONNECT_THREAD),
+        ArgsManager::ALLOW_BOOL | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::OPTIONS);
     argsman.AddArg("-mempoolexpiry=<n>",
                    strprintf("Do not keep transactions in the mempool longer "
                              "than <n> hours (default: %u)",
                              DEFAULT_MEMPOOL_EXPIRY_HOURS),
                    ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-mempooljournalsize=<n>",
+                   strprintf("Keep the last <n> additions and removals of "
+                             "mempool transactions, for getmempoolchanges "
+                             "(default: %u)",
+                             DEFAULT_MEMPOOL_JOURNAL_SIZE),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-minimumchainwork=<hex>",
         strprintf(
@@ -623,6 +750,17 @@ void SetupServerArgs(NodeContext &node) {
                   "target size in MiB)",
                   MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-pruneundo=<n>",
+        strprintf("Delete the undo data of the blocks buried more than <n> "
+                  "blocks deep, keeping the blocks themselves. The undo data "
+                  "still needed by -coinstatsindex and -blockfilterindex is "
+                  "kept. Reorganizations deeper than <n> blocks then require "
+                  "a -reindex. This mode is incompatible with -chronik. "
+                  "(default: %d = keep all the undo data, >=%u = depth in "
+                  "blocks)",
+                  DEFAULT_PRUNE_UNDO_DEPTH, MIN_BLOCKS_TO_KEEP),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-reindex-chainstate",
         "Rebuild chain state from the currently indexed blocks. When "
@@ -830,6 +968,13 @@ void SetupServerArgs(NodeContext &node) {
             "Maximum per-connection send buffer, <n>*1000 bytes (default: %u)",
             DEFAULT_MAXSENDBUFFER),
         ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg(
+        "-msghandlers=<n>",
+        strprintf("Number of threads processing peer messages, each peer being "
+                  "handled by one of them (1 to %d, default: %d)",
+                  MAX_MSGHANDLER_THREADS, DEFAULT_MSGHANDLER_THREADS),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::CONNECTION);
     argsman.AddArg(
         "-maxtimeadjustment",
         strprintf("Maximum allowed median peer time offset adjustment. Local "
@@ -867,6 +1012,12 @@ void SetupServerArgs(NodeContext &node) {
             "connections will still be made; use -noonion or -onion=0 to "
             "disable outbound onion connections in this case",
         ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg(
+        "-p2pcompression",
+        strprintf("Exchange zstd compressed messages with the peers that "
+                  "support it too (default: %d)",
+                  DEFAULT_P2P_COMPRESSION),
+        ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerbloomfilters",
                    strprintf("Support filtering of blocks and transaction with "
                              "bloom filters (default: %d)",
@@ -913,6 +1064,13 @@ void SetupServerArgs(NodeContext &node) {
         "Enable all P2P network activity (default: 1). Can be changed "
         "by the setnetworkactive RPC command",
         ArgsManager::ALLOW_BOOL, OptionsCategory::CONNECTION);
+    argsman.AddArg(
+        "-sockevents",
+        strprintf("Wait for socket events with epoll or kqueue where "
+                  "available, instead of polling all the sockets (default: %d)",
+                  DEFAULT_USE_SOCK_EVENTS),
+        ArgsManager::ALLOW_BOOL | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::CONNECTION);
     argsman.AddArg("-timeout=<n>",
                    strprintf("Specify connection timeout in milliseconds "
                              "(minimum: 1, default: %d)",
@@ -1006,6 +1164,10 @@ void SetupServerArgs(NodeContext &node) {
     argsman.AddArg("-zmqpubsequence=<address>",
                    "Enable publish hash block and tx sequence in <address>",
                    ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawblocktemplate=<address>",
+                   "Enable publish raw block template in <address>, requires "
+                   "-blocktemplaterefresh",
+                   ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg(
         "-zmqpubhashblockhwm=<n>",
         strprintf("Set publish hash block outbound message high water "
@@ -1035,17 +1197,46 @@ void SetupServerArgs(NodeContext &node) {
                              " (default: %d)",
                              CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM),
                    ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg(
+        "-zmqpubrawblocktemplatehwm=<n>",
+        strprintf("Set publish raw block template outbound message high "
+                  "water mark (default: %d)",
+                  CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM),
+        ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg(
+        "-zmqpubhashtxbatch=<n>",
+        strprintf("Send up to <n> queued hash transaction notifications in a "
+                  "single message (default: %d)",
+                  CZMQAbstractNotifier::DEFAULT_ZMQ_BATCH),
+        ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg(
+        "-zmqpubrawtxbatch=<n>",
+        strprintf("Send up to <n> queued raw transaction notifications in a "
+                  "single message (default: %d)",
+                  CZMQAbstractNotifier::DEFAULT_ZMQ_BATCH),
+        ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg(
+        "-zmqqueuesize=<n>",
+        strprintf("Maximum number of notifications waiting to be sent, the "
+                  "new ones are dropped beyond that (default: %u)",
+                  CZMQPublisher::DEFAULT_ZMQ_QUEUE_SIZE),
+        ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
     hidden_args.emplace_back("-zmqpubrawblock=<address>");
     hidden_args.emplace_back("-zmqpubrawtx=<address>");
     hidden_args.emplace_back("-zmqpubsequence=<n>");
+    hidden_args.emplace_back("-zmqpubrawblocktemplate=<address>");
     hidden_args.emplace_back("-zmqpubhashblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubhashtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubsequencehwm=<n>");
+    hidden_args.emplace_back("-zmqpubrawblocktemplatehwm=<n>");
+    hidden_args.emplace_back("-zmqpubhashtxbatch=<n>");
+    hidden_args.emplace_back("-zmqpubrawtxbatch=<n>");
+    hidden_args.emplace_back("-zmqqueuesize=<n>");
 #endif
 
     argsman.AddArg(
@@ -1082,6 +1273,87 @@ void SetupServerArgs(NodeContext &node) {
                   regtestChainParams->DefaultConsistencyChecks()),
         ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
         OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-checkqueueworkstealing",
+        strprintf("Let the script and proof of work verification threads "
+                  "steal work from a lock-free queue instead of sharing a "
+                  "locked one (default: %d)",
+                  DEFAULT_CHECKQUEUE_WORK_STEALING),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-utxoprefetchblocks=<n>",
+        strprintf("Read ahead from the UTXO database the inputs of up to <n> "
+                  "of the blocks queued for connection, 0 to disable "
+                  "(default: %d)",
+                  DEFAULT_UTXO_PREFETCH_BLOCKS),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-coinswriteback=<n>",
+        strprintf("When the coins cache is getting large, write back up to <n> "
+                  "MiB of its oldest changes at a time and keep it warm, "
+                  "rather than emptying it, 0 to disable (default: %d)",
+                  DEFAULT_COINS_WRITE_BACK_MB),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-coinsevict",
+        strprintf("When the coins cache is getting large, evict its least "
+                  "recently used coins that are not modified rather than "
+                  "emptying it (default: %d)",
+                  DEFAULT_COINS_EVICT),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-blockcompression=<level>",
+        strprintf("Store the new blocks zstd compressed at this level, 1 to "
+                  "%d, when that makes them smaller, 0 to store them as is. "
+                  "Compressed blocks can not be read by older versions "
+                  "(default: %d)",
+                  node::MAX_BLOCK_COMPRESSION_LEVEL,
+                  DEFAULT_BLOCK_COMPRESSION_LEVEL),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-blockfilemmap",
+        strprintf("Read the blocks and undo data by memory mapping the block "
+                  "files rather than through buffered reads (default: %d)",
+                  DEFAULT_BLOCK_FILE_MMAP),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-blockreadhandles=<n>",
+        strprintf("Number of block files, and of undo files, kept open for "
+                  "reading, 0 to open them for every read (default: %d)",
+                  DEFAULT_BLOCK_READ_HANDLES),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-blockwritequeue=<n>",
+        strprintf("Write the blocks and undo data to disk on background "
+                  "threads, queuing up to <n> MiB of each, 0 to write them "
+                  "synchronously (default: %d)",
+                  DEFAULT_BLOCK_WRITE_QUEUE_MB),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-reindexreadahead=<n>",
+        strprintf("During -reindex, read and check up to <n> block files on "
+                  "background threads ahead of the one being imported, each "
+                  "held in memory until it is imported, 0 to read them one at "
+                  "a time (0 to %d, default: %d)",
+                  node::MAX_REINDEX_READ_AHEAD, DEFAULT_REINDEX_READ_AHEAD),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-checkblockreadpow",
+        strprintf("Recheck the proof of work of every block read from disk, "
+                  "even if it was already checked when it was stored "
+                  "(default: %d)",
+                  DEFAULT_CHECK_BLOCK_READ_POW),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-checkpoints",
                    strprintf("Only accept block chain matching built-in "
                              "checkpoints (default: %d)",
@@ -1110,6 +1382,12 @@ void SetupServerArgs(NodeContext &node) {
     argsman.AddArg("-capturemessages", "Capture all P2P messages to disk",
                    ArgsManager::ALLOW_BOOL | ArgsManager::DEBUG_ONLY,
                    OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-profilelockcontention",
+                   strprintf("Record the time spent waiting for the "
+                             "contended locks, see getlockcontention "
+                             "(default: %d)",
+                             DEFAULT_PROFILE_LOCK_CONTENTION),
+                   ArgsManager::ALLOW_BOOL, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-mocktime=<n>",
                    "Replace actual time with " + UNIX_EPOCH_TIME +
                        " (default: 0)",
@@ -1127,6 +1405,12 @@ void SetupServerArgs(NodeContext &node) {
                   DEFAULT_MAX_SCRIPT_CACHE_BYTES >> 20),
         ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
         OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-maxpowcachesize=<n>",
+        strprintf("Limit size of proof of work cache to <n> MiB (default: %u)",
+                  DEFAULT_MAX_POW_CACHE_BYTES >> 20),
+        ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
+        OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-maxtipage=<n>",
                    strprintf("Maximum tip age in seconds to consider node in "
                              "initial block download (default: %u)",
@@ -1231,13 +1515,33 @@ void SetupServerArgs(NodeContext &node) {
                    "Override block version to test forking scenarios",
                    ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
                    OptionsCategory::BLOCK_CREATION);
+    argsman.AddArg(
+        "-blocktemplaterefresh=<ms>",
+        strprintf("Keep a block template ready for getblocktemplate, checking "
+                  "every <ms> milliseconds whether the tip or the mempool "
+                  "changed, 0 to disable (default: %d)",
+                  count_milliseconds(DEFAULT_BLOCK_TEMPLATE_REFRESH)),
+        ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
 
+    argsman.AddArg(
+        "-blockstatscache=<n>",
+        strprintf("Keep the statistics of the last <n> blocks queried by "
+                  "getblockstats and getblockstatsrange in memory, 0 to "
+                  "disable (default: %u)",
+                  DEFAULT_BLOCK_STATS_CACHE_SIZE),
+        ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-server", "Accept command line and JSON-RPC commands",
                    ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rest",
                    strprintf("Accept public REST requests (default: %d)",
                              DEFAULT_REST_ENABLE),
                    ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg("-metrics",
+                   strprintf("Serve the performance metrics to Prometheus on "
+                             "/metrics of the RPC port, without "
+                             "authentication (default: %d)",
+                             DEFAULT_METRICS_ENABLE),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg(
         "-rpcbind=<addr>[:port]",
         "Bind to given address to listen for JSON-RPC connections. Do not "
@@ -1249,6 +1553,18 @@ void SetupServerArgs(NodeContext &node) {
         ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY |
             ArgsManager::SENSITIVE,
         OptionsCategory::RPC);
+#ifndef WIN32
+    argsman.AddArg(
+        "-rpcunixsocket=<path>",
+        "Also listen for JSON-RPC connections on a unix domain socket at "
+        "<path>, only accessible to the user running the node. The requests "
+        "are authenticated as on the other RPC endpoints. Relative paths will "
+        "be prefixed by a net-specific datadir location (default: disabled)",
+        ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY,
+        OptionsCategory::RPC);
+#else
+    hidden_args.emplace_back("-rpcunixsocket");
+#endif
     argsman.AddArg(
         "-rpcdoccheck",
         strprintf("Throw a non-fatal error at runtime if the documentation for "
@@ -1309,7 +1625,8 @@ void SetupServerArgs(NodeContext &node) {
     argsman.AddArg(
         "-rpcthreads=<n>",
         strprintf(
-            "Set the number of threads to service RPC calls (default: %d)",
+            "Set the number of threads to service RPC calls, in addition to "
+            "the one dedicated to the mining calls (default: %d)",
             DEFAULT_HTTP_THREADS),
         ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg(
@@ -1317,9 +1634,23 @@ void SetupServerArgs(NodeContext &node) {
         "Domain from which to accept cross origin requests (browser enforced)",
         ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
 
+    argsman.AddArg(
+        "-rpcbatchthreads=<n>",
+        strprintf("Set the number of additional RPC threads the entries of a "
+                  "JSON-RPC batch can be executed on concurrently, 0 to "
+                  "execute them in order (default: %u)",
+                  DEFAULT_RPC_BATCH_THREADS),
+        ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg(
+        "-rpcbatchmaxsize=<n>",
+        strprintf("Set the maximum size of the reply to a JSON-RPC batch in "
+                  "megabytes, the entries executed past this size fail "
+                  "(default: %u)",
+                  DEFAULT_RPC_BATCH_MAX_SIZE),
+        ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcworkqueue=<n>",
                    strprintf("Set the depth of the work queue to service RPC "
-                             "calls (default: %d)",
+                             "calls, for each priority (default: %d)",
                              DEFAULT_HTTP_WORKQUEUE),
                    ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
                    OptionsCategory::RPC);
@@ -1413,6 +1744,20 @@ void SetupServerArgs(NodeContext &node) {
         strprintf("Avalanche query timeout in milliseconds (default: %u)",
                   AVALANCHE_DEFAULT_QUERY_TIMEOUT.count()),
         ArgsManager::ALLOW_ANY, OptionsCategory::AVALANCHE);
+    argsman.AddArg(
+        "-avaadaptivetimeout",
+        strprintf("Shorten the avalanche query timeout according to how fast "
+                  "the nodes respond, down to %u milliseconds (default: %u)",
+                  AVALANCHE_MIN_ADAPTIVE_QUERY_TIMEOUT.count(),
+                  AVALANCHE_DEFAULT_ADAPTIVE_QUERY_TIMEOUT),
+        ArgsManager::ALLOW_BOOL, OptionsCategory::AVALANCHE);
+    argsman.AddArg(
+        "-avamaxpollspertick",
+        strprintf("Maximum number of avalanche polls sent at once when there "
+                  "are more items to poll than a single poll can carry "
+                  "(default: %u)",
+                  AVALANCHE_DEFAULT_MAX_POLLS_PER_TICK),
+        ArgsManager::ALLOW_INT, OptionsCategory::AVALANCHE);
     argsman.AddArg(
         "-avadelegation",
         "Avalanche proof delegation to the master key used by this node "
@@ -1514,6 +1859,9 @@ static bool AppInitServers(Config &config,
     if (args.GetBoolArg("-rest", DEFAULT_REST_ENABLE)) {
         StartREST(&node);
     }
+    if (args.GetBoolArg("-metrics", DEFAULT_METRICS_ENABLE)) {
+        StartHTTPMetrics();
+    }
 
     StartHTTPServer();
     return true;
@@ -1812,6 +2160,12 @@ bool AppInitParameterInteraction(Config &config, const ArgsManager &args) {
         }
     }
 
+    // chronik references the undo data of all the blocks it indexed
+    if (args.GetIntArg("-pruneundo", DEFAULT_PRUNE_UNDO_DEPTH) &&
+        args.GetBoolArg("-chronik", DEFAULT_CHRONIK)) {
+        return InitError(_("-pruneundo is incompatible with -chronik."));
+    }
+
     // -bind and -whitebind can't be set when not listening
     size_t nUserBind =
         args.GetArgs("-bind").size() + args.GetArgs("-whitebind").size();
@@ -1895,6 +2249,9 @@ bool AppInitParameterInteraction(Config &config, const ArgsManager &args) {
                            "(excessiveblocksize)"));
     }
 
+    g_profile_lock_contention = args.GetBoolArg(
+        "-profilelockcontention", DEFAULT_PROFILE_LOCK_CONTENTION);
+
     nConnectTimeout = args.GetIntArg("-timeout", DEFAULT_CONNECT_TIMEOUT);
     if (nConnectTimeout <= 0) {
         nConnectTimeout = DEFAULT_CONNECT_TIMEOUT;
@@ -1907,6 +2264,13 @@ bool AppInitParameterInteraction(Config &config, const ArgsManager &args) {
             "peertimeout cannot be configured with a negative value."));
     }
 
+    const int64_t msghandlers{
+        args.GetIntArg("-msghandlers", DEFAULT_MSGHANDLER_THREADS)};
+    if (msghandlers < 1 || msghandlers > MAX_MSGHANDLER_THREADS) {
+        return InitError(Untranslated(strprintf(
+            "-msghandlers must be between 1 and %d.", MAX_MSGHANDLER_THREADS)));
+    }
+
     // Sanity check argument for min fee for including tx in block
     // TODO: Harmonize which arguments need sanity checking and where that
     // happens.
@@ -1930,10 +2294,38 @@ bool AppInitParameterInteraction(Config &config, const ArgsManager &args) {
     // Option to startup with mocktime set (used for regression testing):
     SetMockTime(args.GetIntArg("-mocktime", 0)); // SetMockTime(0) is a no-op
 
+    // Before the chainstate and the mempool allocate anything.
+    SetPoolHugePages(args.GetBoolArg("-hugepages", DEFAULT_HUGE_PAGES));
+
+    // Before the threads are started.
+    for (const std::string &rule : args.GetArgs("-threadaffinity")) {
+        if (!util::ThreadAffinitySupported()) {
+            return InitError(
+                _("-threadaffinity is not supported on this platform."));
+        }
+        const size_t colon{rule.find(':')};
+        std::string error;
+        if (colon == std::string::npos ||
+            !util::AddThreadAffinity(rule.substr(0, colon),
+                                     rule.substr(colon + 1), error)) {
+            return InitError(strprintf(
+                _("Invalid -threadaffinity=<thread>:<cpus> value: '%s'"),
+                rule));
+        }
+    }
+
     if (args.GetBoolArg("-peerbloomfilters", DEFAULT_PEERBLOOMFILTERS)) {
         nLocalServices = ServiceFlags(nLocalServices | NODE_BLOOM);
     }
 
+    if (args.GetBoolArg("-p2pcompression", DEFAULT_P2P_COMPRESSION)) {
+        if (!P2PCompressionSupported()) {
+            return InitError(
+                _("-p2pcompression is not supported by this build."));
+        }
+        nLocalServices = ServiceFlags(nLocalServices | NODE_P2P_COMPRESSION);
+    }
+
     if (args.IsArgSet("-proxy") && args.GetArg("-proxy", "").empty()) {
         return InitError(_(
             "No proxy server specified. Use -proxy=<ip> or -proxy=<ip:port>."));
@@ -2012,6 +2404,15 @@ bool AppInitParameterInteraction(Config &config, const ArgsManager &args) {
         if (const auto error{ApplyArgsManOptions(args, blockman_opts_dummy)}) {
             return InitError(*error);
         }
+        // The index databases read their options when they are opened.
+        for (const char *name : {"blockfilterindex", "coinstatsindex",
+                                 "txindex"}) {
+            DBOptions db_options_dummy;
+            if (const auto error{
+                    ReadDatabaseArgs(args, db_options_dummy, name)}) {
+                return InitError(*error);
+            }
+        }
     }
 
     return true;
@@ -2124,6 +2525,12 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
             args.GetIntArg("-maxscriptcachesize",
                            DEFAULT_MAX_SCRIPT_CACHE_BYTES >> 20)));
     }
+    if (!InitPowCache(validation_cache_sizes.pow_cache_bytes)) {
+        return InitError(strprintf(
+            _("Unable to allocate memory for -maxpowcachesize: '%s' MiB"),
+            args.GetIntArg("-maxpowcachesize",
+                           DEFAULT_MAX_POW_CACHE_BYTES >> 20)));
+    }
 
     int script_threads = args.GetIntArg("-par", DEFAULT_SCRIPTCHECK_THREADS);
     if (script_threads <= 0) {
@@ -2139,20 +2546,19 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
     // Number of script-checking threads <= MAX_SCRIPTCHECK_THREADS
     script_threads = std::min(script_threads, MAX_SCRIPTCHECK_THREADS);
 
-    LogPrintf("Script verification uses %d additional threads\n",
-              script_threads);
+    const bool work_stealing = args.GetBoolArg(
+        "-checkqueueworkstealing", DEFAULT_CHECKQUEUE_WORK_STEALING);
+    LogPrintf("Script and PoW verification share %d additional threads%s\n",
+              script_threads, work_stealing ? " (work stealing)" : "");
     if (script_threads >= 1) {
-        StartScriptCheckWorkerThreads(script_threads);
-        StartPowCheckWorkerThreads(script_threads);
+        StartValidationWorkerThreads(script_threads, work_stealing);
     }
 
     assert(!node.scheduler);
     node.scheduler = std::make_unique<CScheduler>();
 
-    // Start the lightweight task scheduler thread
-    node.scheduler->m_service_thread =
-        std::thread(&util::TraceThread, "scheduler",
-                    [&] { node.scheduler->serviceQueue(); });
+    // Start the lightweight task scheduler threads
+    node.scheduler->StartServiceThreads();
 
     // Gather some entropy once per minute.
     node.scheduler->scheduleEvery(
@@ -2373,9 +2779,10 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
 
 #if ENABLE_ZMQ
     g_zmq_notification_interface = CZMQNotificationInterface::Create(
-        [&chainman = node.chainman](CBlock &block, const CBlockIndex &index) {
+        [&chainman = node.chainman](std::vector<uint8_t> &block,
+                                    const CBlockIndex &index) {
             assert(chainman);
-            return chainman->m_blockman.ReadBlockFromDisk(block, index);
+            return chainman->m_blockman.ReadRawBlockFromDisk(block, index);
         });
 
     if (g_zmq_notification_interface) {
@@ -2584,6 +2991,21 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
                                      node.avalanche.get(), peerman_opts);
     RegisterValidationInterface(node.peerman.get());
 
+    assert(!node.fee_estimator);
+    node.fee_estimator = std::make_unique<FeeRateEstimator>(
+        WITH_LOCK(cs_main, return chainman.ActiveHeight()));
+    {
+        CAutoFile est_filein(
+            fsbridge::fopen(args.GetDataDirNet() / FEE_ESTIMATES_FILENAME,
+                            "rb"),
+            SER_DISK, CLIENT_VERSION);
+        // Allowed to fail as this file IS missing on first startup.
+        if (!est_filein.IsNull()) {
+            node.fee_estimator->Read(est_filein);
+        }
+    }
+    RegisterValidationInterface(node.fee_estimator.get());
+
     // Encoded addresses using cashaddr instead of base58.
     // We don't this by default because Dogecoin uses base58 with a custom
     // prefix, so ambiguity with BTC addresses is avoided.
@@ -2794,6 +3216,10 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         1024 * 1024 *
         args.GetIntArg("-maxuploadtarget", DEFAULT_MAX_UPLOAD_TARGET);
     connOptions.m_peer_connect_timeout = peer_connect_timeout;
+    connOptions.m_msghandler_threads =
+        args.GetIntArg("-msghandlers", DEFAULT_MSGHANDLER_THREADS);
+    connOptions.m_use_sock_events =
+        args.GetBoolArg("-sockevents", DEFAULT_USE_SOCK_EVENTS);
     connOptions.whitelist_forcerelay =
         args.GetBoolArg("-whitelistforcerelay", DEFAULT_WHITELISTFORCERELAY);
     connOptions.whitelist_relay =
@@ -2959,7 +3385,7 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
             banman->DumpBanlist();
             return true;
         },
-        DUMP_BANS_INTERVAL);
+        DUMP_BANS_INTERVAL, CScheduler::Priority::LOW);
 
     // Start Avalanche's event loop.
     if (node.avalanche) {
@@ -2970,6 +3396,34 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         node.peerman->StartScheduledTasks(*node.scheduler);
     }
 
+    const std::chrono::milliseconds template_refresh{
+        args.GetIntArg("-blocktemplaterefresh",
+                       count_milliseconds(DEFAULT_BLOCK_TEMPLATE_REFRESH))};
+    if (template_refresh > 0ms && node.mempool) {
+        BlockTemplateBuilder::UpdatedFn on_updated;
+#if ENABLE_ZMQ
+        if (g_zmq_notification_interface) {
+            // Both the scheduled refresh and the validation interface run on
+            // the scheduler thread, which ZMQ publishes from.
+            on_updated = [](const CBlockTemplate &block_template) {
+                g_zmq_notification_interface->BlockTemplateUpdated(
+                    block_template.block);
+            };
+        }
+#endif
+        node.template_builder = std::make_unique<BlockTemplateBuilder>(
+            config, chainman, *node.mempool, node.avalanche.get(),
+            std::move(on_updated));
+        RegisterValidationInterface(node.template_builder.get());
+        BlockTemplateBuilder *template_builder = node.template_builder.get();
+        node.scheduler->scheduleEvery(
+            [template_builder] {
+                template_builder->Update();
+                return true;
+            },
+            template_refresh);
+    }
+
 #if HAVE_SYSTEM
     StartupNotify(args);
 #endif
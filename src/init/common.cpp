@@ -17,9 +17,11 @@
 #include <pubkey.h>
 #include <random.h>
 #include <util/fs_helpers.h>
+#include <util/strencodings.h>
 #include <util/time.h>
 #include <util/translation.h>
 
+#include <algorithm>
 #include <memory>
 
 using node::DEFAULT_PRINTPRIORITY;
@@ -87,6 +89,19 @@ void AddLoggingArgs(ArgsManager &argsman) {
             "except the specified category. This option can be specified "
             "multiple times to exclude multiple categories."),
         ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-debugratelimit=<[category:]n>",
+        "Log at most n messages per second from each place of the code "
+        "logging for the debug category, or for all the categories if none is "
+        "given. The number of suppressed messages is logged with the next "
+        "message. This option can be specified multiple times.",
+        ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-debugsample=<[category:]n>",
+        "Log only 1 in n messages from each place of the code logging for the "
+        "debug category, or for all the categories if none is given. This "
+        "option can be specified multiple times.",
+        ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg(
         "-logips",
         strprintf("Include IP addresses in debug output (default: %u)",
@@ -115,6 +130,28 @@ void AddLoggingArgs(ArgsManager &argsman) {
             "(source file, line number and function name) (default: %u)",
             DEFAULT_LOGSOURCELOCATIONS),
         ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-logjson",
+        strprintf("Write each debug output message as a JSON object on a "
+                  "line, with its time, thread, category, level and source "
+                  "location (default: %u)",
+                  DEFAULT_LOGJSON),
+        ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-logasync",
+        strprintf("Write the debug output from a background thread. The debug "
+                  "messages are dropped, and counted, when a thread logs more "
+                  "than -logasyncbuffer messages faster than they are written. "
+                  "The messages logged right before a crash can be lost "
+                  "(default: %u)",
+                  DEFAULT_LOGASYNC),
+        ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-logasyncbuffer=<n>",
+        strprintf("Number of messages each thread can queue with -logasync "
+                  "(default: %u)",
+                  DEFAULT_LOGASYNC_BUFFER),
+        ArgsManager::ALLOW_INT, OptionsCategory::DEBUG_TEST);
     argsman.AddArg(
         "-logtimemicros",
         strprintf("Add microsecond precision to debug timestamps (default: %u)",
@@ -154,10 +191,25 @@ void SetLoggingOptions(const ArgsManager &args) {
 #endif
     LogInstance().m_log_sourcelocations =
         args.GetBoolArg("-logsourcelocations", DEFAULT_LOGSOURCELOCATIONS);
+    LogInstance().m_log_json = args.GetBoolArg("-logjson", DEFAULT_LOGJSON);
 
     fLogIPs = args.GetBoolArg("-logips", DEFAULT_LOGIPS);
 }
 
+/** Parse a [category:]n limit, where no category means all of them. */
+static bool ParseCategoryLimit(const std::string &str, uint32_t &categories,
+                               uint32_t &n) {
+    const size_t colon = str.rfind(':');
+    BCLog::LogFlags flag = BCLog::ALL;
+    if (colon != std::string::npos &&
+        !GetLogCategory(flag, str.substr(0, colon))) {
+        return false;
+    }
+    categories = flag;
+    return ParseUInt32(colon == std::string::npos ? str : str.substr(colon + 1),
+                       &n);
+}
+
 void SetLoggingCategories(const ArgsManager &args) {
     if (args.IsArgSet("-debug")) {
         // Special-case: if -debug=0/-nodebug is set, turn off debugging
@@ -184,6 +236,25 @@ void SetLoggingCategories(const ArgsManager &args) {
                                   "-debugexclude", cat));
         }
     }
+
+    for (const std::string &limit : args.GetArgs("-debugratelimit")) {
+        uint32_t categories, per_second;
+        if (!ParseCategoryLimit(limit, categories, per_second)) {
+            InitWarning(strprintf(_("Invalid logging limit %s=%s."),
+                                  "-debugratelimit", limit));
+            continue;
+        }
+        LogInstance().SetRateLimit(categories, per_second);
+    }
+    for (const std::string &sample : args.GetArgs("-debugsample")) {
+        uint32_t categories, n;
+        if (!ParseCategoryLimit(sample, categories, n)) {
+            InitWarning(strprintf(_("Invalid logging limit %s=%s."),
+                                  "-debugsample", sample));
+            continue;
+        }
+        LogInstance().SetSampling(categories, n);
+    }
 }
 
 bool StartLogging(const ArgsManager &args) {
@@ -204,6 +275,11 @@ bool StartLogging(const ArgsManager &args) {
                       fs::PathToString(logger.m_file_path)));
     }
 
+    if (args.GetBoolArg("-logasync", DEFAULT_LOGASYNC)) {
+        logger.StartAsyncLogging(std::max<int64_t>(
+            1, args.GetIntArg("-logasyncbuffer", DEFAULT_LOGASYNC_BUFFER)));
+    }
+
     if (!logger.m_log_timestamps) {
         LogPrintf("Startup time: %s\n", FormatISO8601DateTime(GetTime()));
     }
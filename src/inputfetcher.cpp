@@ -0,0 +1,298 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <inputfetcher.h>
+
+#include <primitives/block.h>
+#include <txdb.h>
+#include <util/hasher.h>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <unordered_set>
+
+void InputFetcher::StartWorkerPool(ValidationThreadPool &pool,
+                                   ValidationThreadPool::Priority priority) {
+    assert(m_pool == nullptr);
+    m_pool = &pool;
+    pool.AddWorkSource(priority, [this]() { return TryRunBatch(); });
+}
+
+void InputFetcher::Start(const CBlock &block, const CCoinsViewCache &cache,
+                         const CCoinsView &db) {
+    assert(!m_active);
+    if (m_pool == nullptr || m_pool->Size() == 0) {
+        return;
+    }
+
+    // The outputs created by the block itself are not in the database.
+    std::unordered_set<TxId, SaltedTxIdHasher> txids;
+    txids.reserve(block.vtx.size());
+    for (const auto &ptx : block.vtx) {
+        txids.insert(ptx->GetId());
+    }
+
+    m_tx_end.reserve(block.vtx.size());
+    for (const auto &ptx : block.vtx) {
+        if (!ptx->IsCoinBase()) {
+            for (const CTxIn &txin : ptx->vin) {
+                if (txids.count(txin.prevout.GetTxId()) == 0 &&
+                    !cache.HaveCoinInCache(txin.prevout)) {
+                    m_outpoints.push_back(txin.prevout);
+                }
+            }
+        }
+        m_tx_end.push_back(m_outpoints.size());
+    }
+
+    if (m_outpoints.empty()) {
+        m_tx_end.clear();
+        return;
+    }
+
+    m_coins.resize(m_outpoints.size());
+    m_inserted = 0;
+    {
+        LOCK(m_mutex);
+        m_db = &db;
+        m_num_batches = (m_outpoints.size() + BATCH_SIZE - 1) / BATCH_SIZE;
+        m_next_batch = 0;
+        m_batch_done.assign(m_num_batches, false);
+        m_active = true;
+    }
+    m_pool->Notify();
+}
+
+std::optional<size_t> InputFetcher::ClaimBatch() {
+    if (!m_active || m_next_batch >= m_num_batches) {
+        return std::nullopt;
+    }
+    ++m_running;
+    return m_next_batch++;
+}
+
+void InputFetcher::RunBatch(size_t batch, const CCoinsView &db) {
+    const size_t end = std::min((batch + 1) * BATCH_SIZE, m_outpoints.size());
+    for (size_t i = batch * BATCH_SIZE; i < end; ++i) {
+        Coin coin;
+        try {
+            if (db.GetCoin(m_outpoints[i], coin)) {
+                m_coins[i] = std::move(coin);
+            }
+        } catch (const std::runtime_error &) {
+            // Leave this one to the connecting thread, whose read goes through
+            // the error handling of the coins views.
+        }
+    }
+
+    LOCK(m_mutex);
+    m_batch_done[batch] = true;
+    --m_running;
+    // Notify while holding the lock, as the fetcher may be destroyed as soon
+    // as the last running batch is done.
+    m_cv.notify_all();
+}
+
+bool InputFetcher::TryRunBatch() {
+    if (!m_active.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    std::optional<size_t> batch;
+    const CCoinsView *db;
+    {
+        LOCK(m_mutex);
+        batch = ClaimBatch();
+        db = m_db;
+    }
+    if (!batch) {
+        return false;
+    }
+    RunBatch(*batch, *db);
+    return true;
+}
+
+void InputFetcher::FetchInputs(size_t tx_index, CCoinsViewCache &cache) {
+    if (tx_index >= m_tx_end.size()) {
+        // Nothing is being fetched.
+        return;
+    }
+
+    const size_t needed = (m_tx_end[tx_index] + BATCH_SIZE - 1) / BATCH_SIZE;
+    while (m_inserted < needed) {
+        // Wait for the batch, or read it here if no worker claimed it yet.
+        while (true) {
+            std::optional<size_t> batch;
+            const CCoinsView *db;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                if (m_batch_done[m_inserted]) {
+                    break;
+                }
+                batch = ClaimBatch();
+                if (!batch) {
+                    m_cv.wait(lock);
+                    continue;
+                }
+                db = m_db;
+            }
+            RunBatch(*batch, *db);
+        }
+
+        const size_t end =
+            std::min((m_inserted + 1) * BATCH_SIZE, m_outpoints.size());
+        for (size_t i = m_inserted * BATCH_SIZE; i < end; ++i) {
+            if (m_coins[i]) {
+                cache.EmplaceFetchedCoin(m_outpoints[i],
+                                         std::move(*m_coins[i]));
+            }
+        }
+        ++m_inserted;
+    }
+}
+
+void InputFetcher::Stop() {
+    if (!m_active) {
+        return;
+    }
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_active = false;
+        while (m_running > 0) {
+            m_cv.wait(lock);
+        }
+        m_db = nullptr;
+        m_num_batches = 0;
+        m_next_batch = 0;
+        m_batch_done.clear();
+    }
+    m_outpoints.clear();
+    m_coins.clear();
+    m_tx_end.clear();
+    m_inserted = 0;
+}
+
+CoinsPrefetcher::CoinsPrefetcher() : m_state(std::make_shared<State>()) {}
+
+void CoinsPrefetcher::Prefetch(const BlockHash &hash, int height,
+                               ReadBlockFn read_block, const CCoinsViewDB &db,
+                               ValidationThreadPool &pool) {
+    if (pool.Size() == 0) {
+        // The block would be read synchronously.
+        return;
+    }
+    uint64_t generation;
+    {
+        LOCK(m_state->mutex);
+        auto [it, inserted] = m_state->results.try_emplace(hash);
+        if (!inserted) {
+            return;
+        }
+        it->second.height = height;
+        generation = m_state->generation;
+    }
+    pool.Submit([state = m_state, generation, hash,
+                 read_block = std::move(read_block), &db]() {
+        Run(*state, generation, hash, read_block, db);
+    });
+}
+
+void CoinsPrefetcher::Run(State &state, uint64_t generation,
+                          const BlockHash &hash, const ReadBlockFn &read_block,
+                          const CCoinsViewDB &db) {
+    {
+        LOCK(state.mutex);
+        if (generation != state.generation) {
+            // Stopped since, the database may be gone.
+            return;
+        }
+        ++state.running;
+    }
+
+    const uint64_t epoch = db.GetWriteEpoch();
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    CBlock block;
+    if (epoch % 2 == 0 && read_block(block)) {
+        // The outputs created by the block itself are not in the database.
+        std::unordered_set<TxId, SaltedTxIdHasher> txids;
+        txids.reserve(block.vtx.size());
+        for (const auto &ptx : block.vtx) {
+            txids.insert(ptx->GetId());
+        }
+
+        std::vector<COutPoint> outpoints;
+        for (const auto &ptx : block.vtx) {
+            if (ptx->IsCoinBase()) {
+                continue;
+            }
+            for (const CTxIn &txin : ptx->vin) {
+                if (txids.count(txin.prevout.GetTxId()) == 0) {
+                    outpoints.push_back(txin.prevout);
+                }
+            }
+        }
+        // Read in key order, which is friendlier to the database.
+        std::sort(outpoints.begin(), outpoints.end());
+
+        coins.reserve(outpoints.size());
+        try {
+            for (const COutPoint &outpoint : outpoints) {
+                Coin coin;
+                if (db.GetCoin(outpoint, coin)) {
+                    coins.emplace_back(outpoint, std::move(coin));
+                }
+            }
+        } catch (const std::runtime_error &) {
+            // Leave the remaining coins to the connecting thread.
+        }
+    }
+    const bool valid = epoch % 2 == 0 && db.GetWriteEpoch() == epoch;
+
+    LOCK(state.mutex);
+    auto it = state.results.find(hash);
+    if (it != state.results.end()) {
+        it->second.done = true;
+        if (valid) {
+            it->second.epoch = epoch;
+            it->second.coins = std::move(coins);
+        }
+    }
+    --state.running;
+    state.cv.notify_all();
+}
+
+size_t CoinsPrefetcher::Apply(const BlockHash &hash, int height,
+                              CCoinsViewCache &cache, const CCoinsViewDB &db) {
+    std::optional<Result> result;
+    {
+        LOCK(m_state->mutex);
+        for (auto it = m_state->results.begin();
+             it != m_state->results.end();) {
+            if (it->first == hash) {
+                result = std::move(it->second);
+            }
+            // Blocks at this height or below are either connected or not
+            // going to be soon.
+            it = it->second.height <= height ? m_state->results.erase(it)
+                                             : std::next(it);
+        }
+    }
+
+    if (!result || !result->done || result->epoch != db.GetWriteEpoch()) {
+        return 0;
+    }
+    for (auto &[outpoint, coin] : result->coins) {
+        cache.EmplaceFetchedCoin(outpoint, std::move(coin));
+    }
+    return result->coins.size();
+}
+
+void CoinsPrefetcher::Stop() {
+    WAIT_LOCK(m_state->mutex, lock);
+    ++m_state->generation;
+    while (m_state->running > 0) {
+        m_state->cv.wait(lock);
+    }
+    m_state->results.clear();
+}
@@ -0,0 +1,227 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INPUTFETCHER_H
+#define BITCOIN_INPUTFETCHER_H
+
+#include <coins.h>
+#include <primitives/blockhash.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <threadsafety.h>
+#include <validationthreadpool.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+class CBlock;
+class CCoinsViewDB;
+
+/**
+ * Reads the coins spent by a block from the UTXO database on the validation
+ * worker threads, ahead of the connection of the block.
+ *
+ * When the coins cache is cold, connecting a block is dominated by the random
+ * database reads of its inputs, which the connecting thread would otherwise
+ * issue one at a time as it walks the transactions. The inputs missing from
+ * the cache are instead split into small batches, read in order by the
+ * workers, and inserted in the cache by the connecting thread right before
+ * the transaction spending them is connected. The reads then overlap with
+ * each other and with the script checks of the previous transactions.
+ *
+ * Only one block is fetched at a time, by the thread that started it.
+ */
+class InputFetcher {
+public:
+    //! The number of inputs read by a worker in one go.
+    static constexpr size_t BATCH_SIZE{8};
+
+    InputFetcher() = default;
+    InputFetcher(const InputFetcher &) = delete;
+    InputFetcher &operator=(const InputFetcher &) = delete;
+
+    /**
+     * Start fetching the inputs of the block that are missing from the cache.
+     * The db must be the view backing the cache, and must be safe to read
+     * from multiple threads while the cache is in use. This does nothing if
+     * there is no worker thread to do the reads.
+     */
+    void Start(const CBlock &block, const CCoinsViewCache &cache,
+               const CCoinsView &db) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Make sure the fetched inputs of the tx_index-th transaction of the block
+     * are in the cache, reading the ones no worker got to yet.
+     */
+    void FetchInputs(size_t tx_index, CCoinsViewCache &cache)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Stop fetching, and wait for the workers to be done with the block. This
+     * must be called before the cache is modified by anything else than
+     * FetchInputs() and the connection of the block.
+     */
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Read one batch of inputs, returning whether there was one. */
+    bool TryRunBatch() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Run the reads on the shared validation thread pool, which must not be
+    //! running yet.
+    void StartWorkerPool(ValidationThreadPool &pool,
+                         ValidationThreadPool::Priority priority);
+
+    //! Stop using the shared pool, which must have been stopped already.
+    void StopWorkerPool() { m_pool = nullptr; }
+
+private:
+    Mutex m_mutex;
+
+    //! The connecting thread waits on this for a batch being read.
+    std::condition_variable m_cv;
+
+    ValidationThreadPool *m_pool{nullptr};
+
+    //! Whether a block is being fetched, so idle workers can bail out without
+    //! taking the lock.
+    std::atomic<bool> m_active{false};
+
+    const CCoinsView *m_db GUARDED_BY(m_mutex){nullptr};
+
+    //! The outpoints to read and the coins read, in the order they are spent
+    //! in the block. Each batch of coins is only touched by the thread that
+    //! claimed it until it is marked done.
+    std::vector<COutPoint> m_outpoints;
+    std::vector<std::optional<Coin>> m_coins;
+
+    //! For each transaction, the index in m_outpoints past its last input.
+    std::vector<size_t> m_tx_end;
+
+    size_t m_num_batches GUARDED_BY(m_mutex){0};
+    size_t m_next_batch GUARDED_BY(m_mutex){0};
+    std::vector<bool> m_batch_done GUARDED_BY(m_mutex);
+
+    //! The number of batches being read.
+    int m_running GUARDED_BY(m_mutex){0};
+
+    //! The number of batches already inserted in the cache. Connecting thread
+    //! only.
+    size_t m_inserted{0};
+
+    /** Claim the next batch to be read, if any. */
+    std::optional<size_t> ClaimBatch() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    /** Read a batch claimed by this thread, then mark it done. */
+    void RunBatch(size_t batch, const CCoinsView &db)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/**
+ * RAII-style controller object for an InputFetcher that guarantees the
+ * fetching of a block is stopped before it goes out of scope.
+ */
+class InputFetcherControl {
+private:
+    InputFetcher &m_fetcher;
+
+public:
+    InputFetcherControl(InputFetcher &fetcher, const CBlock &block,
+                        const CCoinsViewCache &cache, const CCoinsView &db)
+        : m_fetcher(fetcher) {
+        m_fetcher.Start(block, cache, db);
+    }
+
+    InputFetcherControl(const InputFetcherControl &) = delete;
+    InputFetcherControl &operator=(const InputFetcherControl &) = delete;
+
+    void FetchInputs(size_t tx_index, CCoinsViewCache &cache) {
+        m_fetcher.FetchInputs(tx_index, cache);
+    }
+
+    ~InputFetcherControl() { m_fetcher.Stop(); }
+};
+
+/**
+ * Reads ahead the coins spent by the next blocks to be connected, as
+ * background tasks of the validation thread pool.
+ *
+ * While a block is being connected, the following ones usually are already on
+ * disk. Their inputs are read from the UTXO database by the idle workers, and
+ * inserted in the coins cache right before their block gets connected, so
+ * the connecting thread rarely has to wait for the disk.
+ *
+ * The reads are not synchronized with the connection of the blocks, so the
+ * coins read are only used if the database was not written to since, and
+ * never replace an entry of the cache. The cache then stays consistent with
+ * the database it is backed by.
+ *
+ * Not thread safe, except for the background tasks themselves.
+ */
+class CoinsPrefetcher {
+public:
+    using ReadBlockFn = std::function<bool(CBlock &)>;
+
+    CoinsPrefetcher();
+    CoinsPrefetcher(const CoinsPrefetcher &) = delete;
+    CoinsPrefetcher &operator=(const CoinsPrefetcher &) = delete;
+    ~CoinsPrefetcher() { Stop(); }
+
+    /**
+     * Read ahead the coins spent by a block, unless it is already being read.
+     * The block is read with read_block, and its inputs from db, both from the
+     * pool's threads. If the pool has no thread, nothing is read.
+     */
+    void Prefetch(const BlockHash &hash, int height, ReadBlockFn read_block,
+                  const CCoinsViewDB &db, ValidationThreadPool &pool);
+
+    /**
+     * Insert the coins read ahead for a block about to be connected in the
+     * cache, which must be directly backed by db, and forget about the blocks
+     * at the same height or below. Coins still being read are dropped. Return
+     * the number of coins inserted.
+     */
+    size_t Apply(const BlockHash &hash, int height, CCoinsViewCache &cache,
+                 const CCoinsViewDB &db);
+
+    /**
+     * Cancel the pending reads and wait for the running ones, after which the
+     * database and the block reading function can safely go away.
+     */
+    void Stop();
+
+private:
+    struct Result {
+        int height;
+        bool done{false};
+        //! The write epoch of the database the coins were read at.
+        uint64_t epoch{0};
+        std::vector<std::pair<COutPoint, Coin>> coins;
+    };
+
+    //! Shared with the background tasks, which may still be queued after the
+    //! prefetcher is gone.
+    struct State {
+        Mutex mutex;
+        std::condition_variable cv;
+        //! Incremented by Stop(), so the queued tasks become no-ops.
+        uint64_t generation GUARDED_BY(mutex){0};
+        int running GUARDED_BY(mutex){0};
+        std::map<BlockHash, Result> results GUARDED_BY(mutex);
+    };
+
+    const std::shared_ptr<State> m_state;
+
+    static void Run(State &state, uint64_t generation, const BlockHash &hash,
+                    const ReadBlockFn &read_block, const CCoinsViewDB &db);
+};
+
+#endif // BITCOIN_INPUTFETCHER_H
@@ -5,6 +5,7 @@
 #ifndef BITCOIN_INTERFACES_CHAIN_H
 #define BITCOIN_INTERFACES_CHAIN_H
 
+#include <blockfilter.h>
 #include <primitives/transaction.h>
 #include <primitives/txid.h>
 #include <util/settings.h> // For util::SettingsValue
@@ -150,6 +151,27 @@ public:
     virtual bool findBlock(const BlockHash &hash,
                            const FoundBlock &block = {}) = 0;
 
+    //! Look up several blocks as findBlock does, but locking cs_main only
+    //! once. Return how many of them the node has.
+    virtual size_t
+    findBlocks(const std::vector<std::pair<BlockHash, FoundBlock>> &blocks) = 0;
+
+    //! Return the hashes of up to count blocks following the given one on the
+    //! active chain, or none if it isn't on the active chain.
+    virtual std::vector<BlockHash> findNextBlocks(const BlockHash &hash,
+                                                  size_t count) = 0;
+
+    //! Return whether a block filter index of the given type is enabled.
+    virtual bool hasBlockFilterIndex(BlockFilterType filter_type) = 0;
+
+    //! Return whether any of the elements match the filter of the block, or
+    //! std::nullopt if the filter isn't available (e.g. the index is still
+    //! syncing).
+    virtual std::optional<bool>
+    blockFilterMatchesAny(BlockFilterType filter_type,
+                          const BlockHash &block_hash,
+                          const GCSFilter::ElementSet &filter_set) = 0;
+
     //! Find first block in the chain with timestamp >= the given time
     //! and height >= than the given height, return false if there is no block
     //! with a high enough timestamp and height. Optionally return block
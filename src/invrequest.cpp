@@ -62,6 +62,9 @@ enum class State : uint8_t {
 //! Type alias for sequence numbers.
 using SequenceNumber = uint64_t;
 
+//! Type alias for priorities.
+using Priority = uint64_t;
+
 /**
  * An announcement. This is the data we track for each invid that is announced
  * to us by each peer.
@@ -76,6 +79,11 @@ struct Announcement {
     std::chrono::microseconds m_time;
     /** What peer the request was from. */
     const NodeId m_peer;
+    /**
+     * The priority of the announcement, see PriorityComputer. It is computed
+     * once rather than every time it is compared in the ByInvId index.
+     */
+    const Priority m_priority;
     /** What sequence number this announcement has. */
     const SequenceNumber m_sequence : 60;
     /** Whether the request is preferred. */
@@ -124,15 +132,13 @@ struct Announcement {
      * CANDIDATE_DELAYED state.
      */
     Announcement(const uint256 &invid, NodeId peer, bool preferred,
-                 std::chrono::microseconds reqtime, SequenceNumber sequence)
-        : m_invid(invid), m_time(reqtime), m_peer(peer), m_sequence(sequence),
-          m_preferred(preferred),
+                 std::chrono::microseconds reqtime, SequenceNumber sequence,
+                 Priority priority)
+        : m_invid(invid), m_time(reqtime), m_peer(peer), m_priority(priority),
+          m_sequence(sequence), m_preferred(preferred),
           m_state(static_cast<uint8_t>(State::CANDIDATE_DELAYED)) {}
 };
 
-//! Type alias for priorities.
-using Priority = uint64_t;
-
 /**
  * A functor with embedded salt that computes priority of an announcement.
  *
@@ -198,16 +204,11 @@ struct ByPeerViewExtractor {
 //   exist, so the COMPLETED ones can be deleted.
 struct ByInvId {};
 using ByInvIdView = std::tuple<const uint256 &, State, Priority>;
-class ByInvIdViewExtractor {
-    const PriorityComputer &m_computer;
-
-public:
-    explicit ByInvIdViewExtractor(const PriorityComputer &computer)
-        : m_computer(computer) {}
+struct ByInvIdViewExtractor {
     using result_type = ByInvIdView;
     result_type operator()(const Announcement &ann) const {
         const Priority prio =
-            (ann.GetState() == State::CANDIDATE_READY) ? m_computer(ann) : 0;
+            (ann.GetState() == State::CANDIDATE_READY) ? ann.m_priority : 0;
         return ByInvIdView{ann.m_invid, ann.GetState(), prio};
     }
 };
@@ -328,6 +329,7 @@ ComputeInvIdInfo(const Index &index, const PriorityComputer &computer) {
     std::map<uint256, InvIdInfo> ret;
     for (const Announcement &ann : index) {
         InvIdInfo &info = ret[ann.m_invid];
+        assert(ann.m_priority == computer(ann));
         // Classify how many announcements of each state we have for this invid.
         info.m_candidate_delayed +=
             (ann.GetState() == State::CANDIDATE_DELAYED);
@@ -478,8 +480,8 @@ private:
                 ann.SetState(State::CANDIDATE_BEST);
             });
         } else if (it_next->GetState() == State::CANDIDATE_BEST) {
-            Priority priority_old = m_computer(*it_next);
-            Priority priority_new = m_computer(*it);
+            Priority priority_old = it_next->m_priority;
+            Priority priority_new = it->m_priority;
             if (priority_new > priority_old) {
                 // There is a CANDIDATE_BEST announcement already, but this one
                 // is better.
@@ -621,15 +623,7 @@ private:
 
 public:
     explicit InvRequestTrackerImpl(bool deterministic)
-        : m_computer(deterministic),
-          // Explicitly initialize m_index as we need to pass a reference to
-          // m_computer to ByInvIdViewExtractor.
-          m_index(boost::make_tuple(
-              boost::make_tuple(ByPeerViewExtractor(), std::less<ByPeerView>()),
-              boost::make_tuple(ByInvIdViewExtractor(m_computer),
-                                std::less<ByInvIdView>()),
-              boost::make_tuple(ByTimeViewExtractor(),
-                                std::less<ByTimeView>()))) {}
+        : m_computer(deterministic) {}
 
     // Disable copying and assigning (a default copy won't work due the stateful
     // ByInvIdViewExtractor).
@@ -703,8 +697,9 @@ public:
         // will fail due to the uniqueness of the ByPeer index if a
         // non-CANDIDATE_BEST announcement already exists with the same invid
         // and peer). Bail out in that case.
-        auto ret = m_index.get<ByPeer>().emplace(invid, peer, preferred,
-                                                 reqtime, m_current_sequence);
+        auto ret = m_index.get<ByPeer>().emplace(
+            invid, peer, preferred, reqtime, m_current_sequence,
+            m_computer(invid, peer, preferred));
         if (!ret.second) {
             return;
         }
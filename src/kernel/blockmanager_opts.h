@@ -14,6 +14,13 @@ class CChainParams;
 namespace kernel {
 
 static constexpr bool DEFAULT_STOPAFTERBLOCKIMPORT{false};
+static constexpr bool DEFAULT_CHECK_BLOCK_READ_POW{false};
+static constexpr bool DEFAULT_BLOCK_FILE_MMAP{false};
+static constexpr int64_t DEFAULT_BLOCK_READ_HANDLES{8};
+static constexpr int64_t DEFAULT_BLOCK_WRITE_QUEUE_MB{0};
+static constexpr int64_t DEFAULT_BLOCK_COMPRESSION_LEVEL{0};
+static constexpr int64_t DEFAULT_PRUNE_UNDO_DEPTH{0};
+static constexpr int64_t DEFAULT_REINDEX_READ_AHEAD{2};
 
 /**
  * An options struct for `BlockManager`, more ergonomically referred to as
@@ -22,8 +29,27 @@ static constexpr bool DEFAULT_STOPAFTERBLOCKIMPORT{false};
 struct BlockManagerOpts {
     const CChainParams &chainparams;
     uint64_t prune_target{0};
+    //! If not 0, the undo data of the blocks buried deeper than this is
+    //! deleted, unless an index still needs it. The blocks are kept.
+    int prune_undo_depth{DEFAULT_PRUNE_UNDO_DEPTH};
     bool fast_prune{false};
     bool stop_after_block_import{DEFAULT_STOPAFTERBLOCKIMPORT};
+    //! Recompute the (aux)PoW of blocks read from disk even if it was already
+    //! checked when the block was stored.
+    bool check_block_read_pow{DEFAULT_CHECK_BLOCK_READ_POW};
+    //! Read the blocks and undo data through memory mappings of their files.
+    bool block_file_mmap{DEFAULT_BLOCK_FILE_MMAP};
+    //! The number of block files, and of undo files, kept open for reading.
+    size_t block_read_handles{DEFAULT_BLOCK_READ_HANDLES};
+    //! If not 0, write the blocks and undo data on background threads, with
+    //! up to this many bytes queued for each.
+    size_t block_write_queue_bytes{DEFAULT_BLOCK_WRITE_QUEUE_MB << 20};
+    //! If not 0, the zstd level at which the new blocks are compressed.
+    int block_compression_level{DEFAULT_BLOCK_COMPRESSION_LEVEL};
+    //! The number of block files read and checked on background threads
+    //! during -reindex, ahead of the one being imported. If 0, the files are
+    //! read while they are imported.
+    int reindex_read_ahead{DEFAULT_REINDEX_READ_AHEAD};
     const fs::path blocks_dir;
 };
 
@@ -22,6 +22,9 @@ class Config;
 static constexpr bool DEFAULT_CHECKPOINTS_ENABLED{true};
 static constexpr auto DEFAULT_MAX_TIP_AGE{24h};
 static constexpr bool DEFAULT_STORE_RECENT_HEADERS_TIME{false};
+static constexpr int DEFAULT_UTXO_PREFETCH_BLOCKS{4};
+static constexpr int64_t DEFAULT_COINS_WRITE_BACK_MB{0};
+static constexpr bool DEFAULT_COINS_EVICT{false};
 
 namespace kernel {
 
@@ -54,6 +57,19 @@ struct ChainstateManagerOpts {
     //! If set, store and load the last few block headers reception time to
     //! speed up RTT bootstraping
     bool store_recent_headers_time{DEFAULT_STORE_RECENT_HEADERS_TIME};
+
+    //! How many of the blocks queued for connection get their inputs read
+    //! ahead from the UTXO database, 0 to disable.
+    int utxo_prefetch_blocks{DEFAULT_UTXO_PREFETCH_BLOCKS};
+
+    //! If non-zero, the coins cache getting large has up to this many bytes
+    //! of its oldest changes written back at a time, and is only emptied when
+    //! it is over its limit.
+    size_t coins_write_back_bytes{DEFAULT_COINS_WRITE_BACK_MB << 20};
+
+    //! If set, the coins cache getting large has its least recently used
+    //! coins that are not modified evicted rather than being emptied.
+    bool coins_evict{DEFAULT_COINS_EVICT};
 };
 
 } // namespace kernel
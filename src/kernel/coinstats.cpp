@@ -12,8 +12,15 @@
 #include <serialize.h>
 #include <util/check.h>
 #include <validation.h>
+#include <validationthreadpool.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <exception>
 #include <map>
+#include <memory>
+#include <optional>
+#include <vector>
 
 namespace kernel {
 CCoinsStats::CCoinsStats(int block_height, const BlockHash &block_hash)
@@ -45,7 +52,8 @@ CDataStream TxOutSer(const COutPoint &outpoint, const Coin &coin) {
 //! It is also possible, though very unlikely, that a change in this
 //! construction could cause a previously invalid (and potentially malicious)
 //! UTXO snapshot to be considered valid.
-static void ApplyHash(HashWriter &ss, const TxId &txid,
+template <typename Stream>
+static void ApplyHash(Stream &ss, const TxId &txid,
                       const std::map<uint32_t, Coin> &outputs) {
     for (auto it = outputs.begin(); it != outputs.end(); ++it) {
         if (it == outputs.begin()) {
@@ -87,38 +95,96 @@ static void ApplyStats(CCoinsStats &stats, const TxId &txid,
     }
 }
 
+//! The part of the hash computed by a shard of the coins: the serialized
+//! outputs for the legacy hash, which is only computed in key order.
+template <typename T> struct ShardHash { using type = CDataStream; };
+template <> struct ShardHash<MuHash3072> { using type = MuHash3072; };
+template <> struct ShardHash<std::nullptr_t> { using type = std::nullptr_t; };
+
+static CDataStream NewShardHash(const HashWriter &) {
+    return CDataStream(SER_GETHASH, 0);
+}
+static MuHash3072 NewShardHash(const MuHash3072 &) {
+    return MuHash3072();
+}
+static std::nullptr_t NewShardHash(std::nullptr_t) {
+    return nullptr;
+}
+
+static void CombineHash(HashWriter &ss, const CDataStream &shard) {
+    ss.write(MakeByteSpan(shard));
+}
+static void CombineHash(MuHash3072 &muhash, const MuHash3072 &shard) {
+    muhash *= shard;
+}
+static void CombineHash(std::nullptr_t, std::nullptr_t) {}
+
+static void CombineStats(CCoinsStats &stats, const CCoinsStats &shard) {
+    stats.nTransactions += shard.nTransactions;
+    stats.nTransactionOutputs += shard.nTransactionOutputs;
+    stats.nTotalAmount += shard.nTotalAmount;
+    stats.nBogoSize += shard.nBogoSize;
+    stats.coins_count += shard.coins_count;
+}
+
 //! Calculate statistics about the unspent transaction output set
 template <typename T>
-static bool ComputeUTXOStats(CCoinsView *view, CCoinsStats &stats, T hash_obj,
-                             const std::function<void()> &interruption_point) {
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
-    assert(pcursor);
+static bool
+ComputeUTXOStats(CCoinsView *view, CCoinsStats &stats, T hash_obj,
+                 std::vector<std::unique_ptr<CCoinsViewCursor>> &cursors,
+                 const std::function<void()> &interruption_point) {
+    assert(!cursors.empty());
 
     PrepareHash(hash_obj, stats);
 
-    TxId prevkey;
-    std::map<uint32_t, Coin> outputs;
-    while (pcursor->Valid()) {
-        interruption_point();
-        COutPoint key;
-        Coin coin;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            if (!outputs.empty() && key.GetTxId() != prevkey) {
-                ApplyStats(stats, prevkey, outputs);
-                ApplyHash(hash_obj, prevkey, outputs);
-                outputs.clear();
+    struct Shard {
+        CCoinsStats stats;
+        typename ShardHash<T>::type hash;
+        bool success{true};
+    };
+    std::vector<std::optional<Shard>> shards(cursors.size());
+    bool success = true;
+    ScanCoinsSharded(
+        cursors,
+        [&](size_t i, CCoinsViewCursor &cursor) {
+            Shard &shard = shards[i].emplace(
+                Shard{CCoinsStats{}, NewShardHash(hash_obj)});
+            TxId prevkey;
+            std::map<uint32_t, Coin> outputs;
+            while (cursor.Valid()) {
+                if (interruption_point) {
+                    interruption_point();
+                }
+                COutPoint key;
+                Coin coin;
+                if (!cursor.GetKey(key) || !cursor.GetValue(coin)) {
+                    shard.success = false;
+                    return;
+                }
+                if (!outputs.empty() && key.GetTxId() != prevkey) {
+                    ApplyStats(shard.stats, prevkey, outputs);
+                    ApplyHash(shard.hash, prevkey, outputs);
+                    outputs.clear();
+                }
+                prevkey = key.GetTxId();
+                outputs[key.GetN()] = std::move(coin);
+                shard.stats.coins_count++;
+                cursor.Next();
             }
-            prevkey = key.GetTxId();
-            outputs[key.GetN()] = std::move(coin);
-            stats.coins_count++;
-        } else {
-            return error("%s: unable to read value", __func__);
-        }
-        pcursor->Next();
-    }
-    if (!outputs.empty()) {
-        ApplyStats(stats, prevkey, outputs);
-        ApplyHash(hash_obj, prevkey, outputs);
+            if (!outputs.empty()) {
+                ApplyStats(shard.stats, prevkey, outputs);
+                ApplyHash(shard.hash, prevkey, outputs);
+            }
+        },
+        [&](size_t i) {
+            // Fold the shards in key order, releasing their memory.
+            success = success && shards[i]->success;
+            CombineStats(stats, shards[i]->stats);
+            CombineHash(hash_obj, shards[i]->hash);
+            shards[i].reset();
+        });
+    if (!success) {
+        return error("%s: unable to read value", __func__);
     }
 
     FinalizeHash(hash_obj, stats);
@@ -128,27 +194,74 @@ static bool ComputeUTXOStats(CCoinsView *view, CCoinsStats &stats, T hash_obj,
     return true;
 }
 
+void ScanCoinsSharded(
+    std::vector<std::unique_ptr<CCoinsViewCursor>> &cursors,
+    const std::function<void(size_t shard, CCoinsViewCursor &cursor)> &process,
+    const std::function<void(size_t shard)> &finish) {
+    ValidationThreadPool &pool = GetValidationThreadPool();
+    // Only process as many shards as there are threads ahead of the ones
+    // finished, so the results in flight stay a small part of the UTXO set.
+    const size_t wave_size = pool.Size() + 1;
+    std::vector<std::exception_ptr> errors(cursors.size());
+    for (size_t first = 0; first < cursors.size(); first += wave_size) {
+        const size_t count{std::min(wave_size, cursors.size() - first)};
+        pool.ParallelFor(count, [&](size_t i) {
+            const size_t shard{first + i};
+            try {
+                process(shard, *cursors[shard]);
+            } catch (...) {
+                // The pool threads must not throw.
+                errors[shard] = std::current_exception();
+            }
+            cursors[shard].reset();
+        });
+        for (size_t shard = first; shard < first + count; ++shard) {
+            if (errors[shard]) {
+                std::rethrow_exception(errors[shard]);
+            }
+        }
+        for (size_t shard = first; shard < first + count; ++shard) {
+            finish(shard);
+        }
+    }
+}
+
 std::optional<CCoinsStats>
 ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView *view,
                  node::BlockManager &blockman,
                  const std::function<void()> &interruption_point) {
-    CBlockIndex *pindex = WITH_LOCK(
-        ::cs_main, return blockman.LookupBlockIndex(view->GetBestBlock()));
-    CCoinsStats stats{Assert(pindex)->nHeight, pindex->GetBlockHash()};
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    const CBlockIndex *pindex;
+    {
+        LOCK(::cs_main);
+        cursors = view->ShardedCursors(COINS_SCAN_SHARDS);
+        pindex = blockman.LookupBlockIndex(view->GetBestBlock());
+    }
+    return ComputeUTXOStats(hash_type, view, *Assert(pindex),
+                            std::move(cursors), interruption_point);
+}
+
+std::optional<CCoinsStats>
+ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView *view,
+                 const CBlockIndex &pindex,
+                 std::vector<std::unique_ptr<CCoinsViewCursor>> cursors,
+                 const std::function<void()> &interruption_point) {
+    CCoinsStats stats{pindex.nHeight, pindex.GetBlockHash()};
 
     bool success = [&]() -> bool {
         switch (hash_type) {
             case (CoinStatsHashType::HASH_SERIALIZED): {
                 HashWriter ss{};
-                return ComputeUTXOStats(view, stats, ss, interruption_point);
+                return ComputeUTXOStats(view, stats, ss, cursors,
+                                        interruption_point);
             }
             case (CoinStatsHashType::MUHASH): {
                 MuHash3072 muhash;
-                return ComputeUTXOStats(view, stats, muhash,
+                return ComputeUTXOStats(view, stats, muhash, cursors,
                                         interruption_point);
             }
             case (CoinStatsHashType::NONE): {
-                return ComputeUTXOStats(view, stats, nullptr,
+                return ComputeUTXOStats(view, stats, nullptr, cursors,
                                         interruption_point);
             }
         } // no default case, so the compiler can warn about missing cases
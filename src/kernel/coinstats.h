@@ -11,8 +11,12 @@
 #include <streams.h>
 #include <uint256.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
 
 class CCoinsView;
 namespace node {
@@ -73,6 +77,22 @@ struct CCoinsStats {
     CCoinsStats(int block_height, const BlockHash &block_hash);
 };
 
+//! The number of key ranges the UTXO set is split into for a full scan.
+static constexpr size_t COINS_SCAN_SHARDS{256};
+
+/**
+ * Scan the UTXO set using cursors over consecutive key ranges, as returned by
+ * CCoinsView::ShardedCursors(). process(shard, cursor) is called for each of
+ * them on the validation thread pool, then finish(shard) on the calling
+ * thread in key order. Only about as many shards as there are threads are
+ * processed ahead of the last finished one, so the memory used by their
+ * results stays bounded. Exceptions thrown by process are rethrown.
+ */
+void ScanCoinsSharded(
+    std::vector<std::unique_ptr<CCoinsViewCursor>> &cursors,
+    const std::function<void(size_t shard, CCoinsViewCursor &cursor)> &process,
+    const std::function<void(size_t shard)> &finish);
+
 uint64_t GetBogoSize(const CScript &script_pub_key);
 
 CDataStream TxOutSer(const COutPoint &outpoint, const Coin &coin);
@@ -81,6 +101,18 @@ std::optional<CCoinsStats>
 ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView *view,
                  node::BlockManager &blockman,
                  const std::function<void()> &interruption_point = {});
+
+/**
+ * Compute the statistics of the UTXO set at pindex from cursors returned by
+ * view->ShardedCursors(). The cursors read from a database snapshot, so they
+ * can be taken together with pindex under cs_main and then iterated without
+ * holding it while the chainstate moves on.
+ */
+std::optional<CCoinsStats>
+ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView *view,
+                 const CBlockIndex &pindex,
+                 std::vector<std::unique_ptr<CCoinsViewCursor>> cursors,
+                 const std::function<void()> &interruption_point = {});
 } // namespace kernel
 
 #endif // BITCOIN_KERNEL_COINSTATS_H
@@ -57,7 +57,7 @@ void DisconnectedBlockTransactions::importMempool(CTxMemPool &pool) {
         // children first.
         GetMainSignals().TransactionRemovedFromMempool(
             e->GetSharedTx(), MemPoolRemovalReason::REORG,
-            pool.GetAndIncrementSequence());
+            pool.RecordChange(e->GetTx().GetId(), MemPoolRemovalReason::REORG));
     }
     pool.clear();
 
@@ -152,19 +152,23 @@ void DisconnectedBlockTransactions::removeForBlock(
 
     addForBlock(vtx, pool);
 
+    // The block txs in the mempool are removed all at once, which updates the
+    // links between the entries and their in-mempool parents and children
+    // only once. Removing the conflicts of the other txs meanwhile leaves the
+    // staged entries alone: the block would be invalid if they overlapped.
+    CTxMemPool::setEntries stage;
     for (const CTransactionRef &tx :
          reverse_iterate(queuedTx.get<insertion_order>())) {
         CTxMemPool::txiter it = pool.mapTx.find(tx->GetId());
         if (it != pool.mapTx.end()) {
-            CTxMemPool::setEntries stage;
             stage.insert(it);
-            pool.RemoveStaged(stage, MemPoolRemovalReason::BLOCK);
         } else {
             // Conflicting txs can only exist if the tx was not in the mempool
             pool.removeConflicts(*tx);
         }
         pool.ClearPrioritisation(tx->GetId());
     }
+    pool.RemoveStaged(stage, MemPoolRemovalReason::BLOCK);
 
     pool.updateFeeForBlock();
 
@@ -183,11 +187,20 @@ void DisconnectedBlockTransactions::updateMempoolForReorg(
         // Iterate disconnectpool in reverse, so that we add transactions back
         // to the mempool starting with the earliest transaction that had been
         // previously seen in a block.
+        std::vector<CTransactionRef> txs;
+        txs.reserve(queuedTx.size());
         for (const CTransactionRef &tx :
              reverse_iterate(queuedTx.get<insertion_order>())) {
-            if (tx->IsCoinBase()) {
-                continue;
+            if (!tx->IsCoinBase()) {
+                txs.push_back(tx);
             }
+        }
+
+        // Verify all the signatures in parallel up front, so that they hit the
+        // signature cache when the transactions are accepted one at a time.
+        PrecheckTransactionScriptsLocked(active_chainstate, pool, txs);
+
+        for (const CTransactionRef &tx : txs) {
             // restore saved PrioritiseTransaction state and nAcceptTime
             const auto ptxInfo = getTxInfo(tx);
             bool hasFeeDelta = false;
@@ -94,6 +94,9 @@ private:
     //! Used for determining the priority of the transaction for mining in a
     //! block
     Amount feeDelta{Amount::zero()};
+    //! Cached, it is the key of the mempool's feerate index and comparing
+    //! entries would otherwise divide twice
+    CFeeRate m_modified_feerate;
     //! Track the height and time at which tx was final
     LockPoints lockPoints;
 
@@ -104,7 +107,8 @@ public:
                     unsigned int entry_height, int64_t sigchecks, LockPoints lp)
         : tx{_tx}, nFee{fee}, nTxSize(tx->GetTotalSize()),
           nUsageSize{RecursiveDynamicUsage(tx)}, nTime(time),
-          entryHeight{entry_height}, sigChecks(sigchecks), lockPoints(lp) {}
+          entryHeight{entry_height}, sigChecks(sigchecks),
+          m_modified_feerate{nFee, GetTxVirtualSize()}, lockPoints(lp) {}
 
     CTxMemPoolEntry(const CTxMemPoolEntry &other) = delete;
     CTxMemPoolEntry(CTxMemPoolEntry &&other)
@@ -114,6 +118,7 @@ public:
           nTxSize(other.nTxSize), nUsageSize(other.nUsageSize),
           nTime(other.nTime), entryHeight(other.entryHeight),
           sigChecks(other.sigChecks), feeDelta(other.feeDelta),
+          m_modified_feerate(other.m_modified_feerate),
           lockPoints(std::move(other.lockPoints)),
           refcount(other.refcount.load()){};
 
@@ -135,14 +140,15 @@ public:
     unsigned int GetHeight() const { return entryHeight; }
     int64_t GetSigChecks() const { return sigChecks; }
     Amount GetModifiedFee() const { return nFee + feeDelta; }
-    CFeeRate GetModifiedFeeRate() const {
-        return CFeeRate(GetModifiedFee(), GetTxVirtualSize());
-    }
+    CFeeRate GetModifiedFeeRate() const { return m_modified_feerate; }
     size_t DynamicMemoryUsage() const { return nUsageSize; }
     const LockPoints &GetLockPoints() const { return lockPoints; }
 
     // Updates the fee delta used for mining priority score
-    void UpdateFeeDelta(Amount newFeeDelta) { feeDelta = newFeeDelta; }
+    void UpdateFeeDelta(Amount newFeeDelta) {
+        feeDelta = newFeeDelta;
+        m_modified_feerate = CFeeRate(GetModifiedFee(), GetTxVirtualSize());
+    }
 
     const Parents &GetMemPoolParentsConst() const { return m_parents; }
     const Children &GetMemPoolChildrenConst() const { return m_children; }
@@ -16,6 +16,11 @@ static constexpr unsigned int DEFAULT_MAX_MEMPOOL_SIZE_MB{300};
  * Default for -mempoolexpiry, expiration time for mempool transactions in hours
  */
 static constexpr unsigned int DEFAULT_MEMPOOL_EXPIRY_HOURS{336};
+/**
+ * Default for -mempooljournalsize, number of the most recent mempool changes
+ * that can be queried
+ */
+static constexpr unsigned int DEFAULT_MEMPOOL_JOURNAL_SIZE{50'000};
 
 namespace kernel {
 /**
@@ -31,6 +36,8 @@ struct MemPoolOptions {
     int64_t max_size_bytes{DEFAULT_MAX_MEMPOOL_SIZE_MB * 1'000'000};
     std::chrono::seconds expiry{
         std::chrono::hours{DEFAULT_MEMPOOL_EXPIRY_HOURS}};
+    /** Number of the most recent changes kept in the change journal. */
+    size_t journal_size{DEFAULT_MEMPOOL_JOURNAL_SIZE};
     /**
      * A fee rate smaller than this is considered zero fee (for relaying,
      * mining and transaction creation)
@@ -35,6 +35,11 @@ using fsbridge::FopenFn;
 
 namespace kernel {
 static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+/**
+ * The number of transactions read ahead when loading the mempool, whose
+ * scripts are verified together in parallel before they are accepted.
+ */
+static constexpr size_t MEMPOOL_LOAD_BATCH_SIZE{1000};
 
 bool LoadMempool(CTxMemPool &pool, const fs::path &load_path,
                  Chainstate &active_chainstate,
@@ -67,6 +72,8 @@ bool LoadMempool(CTxMemPool &pool, const fs::path &load_path,
 
         uint64_t num;
         file >> num;
+        std::vector<CTransactionRef> batch;
+        std::vector<int64_t> batch_times;
         while (num) {
             --num;
             CTransactionRef tx;
@@ -82,9 +89,23 @@ bool LoadMempool(CTxMemPool &pool, const fs::path &load_path,
             }
             if (nTime >
                 TicksSinceEpoch<std::chrono::seconds>(now - pool.m_expiry)) {
+                batch.push_back(std::move(tx));
+                batch_times.push_back(nTime);
+            } else {
+                ++expired;
+            }
+            if (batch.size() < MEMPOOL_LOAD_BATCH_SIZE && num) {
+                continue;
+            }
+
+            // The signatures verified in parallel here are then found in the
+            // signature cache by AcceptToMemoryPool.
+            PrecheckTransactionScripts(active_chainstate, pool, batch);
+            for (size_t i = 0; i < batch.size(); ++i) {
                 LOCK(cs_main);
                 const auto &accepted =
-                    AcceptToMemoryPool(active_chainstate, tx, nTime,
+                    AcceptToMemoryPool(active_chainstate, batch[i],
+                                       batch_times[i],
                                        /*bypass_limits=*/false,
                                        /*test_accept=*/false);
                 if (accepted.m_result_type ==
@@ -95,15 +116,19 @@ bool LoadMempool(CTxMemPool &pool, const fs::path &load_path,
                     // wallet(s) having loaded it while we were processing
                     // mempool transactions; consider these as valid, instead of
                     // failed, but mark them as 'already there'
-                    if (pool.exists(tx->GetId())) {
+                    if (pool.exists(batch[i]->GetId())) {
                         ++already_there;
                     } else {
                         ++failed;
                     }
                 }
-            } else {
-                ++expired;
+
+                if (ShutdownRequested()) {
+                    return false;
+                }
             }
+            batch.clear();
+            batch_times.clear();
 
             if (ShutdownRequested()) {
                 return false;
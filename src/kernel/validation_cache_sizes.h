@@ -5,6 +5,7 @@
 #ifndef BITCOIN_KERNEL_VALIDATION_CACHE_SIZES_H
 #define BITCOIN_KERNEL_VALIDATION_CACHE_SIZES_H
 
+#include <pow/powcache.h>
 #include <script/scriptcache.h>
 #include <script/sigcache.h>
 
@@ -15,6 +16,7 @@ namespace kernel {
 struct ValidationCacheSizes {
     size_t signature_cache_bytes{DEFAULT_MAX_SIG_CACHE_BYTES};
     size_t script_execution_cache_bytes{DEFAULT_MAX_SCRIPT_CACHE_BYTES};
+    size_t pow_cache_bytes{DEFAULT_MAX_POW_CACHE_BYTES};
 };
 } // namespace kernel
 
@@ -11,7 +11,9 @@
 #include <util/threadnames.h>
 #include <util/time.h>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <map>
 #include <unordered_map>
 
@@ -202,6 +204,7 @@ std::vector<LogCategory> BCLog::Logger::LogCategoriesList() const {
 }
 
 BCLog::Logger::~Logger() {
+    StopAsyncLogging();
     if (m_fileout) {
         fclose(m_fileout);
     }
@@ -256,15 +259,51 @@ std::string LogEscapeMessage(const std::string &str) {
 }
 } // namespace BCLog
 
-void BCLog::Logger::LogPrintStr(const std::string &str,
-                                const std::string &logging_function,
-                                const std::string &source_file,
-                                const int source_line,
-                                const BCLog::LogFlags category,
-                                const BCLog::Level level) {
-    StdLockGuard scoped_lock(m_cs);
+/** Escape the string to be a JSON string value. */
+static std::string JsonEscape(const std::string &str) {
+    std::string ret;
+    for (char ch : str) {
+        if (ch == '"' || ch == '\\') {
+            ret += '\\';
+            ret += ch;
+        } else if (ch == '\n') {
+            ret += "\\n";
+        } else if (uint8_t(ch) < 32) {
+            ret += strprintf("\\u%04x", uint8_t(ch));
+        } else {
+            ret += ch;
+        }
+    }
+    return ret;
+}
+
+std::string BCLog::Logger::FormatLogStr(const std::string &str,
+                                        const std::string &logging_function,
+                                        const std::string &source_file,
+                                        const int source_line,
+                                        const BCLog::LogFlags category,
+                                        const BCLog::Level level) {
     std::string str_prefixed = LogEscapeMessage(str);
 
+    if (m_log_json) {
+        // Every message is a full object, and the newline ends the object
+        if (!str_prefixed.empty() && str_prefixed.back() == '\n') {
+            str_prefixed.pop_back();
+        }
+        const int64_t nTimeMicros = GetTimeMicros();
+        std::string time = FormatISO8601DateTime(nTimeMicros / 1000000);
+        time.pop_back();
+        time += strprintf(".%06dZ", nTimeMicros % 1000000);
+        return strprintf(
+            "{\"time\":\"%s\",\"thread\":\"%s\",\"category\":\"%s\","
+            "\"level\":\"%s\",\"file\":\"%s\",\"line\":%d,"
+            "\"function\":\"%s\",\"message\":\"%s\"}\n",
+            time, JsonEscape(util::ThreadGetInternalName()),
+            LogCategoryToStr(category), LogLevelToStr(level),
+            JsonEscape(RemovePrefix(source_file, "./")), source_line,
+            JsonEscape(logging_function), JsonEscape(str_prefixed));
+    }
+
     if ((category != LogFlags::NONE || level != Level::None) &&
         m_started_new_line) {
         std::string s{"["};
@@ -300,6 +339,38 @@ void BCLog::Logger::LogPrintStr(const std::string &str,
 
     m_started_new_line = !str.empty() && str[str.size() - 1] == '\n';
 
+    return str_prefixed;
+}
+
+void BCLog::Logger::LogPrintStr(const std::string &str,
+                                const std::string &logging_function,
+                                const std::string &source_file,
+                                const int source_line,
+                                const BCLog::LogFlags category,
+                                const BCLog::Level level) {
+    if (m_async.load(std::memory_order_acquire)) {
+        std::string str_prefixed = FormatLogStr(
+            str, logging_function, source_file, source_line, category, level);
+        if (PushAsync(str_prefixed)) {
+            return;
+        }
+        // Only the debug messages are dropped, the others are written
+        // synchronously when the buffer is full.
+        if (category != LogFlags::NONE && level < Level::Warning) {
+            ++m_async_dropped;
+            return;
+        }
+        StdLockGuard scoped_lock(m_cs);
+        WriteLogStr(str_prefixed);
+        return;
+    }
+
+    StdLockGuard scoped_lock(m_cs);
+    WriteLogStr(FormatLogStr(str, logging_function, source_file, source_line,
+                             category, level));
+}
+
+void BCLog::Logger::WriteLogStr(const std::string &str_prefixed) {
     if (m_buffering) {
         // buffer if we haven't started logging yet
         m_msgs_before_open.push_back(str_prefixed);
@@ -332,6 +403,174 @@ void BCLog::Logger::LogPrintStr(const std::string &str,
     }
 }
 
+namespace BCLog {
+/**
+ * A bounded queue of the messages logged by a thread, with a single producer,
+ * the logging thread, and a single consumer, the async writer.
+ */
+class LogRingBuffer {
+public:
+    struct Message {
+        uint64_t sequence;
+        std::string str;
+    };
+
+    explicit LogRingBuffer(size_t capacity) : m_slots(capacity) {}
+
+    /**
+     * Called by the logging thread only. The string is moved from if it is
+     * queued.
+     */
+    bool Push(uint64_t sequence, std::string &str) {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) {
+            return false;
+        }
+        Message &slot = m_slots[tail % m_slots.size()];
+        slot.sequence = sequence;
+        slot.str = std::move(str);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Size() const {
+        return m_tail.load(std::memory_order_relaxed) -
+               m_head.load(std::memory_order_relaxed);
+    }
+    size_t Capacity() const { return m_slots.size(); }
+
+    /** Called by the writer only. */
+    void Drain(std::vector<Message> &msgs) {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        const uint64_t tail = m_tail.load(std::memory_order_acquire);
+        for (uint64_t i = head; i < tail; ++i) {
+            msgs.push_back(std::move(m_slots[i % m_slots.size()]));
+        }
+        m_head.store(tail, std::memory_order_release);
+    }
+
+    //! Set when the logging thread exits
+    std::atomic<bool> m_closed{false};
+
+private:
+    std::vector<Message> m_slots;
+    std::atomic<uint64_t> m_head{0};
+    std::atomic<uint64_t> m_tail{0};
+};
+} // namespace BCLog
+
+namespace {
+struct ThreadLogBuffer {
+    const BCLog::Logger *logger{nullptr};
+    std::shared_ptr<BCLog::LogRingBuffer> buffer;
+
+    ~ThreadLogBuffer() {
+        if (buffer) {
+            buffer->m_closed = true;
+        }
+    }
+};
+thread_local ThreadLogBuffer g_thread_log_buffer;
+} // namespace
+
+bool BCLog::Logger::PushAsync(std::string &str) {
+    ThreadLogBuffer &thread_buffer = g_thread_log_buffer;
+    if (thread_buffer.logger != this) {
+        // First message of this thread, only then it takes the lock
+        if (thread_buffer.buffer) {
+            thread_buffer.buffer->m_closed = true;
+        }
+        std::lock_guard<std::mutex> lock(m_async_mutex);
+        thread_buffer.logger = this;
+        thread_buffer.buffer =
+            std::make_shared<LogRingBuffer>(m_async_buffer_size);
+        m_async_buffers.push_back(thread_buffer.buffer);
+    }
+
+    LogRingBuffer &buffer = *thread_buffer.buffer;
+    if (!buffer.Push(++m_async_sequence, str)) {
+        return false;
+    }
+    // Don't wait for the flush interval when the buffer gets full
+    if (buffer.Size() == buffer.Capacity() / 2) {
+        m_async_cv.notify_one();
+    }
+    return true;
+}
+
+void BCLog::Logger::FlushAsync() {
+    std::vector<LogRingBuffer::Message> msgs;
+    {
+        std::lock_guard<std::mutex> lock(m_async_mutex);
+        for (auto it = m_async_buffers.begin(); it != m_async_buffers.end();) {
+            // Check before draining, so no message is left behind
+            const bool closed = (*it)->m_closed;
+            (*it)->Drain(msgs);
+            it = closed ? m_async_buffers.erase(it) : std::next(it);
+        }
+    }
+    std::sort(msgs.begin(), msgs.end(),
+              [](const LogRingBuffer::Message &a,
+                 const LogRingBuffer::Message &b) {
+                  return a.sequence < b.sequence;
+              });
+
+    const uint64_t dropped = m_async_dropped.load();
+    StdLockGuard scoped_lock(m_cs);
+    for (const LogRingBuffer::Message &msg : msgs) {
+        WriteLogStr(msg.str);
+    }
+    m_async_written += msgs.size();
+
+    if (dropped > m_async_dropped_reported) {
+        WriteLogStr(FormatLogStr(
+            strprintf("Dropped %d log messages, the async log buffer was "
+                      "full\n",
+                      dropped - m_async_dropped_reported),
+            __func__, __FILE__, __LINE__, LogFlags::NONE, Level::Warning));
+        m_async_dropped_reported = dropped;
+    }
+}
+
+void BCLog::Logger::AsyncWriterThread() {
+    // Frequent enough for the log to look live
+    constexpr auto FLUSH_INTERVAL{std::chrono::milliseconds{10}};
+
+    util::ThreadRename("logwriter");
+    std::unique_lock<std::mutex> lock(m_async_mutex);
+    while (!m_async_stop) {
+        // Woken up early when a buffer gets full or to stop
+        m_async_cv.wait_for(lock, FLUSH_INTERVAL);
+        lock.unlock();
+        FlushAsync();
+        lock.lock();
+    }
+}
+
+void BCLog::Logger::StartAsyncLogging(size_t buffer_size) {
+    std::lock_guard<std::mutex> lock(m_async_mutex);
+    assert(!m_async_thread.joinable());
+    m_async_buffer_size = std::max<size_t>(1, buffer_size);
+    m_async_stop = false;
+    m_async_thread = std::thread(&Logger::AsyncWriterThread, this);
+    m_async = true;
+}
+
+void BCLog::Logger::StopAsyncLogging() {
+    {
+        std::lock_guard<std::mutex> lock(m_async_mutex);
+        if (!m_async_thread.joinable()) {
+            return;
+        }
+        m_async = false;
+        m_async_stop = true;
+    }
+    m_async_cv.notify_one();
+    m_async_thread.join();
+    // The messages queued while the writer was stopping
+    FlushAsync();
+}
+
 void BCLog::Logger::ShrinkDebugFile() {
     // Amount of debug.log to save at end when shrinking (must fit in memory)
     constexpr size_t RECENT_DEBUG_HISTORY_SIZE = 10 * 1000000;
@@ -409,6 +648,88 @@ bool BCLog::Logger::WillLogCategory(LogFlags category) const {
     return (m_categories.load(std::memory_order_relaxed) & category) != 0;
 }
 
+void BCLog::Logger::UpdateLimited() {
+    bool limited = false;
+    for (size_t i = 0; i < m_rate_limits.size(); ++i) {
+        limited |= m_rate_limits[i] > 0 || m_sampling[i] > 1;
+    }
+    m_limited = limited;
+}
+
+void BCLog::Logger::SetRateLimit(uint32_t categories, uint32_t per_second) {
+    for (size_t i = 0; i < m_rate_limits.size(); ++i) {
+        if (categories & (uint32_t{1} << i)) {
+            m_rate_limits[i] = per_second;
+        }
+    }
+    UpdateLimited();
+}
+
+void BCLog::Logger::SetSampling(uint32_t categories, uint32_t n) {
+    for (size_t i = 0; i < m_sampling.size(); ++i) {
+        if (categories & (uint32_t{1} << i)) {
+            m_sampling[i] = n;
+        }
+    }
+    UpdateLimited();
+}
+
+std::optional<BCLog::Logger::CallsiteLimits>
+BCLog::Logger::GetCallsiteLimits(LogFlags category) const {
+    if (!m_limited.load(std::memory_order_relaxed)) {
+        return std::nullopt;
+    }
+    for (size_t i = 0; i < m_rate_limits.size(); ++i) {
+        if (category & (uint32_t{1} << i)) {
+            return CallsiteLimits{
+                m_rate_limits[i].load(std::memory_order_relaxed),
+                m_sampling[i].load(std::memory_order_relaxed)};
+        }
+    }
+    return std::nullopt;
+}
+
+bool BCLog::LogCallsite::Allow(LogFlags category, const char *logging_function,
+                               const char *source_file, int source_line) {
+    const std::optional<Logger::CallsiteLimits> limits{
+        LogInstance().GetCallsiteLimits(category)};
+    if (!limits) {
+        return true;
+    }
+
+    if (limits->sampling > 1 &&
+        m_count.fetch_add(1, std::memory_order_relaxed) % limits->sampling !=
+            0) {
+        return false;
+    }
+
+    if (limits->rate_limit > 0) {
+        const int64_t now{TicksSinceEpoch<std::chrono::seconds>(
+            Now<NodeSeconds>())};
+        int64_t window = m_window.load(std::memory_order_relaxed);
+        if (now != window && m_window.compare_exchange_strong(window, now)) {
+            // A new window started, report what the last ones suppressed
+            m_window_count = 0;
+            if (const uint64_t suppressed = m_suppressed.exchange(0)) {
+                LogInstance().LogPrintStr(
+                    strprintf("Suppressed %d messages from %s:%d by the rate "
+                              "limit\n",
+                              suppressed, RemovePrefix(source_file, "./"),
+                              source_line),
+                    logging_function, source_file, source_line, category,
+                    Level::None);
+            }
+        }
+        if (m_window_count.fetch_add(1, std::memory_order_relaxed) >=
+            limits->rate_limit) {
+            ++m_suppressed;
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool BCLog::Logger::DefaultShrinkDebugFile() const {
     return m_categories != BCLog::NONE;
 }
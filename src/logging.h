@@ -12,18 +12,28 @@
 #include <util/fs.h>
 #include <util/string.h>
 
+#include <array>
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
 static const bool DEFAULT_LOGSOURCELOCATIONS = false;
+static const bool DEFAULT_LOGJSON = false;
+static const bool DEFAULT_LOGASYNC = false;
+//! Number of messages each thread can buffer for the async log writer
+static const size_t DEFAULT_LOGASYNC_BUFFER = 4096;
 
 extern bool fLogIPs;
 extern const char *const DEFAULT_DEBUGLOGFILE;
@@ -79,6 +89,27 @@ enum class Level {
     Error = 4,
 };
 
+class LogRingBuffer;
+
+/**
+ * The state of a LogPrint call site, to rate limit and sample the messages of
+ * the hot paths.
+ */
+class LogCallsite {
+private:
+    std::atomic<uint64_t> m_count{0};
+    //! The one second window of the rate limit
+    std::atomic<int64_t> m_window{0};
+    std::atomic<uint32_t> m_window_count{0};
+    std::atomic<uint64_t> m_suppressed{0};
+
+public:
+    /** Return whether the message should be logged, as configured for the
+     * category. */
+    bool Allow(LogFlags category, const char *logging_function,
+               const char *source_file, int source_line);
+};
+
 class Logger {
 private:
     // Can not use Mutex from sync.h because in debug mode it would cause a
@@ -101,8 +132,58 @@ private:
      */
     std::atomic<uint32_t> m_categories{0};
 
+    /**
+     * The limits of the messages per call site, by category bit. The rate
+     * limits are in messages per second and the messages are sampled 1 in n,
+     * 0 means no limit.
+     */
+    std::array<std::atomic<uint32_t>, 32> m_rate_limits{};
+    std::array<std::atomic<uint32_t>, 32> m_sampling{};
+    //! Whether any limit is set, so the call sites can skip the checks
+    std::atomic<bool> m_limited{false};
+    void UpdateLimited();
+
     std::string LogTimestampStr(const std::string &str);
 
+    /** Prefix the message as configured, or format it as a JSON object. */
+    std::string FormatLogStr(const std::string &str,
+                             const std::string &logging_function,
+                             const std::string &source_file,
+                             const int source_line,
+                             const BCLog::LogFlags category,
+                             const BCLog::Level level);
+    /** Write a formatted message to the outputs. */
+    void WriteLogStr(const std::string &str) EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+
+    /**
+     * The async logging state. The messages are queued to the ring buffer of
+     * the logging thread without locking, and written by m_async_thread.
+     */
+    std::atomic<bool> m_async{false};
+    //! Protects the fields below, not held while writing
+    std::mutex m_async_mutex;
+    std::condition_variable m_async_cv;
+    bool m_async_stop = false;
+    std::thread m_async_thread;
+    size_t m_async_buffer_size = DEFAULT_LOGASYNC_BUFFER;
+    //! The buffers of the threads, removed once their thread exits
+    std::vector<std::shared_ptr<LogRingBuffer>> m_async_buffers;
+    //! Orders the messages of the different threads
+    std::atomic<uint64_t> m_async_sequence{0};
+    std::atomic<uint64_t> m_async_written{0};
+    std::atomic<uint64_t> m_async_dropped{0};
+    //! Dropped messages already reported in the log
+    uint64_t m_async_dropped_reported = 0;
+
+    /**
+     * Queue the message, moving from str. Returns false and leaves str as is
+     * if the buffer is full.
+     */
+    bool PushAsync(std::string &str);
+    /** Write all the queued messages, in the order they were logged. */
+    void FlushAsync();
+    void AsyncWriterThread();
+
     /** Slots that connect to the print signal */
     std::list<std::function<void(const std::string &)>>
         m_print_callbacks GUARDED_BY(m_cs){};
@@ -115,6 +196,8 @@ public:
     bool m_log_time_micros = DEFAULT_LOGTIMEMICROS;
     bool m_log_threadnames = DEFAULT_LOGTHREADNAMES;
     bool m_log_sourcelocations = DEFAULT_LOGSOURCELOCATIONS;
+    //! Write each message as a JSON object on a line, instead of text
+    bool m_log_json = DEFAULT_LOGJSON;
 
     fs::path m_file_path;
     std::atomic<bool> m_reopen_file{false};
@@ -154,6 +237,23 @@ public:
     /** Only for testing */
     void DisconnectTestLogger();
 
+    /**
+     * Write the log from a background thread, so the logging threads don't
+     * wait for the outputs. Each thread buffers up to buffer_size messages,
+     * the debug messages are dropped when its buffer is full.
+     */
+    void StartAsyncLogging(size_t buffer_size = DEFAULT_LOGASYNC_BUFFER);
+    /** Write the queued messages and log synchronously again. */
+    void StopAsyncLogging();
+
+    struct AsyncStats {
+        uint64_t written;
+        uint64_t dropped;
+    };
+    AsyncStats GetAsyncStats() const {
+        return {m_async_written.load(), m_async_dropped.load()};
+    }
+
     void ShrinkDebugFile();
 
     uint32_t GetCategoryMask() const { return m_categories.load(); }
@@ -166,6 +266,21 @@ public:
     /** Return true if log accepts specified category */
     bool WillLogCategory(LogFlags category) const;
 
+    /**
+     * Log at most per_second messages per second from each call site of the
+     * categories, 0 to remove the limit.
+     */
+    void SetRateLimit(uint32_t categories, uint32_t per_second);
+    /** Log only 1 in n messages of each call site of the categories. */
+    void SetSampling(uint32_t categories, uint32_t n);
+
+    struct CallsiteLimits {
+        uint32_t rate_limit;
+        uint32_t sampling;
+    };
+    /** The limits of the category, if any limit is set. */
+    std::optional<CallsiteLimits> GetCallsiteLimits(LogFlags category) const;
+
     /** Returns a vector of the log categories in alphabetical order. */
     std::vector<LogCategory> LogCategoriesList() const;
     /** Returns a string with the log categories in alphabetical order. */
@@ -234,11 +349,18 @@ LogPrintf_(const std::string &logging_function, const std::string &source_file,
 // Use a macro instead of a function for conditional logging to prevent
 // evaluating arguments when logging for the category is not enabled.
 
+// The messages are rate limited and sampled per call site, as configured for
+// their category. The warnings and errors are always logged.
+
 // Log conditionally, prefixing the output with the passed category name.
 #define LogPrint(category, ...)                                                \
     do {                                                                       \
         if (LogAcceptCategory((category), BCLog::Level::Debug)) {              \
-            LogPrintLevel_(category, BCLog::Level::None, __VA_ARGS__);         \
+            static BCLog::LogCallsite log_callsite;                            \
+            if (log_callsite.Allow((category), __func__, __FILE__,             \
+                                   __LINE__)) {                                \
+                LogPrintLevel_(category, BCLog::Level::None, __VA_ARGS__);     \
+            }                                                                  \
         }                                                                      \
     } while (0)
 
@@ -247,7 +369,12 @@ LogPrintf_(const std::string &logging_function, const std::string &source_file,
 #define LogPrintLevel(category, level, ...)                                    \
     do {                                                                       \
         if (LogAcceptCategory((category), (level))) {                          \
-            LogPrintLevel_(category, level, __VA_ARGS__);                      \
+            static BCLog::LogCallsite log_callsite;                            \
+            if ((level) >= BCLog::Level::Warning ||                            \
+                log_callsite.Allow((category), __func__, __FILE__,             \
+                                   __LINE__)) {                                \
+                LogPrintLevel_(category, level, __VA_ARGS__);                  \
+            }                                                                  \
         }                                                                      \
     } while (0)
 
@@ -15,6 +15,7 @@
 #include <util/moneystr.h>
 #include <util/translation.h>
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 
@@ -34,6 +35,10 @@ ApplyArgsManOptions(const ArgsManager &argsman, const CChainParams &chainparams,
         mempool_opts.expiry = std::chrono::hours{*hours};
     }
 
+    if (auto size = argsman.GetIntArg("-mempooljournalsize")) {
+        mempool_opts.journal_size = std::max<int64_t>(*size, 0);
+    }
+
     if (argsman.IsArgSet("-minrelaytxfee")) {
         Amount n = Amount::zero();
         auto parsed = ParseMoney(argsman.GetArg("-minrelaytxfee", ""), n);
@@ -5,6 +5,7 @@
 #ifndef BITCOIN_MEMUSAGE_H
 #define BITCOIN_MEMUSAGE_H
 
+#include <flathashmap.h>
 #include <indirectmap.h>
 #include <prevector.h>
 #include <support/allocators/pool.h>
@@ -181,6 +182,13 @@ static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z> &m) {
            MallocUsage(sizeof(void *) * m.bucket_count());
 }
 
+template <typename X, typename Y, typename Z, typename W>
+static inline size_t DynamicUsage(const FlatHashMap<X, Y, Z, W> &m) {
+    // One control byte per slot, allocated separately from the slots.
+    return MallocUsage(m.bucket_count()) +
+           MallocUsage(sizeof(std::pair<const X, Y>) * m.bucket_count());
+}
+
 template <class Key, class T, class Hash, class Pred,
           std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
 static inline size_t DynamicUsage(
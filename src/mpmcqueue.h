@@ -0,0 +1,105 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MPMCQUEUE_H
+#define BITCOIN_MPMCQUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+
+/**
+ * Bounded lock-free queue with any number of producers and consumers.
+ *
+ * Each cell of the ring buffer carries a sequence number telling whether it is
+ * ready to be written or read for a given position, so that producers and
+ * consumers only contend on their own position counter (Vyukov's algorithm).
+ */
+template <typename T> class BoundedMPMCQueue {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    const size_t m_capacity;
+    std::unique_ptr<Cell[]> m_cells;
+
+    alignas(64) std::atomic<size_t> m_enqueue_pos{0};
+    alignas(64) std::atomic<size_t> m_dequeue_pos{0};
+
+public:
+    explicit BoundedMPMCQueue(size_t capacity)
+        : m_capacity(capacity), m_cells(new Cell[capacity]) {
+        assert(capacity > 0);
+        for (size_t i = 0; i < capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedMPMCQueue(const BoundedMPMCQueue &) = delete;
+    BoundedMPMCQueue &operator=(const BoundedMPMCQueue &) = delete;
+
+    size_t Capacity() const { return m_capacity; }
+
+    /**
+     * Push a value at the back of the queue. Returns false if the queue is
+     * full, in which case the value is left untouched.
+     */
+    bool TryPush(T &&value) {
+        size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &m_cells[pos % m_capacity];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t dif = intptr_t(seq) - intptr_t(pos);
+            if (dif == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                // The cell still holds the value from the previous round
+                return false;
+            } else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Pop the value at the front of the queue, if any. */
+    std::optional<T> TryPop() {
+        size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &m_cells[pos % m_capacity];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t dif = intptr_t(seq) - intptr_t(pos + 1);
+            if (dif == 0) {
+                if (m_dequeue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                // Nothing was written to the cell yet
+                return std::nullopt;
+            } else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        std::optional<T> value{std::move(cell->data)};
+        cell->data = T{};
+        cell->sequence.store(pos + m_capacity, std::memory_order_release);
+        return value;
+    }
+};
+
+#endif // BITCOIN_MPMCQUEUE_H
@@ -111,6 +111,31 @@ static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 50;
 
 const std::string NET_MESSAGE_COMMAND_OTHER = "*other*";
 
+/** Map all the known message types plus the others to no processing time. */
+static const mapMsgCmdProcessTime &EmptyProcessTimePerMsgCmd() {
+    static const mapMsgCmdProcessTime empty{[] {
+        mapMsgCmdProcessTime map;
+        for (const std::string &msg : getAllNetMessageTypes()) {
+            map[msg];
+        }
+        map[NET_MESSAGE_COMMAND_OTHER];
+        return map;
+    }()};
+    return empty;
+}
+
+static void AddProcessTime(mapMsgCmdProcessTime &map,
+                           const std::string &msg_type,
+                           const MsgProcessTime &time) {
+    // Only known message types get an entry, to prevent a memory DOS
+    auto it = map.find(msg_type);
+    if (it == map.end()) {
+        it = map.find(NET_MESSAGE_COMMAND_OTHER);
+    }
+    assert(it != map.end());
+    it->second += time;
+}
+
 // SHA256("netgroup")[0:8]
 static const uint64_t RANDOMIZER_ID_NETGROUP = 0x6c0edd8036ef4036ULL;
 // SHA256("localhostnonce")[0:8]
@@ -670,6 +695,10 @@ void CNode::copyStats(CNodeStats &stats) {
         stats.mapRecvBytesPerMsgCmd = mapRecvBytesPerMsgCmd;
         stats.nRecvBytes = nRecvBytes;
     }
+    {
+        LOCK(m_process_time_mutex);
+        stats.mapProcessTimePerMsgCmd = mapProcessTimePerMsgCmd;
+    }
     stats.m_permission_flags = m_permission_flags;
 
     stats.m_last_ping_time = m_last_ping_time;
@@ -827,8 +856,62 @@ V1TransportDeserializer::GetMessage(const Config &config,
     return msg;
 }
 
+bool V1TransportDeserializer::EnableDecompression() {
+    if (!P2PCompressionSupported()) {
+        return false;
+    }
+    if (!m_decompressor) {
+        m_decompressor = std::make_unique<P2PDecompressor>();
+    }
+    return true;
+}
+
+bool V1TransportDeserializer::Decompress(const Config &config) {
+    // Leave a corrupted message to be reported as such
+    if (memcmp(GetMessageHash().begin(), hdr.pchChecksum,
+               CMessageHeader::CHECKSUM_SIZE) != 0) {
+        return true;
+    }
+
+    const Span<const uint8_t> payload{MakeUCharSpan(vRecv)};
+    constexpr size_t prefix_size{CMessageHeader::COMMAND_SIZE +
+                                 sizeof(uint32_t)};
+    if (payload.size() < prefix_size) {
+        return false;
+    }
+    CMessageHeader inner(hdr.pchMessageStart);
+    memcpy(inner.pchCommand.data(), payload.data(),
+           CMessageHeader::COMMAND_SIZE);
+    inner.nMessageSize =
+        ReadLE32(payload.data() + CMessageHeader::COMMAND_SIZE);
+    // Compressed messages are not nested, and decompress to no more than the
+    // size accepted for the message they wrap.
+    if (inner.GetCommand() == NetMsgType::COMPRESSED ||
+        inner.IsOversized(config)) {
+        return false;
+    }
+
+    CDataStream data(vRecv.GetType(), vRecv.GetVersion());
+    data.resize(inner.nMessageSize);
+    if (!m_decompressor->Decompress(
+            payload.subspan(prefix_size),
+            {reinterpret_cast<uint8_t *>(data.data()), data.size()})) {
+        LogPrint(BCLog::NET, "Invalid compressed %s message\n",
+                 SanitizeString(inner.GetCommand()));
+        return false;
+    }
+
+    // The checksum of the compressed message was checked above, so data_hash
+    // is left as is.
+    hdr.pchCommand = inner.pchCommand;
+    hdr.nMessageSize = inner.nMessageSize;
+    nDataPos = inner.nMessageSize;
+    vRecv = std::move(data);
+    return true;
+}
+
 void V1TransportSerializer::prepareForTransport(const Config &config,
-                                                CSerializedNetMsg &msg,
+                                                const CSerializedNetMsg &msg,
                                                 std::vector<uint8_t> &header) {
     // create dbl-sha256 checksum
     uint256 hash = Hash(msg.data);
@@ -843,23 +926,87 @@ void V1TransportSerializer::prepareForTransport(const Config &config,
     CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, header, 0, hdr};
 }
 
+bool V1TransportSerializer::EnableCompression() {
+    if (!P2PCompressionSupported()) {
+        return false;
+    }
+    if (!m_compress) {
+        m_compressor = std::make_unique<P2PCompressor>();
+        m_compress = true;
+    }
+    return true;
+}
+
+bool V1TransportSerializer::prepareCompressed(const Config &config,
+                                              const CSerializedNetMsg &msg,
+                                              std::vector<uint8_t> &header,
+                                              std::vector<uint8_t> &payload) {
+    if (!m_compress) {
+        return false;
+    }
+    // Stop compressing the types of messages that do not compress
+    CompressionStats &stats = m_compression_stats[msg.m_type];
+    if (stats.uncompressed >= P2P_COMPRESSION_SAMPLE_SIZE &&
+        stats.compressed * 16 > stats.uncompressed * 15) {
+        return false;
+    }
+
+    CMessageHeader inner(config.GetChainParams().NetMagic(),
+                         msg.m_type.c_str(), msg.data.size());
+    payload.resize(CMessageHeader::COMMAND_SIZE + sizeof(uint32_t));
+    memcpy(payload.data(), inner.pchCommand.data(),
+           CMessageHeader::COMMAND_SIZE);
+    WriteLE32(payload.data() + CMessageHeader::COMMAND_SIZE,
+              inner.nMessageSize);
+    if (!m_compressor->Compress(msg.data, payload)) {
+        LogPrint(BCLog::NET, "Failed to compress %s message, sending the "
+                             "messages as is from now on\n",
+                 msg.m_type);
+        m_compress = false;
+        payload.clear();
+        return false;
+    }
+    stats.uncompressed += msg.data.size();
+    stats.compressed += payload.size();
+
+    const uint256 hash = Hash(payload);
+    CMessageHeader hdr(config.GetChainParams().NetMagic(),
+                       NetMsgType::COMPRESSED, payload.size());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+    header.reserve(CMessageHeader::HEADER_SIZE);
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, header, 0, hdr};
+    return true;
+}
+
 std::pair<size_t, bool> CConnman::SocketSendData(CNode &node) const {
     size_t nSentSize = 0;
     size_t nMsgCount = 0;
 
-    for (const auto &data : node.vSendMsg) {
-        assert(data.size() > node.nSendOffset);
-        int nBytes = 0;
+    while (nMsgCount < node.vSendMsg.size()) {
+        // Gather as many of the queued messages as possible into one write.
+        std::array<Span<const uint8_t>, Sock::MAX_SEND_BUFFERS> buffers;
+        size_t num_buffers = 0;
+        size_t gathered_size = 0;
+        for (auto it = node.vSendMsg.begin() + nMsgCount;
+             it != node.vSendMsg.end() && num_buffers < buffers.size(); ++it) {
+            Span<const uint8_t> data{**it};
+            if (num_buffers == 0) {
+                assert(data.size() > node.nSendOffset);
+                data = data.subspan(node.nSendOffset);
+            }
+            buffers[num_buffers++] = data;
+            gathered_size += data.size();
+        }
 
+        ssize_t nBytes = 0;
         {
             LOCK(node.m_sock_mutex);
             if (!node.m_sock) {
                 break;
             }
 
-            nBytes = node.m_sock->Send(
-                reinterpret_cast<const char *>(data.data()) + node.nSendOffset,
-                data.size() - node.nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+            nBytes = node.m_sock->SendMany(
+                Span{buffers.data(), num_buffers}, MSG_NOSIGNAL | MSG_DONTWAIT);
         }
 
         if (nBytes == 0) {
@@ -883,17 +1030,28 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode &node) const {
         assert(nBytes > 0);
         node.m_last_send = GetTime<std::chrono::seconds>();
         node.nSendBytes += nBytes;
-        node.nSendOffset += nBytes;
         nSentSize += nBytes;
-        if (node.nSendOffset != data.size()) {
-            // could not send full message; stop sending more
-            break;
+
+        // Drop the messages which were sent in full.
+        size_t remaining = nBytes;
+        while (remaining > 0) {
+            const size_t msg_size = node.vSendMsg[nMsgCount]->size();
+            const size_t msg_left = msg_size - node.nSendOffset;
+            if (remaining < msg_left) {
+                node.nSendOffset += remaining;
+                break;
+            }
+            remaining -= msg_left;
+            node.nSendOffset = 0;
+            node.nSendSize -= msg_size;
+            node.fPauseSend = node.nSendSize > nSendBufferMaxSize;
+            nMsgCount++;
         }
 
-        node.nSendOffset = 0;
-        node.nSendSize -= data.size();
-        node.fPauseSend = node.nSendSize > nSendBufferMaxSize;
-        nMsgCount++;
+        if (size_t(nBytes) != gathered_size) {
+            // could not send everything; stop sending more
+            break;
+        }
     }
 
     node.vSendMsg.erase(node.vSendMsg.begin(),
@@ -1402,10 +1560,7 @@ void CConnman::CreateNodeFromAcceptedSocket(std::unique_ptr<Sock> &&sock,
 
     LogPrint(BCLog::NET, "connection from %s accepted\n", addr.ToString());
 
-    {
-        LOCK(m_nodes_mutex);
-        m_nodes.push_back(pnode);
-    }
+    InsertNode(pnode);
 
     // We received a new connection, harvest entropy from the time (and our peer
     // count)
@@ -1484,6 +1639,7 @@ void CConnman::DisconnectNodes() {
                 // remove from m_nodes
                 m_nodes.erase(remove(m_nodes.begin(), m_nodes.end(), pnode),
                               m_nodes.end());
+                m_nodes_by_id.erase(pnode->GetId());
 
                 // release outbound grant (if any)
                 pnode->grantOutbound.Release();
@@ -1570,6 +1726,14 @@ bool CConnman::InactivityCheck(const CNode &node) const {
     return false;
 }
 
+/**
+ * The tag of the i-th listening socket in the socket events, the connected
+ * sockets are tagged with their node id.
+ */
+static uintptr_t ListenSocketTag(size_t i) {
+    return std::numeric_limits<uintptr_t>::max() - i;
+}
+
 Sock::EventsPerSock CConnman::GenerateWaitSockets(Span<CNode *const> nodes) {
     Sock::EventsPerSock events_per_sock;
 
@@ -1651,92 +1815,105 @@ void CConnman::SocketHandlerConnected(
             }
         }
 
-        if (sendSet) {
-            // Send data
-            auto [bytes_sent, data_left] =
-                WITH_LOCK(pnode->cs_vSend, return SocketSendData(*pnode));
-            if (bytes_sent) {
-                RecordBytesSent(bytes_sent);
-
-                // If both receiving and (non-optimistic) sending were possible,
-                // we first attempt sending. If that succeeds, but does not
-                // fully drain the send queue, do not attempt to receive. This
-                // avoids needlessly queueing data if the remote peer is slow at
-                // receiving data, by means of TCP flow control. We only do this
-                // when sending actually succeeded to make sure progress is
-                // always made; otherwise a deadlock would be possible when both
-                // sides have data to send, but neither is receiving.
-                if (data_left) {
-                    recvSet = false;
-                }
+        SocketHandlerNode(*pnode, sendSet, recvSet, errorSet);
+
+        if (InactivityCheck(*pnode)) {
+            pnode->fDisconnect = true;
+        }
+    }
+}
+
+bool CConnman::SocketHandlerNode(CNode &node, bool send_set, bool recv_set,
+                                 bool error_set) {
+    bool recv_more = false;
+
+    if (send_set) {
+        // Send data
+        auto [bytes_sent, data_left] =
+            WITH_LOCK(node.cs_vSend, return SocketSendData(node));
+        if (bytes_sent) {
+            RecordBytesSent(bytes_sent);
+
+            // If both receiving and (non-optimistic) sending were possible,
+            // we first attempt sending. If that succeeds, but does not
+            // fully drain the send queue, do not attempt to receive. This
+            // avoids needlessly queueing data if the remote peer is slow at
+            // receiving data, by means of TCP flow control. We only do this
+            // when sending actually succeeded to make sure progress is
+            // always made; otherwise a deadlock would be possible when both
+            // sides have data to send, but neither is receiving.
+            if (data_left && recv_set) {
+                recv_set = false;
+                recv_more = true;
             }
         }
+    }
 
-        if (recvSet || errorSet) {
-            // typical socket buffer is 8K-64K
-            uint8_t pchBuf[0x10000];
-            int32_t nBytes = 0;
-            {
-                LOCK(pnode->m_sock_mutex);
-                if (!pnode->m_sock) {
-                    continue;
-                }
-                nBytes =
-                    pnode->m_sock->Recv(pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-            }
-            if (nBytes > 0) {
-                bool notify = false;
-                if (!pnode->ReceiveMsgBytes(*config, {pchBuf, (size_t)nBytes},
-                                            notify)) {
-                    pnode->CloseSocketDisconnect();
-                }
-                RecordBytesRecv(nBytes);
-                if (notify) {
-                    size_t nSizeAdded = 0;
-                    auto it(pnode->vRecvMsg.begin());
-                    for (; it != pnode->vRecvMsg.end(); ++it) {
-                        // vRecvMsg contains only completed CNetMessage
-                        // the single possible partially deserialized message
-                        // are held by TransportDeserializer
-                        nSizeAdded += it->m_raw_message_size;
-                    }
-                    {
-                        LOCK(pnode->cs_vProcessMsg);
-                        pnode->vProcessMsg.splice(pnode->vProcessMsg.end(),
-                                                  pnode->vRecvMsg,
-                                                  pnode->vRecvMsg.begin(), it);
-                        pnode->nProcessQueueSize += nSizeAdded;
-                        pnode->fPauseRecv =
-                            pnode->nProcessQueueSize > nReceiveFloodSize;
-                    }
-                    WakeMessageHandler();
+    if (recv_set || error_set) {
+        // typical socket buffer is 8K-64K
+        uint8_t pchBuf[0x10000];
+        int32_t nBytes = 0;
+        {
+            LOCK(node.m_sock_mutex);
+            if (!node.m_sock) {
+                return false;
+            }
+            nBytes = node.m_sock->Recv(pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+        }
+        if (nBytes > 0) {
+            recv_more = true;
+            bool notify = false;
+            if (!node.ReceiveMsgBytes(*config, {pchBuf, (size_t)nBytes},
+                                      notify)) {
+                node.CloseSocketDisconnect();
+            }
+            RecordBytesRecv(nBytes);
+            if (notify) {
+                size_t nSizeAdded = 0;
+                auto it(node.vRecvMsg.begin());
+                for (; it != node.vRecvMsg.end(); ++it) {
+                    // vRecvMsg contains only completed CNetMessage
+                    // the single possible partially deserialized message
+                    // are held by TransportDeserializer
+                    nSizeAdded += it->m_raw_message_size;
                 }
-            } else if (nBytes == 0) {
-                // socket closed gracefully
-                if (!pnode->fDisconnect) {
-                    LogPrint(BCLog::NET, "socket closed for peer=%d\n",
-                             pnode->GetId());
+                {
+                    LOCK(node.cs_vProcessMsg);
+                    node.vProcessMsg.splice(node.vProcessMsg.end(),
+                                            node.vRecvMsg,
+                                            node.vRecvMsg.begin(), it);
+                    node.nProcessQueueSize += nSizeAdded;
+                    node.fPauseRecv =
+                        node.nProcessQueueSize > nReceiveFloodSize;
                 }
-                pnode->CloseSocketDisconnect();
-            } else if (nBytes < 0) {
-                // error
-                int nErr = WSAGetLastError();
-                if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE &&
-                    nErr != WSAEINTR && nErr != WSAEINPROGRESS) {
-                    if (!pnode->fDisconnect) {
-                        LogPrint(BCLog::NET,
-                                 "socket recv error for peer=%d: %s\n",
-                                 pnode->GetId(), NetworkErrorString(nErr));
-                    }
-                    pnode->CloseSocketDisconnect();
+                WakeMessageHandler(node.GetId());
+            }
+        } else if (nBytes == 0) {
+            // socket closed gracefully
+            if (!node.fDisconnect) {
+                LogPrint(BCLog::NET, "socket closed for peer=%d\n",
+                         node.GetId());
+            }
+            node.CloseSocketDisconnect();
+        } else if (nBytes < 0) {
+            // error
+            int nErr = WSAGetLastError();
+            if (nErr == WSAEINTR) {
+                recv_more = true;
+            }
+            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE &&
+                nErr != WSAEINTR && nErr != WSAEINPROGRESS) {
+                if (!node.fDisconnect) {
+                    LogPrint(BCLog::NET, "socket recv error for peer=%d: %s\n",
+                             node.GetId(), NetworkErrorString(nErr));
                 }
+                node.CloseSocketDisconnect();
             }
         }
-
-        if (InactivityCheck(*pnode)) {
-            pnode->fDisconnect = true;
-        }
     }
+
+
+    return recv_more;
 }
 
 void CConnman::SocketHandlerListening(
@@ -1752,20 +1929,161 @@ void CConnman::SocketHandlerListening(
     }
 }
 
+void CConnman::SocketHandlerEvents() {
+    const auto full_pass_interval =
+        std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS);
+
+    // The nodes which may still have data to receive are serviced again
+    // right away, unless they are paused. Otherwise only wait until the next
+    // inactivity check is due.
+    bool recv_pending = false;
+    {
+        LOCK(m_nodes_mutex);
+        for (auto it = m_sock_pending_recv.begin();
+             it != m_sock_pending_recv.end();) {
+            const auto node_it = m_nodes_by_id.find(*it);
+            if (node_it == m_nodes_by_id.end()) {
+                it = m_sock_pending_recv.erase(it);
+                continue;
+            }
+            recv_pending |= !node_it->second->fPauseRecv;
+            ++it;
+        }
+    }
+    auto timeout = std::chrono::milliseconds{0};
+    if (!recv_pending) {
+        timeout = std::clamp(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                m_last_sock_full_pass + full_pass_interval -
+                std::chrono::steady_clock::now()),
+            std::chrono::milliseconds{0}, full_pass_interval);
+    }
+
+    std::vector<SockEvents::Occurred> occurred;
+    if (!m_sock_events->Wait(timeout, occurred)) {
+        interruptNet.sleep_for(full_pass_interval);
+    }
+
+    // Merge the events per socket, along with the pending receives.
+    std::map<NodeId, Sock::Event> events_per_node;
+    std::vector<size_t> listening;
+    for (const SockEvents::Occurred &event : occurred) {
+        const size_t listen_index = ListenSocketTag(0) - event.tag;
+        if (listen_index < vhListenSocket.size()) {
+            listening.push_back(listen_index);
+        } else {
+            events_per_node[NodeId(event.tag)] |= event.events;
+        }
+    }
+    for (const NodeId id : m_sock_pending_recv) {
+        events_per_node[id] |= Sock::RECV;
+    }
+
+    std::vector<std::pair<CNode *, Sock::Event>> ready;
+    {
+        LOCK(m_nodes_mutex);
+        for (const auto &[id, events] : events_per_node) {
+            const auto it = m_nodes_by_id.find(id);
+            if (it == m_nodes_by_id.end()) {
+                m_sock_pending_recv.erase(id);
+                continue;
+            }
+            it->second->AddRef();
+            ready.emplace_back(it->second, events);
+        }
+    }
+
+    // Service (send/receive) each of the nodes with events. The events are
+    // edge-triggered, so a node stays pending until its socket is drained.
+    for (const auto &[pnode, events] : ready) {
+        if (!interruptNet) {
+            const bool paused = pnode->fPauseRecv;
+            const bool recv_more = SocketHandlerNode(
+                *pnode, events & Sock::SEND, (events & Sock::RECV) && !paused,
+                events & Sock::ERR);
+            if (recv_more || (paused && (events & Sock::RECV))) {
+                m_sock_pending_recv.insert(pnode->GetId());
+            } else {
+                m_sock_pending_recv.erase(pnode->GetId());
+            }
+        }
+        pnode->Release();
+    }
+
+    // Accept new connections from listening sockets.
+    for (const size_t listen_index : listening) {
+        if (interruptNet) {
+            return;
+        }
+        AcceptConnection(vhListenSocket[listen_index]);
+    }
+
+    // The idle nodes have no events, check all of them for inactivity once in
+    // a while.
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= m_last_sock_full_pass + full_pass_interval) {
+        m_last_sock_full_pass = now;
+        const NodesSnapshot snap{*this, /*shuffle=*/false};
+        for (CNode *pnode : snap.Nodes()) {
+            if (InactivityCheck(*pnode)) {
+                pnode->fDisconnect = true;
+            }
+        }
+    }
+}
+
+void CConnman::InsertNode(CNode *pnode) {
+    LOCK(m_nodes_mutex);
+    if (m_sock_events) {
+        LOCK(pnode->m_sock_mutex);
+        if (!pnode->m_sock ||
+            !m_sock_events->Add(*pnode->m_sock, Sock::RECV | Sock::SEND,
+                                uintptr_t(pnode->GetId()),
+                                /*edge_triggered=*/true)) {
+            LogPrint(BCLog::NET, "failed to register socket for peer=%d\n",
+                     pnode->GetId());
+            pnode->fDisconnect = true;
+        }
+    }
+    m_nodes.push_back(pnode);
+    m_nodes_by_id.emplace(pnode->GetId(), pnode);
+}
+
 void CConnman::ThreadSocketHandler() {
     while (!interruptNet) {
         DisconnectNodes();
         NotifyNumConnectionsChanged();
-        SocketHandler();
+        if (m_sock_events) {
+            SocketHandlerEvents();
+        } else {
+            SocketHandler();
+        }
     }
 }
 
 void CConnman::WakeMessageHandler() {
+    size_t num_handlers;
     {
         LOCK(mutexMsgProc);
-        fMsgProcWake = true;
+        num_handlers = m_num_msghandlers;
+        std::fill_n(m_msgproc_wake.begin(), num_handlers, true);
+    }
+    for (size_t i = 0; i < num_handlers; ++i) {
+        m_msgproc_cond[i].notify_one();
     }
-    condMsgProc.notify_one();
+}
+
+void CConnman::WakeMessageHandler(NodeId id) {
+    size_t handler;
+    {
+        LOCK(mutexMsgProc);
+        if (m_num_msghandlers == 0) {
+            return;
+        }
+        handler = size_t(id) % m_num_msghandlers;
+        m_msgproc_wake[handler] = true;
+    }
+    m_msgproc_cond[handler].notify_one();
 }
 
 void CConnman::ThreadDNSAddressSeed() {
@@ -1903,13 +2221,38 @@ void CConnman::ThreadDNSAddressSeed() {
     LogPrintf("%d addresses found from DNS seeds\n", found);
 }
 
-void CConnman::DumpAddresses() {
+void CConnman::DumpAddresses(bool background) {
+    LOCK(m_dump_addresses_mutex);
+    if (background && m_dumping_addresses) {
+        LogPrint(BCLog::NET,
+                 "Skipped dumping peers.dat, still writing the last one\n");
+        return;
+    }
+    if (m_dump_addresses_thread.joinable()) {
+        m_dump_addresses_thread.join();
+    }
+
     int64_t nStart = GetTimeMillis();
 
-    DumpPeerAddresses(config->GetChainParams(), ::gArgs, addrman);
+    auto peers = std::make_shared<CDataStream>(SER_DISK, CLIENT_VERSION);
+    if (!SerializePeerAddresses(config->GetChainParams(), addrman, *peers)) {
+        return;
+    }
+    const size_t num_addresses{addrman.size()};
 
-    LogPrint(BCLog::NET, "Flushed %d addresses to peers.dat  %dms\n",
-             addrman.size(), GetTimeMillis() - nStart);
+    auto write = [this, peers, num_addresses, nStart] {
+        WritePeerAddresses(::gArgs, *peers);
+        LogPrint(BCLog::NET, "Flushed %d addresses to peers.dat  %dms\n",
+                 num_addresses, GetTimeMillis() - nStart);
+        m_dumping_addresses = false;
+    };
+    m_dumping_addresses = true;
+    if (background) {
+        m_dump_addresses_thread =
+            std::thread(&util::TraceThread, "addrdump", std::move(write));
+    } else {
+        write();
+    }
 }
 
 void CConnman::ProcessAddrFetch() {
@@ -2462,17 +2805,10 @@ void CConnman::OpenNetworkConnection(const CAddress &addrConnect,
         interface->InitializeNode(*config, *pnode, nLocalServices);
     }
 
-    {
-        LOCK(m_nodes_mutex);
-        m_nodes.push_back(pnode);
-    }
+    InsertNode(pnode);
 }
 
-Mutex NetEventsInterface::g_msgproc_mutex;
-
-void CConnman::ThreadMessageHandler() {
-    LOCK(NetEventsInterface::g_msgproc_mutex);
-
+void CConnman::ThreadMessageHandler(size_t handler, size_t num_handlers) {
     while (!flagInterruptMsgProc) {
         bool fMoreWork = false;
 
@@ -2483,7 +2819,10 @@ void CConnman::ThreadMessageHandler() {
             const NodesSnapshot snap{*this, /*shuffle=*/true};
 
             for (CNode *pnode : snap.Nodes()) {
-                if (pnode->fDisconnect) {
+                // A peer always goes to the same thread, so its messages are
+                // processed and sent in order.
+                if (pnode->fDisconnect ||
+                    size_t(pnode->GetId()) % num_handlers != handler) {
                     continue;
                 }
 
@@ -2511,13 +2850,15 @@ void CConnman::ThreadMessageHandler() {
 
         WAIT_LOCK(mutexMsgProc, lock);
         if (!fMoreWork) {
-            condMsgProc.wait_until(lock,
-                                   std::chrono::steady_clock::now() +
-                                       std::chrono::milliseconds(100),
-                                   [this]() EXCLUSIVE_LOCKS_REQUIRED(
-                                       mutexMsgProc) { return fMsgProcWake; });
+            m_msgproc_cond[handler].wait_until(
+                lock,
+                std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(100),
+                [&]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) {
+                    return m_msgproc_wake[handler];
+                });
         }
-        fMsgProcWake = false;
+        m_msgproc_wake[handler] = false;
     }
 }
 
@@ -2711,6 +3052,8 @@ CConnman::CConnman(const Config &configIn, uint64_t nSeed0In, uint64_t nSeed1In,
     : config(&configIn), addrman(addrmanIn), nSeed0(nSeed0In),
       nSeed1(nSeed1In) {
     SetTryNewOutboundPeer(false);
+    WITH_LOCK(m_process_time_mutex,
+              m_process_time_per_msg_cmd = EmptyProcessTimePerMsgCmd());
 
     Options connOptions;
     Init(connOptions);
@@ -2783,6 +3126,21 @@ bool CConnman::Start(CScheduler &scheduler, const Options &connOptions) {
         return false;
     }
 
+    if (m_use_sock_events) {
+        m_sock_events = std::make_unique<SockEvents>();
+        bool registered = m_sock_events->IsValid();
+        for (size_t i = 0; registered && i < vhListenSocket.size(); ++i) {
+            registered = m_sock_events->Add(*vhListenSocket[i].sock,
+                                            Sock::RECV, ListenSocketTag(i),
+                                            /*edge_triggered=*/false);
+        }
+        if (!registered) {
+            LogPrintf("Socket events are not available, polling the sockets "
+                      "instead\n");
+            m_sock_events.reset();
+        }
+    }
+
     proxyType i2p_sam;
     if (GetProxy(NET_I2P, i2p_sam)) {
         m_i2p_sam_session = std::make_unique<i2p::sam::Session>(
@@ -2834,7 +3192,8 @@ bool CConnman::Start(CScheduler &scheduler, const Options &connOptions) {
 
     {
         LOCK(mutexMsgProc);
-        fMsgProcWake = false;
+        m_msgproc_wake.fill(false);
+        m_num_msghandlers = m_msghandler_threads;
     }
 
     // Send and receive from sockets, accept connections
@@ -2871,9 +3230,21 @@ bool CConnman::Start(CScheduler &scheduler, const Options &connOptions) {
                         });
     }
 
-    // Process messages
-    threadMessageHandler = std::thread(&util::TraceThread, "msghand",
-                                       [this] { ThreadMessageHandler(); });
+    // Process messages, with the peers spread over the message handler
+    // threads.
+    const size_t num_handlers = m_msghandler_threads;
+    for (size_t i = 0; i < num_handlers; ++i) {
+        m_msghandler_thread_pool.emplace_back([this, i, num_handlers] {
+            const std::string name{
+                num_handlers == 1 ? "msghand" : strprintf("msghand.%d", i)};
+            util::TraceThread(name.c_str(), [this, i, num_handlers] {
+                ThreadMessageHandler(i, num_handlers);
+            });
+        });
+    }
+    if (num_handlers > 1) {
+        LogPrintf("Processing peer messages on %d threads\n", num_handlers);
+    }
 
     if (connOptions.m_i2p_accept_incoming &&
         m_i2p_sam_session.get() != nullptr) {
@@ -2885,10 +3256,10 @@ bool CConnman::Start(CScheduler &scheduler, const Options &connOptions) {
     // Dump network addresses
     scheduler.scheduleEvery(
         [this]() {
-            this->DumpAddresses();
+            this->DumpAddresses(/*background=*/true);
             return true;
         },
-        DUMP_PEERS_INTERVAL);
+        DUMP_PEERS_INTERVAL, CScheduler::Priority::LOW);
 
     return true;
 }
@@ -2911,7 +3282,9 @@ void CConnman::Interrupt() {
         LOCK(mutexMsgProc);
         flagInterruptMsgProc = true;
     }
-    condMsgProc.notify_all();
+    for (std::condition_variable &cond : m_msgproc_cond) {
+        cond.notify_all();
+    }
 
     interruptNet();
     InterruptSocks5(true);
@@ -2933,9 +3306,11 @@ void CConnman::StopThreads() {
     if (threadI2PAcceptIncoming.joinable()) {
         threadI2PAcceptIncoming.join();
     }
-    if (threadMessageHandler.joinable()) {
-        threadMessageHandler.join();
+    for (std::thread &thread : m_msghandler_thread_pool) {
+        thread.join();
     }
+    m_msghandler_thread_pool.clear();
+    WITH_LOCK(mutexMsgProc, m_num_msghandlers = 0);
     if (threadOpenConnections.joinable()) {
         threadOpenConnections.join();
     }
@@ -2970,7 +3345,11 @@ void CConnman::StopNodes() {
 
     // Delete peer connections.
     std::vector<CNode *> nodes;
-    WITH_LOCK(m_nodes_mutex, nodes.swap(m_nodes));
+    {
+        LOCK(m_nodes_mutex);
+        nodes.swap(m_nodes);
+        m_nodes_by_id.clear();
+    }
     for (CNode *pnode : nodes) {
         pnode->CloseSocketDisconnect();
         DeleteNode(pnode);
@@ -2980,6 +3359,8 @@ void CConnman::StopNodes() {
         DeleteNode(pnode);
     }
     m_nodes_disconnected.clear();
+    m_sock_pending_recv.clear();
+    m_sock_events.reset();
     vhListenSocket.clear();
     semOutbound.reset();
     semAddnode.reset();
@@ -2996,6 +3377,10 @@ void CConnman::DeleteNode(CNode *pnode) {
 CConnman::~CConnman() {
     Interrupt();
     Stop();
+    LOCK(m_dump_addresses_mutex);
+    if (m_dump_addresses_thread.joinable()) {
+        m_dump_addresses_thread.join();
+    }
 }
 
 std::vector<CAddress>
@@ -3024,6 +3409,7 @@ CConnman::GetAddresses(CNode &requestor, size_t max_addresses, size_t max_pct) {
             .Write(local_socket_bytes.data(), local_socket_bytes.size())
             .Finalize();
     const auto current_time = GetTime<std::chrono::microseconds>();
+    LOCK(m_addr_response_caches_mutex);
     auto r = m_addr_response_caches.emplace(cache_id, CachedAddrResponse{});
     CachedAddrResponse &cache_entry = r.first->second;
     // New CachedAddrResponse have expiration 0.
@@ -3250,6 +3636,22 @@ uint64_t CConnman::GetTotalBytesSent() const {
     return nTotalBytesSent;
 }
 
+void CConnman::RecordMessageProcessTime(CNode &node,
+                                        const std::string &msg_type,
+                                        const MsgProcessTime &time) {
+    {
+        LOCK(node.m_process_time_mutex);
+        AddProcessTime(node.mapProcessTimePerMsgCmd, msg_type, time);
+    }
+    LOCK(m_process_time_mutex);
+    AddProcessTime(m_process_time_per_msg_cmd, msg_type, time);
+}
+
+mapMsgCmdProcessTime CConnman::GetProcessTimePerMsgCmd() const {
+    LOCK(m_process_time_mutex);
+    return m_process_time_per_msg_cmd;
+}
+
 ServiceFlags CConnman::GetLocalServices() const {
     return nLocalServices;
 }
@@ -3311,6 +3713,8 @@ CNode::CNode(NodeId idIn, std::shared_ptr<Sock> sock, const CAddress &addrIn,
         mapRecvBytesPerMsgCmd[msg] = 0;
     }
     mapRecvBytesPerMsgCmd[NET_MESSAGE_COMMAND_OTHER] = 0;
+    WITH_LOCK(m_process_time_mutex,
+              mapProcessTimePerMsgCmd = EmptyProcessTimePerMsgCmd());
 
     if (fLogIPs) {
         LogPrint(BCLog::NET, "Added connection to %s peer=%d\n", m_addr_name,
@@ -3322,8 +3726,17 @@ CNode::CNode(NodeId idIn, std::shared_ptr<Sock> sock, const CAddress &addrIn,
     m_deserializer = std::make_unique<V1TransportDeserializer>(
         V1TransportDeserializer(GetConfig().GetChainParams().NetMagic(),
                                 SER_NETWORK, INIT_PROTO_VERSION));
-    m_serializer =
-        std::make_unique<V1TransportSerializer>(V1TransportSerializer());
+    m_serializer = std::make_unique<V1TransportSerializer>();
+}
+
+bool CNode::AcceptCompressedMessages() {
+    LOCK(cs_vRecv);
+    return m_deserializer->EnableDecompression();
+}
+
+bool CNode::CompressSentMessages() {
+    LOCK(cs_vSend);
+    return m_serializer->EnableCompression();
 }
 
 bool CConnman::NodeFullyConnected(const CNode *pnode) {
@@ -3331,38 +3744,64 @@ bool CConnman::NodeFullyConnected(const CNode *pnode) {
 }
 
 void CConnman::PushMessage(CNode *pnode, CSerializedNetMsg &&msg) {
-    size_t nMessageSize = msg.data.size();
-    LogPrint(BCLog::NETDEBUG, "sending %s (%d bytes) peer=%d\n", msg.m_type,
+    PushMessage(pnode,
+                std::make_shared<const CSerializedNetMsg>(std::move(msg)));
+}
+
+void CConnman::PushMessage(
+    CNode *pnode, const std::shared_ptr<const CSerializedNetMsg> &msg) {
+    size_t nMessageSize = msg->data.size();
+    LogPrint(BCLog::NETDEBUG, "sending %s (%d bytes) peer=%d\n", msg->m_type,
              nMessageSize, pnode->GetId());
     if (gArgs.GetBoolArg("-capturemessages", false)) {
-        CaptureMessage(pnode->addr, msg.m_type, msg.data,
+        CaptureMessage(pnode->addr, msg->m_type, msg->data,
                        /*is_incoming=*/false);
     }
 
     TRACE6(net, outbound_message, pnode->GetId(), pnode->m_addr_name.c_str(),
-           pnode->ConnectionTypeAsString().c_str(), msg.m_type.c_str(),
-           msg.data.size(), msg.data.data());
+           pnode->ConnectionTypeAsString().c_str(), msg->m_type.c_str(),
+           msg->data.size(), msg->data.data());
 
     // make sure we use the appropriate network transport format
     std::vector<uint8_t> serializedHeader;
-    pnode->m_serializer->prepareForTransport(*config, msg, serializedHeader);
-    size_t nTotalSize = nMessageSize + serializedHeader.size();
+    // The compressed messages share a stream, so they are prepared in the
+    // order they are queued.
+    const bool compress{pnode->m_serializer->ShouldCompress(*msg)};
+    if (!compress) {
+        pnode->m_serializer->prepareForTransport(*config, *msg,
+                                                 serializedHeader);
+    }
 
     size_t nBytesSent = 0;
     {
         LOCK(pnode->cs_vSend);
+        std::vector<uint8_t> compressed;
+        if (compress && !pnode->m_serializer->prepareCompressed(
+                            *config, *msg, serializedHeader, compressed)) {
+            pnode->m_serializer->prepareForTransport(*config, *msg,
+                                                     serializedHeader);
+        }
+        const size_t nPayloadSize{compressed.empty() ? nMessageSize
+                                                     : compressed.size()};
+        const size_t nTotalSize = nPayloadSize + serializedHeader.size();
         bool optimisticSend(pnode->vSendMsg.empty());
 
         // log total amount of bytes per message type
-        pnode->mapSendBytesPerMsgCmd[msg.m_type] += nTotalSize;
+        pnode->mapSendBytesPerMsgCmd[msg->m_type] += nTotalSize;
         pnode->nSendSize += nTotalSize;
 
         if (pnode->nSendSize > nSendBufferMaxSize) {
             pnode->fPauseSend = true;
         }
-        pnode->vSendMsg.push_back(std::move(serializedHeader));
-        if (nMessageSize) {
-            pnode->vSendMsg.push_back(std::move(msg.data));
+        pnode->vSendMsg.push_back(std::make_shared<const std::vector<uint8_t>>(
+            std::move(serializedHeader)));
+        if (!compressed.empty()) {
+            pnode->vSendMsg.push_back(
+                std::make_shared<const std::vector<uint8_t>>(
+                    std::move(compressed)));
+        } else if (nMessageSize) {
+            // Share the payload, the message is kept alive by the queue.
+            pnode->vSendMsg.emplace_back(msg, &msg->data);
         }
 
         // If write queue empty, attempt "optimistic write"
@@ -21,6 +21,7 @@
 #include <net_permissions.h>
 #include <netaddress.h>
 #include <netbase.h>
+#include <netcompression.h>
 #include <nodeid.h>
 #include <protocol.h>
 #include <pubkey.h>
@@ -33,8 +34,11 @@
 #include <uint256.h>
 #include <util/check.h>
 #include <util/sock.h>
+#include <util/sockevents.h>
 #include <util/time.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -43,7 +47,9 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 class AddrMan;
@@ -102,6 +108,12 @@ static const bool DEFAULT_DNSSEED = true;
 static const bool DEFAULT_FIXEDSEEDS = true;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER = 1 * 1000;
+/** -msghandlers default */
+static const int DEFAULT_MSGHANDLER_THREADS = 1;
+/** Maximum number of message handler threads */
+static const int MAX_MSGHANDLER_THREADS = 16;
+/** -sockevents default */
+static const bool DEFAULT_USE_SOCK_EVENTS = false;
 
 struct AddedNodeInfo {
     std::string strAddedNode;
@@ -279,6 +291,25 @@ extern const std::string NET_MESSAGE_COMMAND_OTHER;
 // Command, total bytes
 typedef std::map<std::string, uint64_t> mapMsgCmdSize;
 
+/** The time spent processing messages. */
+struct MsgProcessTime {
+    uint64_t count{0};
+    //! CPU time of the message handler thread.
+    std::chrono::microseconds cpu{0};
+    //! Wall clock time, which also accounts for the time spent waiting for
+    //! locks and disk reads.
+    std::chrono::microseconds wall{0};
+
+    MsgProcessTime &operator+=(const MsgProcessTime &other) {
+        count += other.count;
+        cpu += other.cpu;
+        wall += other.wall;
+        return *this;
+    }
+};
+// Command, processing time
+typedef std::map<std::string, MsgProcessTime> mapMsgCmdProcessTime;
+
 /**
  * POD that contains various stats about a node.
  * Usually constructed from CConman::GetNodeStats. Stats are filled from the
@@ -306,6 +337,7 @@ struct CNodeStats {
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     uint64_t nRecvBytes;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdProcessTime mapProcessTimePerMsgCmd;
     NetPermissionFlags m_permission_flags;
     std::chrono::microseconds m_last_ping_time;
     std::chrono::microseconds m_min_ping_time;
@@ -363,6 +395,11 @@ public:
     // decomposes a message from the context
     virtual CNetMessage GetMessage(const Config &config,
                                    std::chrono::microseconds time) = 0;
+    /**
+     * Accept the compressed messages of the peer from now on. Return false if
+     * the transport does not support them.
+     */
+    virtual bool EnableDecompression() { return false; }
     virtual ~TransportDeserializer() {}
 };
 
@@ -381,10 +418,17 @@ private:
     CDataStream vRecv;
     uint32_t nHdrPos;
     uint32_t nDataPos;
+    //! Set once the compressed messages are accepted
+    std::unique_ptr<P2PDecompressor> m_decompressor;
 
     const uint256 &GetMessageHash() const;
     int readHeader(const Config &config, Span<const uint8_t> msg_bytes);
     int readData(Span<const uint8_t> msg_bytes);
+    /**
+     * Replace the complete compressed message by the one it wraps. Return
+     * false if it is invalid.
+     */
+    bool Decompress(const Config &config);
 
     void Reset() {
         vRecv.clear();
@@ -420,6 +464,10 @@ public:
     }
     int Read(const Config &config, Span<const uint8_t> &msg_bytes) override {
         int ret = in_data ? readData(msg_bytes) : readHeader(config, msg_bytes);
+        if (ret >= 0 && m_decompressor && Complete() &&
+            hdr.GetCommand() == NetMsgType::COMPRESSED && !Decompress(config)) {
+            ret = -1;
+        }
         if (ret < 0) {
             Reset();
         } else {
@@ -430,6 +478,7 @@ public:
 
     CNetMessage GetMessage(const Config &config,
                            std::chrono::microseconds time) override;
+    bool EnableDecompression() override;
 };
 
 /**
@@ -440,15 +489,53 @@ public:
     // prepare message for transport (header construction, error-correction
     // computation, payload encryption, etc.)
     virtual void prepareForTransport(const Config &config,
-                                     CSerializedNetMsg &msg,
+                                     const CSerializedNetMsg &msg,
                                      std::vector<uint8_t> &header) = 0;
+    /**
+     * Compress the messages sent from now on, once the peer accepts them.
+     * Return false if the transport does not support it.
+     */
+    virtual bool EnableCompression() { return false; }
+    /** Whether the message should be prepared with prepareCompressed. */
+    virtual bool ShouldCompress(const CSerializedNetMsg &msg) const {
+        return false;
+    }
+    /**
+     * Prepare the header and the payload of the message compressed. The
+     * compressed messages share a stream, so they must be prepared in the
+     * order they are sent. Return false if the message should be sent as is.
+     */
+    virtual bool prepareCompressed(const Config &config,
+                                   const CSerializedNetMsg &msg,
+                                   std::vector<uint8_t> &header,
+                                   std::vector<uint8_t> &payload) {
+        return false;
+    }
     virtual ~TransportSerializer() {}
 };
 
 class V1TransportSerializer : public TransportSerializer {
+    //! The compressed and uncompressed sizes of the messages of a type
+    struct CompressionStats {
+        uint64_t compressed{0};
+        uint64_t uncompressed{0};
+    };
+
+    std::atomic<bool> m_compress{false};
+    std::unique_ptr<P2PCompressor> m_compressor;
+    std::map<std::string, CompressionStats> m_compression_stats;
+
 public:
-    void prepareForTransport(const Config &config, CSerializedNetMsg &msg,
+    void prepareForTransport(const Config &config,
+                             const CSerializedNetMsg &msg,
                              std::vector<uint8_t> &header) override;
+    bool EnableCompression() override;
+    bool ShouldCompress(const CSerializedNetMsg &msg) const override {
+        return m_compress && msg.data.size() >= P2P_COMPRESSION_MIN_SIZE;
+    }
+    bool prepareCompressed(const Config &config, const CSerializedNetMsg &msg,
+                           std::vector<uint8_t> &header,
+                           std::vector<uint8_t> &payload) override;
 };
 
 struct CNodeOptions {
@@ -483,7 +570,12 @@ public:
     /** Offset inside the first vSendMsg already sent */
     size_t nSendOffset GUARDED_BY(cs_vSend){0};
     uint64_t nSendBytes GUARDED_BY(cs_vSend){0};
-    std::deque<std::vector<uint8_t>> vSendMsg GUARDED_BY(cs_vSend);
+    /**
+     * The serialized headers and payloads to send. The payloads are shared
+     * with the message they come from, which may be queued for other peers.
+     */
+    std::deque<std::shared_ptr<const std::vector<uint8_t>>>
+        vSendMsg GUARDED_BY(cs_vSend);
     Mutex cs_vSend;
     Mutex m_sock_mutex;
     Mutex cs_vRecv;
@@ -743,6 +835,17 @@ public:
     bool ReceiveMsgBytes(const Config &config, Span<const uint8_t> msg_bytes,
                          bool &complete) EXCLUSIVE_LOCKS_REQUIRED(!cs_vRecv);
 
+    /**
+     * Accept compressed messages from the peer, which must be done before
+     * sending it SENDCOMPRESSED. Return false if that is not supported.
+     */
+    bool AcceptCompressedMessages() EXCLUSIVE_LOCKS_REQUIRED(!cs_vRecv);
+    /**
+     * Compress the messages sent to the peer once it sent SENDCOMPRESSED.
+     * Return false if that is not supported.
+     */
+    bool CompressSentMessages() EXCLUSIVE_LOCKS_REQUIRED(!cs_vSend);
+
     void SetCommonVersion(int greatest_common_version) {
         Assume(m_greatest_common_version == INIT_PROTO_VERSION);
         m_greatest_common_version = greatest_common_version;
@@ -765,7 +868,7 @@ public:
 
     void copyStats(CNodeStats &stats)
         EXCLUSIVE_LOCKS_REQUIRED(!m_subver_mutex, !m_addr_local_mutex,
-                                 !cs_vSend, !cs_vRecv);
+                                 !cs_vSend, !cs_vRecv, !m_process_time_mutex);
 
     std::string ConnectionTypeAsString() const {
         return ::ConnectionTypeAsString(m_conn_type);
@@ -797,6 +900,9 @@ private:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd GUARDED_BY(cs_vSend);
     mapMsgCmdSize mapRecvBytesPerMsgCmd GUARDED_BY(cs_vRecv);
+    Mutex m_process_time_mutex;
+    mapMsgCmdProcessTime
+        mapProcessTimePerMsgCmd GUARDED_BY(m_process_time_mutex);
 };
 
 /**
@@ -804,11 +910,6 @@ private:
  */
 class NetEventsInterface {
 public:
-    /**
-     * Mutex for anything that is only accessed via the msg processing thread
-     */
-    static Mutex g_msgproc_mutex;
-
     /** Initialize a peer (setup state, queue any initial messages) */
     virtual void InitializeNode(const Config &config, CNode &node,
                                 ServiceFlags our_services) = 0;
@@ -817,7 +918,8 @@ public:
     virtual void FinalizeNode(const Config &config, const CNode &node) = 0;
 
     /**
-     * Process protocol messages received from a given node
+     * Process protocol messages received from a given node. The message
+     * handler threads may call this concurrently for different nodes.
      *
      * @param[in]   config          The applicable configuration object.
      * @param[in]   pnode           The node which we have received messages
@@ -826,8 +928,7 @@ public:
      * @return                      True if there is more work to be done
      */
     virtual bool ProcessMessages(const Config &config, CNode *pnode,
-                                 std::atomic<bool> &interrupt)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex) = 0;
+                                 std::atomic<bool> &interrupt) = 0;
 
     /**
      * Send queued protocol messages to a given node.
@@ -836,8 +937,7 @@ public:
      * @param[in]   pnode           The node which we are sending messages to.
      * @return                      True if there is more work to be done
      */
-    virtual bool SendMessages(const Config &config, CNode *pnode)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex) = 0;
+    virtual bool SendMessages(const Config &config, CNode *pnode) = 0;
 
 protected:
     /**
@@ -885,6 +985,8 @@ public:
         bool m_i2p_accept_incoming = true;
         bool whitelist_forcerelay = DEFAULT_WHITELISTFORCERELAY;
         bool whitelist_relay = DEFAULT_WHITELISTRELAY;
+        int m_msghandler_threads = DEFAULT_MSGHANDLER_THREADS;
+        bool m_use_sock_events = DEFAULT_USE_SOCK_EVENTS;
     };
 
     void Init(const Options &connOptions)
@@ -927,6 +1029,9 @@ public:
         m_onion_binds = connOptions.onion_binds;
         whitelist_forcerelay = connOptions.whitelist_forcerelay;
         whitelist_relay = connOptions.whitelist_relay;
+        m_msghandler_threads = std::clamp(connOptions.m_msghandler_threads, 1,
+                                          MAX_MSGHANDLER_THREADS);
+        m_use_sock_events = connOptions.m_use_sock_events;
     }
 
     CConnman(const Config &configIn, uint64_t seed0, uint64_t seed1,
@@ -956,6 +1061,12 @@ public:
     bool ForNode(NodeId id, std::function<bool(CNode *pnode)> func);
 
     void PushMessage(CNode *pnode, CSerializedNetMsg &&msg);
+    /**
+     * Queue a message which may be sent to several peers. Its payload is
+     * referenced by the send queue of each peer rather than copied.
+     */
+    void PushMessage(CNode *pnode,
+                     const std::shared_ptr<const CSerializedNetMsg> &msg);
 
     using NodeFn = std::function<void(CNode *)>;
     void ForEachNode(const NodeFn &func) {
@@ -996,7 +1107,8 @@ public:
      * call the function without a parameter to avoid using the cache.
      */
     std::vector<CAddress> GetAddresses(CNode &requestor, size_t max_addresses,
-                                       size_t max_pct);
+                                       size_t max_pct)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_addr_response_caches_mutex);
 
     // This allows temporarily exceeding m_max_outbound_full_relay, with the
     // goal of finding a peer that is better than all our current peers.
@@ -1075,12 +1187,23 @@ public:
     uint64_t GetTotalBytesRecv() const;
     uint64_t GetTotalBytesSent() const;
 
+    /** Account for the time spent processing a message from this node. */
+    void RecordMessageProcessTime(CNode &node, const std::string &msg_type,
+                                  const MsgProcessTime &time)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_process_time_mutex);
+    /** The time spent processing the messages of all the nodes. */
+    mapMsgCmdProcessTime GetProcessTimePerMsgCmd() const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_process_time_mutex);
+
     /** Get a unique deterministic randomizer. */
     CSipHasher GetDeterministicRandomizer(uint64_t id) const;
 
     unsigned int GetReceiveFloodSize() const;
 
+    /** Wake up all the message handler threads. */
     void WakeMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    /** Wake up the message handler thread of a peer. */
+    void WakeMessageHandler(NodeId id) EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
 
     /**
      * Return true if we should disconnect the peer for failing an inactivity
@@ -1121,7 +1244,12 @@ private:
                               mockOpenConnection)
         EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_added_nodes_mutex,
                                  !m_nodes_mutex);
-    void ThreadMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+    /**
+     * Process the messages of the peers assigned to a message handler thread,
+     * the ones with id % num_handlers == handler.
+     */
+    void ThreadMessageHandler(size_t handler, size_t num_handlers)
+        EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
     void ThreadI2PAcceptIncoming();
     void AcceptConnection(const ListenSocket &hListenSocket);
 
@@ -1172,6 +1300,31 @@ private:
      */
     void SocketHandlerListening(const Sock::EventsPerSock &events_per_sock);
 
+    /**
+     * Send to and receive from the socket of a connected node.
+     * @param[in] node The node to service.
+     * @param[in] send_set Whether the socket is ready for sending.
+     * @param[in] recv_set Whether the socket is ready for receiving.
+     * @param[in] error_set Whether an error occurred on the socket.
+     * @return true if the socket may still have data to receive, i.e. the
+     *     receive was skipped or did not find the socket drained.
+     */
+    bool SocketHandlerNode(CNode &node, bool send_set, bool recv_set,
+                           bool error_set)
+        EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+
+    /**
+     * Same as SocketHandler(), but only wait for and process the sockets on
+     * which something happened, as reported by `m_sock_events`.
+     */
+    void SocketHandlerEvents() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
+
+    /**
+     * Add a new node to `m_nodes` and register its socket with
+     * `m_sock_events`, if in use.
+     */
+    void InsertNode(CNode *pnode) EXCLUSIVE_LOCKS_REQUIRED(!m_nodes_mutex);
+
     void ThreadSocketHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
     void ThreadDNSAddressSeed()
         EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_nodes_mutex);
@@ -1207,7 +1360,13 @@ private:
     std::pair<size_t, bool> SocketSendData(CNode &node) const
         EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend);
 
-    void DumpAddresses();
+    /**
+     * Write addrman to peers.dat. In the background, only the serialization
+     * in memory is done right away, and the file is written by another
+     * thread. A dump is skipped if the previous one is still being written.
+     */
+    void DumpAddresses(bool background = false)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_dump_addresses_mutex);
 
     // Network stats
     void RecordBytesRecv(uint64_t bytes);
@@ -1227,6 +1386,9 @@ private:
     mutable RecursiveMutex cs_totalBytesSent;
     std::atomic<uint64_t> nTotalBytesRecv{0};
     uint64_t nTotalBytesSent GUARDED_BY(cs_totalBytesSent){0};
+    mutable Mutex m_process_time_mutex;
+    mapMsgCmdProcessTime
+        m_process_time_per_msg_cmd GUARDED_BY(m_process_time_mutex);
 
     // outbound limit & stats
     uint64_t nMaxOutboundTotalBytesSentInCycle GUARDED_BY(cs_totalBytesSent){0};
@@ -1255,6 +1417,8 @@ private:
     std::vector<std::string> m_added_nodes GUARDED_BY(m_added_nodes_mutex);
     mutable Mutex m_added_nodes_mutex;
     std::vector<CNode *> m_nodes GUARDED_BY(m_nodes_mutex);
+    /** The nodes of `m_nodes` by id, used to resolve socket events. */
+    std::unordered_map<NodeId, CNode *> m_nodes_by_id GUARDED_BY(m_nodes_mutex);
     std::list<CNode *> m_nodes_disconnected;
     mutable RecursiveMutex m_nodes_mutex;
     std::atomic<NodeId> nLastNodeId{0};
@@ -1285,7 +1449,9 @@ private:
      * resulting in at most ~196 KB. Every separate local socket may
      * add up to ~196 KB extra.
      */
-    std::map<uint64_t, CachedAddrResponse> m_addr_response_caches;
+    Mutex m_addr_response_caches_mutex;
+    std::map<uint64_t, CachedAddrResponse>
+        m_addr_response_caches GUARDED_BY(m_addr_response_caches_mutex);
 
     /**
      * Services this node offers.
@@ -1335,13 +1501,34 @@ private:
     /** SipHasher seeds for deterministic randomness */
     const uint64_t nSeed0, nSeed1;
 
-    /** flag for waking the message processor. */
-    bool fMsgProcWake GUARDED_BY(mutexMsgProc);
+    /** The number of message handler threads to start. */
+    int m_msghandler_threads{DEFAULT_MSGHANDLER_THREADS};
+    /** The number of message handler threads running. */
+    size_t m_num_msghandlers GUARDED_BY(mutexMsgProc){0};
+    /** flags for waking each message processor. */
+    std::array<bool, MAX_MSGHANDLER_THREADS>
+        m_msgproc_wake GUARDED_BY(mutexMsgProc){};
 
-    std::condition_variable condMsgProc;
+    std::array<std::condition_variable, MAX_MSGHANDLER_THREADS> m_msgproc_cond;
     Mutex mutexMsgProc;
     std::atomic<bool> flagInterruptMsgProc{false};
 
+    /** Whether to wait for socket events with epoll or kqueue. */
+    bool m_use_sock_events{DEFAULT_USE_SOCK_EVENTS};
+    /**
+     * The event queue of the listening and connected sockets, null when
+     * waiting with Sock::WaitMany() instead. Set up in Start() before the
+     * socket handler thread is started.
+     */
+    std::unique_ptr<SockEvents> m_sock_events;
+    /**
+     * Nodes whose socket may still have data to receive, because socket
+     * events are only reported once. Used only by the socket handler thread.
+     */
+    std::set<NodeId> m_sock_pending_recv;
+    /** When the socket handler last checked all the nodes for inactivity. */
+    std::chrono::steady_clock::time_point m_last_sock_full_pass;
+
     /**
      * This is signaled when network activity should cease.
      * A pointer to it is saved in `m_i2p_sam_session`, so make sure that
@@ -1360,9 +1547,14 @@ private:
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
-    std::thread threadMessageHandler;
+    std::vector<std::thread> m_msghandler_thread_pool;
     std::thread threadI2PAcceptIncoming;
 
+    Mutex m_dump_addresses_mutex;
+    //! Writes peers.dat for the periodic dumps
+    std::thread m_dump_addresses_thread GUARDED_BY(m_dump_addresses_mutex);
+    std::atomic<bool> m_dumping_addresses{false};
+
     /**
      * flag for deciding to connect to an extra outbound peer, in excess of
      * m_max_outbound_full_relay. This takes the place of a feeler connection.
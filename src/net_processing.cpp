@@ -34,9 +34,13 @@
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
+#include <pow/auxpow.h>
+#include <pow/powcache.h>
 #include <primitives/block.h>
+#include <primitives/blockview.h>
 #include <primitives/transaction.h>
 #include <random.h>
+#include <relaymsgcache.h>
 #include <reverse_iterator.h>
 #include <scheduler.h>
 #include <streams.h>
@@ -45,18 +49,26 @@
 #include <txmempool.h>
 #include <txorphanage.h>
 #include <util/check.h> // For NDEBUG compile time check
+#include <util/metrics.h>
 #include <util/strencodings.h>
+#include <util/thread.h>
 #include <util/trace.h>
 #include <validation.h>
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
+#include <map>
 #include <memory>
 #include <numeric>
+#include <optional>
+#include <thread>
 #include <typeinfo>
+#include <utility>
 
 /** How long to cache transactions in mapRelay for normal relay */
 static constexpr auto RELAY_TX_CACHE_TIME = 15min;
@@ -65,6 +77,14 @@ static constexpr auto RELAY_TX_CACHE_TIME = 15min;
  * unconditionally be relayed (even when not in mapRelay).
  */
 static constexpr auto UNCONDITIONAL_RELAY_DELAY = 2min;
+/** How long an incoming transaction may wait for its batch to fill up. */
+static constexpr auto TX_BATCH_WINDOW = 50ms;
+/**
+ * How many transactions received from a peer may wait for the validation
+ * thread. The other messages of the peer are not processed while it has that
+ * many.
+ */
+static constexpr size_t MAX_PEER_TX_VALIDATION_QUEUE{100};
 /**
  * Headers download timeout.
  * Timeout = base + per_header * (expected number of headers)
@@ -117,6 +137,11 @@ static constexpr auto GETAVAADDR_INTERVAL{2min};
  * expired, the proof radix tree can be cleaned up.
  */
 static constexpr auto AVALANCHE_AVAPROOFS_TIMEOUT{2min};
+/**
+ * The number of blocks waiting for the block connection thread that are kept
+ * in memory. They are read back from disk beyond that.
+ */
+static constexpr size_t MAX_BLOCKS_TO_CONNECT{16};
 
 struct DataRequestParameters {
     /**
@@ -186,6 +211,15 @@ static const unsigned int MAX_GETDATA_SZ = 1000;
  * Number of blocks that can be requested at any given time from a single peer.
  */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
+/**
+ * During the block download, the number of blocks in flight from a peer is
+ * sized so that it keeps sending for BLOCK_DOWNLOAD_BUFFER_TIME plus its ping
+ * time, from how fast it sent the previous blocks. Peers which didn't send any
+ * block yet get MAX_BLOCKS_IN_TRANSIT_PER_PEER.
+ */
+static constexpr auto BLOCK_DOWNLOAD_BUFFER_TIME{4s};
+static constexpr int MIN_BLOCKS_IN_TRANSIT_PER_PEER{2};
+static constexpr int MAX_BLOCKS_IN_TRANSIT_PER_FAST_PEER{64};
 /**
  * Default time during which a peer must stall block download progress before
  * being disconnected. The actual timeout is increased temporarily if peers are
@@ -306,6 +340,29 @@ static constexpr uint64_t CMPCTBLOCKS_VERSION{1};
 
 // Internal stuff
 namespace {
+/** The histogram of the time spent handling the messages of this type. */
+metrics::Histogram &MessageHandlerTime(const std::string &msg_type) {
+    // Registered upfront, so the lookup doesn't need to take the registry
+    // lock and unknown message types don't register any metric.
+    static const std::map<std::string, metrics::Histogram *> histograms{[] {
+        std::map<std::string, metrics::Histogram *> map;
+        std::vector<std::string> types{getAllNetMessageTypes()};
+        types.push_back(NET_MESSAGE_COMMAND_OTHER);
+        for (const std::string &type : types) {
+            map.emplace(type,
+                        &metrics::GetHistogram(
+                            "net_message", "Time spent handling the messages",
+                            {"command", type}));
+        }
+        return map;
+    }()};
+    auto it = histograms.find(msg_type);
+    if (it == histograms.end()) {
+        it = histograms.find(NET_MESSAGE_COMMAND_OTHER);
+    }
+    return *it->second;
+}
+
 /**
  * Blocks that are in flight, and that are in the queue to be downloaded.
  */
@@ -317,6 +374,8 @@ struct QueuedBlock {
     const CBlockIndex *pindex;
     /** Optional, used for CMPCTBLOCK downloads */
     std::unique_ptr<PartiallyDownloadedBlock> partialBlock;
+    /** When the block was requested */
+    std::chrono::microseconds m_requested_time{0us};
 };
 
 /**
@@ -336,6 +395,13 @@ struct Peer {
     /** Same id as the CNode object for this peer */
     const NodeId m_id{0};
 
+    /**
+     * Protects the state only used while processing the messages of this
+     * peer and sending messages to it, held by the message handler thread
+     * of the peer for the time of ProcessMessages and SendMessages.
+     */
+    Mutex m_msgproc_mutex;
+
     /**
      * Services we offered to this peer.
      *
@@ -404,10 +470,9 @@ struct Peer {
      * It is *not* a p2p protocol violation for the peer to send us
      * transactions with a lower fee rate than this. See BIP133.
      */
-    Amount m_fee_filter_sent GUARDED_BY(NetEventsInterface::g_msgproc_mutex){
-        Amount::zero()};
+    Amount m_fee_filter_sent GUARDED_BY(m_msgproc_mutex){Amount::zero()};
     std::chrono::microseconds m_next_send_feefilter
-        GUARDED_BY(NetEventsInterface::g_msgproc_mutex){0};
+        GUARDED_BY(m_msgproc_mutex){0};
 
     struct TxRelay {
         mutable RecursiveMutex m_bloom_filter_mutex;
@@ -430,8 +495,7 @@ struct Peer {
 
         /** A rolling bloom filter of all announced tx CInvs to this peer. */
         CRollingBloomFilter m_recently_announced_invs GUARDED_BY(
-            NetEventsInterface::g_msgproc_mutex){INVENTORY_MAX_RECENT_RELAY,
-                                                 0.000001};
+            m_tx_inventory_mutex){INVENTORY_MAX_RECENT_RELAY, 0.000001};
 
         mutable RecursiveMutex m_tx_inventory_mutex;
         /**
@@ -499,8 +563,7 @@ struct Peer {
          * A rolling bloom filter of all announced Proofs CInvs to this peer.
          */
         CRollingBloomFilter m_recently_announced_proofs GUARDED_BY(
-            NetEventsInterface::g_msgproc_mutex){INVENTORY_MAX_RECENT_RELAY,
-                                                 0.000001};
+            m_proof_inventory_mutex){INVENTORY_MAX_RECENT_RELAY, 0.000001};
         std::chrono::microseconds m_next_inv_send_time{0};
 
         RadixTree<const avalanche::Proof, avalanche::ProofRadixTreeAdapter>
@@ -515,11 +578,15 @@ struct Peer {
      */
     const std::unique_ptr<ProofRelay> m_proof_relay;
 
+    /**
+     * Guards m_addrs_to_send and m_addr_known, which the message handler
+     * threads of the other peers relay addresses to.
+     */
+    Mutex m_addr_relay_mutex;
     /**
      * A vector of addresses to send to the peer, limited to MAX_ADDR_TO_SEND.
      */
-    std::vector<CAddress>
-        m_addrs_to_send GUARDED_BY(NetEventsInterface::g_msgproc_mutex);
+    std::vector<CAddress> m_addrs_to_send GUARDED_BY(m_addr_relay_mutex);
     /**
      * Probabilistic filter to track recent addr messages relayed with this
      * peer. Used to avoid relaying redundant addresses to this peer.
@@ -531,7 +598,7 @@ struct Peer {
      *  Presence of this filter must correlate with m_addr_relay_enabled.
      **/
     std::unique_ptr<CRollingBloomFilter>
-        m_addr_known GUARDED_BY(NetEventsInterface::g_msgproc_mutex);
+        m_addr_known GUARDED_BY(m_addr_relay_mutex);
     /**
      * Whether we are participating in address relay with this connection.
      *
@@ -550,7 +617,7 @@ struct Peer {
      */
     std::atomic_bool m_addr_relay_enabled{false};
     /** Whether a getaddr request to this peer is outstanding. */
-    bool m_getaddr_sent GUARDED_BY(NetEventsInterface::g_msgproc_mutex){false};
+    bool m_getaddr_sent GUARDED_BY(m_msgproc_mutex){false};
     /** Guards address sending timers. */
     mutable Mutex m_addr_send_times_mutex;
     /** Time point to send the next ADDR message to this peer. */
@@ -564,8 +631,13 @@ struct Peer {
      * messages, indicating a preference to receive ADDRv2 instead of ADDR ones.
      */
     std::atomic_bool m_wants_addrv2{false};
+    /**
+     * Dogecoin: whether the peer has signaled support for receiving
+     * AUXHEADERS messages, which we then send instead of HEADERS.
+     */
+    std::atomic_bool m_wants_aux_headers{false};
     /** Whether this peer has already sent us a getaddr message. */
-    bool m_getaddr_recvd GUARDED_BY(NetEventsInterface::g_msgproc_mutex){false};
+    bool m_getaddr_recvd GUARDED_BY(m_msgproc_mutex){false};
     /** Guards m_addr_token_bucket */
     mutable Mutex m_addr_token_bucket_mutex;
     /**
@@ -574,9 +646,8 @@ struct Peer {
      */
     double m_addr_token_bucket GUARDED_BY(m_addr_token_bucket_mutex){1.0};
     /** When m_addr_token_bucket was last updated */
-    std::chrono::microseconds
-        m_addr_token_timestamp GUARDED_BY(NetEventsInterface::g_msgproc_mutex){
-            GetTime<std::chrono::microseconds>()};
+    std::chrono::microseconds m_addr_token_timestamp
+        GUARDED_BY(m_msgproc_mutex){GetTime<std::chrono::microseconds>()};
     /** Total number of addresses that were dropped due to rate limiting. */
     std::atomic<uint64_t> m_addr_rate_limited{0};
     /**
@@ -590,7 +661,7 @@ struct Peer {
      * initial-headers-sync completing
      */
     bool m_inv_triggered_getheaders_before_sync
-        GUARDED_BY(NetEventsInterface::g_msgproc_mutex){false};
+        GUARDED_BY(m_msgproc_mutex){false};
 
     /** Protects m_getdata_requests **/
     Mutex m_getdata_requests_mutex;
@@ -599,7 +670,7 @@ struct Peer {
 
     /** Time of the last getheaders message to this peer */
     NodeClock::time_point m_last_getheaders_timestamp
-        GUARDED_BY(NetEventsInterface::g_msgproc_mutex){};
+        GUARDED_BY(m_msgproc_mutex){};
 
     /** Protects m_headers_sync **/
     Mutex m_headers_sync_mutex;
@@ -610,24 +681,29 @@ struct Peer {
     std::unique_ptr<HeadersSyncState>
         m_headers_sync PT_GUARDED_BY(m_headers_sync_mutex)
             GUARDED_BY(m_headers_sync_mutex){};
+    /**
+     * The hash of the last header of the headers message being processed, if
+     * the next headers were already requested from it, see
+     * HeadersSyncState::PipelinedHeadersRequestLocator.
+     */
+    BlockHash m_headers_sync_pipelined_hash
+        GUARDED_BY(m_headers_sync_mutex){};
 
     /** Whether we've sent our peer a sendheaders message. **/
     std::atomic<bool> m_sent_sendheaders{false};
 
     /** Length of current-streak of unconnecting headers announcements */
-    int m_num_unconnecting_headers_msgs
-        GUARDED_BY(NetEventsInterface::g_msgproc_mutex){0};
+    int m_num_unconnecting_headers_msgs GUARDED_BY(m_msgproc_mutex){0};
 
     /** When to potentially disconnect peer for stalling headers download */
     std::chrono::microseconds m_headers_sync_timeout
-        GUARDED_BY(NetEventsInterface::g_msgproc_mutex){0us};
+        GUARDED_BY(m_msgproc_mutex){0us};
 
     /**
      * Whether this peer wants invs or headers (when possible) for block
      * announcements
      */
-    bool m_prefers_headers GUARDED_BY(NetEventsInterface::g_msgproc_mutex){
-        false};
+    bool m_prefers_headers GUARDED_BY(m_msgproc_mutex){false};
 
     explicit Peer(NodeId id, ServiceFlags our_services, bool fRelayProofs)
         : m_id(id), m_our_services{our_services},
@@ -667,6 +743,12 @@ struct CNodeState {
     //! When the first entry in vBlocksInFlight started downloading. Don't care
     //! when vBlocksInFlight is empty.
     std::chrono::microseconds m_downloading_since{0us};
+    //! Moving average of the time this peer took to send each requested
+    //! block, counted from its request or the previous block, or 0 if it
+    //! didn't send any yet.
+    std::chrono::microseconds m_block_receive_interval{0us};
+    //! When this peer last sent a requested block
+    std::chrono::microseconds m_last_block_receive_time{0us};
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload{false};
     /**
@@ -732,6 +814,7 @@ public:
     PeerManagerImpl(CConnman &connman, AddrMan &addrman, BanMan *banman,
                     ChainstateManager &chainman, CTxMemPool &pool,
                     avalanche::Processor *const avalanche, Options opts);
+    ~PeerManagerImpl() override;
 
     /** Overridden from CValidationInterface. */
     void BlockConnected(const std::shared_ptr<const CBlock> &pblock,
@@ -750,6 +833,7 @@ public:
     void NewPoWValidBlock(const CBlockIndex *pindex,
                           const std::shared_ptr<const CBlock> &pblock) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex);
+    std::string GetSubscriberName() const override { return "peerman"; }
 
     /** Implement NetEventsInterface */
     void InitializeNode(const Config &config, CNode &node,
@@ -763,15 +847,19 @@ public:
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex,
                                  !m_recent_confirmed_transactions_mutex,
                                  !m_most_recent_block_mutex, !cs_proofrequest,
-                                 !m_headers_presync_mutex, g_msgproc_mutex);
+                                 !m_headers_presync_mutex, !m_tx_batch_mutex,
+                                 !m_tx_validation_mutex);
     bool SendMessages(const Config &config, CNode *pto) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex,
                                  !m_recent_confirmed_transactions_mutex,
-                                 !m_most_recent_block_mutex, !cs_proofrequest,
-                                 g_msgproc_mutex);
+                                 !m_most_recent_block_mutex, !cs_proofrequest);
 
     /** Implement PeerManager */
     void StartScheduledTasks(CScheduler &scheduler) override;
+    void StopTxValidation() override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_tx_validation_mutex);
+    void StopBlockConnection() override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_block_connect_mutex);
     void CheckForStaleTipAndEvictPeers() override;
     std::optional<std::string>
     FetchBlock(const Config &config, NodeId peer_id,
@@ -796,18 +884,31 @@ public:
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex,
                                  !m_recent_confirmed_transactions_mutex,
                                  !m_most_recent_block_mutex, !cs_proofrequest,
-                                 !m_headers_presync_mutex, g_msgproc_mutex);
+                                 !m_headers_presync_mutex, !m_tx_batch_mutex,
+                                 !m_tx_validation_mutex);
     void UpdateLastBlockAnnounceTime(NodeId node,
                                      int64_t time_in_seconds) override;
 
 private:
+    /** Process a single message from a peer whose state is locked. */
+    void ProcessMessage(const Config &config, CNode &pfrom,
+                        const PeerRef &peer, const std::string &msg_type,
+                        CDataStream &vRecv,
+                        const std::chrono::microseconds time_received,
+                        const std::atomic<bool> &interruptMsgProc)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex,
+                                 !m_recent_confirmed_transactions_mutex,
+                                 !m_most_recent_block_mutex, !cs_proofrequest,
+                                 !m_headers_presync_mutex, !m_tx_batch_mutex,
+                                 !m_tx_validation_mutex, peer->m_msgproc_mutex);
+
     /**
      * Consider evicting an outbound peer based on the amount of time they've
      * been behind our tip.
      */
     void ConsiderEviction(CNode &pto, Peer &peer,
                           std::chrono::seconds time_in_seconds)
-        EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, peer.m_msgproc_mutex);
 
     /**
      * If we have extra outbound peers, try to disconnect the one with the
@@ -908,7 +1009,7 @@ private:
     void ProcessInvalidTx(NodeId nodeid, const CTransactionRef &tx,
                           const TxValidationState &result,
                           bool maybe_add_extra_compact_tx)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, g_msgproc_mutex, cs_main);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, cs_main);
 
     struct PackageToValidate {
         const Package m_txns;
@@ -935,7 +1036,7 @@ private:
      */
     void ProcessPackageResult(const PackageToValidate &package_to_validate,
                               const PackageMempoolAcceptResult &package_result)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, g_msgproc_mutex, cs_main);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, cs_main);
 
     /**
      * Look for a child of this transaction in the orphanage to form a
@@ -945,7 +1046,7 @@ private:
      */
     std::optional<PackageToValidate> Find1P1CPackage(const CTransactionRef &ptx,
                                                      NodeId nodeid)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, g_msgproc_mutex, cs_main);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, cs_main);
 
     /**
      * Handle a transaction whose result was
@@ -953,7 +1054,7 @@ private:
      * m_orphanage. Also queues the tx for relay.
      */
     void ProcessValidTx(NodeId nodeid, const CTransactionRef &tx)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, g_msgproc_mutex, cs_main);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, cs_main);
 
     /**
      * Reconsider orphan transactions after a parent has been accepted to the
@@ -971,7 +1072,59 @@ private:
      *                     this peer will be empty.
      */
     bool ProcessOrphanTx(const Config &config, Peer &peer)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
+
+    /**
+     * Validate a transaction received from a peer and handle the result.
+     *
+     * This runs on the validation thread or while validating a batch, at the
+     * same time as the message handler threads. Everything it touches has a
+     * lock of its own: m_txrequest and the reject filters are guarded by
+     * cs_main, the orphanage and the conflicting pool by their own mutexes,
+     * the known tx filter of the peer by m_tx_inventory_mutex, the
+     * misbehavior score by m_misbehavior_mutex, the extra transactions by
+     * m_extra_txn_mutex and the random context by m_rng_mutex.
+     * @return whether the transaction should be reconciled by avalanche, which
+     *     must be done after releasing cs_main.
+     */
+    bool ProcessIncomingTx(CNode &pfrom, Peer &peer, const CTransactionRef &ptx)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, cs_main);
+
+    /** Queue a transaction received from a peer for batch validation. */
+    void QueueTxForBatch(CNode &pfrom, const CTransactionRef &ptx)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_tx_batch_mutex);
+
+    /**
+     * Validate the queued transactions if the batch is full or has waited for
+     * long enough: their scripts are checked in parallel first, then they are
+     * submitted to the mempool one after the other under a single cs_main
+     * lock.
+     */
+    void MaybeProcessTxBatch()
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_tx_batch_mutex);
+
+    /** Queue a transaction received from a peer for the validation thread. */
+    void QueueTxForValidation(CNode &pfrom, const CTransactionRef &ptx)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_tx_validation_mutex);
+
+    /** Whether a peer has as many transactions waiting as it may queue. */
+    bool IsTxValidationQueueFull(NodeId nodeid)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_tx_validation_mutex);
+
+    /**
+     * Validate the queued transactions until stopped, taking one from each
+     * peer in turn so that a peer sending expensive transactions only delays
+     * its own.
+     */
+    void ThreadTxValidation()
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_tx_validation_mutex);
+
+    /**
+     * Connect the blocks accepted by ProcessBlock() during the initial block
+     * download until stopped.
+     */
+    void ThreadBlockConnection()
+        EXCLUSIVE_LOCKS_REQUIRED(!m_block_connect_mutex);
 
     /**
      * Process a single headers message from a peer.
@@ -987,7 +1140,7 @@ private:
                                std::vector<CBlockHeader> &&headers,
                                bool via_compact_block)
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_headers_presync_mutex,
-                                 g_msgproc_mutex);
+                                 peer.m_msgproc_mutex);
 
     // Various helpers for headers processing, invoked by
     // ProcessHeadersMessage()
@@ -1007,7 +1160,7 @@ private:
      */
     void HandleFewUnconnectingHeaders(CNode &pfrom, Peer &peer,
                                       const std::vector<CBlockHeader> &headers)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(peer.m_msgproc_mutex);
     /** Return true if the headers connect to each other, false otherwise */
     bool
     CheckHeadersAreContinuous(const std::vector<CBlockHeader> &headers) const;
@@ -1033,7 +1186,8 @@ private:
     bool IsContinuationOfLowWorkHeadersSync(Peer &peer, CNode &pfrom,
                                             std::vector<CBlockHeader> &headers)
         EXCLUSIVE_LOCKS_REQUIRED(peer.m_headers_sync_mutex,
-                                 !m_headers_presync_mutex, g_msgproc_mutex);
+                                 !m_headers_presync_mutex,
+                                 peer.m_msgproc_mutex);
     /**
      * Check work on a headers chain to be processed, and if insufficient,
      * initiate our anti-DoS headers sync mechanism.
@@ -1051,7 +1205,8 @@ private:
                                const CBlockIndex *chain_start_header,
                                std::vector<CBlockHeader> &headers)
         EXCLUSIVE_LOCKS_REQUIRED(!peer.m_headers_sync_mutex, !m_peer_mutex,
-                                 !m_headers_presync_mutex, g_msgproc_mutex);
+                                 !m_headers_presync_mutex,
+                                 peer.m_msgproc_mutex);
 
     /**
      * Return true if the given header is an ancestor of
@@ -1067,7 +1222,7 @@ private:
      */
     bool MaybeSendGetHeaders(CNode &pfrom, const CBlockLocator &locator,
                              Peer &peer)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(peer.m_msgproc_mutex);
     /**
      * Potentially fetch blocks from this peer upon receipt of new headers tip
      */
@@ -1078,10 +1233,13 @@ private:
                                            const CBlockIndex &last_header,
                                            bool received_new_header,
                                            bool may_have_more_headers)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(peer.m_msgproc_mutex);
 
     void SendBlockTransactions(CNode &pfrom, Peer &peer, const CBlock &block,
                                const BlockTransactionsRequest &req);
+    void SendBlockTransactions(CNode &pfrom, Peer &peer,
+                               const BlockView &block,
+                               const BlockTransactionsRequest &req);
 
     /**
      * Register with InvRequestTracker that a TX INV has been received from a
@@ -1117,19 +1275,20 @@ private:
     /** Send `addr` messages on a regular schedule. */
     void MaybeSendAddr(CNode &node, Peer &peer,
                        std::chrono::microseconds current_time)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(peer.m_msgproc_mutex,
+                                 !peer.m_addr_relay_mutex, !m_rng_mutex);
 
     /**
      * Send a single `sendheaders` message, after we have completed headers
      * sync with a peer.
      */
     void MaybeSendSendHeaders(CNode &node, Peer &peer)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(peer.m_msgproc_mutex);
 
     /** Send `feefilter` message. */
     void MaybeSendFeefilter(CNode &node, Peer &peer,
                             std::chrono::microseconds current_time)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(peer.m_msgproc_mutex, !m_rng_mutex);
 
     /**
      * Relay (gossip) an address to a few randomly chosen nodes.
@@ -1141,12 +1300,13 @@ private:
      *                         relay unreachable addresses less.
      */
     void RelayAddress(NodeId originator, const CAddress &addr, bool fReachable)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_rng_mutex);
 
-    FastRandomContext m_rng GUARDED_BY(NetEventsInterface::g_msgproc_mutex);
+    /** Shared by all the message handler threads. */
+    Mutex m_rng_mutex;
+    FastRandomContext m_rng GUARDED_BY(m_rng_mutex);
 
-    FeeFilterRounder
-        m_fee_filter_rounder GUARDED_BY(NetEventsInterface::g_msgproc_mutex);
+    FeeFilterRounder m_fee_filter_rounder GUARDED_BY(m_rng_mutex);
 
     const CChainParams &m_chainparams;
     CConnman &m_connman;
@@ -1206,14 +1366,16 @@ private:
     /** Get a pointer to a mutable CNodeState. */
     CNodeState *State(NodeId pnode) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
-    std::atomic<std::chrono::microseconds> m_next_inv_to_inbounds{0us};
+    Mutex m_next_inv_to_inbounds_mutex;
+    std::chrono::microseconds
+        m_next_inv_to_inbounds GUARDED_BY(m_next_inv_to_inbounds_mutex){0us};
 
     /** Number of nodes with fSyncStarted. */
     int nSyncStarted GUARDED_BY(cs_main) = 0;
 
     /** Hash of the last block we received via INV */
     BlockHash
-        m_last_block_inv_triggering_headers_sync GUARDED_BY(g_msgproc_mutex){};
+        m_last_block_inv_triggering_headers_sync GUARDED_BY(::cs_main){};
 
     /**
      * Sources of received blocks, saved to be able to punish them when
@@ -1324,7 +1486,8 @@ private:
      */
     std::chrono::microseconds
     NextInvToInbounds(std::chrono::microseconds now,
-                      std::chrono::seconds average_interval);
+                      std::chrono::seconds average_interval)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_next_inv_to_inbounds_mutex);
 
     // All of the following cache a recent block, and are protected by
     // m_most_recent_block_mutex
@@ -1335,6 +1498,41 @@ private:
         m_most_recent_compact_block GUARDED_BY(m_most_recent_block_mutex);
     BlockHash m_most_recent_block_hash GUARDED_BY(m_most_recent_block_mutex);
 
+    /** Recently serialized block and transaction messages. */
+    RelayMsgCache m_relay_msg_cache;
+
+    /** A transaction waiting for batch validation, with its sender. */
+    struct BatchedTx {
+        //! Referenced until the transaction is processed.
+        CNode *node;
+        CTransactionRef tx;
+    };
+    Mutex m_tx_batch_mutex;
+    std::vector<BatchedTx> m_tx_batch GUARDED_BY(m_tx_batch_mutex);
+    /** When the first transaction of the batch was queued. */
+    std::chrono::microseconds m_tx_batch_start GUARDED_BY(m_tx_batch_mutex){0};
+
+    /** Transactions waiting for the validation thread, by sender. */
+    Mutex m_tx_validation_mutex;
+    std::condition_variable m_tx_validation_cv;
+    std::map<NodeId, std::deque<BatchedTx>>
+        m_tx_validation_queue GUARDED_BY(m_tx_validation_mutex);
+    bool m_tx_validation_stop GUARDED_BY(m_tx_validation_mutex){false};
+    std::thread m_tx_validation_thread;
+
+    /**
+     * The blocks stored to disk and waiting for the block connection thread,
+     * oldest first. Only the last MAX_BLOCKS_TO_CONNECT of them are kept in
+     * memory, older ones are read back from disk when connected.
+     */
+    Mutex m_block_connect_mutex;
+    std::condition_variable m_block_connect_cv;
+    std::deque<std::shared_ptr<const CBlock>>
+        m_blocks_to_connect GUARDED_BY(m_block_connect_mutex);
+    bool m_block_connect_pending GUARDED_BY(m_block_connect_mutex){false};
+    bool m_block_connect_stop GUARDED_BY(m_block_connect_mutex){false};
+    std::thread m_block_connect_thread;
+
     // Data about the low-work headers synchronization, aggregated from all
     // peers' HeadersSyncStates.
     /** Mutex guarding the other m_headers_presync_* variables. */
@@ -1403,9 +1601,21 @@ private:
      */
     void FindNextBlocksToDownload(NodeId nodeid, unsigned int count,
                                   std::vector<const CBlockIndex *> &vBlocks,
-                                  NodeId &nodeStaller)
+                                  NodeId &nodeStaller,
+                                  const CBlockIndex *&stalled_block)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /** Update the download rate of a peer which sent a requested block. */
+    void BlockReceived(NodeId nodeid, const BlockHash &hash)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * How many blocks to keep in flight from a peer during the block
+     * download, see BLOCK_DOWNLOAD_BUFFER_TIME.
+     */
+    unsigned int BlockDownloadWindow(const CNode &node,
+                                     const CNodeState &state) const;
+
     /** Multimap used to preserve insertion order */
     typedef std::multimap<BlockHash,
                           std::pair<NodeId, std::list<QueuedBlock>::iterator>>
@@ -1422,21 +1632,37 @@ private:
     CTransactionRef FindTxForGetData(const Peer &peer, const TxId &txid,
                                      const std::chrono::seconds mempool_req,
                                      const std::chrono::seconds now)
-        LOCKS_EXCLUDED(cs_main)
-            EXCLUSIVE_LOCKS_REQUIRED(NetEventsInterface::g_msgproc_mutex);
+        LOCKS_EXCLUDED(cs_main);
 
     void ProcessGetData(const Config &config, CNode &pfrom, Peer &peer,
                         const std::atomic<bool> &interruptMsgProc)
         EXCLUSIVE_LOCKS_REQUIRED(!m_most_recent_block_mutex,
                                  peer.m_getdata_requests_mutex,
-                                 NetEventsInterface::g_msgproc_mutex)
+                                 peer.m_msgproc_mutex)
             LOCKS_EXCLUDED(cs_main);
 
+    /**
+     * Send headers to a peer, as AUXHEADERS if it signaled support for them
+     * and as HEADERS otherwise.
+     */
+    void PushHeadersMessage(CNode &node, const Peer &peer,
+                            const std::vector<CBlock> &headers);
+
     /** Process a new block. Perform any post-processing housekeeping */
     void ProcessBlock(const Config &config, CNode &node,
                       const std::shared_ptr<const CBlock> &block,
                       bool force_processing, bool min_pow_checked);
 
+    /**
+     * Dogecoin: if the PoW of a received block isn't cached yet, compute it
+     * together with the PoW of all the blocks and compact blocks still queued
+     * from every peer, spread over the PoW check queue workers and SIMD lanes.
+     * The blocks then pass CheckBlockHeader without any scrypt hashing on the
+     * message handler thread.
+     */
+    void PreverifyQueuedBlocksPoW(const CBlockHeader &header)
+        LOCKS_EXCLUDED(cs_main);
+
     /** Relay map. */
     typedef std::map<TxId, CTransactionRef> MapRelay;
     MapRelay mapRelay GUARDED_BY(cs_main);
@@ -1464,7 +1690,9 @@ private:
     int m_peers_downloading_from GUARDED_BY(cs_main) = 0;
 
     void AddToCompactExtraTransactions(const CTransactionRef &tx)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_extra_txn_mutex);
+
+    Mutex m_extra_txn_mutex;
 
     /**
      * Orphan/conflicted/etc transactions that are kept for compact block
@@ -1474,9 +1702,9 @@ private:
      * these are kept in a ring buffer
      */
     std::vector<std::pair<TxHash, CTransactionRef>>
-        vExtraTxnForCompact GUARDED_BY(g_msgproc_mutex);
+        vExtraTxnForCompact GUARDED_BY(m_extra_txn_mutex);
     /** Offset into vExtraTxnForCompact to insert the next tx */
-    size_t vExtraTxnForCompactIt GUARDED_BY(g_msgproc_mutex) = 0;
+    size_t vExtraTxnForCompactIt GUARDED_BY(m_extra_txn_mutex) = 0;
 
     /**
      * Check whether the last unknown block a peer advertised is not yet known.
@@ -1590,12 +1818,13 @@ private:
      *            False if address relay is disallowed
      */
     bool SetupAddressRelay(const CNode &node, Peer &peer)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(peer.m_msgproc_mutex,
+                                 !peer.m_addr_relay_mutex);
 
     void AddAddressKnown(Peer &peer, const CAddress &addr)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!peer.m_addr_relay_mutex);
     void PushAddress(Peer &peer, const CAddress &addr)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!peer.m_addr_relay_mutex, !m_rng_mutex);
 
     /**
      * Manage reception of an avalanche proof.
@@ -1608,8 +1837,7 @@ private:
 
     avalanche::ProofRef FindProofForGetData(const Peer &peer,
                                             const avalanche::ProofId &proofid,
-                                            const std::chrono::seconds now)
-        EXCLUSIVE_LOCKS_REQUIRED(NetEventsInterface::g_msgproc_mutex);
+                                            const std::chrono::seconds now);
 
     bool isPreferredDownloadPeer(const CNode &pfrom);
 };
@@ -1639,6 +1867,7 @@ static bool IsAddrCompatible(const Peer &peer, const CAddress &addr) {
 }
 
 void PeerManagerImpl::AddAddressKnown(Peer &peer, const CAddress &addr) {
+    LOCK(peer.m_addr_relay_mutex);
     assert(peer.m_addr_known);
     peer.m_addr_known->insert(addr.GetKey());
 }
@@ -1647,10 +1876,12 @@ void PeerManagerImpl::PushAddress(Peer &peer, const CAddress &addr) {
     // Known checking here is only to save space from duplicates.
     // Before sending, we'll filter it again for known addresses that were
     // added after addresses were pushed.
+    LOCK(peer.m_addr_relay_mutex);
     assert(peer.m_addr_known);
     if (addr.IsValid() && !peer.m_addr_known->contains(addr.GetKey()) &&
         IsAddrCompatible(peer, addr)) {
         if (peer.m_addrs_to_send.size() >= m_opts.max_addr_to_send) {
+            LOCK(m_rng_mutex);
             peer.m_addrs_to_send[m_rng.randrange(peer.m_addrs_to_send.size())] =
                 addr;
         } else {
@@ -1698,11 +1929,9 @@ static bool IsLimitedPeer(const Peer &peer) {
 std::chrono::microseconds
 PeerManagerImpl::NextInvToInbounds(std::chrono::microseconds now,
                                    std::chrono::seconds average_interval) {
-    if (m_next_inv_to_inbounds.load() < now) {
-        // If this function were called from multiple threads simultaneously
-        // it would possible that both update the next send variable, and return
-        // a different result to their caller. This is not possible in practice
-        // as only the net processing thread invokes this function.
+    // The message handler threads all share the same timer.
+    LOCK(m_next_inv_to_inbounds_mutex);
+    if (m_next_inv_to_inbounds < now) {
         m_next_inv_to_inbounds = GetExponentialRand(now, average_interval);
     }
     return m_next_inv_to_inbounds;
@@ -1791,9 +2020,10 @@ bool PeerManagerImpl::BlockRequested(const Config &config, NodeId nodeid,
 
     std::list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(
         state->vBlocksInFlight.end(),
-        {&block, std::unique_ptr<PartiallyDownloadedBlock>(
-                     pit ? new PartiallyDownloadedBlock(config, &m_mempool)
-                         : nullptr)});
+        {&block,
+         std::unique_ptr<PartiallyDownloadedBlock>(
+             pit ? new PartiallyDownloadedBlock(config, &m_mempool) : nullptr),
+         GetTime<std::chrono::microseconds>()});
     if (state->vBlocksInFlight.size() == 1) {
         // We're starting a block download (batch) from this peer.
         state->m_downloading_since = GetTime<std::chrono::microseconds>();
@@ -1810,6 +2040,46 @@ bool PeerManagerImpl::BlockRequested(const Config &config, NodeId nodeid,
     return true;
 }
 
+void PeerManagerImpl::BlockReceived(NodeId nodeid, const BlockHash &hash) {
+    for (auto range = mapBlocksInFlight.equal_range(hash);
+         range.first != range.second; range.first++) {
+        auto [node_id, list_it] = range.first->second;
+        if (node_id != nodeid) {
+            continue;
+        }
+
+        CNodeState &state = *Assert(State(nodeid));
+        const auto now{GetTime<std::chrono::microseconds>()};
+        // The blocks in flight are sent one after the other, so only count the
+        // time since the previous one was received.
+        const auto interval{
+            now - std::max(list_it->m_requested_time,
+                           state.m_last_block_receive_time)};
+        state.m_block_receive_interval =
+            state.m_block_receive_interval == 0us
+                ? interval
+                : (3 * state.m_block_receive_interval + interval) / 4;
+        state.m_last_block_receive_time = now;
+        return;
+    }
+}
+
+unsigned int
+PeerManagerImpl::BlockDownloadWindow(const CNode &node,
+                                     const CNodeState &state) const {
+    if (state.m_block_receive_interval == 0us) {
+        return MAX_BLOCKS_IN_TRANSIT_PER_PEER;
+    }
+    auto ping_time{node.m_min_ping_time.load()};
+    if (ping_time == std::chrono::microseconds::max()) {
+        ping_time = 0us;
+    }
+    return std::clamp<int64_t>((BLOCK_DOWNLOAD_BUFFER_TIME + ping_time) /
+                                   state.m_block_receive_interval,
+                               MIN_BLOCKS_IN_TRANSIT_PER_PEER,
+                               MAX_BLOCKS_IN_TRANSIT_PER_FAST_PEER);
+}
+
 void PeerManagerImpl::MaybeSetPeerAsAnnouncingHeaderAndIDs(NodeId nodeid) {
     AssertLockHeld(cs_main);
 
@@ -1960,7 +2230,8 @@ void PeerManagerImpl::UpdateBlockAvailability(NodeId nodeid,
 
 void PeerManagerImpl::FindNextBlocksToDownload(
     NodeId nodeid, unsigned int count,
-    std::vector<const CBlockIndex *> &vBlocks, NodeId &nodeStaller) {
+    std::vector<const CBlockIndex *> &vBlocks, NodeId &nodeStaller,
+    const CBlockIndex *&stalled_block) {
     if (count == 0) {
         return;
     }
@@ -2009,6 +2280,7 @@ void PeerManagerImpl::FindNextBlocksToDownload(
     int nMaxHeight =
         std::min<int>(state->pindexBestKnownBlock->nHeight, nWindowEnd + 1);
     NodeId waitingfor = -1;
+    const CBlockIndex *waiting_for_block{nullptr};
     while (pindexWalk->nHeight < nMaxHeight) {
         // Read up to 128 (or more, if more blocks than that are needed)
         // successors of pindexWalk (towards pindexBestKnownBlock) into
@@ -2047,6 +2319,7 @@ void PeerManagerImpl::FindNextBlocksToDownload(
                         // We aren't able to fetch anything, but we would be if
                         // the download window was one larger.
                         nodeStaller = waitingfor;
+                        stalled_block = waiting_for_block;
                     }
                     return;
                 }
@@ -2059,6 +2332,7 @@ void PeerManagerImpl::FindNextBlocksToDownload(
                 waitingfor =
                     mapBlocksInFlight.lower_bound(pindex->GetBlockHash())
                         ->second.first;
+                waiting_for_block = pindex;
             }
         }
     }
@@ -2564,6 +2838,7 @@ void PeerManagerImpl::AddToCompactExtraTransactions(const CTransactionRef &tx) {
         return;
     }
 
+    LOCK(m_extra_txn_mutex);
     if (!vExtraTxnForCompact.size()) {
         vExtraTxnForCompact.resize(m_opts.max_extra_txs);
     }
@@ -2769,6 +3044,11 @@ PeerManagerImpl::PeerManagerImpl(CConnman &connman, AddrMan &addrman,
       m_addrman(addrman), m_banman(banman), m_chainman(chainman),
       m_mempool(pool), m_avalanche(avalanche), m_opts{opts} {}
 
+PeerManagerImpl::~PeerManagerImpl() {
+    StopTxValidation();
+    StopBlockConnection();
+}
+
 void PeerManagerImpl::StartScheduledTasks(CScheduler &scheduler) {
     // Stale tip checking and peer eviction are on two different timers, but we
     // don't want them to get out of sync due to drift in the scheduler, so we
@@ -2801,6 +3081,18 @@ void PeerManagerImpl::StartScheduledTasks(CScheduler &scheduler) {
     const auto avalanchePeriodicNetworkingInterval = 2min + GetRandMillis(3min);
     scheduler.scheduleFromNow([&] { AvalanchePeriodicNetworking(scheduler); },
                               avalanchePeriodicNetworkingInterval);
+
+    if (m_opts.tx_validation_thread) {
+        m_tx_validation_thread =
+            std::thread(&util::TraceThread, "txvalidation",
+                        [this] { ThreadTxValidation(); });
+    }
+
+    if (m_opts.block_connect_thread) {
+        m_block_connect_thread =
+            std::thread(&util::TraceThread, "blockconnect",
+                        [this] { ThreadBlockConnection(); });
+    }
 }
 
 /**
@@ -2881,9 +3173,14 @@ void PeerManagerImpl::NewPoWValidBlock(
     m_highest_fast_announce = pindex->nHeight;
 
     BlockHash hashBlock(pblock->GetHash());
-    const std::shared_future<CSerializedNetMsg> lazy_ser{
+    // Serialized once and shared by the send queues of all the peers.
+    const std::shared_future<std::shared_ptr<const CSerializedNetMsg>> lazy_ser{
         std::async(std::launch::deferred, [&] {
-            return msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock);
+            return m_relay_msg_cache.GetOrMake(
+                CInv(MSG_CMPCT_BLOCK, hashBlock),
+                GetTime<std::chrono::seconds>(), [&] {
+                    return msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock);
+                });
         })};
 
     {
@@ -2915,8 +3212,7 @@ void PeerManagerImpl::NewPoWValidBlock(
                              "PeerManager::NewPoWValidBlock",
                              hashBlock.ToString(), pnode->GetId());
 
-                    const CSerializedNetMsg &ser_cmpctblock{lazy_ser.get()};
-                    m_connman.PushMessage(pnode, ser_cmpctblock.Copy());
+                    m_connman.PushMessage(pnode, lazy_ser.get());
                     state.pindexBestHeaderSent = pindex;
                 }
             });
@@ -3260,8 +3556,30 @@ void PeerManagerImpl::ProcessGetBlockData(const Config &config, CNode &pfrom,
     if (!pindex->nStatus.hasData()) {
         return;
     }
+    const auto now{GetTime<std::chrono::seconds>()};
     std::shared_ptr<const CBlock> pblock;
-    if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
+    if (inv.IsMsgBlk()) {
+        m_connman.PushMessage(
+            &pfrom,
+            m_relay_msg_cache.GetOrMake(
+                CInv(MSG_BLOCK, hash), now, [&] {
+                    if (a_recent_block && a_recent_block->GetHash() == hash) {
+                        return msgMaker.MakeReserved(NetMsgType::BLOCK,
+                                                     *a_recent_block);
+                    }
+                    // Send the block from disk as stored, which is also its
+                    // network serialization, rather than deserializing it
+                    // just to reserialize it.
+                    CSerializedNetMsg msg;
+                    msg.m_type = NetMsgType::BLOCK;
+                    if (!m_chainman.m_blockman.ReadRawBlockFromDisk(msg.data,
+                                                                    *pindex)) {
+                        assert(!"cannot load block from disk");
+                    }
+                    return msg;
+                }));
+    } else if (a_recent_block &&
+               a_recent_block->GetHash() == pindex->GetBlockHash()) {
         pblock = a_recent_block;
     } else {
         // Send block from disk
@@ -3271,9 +3589,8 @@ void PeerManagerImpl::ProcessGetBlockData(const Config &config, CNode &pfrom,
         }
         pblock = pblockRead;
     }
-    if (inv.IsMsgBlk()) {
-        m_connman.PushMessage(&pfrom,
-                              msgMaker.Make(NetMsgType::BLOCK, *pblock));
+    if (!pblock) {
+        // Already sent.
     } else if (inv.IsMsgFilteredBlk()) {
         bool sendMerkleBlock = false;
         CMerkleBlock merkleBlock;
@@ -3300,7 +3617,8 @@ void PeerManagerImpl::ProcessGetBlockData(const Config &config, CNode &pfrom,
             for (PairType &pair : merkleBlock.vMatchedTxn) {
                 m_connman.PushMessage(
                     &pfrom,
-                    msgMaker.Make(NetMsgType::TX, *pblock->vtx[pair.first]));
+                    msgMaker.MakeReserved(NetMsgType::TX,
+                                          *pblock->vtx[pair.first]));
             }
         }
         // else
@@ -3317,9 +3635,13 @@ void PeerManagerImpl::ProcessGetBlockData(const Config &config, CNode &pfrom,
             if (a_recent_compact_block &&
                 a_recent_compact_block->header.GetHash() ==
                     pindex->GetBlockHash()) {
-                m_connman.PushMessage(&pfrom,
-                                      msgMaker.Make(NetMsgType::CMPCTBLOCK,
-                                                    *a_recent_compact_block));
+                m_connman.PushMessage(
+                    &pfrom, m_relay_msg_cache.GetOrMake(
+                                CInv(MSG_CMPCT_BLOCK, hash), now, [&] {
+                                    return msgMaker.Make(
+                                        NetMsgType::CMPCTBLOCK,
+                                        *a_recent_compact_block);
+                                }));
             } else {
                 CBlockHeaderAndShortTxIDs cmpctblock(*pblock);
                 m_connman.PushMessage(
@@ -3328,7 +3650,8 @@ void PeerManagerImpl::ProcessGetBlockData(const Config &config, CNode &pfrom,
             }
         } else {
             m_connman.PushMessage(
-                &pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCK, *pblock));
+                &pfrom,
+                msgMaker.MakeReserved(nSendFlags, NetMsgType::BLOCK, *pblock));
         }
     }
 
@@ -3364,21 +3687,19 @@ PeerManagerImpl::FindTxForGetData(const Peer &peer, const TxId &txid,
         }
     }
 
-    {
+    // Otherwise, the transaction must have been announced recently.
+    auto tx_relay = Assume(peer.GetTxRelay());
+    if (WITH_LOCK(tx_relay->m_tx_inventory_mutex,
+                  return tx_relay->m_recently_announced_invs.contains(txid))) {
+        // If it was, it can be relayed from either the mempool...
+        if (txinfo.tx) {
+            return std::move(txinfo.tx);
+        }
+        // ... or the relay pool.
         LOCK(cs_main);
-
-        // Otherwise, the transaction must have been announced recently.
-        if (Assume(peer.GetTxRelay())
-                ->m_recently_announced_invs.contains(txid)) {
-            // If it was, it can be relayed from either the mempool...
-            if (txinfo.tx) {
-                return std::move(txinfo.tx);
-            }
-            // ... or the relay pool.
-            auto mi = mapRelay.find(txid);
-            if (mi != mapRelay.end()) {
-                return mi->second;
-            }
+        auto mi = mapRelay.find(txid);
+        if (mi != mapRelay.end()) {
+            return mi->second;
         }
     }
 
@@ -3424,7 +3745,10 @@ PeerManagerImpl::FindProofForGetData(const Peer &peer,
     }
 
     // Otherwise, the proofs must have been announced recently.
-    if (peer.m_proof_relay->m_recently_announced_proofs.contains(proofid)) {
+    if (WITH_LOCK(
+            peer.m_proof_relay->m_proof_inventory_mutex,
+            return peer.m_proof_relay->m_recently_announced_proofs.contains(
+                proofid))) {
         return proof;
     }
 
@@ -3498,7 +3822,10 @@ void PeerManagerImpl::ProcessGetData(
             if (tx) {
                 int nSendFlags = 0;
                 m_connman.PushMessage(
-                    &pfrom, msgMaker.Make(nSendFlags, NetMsgType::TX, *tx));
+                    &pfrom, m_relay_msg_cache.GetOrMake(inv, now, [&] {
+                        return msgMaker.MakeReserved(nSendFlags,
+                                                     NetMsgType::TX, *tx);
+                    }));
                 m_mempool.RemoveUnbroadcastTx(txid);
                 // As we're going to send tx, make sure its unconfirmed parents
                 // are made requestable.
@@ -3523,9 +3850,9 @@ void PeerManagerImpl::ProcessGetData(
                 for (const TxId &parent_txid : parent_ids_to_add) {
                     // Relaying a transaction with a recent but unconfirmed
                     // parent.
-                    if (WITH_LOCK(tx_relay->m_tx_inventory_mutex,
-                                  return !tx_relay->m_tx_inventory_known_filter
-                                              .contains(parent_txid))) {
+                    LOCK(tx_relay->m_tx_inventory_mutex);
+                    if (!tx_relay->m_tx_inventory_known_filter.contains(
+                            parent_txid)) {
                         tx_relay->m_recently_announced_invs.insert(parent_txid);
                     }
                 }
@@ -3587,7 +3914,30 @@ void PeerManagerImpl::SendBlockTransactions(
     const CNetMsgMaker msgMaker(pfrom.GetCommonVersion());
     int nSendFlags = 0;
     m_connman.PushMessage(
-        &pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCKTXN, resp));
+        &pfrom, msgMaker.MakeReserved(nSendFlags, NetMsgType::BLOCKTXN, resp));
+}
+
+void PeerManagerImpl::SendBlockTransactions(
+    CNode &pfrom, Peer &peer, const BlockView &block,
+    const BlockTransactionsRequest &req) {
+    // Same message as a BlockTransactions, but the transactions are copied as
+    // serialized on disk.
+    std::vector<TransactionView> txn;
+    txn.reserve(req.indices.size());
+    for (const uint32_t index : req.indices) {
+        if (index >= block.vtx.size()) {
+            Misbehaving(peer, 100, "getblocktxn with out-of-bounds tx indices");
+            return;
+        }
+        txn.push_back(block.vtx[index]);
+    }
+    LOCK(cs_main);
+    const CNetMsgMaker msgMaker(pfrom.GetCommonVersion());
+    m_connman.PushMessage(
+        &pfrom,
+        msgMaker.MakeReserved(
+            NetMsgType::BLOCKTXN, req.blockhash,
+            Using<VectorFormatter<TransactionCompression>>(txn)));
 }
 
 bool PeerManagerImpl::CheckHeadersPoW(const std::vector<CBlockHeader> &headers,
@@ -3685,12 +4035,17 @@ bool PeerManagerImpl::IsContinuationOfLowWorkHeadersSync(
     if (peer.m_headers_sync) {
         auto result = peer.m_headers_sync->ProcessNextHeaders(
             headers, headers.size() == MAX_HEADERS_RESULTS);
+        const BlockHash pipelined_hash{
+            std::exchange(peer.m_headers_sync_pipelined_hash, BlockHash())};
         if (result.request_more) {
             auto locator = peer.m_headers_sync->NextHeadersRequestLocator();
             // If we were instructed to ask for a locator, it should not be
             // empty.
             Assume(!locator.vHave.empty());
-            if (!locator.vHave.empty()) {
+            if (!locator.vHave.empty() &&
+                locator.vHave.front() == pipelined_hash) {
+                // Already requested before these headers were checked
+            } else if (!locator.vHave.empty()) {
                 // It should be impossible for the getheaders request to fail,
                 // because we should have cleared the last getheaders timestamp
                 // when processing the headers that triggered this call. But
@@ -3810,6 +4165,7 @@ bool PeerManagerImpl::TryLowWorkHeadersSync(
                 peer.m_id, m_chainparams.GetConsensus(), chain_start_header,
                 chain_start_header->GetBlockHeader(m_chainman.m_blockman),
                 minimum_chain_work));
+            peer.m_headers_sync_pipelined_hash = BlockHash();
 
             // Now a HeadersSyncState object for tracking this synchronization
             // is created, process the headers using it as normal. Failures are
@@ -4030,6 +4386,24 @@ void PeerManagerImpl::ProcessHeadersMessage(const Config &config, CNode &pfrom,
         return;
     }
 
+    // During a low-work headers sync, the next headers can often be requested
+    // right away, so that they are downloaded while the PoW of these ones is
+    // being checked, which is the bulk of the work on Dogecoin.
+    if (!via_compact_block) {
+        LOCK(peer.m_headers_sync_mutex);
+        if (peer.m_headers_sync) {
+            const std::optional<CBlockLocator> locator{
+                peer.m_headers_sync->PipelinedHeadersRequestLocator(
+                    headers, nCount == MAX_HEADERS_RESULTS)};
+            if (locator && MaybeSendGetHeaders(pfrom, *locator, peer)) {
+                LogPrint(BCLog::NET,
+                         "more getheaders (from %s) to peer=%d, pipelined\n",
+                         locator->vHave.front().ToString(), pfrom.GetId());
+                peer.m_headers_sync_pipelined_hash = locator->vHave.front();
+            }
+        }
+    }
+
     // Before we do any processing, make sure these pass basic sanity checks.
     // We'll rely on headers having valid proof-of-work further down, as an
     // anti-DoS criteria (note: this check is required before passing any
@@ -4170,7 +4544,6 @@ void PeerManagerImpl::ProcessInvalidTx(NodeId nodeid,
                                        const TxValidationState &state,
                                        bool maybe_add_extra_compact_tx) {
     AssertLockNotHeld(m_peer_mutex);
-    AssertLockHeld(g_msgproc_mutex);
     AssertLockHeld(cs_main);
 
     const TxId &txid = ptx->GetId();
@@ -4217,7 +4590,6 @@ void PeerManagerImpl::ProcessInvalidTx(NodeId nodeid,
 
 void PeerManagerImpl::ProcessValidTx(NodeId nodeid, const CTransactionRef &tx) {
     AssertLockNotHeld(m_peer_mutex);
-    AssertLockHeld(g_msgproc_mutex);
     AssertLockHeld(cs_main);
 
     // As this version of the transaction was acceptable, we can forget about
@@ -4244,7 +4616,6 @@ void PeerManagerImpl::ProcessPackageResult(
     const PackageToValidate &package_to_validate,
     const PackageMempoolAcceptResult &package_result) {
     AssertLockNotHeld(m_peer_mutex);
-    AssertLockHeld(g_msgproc_mutex);
     AssertLockHeld(cs_main);
 
     const auto &package = package_to_validate.m_txns;
@@ -4303,7 +4674,6 @@ void PeerManagerImpl::ProcessPackageResult(
 std::optional<PeerManagerImpl::PackageToValidate>
 PeerManagerImpl::Find1P1CPackage(const CTransactionRef &ptx, NodeId nodeid) {
     AssertLockNotHeld(m_peer_mutex);
-    AssertLockHeld(g_msgproc_mutex);
     AssertLockHeld(cs_main);
 
     const auto &parent_txid{ptx->GetId()};
@@ -4350,7 +4720,8 @@ PeerManagerImpl::Find1P1CPackage(const CTransactionRef &ptx, NodeId nodeid) {
     // Create a random permutation of the indices.
     std::vector<size_t> tx_indices(cpfp_candidates_different_peer.size());
     std::iota(tx_indices.begin(), tx_indices.end(), 0);
-    Shuffle(tx_indices.begin(), tx_indices.end(), m_rng);
+    WITH_LOCK(m_rng_mutex,
+              Shuffle(tx_indices.begin(), tx_indices.end(), m_rng));
 
     for (const auto index : tx_indices) {
         // If we already tried a package and failed for any reason, the combined
@@ -4367,8 +4738,359 @@ PeerManagerImpl::Find1P1CPackage(const CTransactionRef &ptx, NodeId nodeid) {
     return std::nullopt;
 }
 
+bool PeerManagerImpl::ProcessIncomingTx(CNode &pfrom, Peer &peer,
+                                        const CTransactionRef &ptx) {
+    AssertLockNotHeld(m_peer_mutex);
+    AssertLockHeld(cs_main);
+
+    const CTransaction &tx = *ptx;
+    const TxId &txid = tx.GetId();
+    bool shouldReconcileTx{false};
+
+    m_txrequest.ReceivedResponse(pfrom.GetId(), txid);
+
+    if (AlreadyHaveTx(txid, /*include_reconsiderable=*/true)) {
+        if (pfrom.HasPermission(NetPermissionFlags::ForceRelay)) {
+            // Always relay transactions received from peers with
+            // forcerelay permission, even if they were already in the
+            // mempool, allowing the node to function as a gateway for
+            // nodes hidden behind it.
+            if (!m_mempool.exists(tx.GetId())) {
+                LogPrintf("Not relaying non-mempool transaction %s from "
+                          "forcerelay peer=%d\n",
+                          tx.GetId().ToString(), pfrom.GetId());
+            } else {
+                LogPrintf("Force relaying tx %s from peer=%d\n",
+                          tx.GetId().ToString(), pfrom.GetId());
+                RelayTransaction(tx.GetId());
+            }
+        }
+
+        if (m_recent_rejects_package_reconsiderable.contains(txid)) {
+            // When a transaction is already in
+            // m_recent_rejects_package_reconsiderable, we shouldn't
+            // submit it by itself again. However, look for a matching
+            // child in the orphanage, as it is possible that they
+            // succeed as a package.
+            LogPrint(BCLog::TXPACKAGES,
+                     "found tx %s in reconsiderable rejects, looking for "
+                     "child in orphanage\n",
+                     txid.ToString());
+            if (auto package_to_validate{Find1P1CPackage(ptx, pfrom.GetId())}) {
+                const auto package_result{ProcessNewPackage(
+                    m_chainman.ActiveChainstate(), m_mempool,
+                    package_to_validate->m_txns, /*test_accept=*/false)};
+                LogPrint(BCLog::TXPACKAGES,
+                         "package evaluation for %s: %s (%s)\n",
+                         package_to_validate->ToString(),
+                         package_result.m_state.IsValid() ? "package accepted"
+                                                          : "package rejected",
+                         package_result.m_state.ToString());
+                ProcessPackageResult(package_to_validate.value(),
+                                     package_result);
+            }
+        }
+        // If a tx is detected by m_recent_rejects it is ignored.
+        // Because we haven't submitted the tx to our mempool, we won't
+        // have computed a DoS score for it or determined exactly why we
+        // consider it invalid.
+        //
+        // This means we won't penalize any peer subsequently relaying a
+        // DoSy tx (even if we penalized the first peer who gave it to
+        // us) because we have to account for m_recent_rejects showing
+        // false positives. In other words, we shouldn't penalize a peer
+        // if we aren't *sure* they submitted a DoSy tx.
+        //
+        // Note that m_recent_rejects doesn't just record DoSy or
+        // invalid transactions, but any tx not accepted by the mempool,
+        // which may be due to node policy (vs. consensus). So we can't
+        // blanket penalize a peer simply for relaying a tx that our
+        // m_recent_rejects has caught, regardless of false positives.
+        return false;
+    }
+
+    const MempoolAcceptResult result = m_chainman.ProcessTransaction(ptx);
+    const TxValidationState &state = result.m_state;
+
+    if (result.m_result_type == MempoolAcceptResult::ResultType::VALID) {
+        ProcessValidTx(pfrom.GetId(), ptx);
+        pfrom.m_last_tx_time = GetTime<std::chrono::seconds>();
+    } else if (state.GetResult() == TxValidationResult::TX_MISSING_INPUTS) {
+        // It may be the case that the orphans parents have all been
+        // rejected.
+        bool fRejectedParents = false;
+
+        // Deduplicate parent txids, so that we don't have to loop over
+        // the same parent txid more than once down below.
+        std::vector<TxId> unique_parents;
+        unique_parents.reserve(tx.vin.size());
+        for (const CTxIn &txin : tx.vin) {
+            // We start with all parents, and then remove duplicates
+            // below.
+            unique_parents.push_back(txin.prevout.GetTxId());
+        }
+        std::sort(unique_parents.begin(), unique_parents.end());
+        unique_parents.erase(
+            std::unique(unique_parents.begin(), unique_parents.end()),
+            unique_parents.end());
+
+        // Distinguish between parents in m_recent_rejects and
+        // m_recent_rejects_package_reconsiderable. We can tolerate
+        // having up to 1 parent in
+        // m_recent_rejects_package_reconsiderable since we submit 1p1c
+        // packages. However, fail immediately if any are in
+        // m_recent_rejects.
+        std::optional<TxId> rejected_parent_reconsiderable;
+        for (const TxId &parent_txid : unique_parents) {
+            if (m_recent_rejects.contains(parent_txid)) {
+                fRejectedParents = true;
+                break;
+            }
+
+            if (m_recent_rejects_package_reconsiderable.contains(parent_txid) &&
+                !m_mempool.exists(parent_txid)) {
+                // More than 1 parent in
+                // m_recent_rejects_package_reconsiderable:
+                // 1p1c will not be sufficient to accept this package,
+                // so just give up here.
+                if (rejected_parent_reconsiderable.has_value()) {
+                    fRejectedParents = true;
+                    break;
+                }
+                rejected_parent_reconsiderable = parent_txid;
+            }
+        }
+        if (!fRejectedParents) {
+            const auto current_time{GetTime<std::chrono::microseconds>()};
+
+            for (const TxId &parent_txid : unique_parents) {
+                // FIXME: MSG_TX should use a TxHash, not a TxId.
+                AddKnownTx(peer, parent_txid);
+                // Exclude m_recent_rejects_package_reconsiderable: the
+                // missing parent may have been previously rejected for
+                // being too low feerate. This orphan might CPFP it.
+                if (!AlreadyHaveTx(parent_txid,
+                                   /*include_reconsiderable=*/false)) {
+                    AddTxAnnouncement(pfrom, parent_txid, current_time);
+                }
+            }
+
+            if (unsigned int nEvicted = m_mempool.withOrphanage(
+                    [&](TxOrphanage &orphanage) {
+                        if (orphanage.AddTx(ptx, pfrom.GetId())) {
+                            AddToCompactExtraTransactions(ptx);
+                        }
+                        LOCK(m_rng_mutex);
+                        return orphanage.LimitTxs(m_opts.max_orphan_txs,
+                                                  m_rng);
+                    }) > 0) {
+                LogPrint(BCLog::TXPACKAGES,
+                         "orphanage overflow, removed %u tx\n", nEvicted);
+            }
+
+            // Once added to the orphan pool, a tx is considered
+            // AlreadyHave, and we shouldn't request it anymore.
+            m_txrequest.ForgetInvId(tx.GetId());
+
+        } else {
+            LogPrint(BCLog::MEMPOOL,
+                     "not keeping orphan with rejected parents %s\n",
+                     tx.GetId().ToString());
+            // We will continue to reject this tx since it has rejected
+            // parents so avoid re-requesting it from other peers.
+            m_recent_rejects.insert(tx.GetId());
+            m_txrequest.ForgetInvId(tx.GetId());
+        }
+    }
+    if (state.IsInvalid()) {
+        ProcessInvalidTx(pfrom.GetId(), ptx, state,
+                         /*maybe_add_extra_compact_tx=*/true);
+    }
+    // When a transaction fails for TX_PACKAGE_RECONSIDERABLE, look for
+    // a matching child in the orphanage, as it is possible that they
+    // succeed as a package.
+    if (state.GetResult() == TxValidationResult::TX_PACKAGE_RECONSIDERABLE) {
+        LogPrint(BCLog::TXPACKAGES,
+                 "tx %s failed but reconsiderable, looking for child in "
+                 "orphanage\n",
+                 txid.ToString());
+        if (auto package_to_validate{Find1P1CPackage(ptx, pfrom.GetId())}) {
+            const auto package_result{ProcessNewPackage(
+                m_chainman.ActiveChainstate(), m_mempool,
+                package_to_validate->m_txns, /*test_accept=*/false)};
+            LogPrint(BCLog::TXPACKAGES, "package evaluation for %s: %s (%s)\n",
+                     package_to_validate->ToString(),
+                     package_result.m_state.IsValid() ? "package accepted"
+                                                      : "package rejected",
+                     package_result.m_state.ToString());
+            ProcessPackageResult(package_to_validate.value(), package_result);
+        }
+    }
+
+    if (state.GetResult() == TxValidationResult::TX_AVALANCHE_RECONSIDERABLE) {
+        // Once added to the conflicting pool, a tx is considered
+        // AlreadyHave, and we shouldn't request it anymore.
+        m_txrequest.ForgetInvId(tx.GetId());
+
+        unsigned int nEvicted{0};
+        m_mempool.withConflicting([&](TxConflicting &conflicting) {
+            conflicting.AddTx(ptx, pfrom.GetId());
+            LOCK(m_rng_mutex);
+            nEvicted =
+                conflicting.LimitTxs(m_opts.max_conflicting_txs, m_rng);
+            shouldReconcileTx = conflicting.HaveTx(ptx->GetId());
+        });
+
+        if (nEvicted > 0) {
+            LogPrint(BCLog::TXPACKAGES,
+                     "conflicting pool overflow, removed %u tx\n", nEvicted);
+        }
+    }
+
+    return shouldReconcileTx;
+}
+
+void PeerManagerImpl::QueueTxForBatch(CNode &pfrom,
+                                      const CTransactionRef &ptx) {
+    pfrom.AddRef();
+    LOCK(m_tx_batch_mutex);
+    if (m_tx_batch.empty()) {
+        m_tx_batch_start = GetTime<std::chrono::microseconds>();
+    }
+    m_tx_batch.push_back({&pfrom, ptx});
+}
+
+void PeerManagerImpl::MaybeProcessTxBatch() {
+    AssertLockNotHeld(m_peer_mutex);
+
+    std::vector<BatchedTx> batch;
+    {
+        LOCK(m_tx_batch_mutex);
+        if (m_tx_batch.empty() ||
+            (m_tx_batch.size() < m_opts.tx_batch_size &&
+             GetTime<std::chrono::microseconds>() <
+                 m_tx_batch_start + TX_BATCH_WINDOW)) {
+            return;
+        }
+        batch.swap(m_tx_batch);
+    }
+
+    std::vector<CTransactionRef> txs;
+    txs.reserve(batch.size());
+    for (const BatchedTx &entry : batch) {
+        txs.push_back(entry.tx);
+    }
+    PrecheckTransactionScripts(m_chainman.ActiveChainstate(), m_mempool, txs);
+
+    std::vector<CTransactionRef> to_reconcile;
+    {
+        LOCK(cs_main);
+        for (const BatchedTx &entry : batch) {
+            if (entry.node->fDisconnect) {
+                continue;
+            }
+            if (PeerRef peer = GetPeerRef(entry.node->GetId());
+                peer && ProcessIncomingTx(*entry.node, *peer, entry.tx)) {
+                to_reconcile.push_back(entry.tx);
+            }
+        }
+    }
+
+    if (m_avalanche && m_avalanche->m_preConsensus) {
+        for (const CTransactionRef &tx : to_reconcile) {
+            m_avalanche->addToReconcile(tx);
+        }
+    }
+
+    for (const BatchedTx &entry : batch) {
+        entry.node->Release();
+    }
+}
+
+void PeerManagerImpl::QueueTxForValidation(CNode &pfrom,
+                                           const CTransactionRef &ptx) {
+    {
+        LOCK(m_tx_validation_mutex);
+        if (m_tx_validation_stop) {
+            return;
+        }
+        pfrom.AddRef();
+        m_tx_validation_queue[pfrom.GetId()].push_back({&pfrom, ptx});
+    }
+    m_tx_validation_cv.notify_one();
+}
+
+bool PeerManagerImpl::IsTxValidationQueueFull(NodeId nodeid) {
+    LOCK(m_tx_validation_mutex);
+    auto it = m_tx_validation_queue.find(nodeid);
+    return it != m_tx_validation_queue.end() &&
+           it->second.size() >= MAX_PEER_TX_VALIDATION_QUEUE;
+}
+
+void PeerManagerImpl::ThreadTxValidation() {
+    NodeId last_served{-1};
+    while (true) {
+        BatchedTx entry;
+        bool was_full;
+        {
+            WAIT_LOCK(m_tx_validation_mutex, lock);
+            m_tx_validation_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(
+                                              m_tx_validation_mutex) {
+                return m_tx_validation_stop || !m_tx_validation_queue.empty();
+            });
+            if (m_tx_validation_stop) {
+                return;
+            }
+            auto it = m_tx_validation_queue.upper_bound(last_served);
+            if (it == m_tx_validation_queue.end()) {
+                it = m_tx_validation_queue.begin();
+            }
+            last_served = it->first;
+            was_full = it->second.size() >= MAX_PEER_TX_VALIDATION_QUEUE;
+            entry = std::move(it->second.front());
+            it->second.pop_front();
+            if (it->second.empty()) {
+                m_tx_validation_queue.erase(it);
+            }
+        }
+
+        bool should_reconcile{false};
+        if (!entry.node->fDisconnect) {
+            if (PeerRef peer = GetPeerRef(entry.node->GetId())) {
+                LOCK(cs_main);
+                should_reconcile =
+                    ProcessIncomingTx(*entry.node, *peer, entry.tx);
+            }
+        }
+        if (should_reconcile && m_avalanche && m_avalanche->m_preConsensus) {
+            m_avalanche->addToReconcile(entry.tx);
+        }
+
+        if (was_full) {
+            // The peer's messages can be processed again.
+            m_connman.WakeMessageHandler(entry.node->GetId());
+        }
+        entry.node->Release();
+    }
+}
+
+void PeerManagerImpl::StopTxValidation() {
+    WITH_LOCK(m_tx_validation_mutex, m_tx_validation_stop = true);
+    m_tx_validation_cv.notify_all();
+    if (m_tx_validation_thread.joinable()) {
+        m_tx_validation_thread.join();
+    }
+
+    std::map<NodeId, std::deque<BatchedTx>> dropped;
+    WITH_LOCK(m_tx_validation_mutex, dropped.swap(m_tx_validation_queue));
+    for (const auto &[nodeid, entries] : dropped) {
+        for (const BatchedTx &entry : entries) {
+            entry.node->Release();
+        }
+    }
+}
+
 bool PeerManagerImpl::ProcessOrphanTx(const Config &config, Peer &peer) {
-    AssertLockHeld(g_msgproc_mutex);
     LOCK(cs_main);
 
     while (CTransactionRef porphanTx =
@@ -4722,13 +5444,69 @@ static uint32_t getAvalancheVoteForProof(const avalanche::Processor &avalanche,
     });
 };
 
+void PeerManagerImpl::StopBlockConnection() {
+    WITH_LOCK(m_block_connect_mutex, m_block_connect_stop = true);
+    m_block_connect_cv.notify_all();
+    if (m_block_connect_thread.joinable()) {
+        m_block_connect_thread.join();
+    }
+}
+
+void PeerManagerImpl::ThreadBlockConnection() {
+    while (true) {
+        std::shared_ptr<const CBlock> block;
+        {
+            WAIT_LOCK(m_block_connect_mutex, lock);
+            m_block_connect_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(
+                                              m_block_connect_mutex) {
+                return m_block_connect_stop || m_block_connect_pending;
+            });
+            if (m_block_connect_stop) {
+                return;
+            }
+            if (!m_blocks_to_connect.empty()) {
+                block = std::move(m_blocks_to_connect.front());
+                m_blocks_to_connect.pop_front();
+            }
+            m_block_connect_pending = !m_blocks_to_connect.empty();
+        }
+
+        // Connects as many blocks as possible, the block only saves reading
+        // it back from disk. Only used to report errors, not invalidity.
+        BlockValidationState state;
+        if (!m_chainman.ActiveChainstate().ActivateBestChain(state, block,
+                                                             m_avalanche)) {
+            LogPrint(BCLog::VALIDATION, "ActivateBestChain failed (%s)\n",
+                     state.ToString());
+        }
+    }
+}
+
 void PeerManagerImpl::ProcessBlock(const Config &config, CNode &node,
                                    const std::shared_ptr<const CBlock> &block,
                                    bool force_processing,
                                    bool min_pow_checked) {
     bool new_block{false};
-    m_chainman.ProcessNewBlock(block, force_processing, min_pow_checked,
-                               &new_block, m_avalanche);
+    if (m_block_connect_thread.joinable() &&
+        m_chainman.ActiveChainstate().IsInitialBlockDownload()) {
+        // Store the block and let the block connection thread connect it, so
+        // this thread can go on downloading the next ones meanwhile.
+        if (m_chainman.AcceptNewBlock(block, force_processing, min_pow_checked,
+                                      &new_block)) {
+            {
+                LOCK(m_block_connect_mutex);
+                m_blocks_to_connect.push_back(block);
+                if (m_blocks_to_connect.size() > MAX_BLOCKS_TO_CONNECT) {
+                    m_blocks_to_connect.pop_front();
+                }
+                m_block_connect_pending = true;
+            }
+            m_block_connect_cv.notify_one();
+        }
+    } else {
+        m_chainman.ProcessNewBlock(block, force_processing, min_pow_checked,
+                                   &new_block, m_avalanche);
+    }
     if (new_block) {
         node.m_last_block_time = GetTime<std::chrono::seconds>();
         // In case this block came from a different peer than we requested
@@ -4742,20 +5520,79 @@ void PeerManagerImpl::ProcessBlock(const Config &config, CNode &node,
     }
 }
 
+void PeerManagerImpl::PushHeadersMessage(CNode &node, const Peer &peer,
+                                         const std::vector<CBlock> &headers) {
+    const CNetMsgMaker msgMaker(node.GetCommonVersion());
+    if (peer.m_wants_aux_headers) {
+        m_connman.PushMessage(
+            &node, msgMaker.Make(NetMsgType::AUXHEADERS,
+                                 CompactAuxPowHeaders{std::vector<CBlockHeader>(
+                                     headers.begin(), headers.end())}));
+        return;
+    }
+    // We must use CBlocks, as CBlockHeaders won't include the 0x00 nTx count
+    // at the end
+    m_connman.PushMessage(&node,
+                          msgMaker.MakeReserved(NetMsgType::HEADERS, headers));
+}
+
+void PeerManagerImpl::PreverifyQueuedBlocksPoW(const CBlockHeader &header) {
+    if (IsPowCached(GetPowHeader(header).GetHash(), header.nBits)) {
+        return;
+    }
+
+    std::vector<CBlockHeader> headers{header};
+    m_connman.ForEachNode([&](CNode *pnode) {
+        LOCK(pnode->cs_vProcessMsg);
+        for (const CNetMessage &msg : pnode->vProcessMsg) {
+            if (msg.m_type != NetMsgType::BLOCK &&
+                msg.m_type != NetMsgType::CMPCTBLOCK) {
+                continue;
+            }
+            // Both messages start with the block header. Only read it,
+            // without consuming the message.
+            SpanReader reader{SER_NETWORK, PROTOCOL_VERSION,
+                              MakeUCharSpan(msg.m_recv)};
+            CBlockHeader queued;
+            try {
+                reader >> queued;
+            } catch (const std::ios_base::failure &) {
+                // Malformed messages are dealt with when they are processed.
+                continue;
+            }
+            if (!IsPowCached(GetPowHeader(queued).GetHash(), queued.nBits)) {
+                headers.push_back(std::move(queued));
+            }
+        }
+    });
+
+    PreverifyProofOfWork(headers, m_chainparams.GetConsensus());
+}
+
 void PeerManagerImpl::ProcessMessage(
     const Config &config, CNode &pfrom, const std::string &msg_type,
     CDataStream &vRecv, const std::chrono::microseconds time_received,
     const std::atomic<bool> &interruptMsgProc) {
-    AssertLockHeld(g_msgproc_mutex);
-
-    LogPrint(BCLog::NETDEBUG, "received: %s (%u bytes) peer=%d\n",
-             SanitizeString(msg_type), vRecv.size(), pfrom.GetId());
-
     PeerRef peer = GetPeerRef(pfrom.GetId());
     if (peer == nullptr) {
         return;
     }
 
+    LOCK(peer->m_msgproc_mutex);
+    ProcessMessage(config, pfrom, peer, msg_type, vRecv, time_received,
+                   interruptMsgProc);
+}
+
+void PeerManagerImpl::ProcessMessage(
+    const Config &config, CNode &pfrom, const PeerRef &peer,
+    const std::string &msg_type, CDataStream &vRecv,
+    const std::chrono::microseconds time_received,
+    const std::atomic<bool> &interruptMsgProc) {
+    AssertLockHeld(peer->m_msgproc_mutex);
+
+    LogPrint(BCLog::NETDEBUG, "received: %s (%u bytes) peer=%d\n",
+             SanitizeString(msg_type), vRecv.size(), pfrom.GetId());
+
     if (!m_avalanche && IsAvalancheMessageType(msg_type)) {
         LogPrint(BCLog::AVALANCHE,
                  "Avalanche is not initialized, ignoring %s message\n",
@@ -4874,6 +5711,18 @@ void PeerManagerImpl::ProcessMessage(
         // Signal ADDRv2 support (BIP155).
         m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::SENDADDRV2));
 
+        // Signal support for compact auxpow headers.
+        m_connman.PushMessage(&pfrom,
+                              msg_maker.Make(NetMsgType::SENDAUXHEADERS));
+
+        // Accept compressed messages if both ends support them and signal it.
+        if ((peer->m_our_services & NODE_P2P_COMPRESSION) &&
+            (nServices & NODE_P2P_COMPRESSION) &&
+            pfrom.AcceptCompressedMessages()) {
+            m_connman.PushMessage(&pfrom,
+                                  msg_maker.Make(NetMsgType::SENDCOMPRESSED));
+        }
+
         pfrom.m_has_all_wanted_services =
             HasAllDesirableServiceFlags(nServices);
         peer->m_their_services = nServices;
@@ -5042,6 +5891,7 @@ void PeerManagerImpl::ProcessMessage(
                     // Add our proof id to the list or the recently announced
                     // proof INVs to this peer. This is used for filtering which
                     // INV can be requested for download.
+                    LOCK(peer->m_proof_relay->m_proof_inventory_mutex);
                     peer->m_proof_relay->m_recently_announced_proofs.insert(
                         localProof->getId());
                 }
@@ -5123,7 +5973,7 @@ void PeerManagerImpl::ProcessMessage(
             !pfrom.HasPermission(NetPermissionFlags::Addr);
         uint64_t num_proc = 0;
         uint64_t num_rate_limit = 0;
-        Shuffle(vAddr.begin(), vAddr.end(), m_rng);
+        WITH_LOCK(m_rng_mutex, Shuffle(vAddr.begin(), vAddr.end(), m_rng));
         for (CAddress &addr : vAddr) {
             if (interruptMsgProc) {
                 return;
@@ -5201,11 +6051,26 @@ void PeerManagerImpl::ProcessMessage(
         return;
     }
 
+    if (msg_type == NetMsgType::SENDAUXHEADERS) {
+        peer->m_wants_aux_headers = true;
+        return;
+    }
+
     if (msg_type == NetMsgType::SENDHEADERS) {
         peer->m_prefers_headers = true;
         return;
     }
 
+    if (msg_type == NetMsgType::SENDCOMPRESSED) {
+        if ((peer->m_our_services & NODE_P2P_COMPRESSION) &&
+            (peer->m_their_services & NODE_P2P_COMPRESSION) &&
+            pfrom.CompressSentMessages()) {
+            LogPrint(BCLog::NET, "compressing the messages to peer=%d\n",
+                     pfrom.GetId());
+        }
+        return;
+    }
+
     if (msg_type == NetMsgType::SENDCMPCT) {
         bool sendcmpct_hb{false};
         uint64_t sendcmpct_version{0};
@@ -5504,9 +6369,11 @@ void PeerManagerImpl::ProcessMessage(
 
             if (pindex->nHeight >=
                 m_chainman.ActiveChain().Height() - MAX_BLOCKTXN_DEPTH) {
-                CBlock block;
-                const bool ret{
-                    m_chainman.m_blockman.ReadBlockFromDisk(block, *pindex)};
+                std::vector<uint8_t> block_data;
+                BlockView block;
+                const bool ret{m_chainman.m_blockman.ReadRawBlockFromDisk(
+                                   block_data, *pindex) &&
+                               block.Parse(block_data)};
                 assert(ret);
 
                 SendBlockTransactions(pfrom, *peer, block, req);
@@ -5604,8 +6471,6 @@ void PeerManagerImpl::ProcessMessage(
             }
         }
 
-        // we must use CBlocks, as CBlockHeaders won't include the 0x00 nTx
-        // count at the end
         std::vector<CBlock> vHeaders;
         int nLimit = MAX_HEADERS_RESULTS;
         LogPrint(BCLog::NET, "getheaders %d to %s from peer=%d\n",
@@ -5633,8 +6498,7 @@ void PeerManagerImpl::ProcessMessage(
         // in the SendMessages logic.
         nodestate->pindexBestHeaderSent =
             pindex ? pindex : m_chainman.ActiveChain().Tip();
-        m_connman.PushMessage(&pfrom,
-                              msgMaker.Make(NetMsgType::HEADERS, vHeaders));
+        PushHeadersMessage(pfrom, *peer, vHeaders);
         return;
     }
 
@@ -5657,244 +6521,23 @@ void PeerManagerImpl::ProcessMessage(
 
         CTransactionRef ptx;
         vRecv >> ptx;
-        const CTransaction &tx = *ptx;
-        const TxId &txid = tx.GetId();
-        AddKnownTx(*peer, txid);
-
-        bool shouldReconcileTx{false};
-        {
-            LOCK(cs_main);
-
-            m_txrequest.ReceivedResponse(pfrom.GetId(), txid);
-
-            if (AlreadyHaveTx(txid, /*include_reconsiderable=*/true)) {
-                if (pfrom.HasPermission(NetPermissionFlags::ForceRelay)) {
-                    // Always relay transactions received from peers with
-                    // forcerelay permission, even if they were already in the
-                    // mempool, allowing the node to function as a gateway for
-                    // nodes hidden behind it.
-                    if (!m_mempool.exists(tx.GetId())) {
-                        LogPrintf(
-                            "Not relaying non-mempool transaction %s from "
-                            "forcerelay peer=%d\n",
-                            tx.GetId().ToString(), pfrom.GetId());
-                    } else {
-                        LogPrintf("Force relaying tx %s from peer=%d\n",
-                                  tx.GetId().ToString(), pfrom.GetId());
-                        RelayTransaction(tx.GetId());
-                    }
-                }
-
-                if (m_recent_rejects_package_reconsiderable.contains(txid)) {
-                    // When a transaction is already in
-                    // m_recent_rejects_package_reconsiderable, we shouldn't
-                    // submit it by itself again. However, look for a matching
-                    // child in the orphanage, as it is possible that they
-                    // succeed as a package.
-                    LogPrint(
-                        BCLog::TXPACKAGES,
-                        "found tx %s in reconsiderable rejects, looking for "
-                        "child in orphanage\n",
-                        txid.ToString());
-                    if (auto package_to_validate{
-                            Find1P1CPackage(ptx, pfrom.GetId())}) {
-                        const auto package_result{ProcessNewPackage(
-                            m_chainman.ActiveChainstate(), m_mempool,
-                            package_to_validate->m_txns,
-                            /*test_accept=*/false)};
-                        LogPrint(BCLog::TXPACKAGES,
-                                 "package evaluation for %s: %s (%s)\n",
-                                 package_to_validate->ToString(),
-                                 package_result.m_state.IsValid()
-                                     ? "package accepted"
-                                     : "package rejected",
-                                 package_result.m_state.ToString());
-                        ProcessPackageResult(package_to_validate.value(),
-                                             package_result);
-                    }
-                }
-                // If a tx is detected by m_recent_rejects it is ignored.
-                // Because we haven't submitted the tx to our mempool, we won't
-                // have computed a DoS score for it or determined exactly why we
-                // consider it invalid.
-                //
-                // This means we won't penalize any peer subsequently relaying a
-                // DoSy tx (even if we penalized the first peer who gave it to
-                // us) because we have to account for m_recent_rejects showing
-                // false positives. In other words, we shouldn't penalize a peer
-                // if we aren't *sure* they submitted a DoSy tx.
-                //
-                // Note that m_recent_rejects doesn't just record DoSy or
-                // invalid transactions, but any tx not accepted by the mempool,
-                // which may be due to node policy (vs. consensus). So we can't
-                // blanket penalize a peer simply for relaying a tx that our
-                // m_recent_rejects has caught, regardless of false positives.
-                return;
-            }
-
-            const MempoolAcceptResult result =
-                m_chainman.ProcessTransaction(ptx);
-            const TxValidationState &state = result.m_state;
-
-            if (result.m_result_type ==
-                MempoolAcceptResult::ResultType::VALID) {
-                ProcessValidTx(pfrom.GetId(), ptx);
-                pfrom.m_last_tx_time = GetTime<std::chrono::seconds>();
-            } else if (state.GetResult() ==
-                       TxValidationResult::TX_MISSING_INPUTS) {
-                // It may be the case that the orphans parents have all been
-                // rejected.
-                bool fRejectedParents = false;
-
-                // Deduplicate parent txids, so that we don't have to loop over
-                // the same parent txid more than once down below.
-                std::vector<TxId> unique_parents;
-                unique_parents.reserve(tx.vin.size());
-                for (const CTxIn &txin : tx.vin) {
-                    // We start with all parents, and then remove duplicates
-                    // below.
-                    unique_parents.push_back(txin.prevout.GetTxId());
-                }
-                std::sort(unique_parents.begin(), unique_parents.end());
-                unique_parents.erase(
-                    std::unique(unique_parents.begin(), unique_parents.end()),
-                    unique_parents.end());
-
-                // Distinguish between parents in m_recent_rejects and
-                // m_recent_rejects_package_reconsiderable. We can tolerate
-                // having up to 1 parent in
-                // m_recent_rejects_package_reconsiderable since we submit 1p1c
-                // packages. However, fail immediately if any are in
-                // m_recent_rejects.
-                std::optional<TxId> rejected_parent_reconsiderable;
-                for (const TxId &parent_txid : unique_parents) {
-                    if (m_recent_rejects.contains(parent_txid)) {
-                        fRejectedParents = true;
-                        break;
-                    }
-
-                    if (m_recent_rejects_package_reconsiderable.contains(
-                            parent_txid) &&
-                        !m_mempool.exists(parent_txid)) {
-                        // More than 1 parent in
-                        // m_recent_rejects_package_reconsiderable:
-                        // 1p1c will not be sufficient to accept this package,
-                        // so just give up here.
-                        if (rejected_parent_reconsiderable.has_value()) {
-                            fRejectedParents = true;
-                            break;
-                        }
-                        rejected_parent_reconsiderable = parent_txid;
-                    }
-                }
-                if (!fRejectedParents) {
-                    const auto current_time{
-                        GetTime<std::chrono::microseconds>()};
-
-                    for (const TxId &parent_txid : unique_parents) {
-                        // FIXME: MSG_TX should use a TxHash, not a TxId.
-                        AddKnownTx(*peer, parent_txid);
-                        // Exclude m_recent_rejects_package_reconsiderable: the
-                        // missing parent may have been previously rejected for
-                        // being too low feerate. This orphan might CPFP it.
-                        if (!AlreadyHaveTx(parent_txid,
-                                           /*include_reconsiderable=*/false)) {
-                            AddTxAnnouncement(pfrom, parent_txid, current_time);
-                        }
-                    }
-
-                    // NO_THREAD_SAFETY_ANALYSIS because we can't annotate for
-                    // g_msgproc_mutex
-                    if (unsigned int nEvicted =
-                            m_mempool.withOrphanage(
-                                [&](TxOrphanage &orphanage)
-                                    NO_THREAD_SAFETY_ANALYSIS {
-                                        if (orphanage.AddTx(ptx,
-                                                            pfrom.GetId())) {
-                                            AddToCompactExtraTransactions(ptx);
-                                        }
-                                        return orphanage.LimitTxs(
-                                            m_opts.max_orphan_txs, m_rng);
-                                    }) > 0) {
-                        LogPrint(BCLog::TXPACKAGES,
-                                 "orphanage overflow, removed %u tx\n",
-                                 nEvicted);
-                    }
-
-                    // Once added to the orphan pool, a tx is considered
-                    // AlreadyHave, and we shouldn't request it anymore.
-                    m_txrequest.ForgetInvId(tx.GetId());
+        AddKnownTx(*peer, ptx->GetId());
 
-                } else {
-                    LogPrint(BCLog::MEMPOOL,
-                             "not keeping orphan with rejected parents %s\n",
-                             tx.GetId().ToString());
-                    // We will continue to reject this tx since it has rejected
-                    // parents so avoid re-requesting it from other peers.
-                    m_recent_rejects.insert(tx.GetId());
-                    m_txrequest.ForgetInvId(tx.GetId());
-                }
-            }
-            if (state.IsInvalid()) {
-                ProcessInvalidTx(pfrom.GetId(), ptx, state,
-                                 /*maybe_add_extra_compact_tx=*/true);
-            }
-            // When a transaction fails for TX_PACKAGE_RECONSIDERABLE, look for
-            // a matching child in the orphanage, as it is possible that they
-            // succeed as a package.
-            if (state.GetResult() ==
-                TxValidationResult::TX_PACKAGE_RECONSIDERABLE) {
-                LogPrint(
-                    BCLog::TXPACKAGES,
-                    "tx %s failed but reconsiderable, looking for child in "
-                    "orphanage\n",
-                    txid.ToString());
-                if (auto package_to_validate{
-                        Find1P1CPackage(ptx, pfrom.GetId())}) {
-                    const auto package_result{ProcessNewPackage(
-                        m_chainman.ActiveChainstate(), m_mempool,
-                        package_to_validate->m_txns, /*test_accept=*/false)};
-                    LogPrint(BCLog::TXPACKAGES,
-                             "package evaluation for %s: %s (%s)\n",
-                             package_to_validate->ToString(),
-                             package_result.m_state.IsValid()
-                                 ? "package accepted"
-                                 : "package rejected",
-                             package_result.m_state.ToString());
-                    ProcessPackageResult(package_to_validate.value(),
-                                         package_result);
-                }
-            }
+        if (m_opts.tx_validation_thread) {
+            QueueTxForValidation(pfrom, ptx);
+            return;
+        }
 
-            if (state.GetResult() ==
-                TxValidationResult::TX_AVALANCHE_RECONSIDERABLE) {
-                // Once added to the conflicting pool, a tx is considered
-                // AlreadyHave, and we shouldn't request it anymore.
-                m_txrequest.ForgetInvId(tx.GetId());
-
-                unsigned int nEvicted{0};
-                // NO_THREAD_SAFETY_ANALYSIS because of g_msgproc_mutex required
-                // in the lambda for m_rng
-                m_mempool.withConflicting(
-                    [&](TxConflicting &conflicting) NO_THREAD_SAFETY_ANALYSIS {
-                        conflicting.AddTx(ptx, pfrom.GetId());
-                        nEvicted = conflicting.LimitTxs(
-                            m_opts.max_conflicting_txs, m_rng);
-                        shouldReconcileTx = conflicting.HaveTx(ptx->GetId());
-                    });
-
-                if (nEvicted > 0) {
-                    LogPrint(BCLog::TXPACKAGES,
-                             "conflicting pool overflow, removed %u tx\n",
-                             nEvicted);
-                }
-            }
-        } // Release cs_main
+        if (m_opts.tx_batch_size > 0) {
+            // Validated along with the other transactions received meanwhile.
+            QueueTxForBatch(pfrom, ptx);
+            return;
+        }
 
-        if (m_avalanche && m_avalanche->m_preConsensus && shouldReconcileTx) {
+        if (WITH_LOCK(cs_main, return ProcessIncomingTx(pfrom, *peer, ptx)) &&
+            m_avalanche && m_avalanche->m_preConsensus) {
             m_avalanche->addToReconcile(ptx);
         }
-
         return;
     }
 
@@ -5916,6 +6559,8 @@ void PeerManagerImpl::ProcessMessage(
             return;
         }
 
+        PreverifyQueuedBlocksPoW(cmpctblock.header);
+
         bool received_new_header = false;
         const auto blockhash = cmpctblock.header.GetHash();
 
@@ -6077,8 +6722,10 @@ void PeerManagerImpl::ProcessMessage(
 
                     PartiallyDownloadedBlock &partialBlock =
                         *(*queuedBlockIt)->partialBlock;
-                    ReadStatus status =
-                        partialBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                    ReadStatus status{
+                        WITH_LOCK(m_extra_txn_mutex,
+                                  return partialBlock.InitData(
+                                      cmpctblock, vExtraTxnForCompact))};
                     if (status == READ_STATUS_INVALID) {
                         // Reset in-flight state in case Misbehaving does not
                         // result in a disconnect
@@ -6149,8 +6796,10 @@ void PeerManagerImpl::ProcessMessage(
                     // download from. Optimistically try to reconstruct anyway
                     // since we might be able to without any round trips.
                     PartiallyDownloadedBlock tempBlock(config, &m_mempool);
-                    ReadStatus status =
-                        tempBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                    ReadStatus status{
+                        WITH_LOCK(m_extra_txn_mutex,
+                                  return tempBlock.InitData(
+                                      cmpctblock, vExtraTxnForCompact))};
                     if (status != READ_STATUS_OK) {
                         // TODO: don't ignore failures
                         return;
@@ -6345,7 +6994,8 @@ void PeerManagerImpl::ProcessMessage(
         return;
     }
 
-    if (msg_type == NetMsgType::HEADERS) {
+    if (msg_type == NetMsgType::HEADERS ||
+        msg_type == NetMsgType::AUXHEADERS) {
         // Ignore headers received while importing
         if (m_chainman.m_blockman.LoadingBlocks()) {
             LogPrint(BCLog::NET,
@@ -6360,20 +7010,34 @@ void PeerManagerImpl::ProcessMessage(
 
         std::vector<CBlockHeader> headers;
 
-        // Bypass the normal CBlock deserialization, as we don't want to risk
-        // deserializing 2000 full blocks.
-        unsigned int nCount = ReadCompactSize(vRecv);
-        if (nCount > MAX_HEADERS_RESULTS) {
-            Misbehaving(*peer, 20,
-                        strprintf("too-many-headers: headers message size = %u",
-                                  nCount));
-            return;
-        }
-        headers.resize(nCount);
-        for (unsigned int n = 0; n < nCount; n++) {
-            vRecv >> headers[n];
-            // Ignore tx count; assume it is 0.
-            ReadCompactSize(vRecv);
+        if (msg_type == NetMsgType::AUXHEADERS) {
+            CompactAuxPowHeaders auxHeaders;
+            vRecv >> auxHeaders;
+            headers = std::move(auxHeaders.headers);
+            if (headers.size() > MAX_HEADERS_RESULTS) {
+                Misbehaving(
+                    *peer, 20,
+                    strprintf("too-many-headers: headers message size = %u",
+                              headers.size()));
+                return;
+            }
+        } else {
+            // Bypass the normal CBlock deserialization, as we don't want to
+            // risk deserializing 2000 full blocks.
+            unsigned int nCount = ReadCompactSize(vRecv);
+            if (nCount > MAX_HEADERS_RESULTS) {
+                Misbehaving(
+                    *peer, 20,
+                    strprintf("too-many-headers: headers message size = %u",
+                              nCount));
+                return;
+            }
+            headers.resize(nCount);
+            for (unsigned int n = 0; n < nCount; n++) {
+                vRecv >> headers[n];
+                // Ignore tx count; assume it is 0.
+                ReadCompactSize(vRecv);
+            }
         }
 
         ProcessHeadersMessage(config, pfrom, *peer, std::move(headers),
@@ -6416,6 +7080,8 @@ void PeerManagerImpl::ProcessMessage(
         LogPrint(BCLog::NET, "received block %s peer=%d\n",
                  pblock->GetHash().ToString(), pfrom.GetId());
 
+        PreverifyQueuedBlocksPoW(*pblock);
+
         // Process all blocks from whitelisted peers, even if not requested,
         // unless we're still syncing with the network. Such an unrequested
         // block may still be processed, subject to the conditions in
@@ -6430,6 +7096,7 @@ void PeerManagerImpl::ProcessMessage(
             // Always process the block if we requested it, since we may
             // need it even when it's not a candidate for a new best tip.
             forceProcessing = IsBlockRequested(hash);
+            BlockReceived(pfrom.GetId(), hash);
             RemoveBlockRequest(hash, pfrom.GetId());
             // mapBlockSource is only used for punishing peers and setting
             // which peers send us compact blocks, so the race between here and
@@ -7089,8 +7756,18 @@ void PeerManagerImpl::ProcessMessage(
         }
 
         // If there are prefilled proofs, process them first
+        const auto &prefilledProofs = compactProofs.getPrefilledProofs();
+        if (prefilledProofs.size() > 1 &&
+            !m_chainman.ActiveChainstate().IsInitialBlockDownload()) {
+            std::vector<avalanche::ProofRef> proofs;
+            proofs.reserve(prefilledProofs.size());
+            for (const auto &prefilledProof : prefilledProofs) {
+                proofs.push_back(prefilledProof.proof);
+            }
+            avalanche::Proof::preverifySignatures(proofs);
+        }
         std::set<uint32_t> prefilledIndexes;
-        for (const auto &prefilledProof : compactProofs.getPrefilledProofs()) {
+        for (const auto &prefilledProof : prefilledProofs) {
             if (!ReceivedAvalancheProof(pfrom, *peer, prefilledProof.proof)) {
                 // If we got an invalid proof, the peer is getting banned and we
                 // can bail out.
@@ -7136,30 +7813,38 @@ void PeerManagerImpl::ProcessMessage(
             return;
         }
 
-        std::vector<std::pair<avalanche::ProofId, bool>> remoteProofsStatus;
+        // The short ids depend on the salt picked by our peer for this
+        // message, so they have to be computed over all our proofs again. Only
+        // collect the proofs under the peer manager lock and match them after
+        // releasing it.
+        std::vector<avalanche::ProofRef> knownProofs;
         m_avalanche->withPeerManager([&](const avalanche::PeerManager &pm) {
             pm.forEachPeer([&](const avalanche::Peer &peer) {
                 assert(peer.proof);
-                uint64_t shortid = compactProofs.getShortID(peer.getProofId());
-
-                int added =
-                    shortIdProcessor.matchKnownItem(shortid, peer.proof);
-
-                // No collision
-                if (added >= 0) {
-                    // Because we know the proof, we can determine if our peer
-                    // has it (added = 1) or not (added = 0) and update the
-                    // remote proof status accordingly.
-                    remoteProofsStatus.emplace_back(peer.getProofId(),
-                                                    added > 0);
-                }
-
-                // In order to properly determine which proof is missing, we
-                // need to keep scanning for all our proofs.
+                knownProofs.push_back(peer.proof);
                 return true;
             });
         });
 
+        std::vector<std::pair<avalanche::ProofId, bool>> remoteProofsStatus;
+        remoteProofsStatus.reserve(knownProofs.size());
+        for (const avalanche::ProofRef &proof : knownProofs) {
+            uint64_t shortid = compactProofs.getShortID(proof->getId());
+
+            int added = shortIdProcessor.matchKnownItem(shortid, proof);
+
+            // No collision
+            if (added >= 0) {
+                // Because we know the proof, we can determine if our peer has
+                // it (added = 1) or not (added = 0) and update the remote proof
+                // status accordingly.
+                remoteProofsStatus.emplace_back(proof->getId(), added > 0);
+            }
+
+            // In order to properly determine which proof is missing, we need to
+            // keep scanning for all our proofs.
+        }
+
         avalanche::ProofsRequest req;
         for (size_t i = 0; i < compactProofs.size(); i++) {
             if (shortIdProcessor.getItem(i) == nullptr) {
@@ -7247,7 +7932,7 @@ void PeerManagerImpl::ProcessMessage(
         }
         peer->m_getaddr_recvd = true;
 
-        peer->m_addrs_to_send.clear();
+        WITH_LOCK(peer->m_addr_relay_mutex, peer->m_addrs_to_send.clear());
         std::vector<CAddress> vAddr;
         const size_t maxAddrToSend = m_opts.max_addr_to_send;
         if (pfrom.HasPermission(NetPermissionFlags::Addr)) {
@@ -7310,7 +7995,7 @@ void PeerManagerImpl::ProcessMessage(
             }
         });
 
-        peer->m_addrs_to_send.clear();
+        WITH_LOCK(peer->m_addr_relay_mutex, peer->m_addrs_to_send.clear());
         for (const CNode *pnode : avaNodes) {
             PushAddress(*peer, pnode->addr);
         }
@@ -7624,8 +8309,6 @@ bool PeerManagerImpl::MaybeDiscourageAndDisconnect(CNode &pnode, Peer &peer) {
 
 bool PeerManagerImpl::ProcessMessages(const Config &config, CNode *pfrom,
                                       std::atomic<bool> &interruptMsgProc) {
-    AssertLockHeld(g_msgproc_mutex);
-
     //
     // Message format
     //  (4) message start
@@ -7636,10 +8319,13 @@ bool PeerManagerImpl::ProcessMessages(const Config &config, CNode *pfrom,
     //
     bool fMoreWork = false;
 
+    MaybeProcessTxBatch();
+
     PeerRef peer = GetPeerRef(pfrom->GetId());
     if (peer == nullptr) {
         return false;
     }
+    LOCK(peer->m_msgproc_mutex);
 
     {
         LOCK(peer->m_getdata_requests_mutex);
@@ -7672,6 +8358,13 @@ bool PeerManagerImpl::ProcessMessages(const Config &config, CNode *pfrom,
         return false;
     }
 
+    // Wait for the validation thread to catch up with this peer, it wakes us
+    // up then.
+    if (m_opts.tx_validation_thread &&
+        IsTxValidationQueueFull(pfrom->GetId())) {
+        return false;
+    }
+
     std::list<CNetMessage> msgs;
     {
         LOCK(pfrom->cs_vProcessMsg);
@@ -7736,8 +8429,18 @@ bool PeerManagerImpl::ProcessMessages(const Config &config, CNode *pfrom,
     }
 
     try {
-        ProcessMessage(config, *pfrom, msg.m_type, vRecv, msg.m_time,
-                       interruptMsgProc);
+        {
+            metrics::ScopedTimer timer{MessageHandlerTime(msg.m_type)};
+            const auto cpu_start{GetThreadCPUTime()};
+            const auto wall_start{SteadyClock::now()};
+            ProcessMessage(config, *pfrom, peer, msg.m_type, vRecv, msg.m_time,
+                           interruptMsgProc);
+            m_connman.RecordMessageProcessTime(
+                *pfrom, msg.m_type,
+                {/*count=*/1, GetThreadCPUTime() - cpu_start,
+                 std::chrono::duration_cast<std::chrono::microseconds>(
+                     SteadyClock::now() - wall_start)});
+        }
         if (interruptMsgProc) {
             return false;
         }
@@ -8090,7 +8793,7 @@ void PeerManagerImpl::MaybeSendAddr(CNode &node, Peer &peer,
         // bandwidth cost that we can incur by doing this (which happens
         // once a day on average).
         if (peer.m_next_local_addr_send != 0us) {
-            peer.m_addr_known->reset();
+            WITH_LOCK(peer.m_addr_relay_mutex, peer.m_addr_known->reset());
         }
         if (std::optional<CService> local_service = GetLocalAddrForPeer(node)) {
             CAddress local_addr{*local_service, peer.m_our_services,
@@ -8109,6 +8812,7 @@ void PeerManagerImpl::MaybeSendAddr(CNode &node, Peer &peer,
     peer.m_next_addr_send =
         GetExponentialRand(current_time, AVG_ADDRESS_BROADCAST_INTERVAL);
 
+    LOCK(peer.m_addr_relay_mutex);
     const size_t max_addr_to_send = m_opts.max_addr_to_send;
     if (!Assume(peer.m_addrs_to_send.size() <= max_addr_to_send)) {
         // Should be impossible since we always check size before adding to
@@ -8120,7 +8824,7 @@ void PeerManagerImpl::MaybeSendAddr(CNode &node, Peer &peer,
     // addrs to the m_addr_known filter on the same pass.
     auto addr_already_known =
         [&peer](const CAddress &addr)
-            EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex) {
+            EXCLUSIVE_LOCKS_REQUIRED(peer.m_addr_relay_mutex) {
                 bool ret = peer.m_addr_known->contains(addr.GetKey());
                 if (!ret) {
                     peer.m_addr_known->insert(addr.GetKey());
@@ -8206,7 +8910,8 @@ void PeerManagerImpl::MaybeSendFeefilter(
         // chainstate is in IBD, so tell the peer to not send them.
         currentFilter = MAX_MONEY;
     } else {
-        static const Amount MAX_FILTER{m_fee_filter_rounder.round(MAX_MONEY)};
+        static const Amount MAX_FILTER{WITH_LOCK(
+            m_rng_mutex, return m_fee_filter_rounder.round(MAX_MONEY))};
         if (peer.m_fee_filter_sent == MAX_FILTER) {
             // Send the current filter if we sent MAX_FILTER previously
             // and made it out of IBD.
@@ -8214,7 +8919,8 @@ void PeerManagerImpl::MaybeSendFeefilter(
         }
     }
     if (current_time > peer.m_next_send_feefilter) {
-        Amount filterToSend = m_fee_filter_rounder.round(currentFilter);
+        Amount filterToSend{WITH_LOCK(
+            m_rng_mutex, return m_fee_filter_rounder.round(currentFilter))};
         // We always have a fee filter of at least the min relay fee
         filterToSend =
             std::max(filterToSend, m_mempool.m_min_relay_feerate.GetFeePerK());
@@ -8241,18 +8947,21 @@ void PeerManagerImpl::MaybeSendFeefilter(
 }
 
 namespace {
-class CompareInvMempoolOrder {
-    CTxMemPool *mp;
+/** A tx to announce, along with what is needed to order and filter it. */
+struct InvTxCandidate {
+    uint64_t entry_id;
+    std::set<TxId>::iterator it;
+    TxMempoolInfo info;
+};
 
+class CompareInvMempoolOrder {
 public:
-    explicit CompareInvMempoolOrder(CTxMemPool *_mempool) : mp(_mempool) {}
-
-    bool operator()(std::set<TxId>::iterator a, std::set<TxId>::iterator b) {
+    bool operator()(const InvTxCandidate &a, const InvTxCandidate &b) const {
         /**
          * As std::make_heap produces a max-heap, we want the entries which
          * are topologically earlier to sort later.
          */
-        return mp->CompareTopologically(*b, *a);
+        return a.entry_id > b.entry_id;
     }
 };
 } // namespace
@@ -8281,23 +8990,29 @@ bool PeerManagerImpl::SetupAddressRelay(const CNode &node, Peer &peer) {
         return false;
     }
 
-    if (!peer.m_addr_relay_enabled.exchange(true)) {
+    if (!peer.m_addr_relay_enabled) {
         // During version message processing (non-block-relay-only outbound
         // peers) or on first addr-related message we have received (inbound
         // peers), initialize m_addr_known.
-        peer.m_addr_known = std::make_unique<CRollingBloomFilter>(5000, 0.001);
+        {
+            LOCK(peer.m_addr_relay_mutex);
+            peer.m_addr_known =
+                std::make_unique<CRollingBloomFilter>(5000, 0.001);
+        }
+        // Only then may the other message handler threads relay addresses to
+        // this peer.
+        peer.m_addr_relay_enabled = true;
     }
 
     return true;
 }
 
 bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
-    AssertLockHeld(g_msgproc_mutex);
-
     PeerRef peer = GetPeerRef(pto->GetId());
     if (!peer) {
         return false;
     }
+    LOCK(peer->m_msgproc_mutex);
     const Consensus::Params &consensusParams = m_chainparams.GetConsensus();
 
     // We must call MaybeDiscourageAndDisconnect first, to ensure that we'll
@@ -8497,23 +9212,31 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
                              __func__, vHeaders.front().GetHash().ToString(),
                              pto->GetId());
 
-                    std::optional<CSerializedNetMsg> cached_cmpctblock_msg;
+                    std::shared_ptr<const CSerializedNetMsg>
+                        cached_cmpctblock_msg;
                     {
                         LOCK(m_most_recent_block_mutex);
                         if (m_most_recent_block_hash ==
                             pBestIndex->GetBlockHash()) {
-                            cached_cmpctblock_msg =
-                                msgMaker.Make(NetMsgType::CMPCTBLOCK,
-                                              *m_most_recent_compact_block);
+                            cached_cmpctblock_msg = m_relay_msg_cache.GetOrMake(
+                                CInv(MSG_CMPCT_BLOCK,
+                                     m_most_recent_block_hash),
+                                GetTime<std::chrono::seconds>(), [&] {
+                                    return msgMaker.Make(
+                                        NetMsgType::CMPCTBLOCK,
+                                        *m_most_recent_compact_block);
+                                });
                         }
                     }
-                    if (cached_cmpctblock_msg.has_value()) {
-                        m_connman.PushMessage(
-                            pto, std::move(cached_cmpctblock_msg.value()));
+                    if (cached_cmpctblock_msg) {
+                        m_connman.PushMessage(pto, cached_cmpctblock_msg);
                     } else {
-                        CBlock block;
-                        const bool ret{m_chainman.m_blockman.ReadBlockFromDisk(
-                            block, *pBestIndex)};
+                        std::vector<uint8_t> block_data;
+                        BlockView block;
+                        const bool ret{
+                            m_chainman.m_blockman.ReadRawBlockFromDisk(
+                                block_data, *pBestIndex) &&
+                            block.Parse(block_data)};
                         assert(ret);
                         CBlockHeaderAndShortTxIDs cmpctblock(block);
                         m_connman.PushMessage(
@@ -8535,8 +9258,7 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
                                  vHeaders.front().GetHash().ToString(),
                                  pto->GetId());
                     }
-                    m_connman.PushMessage(
-                        pto, msgMaker.Make(NetMsgType::HEADERS, vHeaders));
+                    PushHeadersMessage(*pto, *peer, vHeaders);
                     state.pindexBestHeaderSent = pBestIndex;
                 } else {
                     fRevertToInv = true;
@@ -8708,13 +9430,25 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
 
             // Determine transactions to relay
             if (fSendTrickle) {
-                // Produce a vector with all candidates for sending
-                std::vector<std::set<TxId>::iterator> vInvTx;
-                vInvTx.reserve(tx_relay->m_tx_inventory_to_send.size());
-                for (std::set<TxId>::iterator it =
-                         tx_relay->m_tx_inventory_to_send.begin();
-                     it != tx_relay->m_tx_inventory_to_send.end(); it++) {
-                    vInvTx.push_back(it);
+                // Produce a vector with all candidates for sending, looking
+                // them all up in the mempool at once rather than for every
+                // comparison.
+                const std::vector<TxId> txids{
+                    tx_relay->m_tx_inventory_to_send.begin(),
+                    tx_relay->m_tx_inventory_to_send.end()};
+                auto txinfos = m_mempool.infoWithEntryIds(txids);
+                std::vector<InvTxCandidate> vInvTx;
+                vInvTx.reserve(txids.size());
+                std::set<TxId>::iterator it =
+                    tx_relay->m_tx_inventory_to_send.begin();
+                for (auto &txinfo : txinfos) {
+                    if (!txinfo) {
+                        // Not in the mempool anymore? don't bother sending it.
+                        it = tx_relay->m_tx_inventory_to_send.erase(it);
+                        continue;
+                    }
+                    vInvTx.push_back(
+                        {txinfo->first, it++, std::move(txinfo->second)});
                 }
                 const CFeeRate filterrate{
                     tx_relay->m_fee_filter_received.load()};
@@ -8722,7 +9456,7 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
                 // mempool, which is guaranteed to be a topological sort order.
                 // A heap is used so that not all items need sorting if only a
                 // few are being sent.
-                CompareInvMempoolOrder compareInvMempoolOrder(&m_mempool);
+                CompareInvMempoolOrder compareInvMempoolOrder;
                 std::make_heap(vInvTx.begin(), vInvTx.end(),
                                compareInvMempoolOrder);
                 // No reason to drain out at many times the network's
@@ -8737,20 +9471,15 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
                     // Fetch the top element from the heap
                     std::pop_heap(vInvTx.begin(), vInvTx.end(),
                                   compareInvMempoolOrder);
-                    std::set<TxId>::iterator it = vInvTx.back();
-                    vInvTx.pop_back();
-                    const TxId txid = *it;
+                    TxMempoolInfo txinfo{std::move(vInvTx.back().info)};
+                    const TxId txid = *vInvTx.back().it;
                     // Remove it from the to-be-sent set
-                    tx_relay->m_tx_inventory_to_send.erase(it);
+                    tx_relay->m_tx_inventory_to_send.erase(vInvTx.back().it);
+                    vInvTx.pop_back();
                     // Check if not in the filter already
                     if (tx_relay->m_tx_inventory_known_filter.contains(txid)) {
                         continue;
                     }
-                    // Not in the mempool anymore? don't bother sending it.
-                    auto txinfo = m_mempool.info(txid);
-                    if (!txinfo.tx) {
-                        continue;
-                    }
                     // Peer told you to not send transactions at that
                     // feerate? Don't bother sending it.
                     if (txinfo.fee < filterrate.GetFee(txinfo.vsize)) {
@@ -8903,17 +9632,18 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
         LOCK(cs_main);
 
         CNodeState &state = *State(pto->GetId());
+        const unsigned int download_window{BlockDownloadWindow(*pto, state)};
 
         if (CanServeBlocks(*peer) &&
             ((sync_blocks_and_headers_from_peer && !IsLimitedPeer(*peer)) ||
              !m_chainman.ActiveChainstate().IsInitialBlockDownload()) &&
-            state.vBlocksInFlight.size() < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+            state.vBlocksInFlight.size() < download_window) {
             std::vector<const CBlockIndex *> vToDownload;
             NodeId staller = -1;
-            FindNextBlocksToDownload(pto->GetId(),
-                                     MAX_BLOCKS_IN_TRANSIT_PER_PEER -
-                                         state.vBlocksInFlight.size(),
-                                     vToDownload, staller);
+            const CBlockIndex *stalled_block{nullptr};
+            FindNextBlocksToDownload(
+                pto->GetId(), download_window - state.vBlocksInFlight.size(),
+                vToDownload, staller, stalled_block);
             for (const CBlockIndex *pindex : vToDownload) {
                 vGetData.push_back(CInv(MSG_BLOCK, pindex->GetBlockHash()));
                 BlockRequested(config, pto->GetId(), *pindex);
@@ -8922,10 +9652,30 @@ bool PeerManagerImpl::SendMessages(const Config &config, CNode *pto) {
                          pto->GetId());
             }
             if (state.vBlocksInFlight.empty() && staller != -1) {
-                if (State(staller)->m_stalling_since == 0us) {
-                    State(staller)->m_stalling_since = current_time;
+                CNodeState &staller_state = *State(staller);
+                if (staller_state.m_stalling_since == 0us) {
+                    staller_state.m_stalling_since = current_time;
                     LogPrint(BCLog::NET, "Stall started peer=%d\n", staller);
                 }
+                // The whole download waits on this block, so also request it
+                // from this idle peer, unless it is known to be slower.
+                const bool slower{
+                    state.m_block_receive_interval != 0us &&
+                    staller_state.m_block_receive_interval != 0us &&
+                    state.m_block_receive_interval >=
+                        staller_state.m_block_receive_interval};
+                if (stalled_block && !slower &&
+                    mapBlocksInFlight.count(stalled_block->GetBlockHash()) ==
+                        1) {
+                    vGetData.push_back(
+                        CInv(MSG_BLOCK, stalled_block->GetBlockHash()));
+                    BlockRequested(config, pto->GetId(), *stalled_block);
+                    LogPrint(BCLog::NET,
+                             "Requesting stalled block %s (%d) from peer=%d "
+                             "too\n",
+                             stalled_block->GetBlockHash().ToString(),
+                             stalled_block->nHeight, pto->GetId());
+                }
             }
         }
     } // release cs_main
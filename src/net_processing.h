@@ -35,6 +35,22 @@ static const uint32_t DEFAULT_MAX_CONFLICTING_TRANSACTIONS{100};
  * reconstruction. Includes orphan and rejected transactions.
  */
 static const uint32_t DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN{100};
+/**
+ * Default number of incoming transactions validated together, 0 to validate
+ * each of them as it is received.
+ */
+static const uint32_t DEFAULT_TX_BATCH_SIZE{0};
+/**
+ * Default for whether incoming transactions are validated on a dedicated
+ * thread rather than on the message handler threads.
+ */
+static const bool DEFAULT_TX_VALIDATION_THREAD{false};
+/**
+ * Default for whether the blocks received during the initial block download
+ * are connected on a dedicated thread rather than on the message handler
+ * threads.
+ */
+static const bool DEFAULT_BLOCK_CONNECT_THREAD{false};
 static const bool DEFAULT_PEERBLOCKFILTERS = false;
 /** Threshold for marking a node to be discouraged, e.g. disconnected and added
  * to the discouragement filter. */
@@ -78,6 +94,14 @@ public:
         //! Number of non-mempool transactions to keep around for block
         //! reconstruction. Includes orphan and rejected transactions.
         uint32_t max_extra_txs{DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN};
+        //! Number of incoming transactions validated together, 0 to validate
+        //! each of them as it is received.
+        uint32_t tx_batch_size{DEFAULT_TX_BATCH_SIZE};
+        //! Whether incoming transactions are validated on a dedicated thread.
+        bool tx_validation_thread{DEFAULT_TX_VALIDATION_THREAD};
+        //! Whether the blocks received during the initial block download are
+        //! connected on a dedicated thread.
+        bool block_connect_thread{DEFAULT_BLOCK_CONNECT_THREAD};
         //! Whether all P2P messages are captured to disk
         bool capture_messages{false};
         //! Number of addresses a node may send in an ADDR message.
@@ -126,6 +150,19 @@ public:
     /** Begin running background tasks, should only be called once */
     virtual void StartScheduledTasks(CScheduler &scheduler) = 0;
 
+    /**
+     * Stop the transaction validation thread, if any, dropping the
+     * transactions it did not validate yet. Must be called before the connman
+     * is stopped.
+     */
+    virtual void StopTxValidation() = 0;
+
+    /**
+     * Stop the block connection thread, if any. The blocks it did not connect
+     * yet are stored, so they are connected on the next start.
+     */
+    virtual void StopBlockConnection() = 0;
+
     /** Get statistics from node state */
     virtual bool GetNodeStateStats(NodeId nodeid,
                                    CNodeStateStats &stats) const = 0;
@@ -159,8 +196,7 @@ public:
     virtual void ProcessMessage(const Config &config, CNode &pfrom,
                                 const std::string &msg_type, CDataStream &vRecv,
                                 const std::chrono::microseconds time_received,
-                                const std::atomic<bool> &interruptMsgProc)
-        EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex) = 0;
+                                const std::atomic<bool> &interruptMsgProc) = 0;
 
     /**
      * This function is used for testing the stale tip eviction logic, see
@@ -1230,6 +1230,26 @@ bool CSubNet::IsValid() const {
     return valid;
 }
 
+std::optional<uint8_t> CSubNet::GetPrefixLength() const {
+    if (!valid) {
+        return std::nullopt;
+    }
+
+    uint8_t cidr = 0;
+    bool zeros_found = false;
+    for (size_t i = 0; i < network.m_addr.size(); ++i) {
+        const int num_bits = NetmaskBits(netmask[i]);
+        if (num_bits == -1 || (zeros_found && num_bits != 0)) {
+            return std::nullopt;
+        }
+        if (num_bits < 8) {
+            zeros_found = true;
+        }
+        cidr += num_bits;
+    }
+    return cidr;
+}
+
 bool CSubNet::SanityCheck() const {
     if (!(network.IsIPv4() || network.IsIPv6())) {
         return false;
@@ -22,6 +22,7 @@
 #include <array>
 #include <cstdint>
 #include <ios>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -516,6 +517,13 @@ public:
     std::string ToString() const;
     bool IsValid() const;
 
+    /**
+     * @returns The number of leading bits matched by this subnet, so that it
+     *          equals CSubNet(network, length), or std::nullopt if it is
+     *          invalid or its netmask is not a prefix.
+     */
+    std::optional<uint8_t> GetPrefixLength() const;
+
     friend bool operator==(const CSubNet &a, const CSubNet &b);
     friend bool operator!=(const CSubNet &a, const CSubNet &b) {
         return !(a == b);
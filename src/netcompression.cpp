@@ -0,0 +1,131 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
+#include <netcompression.h>
+
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef ENABLE_ZSTD
+struct P2PCompressor::Context {
+    ZSTD_CCtx *cctx{ZSTD_createCCtx()};
+
+    Context() {
+        if (!cctx) {
+            return;
+        }
+        const size_t level{ZSTD_CCtx_setParameter(
+            cctx, ZSTD_c_compressionLevel, P2P_COMPRESSION_LEVEL)};
+        const size_t window{ZSTD_CCtx_setParameter(
+            cctx, ZSTD_c_windowLog, P2P_COMPRESSION_WINDOW_LOG)};
+        if (ZSTD_isError(level) || ZSTD_isError(window)) {
+            ZSTD_freeCCtx(cctx);
+            cctx = nullptr;
+        }
+    }
+    ~Context() { ZSTD_freeCCtx(cctx); }
+};
+
+struct P2PDecompressor::Context {
+    ZSTD_DCtx *dctx{ZSTD_createDCtx()};
+
+    Context() {
+        if (!dctx) {
+            return;
+        }
+        const size_t window{ZSTD_DCtx_setParameter(
+            dctx, ZSTD_d_windowLogMax, P2P_COMPRESSION_WINDOW_LOG)};
+        if (ZSTD_isError(window)) {
+            ZSTD_freeDCtx(dctx);
+            dctx = nullptr;
+        }
+    }
+    ~Context() { ZSTD_freeDCtx(dctx); }
+};
+
+bool P2PCompressionSupported() {
+    return true;
+}
+
+P2PCompressor::P2PCompressor() : m_ctx{std::make_unique<Context>()} {}
+
+bool P2PCompressor::Compress(Span<const uint8_t> data,
+                             std::vector<uint8_t> &compressed) {
+    if (!m_ctx || !m_ctx->cctx) {
+        return false;
+    }
+    const size_t offset{compressed.size()};
+    compressed.resize(offset + ZSTD_compressBound(data.size()));
+    ZSTD_inBuffer in{data.data(), data.size(), 0};
+    ZSTD_outBuffer out{compressed.data(), compressed.size(), offset};
+    while (true) {
+        const size_t remaining{
+            ZSTD_compressStream2(m_ctx->cctx, &out, &in, ZSTD_e_flush)};
+        if (ZSTD_isError(remaining)) {
+            // The peer can not follow the stream anymore
+            m_ctx.reset();
+            compressed.resize(offset);
+            return false;
+        }
+        if (remaining == 0) {
+            break;
+        }
+        compressed.resize(compressed.size() + remaining);
+        out.dst = compressed.data();
+        out.size = compressed.size();
+    }
+    compressed.resize(out.pos);
+    return true;
+}
+
+P2PDecompressor::P2PDecompressor() : m_ctx{std::make_unique<Context>()} {}
+
+bool P2PDecompressor::Decompress(Span<const uint8_t> compressed,
+                                 Span<uint8_t> data) {
+    if (!m_ctx || !m_ctx->dctx) {
+        return false;
+    }
+    ZSTD_inBuffer in{compressed.data(), compressed.size(), 0};
+    ZSTD_outBuffer out{data.data(), data.size(), 0};
+    while (in.pos < in.size || out.pos < out.size) {
+        const size_t in_pos{in.pos}, out_pos{out.pos};
+        if (ZSTD_isError(ZSTD_decompressStream(m_ctx->dctx, &out, &in)) ||
+            (in.pos == in_pos && out.pos == out_pos)) {
+            // Either invalid, truncated or not of the expected size
+            m_ctx.reset();
+            return false;
+        }
+    }
+    return true;
+}
+#else
+struct P2PCompressor::Context {};
+struct P2PDecompressor::Context {};
+
+bool P2PCompressionSupported() {
+    return false;
+}
+
+P2PCompressor::P2PCompressor() {}
+
+bool P2PCompressor::Compress(Span<const uint8_t> data,
+                             std::vector<uint8_t> &compressed) {
+    return false;
+}
+
+P2PDecompressor::P2PDecompressor() {}
+
+bool P2PDecompressor::Decompress(Span<const uint8_t> compressed,
+                                 Span<uint8_t> data) {
+    return false;
+}
+#endif
+
+P2PCompressor::~P2PCompressor() = default;
+P2PDecompressor::~P2PDecompressor() = default;
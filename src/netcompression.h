@@ -0,0 +1,82 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NETCOMPRESSION_H
+#define BITCOIN_NETCOMPRESSION_H
+
+#include <span.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/** Default for -p2pcompression. */
+static constexpr bool DEFAULT_P2P_COMPRESSION{false};
+
+/**
+ * The log2 of the window of the zstd stream of the compressed messages sent on
+ * a connection. It bounds the memory both peers keep for each other, so the
+ * compressed messages must be decompressible with it.
+ */
+static constexpr int P2P_COMPRESSION_WINDOW_LOG{17};
+
+/** The fast zstd level the messages are compressed at. */
+static constexpr int P2P_COMPRESSION_LEVEL{1};
+
+/** Messages smaller than this are not worth compressing. */
+static constexpr size_t P2P_COMPRESSION_MIN_SIZE{256};
+
+/**
+ * Once this many bytes of messages of a type are compressed, the type is sent
+ * as is from then on if it did not compress to less than 15/16 of its size.
+ */
+static constexpr uint64_t P2P_COMPRESSION_SAMPLE_SIZE{64 * 1024};
+
+/** Whether the messages can be compressed, i.e. zstd support is built in. */
+bool P2PCompressionSupported();
+
+/**
+ * The zstd stream of the messages compressed for a peer. Each message is
+ * flushed, so the peer can decompress it as soon as it gets it, but the window
+ * is shared by the stream, so the repeated parts of the successive messages
+ * (e.g. the auxpow of consecutive merge-mined headers) compress too. The
+ * messages must be decompressed in the order they are compressed.
+ */
+class P2PCompressor {
+public:
+    P2PCompressor();
+    ~P2PCompressor();
+
+    /**
+     * Append the next message of the stream, compressed, to compressed. Return
+     * false if compression is not supported or failed, in which case the
+     * stream is broken and the compressor must not be used anymore.
+     */
+    bool Compress(Span<const uint8_t> data, std::vector<uint8_t> &compressed);
+
+private:
+    struct Context;
+    std::unique_ptr<Context> m_ctx;
+};
+
+/** The zstd stream of the compressed messages received from a peer. */
+class P2PDecompressor {
+public:
+    P2PDecompressor();
+    ~P2PDecompressor();
+
+    /**
+     * Decompress the next message of the stream, which must be exactly as
+     * large as data. Return false if decompression is not supported or
+     * failed, in which case the stream is broken.
+     */
+    bool Decompress(Span<const uint8_t> compressed, Span<uint8_t> data);
+
+private:
+    struct Context;
+    std::unique_ptr<Context> m_ctx;
+};
+
+#endif // BITCOIN_NETCOMPRESSION_H
@@ -30,6 +30,28 @@ public:
         return Make(0, std::move(msg_type), std::forward<Args>(args)...);
     }
 
+    /**
+     * Like Make, but the payload is sized first so that it gets written with
+     * a single allocation. This is for the large messages, such as blocks and
+     * transactions, whose size is cheap to compute.
+     */
+    template <typename... Args>
+    CSerializedNetMsg MakeReserved(int nFlags, std::string msg_type,
+                                   Args &&...args) const {
+        CSerializedNetMsg msg;
+        msg.m_type = std::move(msg_type);
+        msg.data.reserve(GetSerializeSizeMany(nFlags | nVersion, args...));
+        CVectorWriter{SER_NETWORK, nFlags | nVersion, msg.data, 0,
+                      std::forward<Args>(args)...};
+        return msg;
+    }
+
+    template <typename... Args>
+    CSerializedNetMsg MakeReserved(std::string msg_type, Args &&...args) const {
+        return MakeReserved(0, std::move(msg_type),
+                            std::forward<Args>(args)...);
+    }
+
 private:
     const int nVersion;
 };
@@ -0,0 +1,102 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
+#include <node/blockcompression.h>
+
+#include <serialize.h>
+
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+
+#include <memory>
+#endif
+
+namespace node {
+
+#ifdef ENABLE_ZSTD
+namespace {
+struct CCtxDeleter {
+    void operator()(ZSTD_CCtx *ctx) const { ZSTD_freeCCtx(ctx); }
+};
+struct DCtxDeleter {
+    void operator()(ZSTD_DCtx *ctx) const { ZSTD_freeDCtx(ctx); }
+};
+
+// The contexts are reused by each thread, rather than allocated for every
+// block.
+ZSTD_CCtx *CompressionContext() {
+    thread_local std::unique_ptr<ZSTD_CCtx, CCtxDeleter> ctx{ZSTD_createCCtx()};
+    return ctx.get();
+}
+
+ZSTD_DCtx *DecompressionContext() {
+    thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> ctx{ZSTD_createDCtx()};
+    return ctx.get();
+}
+} // namespace
+
+bool BlockCompressionSupported() {
+    return true;
+}
+
+bool CompressBlock(Span<const uint8_t> block, int level,
+                   std::vector<uint8_t> &compressed) {
+    ZSTD_CCtx *ctx{CompressionContext()};
+    if (!ctx || block.empty()) {
+        return false;
+    }
+    // Anything not smaller than the block is useless, so there is no need to
+    // make room for the worst case.
+    compressed.resize(block.size() - 1);
+    const size_t size{ZSTD_compressCCtx(ctx, compressed.data(),
+                                        compressed.size(), block.data(),
+                                        block.size(), level)};
+    if (ZSTD_isError(size)) {
+        compressed.clear();
+        return false;
+    }
+    compressed.resize(size);
+    return true;
+}
+
+bool DecompressBlock(Span<const uint8_t> compressed,
+                     std::vector<uint8_t> &block) {
+    ZSTD_DCtx *ctx{DecompressionContext()};
+    const unsigned long long size{
+        ZSTD_getFrameContentSize(compressed.data(), compressed.size())};
+    if (!ctx || size == ZSTD_CONTENTSIZE_UNKNOWN ||
+        size == ZSTD_CONTENTSIZE_ERROR || size > MAX_SIZE) {
+        return false;
+    }
+    block.resize(size);
+    const size_t result{ZSTD_decompressDCtx(ctx, block.data(), block.size(),
+                                            compressed.data(),
+                                            compressed.size())};
+    if (ZSTD_isError(result) || result != size) {
+        block.clear();
+        return false;
+    }
+    return true;
+}
+#else
+bool BlockCompressionSupported() {
+    return false;
+}
+
+bool CompressBlock(Span<const uint8_t> block, int level,
+                   std::vector<uint8_t> &compressed) {
+    return false;
+}
+
+bool DecompressBlock(Span<const uint8_t> compressed,
+                     std::vector<uint8_t> &block) {
+    return false;
+}
+#endif
+
+} // namespace node
@@ -0,0 +1,46 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKCOMPRESSION_H
+#define BITCOIN_NODE_BLOCKCOMPRESSION_H
+
+#include <span.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace node {
+
+/**
+ * Set in the size stored in front of a block to mark it as compressed. The
+ * size is then the one of the zstd frame that follows, which records the size
+ * of the serialized block it decompresses to. Actual block sizes are way below
+ * this bit, so the blocks stored as is keep their format.
+ */
+static constexpr uint32_t BLOCK_COMPRESSED_FLAG{0x80000000};
+
+/** The highest zstd compression level. */
+static constexpr int MAX_BLOCK_COMPRESSION_LEVEL{22};
+
+/** Whether the blocks can be compressed, i.e. zstd support is built in. */
+bool BlockCompressionSupported();
+
+/**
+ * Compress a serialized block at the given level. Return false if that is not
+ * supported or failed, or if it would not make the block smaller, in which
+ * case the block should be stored as is.
+ */
+bool CompressBlock(Span<const uint8_t> block, int level,
+                   std::vector<uint8_t> &compressed);
+
+/**
+ * Decompress a block stored compressed. Return false if that is not supported,
+ * or if the stored data is not a valid frame of a block.
+ */
+bool DecompressBlock(Span<const uint8_t> compressed,
+                     std::vector<uint8_t> &block);
+
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKCOMPRESSION_H
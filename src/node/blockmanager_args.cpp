@@ -5,12 +5,14 @@
 #include <node/blockmanager_args.h>
 
 #include <common/args.h>
+#include <node/blockcompression.h>
 #include <node/blockstorage.h>
 #include <tinyformat.h>
 #include <util/translation.h>
 #include <validation.h>
 
 #include <cstdint>
+#include <limits>
 #include <optional>
 
 namespace node {
@@ -35,12 +37,59 @@ std::optional<bilingual_str> ApplyArgsManOptions(const ArgsManager &args,
     }
     opts.prune_target = nPruneTarget;
 
+    if (auto value{args.GetIntArg("-pruneundo")}) {
+        if (*value != 0 && (*value < int64_t(MIN_BLOCKS_TO_KEEP) ||
+                            *value > std::numeric_limits<int>::max())) {
+            return strprintf(_("-pruneundo must be 0 or at least %d."),
+                             MIN_BLOCKS_TO_KEEP);
+        }
+        opts.prune_undo_depth = int(*value);
+    }
+
     if (auto value{args.GetBoolArg("-fastprune")}) {
         opts.fast_prune = *value;
     }
     if (auto value{args.GetBoolArg("-stopafterblockimport")}) {
         opts.stop_after_block_import = *value;
     }
+    if (auto value{args.GetBoolArg("-checkblockreadpow")}) {
+        opts.check_block_read_pow = *value;
+    }
+    if (auto value{args.GetBoolArg("-blockfilemmap")}) {
+        opts.block_file_mmap = *value;
+    }
+    if (auto value{args.GetIntArg("-blockreadhandles")}) {
+        if (*value < 0) {
+            return _("-blockreadhandles cannot be configured with a negative "
+                     "value.");
+        }
+        opts.block_read_handles = size_t(*value);
+    }
+    if (auto value{args.GetIntArg("-blockwritequeue")}) {
+        if (*value < 0) {
+            return _("-blockwritequeue cannot be configured with a negative "
+                     "value.");
+        }
+        opts.block_write_queue_bytes = size_t(*value) << 20;
+    }
+    if (auto value{args.GetIntArg("-blockcompression")}) {
+        if (*value != 0 && !BlockCompressionSupported()) {
+            return _("-blockcompression is not supported by this build.");
+        }
+        if (*value < 0 || *value > MAX_BLOCK_COMPRESSION_LEVEL) {
+            return strprintf(_("-blockcompression must be between 0 and %d."),
+                             MAX_BLOCK_COMPRESSION_LEVEL);
+        }
+        opts.block_compression_level = int(*value);
+    }
+    if (auto value{args.GetIntArg("-reindexreadahead")}) {
+        if (*value < 0 || *value > MAX_REINDEX_READ_AHEAD) {
+            return strprintf(
+                _("-reindexreadahead must be between 0 and %d."),
+                MAX_REINDEX_READ_AHEAD);
+        }
+        opts.reindex_read_ahead = int(*value);
+    }
 
     return std::nullopt;
 }
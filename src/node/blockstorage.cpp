@@ -10,21 +10,29 @@
 #include <clientversion.h>
 #include <common/system.h>
 #include <config.h>
+#include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
 #include <flatfile.h>
 #include <hash.h>
 #include <kernel/chainparams.h>
 #include <logging.h>
+#include <node/blockcompression.h>
 #include <pow/auxpow.h>
 #include <pow/pow.h>
+#include <pow/powcache.h>
 #include <reverse_iterator.h>
 #include <shutdown.h>
 #include <streams.h>
 #include <undo.h>
 #include <util/batchpriority.h>
 #include <util/fs.h>
+#include <util/thread.h>
 #include <validation.h>
+#include <validationthreadpool.h>
 
+#include <deque>
+#include <future>
 #include <map>
 #include <unordered_map>
 
@@ -91,17 +99,29 @@ CBlockIndex *BlockManager::AddToBlockIndex(const CBlockHeader &block,
     }
 
     m_dirty_blockindex.insert(pindexNew);
+    if (block.auxpow) {
+        m_dirty_auxpow.emplace(pindexNew, block.auxpow);
+    }
     return pindexNew;
 }
 
 void BlockManager::PruneOneBlockFile(const int fileNumber) {
+    PruneBlockFiles({fileNumber});
+}
+
+void BlockManager::PruneBlockFiles(const std::set<int> &file_numbers) {
     AssertLockHeld(cs_main);
     LOCK(cs_LastBlockFile);
+    if (file_numbers.empty()) {
+        return;
+    }
 
     for (auto &entry : m_block_index) {
         CBlockIndex *pindex = &entry.second;
-        if (pindex->nFile == fileNumber) {
-            pindex->nStatus = pindex->nStatus.withData(false).withUndo(false);
+        if (pindex->nStatus.hasData() && file_numbers.count(pindex->nFile)) {
+            pindex->nStatus = pindex->nStatus.withData(false)
+                                  .withUndo(false)
+                                  .withCheckedPoW(false);
             pindex->nFile = 0;
             pindex->nDataPos = 0;
             pindex->nUndoPos = 0;
@@ -123,8 +143,33 @@ void BlockManager::PruneOneBlockFile(const int fileNumber) {
         }
     }
 
-    m_blockfile_info[fileNumber].SetNull();
-    m_dirty_fileinfo.insert(fileNumber);
+    for (const int fileNumber : file_numbers) {
+        m_blockfile_info[fileNumber].SetNull();
+        m_dirty_fileinfo.insert(fileNumber);
+    }
+    while (m_first_unpruned_file < m_last_blockfile &&
+           m_blockfile_info[m_first_unpruned_file].nSize == 0) {
+        ++m_first_unpruned_file;
+    }
+}
+
+void BlockManager::PruneUndoFiles(const std::set<int> &file_numbers) {
+    AssertLockHeld(cs_main);
+    LOCK(cs_LastBlockFile);
+
+    for (auto &entry : m_block_index) {
+        CBlockIndex *pindex = &entry.second;
+        if (pindex->nStatus.hasUndo() && file_numbers.count(pindex->nFile)) {
+            pindex->nStatus = pindex->nStatus.withUndo(false);
+            pindex->nUndoPos = 0;
+            m_dirty_blockindex.insert(pindex);
+        }
+    }
+
+    for (const int fileNumber : file_numbers) {
+        m_blockfile_info[fileNumber].nUndoSize = 0;
+        m_dirty_fileinfo.insert(fileNumber);
+    }
 }
 
 void BlockManager::FindFilesToPruneManual(std::set<int> &setFilesToPrune,
@@ -141,16 +186,18 @@ void BlockManager::FindFilesToPruneManual(std::set<int> &setFilesToPrune,
     // MIN_BLOCKS_TO_KEEP from the tip)
     unsigned int nLastBlockWeCanPrune{std::min(
         (unsigned)nManualPruneHeight, chain_tip_height - MIN_BLOCKS_TO_KEEP)};
-    int count = 0;
-    for (int fileNumber = 0; fileNumber < m_last_blockfile; fileNumber++) {
+    std::set<int> selected;
+    for (int fileNumber = m_first_unpruned_file; fileNumber < m_last_blockfile;
+         fileNumber++) {
         if (m_blockfile_info[fileNumber].nSize == 0 ||
             m_blockfile_info[fileNumber].nHeightLast > nLastBlockWeCanPrune) {
             continue;
         }
-        PruneOneBlockFile(fileNumber);
-        setFilesToPrune.insert(fileNumber);
-        count++;
+        selected.insert(fileNumber);
     }
+    const size_t count{selected.size()};
+    PruneBlockFiles(selected);
+    setFilesToPrune.merge(selected);
     LogPrintf("Prune (Manual): prune_height=%d removed %d blk/rev pairs\n",
               nLastBlockWeCanPrune, count);
 }
@@ -175,7 +222,7 @@ void BlockManager::FindFilesToPrune(std::set<int> &setFilesToPrune,
     // allocation before the next pruning.
     uint64_t nBuffer = BLOCKFILE_CHUNK_SIZE + UNDOFILE_CHUNK_SIZE;
     uint64_t nBytesToPrune;
-    int count = 0;
+    std::set<int> selected;
 
     if (nCurrentUsage + nBuffer >= GetPruneTarget()) {
         // On a prune event, the chainstate DB is flushed.
@@ -188,7 +235,8 @@ void BlockManager::FindFilesToPrune(std::set<int> &setFilesToPrune,
             nBuffer += GetPruneTarget() / 10;
         }
 
-        for (int fileNumber = 0; fileNumber < m_last_blockfile; fileNumber++) {
+        for (int fileNumber = m_first_unpruned_file;
+             fileNumber < m_last_blockfile; fileNumber++) {
             nBytesToPrune = m_blockfile_info[fileNumber].nSize +
                             m_blockfile_info[fileNumber].nUndoSize;
 
@@ -208,13 +256,14 @@ void BlockManager::FindFilesToPrune(std::set<int> &setFilesToPrune,
                 continue;
             }
 
-            PruneOneBlockFile(fileNumber);
-            // Queue up the files for removal
-            setFilesToPrune.insert(fileNumber);
+            selected.insert(fileNumber);
             nCurrentUsage -= nBytesToPrune;
-            count++;
         }
     }
+    const size_t count{selected.size()};
+    PruneBlockFiles(selected);
+    // Queue up the files for removal
+    setFilesToPrune.merge(selected);
 
     LogPrint(BCLog::PRUNE,
              "Prune: target=%dMiB actual=%dMiB diff=%dMiB "
@@ -224,6 +273,43 @@ void BlockManager::FindFilesToPrune(std::set<int> &setFilesToPrune,
              nLastBlockWeCanPrune, count);
 }
 
+void BlockManager::FindUndoFilesToPrune(std::set<int> &setFilesToPrune,
+                                        int chain_tip_height,
+                                        int prune_height) {
+    AssertLockHeld(::cs_main);
+    LOCK(cs_LastBlockFile);
+    if (chain_tip_height < 0 || GetPruneUndoDepth() == 0) {
+        return;
+    }
+
+    const int nLastBlockWeCanPrune{
+        std::min(prune_height, chain_tip_height - GetPruneUndoDepth())};
+    if (nLastBlockWeCanPrune < 0) {
+        return;
+    }
+    uint64_t nBytesPruned = 0;
+    std::set<int> files;
+    // The last file is still being written to
+    for (int fileNumber = 0; fileNumber < m_last_blockfile; fileNumber++) {
+        const CBlockFileInfo &info = m_blockfile_info[fileNumber];
+        if (info.nUndoSize == 0 ||
+            info.nHeightLast > unsigned(nLastBlockWeCanPrune)) {
+            continue;
+        }
+        nBytesPruned += info.nUndoSize;
+        files.insert(fileNumber);
+    }
+    if (files.empty()) {
+        return;
+    }
+
+    PruneUndoFiles(files);
+    setFilesToPrune.insert(files.begin(), files.end());
+    LogPrint(BCLog::PRUNE,
+             "Prune: max_undo_prune_height=%d removed %d rev files (%dMiB)\n",
+             nLastBlockWeCanPrune, files.size(), nBytesPruned / 1024 / 1024);
+}
+
 void BlockManager::UpdatePruneLock(const std::string &name,
                                    const PruneLockInfo &lock_info) {
     AssertLockHeld(::cs_main);
@@ -251,7 +337,8 @@ bool BlockManager::LoadBlockIndex() {
             GetConsensus(),
             [this](const BlockHash &hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
                 return this->InsertBlockIndex(hash);
-            })) {
+            },
+            GetValidationThreadPool())) {
         return false;
     }
 
@@ -260,12 +347,28 @@ bool BlockManager::LoadBlockIndex() {
     std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
               CBlockIndexHeightOnlyComparator());
 
+    // The proofs of the blocks themselves don't depend on each other, so they
+    // are computed in parallel and only summed up along the chains below.
+    static constexpr size_t PROOF_SHARD_ENTRIES{1 << 14};
+    GetValidationThreadPool().ParallelFor(
+        (vSortedByHeight.size() + PROOF_SHARD_ENTRIES - 1) /
+            PROOF_SHARD_ENTRIES,
+        [&](size_t shard) {
+            const size_t end{std::min(vSortedByHeight.size(),
+                                      (shard + 1) * PROOF_SHARD_ENTRIES)};
+            for (size_t i = shard * PROOF_SHARD_ENTRIES; i < end; ++i) {
+                vSortedByHeight[i]->nChainWork =
+                    GetBlockProof(*vSortedByHeight[i]);
+            }
+        });
+
     for (CBlockIndex *pindex : vSortedByHeight) {
         if (ShutdownRequested()) {
             return false;
         }
-        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) +
-                             GetBlockProof(*pindex);
+        if (pindex->pprev) {
+            pindex->nChainWork += pindex->pprev->nChainWork;
+        }
         pindex->nTimeMax =
             (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime)
                            : pindex->nTime);
@@ -311,9 +414,17 @@ bool BlockManager::WriteBlockIndexDB() {
 
     m_dirty_blockindex.clear();
 
-    if (!m_block_tree_db->WriteBatchSync(vFiles, m_last_blockfile, vBlocks)) {
+    std::vector<std::pair<const CBlockIndex *, const CAuxPow *>> vAuxPow;
+    vAuxPow.reserve(m_dirty_auxpow.size());
+    for (const auto &[pindex, auxpow] : m_dirty_auxpow) {
+        vAuxPow.emplace_back(pindex, auxpow.get());
+    }
+
+    if (!m_block_tree_db->WriteBatchSync(vFiles, m_last_blockfile, vBlocks,
+                                         vAuxPow)) {
         return false;
     }
+    m_dirty_auxpow.clear();
     return true;
 }
 
@@ -374,6 +485,20 @@ bool BlockManager::LoadBlockIndexDB() {
 
 void BlockManager::ScanAndUnlinkAlreadyPrunedFiles() {
     AssertLockHeld(::cs_main);
+
+    // Also the undo files pruned with -pruneundo, the block files being kept
+    if (GetPruneUndoDepth() > 0) {
+        std::set<int> undo_files_to_prune;
+        for (int file_number = 0; file_number < m_last_blockfile;
+             file_number++) {
+            const CBlockFileInfo &info = m_blockfile_info[file_number];
+            if (info.nSize > 0 && info.nUndoSize == 0) {
+                undo_files_to_prune.insert(file_number);
+            }
+        }
+        UnlinkPrunedUndoFiles(undo_files_to_prune);
+    }
+
     if (!m_have_pruned) {
         return;
     }
@@ -469,6 +594,23 @@ CBlockFileInfo *BlockManager::GetBlockFileInfo(size_t n) {
 bool BlockManager::UndoWriteToDisk(
     const CBlockUndo &blockundo, FlatFilePos &pos, const BlockHash &hashBlock,
     const CMessageHeader::MessageMagic &messageStart) const {
+    if (m_undo_writer) {
+        // Queue the index header, the undo data and its checksum
+        std::vector<uint8_t> data;
+        const unsigned int nSize = GetSerializeSize(blockundo, CLIENT_VERSION);
+        HashWriter hasher{};
+        hasher << hashBlock;
+        hasher << blockundo;
+        CVectorWriter{SER_DISK, CLIENT_VERSION, data, 0, messageStart, nSize,
+                      blockundo, hasher.GetHash()};
+        const FlatFilePos write_pos{pos};
+        pos.nPos += BLOCK_SERIALIZATION_HEADER_SIZE;
+        if (!m_undo_writer->Write(write_pos, std::move(data))) {
+            return error("%s: A previous write failed", __func__);
+        }
+        return true;
+    }
+
     // Open history file to append
     CAutoFile fileout(OpenUndoFile(pos), SER_DISK, CLIENT_VERSION);
     if (fileout.IsNull()) {
@@ -496,6 +638,91 @@ bool BlockManager::UndoWriteToDisk(
     return true;
 }
 
+std::optional<FlatFileMapper::View>
+BlockManager::MapStored(FlatFileMapper &mapper, const FlatFileSeq &seq,
+                        const FlatFilePos &pos, size_t lead,
+                        size_t extra) const {
+    if (!m_opts.block_file_mmap ||
+        pos.nPos < std::max(lead, sizeof(uint32_t))) {
+        return std::nullopt;
+    }
+    const FlatFilePos size_pos(pos.nFile, pos.nPos - sizeof(uint32_t));
+    const auto size_view{mapper.Read(seq, size_pos, sizeof(uint32_t))};
+    if (!size_view) {
+        return std::nullopt;
+    }
+    const uint32_t size{ReadLE32(UCharCast(size_view->data.data())) &
+                        ~BLOCK_COMPRESSED_FLAG};
+    return mapper.Read(seq, FlatFilePos(pos.nFile, pos.nPos - lead),
+                       lead + size_t(size) + extra);
+}
+
+template <typename Unserialize>
+bool BlockManager::ReadStored(FlatFileMapper *mapper, FlatFileReadCache &cache,
+                              FlatFileWriter *writer, FlatFileSeq seq,
+                              const FlatFilePos &pos, size_t lead,
+                              size_t extra, size_t buffer_size,
+                              Unserialize &&unserialize) const {
+    assert(pos.nPos >= lead);
+    if (writer && !writer->WaitForWrites(pos.nFile)) {
+        return false;
+    }
+    if (mapper) {
+        if (const auto view{MapStored(*mapper, seq, pos, lead, extra)}) {
+            SpanReader reader{SER_DISK, CLIENT_VERSION,
+                              UCharSpanCast(view->data)};
+            unserialize(reader);
+            return true;
+        }
+    }
+    if (auto handle{cache.Open(seq, pos.nFile)}) {
+        FlatFileReader reader{std::move(handle), pos.nPos - lead, SER_DISK,
+                              CLIENT_VERSION, buffer_size};
+        unserialize(reader);
+        return true;
+    }
+    CAutoFile file(seq.Open(FlatFilePos(pos.nFile, pos.nPos - lead), true),
+                   SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        return false;
+    }
+    unserialize(file);
+    return true;
+}
+
+template <typename Unserialize>
+bool BlockManager::ReadStoredBlock(const FlatFilePos &pos, size_t buffer_size,
+                                   Unserialize &&unserialize) const {
+    // The block is preceded by the disk magic and its size, which tells
+    // whether it is stored compressed.
+    if (pos.nPos < BLOCK_SERIALIZATION_HEADER_SIZE) {
+        throw std::ios_base::failure("invalid block position");
+    }
+    return ReadStored(
+        &m_block_file_mapper, m_block_file_reader, m_block_writer.get(),
+        BlockFileSeq(), pos, BLOCK_SERIALIZATION_HEADER_SIZE, 0, buffer_size,
+        [&](auto &filein) {
+            CMessageHeader::MessageMagic magic;
+            uint32_t size;
+            filein >> magic >> size;
+            if (magic != GetParams().DiskMagic()) {
+                throw std::ios_base::failure("block magic mismatch");
+            }
+            if (!(size & BLOCK_COMPRESSED_FLAG)) {
+                unserialize(filein, size);
+                return;
+            }
+            std::vector<uint8_t> compressed(size & ~BLOCK_COMPRESSED_FLAG);
+            filein >> Span{compressed};
+            std::vector<uint8_t> block;
+            if (!DecompressBlock(compressed, block)) {
+                throw std::ios_base::failure("unable to decompress block");
+            }
+            SpanReader reader{SER_DISK, CLIENT_VERSION, block};
+            unserialize(reader, uint32_t(block.size()));
+        });
+}
+
 bool BlockManager::UndoReadFromDisk(CBlockUndo &blockundo,
                                     const CBlockIndex &index) const {
     const FlatFilePos pos{WITH_LOCK(::cs_main, return index.GetUndoPos())};
@@ -504,26 +731,80 @@ bool BlockManager::UndoReadFromDisk(CBlockUndo &blockundo,
         return error("%s: no undo data available", __func__);
     }
 
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("%s: OpenUndoFile failed", __func__);
-    }
-
     // Read block
     uint256 hashChecksum;
-    // We need a CHashVerifier as reserializing may lose data
-    CHashVerifier<CAutoFile> verifier(&filein);
+    uint256 hash;
     try {
-        verifier << index.pprev->GetBlockHash();
-        verifier >> blockundo;
-        filein >> hashChecksum;
+        // The undo data is followed by its checksum.
+        if (!ReadStored(&m_undo_file_mapper, m_undo_file_reader,
+                        m_undo_writer.get(), UndoFileSeq(), pos, 0,
+                        sizeof(uint256), BLOCK_READ_BUFFER_SIZE,
+                        [&](auto &filein) {
+                            // We need a CHashVerifier as reserializing may
+                            // lose data
+                            CHashVerifier verifier(&filein);
+                            verifier << index.pprev->GetBlockHash();
+                            verifier >> blockundo;
+                            filein >> hashChecksum;
+                            hash = verifier.GetHash();
+                        })) {
+            return error("%s: OpenUndoFile failed", __func__);
+        }
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s", __func__, e.what());
     }
 
     // Verify checksum
-    if (hashChecksum != verifier.GetHash()) {
+    if (hashChecksum != hash) {
+        return error("%s: Checksum mismatch", __func__);
+    }
+
+    return true;
+}
+
+bool BlockManager::ReadRawUndoFromDisk(std::vector<uint8_t> &undo,
+                                       const CBlockIndex &index) const {
+    const FlatFilePos pos{WITH_LOCK(::cs_main, return index.GetUndoPos())};
+    undo.clear();
+
+    if (pos.IsNull()) {
+        return error("%s: no undo data available", __func__);
+    }
+
+    uint256 hashChecksum;
+    try {
+        // The undo data is preceded by the disk magic and its size, and
+        // followed by its checksum.
+        if (!ReadStored(&m_undo_file_mapper, m_undo_file_reader,
+                        m_undo_writer.get(), UndoFileSeq(), pos,
+                        BLOCK_SERIALIZATION_HEADER_SIZE, sizeof(uint256),
+                        BLOCK_READ_BUFFER_SIZE, [&](auto &filein) {
+                            CMessageHeader::MessageMagic magic;
+                            uint32_t size;
+                            filein >> magic >> size;
+                            if (magic != GetParams().DiskMagic()) {
+                                throw std::ios_base::failure(
+                                    "undo magic mismatch");
+                            }
+                            if (size > MAX_SIZE) {
+                                throw std::ios_base::failure(
+                                    "undo size too large");
+                            }
+                            undo.resize(size);
+                            filein >> Span{undo} >> hashChecksum;
+                        })) {
+            return error("%s: OpenUndoFile failed", __func__);
+        }
+    } catch (const std::exception &e) {
+        undo.clear();
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+
+    HashWriter hasher{};
+    hasher << index.pprev->GetBlockHash();
+    hasher.write(MakeByteSpan(undo));
+    if (hashChecksum != hasher.GetHash()) {
+        undo.clear();
         return error("%s: Checksum mismatch", __func__);
     }
 
@@ -533,7 +814,12 @@ bool BlockManager::UndoReadFromDisk(CBlockUndo &blockundo,
 void BlockManager::FlushUndoFile(int block_file, bool finalize) {
     FlatFilePos undo_pos_old(block_file,
                              m_blockfile_info[block_file].nUndoSize);
-    if (!UndoFileSeq().Flush(undo_pos_old, finalize)) {
+    if (finalize) {
+        // The file may be truncated.
+        m_undo_file_mapper.Unmap(block_file);
+    }
+    if (m_undo_writer ? !m_undo_writer->Flush(undo_pos_old, finalize)
+                      : !UndoFileSeq().Flush(undo_pos_old, finalize)) {
         AbortNode("Flushing undo file to disk failed. This is likely the "
                   "result of an I/O error.");
     }
@@ -552,9 +838,22 @@ void BlockManager::FlushBlockFile(bool fFinalize, bool finalize_undo) {
     }
     assert(static_cast<int>(m_blockfile_info.size()) > m_last_blockfile);
 
+    // The undo data of older block files may still be queued too. The block
+    // index must not refer to data that is not written yet.
+    if (m_block_writer && (!m_block_writer->WaitForAllWrites() ||
+                           !m_undo_writer->WaitForAllWrites())) {
+        AbortNode("Writing block files to disk failed. This is likely the "
+                  "result of an I/O error.");
+    }
+
     FlatFilePos block_pos_old(m_last_blockfile,
                               m_blockfile_info[m_last_blockfile].nSize);
-    if (!BlockFileSeq().Flush(block_pos_old, fFinalize)) {
+    if (fFinalize) {
+        // The file may be truncated.
+        m_block_file_mapper.Unmap(m_last_blockfile);
+    }
+    if (m_block_writer ? !m_block_writer->Flush(block_pos_old, fFinalize)
+                       : !BlockFileSeq().Flush(block_pos_old, fFinalize)) {
         AbortNode("Flushing block file to disk failed. This is likely the "
                   "result of an I/O error.");
     }
@@ -577,22 +876,110 @@ uint64_t BlockManager::CalculateCurrentUsage() {
     return retval;
 }
 
-void BlockManager::UnlinkPrunedFiles(
-    const std::set<int> &setFilesToPrune) const {
+void BlockManager::UnlinkFile(int file, bool undo_only) const {
     std::error_code error_code;
+    FlatFilePos pos(file, 0);
+    if (m_block_writer && !undo_only) {
+        m_block_writer->WaitForWrites(file);
+    }
+    if (m_undo_writer) {
+        m_undo_writer->WaitForWrites(file);
+    }
+    if (!undo_only) {
+        m_block_file_mapper.Unmap(file);
+        m_block_file_reader.Close(file);
+    }
+    m_undo_file_mapper.Unmap(file);
+    m_undo_file_reader.Close(file);
+    const bool removed_blockfile{
+        !undo_only && fs::remove(BlockFileSeq().FileName(pos), error_code)};
+    const bool removed_undofile{
+        fs::remove(UndoFileSeq().FileName(pos), error_code)};
+    if (removed_blockfile || removed_undofile) {
+        LogPrint(BCLog::BLOCKSTORE, "Prune: %s deleted %s (%05u)\n",
+                 __func__, undo_only ? "rev" : "blk/rev", file);
+    }
+}
+
+void BlockManager::UnlinkPrunedFiles(const std::set<int> &setFilesToPrune) {
+    if (m_unlink_thread.joinable()) {
+        QueueUnlink(setFilesToPrune, /*undo_only=*/false);
+        return;
+    }
     for (const int i : setFilesToPrune) {
-        FlatFilePos pos(i, 0);
-        const bool removed_blockfile{
-            fs::remove(BlockFileSeq().FileName(pos), error_code)};
-        const bool removed_undofile{
-            fs::remove(UndoFileSeq().FileName(pos), error_code)};
-        if (removed_blockfile || removed_undofile) {
-            LogPrint(BCLog::BLOCKSTORE, "Prune: %s deleted blk/rev (%05u)\n",
-                     __func__, i);
+        UnlinkFile(i, /*undo_only=*/false);
+    }
+}
+
+void BlockManager::UnlinkPrunedUndoFiles(
+    const std::set<int> &setFilesToPrune) {
+    if (m_unlink_thread.joinable()) {
+        QueueUnlink(setFilesToPrune, /*undo_only=*/true);
+        return;
+    }
+    for (const int i : setFilesToPrune) {
+        UnlinkFile(i, /*undo_only=*/true);
+    }
+}
+
+void BlockManager::QueueUnlink(const std::set<int> &files, bool undo_only) {
+    {
+        LOCK(m_unlink_mutex);
+        for (const int file : files) {
+            // Unlinking the block file as well wins
+            auto it = m_unlink_queue.emplace(file, undo_only).first;
+            it->second &= undo_only;
+        }
+    }
+    m_unlink_cv.notify_all();
+}
+
+void BlockManager::WaitForUnlink(int file) {
+    WAIT_LOCK(m_unlink_mutex, lock);
+    while (m_unlinking == file || m_unlink_queue.count(file) > 0) {
+        m_unlink_cv.wait(lock);
+    }
+}
+
+void BlockManager::StartUnlinkThread() {
+    m_unlink_thread = std::thread(&util::TraceThread, "pruneunlink",
+                                  [this] { ThreadUnlink(); });
+}
+
+void BlockManager::ThreadUnlink() {
+    WAIT_LOCK(m_unlink_mutex, lock);
+    while (true) {
+        if (m_unlink_queue.empty()) {
+            if (m_unlink_stop) {
+                return;
+            }
+            m_unlink_cv.wait(lock);
+            continue;
+        }
+        const auto [file, undo_only] = *m_unlink_queue.begin();
+        m_unlink_queue.erase(m_unlink_queue.begin());
+        m_unlinking = file;
+        {
+            REVERSE_LOCK(lock);
+            UnlinkFile(file, undo_only);
         }
+        m_unlinking = -1;
+        m_unlink_cv.notify_all();
     }
 }
 
+BlockManager::~BlockManager() {
+    if (!m_unlink_thread.joinable()) {
+        return;
+    }
+    {
+        LOCK(m_unlink_mutex);
+        m_unlink_stop = true;
+    }
+    m_unlink_cv.notify_all();
+    m_unlink_thread.join();
+}
+
 FlatFileSeq BlockManager::BlockFileSeq() const {
     return FlatFileSeq(m_opts.blocks_dir, "blk",
                        m_opts.fast_prune ? 0x4000 /* 16kb */
@@ -605,11 +992,135 @@ FlatFileSeq BlockManager::UndoFileSeq() const {
 
 FILE *BlockManager::OpenBlockFile(const FlatFilePos &pos,
                                   bool fReadOnly) const {
+    if (fReadOnly && m_block_writer &&
+        !m_block_writer->WaitForWrites(pos.nFile)) {
+        return nullptr;
+    }
     return BlockFileSeq().Open(pos, fReadOnly);
 }
 
+/**
+ * The number of blocks whose PoW is precomputed together when reading a block
+ * file for -reindex. This keeps the PoW check queue busy while staying well
+ * below the capacity of the PoW cache, so the results are still there when
+ * the blocks are checked.
+ */
+static constexpr size_t REINDEX_CHECK_BATCH_SIZE{1024};
+
+std::optional<std::vector<ReindexBlock>>
+BlockManager::ReadBlockFileForReindex(int nFile, const Config &config) const {
+    FlatFilePos pos(nFile, 0);
+    FILE *file = OpenBlockFile(pos, true);
+    if (!file) {
+        // This error is logged in OpenBlockFile
+        return std::nullopt;
+    }
+
+    const CMessageHeader::MessageMagic &magic{GetParams().DiskMagic()};
+    std::vector<ReindexBlock> blocks;
+    try {
+        // This takes over file and calls fclose() on it in the CBufferedFile
+        // destructor.
+        CBufferedFile blkdat(file, 2 * MAX_TX_SIZE, MAX_TX_SIZE + 8, SER_DISK,
+                             CLIENT_VERSION);
+        // nRewind indicates where to resume scanning in case something goes
+        // wrong, such as a block fails to deserialize.
+        uint64_t nRewind = blkdat.GetPos();
+        while (!blkdat.eof() && !ShutdownRequested()) {
+            blkdat.SetPos(nRewind);
+            // Start one byte further next time, in case of failure.
+            nRewind++;
+            // Remove former limit.
+            blkdat.SetLimit();
+            unsigned int nSize = 0;
+            bool compressed = false;
+            try {
+                // Locate a header.
+                uint8_t buf[CMessageHeader::MESSAGE_START_SIZE];
+                blkdat.FindByte(std::byte(magic[0]));
+                nRewind = blkdat.GetPos() + 1;
+                blkdat >> buf;
+                if (memcmp(buf, magic.data(),
+                           CMessageHeader::MESSAGE_START_SIZE)) {
+                    continue;
+                }
+
+                // Read size, which flags the blocks stored compressed.
+                blkdat >> nSize;
+                compressed = (nSize & BLOCK_COMPRESSED_FLAG) != 0;
+                nSize &= ~BLOCK_COMPRESSED_FLAG;
+                if ((!compressed && nSize < 80) || nSize > MAX_SIZE) {
+                    continue;
+                }
+            } catch (const std::exception &) {
+                // No valid block header found; don't complain.
+                // (this happens at the end of every blk.dat file)
+                break;
+            }
+
+            try {
+                const uint64_t nBlockPos{blkdat.GetPos()};
+                blkdat.SetLimit(nBlockPos + nSize);
+                auto pblock = std::make_shared<CBlock>();
+                if (compressed) {
+                    std::vector<uint8_t> stored(nSize);
+                    blkdat >> Span{stored};
+                    std::vector<uint8_t> block_data;
+                    if (!DecompressBlock(stored, block_data)) {
+                        throw std::ios_base::failure(
+                            "unable to decompress block");
+                    }
+                    SpanReader{SER_DISK, CLIENT_VERSION, block_data} >>
+                        *pblock;
+                } else {
+                    blkdat >> *pblock;
+                }
+                nRewind = blkdat.GetPos();
+                blocks.push_back(
+                    {std::move(pblock), FlatFilePos(nFile, nBlockPos)});
+            } catch (const std::exception &e) {
+                // See LoadExternalBlockFile() about the unexpected data
+                LogPrint(BCLog::REINDEX,
+                         "%s: unexpected data at offset 0x%x of blk%05u.dat - "
+                         "%s. continuing\n",
+                         __func__, (nRewind - 1), nFile, e.what());
+            }
+        }
+    } catch (const std::runtime_error &e) {
+        AbortNode(std::string("System error: ") + e.what());
+        return std::nullopt;
+    }
+
+    const BlockValidationOptions validation_options(config);
+    std::vector<CBlockHeader> headers;
+    for (size_t i = 0; i < blocks.size() && !ShutdownRequested();
+         i += REINDEX_CHECK_BATCH_SIZE) {
+        const size_t end{std::min(blocks.size(), i + REINDEX_CHECK_BATCH_SIZE)};
+        headers.clear();
+        for (size_t j = i; j < end; ++j) {
+            const CBlockHeader &header = *blocks[j].block;
+            if (!IsPowCached(GetPowHeader(header).GetHash(), header.nBits)) {
+                headers.push_back(header);
+            }
+        }
+        PreverifyProofOfWork(headers, GetConsensus());
+        // The invalid blocks are rejected when they are accepted.
+        for (size_t j = i; j < end; ++j) {
+            BlockValidationState state;
+            CheckBlock(*blocks[j].block, state, GetConsensus(),
+                       validation_options);
+        }
+    }
+
+    return blocks;
+}
+
 /** Open an undo file (rev?????.dat) */
 FILE *BlockManager::OpenUndoFile(const FlatFilePos &pos, bool fReadOnly) const {
+    if (fReadOnly && m_undo_writer &&
+        !m_undo_writer->WaitForWrites(pos.nFile)) {
+        return nullptr;
+    }
     return UndoFileSeq().Open(pos, fReadOnly);
 }
 
@@ -671,6 +1182,7 @@ bool BlockManager::FindBlockPos(FlatFilePos &pos, unsigned int nAddSize,
     }
 
     m_blockfile_info[nFile].AddBlock(nHeight, nTime);
+    m_first_unpruned_file = std::min<int>(m_first_unpruned_file, nFile);
     if (fKnown) {
         m_blockfile_info[nFile].nSize =
             std::max(pos.nPos + nAddSize, m_blockfile_info[nFile].nSize);
@@ -698,6 +1210,8 @@ bool BlockManager::FindBlockPos(FlatFilePos &pos, unsigned int nAddSize,
 bool BlockManager::FindUndoPos(BlockValidationState &state, int nFile,
                                FlatFilePos &pos, unsigned int nAddSize) {
     pos.nFile = nFile;
+    // Don't write to an undo file that is still being unlinked
+    WaitForUnlink(nFile);
 
     LOCK(cs_LastBlockFile);
 
@@ -715,6 +1229,9 @@ bool BlockManager::FindUndoPos(BlockValidationState &state, int nFile,
     if (bytes_allocated != 0 && IsPruneMode()) {
         m_check_for_pruning = true;
     }
+    if (bytes_allocated != 0 && GetPruneUndoDepth() > 0) {
+        m_check_for_undo_pruning = true;
+    }
 
     return true;
 }
@@ -722,6 +1239,20 @@ bool BlockManager::FindUndoPos(BlockValidationState &state, int nFile,
 bool BlockManager::WriteBlockToDisk(
     const CBlock &block, FlatFilePos &pos,
     const CMessageHeader::MessageMagic &messageStart) const {
+    if (m_block_writer) {
+        // Queue the index header and the block
+        std::vector<uint8_t> data;
+        const unsigned int nSize = GetSerializeSize(block, CLIENT_VERSION);
+        CVectorWriter{SER_DISK, CLIENT_VERSION, data, 0, messageStart, nSize,
+                      block};
+        const FlatFilePos write_pos{pos};
+        pos.nPos += BLOCK_SERIALIZATION_HEADER_SIZE;
+        if (!m_block_writer->Write(write_pos, std::move(data))) {
+            return error("WriteBlockToDisk: A previous write failed");
+        }
+        return true;
+    }
+
     // Open history file to append
     CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
     if (fileout.IsNull()) {
@@ -744,6 +1275,44 @@ bool BlockManager::WriteBlockToDisk(
     return true;
 }
 
+bool BlockManager::WriteCompressedBlockToDisk(
+    const std::vector<uint8_t> &compressed, FlatFilePos &pos,
+    const CMessageHeader::MessageMagic &messageStart) const {
+    const uint32_t nSize{uint32_t(compressed.size()) | BLOCK_COMPRESSED_FLAG};
+    if (m_block_writer) {
+        // Queue the index header and the compressed block
+        std::vector<uint8_t> data;
+        CVectorWriter{SER_DISK, CLIENT_VERSION, data, 0, messageStart, nSize,
+                      Span{compressed}};
+        const FlatFilePos write_pos{pos};
+        pos.nPos += BLOCK_SERIALIZATION_HEADER_SIZE;
+        if (!m_block_writer->Write(write_pos, std::move(data))) {
+            return error("WriteCompressedBlockToDisk: A previous write failed");
+        }
+        return true;
+    }
+
+    // Open history file to append
+    CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull()) {
+        return error("WriteCompressedBlockToDisk: OpenBlockFile failed");
+    }
+
+    // Write index header
+    fileout << messageStart << nSize;
+
+    // Write compressed block
+    long fileOutPos = ftell(fileout.Get());
+    if (fileOutPos < 0) {
+        return error("WriteCompressedBlockToDisk: ftell failed");
+    }
+
+    pos.nPos = (unsigned int)fileOutPos;
+    fileout << Span{compressed};
+
+    return true;
+}
+
 bool BlockManager::WriteUndoDataForBlock(const CBlockUndo &blockundo,
                                          BlockValidationState &state,
                                          CBlockIndex &block) {
@@ -781,27 +1350,33 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo &blockundo,
     return true;
 }
 
-bool BlockManager::ReadBlockFromDisk(CBlock &block,
-                                     const FlatFilePos &pos) const {
-    block.SetNull();
+bool BlockManager::NeedsPoWCheckOnRead(const CBlockIndex &index) const {
+    AssertLockHeld(::cs_main);
+    // The block hash is always checked against the index by the callers, which
+    // is enough to detect a wrong block for entries that had their PoW checked
+    // when they were stored.
+    return m_opts.check_block_read_pow || !index.nStatus.hasCheckedPoW();
+}
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s",
-                     pos.ToString());
-    }
+bool BlockManager::ReadBlockFromDisk(CBlock &block, const FlatFilePos &pos,
+                                     bool check_pow) const {
+    block.SetNull();
 
     // Read block
     try {
-        filein >> block;
+        if (!ReadStoredBlock(
+                pos, BLOCK_READ_BUFFER_SIZE,
+                [&](auto &filein, uint32_t) { filein >> block; })) {
+            return error("ReadBlockFromDisk: OpenBlockFile failed for %s",
+                         pos.ToString());
+        }
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__,
                      e.what(), pos.ToString());
     }
 
     // Check the header
-    if (!CheckAuxProofOfWork(block, GetConsensus())) {
+    if (check_pow && !CheckAuxProofOfWork(block, GetConsensus())) {
         return error("ReadBlockFromDisk: Errors in block header at %s",
                      pos.ToString());
     }
@@ -811,9 +1386,15 @@ bool BlockManager::ReadBlockFromDisk(CBlock &block,
 
 bool BlockManager::ReadBlockFromDisk(CBlock &block,
                                      const CBlockIndex &index) const {
-    const FlatFilePos block_pos{WITH_LOCK(cs_main, return index.GetBlockPos())};
+    FlatFilePos block_pos;
+    bool check_pow;
+    {
+        LOCK(cs_main);
+        block_pos = index.GetBlockPos();
+        check_pow = NeedsPoWCheckOnRead(index);
+    }
 
-    if (!ReadBlockFromDisk(block, block_pos)) {
+    if (!ReadBlockFromDisk(block, block_pos, check_pow)) {
         return false;
     }
 
@@ -826,27 +1407,95 @@ bool BlockManager::ReadBlockFromDisk(CBlock &block,
     return true;
 }
 
-bool BlockManager::ReadBlockHeaderFromDisk(CBlockHeader &header,
-                                           const FlatFilePos &pos) const {
-    header.SetNull();
+bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t> &block,
+                                        const FlatFilePos &pos) const {
+    block.clear();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadBlockHeaderFromDisk: OpenBlockFile failed for %s",
-                     pos.ToString());
+    try {
+        if (!ReadStoredBlock(pos, BLOCK_READ_BUFFER_SIZE,
+                             [&](auto &filein, uint32_t size) {
+                                 if (size > MAX_SIZE) {
+                                     throw std::ios_base::failure(
+                                         "block size too large");
+                                 }
+                                 block.resize(size);
+                                 filein >> Span{block};
+                             })) {
+            return error("ReadRawBlockFromDisk: OpenBlockFile failed for %s",
+                         pos.ToString());
+        }
+    } catch (const std::exception &e) {
+        block.clear();
+        return error("%s: Deserialize or I/O error - %s at %s", __func__,
+                     e.what(), pos.ToString());
+    }
+
+    return true;
+}
+
+bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t> &block,
+                                        const CBlockIndex &index) const {
+    FlatFilePos block_pos;
+    bool check_pow;
+    {
+        LOCK(cs_main);
+        block_pos = index.GetBlockPos();
+        check_pow = NeedsPoWCheckOnRead(index);
+    }
+
+    if (!ReadRawBlockFromDisk(block, block_pos)) {
+        return false;
     }
 
+    // The block hash is the hash of the leading base header.
+    if (block.size() < CBaseBlockHeader::SERIALIZED_SIZE ||
+        BlockHash(Hash(Span{block}.first(CBaseBlockHeader::SERIALIZED_SIZE))) !=
+            index.GetBlockHash()) {
+        block.clear();
+        return error("ReadRawBlockFromDisk(std::vector<uint8_t>&, "
+                     "CBlockIndex*): hash doesn't match index for %s at %s",
+                     index.ToString(), block_pos.ToString());
+    }
+
+    if (check_pow) {
+        CBlockHeader header;
+        try {
+            SpanReader{SER_DISK, CLIENT_VERSION, block} >> header;
+        } catch (const std::exception &e) {
+            block.clear();
+            return error("%s: Deserialize error - %s at %s", __func__,
+                         e.what(), block_pos.ToString());
+        }
+        if (!CheckAuxProofOfWork(header, GetConsensus())) {
+            block.clear();
+            return error("ReadRawBlockFromDisk: Errors in block header at %s",
+                         block_pos.ToString());
+        }
+    }
+
+    return true;
+}
+
+bool BlockManager::ReadBlockHeaderFromDisk(CBlockHeader &header,
+                                           const FlatFilePos &pos,
+                                           bool check_pow) const {
+    header.SetNull();
+
     // Read header
     try {
-        filein >> header;
+        if (!ReadStoredBlock(
+                pos, SMALL_READ_BUFFER_SIZE,
+                [&](auto &filein, uint32_t) { filein >> header; })) {
+            return error("ReadBlockHeaderFromDisk: OpenBlockFile failed for %s",
+                         pos.ToString());
+        }
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__,
                      e.what(), pos.ToString());
     }
 
     // Check the header
-    if (!CheckAuxProofOfWork(header, GetConsensus())) {
+    if (check_pow && !CheckAuxProofOfWork(header, GetConsensus())) {
         return error("ReadBlockHeaderFromDisk: Errors in block header at %s",
                      pos.ToString());
     }
@@ -856,9 +1505,15 @@ bool BlockManager::ReadBlockHeaderFromDisk(CBlockHeader &header,
 
 bool BlockManager::ReadBlockHeaderFromDisk(CBlockHeader &header,
                                            const CBlockIndex &index) const {
-    const FlatFilePos block_pos{WITH_LOCK(cs_main, return index.GetBlockPos())};
+    FlatFilePos block_pos;
+    bool check_pow;
+    {
+        LOCK(cs_main);
+        block_pos = index.GetBlockPos();
+        check_pow = NeedsPoWCheckOnRead(index);
+    }
 
-    if (!ReadBlockHeaderFromDisk(header, block_pos)) {
+    if (!ReadBlockHeaderFromDisk(header, block_pos, check_pow)) {
         return false;
     }
 
@@ -871,21 +1526,87 @@ bool BlockManager::ReadBlockHeaderFromDisk(CBlockHeader &header,
     return true;
 }
 
+bool BlockManager::ReadAuxPow(const CBlockIndex &index,
+                              std::shared_ptr<CAuxPow> &auxpow) const {
+    LOCK(cs_main);
+    const auto it = m_dirty_auxpow.find(&index);
+    if (it != m_dirty_auxpow.end()) {
+        auxpow = it->second;
+        return true;
+    }
+    if (const auto lru_it = m_auxpow_lru_index.find(&index);
+        lru_it != m_auxpow_lru_index.end()) {
+        m_auxpow_lru.splice(m_auxpow_lru.begin(), m_auxpow_lru,
+                            lru_it->second);
+        auxpow = lru_it->second->second;
+        return true;
+    }
+
+    auto stored = std::make_shared<CAuxPow>();
+    if (!m_block_tree_db ||
+        !m_block_tree_db->ReadAuxPow(index.GetBlockHash(), *stored)) {
+        return false;
+    }
+    CacheAuxPow(index, stored);
+    auxpow = std::move(stored);
+    return true;
+}
+
+void BlockManager::CacheAuxPow(const CBlockIndex &index,
+                               std::shared_ptr<CAuxPow> auxpow) const {
+    if (!auxpow) {
+        return;
+    }
+    LOCK(cs_main);
+    if (const auto it = m_auxpow_lru_index.find(&index);
+        it != m_auxpow_lru_index.end()) {
+        m_auxpow_lru.splice(m_auxpow_lru.begin(), m_auxpow_lru, it->second);
+        return;
+    }
+    m_auxpow_lru.emplace_front(&index, std::move(auxpow));
+    m_auxpow_lru_index.emplace(&index, m_auxpow_lru.begin());
+    if (m_auxpow_lru.size() > MAX_AUXPOW_CACHE_SIZE) {
+        m_auxpow_lru_index.erase(m_auxpow_lru.back().first);
+        m_auxpow_lru.pop_back();
+    }
+}
+
 bool BlockManager::ReadTxFromDisk(CMutableTransaction &tx,
                                   const FlatFilePos &pos) const {
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadTxFromDisk: OpenBlockFile failed for %s",
-                     pos.ToString());
+    // Read tx, which is not stored on its own so can not be mapped
+    try {
+        if (!ReadStored(nullptr, m_block_file_reader, m_block_writer.get(),
+                        BlockFileSeq(), pos, 0, 0, SMALL_READ_BUFFER_SIZE,
+                        [&](auto &filein) { filein >> tx; })) {
+            return error("ReadTxFromDisk: OpenBlockFile failed for %s",
+                         pos.ToString());
+        }
+    } catch (const std::exception &e) {
+        return error("%s: Deserialize or I/O error - %s at %s", __func__,
+                     e.what(), pos.ToString());
     }
 
-    // Read tx
+    return true;
+}
+
+bool BlockManager::ReadBlockTxFromDisk(CBlockHeader &header,
+                                       CMutableTransaction &tx,
+                                       const FlatFilePos &block_pos,
+                                       uint32_t tx_offset) const {
+    // Read the header, then the tx in the same stream
     try {
-        filein >> tx;
+        if (!ReadStoredBlock(block_pos, SMALL_READ_BUFFER_SIZE,
+                             [&](auto &filein, uint32_t) {
+                                 filein >> header;
+                                 filein.ignore(tx_offset);
+                                 filein >> tx;
+                             })) {
+            return error("ReadBlockTxFromDisk: OpenBlockFile failed for %s",
+                         block_pos.ToString());
+        }
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__,
-                     e.what(), pos.ToString());
+                     e.what(), block_pos.ToString());
     }
 
     return true;
@@ -893,16 +1614,14 @@ bool BlockManager::ReadTxFromDisk(CMutableTransaction &tx,
 
 bool BlockManager::ReadTxUndoFromDisk(CTxUndo &tx_undo,
                                       const FlatFilePos &pos) const {
-    // Open undo file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadTxUndoFromDisk: OpenUndoFile failed for %s",
-                     pos.ToString());
-    }
-
     // Read undo data
     try {
-        filein >> tx_undo;
+        if (!ReadStored(nullptr, m_undo_file_reader, m_undo_writer.get(),
+                        UndoFileSeq(), pos, 0, 0, SMALL_READ_BUFFER_SIZE,
+                        [&](auto &filein) { filein >> tx_undo; })) {
+            return error("ReadTxUndoFromDisk: OpenUndoFile failed for %s",
+                         pos.ToString());
+        }
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__,
                      e.what(), pos.ToString());
@@ -917,9 +1636,20 @@ FlatFilePos BlockManager::SaveBlockToDisk(const CBlock &block, int nHeight,
     unsigned int nBlockSize = ::GetSerializeSize(block, CLIENT_VERSION);
     FlatFilePos blockPos;
     const auto position_known{dbp != nullptr};
+    // Empty unless the block is to be stored compressed.
+    std::vector<uint8_t> compressed;
     if (position_known) {
         blockPos = *dbp;
     } else {
+        if (m_opts.block_compression_level > 0) {
+            std::vector<uint8_t> serialized;
+            serialized.reserve(nBlockSize);
+            CVectorWriter{SER_DISK, CLIENT_VERSION, serialized, 0, block};
+            if (CompressBlock(serialized, m_opts.block_compression_level,
+                              compressed)) {
+                nBlockSize = compressed.size();
+            }
+        }
         // When known, blockPos.nPos points at the offset of the block data in
         // the blk file. That already accounts for the serialization header
         // present in the file (the 4 magic message start bytes + the 4 length
@@ -935,7 +1665,12 @@ FlatFilePos BlockManager::SaveBlockToDisk(const CBlock &block, int nHeight,
         return FlatFilePos();
     }
     if (!position_known) {
-        if (!WriteBlockToDisk(block, blockPos, GetParams().DiskMagic())) {
+        const bool written{
+            compressed.empty()
+                ? WriteBlockToDisk(block, blockPos, GetParams().DiskMagic())
+                : WriteCompressedBlockToDisk(compressed, blockPos,
+                                             GetParams().DiskMagic())};
+        if (!written) {
             AbortNode("Failed to write block");
             return FlatFilePos();
         }
@@ -973,21 +1708,60 @@ void ThreadImport(ChainstateManager &chainman,
             // for reindex);  parent hash -> child disk position, multiple
             // children can have the same parent.
             std::multimap<BlockHash, FlatFilePos> blocks_with_unknown_parent;
+            // The block files being read and checked ahead, in order. The
+            // blocks are still imported one file at a time, in the order they
+            // are stored.
+            const int read_ahead{chainman.m_blockman.GetReindexReadAhead()};
+            std::deque<std::future<std::optional<std::vector<ReindexBlock>>>>
+                pending;
+            int next_file = 0;
             while (true) {
                 FlatFilePos pos(nFile, 0);
-                if (!fs::exists(chainman.m_blockman.GetBlockPosFilename(pos))) {
-                    // No block files left to reindex
-                    break;
-                }
-                FILE *file = chainman.m_blockman.OpenBlockFile(pos, true);
-                if (!file) {
-                    // This error is logged in OpenBlockFile
-                    break;
+                std::optional<std::vector<ReindexBlock>> blocks;
+                FILE *file{nullptr};
+                if (read_ahead > 0) {
+                    while (int(pending.size()) <= read_ahead &&
+                           fs::exists(chainman.m_blockman.GetBlockPosFilename(
+                               FlatFilePos(next_file, 0)))) {
+                        pending.push_back(std::async(
+                            std::launch::async,
+                            [&blockman = chainman.m_blockman,
+                             &config = chainman.GetConfig(), next_file] {
+                                return blockman.ReadBlockFileForReindex(
+                                    next_file, config);
+                            }));
+                        next_file++;
+                    }
+                    if (pending.empty()) {
+                        // No block files left to reindex
+                        break;
+                    }
+                    blocks = pending.front().get();
+                    pending.pop_front();
+                    if (!blocks) {
+                        break;
+                    }
+                } else {
+                    if (!fs::exists(
+                            chainman.m_blockman.GetBlockPosFilename(pos))) {
+                        // No block files left to reindex
+                        break;
+                    }
+                    file = chainman.m_blockman.OpenBlockFile(pos, true);
+                    if (!file) {
+                        // This error is logged in OpenBlockFile
+                        break;
+                    }
                 }
                 LogPrintf("Reindexing block file blk%05u.dat...\n",
                           (unsigned int)nFile);
-                chainman.ActiveChainstate().LoadExternalBlockFile(
-                    file, &pos, &blocks_with_unknown_parent, avalanche);
+                if (blocks) {
+                    chainman.ActiveChainstate().LoadExternalBlocks(
+                        *blocks, blocks_with_unknown_parent, avalanche);
+                } else {
+                    chainman.ActiveChainstate().LoadExternalBlockFile(
+                        file, &pos, &blocks_with_unknown_parent, avalanche);
+                }
                 if (ShutdownRequested()) {
                     LogPrintf("Shutdown requested. Exit %s\n", __func__);
                     return;
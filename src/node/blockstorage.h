@@ -5,15 +5,25 @@
 #ifndef BITCOIN_NODE_BLOCKSTORAGE_H
 #define BITCOIN_NODE_BLOCKSTORAGE_H
 
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include <chain.h>
 #include <chainparams.h>
+#include <flatfile.h>
 #include <kernel/blockmanager_opts.h>
 #include <kernel/cs_main.h>
 #include <protocol.h> // For CMessageHeader::MessageStartChars
+#include <support/allocators/pool.h>
 #include <sync.h>
 #include <txdb.h>
 #include <util/fs.h>
@@ -30,7 +40,6 @@ class Chainstate;
 class ChainstateManager;
 struct CCheckpointData;
 class Config;
-struct FlatFilePos;
 namespace Consensus {
 struct Params;
 }
@@ -47,6 +56,19 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 /** The maximum size of a blk?????.dat file (since 0.8) */
 static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 
+/** The maximum number of block files, and of undo files, kept mapped */
+static constexpr size_t MAX_MAPPED_BLOCK_FILES{64};
+
+/** The size of the buffers for reading blocks and undo data from files */
+static constexpr size_t BLOCK_READ_BUFFER_SIZE{1 << 16};
+/** The size of the buffers for reading headers and transactions from files */
+static constexpr size_t SMALL_READ_BUFFER_SIZE{1 << 12};
+/**
+ * Dogecoin: the number of auxpows kept in memory, enough for a full headers
+ * message (MAX_HEADERS_RESULTS).
+ */
+static constexpr size_t MAX_AUXPOW_CACHE_SIZE{2000};
+
 /** Size of header written by WriteBlockToDisk before a serialized CBlock */
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE =
     CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int);
@@ -57,13 +79,32 @@ extern std::atomic_bool fReindex;
 // we ever switch to another associative container, we need to either use a
 // container that has stable addressing (true of all std associative
 // containers), or make the key a `std::unique_ptr<CBlockIndex>`
-using BlockMap = std::unordered_map<BlockHash, CBlockIndex, BlockHasher>;
+//
+// The entries are allocated from a pool, in large chunks instead of one by
+// one. This saves the overhead of an allocation per header and keeps the
+// entries close together in memory. See CCoinsMap for the node size bound.
+using BlockMap = std::unordered_map<
+    BlockHash, CBlockIndex, BlockHasher, std::equal_to<BlockHash>,
+    PoolAllocator<std::pair<const BlockHash, CBlockIndex>,
+                  sizeof(std::pair<const BlockHash, CBlockIndex>) +
+                      sizeof(void *) * 4>>;
+
+using BlockMapMemoryResource = BlockMap::allocator_type::ResourceType;
 
 struct PruneLockInfo {
     //! Height of earliest block that should be kept and not pruned
     int height_first{std::numeric_limits<int>::max()};
 };
 
+//! The most block files that can be read ahead during -reindex.
+static constexpr int MAX_REINDEX_READ_AHEAD{16};
+
+/** A block read from a block file, with its position in the file. */
+struct ReindexBlock {
+    std::shared_ptr<CBlock> block;
+    FlatFilePos pos;
+};
+
 /**
  * Maintains a tree of blocks (stored in `m_block_index`) which is consulted
  * to determine where the most-work tip is.
@@ -97,11 +138,99 @@ private:
     FlatFileSeq BlockFileSeq() const;
     FlatFileSeq UndoFileSeq() const;
 
+    /**
+     * Memory mappings of the block and undo files, used for the reads with
+     * -blockfilemmap.
+     */
+    mutable FlatFileMapper m_block_file_mapper{MAX_MAPPED_BLOCK_FILES};
+    mutable FlatFileMapper m_undo_file_mapper{MAX_MAPPED_BLOCK_FILES};
+
+    /**
+     * Map the data stored at pos, as written after its size by
+     * WriteBlockToDisk or UndoWriteToDisk, preceded by lead bytes and followed
+     * by extra bytes. Return std::nullopt if mapping is disabled or fails, so
+     * the caller falls back to reading the file.
+     */
+    std::optional<FlatFileMapper::View> MapStored(FlatFileMapper &mapper,
+                                                  const FlatFileSeq &seq,
+                                                  const FlatFilePos &pos,
+                                                  size_t lead,
+                                                  size_t extra) const;
+
+    /**
+     * Descriptors of the block and undo files kept open for reading, with
+     * -blockreadhandles.
+     */
+    mutable FlatFileReadCache m_block_file_reader;
+    mutable FlatFileReadCache m_undo_file_reader;
+
+    /**
+     * The background writers of the block and undo files, with
+     * -blockwritequeue. Reads wait for the writes queued to their file.
+     */
+    std::unique_ptr<FlatFileWriter> m_block_writer;
+    std::unique_ptr<FlatFileWriter> m_undo_writer;
+
+    /**
+     * The pruned files left to unlink on m_unlink_thread, in prune modes, with
+     * whether only their undo file is pruned. They are unlinked in the
+     * background as removing large files can take a while, after the block
+     * index no longer refers to them.
+     */
+    Mutex m_unlink_mutex;
+    //! Notified when a file is queued or unlinked, and on stop.
+    std::condition_variable m_unlink_cv;
+    std::map<int, bool> m_unlink_queue GUARDED_BY(m_unlink_mutex);
+    //! The file being unlinked, -1 if none.
+    int m_unlinking GUARDED_BY(m_unlink_mutex){-1};
+    bool m_unlink_stop GUARDED_BY(m_unlink_mutex){false};
+    std::thread m_unlink_thread;
+
+    void StartUnlinkThread();
+    void ThreadUnlink() EXCLUSIVE_LOCKS_REQUIRED(!m_unlink_mutex);
+    /** Unlink the block and undo files, or only the undo file. */
+    void UnlinkFile(int file, bool undo_only) const;
+    void QueueUnlink(const std::set<int> &files, bool undo_only)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_unlink_mutex);
+
+    /**
+     * Call unserialize with a stream reading the file of seq from lead bytes
+     * before pos on: the mapping of the data stored there if mapper is set and
+     * can map it, else a descriptor from the cache if there is one, else the
+     * file opened on its own. Return false if the file can not be opened.
+     */
+    template <typename Unserialize>
+    bool ReadStored(FlatFileMapper *mapper, FlatFileReadCache &cache,
+                    FlatFileWriter *writer, FlatFileSeq seq,
+                    const FlatFilePos &pos, size_t lead, size_t extra,
+                    size_t buffer_size, Unserialize &&unserialize) const;
+
+    /**
+     * Call unserialize with a stream reading the serialized block stored at
+     * pos, decompressing it first if it is stored compressed, and with the
+     * size of the serialized block. Return false if the file can not be
+     * opened, throw if the block can not be read.
+     */
+    template <typename Unserialize>
+    bool ReadStoredBlock(const FlatFilePos &pos, size_t buffer_size,
+                         Unserialize &&unserialize) const;
+
     FILE *OpenUndoFile(const FlatFilePos &pos, bool fReadOnly = false) const;
 
+    /**
+     * Whether a block read from disk by index needs its (aux)PoW to be
+     * checked again.
+     */
+    bool NeedsPoWCheckOnRead(const CBlockIndex &index) const
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     bool
     WriteBlockToDisk(const CBlock &block, FlatFilePos &pos,
                      const CMessageHeader::MessageMagic &messageStart) const;
+    /** Write a block compressed by CompressBlock, flagged as such. */
+    bool WriteCompressedBlockToDisk(
+        const std::vector<uint8_t> &compressed, FlatFilePos &pos,
+        const CMessageHeader::MessageMagic &messageStart) const;
     bool
     UndoWriteToDisk(const CBlockUndo &blockundo, FlatFilePos &pos,
                     const BlockHash &hashBlock,
@@ -139,21 +268,64 @@ private:
                           uint64_t nPruneAfterHeight, int chain_tip_height,
                           int prune_height, bool is_ibd);
 
+    /**
+     * Delete the undo data of the blocks buried deeper than the
+     * -pruneundo depth, unless it is above prune_height, keeping the blocks.
+     * Like pruning, this is done for whole undo files, the ones where all the
+     * blocks are deep enough. The block index is updated by unsetting
+     * HAVE_UNDO for the blocks of these files.
+     *
+     * @param[out]   setFilesToPrune   The set of undo file indices that can be
+     *                                 unlinked will be returned
+     */
+    void FindUndoFilesToPrune(std::set<int> &setFilesToPrune,
+                              int chain_tip_height, int prune_height)
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     RecursiveMutex cs_LastBlockFile;
     std::vector<CBlockFileInfo> m_blockfile_info;
     int m_last_blockfile = 0;
+    /**
+     * All the block files below this one are pruned, so that the searches for
+     * files to prune don't scan them again.
+     */
+    int m_first_unpruned_file = 0;
     /**
      * Global flag to indicate we should check to see if there are
      * block/undo files that should be deleted.  Set on startup
      * or if we allocate more file space when we're in prune mode
      */
     bool m_check_for_pruning = false;
+    /**
+     * Flag to indicate we should check to see if there are undo files that
+     * should be deleted with -pruneundo. Set on startup or if we allocate more
+     * undo file space.
+     */
+    bool m_check_for_undo_pruning = true;
 
     const bool m_prune_mode;
 
     /** Dirty block index entries. */
     std::set<CBlockIndex *> m_dirty_blockindex;
 
+    /**
+     * Dogecoin: auxpows of newly added block index entries that have not been
+     * written to the block tree DB yet.
+     */
+    std::map<const CBlockIndex *, std::shared_ptr<CAuxPow>>
+        m_dirty_auxpow GUARDED_BY(::cs_main);
+
+    /**
+     * Dogecoin: the auxpows read most recently, most recent first, so the
+     * headers near the tip that are served over and over to getheaders,
+     * getblockheader and REST are rebuilt without any database read.
+     */
+    using AuxPowLru =
+        std::list<std::pair<const CBlockIndex *, std::shared_ptr<CAuxPow>>>;
+    mutable AuxPowLru m_auxpow_lru GUARDED_BY(::cs_main);
+    mutable std::unordered_map<const CBlockIndex *, AuxPowLru::iterator>
+        m_auxpow_lru_index GUARDED_BY(::cs_main);
+
     /** Dirty block file entries. */
     std::set<int> m_dirty_fileinfo;
 
@@ -173,11 +345,29 @@ public:
     using Options = kernel::BlockManagerOpts;
 
     explicit BlockManager(Options opts)
-        : m_prune_mode{opts.prune_target > 0}, m_opts{std::move(opts)} {};
+        : m_block_file_reader{opts.block_read_handles},
+          m_undo_file_reader{opts.block_read_handles},
+          m_prune_mode{opts.prune_target > 0}, m_opts{std::move(opts)} {
+        if (m_opts.block_write_queue_bytes > 0) {
+            m_block_writer = std::make_unique<FlatFileWriter>(
+                BlockFileSeq(), "blkwrite", m_opts.block_write_queue_bytes);
+            m_undo_writer = std::make_unique<FlatFileWriter>(
+                UndoFileSeq(), "revwrite", m_opts.block_write_queue_bytes);
+        }
+        if (m_prune_mode || m_opts.prune_undo_depth > 0) {
+            StartUnlinkThread();
+        }
+    };
+
+    /** Unlink the files still queued, then stop the thread. */
+    ~BlockManager();
 
     std::atomic<bool> m_importing{false};
 
-    BlockMap m_block_index GUARDED_BY(cs_main);
+    //! The memory of the entries of m_block_index, which must outlive it.
+    BlockMapMemoryResource m_block_index_resource;
+    BlockMap m_block_index GUARDED_BY(cs_main){
+        0, BlockMap::hasher{}, BlockMap::key_equal{}, &m_block_index_resource};
 
     std::vector<CBlockIndex *> GetAllBlockIndices()
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
@@ -211,6 +401,14 @@ public:
     //! Mark one block file as pruned (modify associated database entries)
     void PruneOneBlockFile(const int fileNumber)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    //! Mark several block files as pruned, in a single pass over the block
+    //! index.
+    void PruneBlockFiles(const std::set<int> &file_numbers)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    //! Mark the undo data of several block files as pruned, in a single pass
+    //! over the block index.
+    void PruneUndoFiles(const std::set<int> &file_numbers)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     CBlockIndex *LookupBlockIndex(const BlockHash &hash)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -234,6 +432,11 @@ public:
     /** Whether running in -prune mode. */
     [[nodiscard]] bool IsPruneMode() const { return m_prune_mode; }
 
+    /** The -pruneundo depth, 0 if the undo data is never deleted. */
+    [[nodiscard]] int GetPruneUndoDepth() const {
+        return m_opts.prune_undo_depth;
+    }
+
     /** Attempt to stay below this number of bytes of block files. */
     [[nodiscard]] uint64_t GetPruneTarget() const {
         return m_opts.prune_target;
@@ -243,6 +446,10 @@ public:
 
     [[nodiscard]] bool LoadingBlocks() const { return m_importing || fReindex; }
 
+    [[nodiscard]] int GetReindexReadAhead() const {
+        return m_opts.reindex_read_ahead;
+    }
+
     [[nodiscard]] bool StopAfterBlockImport() const {
         return m_opts.stop_after_block_import;
     }
@@ -276,26 +483,89 @@ public:
     /** Open a block file (blk?????.dat) */
     FILE *OpenBlockFile(const FlatFilePos &pos, bool fReadOnly = false) const;
 
+    /**
+     * Read all the blocks of a block file for -reindex, skipping the data
+     * that doesn't deserialize like LoadExternalBlockFile() does, and run the
+     * context-free checks on them: the PoW of their headers is computed in
+     * batches on the PoW check queue, and the blocks that pass CheckBlock()
+     * are not checked again when they are accepted. This doesn't need
+     * cs_main, so several files can be read in parallel.
+     *
+     * @returns the blocks in the order they are stored, or std::nullopt if
+     *          the file can't be opened.
+     */
+    std::optional<std::vector<ReindexBlock>>
+    ReadBlockFileForReindex(int nFile, const Config &config) const;
+
     /** Translation to a filesystem path. */
     fs::path GetBlockPosFilename(const FlatFilePos &pos) const;
 
     /**
-     *  Actually unlink the specified files
+     * Actually unlink the specified files, in the background in prune modes.
      */
-    void UnlinkPrunedFiles(const std::set<int> &setFilesToPrune) const;
+    void UnlinkPrunedFiles(const std::set<int> &setFilesToPrune)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_unlink_mutex);
+    /** Only unlink the undo files, see FindUndoFilesToPrune(). */
+    void UnlinkPrunedUndoFiles(const std::set<int> &setFilesToPrune)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_unlink_mutex);
+    /** Wait for the file to be unlinked, if it is queued to be. */
+    void WaitForUnlink(int file) EXCLUSIVE_LOCKS_REQUIRED(!m_unlink_mutex);
 
-    /** Functions for disk access for blocks */
-    bool ReadBlockFromDisk(CBlock &block, const FlatFilePos &pos) const;
+    /**
+     * Functions for disk access for blocks.
+     *
+     * Reading by position always checks the (aux)PoW of the block unless
+     * check_pow is false. Reading by index only does it if the block was not
+     * marked as PoW checked when it was stored, or with -checkblockreadpow.
+     */
+    bool ReadBlockFromDisk(CBlock &block, const FlatFilePos &pos,
+                           bool check_pow = true) const;
     bool ReadBlockFromDisk(CBlock &block, const CBlockIndex &index) const;
-    bool ReadBlockHeaderFromDisk(CBlockHeader &header,
-                                 const FlatFilePos &pos) const;
+    /**
+     * Read the serialized block as stored, which is also its network
+     * serialization, without deserializing it. Reading by index checks the
+     * block hash, and the (aux)PoW under the same conditions as above.
+     */
+    bool ReadRawBlockFromDisk(std::vector<uint8_t> &block,
+                              const FlatFilePos &pos) const;
+    bool ReadRawBlockFromDisk(std::vector<uint8_t> &block,
+                              const CBlockIndex &index) const;
+    bool ReadBlockHeaderFromDisk(CBlockHeader &header, const FlatFilePos &pos,
+                                 bool check_pow = true) const;
     bool ReadBlockHeaderFromDisk(CBlockHeader &header,
                                  const CBlockIndex &index) const;
+    /**
+     * Dogecoin: fetch the auxpow of a merge-mined block index entry from the
+     * block tree DB, without reading the block files. Returns false if the
+     * auxpow is not stored there (e.g. for entries written by older versions).
+     */
+    bool ReadAuxPow(const CBlockIndex &index,
+                    std::shared_ptr<CAuxPow> &auxpow) const;
+    /**
+     * Dogecoin: keep the auxpow of a merge-mined block index entry in the
+     * cache ReadAuxPow() looks up first.
+     */
+    void CacheAuxPow(const CBlockIndex &index,
+                     std::shared_ptr<CAuxPow> auxpow) const;
     bool UndoReadFromDisk(CBlockUndo &blockundo,
                           const CBlockIndex &index) const;
+    /**
+     * Read the serialized undo data of a block as stored, without
+     * deserializing it. The checksum is verified.
+     */
+    bool ReadRawUndoFromDisk(std::vector<uint8_t> &undo,
+                             const CBlockIndex &index) const;
 
     /** Functions for disk access for txs */
     bool ReadTxFromDisk(CMutableTransaction &tx, const FlatFilePos &pos) const;
+    /**
+     * Read the header of the block stored at block_pos, and the transaction
+     * tx_offset bytes after the header. Unlike ReadTxFromDisk, this works for
+     * the blocks stored compressed.
+     */
+    bool ReadBlockTxFromDisk(CBlockHeader &header, CMutableTransaction &tx,
+                             const FlatFilePos &block_pos,
+                             uint32_t tx_offset) const;
     bool ReadTxUndoFromDisk(CTxUndo &tx, const FlatFilePos &pos) const;
 
     void CleanupBlockRevFiles() const;
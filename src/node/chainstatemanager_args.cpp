@@ -15,7 +15,9 @@
 #include <util/translation.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <optional>
 #include <string>
 
@@ -48,14 +50,30 @@ ApplyArgsManOptions(const ArgsManager &args, ChainstateManager::Options &opts) {
         opts.max_tip_age = std::chrono::seconds{*value};
     }
 
-    ReadDatabaseArgs(args, opts.block_tree_db);
-    ReadDatabaseArgs(args, opts.coins_db);
+    if (auto error{ReadDatabaseArgs(args, opts.block_tree_db, "blockindex")}) {
+        return error;
+    }
+    if (auto error{ReadDatabaseArgs(args, opts.coins_db, "chainstate")}) {
+        return error;
+    }
     ReadCoinsViewArgs(args, opts.coins_view);
 
     if (auto value{args.GetBoolArg("-persistrecentheaderstime")}) {
         opts.store_recent_headers_time = *value;
     }
 
+    if (auto value{args.GetIntArg("-utxoprefetchblocks")}) {
+        opts.utxo_prefetch_blocks = std::max<int64_t>(0, *value);
+    }
+
+    if (auto value{args.GetIntArg("-coinswriteback")}) {
+        opts.coins_write_back_bytes = std::max<int64_t>(0, *value) << 20;
+    }
+
+    if (auto value{args.GetBoolArg("-coinsevict")}) {
+        opts.coins_evict = *value;
+    }
+
     return std::nullopt;
 }
 } // namespace node
@@ -11,6 +11,8 @@
 #include <net.h>
 #include <net_processing.h>
 #include <node/kernel_notifications.h>
+#include <node/miner.h>
+#include <policy/fees.h>
 #include <scheduler.h>
 #include <txmempool.h>
 #include <validation.h>
@@ -17,6 +17,7 @@ class CConnman;
 class CScheduler;
 class CTxMemPool;
 class ChainstateManager;
+class FeeRateEstimator;
 class PeerManager;
 namespace interfaces {
 class Chain;
@@ -28,6 +29,7 @@ class Processor;
 } // namespace avalanche
 
 namespace node {
+class BlockTemplateBuilder;
 class KernelNotifications;
 
 //! NodeContext struct containing references to chain state and connection
@@ -44,6 +46,7 @@ struct NodeContext {
     std::unique_ptr<AddrMan> addrman;
     std::unique_ptr<CConnman> connman;
     std::unique_ptr<CTxMemPool> mempool;
+    std::unique_ptr<FeeRateEstimator> fee_estimator;
     std::unique_ptr<PeerManager> peerman;
     std::unique_ptr<ChainstateManager> chainman;
     std::unique_ptr<BanMan> banman;
@@ -61,6 +64,7 @@ struct NodeContext {
     std::unique_ptr<KernelNotifications> notifications;
 
     std::unique_ptr<avalanche::Processor> avalanche;
+    std::unique_ptr<BlockTemplateBuilder> template_builder;
 
     //! Declare default constructor and destructor that are not inline, so code
     //! instantiating the NodeContext struct doesn't need to #include class
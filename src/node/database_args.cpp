@@ -6,14 +6,126 @@
 
 #include <common/args.h>
 #include <dbwrapper.h>
+#include <tinyformat.h>
+#include <util/strencodings.h>
+#include <util/translation.h>
+
+#include <cstdint>
+#include <set>
 
 namespace node {
-void ReadDatabaseArgs(const ArgsManager &args, DBOptions &options) {
-    // Settings here apply to all databases (chainstate, blocks, and index
-    // databases), but it'd be easy to parse database-specific options by adding
-    // a database_type string or enum parameter to this function.
+namespace {
+//! The databases that can be configured on their own.
+const std::set<std::string> DATABASE_NAMES{
+    "blockfilterindex", "blockindex", "chainstate", "coinstatsindex",
+    "txindex"};
+
+/**
+ * Find the value of a per-database argument for the named database: the last
+ * one prefixed with its name, else the last one without a prefix.
+ */
+std::optional<bilingual_str> GetDatabaseArg(const ArgsManager &args,
+                                            const std::string &arg,
+                                            const std::string &name,
+                                            std::optional<std::string> &value) {
+    std::optional<std::string> any;
+    for (const std::string &entry : args.GetArgs(arg)) {
+        const size_t sep{entry.find(':')};
+        if (sep == std::string::npos) {
+            any = entry;
+            continue;
+        }
+        const std::string db{entry.substr(0, sep)};
+        if (DATABASE_NAMES.count(db) == 0) {
+            return strprintf(_("Unknown database '%s' in %s=%s"), db, arg,
+                             entry);
+        }
+        if (db == name) {
+            value = entry.substr(sep + 1);
+        }
+    }
+    if (!value) {
+        value = any;
+    }
+    return std::nullopt;
+}
+
+std::optional<bilingual_str> GetDatabaseIntArg(const ArgsManager &args,
+                                               const std::string &arg,
+                                               const std::string &name,
+                                               int64_t min, int64_t max,
+                                               std::optional<int64_t> &value) {
+    std::optional<std::string> str;
+    if (auto error{GetDatabaseArg(args, arg, name, str)}) {
+        return error;
+    }
+    if (!str) {
+        return std::nullopt;
+    }
+    value = ToIntegral<int64_t>(*str);
+    if (!value || *value < min || *value > max) {
+        return strprintf(_("Invalid value %s for %s, must be between %d and "
+                           "%d"),
+                         *str, arg, min, max);
+    }
+    return std::nullopt;
+}
+} // namespace
+
+std::optional<bilingual_str> ReadDatabaseArgs(const ArgsManager &args,
+                                              DBOptions &options,
+                                              const std::string &name) {
     if (auto value = args.GetBoolArg("-forcecompactdb")) {
         options.force_compact = *value;
     }
+
+    std::optional<std::string> profile;
+    if (auto error{GetDatabaseArg(args, "-dbprofile", name, profile)}) {
+        return error;
+    }
+    if (profile == "default") {
+        options.profile = DBProfile::DEFAULT;
+    } else if (profile == "ibd") {
+        options.profile = DBProfile::IBD;
+    } else if (profile == "steady") {
+        options.profile = DBProfile::STEADY_STATE;
+    } else if (profile) {
+        return strprintf(_("Unknown database profile '%s'"), *profile);
+    }
+
+    std::optional<int64_t> value;
+    if (auto error{GetDatabaseIntArg(args, "-dbwritebuffer", name, 1, 1024,
+                                     value)}) {
+        return error;
+    }
+    if (value) {
+        options.write_buffer_size = size_t(*value) << 20;
+    }
+    value.reset();
+    if (auto error{GetDatabaseIntArg(args, "-dbmaxfilesize", name, 1, 1024,
+                                     value)}) {
+        return error;
+    }
+    if (value) {
+        options.max_file_size = size_t(*value) << 20;
+    }
+    value.reset();
+    if (auto error{GetDatabaseIntArg(args, "-dbblocksize", name, 1, 4096,
+                                     value)}) {
+        return error;
+    }
+    if (value) {
+        options.block_size = size_t(*value) << 10;
+    }
+    value.reset();
+    if (auto error{
+            GetDatabaseIntArg(args, "-dbbloombits", name, 0, 64, value)}) {
+        return error;
+    }
+    if (value) {
+        options.bloom_bits = int(*value);
+    }
+
+    return std::nullopt;
 }
 } // namespace node
@@ -5,11 +5,22 @@
 #ifndef BITCOIN_NODE_DATABASE_ARGS_H
 #define BITCOIN_NODE_DATABASE_ARGS_H
 
+#include <optional>
+#include <string>
+
 class ArgsManager;
+struct bilingual_str;
 struct DBOptions;
 
 namespace node {
-void ReadDatabaseArgs(const ArgsManager &args, DBOptions &options);
+/**
+ * Read the options of the named database: blockfilterindex, blockindex,
+ * chainstate, coinstatsindex or txindex. The per-database arguments apply to
+ * all of them, unless prefixed with the name of one followed by a colon.
+ */
+std::optional<bilingual_str> ReadDatabaseArgs(const ArgsManager &args,
+                                              DBOptions &options,
+                                              const std::string &name);
 } // namespace node
 
 #endif // BITCOIN_NODE_DATABASE_ARGS_H
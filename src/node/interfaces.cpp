@@ -8,6 +8,7 @@
 #include <chainparams.h>
 #include <common/args.h>
 #include <config.h>
+#include <index/blockfilterindex.h>
 #include <init.h>
 #include <interfaces/chain.h>
 #include <interfaces/handler.h>
@@ -24,6 +25,7 @@
 #include <node/context.h>
 #include <node/transaction.h>
 #include <node/ui_interface.h>
+#include <policy/fees.h>
 #include <policy/settings.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
@@ -443,6 +445,9 @@ namespace {
         void ChainStateFlushed(const CBlockLocator &locator) override {
             m_notifications->chainStateFlushed(locator);
         }
+        std::string GetSubscriberName() const override {
+            return "chain_client";
+        }
         std::shared_ptr<Chain::Notifications> m_notifications;
     };
 
@@ -561,6 +566,55 @@ namespace {
             return FillBlock(m_node.chainman->m_blockman.LookupBlockIndex(hash),
                              block, lock, active, chainman().m_blockman);
         }
+        size_t findBlocks(const std::vector<std::pair<BlockHash, FoundBlock>>
+                              &blocks) override {
+            WAIT_LOCK(cs_main, lock);
+            const CChain &active = Assert(m_node.chainman)->ActiveChain();
+            size_t found{0};
+            for (const auto &[hash, block] : blocks) {
+                if (FillBlock(chainman().m_blockman.LookupBlockIndex(hash),
+                              block, lock, active, chainman().m_blockman)) {
+                    ++found;
+                }
+            }
+            return found;
+        }
+        std::vector<BlockHash> findNextBlocks(const BlockHash &hash,
+                                              size_t count) override {
+            LOCK(cs_main);
+            const CChain &active = Assert(m_node.chainman)->ActiveChain();
+            std::vector<BlockHash> hashes;
+            const CBlockIndex *index{
+                chainman().m_blockman.LookupBlockIndex(hash)};
+            if (!index || !active.Contains(index)) {
+                return hashes;
+            }
+            while (hashes.size() < count &&
+                   (index = active.Next(index)) != nullptr) {
+                hashes.push_back(index->GetBlockHash());
+            }
+            return hashes;
+        }
+        bool hasBlockFilterIndex(BlockFilterType filter_type) override {
+            return GetBlockFilterIndex(filter_type) != nullptr;
+        }
+        std::optional<bool> blockFilterMatchesAny(
+            BlockFilterType filter_type, const BlockHash &block_hash,
+            const GCSFilter::ElementSet &filter_set) override {
+            const BlockFilterIndex *block_filter_index{
+                GetBlockFilterIndex(filter_type)};
+            if (!block_filter_index) {
+                return std::nullopt;
+            }
+            const CBlockIndex *index{WITH_LOCK(
+                ::cs_main,
+                return chainman().m_blockman.LookupBlockIndex(block_hash))};
+            BlockFilter filter;
+            if (!index || !block_filter_index->LookupFilter(index, filter)) {
+                return std::nullopt;
+            }
+            return filter.GetFilter().MatchAny(filter_set);
+        }
         bool findFirstBlockWithTimeAndHeight(int64_t min_time, int min_height,
                                              const FoundBlock &block) override {
             WAIT_LOCK(cs_main, lock);
@@ -674,7 +728,13 @@ namespace {
             if (!m_node.mempool) {
                 return {};
             }
-            return m_node.mempool->estimateFee();
+            CFeeRate feerate{m_node.mempool->estimateFee()};
+            if (m_node.fee_estimator) {
+                feerate =
+                    std::max(feerate, m_node.fee_estimator->estimateFee(
+                                          DEFAULT_CONFIRM_TARGET));
+            }
+            return feerate;
         }
         CFeeRate relayMinFee() override {
             if (!m_node.mempool) {
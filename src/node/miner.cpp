@@ -262,6 +262,79 @@ BlockAssembler::CreateNewBlock(const CScript &scriptPubKeyIn) {
     return std::move(pblocktemplate);
 }
 
+BlockTemplateBuilder::BlockTemplateBuilder(
+    const Config &config, ChainstateManager &chainman,
+    const CTxMemPool &mempool, const avalanche::Processor *avalanche,
+    UpdatedFn on_updated)
+    : m_config(config), m_chainman(chainman), m_mempool(mempool),
+      m_avalanche(avalanche), m_on_updated(std::move(on_updated)) {}
+
+void BlockTemplateBuilder::UpdatedBlockTip(const CBlockIndex *pindexNew,
+                                           const CBlockIndex *pindexFork,
+                                           bool fInitialDownload) {
+    if (!fInitialDownload) {
+        Update();
+    }
+}
+
+void BlockTemplateBuilder::Update() {
+    // Read before assembling: a transaction added meanwhile triggers another
+    // rebuild next time.
+    const unsigned int transactions_updated{
+        m_mempool.GetTransactionsUpdated()};
+    const BlockHash tip{WITH_LOCK(::cs_main, {
+        if (m_chainman.ActiveChainstate().IsInitialBlockDownload()) {
+            return BlockHash{};
+        }
+        return m_chainman.ActiveTip()->GetBlockHash();
+    })};
+    if (tip.IsNull()) {
+        return;
+    }
+
+    {
+        LOCK(m_mutex);
+        if (m_template && m_template->block.hashPrevBlock == tip &&
+            m_transactions_updated == transactions_updated) {
+            return;
+        }
+    }
+
+    std::shared_ptr<const CBlockTemplate> block_template;
+    try {
+        block_template = BlockAssembler{m_config,
+                                        m_chainman.ActiveChainstate(),
+                                        &m_mempool, m_avalanche}
+                             .CreateNewBlock(CScript() << OP_TRUE);
+    } catch (const std::runtime_error &e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+        return;
+    }
+    if (!block_template) {
+        return;
+    }
+
+    {
+        LOCK(m_mutex);
+        m_template = block_template;
+        m_transactions_updated = transactions_updated;
+    }
+    if (m_on_updated) {
+        m_on_updated(*block_template);
+    }
+}
+
+std::shared_ptr<const CBlockTemplate>
+BlockTemplateBuilder::Get(const BlockHash &tip,
+                          unsigned int &transactions_updated) const {
+    LOCK(m_mutex);
+    if (!m_template || m_template->block.hashPrevBlock != tip) {
+        return nullptr;
+    }
+    transactions_updated = m_transactions_updated;
+    return m_template;
+}
+
 bool BlockAssembler::TestTxFits(uint64_t txSize, int64_t txSigChecks) const {
     if (nBlockSize + txSize >= nMaxGeneratedBlockSize) {
         return false;
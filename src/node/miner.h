@@ -9,17 +9,22 @@
 #include <consensus/amount.h>
 #include <kernel/mempool_entry.h>
 #include <primitives/block.h>
+#include <sync.h>
 #include <txmempool.h>
+#include <validationinterface.h>
 
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
 
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 
 class CBlockIndex;
 class CChainParams;
+class ChainstateManager;
 class Config;
 class CScript;
 
@@ -33,6 +38,11 @@ class Processor;
 
 namespace node {
 static const bool DEFAULT_PRINTPRIORITY = false;
+/**
+ * Default for -blocktemplaterefresh, 0 to only assemble block templates on
+ * request.
+ */
+static constexpr std::chrono::milliseconds DEFAULT_BLOCK_TEMPLATE_REFRESH{0};
 
 struct CBlockTemplateEntry {
     CTransactionRef tx;
@@ -122,6 +132,61 @@ private:
     bool CheckTx(const CTransaction &tx) const;
 };
 
+/**
+ * Keeps a block template on top of the active tip, paying to OP_TRUE like the
+ * ones of getblocktemplate. It is rebuilt in the background whenever the tip
+ * or the mempool changed, so that getblocktemplate can hand out a copy rather
+ * than assemble a block while the miner waits.
+ * As a validation interface, it rebuilds the template as soon as a new tip is
+ * connected.
+ */
+class BlockTemplateBuilder final : public CValidationInterface {
+public:
+    using UpdatedFn = std::function<void(const CBlockTemplate &)>;
+
+    /**
+     * @param[in] on_updated Called with every new template, from the thread
+     *     that built it.
+     */
+    BlockTemplateBuilder(const Config &config, ChainstateManager &chainman,
+                         const CTxMemPool &mempool,
+                         const avalanche::Processor *avalanche,
+                         UpdatedFn on_updated = {});
+
+    /** Rebuild the template if the tip or the mempool changed since. */
+    void Update() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex, !::cs_main);
+
+    /**
+     * Get the latest template, if it is built on top of the given tip.
+     * @param[out] transactions_updated The mempool's transactions updated
+     *     counter as of the template.
+     */
+    std::shared_ptr<const CBlockTemplate>
+    Get(const BlockHash &tip, unsigned int &transactions_updated) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+protected:
+    // CValidationInterface
+    void UpdatedBlockTip(const CBlockIndex *pindexNew,
+                         const CBlockIndex *pindexFork,
+                         bool fInitialDownload) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::string GetSubscriberName() const override {
+        return "template_builder";
+    }
+
+private:
+    const Config &m_config;
+    ChainstateManager &m_chainman;
+    const CTxMemPool &m_mempool;
+    const avalanche::Processor *const m_avalanche;
+    const UpdatedFn m_on_updated;
+
+    mutable Mutex m_mutex;
+    std::shared_ptr<const CBlockTemplate> m_template GUARDED_BY(m_mutex);
+    unsigned int m_transactions_updated GUARDED_BY(m_mutex){0};
+};
+
 int64_t UpdateTime(CBlockHeader *pblock, const CChainParams &chainParams,
                    const CBlockIndex *pindexPrev, int64_t adjustedTime);
 } // namespace node
@@ -20,6 +20,19 @@ void ApplyArgsManOptions(const ArgsManager &argsman,
             *value, 0, std::numeric_limits<uint32_t>::max()));
     }
 
+    if (auto value{argsman.GetIntArg("-txbatchsize")}) {
+        options.tx_batch_size = uint32_t(std::clamp<int64_t>(
+            *value, 0, std::numeric_limits<uint32_t>::max()));
+    }
+
+    if (auto value{argsman.GetBoolArg("-txvalidationthread")}) {
+        options.tx_validation_thread = *value;
+    }
+
+    if (auto value{argsman.GetBoolArg("-blockconnectthread")}) {
+        options.block_connect_thread = *value;
+    }
+
     if (auto value{argsman.GetBoolArg("-capturemessages")}) {
         options.capture_messages = *value;
     }
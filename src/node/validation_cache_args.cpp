@@ -19,8 +19,8 @@ using kernel::ValidationCacheSizes;
 namespace node {
 void ApplyArgsManOptions(const ArgsManager &argsman,
                          ValidationCacheSizes &cache_sizes) {
-    // When supplied with a max_size of 0, both InitSignatureCache and
-    // InitScriptExecutionCache create the minimum possible cache (2
+    // When supplied with a max_size of 0, InitSignatureCache,
+    // InitScriptExecutionCache and InitPowCache create the minimum possible cache (2
     // elements). Therefore, we can use 0 as a floor here.
     if (auto max_size = argsman.GetIntArg("-maxsigcachesize")) {
         cache_sizes.signature_cache_bytes =
@@ -30,5 +30,9 @@ void ApplyArgsManOptions(const ArgsManager &argsman,
         cache_sizes.script_execution_cache_bytes =
             std::max<int64_t>(*max_size, 0) * (1 << 20);
     }
+    if (auto max_size = argsman.GetIntArg("-maxpowcachesize")) {
+        cache_sizes.pow_cache_bytes =
+            std::max<int64_t>(*max_size, 0) * (1 << 20);
+    }
 }
 } // namespace node
@@ -16,6 +16,7 @@
 #include <tinyformat.h>
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 
 bool RTTPolicy::operator()(BlockPolicyValidationState &state) {
@@ -89,7 +90,7 @@ static const double RTT_CONSTANT_FACTOR_11 =
 static const double RTT_CONSTANT_FACTOR_17 =
     RTT_K * std::pow(std::tgamma(1. + 1. / RTT_K), RTT_K) /
     std::pow(9600., RTT_K - 1.);
-static const std::vector<double> RTT_CONSTANT_FACTOR = {
+static const std::array<double, 18> RTT_CONSTANT_FACTOR = {
     0., 0., RTT_CONSTANT_FACTOR_2,
     0., 0., RTT_CONSTANT_FACTOR_5,
     0., 0., 0.,
@@ -104,7 +105,9 @@ GetNextRTTWorkRequired(const CBlockIndex *pprev, int64_t now,
     const CBlockIndex *previousIndex = pprev;
     // We loop over the past 17 blocks to gather their receive time. We don't
     // care about the receive time of the current block se we leave it at zero.
-    std::vector<int64_t> prevHeaderReceivedTime(18, 0);
+    // This runs for every block considered for parking, so the times are kept
+    // on the stack.
+    std::array<int64_t, 18> prevHeaderReceivedTime{};
     for (size_t i = 1; i < 18; i++) {
         if (!previousIndex) {
             return std::nullopt;
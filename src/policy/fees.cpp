@@ -6,7 +6,17 @@
 
 #include <policy/fees.h>
 
+#include <chain.h>
+#include <coins.h>
 #include <feerate.h>
+#include <logging.h>
+#include <primitives/block.h>
+#include <serialize.h>
+#include <streams.h>
+#include <txmempool.h>
+
+#include <algorithm>
+#include <optional>
 
 static std::set<Amount> MakeFeeSet(const CFeeRate &min_incremental_fee,
                                    const Amount &max_filter_fee_rate,
@@ -43,3 +53,238 @@ Amount FeeFilterRounder::round(const Amount currentMinFee) {
 
     return *it;
 }
+
+/** The decay applied to the counts with every block. */
+static constexpr double FEE_ESTIMATE_DECAY{0.995};
+/** The share of the transactions that must confirm within the target. */
+static constexpr double FEE_ESTIMATE_SUCCESS_THRESHOLD{0.85};
+/** The decayed number of transactions a bucket range needs for an estimate. */
+static constexpr double FEE_ESTIMATE_SUFFICIENT_TXS{10};
+/** Rescale the counts when the weight of the new events grows this large. */
+static constexpr double FEE_ESTIMATE_MAX_WEIGHT{1e100};
+/** The version of the serialized estimator statistics. */
+static constexpr uint32_t FEE_ESTIMATES_VERSION{1};
+
+static std::vector<Amount> MakeBucketLimits() {
+    std::vector<Amount> limits;
+    for (double bucket_boundary = MIN_FEERATE / SATOSHI;
+         bucket_boundary < double(MAX_FEERATE / SATOSHI);
+         bucket_boundary *= FEE_SPACING) {
+        limits.push_back(int64_t(bucket_boundary) * SATOSHI);
+    }
+    limits.push_back(MAX_FEERATE);
+    return limits;
+}
+
+FeeRateEstimator::FeeRateEstimator(int best_height)
+    : m_bucket_limits{MakeBucketLimits()}, m_buckets(m_bucket_limits.size()),
+      m_best_height{best_height} {}
+
+size_t FeeRateEstimator::GetBucket(const CFeeRate &feerate) const {
+    auto it = std::lower_bound(m_bucket_limits.begin(), m_bucket_limits.end(),
+                               feerate.GetFeePerK());
+    if (it == m_bucket_limits.end()) {
+        return m_bucket_limits.size() - 1;
+    }
+    return it - m_bucket_limits.begin();
+}
+
+void FeeRateEstimator::processTransaction(const TxId &txid,
+                                          const CFeeRate &feerate) {
+    const size_t bucket{GetBucket(feerate)};
+    LOCK(m_mutex);
+    if (!m_tracked.emplace(txid, TrackedTx{bucket, m_best_height}).second) {
+        return;
+    }
+    m_entry_order.emplace_back(m_best_height, txid);
+}
+
+void FeeRateEstimator::removeTransaction(const TxId &txid, bool failed) {
+    LOCK(m_mutex);
+    auto it = m_tracked.find(txid);
+    if (it == m_tracked.end()) {
+        return;
+    }
+    if (failed) {
+        Resolve(it->second, 0);
+    }
+    m_tracked.erase(it);
+}
+
+void FeeRateEstimator::Resolve(const TrackedTx &tracked, int confirmations) {
+    AssertLockHeld(m_mutex);
+    Bucket &bucket = m_buckets[tracked.bucket];
+    bucket.resolved += m_weight;
+    if (confirmations > 0) {
+        bucket.confirmed[std::min(confirmations, MAX_CONFIRM_TARGET) - 1] +=
+            m_weight;
+    }
+}
+
+void FeeRateEstimator::processBlock(int height,
+                                    const std::vector<CTransactionRef> &txs) {
+    LOCK(m_mutex);
+    m_best_height = height;
+
+    for (const auto &tx : txs) {
+        auto it = m_tracked.find(tx->GetId());
+        if (it == m_tracked.end()) {
+            continue;
+        }
+        Resolve(it->second, std::max(1, height - it->second.entry_height));
+        m_tracked.erase(it);
+    }
+
+    // The transactions that did not confirm within the longest target are
+    // failures for all the targets.
+    while (!m_entry_order.empty() &&
+           m_entry_order.front().first < height - MAX_CONFIRM_TARGET) {
+        auto it = m_tracked.find(m_entry_order.front().second);
+        // The transaction might have been removed then added again later.
+        if (it != m_tracked.end() &&
+            it->second.entry_height == m_entry_order.front().first) {
+            Resolve(it->second, 0);
+            m_tracked.erase(it);
+        }
+        m_entry_order.pop_front();
+    }
+
+    m_weight /= FEE_ESTIMATE_DECAY;
+    if (m_weight > FEE_ESTIMATE_MAX_WEIGHT) {
+        for (Bucket &bucket : m_buckets) {
+            bucket.resolved /= m_weight;
+            for (double &confirmed : bucket.confirmed) {
+                confirmed /= m_weight;
+            }
+        }
+        m_weight = 1;
+    }
+}
+
+CFeeRate FeeRateEstimator::estimateFee(int conf_target) const {
+    conf_target = std::clamp(conf_target, 1, MAX_CONFIRM_TARGET);
+
+    LOCK(m_mutex);
+    // Walk down from the highest fee rate, grouping buckets until there are
+    // enough transactions to tell, and stop at the first group that does not
+    // confirm fast enough.
+    std::optional<size_t> best;
+    double resolved{0};
+    double confirmed{0};
+    for (size_t i = m_buckets.size(); i-- > 0;) {
+        const Bucket &bucket = m_buckets[i];
+        resolved += bucket.resolved;
+        for (int target = 0; target < conf_target; ++target) {
+            confirmed += bucket.confirmed[target];
+        }
+        if (resolved < FEE_ESTIMATE_SUFFICIENT_TXS * m_weight) {
+            continue;
+        }
+        if (confirmed < FEE_ESTIMATE_SUCCESS_THRESHOLD * resolved) {
+            break;
+        }
+        best = i;
+        resolved = 0;
+        confirmed = 0;
+    }
+
+    if (!best) {
+        return CFeeRate();
+    }
+    return CFeeRate(m_bucket_limits[*best]);
+}
+
+bool FeeRateEstimator::Write(CAutoFile &file) const {
+    try {
+        LOCK(m_mutex);
+        file << FEE_ESTIMATES_VERSION;
+        file << uint32_t(MAX_CONFIRM_TARGET);
+        file << m_bucket_limits;
+
+        // Only the buckets that still carry some weight are saved.
+        std::vector<std::pair<uint32_t, const Bucket *>> buckets;
+        for (size_t i = 0; i < m_buckets.size(); ++i) {
+            if (m_buckets[i].resolved / m_weight >= 1e-3) {
+                buckets.emplace_back(i, &m_buckets[i]);
+            }
+        }
+        WriteCompactSize(file, buckets.size());
+        for (const auto &[index, bucket] : buckets) {
+            file << index << bucket->resolved / m_weight;
+            for (const double confirmed : bucket->confirmed) {
+                file << confirmed / m_weight;
+            }
+        }
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to write fee estimates: %s\n", e.what());
+        return false;
+    }
+    return true;
+}
+
+bool FeeRateEstimator::Read(CAutoFile &file) {
+    try {
+        uint32_t version;
+        uint32_t max_target;
+        std::vector<Amount> bucket_limits;
+        file >> version >> max_target >> bucket_limits;
+        if (version != FEE_ESTIMATES_VERSION ||
+            max_target != MAX_CONFIRM_TARGET ||
+            bucket_limits != m_bucket_limits) {
+            // The statistics are not worth converting, they are rebuilt
+            // within a few hours.
+            LogPrintf("Ignoring fee estimates in an incompatible format\n");
+            return false;
+        }
+
+        std::vector<Bucket> buckets(m_bucket_limits.size());
+        const uint64_t num_buckets{ReadCompactSize(file)};
+        for (uint64_t i = 0; i < num_buckets; ++i) {
+            uint32_t index;
+            file >> index;
+            if (index >= buckets.size()) {
+                throw std::ios_base::failure("Invalid fee estimates bucket");
+            }
+            file >> buckets[index].resolved;
+            for (double &confirmed : buckets[index].confirmed) {
+                file >> confirmed;
+            }
+        }
+
+        LOCK(m_mutex);
+        m_buckets = std::move(buckets);
+        m_weight = 1;
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to read fee estimates: %s\n", e.what());
+        return false;
+    }
+    return true;
+}
+
+void FeeRateEstimator::TransactionAddedToMempool(
+    const CTransactionRef &tx,
+    std::shared_ptr<const std::vector<Coin>> spent_coins,
+    uint64_t mempool_sequence) {
+    if (!spent_coins || spent_coins->size() != tx->vin.size()) {
+        return;
+    }
+    Amount value_in{Amount::zero()};
+    for (const Coin &coin : *spent_coins) {
+        value_in += coin.GetTxOut().nValue;
+    }
+    processTransaction(tx->GetId(), CFeeRate(value_in - tx->GetValueOut(),
+                                             tx->GetTotalSize()));
+}
+
+void FeeRateEstimator::TransactionRemovedFromMempool(
+    const CTransactionRef &tx, MemPoolRemovalReason reason,
+    uint64_t mempool_sequence) {
+    removeTransaction(tx->GetId(),
+                      reason == MemPoolRemovalReason::EXPIRY ||
+                          reason == MemPoolRemovalReason::SIZELIMIT);
+}
+
+void FeeRateEstimator::BlockConnected(
+    const std::shared_ptr<const CBlock> &block, const CBlockIndex *pindex) {
+    processBlock(pindex->nHeight, block->vtx);
+}
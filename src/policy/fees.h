@@ -6,15 +6,22 @@
 #define BITCOIN_POLICY_FEES_H
 
 #include <consensus/amount.h>
+#include <feerate.h>
+#include <primitives/transaction.h>
 #include <random.h>
 #include <sync.h>
 #include <uint256.h>
+#include <util/hasher.h>
+#include <validationinterface.h>
 
+#include <array>
+#include <deque>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-class CFeeRate;
+class CAutoFile;
 
 // Minimum and Maximum values for tracking feerates
 static constexpr Amount MIN_FEERATE(10 * SATOSHI);
@@ -44,4 +51,105 @@ private:
     FastRandomContext &insecure_rand GUARDED_BY(m_insecure_rand_mutex);
 };
 
+/** The longest confirmation target, in blocks, the estimator tracks. */
+static constexpr int MAX_CONFIRM_TARGET{48};
+/** The confirmation target used when none is requested. */
+static constexpr int DEFAULT_CONFIRM_TARGET{6};
+
+/**
+ * Estimate the fee rate a transaction should pay to confirm within a number of
+ * blocks, from how fast the transactions seen in the mempool were mined.
+ *
+ * The transactions are lumped into exponentially spaced fee rate buckets. For
+ * each bucket the estimator counts the transactions that left the tracking,
+ * either because they were mined or because they failed to confirm within
+ * MAX_CONFIRM_TARGET blocks, along with the number of blocks it took to mine
+ * them. All the counts decay exponentially with every block, so recent
+ * behavior prevails. The estimate is the lowest fee rate above which enough of
+ * the transactions were mined within the target.
+ *
+ * Finding the bucket of a transaction is logarithmic in the number of buckets
+ * and the other updates are constant time: rather than decaying every count on
+ * each block, the weight of the new events grows.
+ */
+class FeeRateEstimator final : public CValidationInterface {
+public:
+    explicit FeeRateEstimator(int best_height);
+
+    /** Start tracking a transaction that entered the mempool. */
+    void processTransaction(const TxId &txid, const CFeeRate &feerate)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Stop tracking a transaction that left the mempool without being mined.
+     * @param[in] failed Whether it counts as a failure to confirm (it expired
+     *     or was evicted) rather than just being forgotten (e.g. a conflict).
+     */
+    void removeTransaction(const TxId &txid, bool failed)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Account for the transactions mined in a block and decay the counts. */
+    void processBlock(int height, const std::vector<CTransactionRef> &txs)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Estimate the fee rate needed to confirm within conf_target blocks, which
+     * is clamped to [1, MAX_CONFIRM_TARGET].
+     * @return A null fee rate if there is not enough data.
+     */
+    CFeeRate estimateFee(int conf_target) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Save and restore the bucket statistics. The transactions being tracked
+     * are not saved.
+     */
+    bool Write(CAutoFile &file) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool Read(CAutoFile &file) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+protected:
+    void TransactionAddedToMempool(
+        const CTransactionRef &tx,
+        std::shared_ptr<const std::vector<Coin>> spent_coins,
+        uint64_t mempool_sequence) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void TransactionRemovedFromMempool(const CTransactionRef &tx,
+                                       MemPoolRemovalReason reason,
+                                       uint64_t mempool_sequence) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void BlockConnected(const std::shared_ptr<const CBlock> &block,
+                        const CBlockIndex *pindex) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::string GetSubscriberName() const override { return "fee_estimator"; }
+
+private:
+    struct Bucket {
+        /** Transactions that were mined or failed to confirm. */
+        double resolved{0};
+        /** Transactions mined, by the number of blocks it took minus one. */
+        std::array<double, MAX_CONFIRM_TARGET> confirmed{};
+    };
+
+    struct TrackedTx {
+        size_t bucket;
+        int entry_height;
+    };
+
+    /** The upper fee rate limit of each bucket, in satoshis per kB. */
+    const std::vector<Amount> m_bucket_limits;
+
+    mutable Mutex m_mutex;
+    std::vector<Bucket> m_buckets GUARDED_BY(m_mutex);
+    /** The weight of an event happening now. */
+    double m_weight GUARDED_BY(m_mutex){1};
+    int m_best_height GUARDED_BY(m_mutex);
+    std::unordered_map<TxId, TrackedTx, SaltedTxIdHasher>
+        m_tracked GUARDED_BY(m_mutex);
+    /** The tracked transactions in the order they entered the mempool. */
+    std::deque<std::pair<int, TxId>> m_entry_order GUARDED_BY(m_mutex);
+
+    size_t GetBucket(const CFeeRate &feerate) const;
+    void Resolve(const TrackedTx &tracked, int confirmations)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+};
+
 #endif // BITCOIN_POLICY_FEES_H
@@ -5,11 +5,26 @@
 #include <consensus/params.h>
 #include <logging.h>
 #include <pow/pow.h>
+#include <pow/powcache.h>
 #include <primitives/auxpow.h>
 #include <primitives/block.h>
 
-bool CheckAuxProofOfWork(const CBlockHeader &block,
-                         const Consensus::Params &params) {
+const CBaseBlockHeader &GetPowHeader(const CBlockHeader &block) {
+    if (block.auxpow) {
+        return block.auxpow->parentBlock;
+    }
+    return block;
+}
+
+/**
+ * Run the checks of an auxpow header, and check_pow() for its PoW. The PoW is
+ * only checked once all the cheaper checks passed, so invalid headers can't
+ * make us do expensive scrypt hashing.
+ */
+template <typename CheckPow>
+static bool CheckAuxProofOfWorkImpl(const CBlockHeader &block,
+                                    const Consensus::Params &params,
+                                    CheckPow check_pow) {
     // Except for legacy blocks with full version 1 or 2, ensure that the chain
     // ID is correct. Legacy blocks are not allowed since the merge-mining
     // start, which is checked in AcceptBlockHeader where the height is known.
@@ -28,7 +43,7 @@ bool CheckAuxProofOfWork(const CBlockHeader &block,
                          __func__, block.GetHash().ToString(), block.nVersion);
         }
 
-        if (!CheckProofOfWork(block.GetPowHash(), block.nBits, params)) {
+        if (!check_pow()) {
             return error("%s: non-AUX proof of work failed", __func__);
         }
 
@@ -47,10 +62,43 @@ bool CheckAuxProofOfWork(const CBlockHeader &block,
                      ErrorString(auxResult).original);
     }
 
-    if (!CheckProofOfWork(BlockHash(block.auxpow->parentBlock.GetPowHash()),
-                          block.nBits, params)) {
+    if (!check_pow()) {
         return error("%s: Auxillary header proof of work failed", __func__);
     }
 
     return true;
 }
+
+bool CheckAuxProofOfWork(const CBlockHeader &block,
+                         const Consensus::Params &params) {
+    return CheckAuxProofOfWorkImpl(block, params, [&]() {
+        const CBaseBlockHeader &powHeader = GetPowHeader(block);
+        const BlockHash powHeaderHash = powHeader.GetHash();
+        // Headers found in the PoW cache are not hashed at all.
+        if (IsPowCached(powHeaderHash, block.nBits)) {
+            return true;
+        }
+        if (!CheckProofOfWork(powHeader.GetPowHash(), block.nBits, params)) {
+            return false;
+        }
+        AddPowCache(powHeaderHash, block.nBits);
+        return true;
+    });
+}
+
+bool CheckAuxProofOfWork(const CBlockHeader &block, const BlockHash &powHash,
+                         const Consensus::Params &params) {
+    return CheckAuxProofOfWorkImpl(block, params, [&]() {
+        // A caller that already computed the hash has no use for the cache.
+        if (!CheckProofOfWork(powHash, block.nBits, params)) {
+            return false;
+        }
+        AddPowCache(GetPowHeader(block).GetHash(), block.nBits);
+        return true;
+    });
+}
+
+bool CheckCachedAuxProofOfWork(const CBlockHeader &block,
+                               const Consensus::Params &params) {
+    return CheckAuxProofOfWorkImpl(block, params, []() { return true; });
+}
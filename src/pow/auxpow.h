@@ -5,7 +5,9 @@
 #ifndef BITCOIN_POW_AUXPOW_H
 #define BITCOIN_POW_AUXPOW_H
 
+class CBaseBlockHeader;
 class CBlockHeader;
+struct BlockHash;
 
 namespace Consensus {
 struct Params;
@@ -14,4 +16,25 @@ struct Params;
 bool CheckAuxProofOfWork(const CBlockHeader &block,
                          const Consensus::Params &params);
 
+/**
+ * Like CheckAuxProofOfWork, but using a PoW hash of GetPowHeader(block) that
+ * was computed beforehand, e.g. in a batch with other headers.
+ */
+bool CheckAuxProofOfWork(const CBlockHeader &block, const BlockHash &powHash,
+                         const Consensus::Params &params);
+
+/**
+ * Like CheckAuxProofOfWork, for a header the caller found in the PoW cache
+ * with IsPowCached(): only the checks other than the PoW hash itself are run,
+ * and the cache is not looked up again.
+ */
+bool CheckCachedAuxProofOfWork(const CBlockHeader &block,
+                               const Consensus::Params &params);
+
+/**
+ * The header whose PoW hash must meet the target of the block: the parent
+ * block for merge-mined blocks, or the block itself.
+ */
+const CBaseBlockHeader &GetPowHeader(const CBlockHeader &block);
+
 #endif // BITCOIN_POW_AUXPOW_H
@@ -0,0 +1,130 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <pow/powcache.h>
+
+#include <crypto/common.h>
+#include <crypto/sha256.h>
+#include <cuckoocache.h>
+#include <logging.h>
+#include <random.h>
+#include <uint256.h>
+#include <util/hasher.h>
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+
+namespace {
+
+/**
+ * Valid PoW cache, to avoid computing the scrypt hash of a header several
+ * times.
+ */
+class CPowCache {
+private:
+    //! Entries are SHA256(nonce || SHA256d(header) || nBits)
+    CSHA256 m_salted_hasher;
+    typedef CuckooCache::cache<CuckooCache::KeyOnly<uint256>,
+                               SignatureCacheHasher>
+        map_type;
+    map_type setValid;
+    std::shared_mutex cs_powcache;
+
+    std::atomic<bool> m_initialized{false};
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    size_t m_max_elements{0};
+    size_t m_size_bytes{0};
+
+public:
+    CPowCache() {
+        uint256 nonce = GetRandHash();
+        // Write the 32-byte entropy twice to fill a 64-byte chunk, which makes
+        // later hash computations more efficient.
+        m_salted_hasher.Write(nonce.begin(), 32);
+        m_salted_hasher.Write(nonce.begin(), 32);
+    }
+
+    void ComputeEntry(uint256 &entry, const BlockHash &hash, uint32_t nBits) {
+        uint8_t bits[4];
+        WriteLE32(bits, nBits);
+        CSHA256 hasher = m_salted_hasher;
+        hasher.Write(hash.begin(), 32).Write(bits, 4).Finalize(entry.begin());
+    }
+
+    bool IsInitialized() const { return m_initialized; }
+
+    bool Get(const uint256 &entry) {
+        bool found;
+        {
+            std::shared_lock<std::shared_mutex> lock(cs_powcache);
+            found = setValid.contains(entry, /*erase=*/false);
+        }
+        ++(found ? m_hits : m_misses);
+        return found;
+    }
+
+    void Set(const uint256 &entry) {
+        std::unique_lock<std::shared_mutex> lock(cs_powcache);
+        setValid.insert(entry);
+    }
+
+    std::optional<std::pair<uint32_t, size_t>> setup_bytes(size_t n) {
+        std::unique_lock<std::shared_mutex> lock(cs_powcache);
+        auto setup_results = setValid.setup_bytes(n);
+        if (setup_results) {
+            std::tie(m_max_elements, m_size_bytes) = *setup_results;
+            m_initialized = true;
+        }
+        return setup_results;
+    }
+
+    PowCacheStats GetStats() {
+        std::shared_lock<std::shared_mutex> lock(cs_powcache);
+        return {m_hits, m_misses, m_max_elements, m_size_bytes};
+    }
+};
+
+static CPowCache powCache;
+} // namespace
+
+// To be called once in AppInitMain/BasicTestingSetup to initialize the
+// powCache.
+bool InitPowCache(size_t max_size_bytes) {
+    auto setup_results = powCache.setup_bytes(max_size_bytes);
+    if (!setup_results) {
+        return false;
+    }
+
+    const auto [num_elems, approx_size_bytes] = *setup_results;
+    LogPrintf("Using %zu MiB out of %zu MiB requested for PoW cache, able to "
+              "store %zu elements\n",
+              approx_size_bytes >> 20, max_size_bytes >> 20, num_elems);
+    return true;
+}
+
+bool IsPowCached(const BlockHash &powHeaderHash, uint32_t nBits) {
+    if (!powCache.IsInitialized()) {
+        return false;
+    }
+    uint256 entry;
+    powCache.ComputeEntry(entry, powHeaderHash, nBits);
+    return powCache.Get(entry);
+}
+
+void AddPowCache(const BlockHash &powHeaderHash, uint32_t nBits) {
+    if (!powCache.IsInitialized()) {
+        return;
+    }
+    uint256 entry;
+    powCache.ComputeEntry(entry, powHeaderHash, nBits);
+    powCache.Set(entry);
+}
+
+PowCacheStats GetPowCacheStats() {
+    return powCache.GetStats();
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_POW_POWCACHE_H
+#define BITCOIN_POW_POWCACHE_H
+
+#include <primitives/blockhash.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// The scrypt PoW hash is very expensive, so even a small cache saves a lot of
+// work: 4MiB holds the result for over 100000 headers.
+static constexpr size_t DEFAULT_MAX_POW_CACHE_BYTES{4 << 20};
+
+/**
+ * Dogecoin: the PoW cache remembers which headers are known to have a scrypt
+ * hash below a given target, so the same header doesn't get scrypt-hashed
+ * again when it is checked in headers processing, when the full block arrives
+ * and when it is read back from disk.
+ *
+ * Entries are keyed by the SHA256d hash of the header that carries the PoW
+ * (the parent block for merge-mined blocks) and the target nBits.
+ */
+
+/** Initializes the PoW cache. Until it is, no result is cached. */
+[[nodiscard]] bool InitPowCache(size_t max_size_bytes);
+
+/**
+ * Whether the PoW hash of the header with block hash powHeaderHash is known to
+ * meet the nBits target.
+ */
+bool IsPowCached(const BlockHash &powHeaderHash, uint32_t nBits);
+
+/**
+ * Record that the PoW hash of the header with block hash powHeaderHash meets
+ * the nBits target.
+ */
+void AddPowCache(const BlockHash &powHeaderHash, uint32_t nBits);
+
+struct PowCacheStats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+    size_t max_elements{0};
+    size_t size_bytes{0};
+};
+
+PowCacheStats GetPowCacheStats();
+
+#endif // BITCOIN_POW_POWCACHE_H
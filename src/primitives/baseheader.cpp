@@ -4,46 +4,59 @@
 
 #include <primitives/baseheader.h>
 
-#include <chainparams.h>
+#include <crypto/common.h>
 #include <crypto/scrypt.h>
 #include <hash.h>
-#include <serialize.h>
+
+#include <algorithm>
+
+/**
+ * Write the 80-byte wire serialization of the header, which is both the input
+ * of the block hash and the PoW hash.
+ */
+static void SerializeHeader(const CBaseBlockHeader &header, uint8_t *bytes) {
+    WriteLE32(bytes, header.nVersion);
+    std::copy(header.hashPrevBlock.begin(), header.hashPrevBlock.end(),
+              bytes + 4);
+    std::copy(header.hashMerkleRoot.begin(), header.hashMerkleRoot.end(),
+              bytes + 36);
+    WriteLE32(bytes + 68, header.nTime);
+    WriteLE32(bytes + 72, header.nBits);
+    WriteLE32(bytes + 76, header.nNonce);
+}
 
 BlockHash CBaseBlockHeader::GetHash() const {
-    return BlockHash(SerializeHash(*this));
+    uint8_t bytes[SERIALIZED_SIZE];
+    SerializeHeader(*this, bytes);
+    return BlockHash(Hash(bytes));
 }
 
 BlockHash CBaseBlockHeader::GetPowHash() const {
-    // TODO: Dedup serialization, e.g. using a SpanWriter
-    uint8_t bytes[80];
-    size_t idx = 0;
-    uint32_t version = this->nVersion;
-    for (size_t i = 0; i < 4; ++i) {
-        bytes[idx++] = version & 0xff;
-        version >>= 8;
-    }
-    for (uint8_t byte : this->hashPrevBlock) {
-        bytes[idx++] = byte;
-    }
-    for (uint8_t byte : this->hashMerkleRoot) {
-        bytes[idx++] = byte;
-    }
-    uint32_t time = this->nTime;
-    for (size_t i = 0; i < 4; ++i) {
-        bytes[idx++] = time & 0xff;
-        time >>= 8;
-    }
-    uint32_t bits = this->nBits;
-    for (size_t i = 0; i < 4; ++i) {
-        bytes[idx++] = bits & 0xff;
-        bits >>= 8;
-    }
-    uint32_t nonce = this->nNonce;
-    for (size_t i = 0; i < 4; ++i) {
-        bytes[idx++] = nonce & 0xff;
-        nonce >>= 8;
-    }
+    uint8_t bytes[SERIALIZED_SIZE];
+    SerializeHeader(*this, bytes);
     uint256 hash;
     scrypt_1024_1_1_256(bytes, hash.data());
     return BlockHash(hash);
 }
+
+std::pair<BlockHash, BlockHash> CBaseBlockHeader::GetHashes() const {
+    uint8_t bytes[SERIALIZED_SIZE];
+    SerializeHeader(*this, bytes);
+    uint256 powHash;
+    scrypt_1024_1_1_256(bytes, powHash.data());
+    return {BlockHash(Hash(bytes)), BlockHash(powHash)};
+}
+
+std::vector<BlockHash> CBaseBlockHeader::GetPowHashes(
+    const std::vector<const CBaseBlockHeader *> &headers) {
+    std::vector<uint8_t> inputs(SERIALIZED_SIZE * headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        SerializeHeader(*headers[i], &inputs[SERIALIZED_SIZE * i]);
+    }
+    std::vector<BlockHash> hashes(headers.size());
+    static_assert(sizeof(BlockHash) == 32);
+    scrypt_1024_1_1_256_multi(inputs.data(),
+                              reinterpret_cast<uint8_t *>(hashes.data()),
+                              headers.size());
+    return hashes;
+}
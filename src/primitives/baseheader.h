@@ -10,6 +10,10 @@
 #include <uint256.h>
 #include <util/time.h>
 
+#include <cstddef>
+#include <utility>
+#include <vector>
+
 /**
  * Dogecoin specific: A normal Bitcoin header without auxpow information, for
  * merge-mining.
@@ -23,6 +27,9 @@
  */
 class CBaseBlockHeader {
 public:
+    //! Size of the serialized header, the input of both hashes
+    static constexpr size_t SERIALIZED_SIZE = 80;
+
     // header
     int32_t nVersion;
     BlockHash hashPrevBlock;
@@ -59,6 +66,20 @@ public:
      * below the target. */
     BlockHash GetPowHash() const;
 
+    /**
+     * Compute both the block hash and the PoW hash, serializing the header
+     * only once.
+     */
+    std::pair<BlockHash, BlockHash> GetHashes() const;
+
+    /**
+     * Compute the "PoW hashes" of several headers at once. This is much
+     * faster than calling GetPowHash on each of them when the CPU supports
+     * hashing multiple scrypt lanes in parallel.
+     */
+    static std::vector<BlockHash>
+    GetPowHashes(const std::vector<const CBaseBlockHeader *> &headers);
+
     NodeSeconds Time() const {
         return NodeSeconds{std::chrono::seconds{nTime}};
     }
@@ -16,6 +16,9 @@
 #include <uint256.h>
 #include <util/time.h>
 
+#include <atomic>
+#include <utility>
+
 /**
  * Nodes collect new transactions into a block, hash them into a hash tree, and
  * scan through nonce values to make the block's hash satisfy proof-of-work
@@ -65,7 +68,9 @@ public:
     std::vector<CTransactionRef> vtx;
 
     // memory only
-    mutable bool fChecked;
+    // Atomic so that the context free checks of a shared block can run
+    // concurrently, without holding cs_main.
+    mutable std::atomic<bool> fChecked;
 
     CBlock() { SetNull(); }
 
@@ -74,9 +79,35 @@ public:
         *(static_cast<CBlockHeader *>(this)) = header;
     }
 
-    SERIALIZE_METHODS(CBlock, obj) {
-        READWRITEAS(CBlockHeader, obj);
-        READWRITE(obj.vtx);
+    CBlock(const CBlock &other)
+        : CBlockHeader(other), vtx(other.vtx), fChecked(other.fChecked.load()) {
+    }
+    CBlock(CBlock &&other) noexcept
+        : CBlockHeader(std::move(other)), vtx(std::move(other.vtx)),
+          fChecked(other.fChecked.load()) {}
+
+    CBlock &operator=(const CBlock &other) {
+        CBlockHeader::operator=(other);
+        vtx = other.vtx;
+        fChecked = other.fChecked.load();
+        return *this;
+    }
+    CBlock &operator=(CBlock &&other) noexcept {
+        CBlockHeader::operator=(std::move(other));
+        vtx = std::move(other.vtx);
+        fChecked = other.fChecked.load();
+        return *this;
+    }
+
+    template <typename Stream> void Serialize(Stream &s) const {
+        s << static_cast<const CBlockHeader &>(*this);
+        s << vtx;
+    }
+
+    template <typename Stream> void Unserialize(Stream &s) {
+        s >> static_cast<CBlockHeader &>(*this);
+        // Compute the hashes of all the transactions at once
+        UnserializeTransactions(s, vtx);
     }
 
     void SetNull() {
@@ -0,0 +1,73 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <primitives/blockview.h>
+
+#include <hash.h>
+#include <serialize.h>
+#include <streams.h>
+#include <version.h>
+
+#include <algorithm>
+#include <ios>
+
+TxId TransactionView::GetId() const {
+    return TxId(Hash(m_data));
+}
+
+TxHash TransactionView::GetHash() const {
+    return TxHash(Hash(m_data));
+}
+
+CTransactionRef TransactionView::ToTransactionRef() const {
+    CTransactionRef tx;
+    SpanReader{SER_NETWORK, PROTOCOL_VERSION, m_data} >> tx;
+    return tx;
+}
+
+/** Skip over a serialized transaction, mirroring UnserializeTransaction. */
+static void SkipTransaction(SpanReader &s) {
+    // nVersion
+    s.ignore(4);
+    const uint64_t num_inputs{ReadCompactSize(s)};
+    for (uint64_t i = 0; i < num_inputs; ++i) {
+        // prevout, scriptSig, nSequence
+        s.ignore(32 + 4);
+        s.ignore(ReadCompactSize(s));
+        s.ignore(4);
+    }
+    const uint64_t num_outputs{ReadCompactSize(s)};
+    for (uint64_t i = 0; i < num_outputs; ++i) {
+        // nValue, scriptPubKey
+        s.ignore(8);
+        s.ignore(ReadCompactSize(s));
+    }
+    // nLockTime
+    s.ignore(4);
+}
+
+bool BlockView::Parse(Span<const uint8_t> data) {
+    vtx.clear();
+    try {
+        SpanReader s{SER_NETWORK, PROTOCOL_VERSION, data};
+        s >> header;
+        const uint64_t num_txs{ReadCompactSize(s)};
+        // Each transaction is at least 10 bytes, don't let the count make us
+        // reserve more than the data can hold.
+        vtx.reserve(std::min<uint64_t>(num_txs, s.size() / 10));
+        for (uint64_t i = 0; i < num_txs; ++i) {
+            const size_t remaining{s.size()};
+            SkipTransaction(s);
+            vtx.emplace_back(data.last(remaining).first(remaining - s.size()));
+        }
+        if (!s.empty()) {
+            vtx.clear();
+            return false;
+        }
+    } catch (const std::ios_base::failure &) {
+        vtx.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_PRIMITIVES_BLOCKVIEW_H
+#define BITCOIN_PRIMITIVES_BLOCKVIEW_H
+
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <primitives/txid.h>
+#include <span.h>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * A transaction within a serialized block, referring to its serialized bytes
+ * rather than owning a deserialized copy.
+ */
+class TransactionView {
+    Span<const uint8_t> m_data;
+
+public:
+    explicit TransactionView(Span<const uint8_t> data) : m_data(data) {}
+
+    /** The serialization of the transaction, valid as long as the block. */
+    Span<const uint8_t> data() const { return m_data; }
+    size_t GetTotalSize() const { return m_data.size(); }
+
+    TxId GetId() const;
+    TxHash GetHash() const;
+
+    /** Deserialize the transaction, for when it outlives the block. */
+    CTransactionRef ToTransactionRef() const;
+
+    template <typename Stream> void Serialize(Stream &s) const {
+        s.write(MakeByteSpan(m_data));
+    }
+};
+
+/**
+ * A serialized block split into its header and transactions. Only the header
+ * is deserialized, so the transactions are not allocated and are just hashed
+ * or copied where they are needed.
+ */
+class BlockView {
+public:
+    CBlockHeader header;
+    std::vector<TransactionView> vtx;
+
+    /**
+     * Split the serialized block, which must outlive this view.
+     * @return false if the data is not a well formed block.
+     */
+    bool Parse(Span<const uint8_t> data);
+};
+
+#endif // BITCOIN_PRIMITIVES_BLOCKVIEW_H
@@ -6,10 +6,12 @@
 #include <primitives/transaction.h>
 
 #include <consensus/amount.h>
+#include <crypto/sha256.h>
 #include <hash.h>
 #include <tinyformat.h>
 #include <util/strencodings.h>
 
+#include <algorithm>
 #include <cassert>
 
 std::string COutPoint::ToString() const {
@@ -61,19 +63,64 @@ uint256 CTransaction::ComputeHash() const {
     return SerializeHash(*this, SER_GETHASH, 0);
 }
 
+unsigned int CTransaction::ComputeTotalSize() const {
+    // Not through Serialize(CSizeComputer &), which reads the cached size.
+    CSizeComputer s(PROTOCOL_VERSION);
+    SerializeTransaction(*this, s);
+    return s.size();
+}
+
 /**
  * For backward compatibility, the hash is initialized to 0.
  * TODO: remove the need for this default constructor entirely.
  */
 CTransaction::CTransaction()
     : vin(), vout(), nVersion(CTransaction::CURRENT_VERSION), nLockTime(0),
-      hash() {}
+      hash(), m_total_size(ComputeTotalSize()) {}
 CTransaction::CTransaction(const CMutableTransaction &tx)
     : vin(tx.vin), vout(tx.vout), nVersion(tx.nVersion),
-      nLockTime(tx.nLockTime), hash(ComputeHash()) {}
+      nLockTime(tx.nLockTime), hash(ComputeHash()),
+      m_total_size(ComputeTotalSize()) {}
 CTransaction::CTransaction(CMutableTransaction &&tx)
     : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion),
-      nLockTime(tx.nLockTime), hash(ComputeHash()) {}
+      nLockTime(tx.nLockTime), hash(ComputeHash()),
+      m_total_size(ComputeTotalSize()) {}
+CTransaction::CTransaction(CMutableTransaction &&tx, const uint256 &hashIn,
+                           unsigned int total_size, PrecomputedHash)
+    : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion),
+      nLockTime(tx.nLockTime), hash(hashIn), m_total_size(total_size) {}
+
+std::vector<CTransactionRef>
+MakeTransactionRefs(std::vector<CMutableTransaction> &&txs,
+                    Span<const uint8_t> data, Span<const size_t> offsets) {
+    assert(offsets.size() == txs.size());
+    std::vector<const uint8_t *> inputs;
+    std::vector<size_t> lengths;
+    inputs.reserve(txs.size());
+    lengths.reserve(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i) {
+        const size_t end = i + 1 < txs.size() ? offsets[i + 1] : data.size();
+        assert(offsets[i] <= end && end <= data.size());
+        inputs.push_back(data.data() + offsets[i]);
+        lengths.push_back(end - offsets[i]);
+    }
+    std::vector<uint8_t> hashes(CSHA256::OUTPUT_SIZE * txs.size());
+    SHA256DMulti(hashes.data(), inputs.data(), lengths.data(), txs.size());
+
+    std::vector<CTransactionRef> refs;
+    refs.reserve(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i) {
+        uint256 hash;
+        std::copy_n(hashes.begin() + CSHA256::OUTPUT_SIZE * i,
+                    CSHA256::OUTPUT_SIZE, hash.begin());
+        // The transactions were read back to back, so their lengths are
+        // their serialized sizes.
+        refs.push_back(std::make_shared<const CTransaction>(
+            std::move(txs[i]), hash, lengths[i],
+            CTransaction::PrecomputedHash{}));
+    }
+    return refs;
+}
 
 Amount CTransaction::GetValueOut() const {
     Amount nValueOut = Amount::zero();
@@ -89,10 +136,6 @@ Amount CTransaction::GetValueOut() const {
     return nValueOut;
 }
 
-unsigned int CTransaction::GetTotalSize() const {
-    return ::GetSerializeSize(*this, PROTOCOL_VERSION);
-}
-
 std::string CTransaction::ToString() const {
     std::string str;
     str += strprintf("CTransaction(txid=%s, ver=%d, vin.size=%u, vout.size=%u, "
@@ -9,6 +9,7 @@
 
 #include <consensus/amount.h>
 #include <feerate.h>
+#include <hash.h>
 #include <primitives/txid.h>
 #include <script/script.h>
 #include <serialize.h>
@@ -211,20 +212,40 @@ public:
 private:
     /** Memory only. */
     const uint256 hash;
+    //! The serialized size, so that sizing a block or a message containing
+    //! the transaction doesn't need to go over its inputs and outputs again.
+    const unsigned int m_total_size;
 
     uint256 ComputeHash() const;
+    unsigned int ComputeTotalSize() const;
 
 public:
+    /**
+     * Key to the constructor taking an already computed hash and size, only
+     * MakeTransactionRefs can create one.
+     */
+    class PrecomputedHash {
+        explicit PrecomputedHash() = default;
+        friend std::vector<std::shared_ptr<const CTransaction>>
+        MakeTransactionRefs(std::vector<CMutableTransaction> &&txs,
+                            Span<const uint8_t> data,
+                            Span<const size_t> offsets);
+    };
+
     /** Construct a CTransaction that qualifies as IsNull() */
     CTransaction();
 
     /** Convert a CMutableTransaction into a CTransaction. */
     explicit CTransaction(const CMutableTransaction &tx);
     explicit CTransaction(CMutableTransaction &&tx);
+    CTransaction(CMutableTransaction &&tx, const uint256 &hashIn,
+                 unsigned int total_size, PrecomputedHash);
 
     template <typename Stream> inline void Serialize(Stream &s) const {
         SerializeTransaction(*this, s);
     }
+    //! Sizing only needs the cached size.
+    void Serialize(CSizeComputer &s) const { s.seek(m_total_size); }
 
     /**
      * This deserializing constructor is provided instead of an Unserialize
@@ -247,7 +268,7 @@ public:
      * Get the total transaction size in bytes.
      * @return Total transaction size in bytes
      */
-    unsigned int GetTotalSize() const;
+    unsigned int GetTotalSize() const { return m_total_size; }
 
     bool IsCoinBase() const {
         return (vin.size() == 1 && vin[0].prevout.IsNull());
@@ -264,8 +285,8 @@ public:
     std::string ToString() const;
 };
 #if defined(__x86_64__)
-static_assert(sizeof(CTransaction) == 88,
-              "sizeof CTransaction is expected to be 88 bytes");
+static_assert(sizeof(CTransaction) == 96,
+              "sizeof CTransaction is expected to be 96 bytes");
 #endif
 
 /**
@@ -321,10 +342,70 @@ static inline CTransactionRef MakeTransactionRef(Tx &&txIn) {
     return std::make_shared<const CTransaction>(std::forward<Tx>(txIn));
 }
 
+/**
+ * Convert a batch of transactions, such as the ones of a block. Their hashes
+ * are computed together, several at once in the lanes of the multi-way
+ * SHA256d implementation when available.
+ * data holds the serialized transactions back to back, as they were read, and
+ * offsets the position of each of them in data.
+ */
+std::vector<CTransactionRef>
+MakeTransactionRefs(std::vector<CMutableTransaction> &&txs,
+                    Span<const uint8_t> data, Span<const size_t> offsets);
+
+/**
+ * Deserialize a vector of transactions, computing their hashes together with
+ * MakeTransactionRefs from the bytes read.
+ */
+template <typename Stream>
+void UnserializeTransactions(Stream &s, std::vector<CTransactionRef> &vtx) {
+    const uint64_t count = ReadCompactSize(s);
+    // The bytes read are the serialization of the transactions, as the
+    // encodings are canonical: non-canonical compact sizes are rejected.
+    std::vector<uint8_t> data;
+    std::vector<size_t> offsets;
+    std::vector<CMutableTransaction> txs;
+    RecordingReader<Stream> reader{s, data};
+    while (txs.size() < count) {
+        // Don't trust the count for the allocation, same as for a vector.
+        if (txs.size() == txs.capacity()) {
+            const size_t grow = std::min<uint64_t>(
+                count - txs.size(),
+                MAX_VECTOR_ALLOCATE / sizeof(CMutableTransaction));
+            txs.reserve(txs.size() + grow);
+            offsets.reserve(txs.size() + grow);
+        }
+        offsets.push_back(data.size());
+        txs.emplace_back(deserialize, reader);
+    }
+    vtx = MakeTransactionRefs(std::move(txs), data, offsets);
+}
+
 /** Precompute sighash midstate to avoid quadratic hashing */
 struct PrecomputedTransactionData {
+    /**
+     * Number of inputs between two checkpoints of the legacy signature hash
+     * serialization.
+     */
+    static constexpr unsigned int LEGACY_SIGHASH_CHECKPOINT_INTERVAL{8};
+
     uint256 hashPrevouts, hashSequence, hashOutputs;
 
+    /**
+     * SIGHASH_FORKID hasher states after the version and the prevouts and
+     * sequence hashes, for the regular, SINGLE/NONE and ANYONECANPAY hash
+     * types. These 68 bytes are common to all the inputs.
+     */
+    HashWriter forkIdPrefix, forkIdPrefixNoSequence, forkIdPrefixAnyoneCanPay;
+
+    /**
+     * Legacy (non-forkid) SIGHASH_ALL hasher states after the version and the
+     * first k * LEGACY_SIGHASH_CHECKPOINT_INTERVAL blanked inputs, for k >= 1.
+     * Hashing input nIn can resume from any checkpoint that does not cover it.
+     * Shared so that the per input script checks copy the cache cheaply.
+     */
+    std::shared_ptr<const std::vector<HashWriter>> legacyInputsCheckpoints;
+
     PrecomputedTransactionData()
         : hashPrevouts(), hashSequence(), hashOutputs() {}
 
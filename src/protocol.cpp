@@ -56,6 +56,10 @@ const char *GETAVAADDR = "getavaaddr";
 const char *GETAVAPROOFS = "getavaproofs";
 const char *AVAPROOFS = "avaproofs";
 const char *AVAPROOFSREQ = "avaproofsreq";
+const char *SENDAUXHEADERS = "sendauxhdrs";
+const char *AUXHEADERS = "auxheaders";
+const char *SENDCOMPRESSED = "sendcompr";
+const char *COMPRESSED = "compressed";
 
 bool IsBlockLike(const std::string &strCommand) {
     return strCommand == NetMsgType::BLOCK ||
@@ -82,7 +86,8 @@ static const std::string allNetMessageTypes[] = {
     NetMsgType::CFHEADERS,   NetMsgType::GETCFCHECKPT, NetMsgType::CFCHECKPT,
     NetMsgType::AVAHELLO,    NetMsgType::AVAPOLL,      NetMsgType::AVARESPONSE,
     NetMsgType::AVAPROOF,    NetMsgType::GETAVAADDR,   NetMsgType::GETAVAPROOFS,
-    NetMsgType::AVAPROOFS,   NetMsgType::AVAPROOFSREQ,
+    NetMsgType::AVAPROOFS,   NetMsgType::AVAPROOFSREQ, NetMsgType::SENDAUXHEADERS,
+    NetMsgType::AUXHEADERS,  NetMsgType::SENDCOMPRESSED, NetMsgType::COMPRESSED,
 };
 static const std::vector<std::string>
     allNetMessageTypesVec(std::begin(allNetMessageTypes),
@@ -193,8 +198,9 @@ bool CMessageHeader::IsValidWithoutConfig(const MessageMagic &magic) const {
 
 bool CMessageHeader::IsOversized(const Config &config) const {
     // Scale the maximum accepted size with the block size for messages with
-    // block content
-    if (NetMsgType::IsBlockLike(GetCommand())) {
+    // block content, which compressed messages may wrap
+    if (NetMsgType::IsBlockLike(GetCommand()) ||
+        GetCommand() == NetMsgType::COMPRESSED) {
         return nMessageSize > 2 * config.GetMaxBlockSize();
     }
 
@@ -271,6 +277,8 @@ static std::string serviceFlagToStr(const size_t bit) {
             return "COMPACT_FILTERS";
         case NODE_AVALANCHE:
             return "AVALANCHE";
+        case NODE_P2P_COMPRESSION:
+            return "P2P_COMPRESSION";
         default:
             std::ostringstream stream;
             stream.imbue(std::locale::classic());
@@ -318,6 +318,32 @@ extern const char *AVAPROOFS;
  */
 extern const char *AVAPROOFSREQ;
 
+/**
+ * Dogecoin: the sendauxhdrs message signals support for receiving AUXHEADERS
+ * messages. It also implies that its sender would send AUXHEADERS instead of
+ * HEADERS to a peer that has signaled support by sending SENDAUXHEADERS.
+ */
+extern const char *SENDAUXHEADERS;
+/**
+ * Dogecoin: the auxheaders message carries the same headers as a headers
+ * message, but with the auxpow of merge-mined headers in a compact encoding
+ * (see CompactAuxPowHeaders).
+ */
+extern const char *AUXHEADERS;
+
+/**
+ * The sendcompr message signals that its sender accepts COMPRESSED messages.
+ * It is only sent by and to peers advertising NODE_P2P_COMPRESSION.
+ */
+extern const char *SENDCOMPRESSED;
+/**
+ * The compressed message wraps another message: its 12 byte command, its
+ * 4 byte LE payload size, then its payload compressed as the next flushed
+ * block of the zstd stream of the connection (see P2PCompressor). It is only
+ * sent to peers that have sent SENDCOMPRESSED.
+ */
+extern const char *COMPRESSED;
+
 /**
  * Indicate if the message is used to transmit the content of a block.
  * These messages can be significantly larger than usual messages and therefore
@@ -378,6 +404,11 @@ enum ServiceFlags : uint64_t {
     // NODE_AVALANCHE means the node supports Bitcoin Cash's avalanche
     // preconsensus mechanism.
     NODE_AVALANCHE = (1 << 24),
+
+    // NODE_P2P_COMPRESSION means the node can exchange zstd compressed
+    // messages, which it does with the peers advertising it too after
+    // negotiating it with SENDCOMPRESSED.
+    NODE_P2P_COMPRESSION = (1 << 25),
 };
 
 /**
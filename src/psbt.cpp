@@ -186,7 +186,7 @@ void UpdatePSBTOutput(const SigningProvider &provider,
 bool SignPSBTInput(const SigningProvider &provider,
                    PartiallySignedTransaction &psbt, int index,
                    SigHashType sighash, SignatureData *out_sigdata,
-                   bool use_dummy) {
+                   bool use_dummy, const PrecomputedTransactionData *txdata) {
     PSBTInput &input = psbt.inputs.at(index);
     const CMutableTransaction &tx = *psbt.tx;
 
@@ -211,6 +211,11 @@ bool SignPSBTInput(const SigningProvider &provider,
     if (use_dummy) {
         sig_complete = ProduceSignature(provider, DUMMY_SIGNATURE_CREATOR,
                                         utxo.scriptPubKey, sigdata);
+    } else if (txdata) {
+        MutableTransactionSignatureCreator creator(&tx, index, utxo.nValue,
+                                                   *txdata, sighash);
+        sig_complete =
+            ProduceSignature(provider, creator, utxo.scriptPubKey, sigdata);
     } else {
         MutableTransactionSignatureCreator creator(&tx, index, utxo.nValue,
                                                    sighash);
@@ -524,7 +524,8 @@ bool SignPSBTInput(const SigningProvider &provider,
                    PartiallySignedTransaction &psbt, int index,
                    SigHashType sighash = SigHashType(),
                    SignatureData *out_sigdata = nullptr,
-                   bool use_dummy = false);
+                   bool use_dummy = false,
+                   const PrecomputedTransactionData *txdata = nullptr);
 
 /**
  * Updates a PSBTOutput with information from provider.
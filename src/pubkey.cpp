@@ -224,6 +224,45 @@ bool CPubKey::VerifySchnorr(const uint256 &hash,
     return VerifySchnorr(hash, sig);
 }
 
+bool VerifySchnorrBatch(const std::vector<SchnorrSigCheck> &checks) {
+    // Enough scratch space per signature for Strauss' algorithm on the R and P
+    // points. If it falls short, libsecp256k1 splits the multiplication.
+    static constexpr size_t SCRATCH_BYTES_PER_SIG = 4096;
+
+    if (checks.empty()) {
+        return true;
+    }
+
+    std::vector<secp256k1_pubkey> pubkeys(checks.size());
+    std::vector<const secp256k1_pubkey *> pubkey_ptrs;
+    std::vector<const uint8_t *> sig_ptrs;
+    std::vector<const uint8_t *> msg_ptrs;
+    pubkey_ptrs.reserve(checks.size());
+    sig_ptrs.reserve(checks.size());
+    msg_ptrs.reserve(checks.size());
+    for (size_t i = 0; i < checks.size(); ++i) {
+        const CPubKey &pubkey = checks[i].pubkey;
+        if (!pubkey.IsValid() ||
+            !secp256k1_ec_pubkey_parse(secp256k1_context_verify, &pubkeys[i],
+                                       pubkey.data(), pubkey.size())) {
+            return false;
+        }
+        pubkey_ptrs.push_back(&pubkeys[i]);
+        sig_ptrs.push_back(checks[i].sig.data());
+        msg_ptrs.push_back(checks[i].hash.begin());
+    }
+
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(
+        secp256k1_context_verify, SCRATCH_BYTES_PER_SIG * checks.size());
+    const int ret = secp256k1_schnorr_verify_batch(
+        secp256k1_context_verify, scratch, sig_ptrs.data(), msg_ptrs.data(),
+        pubkey_ptrs.data(), checks.size());
+    if (scratch) {
+        secp256k1_scratch_space_destroy(secp256k1_context_verify, scratch);
+    }
+    return ret;
+}
+
 bool CPubKey::RecoverCompact(const uint256 &hash,
                              const std::vector<uint8_t> &vchSig) {
     if (vchSig.size() != COMPACT_SIGNATURE_SIZE) {
@@ -13,6 +13,7 @@
 
 #include <boost/range/adaptor/sliced.hpp>
 
+#include <array>
 #include <stdexcept>
 #include <vector>
 
@@ -190,6 +191,26 @@ public:
                 const ChainCode &cc) const;
 };
 
+/**
+ * A Schnorr signature whose verification has been deferred, so it can be
+ * verified together with others in a batch.
+ */
+struct SchnorrSigCheck {
+    uint256 hash;
+    std::array<uint8_t, CPubKey::SCHNORR_SIZE> sig;
+    CPubKey pubkey;
+};
+
+/**
+ * Verify a batch of Schnorr signatures at once, which is faster than verifying
+ * them one by one. If the batch fails, there is no indication of which
+ * signature is invalid.
+ */
+bool VerifySchnorrBatch(const std::vector<SchnorrSigCheck> &checks);
+
+/** Number of Schnorr signatures worth verifying together in a batch */
+static constexpr size_t SCHNORR_BATCH_SIZE{64};
+
 struct CExtPubKey {
     uint8_t nDepth;
     uint8_t vchFingerprint[4];
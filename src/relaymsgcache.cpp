@@ -0,0 +1,50 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <relaymsgcache.h>
+
+std::shared_ptr<const CSerializedNetMsg>
+RelayMsgCache::GetOrMake(const CInv &inv, std::chrono::seconds now,
+                         const std::function<CSerializedNetMsg()> &make) {
+    if (auto msg = Get(inv, now)) {
+        return msg;
+    }
+
+    auto msg = std::make_shared<const CSerializedNetMsg>(make());
+    const size_t size = msg->data.size();
+    if (size > m_max_bytes) {
+        return msg;
+    }
+
+    LOCK(m_mutex);
+    // Another thread may have made the same message in the meantime.
+    const auto [it, inserted] = m_entries.emplace(inv, msg);
+    if (!inserted) {
+        return it->second;
+    }
+    m_insertion_order.emplace_back(now, inv);
+    m_total_bytes += size;
+    Trim(now);
+    return msg;
+}
+
+std::shared_ptr<const CSerializedNetMsg>
+RelayMsgCache::Get(const CInv &inv, std::chrono::seconds now) {
+    LOCK(m_mutex);
+    Trim(now);
+    const auto it = m_entries.find(inv);
+    return it != m_entries.end() ? it->second : nullptr;
+}
+
+void RelayMsgCache::Trim(std::chrono::seconds now) {
+    AssertLockHeld(m_mutex);
+    while (!m_insertion_order.empty() &&
+           (m_total_bytes > m_max_bytes ||
+            m_insertion_order.front().first + m_expiry <= now)) {
+        const auto it = m_entries.find(m_insertion_order.front().second);
+        m_total_bytes -= it->second->data.size();
+        m_entries.erase(it);
+        m_insertion_order.pop_front();
+    }
+}
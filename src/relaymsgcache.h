@@ -0,0 +1,81 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RELAYMSGCACHE_H
+#define BITCOIN_RELAYMSGCACHE_H
+
+#include <net.h>
+#include <protocol.h>
+#include <sync.h>
+#include <util/time.h>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+
+/** How long a serialized message is kept in the relay message cache. */
+static constexpr auto RELAY_MSG_CACHE_EXPIRY{30s};
+/** The maximum total payload size of the relay message cache. */
+static constexpr size_t MAX_RELAY_MSG_CACHE_BYTES{32 * 1000 * 1000};
+
+/**
+ * A short-lived cache of serialized TX, BLOCK and CMPCTBLOCK messages.
+ *
+ * When a block or a transaction is requested by many peers in a short period
+ * of time, it is only serialized for the first one. The other peers get the
+ * same message, the payload of which is then shared by their send queues.
+ * Entries expire in insertion order, after `RELAY_MSG_CACHE_EXPIRY` or once
+ * the cache is full.
+ */
+class RelayMsgCache {
+public:
+    explicit RelayMsgCache(
+        std::chrono::seconds expiry = RELAY_MSG_CACHE_EXPIRY,
+        size_t max_bytes = MAX_RELAY_MSG_CACHE_BYTES)
+        : m_expiry(expiry), m_max_bytes(max_bytes) {}
+
+    /**
+     * Get the cached message for an inventory, or make it and cache it.
+     * `make` is called without holding the cache lock.
+     */
+    std::shared_ptr<const CSerializedNetMsg>
+    GetOrMake(const CInv &inv, std::chrono::seconds now,
+              const std::function<CSerializedNetMsg()> &make)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Get the cached message for an inventory, or nullptr. */
+    std::shared_ptr<const CSerializedNetMsg> Get(const CInv &inv,
+                                                 std::chrono::seconds now)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    size_t Size() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        return WITH_LOCK(m_mutex, return m_entries.size());
+    }
+
+    size_t TotalBytes() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        return WITH_LOCK(m_mutex, return m_total_bytes);
+    }
+
+private:
+    /** Drop the expired entries, and the oldest ones above the limit. */
+    void Trim(std::chrono::seconds now) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    const std::chrono::seconds m_expiry;
+    const size_t m_max_bytes;
+
+    mutable Mutex m_mutex;
+    std::map<CInv, std::shared_ptr<const CSerializedNetMsg>>
+        m_entries GUARDED_BY(m_mutex);
+    /** The entries in insertion order, along with their insertion time. */
+    std::deque<std::pair<std::chrono::seconds, CInv>>
+        m_insertion_order GUARDED_BY(m_mutex);
+    /** The total payload size of the entries. */
+    size_t m_total_bytes GUARDED_BY(m_mutex){0};
+};
+
+#endif // BITCOIN_RELAYMSGCACHE_H
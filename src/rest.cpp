@@ -5,35 +5,60 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <coins.h>
 #include <config.h>
 #include <core_io.h>
+#include <crypto/common.h>
 #include <httpserver.h>
 #include <index/txindex.h>
+#include <logging.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
+#include <node/miner.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
 #include <rpc/mempool.h>
+#include <rpc/mining.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <streams.h>
 #include <sync.h>
+#include <timedata.h>
+#include <txdb.h>
 #include <txmempool.h>
 #include <util/any.h>
+#include <util/metrics.h>
 #include <validation.h>
 #include <version.h>
 
 #include <univalue.h>
 
+#include <algorithm>
 #include <any>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
+using node::BlockAssembler;
+using node::CBlockTemplate;
 using node::GetTransaction;
 using node::NodeContext;
+using node::UpdateTime;
 
 // Allow a max of 15 outpoints to be queried at once.
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15;
+// Allow a max of 1000 blocks to be fetched at once by /rest/blocks/.
+static const int32_t MAX_REST_BLOCKS_COUNT = 1000;
+// Allow a max of 100000 outpoints to be queried at once by
+// /rest/getutxosbatch.
+static const size_t MAX_GETUTXOS_BATCH_OUTPOINTS = 100000;
+// The streamed replies are sent in chunks of at least 64KiB, and the blocks
+// are not read ahead of more than 16MiB waiting to be sent.
+static const size_t REST_STREAM_CHUNK_SIZE = 64 * 1024;
+static const size_t REST_BLOCKS_MAX_BACKLOG = 16 * 1024 * 1024;
 
 enum class RetFormat {
     UNDEF,
@@ -296,7 +321,6 @@ static bool rest_block(const Config &config, const std::any &context,
 
     const BlockHash hash(rawHash);
 
-    CBlock block;
     const CBlockIndex *pblockindex = nullptr;
     const CBlockIndex *tip = nullptr;
     ChainstateManager *maybe_chainman = GetChainman(context, req);
@@ -317,32 +341,38 @@ static bool rest_block(const Config &config, const std::any &context,
                            hashStr + " not available (pruned data)");
         }
     }
-    if (!chainman.m_blockman.ReadBlockFromDisk(block, *pblockindex)) {
-        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
-    }
 
     switch (rf) {
         case RetFormat::BINARY: {
-            CDataStream ssBlock(SER_NETWORK,
-                                PROTOCOL_VERSION | RPCSerializationFlags());
-            ssBlock << block;
-            std::string binaryBlock = ssBlock.str();
+            // The block as stored is also its serialization for the wire.
+            std::vector<uint8_t> block_data;
+            if (!chainman.m_blockman.ReadRawBlockFromDisk(block_data,
+                                                          *pblockindex)) {
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+            }
+            std::string binaryBlock(block_data.begin(), block_data.end());
             req->WriteHeader("Content-Type", "application/octet-stream");
             req->WriteReply(HTTP_OK, binaryBlock);
             return true;
         }
 
         case RetFormat::HEX: {
-            CDataStream ssBlock(SER_NETWORK,
-                                PROTOCOL_VERSION | RPCSerializationFlags());
-            ssBlock << block;
-            std::string strHex = HexStr(ssBlock) + "\n";
+            std::vector<uint8_t> block_data;
+            if (!chainman.m_blockman.ReadRawBlockFromDisk(block_data,
+                                                          *pblockindex)) {
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+            }
+            std::string strHex = HexStr(block_data) + "\n";
             req->WriteHeader("Content-Type", "text/plain");
             req->WriteReply(HTTP_OK, strHex);
             return true;
         }
 
         case RetFormat::JSON: {
+            CBlock block;
+            if (!chainman.m_blockman.ReadBlockFromDisk(block, *pblockindex)) {
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+            }
             UniValue objBlock = blockToJSON(chainman.m_blockman, block, tip,
                                             pblockindex, showTxDetails);
             std::string strJSON = objBlock.write() + "\n";
@@ -371,6 +401,128 @@ static bool rest_block_notxdetails(Config &config, const std::any &context,
     return rest_block(config, context, req, strURIPart, false);
 }
 
+/**
+ * Append the size of data as 4 bytes little endian, then data itself, so that
+ * the client can split the stream without deserializing the blocks.
+ */
+static void AppendSizedData(std::string &out,
+                            const std::vector<uint8_t> &data) {
+    uint8_t size[4];
+    WriteLE32(size, data.size());
+    out.append(reinterpret_cast<const char *>(size), sizeof(size));
+    out.append(data.begin(), data.end());
+}
+
+static bool rest_blocks(const Config &config, const std::any &context,
+                        HTTPRequest *req, const std::string &strURIPart,
+                        bool with_undo) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (rf != RetFormat::BINARY) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: bin)");
+    }
+
+    const std::vector<std::string> path = SplitString(param, '/');
+    int32_t start_height;
+    int32_t count;
+    if (path.size() != 2 || !ParseInt32(path[0], &start_height) ||
+        start_height < 0 || !ParseInt32(path[1], &count)) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Invalid range. Use "
+                       "/rest/blocks/<start_height>/<count>.bin.");
+    }
+    if (count < 1 || count > MAX_REST_BLOCKS_COUNT) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Block count out of range: " + SanitizeString(path[1]));
+    }
+
+    ChainstateManager *maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) {
+        return false;
+    }
+    ChainstateManager &chainman = *maybe_chainman;
+
+    // Only the index entries are collected up front, the blocks are read one
+    // at a time while the reply is being sent.
+    std::vector<const CBlockIndex *> blocks;
+    {
+        LOCK(cs_main);
+        const CChain &active_chain = chainman.ActiveChain();
+        if (start_height > active_chain.Height()) {
+            return RESTERR(req, HTTP_NOT_FOUND, "Block height out of range");
+        }
+        const int32_t end_height{
+            std::min(active_chain.Height(), start_height + (count - 1))};
+        blocks.reserve(end_height - start_height + 1);
+        for (int32_t height = start_height; height <= end_height; ++height) {
+            const CBlockIndex *pindex = active_chain[height];
+            if (chainman.m_blockman.IsBlockPruned(pindex)) {
+                return RESTERR(req, HTTP_NOT_FOUND,
+                               pindex->GetBlockHash().GetHex() +
+                                   " not available (pruned data)");
+            }
+            blocks.push_back(pindex);
+        }
+    }
+
+    req->WriteHeader("Content-Type", "application/octet-stream");
+    req->WriteReplyStart(HTTP_OK);
+    std::string chunk;
+    std::vector<uint8_t> data;
+    for (const CBlockIndex *pindex : blocks) {
+        // The status can no longer be changed, so a failure truncates the
+        // reply, which the client notices from the sizes.
+        if (!chainman.m_blockman.ReadRawBlockFromDisk(data, *pindex)) {
+            LogPrintf("REST: failed to read block %s, truncating the reply\n",
+                      pindex->GetBlockHash().GetHex());
+            break;
+        }
+        AppendSizedData(chunk, data);
+        if (with_undo) {
+            // The genesis block has no undo data.
+            data.clear();
+            if (pindex->pprev &&
+                !chainman.m_blockman.ReadRawUndoFromDisk(data, *pindex)) {
+                LogPrintf("REST: failed to read the undo data of block %s, "
+                          "truncating the reply\n",
+                          pindex->GetBlockHash().GetHex());
+                break;
+            }
+            AppendSizedData(chunk, data);
+        }
+        if (chunk.size() >= REST_STREAM_CHUNK_SIZE) {
+            req->WriteReplyChunk(std::move(chunk));
+            chunk.clear();
+            // Don't read further than the client is able to follow.
+            if (!req->WaitReplyBacklog(REST_BLOCKS_MAX_BACKLOG)) {
+                break;
+            }
+        }
+    }
+    if (!chunk.empty()) {
+        req->WriteReplyChunk(std::move(chunk));
+    }
+    req->WriteReplyEnd();
+    return true;
+}
+
+static bool rest_blocks_with_undo(Config &config, const std::any &context,
+                                  HTTPRequest *req,
+                                  const std::string &strURIPart) {
+    return rest_blocks(config, context, req, strURIPart, true);
+}
+
+static bool rest_blocks_no_undo(Config &config, const std::any &context,
+                                HTTPRequest *req,
+                                const std::string &strURIPart) {
+    return rest_blocks(config, context, req, strURIPart, false);
+}
+
 static bool rest_chaininfo(Config &config, const std::any &context,
                            HTTPRequest *req, const std::string &strURIPart) {
     if (!CheckWarmup(req)) {
@@ -760,6 +912,135 @@ static bool rest_getutxos(Config &config, const std::any &context,
     }
 }
 
+static bool rest_getutxos_batch(Config &config, const std::any &context,
+                                HTTPRequest *req,
+                                const std::string &strURIPart) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (rf != RetFormat::BINARY || !param.empty()) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: bin)");
+    }
+
+    bool check_mempool;
+    std::vector<COutPoint> outpoints;
+    try {
+        CDataStream ss(MakeByteSpan(req->ReadBody()), SER_NETWORK,
+                       PROTOCOL_VERSION);
+        ss >> check_mempool >> outpoints;
+    } catch (const std::ios_base::failure &) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+    }
+    if (outpoints.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    }
+    if (outpoints.size() > MAX_GETUTXOS_BATCH_OUTPOINTS) {
+        return RESTERR(
+            req, HTTP_BAD_REQUEST,
+            strprintf("Error: max outpoints exceeded (max: %d, tried: %d)",
+                      MAX_GETUTXOS_BATCH_OUTPOINTS, outpoints.size()));
+    }
+
+    ChainstateManager *maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) {
+        return false;
+    }
+    ChainstateManager &chainman = *maybe_chainman;
+    const CTxMemPool *mempool = nullptr;
+    if (check_mempool) {
+        mempool = GetMemPool(context, req);
+        if (!mempool) {
+            return false;
+        }
+    }
+
+    // The mempool and the coins cache are looked up under the locks, and the
+    // remaining coins are read without them from a snapshot of the database
+    // taken at the same time.
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    std::vector<size_t> db_lookups;
+    std::unique_ptr<CCoinsViewDBSnapshot> db_snapshot;
+    int active_height;
+    BlockHash active_hash;
+    auto lookup_cached = [&](const CTxMemPool *pool)
+                             EXCLUSIVE_LOCKS_REQUIRED(chainman.GetMutex()) {
+        const CCoinsViewCache &cache = chainman.ActiveChainstate().CoinsTip();
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            const COutPoint &outpoint = outpoints[i];
+            if (pool) {
+                // As in CCoinsViewMemPool, the mempool entries come first.
+                if (pool->isSpent(outpoint)) {
+                    continue;
+                }
+                if (CTransactionRef ptx = pool->get(outpoint.GetTxId())) {
+                    if (outpoint.GetN() < ptx->vout.size()) {
+                        coins[i].emplace(ptx->vout[outpoint.GetN()],
+                                         MEMPOOL_HEIGHT, false);
+                    }
+                    continue;
+                }
+            }
+            if (const Coin *coin = cache.PeekCoinInCache(outpoint)) {
+                if (!coin->IsSpent()) {
+                    coins[i] = *coin;
+                }
+                continue;
+            }
+            db_lookups.push_back(i);
+        }
+        if (!db_lookups.empty()) {
+            db_snapshot = chainman.ActiveChainstate().CoinsDB().GetSnapshot();
+        }
+        active_height = chainman.ActiveHeight();
+        active_hash = chainman.ActiveTip()->GetBlockHash();
+    };
+    if (mempool) {
+        LOCK2(cs_main, mempool->cs);
+        lookup_cached(mempool);
+    } else {
+        LOCK(cs_main);
+        lookup_cached(nullptr);
+    }
+
+    // Read in key order, which is friendlier to the database.
+    std::sort(db_lookups.begin(), db_lookups.end(), [&](size_t a, size_t b) {
+        return CCoinsViewDB::KeyLess(outpoints[a], outpoints[b]);
+    });
+    for (const size_t i : db_lookups) {
+        Coin coin;
+        if (db_snapshot->GetCoin(outpoints[i], coin)) {
+            coins[i] = std::move(coin);
+        }
+    }
+    db_snapshot.reset();
+
+    // The chain height and tip, then for each outpoint in the order of the
+    // request, whether it is unspent followed by the coin if so.
+    CDataStream reply(SER_NETWORK, PROTOCOL_VERSION);
+    reply << active_height << active_hash;
+    req->WriteHeader("Content-Type", "application/octet-stream");
+    req->WriteReplyStart(HTTP_OK);
+    for (std::optional<Coin> &coin : coins) {
+        reply << bool(coin);
+        if (coin) {
+            reply << CCoin(std::move(*coin));
+        }
+        if (reply.size() >= REST_STREAM_CHUNK_SIZE) {
+            req->WriteReplyChunk(reply.str());
+            reply.clear();
+        }
+    }
+    if (!reply.empty()) {
+        req->WriteReplyChunk(reply.str());
+    }
+    req->WriteReplyEnd();
+    return true;
+}
+
 static bool rest_blockhash_by_height(Config &config, const std::any &context,
                                      HTTPRequest *req,
                                      const std::string &str_uri_part) {
@@ -818,6 +1099,90 @@ static bool rest_blockhash_by_height(Config &config, const std::any &context,
     }
 }
 
+static bool rest_blocktemplate(Config &config, const std::any &context,
+                               HTTPRequest *req,
+                               const std::string &strURIPart) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (rf != RetFormat::BINARY && rf != RetFormat::HEX) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: .bin, .hex)");
+    }
+
+    NodeContext *node = GetNodeContext(context, req);
+    if (!node) {
+        return false;
+    }
+    ChainstateManager *maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) {
+        return false;
+    }
+    ChainstateManager &chainman = *maybe_chainman;
+    const CTxMemPool *mempool = GetMemPool(context, req);
+    if (!mempool) {
+        return false;
+    }
+
+    const CBlockIndex *tip{nullptr};
+    {
+        LOCK(cs_main);
+        if (chainman.ActiveChainstate().IsInitialBlockDownload()) {
+            return RESTERR(req, HTTP_SERVICE_UNAVAILABLE,
+                           "Node is in initial block download");
+        }
+        tip = chainman.ActiveTip();
+    }
+
+    // Use the template kept ready in the background if there is one
+    std::shared_ptr<const CBlockTemplate> prebuilt;
+    unsigned int transactions_updated{0};
+    if (node->template_builder) {
+        prebuilt = node->template_builder->Get(tip->GetBlockHash(),
+                                               transactions_updated);
+    }
+    if (!prebuilt) {
+        try {
+            prebuilt = BlockAssembler{config, chainman.ActiveChainstate(),
+                                      mempool, node->avalanche.get()}
+                           .CreateNewBlock(CScript() << OP_TRUE);
+        } catch (const std::runtime_error &e) {
+            return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, e.what());
+        }
+        if (!prebuilt) {
+            return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Out of memory");
+        }
+    }
+
+    std::vector<uint8_t> encoded;
+    {
+        LOCK(cs_main);
+        const CBlockIndex *prev{chainman.m_blockman.LookupBlockIndex(
+            prebuilt->block.hashPrevBlock)};
+        if (!prev) {
+            return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR,
+                           "Block template parent not found");
+        }
+        CBlockTemplate block_template{*prebuilt};
+        UpdateTime(&block_template.block, config.GetChainParams(), prev,
+                   TicksSinceEpoch<std::chrono::seconds>(GetAdjustedTime()));
+        block_template.block.nNonce = 0;
+        encoded = EncodeBinaryBlockTemplate(config, block_template, *prev,
+                                            node->avalanche.get());
+    }
+
+    if (rf == RetFormat::BINARY) {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, std::string(encoded.begin(), encoded.end()));
+        return true;
+    }
+    req->WriteHeader("Content-Type", "text/plain");
+    req->WriteReply(HTTP_OK, HexStr(encoded) + "\n");
+    return true;
+}
+
 static const struct {
     const char *prefix;
     bool (*handler)(Config &config, const std::any &context, HTTPRequest *req,
@@ -826,12 +1191,16 @@ static const struct {
     {"/rest/tx/", rest_tx},
     {"/rest/block/notxdetails/", rest_block_notxdetails},
     {"/rest/block/", rest_block_extended},
+    {"/rest/blocks/undo/", rest_blocks_with_undo},
+    {"/rest/blocks/", rest_blocks_no_undo},
     {"/rest/chaininfo", rest_chaininfo},
     {"/rest/mempool/info", rest_mempool_info},
     {"/rest/mempool/contents", rest_mempool_contents},
     {"/rest/headers/", rest_headers},
+    {"/rest/getutxosbatch", rest_getutxos_batch},
     {"/rest/getutxos", rest_getutxos},
     {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+    {"/rest/blocktemplate", rest_blocktemplate},
 };
 
 void StartREST(const std::any &context) {
@@ -851,3 +1220,21 @@ void StopREST() {
         UnregisterHTTPHandler(up.prefix, false);
     }
 }
+
+static bool http_metrics(Config &config, HTTPRequest *req,
+                         const std::string &strURIPart) {
+    if (req->GetRequestMethod() != HTTPRequest::GET) {
+        return RESTERR(req, HTTP_BAD_METHOD, "Only GET is supported");
+    }
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+    req->WriteReply(HTTP_OK, metrics::FormatPrometheus("doged_"));
+    return true;
+}
+
+void StartHTTPMetrics() {
+    RegisterHTTPHandler("/metrics", true, http_metrics);
+}
+
+void StopHTTPMetrics() {
+    UnregisterHTTPHandler("/metrics", true);
+}
@@ -23,6 +23,7 @@
 #include <rpc/server_util.h>
 #include <rpc/util.h>
 #include <util/strencodings.h>
+#include <util/time.h>
 #include <util/translation.h>
 
 #include <univalue.h>
@@ -705,6 +706,30 @@ static RPCHelpMan getavalancheinfo() {
                      {RPCResult::Type::NUM, "pending_node_count",
                       "The number of avalanche nodes pending for a proof."},
                  }},
+                {RPCResult::Type::OBJ,
+                 "polling",
+                 "",
+                 {
+                     {RPCResult::Type::NUM, "polls_sent",
+                      "The number of polls sent since startup."},
+                     {RPCResult::Type::NUM, "responses_received",
+                      "The number of poll responses received since startup."},
+                     {RPCResult::Type::NUM, "polls_timed_out",
+                      "The number of polls that timed out since startup."},
+                     {RPCResult::Type::NUM, "inflight_polls",
+                      "The number of polls awaiting a response."},
+                     {RPCResult::Type::NUM, "pending_items",
+                      "The number of items being polled."},
+                     {RPCResult::Type::NUM, "average_response_time",
+                      "The smoothed time the nodes take to respond to a poll, "
+                      "in milliseconds."},
+                     {RPCResult::Type::NUM, "query_timeout",
+                      "The time after which a poll sent now times out, in "
+                      "milliseconds."},
+                     {RPCResult::Type::NUM, "max_polls_per_tick",
+                      "The maximum number of polls sent at once when there "
+                      "are more items to poll than a single poll can carry."},
+                 }},
             },
         },
         RPCExamples{HelpExampleCli("getavalancheinfo", "") +
@@ -819,6 +844,23 @@ static RPCHelpMan getavalancheinfo() {
                 ret.pushKV("network", network);
             });
 
+            const avalanche::Processor::PollingStats stats =
+                avalanche.getPollingStats();
+            UniValue polling(UniValue::VOBJ);
+            polling.pushKV("polls_sent", stats.pollsSent);
+            polling.pushKV("responses_received", stats.responsesReceived);
+            polling.pushKV("polls_timed_out", stats.pollsTimedOut);
+            polling.pushKV("inflight_polls", uint64_t(stats.inflightQueries));
+            polling.pushKV("pending_items", uint64_t(stats.pendingItems));
+            polling.pushKV("average_response_time",
+                           count_microseconds(stats.averageResponseTime) /
+                               1000.0);
+            polling.pushKV("query_timeout",
+                           count_milliseconds(stats.queryTimeout));
+            polling.pushKV("max_polls_per_tick",
+                           uint64_t(stats.maxPollsPerTick));
+            ret.pushKV("polling", polling);
+
             return ret;
         },
     };
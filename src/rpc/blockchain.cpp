@@ -18,6 +18,7 @@
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <kernel/coinstats.h>
 #include <logging/timer.h>
 #include <net.h>
 #include <net_processing.h>
@@ -25,17 +26,20 @@
 #include <node/coinstats.h>
 #include <node/context.h>
 #include <node/utxo_snapshot.h>
+#include <pow/powcache.h>
 #include <primitives/transaction.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
+#include <script/scriptcache.h>
 #include <streams.h>
 #include <txdb.h>
 #include <txmempool.h>
 #include <undo.h>
 #include <util/check.h>
 #include <util/fs.h>
+#include <util/hasher.h>
 #include <util/strencodings.h>
 #include <util/translation.h>
 #include <validation.h>
@@ -44,11 +48,18 @@
 
 #include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <list>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <unordered_map>
 
 using kernel::CCoinsStats;
+using kernel::COINS_SCAN_SHARDS;
 using kernel::CoinStatsHashType;
+using kernel::ComputeUTXOStats;
+using kernel::ScanCoinsSharded;
 
 using node::BlockManager;
 using node::GetUTXOStats;
@@ -162,6 +173,50 @@ UniValue blockheaderToJSON(const CBlockIndex *tip,
     return result;
 }
 
+/** Call fn with the detailed JSON of every transaction in the block. */
+static void
+BlockTxsToJSON(BlockManager &blockman, const CBlock &block,
+               const CBlockIndex *blockindex,
+               const std::function<void(UniValue &&objTx)> &fn) {
+    CBlockUndo blockUndo;
+    const bool is_not_pruned{
+        WITH_LOCK(::cs_main, return !blockman.IsBlockPruned(blockindex))};
+    const bool have_undo{is_not_pruned &&
+                         blockman.UndoReadFromDisk(blockUndo, *blockindex)};
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransactionRef &tx = block.vtx.at(i);
+        // coinbase transaction (i == 0) doesn't have undo data
+        const CTxUndo *txundo =
+            (have_undo && i) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
+        UniValue objTx(UniValue::VOBJ);
+        TxToUniv(*tx, BlockHash(), objTx, true, RPCSerializationFlags(),
+                 txundo);
+        fn(std::move(objTx));
+    }
+}
+
+/** Stream the blockToJSON result with the transaction details. */
+static void blockToJSONStream(JSONRPCReplyStream &stream,
+                              BlockManager &blockman, const CBlock &block,
+                              const CBlockIndex *tip,
+                              const CBlockIndex *blockindex) {
+    const UniValue header = blockheaderToJSON(tip, blockindex);
+
+    stream.BeginObject();
+    for (size_t i = 0; i < header.size(); ++i) {
+        stream.Key(header.getKeys()[i]);
+        stream.Value(header[i]);
+    }
+    stream.Key("size");
+    stream.Value((int)::GetSerializeSize(block, PROTOCOL_VERSION));
+    stream.Key("tx");
+    stream.BeginArray();
+    BlockTxsToJSON(blockman, block, blockindex,
+                   [&](UniValue &&objTx) { stream.Value(objTx); });
+    stream.EndArray();
+    stream.EndObject();
+}
+
 UniValue blockToJSON(BlockManager &blockman, const CBlock &block,
                      const CBlockIndex *tip, const CBlockIndex *blockindex,
                      bool txDetails) {
@@ -170,21 +225,9 @@ UniValue blockToJSON(BlockManager &blockman, const CBlock &block,
     result.pushKV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
     UniValue txs(UniValue::VARR);
     if (txDetails) {
-        CBlockUndo blockUndo;
-        const bool is_not_pruned{
-            WITH_LOCK(::cs_main, return !blockman.IsBlockPruned(blockindex))};
-        const bool have_undo{is_not_pruned &&
-                             blockman.UndoReadFromDisk(blockUndo, *blockindex)};
-        for (size_t i = 0; i < block.vtx.size(); ++i) {
-            const CTransactionRef &tx = block.vtx.at(i);
-            // coinbase transaction (i == 0) doesn't have undo data
-            const CTxUndo *txundo =
-                (have_undo && i) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
-            UniValue objTx(UniValue::VOBJ);
-            TxToUniv(*tx, BlockHash(), objTx, true, RPCSerializationFlags(),
-                     txundo);
-            txs.push_back(objTx);
-        }
+        BlockTxsToJSON(blockman, block, blockindex, [&](UniValue &&objTx) {
+            txs.push_back(std::move(objTx));
+        });
     } else {
         for (const CTransactionRef &tx : block.vtx) {
             txs.push_back(tx->GetId().GetHex());
@@ -207,8 +250,7 @@ static RPCHelpMan getblockcount() {
         [&](const RPCHelpMan &self, const Config &config,
             const JSONRPCRequest &request) -> UniValue {
             ChainstateManager &chainman = EnsureAnyChainman(request.context);
-            LOCK(cs_main);
-            return chainman.ActiveHeight();
+            return chainman.GetActiveChainSnapshot()->Height();
         },
     };
 }
@@ -225,8 +267,10 @@ static RPCHelpMan getbestblockhash() {
         [&](const RPCHelpMan &self, const Config &config,
             const JSONRPCRequest &request) -> UniValue {
             ChainstateManager &chainman = EnsureAnyChainman(request.context);
-            LOCK(cs_main);
-            return chainman.ActiveTip()->GetBlockHash().GetHex();
+            return chainman.GetActiveChainSnapshot()
+                ->Tip()
+                ->GetBlockHash()
+                .GetHex();
         },
     };
 }
@@ -456,6 +500,75 @@ static RPCHelpMan getdifficulty() {
     };
 }
 
+static RPCHelpMan getpowcacheinfo() {
+    return RPCHelpMan{
+        "getpowcacheinfo",
+        "Returns statistics about the proof-of-work cache.\n",
+        {},
+        RPCResult{RPCResult::Type::OBJ,
+                  "",
+                  "",
+                  {
+                      {RPCResult::Type::NUM, "hits",
+                       "Number of PoW checks answered by the cache"},
+                      {RPCResult::Type::NUM, "misses",
+                       "Number of PoW checks that required hashing"},
+                      {RPCResult::Type::NUM, "max_elements",
+                       "Maximum number of entries held by the cache"},
+                      {RPCResult::Type::NUM, "size_bytes",
+                       "Memory allocated for the cache"},
+                  }},
+        RPCExamples{HelpExampleCli("getpowcacheinfo", "") +
+                    HelpExampleRpc("getpowcacheinfo", "")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const PowCacheStats stats = GetPowCacheStats();
+            UniValue ret(UniValue::VOBJ);
+            ret.pushKV("hits", stats.hits);
+            ret.pushKV("misses", stats.misses);
+            ret.pushKV("max_elements", uint64_t(stats.max_elements));
+            ret.pushKV("size_bytes", uint64_t(stats.size_bytes));
+            return ret;
+        },
+    };
+}
+
+static RPCHelpMan getscriptcacheinfo() {
+    return RPCHelpMan{
+        "getscriptcacheinfo",
+        "Returns statistics about the script execution cache.\n",
+        {},
+        RPCResult{RPCResult::Type::OBJ,
+                  "",
+                  "",
+                  {
+                      {RPCResult::Type::NUM, "hits",
+                       "Number of transactions whose script checks were "
+                       "answered by the cache"},
+                      {RPCResult::Type::NUM, "misses",
+                       "Number of transactions whose scripts had to be "
+                       "executed"},
+                      {RPCResult::Type::NUM, "max_elements",
+                       "Maximum number of entries held by the cache"},
+                      {RPCResult::Type::NUM, "size_bytes",
+                       "Memory allocated for the cache"},
+                  }},
+        RPCExamples{HelpExampleCli("getscriptcacheinfo", "") +
+                    HelpExampleRpc("getscriptcacheinfo", "")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const ScriptCacheStats stats =
+                WITH_LOCK(cs_main, return GetScriptCacheStats());
+            UniValue ret(UniValue::VOBJ);
+            ret.pushKV("hits", stats.hits);
+            ret.pushKV("misses", stats.misses);
+            ret.pushKV("max_elements", uint64_t(stats.max_elements));
+            ret.pushKV("size_bytes", uint64_t(stats.size_bytes));
+            return ret;
+        },
+    };
+}
+
 static RPCHelpMan getblockfrompeer() {
     return RPCHelpMan{
         "getblockfrompeer",
@@ -522,16 +635,15 @@ static RPCHelpMan getblockhash() {
         [&](const RPCHelpMan &self, const Config &config,
             const JSONRPCRequest &request) -> UniValue {
             ChainstateManager &chainman = EnsureAnyChainman(request.context);
-            LOCK(cs_main);
-            const CChain &active_chain = chainman.ActiveChain();
+            const auto active_chain = chainman.GetActiveChainSnapshot();
 
             int nHeight = request.params[0].getInt<int>();
-            if (nHeight < 0 || nHeight > active_chain.Height()) {
+            if (nHeight < 0 || nHeight > active_chain->Height()) {
                 throw JSONRPCError(RPC_INVALID_PARAMETER,
                                    "Block height out of range");
             }
 
-            const CBlockIndex *pblockindex = active_chain[nHeight];
+            const CBlockIndex *pblockindex = (*active_chain)[nHeight];
             return pblockindex->GetBlockHash().GetHex();
         },
     };
@@ -606,14 +718,11 @@ static RPCHelpMan getblockheader() {
                 fVerbose = request.params[1].get_bool();
             }
 
+            ChainstateManager &chainman = EnsureAnyChainman(request.context);
             const CBlockIndex *pblockindex;
-            const CBlockIndex *tip;
             {
-                ChainstateManager &chainman =
-                    EnsureAnyChainman(request.context);
                 LOCK(cs_main);
                 pblockindex = chainman.m_blockman.LookupBlockIndex(hash);
-                tip = chainman.ActiveTip();
 
                 if (!pblockindex) {
                     throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY,
@@ -628,7 +737,8 @@ static RPCHelpMan getblockheader() {
                 }
             }
 
-            return blockheaderToJSON(tip, pblockindex);
+            return blockheaderToJSON(chainman.GetActiveChainSnapshot()->Tip(),
+                                     pblockindex);
         },
     };
 }
@@ -655,25 +765,6 @@ static CBlock GetBlockChecked(BlockManager &blockman,
     return block;
 }
 
-static CBlockUndo GetUndoChecked(BlockManager &blockman,
-                                 const CBlockIndex *pblockindex) {
-    CBlockUndo blockUndo;
-
-    {
-        LOCK(cs_main);
-        if (blockman.IsBlockPruned(pblockindex)) {
-            throw JSONRPCError(RPC_MISC_ERROR,
-                               "Undo data not available (pruned data)");
-        }
-    }
-
-    if (!blockman.UndoReadFromDisk(blockUndo, *pblockindex)) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Can't read undo data from disk");
-    }
-
-    return blockUndo;
-}
-
 static RPCHelpMan getblock() {
     return RPCHelpMan{
         "getblock",
@@ -807,6 +898,12 @@ static RPCHelpMan getblock() {
                 return strHex;
             }
 
+            if (verbosity >= 2 && request.stream) {
+                blockToJSONStream(*request.stream, chainman.m_blockman, block,
+                                  tip, pblockindex);
+                return NullUniValue;
+            }
+
             return blockToJSON(chainman.m_blockman, block, tip, pblockindex,
                                verbosity >= 2);
         },
@@ -1927,6 +2024,271 @@ static inline bool SetHasKeys(const std::set<T> &set, const Tk &key,
 static constexpr size_t PER_UTXO_OVERHEAD =
     sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
 
+//! Maximum number of blocks for a single getblockstatsrange call
+static constexpr int MAX_BLOCK_STATS_RANGE{10000};
+
+/**
+ * Compute the statistics of a block from its data. Only the selected ones are
+ * guaranteed to be right, all of them are if the selection is empty.
+ */
+static UniValue ComputeBlockStats(const Config &config,
+                                  const ChainstateManager &chainman,
+                                  const CBlockIndex &pindex,
+                                  const CBlock &block,
+                                  const CBlockUndo &blockUndo,
+                                  const std::set<std::string> &stats) {
+    // Calculate everything if nothing selected (default)
+    const bool do_all = stats.size() == 0;
+    const bool do_mediantxsize = do_all || stats.count("mediantxsize") != 0;
+    const bool do_medianfee = do_all || stats.count("medianfee") != 0;
+    const bool do_medianfeerate =
+        do_all || stats.count("medianfeerate") != 0;
+    const bool loop_inputs =
+        do_all || do_medianfee || do_medianfeerate ||
+        SetHasKeys(stats, "utxo_size_inc", "totalfee", "avgfee", "avgfeerate",
+                   "minfee", "maxfee", "minfeerate", "maxfeerate");
+    const bool loop_outputs = do_all || loop_inputs || stats.count("total_out");
+    const bool do_calculate_size =
+        do_mediantxsize || loop_inputs ||
+        SetHasKeys(stats, "total_size", "avgtxsize", "mintxsize", "maxtxsize");
+
+    const int64_t blockMaxSize = config.GetMaxBlockSize();
+    Amount maxfee = Amount::zero();
+    Amount maxfeerate = Amount::zero();
+    Amount minfee = MAX_MONEY;
+    Amount minfeerate = MAX_MONEY;
+    Amount total_out = Amount::zero();
+    Amount totalfee = Amount::zero();
+    int64_t inputs = 0;
+    int64_t maxtxsize = 0;
+    int64_t mintxsize = blockMaxSize;
+    int64_t outputs = 0;
+    int64_t total_size = 0;
+    int64_t utxo_size_inc = 0;
+    std::vector<Amount> fee_array;
+    std::vector<Amount> feerate_array;
+    std::vector<int64_t> txsize_array;
+
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const auto &tx = block.vtx.at(i);
+        outputs += tx->vout.size();
+        Amount tx_total_out = Amount::zero();
+        if (loop_outputs) {
+            for (const CTxOut &out : tx->vout) {
+                tx_total_out += out.nValue;
+                utxo_size_inc +=
+                    GetSerializeSize(out, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+            }
+        }
+
+        if (tx->IsCoinBase()) {
+            continue;
+        }
+
+        // Don't count coinbase's fake input
+        inputs += tx->vin.size();
+        // Don't count coinbase reward
+        total_out += tx_total_out;
+
+        int64_t tx_size = 0;
+        if (do_calculate_size) {
+            tx_size = tx->GetTotalSize();
+            if (do_mediantxsize) {
+                txsize_array.push_back(tx_size);
+            }
+            maxtxsize = std::max(maxtxsize, tx_size);
+            mintxsize = std::min(mintxsize, tx_size);
+            total_size += tx_size;
+        }
+
+        if (loop_inputs) {
+            Amount tx_total_in = Amount::zero();
+            const auto &txundo = blockUndo.vtxundo.at(i - 1);
+            for (const Coin &coin : txundo.vprevout) {
+                const CTxOut &prevoutput = coin.GetTxOut();
+
+                tx_total_in += prevoutput.nValue;
+                utxo_size_inc -=
+                    GetSerializeSize(prevoutput, PROTOCOL_VERSION) +
+                    PER_UTXO_OVERHEAD;
+            }
+
+            Amount txfee = tx_total_in - tx_total_out;
+            CHECK_NONFATAL(MoneyRange(txfee));
+            if (do_medianfee) {
+                fee_array.push_back(txfee);
+            }
+            maxfee = std::max(maxfee, txfee);
+            minfee = std::min(minfee, txfee);
+            totalfee += txfee;
+
+            Amount feerate = txfee / tx_size;
+            if (do_medianfeerate) {
+                feerate_array.push_back(feerate);
+            }
+            maxfeerate = std::max(maxfeerate, feerate);
+            minfeerate = std::min(minfeerate, feerate);
+        }
+    }
+
+    UniValue ret_all(UniValue::VOBJ);
+    ret_all.pushKV("avgfee", block.vtx.size() > 1
+                                 ? (totalfee / int((block.vtx.size() - 1)))
+                                 : Amount::zero());
+    ret_all.pushKV("avgfeerate",
+                   total_size > 0 ? (totalfee / total_size) : Amount::zero());
+    ret_all.pushKV("avgtxsize", (block.vtx.size() > 1)
+                                    ? total_size / (block.vtx.size() - 1)
+                                    : 0);
+    ret_all.pushKV("blockhash", pindex.GetBlockHash().GetHex());
+    ret_all.pushKV("height", (int64_t)pindex.nHeight);
+    ret_all.pushKV("ins", inputs);
+    ret_all.pushKV("maxfee", maxfee);
+    ret_all.pushKV("maxfeerate", maxfeerate);
+    ret_all.pushKV("maxtxsize", maxtxsize);
+    ret_all.pushKV("medianfee", CalculateTruncatedMedian(fee_array));
+    ret_all.pushKV("medianfeerate", CalculateTruncatedMedian(feerate_array));
+    ret_all.pushKV("mediantime", pindex.GetMedianTimePast());
+    ret_all.pushKV("mediantxsize", CalculateTruncatedMedian(txsize_array));
+    ret_all.pushKV("minfee", minfee == MAX_MONEY ? Amount::zero() : minfee);
+    ret_all.pushKV("minfeerate",
+                   minfeerate == MAX_MONEY ? Amount::zero() : minfeerate);
+    ret_all.pushKV("mintxsize", mintxsize == blockMaxSize ? 0 : mintxsize);
+    ret_all.pushKV("outs", outputs);
+    ret_all.pushKV("subsidy",
+                   GetBlockSubsidy(pindex.nHeight, chainman.GetConsensus(),
+                                   block.hashPrevBlock));
+    ret_all.pushKV("time", pindex.GetBlockTime());
+    ret_all.pushKV("total_out", total_out);
+    ret_all.pushKV("total_size", total_size);
+    ret_all.pushKV("totalfee", totalfee);
+    ret_all.pushKV("txs", (int64_t)block.vtx.size());
+    ret_all.pushKV("utxo_increase", outputs - inputs);
+    ret_all.pushKV("utxo_size_inc", utxo_size_inc);
+
+    return ret_all;
+}
+
+/** Keep the selected statistics only, or all of them if none is selected. */
+static UniValue SelectBlockStats(const UniValue &ret_all,
+                                 const std::set<std::string> &stats) {
+    if (stats.empty()) {
+        return ret_all;
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    for (const std::string &stat : stats) {
+        const UniValue &value = ret_all[stat];
+        if (value.isNull()) {
+            throw JSONRPCError(
+                RPC_INVALID_PARAMETER,
+                strprintf("Invalid selected statistic %s", stat));
+        }
+        ret.pushKV(stat, value);
+    }
+    return ret;
+}
+
+namespace {
+/**
+ * Least recently used cache of the statistics of the blocks. They only depend
+ * on the block and its undo data, so the entries never get stale.
+ */
+class BlockStatsCache {
+private:
+    using Entry = std::pair<BlockHash, UniValue>;
+
+    Mutex m_mutex;
+    std::list<Entry> m_entries GUARDED_BY(m_mutex);
+    std::unordered_map<BlockHash, std::list<Entry>::iterator, BlockHasher>
+        m_index GUARDED_BY(m_mutex);
+
+public:
+    std::optional<UniValue> Get(const BlockHash &hash)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        LOCK(m_mutex);
+        const auto it = m_index.find(hash);
+        if (it == m_index.end()) {
+            return std::nullopt;
+        }
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return it->second->second;
+    }
+
+    void Add(const BlockHash &hash, const UniValue &stats, size_t max_entries)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        LOCK(m_mutex);
+        if (m_index.count(hash) != 0) {
+            return;
+        }
+        m_entries.emplace_front(hash, stats);
+        m_index.emplace(hash, m_entries.begin());
+        while (m_entries.size() > max_entries) {
+            m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+    }
+};
+
+BlockStatsCache g_block_stats_cache;
+} // namespace
+
+static size_t GetBlockStatsCacheSize(const JSONRPCRequest &request) {
+    const ArgsManager &args{EnsureAnyArgsman(request.context)};
+    return std::max<int64_t>(
+        0, args.GetIntArg("-blockstatscache", DEFAULT_BLOCK_STATS_CACHE_SIZE));
+}
+
+/**
+ * Get the selected statistics of a block, either from the cache or from the
+ * block data. The caller checks that the block is not pruned. All the
+ * statistics are computed when the cache is enabled, so they can be stored.
+ */
+static UniValue GetBlockStats(const Config &config,
+                              const ChainstateManager &chainman,
+                              const CBlockIndex &pindex,
+                              const std::set<std::string> &stats,
+                              size_t cache_size) {
+    if (cache_size > 0) {
+        if (const auto cached{g_block_stats_cache.Get(pindex.GetBlockHash())}) {
+            return SelectBlockStats(*cached, stats);
+        }
+    }
+
+    CBlock block;
+    if (!chainman.m_blockman.ReadBlockFromDisk(block, pindex)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    }
+    CBlockUndo blockUndo;
+    if (!chainman.m_blockman.UndoReadFromDisk(blockUndo, pindex)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Can't read undo data from disk");
+    }
+
+    if (cache_size == 0) {
+        return SelectBlockStats(
+            ComputeBlockStats(config, chainman, pindex, block, blockUndo,
+                              stats),
+            stats);
+    }
+
+    const UniValue ret_all =
+        ComputeBlockStats(config, chainman, pindex, block, blockUndo, {});
+    g_block_stats_cache.Add(pindex.GetBlockHash(), ret_all, cache_size);
+    return SelectBlockStats(ret_all, stats);
+}
+
+static std::set<std::string> ParseSelectedStats(const UniValue &param) {
+    std::set<std::string> stats;
+    if (!param.isNull()) {
+        const UniValue stats_univalue = param.get_array();
+        for (unsigned int i = 0; i < stats_univalue.size(); i++) {
+            const std::string stat = stats_univalue[i].get_str();
+            stats.insert(stat);
+        }
+    }
+    return stats;
+}
+
 static RPCHelpMan getblockstats() {
     const auto &ticker = Currency::get().ticker;
     return RPCHelpMan{
@@ -2016,175 +2378,135 @@ static RPCHelpMan getblockstats() {
             ChainstateManager &chainman = EnsureAnyChainman(request.context);
             const CBlockIndex &pindex{*CHECK_NONFATAL(
                 ParseHashOrHeight(request.params[0], chainman))};
+            const std::set<std::string> stats{
+                ParseSelectedStats(request.params[1])};
 
-            std::set<std::string> stats;
-            if (!request.params[1].isNull()) {
-                const UniValue stats_univalue = request.params[1].get_array();
-                for (unsigned int i = 0; i < stats_univalue.size(); i++) {
-                    const std::string stat = stats_univalue[i].get_str();
-                    stats.insert(stat);
+            {
+                LOCK(cs_main);
+                if (chainman.m_blockman.IsBlockPruned(&pindex)) {
+                    throw JSONRPCError(RPC_MISC_ERROR,
+                                       "Block not available (pruned data)");
                 }
             }
 
-            const CBlock &block = GetBlockChecked(chainman.m_blockman, &pindex);
-            const CBlockUndo &blockUndo =
-                GetUndoChecked(chainman.m_blockman, &pindex);
-
-            // Calculate everything if nothing selected (default)
-            const bool do_all = stats.size() == 0;
-            const bool do_mediantxsize =
-                do_all || stats.count("mediantxsize") != 0;
-            const bool do_medianfee = do_all || stats.count("medianfee") != 0;
-            const bool do_medianfeerate =
-                do_all || stats.count("medianfeerate") != 0;
-            const bool loop_inputs =
-                do_all || do_medianfee || do_medianfeerate ||
-                SetHasKeys(stats, "utxo_size_inc", "totalfee", "avgfee",
-                           "avgfeerate", "minfee", "maxfee", "minfeerate",
-                           "maxfeerate");
-            const bool loop_outputs =
-                do_all || loop_inputs || stats.count("total_out");
-            const bool do_calculate_size =
-                do_mediantxsize || loop_inputs ||
-                SetHasKeys(stats, "total_size", "avgtxsize", "mintxsize",
-                           "maxtxsize");
-
-            const int64_t blockMaxSize = config.GetMaxBlockSize();
-            Amount maxfee = Amount::zero();
-            Amount maxfeerate = Amount::zero();
-            Amount minfee = MAX_MONEY;
-            Amount minfeerate = MAX_MONEY;
-            Amount total_out = Amount::zero();
-            Amount totalfee = Amount::zero();
-            int64_t inputs = 0;
-            int64_t maxtxsize = 0;
-            int64_t mintxsize = blockMaxSize;
-            int64_t outputs = 0;
-            int64_t total_size = 0;
-            int64_t utxo_size_inc = 0;
-            std::vector<Amount> fee_array;
-            std::vector<Amount> feerate_array;
-            std::vector<int64_t> txsize_array;
-
-            for (size_t i = 0; i < block.vtx.size(); ++i) {
-                const auto &tx = block.vtx.at(i);
-                outputs += tx->vout.size();
-                Amount tx_total_out = Amount::zero();
-                if (loop_outputs) {
-                    for (const CTxOut &out : tx->vout) {
-                        tx_total_out += out.nValue;
-                        utxo_size_inc +=
-                            GetSerializeSize(out, PROTOCOL_VERSION) +
-                            PER_UTXO_OVERHEAD;
-                    }
-                }
-
-                if (tx->IsCoinBase()) {
-                    continue;
-                }
+            return GetBlockStats(config, chainman, pindex, stats,
+                                 GetBlockStatsCacheSize(request));
+        },
+    };
+}
 
-                // Don't count coinbase's fake input
-                inputs += tx->vin.size();
-                // Don't count coinbase reward
-                total_out += tx_total_out;
+static RPCHelpMan getblockstatsrange() {
+    return RPCHelpMan{
+        "getblockstatsrange",
+        "Compute the per block statistics of a range of blocks of the active "
+        "chain, as getblockstats does for a single block. The blocks are read "
+        "and processed in parallel.\n"
+        "Each statistic is returned as an array holding its value for every "
+        "block of the range, in height order. The range stops at the tip.\n"
+        "It won't work for some heights with pruning.\n",
+        {
+            {"start_height", RPCArg::Type::NUM, RPCArg::Optional::NO,
+             "The height of the first block of the range"},
+            {"count", RPCArg::Type::NUM, RPCArg::Optional::NO,
+             strprintf("The number of blocks in the range, at most %d",
+                       MAX_BLOCK_STATS_RANGE)},
+            {"stats",
+             RPCArg::Type::ARR,
+             RPCArg::DefaultHint{"all values"},
+             "Values to plot (see getblockstats)",
+             {
+                 {"height", RPCArg::Type::STR, RPCArg::Optional::OMITTED,
+                  "Selected statistic"},
+                 {"time", RPCArg::Type::STR, RPCArg::Optional::OMITTED,
+                  "Selected statistic"},
+             },
+             RPCArgOptions{.oneline_description = "stats"}},
+        },
+        RPCResult{RPCResult::Type::OBJ_DYN,
+                  "",
+                  "",
+                  {
+                      {RPCResult::Type::ARR,
+                       "stat",
+                       "The values of the statistic, one per block",
+                       {{RPCResult::Type::ELISION, "", "See getblockstats"}}},
+                  }},
+        RPCExamples{HelpExampleCli("getblockstatsrange",
+                                   R"(1000 100 '["minfeerate","avgfeerate"]')") +
+                    HelpExampleRpc("getblockstatsrange",
+                                   R"(1000, 100, ["minfeerate","avgfeerate"])")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            ChainstateManager &chainman = EnsureAnyChainman(request.context);
+            const int start_height{request.params[0].getInt<int>()};
+            const int count{request.params[1].getInt<int>()};
+            if (count < 1 || count > MAX_BLOCK_STATS_RANGE) {
+                throw JSONRPCError(
+                    RPC_INVALID_PARAMETER,
+                    strprintf("Block count must be between 1 and %d",
+                              MAX_BLOCK_STATS_RANGE));
+            }
+            const std::set<std::string> stats{
+                ParseSelectedStats(request.params[2])};
 
-                int64_t tx_size = 0;
-                if (do_calculate_size) {
-                    tx_size = tx->GetTotalSize();
-                    if (do_mediantxsize) {
-                        txsize_array.push_back(tx_size);
-                    }
-                    maxtxsize = std::max(maxtxsize, tx_size);
-                    mintxsize = std::min(mintxsize, tx_size);
-                    total_size += tx_size;
+            std::vector<const CBlockIndex *> indexes;
+            {
+                LOCK(cs_main);
+                const CChain &active_chain = chainman.ActiveChain();
+                if (start_height < 0) {
+                    throw JSONRPCError(
+                        RPC_INVALID_PARAMETER,
+                        strprintf("Target block height %d is negative",
+                                  start_height));
                 }
-
-                if (loop_inputs) {
-                    Amount tx_total_in = Amount::zero();
-                    const auto &txundo = blockUndo.vtxundo.at(i - 1);
-                    for (const Coin &coin : txundo.vprevout) {
-                        const CTxOut &prevoutput = coin.GetTxOut();
-
-                        tx_total_in += prevoutput.nValue;
-                        utxo_size_inc -=
-                            GetSerializeSize(prevoutput, PROTOCOL_VERSION) +
-                            PER_UTXO_OVERHEAD;
-                    }
-
-                    Amount txfee = tx_total_in - tx_total_out;
-                    CHECK_NONFATAL(MoneyRange(txfee));
-                    if (do_medianfee) {
-                        fee_array.push_back(txfee);
-                    }
-                    maxfee = std::max(maxfee, txfee);
-                    minfee = std::min(minfee, txfee);
-                    totalfee += txfee;
-
-                    Amount feerate = txfee / tx_size;
-                    if (do_medianfeerate) {
-                        feerate_array.push_back(feerate);
+                const int current_tip{active_chain.Height()};
+                if (start_height > current_tip) {
+                    throw JSONRPCError(
+                        RPC_INVALID_PARAMETER,
+                        strprintf("Target block height %d after current tip %d",
+                                  start_height, current_tip));
+                }
+                const int end_height{
+                    std::min(current_tip, start_height + count - 1)};
+                for (int height = start_height; height <= end_height;
+                     ++height) {
+                    const CBlockIndex *pindex{active_chain[height]};
+                    if (chainman.m_blockman.IsBlockPruned(pindex)) {
+                        throw JSONRPCError(RPC_MISC_ERROR,
+                                           "Block not available (pruned data)");
                     }
-                    maxfeerate = std::max(maxfeerate, feerate);
-                    minfeerate = std::min(minfeerate, feerate);
+                    indexes.push_back(pindex);
                 }
             }
 
-            UniValue ret_all(UniValue::VOBJ);
-            ret_all.pushKV("avgfee",
-                           block.vtx.size() > 1
-                               ? (totalfee / int((block.vtx.size() - 1)))
-                               : Amount::zero());
-            ret_all.pushKV("avgfeerate", total_size > 0
-                                             ? (totalfee / total_size)
-                                             : Amount::zero());
-            ret_all.pushKV("avgtxsize",
-                           (block.vtx.size() > 1)
-                               ? total_size / (block.vtx.size() - 1)
-                               : 0);
-            ret_all.pushKV("blockhash", pindex.GetBlockHash().GetHex());
-            ret_all.pushKV("height", (int64_t)pindex.nHeight);
-            ret_all.pushKV("ins", inputs);
-            ret_all.pushKV("maxfee", maxfee);
-            ret_all.pushKV("maxfeerate", maxfeerate);
-            ret_all.pushKV("maxtxsize", maxtxsize);
-            ret_all.pushKV("medianfee", CalculateTruncatedMedian(fee_array));
-            ret_all.pushKV("medianfeerate",
-                           CalculateTruncatedMedian(feerate_array));
-            ret_all.pushKV("mediantime", pindex.GetMedianTimePast());
-            ret_all.pushKV("mediantxsize",
-                           CalculateTruncatedMedian(txsize_array));
-            ret_all.pushKV("minfee",
-                           minfee == MAX_MONEY ? Amount::zero() : minfee);
-            ret_all.pushKV("minfeerate", minfeerate == MAX_MONEY
-                                             ? Amount::zero()
-                                             : minfeerate);
-            ret_all.pushKV("mintxsize",
-                           mintxsize == blockMaxSize ? 0 : mintxsize);
-            ret_all.pushKV("outs", outputs);
-            ret_all.pushKV("subsidy", GetBlockSubsidy(pindex.nHeight,
-                                                      chainman.GetConsensus(),
-                                                      block.hashPrevBlock));
-            ret_all.pushKV("time", pindex.GetBlockTime());
-            ret_all.pushKV("total_out", total_out);
-            ret_all.pushKV("total_size", total_size);
-            ret_all.pushKV("totalfee", totalfee);
-            ret_all.pushKV("txs", (int64_t)block.vtx.size());
-            ret_all.pushKV("utxo_increase", outputs - inputs);
-            ret_all.pushKV("utxo_size_inc", utxo_size_inc);
-
-            if (do_all) {
-                return ret_all;
+            const size_t cache_size{GetBlockStatsCacheSize(request)};
+            std::vector<UniValue> results(indexes.size());
+            std::vector<std::exception_ptr> errors(indexes.size());
+            GetValidationThreadPool().ParallelFor(
+                indexes.size(), [&](size_t i) {
+                    try {
+                        results[i] = GetBlockStats(config, chainman,
+                                                   *indexes[i], stats,
+                                                   cache_size);
+                    } catch (...) {
+                        // The pool threads must not throw.
+                        errors[i] = std::current_exception();
+                    }
+                });
+            for (const std::exception_ptr &error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
             }
 
             UniValue ret(UniValue::VOBJ);
-            for (const std::string &stat : stats) {
-                const UniValue &value = ret_all[stat];
-                if (value.isNull()) {
-                    throw JSONRPCError(
-                        RPC_INVALID_PARAMETER,
-                        strprintf("Invalid selected statistic %s", stat));
+            for (const std::string &stat : results.front().getKeys()) {
+                UniValue values(UniValue::VARR);
+                values.reserve(results.size());
+                for (const UniValue &result : results) {
+                    values.push_back(result[stat]);
                 }
-                ret.pushKV(stat, value);
+                ret.pushKV(stat, std::move(values));
             }
             return ret;
         },
@@ -2192,38 +2514,51 @@ static RPCHelpMan getblockstats() {
 }
 
 namespace {
-//! Search for a given set of pubkey scripts
-static bool FindScriptPubKey(std::atomic<int> &scan_progress,
-                             const std::atomic<bool> &should_abort,
-                             int64_t &count, CCoinsViewCursor *cursor,
-                             const std::set<CScript> &needles,
-                             std::map<COutPoint, Coin> &out_results,
-                             std::function<void()> &interruption_point) {
+//! Search for a given set of pubkey scripts, scanning the shards of the UTXO
+//! set in parallel.
+static bool
+FindScriptPubKey(std::atomic<int> &scan_progress,
+                 const std::atomic<bool> &should_abort, int64_t &count,
+                 std::vector<std::unique_ptr<CCoinsViewCursor>> &cursors,
+                 const std::set<CScript> &needles,
+                 std::map<COutPoint, Coin> &out_results,
+                 std::function<void()> &interruption_point) {
     scan_progress = 0;
-    count = 0;
-    while (cursor->Valid()) {
-        COutPoint key;
-        Coin coin;
-        if (!cursor->GetKey(key) || !cursor->GetValue(coin)) {
-            return false;
-        }
-        if (++count % 8192 == 0) {
-            interruption_point();
-            if (should_abort) {
-                // allow to abort the scan via the abort reference
-                return false;
+    std::atomic<int64_t> scanned{0};
+    std::atomic<bool> failed{false};
+    std::atomic<size_t> shards_done{0};
+    std::vector<std::map<COutPoint, Coin>> shard_results(cursors.size());
+    ScanCoinsSharded(
+        cursors,
+        [&](size_t shard, CCoinsViewCursor &cursor) {
+            int64_t shard_count = 0;
+            while (cursor.Valid()) {
+                COutPoint key;
+                Coin coin;
+                if (!cursor.GetKey(key) || !cursor.GetValue(coin)) {
+                    failed = true;
+                    break;
+                }
+                if (++shard_count % 8192 == 0) {
+                    interruption_point();
+                    if (should_abort || failed) {
+                        // allow to abort the scan via the abort reference
+                        failed = true;
+                        break;
+                    }
+                }
+                if (needles.count(coin.GetTxOut().scriptPubKey)) {
+                    shard_results[shard].emplace(key, coin);
+                }
+                cursor.Next();
             }
-        }
-        if (count % 256 == 0) {
-            // update progress reference every 256 item
-            const TxId &txid = key.GetTxId();
-            uint32_t high = 0x100 * *txid.begin() + *(txid.begin() + 1);
-            scan_progress = int(high * 100.0 / 65536.0 + 0.5);
-        }
-        if (needles.count(coin.GetTxOut().scriptPubKey)) {
-            out_results.emplace(key, coin);
-        }
-        cursor->Next();
+            scanned += shard_count;
+            scan_progress = int(++shards_done * 100 / cursors.size());
+        },
+        [&](size_t shard) { out_results.merge(shard_results[shard]); });
+    count = scanned;
+    if (failed) {
+        return false;
     }
     scan_progress = 100;
     return true;
@@ -2434,7 +2769,7 @@ static RPCHelpMan scantxoutset() {
                 g_should_abort_scan = false;
                 g_scan_progress = 0;
                 int64_t count = 0;
-                std::unique_ptr<CCoinsViewCursor> pcursor;
+                std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
                 const CBlockIndex *tip;
                 NodeContext &node = EnsureAnyNodeContext(request.context);
                 {
@@ -2442,12 +2777,13 @@ static RPCHelpMan scantxoutset() {
                     LOCK(cs_main);
                     Chainstate &active_chainstate = chainman.ActiveChainstate();
                     active_chainstate.ForceFlushStateToDisk();
-                    pcursor = CHECK_NONFATAL(std::unique_ptr<CCoinsViewCursor>(
-                        active_chainstate.CoinsDB().Cursor()));
+                    cursors = active_chainstate.CoinsDB().ShardedCursors(
+                        COINS_SCAN_SHARDS);
+                    CHECK_NONFATAL(!cursors.empty());
                     tip = CHECK_NONFATAL(active_chainstate.m_chain.Tip());
                 }
                 bool res = FindScriptPubKey(
-                    g_scan_progress, g_should_abort_scan, count, pcursor.get(),
+                    g_scan_progress, g_should_abort_scan, count, cursors,
                     needles, coins, node.rpc_interruption_point);
                 result.pushKV("success", res);
                 result.pushKV("txouts", count);
@@ -2578,6 +2914,154 @@ static RPCHelpMan getblockfilter() {
     };
 }
 
+/** Number of filters loaded and matched at once by scanblockfilters. */
+static constexpr int SCAN_FILTERS_BATCH_SIZE{1000};
+
+static RPCHelpMan scanblockfilters() {
+    return RPCHelpMan{
+        "scanblockfilters",
+        "Return the blocks of the active chain whose BIP 157 content filter "
+        "matches any of the given scripts.\n"
+        "The filters can report false positives, so the returned blocks may "
+        "not actually involve the scripts.\n",
+        {
+            {"scripts",
+             RPCArg::Type::ARR,
+             RPCArg::Optional::NO,
+             "The scripts to look for",
+             {
+                 {"script", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED,
+                  "A hex-encoded output script"},
+             }},
+            {"start_height", RPCArg::Type::NUM, RPCArg::Default{0},
+             "The height of the first block to scan"},
+            {"stop_height", RPCArg::Type::NUM,
+             RPCArg::DefaultHint{"the chain tip"},
+             "The height of the last block to scan"},
+            {"filtertype", RPCArg::Type::STR, RPCArg::Default{"basic"},
+             "The type name of the filter"},
+        },
+        RPCResult{RPCResult::Type::OBJ,
+                  "",
+                  "",
+                  {
+                      {RPCResult::Type::NUM, "from_height",
+                       "The height of the first block scanned"},
+                      {RPCResult::Type::NUM, "to_height",
+                       "The height of the last block scanned"},
+                      {RPCResult::Type::ARR,
+                       "relevant_blocks",
+                       "The blocks whose filter matched, by increasing height",
+                       {
+                           {RPCResult::Type::OBJ,
+                            "",
+                            "",
+                            {
+                                {RPCResult::Type::NUM, "height",
+                                 "The block height"},
+                                {RPCResult::Type::STR_HEX, "hash",
+                                 "The block hash"},
+                            }},
+                       }},
+                  }},
+        RPCExamples{HelpExampleCli("scanblockfilters",
+                                   "'[\"76a914...88ac\"]' 100000") +
+                    HelpExampleRpc("scanblockfilters",
+                                   "[\"76a914...88ac\"], 100000")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            GCSFilter::ElementSet needles;
+            for (const UniValue &script :
+                 request.params[0].get_array().getValues()) {
+                const std::vector<uint8_t> bytes{ParseHexV(script, "script")};
+                if (!bytes.empty()) {
+                    needles.insert(bytes);
+                }
+            }
+
+            std::string filtertype_name = "basic";
+            if (!request.params[3].isNull()) {
+                filtertype_name = request.params[3].get_str();
+            }
+            BlockFilterType filtertype;
+            if (!BlockFilterTypeByName(filtertype_name, filtertype)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY,
+                                   "Unknown filtertype");
+            }
+            BlockFilterIndex *index = GetBlockFilterIndex(filtertype);
+            if (!index) {
+                throw JSONRPCError(RPC_MISC_ERROR,
+                                   "Index is not enabled for filtertype " +
+                                       filtertype_name);
+            }
+            if (!index->BlockUntilSyncedToCurrentChain()) {
+                throw JSONRPCError(RPC_MISC_ERROR,
+                                   "Block filters are still in the process of "
+                                   "being indexed.");
+            }
+
+            const int start_height{request.params[1].isNull()
+                                       ? 0
+                                       : request.params[1].getInt<int>()};
+            const CBlockIndex *stop_index;
+            {
+                ChainstateManager &chainman =
+                    EnsureAnyChainman(request.context);
+                LOCK(cs_main);
+                const CChain &active_chain = chainman.ActiveChain();
+                const int stop_height{request.params[2].isNull()
+                                          ? active_chain.Height()
+                                          : request.params[2].getInt<int>()};
+                if (start_height < 0 || stop_height < start_height ||
+                    stop_height > active_chain.Height()) {
+                    throw JSONRPCError(RPC_INVALID_PARAMETER,
+                                       "Invalid height range");
+                }
+                stop_index = active_chain[stop_height];
+            }
+
+            UniValue blocks(UniValue::VARR);
+            for (int batch_start = start_height;
+                 !needles.empty() && batch_start <= stop_index->nHeight;
+                 batch_start += SCAN_FILTERS_BATCH_SIZE) {
+                const CBlockIndex *batch_stop{stop_index->GetAncestor(
+                    std::min(stop_index->nHeight,
+                             batch_start + SCAN_FILTERS_BATCH_SIZE - 1))};
+                std::vector<BlockFilter> filters;
+                if (!index->LookupFilterRange(batch_start, batch_stop,
+                                              filters)) {
+                    throw JSONRPCError(RPC_INTERNAL_ERROR,
+                                       "Failed to read the block filters");
+                }
+
+                // Each filter is keyed by the hash of its block, so the
+                // scripts are hashed again for every filter and the filters
+                // are matched in parallel instead.
+                std::vector<char> matches(filters.size());
+                GetValidationThreadPool().ParallelFor(
+                    filters.size(), [&](size_t i) {
+                        matches[i] = filters[i].GetFilter().MatchAny(needles);
+                    });
+                for (size_t i = 0; i < filters.size(); ++i) {
+                    if (!matches[i]) {
+                        continue;
+                    }
+                    UniValue block(UniValue::VOBJ);
+                    block.pushKV("height", batch_start + int(i));
+                    block.pushKV("hash", filters[i].GetBlockHash().GetHex());
+                    blocks.push_back(std::move(block));
+                }
+            }
+
+            UniValue ret(UniValue::VOBJ);
+            ret.pushKV("from_height", start_height);
+            ret.pushKV("to_height", stop_index->nHeight);
+            ret.pushKV("relevant_blocks", std::move(blocks));
+            return ret;
+        },
+    };
+}
+
 /**
  * Serialize the UTXO set to a file for loading elsewhere.
  *
@@ -2645,20 +3129,20 @@ static RPCHelpMan dumptxoutset() {
 UniValue CreateUTXOSnapshot(NodeContext &node, Chainstate &chainstate,
                             AutoFile &afile, const fs::path &path,
                             const fs::path &temppath) {
-    std::unique_ptr<CCoinsViewCursor> pcursor;
-    std::optional<CCoinsStats> maybe_stats;
+    std::vector<std::unique_ptr<CCoinsViewCursor>> stats_cursors;
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
     const CBlockIndex *tip;
 
     {
         // We need to lock cs_main to ensure that the coinsdb isn't
         // written to between (i) flushing coins cache to disk
-        // (coinsdb), (ii) getting stats based upon the coinsdb, and
-        // (iii) constructing a cursor to the coinsdb for use below this
-        // block.
+        // (coinsdb) and (ii) constructing the cursors to the coinsdb used
+        // for the stats and the dump below this block.
         //
-        // Cursors returned by leveldb iterate over snapshots, so the
-        // contents of the pcursor will not be affected by simultaneous
-        // writes during use below this block.
+        // Cursors returned by leveldb iterate over snapshots, so both sets
+        // see the same coins and are not affected by simultaneous writes
+        // during use below this block. The UTXO set is only scanned once
+        // cs_main is released.
         //
         // See discussion here:
         //   https://github.com/bitcoin/bitcoin/pull/15606#discussion_r274479369
@@ -2667,17 +3151,18 @@ UniValue CreateUTXOSnapshot(NodeContext &node, Chainstate &chainstate,
 
         chainstate.ForceFlushStateToDisk();
 
-        maybe_stats = GetUTXOStats(&chainstate.CoinsDB(), chainstate.m_blockman,
-                                   CoinStatsHashType::HASH_SERIALIZED,
-                                   node.rpc_interruption_point);
-        if (!maybe_stats) {
-            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
-        }
+        stats_cursors = chainstate.CoinsDB().ShardedCursors(COINS_SCAN_SHARDS);
+        cursors = chainstate.CoinsDB().ShardedCursors(COINS_SCAN_SHARDS);
+        CHECK_NONFATAL(!cursors.empty());
+        tip = CHECK_NONFATAL(chainstate.m_blockman.LookupBlockIndex(
+            chainstate.CoinsDB().GetBestBlock()));
+    }
 
-        pcursor =
-            std::unique_ptr<CCoinsViewCursor>(chainstate.CoinsDB().Cursor());
-        tip = CHECK_NONFATAL(
-            chainstate.m_blockman.LookupBlockIndex(maybe_stats->hashBlock));
+    const std::optional<CCoinsStats> maybe_stats = ComputeUTXOStats(
+        CoinStatsHashType::HASH_SERIALIZED, &chainstate.CoinsDB(), *tip,
+        std::move(stats_cursors), node.rpc_interruption_point);
+    if (!maybe_stats) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
     }
 
     LOG_TIME_SECONDS(
@@ -2690,22 +3175,33 @@ UniValue CreateUTXOSnapshot(NodeContext &node, Chainstate &chainstate,
 
     afile << metadata;
 
-    COutPoint key;
-    Coin coin;
-    unsigned int iter{0};
+    // The shards are serialized in parallel, and written in key order.
+    std::vector<CDataStream> serialized(cursors.size(),
+                                        CDataStream(SER_DISK, CLIENT_VERSION));
+    ScanCoinsSharded(
+        cursors,
+        [&](size_t shard, CCoinsViewCursor &cursor) {
+            COutPoint key;
+            Coin coin;
+            unsigned int iter{0};
 
-    while (pcursor->Valid()) {
-        if (iter % 5000 == 0) {
-            node.rpc_interruption_point();
-        }
-        ++iter;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            afile << key;
-            afile << coin;
-        }
+            while (cursor.Valid()) {
+                if (iter % 5000 == 0) {
+                    node.rpc_interruption_point();
+                }
+                ++iter;
+                if (cursor.GetKey(key) && cursor.GetValue(coin)) {
+                    serialized[shard] << key;
+                    serialized[shard] << coin;
+                }
 
-        pcursor->Next();
-    }
+                cursor.Next();
+            }
+        },
+        [&](size_t shard) {
+            afile.write(MakeByteSpan(serialized[shard]));
+            serialized[shard] = CDataStream(SER_DISK, CLIENT_VERSION);
+        });
 
     afile.fclose();
 
@@ -2734,9 +3230,12 @@ void RegisterBlockchainRPCCommands(CRPCTable &t) {
         { "blockchain",         getblockhash,                      },
         { "blockchain",         getblockheader,                    },
         { "blockchain",         getblockstats,                     },
+        { "blockchain",         getblockstatsrange,                },
         { "blockchain",         getchaintips,                      },
         { "blockchain",         getchaintxstats,                   },
         { "blockchain",         getdifficulty,                     },
+        { "blockchain",         getpowcacheinfo,                   },
+        { "blockchain",         getscriptcacheinfo,                },
         { "blockchain",         gettxout,                          },
         { "blockchain",         gettxoutsetinfo,                   },
         { "blockchain",         pruneblockchain,                   },
@@ -2744,6 +3243,7 @@ void RegisterBlockchainRPCCommands(CRPCTable &t) {
         { "blockchain",         preciousblock,                     },
         { "blockchain",         scantxoutset,                      },
         { "blockchain",         getblockfilter,                    },
+        { "blockchain",         scanblockfilters,                  },
 
         /* Not shown in help */
         { "hidden",             invalidateblock,                   },
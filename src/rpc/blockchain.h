@@ -22,6 +22,9 @@ namespace node {
 struct NodeContext;
 } // namespace node
 
+//! Default number of blocks whose statistics are kept in memory
+static constexpr int64_t DEFAULT_BLOCK_STATS_CACHE_SIZE{1000};
+
 RPCHelpMan getblockchaininfo();
 
 /**
@@ -64,6 +64,7 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"listtransactions", 3, "include_watchonly"},
     {"walletpassphrase", 1, "timeout"},
     {"getblocktemplate", 0, "template_request"},
+    {"estimatefee", 0, "nblocks"},
     {"listsinceblock", 1, "target_confirmations"},
     {"listsinceblock", 2, "include_watchonly"},
     {"listsinceblock", 3, "include_removed"},
@@ -72,6 +73,9 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"sendmany", 4, "subtractfeefrom"},
     {"deriveaddresses", 1, "range"},
     {"scantxoutset", 1, "scanobjects"},
+    {"scanblockfilters", 0, "scripts"},
+    {"scanblockfilters", 1, "start_height"},
+    {"scanblockfilters", 2, "stop_height"},
     {"addmultisigaddress", 0, "nrequired"},
     {"addmultisigaddress", 1, "keys"},
     {"createmultisig", 0, "nrequired"},
@@ -164,10 +168,14 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"verifychain", 1, "nblocks"},
     {"getblockstats", 0, "hash_or_height"},
     {"getblockstats", 1, "stats"},
+    {"getblockstatsrange", 0, "start_height"},
+    {"getblockstatsrange", 1, "count"},
+    {"getblockstatsrange", 2, "stats"},
     {"pruneblockchain", 0, "height"},
     {"keypoolrefill", 0, "newsize"},
     {"getrawmempool", 0, "verbose"},
     {"getrawmempool", 1, "mempool_sequence"},
+    {"getmempoolchanges", 0, "sequence"},
     {"prioritisetransaction", 1, "dummy"},
     {"prioritisetransaction", 2, "fee_delta"},
     {"setban", 2, "bantime"},
@@ -177,6 +185,9 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"getmempoolancestors", 1, "verbose"},
     {"getmempooldescendants", 1, "verbose"},
     {"disconnectnode", 1, "nodeid"},
+    {"getlockcontention", 0, "sites"},
+    {"setlockcontention", 0, "enable"},
+    {"setlockcontention", 1, "reset"},
     {"logging", 0, "include"},
     {"logging", 1, "exclude"},
     {"upgradewallet", 0, "version"},
@@ -392,6 +392,20 @@ static void entryToJSON(const CTxMemPool &pool, UniValue &info,
     info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetId()));
 }
 
+/** Stream the verbose MempoolToJSON result. */
+static void MempoolToJSONStream(const CTxMemPool &pool,
+                                JSONRPCReplyStream &stream) {
+    LOCK(pool.cs);
+    stream.BeginObject();
+    for (const CTxMemPoolEntryRef &e : pool.mapTx) {
+        UniValue info(UniValue::VOBJ);
+        entryToJSON(pool, info, e);
+        stream.Key(e->GetTx().GetId().ToString());
+        stream.Value(info);
+    }
+    stream.EndObject();
+}
+
 UniValue MempoolToJSON(const CTxMemPool &pool, bool verbose,
                        bool include_mempool_sequence) {
     if (verbose) {
@@ -409,7 +423,7 @@ UniValue MempoolToJSON(const CTxMemPool &pool, bool verbose,
             // Mempool has unique entries so there is no advantage in using
             // UniValue::pushKV, which checks if the key already exists in O(N).
             // UniValue::pushKVEnd is used instead which currently is O(1).
-            o.pushKVEnd(txid.ToString(), info);
+            o.pushKVEnd(txid.ToString(), std::move(info));
         }
         return o;
     } else {
@@ -496,8 +510,13 @@ static RPCHelpMan getrawmempool() {
                 include_mempool_sequence = request.params[1].get_bool();
             }
 
-            return MempoolToJSON(EnsureAnyMemPool(request.context), fVerbose,
-                                 include_mempool_sequence);
+            const CTxMemPool &mempool = EnsureAnyMemPool(request.context);
+            if (fVerbose && !include_mempool_sequence && request.stream) {
+                MempoolToJSONStream(mempool, *request.stream);
+                return NullUniValue;
+            }
+
+            return MempoolToJSON(mempool, fVerbose, include_mempool_sequence);
         },
     };
 }
@@ -565,7 +584,8 @@ static RPCHelpMan getmempoolancestors() {
                     const TxId &_txid = e->GetTx().GetId();
                     UniValue info(UniValue::VOBJ);
                     entryToJSON(mempool, info, e);
-                    o.pushKV(_txid.ToString(), info);
+                    // The entries are unique, see getrawmempool.
+                    o.pushKVEnd(_txid.ToString(), std::move(info));
                 }
                 return o;
             }
@@ -639,7 +659,8 @@ static RPCHelpMan getmempooldescendants() {
                     const TxId &_txid = e->GetTx().GetId();
                     UniValue info(UniValue::VOBJ);
                     entryToJSON(mempool, info, e);
-                    o.pushKV(_txid.ToString(), info);
+                    // The entries are unique, see getrawmempool.
+                    o.pushKVEnd(_txid.ToString(), std::move(info));
                 }
                 return o;
             }
@@ -737,6 +758,95 @@ static RPCHelpMan getmempoolinfo() {
     };
 }
 
+static RPCHelpMan getmempoolchanges() {
+    return RPCHelpMan{
+        "getmempoolchanges",
+        "Returns the transactions added to and removed from the mempool "
+        "since a given mempool sequence number, oldest first.\n"
+        "\nHint: use getrawmempool with mempool_sequence=true to get a "
+        "starting point. Only the last -mempooljournalsize changes are kept, "
+        "and the call fails if some of the requested ones are gone.\n",
+        {
+            {"sequence", RPCArg::Type::NUM, RPCArg::Optional::NO,
+             "The sequence number of the first change to return"},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ,
+            "",
+            "",
+            {
+                {RPCResult::Type::ARR,
+                 "changes",
+                 "",
+                 {
+                     {RPCResult::Type::OBJ,
+                      "",
+                      "",
+                      {
+                          {RPCResult::Type::NUM, "sequence",
+                           "The mempool sequence number of the change"},
+                          {RPCResult::Type::STR, "type",
+                           "Either \"added\" or \"removed\""},
+                          {RPCResult::Type::STR_HEX, "txid",
+                           "The transaction id"},
+                          {RPCResult::Type::STR, "reason", /*optional=*/true,
+                           "Why the transaction was removed (expiry, "
+                           "sizelimit, reorg, block, conflict, avalanche)"},
+                      }},
+                 }},
+                {RPCResult::Type::NUM, "mempool_sequence",
+                 "The sequence number of the next change"},
+            }},
+        RPCExamples{HelpExampleCli("getmempoolchanges", "1000") +
+                    HelpExampleRpc("getmempoolchanges", "1000")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const CTxMemPool &mempool = EnsureAnyMemPool(request.context);
+            const int64_t from{request.params[0].getInt<int64_t>()};
+            if (from < 0) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER,
+                                   "Sequence number must be non-negative");
+            }
+
+            std::optional<std::vector<MempoolChange>> changes;
+            uint64_t mempool_sequence;
+            {
+                LOCK(mempool.cs);
+                changes = mempool.GetChangesSince(from);
+                mempool_sequence = mempool.GetSequence();
+            }
+            if (!changes) {
+                throw JSONRPCError(
+                    RPC_MISC_ERROR,
+                    strprintf("Changes since sequence %d are no longer "
+                              "available, getrawmempool has to be called again",
+                              from));
+            }
+
+            UniValue changes_json(UniValue::VARR);
+            changes_json.reserve(changes->size());
+            for (const MempoolChange &change : *changes) {
+                UniValue change_json(UniValue::VOBJ);
+                change_json.pushKV("sequence", change.sequence);
+                change_json.pushKV("type",
+                                   change.removal_reason ? "removed" : "added");
+                change_json.pushKV("txid", change.txid.GetHex());
+                if (change.removal_reason) {
+                    change_json.pushKV(
+                        "reason",
+                        RemovalReasonToString(*change.removal_reason));
+                }
+                changes_json.push_back(std::move(change_json));
+            }
+
+            UniValue ret(UniValue::VOBJ);
+            ret.pushKV("changes", std::move(changes_json));
+            ret.pushKV("mempool_sequence", mempool_sequence);
+            return ret;
+        },
+    };
+}
+
 static RPCHelpMan savemempool() {
     return RPCHelpMan{
         "savemempool",
@@ -1007,6 +1117,7 @@ void RegisterMempoolRPCCommands(CRPCTable &t) {
         {"rawtransactions", testmempoolaccept},
         {"blockchain", getmempoolancestors},
         {"blockchain", getmempooldescendants},
+        {"blockchain", getmempoolchanges},
         {"blockchain", getmempoolentry},
         {"blockchain", getmempoolinfo},
         {"blockchain", getrawmempool},
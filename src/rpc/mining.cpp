@@ -25,8 +25,10 @@
 #include <node/miner.h>
 #include <policy/block/rtt.h>
 #include <policy/block/stakingrewards.h>
+#include <policy/fees.h>
 #include <policy/policy.h>
 #include <pow/pow.h>
+#include <primitives/auxpow.h>
 #include <rpc/blockchain.h>
 #include <rpc/mining.h>
 #include <rpc/server.h>
@@ -35,6 +37,7 @@
 #include <script/descriptor.h>
 #include <script/script.h>
 #include <shutdown.h>
+#include <streams.h>
 #include <timedata.h>
 #include <txmempool.h>
 #include <univalue.h>
@@ -46,6 +49,8 @@
 #include <warnings.h>
 
 #include <cstdint>
+#include <map>
+#include <memory>
 
 using node::BlockAssembler;
 using node::CBlockTemplate;
@@ -630,6 +635,60 @@ static UniValue BIP22ValidationResult(const Config &config,
     return "valid?";
 }
 
+std::vector<uint8_t>
+EncodeBinaryBlockTemplate(const Config &config,
+                          const CBlockTemplate &block_template,
+                          const CBlockIndex &prev,
+                          const avalanche::Processor *avalanche) {
+    const Consensus::Params &consensusParams =
+        config.GetChainParams().GetConsensus();
+    const CBlock &block = block_template.block;
+
+    Amount coinbasevalue = Amount::zero();
+    for (const auto &o : block.vtx[0]->vout) {
+        coinbasevalue += o.nValue;
+    }
+
+    std::vector<CScript> minerFundScripts;
+    for (const auto &fundDestination :
+         GetMinerFundWhitelist(consensusParams)) {
+        minerFundScripts.push_back(GetScriptForDestination(fundDestination));
+    }
+    Amount minerFundMinValue = Amount::zero();
+    if (IsAxionEnabled(consensusParams, &prev)) {
+        minerFundMinValue =
+            GetMinerFundAmount(consensusParams, coinbasevalue, &prev);
+    }
+
+    // Empty when there is no staking reward to pay
+    CScript stakingRewardsPayoutScript;
+    Amount stakingRewardsMinValue = Amount::zero();
+    std::vector<CScript> stakingRewardsPayoutScripts;
+    if (avalanche && IsStakingRewardsActivated(consensusParams, &prev) &&
+        avalanche->getStakingRewardWinners(prev.GetBlockHash(),
+                                           stakingRewardsPayoutScripts)) {
+        stakingRewardsPayoutScript = stakingRewardsPayoutScripts[0];
+        stakingRewardsMinValue = GetStakingRewardsAmount(coinbasevalue);
+    }
+
+    std::vector<uint8_t> encoded;
+    CVectorWriter ss(SER_NETWORK, PROTOCOL_VERSION, encoded, 0);
+    ss << block.nVersion << block.hashPrevBlock << block.nTime << block.nBits
+       << int32_t(prev.nHeight + 1) << prev.GetMedianTimePast() + 1
+       << VersionChainId(block.nVersion) << coinbasevalue;
+    ss << minerFundScripts << minerFundMinValue;
+    ss << stakingRewardsPayoutScript << stakingRewardsMinValue;
+
+    // The coinbase is left out, the miner builds its own
+    WriteCompactSize(ss, block.vtx.size() - 1);
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        ss << *block.vtx[i] << block_template.entries[i].fees
+           << block_template.entries[i].sigChecks;
+    }
+
+    return encoded;
+}
+
 static RPCHelpMan getblocktemplate() {
     return RPCHelpMan{
         "getblocktemplate",
@@ -658,6 +717,10 @@ static RPCHelpMan getblocktemplate() {
                   RPCArg::Optional::OMITTED_NAMED_ARG,
                   "This must be set to \"template\", \"proposal\" (see BIP "
                   "23), or omitted"},
+                 {"format", RPCArg::Type::STR, /* treat as named arg */
+                  RPCArg::Optional::OMITTED_NAMED_ARG,
+                  "\"json\" (default), or \"hex\" for the compact binary "
+                  "encoding of the template, see doc/REST-interface.md"},
                  {
                      "capabilities",
                      RPCArg::Type::ARR,
@@ -680,6 +743,8 @@ static RPCHelpMan getblocktemplate() {
                       RPCResult::Type::NONE, "", ""},
             RPCResult{"If the proposal was not accepted with mode=='proposal'",
                       RPCResult::Type::STR, "", "According to BIP22"},
+            RPCResult{"If format=='hex'", RPCResult::Type::STR_HEX, "",
+                      "The binary encoding of the template"},
             RPCResult{
                 "Otherwise",
                 RPCResult::Type::OBJ,
@@ -862,6 +927,7 @@ static RPCHelpMan getblocktemplate() {
             const CChainParams &chainparams = config.GetChainParams();
 
             std::string strMode = "template";
+            bool binary_format{false};
             UniValue lpval = NullUniValue;
             std::set<std::string> setClientRules;
             Chainstate &active_chainstate = chainman.ActiveChainstate();
@@ -876,6 +942,15 @@ static RPCHelpMan getblocktemplate() {
                 } else {
                     throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid mode");
                 }
+                const UniValue &formatval = oparam.find_value("format");
+                if (formatval.isStr() && formatval.get_str() == "hex") {
+                    binary_format = true;
+                } else if (formatval.isStr() && formatval.get_str() == "json") {
+                    /* Do nothing */
+                } else if (!formatval.isNull()) {
+                    throw JSONRPCError(RPC_INVALID_PARAMETER,
+                                       "Invalid format");
+                }
                 lpval = oparam.find_value("longpollid");
 
                 if (strMode == "proposal") {
@@ -1018,9 +1093,27 @@ static RPCHelpMan getblocktemplate() {
             static CBlockIndex *pindexPrev;
             static int64_t nStart;
             static std::unique_ptr<CBlockTemplate> pblocktemplate;
-            if (pindexPrev != active_chain.Tip() ||
-                (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast &&
-                 GetTime() - nStart > 5)) {
+            // Prefer the template kept up to date in the background, if any
+            std::shared_ptr<const CBlockTemplate> prebuilt;
+            unsigned int prebuilt_transactions_updated{0};
+            if (node.template_builder) {
+                prebuilt = node.template_builder->Get(
+                    active_chain.Tip()->GetBlockHash(),
+                    prebuilt_transactions_updated);
+            }
+            if (prebuilt) {
+                if (pindexPrev != active_chain.Tip() ||
+                    prebuilt_transactions_updated != nTransactionsUpdatedLast) {
+                    pblocktemplate =
+                        std::make_unique<CBlockTemplate>(*prebuilt);
+                    nTransactionsUpdatedLast = prebuilt_transactions_updated;
+                    pindexPrev = active_chain.Tip();
+                    nStart = GetTime();
+                }
+            } else if (pindexPrev != active_chain.Tip() ||
+                       (mempool.GetTransactionsUpdated() !=
+                            nTransactionsUpdatedLast &&
+                        GetTime() - nStart > 5)) {
                 // Clear pindexPrev so future calls make a new block, despite
                 // any failures from here on
                 pindexPrev = nullptr;
@@ -1054,6 +1147,12 @@ static RPCHelpMan getblocktemplate() {
             UpdateTime(pblock, chainparams, pindexPrev, adjustedTime);
             pblock->nNonce = 0;
 
+            if (binary_format) {
+                return HexStr(EncodeBinaryBlockTemplate(
+                    config, *pblocktemplate, *pindexPrev,
+                    node.avalanche.get()));
+            }
+
             UniValue aCaps(UniValue::VARR);
             aCaps.push_back("proposal");
 
@@ -1363,18 +1462,277 @@ static RPCHelpMan submitheader() {
     };
 }
 
+/**
+ * Do not rebuild a merge-mining template for new mempool transactions more
+ * often than this many seconds, like getblocktemplate.
+ */
+static constexpr int64_t AUX_BLOCK_TEMPLATE_MIN_AGE{5};
+
+/**
+ * The blocks handed out by createauxblock, so that submitauxblock only needs
+ * their hash and the auxpow. The template for a payout script is reused until
+ * the tip changes, or the mempool does and the template is old enough.
+ */
+class AuxBlockCache {
+public:
+    std::shared_ptr<const CBlock>
+    GetOrCreate(const Config &config, Chainstate &chainstate,
+                const CTxMemPool &mempool, avalanche::Processor *avalanche,
+                const CScript &script_pub_key)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    std::shared_ptr<const CBlock> Get(const BlockHash &hash)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Template {
+        std::shared_ptr<const CBlock> block;
+        uint64_t mempool_sequence;
+        int64_t created;
+    };
+
+    Mutex m_mutex;
+    //! The tip the blocks are built on.
+    BlockHash m_tip GUARDED_BY(m_mutex);
+    //! The latest template for each payout script.
+    std::map<CScript, Template> m_templates GUARDED_BY(m_mutex);
+    //! All the blocks handed out on top of the tip, by hash.
+    std::map<BlockHash, std::shared_ptr<const CBlock>>
+        m_blocks GUARDED_BY(m_mutex);
+    //! The templates for a tip, and for all payouts, mostly share their tree.
+    MerkleTreeCache m_merkle_cache GUARDED_BY(m_mutex);
+};
+
+std::shared_ptr<const CBlock>
+AuxBlockCache::GetOrCreate(const Config &config, Chainstate &chainstate,
+                           const CTxMemPool &mempool,
+                           avalanche::Processor *avalanche,
+                           const CScript &script_pub_key) {
+    const BlockHash tip{
+        WITH_LOCK(cs_main, return chainstate.m_chain.Tip()->GetBlockHash())};
+    const uint64_t mempool_sequence{
+        WITH_LOCK(mempool.cs, return mempool.GetSequence())};
+    const int64_t now{GetTime()};
+
+    LOCK(m_mutex);
+    if (auto it = m_templates.find(script_pub_key);
+        it != m_templates.end() && it->second.block->hashPrevBlock == tip &&
+        (it->second.mempool_sequence == mempool_sequence ||
+         now - it->second.created < AUX_BLOCK_TEMPLATE_MIN_AGE)) {
+        return it->second.block;
+    }
+
+    std::unique_ptr<CBlockTemplate> block_template{
+        BlockAssembler{config, chainstate, &mempool, avalanche}.CreateNewBlock(
+            script_pub_key)};
+    if (!block_template) {
+        throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
+    }
+    auto block = std::make_shared<CBlock>(block_template->block);
+    block->nVersion = VersionWithAuxPow(block->nVersion, true);
+    block->hashMerkleRoot = m_merkle_cache.BlockMerkleRoot(*block);
+
+    if (block->hashPrevBlock != m_tip) {
+        // The blocks built on the previous tip are stale.
+        m_tip = block->hashPrevBlock;
+        m_templates.clear();
+        m_blocks.clear();
+    }
+    m_blocks.emplace(block->GetHash(), block);
+    m_templates.insert_or_assign(script_pub_key,
+                                 Template{block, mempool_sequence, now});
+    return block;
+}
+
+std::shared_ptr<const CBlock> AuxBlockCache::Get(const BlockHash &hash) {
+    LOCK(m_mutex);
+    auto it = m_blocks.find(hash);
+    return it != m_blocks.end() ? it->second : nullptr;
+}
+
+static AuxBlockCache g_aux_block_cache;
+
+static RPCHelpMan createauxblock() {
+    return RPCHelpMan{
+        "createauxblock",
+        "Create a new block paying to the given address and return the data "
+        "needed to merge-mine it.\n"
+        "The block is kept by the node, see submitauxblock.\n",
+        {
+            {"address", RPCArg::Type::STR, RPCArg::Optional::NO,
+             "The address to send the newly generated coins to."},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ,
+            "",
+            "",
+            {
+                {RPCResult::Type::STR_HEX, "hash",
+                 "hash of the block, to commit to in the parent coinbase"},
+                {RPCResult::Type::NUM, "chainid", "the auxpow chain ID"},
+                {RPCResult::Type::STR_HEX, "previousblockhash",
+                 "hash of the previous block"},
+                {RPCResult::Type::NUM, "coinbasevalue",
+                 "value of the block's coinbase, in satoshis"},
+                {RPCResult::Type::STR_HEX, "bits",
+                 "compressed target of the block"},
+                {RPCResult::Type::NUM, "height", "height of the block"},
+                {RPCResult::Type::STR_HEX, "_target",
+                 "target of the block, in little-endian byte order"},
+            }},
+        RPCExamples{HelpExampleCli("createauxblock", "\"myaddress\"") +
+                    HelpExampleRpc("createauxblock", "\"myaddress\"")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const CChainParams &chainparams = config.GetChainParams();
+            const CTxDestination destination =
+                DecodeDestination(request.params[0].get_str(), chainparams);
+            if (!IsValidDestination(destination)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY,
+                                   "Error: Invalid address");
+            }
+
+            NodeContext &node = EnsureAnyNodeContext(request.context);
+            ChainstateManager &chainman = EnsureChainman(node);
+            const CTxMemPool &mempool = EnsureMemPool(node);
+            Chainstate &active_chainstate = chainman.ActiveChainstate();
+
+            if (!chainparams.MineBlocksOnDemand()) {
+                const CConnman &connman = EnsureConnman(node);
+                if (connman.GetNodeCount(ConnectionDirection::Both) == 0) {
+                    throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED,
+                                       "Bitcoin is not connected!");
+                }
+                if (active_chainstate.IsInitialBlockDownload()) {
+                    throw JSONRPCError(
+                        RPC_CLIENT_IN_INITIAL_DOWNLOAD, PACKAGE_NAME
+                        " is in initial sync and waiting for blocks...");
+                }
+            }
+
+            const std::shared_ptr<const CBlock> block{
+                g_aux_block_cache.GetOrCreate(
+                    config, active_chainstate, mempool, node.avalanche.get(),
+                    GetScriptForDestination(destination))};
+
+            const int height{WITH_LOCK(
+                cs_main, return chainman.m_blockman
+                                    .LookupBlockIndex(block->hashPrevBlock)
+                                    ->nHeight +
+                                1)};
+            const arith_uint256 target{
+                arith_uint256().SetCompact(block->nBits)};
+
+            UniValue result(UniValue::VOBJ);
+            result.pushKV("hash", block->GetHash().GetHex());
+            result.pushKV("chainid", int64_t(VersionChainId(block->nVersion)));
+            result.pushKV("previousblockhash", block->hashPrevBlock.GetHex());
+            result.pushKV("coinbasevalue",
+                          int64_t(block->vtx[0]->GetValueOut() / SATOSHI));
+            result.pushKV("bits", strprintf("%08x", block->nBits));
+            result.pushKV("height", height);
+            result.pushKV("_target", HexStr(ArithToUint256(target)));
+            return result;
+        },
+    };
+}
+
+static RPCHelpMan submitauxblock() {
+    return RPCHelpMan{
+        "submitauxblock",
+        "Submit a block created by createauxblock, merge-mined with the given "
+        "auxpow.\n",
+        {
+            {"hash", RPCArg::Type::STR_HEX, RPCArg::Optional::NO,
+             "the hash of the block, as returned by createauxblock"},
+            {"auxpow", RPCArg::Type::STR_HEX, RPCArg::Optional::NO,
+             "the serialized auxpow"},
+        },
+        RPCResult{RPCResult::Type::BOOL, "",
+                  "whether the block was accepted"},
+        RPCExamples{
+            HelpExampleCli("submitauxblock", "\"hash\" \"serialized auxpow\"") +
+            HelpExampleRpc("submitauxblock", "\"hash\" \"serialized auxpow\"")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const BlockHash hash{ParseHashV(request.params[0], "hash")};
+            const std::shared_ptr<const CBlock> cached_block{
+                g_aux_block_cache.Get(hash)};
+            if (!cached_block) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER,
+                                   "Block hash unknown or stale");
+            }
+
+            auto auxpow = std::make_shared<CAuxPow>();
+            try {
+                CDataStream ss(ParseHexV(request.params[1], "auxpow"),
+                               SER_NETWORK, PROTOCOL_VERSION);
+                ss >> *auxpow;
+            } catch (const std::exception &) {
+                throw JSONRPCError(RPC_DESERIALIZATION_ERROR,
+                                   "AuxPow decode failed");
+            }
+
+            auto blockptr = std::make_shared<CBlock>(*cached_block);
+            blockptr->auxpow = std::move(auxpow);
+
+            NodeContext &node = EnsureAnyNodeContext(request.context);
+            ChainstateManager &chainman = EnsureChainman(node);
+
+            bool new_block;
+            auto sc = std::make_shared<submitblock_StateCatcher>(hash);
+            RegisterSharedValidationInterface(sc);
+            const bool accepted = chainman.ProcessNewBlock(
+                blockptr, /*force_processing=*/true, /*min_pow_checked=*/true,
+                /*new_block=*/&new_block, node.avalanche.get());
+            UnregisterSharedValidationInterface(sc);
+            if (!new_block || !sc->found) {
+                return false;
+            }
+
+            // Block to make sure wallet/indexers sync before returning
+            SyncWithValidationInterfaceQueue();
+
+            return accepted && sc->state.IsValid();
+        },
+    };
+}
+
 static RPCHelpMan estimatefee() {
     return RPCHelpMan{
         "estimatefee",
         "Estimates the approximate fee per kilobyte needed for a "
-        "transaction\n",
-        {},
+        "transaction to confirm within nblocks blocks, based on how fast the "
+        "recent transactions confirmed. It is never below the fee needed to "
+        "enter the mempool.\n",
+        {
+            {"nblocks", RPCArg::Type::NUM,
+             RPCArg::Default{DEFAULT_CONFIRM_TARGET},
+             strprintf("Confirmation target in blocks (1 - %d)",
+                       MAX_CONFIRM_TARGET)},
+        },
         RPCResult{RPCResult::Type::NUM, "", "estimated fee-per-kilobyte"},
-        RPCExamples{HelpExampleCli("estimatefee", "")},
+        RPCExamples{HelpExampleCli("estimatefee", "") +
+                    HelpExampleCli("estimatefee", "2")},
         [&](const RPCHelpMan &self, const Config &config,
             const JSONRPCRequest &request) -> UniValue {
-            const CTxMemPool &mempool = EnsureAnyMemPool(request.context);
-            return mempool.estimateFee().GetFeePerK();
+            NodeContext &node = EnsureAnyNodeContext(request.context);
+            const CTxMemPool &mempool = EnsureMemPool(node);
+            const int conf_target{request.params[0].isNull()
+                                      ? DEFAULT_CONFIRM_TARGET
+                                      : request.params[0].getInt<int>()};
+            if (conf_target < 1 || conf_target > MAX_CONFIRM_TARGET) {
+                throw JSONRPCError(
+                    RPC_INVALID_PARAMETER,
+                    strprintf("Invalid nblocks, must be between 1 - %d",
+                              MAX_CONFIRM_TARGET));
+            }
+            CFeeRate feerate{mempool.estimateFee()};
+            if (node.fee_estimator) {
+                feerate = std::max(
+                    feerate, node.fee_estimator->estimateFee(conf_target));
+            }
+            return feerate.GetFeePerK();
         },
     };
 }
@@ -1390,6 +1748,8 @@ void RegisterMiningRPCCommands(CRPCTable &t) {
         {"mining",      getblocktemplate,      },
         {"mining",      submitblock,           },
         {"mining",      submitheader,          },
+        {"mining",      createauxblock,        },
+        {"mining",      submitauxblock,        },
 
         {"generating",  generatetoaddress,     },
         {"generating",  generatetodescriptor,  },
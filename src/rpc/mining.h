@@ -5,10 +5,34 @@
 #ifndef BITCOIN_RPC_MINING_H
 #define BITCOIN_RPC_MINING_H
 
+#include <cstdint>
+#include <vector>
+
+class CBlockIndex;
+class Config;
+namespace avalanche {
+class Processor;
+}
+namespace node {
+struct CBlockTemplate;
+}
+
 /**
  * Default max iterations to try in RPC generatetodescriptor,
  * generatetoaddress, and generateblock.
  */
 static const uint64_t DEFAULT_MAX_TRIES{1000000};
 
+/**
+ * The compact binary encoding of a block template, as returned by
+ * getblocktemplate with format "hex" and by the REST blocktemplate endpoint.
+ * It carries the same data as the JSON template, see doc/REST-interface.md
+ * for the layout.
+ */
+std::vector<uint8_t>
+EncodeBinaryBlockTemplate(const Config &config,
+                          const node::CBlockTemplate &block_template,
+                          const CBlockIndex &prev,
+                          const avalanche::Processor *avalanche);
+
 #endif // BITCOIN_RPC_MINING_H
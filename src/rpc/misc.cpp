@@ -21,12 +21,17 @@
 #include <rpc/util.h>
 #include <scheduler.h>
 #include <script/descriptor.h>
+#include <support/allocators/pool.h>
+#include <sync.h>
 #include <timedata.h>
 #include <util/any.h>
 #include <util/check.h>
 #include <util/message.h> // For MessageSign(), MessageVerify()
+#include <util/metrics.h>
 #include <util/strencodings.h>
+#include <util/threadaffinity.h>
 #include <util/time.h>
+#include <validationinterface.h>
 
 #include <univalue.h>
 
@@ -590,6 +595,31 @@ static RPCHelpMan getmemoryinfo() {
                          {RPCResult::Type::NUM, "chunks_free",
                           "Number unused chunks"},
                      }},
+                    {RPCResult::Type::OBJ,
+                     "hugepages",
+                     "Information about the huge pages backing the coins "
+                     "cache, the block index and the mempool",
+                     {
+                         {RPCResult::Type::BOOL, "enabled",
+                          "Whether -hugepages is set"},
+                         {RPCResult::Type::NUM, "total",
+                          "Number of bytes advised to be backed by huge "
+                          "pages"},
+                     }},
+                    {RPCResult::Type::ARR,
+                     "threadaffinity",
+                     "The threads pinned by -threadaffinity",
+                     {
+                         {RPCResult::Type::OBJ,
+                          "",
+                          "",
+                          {
+                              {RPCResult::Type::STR, "thread",
+                               "The name of the thread"},
+                              {RPCResult::Type::STR, "cpus",
+                               "The CPUs it is pinned to"},
+                          }},
+                     }},
                 }},
             RPCResult{"mode \"mallocinfo\"", RPCResult::Type::STR, "",
                       "\"<malloc version=\"1\">...\""},
@@ -604,6 +634,19 @@ static RPCHelpMan getmemoryinfo() {
             if (mode == "stats") {
                 UniValue obj(UniValue::VOBJ);
                 obj.pushKV("locked", RPCLockedMemoryInfo());
+                UniValue huge_pages(UniValue::VOBJ);
+                huge_pages.pushKV("enabled", PoolHugePagesEnabled());
+                huge_pages.pushKV("total", uint64_t(PoolHugePageBytes()));
+                obj.pushKV("hugepages", huge_pages);
+                UniValue affinities(UniValue::VARR);
+                for (const auto &[thread, cpus] :
+                     util::GetThreadAffinities()) {
+                    UniValue affinity(UniValue::VOBJ);
+                    affinity.pushKV("thread", thread);
+                    affinity.pushKV("cpus", cpus);
+                    affinities.push_back(affinity);
+                }
+                obj.pushKV("threadaffinity", affinities);
                 return obj;
             } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -621,6 +664,270 @@ static RPCHelpMan getmemoryinfo() {
     };
 }
 
+static RPCHelpMan getperfstats() {
+    return RPCHelpMan{
+        "getperfstats",
+        "Returns the performance metrics collected since the node started.\n"
+        "The durations are in microseconds.\n",
+        {},
+        RPCResult{
+            RPCResult::Type::OBJ,
+            "",
+            "",
+            {
+                {RPCResult::Type::ARR,
+                 "counters",
+                 "",
+                 {
+                     {RPCResult::Type::OBJ,
+                      "",
+                      "",
+                      {
+                          {RPCResult::Type::STR, "name", "The counter name"},
+                          {RPCResult::Type::STR, "label", /*optional=*/true,
+                           "The counter label, as name=value"},
+                          {RPCResult::Type::STR, "help",
+                           "What the counter counts"},
+                          {RPCResult::Type::NUM, "value", "The counter value"},
+                      }},
+                 }},
+                {RPCResult::Type::ARR,
+                 "histograms",
+                 "",
+                 {
+                     {RPCResult::Type::OBJ,
+                      "",
+                      "",
+                      {
+                          {RPCResult::Type::STR, "name", "The histogram name"},
+                          {RPCResult::Type::STR, "label", /*optional=*/true,
+                           "The histogram label, as name=value"},
+                          {RPCResult::Type::STR, "help",
+                           "What the histogram measures"},
+                          {RPCResult::Type::NUM, "count",
+                           "The number of values"},
+                          {RPCResult::Type::NUM, "sum",
+                           "The sum of the values"},
+                          {RPCResult::Type::NUM, "max", "The highest value"},
+                          {RPCResult::Type::NUM, "p50", "The median value"},
+                          {RPCResult::Type::NUM, "p90",
+                           "The 90th percentile of the values"},
+                          {RPCResult::Type::NUM, "p99",
+                           "The 99th percentile of the values"},
+                      }},
+                 }},
+                {RPCResult::Type::ARR,
+                 "validationqueues",
+                 "The background validation events queue of each subscriber",
+                 {
+                     {RPCResult::Type::OBJ,
+                      "",
+                      "",
+                      {
+                          {RPCResult::Type::STR, "subscriber",
+                           "The subscriber name"},
+                          {RPCResult::Type::NUM, "pending",
+                           "The number of events not yet delivered"},
+                          {RPCResult::Type::NUM, "max_pending",
+                           "The most events that were pending at once"},
+                          {RPCResult::Type::NUM, "delivered",
+                           "The number of events delivered"},
+                      }},
+                 }},
+            }},
+        RPCExamples{HelpExampleCli("getperfstats", "") +
+                    HelpExampleRpc("getperfstats", "")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            auto push_metadata = [](UniValue &obj, const std::string &name,
+                                    const std::string &help,
+                                    const metrics::Label &label) {
+                obj.pushKV("name", name);
+                if (!label.name.empty()) {
+                    obj.pushKV("label", label.name + "=" + label.value);
+                }
+                obj.pushKV("help", help);
+            };
+
+            UniValue counters(UniValue::VARR);
+            metrics::ForEachCounter([&](const std::string &name,
+                                        const std::string &help,
+                                        const metrics::Label &label,
+                                        const metrics::Counter &counter) {
+                UniValue obj(UniValue::VOBJ);
+                push_metadata(obj, name, help, label);
+                obj.pushKV("value", counter.Get());
+                counters.push_back(obj);
+            });
+
+            UniValue histograms(UniValue::VARR);
+            metrics::ForEachHistogram([&](const std::string &name,
+                                          const std::string &help,
+                                          const metrics::Label &label,
+                                          const metrics::Histogram &histogram) {
+                const metrics::Histogram::Snapshot snapshot{
+                    histogram.GetSnapshot()};
+                UniValue obj(UniValue::VOBJ);
+                push_metadata(obj, name, help, label);
+                obj.pushKV("count", snapshot.count);
+                obj.pushKV("sum", snapshot.sum);
+                obj.pushKV("max", snapshot.max);
+                obj.pushKV("p50", snapshot.Quantile(0.5));
+                obj.pushKV("p90", snapshot.Quantile(0.9));
+                obj.pushKV("p99", snapshot.Quantile(0.99));
+                histograms.push_back(obj);
+            });
+
+            UniValue queues(UniValue::VARR);
+            for (const SubscriberQueueStats &stats :
+                 GetMainSignals().GetSubscriberQueueStats()) {
+                UniValue obj(UniValue::VOBJ);
+                obj.pushKV("subscriber", stats.name);
+                obj.pushKV("pending", uint64_t(stats.pending));
+                obj.pushKV("max_pending", uint64_t(stats.max_pending));
+                obj.pushKV("delivered", stats.delivered);
+                queues.push_back(obj);
+            }
+
+            UniValue ret(UniValue::VOBJ);
+            ret.pushKV("counters", counters);
+            ret.pushKV("histograms", histograms);
+            ret.pushKV("validationqueues", queues);
+            return ret;
+        },
+    };
+}
+
+static RPCHelpMan setlockcontention() {
+    return RPCHelpMan{
+        "setlockcontention",
+        "Turn the recording of the lock contention on or off.\n",
+        {
+            {"enable", RPCArg::Type::BOOL, RPCArg::Optional::NO,
+             "Whether to record the time spent waiting for the locks"},
+            {"reset", RPCArg::Type::BOOL, RPCArg::Default{false},
+             "Whether to clear the contention recorded so far"},
+        },
+        RPCResult{RPCResult::Type::NONE, "", ""},
+        RPCExamples{HelpExampleCli("setlockcontention", "true") +
+                    HelpExampleRpc("setlockcontention", "true")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            if (!request.params[1].isNull() && request.params[1].get_bool()) {
+                ResetLockContentionStats();
+            }
+            g_profile_lock_contention = request.params[0].get_bool();
+            return NullUniValue;
+        },
+    };
+}
+
+static RPCHelpMan getlockcontention() {
+    return RPCHelpMan{
+        "getlockcontention",
+        "Returns the time spent waiting for the contended locks, by mutex "
+        "name and call site.\n"
+        "Only recorded while enabled with -profilelockcontention or "
+        "setlockcontention. The durations are in microseconds.\n",
+        {
+            {"sites", RPCArg::Type::NUM, RPCArg::Default{10},
+             "The maximum number of call sites to return for each mutex"},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ,
+            "",
+            "",
+            {
+                {RPCResult::Type::BOOL, "enabled",
+                 "Whether the lock contention is being recorded"},
+                {RPCResult::Type::ARR,
+                 "locks",
+                 "The mutexes waited for the longest in total first",
+                 {
+                     {RPCResult::Type::OBJ,
+                      "",
+                      "",
+                      {
+                          {RPCResult::Type::STR, "name",
+                           "The mutex, as named by the LOCKs"},
+                          {RPCResult::Type::NUM, "count",
+                           "The number of contended locks"},
+                          {RPCResult::Type::NUM, "total_wait",
+                           "The total time spent waiting"},
+                          {RPCResult::Type::NUM, "max_wait",
+                           "The longest wait"},
+                          {RPCResult::Type::NUM, "p50", "The median wait"},
+                          {RPCResult::Type::NUM, "p90",
+                           "The 90th percentile of the waits"},
+                          {RPCResult::Type::NUM, "p99",
+                           "The 99th percentile of the waits"},
+                          {RPCResult::Type::ARR,
+                           "sites",
+                           "The call sites that waited the longest in total "
+                           "first",
+                           {
+                               {RPCResult::Type::OBJ,
+                                "",
+                                "",
+                                {
+                                    {RPCResult::Type::STR, "location",
+                                     "The file and line of the LOCK"},
+                                    {RPCResult::Type::NUM, "count",
+                                     "The number of contended locks"},
+                                    {RPCResult::Type::NUM, "total_wait",
+                                     "The total time spent waiting"},
+                                    {RPCResult::Type::NUM, "max_wait",
+                                     "The longest wait"},
+                                }},
+                           }},
+                      }},
+                 }},
+            }},
+        RPCExamples{HelpExampleCli("getlockcontention", "") +
+                    HelpExampleRpc("getlockcontention", "")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const int max_sites{request.params[0].isNull()
+                                    ? 10
+                                    : request.params[0].getInt<int>()};
+            if (max_sites < 0) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER,
+                                   "sites must not be negative");
+            }
+
+            UniValue locks(UniValue::VARR);
+            for (const LockContentionStats &stats :
+                 GetLockContentionStats(max_sites)) {
+                UniValue sites(UniValue::VARR);
+                for (const LockContentionSite &site : stats.sites) {
+                    UniValue obj(UniValue::VOBJ);
+                    obj.pushKV("location", site.location);
+                    obj.pushKV("count", site.count);
+                    obj.pushKV("total_wait",
+                               count_microseconds(site.total_wait));
+                    obj.pushKV("max_wait", count_microseconds(site.max_wait));
+                    sites.push_back(obj);
+                }
+                UniValue obj(UniValue::VOBJ);
+                obj.pushKV("name", stats.name);
+                obj.pushKV("count", stats.count);
+                obj.pushKV("total_wait", count_microseconds(stats.total_wait));
+                obj.pushKV("max_wait", count_microseconds(stats.max_wait));
+                obj.pushKV("p50", count_microseconds(stats.wait_p50));
+                obj.pushKV("p90", count_microseconds(stats.wait_p90));
+                obj.pushKV("p99", count_microseconds(stats.wait_p99));
+                obj.pushKV("sites", sites);
+                locks.push_back(obj);
+            }
+
+            UniValue ret(UniValue::VOBJ);
+            ret.pushKV("enabled", g_profile_lock_contention.load());
+            ret.pushKV("locks", locks);
+            return ret;
+        },
+    };
+}
+
 static void EnableOrDisableLogCategories(UniValue cats, bool enable) {
     cats = cats.get_array();
     for (size_t i = 0; i < cats.size(); ++i) {
@@ -927,6 +1234,9 @@ void RegisterMiscRPCCommands(CRPCTable &t) {
         //  category            actor (function)
         //  ------------------  ----------------------
         { "control",            getmemoryinfo,           },
+        { "control",            getperfstats,            },
+        { "control",            getlockcontention,       },
+        { "control",            setlockcontention,       },
         { "control",            logging,                 },
         { "util",               validateaddress,         },
         { "util",               createmultisig,          },
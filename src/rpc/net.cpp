@@ -79,6 +79,43 @@ static RPCHelpMan ping() {
     };
 }
 
+static RPCResult ProcessTimePerMsgResult(const std::string &description) {
+    return {RPCResult::Type::OBJ_DYN,
+            "processtime_per_msg",
+            description + " aggregated by message type\n"
+                          "When a message type is not listed in this json "
+                          "object, no such message was processed.\n"
+                          "The messages of unknown types are listed under '" +
+                NET_MESSAGE_COMMAND_OTHER + "'.",
+            {{RPCResult::Type::OBJ,
+              "msg",
+              "",
+              {
+                  {RPCResult::Type::NUM, "count",
+                   "The number of messages processed"},
+                  {RPCResult::Type::NUM, "cputime",
+                   "The CPU time spent processing them, in microseconds"},
+                  {RPCResult::Type::NUM, "walltime",
+                   "The wall clock time spent processing them, in "
+                   "microseconds. The difference with cputime is mostly "
+                   "spent waiting for locks or disk reads."},
+              }}}};
+}
+
+static UniValue ProcessTimePerMsgToUniv(const mapMsgCmdProcessTime &map) {
+    UniValue ret(UniValue::VOBJ);
+    for (const auto &[msg_type, time] : map) {
+        if (time.count > 0) {
+            UniValue obj(UniValue::VOBJ);
+            obj.pushKV("count", time.count);
+            obj.pushKV("cputime", count_microseconds(time.cpu));
+            obj.pushKV("walltime", count_microseconds(time.wall));
+            ret.pushKV(msg_type, obj);
+        }
+    }
+    return ret;
+}
+
 static RPCHelpMan getpeerinfo() {
     return RPCHelpMan{
         "getpeerinfo",
@@ -206,6 +243,9 @@ static RPCHelpMan getpeerinfo() {
                        "object and all bytes received\n"
                        "of unknown message types are listed under '" +
                            NET_MESSAGE_COMMAND_OTHER + "'."}}},
+                    ProcessTimePerMsgResult(
+                        "The time spent processing the messages from this "
+                        "peer"),
                     {RPCResult::Type::NUM, "availability_score",
                      "Avalanche availability score of this node (if any)"},
                 }},
@@ -320,6 +360,9 @@ static RPCHelpMan getpeerinfo() {
                     }
                 }
                 obj.pushKV("bytesrecv_per_msg", recvPerMsgCmd);
+                obj.pushKV("processtime_per_msg",
+                           ProcessTimePerMsgToUniv(
+                               stats.mapProcessTimePerMsgCmd));
                 obj.pushKV("connection_type",
                            ConnectionTypeAsString(stats.m_conn_type));
 
@@ -650,6 +693,9 @@ static RPCHelpMan getnettotals() {
                      {RPCResult::Type::NUM, "time_left_in_cycle",
                       "Seconds left in current time cycle"},
                  }},
+                ProcessTimePerMsgResult(
+                    "The time spent processing the messages from all the "
+                    "peers"),
             }},
         RPCExamples{HelpExampleCli("getnettotals", "") +
                     HelpExampleRpc("getnettotals", "")},
@@ -677,6 +723,9 @@ static RPCHelpMan getnettotals() {
                 "time_left_in_cycle",
                 count_seconds(connman.GetMaxOutboundTimeLeftInCycle()));
             obj.pushKV("uploadtarget", outboundLimit);
+            obj.pushKV("processtime_per_msg",
+                       ProcessTimePerMsgToUniv(
+                           connman.GetProcessTimePerMsgCmd()));
             return obj;
         },
     };
@@ -13,6 +13,7 @@
 #include <util/fs_helpers.h>
 #include <util/strencodings.h>
 
+#include <cassert>
 #include <fstream>
 #include <stdexcept>
 #include <string>
@@ -55,6 +56,80 @@ std::string JSONRPCReply(const UniValue &result, const UniValue &error,
     return reply.write() + "\n";
 }
 
+void JSONRPCReplyStream::BeginElement() {
+    if (!m_started) {
+        m_started = true;
+        m_buffer = "{\"result\":";
+    }
+    if (m_after_key) {
+        m_after_key = false;
+        return;
+    }
+    if (!m_containers.empty()) {
+        if (m_containers.back()) {
+            m_buffer += ',';
+        }
+        m_containers.back() = true;
+    }
+}
+
+void JSONRPCReplyStream::EndContainer(char close) {
+    assert(!m_containers.empty() && !m_after_key);
+    m_containers.pop_back();
+    m_buffer += close;
+    Flush(false);
+}
+
+void JSONRPCReplyStream::Flush(bool force) {
+    if (m_buffer.size() >= CHUNK_SIZE || (force && !m_buffer.empty())) {
+        m_sink(std::move(m_buffer));
+        m_buffer.clear();
+    }
+}
+
+void JSONRPCReplyStream::BeginObject() {
+    BeginElement();
+    m_buffer += '{';
+    m_containers.push_back(false);
+}
+
+void JSONRPCReplyStream::EndObject() {
+    EndContainer('}');
+}
+
+void JSONRPCReplyStream::BeginArray() {
+    BeginElement();
+    m_buffer += '[';
+    m_containers.push_back(false);
+}
+
+void JSONRPCReplyStream::EndArray() {
+    EndContainer(']');
+}
+
+void JSONRPCReplyStream::Key(const std::string &key) {
+    assert(!m_containers.empty() && !m_after_key);
+    BeginElement();
+    m_buffer += UniValue(key).write();
+    m_buffer += ':';
+    m_after_key = true;
+}
+
+void JSONRPCReplyStream::Value(const UniValue &value) {
+    BeginElement();
+    m_buffer += value.write();
+    Flush(false);
+}
+
+void JSONRPCReplyStream::Finish(const UniValue &id) {
+    assert(m_started && m_containers.empty() && !m_after_key);
+    // Same layout as JSONRPCReply
+    m_buffer += ",\"error\":null,\"id\":";
+    m_buffer += id.write();
+    m_buffer += "}\n";
+    Flush(true);
+}
+
 UniValue JSONRPCError(int code, const std::string &message) {
     UniValue error(UniValue::VOBJ);
     error.pushKV("code", code);
@@ -8,7 +8,10 @@
 #include <univalue.h>
 
 #include <any>
+#include <cstddef>
+#include <functional>
 #include <string>
+#include <vector>
 
 UniValue JSONRPCRequestObj(const std::string &strMethod, const UniValue &params,
                            const UniValue &id);
@@ -27,6 +30,51 @@ void DeleteAuthCookie();
 /** Parse JSON-RPC batch reply into a vector */
 std::vector<UniValue> JSONRPCProcessBatchReply(const UniValue &in);
 
+/**
+ * Writer for the reply to a JSON-RPC request which is serialized while the
+ * result is produced, so that large results don't need to be built as a
+ * single UniValue first. The reply is handed over to the sink in chunks of
+ * about CHUNK_SIZE bytes.
+ *
+ * Once anything was written, the reply can't be turned into an error anymore,
+ * so all the checks that may fail should be done before.
+ */
+class JSONRPCReplyStream {
+public:
+    using Sink = std::function<void(std::string &&chunk)>;
+
+    static constexpr size_t CHUNK_SIZE{64 * 1024};
+
+    explicit JSONRPCReplyStream(Sink sink) : m_sink(std::move(sink)) {}
+
+    /** Whether the result is being streamed. */
+    bool IsStarted() const { return m_started; }
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    /** Write the key of the next member of the current object. */
+    void Key(const std::string &key);
+    /** Write a value, or the value of the member which key was just written. */
+    void Value(const UniValue &value);
+
+    /** Terminate the reply, after the result has been fully written. */
+    void Finish(const UniValue &id);
+
+private:
+    Sink m_sink;
+    std::string m_buffer;
+    bool m_started{false};
+    bool m_after_key{false};
+    //! For each nested object or array, whether it has any element yet.
+    std::vector<bool> m_containers;
+
+    void BeginElement();
+    void EndContainer(char close);
+    void Flush(bool force);
+};
+
 class JSONRPCRequest {
 public:
     UniValue id;
@@ -37,6 +85,9 @@ public:
     std::string authUser;
     std::string peerAddr;
     std::any context;
+    //! Set if the result can be streamed, it is then up to the handler to
+    //! use it or to return the result as usual.
+    JSONRPCReplyStream *stream{nullptr};
 
     void parse(const UniValue &valRequest);
 };
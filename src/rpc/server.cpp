@@ -18,12 +18,16 @@
 
 #include <boost/signals2/signal.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <unordered_map>
+#include <vector>
 
 using SteadyClock = std::chrono::steady_clock;
 
@@ -432,14 +436,90 @@ static UniValue JSONRPCExecOne(const Config &config, RPCServer &rpcServer,
     return rpc_result;
 }
 
+namespace {
+/** Shared by the threads executing the entries of a batch. */
+struct RPCBatchState {
+    explicit RPCBatchState(size_t size) : replies(size) {}
+
+    //! The serialized replies, in the order of the entries
+    std::vector<std::string> replies;
+    //! The next entry to be executed
+    std::atomic<size_t> next{0};
+    //! The total size of the replies so far
+    std::atomic<size_t> reply_size{0};
+
+    Mutex mutex;
+    std::condition_variable cv;
+    size_t num_done GUARDED_BY(mutex){0};
+};
+} // namespace
+
 std::string JSONRPCExecBatch(const Config &config, RPCServer &rpcServer,
-                             const JSONRPCRequest &jreq, const UniValue &vReq) {
-    UniValue ret(UniValue::VARR);
-    for (size_t i = 0; i < vReq.size(); i++) {
-        ret.push_back(JSONRPCExecOne(config, rpcServer, jreq, vReq[i]));
+                             const JSONRPCRequest &jreq, const UniValue &vReq,
+                             const RPCBatchOptions &options) {
+    const size_t size{vReq.size()};
+    // The helpers might only start after the batch is complete, so they share
+    // the ownership of the state. They don't touch the arguments unless they
+    // claim an entry, which can't happen anymore once the batch is complete.
+    auto state = std::make_shared<RPCBatchState>(size);
+    auto work = [state, size, max_reply_size = options.max_reply_size,
+                 &config, &rpcServer, &jreq, &vReq] {
+        while (true) {
+            const size_t i{state->next++};
+            if (i >= size) {
+                return;
+            }
+            std::string reply;
+            if (state->reply_size < max_reply_size) {
+                reply =
+                    JSONRPCExecOne(config, rpcServer, jreq, vReq[i]).write();
+            } else {
+                const UniValue &id{vReq[i].isObject() ? vReq[i].find_value("id")
+                                                      : NullUniValue};
+                reply = JSONRPCReplyObj(
+                            NullUniValue,
+                            JSONRPCError(RPC_OUT_OF_MEMORY,
+                                         "Batch reply size limit exceeded"),
+                            id)
+                            .write();
+            }
+            state->reply_size += reply.size();
+            state->replies[i] = std::move(reply);
+
+            LOCK(state->mutex);
+            if (++state->num_done == size) {
+                state->cv.notify_all();
+            }
+        }
+    };
+
+    if (options.executor) {
+        const size_t num_helpers{
+            std::min(options.max_helpers, size > 0 ? size - 1 : 0)};
+        for (size_t i = 0; i < num_helpers; ++i) {
+            if (!options.executor(work)) {
+                break;
+            }
+        }
+    }
+    work();
+    {
+        WAIT_LOCK(state->mutex, lock);
+        state->cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(state->mutex) {
+            return state->num_done == size;
+        });
     }
 
-    return ret.write() + "\n";
+    // Same as serializing the replies as an UniValue array
+    std::string ret{"["};
+    for (size_t i = 0; i < size; ++i) {
+        if (i > 0) {
+            ret += ',';
+        }
+        ret += state->replies[i];
+    }
+    ret += "]\n";
+    return ret;
 }
 
 /**
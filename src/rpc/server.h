@@ -244,8 +244,33 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
+
+/** Default for -rpcbatchthreads */
+static constexpr unsigned int DEFAULT_RPC_BATCH_THREADS{3};
+/** Default for -rpcbatchmaxsize, in megabytes */
+static constexpr unsigned int DEFAULT_RPC_BATCH_MAX_SIZE{256};
+
+/** How the entries of a JSON-RPC batch get executed. */
+struct RPCBatchOptions {
+    /**
+     * Run a task on another thread, returns false if the task can't be
+     * queued. The entries are only executed in order on the calling thread if
+     * this is not set.
+     */
+    std::function<bool(std::function<void()> task)> executor;
+    //! The maximum number of tasks given to the executor for one batch.
+    size_t max_helpers{0};
+    //! Once the replies reach this size, the remaining entries fail.
+    size_t max_reply_size{size_t(DEFAULT_RPC_BATCH_MAX_SIZE) << 20};
+};
+
+/**
+ * Execute the entries of a JSON-RPC batch, concurrently if an executor is
+ * provided. The replies are in the same order as the entries.
+ */
 std::string JSONRPCExecBatch(const Config &config, RPCServer &rpcServer,
-                             const JSONRPCRequest &req, const UniValue &vReq);
+                             const JSONRPCRequest &req, const UniValue &vReq,
+                             const RPCBatchOptions &options = {});
 
 /**
  * Retrieves any serialization flags requested in command line argument
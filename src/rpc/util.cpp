@@ -612,6 +612,10 @@ UniValue RPCHelpMan::HandleRequest(const Config &config,
                                                      arg_mismatch.write(4)));
     }
     const UniValue ret = m_fun(*this, config, request);
+    if (request.stream && request.stream->IsStarted()) {
+        // The result has already been sent
+        return ret;
+    }
     if (gArgs.GetBoolArg("-rpcdoccheck", DEFAULT_RPC_DOC_CHECK)) {
         UniValue mismatch{UniValue::VARR};
         for (const auto &res : m_results.m_results) {
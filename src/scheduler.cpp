@@ -5,10 +5,13 @@
 #include <scheduler.h>
 
 #include <sync.h>
+#include <tinyformat.h>
+#include <util/thread.h>
 
 #include <cassert>
 #include <chrono>
 #include <functional>
+#include <optional>
 #include <utility>
 
 CScheduler::CScheduler() {}
@@ -28,40 +31,65 @@ void CScheduler::serviceQueue() {
     // waiting or when the user's function is called.
     while (!shouldStop()) {
         try {
-            while (!shouldStop() && taskQueue.empty()) {
-                // Wait until there is something to do.
-                newTaskScheduled.wait(lock);
-            }
-
-            // Wait until either there is a new task, or until
-            // the time of the first item on the queue:
-
-            while (!shouldStop() && !taskQueue.empty()) {
-                std::chrono::steady_clock::time_point timeToWaitFor =
-                    taskQueue.begin()->first;
-                if (newTaskScheduled.wait_until(lock, timeToWaitFor) ==
-                    std::cv_status::timeout) {
-                    // Exit loop after timeout, it means we reached the time of
-                    // the event
+            // Find the first due task of the highest priority among the ones
+            // not already running, else the time of the next one.
+            const auto now = std::chrono::steady_clock::now();
+            auto task = taskQueue.end();
+            std::optional<std::chrono::steady_clock::time_point> next;
+            for (auto it = taskQueue.begin(); it != taskQueue.end(); ++it) {
+                const Priority priority = it->second.priority;
+                if (it->second.exclusive && m_running[size_t(priority)]) {
+                    continue;
+                }
+                if (it->first > now) {
+                    next = it->first;
+                    break;
+                }
+                if (task == taskQueue.end() ||
+                    priority < task->second.priority) {
+                    task = it;
+                }
+                if (priority == Priority::HIGH) {
                     break;
                 }
             }
 
-            // If there are multiple threads, the queue can empty while we're
-            // waiting (another thread may service the task we were waiting on).
-            if (shouldStop() || taskQueue.empty()) {
+            if (task == taskQueue.end()) {
+                // Wait until there is a new task, a running one is done or
+                // the time of the next one.
+                if (next) {
+                    newTaskScheduled.wait_until(lock, *next);
+                } else {
+                    newTaskScheduled.wait(lock);
+                }
                 continue;
             }
 
-            Function f = taskQueue.begin()->second;
-            taskQueue.erase(taskQueue.begin());
+            Function f = std::move(task->second.f);
+            const size_t priority = size_t(task->second.priority);
+            const bool exclusive = task->second.exclusive;
+            taskQueue.erase(task);
 
-            {
+            if (!exclusive) {
+                REVERSE_LOCK(lock);
+                f();
+                continue;
+            }
+
+            m_running[priority] = true;
+            try {
                 // Unlock before calling f, so it can reschedule itself or
                 // another task without deadlocking:
                 REVERSE_LOCK(lock);
                 f();
+            } catch (...) {
+                m_running[priority] = false;
+                throw;
             }
+            m_running[priority] = false;
+            // Another thread might be waiting for the next task of this
+            // priority.
+            newTaskScheduled.notify_all();
         } catch (...) {
             --nThreadsServicingQueue;
             throw;
@@ -71,11 +99,38 @@ void CScheduler::serviceQueue() {
     newTaskScheduled.notify_one();
 }
 
+void CScheduler::StartServiceThreads(size_t num_threads) {
+    for (size_t i = 0; i < num_threads; ++i) {
+        m_service_threads.emplace_back(
+            [this, name = i ? strprintf("scheduler.%d", i) : "scheduler"] {
+                util::TraceThread(name.c_str(), [this] { serviceQueue(); });
+            });
+    }
+}
+
+void CScheduler::JoinServiceThreads() {
+    for (std::thread &thread : m_service_threads) {
+        thread.join();
+    }
+    m_service_threads.clear();
+}
+
 void CScheduler::schedule(CScheduler::Function f,
-                          std::chrono::steady_clock::time_point t) {
+                          std::chrono::steady_clock::time_point t,
+                          Priority priority) {
+    {
+        LOCK(newTaskMutex);
+        taskQueue.emplace(t, Task{std::move(f), priority, true});
+    }
+    newTaskScheduled.notify_one();
+}
+
+void CScheduler::scheduleConcurrent(CScheduler::Function f,
+                                    std::chrono::steady_clock::time_point t,
+                                    Priority priority) {
     {
         LOCK(newTaskMutex);
-        taskQueue.insert(std::make_pair(t, f));
+        taskQueue.emplace(t, Task{std::move(f), priority, false});
     }
     newTaskScheduled.notify_one();
 }
@@ -87,7 +142,7 @@ void CScheduler::MockForward(std::chrono::seconds delta_seconds) {
         LOCK(newTaskMutex);
 
         // use temp_queue to maintain updated schedule
-        std::multimap<std::chrono::steady_clock::time_point, Function>
+        std::multimap<std::chrono::steady_clock::time_point, Task>
             temp_queue;
 
         for (const auto &element : taskQueue) {
@@ -105,15 +160,20 @@ void CScheduler::MockForward(std::chrono::seconds delta_seconds) {
 }
 
 static void Repeat(CScheduler &s, CScheduler::Predicate p,
-                   std::chrono::milliseconds delta) {
+                   std::chrono::milliseconds delta,
+                   CScheduler::Priority priority) {
     if (p()) {
-        s.scheduleFromNow([=, &s] { Repeat(s, p, delta); }, delta);
+        s.scheduleFromNow([=, &s] { Repeat(s, p, delta, priority); }, delta,
+                          priority);
     }
 }
 
 void CScheduler::scheduleEvery(CScheduler::Predicate p,
-                               std::chrono::milliseconds delta) {
-    scheduleFromNow([this, p, delta] { Repeat(*this, p, delta); }, delta);
+                               std::chrono::milliseconds delta,
+                               Priority priority) {
+    scheduleFromNow(
+        [this, p, delta, priority] { Repeat(*this, p, delta, priority); },
+        delta, priority);
 }
 
 size_t
@@ -9,6 +9,7 @@
 #include <sync.h>
 #include <threadsafety.h>
 
+#include <array>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
@@ -17,6 +18,7 @@
 #include <map>
 #include <thread>
 #include <utility>
+#include <vector>
 
 /**
  * Simple class for background tasks that should be run periodically or once
@@ -29,33 +31,56 @@
  * s->scheduleFromNow(doSomething, std::chrono::milliseconds{11});
  * s->scheduleFromNow([=] { this->func(argument); },
  *                    std::chrono::milliseconds{3});
- * std::thread *t = new std::thread([?] { s->serviceQueue(); });
+ * s->StartServiceThreads();
  *
  * ... then at program shutdown, make sure to call stop() to clean up the
- * thread(s) running serviceQueue:
+ * threads running serviceQueue:
  * s->stop();
- * t->join();
- * delete t;
  * delete s; // Must be done after thread is interrupted/joined.
+ *
+ * The tasks of a priority are run one at a time, in the order of their time,
+ * as if there was a single thread. The tasks of different priorities can run
+ * at the same time if there are enough threads servicing the queue, so the
+ * slow tasks don't delay the latency sensitive ones. Otherwise the due task of
+ * the highest priority is run first.
  */
 class CScheduler {
 public:
     CScheduler();
     ~CScheduler();
 
-    std::thread m_service_thread;
+    enum class Priority {
+        //! Latency sensitive, e.g. avalanche polling
+        HIGH,
+        NORMAL,
+        //! Can be delayed, e.g. writing files to disk
+        LOW,
+    };
+    static constexpr size_t NUM_PRIORITIES{3};
 
     typedef std::function<void()> Function;
     typedef std::function<bool()> Predicate;
 
     /** Call func at/after time t */
-    void schedule(Function f, std::chrono::steady_clock::time_point t)
+    void schedule(Function f, std::chrono::steady_clock::time_point t,
+                  Priority priority = Priority::NORMAL)
+        EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
+
+    /**
+     * Call func at/after time t, without waiting for the other tasks of its
+     * priority to be done. It can run concurrently with any task, so func is
+     * responsible for its own synchronization.
+     */
+    void scheduleConcurrent(Function f, std::chrono::steady_clock::time_point t,
+                            Priority priority = Priority::NORMAL)
         EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
 
     /** Call f once after the delta has passed */
-    void scheduleFromNow(Function f, std::chrono::milliseconds delta)
+    void scheduleFromNow(Function f, std::chrono::milliseconds delta,
+                         Priority priority = Priority::NORMAL)
         EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex) {
-        schedule(std::move(f), std::chrono::steady_clock::now() + delta);
+        schedule(std::move(f), std::chrono::steady_clock::now() + delta,
+                 priority);
     }
 
     /**
@@ -65,7 +90,8 @@ public:
      * run again after delta. If you need more accurate scheduling, don't use
      * this method.
      */
-    void scheduleEvery(Predicate p, std::chrono::milliseconds delta)
+    void scheduleEvery(Predicate p, std::chrono::milliseconds delta,
+                       Priority priority = Priority::NORMAL)
         EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
 
     /**
@@ -81,6 +107,13 @@ public:
      */
     void serviceQueue() EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
 
+    /**
+     * Start the threads servicing the queue, which are joined by stop(). With
+     * a thread per priority, a task is never delayed by the tasks of the other
+     * priorities.
+     */
+    void StartServiceThreads(size_t num_threads = NUM_PRIORITIES);
+
     /**
      * Tell any threads running serviceQueue to stop as soon as the current
      * task is done
@@ -88,9 +121,7 @@ public:
     void stop() EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex) {
         WITH_LOCK(newTaskMutex, stopRequested = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) {
-            m_service_thread.join();
-        }
+        JoinServiceThreads();
     }
 
     /**
@@ -100,9 +131,7 @@ public:
     void StopWhenDrained() EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex) {
         WITH_LOCK(newTaskMutex, stopWhenEmpty = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) {
-            m_service_thread.join();
-        }
+        JoinServiceThreads();
     }
 
     /**
@@ -118,10 +147,22 @@ public:
         EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
 
 private:
+    struct Task {
+        Function f;
+        Priority priority;
+        //! Whether the task waits for the other tasks of its priority
+        bool exclusive;
+    };
+
+    std::vector<std::thread> m_service_threads;
+    void JoinServiceThreads();
+
     mutable Mutex newTaskMutex;
     std::condition_variable newTaskScheduled;
-    std::multimap<std::chrono::steady_clock::time_point, Function>
+    std::multimap<std::chrono::steady_clock::time_point, Task>
         taskQueue GUARDED_BY(newTaskMutex);
+    //! Whether a task of the priority is running
+    std::array<bool, NUM_PRIORITIES> m_running GUARDED_BY(newTaskMutex){};
     int nThreadsServicingQueue GUARDED_BY(newTaskMutex){0};
     bool stopRequested GUARDED_BY(newTaskMutex){false};
     bool stopWhenEmpty GUARDED_BY(newTaskMutex){false};
@@ -16,6 +16,8 @@
 #include <uint256.h>
 #include <util/bitmanip.h>
 
+#include <algorithm>
+
 bool CastToBool(const valtype &vch) {
     for (size_t i = 0; i < vch.size(); i++) {
         if (vch[i] != 0) {
@@ -35,10 +37,51 @@ bool CastToBool(const valtype &vch) {
  */
 #define stacktop(i) (stack.at(stack.size() + (i)))
 #define altstacktop(i) (altstack.at(altstack.size() + (i)))
+namespace {
+/**
+ * Buffers of the elements popped off the stacks, reused by the next pushes so
+ * that pushing a signature or a pubkey doesn't allocate once the pool of the
+ * thread is warm.
+ */
+class StackElementPool {
+public:
+    //! Keep at most this many buffers, of at most this capacity.
+    static constexpr size_t MAX_BUFFERS{128};
+    static constexpr size_t MAX_BUFFER_CAPACITY{MAX_SCRIPT_ELEMENT_SIZE};
+
+    /** An empty buffer, with some capacity if one was recycled. */
+    valtype Get() {
+        if (m_buffers.empty()) {
+            return {};
+        }
+        valtype vch{std::move(m_buffers.back())};
+        m_buffers.pop_back();
+        vch.clear();
+        return vch;
+    }
+
+    void Recycle(valtype &&vch) {
+        if (m_buffers.size() < MAX_BUFFERS && vch.capacity() > 0 &&
+            vch.capacity() <= MAX_BUFFER_CAPACITY) {
+            m_buffers.push_back(std::move(vch));
+        }
+    }
+
+private:
+    std::vector<valtype> m_buffers;
+};
+
+StackElementPool &GetStackElementPool() {
+    thread_local StackElementPool pool;
+    return pool;
+}
+} // namespace
+
 static inline void popstack(std::vector<valtype> &stack) {
     if (stack.empty()) {
         throw std::runtime_error("popstack(): stack empty");
     }
+    GetStackElementPool().Recycle(std::move(stack.back()));
     stack.pop_back();
 }
 
@@ -147,6 +190,231 @@ static bool EvalChecksig(const valtype &vchSig, const valtype &vchPubKey,
     return true;
 }
 
+/**
+ * Helper for OP_CHECKMULTISIG and OP_CHECKMULTISIGVERIFY, which pops the
+ * arguments.
+ *
+ * A return value of false means the script fails entirely. When true is
+ * returned, the fSuccess variable indicates whether the signatures check
+ * succeeded.
+ */
+static bool EvalCheckMultisig(std::vector<valtype> &stack,
+                              CScript::const_iterator pbegincodehash,
+                              CScript::const_iterator pend, uint32_t flags,
+                              const BaseSignatureChecker &checker,
+                              ScriptExecutionMetrics &metrics,
+                              size_t &nOpCount, ScriptError *serror,
+                              bool &fSuccess) {
+    const bool fRequireMinimal = (flags & SCRIPT_VERIFY_MINIMALDATA) != 0;
+
+    const size_t idxKeyCount = 1;
+    if (stack.size() < idxKeyCount) {
+        return set_error(serror, ScriptError::INVALID_STACK_OPERATION);
+    }
+    const int nKeysCount =
+        CScriptNum(stacktop(-idxKeyCount), fRequireMinimal).getint();
+    if (nKeysCount < 0 || nKeysCount > MAX_PUBKEYS_PER_MULTISIG) {
+        return set_error(serror, ScriptError::PUBKEY_COUNT);
+    }
+    nOpCount += nKeysCount;
+    if (nOpCount > MAX_OPS_PER_SCRIPT) {
+        return set_error(serror, ScriptError::OP_COUNT);
+    }
+
+    // stack depth of the top pubkey
+    const size_t idxTopKey = idxKeyCount + 1;
+
+    // stack depth of nSigsCount
+    const size_t idxSigCount = idxTopKey + nKeysCount;
+    if (stack.size() < idxSigCount) {
+        return set_error(serror, ScriptError::INVALID_STACK_OPERATION);
+    }
+    const int nSigsCount =
+        CScriptNum(stacktop(-idxSigCount), fRequireMinimal).getint();
+    if (nSigsCount < 0 || nSigsCount > nKeysCount) {
+        return set_error(serror, ScriptError::SIG_COUNT);
+    }
+
+    // stack depth of the top signature
+    const size_t idxTopSig = idxSigCount + 1;
+
+    // stack depth of the dummy element
+    const size_t idxDummy = idxTopSig + nSigsCount;
+    if (stack.size() < idxDummy) {
+        return set_error(serror, ScriptError::INVALID_STACK_OPERATION);
+    }
+
+    // Subset of script starting at the most recent
+    // codeseparator
+    CScript scriptCode(pbegincodehash, pend);
+
+    // Assuming success is usually a bad idea, but the
+    // schnorr path can only succeed.
+    fSuccess = true;
+
+    if ((flags & SCRIPT_ENABLE_SCHNORR_MULTISIG) &&
+        stacktop(-idxDummy).size() != 0) {
+        // SCHNORR MULTISIG
+        static_assert(MAX_PUBKEYS_PER_MULTISIG < 32,
+                      "Schnorr multisig checkbits implementation "
+                      "assumes < 32 pubkeys.");
+        uint32_t checkBits = 0;
+
+        // Dummy element is to be interpreted as a bitfield
+        // that represent which pubkeys should be checked.
+        valtype &vchDummy = stacktop(-idxDummy);
+        if (!DecodeBitfield(vchDummy, nKeysCount, checkBits, serror)) {
+            // serror is set
+            return false;
+        }
+
+        // The bitfield doesn't set the right number of
+        // signatures.
+        if (countBits(checkBits) != uint32_t(nSigsCount)) {
+            return set_error(serror, ScriptError::INVALID_BIT_COUNT);
+        }
+
+        const size_t idxBottomKey = idxTopKey + nKeysCount - 1;
+        const size_t idxBottomSig = idxTopSig + nSigsCount - 1;
+
+        int iKey = 0;
+        for (int iSig = 0; iSig < nSigsCount; iSig++, iKey++) {
+            if ((checkBits >> iKey) == 0) {
+                // This is a sanity check and should be
+                // unreachable.
+                return set_error(serror, ScriptError::INVALID_BIT_RANGE);
+            }
+
+            // Find the next suitable key.
+            while (((checkBits >> iKey) & 0x01) == 0) {
+                iKey++;
+            }
+
+            if (iKey >= nKeysCount) {
+                // This is a sanity check and should be
+                // unreachable.
+                return set_error(serror, ScriptError::PUBKEY_COUNT);
+            }
+
+            // Check the signature.
+            valtype &vchSig = stacktop(-idxBottomSig + iSig);
+            valtype &vchPubKey = stacktop(-idxBottomKey + iKey);
+
+            // Note that only pubkeys associated with a
+            // signature are checked for validity.
+            if (!CheckTransactionSchnorrSignatureEncoding(
+                    vchSig, flags, serror) ||
+                !CheckPubKeyEncoding(vchPubKey, flags, serror)) {
+                // serror is set
+                return false;
+            }
+
+            // Check signature
+            if (!checker.CheckSig(vchSig, vchPubKey, scriptCode, flags)) {
+                // This can fail if the signature is empty,
+                // which also is a NULLFAIL error as the
+                // bitfield should have been null in this
+                // situation.
+                return set_error(serror, ScriptError::SIG_NULLFAIL);
+            }
+
+            // this is guaranteed to execute exactly
+            // nSigsCount times (if not script error)
+            metrics.nSigChecks += 1;
+        }
+
+        if ((checkBits >> iKey) != 0) {
+            // This is a sanity check and should be
+            // unreachable.
+            return set_error(serror, ScriptError::INVALID_BIT_COUNT);
+        }
+    } else {
+        // LEGACY MULTISIG (ECDSA / NULL)
+        // A bug causes CHECKMULTISIG to consume one extra
+        // argument whose contents were not checked in any
+        // way.
+        //
+        // Unfortunately this is a potential source of
+        // mutability, so optionally verify it is exactly
+        // equal to zero.
+        if ((flags & SCRIPT_VERIFY_NULLDUMMY) && stacktop(-idxDummy).size()) {
+            return set_error(serror, ScriptError::SIG_NULLDUMMY);
+        }
+
+        // Remove signature for pre-fork scripts
+        for (int k = 0; k < nSigsCount; k++) {
+            valtype &vchSig = stacktop(-idxTopSig - k);
+            CleanupScriptCode(scriptCode, vchSig, flags);
+        }
+
+        int nSigsRemaining = nSigsCount;
+        int nKeysRemaining = nKeysCount;
+        while (fSuccess && nSigsRemaining > 0) {
+            valtype &vchSig =
+                stacktop(-idxTopSig - (nSigsCount - nSigsRemaining));
+            valtype &vchPubKey =
+                stacktop(-idxTopKey - (nKeysCount - nKeysRemaining));
+
+            // Note how this makes the exact order of
+            // pubkey/signature evaluation distinguishable
+            // by CHECKMULTISIG NOT if the STRICTENC flag is
+            // set. See the script_(in)valid tests for
+            // details.
+            if (!CheckTransactionECDSASignatureEncoding(vchSig, flags,
+                                                        serror) ||
+                !CheckPubKeyEncoding(vchPubKey, flags, serror)) {
+                // serror is set
+                return false;
+            }
+
+            // Check signature
+            bool fOk = checker.CheckSig(vchSig, vchPubKey, scriptCode, flags);
+
+            if (fOk) {
+                nSigsRemaining--;
+            }
+            nKeysRemaining--;
+
+            // If there are more signatures left than keys
+            // left, then too many signatures have failed.
+            // Exit early, without checking any further
+            // signatures.
+            if (nSigsRemaining > nKeysRemaining) {
+                fSuccess = false;
+            }
+        }
+
+        bool areAllSignaturesNull = true;
+        for (int i = 0; i < nSigsCount; i++) {
+            if (stacktop(-idxTopSig - i).size()) {
+                areAllSignaturesNull = false;
+                break;
+            }
+        }
+
+        // If the operation failed, we may require that all
+        // signatures must be empty vector
+        if (!fSuccess && (flags & SCRIPT_VERIFY_NULLFAIL) &&
+            !areAllSignaturesNull) {
+            return set_error(serror, ScriptError::SIG_NULLFAIL);
+        }
+
+        if (!areAllSignaturesNull) {
+            // This is not identical to the number of actual
+            // ECDSA verifies, but, it is an upper bound
+            // that can be easily determined without doing
+            // CPU-intensive checks.
+            metrics.nSigChecks += nKeysCount;
+        }
+    }
+
+    // Clean up stack of all arguments
+    for (size_t i = 0; i < idxDummy; i++) {
+        popstack(stack);
+    }
+    return true;
+}
+
 ScriptInterpreter::ScriptInterpreter(std::vector<valtype> &stackIn,
                                      const CScript &scriptIn, uint32_t flags,
                                      const BaseSignatureChecker &checkerIn,
@@ -157,6 +425,11 @@ ScriptInterpreter::ScriptInterpreter(std::vector<valtype> &stackIn,
     this->pbegincodehash = scriptIn.begin();
     this->flags = flags;
     this->script_error = ScriptError::UNKNOWN;
+    this->vchPushValue = GetStackElementPool().Get();
+}
+
+ScriptInterpreter::~ScriptInterpreter() {
+    GetStackElementPool().Recycle(std::move(vchPushValue));
 }
 
 bool ScriptInterpreter::IsAtEnd() {
@@ -215,7 +488,6 @@ bool ScriptInterpreter::RunNextOp() {
     static const valtype vchTrue(1, 1);
 
     opcodetype opcode;
-    valtype vchPushValue;
 
     ScriptError *serror = &script_error;
     bool fRequireMinimal = (flags & SCRIPT_VERIFY_MINIMALDATA) != 0;
@@ -245,7 +517,8 @@ bool ScriptInterpreter::RunNextOp() {
         if (fRequireMinimal && !CheckMinimalPush(vchPushValue, opcode)) {
             return set_error(serror, ScriptError::MINIMALDATA);
         }
-        stack.push_back(vchPushValue);
+        stack.push_back(std::move(vchPushValue));
+        vchPushValue = GetStackElementPool().Get();
     } else if (fExec || (OP_IF <= opcode && opcode <= OP_ENDIF)) {
         switch (opcode) {
             //
@@ -1010,222 +1283,12 @@ bool ScriptInterpreter::RunNextOp() {
             case OP_CHECKMULTISIGVERIFY: {
                 // ([dummy] [sig ...] num_of_signatures [pubkey ...]
                 // num_of_pubkeys -- bool)
-                const size_t idxKeyCount = 1;
-                if (stack.size() < idxKeyCount) {
-                    return set_error(serror,
-                                     ScriptError::INVALID_STACK_OPERATION);
-                }
-                const int nKeysCount =
-                    CScriptNum(stacktop(-idxKeyCount), fRequireMinimal)
-                        .getint();
-                if (nKeysCount < 0 || nKeysCount > MAX_PUBKEYS_PER_MULTISIG) {
-                    return set_error(serror, ScriptError::PUBKEY_COUNT);
-                }
-                nOpCount += nKeysCount;
-                if (nOpCount > MAX_OPS_PER_SCRIPT) {
-                    return set_error(serror, ScriptError::OP_COUNT);
-                }
-
-                // stack depth of the top pubkey
-                const size_t idxTopKey = idxKeyCount + 1;
-
-                // stack depth of nSigsCount
-                const size_t idxSigCount = idxTopKey + nKeysCount;
-                if (stack.size() < idxSigCount) {
-                    return set_error(serror,
-                                     ScriptError::INVALID_STACK_OPERATION);
-                }
-                const int nSigsCount =
-                    CScriptNum(stacktop(-idxSigCount), fRequireMinimal)
-                        .getint();
-                if (nSigsCount < 0 || nSigsCount > nKeysCount) {
-                    return set_error(serror, ScriptError::SIG_COUNT);
-                }
-
-                // stack depth of the top signature
-                const size_t idxTopSig = idxSigCount + 1;
-
-                // stack depth of the dummy element
-                const size_t idxDummy = idxTopSig + nSigsCount;
-                if (stack.size() < idxDummy) {
-                    return set_error(serror,
-                                     ScriptError::INVALID_STACK_OPERATION);
-                }
-
-                // Subset of script starting at the most recent
-                // codeseparator
-                CScript scriptCode(pbegincodehash, pend);
-
-                // Assuming success is usually a bad idea, but the
-                // schnorr path can only succeed.
                 bool fSuccess = true;
-
-                if ((flags & SCRIPT_ENABLE_SCHNORR_MULTISIG) &&
-                    stacktop(-idxDummy).size() != 0) {
-                    // SCHNORR MULTISIG
-                    static_assert(MAX_PUBKEYS_PER_MULTISIG < 32,
-                                  "Schnorr multisig checkbits implementation "
-                                  "assumes < 32 pubkeys.");
-                    uint32_t checkBits = 0;
-
-                    // Dummy element is to be interpreted as a bitfield
-                    // that represent which pubkeys should be checked.
-                    valtype &vchDummy = stacktop(-idxDummy);
-                    if (!DecodeBitfield(vchDummy, nKeysCount, checkBits,
-                                        serror)) {
-                        // serror is set
-                        return false;
-                    }
-
-                    // The bitfield doesn't set the right number of
-                    // signatures.
-                    if (countBits(checkBits) != uint32_t(nSigsCount)) {
-                        return set_error(serror,
-                                         ScriptError::INVALID_BIT_COUNT);
-                    }
-
-                    const size_t idxBottomKey = idxTopKey + nKeysCount - 1;
-                    const size_t idxBottomSig = idxTopSig + nSigsCount - 1;
-
-                    int iKey = 0;
-                    for (int iSig = 0; iSig < nSigsCount; iSig++, iKey++) {
-                        if ((checkBits >> iKey) == 0) {
-                            // This is a sanity check and should be
-                            // unreachable.
-                            return set_error(serror,
-                                             ScriptError::INVALID_BIT_RANGE);
-                        }
-
-                        // Find the next suitable key.
-                        while (((checkBits >> iKey) & 0x01) == 0) {
-                            iKey++;
-                        }
-
-                        if (iKey >= nKeysCount) {
-                            // This is a sanity check and should be
-                            // unreachable.
-                            return set_error(serror, ScriptError::PUBKEY_COUNT);
-                        }
-
-                        // Check the signature.
-                        valtype &vchSig = stacktop(-idxBottomSig + iSig);
-                        valtype &vchPubKey = stacktop(-idxBottomKey + iKey);
-
-                        // Note that only pubkeys associated with a
-                        // signature are checked for validity.
-                        if (!CheckTransactionSchnorrSignatureEncoding(
-                                vchSig, flags, serror) ||
-                            !CheckPubKeyEncoding(vchPubKey, flags, serror)) {
-                            // serror is set
-                            return false;
-                        }
-
-                        // Check signature
-                        if (!checker.CheckSig(vchSig, vchPubKey, scriptCode,
-                                              flags)) {
-                            // This can fail if the signature is empty,
-                            // which also is a NULLFAIL error as the
-                            // bitfield should have been null in this
-                            // situation.
-                            return set_error(serror, ScriptError::SIG_NULLFAIL);
-                        }
-
-                        // this is guaranteed to execute exactly
-                        // nSigsCount times (if not script error)
-                        metrics.nSigChecks += 1;
-                    }
-
-                    if ((checkBits >> iKey) != 0) {
-                        // This is a sanity check and should be
-                        // unreachable.
-                        return set_error(serror,
-                                         ScriptError::INVALID_BIT_COUNT);
-                    }
-                } else {
-                    // LEGACY MULTISIG (ECDSA / NULL)
-                    // A bug causes CHECKMULTISIG to consume one extra
-                    // argument whose contents were not checked in any
-                    // way.
-                    //
-                    // Unfortunately this is a potential source of
-                    // mutability, so optionally verify it is exactly
-                    // equal to zero.
-                    if ((flags & SCRIPT_VERIFY_NULLDUMMY) &&
-                        stacktop(-idxDummy).size()) {
-                        return set_error(serror, ScriptError::SIG_NULLDUMMY);
-                    }
-
-                    // Remove signature for pre-fork scripts
-                    for (int k = 0; k < nSigsCount; k++) {
-                        valtype &vchSig = stacktop(-idxTopSig - k);
-                        CleanupScriptCode(scriptCode, vchSig, flags);
-                    }
-
-                    int nSigsRemaining = nSigsCount;
-                    int nKeysRemaining = nKeysCount;
-                    while (fSuccess && nSigsRemaining > 0) {
-                        valtype &vchSig = stacktop(
-                            -idxTopSig - (nSigsCount - nSigsRemaining));
-                        valtype &vchPubKey = stacktop(
-                            -idxTopKey - (nKeysCount - nKeysRemaining));
-
-                        // Note how this makes the exact order of
-                        // pubkey/signature evaluation distinguishable
-                        // by CHECKMULTISIG NOT if the STRICTENC flag is
-                        // set. See the script_(in)valid tests for
-                        // details.
-                        if (!CheckTransactionECDSASignatureEncoding(
-                                vchSig, flags, serror) ||
-                            !CheckPubKeyEncoding(vchPubKey, flags, serror)) {
-                            // serror is set
-                            return false;
-                        }
-
-                        // Check signature
-                        bool fOk = checker.CheckSig(vchSig, vchPubKey,
-                                                    scriptCode, flags);
-
-                        if (fOk) {
-                            nSigsRemaining--;
-                        }
-                        nKeysRemaining--;
-
-                        // If there are more signatures left than keys
-                        // left, then too many signatures have failed.
-                        // Exit early, without checking any further
-                        // signatures.
-                        if (nSigsRemaining > nKeysRemaining) {
-                            fSuccess = false;
-                        }
-                    }
-
-                    bool areAllSignaturesNull = true;
-                    for (int i = 0; i < nSigsCount; i++) {
-                        if (stacktop(-idxTopSig - i).size()) {
-                            areAllSignaturesNull = false;
-                            break;
-                        }
-                    }
-
-                    // If the operation failed, we may require that all
-                    // signatures must be empty vector
-                    if (!fSuccess && (flags & SCRIPT_VERIFY_NULLFAIL) &&
-                        !areAllSignaturesNull) {
-                        return set_error(serror, ScriptError::SIG_NULLFAIL);
-                    }
-
-                    if (!areAllSignaturesNull) {
-                        // This is not identical to the number of actual
-                        // ECDSA verifies, but, it is an upper bound
-                        // that can be easily determined without doing
-                        // CPU-intensive checks.
-                        metrics.nSigChecks += nKeysCount;
-                    }
-                }
-
-                // Clean up stack of all arguments
-                for (size_t i = 0; i < idxDummy; i++) {
-                    popstack(stack);
+                if (!EvalCheckMultisig(stack, pbegincodehash, pend, flags,
+                                       checker, metrics, nOpCount, serror,
+                                       fSuccess)) {
+                    // serror is set
+                    return false;
                 }
 
                 stack.push_back(fSuccess ? vchTrue : vchFalse);
@@ -1477,10 +1540,20 @@ public:
         // Serialize nVersion
         ::Serialize(s, txTo.nVersion);
         // Serialize vin
+        ::WriteCompactSize(s,
+                           sigHashType.hasAnyoneCanPay() ? 1 : txTo.vin.size());
+        SerializeFrom(s, 0);
+    }
+
+    /**
+     * Serialize the part of txTo that follows its first nFirstInput inputs,
+     * the ones before having already been written.
+     */
+    template <typename S>
+    void SerializeFrom(S &s, unsigned int nFirstInput) const {
         unsigned int nInputs =
             sigHashType.hasAnyoneCanPay() ? 1 : txTo.vin.size();
-        ::WriteCompactSize(s, nInputs);
-        for (unsigned int nInput = 0; nInput < nInputs; nInput++) {
+        for (unsigned int nInput = nFirstInput; nInput < nInputs; nInput++) {
             SerializeInput(s, nInput);
         }
         // Serialize vout
@@ -1530,6 +1603,32 @@ PrecomputedTransactionData::PrecomputedTransactionData(const T &txTo) {
     hashPrevouts = GetPrevoutHash(txTo);
     hashSequence = GetSequenceHash(txTo);
     hashOutputs = GetOutputsHash(txTo);
+
+    const uint256 zero;
+    forkIdPrefix << txTo.nVersion << hashPrevouts << hashSequence;
+    forkIdPrefixNoSequence << txTo.nVersion << hashPrevouts << zero;
+    forkIdPrefixAnyoneCanPay << txTo.nVersion << zero << zero;
+
+    // The inputs other than the one being signed are serialized the same way
+    // for every SIGHASH_ALL legacy signature hash, so checkpoint the hasher
+    // every few of them. The last input is never skipped.
+    const size_t nInputs = txTo.vin.size();
+    if (nInputs <= LEGACY_SIGHASH_CHECKPOINT_INTERVAL) {
+        return;
+    }
+    std::vector<HashWriter> checkpoints;
+    checkpoints.reserve((nInputs - 1) / LEGACY_SIGHASH_CHECKPOINT_INTERVAL);
+    HashWriter ss{};
+    ss << txTo.nVersion;
+    ::WriteCompactSize(ss, nInputs);
+    for (size_t i = 0; i + 1 < nInputs; i++) {
+        ss << txTo.vin[i].prevout << CScript() << txTo.vin[i].nSequence;
+        if ((i + 1) % LEGACY_SIGHASH_CHECKPOINT_INTERVAL == 0) {
+            checkpoints.push_back(ss);
+        }
+    }
+    legacyInputsCheckpoints =
+        std::make_shared<const std::vector<HashWriter>>(std::move(checkpoints));
 }
 
 // explicit instantiation
@@ -1579,11 +1678,23 @@ uint256 SignatureHash(const CScript &scriptCode, const T &txTo,
         }
 
         HashWriter ss{};
-        // Version
-        ss << txTo.nVersion;
-        // Input prevouts/nSequence (none/all, depending on flags)
-        ss << hashPrevouts;
-        ss << hashSequence;
+        if (cache) {
+            // Resume from the version and prevouts/nSequence midstate
+            if (sigHashType.hasAnyoneCanPay()) {
+                ss = cache->forkIdPrefixAnyoneCanPay;
+            } else if (sigHashType.getBaseType() == BaseSigHashType::SINGLE ||
+                       sigHashType.getBaseType() == BaseSigHashType::NONE) {
+                ss = cache->forkIdPrefixNoSequence;
+            } else {
+                ss = cache->forkIdPrefix;
+            }
+        } else {
+            // Version
+            ss << txTo.nVersion;
+            // Input prevouts/nSequence (none/all, depending on flags)
+            ss << hashPrevouts;
+            ss << hashSequence;
+        }
         // The input being signed (replacing the scriptSig with scriptCode +
         // amount). The prevout may already be contained in hashPrevout, and the
         // nSequence may already be contain in hashSequence.
@@ -1613,6 +1724,22 @@ uint256 SignatureHash(const CScript &scriptCode, const T &txTo,
     CTransactionSignatureSerializer<T> txTmp(txTo, scriptCode, nIn,
                                              sigHashType);
 
+    // With SIGHASH_ALL, the inputs before the one being signed do not depend
+    // on it, so resume from the closest checkpoint if there is one.
+    constexpr unsigned int interval{
+        PrecomputedTransactionData::LEGACY_SIGHASH_CHECKPOINT_INTERVAL};
+    const size_t checkpoint = nIn / interval;
+    if (cache && cache->legacyInputsCheckpoints && checkpoint > 0 &&
+        checkpoint <= cache->legacyInputsCheckpoints->size() &&
+        !sigHashType.hasAnyoneCanPay() &&
+        sigHashType.getBaseType() != BaseSigHashType::SINGLE &&
+        sigHashType.getBaseType() != BaseSigHashType::NONE) {
+        HashWriter ss = (*cache->legacyInputsCheckpoints)[checkpoint - 1];
+        txTmp.SerializeFrom(ss, checkpoint * interval);
+        ss << sigHashType;
+        return ss.GetHash();
+    }
+
     // Serialize and hash
     HashWriter ss{};
     ss << txTmp << sigHashType;
@@ -1752,6 +1879,215 @@ bool GenericTransactionSignatureChecker<T>::CheckSequence(
 template class GenericTransactionSignatureChecker<CTransaction>;
 template class GenericTransactionSignatureChecker<CMutableTransaction>;
 
+/**
+ * Read the pushes of a scriptSig, if they are all minimal pushes of at most
+ * MAX_SCRIPT_ELEMENT_SIZE bytes and there are exactly nPushes of them.
+ */
+static bool GetTemplatePushes(const CScript &scriptSig, size_t nPushes,
+                              std::vector<valtype> &pushes) {
+    if (scriptSig.size() > MAX_SCRIPT_SIZE) {
+        return false;
+    }
+    pushes.clear();
+    CScript::const_iterator pc = scriptSig.begin();
+    opcodetype opcode;
+    valtype data;
+    while (pc < scriptSig.end()) {
+        if (pushes.size() == nPushes || !scriptSig.GetOp(pc, opcode, data) ||
+            opcode > OP_PUSHDATA4 || data.size() > MAX_SCRIPT_ELEMENT_SIZE ||
+            !CheckMinimalPush(data, opcode)) {
+            return false;
+        }
+        pushes.push_back(std::move(data));
+    }
+    return pushes.size() == nPushes;
+}
+
+/** Whether the script is <pubkey> OP_CHECKSIG. */
+static bool IsTemplatePayToPubKey(const CScript &script) {
+    return (script.size() == CPubKey::COMPRESSED_SIZE + 2 &&
+            script[0] == CPubKey::COMPRESSED_SIZE &&
+            script.back() == OP_CHECKSIG) ||
+           (script.size() == CPubKey::SIZE + 2 && script[0] == CPubKey::SIZE &&
+            script.back() == OP_CHECKSIG);
+}
+
+/**
+ * Whether the script is OP_DUP OP_HASH160 <hash> OP_EQUALVERIFY OP_CHECKSIG.
+ */
+static bool IsTemplatePayToPubKeyHash(const CScript &script) {
+    return script.size() == 25 && script[0] == OP_DUP &&
+           script[1] == OP_HASH160 && script[2] == 20 &&
+           script[23] == OP_EQUALVERIFY && script[24] == OP_CHECKSIG;
+}
+
+/**
+ * Whether the script is OP_m <pubkey>... OP_n OP_CHECKMULTISIG, with
+ * 1 <= m <= n <= 16, in which case m and n are returned.
+ */
+static bool IsTemplateMultisig(const CScript &script, int &nRequired,
+                               int &nKeys) {
+    if (script.size() < 3 || script.back() != OP_CHECKMULTISIG) {
+        return false;
+    }
+    const opcodetype opRequired = opcodetype(script[0]);
+    const opcodetype opKeys = opcodetype(script[script.size() - 2]);
+    if (opRequired < OP_1 || opRequired > OP_16 || opKeys < OP_1 ||
+        opKeys > OP_16) {
+        return false;
+    }
+    nRequired = CScript::DecodeOP_N(opRequired);
+    nKeys = CScript::DecodeOP_N(opKeys);
+    if (nRequired > nKeys) {
+        return false;
+    }
+    size_t pos = 1;
+    for (int i = 0; i < nKeys; i++) {
+        if (pos >= script.size() - 2 ||
+            (script[pos] != CPubKey::COMPRESSED_SIZE &&
+             script[pos] != CPubKey::SIZE)) {
+            return false;
+        }
+        pos += 1 + script[pos];
+    }
+    return pos == script.size() - 2;
+}
+
+std::optional<bool>
+EvalStandardTemplate(const CScript &scriptSig, const CScript &scriptPubKey,
+                     uint32_t flags, const BaseSignatureChecker &checker,
+                     std::vector<valtype> &stack,
+                     ScriptExecutionMetrics &metrics, ScriptError *serror) {
+    static const valtype vchTrue(1, 1);
+
+    // As done by VerifyScript.
+    if (flags & SCRIPT_ENABLE_SIGHASH_FORKID) {
+        flags |= SCRIPT_VERIFY_STRICTENC;
+    }
+
+    std::vector<valtype> pushes;
+    bool fSuccess = false;
+    try {
+        if (IsTemplatePayToPubKey(scriptPubKey)) {
+            // (sig -- bool)
+            if (!GetTemplatePushes(scriptSig, 1, pushes)) {
+                return std::nullopt;
+            }
+            const valtype vchPubKey(scriptPubKey.begin() + 1,
+                                    scriptPubKey.end() - 1);
+            if (!EvalChecksig(pushes[0], vchPubKey, scriptPubKey.begin(),
+                              scriptPubKey.end(), flags, checker, metrics,
+                              serror, fSuccess)) {
+                // serror is set
+                return false;
+            }
+        } else if (IsTemplatePayToPubKeyHash(scriptPubKey)) {
+            // (sig pubkey -- bool)
+            if (!GetTemplatePushes(scriptSig, 2, pushes)) {
+                return std::nullopt;
+            }
+            uint160 hash;
+            CHash160().Write(pushes[1]).Finalize(hash);
+            if (!std::equal(hash.begin(), hash.end(),
+                            scriptPubKey.begin() + 3)) {
+                return set_error(serror, ScriptError::EQUALVERIFY);
+            }
+            if (!EvalChecksig(pushes[0], pushes[1], scriptPubKey.begin(),
+                              scriptPubKey.end(), flags, checker, metrics,
+                              serror, fSuccess)) {
+                // serror is set
+                return false;
+            }
+        } else if ((flags & SCRIPT_VERIFY_P2SH) &&
+                   scriptPubKey.IsPayToScriptHash()) {
+            // ([dummy] [sig ...] redeemscript -- bool)
+            int nRequired, nKeys;
+            CScript::const_iterator pc = scriptSig.begin();
+            opcodetype opcode;
+            valtype redeemScriptBytes;
+            // The redeem script is the last push, look for it first to know
+            // how many signatures to expect.
+            while (pc < scriptSig.end()) {
+                if (!scriptSig.GetOp(pc, opcode, redeemScriptBytes)) {
+                    return std::nullopt;
+                }
+            }
+            const CScript redeemScript(redeemScriptBytes.begin(),
+                                       redeemScriptBytes.end());
+            if (!IsTemplateMultisig(redeemScript, nRequired, nKeys) ||
+                !GetTemplatePushes(scriptSig, nRequired + 2, pushes)) {
+                return std::nullopt;
+            }
+            uint160 hash;
+            CHash160().Write(pushes.back()).Finalize(hash);
+            if (!std::equal(hash.begin(), hash.end(),
+                            scriptPubKey.begin() + 2)) {
+                return set_error(serror, ScriptError::EVAL_FALSE);
+            }
+
+            // Lay the stack out as the redeem script would, then check the
+            // signatures.
+            pushes.pop_back();
+            pushes.push_back(CScriptNum(nRequired).getvch());
+            CScript::const_iterator pk = redeemScript.begin() + 1;
+            for (int i = 0; i < nKeys; i++) {
+                pushes.emplace_back(pk + 1, pk + 1 + *pk);
+                pk += 1 + *pk;
+            }
+            pushes.push_back(CScriptNum(nKeys).getvch());
+            // OP_CHECKMULTISIG itself counts as an operation.
+            size_t nOpCount = 1;
+            if (!EvalCheckMultisig(pushes, redeemScript.begin(),
+                                   redeemScript.end(), flags, checker, metrics,
+                                   nOpCount, serror, fSuccess)) {
+                // serror is set
+                return false;
+            }
+        } else {
+            return std::nullopt;
+        }
+    } catch (...) {
+        return set_error(serror, ScriptError::UNKNOWN);
+    }
+
+    if (!fSuccess) {
+        return set_error(serror, ScriptError::EVAL_FALSE);
+    }
+    stack.assign(1, vchTrue);
+    return true;
+}
+
+/** Check the SCRIPT_VERIFY_INPUT_SIGCHECKS density limit. */
+static bool CheckInputSigChecks(const CScript &scriptSig, uint32_t flags,
+                                const ScriptExecutionMetrics &metrics,
+                                ScriptError *serror) {
+    if ((flags & SCRIPT_VERIFY_INPUT_SIGCHECKS) == 0) {
+        return true;
+    }
+    // This limit is intended for standard use, and is based on an
+    // examination of typical and historical standard uses.
+    // - allowing P2SH ECDSA multisig with compressed keys, which at an
+    // extreme (1-of-15) may have 15 SigChecks in ~590 bytes of scriptSig.
+    // - allowing Bare ECDSA multisig, which at an extreme (1-of-3) may have
+    // 3 sigchecks in ~72 bytes of scriptSig.
+    // - Since the size of an input is 41 bytes + length of scriptSig, then
+    // the most dense possible inputs satisfying this rule would be:
+    //   2 sigchecks and 26 bytes: 1/33.50 sigchecks/byte.
+    //   3 sigchecks and 69 bytes: 1/36.66 sigchecks/byte.
+    // The latter can be readily done with 1-of-3 bare multisignatures,
+    // however the former is not practically doable with standard scripts,
+    // so the practical density limit is 1/36.66.
+    static_assert(INT_MAX > MAX_SCRIPT_SIZE,
+                  "overflow sanity check on max script size");
+    static_assert(INT_MAX / 43 / 3 > MAX_OPS_PER_SCRIPT,
+                  "overflow sanity check on maximum possible sigchecks "
+                  "from sig+redeem+pub scripts");
+    if (int(scriptSig.size()) < metrics.nSigChecks * 43 - 60) {
+        return set_error(serror, ScriptError::INPUT_SIGCHECKS);
+    }
+    return true;
+}
+
 bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
                   uint32_t flags, const BaseSignatureChecker &checker,
                   ScriptExecutionMetrics &metricsOut, ScriptError *serror) {
@@ -1768,9 +2104,22 @@ bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
 
     ScriptExecutionMetrics metrics = {};
 
+    // Standard spends skip the interpreter loop, with the same outcome. They
+    // leave a clean stack.
+    std::vector<valtype> stack, stackCopy;
+    if (const std::optional<bool> templateResult = EvalStandardTemplate(
+            scriptSig, scriptPubKey, flags, checker, stack, metrics, serror)) {
+        if (!*templateResult ||
+            !CheckInputSigChecks(scriptSig, flags, metrics, serror)) {
+            // serror is set
+            return false;
+        }
+        metricsOut = metrics;
+        return set_success(serror);
+    }
+
     // scriptSig and scriptPubKey must be evaluated sequentially on the same
     // stack rather than being simply concatenated (see CVE-2010-5141)
-    std::vector<valtype> stack, stackCopy;
     if (!EvalScript(stack, scriptSig, flags, checker, metrics, serror)) {
         // serror is set
         return false;
@@ -1844,28 +2193,9 @@ bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
         }
     }
 
-    if (flags & SCRIPT_VERIFY_INPUT_SIGCHECKS) {
-        // This limit is intended for standard use, and is based on an
-        // examination of typical and historical standard uses.
-        // - allowing P2SH ECDSA multisig with compressed keys, which at an
-        // extreme (1-of-15) may have 15 SigChecks in ~590 bytes of scriptSig.
-        // - allowing Bare ECDSA multisig, which at an extreme (1-of-3) may have
-        // 3 sigchecks in ~72 bytes of scriptSig.
-        // - Since the size of an input is 41 bytes + length of scriptSig, then
-        // the most dense possible inputs satisfying this rule would be:
-        //   2 sigchecks and 26 bytes: 1/33.50 sigchecks/byte.
-        //   3 sigchecks and 69 bytes: 1/36.66 sigchecks/byte.
-        // The latter can be readily done with 1-of-3 bare multisignatures,
-        // however the former is not practically doable with standard scripts,
-        // so the practical density limit is 1/36.66.
-        static_assert(INT_MAX > MAX_SCRIPT_SIZE,
-                      "overflow sanity check on max script size");
-        static_assert(INT_MAX / 43 / 3 > MAX_OPS_PER_SCRIPT,
-                      "overflow sanity check on maximum possible sigchecks "
-                      "from sig+redeem+pub scripts");
-        if (int(scriptSig.size()) < metrics.nSigChecks * 43 - 60) {
-            return set_error(serror, ScriptError::INPUT_SIGCHECKS);
-        }
+    if (!CheckInputSigChecks(scriptSig, flags, metrics, serror)) {
+        // serror is set
+        return false;
     }
 
     metricsOut = metrics;
@@ -16,6 +16,7 @@
 #include <script/sighashtype.h>
 
 #include <cstdint>
+#include <optional>
 #include <vector>
 
 class CPubKey;
@@ -120,11 +121,15 @@ private:
     // Last script error
     ScriptError script_error;
 
+    // Buffer the next pushed element is read into
+    std::vector<uint8_t> vchPushValue;
+
 public:
     ScriptInterpreter(std::vector<std::vector<uint8_t>> &stack,
                       const CScript &script, uint32_t flags,
                       const BaseSignatureChecker &checker,
                       ScriptExecutionMetrics &metrics);
+    ~ScriptInterpreter();
 
     // Whether the interpreter program counter reached the end of the Script.
     // This does not reflect whether an error occured or not.
@@ -174,6 +179,25 @@ static inline bool EvalScript(std::vector<std::vector<uint8_t>> &stack,
     return EvalScript(stack, script, flags, checker, dummymetrics, error);
 }
 
+/**
+ * Evaluate the spend of a standard P2PK, P2PKH or P2SH multisig output without
+ * going through the interpreter loop.
+ *
+ * Only the exact templates are recognized, with minimal pushes and no extra
+ * item in the scriptSig. Their signatures are checked with the same helpers
+ * as the interpreter.
+ *
+ * @return std::nullopt if the scripts do not match a template. Otherwise,
+ *     whether the evaluation succeeded, with the stack, metrics and error
+ *     that evaluating them with VerifyScript would produce.
+ */
+std::optional<bool>
+EvalStandardTemplate(const CScript &scriptSig, const CScript &scriptPubKey,
+                     uint32_t flags, const BaseSignatureChecker &checker,
+                     std::vector<std::vector<uint8_t>> &stack,
+                     ScriptExecutionMetrics &metrics,
+                     ScriptError *serror = nullptr);
+
 /**
  * Execute an unlocking and locking script together.
  *
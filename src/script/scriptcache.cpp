@@ -72,6 +72,7 @@ public:
 static CuckooCache::cache<ScriptCacheElement, ScriptCacheHasher>
     g_scriptExecutionCache;
 static CSHA256 g_scriptExecutionCacheHasher;
+static ScriptCacheStats g_scriptExecutionCacheStats GUARDED_BY(cs_main);
 
 bool InitScriptExecutionCache(size_t max_size_bytes) {
     // Setup the salted hasher
@@ -88,6 +89,10 @@ bool InitScriptExecutionCache(size_t max_size_bytes) {
     }
 
     const auto [num_elems, approx_size_bytes] = *setup_results;
+    {
+        LOCK(cs_main);
+        g_scriptExecutionCacheStats = {0, 0, num_elems, approx_size_bytes};
+    }
     LogPrintf("Using %zu MiB out of %zu MiB requested for script execution "
               "cache, able to store %zu elements\n",
               approx_size_bytes >> 20, max_size_bytes >> 20, num_elems);
@@ -112,6 +117,8 @@ bool IsKeyInScriptCache(ScriptCacheKey key, bool erase, int &nSigChecksOut) {
 
     ScriptCacheElement elem(key, 0);
     bool ret = g_scriptExecutionCache.get(elem, erase);
+    ++(ret ? g_scriptExecutionCacheStats.hits
+           : g_scriptExecutionCacheStats.misses);
     nSigChecksOut = elem.nSigChecks;
     return ret;
 }
@@ -124,3 +131,8 @@ void AddKeyInScriptCache(ScriptCacheKey key, int nSigChecks) {
     ScriptCacheElement elem(key, nSigChecks);
     g_scriptExecutionCache.insert(elem);
 }
+
+ScriptCacheStats GetScriptCacheStats() {
+    AssertLockHeld(cs_main);
+    return g_scriptExecutionCacheStats;
+}
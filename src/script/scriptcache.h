@@ -60,4 +60,15 @@ bool IsKeyInScriptCache(ScriptCacheKey key, bool erase, int &nSigChecksOut)
 void AddKeyInScriptCache(ScriptCacheKey key, int nSigChecks)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+struct ScriptCacheStats {
+    //! Number of lookups answered by the cache
+    uint64_t hits{0};
+    //! Number of lookups for a key not in the cache
+    uint64_t misses{0};
+    size_t max_elements{0};
+    size_t size_bytes{0};
+};
+
+ScriptCacheStats GetScriptCacheStats() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 #endif // BITCOIN_SCRIPT_SCRIPTCACHE_H
@@ -23,6 +23,13 @@ MutableTransactionSignatureCreator::MutableTransactionSignatureCreator(
     : txTo(txToIn), nIn(nInIn), amount(amountIn), sigHashType(sigHashTypeIn),
       checker(txTo, nIn, amountIn) {}
 
+MutableTransactionSignatureCreator::MutableTransactionSignatureCreator(
+    const CMutableTransaction *txToIn, unsigned int nInIn,
+    const Amount &amountIn, const PrecomputedTransactionData &txdata,
+    SigHashType sigHashTypeIn)
+    : txTo(txToIn), nIn(nInIn), amount(amountIn), sigHashType(sigHashTypeIn),
+      checker(txTo, nIn, amountIn, txdata), m_txdata(&txdata) {}
+
 bool MutableTransactionSignatureCreator::CreateSig(
     const SigningProvider &provider, std::vector<uint8_t> &vchSig,
     const CKeyID &address, const CScript &scriptCode) const {
@@ -31,7 +38,8 @@ bool MutableTransactionSignatureCreator::CreateSig(
         return false;
     }
 
-    uint256 hash = SignatureHash(scriptCode, *txTo, nIn, sigHashType, amount);
+    uint256 hash =
+        SignatureHash(scriptCode, *txTo, nIn, sigHashType, amount, m_txdata);
     if (!key.SignECDSA(hash, vchSig)) {
         return false;
     }
@@ -452,6 +460,7 @@ bool SignTransaction(CMutableTransaction &mtx, const SigningProvider *keystore,
     // Use CTransaction for the constant parts of the
     // transaction to avoid rehashing.
     const CTransaction txConst(mtx);
+    const PrecomputedTransactionData txdata(txConst);
     // Sign what we can:
     for (size_t i = 0; i < mtx.vin.size(); i++) {
         CTxIn &txin = mtx.vin[i];
@@ -469,8 +478,8 @@ bool SignTransaction(CMutableTransaction &mtx, const SigningProvider *keystore,
         if ((sigHashType.getBaseType() != BaseSigHashType::SINGLE) ||
             (i < mtx.vout.size())) {
             ProduceSignature(*keystore,
-                             MutableTransactionSignatureCreator(&mtx, i, amount,
-                                                                sigHashType),
+                             MutableTransactionSignatureCreator(
+                                 &mtx, i, amount, txdata, sigHashType),
                              prevPubKey, sigdata);
         }
 
@@ -484,7 +493,8 @@ bool SignTransaction(CMutableTransaction &mtx, const SigningProvider *keystore,
 
         ScriptError serror = ScriptError::OK;
         if (!VerifyScript(txin.scriptSig, prevPubKey, GetSignScriptFlags(),
-                          TransactionSignatureChecker(&txConst, i, amount),
+                          TransactionSignatureChecker(&txConst, i, amount,
+                                                      txdata),
                           &serror)) {
             if (serror == ScriptError::INVALID_STACK_OPERATION) {
                 // Unable to sign input and verification failed (possible
@@ -41,11 +41,21 @@ class MutableTransactionSignatureCreator : public BaseSignatureCreator {
     Amount amount;
     SigHashType sigHashType;
     const MutableTransactionSignatureChecker checker;
+    const PrecomputedTransactionData *m_txdata{nullptr};
 
 public:
     MutableTransactionSignatureCreator(
         const CMutableTransaction *txToIn, unsigned int nInIn,
         const Amount &amountIn, SigHashType sigHashTypeIn = SigHashType());
+    /**
+     * Sign with the signature hash midstates of the transaction, so signing
+     * all its inputs isn't quadratic. Only the scriptSigs of the transaction
+     * may change as long as txdata is used.
+     */
+    MutableTransactionSignatureCreator(
+        const CMutableTransaction *txToIn, unsigned int nInIn,
+        const Amount &amountIn, const PrecomputedTransactionData &txdata,
+        SigHashType sigHashTypeIn = SigHashType());
     const BaseSignatureChecker &Checker() const override { return checker; }
     bool CreateSig(const SigningProvider &provider,
                    std::vector<uint8_t> &vchSig, const CKeyID &keyid,
@@ -28,6 +28,30 @@ SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorr_verify(
   const secp256k1_pubkey *pubkey
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
 
+/**
+ * Verify a batch of signatures created by secp256k1_schnorr_sign at once.
+ * This is faster than verifying each signature individually, but gives no
+ * indication of which signature is invalid if the batch fails.
+ * Returns: 1: all the signatures are correct
+ *          0: at least one of the signatures is incorrect, or a public key
+ *             could not be loaded
+ * Args:    ctx:       a secp256k1 context object, initialized for verification.
+ *          scratch:   scratch space used for the multi-multiplication. It can
+ *                     be NULL, in which case a slower algorithm is used.
+ * In:      sig64:     array of n pointers to 64-byte signatures
+ *          msghash32: array of n pointers to the 32-byte message hashes
+ *          pubkey:    array of n pointers to the public keys
+ *          n:         the number of signatures to verify
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_schnorr_verify_batch(
+  const secp256k1_context* ctx,
+  secp256k1_scratch_space *scratch,
+  const unsigned char *const *sig64,
+  const unsigned char *const *msghash32,
+  const secp256k1_pubkey *const *pubkey,
+  size_t n
+) SECP256K1_ARG_NONNULL(1);
+
 /**
  * Create a signature using a custom EC-Schnorr-SHA256 construction. It
  * produces non-malleable 64-byte signatures which support batch validation,
@@ -30,6 +30,120 @@ int secp256k1_schnorr_verify(
     return secp256k1_schnorr_sig_verify(&ctx->ecmult_ctx, sig64, &q, msghash32);
 }
 
+typedef struct {
+    const secp256k1_context *ctx;
+    const unsigned char *const *sig64;
+    const unsigned char *const *msghash32;
+    const secp256k1_pubkey *const *pubkey;
+    unsigned char seed[32];
+} secp256k1_schnorr_verify_batch_data;
+
+/* Derive the random coefficient of the i-th signature of the batch from a
+ * seed committing to all the signatures, messages and public keys. */
+static void secp256k1_schnorr_batch_randomizer(secp256k1_scalar *a, const unsigned char *seed32, size_t i) {
+    secp256k1_sha256 sha;
+    unsigned char buf[32];
+    unsigned char idx[8];
+    int j;
+
+    for (j = 0; j < 8; j++) {
+        idx[j] = (i >> (8 * j)) & 0xff;
+    }
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, seed32, 32);
+    secp256k1_sha256_write(&sha, idx, sizeof(idx));
+    secp256k1_sha256_finalize(&sha, buf);
+    secp256k1_scalar_set_b32(a, buf, NULL);
+}
+
+/* Provide the points -a_i * R_i (even indices) and -a_i * e_i * P_i (odd
+ * indices) to the multi-multiplication. */
+static int secp256k1_schnorr_verify_batch_callback(secp256k1_scalar *sc, secp256k1_ge *pt, size_t idx, void *cbdata) {
+    secp256k1_schnorr_verify_batch_data *data = (secp256k1_schnorr_verify_batch_data *)cbdata;
+    size_t i = idx / 2;
+    secp256k1_scalar a;
+
+    secp256k1_schnorr_batch_randomizer(&a, data->seed, i);
+    if (idx % 2 == 0) {
+        secp256k1_fe rx;
+        /* Decompress r into R, with R.y a quadratic residue. */
+        if (!secp256k1_fe_set_b32(&rx, data->sig64[i])) {
+            return 0;
+        }
+        if (!secp256k1_ge_set_xquad(pt, &rx)) {
+            return 0;
+        }
+        secp256k1_scalar_negate(sc, &a);
+    } else {
+        secp256k1_scalar e;
+        if (!secp256k1_pubkey_load(data->ctx, pt, data->pubkey[i])) {
+            return 0;
+        }
+        secp256k1_schnorr_compute_e(&e, data->sig64[i], pt, data->msghash32[i]);
+        secp256k1_scalar_mul(sc, &a, &e);
+        secp256k1_scalar_negate(sc, sc);
+    }
+    return 1;
+}
+
+int secp256k1_schnorr_verify_batch(
+    const secp256k1_context* ctx,
+    secp256k1_scratch_space *scratch,
+    const unsigned char *const *sig64,
+    const unsigned char *const *msghash32,
+    const secp256k1_pubkey *const *pubkey,
+    size_t n
+) {
+    secp256k1_schnorr_verify_batch_data data;
+    secp256k1_sha256 sha;
+    secp256k1_scalar s, a, sum;
+    secp256k1_gej r;
+    size_t i;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(n == 0 || sig64 != NULL);
+    ARG_CHECK(n == 0 || msghash32 != NULL);
+    ARG_CHECK(n == 0 || pubkey != NULL);
+
+    if (n == 0) {
+        return 1;
+    }
+
+    /* The random coefficients are derived from all the inputs, so they can't
+     * be predicted when crafting the signatures. */
+    secp256k1_sha256_initialize(&sha);
+    for (i = 0; i < n; i++) {
+        secp256k1_sha256_write(&sha, sig64[i], 64);
+        secp256k1_sha256_write(&sha, msghash32[i], 32);
+        secp256k1_sha256_write(&sha, pubkey[i]->data, sizeof(pubkey[i]->data));
+    }
+    data.ctx = ctx;
+    data.sig64 = sig64;
+    data.msghash32 = msghash32;
+    data.pubkey = pubkey;
+    secp256k1_sha256_finalize(&sha, data.seed);
+
+    /* Compute sum(a_i * s_i), rejecting any overflowing s. */
+    secp256k1_scalar_set_int(&sum, 0);
+    for (i = 0; i < n; i++) {
+        int overflow = 0;
+        secp256k1_scalar_set_b32(&s, sig64[i] + 32, &overflow);
+        if (overflow) {
+            return 0;
+        }
+        secp256k1_schnorr_batch_randomizer(&a, data.seed, i);
+        secp256k1_scalar_mul(&s, &s, &a);
+        secp256k1_scalar_add(&sum, &sum, &s);
+    }
+
+    /* The batch is valid if sum(a_i * s_i) * G - sum(a_i * R_i)
+     * - sum(a_i * e_i * P_i) == 0. */
+    if (!secp256k1_ecmult_multi_var(&ctx->error_callback, &ctx->ecmult_ctx, scratch, &r, &sum, secp256k1_schnorr_verify_batch_callback, &data, 2 * n)) {
+        return 0;
+    }
+    return secp256k1_gej_is_infinity(&r);
+}
+
 int secp256k1_schnorr_sign(
     const secp256k1_context *ctx,
     unsigned char *sig64,
@@ -76,6 +76,57 @@ void test_schnorr_sign_verify(void) {
     }
 }
 
+void test_schnorr_verify_batch(void) {
+    unsigned char msg32[SIG_COUNT][32];
+    unsigned char sig64[SIG_COUNT][64];
+    unsigned char privkey[32];
+    secp256k1_pubkey pubkey[SIG_COUNT];
+    const unsigned char *sigptr[SIG_COUNT];
+    const unsigned char *msgptr[SIG_COUNT];
+    const secp256k1_pubkey *pubkeyptr[SIG_COUNT];
+    secp256k1_scratch_space *scratch = secp256k1_scratch_space_create(ctx, 1024 * 1024);
+    int i, n;
+
+    for (i = 0; i < SIG_COUNT; i++) {
+        secp256k1_scalar key;
+        random_scalar_order_test(&key);
+        secp256k1_scalar_get_b32(privkey, &key);
+        secp256k1_testrand256_test(msg32[i]);
+        CHECK(secp256k1_ec_pubkey_create(ctx, &pubkey[i], privkey) == 1);
+        CHECK(secp256k1_schnorr_sign(ctx, sig64[i], msg32[i], privkey, NULL, NULL) == 1);
+        sigptr[i] = sig64[i];
+        msgptr[i] = msg32[i];
+        pubkeyptr[i] = &pubkey[i];
+    }
+
+    /* An empty batch is valid. */
+    CHECK(secp256k1_schnorr_verify_batch(ctx, scratch, NULL, NULL, NULL, 0) == 1);
+
+    for (n = 1; n <= SIG_COUNT; n++) {
+        int pos = secp256k1_testrand_bits(6);
+        int mod = 1 + secp256k1_testrand_int(255);
+        i = secp256k1_testrand_int(n);
+
+        CHECK(secp256k1_schnorr_verify_batch(ctx, scratch, sigptr, msgptr, pubkeyptr, n) == 1);
+        CHECK(secp256k1_schnorr_verify_batch(ctx, NULL, sigptr, msgptr, pubkeyptr, n) == 1);
+
+        /* Any modified signature invalidates the whole batch. */
+        sig64[i][pos] ^= mod;
+        CHECK(secp256k1_schnorr_verify_batch(ctx, scratch, sigptr, msgptr, pubkeyptr, n) == 0);
+        CHECK(secp256k1_schnorr_verify_batch(ctx, NULL, sigptr, msgptr, pubkeyptr, n) == 0);
+        sig64[i][pos] ^= mod;
+
+        /* So does a signature checked against the wrong message. */
+        if (n > 1) {
+            msgptr[i] = msg32[(i + 1) % n];
+            CHECK(secp256k1_schnorr_verify_batch(ctx, scratch, sigptr, msgptr, pubkeyptr, n) == 0);
+            msgptr[i] = msg32[i];
+        }
+    }
+
+    secp256k1_scratch_space_destroy(ctx, scratch);
+}
+
 #undef SIG_COUNT
 
 void run_schnorr_compact_test(void) {
@@ -516,6 +567,7 @@ void run_schnorr_tests(void) {
     }
 
     test_schnorr_sign_verify();
+    test_schnorr_verify_batch();
     run_schnorr_compact_test();
 }
 
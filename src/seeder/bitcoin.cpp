@@ -255,6 +255,71 @@ CSeederNode::CSeederNode(const CService &ip, std::vector<CAddress> *vAddrIn)
     }
 }
 
+void CSeederNode::PushVersion() {
+    // Don't include the time in CAddress serialization. See D14753.
+    uint64_t nLocalServices = 0;
+    uint64_t nLocalNonce = BITCOIN_SEED_NONCE;
+    uint64_t your_services{yourServices};
+    uint64_t my_services{ServiceFlags(NODE_NETWORK)};
+    uint8_t fRelayTxs = 0;
+
+    const std::string clientName = gArgs.GetArg("-uaclientname", CLIENT_NAME);
+    const std::string clientVersion =
+        gArgs.GetArg("-uaclientversion", FormatVersion(CLIENT_VERSION));
+    const std::string userAgent =
+        FormatUserAgent(clientName, clientVersion, {"seeder"});
+
+    MessageWriter::WriteMessage(vSend, NetMsgType::VERSION, PROTOCOL_VERSION,
+                                nLocalServices, GetTime(), your_services, you,
+                                my_services, CService(), nLocalNonce, userAgent,
+                                GetRequireHeight(), fRelayTxs);
+}
+
+bool CSeederNode::IsAwaitingMessages(NodeSeconds now) const {
+    return ban == 0 &&
+           (TicksSinceEpoch<std::chrono::seconds>(doneAfter) == 0 ||
+            doneAfter > now) &&
+           sock;
+}
+
+bool CSeederNode::Receive(bool until_would_block) {
+    char pchBuf[0x10000];
+    do {
+        int nBytes = sock->Recv(pchBuf, sizeof(pchBuf), 0);
+        if (nBytes > 0) {
+            int nPos = vRecv.size();
+            vRecv.resize(nPos + nBytes);
+            memcpy(&vRecv[nPos], pchBuf, nBytes);
+        } else if (nBytes == 0) {
+            // tfm::format(std::cout, "%s: BAD (connection closed
+            // prematurely)\n",
+            //        ToString(you));
+            return false;
+        } else if (!until_would_block) {
+            // tfm::format(std::cout, "%s: BAD (connection error)\n",
+            // ToString(you));
+            return false;
+        } else {
+            const int nErr = WSAGetLastError();
+            if (nErr == WSAEWOULDBLOCK) {
+                return true;
+            }
+            if (nErr != WSAEINTR) {
+                return false;
+            }
+        }
+    } while (until_would_block);
+    return true;
+}
+
+bool CSeederNode::Finish(bool res) {
+    if (!sock) {
+        res = false;
+    }
+    sock.reset();
+    return (ban == 0) && res;
+}
+
 bool CSeederNode::Run() {
     // FIXME: This logic is duplicated with CConnman::ConnectNode for no
     // good reason.
@@ -292,33 +357,12 @@ bool CSeederNode::Run() {
     }
 
     // Write version message
-    // Don't include the time in CAddress serialization. See D14753.
-    uint64_t nLocalServices = 0;
-    uint64_t nLocalNonce = BITCOIN_SEED_NONCE;
-    uint64_t your_services{yourServices};
-    uint64_t my_services{ServiceFlags(NODE_NETWORK)};
-    uint8_t fRelayTxs = 0;
-
-    const std::string clientName = gArgs.GetArg("-uaclientname", CLIENT_NAME);
-    const std::string clientVersion =
-        gArgs.GetArg("-uaclientversion", FormatVersion(CLIENT_VERSION));
-    const std::string userAgent =
-        FormatUserAgent(clientName, clientVersion, {"seeder"});
-
-    MessageWriter::WriteMessage(vSend, NetMsgType::VERSION, PROTOCOL_VERSION,
-                                nLocalServices, GetTime(), your_services, you,
-                                my_services, CService(), nLocalNonce, userAgent,
-                                GetRequireHeight(), fRelayTxs);
+    PushVersion();
     Send();
 
     bool res = true;
     NodeSeconds now;
-    while (now = Now<NodeSeconds>(),
-           ban == 0 &&
-               (TicksSinceEpoch<std::chrono::seconds>(doneAfter) == 0 ||
-                doneAfter > now) &&
-               sock) {
-        char pchBuf[0x10000];
+    while (now = Now<NodeSeconds>(), IsAwaitingMessages(now)) {
         fd_set fdsetRecv;
         fd_set fdsetError;
         FD_ZERO(&fdsetRecv);
@@ -341,29 +385,101 @@ bool CSeederNode::Run() {
             }
             break;
         }
-        int nBytes = sock->Recv(pchBuf, sizeof(pchBuf), 0);
-        int nPos = vRecv.size();
-        if (nBytes > 0) {
-            vRecv.resize(nPos + nBytes);
-            memcpy(&vRecv[nPos], pchBuf, nBytes);
-        } else if (nBytes == 0) {
-            // tfm::format(std::cout, "%s: BAD (connection closed
-            // prematurely)\n",
-            //        ToString(you));
-            res = false;
-            break;
-        } else {
-            // tfm::format(std::cout, "%s: BAD (connection error)\n",
-            // ToString(you));
+        if (!Receive(/*until_would_block=*/false)) {
             res = false;
             break;
         }
         ProcessMessages();
         Send();
     }
+    return Finish(res);
+}
+
+bool CSeederNode::StartProbe() {
+    proxyType proxy;
+    if (!you.IsValid() || GetProxy(you.GetNetwork(), proxy)) {
+        // The proxy handshake is blocking
+        return false;
+    }
+    struct sockaddr_storage sockaddr;
+    socklen_t len = sizeof(sockaddr);
+    if (!you.GetSockAddr((struct sockaddr *)&sockaddr, &len)) {
+        return false;
+    }
+    sock = CreateSock(you);
     if (!sock) {
-        res = false;
+        return false;
     }
-    sock.reset();
-    return (ban == 0) && res;
+    if (sock->Connect(reinterpret_cast<struct sockaddr *>(&sockaddr), len) ==
+        SOCKET_ERROR) {
+        const int nErr = WSAGetLastError();
+        if (nErr != WSAEINPROGRESS && nErr != WSAEWOULDBLOCK &&
+            nErr != WSAEINVAL) {
+            // Failed right away, there is nothing to wait for
+            connecting = false;
+            probeFailed = true;
+            return true;
+        }
+    }
+    connecting = true;
+    lastActivity = Now<NodeSeconds>();
+    return true;
+}
+
+void CSeederNode::OnSockEvents(Sock::Event events) {
+    if (!sock || probeFailed) {
+        return;
+    }
+    if (connecting) {
+        if (!(events & (Sock::SEND | Sock::ERR))) {
+            return;
+        }
+        // The reason a connection failed is in SO_ERROR
+        int sockerr;
+        socklen_t sockerr_len = sizeof(sockerr);
+        if (sock->GetSockOpt(SOL_SOCKET, SO_ERROR, (sockopt_arg_type)&sockerr,
+                             &sockerr_len) == SOCKET_ERROR ||
+            sockerr != 0) {
+            probeFailed = true;
+            return;
+        }
+        connecting = false;
+        lastActivity = Now<NodeSeconds>();
+        PushVersion();
+        Send();
+        return;
+    }
+    if (events & (Sock::RECV | Sock::ERR)) {
+        // The socket events are edge triggered
+        if (!Receive(/*until_would_block=*/true)) {
+            probeFailed = true;
+            return;
+        }
+        lastActivity = Now<NodeSeconds>();
+        ProcessMessages();
+    }
+    Send();
+}
+
+bool CSeederNode::IsProbeDone(NodeSeconds now) {
+    if (probeFailed) {
+        return true;
+    }
+    if (connecting) {
+        if (now >= lastActivity + std::chrono::milliseconds{nConnectTimeout}) {
+            probeFailed = true;
+            return true;
+        }
+        return false;
+    }
+    if (!IsAwaitingMessages(now)) {
+        return true;
+    }
+    if (TicksSinceEpoch<std::chrono::seconds>(doneAfter) == 0 &&
+        now >= lastActivity + GetTimeout()) {
+        // Nothing was received for too long
+        probeFailed = true;
+        return true;
+    }
+    return false;
 }
@@ -8,6 +8,7 @@
 #include <chainparams.h>
 #include <protocol.h>
 #include <streams.h>
+#include <util/sock.h>
 #include <util/time.h>
 
 #include <chrono>
@@ -28,8 +29,6 @@ enum class PeerMessagingState {
     Finished,
 };
 
-class Sock;
-
 namespace {
 class CSeederNodeTest;
 }
@@ -51,6 +50,10 @@ private:
     ServiceFlags yourServices{ServiceFlags(NODE_NETWORK)};
     bool checkpointVerified{false};
     bool needAddrReply{false};
+    // State of the probes driven by the socket events
+    bool connecting{false};
+    bool probeFailed{false};
+    NodeSeconds lastActivity{NodeSeconds{0s}};
 
     std::chrono::seconds GetTimeout() { return you.IsTor() ? 120s : 30s; }
 
@@ -66,6 +69,16 @@ private:
 
     bool ProcessMessages();
 
+    bool IsAwaitingMessages(NodeSeconds now) const;
+
+    /**
+     * Read what was received, once or until the socket would block.
+     * Returns false if the connection was closed or failed.
+     */
+    bool Receive(bool until_would_block);
+
+    bool Finish(bool res);
+
 protected:
     PeerMessagingState ProcessMessage(std::string strCommand,
                                       CDataStream &recv);
@@ -73,8 +86,26 @@ protected:
 public:
     CSeederNode(const CService &ip, std::vector<CAddress> *vAddrIn);
 
+    /** Probe the node, blocking until done. Returns whether it is good. */
     bool Run();
 
+    /**
+     * Probe the node without blocking, driven by the events of its socket,
+     * so that a thread can probe many nodes at once. StartProbe() returns
+     * false if the node couldn't be probed this way, then Run() must be used.
+     * Once IsProbeDone(), FinishProbe() returns whether the node is good.
+     */
+    bool StartProbe();
+
+    /** The socket of a started probe, to wait for its events. */
+    const Sock &GetSock() const { return *sock; }
+
+    void OnSockEvents(Sock::Event events);
+
+    bool IsProbeDone(NodeSeconds now);
+
+    bool FinishProbe() { return Finish(!probeFailed); }
+
     int GetBan() { return ban; }
 
     int GetClientVersion() { return nVersion; }
@@ -185,54 +185,76 @@ void CAddrDb::Add_(const CAddress &addr, bool force) {
     unkId.insert(id);
 }
 
-void CAddrDb::GetIPs_(std::set<CNetAddr> &ips, uint64_t requestedFlags,
-                      uint32_t max, const bool *nets) {
+void CAddrDb::PublishIPs_() {
+    auto snapshot = std::make_shared<IPSnapshot>();
+    snapshot->time = GetTime();
     if (goodId.size() == 0) {
+        // Fall back to a single node that is not known to be good
         int id = -1;
-        if (ourId.size() == 0) {
-            if (unkId.size() == 0) {
-                return;
-            }
-            id = *unkId.begin();
-        } else {
+        if (ourId.size() != 0) {
             id = *ourId.begin();
+        } else if (unkId.size() != 0) {
+            id = *unkId.begin();
+        }
+        if (id >= 0) {
+            snapshot->nodes.emplace_back(idToInfo[id].ip,
+                                         idToInfo[id].services);
         }
+    } else {
+        snapshot->nodes.reserve(goodId.size());
+        for (auto &id : goodId) {
+            snapshot->nodes.emplace_back(idToInfo[id].ip,
+                                         idToInfo[id].services);
+        }
+    }
+    std::atomic_store(&ipSnapshot,
+                      std::shared_ptr<const IPSnapshot>{std::move(snapshot)});
+}
 
-        if (id >= 0 &&
-            (idToInfo[id].services & requestedFlags) == requestedFlags) {
-            ips.insert(idToInfo[id].ip);
+void CAddrDb::GetIPs(std::set<CNetAddr> &ips, uint64_t requestedFlags,
+                     uint32_t max, const bool *nets) {
+    auto snapshot = std::atomic_load(&ipSnapshot);
+    if (!snapshot) {
+        LOCK(cs);
+        PublishIPs_();
+        snapshot = std::atomic_load(&ipSnapshot);
+    } else if (snapshot->time + IP_SNAPSHOT_INTERVAL < GetTime()) {
+        // A DNS thread doesn't wait for the crawlers, another thread will
+        // publish the nodes if it can't right now.
+        TRY_LOCK(cs, lock);
+        if (lock) {
+            PublishIPs_();
+            snapshot = std::atomic_load(&ipSnapshot);
         }
-        return;
     }
 
-    std::vector<int> goodIdFiltered;
-    for (auto &id : goodId) {
-        if ((idToInfo[id].services & requestedFlags) == requestedFlags) {
-            goodIdFiltered.push_back(id);
+    std::vector<const CService *> nodesFiltered;
+    for (const auto &[ip, services] : snapshot->nodes) {
+        if ((services & requestedFlags) == requestedFlags) {
+            nodesFiltered.push_back(&ip);
         }
     }
 
-    if (!goodIdFiltered.size()) {
+    if (!nodesFiltered.size()) {
         return;
     }
 
-    if (max > goodIdFiltered.size() / 2) {
-        max = goodIdFiltered.size() / 2;
+    if (max > nodesFiltered.size() / 2) {
+        max = nodesFiltered.size() / 2;
     }
 
     if (max < 1) {
         max = 1;
     }
 
-    std::set<int> ids;
-    while (ids.size() < max) {
-        ids.insert(goodIdFiltered[rand() % goodIdFiltered.size()]);
+    std::set<const CService *> picked;
+    while (picked.size() < max) {
+        picked.insert(nodesFiltered[rand() % nodesFiltered.size()]);
     }
 
-    for (auto &id : ids) {
-        CService &ip = idToInfo[id].ip;
-        if (nets[ip.GetNetwork()]) {
-            ips.insert(ip);
+    for (const CService *ip : picked) {
+        if (nets[ip->GetNetwork()]) {
+            ips.insert(*ip);
         }
     }
 }
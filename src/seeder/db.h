@@ -18,11 +18,16 @@
 #include <cstdint>
 #include <deque>
 #include <map>
+#include <memory>
 #include <set>
+#include <utility>
 #include <vector>
 
 #define MIN_RETRY 1000
 
+// How often the nodes GetIPs() picks from are updated, in seconds
+static constexpr int64_t IP_SNAPSHOT_INTERVAL = 5;
+
 #define REQUIRE_VERSION 70001
 
 static inline int GetRequireHeight() {
@@ -297,6 +302,15 @@ private:
     // set of good nodes  (d, good e)
     std::set<int> goodId;
 
+    // The nodes GetIPs() picks from, along with their services, published
+    // so that the DNS threads don't need cs. Only read and written with
+    // std::atomic_load and std::atomic_store.
+    struct IPSnapshot {
+        std::vector<std::pair<CService, uint64_t>> nodes;
+        int64_t time;
+    };
+    std::shared_ptr<const IPSnapshot> ipSnapshot;
+
 protected:
     // internal routines that assume proper locks are acquired
     // add an address
@@ -311,9 +325,8 @@ protected:
     void Bad_(const CService &ip, int ban);
     // look up id of an IP
     int Lookup_(const CService &ip);
-    // get a random set of IPs (shared lock only)
-    void GetIPs_(std::set<CNetAddr> &ips, uint64_t requestedFlags, uint32_t max,
-                 const bool *nets);
+    // publish the good nodes for GetIPs
+    void PublishIPs_();
 
 public:
     // nodes that are banned, with their unban time (a)
@@ -452,11 +465,10 @@ public:
         }
     }
 
+    // get a random set of IPs, from the nodes that were good at most
+    // IP_SNAPSHOT_INTERVAL seconds ago
     void GetIPs(std::set<CNetAddr> &ips, uint64_t requestedFlags, uint32_t max,
-                const bool *nets) {
-        LOCK(cs);
-        GetIPs_(ips, requestedFlags, max, nets);
-    }
+                const bool *nets);
 };
 
 #endif // BITCOIN_SEEDER_DB_H
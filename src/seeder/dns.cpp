@@ -363,7 +363,50 @@ error:
     return error;
 }
 
-static ssize_t dnshandle(dns_opt_t *opt, const uint8_t *inbuf, size_t insize,
+// The records of the responses that only depend on the options, encoded once
+// by each server rather than for every query.
+struct dns_records_t {
+    // The NS record, ns_size is 0 if it doesn't fit
+    uint8_t ns[BUFLEN];
+    int ns_size;
+    // Room to leave for the authority section, NS or SOA
+    int max_auth_size;
+};
+
+static void init_records(const dns_opt_t *opt, dns_records_t *records) {
+    // The question name, which the records point to, always starts right
+    // after the header.
+    const int offset = 12;
+
+    uint8_t *pos = records->ns;
+    write_record_ns(&pos, records->ns + BUFLEN, "", offset, CLASS_IN,
+                    opt->nsttl, opt->ns);
+    records->ns_size = pos - records->ns;
+
+    // Only the serial of the SOA record changes, not its size
+    uint8_t soa[BUFLEN];
+    pos = soa;
+    write_record_soa(&pos, soa + BUFLEN, "", offset, CLASS_IN, opt->nsttl,
+                     opt->ns, opt->mbox, GetTime(), 604800, 86400, 2592000,
+                     604800);
+    records->max_auth_size = records->ns_size;
+    if (records->max_auth_size < pos - soa) {
+        records->max_auth_size = pos - soa;
+    }
+}
+
+static int write_cached_record(uint8_t **outpos, const uint8_t *outend,
+                               const uint8_t *record, int size) {
+    if (size == 0 || outend - *outpos < size) {
+        return -1;
+    }
+    memcpy(*outpos, record, size);
+    *outpos += size;
+    return 0;
+}
+
+static ssize_t dnshandle(dns_opt_t *opt, const dns_records_t *records,
+                         const uint8_t *inbuf, size_t insize,
                          uint8_t *outbuf) {
     DNSResponseCode responseCode = DNSResponseCode::OK;
     if (insize < 12) {
@@ -475,17 +518,7 @@ static ssize_t dnshandle(dns_opt_t *opt, const uint8_t *inbuf, size_t insize,
         if (!((typ == TYPE_NS || typ == QTYPE_ANY) &&
               (cls == CLASS_IN || cls == QCLASS_ANY))) {
             // authority section will be necessary, either NS or SOA
-            uint8_t *newpos = outpos;
-            write_record_ns(&newpos, outend, "", offset, CLASS_IN, 0, opt->ns);
-            max_auth_size = newpos - outpos;
-
-            newpos = outpos;
-            write_record_soa(&newpos, outend, "", offset, CLASS_IN, opt->nsttl,
-                             opt->ns, opt->mbox, GetTime(), 604800, 86400,
-                             2592000, 604800);
-            if (max_auth_size < newpos - outpos) {
-                max_auth_size = newpos - outpos;
-            }
+            max_auth_size = records->max_auth_size;
             //    tfm::format(std::cout, "Authority section will claim %i bytes
             //    max\n", max_auth_size);
         }
@@ -495,8 +528,8 @@ static ssize_t dnshandle(dns_opt_t *opt, const uint8_t *inbuf, size_t insize,
         // NS records
         if ((typ == TYPE_NS || typ == QTYPE_ANY) &&
             (cls == CLASS_IN || cls == QCLASS_ANY)) {
-            int ret2 = write_record_ns(&outpos, outend - max_auth_size, "",
-                                       offset, CLASS_IN, opt->nsttl, opt->ns);
+            int ret2 = write_cached_record(&outpos, outend - max_auth_size,
+                                           records->ns, records->ns_size);
             //    tfm::format(std::cout, "wrote NS record: %i\n", ret2);
             if (!ret2) {
                 outbuf[7]++;
@@ -550,8 +583,8 @@ static ssize_t dnshandle(dns_opt_t *opt, const uint8_t *inbuf, size_t insize,
 
         // Authority section
         if (!have_ns && outbuf[7]) {
-            int ret2 = write_record_ns(&outpos, outend, "", offset, CLASS_IN,
-                                       opt->nsttl, opt->ns);
+            int ret2 = write_cached_record(&outpos, outend, records->ns,
+                                           records->ns_size);
             //    tfm::format(std::cout, "wrote NS record: %i\n", ret2);
             if (!ret2) {
                 outbuf[9]++;
@@ -627,6 +660,8 @@ int dnsserver(dns_opt_t *opt) {
     }
 
     uint8_t inbuf[BUFLEN], outbuf[BUFLEN];
+    dns_records_t records;
+    init_records(opt, &records);
     struct iovec iov[1] = {
         {
             .iov_base = inbuf,
@@ -653,7 +688,7 @@ int dnsserver(dns_opt_t *opt) {
             continue;
         }
 
-        ssize_t ret = dnshandle(opt, inbuf, insize, outbuf);
+        ssize_t ret = dnshandle(opt, &records, inbuf, insize, outbuf);
         if (ret <= 0) {
             continue;
         }
@@ -13,6 +13,7 @@
 #include <seeder/options.h>
 #include <streams.h>
 #include <util/fs.h>
+#include <util/sockevents.h>
 #include <util/strencodings.h>
 #include <util/time.h>
 #include <util/translation.h>
@@ -24,6 +25,7 @@
 #include <cstdlib>
 #include <fstream>
 #include <functional>
+#include <memory>
 #include <pthread.h>
 
 const std::function<std::string(const char *)> G_TRANSLATION_FUN = nullptr;
@@ -34,8 +36,36 @@ extern "C" {
 
 CAddrDb db;
 
+// How long the crawler waits for the sockets of the nodes it is probing
+static constexpr auto CRAWLER_WAIT_INTERVAL{100ms};
+
+// Record the outcome of a probe
+static void SetProbeResult(CServiceResult &res, CSeederNode &node, bool ret) {
+    if (!ret) {
+        res.nBanTime = node.GetBan();
+    } else {
+        res.nBanTime = 0;
+    }
+    res.nClientV = node.GetClientVersion();
+    res.strClientV = node.GetClientSubVersion();
+    res.nHeight = node.GetStartingHeight();
+    res.services = node.GetServices();
+    res.checkpointVerified = node.IsCheckpointVerified();
+    // tfm::format(std::cout, "%s: %s!!!\n", cip.ToString(),
+    // ret ? "GOOD" : "BAD");
+    res.fGood = ret;
+}
+
+static void SetProbeFailed(CServiceResult &res) {
+    res.nBanTime = 0;
+    res.fGood = false;
+}
+
 extern "C" void *ThreadCrawler(void *data) {
     int *nThreads = (int *)data;
+    // The nodes are probed all at once, waiting for the events of their
+    // sockets, rather than one after the other.
+    SockEvents sock_events;
     do {
         std::vector<CServiceResult> ips;
         db.GetMany(ips, 16);
@@ -47,6 +77,8 @@ extern "C" void *ThreadCrawler(void *data) {
         }
 
         std::vector<CAddress> addr;
+        std::vector<std::unique_ptr<CSeederNode>> probes(ips.size());
+        std::vector<std::pair<size_t, std::unique_ptr<CSeederNode>>> blocking;
         for (size_t i = 0; i < ips.size(); i++) {
             CServiceResult &res = ips[i];
             res.nBanTime = 0;
@@ -55,25 +87,61 @@ extern "C" void *ThreadCrawler(void *data) {
             res.strClientV = "";
             res.services = 0;
             bool getaddr = res.ourLastSuccess + 86400 < now;
-            try {
-                CSeederNode node(res.service, getaddr ? &addr : nullptr);
-                bool ret = node.Run();
-                if (!ret) {
-                    res.nBanTime = node.GetBan();
+            auto node = std::make_unique<CSeederNode>(
+                res.service, getaddr ? &addr : nullptr);
+            if (!sock_events.IsValid() || !node->StartProbe()) {
+                blocking.emplace_back(i, std::move(node));
+            } else if (sock_events.Add(node->GetSock(),
+                                       Sock::RECV | Sock::SEND, i,
+                                       /*edge_triggered=*/true)) {
+                probes[i] = std::move(node);
+            } else {
+                SetProbeFailed(res);
+            }
+        }
+
+        // A probe is reset once its result is known
+        auto finish_probes = [&]() {
+            size_t pending{0};
+            const NodeSeconds now{Now<NodeSeconds>()};
+            for (size_t i = 0; i < ips.size(); i++) {
+                if (!probes[i]) {
+                    continue;
+                }
+                if (probes[i]->IsProbeDone(now)) {
+                    SetProbeResult(ips[i], *probes[i],
+                                   probes[i]->FinishProbe());
+                    probes[i].reset();
                 } else {
-                    res.nBanTime = 0;
+                    ++pending;
+                }
+            }
+            return pending;
+        };
+        std::vector<SockEvents::Occurred> occurred;
+        while (finish_probes() > 0) {
+            if (!sock_events.Wait(CRAWLER_WAIT_INTERVAL, occurred)) {
+                UninterruptibleSleep(CRAWLER_WAIT_INTERVAL);
+                continue;
+            }
+            for (const SockEvents::Occurred &event : occurred) {
+                try {
+                    if (probes[event.tag]) {
+                        probes[event.tag]->OnSockEvents(event.events);
+                    }
+                } catch (std::ios_base::failure &e) {
+                    SetProbeFailed(ips[event.tag]);
+                    probes[event.tag].reset();
                 }
-                res.nClientV = node.GetClientVersion();
-                res.strClientV = node.GetClientSubVersion();
-                res.nHeight = node.GetStartingHeight();
-                res.services = node.GetServices();
-                res.checkpointVerified = node.IsCheckpointVerified();
-                // tfm::format(std::cout, "%s: %s!!!\n", cip.ToString(),
-                // ret ? "GOOD" : "BAD");
-                res.fGood = ret;
+            }
+        }
+
+        // The nodes behind a proxy are probed one after the other
+        for (auto &[i, node] : blocking) {
+            try {
+                SetProbeResult(ips[i], *node, node->Run());
             } catch (std::ios_base::failure &e) {
-                res.nBanTime = 0;
-                res.fGood = false;
+                SetProbeFailed(ips[i]);
             }
         }
 
@@ -112,9 +180,13 @@ public:
         int64_t now = GetTime();
         FlagSpecificData &thisflag = perflag[requestedFlags];
         thisflag.cacheHits++;
+        // However many queries there are, the database is queried at most
+        // once a second for each flag, so that it is not contended by the
+        // DNS threads.
         if (force ||
-            thisflag.cacheHits * 400 >
-                (thisflag.cache.size() * thisflag.cache.size()) ||
+            (thisflag.cacheHits * 400 >
+                 (thisflag.cache.size() * thisflag.cache.size()) &&
+             now > thisflag.cacheTime) ||
             (thisflag.cacheHits * thisflag.cacheHits * 20 >
                  thisflag.cache.size() &&
              (now - thisflag.cacheTime > 5))) {
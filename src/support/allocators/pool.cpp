@@ -0,0 +1,45 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <support/allocators/pool.h>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+
+#include <atomic>
+
+namespace {
+std::atomic<bool> g_huge_pages{false};
+std::atomic<std::size_t> g_huge_page_bytes{0};
+} // namespace
+
+void SetPoolHugePages(bool enabled) {
+    g_huge_pages = enabled;
+}
+
+bool PoolHugePagesEnabled() {
+    return g_huge_pages;
+}
+
+std::size_t PoolHugePageBytes() {
+    return g_huge_page_bytes;
+}
+
+std::byte *AllocateHugePageRegion() {
+    void *region = ::operator new(POOL_HUGE_PAGE_SIZE,
+                                  std::align_val_t{POOL_HUGE_PAGE_SIZE});
+#ifdef MADV_HUGEPAGE
+    // This is only advice, the kernel may not have huge pages available.
+    madvise(region, POOL_HUGE_PAGE_SIZE, MADV_HUGEPAGE);
+#endif
+    g_huge_page_bytes += POOL_HUGE_PAGE_SIZE;
+    return static_cast<std::byte *>(region);
+}
+
+void FreeHugePageRegion(std::byte *region) {
+    g_huge_page_bytes -= POOL_HUGE_PAGE_SIZE;
+    ::operator delete(static_cast<void *>(region),
+                      std::align_val_t{POOL_HUGE_PAGE_SIZE});
+}
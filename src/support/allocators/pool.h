@@ -13,6 +13,24 @@
 #include <new>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+/** The size of the huge page regions the chunks of large pools come from. */
+static constexpr std::size_t POOL_HUGE_PAGE_SIZE{2 * 1024 * 1024};
+
+/**
+ * Have the pools that grew to at least POOL_HUGE_PAGE_SIZE carve their next
+ * chunks out of regions backed by transparent huge pages, when supported.
+ * Small and short lived pools, like the coins caches of a block, keep
+ * allocating chunks on their own. Only meant to be set at startup.
+ */
+void SetPoolHugePages(bool enabled);
+bool PoolHugePagesEnabled();
+/** The number of bytes of the huge page regions currently allocated. */
+std::size_t PoolHugePageBytes();
+/** Allocate a POOL_HUGE_PAGE_SIZE region aligned to its size. */
+std::byte *AllocateHugePageRegion();
+void FreeHugePageRegion(std::byte *region);
 
 /**
  * A memory resource similar to std::pmr::unsynchronized_pool_resource, but
@@ -131,6 +149,18 @@ class PoolResource final {
      */
     std::byte *m_available_memory_end = nullptr;
 
+    /**
+     * Whether the chunks are carved out of huge page regions, which once set
+     * holds for all the following chunks. The first m_num_plain_chunks of
+     * m_allocated_chunks were allocated on their own, the others belong to
+     * m_huge_regions.
+     */
+    bool m_use_huge_pages{false};
+    std::size_t m_num_plain_chunks{0};
+    std::vector<std::byte *> m_huge_regions{};
+    std::byte *m_region_it = nullptr;
+    std::byte *m_region_end = nullptr;
+
     /**
      * How many multiple of ELEM_ALIGN_BYTES are necessary to fit bytes. We use
      * that result directly as an index into m_free_lists.
@@ -175,8 +205,26 @@ class PoolResource final {
                 m_free_lists[remaining_available_bytes / ELEM_ALIGN_BYTES]);
         }
 
-        void *storage = ::operator new(m_chunk_size_bytes,
-                                       std::align_val_t{ELEM_ALIGN_BYTES});
+        m_use_huge_pages =
+            m_use_huge_pages ||
+            (PoolHugePagesEnabled() &&
+             POOL_HUGE_PAGE_SIZE % m_chunk_size_bytes == 0 &&
+             m_allocated_chunks.size() * m_chunk_size_bytes >=
+                 POOL_HUGE_PAGE_SIZE);
+        void *storage;
+        if (m_use_huge_pages) {
+            if (m_region_it == m_region_end) {
+                m_region_it = AllocateHugePageRegion();
+                m_region_end = m_region_it + POOL_HUGE_PAGE_SIZE;
+                m_huge_regions.push_back(m_region_it);
+            }
+            storage =
+                std::exchange(m_region_it, m_region_it + m_chunk_size_bytes);
+        } else {
+            storage = ::operator new(m_chunk_size_bytes,
+                                     std::align_val_t{ELEM_ALIGN_BYTES});
+            ++m_num_plain_chunks;
+        }
         m_available_memory_it = new (storage) std::byte[m_chunk_size_bytes];
         m_available_memory_end = m_available_memory_it + m_chunk_size_bytes;
         m_allocated_chunks.emplace_back(m_available_memory_it);
@@ -216,10 +264,16 @@ public:
      * Deallocates all memory allocated associated with the memory resource.
      */
     ~PoolResource() {
+        std::size_t num_chunks{0};
         for (std::byte *chunk : m_allocated_chunks) {
             std::destroy(chunk, chunk + m_chunk_size_bytes);
-            ::operator delete((void *)chunk,
-                              std::align_val_t{ELEM_ALIGN_BYTES});
+            if (num_chunks++ < m_num_plain_chunks) {
+                ::operator delete((void *)chunk,
+                                  std::align_val_t{ELEM_ALIGN_BYTES});
+            }
+        }
+        for (std::byte *region : m_huge_regions) {
+            FreeHugePageRegion(region);
         }
     }
 
@@ -6,14 +6,17 @@
 
 #include <logging.h>
 #include <tinyformat.h>
+#include <util/metrics.h>
 #include <util/strencodings.h>
 #include <util/threadnames.h>
 
 #include <tinyformat.h>
 
+#include <algorithm>
 #include <map>
 #include <mutex>
 #include <set>
+#include <string_view>
 #include <system_error>
 #include <thread>
 #include <type_traits>
@@ -340,3 +343,92 @@ bool LockStackEmpty() {
 bool g_debug_lockorder_abort = true;
 
 #endif /* DEBUG_LOCKORDER */
+
+std::atomic<bool> g_profile_lock_contention{false};
+
+namespace {
+struct ContendedSite {
+    uint64_t count{0};
+    std::chrono::microseconds total_wait{0};
+    std::chrono::microseconds max_wait{0};
+};
+
+struct ContendedLock {
+    metrics::Histogram wait;
+    std::map<std::pair<std::string, int>, ContendedSite> sites;
+};
+
+struct LockContention {
+    //! Not a Mutex, as it is taken while holding the contended lock and must
+    //! not be profiled itself.
+    std::mutex mutex;
+    std::map<std::string, ContendedLock, std::less<>> locks;
+};
+
+LockContention &GetLockContention() {
+    static LockContention contention;
+    return contention;
+}
+} // namespace
+
+void RecordLockContention(const char *pszName, const char *pszFile, int nLine,
+                          std::chrono::microseconds wait) {
+    LockContention &contention{GetLockContention()};
+    std::lock_guard<std::mutex> lock{contention.mutex};
+    auto it = contention.locks.find(std::string_view{pszName});
+    if (it == contention.locks.end()) {
+        it = contention.locks.try_emplace(pszName).first;
+    }
+    ContendedLock &contended{it->second};
+    contended.wait.Record(wait);
+    ContendedSite &site{contended.sites[{pszFile, nLine}]};
+    ++site.count;
+    site.total_wait += wait;
+    site.max_wait = std::max(site.max_wait, wait);
+}
+
+std::vector<LockContentionStats> GetLockContentionStats(size_t max_sites) {
+    // Shorten the absolute paths of the source files
+    auto source_location = [](const std::string &file, int line) {
+        const size_t pos{file.rfind("/src/")};
+        return strprintf("%s:%d",
+                         pos == std::string::npos ? file : file.substr(pos + 5),
+                         line);
+    };
+
+    std::vector<LockContentionStats> ret;
+    LockContention &contention{GetLockContention()};
+    std::lock_guard<std::mutex> lock{contention.mutex};
+    for (const auto &[name, contended] : contention.locks) {
+        const metrics::Histogram::Snapshot wait{contended.wait.GetSnapshot()};
+        LockContentionStats &stats{ret.emplace_back()};
+        stats.name = name;
+        stats.count = wait.count;
+        stats.total_wait = std::chrono::microseconds{wait.sum};
+        stats.max_wait = std::chrono::microseconds{wait.max};
+        stats.wait_p50 = std::chrono::microseconds{wait.Quantile(0.5)};
+        stats.wait_p90 = std::chrono::microseconds{wait.Quantile(0.9)};
+        stats.wait_p99 = std::chrono::microseconds{wait.Quantile(0.99)};
+        for (const auto &[file_line, site] : contended.sites) {
+            stats.sites.push_back(
+                {source_location(file_line.first, file_line.second),
+                 site.count, site.total_wait, site.max_wait});
+        }
+        std::sort(stats.sites.begin(), stats.sites.end(),
+                  [](const LockContentionSite &a, const LockContentionSite &b) {
+                      return a.total_wait > b.total_wait;
+                  });
+        stats.sites.resize(std::min(stats.sites.size(), max_sites));
+    }
+    std::sort(ret.begin(), ret.end(),
+              [](const LockContentionStats &a, const LockContentionStats &b) {
+                  return a.total_wait > b.total_wait;
+              });
+    return ret;
+}
+
+void ResetLockContentionStats() {
+    LockContention &contention{GetLockContention()};
+    std::lock_guard<std::mutex> lock{contention.mutex};
+    contention.locks.clear();
+}
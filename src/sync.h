@@ -14,10 +14,14 @@
 #include <threadsafety.h>
 #include <util/macros.h>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 /////////////////////////////////////////////////
 //                                             //
@@ -96,6 +100,43 @@ inline bool LockStackEmpty() {
 }
 #endif
 
+/**
+ * Whether to record how long the LOCKs wait for the contended mutexes. This
+ * only costs an atomic load when a try_lock fails, so it can be turned on in
+ * production.
+ */
+extern std::atomic<bool> g_profile_lock_contention;
+void RecordLockContention(const char *pszName, const char *pszFile, int nLine,
+                          std::chrono::microseconds wait);
+
+struct LockContentionSite {
+    //! file:line of the LOCK
+    std::string location;
+    uint64_t count;
+    std::chrono::microseconds total_wait;
+    std::chrono::microseconds max_wait;
+};
+
+/** The contention of the mutexes locked under this name. */
+struct LockContentionStats {
+    std::string name;
+    uint64_t count;
+    std::chrono::microseconds total_wait;
+    std::chrono::microseconds max_wait;
+    std::chrono::microseconds wait_p50;
+    std::chrono::microseconds wait_p90;
+    std::chrono::microseconds wait_p99;
+    //! The call sites that waited the longest in total, longest first
+    std::vector<LockContentionSite> sites;
+};
+
+/**
+ * The contention recorded since the last reset, the mutexes waited for the
+ * longest in total first.
+ */
+std::vector<LockContentionStats> GetLockContentionStats(size_t max_sites);
+void ResetLockContentionStats();
+
 /**
  * Template mixin that adds -Wthread-safety locking annotations and lock order
  * checking to a subset of the mutex API.
@@ -169,15 +210,24 @@ class SCOPED_LOCKABLE UniqueLock : public Base {
 private:
     void Enter(const char *pszName, const char *pszFile, int nLine) {
         EnterCritical(pszName, pszFile, nLine, Base::mutex());
-#ifdef DEBUG_LOCKCONTENTION
         if (Base::try_lock()) {
             return;
         }
+#ifdef DEBUG_LOCKCONTENTION
         LOG_TIME_MICROS_WITH_CATEGORY(
             strprintf("lock contention %s, %s:%d", pszName, pszFile, nLine),
             BCLog::LOCK);
 #endif
+        if (!g_profile_lock_contention.load(std::memory_order_relaxed)) {
+            Base::lock();
+            return;
+        }
+        const auto start{std::chrono::steady_clock::now()};
         Base::lock();
+        RecordLockContention(
+            pszName, pszFile, nLine,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start));
     }
 
     bool TryEnter(const char *pszName, const char *pszFile, int nLine) {
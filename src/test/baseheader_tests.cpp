@@ -4,6 +4,7 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <hash.h>
 #include <primitives/baseheader.h>
 #include <streams.h>
 #include <util/strencodings.h>
@@ -25,6 +26,10 @@ BOOST_AUTO_TEST_CASE(genesis) {
     BOOST_CHECK_EQUAL(
         genesis.GetPowHash().ToString(),
         "0000026f3f7874ca0c251314eaed2d2fcf83d7da3acfaacf59417d485310b448");
+    const auto [hash, powHash] = genesis.GetHashes();
+    BOOST_CHECK(hash == genesis.GetHash());
+    BOOST_CHECK(powHash == genesis.GetPowHash());
+    BOOST_CHECK(hash == BlockHash(SerializeHash(genesis)));
 
     // Check serialization
     CDataStream ss(0, 0);
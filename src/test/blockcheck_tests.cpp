@@ -11,6 +11,10 @@
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include <boost/test/unit_test.hpp>
 
 BOOST_FIXTURE_TEST_SUITE(blockcheck_tests, BasicTestingSetup)
@@ -101,4 +105,83 @@ BOOST_AUTO_TEST_CASE(blockfail) {
     RunCheckOnBlock(config, block, "bad-blk-length");
 }
 
+BOOST_FIXTURE_TEST_CASE(first_invalid_transaction, ChainTestingSetup) {
+    GlobalConfig config;
+    config.SetMaxBlockSize(DEFAULT_MAX_BLOCK_SIZE);
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig.resize(10);
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = 42 * SATOSHI;
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 42 * SATOSHI;
+
+    // Enough transactions to be checked in several chunks, by the workers
+    const auto make_block = [&](size_t no_input_pos, size_t no_output_pos) {
+        CBlock block;
+        block.vtx.push_back(MakeTransactionRef(coinbase));
+        for (size_t i = 1; i < 1000; i++) {
+            CMutableTransaction mtx{tx};
+            mtx.vin[0].prevout = InsecureRandOutPoint();
+            if (i == no_input_pos) {
+                mtx.vin.clear();
+            }
+            if (i == no_output_pos) {
+                mtx.vout.clear();
+            }
+            block.vtx.push_back(MakeTransactionRef(mtx));
+        }
+        return block;
+    };
+
+    RunCheckOnBlock(config, make_block(0, 0));
+    // Whichever chunk is checked first, the error of the first invalid
+    // transaction is reported
+    for (int i = 0; i < 10; i++) {
+        RunCheckOnBlock(config, make_block(100, 900), "bad-txns-vin-empty");
+        RunCheckOnBlock(config, make_block(900, 100), "bad-txns-vout-empty");
+        RunCheckOnBlock(config, make_block(999, 998), "bad-txns-vout-empty");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(checked_block_concurrently) {
+    const GlobalConfig config;
+    const Consensus::Params &params = config.GetChainParams().GetConsensus();
+    CBlock block{config.GetChainParams().GenesisBlock()};
+    block.fChecked = false;
+
+    // The context free checks don't need cs_main and can run on the same
+    // block from several threads.
+    std::atomic<int> num_valid{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            BlockValidationState state;
+            if (CheckBlock(block, state, params,
+                           BlockValidationOptions(config))) {
+                ++num_valid;
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(num_valid, 4);
+    BOOST_CHECK(block.fChecked);
+
+    // The flag is carried over by copies and moves.
+    CBlock copy{block};
+    BOOST_CHECK(copy.fChecked);
+    CBlock moved{std::move(copy)};
+    BOOST_CHECK(moved.fChecked);
+    BOOST_CHECK_EQUAL(moved.GetHash(), block.GetHash());
+    CBlock assigned;
+    assigned = moved;
+    BOOST_CHECK(assigned.fChecked);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,8 +8,10 @@
 #include <config.h>
 #include <consensus/merkle.h>
 #include <pow/pow.h>
+#include <primitives/auxpow.h>
 #include <streams.h>
 #include <txmempool.h>
+#include <util/strencodings.h>
 #include <validation.h>
 
 #include <test/util/random.h>
@@ -371,6 +373,49 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(BlockViewTest) {
+    CBlock block(BuildBlockTestCase());
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << block;
+    const std::vector<uint8_t> data{UCharCast(stream.data()),
+                                    UCharCast(stream.data() + stream.size())};
+
+    BlockView view;
+    BOOST_REQUIRE(view.Parse(data));
+    BOOST_CHECK_EQUAL(view.header.GetHash(), block.GetHash());
+    BOOST_REQUIRE_EQUAL(view.vtx.size(), block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        BOOST_CHECK_EQUAL(view.vtx[i].GetId(), block.vtx[i]->GetId());
+        BOOST_CHECK_EQUAL(view.vtx[i].GetTotalSize(),
+                          block.vtx[i]->GetTotalSize());
+        BOOST_CHECK_EQUAL(view.vtx[i].ToTransactionRef()->GetId(),
+                          block.vtx[i]->GetId());
+    }
+
+    // The blocktxn message is the same as built from the deserialized block.
+    BlockTransactions resp;
+    resp.blockhash = block.GetHash();
+    resp.txn = {block.vtx[2], block.vtx[1]};
+    std::vector<TransactionView> txn{view.vtx[2], view.vtx[1]};
+    CDataStream expected(SER_NETWORK, PROTOCOL_VERSION);
+    expected << resp;
+    CDataStream actual(SER_NETWORK, PROTOCOL_VERSION);
+    actual << resp.blockhash
+           << Using<VectorFormatter<TransactionCompression>>(txn);
+    BOOST_CHECK_EQUAL(HexStr(actual), HexStr(expected));
+
+    CBlockHeaderAndShortTxIDs shortIDs(view);
+    BOOST_CHECK_EQUAL(shortIDs.BlockTxCount(), block.vtx.size());
+    BOOST_CHECK_EQUAL(shortIDs.header.GetHash(), block.GetHash());
+
+    // Truncated data or trailing garbage is rejected.
+    BOOST_CHECK(!view.Parse(Span{data}.first(data.size() - 1)));
+    BOOST_CHECK(view.vtx.empty());
+    std::vector<uint8_t> extended{data};
+    extended.push_back(0);
+    BOOST_CHECK(!view.Parse(extended));
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = BlockHash(InsecureRand256());
@@ -627,4 +672,80 @@ BOOST_AUTO_TEST_CASE(compactblock_overflow) {
     }
 }
 
+static CBlockHeader BuildAuxPowHeaderTestCase(uint32_t nExtraNonce) {
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << nExtraNonce
+                                          << std::vector<uint8_t>(200, 0x42);
+    coinbase.vout.resize(3);
+    for (CTxOut &out : coinbase.vout) {
+        out.nValue = 50 * COIN;
+        out.scriptPubKey = CScript() << std::vector<uint8_t>(25, 0x17);
+    }
+
+    CBlockHeader header;
+    header.nVersion = VersionWithAuxPow(MakeVersionWithChainId(0x62, 4), true);
+    header.hashPrevBlock = BlockHash(InsecureRand256());
+    header.hashMerkleRoot = InsecureRand256();
+    header.nBits = 0x207fffff;
+    header.auxpow = std::make_shared<CAuxPow>();
+    CAuxPow &auxpow = *header.auxpow;
+    auxpow.coinbaseTx = MakeTransactionRef(coinbase);
+    auxpow.vMerkleBranch = {InsecureRand256(), InsecureRand256()};
+    auxpow.nIndex = 0;
+    auxpow.vChainMerkleBranch = {InsecureRand256()};
+    auxpow.nChainIndex = 1;
+    auxpow.parentBlock.nVersion = 0x20000000;
+    auxpow.parentBlock.hashPrevBlock = BlockHash(InsecureRand256());
+    auxpow.parentBlock.hashMerkleRoot = ComputeMerkleRootForBranch(
+        auxpow.coinbaseTx->GetHash(), auxpow.vMerkleBranch, auxpow.nIndex);
+    auxpow.parentBlock.nTime = nExtraNonce;
+    auxpow.parentBlock.nBits = 0x1b00ffff;
+    auxpow.parentBlock.nNonce = InsecureRand32();
+    auxpow.hashBlock = auxpow.parentBlock.GetHash();
+    return header;
+}
+
+BOOST_AUTO_TEST_CASE(CompactAuxPowHeadersTest) {
+    std::vector<CBlockHeader> headers;
+    for (uint32_t i = 0; i < 10; ++i) {
+        headers.push_back(BuildAuxPowHeaderTestCase(i));
+    }
+
+    // Legacy header, without auxpow
+    CBlockHeader legacy = BuildBlockTestCase().GetBlockHeader();
+    headers.insert(headers.begin() + 3, legacy);
+
+    // Fields that can't be derived are sent as is
+    CAuxPow &auxpow = *headers[5].auxpow;
+    auxpow.hashBlock = InsecureRand256();
+    auxpow.nIndex = 1;
+    auxpow.parentBlock.hashMerkleRoot = InsecureRand256();
+    headers[6].auxpow->hashBlock.SetNull();
+
+    CDataStream headersStream(SER_NETWORK, PROTOCOL_VERSION);
+    headersStream << headers;
+    CDataStream compactStream(SER_NETWORK, PROTOCOL_VERSION);
+    compactStream << CompactAuxPowHeaders{headers};
+    BOOST_CHECK_LT(compactStream.size(), headersStream.size() / 2);
+
+    CompactAuxPowHeaders decoded;
+    compactStream >> decoded;
+    BOOST_CHECK(compactStream.empty());
+    CDataStream decodedStream(SER_NETWORK, PROTOCOL_VERSION);
+    decodedStream << decoded.headers;
+    BOOST_CHECK_EQUAL(HexStr(decodedStream), HexStr(headersStream));
+    BOOST_CHECK(!decoded.headers[3].auxpow);
+
+    // Reusing more of the previous coinbase than there is is invalid
+    CDataStream bogus(SER_NETWORK, PROTOCOL_VERSION);
+    WriteCompactSize(bogus, 1);
+    bogus << static_cast<const CBaseBlockHeader &>(headers[0]) << uint8_t{0};
+    WriteCompactSize(bogus, 1);
+    WriteCompactSize(bogus, 0);
+    CompactAuxPowHeaders bogusDecoded;
+    BOOST_CHECK_EXCEPTION(bogus >> bogusDecoded, std::ios_base::failure,
+                          HasReason("compact auxpow coinbase out of range"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
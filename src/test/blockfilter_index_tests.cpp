@@ -299,6 +299,19 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync,
     BOOST_CHECK(tip->nHeight >= 0);
     BOOST_CHECK_EQUAL(filters.size(), tip->nHeight + 1U);
     BOOST_CHECK_EQUAL(filter_hashes.size(), tip->nHeight + 1U);
+    for (size_t i = 0; i < filters.size(); ++i) {
+        BOOST_CHECK_EQUAL(filters[i].GetHash(), filter_hashes[i]);
+    }
+
+    // The same filters are served from the cache the second time around
+    std::vector<BlockFilter> cached_filters;
+    BOOST_CHECK(filter_index.LookupFilterRange(0, tip, cached_filters));
+    BOOST_REQUIRE_EQUAL(cached_filters.size(), filters.size());
+    for (size_t i = 0; i < filters.size(); ++i) {
+        BOOST_CHECK_EQUAL(cached_filters[i].GetHash(), filters[i].GetHash());
+        BOOST_CHECK_EQUAL(cached_filters[i].GetBlockHash(),
+                          filters[i].GetBlockHash());
+    }
 
     filters.clear();
     filter_hashes.clear();
@@ -3,15 +3,30 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <node/blockcompression.h>
 #include <node/blockstorage.h>
+#include <streams.h>
 #include <node/context.h>
+#include <txdb.h>
+#include <undo.h>
 #include <validation.h>
+#include <validationthreadpool.h>
 
 #include <boost/test/unit_test.hpp>
+#include <test/util/poolresourcetester.h>
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
+#include <limits>
+#include <unordered_map>
+
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
+using node::BlockCompressionSupported;
 using node::BlockManager;
+using node::BlockMap;
+using node::BlockMapMemoryResource;
+using node::CompressBlock;
+using node::DecompressBlock;
 using node::MAX_BLOCKFILE_SIZE;
 
 // use BasicTestingSetup here for the data directory configuration, setup, and
@@ -57,6 +72,147 @@ BOOST_AUTO_TEST_CASE(blockmanager_find_block_pos) {
             BLOCK_SERIALIZATION_HEADER_SIZE);
 }
 
+BOOST_AUTO_TEST_CASE(blockmanager_compressed_blocks) {
+    const auto params{CreateChainParams(*m_node.args, CBaseChainParams::MAIN)};
+    // A block that compresses well.
+    CBlock block{params->GenesisBlock()};
+    CMutableTransaction mtx{*block.vtx[0]};
+    mtx.vout[0].scriptPubKey = CScript() << std::vector<uint8_t>(10000, 0x42);
+    block.vtx[0] = MakeTransactionRef(mtx);
+    std::vector<uint8_t> serialized;
+    CVectorWriter{SER_DISK, CLIENT_VERSION, serialized, 0, block};
+
+    std::vector<uint8_t> compressed;
+    if (!BlockCompressionSupported()) {
+        BOOST_CHECK(!CompressBlock(serialized, 3, compressed));
+        return;
+    }
+    BOOST_CHECK(CompressBlock(serialized, 3, compressed));
+    BOOST_CHECK(compressed.size() < serialized.size());
+    std::vector<uint8_t> decompressed;
+    BOOST_CHECK(DecompressBlock(compressed, decompressed));
+    BOOST_CHECK(decompressed == serialized);
+    BOOST_CHECK(!DecompressBlock(Span{compressed}.first(10), decompressed));
+    // Blocks that would not get smaller are not compressed.
+    BOOST_CHECK(!CompressBlock(Span{compressed}, 3, decompressed));
+
+    BlockManager::Options blockman_opts{
+        .chainparams = *params,
+        .blocks_dir = m_args.GetBlocksDirPath(),
+    };
+    blockman_opts.block_compression_level = 3;
+    BlockManager blockman{blockman_opts};
+    CChain chain{};
+    const FlatFilePos pos{blockman.SaveBlockToDisk(block, 0, chain, nullptr)};
+    BOOST_CHECK_EQUAL(pos.nPos, BLOCK_SERIALIZATION_HEADER_SIZE);
+    // The blocks follow each other, however they are stored.
+    const FlatFilePos next{
+        blockman.SaveBlockToDisk(params->GenesisBlock(), 1, chain, nullptr)};
+    BOOST_CHECK_EQUAL(next.nPos, pos.nPos + compressed.size() +
+                                     BLOCK_SERIALIZATION_HEADER_SIZE);
+
+    CBlock read;
+    BOOST_CHECK(blockman.ReadBlockFromDisk(read, pos, false));
+    BOOST_CHECK_EQUAL(read.GetHash(), block.GetHash());
+    BOOST_CHECK(*read.vtx[0] == *block.vtx[0]);
+    BOOST_CHECK(blockman.ReadBlockFromDisk(read, next, false));
+    BOOST_CHECK_EQUAL(read.GetHash(), params->GenesisBlock().GetHash());
+
+    std::vector<uint8_t> raw;
+    BOOST_CHECK(blockman.ReadRawBlockFromDisk(raw, pos));
+    BOOST_CHECK(raw == serialized);
+
+    CBlockHeader header;
+    CMutableTransaction tx;
+    BOOST_CHECK(blockman.ReadBlockHeaderFromDisk(header, pos, false));
+    BOOST_CHECK_EQUAL(header.GetHash(), block.GetHash());
+    // The coinbase follows the number of transactions.
+    BOOST_CHECK(blockman.ReadBlockTxFromDisk(header, tx, pos, 1));
+    BOOST_CHECK_EQUAL(header.GetHash(), block.GetHash());
+    BOOST_CHECK(CTransaction(tx) == *block.vtx[0]);
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_load_block_index_guts) {
+    // Enough headers to be hashed by several jobs.
+    const int num_blocks{5000};
+    std::vector<BlockHash> hashes(num_blocks);
+    std::vector<CBlockIndex> indices;
+    indices.reserve(num_blocks);
+    for (int i = 0; i < num_blocks; ++i) {
+        CBlockHeader header;
+        header.hashPrevBlock = i > 0 ? hashes[i - 1] : BlockHash{};
+        header.nTime = i;
+        header.nBits = 0x207fffff;
+        header.nNonce = InsecureRand32();
+        hashes[i] = header.GetHash();
+        CBlockIndex &index{indices.emplace_back(header)};
+        index.phashBlock = &hashes[i];
+        index.pprev = i > 0 ? &indices[i - 1] : nullptr;
+        index.nHeight = i;
+    }
+    std::vector<const CBlockIndex *> blockinfo;
+    for (const CBlockIndex &index : indices) {
+        blockinfo.push_back(&index);
+    }
+
+    CBlockTreeDB db{DBParams{.path = m_args.GetDataDirNet() / "blocks_index",
+                             .cache_bytes = 1 << 20,
+                             .memory_only = true}};
+    BOOST_CHECK(db.Upgrade());
+    BOOST_CHECK(db.WriteBatchSync({}, 0, blockinfo));
+
+    // The same entries are loaded with and without threads.
+    ValidationThreadPool pool;
+    for (int threads : {0, 3}) {
+        pool.Start(threads);
+        std::unordered_map<BlockHash, CBlockIndex, BlockHasher> loaded;
+        {
+            LOCK(cs_main);
+            BOOST_CHECK(db.LoadBlockIndexGuts(
+                Params().GetConsensus(),
+                [&](const BlockHash &hash) -> CBlockIndex * {
+                    if (hash.IsNull()) {
+                        return nullptr;
+                    }
+                    auto [it, inserted] = loaded.try_emplace(hash);
+                    it->second.phashBlock = &it->first;
+                    return &it->second;
+                },
+                pool));
+        }
+        pool.Stop();
+
+        BOOST_CHECK_EQUAL(loaded.size(), num_blocks);
+        for (int i = 0; i < num_blocks; ++i) {
+            const auto it{loaded.find(hashes[i])};
+            BOOST_REQUIRE(it != loaded.end());
+            BOOST_CHECK_EQUAL(it->second.nHeight, i);
+            BOOST_CHECK_EQUAL(it->second.nNonce, indices[i].nNonce);
+            if (i > 0) {
+                BOOST_REQUIRE(it->second.pprev);
+                BOOST_CHECK(it->second.pprev->GetBlockHash() == hashes[i - 1]);
+            } else {
+                BOOST_CHECK(!it->second.pprev);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_block_index_resource_is_used) {
+    BlockMapMemoryResource resource;
+    {
+        BlockMap map{0, BlockMap::hasher{}, BlockMap::key_equal{}, &resource};
+        for (int i = 0; i < 1000; ++i) {
+            map[BlockHash{InsecureRand256()}];
+        }
+        // The entries are all allocated from the chunks of the resource.
+        BOOST_CHECK(resource.NumAllocatedChunks() > 0);
+        BOOST_CHECK(resource.NumAllocatedChunks() * resource.ChunkSizeBytes() >=
+                    1000 * sizeof(BlockMap::value_type));
+    }
+    PoolResourceTester::CheckAllDataAccountedFor(resource);
+}
+
 BOOST_FIXTURE_TEST_CASE(blockmanager_scan_unlink_already_pruned_files,
                         TestChain100Setup) {
     // Cap last block file size, and mine new block in a new block file.
@@ -103,4 +259,142 @@ BOOST_FIXTURE_TEST_CASE(blockmanager_scan_unlink_already_pruned_files,
     BOOST_CHECK(!AutoFile(blockman.OpenBlockFile(new_pos, true)).IsNull());
 }
 
+BOOST_FIXTURE_TEST_CASE(blockmanager_read_block_file_for_reindex,
+                        TestChain100Setup) {
+    const auto &chainman = Assert(m_node.chainman);
+    auto &blockman = chainman->m_blockman;
+    const auto blocks{
+        blockman.ReadBlockFileForReindex(0, chainman->GetConfig())};
+    BOOST_REQUIRE(blocks);
+
+    // The genesis block and the 100 blocks of the chain, in order
+    LOCK(chainman->GetMutex());
+    const CChain &chain{chainman->ActiveChain()};
+    BOOST_REQUIRE_EQUAL(blocks->size(), chain.Height() + 1);
+    for (int height = 0; height <= chain.Height(); ++height) {
+        const auto &[block, pos] = (*blocks)[height];
+        BOOST_CHECK(block->GetHash() == chain[height]->GetBlockHash());
+        BOOST_CHECK(pos == chain[height]->GetBlockPos());
+        // The blocks are already checked
+        BOOST_CHECK(block->fChecked);
+    }
+
+    // The file doesn't exist
+    BOOST_CHECK(!blockman.ReadBlockFileForReindex(1, chainman->GetConfig()));
+}
+
+struct PruneUndoSetup : public TestChain100Setup {
+    PruneUndoSetup()
+        : TestChain100Setup{CBaseChainParams::REGTEST, {"-pruneundo=288"}} {}
+};
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_prune_undo, PruneUndoSetup) {
+    // Mine the next block in a new block file, so the older one is complete
+    const auto &chainman = Assert(m_node.chainman);
+    auto &blockman = chainman->m_blockman;
+    const CBlockIndex *old_tip{
+        WITH_LOCK(chainman->GetMutex(), return chainman->ActiveChain().Tip())};
+    WITH_LOCK(chainman->GetMutex(),
+              blockman.GetBlockFileInfo(old_tip->GetBlockPos().nFile)->nSize =
+                  MAX_BLOCKFILE_SIZE);
+    const int file_number{
+        WITH_LOCK(chainman->GetMutex(), return old_tip->GetBlockPos().nFile)};
+    const fs::path undo_file{m_args.GetBlocksDirPath() /
+                             strprintf("rev%05u.dat", file_number)};
+    BOOST_CHECK(fs::exists(undo_file));
+
+    const auto prune_and_check = [&](bool pruned) {
+        chainman->ActiveChainstate().PruneAndFlush();
+        // The files are unlinked in the background
+        blockman.WaitForUnlink(file_number);
+        CBlockUndo undo;
+        BOOST_CHECK_EQUAL(blockman.UndoReadFromDisk(undo, *old_tip), !pruned);
+        BOOST_CHECK_EQUAL(fs::exists(undo_file), !pruned);
+        BOOST_CHECK_EQUAL(WITH_LOCK(chainman->GetMutex(),
+                                    return old_tip->nStatus.hasUndo()),
+                          !pruned);
+        // The block itself is kept
+        CBlock block;
+        BOOST_CHECK(blockman.ReadBlockFromDisk(block, *old_tip));
+    };
+
+    // The undo data is deleted once all the blocks of the file are deep enough
+    const CScript script{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+    for (int i = 0; i < 287; ++i) {
+        CreateAndProcessBlock({}, script);
+    }
+    prune_and_check(false);
+    CreateAndProcessBlock({}, script);
+
+    // Not while an index needs it
+    WITH_LOCK(chainman->GetMutex(),
+              blockman.UpdatePruneLock("test", {old_tip->nHeight}));
+    prune_and_check(false);
+    WITH_LOCK(chainman->GetMutex(),
+              blockman.UpdatePruneLock(
+                  "test", {std::numeric_limits<int>::max()}));
+    prune_and_check(true);
+
+    // The undo data of the new blocks is kept
+    const CBlockIndex *tip{
+        WITH_LOCK(chainman->GetMutex(), return chainman->ActiveChain().Tip())};
+    CBlockUndo undo;
+    BOOST_CHECK(blockman.UndoReadFromDisk(undo, *tip));
+}
+
+struct ManualPruneSetup : public TestChain100Setup {
+    ManualPruneSetup()
+        : TestChain100Setup{CBaseChainParams::REGTEST, {"-prune=1"}} {}
+};
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_prune_files_in_background,
+                        ManualPruneSetup) {
+    // Spread the chain over two complete block files and a last one
+    const auto &chainman = Assert(m_node.chainman);
+    auto &blockman = chainman->m_blockman;
+    const CScript script{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+    std::vector<const CBlockIndex *> tips;
+    for (int i = 0; i < 2; ++i) {
+        tips.push_back(WITH_LOCK(chainman->GetMutex(),
+                                 return chainman->ActiveChain().Tip()));
+        WITH_LOCK(chainman->GetMutex(),
+                  blockman.GetBlockFileInfo(tips.back()->GetBlockPos().nFile)
+                      ->nSize = MAX_BLOCKFILE_SIZE);
+        CreateAndProcessBlock({}, script);
+    }
+    const int first_file{
+        WITH_LOCK(chainman->GetMutex(), return tips[0]->GetBlockPos().nFile)};
+    const int second_file{
+        WITH_LOCK(chainman->GetMutex(), return tips[1]->GetBlockPos().nFile)};
+    BOOST_CHECK_EQUAL(second_file, first_file + 1);
+
+    // Both files are pruned in a single pass over the block index
+    const std::set<int> files{first_file, second_file};
+    {
+        LOCK(chainman->GetMutex());
+        blockman.PruneBlockFiles(files);
+        for (const CBlockIndex *pindex : tips) {
+            BOOST_CHECK(!pindex->nStatus.hasData());
+            BOOST_CHECK(!pindex->nStatus.hasUndo());
+        }
+        BOOST_CHECK_EQUAL(blockman.GetBlockFileInfo(first_file)->nSize, 0U);
+        BOOST_CHECK_EQUAL(blockman.GetBlockFileInfo(second_file)->nSize, 0U);
+    }
+
+    blockman.UnlinkPrunedFiles(files);
+    for (const int file : files) {
+        blockman.WaitForUnlink(file);
+        BOOST_CHECK(
+            AutoFile(blockman.OpenBlockFile({file, 0}, true)).IsNull());
+        BOOST_CHECK(!fs::exists(m_args.GetBlocksDirPath() /
+                                strprintf("rev%05u.dat", file)));
+    }
+
+    // The last block file is kept
+    const CBlockIndex *tip{
+        WITH_LOCK(chainman->GetMutex(), return chainman->ActiveChain().Tip())};
+    CBlock block;
+    BOOST_CHECK(blockman.ReadBlockFromDisk(block, *tip));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -133,4 +133,31 @@ BOOST_AUTO_TEST_CASE(sighash_construction_test) {
     CheckHaveDataAndUndo(BlockStatus());
 }
 
+BOOST_AUTO_TEST_CASE(checked_pow_flag_test) {
+    const BlockStatus s = BlockStatus().withData().withUndo();
+    BOOST_CHECK(!s.hasCheckedPoW());
+
+    const BlockStatus checked = s.withCheckedPoW();
+    BOOST_CHECK(checked.hasCheckedPoW());
+    // The other flags are left untouched.
+    CheckBlockStatus(checked, BlockValidity::UNKNOWN, true, true, false, false,
+                     false, false);
+    BOOST_CHECK(checked.withCheckedPoW(false) == s);
+    BOOST_CHECK(checked.withData(false).hasCheckedPoW());
+}
+
+BOOST_AUTO_TEST_CASE(checked_scripts_flag_test) {
+    const BlockStatus s = BlockStatus().withData().withUndo();
+    BOOST_CHECK(!s.hasCheckedScripts());
+
+    const BlockStatus checked = s.withCheckedScripts();
+    BOOST_CHECK(checked.hasCheckedScripts());
+    // The other flags are left untouched.
+    CheckBlockStatus(checked, BlockValidity::UNKNOWN, true, true, false, false,
+                     false, false);
+    BOOST_CHECK(!checked.hasCheckedPoW());
+    BOOST_CHECK(checked.withCheckedScripts(false) == s);
+    BOOST_CHECK(checked.withFailed().withClearedFailureFlags() == checked);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
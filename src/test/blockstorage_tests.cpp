@@ -5,6 +5,7 @@
 #include <chainparams.h>
 #include <config.h>
 #include <node/blockstorage.h>
+#include <streams.h>
 #include <undo.h>
 #include <validation.h>
 
@@ -110,4 +111,44 @@ BOOST_AUTO_TEST_CASE(read_tx_data_from_disk_bad) {
         txundo, FlatFilePos(0, 0x7fffffff)));
 }
 
+BOOST_AUTO_TEST_CASE(read_raw_block_from_disk) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    const CBlockIndex *tip =
+        WITH_LOCK(chainman.GetMutex(), return chainman.ActiveTip());
+
+    // The stored bytes are the network serialization of the block.
+    CBlock block;
+    BOOST_CHECK(chainman.m_blockman.ReadBlockFromDisk(block, *tip));
+    std::vector<uint8_t> raw;
+    BOOST_CHECK(chainman.m_blockman.ReadRawBlockFromDisk(raw, *tip));
+    CDataStream expected(SER_NETWORK, PROTOCOL_VERSION);
+    expected << block;
+    BOOST_CHECK(Span{raw} == MakeUCharSpan(expected));
+
+    const FlatFilePos pos{WITH_LOCK(cs_main, return tip->GetBlockPos())};
+    std::vector<uint8_t> raw_by_pos;
+    BOOST_CHECK(chainman.m_blockman.ReadRawBlockFromDisk(raw_by_pos, pos));
+    BOOST_CHECK(raw_by_pos == raw);
+
+    // The block is checked against the index.
+    const BlockHash other_hash{tip->pprev->GetBlockHash()};
+    CBlockIndex wrong_index;
+    {
+        LOCK(cs_main);
+        wrong_index.nFile = tip->nFile;
+        wrong_index.nDataPos = tip->nDataPos;
+    }
+    wrong_index.phashBlock = &other_hash;
+    BOOST_CHECK(!chainman.m_blockman.ReadRawBlockFromDisk(raw, wrong_index));
+    BOOST_CHECK(raw.empty());
+
+    // Positions that do not point past a block header are rejected.
+    BOOST_CHECK(!chainman.m_blockman.ReadRawBlockFromDisk(
+        raw, FlatFilePos(pos.nFile, pos.nPos + 1)));
+    BOOST_CHECK(!chainman.m_blockman.ReadRawBlockFromDisk(
+        raw, FlatFilePos(pos.nFile, 0)));
+    BOOST_CHECK(!chainman.m_blockman.ReadRawBlockFromDisk(
+        raw, FlatFilePos(0x7fffffff, 8)));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1109,7 +1109,7 @@ BOOST_AUTO_TEST_CASE(rolling_bloom) {
         }
     }
     // Expect about 100 hits
-    BOOST_CHECK_EQUAL(nHits, 75U);
+    BOOST_CHECK_EQUAL(nHits, 89U);
 
     BOOST_CHECK(rb1.contains(data[DATASIZE - 1]));
     rb1.reset();
@@ -1139,7 +1139,7 @@ BOOST_AUTO_TEST_CASE(rolling_bloom) {
         }
     }
     // Expect about 5 false positives
-    BOOST_CHECK_EQUAL(nHits, 6U);
+    BOOST_CHECK_EQUAL(nHits, 1U);
 
     // last-1000-entry, 0.01% false positive:
     CRollingBloomFilter rb2(1000, 0.001);
@@ -7,6 +7,7 @@
 #include <common/args.h>
 #include <sync.h>
 #include <util/time.h>
+#include <validationthreadpool.h>
 
 #include <atomic>
 #include <condition_variable>
@@ -63,6 +64,17 @@ struct FailingCheck {
     bool operator()() const { return !fails; }
 };
 
+struct CountingFailingCheck {
+    static std::atomic<size_t> n_calls;
+    bool fails;
+    CountingFailingCheck(bool _fails) : fails(_fails){};
+    CountingFailingCheck() : fails(true){};
+    bool operator()() {
+        n_calls.fetch_add(1, std::memory_order_relaxed);
+        return !fails;
+    }
+};
+
 struct UniqueCheck {
     static Mutex m;
     static std::unordered_multiset<size_t> results GUARDED_BY(m);
@@ -130,12 +142,14 @@ std::condition_variable FrozenCleanupCheck::cv{};
 Mutex UniqueCheck::m;
 std::unordered_multiset<size_t> UniqueCheck::results;
 std::atomic<size_t> FakeCheckCheckCompletion::n_calls{0};
+std::atomic<size_t> CountingFailingCheck::n_calls{0};
 std::atomic<size_t> MemoryCheck::fake_allocated_memory{0};
 
 // Queue Typedefs
 typedef CCheckQueue<FakeCheckCheckCompletion> Correct_Queue;
 typedef CCheckQueue<FakeCheck> Standard_Queue;
 typedef CCheckQueue<FailingCheck> Failing_Queue;
+typedef CCheckQueue<CountingFailingCheck> CountingFailing_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
 typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
@@ -143,9 +157,10 @@ typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
 /** This test case checks that the CCheckQueue works properly
  * with each specified size_t Checks pushed.
  */
-static void Correct_Queue_range(std::vector<size_t> range) {
+static void Correct_Queue_range(std::vector<size_t> range,
+                                bool work_stealing = false) {
     auto small_queue = std::make_unique<Correct_Queue>(QUEUE_BATCH_SIZE);
-    small_queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
+    small_queue->StartWorkerThreads(SCRIPT_CHECK_THREADS, work_stealing);
     // Make vChecks here to save on malloc (this test can be slow...)
     std::vector<FakeCheckCheckCompletion> vChecks;
     vChecks.reserve(9);
@@ -228,6 +243,54 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Catches_Failure) {
     }
     fail_queue->StopWorkerThreads();
 }
+// Test that the remaining checks are skipped after a failure, and that the
+// skipped checks are accounted for.
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Early_Abort) {
+    // A multiple of the batch size, so the batches are the same in both modes
+    constexpr size_t COUNT = 80 * QUEUE_BATCH_SIZE;
+    for (const bool work_stealing : {false, true}) {
+        auto queue = std::make_unique<CountingFailing_Queue>(QUEUE_BATCH_SIZE);
+
+        // Without worker threads, the master processes the last batch first
+        // and the failure at its start makes it skip everything else.
+        queue->StartWorkerThreads(0, work_stealing);
+        {
+            CountingFailingCheck::n_calls = 0;
+            CCheckQueueControl<CountingFailingCheck> control(queue.get());
+            std::vector<CountingFailingCheck> vChecks(COUNT, false);
+            vChecks[COUNT - QUEUE_BATCH_SIZE] = true;
+            control.Add(std::move(vChecks));
+            size_t skipped = 0;
+            BOOST_REQUIRE(!control.Wait(&skipped));
+            BOOST_CHECK_EQUAL(CountingFailingCheck::n_calls, 1U);
+            BOOST_CHECK_EQUAL(skipped, COUNT - 1);
+        }
+        queue->StopWorkerThreads();
+
+        // With worker threads, every check is either run or skipped and the
+        // next run is not affected.
+        queue->StartWorkerThreads(SCRIPT_CHECK_THREADS, work_stealing);
+        for (size_t i = 0; i < 100; ++i) {
+            CountingFailingCheck::n_calls = 0;
+            CCheckQueueControl<CountingFailingCheck> control(queue.get());
+            std::vector<CountingFailingCheck> vChecks(COUNT, false);
+            vChecks[InsecureRandRange(COUNT)] = true;
+            control.Add(std::move(vChecks));
+            size_t skipped = 0;
+            BOOST_REQUIRE(!control.Wait(&skipped));
+            BOOST_REQUIRE_EQUAL(CountingFailingCheck::n_calls + skipped, COUNT);
+        }
+        {
+            CCheckQueueControl<CountingFailingCheck> control(queue.get());
+            control.Add(std::vector<CountingFailingCheck>(COUNT, false));
+            size_t skipped = 1;
+            BOOST_REQUIRE(control.Wait(&skipped));
+            BOOST_CHECK_EQUAL(skipped, 0U);
+        }
+        queue->StopWorkerThreads();
+    }
+}
+
 // Test that a block validation which fails does not interfere with
 // future blocks, ie, the bad state is cleared.
 BOOST_AUTO_TEST_CASE(test_CheckQueue_Recovers_From_Failure) {
@@ -350,6 +413,152 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_FrozenCleanup) {
     queue->StopWorkerThreads();
 }
 
+/** Test that the work-stealing mode runs every check exactly once */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_WorkStealing_Correct) {
+    Correct_Queue_range({0, 1, 100000}, /*work_stealing=*/true);
+    std::vector<size_t> range;
+    for (size_t i = 2; i < 100000;
+         i += std::max((size_t)1, (size_t)InsecureRandRange(std::min(
+                                      (size_t)1000, ((size_t)100000) - i)))) {
+        range.push_back(i);
+    }
+    Correct_Queue_range(range, /*work_stealing=*/true);
+}
+
+/** Test that the work-stealing mode catches failures and recovers from them */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_WorkStealing_Failure) {
+    auto fail_queue = std::make_unique<Failing_Queue>(QUEUE_BATCH_SIZE);
+    fail_queue->StartWorkerThreads(SCRIPT_CHECK_THREADS,
+                                   /*work_stealing=*/true);
+
+    for (size_t i = 0; i < 1001; ++i) {
+        CCheckQueueControl<FailingCheck> control(fail_queue.get());
+        size_t remaining = i;
+        while (remaining) {
+            size_t r = InsecureRandRange(10);
+
+            std::vector<FailingCheck> vChecks;
+            vChecks.reserve(r);
+            for (size_t k = 0; k < r && remaining; k++, remaining--) {
+                vChecks.emplace_back(remaining == 1);
+            }
+            control.Add(std::move(vChecks));
+        }
+        BOOST_REQUIRE_EQUAL(control.Wait(), i == 0);
+    }
+    fail_queue->StopWorkerThreads();
+}
+
+/** Test that the work-stealing mode runs unique checks individually */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_WorkStealing_UniqueCheck) {
+    WITH_LOCK(UniqueCheck::m, UniqueCheck::results.clear());
+    auto queue = std::make_unique<Unique_Queue>(QUEUE_BATCH_SIZE);
+    queue->StartWorkerThreads(SCRIPT_CHECK_THREADS, /*work_stealing=*/true);
+
+    size_t COUNT = 100000;
+    size_t total = COUNT;
+    {
+        CCheckQueueControl<UniqueCheck> control(queue.get());
+        while (total) {
+            // Use larger batches than the check order so chunks get split
+            size_t r = InsecureRandRange(1000);
+            std::vector<UniqueCheck> vChecks;
+            for (size_t k = 0; k < r && total; k++) {
+                vChecks.emplace_back(--total);
+            }
+            control.Add(std::move(vChecks));
+        }
+    }
+    {
+        LOCK(UniqueCheck::m);
+        bool r = true;
+        BOOST_REQUIRE_EQUAL(UniqueCheck::results.size(), COUNT);
+        for (size_t i = 0; i < COUNT; ++i) {
+            r = r && UniqueCheck::results.count(i) == 1;
+        }
+        BOOST_REQUIRE(r);
+    }
+    queue->StopWorkerThreads();
+}
+
+/** Test that the work-stealing mode frees the checks before returning */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_WorkStealing_Memory) {
+    auto queue = std::make_unique<Memory_Queue>(QUEUE_BATCH_SIZE);
+    queue->StartWorkerThreads(SCRIPT_CHECK_THREADS, /*work_stealing=*/true);
+    for (size_t i = 0; i < 1000; ++i) {
+        size_t total = i;
+        {
+            CCheckQueueControl<MemoryCheck> control(queue.get());
+            while (total) {
+                size_t r = InsecureRandRange(10);
+                std::vector<MemoryCheck> vChecks;
+                for (size_t k = 0; k < r && total; k++) {
+                    total--;
+                    vChecks.emplace_back(total == 0 || total == i ||
+                                         total == i / 2);
+                }
+                control.Add(std::move(vChecks));
+            }
+        }
+        BOOST_REQUIRE_EQUAL(MemoryCheck::fake_allocated_memory, 0U);
+    }
+    queue->StopWorkerThreads();
+}
+
+/** Test that queues sharing a thread pool run all their checks */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_SharedPool) {
+    for (const bool work_stealing : {false, true}) {
+        ValidationThreadPool pool;
+        auto correct_queue = std::make_unique<Correct_Queue>(QUEUE_BATCH_SIZE);
+        auto fail_queue = std::make_unique<Failing_Queue>(QUEUE_BATCH_SIZE);
+        correct_queue->StartWorkerPool(
+            pool, ValidationThreadPool::Priority::SCRIPT_CHECK, work_stealing);
+        fail_queue->StartWorkerPool(
+            pool, ValidationThreadPool::Priority::POW_CHECK, work_stealing);
+        pool.Start(SCRIPT_CHECK_THREADS);
+
+        // Both queues are used concurrently by their own master
+        std::atomic<int> fails{0};
+        std::thread t0([&]() {
+            for (size_t i = 0; i < 100; ++i) {
+                CCheckQueueControl<FailingCheck> control(fail_queue.get());
+                std::vector<FailingCheck> vChecks(1000, false);
+                vChecks[i * 7] = i % 2;
+                control.Add(std::move(vChecks));
+                fails += control.Wait() != (i % 2 == 0);
+            }
+        });
+        for (const size_t n : {0, 1, 10000, 100000}) {
+            FakeCheckCheckCompletion::n_calls = 0;
+            CCheckQueueControl<FakeCheckCheckCompletion> control(
+                correct_queue.get());
+            for (size_t total = n; total;) {
+                std::vector<FakeCheckCheckCompletion> vChecks(
+                    std::min<size_t>(total, 1000));
+                total -= vChecks.size();
+                control.Add(std::move(vChecks));
+            }
+            BOOST_REQUIRE(control.Wait());
+            BOOST_REQUIRE_EQUAL(FakeCheckCheckCompletion::n_calls, n);
+        }
+        t0.join();
+        BOOST_CHECK_EQUAL(fails, 0);
+
+        // Background tasks are run by the pool workers too
+        std::atomic<int> n_tasks{0};
+        for (int i = 0; i < 10; ++i) {
+            pool.Submit([&]() { ++n_tasks; });
+        }
+        while (n_tasks < 10) {
+            UninterruptibleSleep(std::chrono::milliseconds{1});
+        }
+
+        pool.Stop();
+        correct_queue->StopWorkerPool();
+        fail_queue->StopWorkerPool();
+    }
+}
+
 /** Test that CCheckQueueControl is threadsafe */
 BOOST_AUTO_TEST_CASE(test_CheckQueueControl_Locks) {
     auto queue = std::make_unique<Standard_Queue>(QUEUE_BATCH_SIZE);
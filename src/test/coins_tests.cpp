@@ -12,13 +12,17 @@
 #include <undo.h>
 #include <util/strencodings.h>
 #include <validation.h>
+#include <validationthreadpool.h>
 
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <limits>
 #include <map>
+#include <memory>
 #include <vector>
 
 namespace {
@@ -1171,6 +1175,284 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_partial_sync) {
+    CCoinsViewDB base{
+        {.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewCacheTest cache(&base);
+    cache.SetTrackDirty(true);
+    Amount value;
+    char flags;
+
+    std::vector<COutPoint> old_outpoints;
+    for (int i = 0; i < 10; ++i) {
+        old_outpoints.emplace_back(TxId{InsecureRand256()}, 0);
+        cache.AddCoin(old_outpoints.back(), MakeCoin(), false);
+    }
+    const BlockHash old_tip{InsecureRand256()};
+    cache.SetBestBlock(old_tip);
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK(!base.IsWrittenPartially());
+
+    // The changes are written back oldest first: a spend, then new coins, one
+    // of which is spent already.
+    BOOST_CHECK(cache.SpendCoin(old_outpoints[0]));
+    std::vector<COutPoint> new_outpoints;
+    for (int i = 0; i < 20; ++i) {
+        new_outpoints.emplace_back(TxId{InsecureRand256()}, 0);
+        cache.AddCoin(new_outpoints.back(), MakeCoin(), false);
+    }
+    BOOST_CHECK(cache.SpendCoin(new_outpoints.back()));
+    const BlockHash tip{InsecureRand256()};
+    cache.SetBestBlock(tip);
+
+    BOOST_CHECK(cache.SyncPartial(1));
+    BOOST_CHECK(!base.HaveCoin(old_outpoints[0]));
+    GetCoinMapEntry(cache.map(), value, flags, old_outpoints[0]);
+    BOOST_CHECK_EQUAL(flags, NO_ENTRY);
+    GetCoinMapEntry(cache.map(), value, flags, new_outpoints[0]);
+    BOOST_CHECK_EQUAL(flags, DIRTY | FRESH);
+    BOOST_CHECK(!base.HaveCoin(new_outpoints[0]));
+
+    // The database is in the middle of the transition to the tip.
+    BOOST_CHECK(base.IsWrittenPartially());
+    BOOST_CHECK(base.GetBestBlock().IsNull());
+    BOOST_CHECK(base.GetHeadBlocks() == std::vector<BlockHash>({tip, old_tip}));
+
+    BOOST_CHECK(cache.SyncPartial(std::numeric_limits<size_t>::max()));
+    for (size_t i = 0; i + 1 < new_outpoints.size(); ++i) {
+        GetCoinMapEntry(cache.map(), value, flags, new_outpoints[i]);
+        BOOST_CHECK_EQUAL(flags, 0);
+        BOOST_CHECK(base.HaveCoin(new_outpoints[i]));
+    }
+    BOOST_CHECK(!base.HaveCoin(new_outpoints.back()));
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 9 + 19);
+    cache.SanityCheck();
+
+    // Nothing is left to write back.
+    BOOST_CHECK(cache.SyncPartial(std::numeric_limits<size_t>::max()));
+    BOOST_CHECK(base.GetBestBlock().IsNull());
+
+    // An entry modified again is written back again, and syncing makes the
+    // database consistent with the tip.
+    BOOST_CHECK(cache.SpendCoin(new_outpoints[0]));
+    BOOST_CHECK(cache.SyncPartial(1));
+    BOOST_CHECK(!base.HaveCoin(new_outpoints[0]));
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK(!base.IsWrittenPartially());
+    BOOST_CHECK(base.GetBestBlock() == tip);
+    BOOST_CHECK(base.GetHeadBlocks().empty());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 9 + 18);
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_evict) {
+    CCoinsViewDB base{
+        {.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    std::vector<COutPoint> outpoints;
+    {
+        CCoinsViewCache writer(&base);
+        for (int i = 0; i < 100; ++i) {
+            outpoints.emplace_back(TxId{InsecureRand256()}, 0);
+            writer.AddCoin(outpoints.back(), MakeCoin(), false);
+        }
+        writer.SetBestBlock(BlockHash{InsecureRand256()});
+        BOOST_CHECK(writer.Flush());
+    }
+
+    CCoinsViewCacheTest cache(&base);
+    for (const COutPoint &outpoint : outpoints) {
+        BOOST_CHECK(cache.HaveCoin(outpoint));
+    }
+    // The coins all have the same size.
+    const size_t entry_usage = cache.EntriesMemoryUsage() / outpoints.size();
+    const size_t usage = cache.EntriesMemoryUsage();
+    BOOST_CHECK_EQUAL(cache.EvictCoins(usage), 0);
+
+    // The first 10 coins are used again, the next 10 are modified.
+    for (size_t i = 0; i < 10; ++i) {
+        BOOST_CHECK(cache.HaveCoin(outpoints[i]));
+        BOOST_CHECK(cache.SpendCoin(outpoints[10 + i]));
+    }
+
+    // The coins not used since are evicted first.
+    const size_t evicted =
+        cache.EvictCoins(cache.EntriesMemoryUsage() - 50 * entry_usage);
+    BOOST_CHECK(evicted >= 50 && evicted <= 80);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 100 - evicted);
+    for (size_t i = 0; i < 20; ++i) {
+        BOOST_CHECK(cache.map().count(outpoints[i]));
+    }
+    BOOST_CHECK(cache.EntriesMemoryUsage() <= usage - 50 * entry_usage);
+    cache.SanityCheck();
+
+    // Only the modified coins are left when evicting as much as possible.
+    BOOST_CHECK_EQUAL(cache.EvictCoins(0), 90 - evicted);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 10);
+    for (size_t i = 10; i < 20; ++i) {
+        BOOST_CHECK(!cache.HaveCoin(outpoints[i]));
+    }
+    BOOST_CHECK(cache.HaveCoin(outpoints[0]));
+    cache.SetBestBlock(base.GetBestBlock());
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(!base.HaveCoin(outpoints[10]));
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_bulk_write) {
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    for (int i = 0; i < 100; ++i) {
+        const TxId txid{InsecureRand256()};
+        // Indexes around the change of size of their VARINT encoding.
+        for (uint32_t n : {0u, 127u, 128u, 16511u, 16512u,
+                           uint32_t(InsecureRand32())}) {
+            coins.emplace_back(COutPoint(txid, n), MakeCoin());
+        }
+    }
+
+    CCoinsViewDB db{
+        {.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    BOOST_CHECK(db.BulkWrite(coins));
+    BOOST_CHECK(db.GetBestBlock().IsNull());
+    for (const auto &[outpoint, coin] : coins) {
+        Coin read;
+        BOOST_CHECK(db.GetCoin(outpoint, read));
+        BOOST_CHECK(read == coin);
+    }
+
+    // KeyLess() sorts the coins in the order of a database cursor.
+    std::vector<COutPoint> cursor_order;
+    std::unique_ptr<CCoinsViewCursor> cursor{db.Cursor()};
+    for (; cursor->Valid(); cursor->Next()) {
+        COutPoint outpoint;
+        BOOST_CHECK(cursor->GetKey(outpoint));
+        cursor_order.push_back(outpoint);
+    }
+    std::sort(coins.begin(), coins.end(), [](const auto &a, const auto &b) {
+        return CCoinsViewDB::KeyLess(a.first, b.first);
+    });
+    BOOST_REQUIRE_EQUAL(cursor_order.size(), coins.size());
+    for (size_t i = 0; i < coins.size(); ++i) {
+        BOOST_CHECK(cursor_order[i] == coins[i].first);
+        if (i > 0) {
+            BOOST_CHECK(CCoinsViewDB::KeyLess(cursor_order[i - 1],
+                                              cursor_order[i]));
+            BOOST_CHECK(!CCoinsViewDB::KeyLess(cursor_order[i],
+                                               cursor_order[i - 1]));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_sharded_cursors) {
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    for (int i = 0; i < 1000; ++i) {
+        TxId txid{InsecureRand256()};
+        // Some at the edges of the shards.
+        if (i < 256) {
+            *txid.begin() = i;
+            std::fill(txid.begin() + 1, txid.end(), i % 2 ? 0xff : 0);
+        }
+        coins.emplace_back(COutPoint(txid, 0), MakeCoin());
+        coins.emplace_back(COutPoint(txid, InsecureRand32()), MakeCoin());
+    }
+    CCoinsViewDB db{
+        {.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    BOOST_CHECK(db.BulkWrite(coins));
+    std::sort(coins.begin(), coins.end(), [](const auto &a, const auto &b) {
+        return CCoinsViewDB::KeyLess(a.first, b.first);
+    });
+
+    BOOST_CHECK_EQUAL(db.ShardedCursors(0).size(), 1);
+    BOOST_CHECK_EQUAL(db.ShardedCursors(1000).size(), 256);
+    for (const size_t num_shards : {1, 7, 256}) {
+        auto cursors = db.ShardedCursors(num_shards);
+        BOOST_CHECK_EQUAL(cursors.size(), num_shards);
+
+        // The cursors don't see the later changes.
+        std::vector<std::pair<COutPoint, Coin>> more{
+            {COutPoint(TxId{InsecureRand256()}, 0), MakeCoin()}};
+        BOOST_CHECK(db.BulkWrite(more));
+
+        // The shards are consecutive and cover all the coins.
+        size_t i = 0;
+        for (auto &cursor : cursors) {
+            for (; cursor->Valid(); cursor->Next()) {
+                COutPoint outpoint;
+                Coin coin;
+                BOOST_CHECK(cursor->GetKey(outpoint));
+                BOOST_CHECK(cursor->GetValue(coin));
+                BOOST_REQUIRE(i < coins.size());
+                BOOST_CHECK(outpoint == coins[i].first);
+                BOOST_CHECK(coin == coins[i].second);
+                ++i;
+            }
+        }
+        BOOST_CHECK_EQUAL(i, coins.size());
+
+        coins.insert(coins.end(), more.begin(), more.end());
+        std::sort(coins.begin(), coins.end(), [](const auto &a, const auto &b) {
+            return CCoinsViewDB::KeyLess(a.first, b.first);
+        });
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_parallel_write) {
+    ValidationThreadPool pool;
+    pool.Start(3);
+    // Small batches, so many are written partially.
+    CoinsViewOptions options{.batch_write_bytes = 1 << 16};
+    CCoinsViewDB serial{
+        {.path = "serial", .cache_bytes = 1 << 23, .memory_only = true},
+        options};
+    options.write_pool = &pool;
+    CCoinsViewDB parallel{
+        {.path = "parallel", .cache_bytes = 1 << 23, .memory_only = true},
+        options};
+
+    // More entries than are encoded in one round, written with and without
+    // erasing them, then some spent and others not modified.
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    for (int i = 0; i < 100000; ++i) {
+        coins.emplace_back(COutPoint(TxId{InsecureRand256()}, i % 300),
+                           MakeCoin());
+    }
+    const BlockHash tip{InsecureRand256()};
+    for (CCoinsViewDB *db : {&serial, &parallel}) {
+        CCoinsViewCache cache(db);
+        for (const auto &[outpoint, coin] : coins) {
+            cache.AddCoin(outpoint, Coin{coin}, false);
+        }
+        cache.SetBestBlock(BlockHash{InsecureRand256()});
+        BOOST_CHECK(cache.Sync());
+        for (size_t i = 0; i < coins.size(); i += 3) {
+            BOOST_CHECK(cache.SpendCoin(coins[i].first));
+        }
+        cache.SetBestBlock(tip);
+        BOOST_CHECK(cache.Flush());
+    }
+    pool.Stop();
+
+    // The databases end up the same.
+    std::unique_ptr<CCoinsViewCursor> serial_cursor{serial.Cursor()};
+    std::unique_ptr<CCoinsViewCursor> parallel_cursor{parallel.Cursor()};
+    size_t num_coins = 0;
+    for (; serial_cursor->Valid(); serial_cursor->Next()) {
+        BOOST_REQUIRE(parallel_cursor->Valid());
+        COutPoint serial_key, parallel_key;
+        Coin serial_coin, parallel_coin;
+        BOOST_CHECK(serial_cursor->GetKey(serial_key));
+        BOOST_CHECK(parallel_cursor->GetKey(parallel_key));
+        BOOST_CHECK(serial_key == parallel_key);
+        BOOST_CHECK(serial_cursor->GetValue(serial_coin));
+        BOOST_CHECK(parallel_cursor->GetValue(parallel_coin));
+        BOOST_CHECK(serial_coin == parallel_coin);
+        parallel_cursor->Next();
+        ++num_coins;
+    }
+    BOOST_CHECK(!parallel_cursor->Valid());
+    BOOST_CHECK_EQUAL(num_coins, coins.size() - (coins.size() + 2) / 3);
+    BOOST_CHECK(parallel.GetBestBlock() == tip);
+    BOOST_CHECK(parallel.GetHeadBlocks().empty());
+}
+
+#ifndef ENABLE_FLAT_COINS_MAP
 BOOST_AUTO_TEST_CASE(coins_resource_is_used) {
     CCoinsMapMemoryResource resource;
     PoolResourceTester::CheckAllDataAccountedFor(resource);
@@ -1195,5 +1477,6 @@ BOOST_AUTO_TEST_CASE(coins_resource_is_used) {
 
     PoolResourceTester::CheckAllDataAccountedFor(resource);
 }
+#endif
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -1076,6 +1076,36 @@ BOOST_AUTO_TEST_CASE(sha256d64) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(sha256dmulti) {
+    std::vector<std::vector<uint8_t>> messages;
+    // All the lengths around the padding and chunk boundaries, and some long
+    // messages to have the lanes running unevenly.
+    for (size_t len = 0; len <= 200; ++len) {
+        messages.push_back(g_insecure_rand_ctx.randbytes(len));
+    }
+    for (int i = 0; i < 20; ++i) {
+        messages.push_back(
+            g_insecure_rand_ctx.randbytes(InsecureRandRange(10000)));
+    }
+
+    std::vector<const uint8_t *> inputs;
+    std::vector<size_t> lengths;
+    for (const std::vector<uint8_t> &message : messages) {
+        inputs.push_back(message.data());
+        lengths.push_back(message.size());
+    }
+
+    for (size_t count : {size_t(0), size_t(1), size_t(2), size_t(9),
+                         messages.size()}) {
+        std::vector<uint8_t> out1(32 * count), out2(32 * count);
+        for (size_t i = 0; i < count; ++i) {
+            CHash256().Write(messages[i]).Finalize({&out1[32 * i], 32});
+        }
+        SHA256DMulti(out2.data(), inputs.data(), lengths.data(), count);
+        BOOST_CHECK(out1 == out2);
+    }
+}
+
 static void TestSHA3_256(const std::string &input, const std::string &output) {
     const auto in_bytes = ParseHex(input);
     const auto out_bytes = ParseHex(output);
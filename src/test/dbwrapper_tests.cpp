@@ -4,7 +4,10 @@
 
 #include <dbwrapper.h>
 
+#include <common/args.h>
+#include <node/database_args.h>
 #include <uint256.h>
+#include <util/translation.h>
 
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
@@ -12,6 +15,8 @@
 #include <boost/test/unit_test.hpp>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 // Test if a string consists entirely of null characters
 static bool is_null_key(const std::vector<uint8_t> &key) {
@@ -51,6 +56,93 @@ BOOST_AUTO_TEST_CASE(dbwrapper) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_snapshot) {
+    for (const bool obfuscate : {false, true}) {
+        CDBWrapper dbw({.path = m_args.GetDataDirBase() / "dbwrapper_snapshot",
+                        .cache_bytes = 1 << 20,
+                        .memory_only = true,
+                        .obfuscate = obfuscate});
+        const uint256 in = InsecureRand256();
+        BOOST_CHECK(dbw.Write(uint8_t{'k'}, in));
+
+        // The snapshot doesn't see the later writes
+        CDBSnapshot snapshot(dbw);
+        BOOST_CHECK(dbw.Write(uint8_t{'k'}, InsecureRand256()));
+        BOOST_CHECK(dbw.Write(uint8_t{'n'}, in));
+        BOOST_CHECK(dbw.Erase(uint8_t{'k'}));
+
+        uint256 res;
+        BOOST_CHECK(!dbw.Read(uint8_t{'k'}, res));
+        BOOST_CHECK(snapshot.Read(uint8_t{'k'}, res));
+        BOOST_CHECK_EQUAL(res, in);
+        BOOST_CHECK(!snapshot.Read(uint8_t{'n'}, res));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_options) {
+    std::vector<DBOptions> all_options(3);
+    all_options[0].profile = DBProfile::IBD;
+    all_options[1].profile = DBProfile::STEADY_STATE;
+    all_options[2].write_buffer_size = 1 << 16;
+    all_options[2].max_file_size = 1 << 20;
+    all_options[2].block_size = 1 << 10;
+    all_options[2].bloom_bits = 0;
+    for (const DBOptions &options : all_options) {
+        CDBWrapper dbw({.path = m_args.GetDataDirBase() / "dbwrapper_options",
+                        .cache_bytes = 1 << 20,
+                        .memory_only = true,
+                        .options = options});
+        for (uint32_t i = 0; i < 1000; ++i) {
+            BOOST_CHECK(dbw.Write(i, uint256S(std::to_string(i))));
+        }
+        uint256 res;
+        for (uint32_t i = 0; i < 1000; ++i) {
+            BOOST_CHECK(dbw.Read(i, res));
+            BOOST_CHECK(res == uint256S(std::to_string(i)));
+        }
+        BOOST_CHECK(!dbw.Read(uint32_t{1000}, res));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_options_args) {
+    ArgsManager args;
+    for (const char *arg : {"-dbprofile", "-dbwritebuffer", "-dbmaxfilesize",
+                            "-dbblocksize", "-dbbloombits"}) {
+        args.AddArg(arg, "", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    }
+    const auto parse = [&](std::vector<const char *> argv) {
+        argv.insert(argv.begin(), "dummy");
+        std::string error;
+        BOOST_REQUIRE(args.ParseParameters(argv.size(), argv.data(), error));
+    };
+
+    // The prefixed values apply to their database only, and take precedence
+    // over the others whatever the order.
+    parse({"-dbprofile=chainstate:ibd", "-dbprofile=steady",
+           "-dbbloombits=txindex:0", "-dbwritebuffer=64",
+           "-dbblocksize=chainstate:16"});
+    DBOptions chainstate;
+    BOOST_CHECK(!node::ReadDatabaseArgs(args, chainstate, "chainstate"));
+    BOOST_CHECK(chainstate.profile == DBProfile::IBD);
+    BOOST_CHECK_EQUAL(*chainstate.write_buffer_size, size_t{64} << 20);
+    BOOST_CHECK_EQUAL(*chainstate.block_size, size_t{16} << 10);
+    BOOST_CHECK(!chainstate.bloom_bits);
+    BOOST_CHECK(!chainstate.max_file_size);
+    DBOptions txindex;
+    BOOST_CHECK(!node::ReadDatabaseArgs(args, txindex, "txindex"));
+    BOOST_CHECK(txindex.profile == DBProfile::STEADY_STATE);
+    BOOST_CHECK_EQUAL(*txindex.bloom_bits, 0);
+    BOOST_CHECK(!txindex.block_size);
+
+    for (const char *arg : {"-dbprofile=fast", "-dbprofile=blocks:ibd",
+                            "-dbwritebuffer=0", "-dbmaxfilesize=2048",
+                            "-dbblocksize=x", "-dbbloombits=-1"}) {
+        parse({arg});
+        DBOptions options;
+        BOOST_CHECK(node::ReadDatabaseArgs(args, options, "chainstate"));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(dbwrapper_basic_data) {
     // Perform tests both obfuscated and non-obfuscated.
     for (bool obfuscate : {false, true}) {
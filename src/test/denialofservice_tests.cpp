@@ -11,6 +11,7 @@
 #include <config.h>
 #include <net.h>
 #include <net_processing.h>
+#include <netbase.h>
 #include <script/sign.h>
 #include <script/signingprovider.h>
 #include <script/standard.h>
@@ -62,8 +63,6 @@ BOOST_FIXTURE_TEST_SUITE(denialofservice_tests, TestingSetup)
 // test takes advantage of that protection only being applied to nodes which
 // send headers with sufficient work.
 BOOST_AUTO_TEST_CASE(outbound_slow_chain_eviction) {
-    LOCK(NetEventsInterface::g_msgproc_mutex);
-
     const Config &config = m_node.chainman->GetConfig();
 
     ConnmanTestMsg &connman = static_cast<ConnmanTestMsg &>(*m_node.connman);
@@ -229,8 +228,6 @@ BOOST_AUTO_TEST_CASE(stale_tip_peer_management) {
 }
 
 BOOST_AUTO_TEST_CASE(peer_discouragement) {
-    LOCK(NetEventsInterface::g_msgproc_mutex);
-
     const Config &config = m_node.chainman->GetConfig();
 
     auto banman = std::make_unique<BanMan>(
@@ -286,8 +283,6 @@ BOOST_AUTO_TEST_CASE(peer_discouragement) {
 }
 
 BOOST_AUTO_TEST_CASE(DoS_bantime) {
-    LOCK(NetEventsInterface::g_msgproc_mutex);
-
     const Config &config = m_node.chainman->GetConfig();
 
     auto banman = std::make_unique<BanMan>(
@@ -320,4 +315,58 @@ BOOST_AUTO_TEST_CASE(DoS_bantime) {
     peerLogic->FinalizeNode(config, dummyNode);
 }
 
+BOOST_AUTO_TEST_CASE(subnet_bans) {
+    const Config &config = m_node.chainman->GetConfig();
+
+    auto banman = std::make_unique<BanMan>(
+        m_args.GetDataDirBase() / "banlist.dat", config.GetChainParams(),
+        nullptr, DEFAULT_MISBEHAVING_BANTIME);
+    banman->ClearBanned();
+    SetMockTime(GetTime());
+
+    const auto subnet = [](const std::string &str) {
+        CSubNet ret;
+        BOOST_REQUIRE(LookupSubNet(str, ret));
+        return ret;
+    };
+    const auto host = [](const std::string &str) {
+        CNetAddr ret;
+        BOOST_REQUIRE(LookupHost(str, ret, false));
+        return ret;
+    };
+
+    banman->Ban(subnet("10.1.0.0/16"));
+    banman->Ban(subnet("10.2.3.4"));
+    banman->Ban(subnet("2001:db8::/32"), 10);
+    banman->Ban(host("2001:db9::1"));
+    BOOST_CHECK(banman->IsBanned(host("10.1.2.3")));
+    BOOST_CHECK(banman->IsBanned(host("10.2.3.4")));
+    BOOST_CHECK(!banman->IsBanned(host("10.2.3.5")));
+    BOOST_CHECK(!banman->IsBanned(host("10.3.0.1")));
+    BOOST_CHECK(banman->IsBanned(host("2001:db8:1::1")));
+    BOOST_CHECK(banman->IsBanned(host("2001:db9::1")));
+    BOOST_CHECK(!banman->IsBanned(host("2001:db9::2")));
+    // The IPv4 addresses are not matched by the IPv6 subnets of the same
+    // prefix lengths, and conversely.
+    BOOST_CHECK(!banman->IsBanned(host("32.1.13.184")));
+    BOOST_CHECK(!banman->IsBanned(host("::10.2.3.4")));
+
+    BOOST_CHECK(banman->Unban(subnet("10.1.0.0/16")));
+    BOOST_CHECK(!banman->IsBanned(host("10.1.2.3")));
+    BOOST_CHECK(banman->IsBanned(host("10.2.3.4")));
+
+    // Expired bans no longer match, and are swept away.
+    SetMockTime(GetTime() + 11);
+    BOOST_CHECK(!banman->IsBanned(host("2001:db8:1::1")));
+    banmap_t banned;
+    banman->GetBanned(banned);
+    BOOST_CHECK_EQUAL(banned.size(), 2U);
+    BOOST_CHECK(banman->IsBanned(host("2001:db9::1")));
+
+    banman->ClearBanned();
+    BOOST_CHECK(!banman->IsBanned(host("10.2.3.4")));
+    BOOST_CHECK(!banman->IsBanned(host("2001:db9::1")));
+    SetMockTime(0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -134,4 +134,57 @@ BOOST_AUTO_TEST_CASE(mine_auxpow_blocks_rng_test) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(auxpow_header_from_block_index_test) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+
+    const CBlock block = CreateAndProcessAuxPowBlock(
+        {}, CScript() << OP_1, 0x63, 0x12345678, {uint256()},
+        {uint256(), uint256()});
+    BOOST_CHECK(block.auxpow);
+
+    auto check_header = [&]() {
+        LOCK(cs_main);
+        const CBlockIndex *pindex =
+            chainman.m_blockman.LookupBlockIndex(block.GetHash());
+        BOOST_REQUIRE(pindex);
+        BOOST_CHECK_EQUAL(pindex, chainman.ActiveTip());
+
+        std::shared_ptr<CAuxPow> auxpow;
+        BOOST_CHECK(chainman.m_blockman.ReadAuxPow(*pindex, auxpow));
+        BOOST_REQUIRE(auxpow);
+
+        const CBlockHeader header =
+            pindex->GetBlockHeader(chainman.m_blockman);
+        BOOST_CHECK_EQUAL(header.GetHash(), block.GetHash());
+        BOOST_REQUIRE(header.auxpow);
+        BOOST_CHECK_EQUAL(header.auxpow->parentBlock.GetHash(),
+                          block.auxpow->parentBlock.GetHash());
+        BOOST_CHECK(header.auxpow->coinbaseTx->GetHash() ==
+                    block.auxpow->coinbaseTx->GetHash());
+    };
+
+    // The auxpow is served from memory before the block index is flushed...
+    check_header();
+
+    // ...and from the block tree DB afterwards.
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(chainman.m_blockman.WriteBlockIndexDB());
+    }
+    check_header();
+
+    // Once read from the block tree DB, it is served from the cache.
+    {
+        LOCK(cs_main);
+        const CBlockIndex *pindex =
+            chainman.m_blockman.LookupBlockIndex(block.GetHash());
+        BOOST_REQUIRE(pindex);
+        std::shared_ptr<CAuxPow> auxpow1, auxpow2;
+        BOOST_CHECK(chainman.m_blockman.ReadAuxPow(*pindex, auxpow1));
+        BOOST_CHECK(chainman.m_blockman.ReadAuxPow(*pindex, auxpow2));
+        BOOST_CHECK(auxpow1);
+        BOOST_CHECK_EQUAL(auxpow1.get(), auxpow2.get());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -12,6 +12,12 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
 BOOST_FIXTURE_TEST_SUITE(flatfile_tests, BasicTestingSetup)
 
 BOOST_AUTO_TEST_CASE(flatfile_filename) {
@@ -125,4 +131,176 @@ BOOST_AUTO_TEST_CASE(flatfile_flush) {
     BOOST_CHECK_EQUAL(fs::file_size(seq.FileName(FlatFilePos(0, 1))), 1U);
 }
 
+#ifndef WIN32
+BOOST_AUTO_TEST_CASE(flatfile_mapper) {
+    const auto data_dir = m_args.GetDataDirBase();
+    FlatFileSeq seq(data_dir, "a", 100);
+    FlatFileMapper mapper(2);
+
+    const auto write = [&](const FlatFilePos &pos, const std::string &str) {
+        AutoFile file{seq.Open(pos)};
+        file.write(MakeByteSpan(str));
+    };
+    const auto read = [&](const FlatFilePos &pos, size_t size) {
+        const auto view{mapper.Read(seq, pos, size)};
+        BOOST_REQUIRE(view);
+        return std::string(reinterpret_cast<const char *>(view->data.data()),
+                           view->data.size());
+    };
+
+    // Missing files can not be mapped.
+    BOOST_CHECK(!mapper.Read(seq, FlatFilePos(0, 0), 1));
+
+    write(FlatFilePos(0, 0), "hello");
+    BOOST_CHECK_EQUAL(read(FlatFilePos(0, 1), 4), "ello");
+    BOOST_CHECK(!mapper.Read(seq, FlatFilePos(0, 0), 6));
+
+    // The file is mapped again when it grew, while the previous view stays
+    // valid.
+    const auto view{mapper.Read(seq, FlatFilePos(0, 0), 5)};
+    BOOST_REQUIRE(view);
+    write(FlatFilePos(0, 5), " world");
+    BOOST_CHECK_EQUAL(read(FlatFilePos(0, 0), 11), "hello world");
+    BOOST_CHECK_EQUAL(std::string(reinterpret_cast<const char *>(
+                                      view->data.data()),
+                                  view->data.size()),
+                      "hello");
+
+    // Mapping more files than the limit unmaps the least recently read one.
+    write(FlatFilePos(1, 0), "one");
+    write(FlatFilePos(2, 0), "two");
+    BOOST_CHECK_EQUAL(read(FlatFilePos(1, 0), 3), "one");
+    BOOST_CHECK_EQUAL(read(FlatFilePos(0, 0), 5), "hello");
+    BOOST_CHECK_EQUAL(read(FlatFilePos(2, 0), 3), "two");
+    BOOST_CHECK_EQUAL(read(FlatFilePos(0, 6), 5), "world");
+
+    // Unmapped files are mapped again on the next read.
+    mapper.Unmap(0);
+    write(FlatFilePos(0, 0), "HELLO");
+    BOOST_CHECK_EQUAL(read(FlatFilePos(0, 0), 5), "HELLO");
+}
+
+BOOST_AUTO_TEST_CASE(flatfile_read_cache) {
+    const auto data_dir = m_args.GetDataDirBase();
+    FlatFileSeq seq(data_dir, "a", 100);
+    FlatFileReadCache cache(2);
+
+    BOOST_CHECK(!FlatFileReadCache(0).Open(seq, 0));
+    BOOST_CHECK(!cache.Open(seq, 0));
+
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = uint8_t(i);
+    }
+    {
+        AutoFile file{seq.Open(FlatFilePos(0, 0))};
+        file << Span{data};
+    }
+    const auto handle{cache.Open(seq, 0)};
+    BOOST_REQUIRE(handle);
+    BOOST_CHECK(cache.Open(seq, 0) == handle);
+
+    // Small reads are buffered, large ones are not, and readers at different
+    // offsets share the descriptor.
+    FlatFileReader reader{handle, 10, SER_DISK, CLIENT_VERSION, 16};
+    FlatFileReader other{handle, 500, SER_DISK, CLIENT_VERSION, 16};
+    std::vector<uint8_t> out(100);
+    for (size_t i = 0; i < 8; ++i) {
+        uint8_t byte;
+        reader >> byte;
+        BOOST_CHECK_EQUAL(byte, 10 + i);
+        other >> byte;
+        BOOST_CHECK_EQUAL(byte, uint8_t(500 + i));
+    }
+    reader >> Span{out};
+    BOOST_CHECK(std::equal(out.begin(), out.end(), data.begin() + 18));
+    reader.ignore(300);
+    reader >> Span{out};
+    BOOST_CHECK(std::equal(out.begin(), out.end(), data.begin() + 418));
+
+    // Reading past the end of the file fails.
+    FlatFileReader end{handle, 990, SER_DISK, CLIENT_VERSION, 16};
+    end >> Span{out.data(), 10};
+    BOOST_CHECK(std::equal(out.begin(), out.begin() + 10, data.begin() + 990));
+    uint8_t byte;
+    BOOST_CHECK_THROW(end >> byte, std::ios_base::failure);
+    BOOST_CHECK_THROW((FlatFileReader{handle, 950, SER_DISK, CLIENT_VERSION,
+                                      16} >>
+                       Span{out}),
+                      std::ios_base::failure);
+
+    // Opening more files than the limit closes the least recently opened one,
+    // which stays readable by its users.
+    {
+        AutoFile file1{seq.Open(FlatFilePos(1, 0))};
+        AutoFile file2{seq.Open(FlatFilePos(2, 0))};
+    }
+    const auto handle1{cache.Open(seq, 1)};
+    BOOST_CHECK(cache.Open(seq, 2));
+    BOOST_CHECK(cache.Open(seq, 1) == handle1);
+    BOOST_CHECK(cache.Open(seq, 0) != handle);
+    FlatFileReader{handle, 0, SER_DISK, CLIENT_VERSION, 16} >> byte;
+    BOOST_CHECK_EQUAL(byte, 0);
+
+    // Closed files are opened again, and can not be once removed.
+    cache.Close(1);
+    fs::remove(seq.FileName(FlatFilePos(1, 0)));
+    BOOST_CHECK(!cache.Open(seq, 1));
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(flatfile_writer) {
+    const auto data_dir = m_args.GetDataDirBase();
+    FlatFileSeq seq(data_dir, "a", 100);
+
+    const auto read = [&](const FlatFilePos &pos, size_t size) {
+        std::vector<uint8_t> data(size);
+        AutoFile file{seq.Open(pos, true)};
+        file >> Span{data};
+        return data;
+    };
+
+    {
+        // The queue holds less than two writes, which then wait for each
+        // other.
+        FlatFileWriter writer(seq, "test", 150);
+        std::vector<uint8_t> expected;
+        for (int i = 0; i < 20; ++i) {
+            const std::vector<uint8_t> data(100, uint8_t(i));
+            BOOST_CHECK(writer.Write(FlatFilePos(0, i * 100), data));
+            expected.insert(expected.end(), data.begin(), data.end());
+        }
+        BOOST_CHECK(writer.Write(FlatFilePos(1, 0), {1, 2, 3}));
+        BOOST_CHECK(writer.WaitForWrites(0));
+        BOOST_CHECK(read(FlatFilePos(0, 0), 2000) == expected);
+
+        // Flushing waits for the writes, and finalizing truncates the file.
+        bool out_of_space;
+        seq.Allocate(FlatFilePos(1, 0), 3, out_of_space);
+        BOOST_CHECK_EQUAL(fs::file_size(seq.FileName(FlatFilePos(1, 0))),
+                          100U);
+        BOOST_CHECK(writer.Flush(FlatFilePos(1, 3), true));
+        BOOST_CHECK_EQUAL(fs::file_size(seq.FileName(FlatFilePos(1, 0))), 3U);
+        BOOST_CHECK(read(FlatFilePos(1, 0), 3) ==
+                    std::vector<uint8_t>({1, 2, 3}));
+        BOOST_CHECK(writer.Flush(FlatFilePos(1, 3)));
+
+        // The queued writes are done before the writer goes away.
+        BOOST_CHECK(writer.Write(FlatFilePos(2, 0), {4, 5}));
+    }
+    BOOST_CHECK(read(FlatFilePos(2, 0), 2) == std::vector<uint8_t>({4, 5}));
+
+    // A failed write fails the following operations.
+    {
+        std::ofstream{data_dir / "blocker"};
+        FlatFileWriter writer(FlatFileSeq(data_dir / "blocker", "a", 100),
+                              "test", 1000);
+        BOOST_CHECK(writer.Write(FlatFilePos(0, 0), {1}));
+        BOOST_CHECK(!writer.WaitForWrites(0));
+        BOOST_CHECK(!writer.WaitForAllWrites());
+        BOOST_CHECK(!writer.Write(FlatFilePos(0, 1), {2}));
+        BOOST_CHECK(!writer.Flush(FlatFilePos(0, 1)));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
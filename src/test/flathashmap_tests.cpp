@@ -0,0 +1,184 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <flathashmap.h>
+
+#include <memusage.h>
+
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+/** A poor hash, so that many keys share the same groups and control bits. */
+struct CollidingHash {
+    size_t operator()(uint32_t key) const { return key % 7; }
+};
+
+/** A good enough hash for the tests. */
+struct MixingHash {
+    size_t operator()(uint32_t key) const {
+        return size_t(key) * 0x9E3779B97F4A7C15ULL;
+    }
+};
+
+template <typename Map>
+void CheckEqual(const Map &map,
+                const std::unordered_map<uint32_t, std::string> &expected) {
+    BOOST_CHECK_EQUAL(map.size(), expected.size());
+    BOOST_CHECK_EQUAL(map.empty(), expected.empty());
+    size_t count = 0;
+    for (const auto &[key, value] : map) {
+        BOOST_CHECK_EQUAL(expected.at(key), value);
+        ++count;
+    }
+    BOOST_CHECK_EQUAL(count, expected.size());
+    for (const auto &[key, value] : expected) {
+        auto it = map.find(key);
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK_EQUAL(it->second, value);
+    }
+}
+
+template <typename Hash> void RandomOperations(uint32_t key_range) {
+    FlatHashMap<uint32_t, std::string, Hash> map;
+    std::unordered_map<uint32_t, std::string> expected;
+
+    for (int i = 0; i < 20000; ++i) {
+        const uint32_t key = InsecureRandRange(key_range);
+        const std::string value = std::to_string(InsecureRand32());
+        switch (InsecureRandRange(5)) {
+            case 0: {
+                auto [it, inserted] = map.try_emplace(key, value);
+                auto [it2, inserted2] = expected.try_emplace(key, value);
+                BOOST_CHECK_EQUAL(inserted, inserted2);
+                BOOST_CHECK_EQUAL(it->second, it2->second);
+                break;
+            }
+            case 1: {
+                auto [it, inserted] = map.emplace(key, value);
+                auto [it2, inserted2] = expected.emplace(key, value);
+                BOOST_CHECK_EQUAL(inserted, inserted2);
+                BOOST_CHECK_EQUAL(it->second, it2->second);
+                break;
+            }
+            case 2:
+                map[key] = value;
+                expected[key] = value;
+                break;
+            case 3:
+                BOOST_CHECK_EQUAL(map.erase(key), expected.erase(key));
+                break;
+            case 4: {
+                auto it = map.find(key);
+                if (it != map.end()) {
+                    map.erase(it);
+                }
+                expected.erase(key);
+                break;
+            }
+        }
+        BOOST_CHECK_EQUAL(map.count(key), expected.count(key));
+        BOOST_CHECK_EQUAL(map.size(), expected.size());
+    }
+    CheckEqual(map, expected);
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(flathashmap_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(random_operations) {
+    // Dense and sparse keys, with a good hash and with lots of collisions.
+    RandomOperations<MixingHash>(100);
+    RandomOperations<MixingHash>(100000);
+    RandomOperations<CollidingHash>(100);
+    RandomOperations<CollidingHash>(1000);
+}
+
+BOOST_AUTO_TEST_CASE(erase_while_iterating) {
+    FlatHashMap<uint32_t, std::string, MixingHash> map;
+    std::unordered_map<uint32_t, std::string> expected;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        map.try_emplace(i, std::to_string(i));
+    }
+
+    // Every element is visited exactly once, even when erasing.
+    size_t visited = 0;
+    for (auto it = map.begin(); it != map.end(); ++visited) {
+        if (it->first % 3 == 0) {
+            it = map.erase(it);
+        } else {
+            expected.emplace(it->first, it->second);
+            ++it;
+        }
+    }
+    BOOST_CHECK_EQUAL(visited, 1000);
+    CheckEqual(map, expected);
+
+    for (auto it = map.begin(); it != map.end();) {
+        it = map.erase(it);
+    }
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.begin() == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(deleted_slots_are_reused) {
+    FlatHashMap<uint32_t, std::string, MixingHash> map;
+    map.reserve(1000);
+    const size_t capacity = map.bucket_count();
+    BOOST_CHECK(capacity >= 1000);
+
+    // Churning through many more keys than the capacity, while keeping the
+    // size below the reservation, never grows the table.
+    for (uint32_t i = 0; i < 100000; ++i) {
+        map.try_emplace(i, "x");
+        if (i >= 500) {
+            BOOST_CHECK_EQUAL(map.erase(i - 500), 1);
+        }
+    }
+    BOOST_CHECK_EQUAL(map.size(), 500);
+    BOOST_CHECK_EQUAL(map.bucket_count(), capacity);
+
+    const size_t usage = memusage::DynamicUsage(map);
+    BOOST_CHECK(usage >= capacity * sizeof(std::pair<const uint32_t,
+                                                     std::string>));
+    map.clear();
+    BOOST_CHECK_EQUAL(map.bucket_count(), 0);
+    BOOST_CHECK_EQUAL(memusage::DynamicUsage(map), 0);
+    BOOST_CHECK(map.find(1) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(moves_elements) {
+    // Elements that are not copyable are moved around when the table grows,
+    // and destroyed with the map.
+    auto counter = std::make_shared<int>(0);
+    {
+        FlatHashMap<uint32_t, std::unique_ptr<std::shared_ptr<int>>,
+                    MixingHash>
+            map;
+        for (uint32_t i = 0; i < 1000; ++i) {
+            map.try_emplace(i, std::make_unique<std::shared_ptr<int>>(counter));
+        }
+        BOOST_CHECK_EQUAL(counter.use_count(), 1001);
+        for (uint32_t i = 0; i < 1000; i += 2) {
+            map.erase(i);
+        }
+        BOOST_CHECK_EQUAL(counter.use_count(), 501);
+        for (const auto &[key, value] : map) {
+            BOOST_CHECK_EQUAL(key % 2, 1);
+            BOOST_CHECK(*value == counter);
+        }
+    }
+    BOOST_CHECK_EQUAL(counter.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
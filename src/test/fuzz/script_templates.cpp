@@ -0,0 +1,218 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <hash.h>
+#include <pubkey.h>
+#include <script/interpreter.h>
+#include <script/script.h>
+
+#include <test/fuzz/FuzzedDataProvider.h>
+#include <test/fuzz/fuzz.h>
+#include <test/fuzz/util.h>
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+using valtype = std::vector<uint8_t>;
+
+void initialize_script_templates() {
+    static const ECCVerifyHandle verify_handle;
+}
+
+namespace {
+/**
+ * The outcome of a signature check only depends on the signature and the
+ * pubkey, so that both evaluations see the same results.
+ */
+class DeterministicSignatureChecker : public BaseSignatureChecker {
+public:
+    bool CheckSig(const std::vector<uint8_t> &vchSigIn,
+                  const std::vector<uint8_t> &vchPubKey,
+                  const CScript &scriptCode, uint32_t flags) const override {
+        return !vchSigIn.empty() && !vchPubKey.empty() &&
+               ((vchSigIn[1 % vchSigIn.size()] ^ vchPubKey.back()) & 1) == 0;
+    }
+};
+
+/** VerifyScript, without the template evaluation. */
+bool VerifyScriptGeneric(const CScript &scriptSig, const CScript &scriptPubKey,
+                         uint32_t flags, const BaseSignatureChecker &checker,
+                         std::vector<valtype> &stack,
+                         ScriptExecutionMetrics &metrics, ScriptError &serror) {
+    if (flags & SCRIPT_ENABLE_SIGHASH_FORKID) {
+        flags |= SCRIPT_VERIFY_STRICTENC;
+    }
+    if (!EvalScript(stack, scriptSig, flags, checker, metrics, &serror)) {
+        return false;
+    }
+    std::vector<valtype> stackCopy{stack};
+    if (!EvalScript(stack, scriptPubKey, flags, checker, metrics, &serror)) {
+        return false;
+    }
+    if (stack.empty() || !CastToBool(stack.back())) {
+        serror = ScriptError::EVAL_FALSE;
+        return false;
+    }
+    if ((flags & SCRIPT_VERIFY_P2SH) && scriptPubKey.IsPayToScriptHash()) {
+        stack.swap(stackCopy);
+        const CScript redeemScript(stack.back().begin(), stack.back().end());
+        stack.pop_back();
+        if (!EvalScript(stack, redeemScript, flags, checker, metrics,
+                        &serror)) {
+            return false;
+        }
+        if (stack.empty() || !CastToBool(stack.back())) {
+            serror = ScriptError::EVAL_FALSE;
+            return false;
+        }
+    }
+    return true;
+}
+
+valtype ConsumePubKey(FuzzedDataProvider &fuzzed_data_provider) {
+    const size_t size{fuzzed_data_provider.ConsumeBool()
+                          ? CPubKey::COMPRESSED_SIZE
+                          : CPubKey::SIZE};
+    valtype pubkey = fuzzed_data_provider.ConsumeBytes<uint8_t>(size);
+    pubkey.resize(size);
+    if (fuzzed_data_provider.ConsumeBool()) {
+        pubkey[0] = pubkey.size() == CPubKey::SIZE
+                        ? 0x04
+                        : 0x02 | fuzzed_data_provider.ConsumeBool();
+    }
+    return pubkey;
+}
+
+valtype ConsumeSignature(FuzzedDataProvider &fuzzed_data_provider) {
+    const uint8_t hashtype = fuzzed_data_provider.ConsumeIntegral<uint8_t>();
+    switch (fuzzed_data_provider.ConsumeIntegralInRange(0, 3)) {
+        case 0:
+            return {};
+        case 1:
+            // A well formed ECDSA signature
+            return {0x30, 6, 2, 1, 0, 2, 1, 0, hashtype};
+        case 2: {
+            // A well formed Schnorr signature
+            valtype sig = fuzzed_data_provider.ConsumeBytes<uint8_t>(64);
+            sig.resize(64);
+            sig.push_back(hashtype);
+            return sig;
+        }
+        default:
+            return ConsumeRandomLengthByteVector(fuzzed_data_provider, 80);
+    }
+}
+
+CScript ConsumeScriptSig(FuzzedDataProvider &fuzzed_data_provider,
+                         const std::vector<valtype> &pushes) {
+    CScript scriptSig;
+    for (const valtype &push : pushes) {
+        scriptSig << push;
+    }
+    if (fuzzed_data_provider.ConsumeBool()) {
+        // Mess with the template a bit
+        const valtype extra =
+            ConsumeRandomLengthByteVector(fuzzed_data_provider, 8);
+        scriptSig.insert(fuzzed_data_provider.ConsumeBool() ? scriptSig.begin()
+                                                             : scriptSig.end(),
+                         extra.begin(), extra.end());
+    }
+    return scriptSig;
+}
+} // namespace
+
+FUZZ_TARGET_INIT(script_templates, initialize_script_templates) {
+    FuzzedDataProvider fuzzed_data_provider(buffer.data(), buffer.size());
+    const uint32_t flags = fuzzed_data_provider.ConsumeIntegral<uint32_t>();
+    if ((flags & SCRIPT_VERIFY_CLEANSTACK) && !(flags & SCRIPT_VERIFY_P2SH)) {
+        return;
+    }
+
+    CScript scriptSig, scriptPubKey;
+    std::vector<valtype> pushes;
+    switch (fuzzed_data_provider.ConsumeIntegralInRange(0, 3)) {
+        case 0: {
+            // P2PK
+            scriptPubKey << ConsumePubKey(fuzzed_data_provider) << OP_CHECKSIG;
+            pushes.push_back(ConsumeSignature(fuzzed_data_provider));
+            break;
+        }
+        case 1: {
+            // P2PKH
+            const valtype pubkey = ConsumePubKey(fuzzed_data_provider);
+            uint160 hash = Hash160(pubkey);
+            if (fuzzed_data_provider.ConsumeBool()) {
+                *hash.begin() ^= 1;
+            }
+            scriptPubKey << OP_DUP << OP_HASH160 << ToByteVector(hash)
+                         << OP_EQUALVERIFY << OP_CHECKSIG;
+            pushes.push_back(ConsumeSignature(fuzzed_data_provider));
+            pushes.push_back(pubkey);
+            break;
+        }
+        case 2: {
+            // P2SH multisig
+            const int nKeys =
+                fuzzed_data_provider.ConsumeIntegralInRange(1, 16);
+            const int nRequired =
+                fuzzed_data_provider.ConsumeIntegralInRange(1, nKeys);
+            CScript redeemScript;
+            redeemScript << CScript::EncodeOP_N(nRequired);
+            for (int i = 0; i < nKeys; i++) {
+                redeemScript << ConsumePubKey(fuzzed_data_provider);
+            }
+            redeemScript << CScript::EncodeOP_N(nKeys) << OP_CHECKMULTISIG;
+            uint160 hash = Hash160(redeemScript);
+            if (fuzzed_data_provider.ConsumeBool()) {
+                *hash.begin() ^= 1;
+            }
+            scriptPubKey << OP_HASH160 << ToByteVector(hash) << OP_EQUAL;
+            // The dummy, either null or a checkbits field
+            pushes.push_back(
+                ConsumeRandomLengthByteVector(fuzzed_data_provider, 3));
+            for (int i = 0; i < nRequired; i++) {
+                pushes.push_back(ConsumeSignature(fuzzed_data_provider));
+            }
+            pushes.emplace_back(redeemScript.begin(), redeemScript.end());
+            break;
+        }
+        default: {
+            const valtype bytes =
+                ConsumeRandomLengthByteVector(fuzzed_data_provider, 520);
+            scriptPubKey = CScript(bytes.begin(), bytes.end());
+            while (fuzzed_data_provider.ConsumeBool()) {
+                pushes.push_back(
+                    ConsumeRandomLengthByteVector(fuzzed_data_provider, 80));
+            }
+            break;
+        }
+    }
+    scriptSig = ConsumeScriptSig(fuzzed_data_provider, pushes);
+
+    const DeterministicSignatureChecker checker;
+    std::vector<valtype> stack;
+    ScriptExecutionMetrics metrics = {};
+    ScriptError serror = ScriptError::UNKNOWN;
+    const std::optional<bool> result = EvalStandardTemplate(
+        scriptSig, scriptPubKey, flags, checker, stack, metrics, &serror);
+    if (!result) {
+        return;
+    }
+
+    std::vector<valtype> stackGeneric;
+    ScriptExecutionMetrics metricsGeneric = {};
+    ScriptError serrorGeneric = ScriptError::UNKNOWN;
+    const bool resultGeneric =
+        VerifyScriptGeneric(scriptSig, scriptPubKey, flags, checker,
+                            stackGeneric, metricsGeneric, serrorGeneric);
+    assert(*result == resultGeneric);
+    if (resultGeneric) {
+        // The templates only succeed with a clean stack.
+        assert(stack == stackGeneric && stack.size() == 1);
+        assert(metrics.nSigChecks == metricsGeneric.nSigChecks);
+    } else {
+        assert(serror == serrorGeneric);
+    }
+}
@@ -56,6 +56,17 @@ ssize_t FuzzedSock::Send(const void *data, size_t len, int flags) const {
     return r;
 }
 
+ssize_t FuzzedSock::SendMany(Span<const Span<const uint8_t>> buffers,
+                             int flags) const {
+    size_t len{0};
+    const size_t count{std::min(buffers.size(), MAX_SEND_BUFFERS)};
+    for (size_t i = 0; i < count; ++i) {
+        len += buffers[i].size();
+    }
+    // Only the length matters, the data is never looked at.
+    return Send(nullptr, len, flags);
+}
+
 ssize_t FuzzedSock::Recv(void *buf, size_t len, int flags) const {
     constexpr std::array<int, 10> recv_errnos{{
         EAGAIN,
@@ -160,4 +160,53 @@ BOOST_AUTO_TEST_CASE(headers_sync_state) {
     BOOST_CHECK(result.success);
 }
 
+// Check that the next headers are only requested before processing a PRESYNC
+// message when the request is known to be the one that follows it.
+BOOST_AUTO_TEST_CASE(pipelined_headers_request) {
+    std::vector<CBlockHeader> chain;
+    const int target_blocks = 3000;
+    GenerateHeaders(chain, target_blocks - 1, Params().GenesisBlock().GetHash(),
+                    Params().GenesisBlock().nVersion,
+                    Params().GenesisBlock().nTime, ArithToUint256(0),
+                    Params().GenesisBlock().nBits);
+    const std::vector<CBlockHeader> first(chain.begin(), chain.begin() + 1000);
+    const std::vector<CBlockHeader> second(chain.begin() + 1000,
+                                           chain.begin() + 2000);
+    const std::vector<CBlockHeader> third(chain.begin() + 2000, chain.end());
+
+    const CBlockIndex *chain_start = WITH_LOCK(
+        ::cs_main, return m_node.chainman->m_blockman.LookupBlockIndex(
+                       Params().GenesisBlock().GetHash()));
+    HeadersSyncState hss(
+        0, Params().GetConsensus(), chain_start,
+        chain_start->GetBlockHeader(m_node.chainman->m_blockman),
+        target_blocks * 2);
+
+    // Only full messages which continue the sync are pipelined
+    BOOST_CHECK(!hss.PipelinedHeadersRequestLocator(first, false));
+    BOOST_CHECK(!hss.PipelinedHeadersRequestLocator(second, true));
+    auto locator = hss.PipelinedHeadersRequestLocator(first, true);
+    BOOST_REQUIRE(locator);
+    BOOST_CHECK(locator->vHave.front() == first.back().GetHash());
+
+    auto result = hss.ProcessNextHeaders(first, true);
+    BOOST_CHECK(result.success);
+    BOOST_CHECK(result.request_more);
+    BOOST_CHECK(hss.NextHeadersRequestLocator().vHave == locator->vHave);
+
+    locator = hss.PipelinedHeadersRequestLocator(second, true);
+    BOOST_REQUIRE(locator);
+    result = hss.ProcessNextHeaders(second, true);
+    BOOST_CHECK(result.request_more);
+    BOOST_CHECK(hss.NextHeadersRequestLocator().vHave == locator->vHave);
+
+    // The last headers reach the required work, so the sync restarts from the
+    // chain start in the REDOWNLOAD phase instead
+    BOOST_CHECK(!hss.PipelinedHeadersRequestLocator(third, true));
+    result = hss.ProcessNextHeaders(third, true);
+    BOOST_CHECK(result.request_more);
+    BOOST_CHECK(hss.GetState() == HeadersSyncState::State::REDOWNLOAD);
+    BOOST_CHECK(!hss.PipelinedHeadersRequestLocator(first, true));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,287 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <inputfetcher.h>
+
+#include <coins.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <txdb.h>
+#include <validationthreadpool.h>
+
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <future>
+#include <map>
+#include <vector>
+
+namespace {
+
+/** A coins view that can be read from multiple threads. */
+class CoinsViewMap : public CCoinsView {
+public:
+    std::map<COutPoint, Coin> m_coins;
+    mutable std::atomic<int> m_reads{0};
+
+    bool GetCoin(const COutPoint &outpoint, Coin &coin) const override {
+        ++m_reads;
+        auto it = m_coins.find(outpoint);
+        if (it == m_coins.end()) {
+            return false;
+        }
+        coin = it->second;
+        return true;
+    }
+};
+
+struct InputFetcherSetup : public BasicTestingSetup {
+    CoinsViewMap db;
+    ValidationThreadPool pool;
+    InputFetcher fetcher;
+
+    InputFetcherSetup() {
+        fetcher.StartWorkerPool(pool,
+                                ValidationThreadPool::Priority::INPUT_FETCH);
+    }
+
+    ~InputFetcherSetup() {
+        pool.Stop();
+        fetcher.StopWorkerPool();
+    }
+
+    COutPoint AddDbCoin() {
+        const COutPoint outpoint(TxId(InsecureRand256()), 0);
+        db.m_coins.emplace(outpoint,
+                           Coin(CTxOut(COIN, CScript() << OP_TRUE), 1, false));
+        return outpoint;
+    }
+};
+
+CTransactionRef MakeTx(const std::vector<COutPoint> &prevouts) {
+    CMutableTransaction mtx;
+    for (const COutPoint &prevout : prevouts) {
+        mtx.vin.emplace_back(prevout);
+    }
+    mtx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+    if (prevouts.empty()) {
+        // Make it a coinbase.
+        mtx.vin.emplace_back(COutPoint());
+    }
+    return MakeTransactionRef(mtx);
+}
+
+/** Wait for the tasks submitted so far to a single thread pool to be run. */
+void WaitForTasks(ValidationThreadPool &pool) {
+    std::promise<void> promise;
+    pool.Submit([&]() { promise.set_value(); });
+    promise.get_future().wait();
+}
+
+void WriteCoins(CCoinsViewDB &db, const std::vector<COutPoint> &outpoints) {
+    CCoinsViewCache cache(&db);
+    for (const COutPoint &outpoint : outpoints) {
+        cache.AddCoin(outpoint,
+                      Coin(CTxOut(COIN, CScript() << OP_TRUE), 1, false),
+                      false);
+    }
+    cache.SetBestBlock(BlockHash(InsecureRand256()));
+    BOOST_CHECK(cache.Flush());
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(inputfetcher_tests, InputFetcherSetup)
+
+BOOST_AUTO_TEST_CASE(fetch_inputs) {
+    pool.Start(3);
+
+    CBlock block;
+    block.vtx.push_back(MakeTx({}));
+    std::vector<std::vector<COutPoint>> inputs;
+    for (int i = 0; i < 50; ++i) {
+        std::vector<COutPoint> prevouts;
+        for (int j = 0; j < i % 5 + 1; ++j) {
+            prevouts.push_back(AddDbCoin());
+        }
+        inputs.push_back(prevouts);
+        block.vtx.push_back(MakeTx(prevouts));
+    }
+    // An output created in the block and a missing coin are not fetched.
+    const COutPoint in_block(block.vtx[3]->GetId(), 0);
+    const COutPoint missing(TxId(InsecureRand256()), 0);
+    block.vtx.push_back(MakeTx({in_block, missing}));
+
+    CCoinsViewCache cache(&db);
+    // Coins already in the cache are not read again.
+    BOOST_CHECK(!cache.AccessCoin(inputs[0][0]).IsSpent());
+    db.m_reads = 0;
+
+    {
+        InputFetcherControl control(fetcher, block, cache, db);
+        for (size_t i = 1; i < block.vtx.size(); ++i) {
+            control.FetchInputs(i, cache);
+            for (const CTxIn &txin : block.vtx[i]->vin) {
+                const bool fetched = txin.prevout != in_block &&
+                                     txin.prevout != missing;
+                BOOST_CHECK_EQUAL(cache.HaveCoinInCache(txin.prevout),
+                                  fetched);
+            }
+        }
+    }
+
+    size_t num_fetched = 1;
+    for (const auto &prevouts : inputs) {
+        num_fetched += prevouts.size();
+    }
+    // Everything but the cached coin and the output created in the block.
+    BOOST_CHECK_EQUAL(db.m_reads, num_fetched - 1);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), num_fetched - 1);
+}
+
+BOOST_AUTO_TEST_CASE(keep_cache_entries) {
+    pool.Start(2);
+
+    const COutPoint spent = AddDbCoin();
+    const COutPoint unspent = AddDbCoin();
+
+    CBlock block;
+    block.vtx.push_back(MakeTx({}));
+    block.vtx.push_back(MakeTx({spent, unspent}));
+
+    // The coin is spent in the cache but not yet in the database, the fetched
+    // coin must not resurrect it.
+    CCoinsViewCache cache(&db);
+    BOOST_CHECK(cache.SpendCoin(spent));
+    BOOST_CHECK(!cache.HaveCoinInCache(spent));
+
+    {
+        InputFetcherControl control(fetcher, block, cache, db);
+        control.FetchInputs(1, cache);
+    }
+    BOOST_CHECK(!cache.HaveCoin(spent));
+    BOOST_CHECK(cache.HaveCoinInCache(unspent));
+}
+
+BOOST_AUTO_TEST_CASE(no_worker) {
+    const COutPoint outpoint = AddDbCoin();
+
+    CBlock block;
+    block.vtx.push_back(MakeTx({}));
+    block.vtx.push_back(MakeTx({outpoint}));
+
+    CCoinsViewCache cache(&db);
+    {
+        InputFetcherControl control(fetcher, block, cache, db);
+        control.FetchInputs(1, cache);
+    }
+    // The reads are left to the connecting thread.
+    BOOST_CHECK_EQUAL(db.m_reads, 0);
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoint));
+}
+
+BOOST_AUTO_TEST_CASE(stop_early) {
+    pool.Start(3);
+
+    CBlock block;
+    block.vtx.push_back(MakeTx({}));
+    for (int i = 0; i < 100; ++i) {
+        block.vtx.push_back(MakeTx({AddDbCoin(), AddDbCoin()}));
+    }
+
+    // Stopping halfway through the block, e.g. because it is invalid, waits
+    // for the workers and lets the fetcher be reused.
+    CCoinsViewCache cache(&db);
+    for (int n = 0; n < 10; ++n) {
+        InputFetcherControl control(fetcher, block, cache, db);
+        control.FetchInputs(n, cache);
+    }
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        cache.Uncache(block.vtx[i]->vin[0].prevout);
+        cache.Uncache(block.vtx[i]->vin[1].prevout);
+    }
+    InputFetcherControl control(fetcher, block, cache, db);
+    control.FetchInputs(block.vtx.size() - 1, cache);
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        BOOST_CHECK(cache.HaveCoinInCache(block.vtx[i]->vin[1].prevout));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(prefetch_coins) {
+    pool.Start(1);
+
+    CCoinsViewDB coinsdb{
+        {.path = "test", .cache_bytes = 1 << 20, .memory_only = true}, {}};
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 20; ++i) {
+        outpoints.emplace_back(TxId(InsecureRand256()), 0);
+    }
+    WriteCoins(coinsdb, outpoints);
+
+    CBlock block;
+    block.vtx.push_back(MakeTx({}));
+    block.vtx.push_back(MakeTx({outpoints.begin(), outpoints.begin() + 10}));
+    block.vtx.push_back(MakeTx({outpoints.begin() + 10, outpoints.end()}));
+    const BlockHash hash{block.GetHash()};
+    std::atomic<int> reads{0};
+    const auto read_block = [&](CBlock &block_out) {
+        ++reads;
+        block_out = block;
+        return true;
+    };
+
+    CCoinsViewCache cache(&coinsdb);
+    CoinsPrefetcher prefetcher;
+
+    // Nothing to apply for an unknown block, or before the reads are done.
+    BOOST_CHECK_EQUAL(prefetcher.Apply(hash, 1, cache, coinsdb), 0);
+
+    // The coins are inserted right before the block is connected.
+    prefetcher.Prefetch(hash, 1, read_block, coinsdb, pool);
+    prefetcher.Prefetch(hash, 1, read_block, coinsdb, pool);
+    WaitForTasks(pool);
+    BOOST_CHECK_EQUAL(reads, 1);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0);
+    BOOST_CHECK_EQUAL(prefetcher.Apply(hash, 1, cache, coinsdb),
+                      outpoints.size());
+    for (const COutPoint &outpoint : outpoints) {
+        BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+    }
+    BOOST_CHECK_EQUAL(prefetcher.Apply(hash, 1, cache, coinsdb), 0);
+
+    // The coins read are dropped if the database is written to in between.
+    for (const COutPoint &outpoint : outpoints) {
+        cache.Uncache(outpoint);
+    }
+    prefetcher.Prefetch(hash, 1, read_block, coinsdb, pool);
+    WaitForTasks(pool);
+    WriteCoins(coinsdb, {COutPoint(TxId(InsecureRand256()), 0)});
+    BOOST_CHECK_EQUAL(prefetcher.Apply(hash, 1, cache, coinsdb), 0);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0);
+
+    // Blocks that are not connected by the time their height is reached are
+    // forgotten.
+    prefetcher.Prefetch(hash, 1, read_block, coinsdb, pool);
+    WaitForTasks(pool);
+    BOOST_CHECK_EQUAL(prefetcher.Apply(BlockHash(InsecureRand256()), 2, cache,
+                                       coinsdb),
+                      0);
+    BOOST_CHECK_EQUAL(prefetcher.Apply(hash, 1, cache, coinsdb), 0);
+
+    // Stopping cancels the pending reads. Keep the worker busy so the read is
+    // still pending.
+    std::promise<void> release;
+    pool.Submit([future = release.get_future().share()]() { future.wait(); });
+    prefetcher.Prefetch(hash, 1, read_block, coinsdb, pool);
+    prefetcher.Stop();
+    release.set_value();
+    WaitForTasks(pool);
+    BOOST_CHECK_EQUAL(reads, 3);
+    BOOST_CHECK_EQUAL(prefetcher.Apply(hash, 1, cache, coinsdb), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
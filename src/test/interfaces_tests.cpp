@@ -75,6 +75,47 @@ BOOST_AUTO_TEST_CASE(findBlock) {
     BOOST_CHECK(!chain->findBlock(BlockHash(), FoundBlock()));
 }
 
+BOOST_AUTO_TEST_CASE(findBlocks) {
+    LOCK(Assert(m_node.chainman)->GetMutex());
+    auto &chain = m_node.chain;
+    const CChain &active = Assert(m_node.chainman)->ActiveChain();
+
+    int height1{-1}, height2{-1};
+    int64_t time{-1};
+    BOOST_CHECK_EQUAL(
+        chain->findBlocks({{active[10]->GetBlockHash(),
+                            FoundBlock().height(height1)},
+                           {BlockHash(), FoundBlock()},
+                           {active[20]->GetBlockHash(),
+                            FoundBlock().height(height2).time(time)}}),
+        2U);
+    BOOST_CHECK_EQUAL(height1, 10);
+    BOOST_CHECK_EQUAL(height2, 20);
+    BOOST_CHECK_EQUAL(time, active[20]->GetBlockTime());
+    BOOST_CHECK_EQUAL(chain->findBlocks({}), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(findNextBlocks) {
+    LOCK(Assert(m_node.chainman)->GetMutex());
+    auto &chain = m_node.chain;
+    const CChain &active = Assert(m_node.chainman)->ActiveChain();
+
+    std::vector<BlockHash> hashes{
+        chain->findNextBlocks(active[10]->GetBlockHash(), 3)};
+    BOOST_CHECK_EQUAL(hashes.size(), 3U);
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        BOOST_CHECK_EQUAL(hashes[i], active[11 + i]->GetBlockHash());
+    }
+
+    // Stops at the tip
+    hashes = chain->findNextBlocks(active[98]->GetBlockHash(), 10);
+    BOOST_CHECK_EQUAL(hashes.size(), 2U);
+    BOOST_CHECK_EQUAL(hashes.back(), active.Tip()->GetBlockHash());
+
+    BOOST_CHECK(chain->findNextBlocks(active[10]->GetBlockHash(), 0).empty());
+    BOOST_CHECK(chain->findNextBlocks(BlockHash(), 10).empty());
+}
+
 BOOST_AUTO_TEST_CASE(findFirstBlockWithTimeAndHeight) {
     LOCK(Assert(m_node.chainman)->GetMutex());
     auto &chain = m_node.chain;
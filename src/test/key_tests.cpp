@@ -12,6 +12,7 @@
 #include <util/strencodings.h>
 #include <util/string.h>
 
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
@@ -449,4 +450,42 @@ BOOST_AUTO_TEST_CASE(pubkey_unserialize) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(schnorr_batch_test) {
+    std::vector<SchnorrSigCheck> checks;
+    BOOST_CHECK(VerifySchnorrBatch(checks));
+
+    for (int i = 0; i < 32; ++i) {
+        CKey key;
+        key.MakeNewKey(i % 2 == 0);
+        SchnorrSigCheck &check = checks.emplace_back();
+        check.hash = InsecureRand256();
+        check.pubkey = key.GetPubKey();
+        BOOST_REQUIRE(key.SignSchnorr(check.hash, check.sig));
+    }
+
+    // Any subset of valid signatures verifies as a batch
+    BOOST_CHECK(VerifySchnorrBatch(checks));
+    BOOST_CHECK(VerifySchnorrBatch({checks.begin(), checks.begin() + 1}));
+    BOOST_CHECK(VerifySchnorrBatch({checks.begin() + 3, checks.end()}));
+
+    // A single bad signature, message or public key fails the batch
+    for (size_t i : {size_t(0), checks.size() / 2, checks.size() - 1}) {
+        std::vector<SchnorrSigCheck> bad = checks;
+        bad[i].sig[InsecureRandRange(CPubKey::SCHNORR_SIZE)] ^= 0x01;
+        BOOST_CHECK(!VerifySchnorrBatch(bad));
+
+        bad = checks;
+        bad[i].hash = InsecureRand256();
+        BOOST_CHECK(!VerifySchnorrBatch(bad));
+
+        bad = checks;
+        bad[i].pubkey = checks[(i + 1) % checks.size()].pubkey;
+        BOOST_CHECK(!VerifySchnorrBatch(bad));
+
+        bad = checks;
+        bad[i].pubkey = CPubKey();
+        BOOST_CHECK(!VerifySchnorrBatch(bad));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
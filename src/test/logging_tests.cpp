@@ -7,9 +7,11 @@
 #include <test/util/setup_common.h>
 #include <util/string.h>
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -25,6 +27,7 @@ struct LogSetup : public BasicTestingSetup {
     bool prev_log_timestamps;
     bool prev_log_threadnames;
     bool prev_log_sourcelocations;
+    bool prev_log_json;
 
     LogSetup()
         : prev_log_path{LogInstance().m_file_path},
@@ -33,7 +36,8 @@ struct LogSetup : public BasicTestingSetup {
           prev_print_to_file{LogInstance().m_print_to_file},
           prev_log_timestamps{LogInstance().m_log_timestamps},
           prev_log_threadnames{LogInstance().m_log_threadnames},
-          prev_log_sourcelocations{LogInstance().m_log_sourcelocations} {
+          prev_log_sourcelocations{LogInstance().m_log_sourcelocations},
+          prev_log_json{LogInstance().m_log_json} {
         LogInstance().m_file_path = tmp_log_path;
         LogInstance().m_reopen_file = true;
         LogInstance().m_print_to_file = true;
@@ -50,6 +54,7 @@ struct LogSetup : public BasicTestingSetup {
         LogInstance().m_log_timestamps = prev_log_timestamps;
         LogInstance().m_log_threadnames = prev_log_threadnames;
         LogInstance().m_log_sourcelocations = prev_log_sourcelocations;
+        LogInstance().m_log_json = prev_log_json;
     }
 };
 
@@ -174,4 +179,181 @@ BOOST_FIXTURE_TEST_CASE(logging_LogPrintMacros_CategoryName, LogSetup) {
                                   expected.begin(), expected.end());
 }
 
+static std::vector<std::string> read_debug_log(const fs::path &path) {
+    std::ifstream file{path};
+    std::vector<std::string> log_lines;
+    for (std::string log; std::getline(file, log);) {
+        log_lines.push_back(log);
+    }
+    return log_lines;
+}
+
+BOOST_FIXTURE_TEST_CASE(logging_json, LogSetup) {
+    LogInstance().m_log_json = true;
+    LogPrintf_("fn1", "./src1", 1, BCLog::LogFlags::NET, BCLog::Level::Debug,
+               "foo1: %s", "\"bar1\"\\\n");
+    LogPrintf_("fn2", "src2", 2, BCLog::LogFlags::NONE, BCLog::Level::None,
+               "foo2: %s", "bar2\x01\n");
+    flush_debug_log();
+    LogInstance().m_log_json = false;
+
+    std::vector<std::string> log_lines = read_debug_log(tmp_log_path);
+    BOOST_REQUIRE_EQUAL(log_lines.size(), 2);
+    // The time and thread vary
+    for (std::string &line : log_lines) {
+        BOOST_REQUIRE(line.substr(0, 9) == "{\"time\":\"");
+        const size_t category = line.find(",\"category\"");
+        BOOST_REQUIRE(category != std::string::npos);
+        line.erase(0, category);
+    }
+    BOOST_CHECK_EQUAL(log_lines[0],
+                      ",\"category\":\"net\",\"level\":\"debug\","
+                      "\"file\":\"src1\",\"line\":1,\"function\":\"fn1\","
+                      "\"message\":\"foo1: \\\"bar1\\\"\\\\\"}");
+    BOOST_CHECK_EQUAL(log_lines[1],
+                      ",\"category\":\"\",\"level\":\"none\","
+                      "\"file\":\"src2\",\"line\":2,\"function\":\"fn2\","
+                      "\"message\":\"foo2: bar2\\\\x01\"}");
+}
+
+BOOST_FIXTURE_TEST_CASE(logging_async, LogSetup) {
+    LogInstance().m_log_sourcelocations = false;
+    LogInstance().EnableCategory(BCLog::NET);
+    const auto stats_before = LogInstance().GetAsyncStats();
+
+    constexpr int NUM_THREADS{4};
+    constexpr int NUM_MESSAGES{1000};
+    // Large enough that no messages are dropped
+    LogInstance().StartAsyncLogging(NUM_MESSAGES);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        threads.emplace_back([i] {
+            for (int j = 0; j < NUM_MESSAGES; ++j) {
+                LogPrint(BCLog::NET, "thread %d message %d\n", i, j);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    LogInstance().StopAsyncLogging();
+    flush_debug_log();
+
+    const auto stats = LogInstance().GetAsyncStats();
+    BOOST_CHECK_EQUAL(stats.written - stats_before.written,
+                      NUM_THREADS * NUM_MESSAGES);
+    BOOST_CHECK_EQUAL(stats.dropped, stats_before.dropped);
+
+    // The messages of each thread are in order
+    std::vector<int> next_message(NUM_THREADS, 0);
+    for (const std::string &line : read_debug_log(tmp_log_path)) {
+        int thread, message;
+        if (sscanf(line.c_str(), "[net] thread %d message %d", &thread,
+                   &message) == 2) {
+            BOOST_REQUIRE(thread >= 0 && thread < NUM_THREADS);
+            BOOST_CHECK_EQUAL(message, next_message[thread]++);
+        }
+    }
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        BOOST_CHECK_EQUAL(next_message[i], NUM_MESSAGES);
+    }
+    LogInstance().DisableCategory(BCLog::NET);
+}
+
+BOOST_FIXTURE_TEST_CASE(logging_async_drop, LogSetup) {
+    LogInstance().m_log_sourcelocations = false;
+    LogInstance().EnableCategory(BCLog::NET);
+    const auto stats_before = LogInstance().GetAsyncStats();
+
+    constexpr int NUM_MESSAGES{1000};
+    LogInstance().StartAsyncLogging(1);
+    for (int i = 0; i < NUM_MESSAGES; ++i) {
+        LogPrint(BCLog::NET, "debug message %d\n", i);
+        LogPrintf("message %d\n", i);
+    }
+    LogInstance().StopAsyncLogging();
+    flush_debug_log();
+
+    // The debug messages can be dropped, but not the others
+    const auto stats = LogInstance().GetAsyncStats();
+    const uint64_t dropped = stats.dropped - stats_before.dropped;
+    BOOST_CHECK(dropped <= NUM_MESSAGES);
+    int debug_messages = 0;
+    int messages = 0;
+    uint64_t dropped_reported = 0;
+    for (const std::string &line : read_debug_log(tmp_log_path)) {
+        debug_messages += line.rfind("[net] debug message ", 0) == 0;
+        messages += line.rfind("message ", 0) == 0;
+        int count;
+        if (sscanf(line.c_str(), "[warning] Dropped %d log messages",
+                   &count) == 1) {
+            dropped_reported += count;
+        }
+    }
+    BOOST_CHECK_EQUAL(debug_messages + dropped, NUM_MESSAGES);
+    BOOST_CHECK_EQUAL(messages, NUM_MESSAGES);
+    BOOST_CHECK_EQUAL(dropped_reported, dropped);
+    LogInstance().DisableCategory(BCLog::NET);
+}
+
+BOOST_FIXTURE_TEST_CASE(logging_rate_limit, LogSetup) {
+    LogInstance().m_log_sourcelocations = false;
+    LogInstance().EnableCategory(BCLog::NET);
+    LogInstance().EnableCategory(BCLog::MEMPOOL);
+    LogInstance().EnableCategory(BCLog::VALIDATION);
+    LogInstance().SetRateLimit(BCLog::NET, 2);
+    LogInstance().SetSampling(BCLog::MEMPOOL, 3);
+
+    SetMockTime(1);
+    auto log = [](int i) {
+        LogPrint(BCLog::NET, "net %d\n", i);
+        LogPrintLevel(BCLog::NET, BCLog::Level::Warning, "warning %d\n", i);
+        LogPrint(BCLog::MEMPOOL, "mempool %d\n", i);
+        LogPrint(BCLog::VALIDATION, "validation %d\n", i);
+    };
+    for (int i = 0; i < 5; ++i) {
+        log(i);
+    }
+    SetMockTime(2);
+    log(5);
+    SetMockTime(0);
+    flush_debug_log();
+
+    LogInstance().SetRateLimit(BCLog::ALL, 0);
+    LogInstance().SetSampling(BCLog::ALL, 0);
+    LogInstance().DisableCategory(BCLog::NET);
+    LogInstance().DisableCategory(BCLog::MEMPOOL);
+    LogInstance().DisableCategory(BCLog::VALIDATION);
+
+    std::vector<std::string> net_lines;
+    std::vector<std::string> other_lines;
+    for (const std::string &line : read_debug_log(tmp_log_path)) {
+        if (line.rfind("[net] ", 0) == 0) {
+            net_lines.push_back(line);
+        } else if (line.rfind("Sentinel", 0) != 0) {
+            other_lines.push_back(line);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(net_lines.size(), 4);
+    BOOST_CHECK_EQUAL(net_lines[0], "[net] net 0");
+    BOOST_CHECK_EQUAL(net_lines[1], "[net] net 1");
+    BOOST_CHECK(net_lines[2].rfind("[net] Suppressed 3 messages from ", 0) ==
+                0);
+    BOOST_CHECK_EQUAL(net_lines[3], "[net] net 5");
+
+    // The warnings and the categories without limits are all logged
+    std::vector<std::string> expected;
+    for (int i = 0; i < 6; ++i) {
+        expected.push_back(strprintf("[net:warning] warning %d", i));
+        if (i % 3 == 0) {
+            expected.push_back(strprintf("[mempool] mempool %d", i));
+        }
+        expected.push_back(strprintf("[validation] validation %d", i));
+    }
+    std::sort(expected.begin(), expected.end());
+    std::sort(other_lines.begin(), other_lines.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(other_lines.begin(), other_lines.end(),
+                                  expected.begin(), expected.end());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
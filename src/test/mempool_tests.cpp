@@ -634,4 +634,57 @@ BOOST_AUTO_TEST_CASE(remove_for_finalized_block) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(change_journal) {
+    CTxMemPool::Options opts{MemPoolOptionsForTest(m_node)};
+    opts.journal_size = 4;
+    CTxMemPool pool{opts};
+    TestMemPoolEntryHelper entry;
+
+    LOCK2(cs_main, pool.cs);
+
+    const uint64_t start{pool.GetSequence()};
+    BOOST_CHECK(pool.GetChangesSince(start)->empty());
+
+    const CTransactionRef tx1{make_tx({1 * COIN})};
+    const CTransactionRef tx2{make_tx({2 * COIN})};
+    pool.addUnchecked(entry.FromTx(tx1));
+    BOOST_CHECK_EQUAL(pool.RecordChange(tx1->GetId()), start);
+    pool.addUnchecked(entry.FromTx(tx2));
+    BOOST_CHECK_EQUAL(pool.RecordChange(tx2->GetId()), start + 1);
+    pool.removeRecursive(*tx1, MemPoolRemovalReason::CONFLICT);
+    pool.removeRecursive(*tx2, MemPoolRemovalReason::BLOCK);
+    BOOST_CHECK_EQUAL(pool.GetSequence(), start + 4);
+
+    // The removals for a block are recorded too, so the sequence is gapless
+    auto changes{pool.GetChangesSince(start)};
+    BOOST_REQUIRE(changes);
+    BOOST_REQUIRE_EQUAL(changes->size(), 4U);
+    const std::vector<std::pair<TxId, std::optional<MemPoolRemovalReason>>>
+        expected{{tx1->GetId(), std::nullopt},
+                 {tx2->GetId(), std::nullopt},
+                 {tx1->GetId(), MemPoolRemovalReason::CONFLICT},
+                 {tx2->GetId(), MemPoolRemovalReason::BLOCK}};
+    for (size_t i = 0; i < expected.size(); i++) {
+        BOOST_CHECK_EQUAL((*changes)[i].sequence, start + i);
+        BOOST_CHECK((*changes)[i].txid == expected[i].first);
+        BOOST_CHECK((*changes)[i].removal_reason == expected[i].second);
+    }
+
+    changes = pool.GetChangesSince(start + 3);
+    BOOST_REQUIRE(changes);
+    BOOST_REQUIRE_EQUAL(changes->size(), 1U);
+    BOOST_CHECK(changes->front().txid == tx2->GetId());
+    BOOST_CHECK(pool.GetChangesSince(start + 4)->empty());
+    BOOST_CHECK(pool.GetChangesSince(start + 100)->empty());
+
+    // Older changes are dropped once the journal is full
+    pool.addUnchecked(entry.FromTx(tx1));
+    pool.RecordChange(tx1->GetId());
+    BOOST_CHECK(!pool.GetChangesSince(start));
+    changes = pool.GetChangesSince(start + 1);
+    BOOST_REQUIRE(changes);
+    BOOST_CHECK_EQUAL(changes->size(), 4U);
+    BOOST_CHECK_EQUAL(changes->back().sequence, start + 4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -255,4 +255,94 @@ BOOST_AUTO_TEST_CASE(merkle_test_LeftSubtreeRightSubtree) {
 
     BOOST_CHECK_EQUAL(root, rootOfLR);
 }
+
+BOOST_AUTO_TEST_CASE(merkle_test_parallel) {
+    // Run the jobs backwards, the result must not depend on their order
+    const MerkleParallelFor parallel_for =
+        [](size_t count, const std::function<void(size_t)> &job) {
+            for (size_t i = count; i-- > 0;) {
+                job(i);
+            }
+        };
+
+    for (const size_t size :
+         {size_t{1}, size_t{2047}, size_t{2048}, size_t{2049}, size_t{4096},
+          size_t{4097}, size_t{5000}, size_t{16387},
+          size_t{2048 + InsecureRandRange(20000)}}) {
+        std::vector<uint256> leaves(size);
+        for (auto &leaf : leaves) {
+            leaf = InsecureRand256();
+        }
+
+        bool mutated{true};
+        bool parallel_mutated{true};
+        BOOST_CHECK_EQUAL(ComputeMerkleRoot(leaves, &mutated),
+                          ComputeMerkleRoot(leaves, &parallel_mutated,
+                                            parallel_for));
+        BOOST_CHECK(!mutated);
+        BOOST_CHECK(!parallel_mutated);
+
+        // Duplicating the last leaves gives the same root, but is detected
+        std::vector<uint256> duplicated{leaves};
+        const size_t duplicate{size_t{1} << ctz(size)};
+        if (duplicate < size) {
+            duplicated.insert(duplicated.end(), leaves.end() - duplicate,
+                              leaves.end());
+            BOOST_CHECK_EQUAL(ComputeMerkleRoot(duplicated, &parallel_mutated,
+                                                parallel_for),
+                              ComputeMerkleRoot(leaves));
+            BOOST_CHECK(parallel_mutated);
+        }
+
+        // So is a pair of identical leaves inside the tree
+        if (size > 11) {
+            duplicated = leaves;
+            duplicated[10] = duplicated[11];
+            BOOST_CHECK_EQUAL(ComputeMerkleRoot(duplicated, &mutated),
+                              ComputeMerkleRoot(duplicated, &parallel_mutated,
+                                                parallel_for));
+            BOOST_CHECK(mutated);
+            BOOST_CHECK(parallel_mutated);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(merkle_test_cache) {
+    MerkleTreeCache cache;
+    BOOST_CHECK(cache.ComputeRoot({}).IsNull());
+
+    std::vector<uint256> leaves;
+    for (int i = 0; i < 200; i++) {
+        // Change the "coinbase", and add, remove or replace a few leaves
+        if (!leaves.empty()) {
+            leaves[0] = InsecureRand256();
+        }
+        switch (InsecureRandRange(4)) {
+            case 0:
+                for (int j = InsecureRandRange(5); j >= 0; --j) {
+                    leaves.insert(leaves.begin() +
+                                      InsecureRandRange(leaves.size() + 1),
+                                  InsecureRand256());
+                }
+                break;
+            case 1:
+                if (!leaves.empty()) {
+                    leaves.erase(leaves.begin() +
+                                 InsecureRandRange(leaves.size()));
+                }
+                break;
+            case 2:
+                if (!leaves.empty()) {
+                    leaves[InsecureRandRange(leaves.size())] =
+                        InsecureRand256();
+                }
+                break;
+            default:
+                leaves.resize(InsecureRandRange(300), InsecureRand256());
+                break;
+        }
+        BOOST_CHECK_EQUAL(cache.ComputeRoot(leaves), ComputeMerkleRoot(leaves));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
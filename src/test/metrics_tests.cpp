@@ -0,0 +1,86 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/metrics.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+BOOST_FIXTURE_TEST_SUITE(metrics_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(histogram_buckets) {
+    using metrics::Histogram;
+    // The buckets are contiguous and each value is in the bucket it indexes
+    uint64_t next{0};
+    for (size_t i = 0; i < Histogram::NUM_BUCKETS; ++i) {
+        BOOST_CHECK_EQUAL(Histogram::BucketIndex(next), i);
+        const uint64_t max{Histogram::BucketMax(i)};
+        BOOST_CHECK_GE(max, next);
+        BOOST_CHECK_EQUAL(Histogram::BucketIndex(max), i);
+        // The bucket width is within 1/SUB_BUCKETS of the values
+        BOOST_CHECK_LE((max - next) * Histogram::SUB_BUCKETS, next);
+        next = max + 1;
+    }
+    BOOST_CHECK_EQUAL(next, Histogram::MAX_VALUE + 1);
+    BOOST_CHECK_EQUAL(Histogram::BucketIndex(Histogram::MAX_VALUE + 1),
+                      Histogram::NUM_BUCKETS - 1);
+    BOOST_CHECK_EQUAL(Histogram::BucketIndex(UINT64_MAX),
+                      Histogram::NUM_BUCKETS - 1);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_quantiles) {
+    metrics::Histogram histogram;
+    BOOST_CHECK_EQUAL(histogram.GetSnapshot().Quantile(0.5), 0U);
+
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.Record(value);
+    }
+    histogram.Record(std::chrono::microseconds{-5});
+
+    const metrics::Histogram::Snapshot snapshot{histogram.GetSnapshot()};
+    BOOST_CHECK_EQUAL(snapshot.count, 1001U);
+    BOOST_CHECK_EQUAL(snapshot.sum, 500500U);
+    BOOST_CHECK_EQUAL(snapshot.max, 1000U);
+    for (double q : {0.5, 0.9, 0.99}) {
+        const double expected{q * 1001};
+        const double quantile = snapshot.Quantile(q);
+        BOOST_CHECK_GE(quantile, expected - 1);
+        BOOST_CHECK_LE(quantile, expected * (1 + 1.0 / 16) + 1);
+    }
+    BOOST_CHECK_EQUAL(snapshot.Quantile(0), 0U);
+    BOOST_CHECK_EQUAL(snapshot.Quantile(1), 1000U);
+}
+
+BOOST_AUTO_TEST_CASE(registry) {
+    auto get_counter = [](const std::string &kind) -> metrics::Counter & {
+        return metrics::GetCounter("test_counter", "A counter", {"kind", kind});
+    };
+    metrics::Counter &counter{get_counter("a")};
+    BOOST_CHECK_EQUAL(&counter, &get_counter("a"));
+    BOOST_CHECK(&counter != &get_counter("b"));
+    counter.Add(3);
+    counter.Add();
+
+    metrics::Histogram &histogram{
+        metrics::GetHistogram("test_histogram", "A histogram")};
+    histogram.Record(std::chrono::microseconds{1500000});
+
+    const std::string text{metrics::FormatPrometheus("test_")};
+    for (const char *line :
+         {"# HELP test_test_counter A counter\n",
+          "# TYPE test_test_counter counter\n",
+          "test_test_counter{kind=\"a\"} 4\n",
+          "test_test_counter{kind=\"b\"} 0\n",
+          "# TYPE test_test_histogram_seconds summary\n",
+          "test_test_histogram_seconds{quantile=\"0.5\"} 1.500000\n",
+          "test_test_histogram_seconds_sum 1.500000\n",
+          "test_test_histogram_seconds_count 1\n"}) {
+        BOOST_CHECK_MESSAGE(text.find(line) != std::string::npos, line);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
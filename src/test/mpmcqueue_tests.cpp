@@ -0,0 +1,108 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <mpmcqueue.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(mpmcqueue_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(mpmcqueue_fifo) {
+    // A capacity which is not a power of two
+    BoundedMPMCQueue<std::unique_ptr<int>> queue(3);
+    BOOST_CHECK_EQUAL(queue.Capacity(), 3);
+    BOOST_CHECK(!queue.TryPop());
+
+    // Go around the ring buffer a few times
+    int next_push{0};
+    int next_pop{0};
+    for (int round = 0; round < 5; ++round) {
+        while (true) {
+            auto value = std::make_unique<int>(next_push);
+            if (!queue.TryPush(std::move(value))) {
+                // The value is left to the caller when the queue is full
+                BOOST_REQUIRE(value);
+                BOOST_CHECK_EQUAL(*value, next_push);
+                break;
+            }
+            BOOST_CHECK(!value);
+            ++next_push;
+        }
+        BOOST_CHECK_EQUAL(next_push - next_pop, 3);
+
+        // Only pop some of them, so the positions don't stay aligned
+        for (int i = 0; i < 2; ++i) {
+            auto value = queue.TryPop();
+            BOOST_REQUIRE(value && *value);
+            BOOST_CHECK_EQUAL(**value, next_pop++);
+        }
+    }
+
+    while (auto value = queue.TryPop()) {
+        BOOST_CHECK_EQUAL(**value, next_pop++);
+    }
+    BOOST_CHECK_EQUAL(next_pop, next_push);
+}
+
+BOOST_AUTO_TEST_CASE(mpmcqueue_concurrent) {
+    constexpr int NUM_PRODUCERS{3};
+    constexpr int NUM_CONSUMERS{3};
+    constexpr int ITEMS_PER_PRODUCER{20000};
+
+    BoundedMPMCQueue<int> queue(16);
+    // Every item is popped exactly once
+    std::vector<std::atomic<int>> popped(NUM_PRODUCERS * ITEMS_PER_PRODUCER);
+    std::atomic<int> num_popped{0};
+    std::atomic<bool> in_order{true};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < NUM_PRODUCERS; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                int item = p * ITEMS_PER_PRODUCER + i;
+                while (!queue.TryPush(std::move(item))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < NUM_CONSUMERS; ++c) {
+        threads.emplace_back([&] {
+            // Items from a single producer come out in order
+            std::vector<int> last(NUM_PRODUCERS, -1);
+            while (num_popped < int(popped.size())) {
+                const auto item = queue.TryPop();
+                if (!item) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                ++popped[*item];
+                ++num_popped;
+                const int producer{*item / ITEMS_PER_PRODUCER};
+                if (*item <= last[producer]) {
+                    in_order = false;
+                }
+                last[producer] = *item;
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    BOOST_CHECK(!queue.TryPop());
+    BOOST_CHECK(in_order);
+    BOOST_CHECK(std::all_of(popped.begin(), popped.end(),
+                            [](const auto &count) { return count == 1; }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
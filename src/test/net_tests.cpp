@@ -19,6 +19,7 @@
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
+#include <test/util/random.h>
 #include <test/util/validation.h>
 #include <threadsafety.h>
 #include <timedata.h>
@@ -1254,8 +1255,6 @@ BOOST_AUTO_TEST_CASE(net_group_limit) {
 }
 
 BOOST_AUTO_TEST_CASE(initial_advertise_from_version_message) {
-    LOCK(NetEventsInterface::g_msgproc_mutex);
-
     // Tests the following scenario:
     // * -bind=3.4.5.6:20001 is specified
     // * we make an outbound connection to a peer
@@ -1392,4 +1391,133 @@ BOOST_AUTO_TEST_CASE(already_connected_to_address) {
     BOOST_CHECK(connman.AlreadyConnectedToAddress(ip1port2));
 }
 
+BOOST_AUTO_TEST_CASE(message_process_time) {
+    CConnmanTest connman(m_node.chainman->GetConfig(), 0x1337, 0x1337,
+                         *m_node.addrman);
+    CAddress addr{CService{ip(0xa0b0c001), 7777}, NODE_NETWORK};
+    auto pnode = std::make_unique<CNode>(
+        0, /*sock=*/nullptr, addr, 0, 0, 0, CAddress(), std::string{},
+        ConnectionType::OUTBOUND_FULL_RELAY, /*inbound_onion=*/false);
+    CNode &node{*pnode};
+
+    connman.RecordMessageProcessTime(node, NetMsgType::PING, {1, 2us, 5us});
+    connman.RecordMessageProcessTime(node, NetMsgType::PING, {1, 3us, 4us});
+    connman.RecordMessageProcessTime(node, "unknown", {1, 1us, 1us});
+
+    CNodeStats stats;
+    node.copyStats(stats);
+    for (const mapMsgCmdProcessTime &map :
+         {stats.mapProcessTimePerMsgCmd, connman.GetProcessTimePerMsgCmd()}) {
+        // Only the known message types have an entry
+        BOOST_CHECK_EQUAL(map.count("unknown"), 0U);
+        BOOST_CHECK_EQUAL(map.at(NET_MESSAGE_COMMAND_OTHER).count, 1U);
+        const MsgProcessTime &ping{map.at(NetMsgType::PING)};
+        BOOST_CHECK_EQUAL(ping.count, 2U);
+        BOOST_CHECK_EQUAL(count_microseconds(ping.cpu), 5);
+        BOOST_CHECK_EQUAL(count_microseconds(ping.wall), 9);
+        BOOST_CHECK_EQUAL(map.at(NetMsgType::PONG).count, 0U);
+    }
+
+    // The thread CPU time is monotonic, if available at all
+    const auto cpu_start{GetThreadCPUTime()};
+    BOOST_CHECK(GetThreadCPUTime() >= cpu_start);
+}
+
+BOOST_AUTO_TEST_CASE(v1_transport_compression) {
+    const Config &config = m_node.chainman->GetConfig();
+    V1TransportSerializer serializer;
+    V1TransportDeserializer deserializer{config.GetChainParams().NetMagic(),
+                                         SER_NETWORK, INIT_PROTO_VERSION};
+    if (!P2PCompressionSupported()) {
+        BOOST_CHECK(!serializer.EnableCompression());
+        BOOST_CHECK(!deserializer.EnableDecompression());
+        return;
+    }
+    BOOST_CHECK(deserializer.EnableDecompression());
+
+    // Send the message and get it back from the deserializer, returning its
+    // size on the wire
+    auto transmit = [&](const CSerializedNetMsg &msg) {
+        std::vector<uint8_t> bytes, compressed;
+        if (!serializer.ShouldCompress(msg) ||
+            !serializer.prepareCompressed(config, msg, bytes, compressed)) {
+            serializer.prepareForTransport(config, msg, bytes);
+            compressed = msg.data;
+        }
+        bytes.insert(bytes.end(), compressed.begin(), compressed.end());
+        const size_t wire_size{bytes.size()};
+
+        Span<const uint8_t> msg_bytes{bytes};
+        while (!msg_bytes.empty()) {
+            BOOST_REQUIRE(deserializer.Read(config, msg_bytes) >= 0);
+        }
+        BOOST_REQUIRE(deserializer.Complete());
+        CNetMessage received{deserializer.GetMessage(config, 0us)};
+        BOOST_CHECK(received.m_valid_header);
+        BOOST_CHECK(received.m_valid_checksum);
+        BOOST_CHECK_EQUAL(received.m_type, msg.m_type);
+        BOOST_CHECK(MakeUCharSpan(received.m_recv) == Span{msg.data});
+        return wire_size;
+    };
+
+    // Similar headers, so the later ones compress better
+    CSerializedNetMsg msg;
+    msg.m_type = NetMsgType::HEADERS;
+    msg.data.resize(4000);
+    for (size_t i = 0; i < msg.data.size(); ++i) {
+        msg.data[i] = (i % 97 < 80) ? i % 97 : InsecureRandBits(8);
+    }
+    BOOST_CHECK(!serializer.ShouldCompress(msg));
+    BOOST_CHECK_EQUAL(transmit(msg),
+                      msg.data.size() + CMessageHeader::HEADER_SIZE);
+
+    BOOST_CHECK(serializer.EnableCompression());
+    BOOST_CHECK(serializer.ShouldCompress(msg));
+    const size_t first_size{transmit(msg)};
+    BOOST_CHECK_LT(first_size, msg.data.size());
+    for (int i = 0; i < 3; ++i) {
+        msg.data[InsecureRandRange(msg.data.size())] ^= 1;
+        BOOST_CHECK_LT(transmit(msg), first_size);
+    }
+
+    // Small messages are sent as is, in between the compressed ones
+    CSerializedNetMsg ping;
+    ping.m_type = NetMsgType::PING;
+    ping.data.resize(8);
+    BOOST_CHECK(!serializer.ShouldCompress(ping));
+    BOOST_CHECK_EQUAL(transmit(ping), 8 + CMessageHeader::HEADER_SIZE);
+
+    // Random data does not compress, so its type is sent as is past the sample
+    CSerializedNetMsg tx;
+    tx.m_type = NetMsgType::TX;
+    tx.data.resize(16 * 1024);
+    size_t tx_bytes{0};
+    while (tx_bytes < P2P_COMPRESSION_SAMPLE_SIZE) {
+        for (uint8_t &byte : tx.data) {
+            byte = InsecureRandBits(8);
+        }
+        BOOST_CHECK_GT(transmit(tx), tx.data.size());
+        tx_bytes += tx.data.size();
+    }
+    BOOST_CHECK_EQUAL(transmit(tx),
+                      tx.data.size() + CMessageHeader::HEADER_SIZE);
+    // And the stream is still in sync for the types that compress
+    BOOST_CHECK_LT(transmit(msg), first_size);
+
+    // A message not decompressing to the size it declares is rejected
+    std::vector<uint8_t> bytes, compressed;
+    BOOST_REQUIRE(serializer.prepareCompressed(config, msg, bytes, compressed));
+    ++compressed[CMessageHeader::COMMAND_SIZE];
+    const uint256 hash{Hash(compressed)};
+    std::copy(hash.begin(), hash.begin() + CMessageHeader::CHECKSUM_SIZE,
+              bytes.end() - CMessageHeader::CHECKSUM_SIZE);
+    bytes.insert(bytes.end(), compressed.begin(), compressed.end());
+    Span<const uint8_t> msg_bytes{bytes};
+    int ret{0};
+    while (!msg_bytes.empty() && ret >= 0) {
+        ret = deserializer.Read(config, msg_bytes);
+    }
+    BOOST_CHECK_LT(ret, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
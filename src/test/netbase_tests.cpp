@@ -321,6 +321,15 @@ BOOST_AUTO_TEST_CASE(subnet_test) {
     subnet = ResolveSubNet(
         "1:2:3:4:5:6:7:8/ffff:ffff:ffff:fffe:ffff:ffff:ffff:ff0f");
     BOOST_CHECK(!subnet.IsValid());
+    BOOST_CHECK(!subnet.GetPrefixLength());
+
+    BOOST_CHECK_EQUAL(*ResolveSubNet("1.2.3.4").GetPrefixLength(), 32);
+    BOOST_CHECK_EQUAL(*ResolveSubNet("1.2.3.4/255.255.240.0").GetPrefixLength(),
+                      20);
+    BOOST_CHECK_EQUAL(*ResolveSubNet("0.0.0.0/0").GetPrefixLength(), 0);
+    BOOST_CHECK_EQUAL(*ResolveSubNet("1:2:3:4:5:6:7:8").GetPrefixLength(), 128);
+    BOOST_CHECK_EQUAL(*ResolveSubNet("1::/17").GetPrefixLength(), 17);
+    BOOST_CHECK(ResolveSubNet("1::/17") == CSubNet(ResolveIP("1:2::"), 17));
 }
 
 BOOST_AUTO_TEST_CASE(netbase_getgroup) {
@@ -5,9 +5,12 @@
 #include <policy/fees.h>
 #include <policy/policy.h>
 
+#include <clientversion.h>
 #include <kernel/disconnected_transactions.h>
+#include <streams.h>
 #include <txmempool.h>
 #include <uint256.h>
+#include <util/fs.h>
 #include <util/time.h>
 
 #include <test/util/setup_common.h>
@@ -97,4 +100,75 @@ BOOST_AUTO_TEST_CASE(MempoolMinimumFeeEstimate) {
                         "Confirm blocks has failed");
 }
 
+BOOST_AUTO_TEST_CASE(FeeRateEstimatorConfirmationTargets) {
+    FeeRateEstimator estimator(/*best_height=*/0);
+
+    // Nothing to tell yet.
+    BOOST_CHECK(estimator.estimateFee(1) == CFeeRate());
+
+    const CFeeRate high_feerate(10000 * SATOSHI);
+    const CFeeRate medium_feerate(1000 * SATOSHI);
+    const CFeeRate low_feerate(100 * SATOSHI);
+
+    // High fee transactions are mined in the next block, medium fee ones
+    // within 3 blocks and low fee ones never.
+    std::map<int, std::vector<CTransactionRef>> to_mine;
+    uint32_t lock_time{0};
+    for (int height = 1; height <= 200; ++height) {
+        for (int i = 0; i < 20; ++i) {
+            for (const auto &[feerate, delay] :
+                 {std::make_pair(high_feerate, 1),
+                  std::make_pair(medium_feerate, 3),
+                  std::make_pair(low_feerate, 0)}) {
+                CMutableTransaction mtx;
+                mtx.nLockTime = ++lock_time;
+                CTransactionRef tx = MakeTransactionRef(mtx);
+                estimator.processTransaction(tx->GetId(), feerate);
+                if (delay > 0) {
+                    to_mine[height - 1 + delay].push_back(tx);
+                }
+            }
+        }
+        estimator.processBlock(height, to_mine[height]);
+        to_mine.erase(height);
+    }
+
+    const CFeeRate fast{estimator.estimateFee(1)};
+    BOOST_CHECK(fast >= high_feerate);
+    BOOST_CHECK(fast < CFeeRate(11000 * SATOSHI));
+
+    const CFeeRate slow{estimator.estimateFee(3)};
+    BOOST_CHECK(slow >= medium_feerate);
+    BOOST_CHECK(slow < CFeeRate(1100 * SATOSHI));
+
+    // Longer targets can't do better than the low fee rate which never
+    // confirms, and out of range targets are clamped.
+    BOOST_CHECK(estimator.estimateFee(MAX_CONFIRM_TARGET) == slow);
+    BOOST_CHECK(estimator.estimateFee(MAX_CONFIRM_TARGET + 1) == slow);
+    BOOST_CHECK(estimator.estimateFee(0) == fast);
+
+    // The statistics survive a restart.
+    const fs::path path{m_args.GetDataDirNet() / "fee_estimates.dat"};
+    {
+        CAutoFile file(fsbridge::fopen(path, "wb"), SER_DISK, CLIENT_VERSION);
+        BOOST_CHECK(estimator.Write(file));
+    }
+    FeeRateEstimator restored(/*best_height=*/200);
+    {
+        CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+        BOOST_CHECK(restored.Read(file));
+    }
+    BOOST_CHECK(restored.estimateFee(1) == fast);
+    BOOST_CHECK(restored.estimateFee(3) == slow);
+
+    // A truncated file is rejected.
+    fs::resize_file(path, fs::file_size(path) / 2);
+    FeeRateEstimator truncated(/*best_height=*/200);
+    {
+        CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+        BOOST_CHECK(!truncated.Read(file));
+    }
+    BOOST_CHECK(truncated.estimateFee(1) == CFeeRate());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
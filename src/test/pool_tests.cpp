@@ -212,4 +212,32 @@ BOOST_AUTO_TEST_CASE(memusage_test) {
     PoolResourceTester::CheckAllDataAccountedFor(resource);
 }
 
+BOOST_AUTO_TEST_CASE(huge_pages) {
+    SetPoolHugePages(true);
+    const size_t huge_page_bytes_before{PoolHugePageBytes()};
+    {
+        auto resource = PoolResource<8, 8>(POOL_HUGE_PAGE_SIZE / 4);
+        std::vector<void *> blocks;
+        // Until the pool adds up to a huge page, its chunks are allocated on
+        // their own.
+        while (resource.NumAllocatedChunks() < 4) {
+            blocks.push_back(resource.Allocate(8, 8));
+        }
+        BOOST_CHECK_EQUAL(PoolHugePageBytes(), huge_page_bytes_before);
+
+        // The following chunks are carved out of huge page regions.
+        while (resource.NumAllocatedChunks() < 9) {
+            blocks.push_back(resource.Allocate(8, 8));
+        }
+        BOOST_CHECK_EQUAL(PoolHugePageBytes(),
+                          huge_page_bytes_before + 2 * POOL_HUGE_PAGE_SIZE);
+        for (void *block : blocks) {
+            resource.Deallocate(block, 8, 8);
+        }
+        PoolResourceTester::CheckAllDataAccountedFor(resource);
+    }
+    BOOST_CHECK_EQUAL(PoolHugePageBytes(), huge_page_bytes_before);
+    SetPoolHugePages(false);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,114 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <pow/powcache.h>
+
+#include <arith_uint256.h>
+#include <chainparams.h>
+#include <pow/auxpow.h>
+#include <pow/pow.h>
+#include <primitives/block.h>
+#include <validation.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(powcache_tests, BasicTestingSetup)
+
+/** Find a nonce for which the PoW of header does (not) meet its target. */
+static void GrindHeader(CBlockHeader &header, bool valid,
+                        const Consensus::Params &params) {
+    while (CheckProofOfWork(header.GetPowHash(), header.nBits, params) !=
+           valid) {
+        ++header.nNonce;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(powcache_test) {
+    const Consensus::Params params =
+        CChainParams::RegTest({})->GetConsensus();
+
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.nTime = 1386325540;
+    header.nBits = UintToArith256(params.powLimit).GetCompact();
+    GrindHeader(header, true, params);
+
+    const PowCacheStats before = GetPowCacheStats();
+    BOOST_CHECK(before.max_elements > 0);
+
+    BOOST_CHECK(!IsPowCached(header.GetHash(), header.nBits));
+    BOOST_CHECK(CheckAuxProofOfWork(header, params));
+    BOOST_CHECK(IsPowCached(header.GetHash(), header.nBits));
+    // Checking the same header again is answered by the cache.
+    BOOST_CHECK(CheckAuxProofOfWork(header, params));
+
+    // The entry is only valid for the target it was checked against.
+    BOOST_CHECK(!IsPowCached(header.GetHash(), header.nBits - 1));
+
+    const PowCacheStats after = GetPowCacheStats();
+    BOOST_CHECK_EQUAL(after.hits - before.hits, 2U);
+    BOOST_CHECK_EQUAL(after.misses - before.misses, 3U);
+
+    // A header failing the PoW check is never cached.
+    CBlockHeader invalid = header;
+    GrindHeader(invalid, false, params);
+    BOOST_CHECK(!CheckAuxProofOfWork(invalid, params));
+    BOOST_CHECK(!IsPowCached(invalid.GetHash(), invalid.nBits));
+
+    // Explicitly added entries are found.
+    CBlockHeader other = header;
+    ++other.nTime;
+    BOOST_CHECK(!IsPowCached(other.GetHash(), other.nBits));
+    AddPowCache(other.GetHash(), other.nBits);
+    BOOST_CHECK(IsPowCached(other.GetHash(), other.nBits));
+}
+
+BOOST_AUTO_TEST_CASE(preverify_pow_test) {
+    const Consensus::Params params =
+        CChainParams::RegTest({})->GetConsensus();
+
+    CBlockHeader header;
+    header.nVersion = 1;
+    header.nTime = 1386325541;
+    header.nBits = UintToArith256(params.powLimit).GetCompact();
+
+    std::vector<CBlockHeader> valid, invalid;
+    while (valid.size() < 10 || invalid.size() < 10) {
+        ++header.nNonce;
+        auto &found =
+            CheckProofOfWork(header.GetPowHash(), header.nBits, params)
+                ? valid
+                : invalid;
+        if (found.size() < 10) {
+            found.push_back(header);
+        }
+    }
+
+    // Invalid headers don't prevent the valid ones from being cached.
+    std::vector<CBlockHeader> headers;
+    for (size_t i = 0; i < 10; ++i) {
+        headers.push_back(invalid[i]);
+        headers.push_back(valid[i]);
+    }
+    PreverifyProofOfWork(headers, params);
+
+    for (const CBlockHeader &h : valid) {
+        BOOST_CHECK(IsPowCached(h.GetHash(), h.nBits));
+    }
+    for (const CBlockHeader &h : invalid) {
+        BOOST_CHECK(!IsPowCached(h.GetHash(), h.nBits));
+    }
+    BOOST_CHECK(!HasValidProofOfWork(headers, params));
+
+    // Each cached header is looked up once, and counted as a single hit.
+    const PowCacheStats before = GetPowCacheStats();
+    BOOST_CHECK(HasValidProofOfWork(valid, params));
+    const PowCacheStats after = GetPowCacheStats();
+    BOOST_CHECK_EQUAL(after.hits - before.hits, valid.size());
+    BOOST_CHECK_EQUAL(after.misses, before.misses);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
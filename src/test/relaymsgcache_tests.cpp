@@ -0,0 +1,82 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <relaymsgcache.h>
+
+#include <protocol.h>
+
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+static CSerializedNetMsg MakeMsg(size_t size, int &made) {
+    ++made;
+    CSerializedNetMsg msg;
+    msg.m_type = NetMsgType::TX;
+    msg.data.resize(size);
+    return msg;
+}
+
+BOOST_FIXTURE_TEST_SUITE(relaymsgcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(serialize_once) {
+    RelayMsgCache cache(10s, 1000);
+    const CInv tx_inv(MSG_TX, InsecureRand256());
+    const CInv block_inv(MSG_BLOCK, tx_inv.hash);
+    int made = 0;
+    const auto make = [&] { return MakeMsg(100, made); };
+
+    const auto now = 1000s;
+    BOOST_CHECK(!cache.Get(tx_inv, now));
+    const auto msg = cache.GetOrMake(tx_inv, now, make);
+    BOOST_CHECK_EQUAL(made, 1);
+    BOOST_CHECK(cache.GetOrMake(tx_inv, now + 1s, make) == msg);
+    BOOST_CHECK(cache.Get(tx_inv, now + 1s) == msg);
+    BOOST_CHECK_EQUAL(made, 1);
+
+    // Same hash, different inventory type.
+    BOOST_CHECK(cache.GetOrMake(block_inv, now, make) != msg);
+    BOOST_CHECK_EQUAL(made, 2);
+    BOOST_CHECK_EQUAL(cache.Size(), 2U);
+    BOOST_CHECK_EQUAL(cache.TotalBytes(), 200U);
+
+    // The entries expire, but the message outlives them.
+    BOOST_CHECK(!cache.Get(tx_inv, now + 10s));
+    BOOST_CHECK_EQUAL(cache.Size(), 0U);
+    BOOST_CHECK_EQUAL(cache.TotalBytes(), 0U);
+    BOOST_CHECK_EQUAL(msg->data.size(), 100U);
+    BOOST_CHECK(cache.GetOrMake(tx_inv, now + 10s, make) != msg);
+    BOOST_CHECK_EQUAL(made, 3);
+}
+
+BOOST_AUTO_TEST_CASE(size_limit) {
+    RelayMsgCache cache(10s, 1000);
+    int made = 0;
+    const auto now = 1000s;
+
+    std::vector<CInv> invs;
+    for (int i = 0; i < 5; ++i) {
+        invs.emplace_back(MSG_TX, InsecureRand256());
+        cache.GetOrMake(invs.back(), now, [&] { return MakeMsg(300, made); });
+    }
+    // Only the 3 most recent entries fit.
+    BOOST_CHECK_EQUAL(cache.Size(), 3U);
+    BOOST_CHECK_EQUAL(cache.TotalBytes(), 900U);
+    BOOST_CHECK(!cache.Get(invs[0], now));
+    BOOST_CHECK(!cache.Get(invs[1], now));
+    for (int i = 2; i < 5; ++i) {
+        BOOST_CHECK(cache.Get(invs[i], now));
+    }
+
+    // A message too large for the cache is made but not kept.
+    const CInv large_inv(MSG_BLOCK, InsecureRand256());
+    BOOST_CHECK(cache.GetOrMake(large_inv, now,
+                                [&] { return MakeMsg(1001, made); }));
+    BOOST_CHECK(!cache.Get(large_inv, now));
+    BOOST_CHECK_EQUAL(cache.Size(), 3U);
+    BOOST_CHECK_EQUAL(made, 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,6 +16,8 @@
 
 #include <any>
 #include <string>
+#include <thread>
+#include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(rpc_server_tests, TestingSetup)
 
@@ -97,4 +99,85 @@ BOOST_AUTO_TEST_CASE(rpc_server_execute_command_from_request_context) {
     BOOST_CHECK_EQUAL(output.get_str(), "testing2");
 }
 
+class EchoRPCCommand : public RPCCommand {
+public:
+    explicit EchoRPCCommand(const std::string &nameIn) : RPCCommand(nameIn) {}
+
+    UniValue Execute(const JSONRPCRequest &request) const override {
+        // Give the other threads a chance to pick entries
+        std::this_thread::yield();
+        return request.params["echo"];
+    }
+};
+
+BOOST_AUTO_TEST_CASE(rpc_server_exec_batch) {
+    DummyConfig config;
+    RPCServer rpcServer;
+    rpcServer.RegisterCommand(std::make_unique<EchoRPCCommand>("echo"));
+
+    JSONRPCRequest jreq;
+    jreq.context = &m_node;
+
+    constexpr int BATCH_SIZE{200};
+    UniValue batch(UniValue::VARR);
+    UniValue expected(UniValue::VARR);
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        UniValue params(UniValue::VOBJ);
+        params.pushKV("echo", strprintf("reply%d", i));
+        // Mix in some failures
+        const std::string method{i % 7 == 3 ? "unknown" : "echo"};
+        batch.push_back(JSONRPCRequestObj(method, params, i));
+        expected.push_back(
+            method == "echo"
+                ? JSONRPCReplyObj(params["echo"], NullUniValue, i)
+                : JSONRPCReplyObj(NullUniValue,
+                                  JSONRPCError(RPC_METHOD_NOT_FOUND,
+                                               "Method not found"),
+                                  i));
+    }
+    const std::string expected_reply{expected.write() + "\n"};
+
+    // In order on this thread
+    BOOST_CHECK_EQUAL(JSONRPCExecBatch(config, rpcServer, jreq, batch),
+                      expected_reply);
+
+    // Concurrently, the replies are in the same order
+    std::vector<std::thread> threads;
+    RPCBatchOptions options;
+    options.max_helpers = 3;
+    options.executor = [&](std::function<void()> task) {
+        threads.emplace_back(std::move(task));
+        return true;
+    };
+    BOOST_CHECK_EQUAL(
+        JSONRPCExecBatch(config, rpcServer, jreq, batch, options),
+        expected_reply);
+    BOOST_CHECK_EQUAL(threads.size(), 3);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // The helpers are optional
+    options.executor = [](std::function<void()> task) { return false; };
+    BOOST_CHECK_EQUAL(
+        JSONRPCExecBatch(config, rpcServer, jreq, batch, options),
+        expected_reply);
+
+    // The entries fail once the reply size limit is reached
+    options.executor = nullptr;
+    options.max_reply_size = expected[0].write().size() + 1;
+    UniValue limited(UniValue::VARR);
+    limited.push_back(expected[0]);
+    limited.push_back(expected[1]);
+    for (int i = 2; i < BATCH_SIZE; ++i) {
+        limited.push_back(JSONRPCReplyObj(
+            NullUniValue,
+            JSONRPCError(RPC_OUT_OF_MEMORY, "Batch reply size limit exceeded"),
+            i));
+    }
+    BOOST_CHECK_EQUAL(
+        JSONRPCExecBatch(config, rpcServer, jreq, batch, options),
+        limited.write() + "\n");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
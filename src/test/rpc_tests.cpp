@@ -747,4 +747,91 @@ BOOST_AUTO_TEST_CASE(help_example) {
                    HelpExampleRpcNamed("foo", {{"arg", "true"}}));
 }
 
+BOOST_AUTO_TEST_CASE(rpc_reply_stream) {
+    const UniValue id{"streamtest"};
+    std::string streamed;
+    size_t num_chunks{0};
+    auto make_stream = [&] {
+        streamed.clear();
+        num_chunks = 0;
+        return JSONRPCReplyStream([&](std::string &&chunk) {
+            streamed += chunk;
+            ++num_chunks;
+        });
+    };
+
+    // Nested objects and arrays, with empty containers
+    {
+        const UniValue result{JSON(
+            R"({"a":1,"b":["x",{"c":null},[],{}],"d":{},"e":{"f":[true]}})")};
+        JSONRPCReplyStream stream = make_stream();
+        BOOST_CHECK(!stream.IsStarted());
+        stream.BeginObject();
+        stream.Key("a");
+        stream.Value(1);
+        stream.Key("b");
+        stream.BeginArray();
+        stream.Value("x");
+        stream.BeginObject();
+        stream.Key("c");
+        stream.Value(NullUniValue);
+        stream.EndObject();
+        stream.BeginArray();
+        stream.EndArray();
+        stream.Value(UniValue{UniValue::VOBJ});
+        stream.EndArray();
+        stream.Key("d");
+        stream.BeginObject();
+        stream.EndObject();
+        stream.Key("e");
+        stream.Value(result["e"]);
+        stream.EndObject();
+        BOOST_CHECK(stream.IsStarted());
+        // Nothing is sent until the buffer is large enough
+        BOOST_CHECK_EQUAL(num_chunks, 0);
+        stream.Finish(id);
+        BOOST_CHECK_EQUAL(num_chunks, 1);
+        BOOST_CHECK_EQUAL(streamed, JSONRPCReply(result, NullUniValue, id));
+    }
+
+    // A large result is sent in several chunks, escaping the keys
+    {
+        UniValue result{UniValue::VOBJ};
+        JSONRPCReplyStream stream = make_stream();
+        stream.BeginObject();
+        for (int i = 0; i < 10000; ++i) {
+            const std::string key{strprintf("\"key\"\t%d", i)};
+            const UniValue value{std::string(20, 'a' + i % 26)};
+            result.pushKVEnd(key, value);
+            stream.Key(key);
+            stream.Value(value);
+        }
+        stream.EndObject();
+        stream.Finish(id);
+        BOOST_CHECK_GT(num_chunks, 1);
+        BOOST_CHECK_EQUAL(streamed, JSONRPCReply(result, NullUniValue, id));
+    }
+
+    // Streaming RPCs give the same reply
+    {
+        const std::string genesis_hash{
+            WITH_LOCK(::cs_main, return m_node.chainman->ActiveTip())
+                ->GetBlockHash()
+                .GetHex()};
+        const UniValue result{CallRPC("getblock " + genesis_hash + " 2")};
+
+        GlobalConfig config;
+        JSONRPCRequest request;
+        request.context = &m_node;
+        request.strMethod = "getblock";
+        request.params = RPCConvertValues("getblock", {genesis_hash, "2"});
+        JSONRPCReplyStream stream = make_stream();
+        request.stream = &stream;
+        BOOST_CHECK(tableRPC.execute(config, request).isNull());
+        BOOST_CHECK(stream.IsStarted());
+        stream.Finish(id);
+        BOOST_CHECK_EQUAL(streamed, JSONRPCReply(result, NullUniValue, id));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
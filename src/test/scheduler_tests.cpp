@@ -10,9 +10,11 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <future>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -292,4 +294,112 @@ BOOST_AUTO_TEST_CASE(mockforward) {
     BOOST_CHECK(delta > 2 * 60 && delta < 3 * 60);
 }
 
+BOOST_AUTO_TEST_CASE(priorities_run_concurrently) {
+    CScheduler scheduler;
+    scheduler.StartServiceThreads();
+
+    // The LOW task blocks until the HIGH and NORMAL ones did run, which would
+    // never happen if they had to wait for it.
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future();
+    std::atomic<int> done{0};
+    scheduler.scheduleFromNow(
+        [&] {
+            released.wait();
+            ++done;
+        },
+        std::chrono::milliseconds{0}, CScheduler::Priority::LOW);
+    std::promise<void> high_done;
+    std::promise<void> normal_done;
+    scheduler.scheduleFromNow([&] { high_done.set_value(); },
+                              std::chrono::milliseconds{1},
+                              CScheduler::Priority::HIGH);
+    scheduler.scheduleFromNow([&] { normal_done.set_value(); },
+                              std::chrono::milliseconds{1});
+
+    BOOST_CHECK(high_done.get_future().wait_for(std::chrono::seconds{10}) ==
+                std::future_status::ready);
+    BOOST_CHECK(normal_done.get_future().wait_for(std::chrono::seconds{10}) ==
+                std::future_status::ready);
+    release.set_value();
+
+    scheduler.StopWhenDrained();
+    BOOST_CHECK_EQUAL(done, 1);
+}
+
+BOOST_AUTO_TEST_CASE(priority_runs_serially) {
+    CScheduler scheduler;
+    scheduler.StartServiceThreads(10);
+
+    // The tasks of the same priority never run at the same time, no matter
+    // how many threads service the queue.
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    int counter{0};
+    for (int i = 0; i < 100; ++i) {
+        scheduler.scheduleFromNow(
+            [&] {
+                max_running = std::max(max_running.load(), ++running);
+                UninterruptibleSleep(std::chrono::microseconds{100});
+                // Not atomic, it would race if the tasks were concurrent
+                ++counter;
+                --running;
+            },
+            std::chrono::milliseconds{0});
+    }
+
+    scheduler.StopWhenDrained();
+    BOOST_CHECK_EQUAL(max_running, 1);
+    BOOST_CHECK_EQUAL(counter, 100);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_tasks) {
+    CScheduler scheduler;
+    scheduler.StartServiceThreads(2);
+
+    // Each task waits for the other one to start, so they can only complete if
+    // they run at the same time.
+    std::promise<void> started[2];
+    std::atomic<int> done{0};
+    for (int i = 0; i < 2; ++i) {
+        scheduler.scheduleConcurrent(
+            [&, i] {
+                started[i].set_value();
+                if (started[1 - i].get_future().wait_for(
+                        std::chrono::seconds{10}) ==
+                    std::future_status::ready) {
+                    ++done;
+                }
+            },
+            std::chrono::steady_clock::now());
+    }
+
+    scheduler.StopWhenDrained();
+    BOOST_CHECK_EQUAL(done, 2);
+}
+
+BOOST_AUTO_TEST_CASE(priority_order) {
+    CScheduler scheduler;
+
+    // With a single thread, the due task of the highest priority runs first
+    // even if it was scheduled after the others.
+    std::vector<CScheduler::Priority> order;
+    const auto now = std::chrono::steady_clock::now();
+    for (auto priority :
+         {CScheduler::Priority::LOW, CScheduler::Priority::NORMAL,
+          CScheduler::Priority::HIGH}) {
+        scheduler.schedule([&order, priority] { order.push_back(priority); },
+                           now - std::chrono::seconds{int(priority)},
+                           priority);
+    }
+
+    scheduler.StartServiceThreads(1);
+    scheduler.StopWhenDrained();
+
+    const std::vector<CScheduler::Priority> expected{
+        CScheduler::Priority::HIGH, CScheduler::Priority::NORMAL,
+        CScheduler::Priority::LOW};
+    BOOST_CHECK(order == expected);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -72,4 +72,28 @@ BOOST_AUTO_TEST_CASE(scrypt_hashtest) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(scrypt_multi_test) {
+    BOOST_TEST_MESSAGE("Using scrypt " << ScryptMultiImplementation());
+
+    // Enough inputs to fill all the lanes twice plus a partial batch, with
+    // distinct inputs in every lane.
+    const size_t n = 2 * SCRYPT_MULTI_MAX_LANES + 3;
+    std::vector<uint8_t> inputs(80 * n);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        inputs[i] = uint8_t(i * 7 + i / 80);
+    }
+
+    std::vector<uint8_t> expected(32 * n);
+    for (size_t i = 0; i < n; ++i) {
+        scrypt_1024_1_1_256(&inputs[80 * i], &expected[32 * i]);
+    }
+
+    for (size_t count : {size_t(0), size_t(1), size_t(4), size_t(8), n}) {
+        std::vector<uint8_t> outputs(32 * count);
+        scrypt_1024_1_1_256_multi(inputs.data(), outputs.data(), count);
+        BOOST_CHECK(std::equal(outputs.begin(), outputs.end(),
+                               expected.begin()));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -96,12 +96,15 @@ static void RandomScript(CScript &script) {
     }
 }
 
-static void RandomTransaction(CMutableTransaction &tx, bool fSingle) {
+static void RandomTransaction(CMutableTransaction &tx, bool fSingle,
+                              int ins = 0) {
     tx.nVersion = InsecureRand32();
     tx.vin.clear();
     tx.vout.clear();
     tx.nLockTime = (InsecureRandBool()) ? InsecureRand32() : 0;
-    int ins = (InsecureRandBits(2)) + 1;
+    if (ins == 0) {
+        ins = (InsecureRandBits(2)) + 1;
+    }
     int outs = fSingle ? ins : (InsecureRandBits(2)) + 1;
     for (int in = 0; in < ins; in++) {
         tx.vin.push_back(CTxIn());
@@ -211,6 +214,39 @@ BOOST_AUTO_TEST_CASE(sighash_test) {
 #endif
 }
 
+BOOST_AUTO_TEST_CASE(sighash_precomputed) {
+    // Enough inputs for the legacy signature hash to resume from checkpoints
+    for (int i = 0; i < 100; i++) {
+        uint32_t nHashType = InsecureRand32();
+        SigHashType sigHashType(nHashType);
+
+        CMutableTransaction mtx;
+        RandomTransaction(mtx, (nHashType & 0x1f) == SIGHASH_SINGLE,
+                          InsecureRandRange(40) + 1);
+        const CTransaction txTo(mtx);
+        const PrecomputedTransactionData txdata(txTo);
+        CScript scriptCode;
+        RandomScript(scriptCode);
+        const Amount amount = InsecureRandMoneyAmount();
+
+        for (unsigned int nIn = 0; nIn < txTo.vin.size(); nIn++) {
+            uint256 shref = SignatureHashOld(scriptCode, txTo, nIn, nHashType);
+            BOOST_CHECK(SignatureHash(scriptCode, txTo, nIn, sigHashType,
+                                      amount, &txdata, 0) == shref);
+
+            for (uint32_t flags : std::vector<uint32_t>{
+                     SCRIPT_ENABLE_SIGHASH_FORKID,
+                     SCRIPT_ENABLE_SIGHASH_FORKID |
+                         SCRIPT_ENABLE_REPLAY_PROTECTION}) {
+                BOOST_CHECK(SignatureHash(scriptCode, txTo, nIn, sigHashType,
+                                          amount, &txdata, flags) ==
+                            SignatureHash(scriptCode, txTo, nIn, sigHashType,
+                                          amount, nullptr, flags));
+            }
+        }
+    }
+}
+
 // Goal: check that SignatureHash generates correct hash
 BOOST_AUTO_TEST_CASE(sighash_from_data) {
     UniValue tests = read_json(json_tests::sighash);
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chain.h>
+#include <validation.h>
 
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
@@ -44,6 +45,60 @@ BOOST_AUTO_TEST_CASE(skiplist_test) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(active_chain_snapshot_test) {
+    // A chain over a few chunks of the height index, and a fork from the
+    // middle of the second chunk
+    const int chunk_size{ActiveChainSnapshot::CHUNK_SIZE};
+    std::vector<CBlockIndex> vBlocksMain(2 * chunk_size + 100);
+    std::vector<CBlockIndex> vBlocksSide(2 * chunk_size);
+    const int fork_height{chunk_size + chunk_size / 2};
+    for (size_t i = 0; i < vBlocksMain.size(); i++) {
+        vBlocksMain[i].nHeight = i;
+        vBlocksMain[i].pprev = i ? &vBlocksMain[i - 1] : nullptr;
+        vBlocksMain[i].BuildSkip();
+    }
+    for (size_t i = 0; i < vBlocksSide.size(); i++) {
+        vBlocksSide[i].nHeight = fork_height + 1 + i;
+        vBlocksSide[i].pprev =
+            i ? &vBlocksSide[i - 1] : &vBlocksMain[fork_height];
+        vBlocksSide[i].BuildSkip();
+    }
+
+    const auto check_snapshot = [](const ActiveChainSnapshot &snapshot,
+                                   const CChain &chain) {
+        BOOST_CHECK_EQUAL(snapshot.Tip(), chain.Tip());
+        BOOST_CHECK_EQUAL(snapshot.Height(), chain.Height());
+        for (int height = -1; height <= chain.Height() + 1; ++height) {
+            BOOST_CHECK_EQUAL(snapshot[height], chain[height]);
+        }
+        BOOST_CHECK(snapshot.Contains(chain.Tip()));
+        BOOST_CHECK(snapshot.Next(chain.Genesis()) == chain[1]);
+    };
+
+    const ActiveChainSnapshot empty{nullptr, nullptr};
+    BOOST_CHECK(empty.Tip() == nullptr);
+    BOOST_CHECK_EQUAL(empty.Height(), -1);
+    BOOST_CHECK(empty[0] == nullptr);
+
+    CChain chain;
+    chain.SetTip(vBlocksMain.back());
+    const ActiveChainSnapshot main{&chain, &empty};
+    check_snapshot(main, chain);
+
+    // The chunks are reused or rebuilt as the chain is reorganized
+    chain.SetTip(vBlocksSide.back());
+    const ActiveChainSnapshot side{&chain, &main};
+    check_snapshot(side, chain);
+    BOOST_CHECK(!side.Contains(&vBlocksMain.back()));
+    BOOST_CHECK(side.Contains(&vBlocksMain[fork_height]));
+
+    chain.SetTip(vBlocksMain[chunk_size - 1]);
+    const ActiveChainSnapshot shorter{&chain, &side};
+    check_snapshot(shorter, chain);
+    chain.SetTip(vBlocksMain.back());
+    check_snapshot(ActiveChainSnapshot{&chain, &shorter}, chain);
+}
+
 BOOST_AUTO_TEST_CASE(getlocator_test) {
     // Build a main chain 100000 blocks long.
     std::vector<BlockHash> vHashMain(100000);
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <util/sock.h>
+#include <util/sockevents.h>
 
 #include <common/system.h>
 #include <compat.h>
@@ -139,6 +140,59 @@ BOOST_AUTO_TEST_CASE(wait) {
     waiter.join();
 }
 
+BOOST_AUTO_TEST_CASE(send_many) {
+    int s[2];
+    CreateSocketPair(s);
+
+    Sock sock0(s[0]);
+    Sock sock1(s[1]);
+
+    const std::vector<uint8_t> a{'a', 'b'}, b{}, c{'c', 'd', 'e'};
+    const std::vector<Span<const uint8_t>> buffers{a, b, c};
+    BOOST_REQUIRE_EQUAL(sock0.SendMany(buffers, 0), 5);
+
+    char recv_buf[10];
+    BOOST_REQUIRE_EQUAL(sock1.Recv(recv_buf, sizeof(recv_buf), 0), 5);
+    BOOST_CHECK_EQUAL(std::string(recv_buf, 5), "abcde");
+}
+
+#if defined(USE_EPOLL) || defined(USE_KQUEUE)
+BOOST_AUTO_TEST_CASE(sock_events) {
+    int s[2];
+    CreateSocketPair(s);
+
+    Sock sock0(s[0]);
+    Sock sock1(s[1]);
+
+    SockEvents events;
+    BOOST_REQUIRE(events.IsValid());
+    BOOST_REQUIRE(events.Add(sock0, Sock::RECV, 42, /*edge_triggered=*/true));
+
+    std::vector<SockEvents::Occurred> occurred;
+    BOOST_REQUIRE(events.Wait(0ms, occurred));
+    BOOST_CHECK(occurred.empty());
+
+    BOOST_REQUIRE_EQUAL(sock1.Send("a", 1, 0), 1);
+    BOOST_REQUIRE(events.Wait(24h, occurred));
+    BOOST_REQUIRE_EQUAL(occurred.size(), 1U);
+    BOOST_CHECK_EQUAL(occurred[0].tag, 42U);
+    BOOST_CHECK(occurred[0].events & Sock::RECV);
+
+    // Edge-triggered: the pending byte is reported once only.
+    BOOST_REQUIRE(events.Wait(0ms, occurred));
+    BOOST_CHECK(occurred.empty());
+
+    // A level-triggered socket is reported for as long as it is writable.
+    BOOST_REQUIRE(events.Add(sock1, Sock::SEND, 7, /*edge_triggered=*/false));
+    for (int i = 0; i < 2; ++i) {
+        BOOST_REQUIRE(events.Wait(0ms, occurred));
+        BOOST_REQUIRE_EQUAL(occurred.size(), 1U);
+        BOOST_CHECK_EQUAL(occurred[0].tag, 7U);
+        BOOST_CHECK(occurred[0].events & Sock::SEND);
+    }
+}
+#endif
+
 BOOST_AUTO_TEST_CASE(recv_until_terminator_limit) {
     // High enough timeout so that it is never hit.
     constexpr auto timeout = 1min;
@@ -4,10 +4,14 @@
 
 #include <sync.h>
 #include <test/util/setup_common.h>
+#include <util/time.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
 #include <mutex>
+#include <optional>
+#include <thread>
 
 namespace {
 template <typename MutexType>
@@ -138,4 +142,57 @@ BOOST_AUTO_TEST_CASE(double_lock_recursive_mutex) {
 }
 #endif /* DEBUG_LOCKORDER */
 
+BOOST_AUTO_TEST_CASE(lock_contention_profiling) {
+    auto find_stats = [](const std::string &name) {
+        for (const LockContentionStats &stats : GetLockContentionStats(10)) {
+            if (stats.name == name) {
+                return std::optional<LockContentionStats>{stats};
+            }
+        }
+        return std::optional<LockContentionStats>{};
+    };
+    Mutex contended_mutex;
+    auto contend = [&] {
+        std::atomic<bool> started{false};
+        std::thread thread;
+        {
+            LOCK(contended_mutex);
+            thread = std::thread{[&] {
+                started = true;
+                LOCK(contended_mutex);
+            }};
+            while (!started) {
+                std::this_thread::yield();
+            }
+            UninterruptibleSleep(50ms);
+        }
+        thread.join();
+    };
+
+    const bool was_enabled{g_profile_lock_contention};
+    g_profile_lock_contention = false;
+    contend();
+    BOOST_CHECK(!find_stats("contended_mutex"));
+
+    g_profile_lock_contention = true;
+    contend();
+    g_profile_lock_contention = was_enabled;
+    // The uncontended locks are not recorded
+    { LOCK(contended_mutex); }
+
+    const auto stats{find_stats("contended_mutex")};
+    BOOST_REQUIRE(stats);
+    BOOST_CHECK_EQUAL(stats->count, 1U);
+    BOOST_CHECK(stats->total_wait >= 10ms);
+    BOOST_CHECK(stats->max_wait == stats->total_wait);
+    BOOST_CHECK(stats->wait_p50 <= stats->max_wait);
+    BOOST_REQUIRE_EQUAL(stats->sites.size(), 1U);
+    BOOST_CHECK_EQUAL(stats->sites[0].location.rfind("test/sync_tests.cpp:", 0),
+                      0U);
+    BOOST_CHECK_EQUAL(stats->sites[0].count, 1U);
+
+    ResetLockContentionStats();
+    BOOST_CHECK(!find_stats("contended_mutex"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -454,6 +454,46 @@ BOOST_AUTO_TEST_CASE(test_big_transaction) {
     scriptcheckqueue.StopWorkerThreads();
 }
 
+BOOST_AUTO_TEST_CASE(sign_with_precomputed_data) {
+    // SignTransaction hashes with the midstates of the transaction, which must
+    // not change the signatures of any input.
+    CKey key;
+    key.MakeNewKey(true);
+    FillableSigningProvider keystore;
+    BOOST_CHECK(keystore.AddKey(key));
+    const CScript scriptPubKey{
+        GetScriptForDestination(PKHash(key.GetPubKey()))};
+
+    CMutableTransaction mtx;
+    std::map<COutPoint, Coin> coins;
+    for (uint32_t i = 0; i < 20; i++) {
+        const COutPoint prevout(TxId(InsecureRand256()), i);
+        mtx.vin.emplace_back(prevout);
+        const Amount amount{(1000 + int64_t(i)) * SATOSHI};
+        coins.emplace(prevout, Coin(CTxOut(amount, scriptPubKey), 1, false));
+    }
+    mtx.vout.emplace_back(1000 * SATOSHI, scriptPubKey);
+
+    for (const SigHashType sighash :
+         {SigHashType().withForkId(),
+          SigHashType().withForkId().withAnyoneCanPay(),
+          SigHashType().withForkId().withBaseType(BaseSigHashType::NONE)}) {
+        CMutableTransaction signed_tx{mtx};
+        std::map<int, std::string> input_errors;
+        BOOST_CHECK(SignTransaction(signed_tx, &keystore, coins, sighash,
+                                    input_errors));
+        BOOST_CHECK(input_errors.empty());
+
+        CMutableTransaction expected_tx{mtx};
+        for (uint32_t i = 0; i < expected_tx.vin.size(); i++) {
+            const Amount amount{(1000 + int64_t(i)) * SATOSHI};
+            BOOST_CHECK(SignSignature(keystore, scriptPubKey, expected_tx, i,
+                                      amount, sighash));
+        }
+        BOOST_CHECK(CTransaction(signed_tx) == CTransaction(expected_tx));
+    }
+}
+
 SignatureData CombineSignatures(const CMutableTransaction &input1,
                                 const CMutableTransaction &input2,
                                 const CTransactionRef tx) {
@@ -942,4 +982,43 @@ BOOST_AUTO_TEST_CASE(tx_getvalueout) {
     BOOST_CHECK_THROW(overflow_sum_tx.GetValueOut(), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(unserialize_transactions) {
+    std::vector<CMutableTransaction> txs;
+    std::vector<TxId> txids;
+    // Transactions of various sizes, spanning one to several SHA256 chunks
+    for (size_t i = 0; i < 50; ++i) {
+        CMutableTransaction mtx;
+        mtx.nVersion = 1;
+        mtx.vin.resize(1 + i % 7);
+        for (CTxIn &in : mtx.vin) {
+            in.prevout = COutPoint(TxId(InsecureRand256()), i);
+            in.scriptSig = CScript() << std::vector<uint8_t>(i * 3, 0x42);
+        }
+        mtx.vout.resize(1 + i % 3);
+        mtx.nLockTime = i;
+        txids.push_back(mtx.GetId());
+        txs.push_back(std::move(mtx));
+    }
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << txs;
+    std::vector<CTransactionRef> refs;
+    UnserializeTransactions(stream, refs);
+    BOOST_CHECK(stream.empty());
+    BOOST_REQUIRE_EQUAL(refs.size(), txids.size());
+    for (size_t i = 0; i < refs.size(); ++i) {
+        BOOST_CHECK_EQUAL(refs[i]->GetId(), txids[i]);
+        // The size recorded while reading matches the serialization.
+        CDataStream tx_stream(SER_NETWORK, PROTOCOL_VERSION);
+        tx_stream << *refs[i];
+        BOOST_CHECK_EQUAL(refs[i]->GetTotalSize(), tx_stream.size());
+        BOOST_CHECK_EQUAL(refs[i]->GetTotalSize(),
+                          CTransaction(txs[i]).GetTotalSize());
+    }
+
+    stream << std::vector<CMutableTransaction>{};
+    UnserializeTransactions(stream, refs);
+    BOOST_CHECK(refs.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -127,4 +127,57 @@ BOOST_AUTO_TEST_CASE(txpool_get_tx) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(txpool_get_children) {
+    TxPool txpool("testing", 1h, 1h);
+    FastRandomContext rng{true};
+
+    auto make_tx = [](const std::vector<COutPoint> &outpoints) {
+        CMutableTransaction tx;
+        for (const COutPoint &outpoint : outpoints) {
+            tx.vin.emplace_back(outpoint);
+            tx.vin.back().scriptSig = SCRIPT_SIG;
+        }
+        tx.vout.resize(2);
+        tx.vout[0].nValue = CENT;
+        tx.vout[0].scriptPubKey = SCRIPT_PUB_KEY;
+        tx.vout[1].nValue = 3 * CENT;
+        tx.vout[1].scriptPubKey = SCRIPT_PUB_KEY;
+        return MakeTransactionRef(tx);
+    };
+
+    const auto parent = make_tx({{TxId(rng.rand256()), 0}});
+    const TxId &parent_txid = parent->GetId();
+    const auto child0 = make_tx({{parent_txid, 0}});
+    const auto child1 = make_tx({{parent_txid, 1}, {parent_txid, 0}});
+    // Spends an output the parent doesn't have
+    const auto not_child = make_tx({{parent_txid, 2}});
+    const auto unrelated = make_tx({{TxId(rng.rand256()), 0}});
+    BOOST_CHECK(txpool.AddTx(child0, 0));
+    BOOST_CHECK(txpool.AddTx(child1, 1));
+    BOOST_CHECK(txpool.AddTx(not_child, 0));
+    BOOST_CHECK(txpool.AddTx(unrelated, 0));
+
+    auto same_peer = txpool.GetChildrenFromSamePeer(parent, 0);
+    BOOST_CHECK_EQUAL(same_peer.size(), 1);
+    BOOST_CHECK_EQUAL(same_peer[0]->GetId(), child0->GetId());
+
+    // child1 spends two outputs of the parent but is only returned once
+    auto different_peer = txpool.GetChildrenFromDifferentPeer(parent, 0);
+    BOOST_CHECK_EQUAL(different_peer.size(), 1);
+    BOOST_CHECK_EQUAL(different_peer[0].first->GetId(), child1->GetId());
+    BOOST_CHECK_EQUAL(different_peer[0].second, 1);
+
+    BOOST_CHECK(!txpool.HaveTxToReconsider(0));
+    BOOST_CHECK(!txpool.HaveTxToReconsider(1));
+    txpool.AddChildrenToWorkSet(*parent);
+    BOOST_CHECK_EQUAL(txpool.GetTxToReconsider(0)->GetId(), child0->GetId());
+    BOOST_CHECK_EQUAL(txpool.GetTxToReconsider(1)->GetId(), child1->GetId());
+    BOOST_CHECK_EQUAL(txpool.GetTxToReconsider(0), nullptr);
+    BOOST_CHECK_EQUAL(txpool.GetTxToReconsider(1), nullptr);
+
+    // A tx nothing spends
+    BOOST_CHECK(txpool.GetChildrenFromSamePeer(unrelated, 0).empty());
+    BOOST_CHECK(txpool.GetChildrenFromDifferentPeer(unrelated, 1).empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
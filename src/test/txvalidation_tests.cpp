@@ -6,6 +6,8 @@
 #include <consensus/validation.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
 #include <validation.h>
 
 #include <test/util/setup_common.h>
@@ -48,4 +50,98 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_reject_coinbase, TestChain100Setup) {
     BOOST_CHECK_EQUAL(result.m_state.GetRejectReason(), "bad-tx-coinbase");
     BOOST_CHECK(result.m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
 }
+
+/**
+ * Ensure that prechecking the scripts of a batch, including duplicates and
+ * transactions spending each other, leaves them acceptable to the mempool.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_precheck_scripts_batch, TestChain100Setup) {
+    const CScript script_pub_key = CScript()
+                                   << ToByteVector(coinbaseKey.GetPubKey())
+                                   << OP_CHECKSIG;
+    const CTransactionRef parent =
+        MakeTransactionRef(CreateValidMempoolTransaction(
+            m_coinbase_txns[0], /*input_vout=*/0, /*input_height=*/1,
+            coinbaseKey, script_pub_key, /*output_amount=*/10 * COIN,
+            /*submit=*/false));
+    const CTransactionRef child =
+        MakeTransactionRef(CreateValidMempoolTransaction(
+            parent, /*input_vout=*/0, /*input_height=*/101, coinbaseKey,
+            script_pub_key, /*output_amount=*/9 * COIN, /*submit=*/false));
+
+    PrecheckTransactionScripts(m_node.chainman->ActiveChainstate(),
+                               *m_node.mempool, {parent, parent, child});
+
+    LOCK(cs_main);
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), 0U);
+    for (const auto &tx : {parent, child}) {
+        const MempoolAcceptResult result =
+            m_node.chainman->ProcessTransaction(tx);
+        BOOST_CHECK(result.m_result_type ==
+                    MempoolAcceptResult::ResultType::VALID);
+    }
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), 2U);
+}
+
+/**
+ * Ensure that a transaction with enough inputs to have its scripts checked on
+ * the script check queue is accepted, and rejected with a bad signature.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_parallel_script_checks,
+                        TestChain100Setup) {
+    const CScript script_pub_key = CScript()
+                                   << ToByteVector(coinbaseKey.GetPubKey())
+                                   << OP_CHECKSIG;
+    FillableSigningProvider keystore;
+    BOOST_CHECK(keystore.AddKey(coinbaseKey));
+    const SigHashType sighash_type = SigHashType().withForkId();
+    std::map<int, std::string> input_errors;
+
+    // Split a coinbase output into enough outputs to be spent together.
+    const int num_inputs{32};
+    CMutableTransaction split;
+    split.vin.emplace_back(COutPoint(m_coinbase_txns[0]->GetId(), 0));
+    for (int i = 0; i < num_inputs; ++i) {
+        split.vout.emplace_back(COIN, script_pub_key);
+    }
+    std::map<COutPoint, Coin> split_coins{
+        {split.vin[0].prevout,
+         Coin(m_coinbase_txns[0]->vout[0], /*nHeightIn=*/1,
+              /*IsCoinbase=*/true)}};
+    BOOST_CHECK(SignTransaction(split, &keystore, split_coins, sighash_type,
+                                input_errors));
+    const CTransactionRef split_tx = MakeTransactionRef(split);
+
+    CMutableTransaction spend;
+    std::map<COutPoint, Coin> spend_coins;
+    for (int i = 0; i < num_inputs; ++i) {
+        spend.vin.emplace_back(COutPoint(split_tx->GetId(), i));
+        spend_coins.emplace(spend.vin.back().prevout,
+                            Coin(split_tx->vout[i], MEMPOOL_HEIGHT,
+                                 /*IsCoinbase=*/false));
+    }
+    spend.vout.emplace_back((num_inputs - 1) * COIN, script_pub_key);
+    BOOST_CHECK(SignTransaction(spend, &keystore, spend_coins, sighash_type,
+                                input_errors));
+
+    // Corrupt the signature of one input.
+    CMutableTransaction bad_spend{spend};
+    bad_spend.vin[num_inputs / 2].scriptSig = spend.vin[0].scriptSig;
+
+    LOCK(cs_main);
+    BOOST_CHECK(m_node.chainman->ProcessTransaction(split_tx).m_result_type ==
+                MempoolAcceptResult::ResultType::VALID);
+
+    const MempoolAcceptResult bad_result =
+        m_node.chainman->ProcessTransaction(MakeTransactionRef(bad_spend));
+    BOOST_CHECK(bad_result.m_result_type ==
+                MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK(bad_result.m_state.GetResult() ==
+                TxValidationResult::TX_CONSENSUS);
+
+    BOOST_CHECK(m_node.chainman->ProcessTransaction(MakeTransactionRef(spend))
+                    .m_result_type == MempoolAcceptResult::ResultType::VALID);
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), 2U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
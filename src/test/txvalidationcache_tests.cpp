@@ -684,4 +684,28 @@ BOOST_AUTO_TEST_CASE(scriptcache_values) {
     CHECK_CACHE_HAS(key1A, 42);
 }
 
+BOOST_AUTO_TEST_CASE(scriptcache_stats) {
+    LOCK(cs_main);
+    CMutableTransaction mtx;
+    mtx.nVersion = 3;
+    const ScriptCacheKey key(CTransaction(mtx), 0x12345678);
+    const ScriptCacheKey other_key(CTransaction(mtx), 0x87654321);
+
+    const ScriptCacheStats before{GetScriptCacheStats()};
+    BOOST_CHECK(before.max_elements > 0);
+    BOOST_CHECK(before.size_bytes > 0);
+
+    int nSigChecks;
+    BOOST_CHECK(!IsKeyInScriptCache(key, false, nSigChecks));
+    AddKeyInScriptCache(key, 1);
+    BOOST_CHECK(IsKeyInScriptCache(key, false, nSigChecks));
+    BOOST_CHECK(IsKeyInScriptCache(key, false, nSigChecks));
+    BOOST_CHECK(!IsKeyInScriptCache(other_key, false, nSigChecks));
+
+    const ScriptCacheStats after{GetScriptCacheStats()};
+    BOOST_CHECK_EQUAL(after.hits - before.hits, 2U);
+    BOOST_CHECK_EQUAL(after.misses - before.misses, 2U);
+    BOOST_CHECK_EQUAL(after.max_elements, before.max_elements);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -37,11 +37,9 @@ struct ConnmanTestMsg : public CConnman {
 
     void Handshake(CNode &node, bool successfully_connected,
                    ServiceFlags remote_services, ServiceFlags local_services,
-                   int32_t version, bool relay_txs)
-        EXCLUSIVE_LOCKS_REQUIRED(NetEventsInterface::g_msgproc_mutex);
+                   int32_t version, bool relay_txs);
 
-    void ProcessMessagesOnce(CNode &node)
-        EXCLUSIVE_LOCKS_REQUIRED(NetEventsInterface::g_msgproc_mutex) {
+    void ProcessMessagesOnce(CNode &node) {
         for (auto interface : m_msgproc) {
             interface->ProcessMessages(*config, &node, flagInterruptMsgProc);
         }
@@ -108,6 +106,16 @@ public:
 
     ssize_t Send(const void *, size_t len, int) const override { return len; }
 
+    ssize_t SendMany(Span<const Span<const uint8_t>> buffers,
+                     int) const override {
+        ssize_t len{0};
+        const size_t count{std::min(buffers.size(), MAX_SEND_BUFFERS)};
+        for (size_t i = 0; i < count; ++i) {
+            len += buffers[i].size();
+        }
+        return len;
+    }
+
     ssize_t Recv(void *buf, size_t len, int flags) const override {
         const size_t consume_bytes{
             std::min(len, m_contents.size() - m_consumed)};
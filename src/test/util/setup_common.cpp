@@ -22,6 +22,7 @@
 #include <mempool_args.h>
 #include <net.h>
 #include <net_processing.h>
+#include <node/blockmanager_args.h>
 #include <node/blockstorage.h>
 #include <node/chainstate.h>
 #include <node/chainstatemanager_args.h>
@@ -32,6 +33,7 @@
 #include <node/validation_cache_args.h>
 #include <noui.h>
 #include <pow/pow.h>
+#include <pow/powcache.h>
 #include <random.h>
 #include <rpc/blockchain.h>
 #include <rpc/register.h>
@@ -46,7 +48,6 @@
 #include <txdb.h>
 #include <txmempool.h>
 #include <util/strencodings.h>
-#include <util/thread.h>
 #include <util/threadnames.h>
 #include <util/time.h>
 #include <util/translation.h>
@@ -149,6 +150,7 @@ BasicTestingSetup::BasicTestingSetup(
     Assert(InitSignatureCache(validation_cache_sizes.signature_cache_bytes));
     Assert(InitScriptExecutionCache(
         validation_cache_sizes.script_execution_cache_bytes));
+    Assert(InitPowCache(validation_cache_sizes.pow_cache_bytes));
 
     m_node.chain = interfaces::MakeChain(m_node, config.GetChainParams());
     g_wallet_init_interface.Construct(m_node);
@@ -186,9 +188,7 @@ ChainTestingSetup::ChainTestingSetup(
     // We have to run a scheduler thread to prevent ActivateBestChain
     // from blocking due to queue overrun.
     m_node.scheduler = std::make_unique<CScheduler>();
-    m_node.scheduler->m_service_thread =
-        std::thread(util::TraceThread, "scheduler",
-                    [&] { m_node.scheduler->serviceQueue(); });
+    m_node.scheduler->StartServiceThreads();
     GetMainSignals().RegisterBackgroundSignalScheduler(*m_node.scheduler);
 
     m_node.mempool =
@@ -206,10 +206,11 @@ ChainTestingSetup::ChainTestingSetup(
         .notifications = *m_node.notifications,
     };
     ApplyArgsManOptions(*m_node.args, chainman_opts);
-    const BlockManager::Options blockman_opts{
+    BlockManager::Options blockman_opts{
         .chainparams = chainman_opts.config.GetChainParams(),
         .blocks_dir = m_args.GetBlocksDirPath(),
     };
+    Assert(!ApplyArgsManOptions(*m_node.args, blockman_opts));
     m_node.chainman =
         std::make_unique<ChainstateManager>(chainman_opts, blockman_opts);
     m_node.chainman->m_blockman.m_block_tree_db =
@@ -222,16 +223,16 @@ ChainTestingSetup::ChainTestingSetup(
     m_node.chainman->m_blockman.m_block_tree_db->Upgrade();
 
     constexpr int script_check_threads = 2;
-    StartScriptCheckWorkerThreads(script_check_threads);
-    StartPowCheckWorkerThreads(script_check_threads);
+    const bool work_stealing = m_args.GetBoolArg(
+        "-checkqueueworkstealing", DEFAULT_CHECKQUEUE_WORK_STEALING);
+    StartValidationWorkerThreads(script_check_threads, work_stealing);
 }
 
 ChainTestingSetup::~ChainTestingSetup() {
     if (m_node.scheduler) {
         m_node.scheduler->stop();
     }
-    StopScriptCheckWorkerThreads();
-    StopPowCheckWorkerThreads();
+    StopValidationWorkerThreads();
     GetMainSignals().FlushBackgroundCallbacks();
     GetMainSignals().UnregisterBackgroundSignalScheduler();
     m_node.connman.reset();
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <util/string.h>
+#include <util/threadaffinity.h>
 #include <util/threadnames.h>
 
 #if defined(HAVE_CONFIG_H)
@@ -67,4 +68,28 @@ BOOST_AUTO_TEST_CASE(util_threadnames_test_rename_threaded) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(util_threadnames_test_affinity) {
+    std::string error;
+    for (const std::string cpus : {"", "a", "1-", "3-2", "1-2-3", "-1", "1024",
+                                   "0,,1"}) {
+        BOOST_CHECK(!util::AddThreadAffinity("pinned", cpus, error));
+        BOOST_CHECK(!error.empty());
+        error.clear();
+    }
+
+    // Any CPU the process may run on will do.
+    BOOST_CHECK(util::AddThreadAffinity("pinned", "0-1000,1023", error));
+    std::thread([] { util::ThreadRename("pinned.3"); }).join();
+    std::thread([] { util::ThreadRename("unpinned.3"); }).join();
+
+    const auto affinities{util::GetThreadAffinities()};
+    if (util::ThreadAffinitySupported()) {
+        BOOST_REQUIRE_EQUAL(affinities.size(), 1U);
+        BOOST_CHECK_EQUAL(affinities[0].first, "pinned.3");
+        BOOST_CHECK_EQUAL(affinities[0].second, "0-1000,1023");
+    } else {
+        BOOST_CHECK(affinities.empty());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
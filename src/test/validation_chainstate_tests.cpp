@@ -2,7 +2,9 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 //
+#include <chain.h>
 #include <chainparams.h>
+#include <clientversion.h>
 #include <config.h>
 #include <consensus/validation.h>
 #include <random.h>
@@ -10,6 +12,7 @@
 #include <sync.h>
 #include <test/util/chainstate.h>
 #include <test/util/coins.h>
+#include <test/util/logging.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <uint256.h>
@@ -78,6 +81,23 @@ BOOST_FIXTURE_TEST_CASE(chainstate_update_tip, TestChain100Setup) {
     // After adding some blocks to the tip, best block should have changed.
     BOOST_CHECK(::g_best_block != curr_tip);
 
+    // The active chain snapshot follows the tip.
+    {
+        const auto snapshot = chainman.GetActiveChainSnapshot();
+        BOOST_CHECK_EQUAL(snapshot->Tip(), ::g_best_block);
+        BOOST_CHECK_EQUAL(snapshot->Height(), ::g_best_block->nHeight);
+        LOCK(::cs_main);
+        const CChain &active_chain = chainman.ActiveChain();
+        for (int height = 0; height <= active_chain.Height(); ++height) {
+            BOOST_CHECK_EQUAL((*snapshot)[height], active_chain[height]);
+        }
+        BOOST_CHECK((*snapshot)[snapshot->Height() + 1] == nullptr);
+        BOOST_CHECK(snapshot->Contains(curr_tip));
+        BOOST_CHECK_EQUAL(snapshot->Next(curr_tip),
+                          active_chain.Next(curr_tip));
+        BOOST_CHECK(snapshot->Next(snapshot->Tip()) == nullptr);
+    }
+
     BOOST_REQUIRE(CreateAndActivateUTXOSnapshot(this, NoMalleation,
                                                 /*reset_chainstate=*/true));
 
@@ -93,6 +113,8 @@ BOOST_FIXTURE_TEST_CASE(chainstate_update_tip, TestChain100Setup) {
     // After adding some blocks to the snapshot tip, best block should have
     // changed.
     BOOST_CHECK(::g_best_block != curr_tip);
+    BOOST_CHECK_EQUAL(chainman.GetActiveChainSnapshot()->Tip(),
+                      ::g_best_block);
 
     curr_tip = ::g_best_block;
 
@@ -141,6 +163,128 @@ BOOST_FIXTURE_TEST_CASE(chainstate_update_tip, TestChain100Setup) {
     // validation chain.
     BOOST_CHECK(block_added);
     BOOST_CHECK_EQUAL(curr_tip, ::g_best_block);
+    BOOST_CHECK_EQUAL(chainman.GetActiveChainSnapshot()->Tip(), curr_tip);
+}
+
+//! Check the scripts of a competing chain before it gets activated.
+BOOST_FIXTURE_TEST_CASE(chainstate_speculative_fork_check, TestChain100Setup) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    Chainstate &chainstate = chainman.ActiveChainstate();
+    const CScript script{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+
+    // Two blocks at the same height, the second one spending a coin
+    const CMutableTransaction tx{CreateValidMempoolTransaction(
+        m_coinbase_txns[0], /*input_vout=*/0, /*input_height=*/0, coinbaseKey,
+        script, /*output_amount=*/10 * COIN, /*submit=*/false)};
+    const auto active_block{
+        std::make_shared<CBlock>(CreateBlock({}, script, chainstate))};
+    const auto competing_block{
+        std::make_shared<CBlock>(CreateBlock({tx}, script, chainstate))};
+    BOOST_CHECK(chainman.ProcessNewBlock(active_block, true, true, nullptr));
+    BOOST_CHECK(chainman.ProcessNewBlock(competing_block, true, true, nullptr));
+    CBlockIndex *active_tip;
+    CBlockIndex *competing_tip;
+    {
+        LOCK(::cs_main);
+        active_tip = chainman.ActiveTip();
+        competing_tip =
+            chainman.m_blockman.LookupBlockIndex(competing_block->GetHash());
+    }
+    BOOST_REQUIRE(competing_tip);
+    BOOST_CHECK_EQUAL(active_tip->GetBlockHash(), active_block->GetHash());
+
+    // The check may also have been scheduled when the competing block arrived,
+    // in any case the transaction is cached afterwards.
+    BOOST_CHECK(chainstate.SpeculativelyCheckFork(competing_tip) <= 1);
+    BOOST_CHECK_EQUAL(chainstate.SpeculativelyCheckFork(competing_tip), 0);
+
+    // Nothing to check on the active chain
+    BOOST_CHECK_EQUAL(chainstate.SpeculativelyCheckFork(active_tip), 0);
+
+    // The competing chain can be activated
+    BlockValidationState state;
+    BOOST_CHECK(chainstate.InvalidateBlock(state, active_tip));
+    BOOST_CHECK(chainstate.ActivateBestChain(state));
+    BOOST_CHECK_EQUAL(WITH_LOCK(::cs_main, return chainman.ActiveTip()),
+                      competing_tip);
+}
+
+//! Reconnect a block whose scripts have already been verified.
+BOOST_FIXTURE_TEST_CASE(chainstate_reconnect_checked_scripts,
+                        TestChain100Setup) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    Chainstate &chainstate = chainman.ActiveChainstate();
+    CBlockIndex *tip{WITH_LOCK(::cs_main, return chainman.ActiveTip())};
+
+    uint32_t script_flags;
+    {
+        LOCK(::cs_main);
+        BOOST_CHECK(tip->nStatus.hasCheckedScripts());
+        script_flags = tip->nScriptFlags;
+        BOOST_CHECK(script_flags != SCRIPT_VERIFY_NONE);
+    }
+
+    // The marker survives a round trip to the block index database
+    CDataStream stream(SER_DISK, CLIENT_VERSION);
+    stream << CDiskBlockIndex{tip};
+    CDiskBlockIndex diskindex;
+    stream >> diskindex;
+    BOOST_CHECK(stream.empty());
+    BOOST_CHECK(WITH_LOCK(::cs_main, return diskindex.nStatus ==
+                                            tip->nStatus));
+    BOOST_CHECK_EQUAL(WITH_LOCK(::cs_main, return diskindex.nScriptFlags),
+                      script_flags);
+
+    // An entry rewritten by an older version keeps the status bit but not the
+    // flags, the scripts are then no longer considered checked
+    CDataStream old_stream(SER_DISK, CLIENT_VERSION);
+    old_stream << CDiskBlockIndex{tip};
+    old_stream.resize(old_stream.size() -
+                      GetSerializeSize(VARINT(script_flags)));
+    CDiskBlockIndex old_diskindex;
+    old_stream >> old_diskindex;
+    BOOST_CHECK(!WITH_LOCK(::cs_main,
+                           return old_diskindex.nStatus.hasCheckedScripts()));
+    BOOST_CHECK(WITH_LOCK(::cs_main, return old_diskindex.nStatus.hasData()));
+
+    BlockValidationState state;
+    BOOST_CHECK(chainstate.InvalidateBlock(state, tip));
+    BOOST_CHECK(WITH_LOCK(::cs_main, return chainman.ActiveTip()) != tip);
+
+    // Connecting the block back doesn't run its scripts again
+    {
+        ASSERT_DEBUG_LOG("Skipping the script checks of block " +
+                         tip->GetBlockHash().ToString());
+        WITH_LOCK(::cs_main, chainstate.ResetBlockFailureFlags(tip));
+        BOOST_CHECK(chainstate.ActivateBestChain(state));
+    }
+    BOOST_CHECK_EQUAL(WITH_LOCK(::cs_main, return chainman.ActiveTip()), tip);
+    BOOST_CHECK_EQUAL(WITH_LOCK(::cs_main, return tip->nScriptFlags),
+                      script_flags);
+}
+
+//! VerifyDB must run the scripts even of the blocks already checked before.
+BOOST_FIXTURE_TEST_CASE(verifydb_runs_checked_scripts, TestChain100Setup) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    Chainstate &chainstate = chainman.ActiveChainstate();
+
+    bool skipped{false};
+    {
+        DebugLogHelper skip_log{"Skipping the script checks of block ",
+                                [&](const std::string *line) {
+                                    if (line) {
+                                        skipped = true;
+                                    }
+                                    return false;
+                                }};
+        LOCK(::cs_main);
+        BOOST_CHECK(chainman.ActiveTip()->nStatus.hasCheckedScripts());
+        BOOST_CHECK(CVerifyDB(chainman.GetNotifications())
+                        .VerifyDB(chainstate, chainstate.CoinsTip(),
+                                  /*nCheckLevel=*/4, /*nCheckDepth=*/10) ==
+                    VerifyDBResult::SUCCESS);
+    }
+    BOOST_CHECK(!skipped);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -10,10 +10,17 @@
 #include <validation.h>
 #include <validationinterface.h>
 
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <future>
+#include <optional>
+#include <string>
+#include <vector>
+
 BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, ChainTestingSetup)
 
 struct TestSubscriberNoop final : public CValidationInterface {
@@ -252,4 +259,156 @@ BOOST_FIXTURE_TEST_CASE(block_invalidated, TestChain100Setup) {
     BOOST_CHECK_EQUAL(calledBlock, block);
 }
 
+class FinalizedRecorder final : public CValidationInterface {
+public:
+    FinalizedRecorder(std::string name,
+                      std::function<void(const CBlockIndex *)> on_finalized)
+        : m_name(std::move(name)), m_on_finalized(std::move(on_finalized)) {}
+
+    void BlockFinalized(const CBlockIndex *pindex) override {
+        m_on_finalized(pindex);
+        m_finalized.push_back(pindex);
+    }
+    std::string GetSubscriberName() const override { return m_name; }
+
+    const std::string m_name;
+    const std::function<void(const CBlockIndex *)> m_on_finalized;
+    //! Only accessed from the callbacks or after syncing with the queue
+    std::vector<const CBlockIndex *> m_finalized;
+};
+
+static std::optional<SubscriberQueueStats>
+GetQueueStats(const std::string &name) {
+    for (const SubscriberQueueStats &stats :
+         GetMainSignals().GetSubscriberQueueStats()) {
+        if (stats.name == name) {
+            return stats;
+        }
+    }
+    return std::nullopt;
+}
+
+BOOST_AUTO_TEST_CASE(slow_subscriber) {
+    std::vector<CBlockIndex> indexes(10);
+    // The events are logged with the block hash
+    std::vector<BlockHash> hashes(indexes.size());
+    std::vector<const CBlockIndex *> expected;
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        hashes[i] = BlockHash{InsecureRand256()};
+        indexes[i].phashBlock = &hashes[i];
+        expected.push_back(&indexes[i]);
+    }
+
+    // The slow subscriber is blocked on its first event
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future();
+    auto slow = std::make_shared<FinalizedRecorder>(
+        "slow", [&](const CBlockIndex *) { released.wait(); });
+    std::promise<void> fast_done;
+    size_t fast_count{0};
+    auto fast = std::make_shared<FinalizedRecorder>(
+        "fast", [&](const CBlockIndex *) {
+            if (++fast_count == indexes.size()) {
+                fast_done.set_value();
+            }
+        });
+    RegisterSharedValidationInterface(slow);
+    RegisterSharedValidationInterface(fast);
+
+    for (const CBlockIndex &index : indexes) {
+        TestInterface::CallBlockFinalized(&index);
+    }
+
+    // The fast subscriber gets all the events regardless
+    BOOST_CHECK(fast_done.get_future().wait_for(std::chrono::seconds{30}) ==
+                std::future_status::ready);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), indexes.size());
+    auto slow_stats = GetQueueStats("slow");
+    BOOST_REQUIRE(slow_stats);
+    BOOST_CHECK_EQUAL(slow_stats->pending, indexes.size());
+    BOOST_CHECK_EQUAL(slow_stats->max_pending, indexes.size());
+    BOOST_CHECK_EQUAL(slow_stats->delivered, 0);
+
+    // The queued function waits for all the subscribers to be done with the
+    // prior events, and the later events wait for it.
+    size_t fast_count_at_barrier{0};
+    size_t slow_count_at_barrier{0};
+    CallFunctionInValidationInterfaceQueue([&] {
+        fast_count_at_barrier = fast->m_finalized.size();
+        slow_count_at_barrier = slow->m_finalized.size();
+    });
+    TestInterface::CallBlockFinalized(nullptr);
+    expected.push_back(nullptr);
+
+    release.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(fast_count_at_barrier, indexes.size());
+    BOOST_CHECK_EQUAL(slow_count_at_barrier, indexes.size());
+    BOOST_CHECK(fast->m_finalized == expected);
+    BOOST_CHECK(slow->m_finalized == expected);
+
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 0);
+    slow_stats = GetQueueStats("slow");
+    BOOST_REQUIRE(slow_stats);
+    BOOST_CHECK_EQUAL(slow_stats->pending, 0);
+    BOOST_CHECK_EQUAL(slow_stats->delivered, expected.size());
+
+    UnregisterSharedValidationInterface(slow);
+    UnregisterSharedValidationInterface(fast);
+    BOOST_CHECK(!GetQueueStats("slow"));
+}
+
+class ConnectedRecorder final : public CValidationInterface {
+public:
+    void BlocksConnected(const std::vector<ConnectedBlock> &blocks) override {
+        std::vector<const CBlockIndex *> batch;
+        for (const ConnectedBlock &connected : blocks) {
+            batch.push_back(connected.pindex);
+        }
+        m_batches.push_back(batch);
+    }
+    void BlockFinalized(const CBlockIndex *pindex) override {
+        m_batches.push_back({});
+    }
+
+    //! Only accessed from the callbacks or after syncing with the queue.
+    //! The finalized blocks are recorded as empty batches.
+    std::vector<std::vector<const CBlockIndex *>> m_batches;
+};
+
+BOOST_AUTO_TEST_CASE(batched_blocks_connected) {
+    auto recorder = std::make_shared<ConnectedRecorder>();
+    RegisterSharedValidationInterface(recorder);
+
+    // Hold the queue so the notifications pile up behind the function
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future();
+    CallFunctionInValidationInterfaceQueue([&] { released.wait(); });
+
+    const auto block = std::make_shared<const CBlock>();
+    std::vector<CBlockIndex> indexes(7);
+    std::vector<BlockHash> hashes(indexes.size());
+    std::vector<const CBlockIndex *> first, second;
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        hashes[i] = BlockHash{InsecureRand256()};
+        indexes[i].phashBlock = &hashes[i];
+        indexes[i].pprev = i > 0 ? &indexes[i - 1] : nullptr;
+        if (i == 5) {
+            TestInterface::CallBlockFinalized(&indexes[i - 1]);
+        }
+        GetMainSignals().BlockConnected(block, &indexes[i]);
+        (i < 5 ? first : second).push_back(&indexes[i]);
+    }
+
+    release.set_value();
+    SyncWithValidationInterfaceQueue();
+
+    // The blocks are batched up to the next notification of another kind
+    const std::vector<std::vector<const CBlockIndex *>> expected{
+        first, {}, second};
+    BOOST_CHECK(recorder->m_batches == expected);
+
+    UnregisterSharedValidationInterface(recorder);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,100 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <workstealingdeque.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(workstealingdeque_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(single_thread) {
+    WorkStealingDeque<int> deque(/*initial_capacity=*/2);
+    BOOST_CHECK(deque.Empty());
+    BOOST_CHECK(!deque.Pop());
+    BOOST_CHECK(!deque.Steal());
+
+    // Push enough elements to grow the ring a few times.
+    for (int i = 0; i < 10; ++i) {
+        deque.Push(i);
+    }
+    BOOST_CHECK(!deque.Empty());
+
+    // The owner pops from the bottom, thieves steal from the top.
+    BOOST_CHECK_EQUAL(*deque.Pop(), 9);
+    BOOST_CHECK_EQUAL(*deque.Steal(), 0);
+    BOOST_CHECK_EQUAL(*deque.Steal(), 1);
+    BOOST_CHECK_EQUAL(*deque.Pop(), 8);
+
+    for (int i = 2; i < 8; ++i) {
+        BOOST_CHECK_EQUAL(*deque.Steal(), i);
+    }
+    BOOST_CHECK(deque.Empty());
+    BOOST_CHECK(!deque.Pop());
+    BOOST_CHECK(!deque.Steal());
+
+    // The deque is still usable once drained.
+    deque.Push(42);
+    BOOST_CHECK_EQUAL(*deque.Pop(), 42);
+    BOOST_CHECK(deque.Empty());
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_steal) {
+    constexpr int NUM_ITEMS = 100000;
+    constexpr int NUM_THIEVES = 3;
+
+    WorkStealingDeque<int> deque(/*initial_capacity=*/16);
+    std::vector<std::atomic<int>> seen(NUM_ITEMS);
+    std::atomic<int> n_taken{0};
+    std::atomic<bool> done_pushing{false};
+
+    std::vector<std::thread> thieves;
+    for (int n = 0; n < NUM_THIEVES; ++n) {
+        thieves.emplace_back([&] {
+            while (!done_pushing || !deque.Empty()) {
+                if (auto x = deque.Steal()) {
+                    seen[*x].fetch_add(1);
+                    n_taken.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    // Interleave pushes and pops on the owner side so it races with the
+    // thieves for the last elements.
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        deque.Push(i);
+        if (i % 3 == 0) {
+            if (auto x = deque.Pop()) {
+                seen[*x].fetch_add(1);
+                n_taken.fetch_add(1);
+            }
+        }
+    }
+    while (auto x = deque.Pop()) {
+        seen[*x].fetch_add(1);
+        n_taken.fetch_add(1);
+    }
+    done_pushing = true;
+
+    for (auto &thread : thieves) {
+        thread.join();
+    }
+
+    // Every element was taken exactly once.
+    BOOST_CHECK_EQUAL(n_taken.load(), NUM_ITEMS);
+    bool all_once = true;
+    for (int i = 0; i < NUM_ITEMS; ++i) {
+        all_once &= seen[i].load() == 1;
+    }
+    BOOST_CHECK(all_once);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
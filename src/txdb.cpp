@@ -10,19 +10,24 @@
 #include <logging.h>
 #include <node/ui_interface.h>
 #include <pow/pow.h>
+#include <primitives/auxpow.h>
 #include <random.h>
 #include <shutdown.h>
 #include <util/translation.h>
 #include <util/vector.h>
+#include <validationthreadpool.h>
 #include <version.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 
 static constexpr uint8_t DB_COIN{'C'};
 static constexpr uint8_t DB_COINS{'c'};
 static constexpr uint8_t DB_BLOCK_FILES{'f'};
 static constexpr uint8_t DB_BLOCK_INDEX{'b'};
+static constexpr uint8_t DB_AUXPOW{'a'};
 
 static constexpr uint8_t DB_BEST_BLOCK{'B'};
 static constexpr uint8_t DB_HEAD_BLOCKS{'H'};
@@ -73,6 +78,20 @@ struct CoinEntry {
         SER_READ(obj, *obj.outpoint = COutPoint(id, n));
     }
 };
+
+//! The number of coins cache entries encoded in parallel at a time.
+static constexpr size_t WRITE_ROUND_ENTRIES{1 << 16};
+//! The number of dirty entries encoded by a thread at a time.
+static constexpr size_t WRITE_SHARD_ENTRIES{1 << 12};
+
+void WriteCoin(CDBBatch &batch, const CCoinsMap::value_type &entry) {
+    CoinEntry key(&entry.first);
+    if (entry.second.coin.IsSpent()) {
+        batch.Erase(key);
+    } else {
+        batch.Write(key, entry.second.coin);
+    }
+}
 } // namespace
 
 CCoinsViewDB::CCoinsViewDB(DBParams db_params, CoinsViewOptions options)
@@ -83,6 +102,14 @@ void CCoinsViewDB::ResizeCache(size_t new_cache_size) {
     // We can't do this operation with an in-memory DB since we'll lose all the
     // coins upon reset.
     if (!m_db_params.memory_only) {
+        {
+            // The snapshots are read without cs_main, and released soon.
+            WAIT_LOCK(m_snapshots.mutex, lock);
+            m_snapshots.cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(
+                                          m_snapshots.mutex) {
+                return m_snapshots.count == 0;
+            });
+        }
         // Have to do a reset first to get the original `m_db` state to release
         // its filesystem lock.
         m_db.reset();
@@ -96,6 +123,26 @@ bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return m_db->Read(CoinEntry(&outpoint), coin);
 }
 
+std::unique_ptr<CCoinsViewDBSnapshot> CCoinsViewDB::GetSnapshot() const {
+    AssertLockHeld(cs_main);
+    WITH_LOCK(m_snapshots.mutex, ++m_snapshots.count);
+    return std::unique_ptr<CCoinsViewDBSnapshot>(
+        new CCoinsViewDBSnapshot(*m_db, m_snapshots));
+}
+
+CCoinsViewDBSnapshot::~CCoinsViewDBSnapshot() {
+    // Release the snapshot before the database may be reopened.
+    m_snapshot.reset();
+    LOCK(m_count.mutex);
+    --m_count.count;
+    m_count.cv.notify_all();
+}
+
+bool CCoinsViewDBSnapshot::GetCoin(const COutPoint &outpoint,
+                                   Coin &coin) const {
+    return m_snapshot->Read(CoinEntry(&outpoint), coin);
+}
+
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
     return m_db->Exists(CoinEntry(&outpoint));
 }
@@ -118,6 +165,17 @@ std::vector<BlockHash> CCoinsViewDB::GetHeadBlocks() const {
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
                               bool erase) {
+    return WriteCoins(mapCoins, hashBlock, erase, /*partial=*/false);
+}
+
+bool CCoinsViewDB::BatchWritePartial(CCoinsMap &mapCoins,
+                                     const BlockHash &hashBlock) {
+    return WriteCoins(mapCoins, hashBlock, /*erase=*/true, /*partial=*/true);
+}
+
+bool CCoinsViewDB::WriteCoins(CCoinsMap &mapCoins, const BlockHash &hashBlock,
+                              bool erase, bool partial) {
+    ++m_write_epoch;
     CDBBatch batch(*m_db);
     size_t count = 0;
     size_t changed = 0;
@@ -128,7 +186,9 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
         // We may be in the middle of replaying.
         std::vector<BlockHash> old_heads = GetHeadBlocks();
         if (old_heads.size() == 2) {
-            assert(old_heads[0] == hashBlock);
+            // Partial writes leave the database in the middle of a transition
+            // to an ancestor of hashBlock.
+            assert(old_heads[0] == hashBlock || m_written_partially);
             old_tip = old_heads[1];
         }
     }
@@ -140,40 +200,101 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
     batch.Erase(DB_BEST_BLOCK);
     batch.Write(DB_HEAD_BLOCKS, Vector(hashBlock, old_tip));
 
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
-        if (it->second.flags & CCoinsCacheEntry::DIRTY) {
-            CoinEntry entry(&it->first);
-            if (it->second.coin.IsSpent()) {
-                batch.Erase(entry);
-            } else {
-                batch.Write(entry, it->second.coin);
+    const auto write_partial_batch = [&]() {
+        if (batch.SizeEstimate() <= m_options.batch_write_bytes) {
+            return;
+        }
+        LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n",
+                 batch.SizeEstimate() * (1.0 / 1048576.0));
+        m_db->WriteBatch(batch);
+        batch.Clear();
+        if (m_options.simulate_crash_ratio) {
+            static FastRandomContext rng;
+            if (rng.randrange(m_options.simulate_crash_ratio) == 0) {
+                LogPrintf("Simulating a crash. Goodbye.\n");
+                _Exit(0);
             }
-            changed++;
         }
-        count++;
-        it = erase ? mapCoins.erase(it) : std::next(it);
-        if (batch.SizeEstimate() > m_options.batch_write_bytes) {
-            LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n",
-                     batch.SizeEstimate() * (1.0 / 1048576.0));
-            m_db->WriteBatch(batch);
-            batch.Clear();
-            if (m_options.simulate_crash_ratio) {
-                static FastRandomContext rng;
-                if (rng.randrange(m_options.simulate_crash_ratio) == 0) {
-                    LogPrintf("Simulating a crash. Goodbye.\n");
-                    _Exit(0);
+    };
+
+    ValidationThreadPool *const pool{m_options.write_pool};
+    if (pool && pool->Size() > 0) {
+        // Encode the dirty entries in rounds, each split in shards that are
+        // encoded in parallel into batches of their own. These are then
+        // appended in order, so the changes are written in the same order as
+        // serially.
+        std::vector<const CCoinsMap::value_type *> dirty;
+        std::vector<CDBBatch> shards;
+        for (CCoinsMap::iterator it = mapCoins.begin();
+             it != mapCoins.end();) {
+            const CCoinsMap::iterator round_begin{it};
+            size_t round_count{0};
+            dirty.clear();
+            for (; it != mapCoins.end() && round_count < WRITE_ROUND_ENTRIES;
+                 ++it, ++round_count) {
+                if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+                    dirty.push_back(&*it);
                 }
             }
+
+            const size_t num_shards{(dirty.size() + WRITE_SHARD_ENTRIES - 1) /
+                                    WRITE_SHARD_ENTRIES};
+            shards.clear();
+            shards.reserve(num_shards);
+            for (size_t n = 0; n < num_shards; ++n) {
+                shards.emplace_back(*m_db);
+            }
+            pool->ParallelFor(num_shards, [&](size_t shard) {
+                const size_t end{
+                    std::min(dirty.size(), (shard + 1) * WRITE_SHARD_ENTRIES)};
+                for (size_t i = shard * WRITE_SHARD_ENTRIES; i < end; ++i) {
+                    WriteCoin(shards[shard], *dirty[i]);
+                }
+            });
+            for (const CDBBatch &shard : shards) {
+                batch.Append(shard);
+                write_partial_batch();
+            }
+            changed += dirty.size();
+            count += round_count;
+
+            if (erase) {
+                // This leaves the next round's entries alone.
+                CCoinsMap::iterator erase_it{round_begin};
+                for (size_t n = 0; n < round_count; ++n) {
+                    erase_it = mapCoins.erase(erase_it);
+                }
+            }
+        }
+    } else {
+        for (CCoinsMap::iterator it = mapCoins.begin();
+             it != mapCoins.end();) {
+            if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+                WriteCoin(batch, *it);
+                changed++;
+            }
+            count++;
+            it = erase ? mapCoins.erase(it) : std::next(it);
+            write_partial_batch();
         }
     }
 
-    // In the last batch, mark the database as consistent with hashBlock again.
-    batch.Erase(DB_HEAD_BLOCKS);
-    batch.Write(DB_BEST_BLOCK, hashBlock);
+    // In the last batch, mark the database as consistent with hashBlock again,
+    // unless more changes are to come.
+    if (!partial) {
+        batch.Erase(DB_HEAD_BLOCKS);
+        batch.Write(DB_BEST_BLOCK, hashBlock);
+    }
 
     LogPrint(BCLog::COINDB, "Writing final batch of %.2f MiB\n",
              batch.SizeEstimate() * (1.0 / 1048576.0));
     bool ret = m_db->WriteBatch(batch);
+    if (partial) {
+        m_written_partially = true;
+    } else if (ret) {
+        m_written_partially = false;
+    }
+    ++m_write_epoch;
     LogPrint(BCLog::COINDB,
              "Committed %u changed transaction outputs (out of "
              "%u) to coin database...\n",
@@ -181,6 +302,39 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
     return ret;
 }
 
+bool CCoinsViewDB::BulkWrite(
+    const std::vector<std::pair<COutPoint, Coin>> &coins) {
+    ++m_write_epoch;
+    CDBBatch batch(*m_db);
+    bool ret = true;
+    for (const auto &[outpoint, coin] : coins) {
+        batch.Write(CoinEntry(&outpoint), coin);
+        if (batch.SizeEstimate() > m_options.batch_write_bytes) {
+            ret = m_db->WriteBatch(batch) && ret;
+            batch.Clear();
+        }
+    }
+    ret = m_db->WriteBatch(batch) && ret;
+    ++m_write_epoch;
+    return ret;
+}
+
+bool CCoinsViewDB::KeyLess(const COutPoint &a, const COutPoint &b) {
+    // uint256::operator< does not compare the bytes in the order of the keys.
+    if (const int cmp{std::memcmp(a.GetTxId().begin(), b.GetTxId().begin(),
+                                  a.GetTxId().size())}) {
+        return cmp < 0;
+    }
+    // The VARINT encoding of the index does not sort like the index.
+    CDataStream key_a(SER_DISK, CLIENT_VERSION);
+    CDataStream key_b(SER_DISK, CLIENT_VERSION);
+    key_a << CoinEntry(&a);
+    key_b << CoinEntry(&b);
+    return std::lexicographical_compare(
+        UCharCast(key_a.data()), UCharCast(key_a.data() + key_a.size()),
+        UCharCast(key_b.data()), UCharCast(key_b.data() + key_b.size()));
+}
+
 size_t CCoinsViewDB::EstimateSize() const {
     return m_db->EstimateSize(DB_COIN, uint8_t(DB_COIN + 1));
 }
@@ -226,6 +380,52 @@ CCoinsViewCursor *CCoinsViewDB::Cursor() const {
     return i;
 }
 
+std::vector<std::unique_ptr<CCoinsViewCursor>>
+CCoinsViewDB::ShardedCursors(size_t num_shards) const {
+    // The shards split the range of the first byte of the txids, which are
+    // uniformly distributed.
+    num_shards = std::clamp<size_t>(num_shards, 1, 256);
+    WITH_LOCK(m_snapshots.mutex, ++m_snapshots.count);
+    const std::shared_ptr<const CCoinsViewDBSnapshot> snapshot(
+        new CCoinsViewDBSnapshot(*m_db, m_snapshots));
+    BlockHash best_block;
+    snapshot->m_snapshot->Read(DB_BEST_BLOCK, best_block);
+
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    cursors.reserve(num_shards);
+    for (size_t shard = 0; shard < num_shards; ++shard) {
+        auto cursor = std::unique_ptr<CCoinsViewDBCursor>(
+            new CCoinsViewDBCursor(snapshot, best_block));
+        TxId begin;
+        *begin.begin() = shard * 256 / num_shards;
+        if (shard + 1 < num_shards) {
+            TxId end;
+            *end.begin() = (shard + 1) * 256 / num_shards;
+            cursor->m_end = end;
+        }
+        cursor->Seek(begin);
+        cursors.push_back(std::move(cursor));
+    }
+    return cursors;
+}
+
+CCoinsViewDBCursor::CCoinsViewDBCursor(
+    std::shared_ptr<const CCoinsViewDBSnapshot> snapshot,
+    const BlockHash &hashBlockIn)
+    : CCoinsViewCursor(hashBlockIn), m_snapshot(std::move(snapshot)),
+      pcursor(m_snapshot->m_snapshot->NewIterator()) {}
+
+void CCoinsViewDBCursor::Seek(const TxId &begin) {
+    COutPoint outpoint(begin, 0);
+    pcursor->Seek(CoinEntry(&outpoint));
+    CoinEntry entry(&keyTmp.second);
+    if (!pcursor->Valid() || !pcursor->GetKey(entry)) {
+        keyTmp.first = 0;
+    } else {
+        keyTmp.first = entry.key;
+    }
+}
+
 bool CCoinsViewDBCursor::GetKey(COutPoint &key) const {
     // Return cached key
     if (keyTmp.first == DB_COIN) {
@@ -244,7 +444,10 @@ unsigned int CCoinsViewDBCursor::GetValueSize() const {
 }
 
 bool CCoinsViewDBCursor::Valid() const {
-    return keyTmp.first == DB_COIN;
+    // Like in KeyLess(), the bound is compared in the order of the keys.
+    return keyTmp.first == DB_COIN &&
+           (!m_end || std::memcmp(keyTmp.second.GetTxId().begin(),
+                                  m_end->begin(), m_end->size()) < 0);
 }
 
 void CCoinsViewDBCursor::Next() {
@@ -261,7 +464,9 @@ void CCoinsViewDBCursor::Next() {
 
 bool CBlockTreeDB::WriteBatchSync(
     const std::vector<std::pair<int, const CBlockFileInfo *>> &fileInfo,
-    int nLastFile, const std::vector<const CBlockIndex *> &blockinfo) {
+    int nLastFile, const std::vector<const CBlockIndex *> &blockinfo,
+    const std::vector<std::pair<const CBlockIndex *, const CAuxPow *>>
+        &auxpowinfo) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<int, const CBlockFileInfo *>>::const_iterator
              it = fileInfo.begin();
@@ -275,9 +480,17 @@ bool CBlockTreeDB::WriteBatchSync(
         batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()),
                     CDiskBlockIndex(*it));
     }
+    for (const auto &[pindex, auxpow] : auxpowinfo) {
+        batch.Write(std::make_pair(DB_AUXPOW, pindex->GetBlockHash()),
+                    *auxpow);
+    }
     return WriteBatch(batch, true);
 }
 
+bool CBlockTreeDB::ReadAuxPow(const BlockHash &hash, CAuxPow &auxpow) const {
+    return Read(std::make_pair(DB_AUXPOW, hash), auxpow);
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
     return Write(std::make_pair(DB_FLAG, name),
                  fValue ? uint8_t{'1'} : uint8_t{'0'});
@@ -292,9 +505,17 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+namespace {
+//! The block index entries are read in batches of this many entries.
+static constexpr size_t BLOCK_INDEX_LOAD_BATCH{16384};
+//! Number of headers hashed by each job of a batch.
+static constexpr size_t BLOCK_INDEX_HASH_CHUNK{512};
+} // namespace
+
 bool CBlockTreeDB::LoadBlockIndexGuts(
     const Consensus::Params &params,
-    std::function<CBlockIndex *(const BlockHash &)> insertBlockIndex) {
+    std::function<CBlockIndex *(const BlockHash &)> insertBlockIndex,
+    ValidationThreadPool &pool) {
     AssertLockHeld(::cs_main);
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
@@ -311,43 +532,69 @@ bool CBlockTreeDB::LoadBlockIndexGuts(
 
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
-    // Load m_block_index
-    while (pcursor->Valid()) {
-        if (ShutdownRequested()) {
-            return false;
-        }
-        std::pair<uint8_t, uint256> key;
-        if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX) {
-            break;
-        }
+    // Hashing the headers is the bulk of the work, so the entries are read in
+    // batches and their headers hashed in parallel. They are decoded on this
+    // thread because deserializing a CDiskBlockIndex locks cs_main. The
+    // batches bound the memory used.
+    std::vector<std::pair<BlockHash, CDiskBlockIndex>> entries;
+    entries.reserve(BLOCK_INDEX_LOAD_BATCH);
+    bool done{false};
+    while (!done) {
+        entries.clear();
+        while (entries.size() < BLOCK_INDEX_LOAD_BATCH) {
+            if (ShutdownRequested()) {
+                return false;
+            }
+            std::pair<uint8_t, uint256> key;
+            if (!pcursor->Valid() || !pcursor->GetKey(key) ||
+                key.first != DB_BLOCK_INDEX) {
+                done = true;
+                break;
+            }
 
-        CDiskBlockIndex diskindex;
-        if (!pcursor->GetValue(diskindex)) {
-            return error("%s : failed to read value", __func__);
+            CDiskBlockIndex diskindex;
+            if (!pcursor->GetValue(diskindex)) {
+                return error("%s : failed to read value", __func__);
+            }
+            entries.emplace_back(BlockHash(), std::move(diskindex));
+            pcursor->Next();
         }
 
-        // Construct block index object
-        CBlockIndex *pindexNew =
-            insertBlockIndex(diskindex.ConstructBlockHash());
-        pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
-        pindexNew->nHeight = diskindex.nHeight;
-        pindexNew->nFile = diskindex.nFile;
-        pindexNew->nDataPos = diskindex.nDataPos;
-        pindexNew->nUndoPos = diskindex.nUndoPos;
-        pindexNew->nVersion = diskindex.nVersion;
-        pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-        pindexNew->nTime = diskindex.nTime;
-        pindexNew->nBits = diskindex.nBits;
-        pindexNew->nNonce = diskindex.nNonce;
-        pindexNew->nStatus = diskindex.nStatus;
-        pindexNew->nTx = diskindex.nTx;
-
-        /* Bitcoin checks the PoW here.  We don't do this because
-           the CDiskBlockIndex does not contain the auxpow.
-           This check isn't important, since the data on disk should
-           already be valid and can be trusted.  */
-
-        pcursor->Next();
+        pool.ParallelFor(
+            (entries.size() + BLOCK_INDEX_HASH_CHUNK - 1) /
+                BLOCK_INDEX_HASH_CHUNK,
+            [&](size_t n) {
+                const size_t end{
+                    std::min(entries.size(), (n + 1) * BLOCK_INDEX_HASH_CHUNK)};
+                for (size_t i = n * BLOCK_INDEX_HASH_CHUNK; i < end; ++i) {
+                    entries[i].first = entries[i].second.ConstructBlockHash();
+                }
+            });
+
+        // Load m_block_index
+        for (const auto &[hash, diskindex] : entries) {
+            // Construct block index object
+            CBlockIndex *pindexNew = insertBlockIndex(hash);
+            pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
+            pindexNew->nHeight = diskindex.nHeight;
+            pindexNew->nFile = diskindex.nFile;
+            pindexNew->nDataPos = diskindex.nDataPos;
+            pindexNew->nUndoPos = diskindex.nUndoPos;
+            pindexNew->nVersion = diskindex.nVersion;
+            pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+            pindexNew->nTime = diskindex.nTime;
+            pindexNew->nBits = diskindex.nBits;
+            pindexNew->nNonce = diskindex.nNonce;
+            pindexNew->nStatus = diskindex.nStatus;
+            pindexNew->nScriptFlags = diskindex.nScriptFlags;
+            pindexNew->nTx = diskindex.nTx;
+
+            /* Bitcoin checks the PoW here.  We don't do this because
+               the CDiskBlockIndex does not contain the auxpow (it is
+               stored separately under DB_AUXPOW and only loaded on
+               demand). This check isn't important, since the data on
+               disk should already be valid and can be trusted.  */
+        }
     }
 
     return true;
@@ -11,9 +11,12 @@
 #include <dbwrapper.h>
 #include <flatfile.h>
 #include <kernel/cs_main.h>
+#include <sync.h>
 #include <util/fs.h>
 #include <util/result.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -24,9 +27,11 @@
 #include <vector>
 
 struct BlockHash;
+class CAuxPow;
 class CBlockFileInfo;
 class CBlockIndex;
 class COutPoint;
+class ValidationThreadPool;
 
 namespace Consensus {
 struct Params;
@@ -59,8 +64,13 @@ struct CoinsViewOptions {
     //! If non-zero, randomly exit when the database is flushed with (1/ratio)
     //! probability.
     int simulate_crash_ratio = 0;
+    //! If set, the changes are encoded with the help of the idle threads of
+    //! this pool when written.
+    ValidationThreadPool *write_pool = nullptr;
 };
 
+class CCoinsViewDBSnapshot;
+
 /** CCoinsView backed by the coin database (chainstate/) */
 class CCoinsViewDB final : public CCoinsView {
 protected:
@@ -68,6 +78,27 @@ protected:
     CoinsViewOptions m_options;
     std::unique_ptr<CDBWrapper> m_db;
 
+    //! Incremented before and after writing a batch, so it is odd while the
+    //! database is being written to.
+    std::atomic<uint64_t> m_write_epoch{0};
+
+    //! Whether changes were written back by BatchWritePartial() since the
+    //! database was last consistent with a block.
+    bool m_written_partially{false};
+
+    //! The number of snapshots of m_db not released yet.
+    struct SnapshotCount {
+        Mutex mutex;
+        std::condition_variable cv;
+        int count GUARDED_BY(mutex){0};
+    };
+    mutable SnapshotCount m_snapshots;
+
+    friend class CCoinsViewDBSnapshot;
+
+    bool WriteCoins(CCoinsMap &mapCoins, const BlockHash &hashBlock,
+                    bool erase, bool partial);
+
 public:
     explicit CCoinsViewDB(DBParams db_params, CoinsViewOptions options);
 
@@ -77,14 +108,48 @@ public:
     std::vector<BlockHash> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
                     bool erase = true) override;
+    bool BatchWritePartial(CCoinsMap &mapCoins,
+                           const BlockHash &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
+    std::vector<std::unique_ptr<CCoinsViewCursor>>
+    ShardedCursors(size_t num_shards) const override;
+
+    //! Whether some changes were written back since the database was last
+    //! consistent with a block. Until the next BatchWrite(), the changes must
+    //! only come from blocks connected on top of the previous ones, so the
+    //! database can be recovered from a crash by replaying them.
+    bool IsWrittenPartially() const { return m_written_partially; }
+
+    /**
+     * Write coins straight to the database, without changing the best block.
+     * Used to bulk load a UTXO snapshot: when the coins are sorted with
+     * KeyLess(), LevelDB writes them into tables that do not overlap, which
+     * are hardly compacted, unlike the random order of a cache flush.
+     */
+    bool BulkWrite(const std::vector<std::pair<COutPoint, Coin>> &coins);
+
+    //! Whether the coin at a is before the one at b in the database.
+    static bool KeyLess(const COutPoint &a, const COutPoint &b);
 
     //! Attempt to update from an older database format.
     //! Returns whether an error occurred.
     bool Upgrade();
     size_t EstimateSize() const override;
 
-    //! Dynamically alter the underlying leveldb cache size.
+    //! Coins read while this is even and doesn't change reflect the state of
+    //! the database until it changes again.
+    uint64_t GetWriteEpoch() const { return m_write_epoch.load(); }
+
+    /**
+     * Take a snapshot of the database, whose coins can be read without
+     * cs_main. Combined with the coins cache at the time it is taken, it
+     * gives the full UTXO set at that time.
+     */
+    std::unique_ptr<CCoinsViewDBSnapshot> GetSnapshot() const
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    //! Dynamically alter the underlying leveldb cache size. This waits for
+    //! the snapshots of the database to be released.
     void ResizeCache(size_t new_cache_size) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     //! @returns filesystem path to on-disk storage or std::nullopt if in
@@ -92,6 +157,25 @@ public:
     std::optional<fs::path> StoragePath() { return m_db->StoragePath(); }
 };
 
+/** Read-only view of the coin database as of when the snapshot was taken. */
+class CCoinsViewDBSnapshot {
+public:
+    ~CCoinsViewDBSnapshot();
+
+    bool GetCoin(const COutPoint &outpoint, Coin &coin) const;
+
+private:
+    CCoinsViewDBSnapshot(const CDBWrapper &db,
+                         CCoinsViewDB::SnapshotCount &count)
+        : m_snapshot(std::make_unique<CDBSnapshot>(db)), m_count(count) {}
+
+    std::unique_ptr<CDBSnapshot> m_snapshot;
+    CCoinsViewDB::SnapshotCount &m_count;
+
+    friend class CCoinsViewDB;
+    friend class CCoinsViewDBCursor;
+};
+
 /** Specialization of CCoinsViewCursor to iterate over a CCoinsViewDB */
 class CCoinsViewDBCursor : public CCoinsViewCursor {
 public:
@@ -107,8 +191,17 @@ public:
 private:
     CCoinsViewDBCursor(CDBIterator *pcursorIn, const BlockHash &hashBlockIn)
         : CCoinsViewCursor(hashBlockIn), pcursor(pcursorIn) {}
+    CCoinsViewDBCursor(std::shared_ptr<const CCoinsViewDBSnapshot> snapshot,
+                       const BlockHash &hashBlockIn);
+    //! Keeps the snapshot iterated by a sharded cursor alive.
+    std::shared_ptr<const CCoinsViewDBSnapshot> m_snapshot;
     std::unique_ptr<CDBIterator> pcursor;
     std::pair<char, COutPoint> keyTmp;
+    //! The first txid after the range of a sharded cursor.
+    std::optional<TxId> m_end;
+
+    //! Position at the first coin whose txid is at least begin.
+    void Seek(const TxId &begin);
 
     friend class CCoinsViewDB;
 };
@@ -119,17 +212,24 @@ public:
     using CDBWrapper::CDBWrapper;
     bool WriteBatchSync(
         const std::vector<std::pair<int, const CBlockFileInfo *>> &fileInfo,
-        int nLastFile, const std::vector<const CBlockIndex *> &blockinfo);
+        int nLastFile, const std::vector<const CBlockIndex *> &blockinfo,
+        const std::vector<std::pair<const CBlockIndex *, const CAuxPow *>>
+            &auxpowinfo = {});
+    //! Dogecoin: read the auxpow stored alongside a block index entry, so that
+    //! merge-mined headers can be rebuilt without touching the block files.
+    bool ReadAuxPow(const BlockHash &hash, CAuxPow &auxpow) const;
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo &info);
     bool ReadLastBlockFile(int &nFile);
     bool WriteReindexing(bool fReindexing);
     bool IsReindexing() const;
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    //! Read the block index entries, decoding them with the help of the idle
+    //! threads of the pool.
     bool LoadBlockIndexGuts(
         const Consensus::Params &params,
-        std::function<CBlockIndex *(const BlockHash &)> insertBlockIndex)
-        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+        std::function<CBlockIndex *(const BlockHash &)> insertBlockIndex,
+        ValidationThreadPool &pool) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     ;
 
     //! Attempt to update from an older database format.
@@ -118,12 +118,15 @@ CTxMemPool::CTxMemPool(const Options &opts)
     : m_check_ratio(opts.check_ratio),
       m_orphanage(std::make_unique<TxOrphanage>()),
       m_conflicting(std::make_unique<TxConflicting>()),
+      mapTx{indexed_transaction_set::ctor_args_list{},
+            NodeAllocator{&m_node_resource}},
       m_max_size_bytes{opts.max_size_bytes}, m_expiry{opts.expiry},
       m_min_relay_feerate{opts.min_relay_feerate},
       m_dust_relay_feerate{opts.dust_relay_feerate},
       m_permit_bare_multisig{opts.permit_bare_multisig},
       m_max_datacarrier_bytes{opts.max_datacarrier_bytes},
-      m_require_standard{opts.require_standard} {
+      m_require_standard{opts.require_standard},
+      m_journal_size{opts.journal_size} {
     // lock free clear
     _clear();
 }
@@ -192,11 +195,11 @@ void CTxMemPool::addUnchecked(CTxMemPoolEntryRef entry) {
 }
 
 void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason) {
+    const TxId &txid = (*it)->GetTx().GetId();
+
     // We increment mempool sequence value no matter removal reason
     // even if not directly reported below.
-    uint64_t mempool_sequence = GetAndIncrementSequence();
-
-    const TxId &txid = (*it)->GetTx().GetId();
+    uint64_t mempool_sequence = RecordChange(txid, reason);
 
     if (reason != MemPoolRemovalReason::BLOCK) {
         // Notify clients that a transaction has been removed from the mempool
@@ -328,6 +331,35 @@ void CTxMemPool::removeForFinalizedBlock(
     }
 }
 
+uint64_t
+CTxMemPool::RecordChange(const TxId &txid,
+                         std::optional<MemPoolRemovalReason> removal_reason) {
+    AssertLockHeld(cs);
+    const uint64_t sequence{m_sequence_number++};
+    if (m_journal_size > 0) {
+        if (m_journal.size() >= m_journal_size) {
+            m_journal.pop_front();
+        }
+        m_journal.push_back({sequence, txid, removal_reason});
+    }
+    return sequence;
+}
+
+std::optional<std::vector<MempoolChange>>
+CTxMemPool::GetChangesSince(uint64_t from) const {
+    AssertLockHeld(cs);
+    if (from >= m_sequence_number) {
+        return std::vector<MempoolChange>{};
+    }
+    // The journal ends at m_sequence_number - 1, so this covers it being empty
+    if (m_sequence_number - from > m_journal.size()) {
+        return std::nullopt;
+    }
+    return std::vector<MempoolChange>(m_journal.end() -
+                                          (m_sequence_number - from),
+                                      m_journal.end());
+}
+
 void CTxMemPool::_clear() {
     mapTx.clear();
     mapNextTx.clear();
@@ -506,6 +538,24 @@ std::vector<TxMempoolInfo> CTxMemPool::infoAll() const {
     return ret;
 }
 
+std::vector<std::optional<std::pair<uint64_t, TxMempoolInfo>>>
+CTxMemPool::infoWithEntryIds(const std::vector<TxId> &txids) const {
+    LOCK(cs);
+
+    std::vector<std::optional<std::pair<uint64_t, TxMempoolInfo>>> ret;
+    ret.reserve(txids.size());
+    for (const TxId &txid : txids) {
+        indexed_transaction_set::const_iterator i = mapTx.find(txid);
+        if (i == mapTx.end()) {
+            ret.emplace_back(std::nullopt);
+            continue;
+        }
+        ret.emplace_back(std::in_place, (*i)->GetEntryId(), GetInfo(i));
+    }
+
+    return ret;
+}
+
 CTransactionRef CTxMemPool::get(const TxId &txid) const {
     LOCK(cs);
     indexed_transaction_set::const_iterator i = mapTx.find(txid);
@@ -16,6 +16,7 @@
 #include <policy/packages.h>
 #include <primitives/transaction.h>
 #include <radix.h>
+#include <support/allocators/pool.h>
 #include <sync.h>
 #include <txconflicting.h>
 #include <txorphanage.h>
@@ -28,6 +29,7 @@
 #include <boost/multi_index_container.hpp>
 
 #include <atomic>
+#include <deque>
 #include <map>
 #include <memory>
 #include <optional>
@@ -165,6 +167,14 @@ enum class MemPoolRemovalReason {
 
 const std::string RemovalReasonToString(const MemPoolRemovalReason &r) noexcept;
 
+/** An addition or a removal of a transaction, as kept by the change journal. */
+struct MempoolChange {
+    uint64_t sequence;
+    TxId txid;
+    //! Why the transaction was removed, or std::nullopt if it was added
+    std::optional<MemPoolRemovalReason> removal_reason;
+};
+
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain transactions that
  * may be included in the next block.
@@ -234,6 +244,10 @@ private:
     // is added or removed from the mempool for any reason.
     mutable uint64_t m_sequence_number GUARDED_BY(cs){1};
 
+    //! The most recent changes, oldest first, with consecutive sequence
+    //! numbers ending just before m_sequence_number.
+    std::deque<MempoolChange> m_journal GUARDED_BY(cs);
+
     void trackPackageRemoved(const CFeeRate &rate) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     bool m_load_tried GUARDED_BY(cs){false};
@@ -254,6 +268,15 @@ public:
     // public only for testing
     static const int ROLLING_FEE_HALFLIFE = 60 * 60 * 12;
 
+    /**
+     * The nodes of mapTx, which hold the links of all the indices of an entry,
+     * are allocated from a pool rather than with a malloc each. The size
+     * leaves room for a hashed and three ordered indices.
+     */
+    using NodeAllocator =
+        PoolAllocator<CTxMemPoolEntryRef,
+                      sizeof(CTxMemPoolEntryRef) + 16 * sizeof(void *)>;
+
     typedef boost::multi_index_container<
         CTxMemPoolEntryRef,
         boost::multi_index::indexed_by<
@@ -274,7 +297,8 @@ public:
             boost::multi_index::ordered_unique<
                 boost::multi_index::tag<entry_id>,
                 boost::multi_index::identity<CTxMemPoolEntryRef>,
-                CompareTxMemPoolEntryByEntryId>>>
+                CompareTxMemPoolEntryByEntryId>>,
+        NodeAllocator>
         indexed_transaction_set;
 
     /**
@@ -305,6 +329,12 @@ public:
      * the mempool is consistent with the new chain tip and fully populated.
      */
     mutable RecursiveMutex cs;
+
+private:
+    //! Backs the allocations of mapTx, so must be declared before it.
+    NodeAllocator::ResourceType m_node_resource;
+
+public:
     indexed_transaction_set mapTx GUARDED_BY(cs);
 
     using txiter = indexed_transaction_set::nth_index<0>::type::const_iterator;
@@ -348,6 +378,7 @@ public:
     const bool m_permit_bare_multisig;
     const std::optional<unsigned> m_max_datacarrier_bytes;
     const bool m_require_standard;
+    const size_t m_journal_size;
 
     /**
      * Create a new CTxMemPool.
@@ -518,6 +549,13 @@ public:
     CTransactionRef get(const TxId &txid) const;
     TxMempoolInfo info(const TxId &txid) const;
     std::vector<TxMempoolInfo> infoAll() const;
+    /**
+     * Look up several txs at once. For each of txids, the id of its entry,
+     * which sorts the txs topologically, along with its info; or nullopt if
+     * it is not in the mempool.
+     */
+    std::vector<std::optional<std::pair<uint64_t, TxMempoolInfo>>>
+    infoWithEntryIds(const std::vector<TxId> &txids) const;
 
     CFeeRate estimateFee() const;
 
@@ -548,15 +586,27 @@ public:
         return (m_unbroadcast_txids.count(txid) != 0);
     }
 
-    /** Guards this internal counter for external reporting */
-    uint64_t GetAndIncrementSequence() const EXCLUSIVE_LOCKS_REQUIRED(cs) {
-        return m_sequence_number++;
-    }
+    /**
+     * Use up the sequence number of the addition of a transaction, or of its
+     * removal if removal_reason is set, and record the change in the journal.
+     */
+    uint64_t RecordChange(
+        const TxId &txid,
+        std::optional<MemPoolRemovalReason> removal_reason = std::nullopt)
+        EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     uint64_t GetSequence() const EXCLUSIVE_LOCKS_REQUIRED(cs) {
         return m_sequence_number;
     }
 
+    /**
+     * Get the changes with a sequence number of at least from, oldest first.
+     * Returns std::nullopt if some of them are no longer in the journal, in
+     * which case the caller has to resync from the whole mempool.
+     */
+    std::optional<std::vector<MempoolChange>>
+    GetChangesSince(uint64_t from) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     template <typename Callable>
     auto withOrphanage(Callable &&func) const
         EXCLUSIVE_LOCKS_REQUIRED(!cs_orphanage) {
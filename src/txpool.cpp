@@ -91,6 +91,19 @@ int TxPool::EraseTxNoLock(const TxId &txid) {
     return 1;
 }
 
+template <typename Callable>
+void TxPool::ForEachOutputSpenders(const CTransaction &tx,
+                                   Callable &&func) const {
+    AssertLockHeld(m_mutex);
+    const TxId &txid = tx.GetId();
+    for (auto it = m_outpoint_to_tx_it.lower_bound(COutPoint(txid, 0));
+         it != m_outpoint_to_tx_it.end() && it->first.GetTxId() == txid &&
+         it->first.GetN() < tx.vout.size();
+         ++it) {
+        func(it->second);
+    }
+}
+
 void TxPool::EraseForPeer(NodeId peer) {
     LOCK(m_mutex);
 
@@ -151,24 +164,19 @@ unsigned int TxPool::LimitTxs(unsigned int max_txs, FastRandomContext &rng) {
 void TxPool::AddChildrenToWorkSet(const CTransaction &tx) {
     LOCK(m_mutex);
 
-    for (size_t i = 0; i < tx.vout.size(); i++) {
-        const auto it_by_prev =
-            m_outpoint_to_tx_it.find(COutPoint(tx.GetId(), i));
-        if (it_by_prev != m_outpoint_to_tx_it.end()) {
-            for (const auto &elem : it_by_prev->second) {
-                // Get this peer's work set, emplacing an empty set if it didn't
-                // exist
-                std::set<TxId> &work_set =
-                    m_peer_work_set.try_emplace(elem->second.fromPeer)
-                        .first->second;
-                // Add this tx to the work set
-                work_set.insert(elem->first);
-                LogPrint(BCLog::TXPACKAGES,
-                         "added %s tx %s to peer %d workset\n", txKind,
-                         tx.GetId().ToString(), elem->second.fromPeer);
-            }
+    ForEachOutputSpenders(tx, [&](const auto &spenders) {
+        for (const auto &elem : spenders) {
+            // Get this peer's work set, emplacing an empty set if it didn't
+            // exist
+            std::set<TxId> &work_set =
+                m_peer_work_set.try_emplace(elem->second.fromPeer)
+                    .first->second;
+            // Add this tx to the work set
+            work_set.insert(elem->first);
+            LogPrint(BCLog::TXPACKAGES, "added %s tx %s to peer %d workset\n",
+                     txKind, tx.GetId().ToString(), elem->second.fromPeer);
         }
-    }
+    });
 }
 
 bool TxPool::HaveTx(const TxId &txid) const {
@@ -284,17 +292,13 @@ TxPool::GetChildrenFromSamePeer(const CTransactionRef &parent,
 
     // For each output, get all entries spending this prevout, filtering for
     // ones from the specified peer.
-    for (unsigned int i = 0; i < parent->vout.size(); i++) {
-        const auto it_by_prev =
-            m_outpoint_to_tx_it.find(COutPoint(parent->GetId(), i));
-        if (it_by_prev != m_outpoint_to_tx_it.end()) {
-            for (const auto &elem : it_by_prev->second) {
-                if (elem->second.fromPeer == nodeid) {
-                    iters.emplace_back(elem);
-                }
+    ForEachOutputSpenders(*parent, [&](const auto &spenders) {
+        for (const auto &elem : spenders) {
+            if (elem->second.fromPeer == nodeid) {
+                iters.emplace_back(elem);
             }
         }
-    }
+    });
 
     // Sort by address so that duplicates can be deleted. At the same time, sort
     // so that more recent txs (which expire later) come first. Break ties
@@ -329,17 +333,13 @@ TxPool::GetChildrenFromDifferentPeer(const CTransactionRef &parent,
 
     // For each output, get all entries spending this prevout, filtering for
     // ones not from the specified peer.
-    for (unsigned int i = 0; i < parent->vout.size(); i++) {
-        const auto it_by_prev =
-            m_outpoint_to_tx_it.find(COutPoint(parent->GetId(), i));
-        if (it_by_prev != m_outpoint_to_tx_it.end()) {
-            for (const auto &elem : it_by_prev->second) {
-                if (elem->second.fromPeer != nodeid) {
-                    iters.emplace_back(elem);
-                }
+    ForEachOutputSpenders(*parent, [&](const auto &spenders) {
+        for (const auto &elem : spenders) {
+            if (elem->second.fromPeer != nodeid) {
+                iters.emplace_back(elem);
             }
         }
-    }
+    });
 
     // Erase duplicates
     std::sort(iters.begin(), iters.end(), IteratorComparator());
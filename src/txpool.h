@@ -146,6 +146,15 @@ protected:
     /** Erase a transaction by txid */
     int EraseTxNoLock(const TxId &txid) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
 
+    /**
+     * Call func with the pool txs spending each output of tx that some do.
+     * The outpoints are sorted by txid first, so those of tx are found with a
+     * single lookup rather than one per output.
+     */
+    template <typename Callable>
+    void ForEachOutputSpenders(const CTransaction &tx, Callable &&func) const
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
     /** Timestamp for the next scheduled sweep of expired transactions */
     NodeSeconds m_next_sweep GUARDED_BY(m_mutex){0s};
 };
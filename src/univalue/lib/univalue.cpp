@@ -5,6 +5,7 @@
 
 #include <univalue.h>
 
+#include <charconv>
 #include <iomanip>
 #include <map>
 #include <memory>
@@ -53,20 +54,26 @@ void UniValue::setNumStr(std::string str) {
     val = std::move(str);
 }
 
-void UniValue::setInt(uint64_t val_) {
-    std::ostringstream oss;
-
-    oss << val_;
+template <typename Int> static std::string FormatInt(Int val_) {
+    // Large enough for any 64 bits integer, sign included.
+    char buf[24];
+    const auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), val_);
+    (void)ec;
+    return std::string(buf, end);
+}
 
-    return setNumStr(oss.str());
+// An integer is always a valid JSON number, so there is no need for setNumStr
+// to parse it back.
+void UniValue::setInt(uint64_t val_) {
+    clear();
+    typ = VNUM;
+    val = FormatInt(val_);
 }
 
 void UniValue::setInt(int64_t val_) {
-    std::ostringstream oss;
-
-    oss << val_;
-
-    return setNumStr(oss.str());
+    clear();
+    typ = VNUM;
+    val = FormatInt(val_);
 }
 
 void UniValue::setFloat(double val_) {
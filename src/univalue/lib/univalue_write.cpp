@@ -44,17 +44,19 @@ struct UniValueStreamWriter {
 };
 
 void UniValueStreamWriter::escapeJson(const std::string &inS) {
+    // Most strings, such as hex data and hashes, need no escaping at all.
+    // Copy the runs of characters that don't need escaping in one go.
     size_t len = inS.length();
+    size_t run_start = 0;
     for (size_t i = 0; i < len; i++) {
-        const char ch = inS[i];
-        const char *const escStr = escapes[uint8_t(ch)];
-
+        const char *const escStr = escapes[uint8_t(inS[i])];
         if (escStr) {
+            str.append(inS, run_start, i - run_start);
             write(escStr);
-        } else {
-            put(ch);
+            run_start = i + 1;
         }
     }
+    str.append(inS, run_start, len - run_start);
 }
 
 void UniValueStreamWriter::writeAny(unsigned int prettyIndent,
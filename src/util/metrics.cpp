@@ -0,0 +1,201 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/metrics.h>
+
+#include <crypto/common.h>
+#include <sync.h>
+#include <tinyformat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace metrics {
+
+size_t Histogram::BucketIndex(uint64_t value) {
+    value = std::min(value, MAX_VALUE);
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+    // The position of the highest set bit is at least SUB_BUCKET_BITS
+    const int shift = CountBits(value) - 1 - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint64_t Histogram::BucketMax(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const int shift = index / SUB_BUCKETS - 1;
+    const uint64_t sub{index % SUB_BUCKETS};
+    return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void Histogram::Record(uint64_t value) {
+    value = std::min(value, MAX_VALUE);
+    m_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max{m_max.load(std::memory_order_relaxed)};
+    while (value > max && !m_max.compare_exchange_weak(
+                              max, value, std::memory_order_relaxed)) {
+    }
+}
+
+Histogram::Snapshot Histogram::GetSnapshot() const {
+    // The values recorded meanwhile may only be partly accounted for, which
+    // is fine for monitoring.
+    Snapshot snapshot;
+    snapshot.count = m_count.load(std::memory_order_relaxed);
+    snapshot.sum = m_sum.load(std::memory_order_relaxed);
+    snapshot.max = m_max.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+uint64_t Histogram::Snapshot::Quantile(double q) const {
+    uint64_t total{0};
+    for (uint64_t bucket : buckets) {
+        total += bucket;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    const uint64_t rank{std::clamp<uint64_t>(std::ceil(q * total), 1, total)};
+    uint64_t seen{0};
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(BucketMax(i), max);
+        }
+    }
+    return max;
+}
+
+namespace {
+template <typename Metric> struct Entry {
+    std::string help;
+    Label label;
+    Metric metric;
+
+    Entry(const std::string &help_in, const Label &label_in)
+        : help{help_in}, label{label_in} {}
+};
+
+template <typename Metric> struct Registry {
+    Mutex mutex;
+    //! Keyed by name and label value. The map never moves the entries.
+    std::map<std::pair<std::string, std::string>, Entry<Metric>>
+        entries GUARDED_BY(mutex);
+
+    Metric &Get(const std::string &name, const std::string &help,
+                const Label &label) EXCLUSIVE_LOCKS_REQUIRED(!mutex) {
+        LOCK(mutex);
+        return entries.try_emplace({name, label.value}, help, label)
+            .first->second.metric;
+    }
+
+    template <typename Func>
+    void ForEach(const Func &func) EXCLUSIVE_LOCKS_REQUIRED(!mutex) {
+        LOCK(mutex);
+        for (const auto &[key, entry] : entries) {
+            func(key.first, entry.help, entry.label, entry.metric);
+        }
+    }
+};
+
+// Constructed on first use, so the metrics can be registered during static
+// initialization.
+Registry<Counter> &Counters() {
+    static Registry<Counter> registry;
+    return registry;
+}
+
+Registry<Histogram> &Histograms() {
+    static Registry<Histogram> registry;
+    return registry;
+}
+} // namespace
+
+Counter &GetCounter(const std::string &name, const std::string &help,
+                    const Label &label) {
+    return Counters().Get(name, help, label);
+}
+
+Histogram &GetHistogram(const std::string &name, const std::string &help,
+                        const Label &label) {
+    return Histograms().Get(name, help, label);
+}
+
+void ForEachCounter(
+    const std::function<void(const std::string &name, const std::string &help,
+                             const Label &label, const Counter &)> &func) {
+    Counters().ForEach(func);
+}
+
+void ForEachHistogram(
+    const std::function<void(const std::string &name, const std::string &help,
+                             const Label &label, const Histogram &)> &func) {
+    Histograms().ForEach(func);
+}
+
+std::string FormatPrometheus(const std::string &prefix) {
+    std::string out;
+    std::string last_name;
+    auto format_labels = [](const Label &label,
+                            const std::string &quantile = "") {
+        std::string labels;
+        if (!label.name.empty()) {
+            labels = strprintf("%s=\"%s\"", label.name, label.value);
+        }
+        if (!quantile.empty()) {
+            labels += strprintf("%squantile=\"%s\"", labels.empty() ? "" : ",",
+                                quantile);
+        }
+        return labels.empty() ? labels : "{" + labels + "}";
+    };
+
+    ForEachCounter([&](const std::string &name, const std::string &help,
+                       const Label &label, const Counter &counter) {
+        const std::string full_name{prefix + name};
+        if (full_name != last_name) {
+            out += strprintf("# HELP %s %s\n# TYPE %s counter\n", full_name,
+                             help, full_name);
+            last_name = full_name;
+        }
+        out += strprintf("%s%s %u\n", full_name, format_labels(label),
+                         counter.Get());
+    });
+
+    last_name.clear();
+    ForEachHistogram([&](const std::string &name, const std::string &help,
+                         const Label &label, const Histogram &histogram) {
+        const std::string full_name{prefix + name + "_seconds"};
+        if (full_name != last_name) {
+            out += strprintf("# HELP %s %s\n# TYPE %s summary\n", full_name,
+                             help, full_name);
+            last_name = full_name;
+        }
+        const Histogram::Snapshot snapshot{histogram.GetSnapshot()};
+        for (const auto &[q, q_str] : {std::make_pair(0.5, "0.5"),
+                                       std::make_pair(0.9, "0.9"),
+                                       std::make_pair(0.99, "0.99")}) {
+            out += strprintf("%s%s %.6f\n", full_name,
+                             format_labels(label, q_str),
+                             snapshot.Quantile(q) / 1e6);
+        }
+        out += strprintf("%s_sum%s %.6f\n", full_name, format_labels(label),
+                         snapshot.sum / 1e6);
+        out += strprintf("%s_count%s %u\n", full_name, format_labels(label),
+                         snapshot.count);
+    });
+    return out;
+}
+
+} // namespace metrics
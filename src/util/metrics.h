@@ -0,0 +1,130 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_METRICS_H
+#define BITCOIN_UTIL_METRICS_H
+
+#include <util/time.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * Performance metrics that are always collected, so they can be watched in
+ * production without turning on the debug logs. Recording a value only takes
+ * a few relaxed atomic operations; the metrics are registered by name once and
+ * the call sites keep a reference to them.
+ */
+namespace metrics {
+
+/** A monotonic counter. */
+class Counter {
+public:
+    void Add(uint64_t value = 1) {
+        m_value.fetch_add(value, std::memory_order_relaxed);
+    }
+    uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+/**
+ * A histogram of durations in microseconds, with log-linear buckets as in an
+ * HDR histogram: the values below 2^SUB_BUCKET_BITS have a bucket each, then
+ * every power of 2 range is split into 2^SUB_BUCKET_BITS buckets, so the
+ * percentiles are within 1/2^SUB_BUCKET_BITS of the recorded values.
+ */
+class Histogram {
+public:
+    static constexpr int SUB_BUCKET_BITS{4};
+    static constexpr uint64_t SUB_BUCKETS{uint64_t{1} << SUB_BUCKET_BITS};
+    //! Larger values (over 12 days) are recorded as this.
+    static constexpr uint64_t MAX_VALUE{(uint64_t{1} << 40) - 1};
+    static constexpr size_t NUM_BUCKETS{(40 - SUB_BUCKET_BITS + 1) *
+                                        SUB_BUCKETS};
+
+    struct Snapshot {
+        uint64_t count{0};
+        uint64_t sum{0};
+        uint64_t max{0};
+        std::array<uint64_t, NUM_BUCKETS> buckets{};
+
+        /** The value below which the fraction q of the values are. */
+        uint64_t Quantile(double q) const;
+    };
+
+    void Record(uint64_t value);
+    void Record(std::chrono::microseconds duration) {
+        Record(uint64_t(std::max<int64_t>(0, duration.count())));
+    }
+    Snapshot GetSnapshot() const;
+
+    static size_t BucketIndex(uint64_t value);
+    /** The highest value recorded in the bucket. */
+    static uint64_t BucketMax(size_t index);
+
+private:
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> m_buckets{};
+};
+
+/** Record the lifetime of the timer into a histogram. */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram &histogram)
+        : m_histogram{histogram}, m_start{SteadyClock::now()} {}
+    ~ScopedTimer() {
+        m_histogram.Record(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                SteadyClock::now() - m_start));
+    }
+
+private:
+    Histogram &m_histogram;
+    const SteadyClock::time_point m_start;
+};
+
+/** Distinguishes the metrics of the same name, e.g. by message type. */
+struct Label {
+    std::string name;
+    std::string value;
+};
+
+/**
+ * Get the counter registered under this name and label, registering it if
+ * needed. The returned reference stays valid for the lifetime of the program.
+ */
+Counter &GetCounter(const std::string &name, const std::string &help,
+                    const Label &label = {});
+/** Get the histogram registered under this name and label, see GetCounter. */
+Histogram &GetHistogram(const std::string &name, const std::string &help,
+                        const Label &label = {});
+
+/** Call func for all the counters, ordered by name then label. */
+void ForEachCounter(
+    const std::function<void(const std::string &name, const std::string &help,
+                             const Label &label, const Counter &)> &func);
+/** Call func for all the histograms, ordered by name then label. */
+void ForEachHistogram(
+    const std::function<void(const std::string &name, const std::string &help,
+                             const Label &label, const Histogram &)> &func);
+
+/**
+ * Format all the metrics in the Prometheus text exposition format, the
+ * histograms as summaries in seconds. The metric names get the prefix.
+ */
+std::string FormatPrometheus(const std::string &prefix);
+
+} // namespace metrics
+
+#endif // BITCOIN_UTIL_METRICS_H
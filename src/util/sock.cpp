@@ -12,6 +12,8 @@
 #include <util/syserror.h>
 #include <util/time.h>
 
+#include <algorithm>
+#include <array>
 #include <codecvt>
 #include <cwchar>
 #include <locale>
@@ -23,6 +25,10 @@
 #include <poll.h>
 #endif
 
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
+
 static inline bool IOErrorIsPermanent(int err) {
     return err != WSAEAGAIN && err != WSAEINTR && err != WSAEWOULDBLOCK &&
            err != WSAEINPROGRESS;
@@ -66,6 +72,27 @@ ssize_t Sock::Send(const void *data, size_t len, int flags) const {
     return send(m_socket, static_cast<const char *>(data), len, flags);
 }
 
+ssize_t Sock::SendMany(Span<const Span<const uint8_t>> buffers,
+                       int flags) const {
+    if (buffers.empty()) {
+        return 0;
+    }
+#ifdef WIN32
+    return Send(buffers[0].data(), buffers[0].size(), flags);
+#else
+    std::array<iovec, MAX_SEND_BUFFERS> iov;
+    const size_t count{std::min(buffers.size(), iov.size())};
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = const_cast<uint8_t *>(buffers[i].data());
+        iov[i].iov_len = buffers[i].size();
+    }
+    msghdr msg{};
+    msg.msg_iov = iov.data();
+    msg.msg_iovlen = count;
+    return sendmsg(m_socket, &msg, flags);
+#endif
+}
+
 ssize_t Sock::Recv(void *buf, size_t len, int flags) const {
     return recv(m_socket, static_cast<char *>(buf), len, flags);
 }
@@ -6,6 +6,7 @@
 #define BITCOIN_UTIL_SOCK_H
 
 #include <compat.h>
+#include <span.h>
 #include <threadinterrupt.h>
 #include <util/time.h>
 
@@ -92,6 +93,19 @@ public:
      */
     virtual ssize_t Send(const void *data, size_t len, int flags) const;
 
+    /** The maximum number of buffers sent at once by SendMany(). */
+    static constexpr size_t MAX_SEND_BUFFERS{64};
+
+    /**
+     * sendmsg(2) wrapper, sending the buffers in one system call as if they
+     * were contiguous. Only the first `MAX_SEND_BUFFERS` buffers are sent, and
+     * only the first one on systems without scatter-gather writes.
+     * Code that uses this wrapper can be unit tested if this method is
+     * overridden by a mock Sock implementation.
+     */
+    virtual ssize_t SendMany(Span<const Span<const uint8_t>> buffers,
+                             int flags) const;
+
     /**
      * recv(2) wrapper. Equivalent to `recv(this->Get(), buf, len, flags);`.
      * Code that uses this wrapper can be unit tested if this method is
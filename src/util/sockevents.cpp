@@ -0,0 +1,127 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/sockevents.h>
+
+#include <util/time.h>
+
+#include <array>
+#include <cerrno>
+
+#if defined(USE_EPOLL)
+#include <sys/epoll.h>
+#include <unistd.h>
+#elif defined(USE_KQUEUE)
+#include <sys/event.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+/** The maximum number of events fetched by a single wait. */
+static constexpr size_t MAX_WAIT_EVENTS{256};
+
+SockEvents::SockEvents() {
+#if defined(USE_EPOLL)
+    m_fd = epoll_create1(EPOLL_CLOEXEC);
+#elif defined(USE_KQUEUE)
+    m_fd = kqueue();
+#endif
+}
+
+SockEvents::~SockEvents() {
+#if defined(USE_EPOLL) || defined(USE_KQUEUE)
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+#endif
+}
+
+bool SockEvents::Add(const Sock &sock, Sock::Event requested, uintptr_t tag,
+                     bool edge_triggered) {
+    if (!IsValid() || sock.Get() == INVALID_SOCKET) {
+        return false;
+    }
+#if defined(USE_EPOLL)
+    epoll_event event{};
+    event.events =
+        (edge_triggered ? uint32_t{EPOLLET} : 0u) |
+        (requested & Sock::RECV ? uint32_t{EPOLLIN | EPOLLRDHUP} : 0u) |
+        (requested & Sock::SEND ? uint32_t{EPOLLOUT} : 0u);
+    event.data.u64 = tag;
+    return epoll_ctl(m_fd, EPOLL_CTL_ADD, sock.Get(), &event) == 0;
+#elif defined(USE_KQUEUE)
+    std::array<struct kevent, 2> changes;
+    int num_changes{0};
+    const auto flags = EV_ADD | (edge_triggered ? EV_CLEAR : 0);
+    if (requested & Sock::RECV) {
+        EV_SET(&changes[num_changes++], sock.Get(), EVFILT_READ, flags, 0, 0,
+               reinterpret_cast<void *>(tag));
+    }
+    if (requested & Sock::SEND) {
+        EV_SET(&changes[num_changes++], sock.Get(), EVFILT_WRITE, flags, 0, 0,
+               reinterpret_cast<void *>(tag));
+    }
+    return kevent(m_fd, changes.data(), num_changes, nullptr, 0, nullptr) == 0;
+#else
+    return false;
+#endif
+}
+
+bool SockEvents::Wait(std::chrono::milliseconds timeout,
+                      std::vector<Occurred> &occurred) {
+    occurred.clear();
+    if (!IsValid()) {
+        return false;
+    }
+#if defined(USE_EPOLL)
+    std::array<epoll_event, MAX_WAIT_EVENTS> events;
+    const int num_events{epoll_wait(m_fd, events.data(), events.size(),
+                                    count_milliseconds(timeout))};
+    if (num_events < 0) {
+        return errno == EINTR;
+    }
+    for (int i = 0; i < num_events; ++i) {
+        Sock::Event what{0};
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP)) {
+            what |= Sock::RECV;
+        }
+        if (events[i].events & EPOLLOUT) {
+            what |= Sock::SEND;
+        }
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            what |= Sock::ERR;
+        }
+        occurred.push_back({uintptr_t(events[i].data.u64), what});
+    }
+    return true;
+#elif defined(USE_KQUEUE)
+    std::array<struct kevent, MAX_WAIT_EVENTS> events;
+    const timespec ts{
+        .tv_sec = time_t(count_milliseconds(timeout) / 1000),
+        .tv_nsec = long(count_milliseconds(timeout) % 1000 * 1000000)};
+    const int num_events{
+        kevent(m_fd, nullptr, 0, events.data(), events.size(), &ts)};
+    if (num_events < 0) {
+        return errno == EINTR;
+    }
+    for (int i = 0; i < num_events; ++i) {
+        Sock::Event what{0};
+        if (events[i].filter == EVFILT_READ) {
+            what |= Sock::RECV;
+        }
+        if (events[i].filter == EVFILT_WRITE) {
+            what |= Sock::SEND;
+        }
+        if (events[i].flags & (EV_EOF | EV_ERROR)) {
+            what |= Sock::ERR;
+        }
+        occurred.push_back(
+            {reinterpret_cast<uintptr_t>(events[i].udata), what});
+    }
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_SOCKEVENTS_H
+#define BITCOIN_UTIL_SOCKEVENTS_H
+
+#include <util/sock.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#if defined(__linux__)
+#define USE_EPOLL
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) ||     \
+    defined(__OpenBSD__) || defined(__DragonFly__)
+#define USE_KQUEUE
+#endif
+
+/**
+ * Wait for the events of a persistent set of sockets, with epoll(7) on Linux
+ * and kqueue(2) on the BSDs and macOS.
+ *
+ * Unlike with `Sock::WaitMany()`, the sockets are registered once rather than
+ * for every wait, and only the ones on which something happened are reported,
+ * so waiting costs the same for a handful or for thousands of sockets.
+ * A socket is unregistered when it is closed.
+ */
+class SockEvents {
+public:
+    /** An event reported for the socket registered with the tag. */
+    struct Occurred {
+        uintptr_t tag;
+        Sock::Event events;
+    };
+
+    SockEvents();
+    ~SockEvents();
+
+    SockEvents(const SockEvents &) = delete;
+    SockEvents &operator=(const SockEvents &) = delete;
+
+    /** Whether this platform is supported and the event queue was created. */
+    bool IsValid() const { return m_fd >= 0; }
+
+    /**
+     * Start reporting the events of a socket.
+     * @param[in] sock The socket, it must outlive the registration.
+     * @param[in] requested Bitwise-or of `Sock::RECV` and `Sock::SEND`.
+     * @param[in] tag Reported along with the events of this socket.
+     * @param[in] edge_triggered Report that the socket became readable or
+     *     writable only once, rather than for as long as it stays so. It is
+     *     then up to the caller to keep reading or writing until the socket
+     *     would block.
+     * @return false on failure, the socket is then not registered.
+     */
+    bool Add(const Sock &sock, Sock::Event requested, uintptr_t tag,
+             bool edge_triggered);
+
+    /**
+     * Wait until events occur on some of the sockets.
+     * @param[in] timeout Wait this long at most.
+     * @param[out] occurred The events, with possibly several entries for the
+     *     same socket. Empty on timeout.
+     * @return false on failure.
+     */
+    bool Wait(std::chrono::milliseconds timeout,
+              std::vector<Occurred> &occurred);
+
+private:
+    /** The epoll or kqueue file descriptor. */
+    int m_fd{-1};
+};
+
+#endif // BITCOIN_UTIL_SOCKEVENTS_H
@@ -84,23 +84,31 @@ bool IsHexNumber(std::string_view str) {
 
 template <typename Byte>
 std::optional<std::vector<Byte>> TryParseHex(std::string_view str) {
-    std::vector<Byte> vch;
+    // Hex strings seldom contain spaces, so this is usually the exact size and
+    // the bytes are written without any reallocation.
+    std::vector<Byte> vch(str.size() / 2);
+    size_t size = 0;
     auto it = str.begin();
     while (it != str.end()) {
-        if (IsSpace(*it)) {
+        const signed char c1 = HexDigit(*it);
+        if (c1 < 0) {
+            // Only check for spaces when the character isn't a hex digit.
+            if (!IsSpace(*it)) {
+                return std::nullopt;
+            }
             ++it;
             continue;
         }
-        auto c1 = HexDigit(*(it++));
-        if (it == str.end()) {
+        if (++it == str.end()) {
             return std::nullopt;
         }
-        auto c2 = HexDigit(*(it++));
-        if (c1 < 0 || c2 < 0) {
+        const signed char c2 = HexDigit(*(it++));
+        if (c2 < 0) {
             return std::nullopt;
         }
-        vch.push_back(Byte(c1 << 4) | Byte(c2));
+        vch[size++] = Byte(c1 << 4) | Byte(c2);
     }
+    vch.resize(size);
     return vch;
 }
 template std::vector<std::byte> ParseHex(std::string_view);
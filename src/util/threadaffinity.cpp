@@ -0,0 +1,99 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/threadaffinity.h>
+
+#include <logging.h>
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/strencodings.h>
+#include <util/string.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+
+namespace util {
+
+namespace {
+//! The highest CPU number that can be pinned to, as for a cpu_set_t.
+constexpr int MAX_CPU{1023};
+
+struct Affinity {
+    std::string cpus;
+    std::vector<int> cpu_numbers;
+};
+
+Mutex g_affinities_mutex;
+std::map<std::string, Affinity> g_affinities GUARDED_BY(g_affinities_mutex);
+std::vector<std::pair<std::string, std::string>>
+    g_pinned GUARDED_BY(g_affinities_mutex);
+} // namespace
+
+bool ThreadAffinitySupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool AddThreadAffinity(const std::string &name, const std::string &cpus,
+                       std::string &error) {
+    Affinity affinity{cpus, {}};
+    for (const std::string &range : SplitString(cpus, ',')) {
+        const std::vector<std::string> bounds{SplitString(range, '-')};
+        int32_t first, last;
+        if (bounds.size() > 2 || !ParseInt32(bounds.front(), &first) ||
+            !ParseInt32(bounds.back(), &last) || first < 0 || first > last ||
+            last > MAX_CPU) {
+            error = strprintf("Invalid CPUs for thread %s: %s", name, cpus);
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            affinity.cpu_numbers.push_back(cpu);
+        }
+    }
+
+    LOCK(g_affinities_mutex);
+    g_affinities[name] = std::move(affinity);
+    return true;
+}
+
+void ApplyThreadAffinity(const std::string &name) {
+    LOCK(g_affinities_mutex);
+    auto it = g_affinities.find(name);
+    if (it == g_affinities.end()) {
+        // The numbered threads are pinned by their common name.
+        it = g_affinities.find(name.substr(0, name.rfind('.')));
+    }
+    if (it == g_affinities.end()) {
+        return;
+    }
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : it->second.cpu_numbers) {
+        CPU_SET(cpu, &set);
+    }
+    // On Linux, pid 0 sets the affinity of the calling thread only.
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        LogPrintf("Failed to pin thread %s to CPUs %s: %s\n", name,
+                  it->second.cpus, std::strerror(errno));
+        return;
+    }
+    g_pinned.emplace_back(name, it->second.cpus);
+#endif
+}
+
+std::vector<std::pair<std::string, std::string>> GetThreadAffinities() {
+    LOCK(g_affinities_mutex);
+    return g_pinned;
+}
+
+} // namespace util
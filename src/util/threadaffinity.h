@@ -0,0 +1,32 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_THREADAFFINITY_H
+#define BITCOIN_UTIL_THREADAFFINITY_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace util {
+//! Whether threads can be pinned to CPUs on this platform.
+bool ThreadAffinitySupported();
+
+//! Pin the threads named name, or name.<n> for the numbered ones like the
+//! script check workers, to cpus: CPU numbers and ranges like "0-3,8". Only
+//! meant to be called at startup, before the threads are started.
+//! @returns false with error set if cpus can not be parsed.
+bool AddThreadAffinity(const std::string &name, const std::string &cpus,
+                       std::string &error);
+
+//! Pin the calling thread, named name, if a thread affinity applies to it.
+//! Called by ThreadRename().
+void ApplyThreadAffinity(const std::string &name);
+
+//! The threads that got pinned, with the CPUs they are pinned to.
+std::vector<std::pair<std::string, std::string>> GetThreadAffinities();
+
+} // namespace util
+
+#endif // BITCOIN_UTIL_THREADAFFINITY_H
@@ -8,6 +8,8 @@
 
 #include <util/threadnames.h>
 
+#include <util/threadaffinity.h>
+
 #if (defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__DragonFly__))
 #include <pthread.h>
 #include <pthread_np.h>
@@ -47,6 +49,7 @@ static void SetInternalName(std::string name) {
 
 void util::ThreadRename(std::string &&name) {
     SetThreadName(("b-" + name).c_str());
+    ApplyThreadAffinity(name);
     SetInternalName(std::move(name));
 }
 
@@ -110,6 +110,27 @@ int64_t GetTime() {
     return GetTime<std::chrono::seconds>().count();
 }
 
+std::chrono::microseconds GetThreadCPUTime() {
+#ifdef WIN32
+    FILETIME creation, exit, kernel, user;
+    if (GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        // In units of 100 nanoseconds
+        const uint64_t ticks{
+            ((uint64_t{kernel.dwHighDateTime} << 32) | kernel.dwLowDateTime) +
+            ((uint64_t{user.dwHighDateTime} << 32) | user.dwLowDateTime)};
+        return std::chrono::microseconds{ticks / 10};
+    }
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return std::chrono::seconds{ts.tv_sec} +
+               std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::nanoseconds{ts.tv_nsec});
+    }
+#endif
+    return 0us;
+}
+
 std::string FormatISO8601DateTime(int64_t nTime) {
     struct tm ts;
     time_t time_val = nTime;
@@ -88,6 +88,12 @@ int64_t GetTimeMillis();
 /** Returns the system time (not mockable) */
 int64_t GetTimeMicros();
 
+/**
+ * Returns the CPU time used by the calling thread, or zero on the platforms
+ * where it is not available.
+ */
+std::chrono::microseconds GetThreadCPUTime();
+
 /**
  * DEPRECATED
  * Use SetMockTime with chrono type
@@ -27,11 +27,14 @@
 #include <consensus/tx_check.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <crypto/scrypt.h>
 #include <hash.h>
+#include <inputfetcher.h>
 #include <kernel/notifications_interface.h>
 #include <logging.h>
 #include <logging/timer.h>
 #include <minerfund.h>
+#include <node/blockcompression.h>
 #include <node/blockstorage.h>
 #include <node/utxo_snapshot.h>
 #include <policy/block/minerfund.h>
@@ -42,6 +45,7 @@
 #include <policy/settings.h>
 #include <pow/auxpow.h>
 #include <pow/pow.h>
+#include <pow/powcache.h>
 #include <primitives/auxpow.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
@@ -59,12 +63,14 @@
 #include <util/check.h> // For NDEBUG compile time check
 #include <util/fs.h>
 #include <util/fs_helpers.h>
+#include <util/metrics.h>
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/time.h>
 #include <util/trace.h>
 #include <util/translation.h>
 #include <validationinterface.h>
+#include <validationthreadpool.h>
 #include <warnings.h>
 
 #include <algorithm>
@@ -74,6 +80,7 @@
 #include <deque>
 #include <numeric>
 #include <optional>
+#include <set>
 #include <string>
 #include <thread>
 
@@ -290,6 +297,22 @@ static bool CheckInputsFromMempoolAndCache(
                              /*scriptCacheStore=*/true, txdata, nSigChecksOut);
 }
 
+/**
+ * Transactions with at least this many inputs have their input scripts
+ * verified on the script check queue when entering the mempool.
+ */
+static constexpr size_t MIN_PARALLEL_MEMPOOL_SCRIPT_INPUTS{16};
+
+/**
+ * Verify the input scripts of a transaction on the script check queue, so the
+ * signatures are in the signature cache by the time CheckInputScripts() runs
+ * on the calling thread. The outcome is left to CheckInputScripts(), which
+ * classifies failures.
+ */
+static void PrecheckInputScriptsInParallel(
+    const CTransaction &tx, const CCoinsViewCache &view, uint32_t flags,
+    const PrecomputedTransactionData &txdata) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 namespace {
 
 class MemPoolAccept {
@@ -741,6 +764,10 @@ bool MemPoolAccept::PreChecks(ATMPArgs &args, Workspace &ws) {
         scriptVerifyFlags |= STANDARD_SCRIPT_VERIFY_FLAGS;
     }
     ws.m_precomputed_txdata = PrecomputedTransactionData{tx};
+    if (tx.vin.size() >= MIN_PARALLEL_MEMPOOL_SCRIPT_INPUTS) {
+        PrecheckInputScriptsInParallel(tx, m_view, scriptVerifyFlags,
+                                       ws.m_precomputed_txdata);
+    }
     if (!CheckInputScripts(tx, state, m_view, scriptVerifyFlags, true, false,
                            ws.m_precomputed_txdata, ws.m_sig_checks_standard)) {
         // State filled in by CheckInputScripts
@@ -947,7 +974,7 @@ bool MemPoolAccept::SubmitPackage(
             ws.m_ptx,
             std::make_shared<const std::vector<Coin>>(
                 getSpentCoins(ws.m_ptx, m_view)),
-            m_pool.GetAndIncrementSequence());
+            m_pool.RecordChange(ws.m_ptx->GetId()));
     }
     return all_submitted;
 }
@@ -1028,7 +1055,7 @@ MemPoolAccept::AcceptSingleTransaction(const CTransactionRef &ptx,
     GetMainSignals().TransactionAddedToMempool(
         ptx,
         std::make_shared<const std::vector<Coin>>(getSpentCoins(ptx, m_view)),
-        m_pool.GetAndIncrementSequence());
+        m_pool.RecordChange(ptx->GetId()));
 
     return MempoolAcceptResult::Success(ws.m_vsize, ws.m_base_fees,
                                         effective_feerate, single_txid);
@@ -1438,6 +1465,9 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate &active_chainstate,
     AssertLockHeld(::cs_main);
     assert(active_chainstate.GetMempool() != nullptr);
     CTxMemPool &pool{*active_chainstate.GetMempool()};
+    static metrics::Histogram &atmp_time{metrics::GetHistogram(
+        "accepttomemorypool", "Time spent accepting a tx to the mempool")};
+    metrics::ScopedTimer timer{atmp_time};
 
     std::vector<COutPoint> coins_to_uncache;
     auto args = MemPoolAccept::ATMPArgs::SingleAccept(
@@ -1504,6 +1534,95 @@ PackageMempoolAcceptResult ProcessNewPackage(Chainstate &active_chainstate,
     return result;
 }
 
+/**
+ * Get the input script checks of the transactions for
+ * PrecheckTransactionScripts. The checks copy the spent outputs, so they can
+ * run once the locks are released.
+ */
+static std::vector<CScriptCheck>
+GetPrecheckScriptChecks(Chainstate &active_chainstate, const CTxMemPool &pool,
+                        const std::vector<CTransactionRef> &txs)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs) {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(pool.cs);
+
+    std::vector<CScriptCheck> checks;
+    CCoinsViewCache &coins_tip = active_chainstate.CoinsTip();
+    CCoinsViewMemPool view_mempool(&coins_tip, pool);
+    CCoinsViewCache view(&view_mempool);
+
+    const ChainstateManager &chainman = active_chainstate.m_chainman;
+    uint32_t flags =
+        GetNextBlockScriptFlags(active_chainstate.m_chain.Tip(), chainman);
+    flags |= IsLegacyScriptRulesEnabled(chainman.GetConsensus())
+                 ? STANDARD_SCRIPT_VERIFY_FLAGS_LEGACY
+                 : STANDARD_SCRIPT_VERIFY_FLAGS;
+
+    std::vector<COutPoint> coins_to_uncache;
+    std::set<TxId> seen;
+    for (const CTransactionRef &ptx : txs) {
+        const CTransaction &tx = *ptx;
+        if (tx.IsCoinBase() || pool.exists(tx.GetId()) ||
+            !seen.insert(tx.GetId()).second) {
+            continue;
+        }
+
+        std::vector<CTxOut> spent_outputs;
+        spent_outputs.reserve(tx.vin.size());
+        for (const CTxIn &txin : tx.vin) {
+            if (!coins_tip.HaveCoinInCache(txin.prevout)) {
+                coins_to_uncache.push_back(txin.prevout);
+            }
+            const Coin &coin = view.AccessCoin(txin.prevout);
+            if (coin.IsSpent()) {
+                break;
+            }
+            spent_outputs.push_back(coin.GetTxOut());
+        }
+        if (spent_outputs.size() != tx.vin.size()) {
+            continue;
+        }
+
+        const PrecomputedTransactionData txdata(tx);
+        for (size_t i = 0; i < tx.vin.size(); ++i) {
+            checks.emplace_back(spent_outputs[i], tx, i, flags,
+                                /*cacheIn=*/true, txdata);
+        }
+        AddCoins(view, tx, MEMPOOL_HEIGHT, /*check=*/true);
+    }
+
+    // The transactions will fetch the coins they need again, don't let
+    // the rejected ones pollute the cache.
+    for (const COutPoint &outpoint : coins_to_uncache) {
+        coins_tip.Uncache(outpoint);
+    }
+
+    return checks;
+}
+
+void PrecheckTransactionScripts(Chainstate &active_chainstate,
+                                const CTxMemPool &pool,
+                                const std::vector<CTransactionRef> &txs) {
+    AssertLockNotHeld(cs_main);
+
+    std::vector<CScriptCheck> checks;
+    {
+        LOCK2(cs_main, pool.cs);
+        checks = GetPrecheckScriptChecks(active_chainstate, pool, txs);
+    }
+    GetValidationThreadPool().ParallelFor(checks.size(),
+                                          [&](size_t i) { checks[i](); });
+}
+
+void PrecheckTransactionScriptsLocked(Chainstate &active_chainstate,
+                                      const CTxMemPool &pool,
+                                      const std::vector<CTransactionRef> &txs) {
+    std::vector<CScriptCheck> checks{
+        GetPrecheckScriptChecks(active_chainstate, pool, txs)};
+    GetValidationThreadPool().ParallelFor(checks.size(),
+                                          [&](size_t i) { checks[i](); });
+}
+
 Amount GetBlockSubsidy(int nHeight, const Consensus::Params &consensusParams,
                        uint256 prevHash) {
     int halvings = nHeight / consensusParams.nSubsidyHalvingInterval;
@@ -1567,6 +1686,9 @@ void Chainstate::InitCoinsDB(size_t cache_size_bytes, bool in_memory,
         leveldb_name += node::SNAPSHOT_CHAINSTATE_SUFFIX;
     }
 
+    m_coins_prefetcher.Stop();
+    CoinsViewOptions coins_view_options{m_chainman.m_options.coins_view};
+    coins_view_options.write_pool = &GetValidationThreadPool();
     m_coins_views = std::make_unique<CoinsViews>(
         DBParams{.path = m_chainman.m_options.datadir / leveldb_name,
                  .cache_bytes = cache_size_bytes,
@@ -1574,7 +1696,7 @@ void Chainstate::InitCoinsDB(size_t cache_size_bytes, bool in_memory,
                  .wipe_data = should_wipe,
                  .obfuscate = true,
                  .options = m_chainman.m_options.coins_db},
-        m_chainman.m_options.coins_view);
+        std::move(coins_view_options));
 }
 
 void Chainstate::InitCoinsCache(size_t cache_size_bytes) {
@@ -1582,6 +1704,7 @@ void Chainstate::InitCoinsCache(size_t cache_size_bytes) {
     assert(m_coins_views != nullptr);
     m_coinstip_cache_size_bytes = cache_size_bytes;
     m_coins_views->InitCache();
+    CoinsTip().SetTrackDirty(m_chainman.m_options.coins_write_back_bytes > 0);
 }
 
 // Note that though this is marked const, we may end up modifying
@@ -1784,13 +1907,22 @@ bool CScriptCheck::operator()() {
     return true;
 }
 
-bool CheckInputScripts(const CTransaction &tx, TxValidationState &state,
-                       const CCoinsViewCache &inputs, const uint32_t flags,
-                       bool sigCacheStore, bool scriptCacheStore,
-                       const PrecomputedTransactionData &txdata,
-                       int &nSigChecksOut, TxSigCheckLimiter &txLimitSigChecks,
-                       CheckInputsLimiter *pBlockLimitSigChecks,
-                       std::vector<CScriptCheck> *pvChecks) {
+/**
+ * Implementation of CheckInputScripts(). If txdata is null, it is only computed
+ * when the scripts have to be executed: transactions connected in a block were
+ * usually verified when entering the mempool already, and hit the script cache.
+ */
+static bool CheckInputScriptsImpl(const CTransaction &tx,
+                                  TxValidationState &state,
+                                  const CCoinsViewCache &inputs,
+                                  const uint32_t flags, bool sigCacheStore,
+                                  bool scriptCacheStore,
+                                  const PrecomputedTransactionData *txdata,
+                                  int &nSigChecksOut,
+                                  TxSigCheckLimiter &txLimitSigChecks,
+                                  CheckInputsLimiter *pBlockLimitSigChecks,
+                                  std::vector<CScriptCheck> *pvChecks)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
     AssertLockHeld(cs_main);
     assert(!tx.IsCoinBase());
 
@@ -1813,6 +1945,11 @@ bool CheckInputScripts(const CTransaction &tx, TxValidationState &state,
         return true;
     }
 
+    std::optional<PrecomputedTransactionData> computed_txdata;
+    if (!txdata) {
+        txdata = &computed_txdata.emplace(tx);
+    }
+
     int nSigChecksTotal = 0;
 
     for (size_t i = 0; i < tx.vin.size(); i++) {
@@ -1827,8 +1964,8 @@ bool CheckInputScripts(const CTransaction &tx, TxValidationState &state,
         // of CScriptCheck.
 
         // Verify signature
-        CScriptCheck check(coin.GetTxOut(), tx, i, flags, sigCacheStore, txdata,
-                           &txLimitSigChecks, pBlockLimitSigChecks);
+        CScriptCheck check(coin.GetTxOut(), tx, i, flags, sigCacheStore,
+                           *txdata, &txLimitSigChecks, pBlockLimitSigChecks);
 
         // If pvChecks is not null, defer the check execution to the caller.
         if (pvChecks) {
@@ -1855,7 +1992,7 @@ bool CheckInputScripts(const CTransaction &tx, TxValidationState &state,
                 // splitting the network between upgraded and non-upgraded nodes
                 // by banning CONSENSUS-failing data providers.
                 CScriptCheck check2(coin.GetTxOut(), tx, i, mandatoryFlags,
-                                    sigCacheStore, txdata);
+                                    sigCacheStore, *txdata);
                 if (check2()) {
                     return state.Invalid(
                         TxValidationResult::TX_NOT_STANDARD,
@@ -1893,6 +2030,19 @@ bool CheckInputScripts(const CTransaction &tx, TxValidationState &state,
     return true;
 }
 
+bool CheckInputScripts(const CTransaction &tx, TxValidationState &state,
+                       const CCoinsViewCache &inputs, const uint32_t flags,
+                       bool sigCacheStore, bool scriptCacheStore,
+                       const PrecomputedTransactionData &txdata,
+                       int &nSigChecksOut, TxSigCheckLimiter &txLimitSigChecks,
+                       CheckInputsLimiter *pBlockLimitSigChecks,
+                       std::vector<CScriptCheck> *pvChecks) {
+    return CheckInputScriptsImpl(tx, state, inputs, flags, sigCacheStore,
+                                 scriptCacheStore, &txdata, nSigChecksOut,
+                                 txLimitSigChecks, pBlockLimitSigChecks,
+                                 pvChecks);
+}
+
 bool AbortNode(BlockValidationState &state, const std::string &strMessage,
                const bilingual_str &userMessage) {
     AbortNode(strMessage, userMessage);
@@ -2016,38 +2166,90 @@ DisconnectResult ApplyBlockUndo(CBlockUndo &&blockUndo, const CBlock &block,
     return fClean ? DisconnectResult::OK : DisconnectResult::UNCLEAN;
 }
 
+/**
+ * Checks the PoW of a small batch of headers, so the scrypt hashes of all the
+ * headers in the batch can be computed in parallel SIMD lanes.
+ */
 class CPowCheck {
 private:
-    CBlockHeader m_header;
+    std::vector<CBlockHeader> m_headers;
     Consensus::Params m_consensusParams;
+    //! Stop at the first invalid header. Otherwise every header is checked,
+    //! which fills the PoW cache with the valid ones.
+    bool m_fail_fast;
 
 public:
-    CPowCheck(CBlockHeader header, Consensus::Params consensusParams)
-        : m_header(header), m_consensusParams(consensusParams) {}
+    CPowCheck(std::vector<CBlockHeader> headers,
+              Consensus::Params consensusParams, bool fail_fast = true)
+        : m_headers(std::move(headers)), m_consensusParams(consensusParams),
+          m_fail_fast(fail_fast) {}
 
     bool operator()() {
-        return CheckAuxProofOfWork(m_header, m_consensusParams);
+        std::vector<const CBaseBlockHeader *> powHeaders;
+        powHeaders.reserve(m_headers.size());
+        for (const CBlockHeader &header : m_headers) {
+            powHeaders.push_back(&GetPowHeader(header));
+        }
+        const std::vector<BlockHash> powHashes =
+            CBaseBlockHeader::GetPowHashes(powHeaders);
+        for (size_t i = 0; i < m_headers.size(); ++i) {
+            if (!CheckAuxProofOfWork(m_headers[i], powHashes[i],
+                                     m_consensusParams) &&
+                m_fail_fast) {
+                return false;
+            }
+        }
+        return true;
     }
 };
 
+static ValidationThreadPool validationthreadpool;
+static InputFetcher inputfetcher;
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+static CCheckQueue<CPowCheck> powcheckqueue(128);
 
-void StartScriptCheckWorkerThreads(int threads_num) {
-    scriptcheckqueue.StartWorkerThreads(threads_num);
+void StartValidationWorkerThreads(int threads_num, bool work_stealing) {
+    inputfetcher.StartWorkerPool(validationthreadpool,
+                                 ValidationThreadPool::Priority::INPUT_FETCH);
+    scriptcheckqueue.StartWorkerPool(
+        validationthreadpool, ValidationThreadPool::Priority::SCRIPT_CHECK,
+        work_stealing);
+    powcheckqueue.StartWorkerPool(validationthreadpool,
+                                  ValidationThreadPool::Priority::POW_CHECK,
+                                  work_stealing);
+    validationthreadpool.Start(threads_num);
 }
 
-void StopScriptCheckWorkerThreads() {
-    scriptcheckqueue.StopWorkerThreads();
+void StopValidationWorkerThreads() {
+    validationthreadpool.Stop();
+    inputfetcher.StopWorkerPool();
+    scriptcheckqueue.StopWorkerPool();
+    powcheckqueue.StopWorkerPool();
 }
 
-static CCheckQueue<CPowCheck> powcheckqueue(128);
-
-void StartPowCheckWorkerThreads(int threads_num) {
-    powcheckqueue.StartWorkerThreads(threads_num);
+ValidationThreadPool &GetValidationThreadPool() {
+    return validationthreadpool;
 }
 
-void StopPowCheckWorkerThreads() {
-    powcheckqueue.StopWorkerThreads();
+static void
+PrecheckInputScriptsInParallel(const CTransaction &tx,
+                               const CCoinsViewCache &view, uint32_t flags,
+                               const PrecomputedTransactionData &txdata) {
+    AssertLockHeld(cs_main);
+
+    std::vector<CScriptCheck> checks;
+    checks.reserve(tx.vin.size());
+    for (size_t i = 0; i < tx.vin.size(); ++i) {
+        const Coin &coin = view.AccessCoin(tx.vin[i].prevout);
+        assert(!coin.IsSpent());
+        checks.emplace_back(coin.GetTxOut(), tx, i, flags, /*cacheIn=*/true,
+                            txdata);
+    }
+
+    // Block connection also holds cs_main, so the queue is free.
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    control.Add(std::move(checks));
+    control.Wait();
 }
 
 // Returns the script flags which should be checked for the block after
@@ -2135,6 +2337,21 @@ static int64_t nTimeIndex = 0;
 static int64_t nTimeTotal = 0;
 static int64_t nBlocksTotal = 0;
 
+static metrics::Histogram &ConnectBlockPhaseTime(const std::string &phase) {
+    return metrics::GetHistogram("connectblock",
+                                 "Time spent in the phases of ConnectBlock",
+                                 {"phase", phase});
+}
+static metrics::Histogram &g_time_check{ConnectBlockPhaseTime("check")};
+static metrics::Histogram &g_time_forks{ConnectBlockPhaseTime("forks")};
+static metrics::Histogram &g_time_connect{ConnectBlockPhaseTime("connect")};
+static metrics::Histogram &g_time_verify{ConnectBlockPhaseTime("verify")};
+static metrics::Histogram &g_time_index{ConnectBlockPhaseTime("index")};
+static metrics::Counter &g_connected_txs{metrics::GetCounter(
+    "connectblock_txs", "Number of txs connected by ConnectBlock")};
+static metrics::Counter &g_connected_inputs{metrics::GetCounter(
+    "connectblock_inputs", "Number of inputs connected by ConnectBlock")};
+
 /**
  * Apply the effects of this block (with given index) on the UTXO set
  * represented by coins. Validity checks that depend on the UTXO set are also
@@ -2144,7 +2361,8 @@ static int64_t nBlocksTotal = 0;
 bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
                               CBlockIndex *pindex, CCoinsViewCache &view,
                               BlockValidationOptions options, Amount *blockFees,
-                              bool fJustCheck) {
+                              bool fJustCheck,
+                              bool allow_skip_checked_scripts) {
     AssertLockHeld(cs_main);
     assert(pindex);
 
@@ -2199,6 +2417,10 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
         return true;
     }
 
+    // Read the inputs missing from the coins cache on the worker threads, so
+    // they are ready by the time their transaction gets connected.
+    InputFetcherControl inputfetch(inputfetcher, block, CoinsTip(), CoinsDB());
+
     bool fScriptChecks = true;
     if (!m_chainman.AssumedValidBlock().IsNull()) {
         // We've been configured with the hash of a block which has been
@@ -2246,6 +2468,7 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
 
     int64_t nTime1 = GetTimeMicros();
     nTimeCheck += nTime1 - nTimeStart;
+    g_time_check.Record(std::chrono::microseconds{nTime1 - nTimeStart});
     LogPrint(BCLog::BENCH, "    - Sanity checks: %.2fms [%.2fs (%.2fms/blk)]\n",
              MILLI * (nTime1 - nTimeStart), nTimeCheck * MICRO,
              nTimeCheck * MILLI / nBlocksTotal);
@@ -2330,8 +2553,22 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
 
     const uint32_t flags = GetNextBlockScriptFlags(pindex->pprev, m_chainman);
 
+    // A block that was fully validated before, e.g. disconnected during a
+    // reorg or by invalidateblock and connected again, spends the exact same
+    // coins since its parent is unchanged. If its scripts passed with the same
+    // flags there is no need to run them again.
+    const bool fScriptsAlreadyChecked = pindex->nStatus.hasCheckedScripts() &&
+                                        pindex->nScriptFlags == flags;
+    if (fScriptChecks && fScriptsAlreadyChecked && allow_skip_checked_scripts) {
+        LogPrint(BCLog::VALIDATION,
+                 "Skipping the script checks of block %s, already verified\n",
+                 block_hash.ToString());
+        fScriptChecks = false;
+    }
+
     int64_t nTime2 = GetTimeMicros();
     nTimeForks += nTime2 - nTime1;
+    g_time_forks.Record(std::chrono::microseconds{nTime2 - nTime1});
     LogPrint(BCLog::BENCH, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n",
              MILLI * (nTime2 - nTime1), nTimeForks * MICRO,
              nTimeForks * MILLI / nBlocksTotal);
@@ -2339,6 +2576,7 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
     std::vector<int> prevheights;
     Amount nFees = Amount::zero();
     int nInputs = 0;
+    const ScriptCacheStats script_cache_before{GetScriptCacheStats()};
 
     uint64_t nMaxBlockSigChecks =
         GetMaxBlockSigChecksCount(options.getExcessiveBlockSize());
@@ -2390,6 +2628,11 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
         const bool isCoinBase = tx.IsCoinBase();
         nInputs += tx.vin.size();
 
+        if (!isCoinBase) {
+            // The coinbase is always first, hence the offset.
+            inputfetch.FetchInputs(txIndex + 1, CoinsTip());
+        }
+
         // CountTxSigOps counts 2 types of sigops:
         // * legacy (always)
         // * p2sh (when P2SH enabled in flags and excludes coinbase)
@@ -2462,10 +2705,10 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
         std::vector<CScriptCheck> vChecks;
         TxValidationState tx_state;
         if (fScriptChecks &&
-            !CheckInputScripts(tx, tx_state, view, flags, fCacheResults,
-                               fCacheResults, PrecomputedTransactionData(tx),
-                               nSigChecksRet, nSigChecksTxLimiters[txIndex],
-                               &nSigChecksBlockLimiter, &vChecks)) {
+            !CheckInputScriptsImpl(tx, tx_state, view, flags, fCacheResults,
+                                   fCacheResults, /*txdata=*/nullptr,
+                                   nSigChecksRet, nSigChecksTxLimiters[txIndex],
+                                   &nSigChecksBlockLimiter, &vChecks)) {
             // Any transaction validation failure in ConnectBlock is a block
             // consensus failure
             state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
@@ -2489,6 +2732,7 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
 
     int64_t nTime3 = GetTimeMicros();
     nTimeConnect += nTime3 - nTime2;
+    g_time_connect.Record(std::chrono::microseconds{nTime3 - nTime2});
     LogPrint(BCLog::BENCH,
              "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) "
              "[%.2fs (%.2fms/blk)]\n",
@@ -2496,6 +2740,10 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
              MILLI * (nTime3 - nTime2) / block.vtx.size(),
              nInputs <= 1 ? 0 : MILLI * (nTime3 - nTime2) / (nInputs - 1),
              nTimeConnect * MICRO, nTimeConnect * MILLI / nBlocksTotal);
+    const ScriptCacheStats script_cache_after{GetScriptCacheStats()};
+    LogPrint(BCLog::BENCH, "      - Script cache: %u hits, %u misses\n",
+             script_cache_after.hits - script_cache_before.hits,
+             script_cache_after.misses - script_cache_before.misses);
 
     const Amount blockReward =
         nFees + GetBlockSubsidy(pindex->nHeight, consensusParams,
@@ -2512,13 +2760,18 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
         *blockFees = nFees;
     }
 
-    if (!control.Wait()) {
+    size_t nSkippedChecks = 0;
+    if (!control.Wait(&nSkippedChecks)) {
+        LogPrint(BCLog::VALIDATION,
+                 "Script check failed for block %s, skipped %u checks\n",
+                 block.GetHash().ToString(), nSkippedChecks);
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS,
                              "blk-bad-inputs", "parallel script check failed");
     }
 
     int64_t nTime4 = GetTimeMicros();
     nTimeVerify += nTime4 - nTime2;
+    g_time_verify.Record(std::chrono::microseconds{nTime4 - nTime2});
     LogPrint(
         BCLog::BENCH,
         "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n",
@@ -2539,11 +2792,20 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
         m_blockman.m_dirty_blockindex.insert(pindex);
     }
 
+    if (fScriptChecks && !fScriptsAlreadyChecked) {
+        pindex->nStatus = pindex->nStatus.withCheckedScripts();
+        pindex->nScriptFlags = flags;
+        m_blockman.m_dirty_blockindex.insert(pindex);
+    }
+
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
     int64_t nTime5 = GetTimeMicros();
     nTimeIndex += nTime5 - nTime4;
+    g_time_index.Record(std::chrono::microseconds{nTime5 - nTime4});
+    g_connected_txs.Add(block.vtx.size());
+    g_connected_inputs.Add(nInputs);
     LogPrint(BCLog::BENCH, "    - Index writing: %.2fms [%.2fs (%.2fms/blk)]\n",
              MILLI * (nTime5 - nTime4), nTimeIndex * MICRO,
              nTimeIndex * MILLI / nBlocksTotal);
@@ -2593,7 +2855,11 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
                                   FlushStateMode mode, int nManualPruneHeight) {
     LOCK(cs_main);
     assert(this->CanFlushToDisk());
+    static metrics::Histogram &flush_time{metrics::GetHistogram(
+        "flushstatetodisk", "Time spent flushing the chainstate to disk")};
+    metrics::ScopedTimer timer{flush_time};
     std::set<int> setFilesToPrune;
+    std::set<int> setUndoFilesToPrune;
     bool full_flush_completed = false;
 
     const size_t coins_count = CoinsTip().GetCacheSize();
@@ -2606,11 +2872,10 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
 
             CoinsCacheSizeState cache_state = GetCoinsCacheSizeState();
             LOCK(m_blockman.cs_LastBlockFile);
-            if (m_blockman.IsPruneMode() &&
-                (m_blockman.m_check_for_pruning || nManualPruneHeight > 0) &&
-                !fReindex) {
-                // Make sure we don't prune any of the prune locks bestblocks.
-                // Pruning is height-based.
+
+            // Make sure we don't prune any of the prune locks bestblocks.
+            // Pruning is height-based.
+            const auto get_max_prune = [&]() EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
                 int last_prune{m_chain.Height()};
                 // prune lock that actually was the limiting factor, only used
                 // for logging
@@ -2635,6 +2900,13 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
                     LogPrint(BCLog::PRUNE, "%s limited pruning to height %d\n",
                              limiting_lock.value(), last_prune);
                 }
+                return last_prune;
+            };
+
+            if (m_blockman.IsPruneMode() &&
+                (m_blockman.m_check_for_pruning || nManualPruneHeight > 0) &&
+                !fReindex) {
+                const int last_prune{get_max_prune()};
 
                 if (nManualPruneHeight > 0) {
                     LOG_TIME_MILLIS_WITH_CATEGORY(
@@ -2661,6 +2933,17 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
                     }
                 }
             }
+            // Deleting the undo data only requires the block index to be
+            // written, not the coins.
+            if (m_blockman.GetPruneUndoDepth() > 0 &&
+                m_blockman.m_check_for_undo_pruning && !fReindex) {
+                LOG_TIME_MILLIS_WITH_CATEGORY("find undo files to prune",
+                                              BCLog::BENCH);
+                m_blockman.FindUndoFilesToPrune(
+                    setUndoFilesToPrune, m_chain.Height(), get_max_prune());
+                m_blockman.m_check_for_undo_pruning = false;
+            }
+            const bool fWriteForUndoPrune = !setUndoFilesToPrune.empty();
             const auto nNow = GetTime<std::chrono::microseconds>();
             // Avoid writing/flushing immediately after startup.
             if (m_last_write.count() == 0) {
@@ -2673,6 +2956,18 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
             // but we have time now (not in the middle of a block processing).
             bool fCacheLarge = mode == FlushStateMode::PERIODIC &&
                                cache_state >= CoinsCacheSizeState::LARGE;
+            // If enabled, write back the oldest changes of the large cache
+            // and evict its least recently used coins rather than flushing it
+            // all, as long as it is not over the limit.
+            const bool fCacheFits = fCacheLarge &&
+                                    cache_state < CoinsCacheSizeState::CRITICAL;
+            const size_t write_back_bytes{
+                m_chainman.m_options.coins_write_back_bytes};
+            const bool fWriteBack = write_back_bytes > 0 && fCacheFits;
+            const bool fEvict = m_chainman.m_options.coins_evict && fCacheFits;
+            if (fWriteBack || fEvict) {
+                fCacheLarge = false;
+            }
             // The cache is over the limit, we have to write now.
             bool fCacheCritical = mode == FlushStateMode::IF_NEEDED &&
                                   cache_state >= CoinsCacheSizeState::CRITICAL;
@@ -2687,8 +2982,11 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
             // Combine all conditions that result in a full cache flush.
             fDoFullFlush = (mode == FlushStateMode::ALWAYS) || fCacheLarge ||
                            fCacheCritical || fPeriodicFlush || fFlushForPrune;
-            // Write blocks and block index to disk.
-            if (fDoFullFlush || fPeriodicWrite) {
+            // Write blocks and block index to disk. This is also required for
+            // writing back, as recovering from a crash in the middle of it
+            // replays the blocks.
+            if (fDoFullFlush || fPeriodicWrite || fWriteBack ||
+                fWriteForUndoPrune) {
                 // Ensure we can write block index
                 if (!CheckDiskSpace(gArgs.GetBlocksDirPath())) {
                     return AbortNode(state, "Disk space is too low!",
@@ -2722,6 +3020,12 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
 
                     m_blockman.UnlinkPrunedFiles(setFilesToPrune);
                 }
+                if (fWriteForUndoPrune) {
+                    LOG_TIME_MILLIS_WITH_CATEGORY("unlink pruned undo files",
+                                                  BCLog::BENCH);
+
+                    m_blockman.UnlinkPrunedUndoFiles(setUndoFilesToPrune);
+                }
                 m_last_write = nNow;
             }
             // Flush best chain related state. This can only be done if the
@@ -2745,12 +3049,43 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
                 }
 
                 // Flush the chainstate (which may refer to block index
-                // entries).
-                if (!CoinsTip().Flush()) {
+                // entries). When writing back, the cache is only emptied if
+                // it is over the limit.
+                const bool keep_cache =
+                    write_back_bytes > 0 &&
+                    cache_state < CoinsCacheSizeState::CRITICAL;
+                if (!(keep_cache ? CoinsTip().Sync() : CoinsTip().Flush())) {
                     return AbortNode(state, "Failed to write to coin database");
                 }
                 m_last_flush = nNow;
                 full_flush_completed = true;
+            } else if (fWriteBack && !CoinsTip().GetBestBlock().IsNull()) {
+                LOG_TIME_MILLIS_WITH_CATEGORY(
+                    strprintf("write back coins cache to disk (%d MiB)",
+                              write_back_bytes >> 20),
+                    BCLog::BENCH);
+
+                if (!CheckDiskSpace(gArgs.GetDataDirNet(),
+                                    2 * 2 * write_back_bytes)) {
+                    return AbortNode(state, "Disk space is too low!",
+                                     _("Disk space is too low!"));
+                }
+
+                if (!CoinsTip().SyncPartial(write_back_bytes)) {
+                    return AbortNode(state, "Failed to write to coin database");
+                }
+            }
+            if (fEvict) {
+                LOG_TIME_MILLIS_WITH_CATEGORY("evict coins from cache",
+                                              BCLog::BENCH);
+
+                // Leave some room below the large threshold, so this does not
+                // happen for every block. If there is not enough to evict,
+                // the cache is flushed once over the limit.
+                const size_t evicted =
+                    CoinsTip().EvictCoins(m_coinstip_cache_size_bytes / 10 * 8);
+                LogPrint(BCLog::COINDB, "Evicted %u coins from the cache\n",
+                         evicted);
             }
 
             TRACE5(utxocache, flush,
@@ -2781,6 +3116,7 @@ void Chainstate::ForceFlushStateToDisk() {
 void Chainstate::PruneAndFlush() {
     BlockValidationState state;
     m_blockman.m_check_for_pruning = true;
+    m_blockman.m_check_for_undo_pruning = true;
     if (!this->FlushStateToDisk(state, FlushStateMode::NONE)) {
         LogPrintf("%s: failed to flush state (%s)\n", __func__,
                   state.ToString());
@@ -2828,6 +3164,8 @@ void Chainstate::UpdateTip(const CBlockIndex *pindexNew) {
         m_mempool->AddTransactionsUpdated(1);
     }
 
+    m_chainman.PublishActiveChainSnapshot();
+
     {
         LOCK(g_best_block_mutex);
         g_best_block = pindexNew;
@@ -2867,6 +3205,13 @@ bool Chainstate::DisconnectTip(BlockValidationState &state,
         return error("DisconnectTip(): Failed to read block");
     }
 
+    // A coins database in the middle of a write back can only be recovered by
+    // replaying blocks forward, so complete the write before going backward.
+    if (CoinsDB().IsWrittenPartially() &&
+        !FlushStateToDisk(state, FlushStateMode::ALWAYS)) {
+        return false;
+    }
+
     // Apply the block atomically to the chain state.
     int64_t nStart = GetTimeMicros();
     {
@@ -2940,6 +3285,19 @@ static int64_t nTimeFlush = 0;
 static int64_t nTimeChainState = 0;
 static int64_t nTimePostConnect = 0;
 
+static metrics::Histogram &ConnectTipPhaseTime(const std::string &phase) {
+    return metrics::GetHistogram(
+        "connecttip", "Time spent in the phases of connecting a tip block",
+        {"phase", phase});
+}
+static metrics::Histogram &g_time_read_from_disk{ConnectTipPhaseTime("load")};
+static metrics::Histogram &g_time_connect_total{ConnectTipPhaseTime("connect")};
+static metrics::Histogram &g_time_flush{ConnectTipPhaseTime("flush")};
+static metrics::Histogram &g_time_chainstate{ConnectTipPhaseTime("chainstate")};
+static metrics::Histogram &g_time_post_connect{
+    ConnectTipPhaseTime("postprocess")};
+static metrics::Histogram &g_time_total{ConnectTipPhaseTime("total")};
+
 /**
  * Connect a new block to m_chain. pblock is either nullptr or a pointer to
  * a CBlock corresponding to pindexNew, to bypass loading it again from disk.
@@ -2976,6 +3334,7 @@ bool Chainstate::ConnectTip(BlockValidationState &state,
     // Apply the block atomically to the chain state.
     int64_t nTime2 = GetTimeMicros();
     nTimeReadFromDisk += nTime2 - nTime1;
+    g_time_read_from_disk.Record(std::chrono::microseconds{nTime2 - nTime1});
     int64_t nTime3;
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms [%.2fs]\n",
              (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO);
@@ -2984,7 +3343,8 @@ bool Chainstate::ConnectTip(BlockValidationState &state,
         CCoinsViewCache view(&CoinsTip());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view,
                                BlockValidationOptions(m_chainman.GetConfig()),
-                               &blockFees);
+                               &blockFees, /*fJustCheck=*/false,
+                               /*allow_skip_checked_scripts=*/true);
         GetMainSignals().BlockChecked(blockConnecting, state);
         if (!rv) {
             if (state.IsInvalid()) {
@@ -3073,6 +3433,7 @@ bool Chainstate::ConnectTip(BlockValidationState &state,
 
         nTime3 = GetTimeMicros();
         nTimeConnectTotal += nTime3 - nTime2;
+        g_time_connect_total.Record(std::chrono::microseconds{nTime3 - nTime2});
         assert(nBlocksTotal > 0);
         LogPrint(BCLog::BENCH,
                  "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n",
@@ -3084,6 +3445,7 @@ bool Chainstate::ConnectTip(BlockValidationState &state,
 
     int64_t nTime4 = GetTimeMicros();
     nTimeFlush += nTime4 - nTime3;
+    g_time_flush.Record(std::chrono::microseconds{nTime4 - nTime3});
     LogPrint(BCLog::BENCH, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n",
              (nTime4 - nTime3) * MILLI, nTimeFlush * MICRO,
              nTimeFlush * MILLI / nBlocksTotal);
@@ -3095,6 +3457,7 @@ bool Chainstate::ConnectTip(BlockValidationState &state,
 
     int64_t nTime5 = GetTimeMicros();
     nTimeChainState += nTime5 - nTime4;
+    g_time_chainstate.Record(std::chrono::microseconds{nTime5 - nTime4});
     LogPrint(BCLog::BENCH,
              "  - Writing chainstate: %.2fms [%.2fs (%.2fms/blk)]\n",
              (nTime5 - nTime4) * MILLI, nTimeChainState * MICRO,
@@ -3124,6 +3487,8 @@ bool Chainstate::ConnectTip(BlockValidationState &state,
     int64_t nTime6 = GetTimeMicros();
     nTimePostConnect += nTime6 - nTime5;
     nTimeTotal += nTime6 - nTime1;
+    g_time_post_connect.Record(std::chrono::microseconds{nTime6 - nTime5});
+    g_time_total.Record(std::chrono::microseconds{nTime6 - nTime1});
     LogPrint(BCLog::BENCH,
              "  - Connect postprocess: %.2fms [%.2fs (%.2fms/blk)]\n",
              (nTime6 - nTime5) * MILLI, nTimePostConnect * MICRO,
@@ -3309,6 +3674,186 @@ CBlockIndex *Chainstate::FindMostWorkChain(
     } while (true);
 }
 
+/**
+ * The most blocks of a competing chain checked by SpeculativelyCheckFork(),
+ * and the deepest fork from the active chain it considers.
+ */
+static constexpr int MAX_SPECULATIVE_FORK_BLOCKS{10};
+static constexpr int MAX_SPECULATIVE_FORK_DEPTH{10};
+
+void Chainstate::ScheduleSpeculativeForkCheck() {
+    AssertLockHeld(cs_main);
+    const CBlockIndex *tip = m_chain.Tip();
+    // Don't hold the caller up if the pool has no thread to run the check.
+    if (!tip || validationthreadpool.Size() == 0 ||
+        IsInitialBlockDownload()) {
+        return;
+    }
+
+    const CBlockIndex *fork_tip = m_chainman.m_best_parked;
+    if (fork_tip && (m_chain.Contains(fork_tip) ||
+                     fork_tip->nStatus.isInvalid() ||
+                     fork_tip->nChainWork < tip->nChainWork)) {
+        fork_tip = nullptr;
+    }
+    for (const CBlockIndex *candidate : setBlockIndexCandidates) {
+        if (candidate != tip &&
+            (!fork_tip || CBlockIndexWorkComparator()(fork_tip, candidate))) {
+            fork_tip = candidate;
+        }
+    }
+    if (!fork_tip || fork_tip == m_speculative_fork_tip ||
+        tip->nHeight - m_chain.FindFork(fork_tip)->nHeight >
+            MAX_SPECULATIVE_FORK_DEPTH) {
+        return;
+    }
+
+    m_speculative_fork_tip = fork_tip;
+    validationthreadpool.Submit(
+        [this, fork_tip] { SpeculativelyCheckFork(fork_tip); });
+}
+
+int Chainstate::SpeculativelyCheckFork(const CBlockIndex *fork_tip) {
+    AssertLockNotHeld(cs_main);
+
+    // The blocks to disconnect from the active chain and the first ones to
+    // connect on the competing chain, with the script flags to check them.
+    const CBlockIndex *fork;
+    std::vector<const CBlockIndex *> to_disconnect;
+    std::vector<std::pair<const CBlockIndex *, uint32_t>> to_connect;
+    {
+        LOCK(cs_main);
+        fork = m_chain.FindFork(fork_tip);
+        if (!fork || fork == fork_tip ||
+            m_chain.Height() - fork->nHeight > MAX_SPECULATIVE_FORK_DEPTH) {
+            return 0;
+        }
+        for (const CBlockIndex *pindex = m_chain.Tip(); pindex != fork;
+             pindex = pindex->pprev) {
+            to_disconnect.push_back(pindex);
+        }
+        for (const CBlockIndex *pindex = fork_tip->GetAncestor(
+                 std::min(fork_tip->nHeight,
+                          fork->nHeight + MAX_SPECULATIVE_FORK_BLOCKS));
+             pindex != fork; pindex = pindex->pprev) {
+            to_connect.emplace_back(
+                pindex, GetNextBlockScriptFlags(pindex->pprev, m_chainman));
+        }
+        std::reverse(to_connect.begin(), to_connect.end());
+    }
+
+    // The coins of the fork point which the blocks to disconnect spent. The
+    // ones they created are not available at the fork point.
+    std::map<COutPoint, Coin> restored;
+    for (const CBlockIndex *pindex : to_disconnect) {
+        CBlock block;
+        CBlockUndo blockundo;
+        if (!m_blockman.ReadBlockFromDisk(block, *pindex) ||
+            !m_blockman.UndoReadFromDisk(blockundo, *pindex) ||
+            blockundo.vtxundo.size() + 1 != block.vtx.size()) {
+            return 0;
+        }
+        for (size_t i = 1; i < block.vtx.size(); ++i) {
+            const CTransaction &tx{*block.vtx[i]};
+            const CTxUndo &txundo{blockundo.vtxundo[i - 1]};
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin &coin{txundo.vprevout[j]};
+                if (int(coin.GetHeight()) <= fork->nHeight) {
+                    restored.emplace(tx.vin[j].prevout, coin);
+                }
+            }
+        }
+    }
+
+    // The outputs of the blocks checked so far on the competing chain
+    std::map<COutPoint, Coin> created;
+    int num_cached{0};
+    for (const auto &[pindex, flags] : to_connect) {
+        CBlock block;
+        if (ShutdownRequested() ||
+            !m_blockman.ReadBlockFromDisk(block, *pindex)) {
+            break;
+        }
+
+        // The coins spent by the transactions whose scripts are not cached
+        // yet, or nullopt if one of these coins is unknown.
+        std::vector<std::optional<std::vector<Coin>>> spent(block.vtx.size());
+        {
+            LOCK(cs_main);
+            for (size_t i = 1; i < block.vtx.size(); ++i) {
+                const CTransaction &tx{*block.vtx[i]};
+                int nSigChecks;
+                if (IsKeyInScriptCache(ScriptCacheKey(tx, flags),
+                                       /*erase=*/false, nSigChecks)) {
+                    continue;
+                }
+                std::vector<Coin> &coins{spent[i].emplace()};
+                for (const CTxIn &txin : tx.vin) {
+                    if (auto it = created.find(txin.prevout);
+                        it != created.end()) {
+                        coins.push_back(it->second);
+                    } else if (auto it2 = restored.find(txin.prevout);
+                               it2 != restored.end()) {
+                        coins.push_back(it2->second);
+                    } else if (const Coin &coin =
+                                   CoinsTip().AccessCoin(txin.prevout);
+                               !coin.IsSpent() &&
+                               int(coin.GetHeight()) <= fork->nHeight) {
+                        coins.push_back(coin);
+                    } else {
+                        spent[i].reset();
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Check the transactions in parallel. The valid scripts are recorded
+        // in the script cache, and their signatures in the signature cache.
+        std::vector<std::pair<ScriptCacheKey, int>> valid;
+        Mutex valid_mutex;
+        validationthreadpool.ParallelFor(block.vtx.size(), [&](size_t i) {
+            if (!spent[i]) {
+                return;
+            }
+            const CTransaction &tx{*block.vtx[i]};
+            const PrecomputedTransactionData txdata(tx);
+            int nSigChecks = 0;
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                CScriptCheck check((*spent[i])[j].GetTxOut(), tx, j, flags,
+                                   /*cacheIn=*/true, txdata);
+                if (!check()) {
+                    return;
+                }
+                nSigChecks += check.GetScriptExecutionMetrics().nSigChecks;
+            }
+            LOCK(valid_mutex);
+            valid.emplace_back(ScriptCacheKey(tx, flags), nSigChecks);
+        });
+        {
+            LOCK(cs_main);
+            for (const auto &[key, nSigChecks] : valid) {
+                AddKeyInScriptCache(key, nSigChecks);
+            }
+        }
+        num_cached += valid.size();
+
+        for (const CTransactionRef &tx : block.vtx) {
+            for (size_t i = 0; i < tx->vout.size(); ++i) {
+                created.emplace(COutPoint(tx->GetId(), i),
+                                Coin(tx->vout[i], pindex->nHeight,
+                                     tx->IsCoinBase()));
+            }
+        }
+    }
+
+    LogPrint(BCLog::VALIDATION,
+             "Speculatively checked the scripts of %d transactions of the "
+             "chain of %s\n",
+             num_cached, fork_tip->GetBlockHash().ToString());
+    return num_cached;
+}
+
 /**
  * Delete all entries in setBlockIndexCandidates that are worse than the current
  * tip.
@@ -3334,6 +3879,35 @@ void Chainstate::PruneBlockIndexCandidates() {
  *
  * @returns true unless a system error occurred
  */
+void Chainstate::PrefetchBlockInputs(const CBlockIndex *pindex,
+                                     const CBlockIndex *pindexMostWork) {
+    AssertLockHeld(cs_main);
+
+    // Use what was read ahead for this block, if anything.
+    const size_t nPrefetched = m_coins_prefetcher.Apply(
+        pindex->GetBlockHash(), pindex->nHeight, CoinsTip(), CoinsDB());
+    LogPrint(BCLog::BENCH, "  - Prefetched %u coins\n", nPrefetched);
+
+    const int nMaxHeight =
+        std::min(pindex->nHeight + m_chainman.m_options.utxo_prefetch_blocks,
+                 pindexMostWork->nHeight);
+    for (int nHeight = pindex->nHeight + 1; nHeight <= nMaxHeight; ++nHeight) {
+        const CBlockIndex *pindexNext = pindexMostWork->GetAncestor(nHeight);
+        if (!pindexNext->nStatus.hasData()) {
+            break;
+        }
+        m_coins_prefetcher.Prefetch(
+            pindexNext->GetBlockHash(), nHeight,
+            [&blockman = m_blockman, pos = pindexNext->GetBlockPos()](
+                CBlock &block) {
+                // The block is checked when it gets connected.
+                return blockman.ReadBlockFromDisk(block, pos,
+                                                  /*check_pow=*/false);
+            },
+            CoinsDB(), GetValidationThreadPool());
+    }
+}
+
 bool Chainstate::ActivateBestChainStep(
     BlockValidationState &state, CBlockIndex *pindexMostWork,
     const std::shared_ptr<const CBlock> &pblock, bool &fInvalidFound,
@@ -3396,6 +3970,8 @@ bool Chainstate::ActivateBestChainStep(
 
         // Connect new blocks.
         for (CBlockIndex *pindexConnect : reverse_iterate(vpindexToConnect)) {
+            PrefetchBlockInputs(pindexConnect, pindexMostWork);
+
             BlockPolicyValidationState blockPolicyState;
             if (!ConnectTip(state, blockPolicyState, pindexConnect,
                             pindexConnect == pindexMostWork
@@ -3575,6 +4151,7 @@ bool Chainstate::ActivateBestChain(BlockValidationState &state,
                 // Whether we have anything to do at all.
                 if (pindexMostWork == nullptr ||
                     pindexMostWork == m_chain.Tip()) {
+                    ScheduleSpeculativeForkCheck();
                     break;
                 }
 
@@ -4128,7 +4705,9 @@ void Chainstate::ReceivedBlockTransactions(const CBlock &block,
     pindexNew->nFile = pos.nFile;
     pindexNew->nDataPos = pos.nPos;
     pindexNew->nUndoPos = 0;
-    pindexNew->nStatus = pindexNew->nStatus.withData();
+    // The block data only gets here after CheckBlock succeeded (or it is the
+    // genesis block), so the proof of work of what we stored is known good.
+    pindexNew->nStatus = pindexNew->nStatus.withData().withCheckedPoW();
     pindexNew->RaiseValidity(BlockValidity::TRANSACTIONS);
     m_blockman.m_dirty_blockindex.insert(pindexNew);
 
@@ -4189,15 +4768,26 @@ static bool CheckBlockHeader(const CBlockHeader &block,
                              const Consensus::Params &params,
                              BlockValidationOptions validationOptions) {
     // Check proof of work matches claimed amount
-    if (validationOptions.shouldValidatePoW() &&
-        !CheckAuxProofOfWork(block, params)) {
-        return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER,
-                             "high-hash", "proof of work failed");
+    if (validationOptions.shouldValidatePoW()) {
+        static metrics::Histogram &pow_time{
+            metrics::GetHistogram("checkpow", "Time spent checking the PoW",
+                                  {"source", "block"})};
+        metrics::ScopedTimer timer{pow_time};
+        if (!CheckAuxProofOfWork(block, params)) {
+            return state.Invalid(BlockValidationResult::BLOCK_INVALID_HEADER,
+                                 "high-hash", "proof of work failed");
+        }
     }
 
     return true;
 }
 
+/**
+ * Number of transactions checked in a row by a worker in CheckBlock(). The
+ * checks are short, so the chunks amortize the cost of handing them out.
+ */
+static constexpr size_t CHECKBLOCK_CHUNK_SIZE{64};
+
 bool CheckBlock(const CBlock &block, BlockValidationState &state,
                 const Consensus::Params &params,
                 BlockValidationOptions validationOptions) {
@@ -4215,7 +4805,11 @@ bool CheckBlock(const CBlock &block, BlockValidationState &state,
     // Check the merkle root.
     if (validationOptions.shouldValidateMerkleRoot()) {
         bool mutated;
-        uint256 hashMerkleRoot2 = BlockMerkleRoot(block, &mutated);
+        uint256 hashMerkleRoot2 = BlockMerkleRoot(
+            block, &mutated,
+            [](size_t count, const std::function<void(size_t)> &job) {
+                GetValidationThreadPool().ParallelFor(count, job);
+            });
         if (block.hashMerkleRoot != hashMerkleRoot2) {
             return state.Invalid(BlockValidationResult::BLOCK_MUTATED,
                                  "bad-txnmrklroot", "hashMerkleRoot mismatch");
@@ -4267,15 +4861,35 @@ bool CheckBlock(const CBlock &block, BlockValidationState &state,
 
     // Check transactions for regularity, skipping the first. Note that this
     // is the first time we check that all after the first are !IsCoinBase.
-    for (size_t i = 1; i < block.vtx.size(); i++) {
-        auto *tx = block.vtx[i].get();
-        if (!CheckRegularTransaction(*tx, tx_state)) {
-            return state.Invalid(
-                BlockValidationResult::BLOCK_CONSENSUS,
-                tx_state.GetRejectReason(),
-                strprintf("Transaction check failed (txid %s) %s",
-                          tx->GetId().ToString(), tx_state.GetDebugMessage()));
+    // The checks are context free, so chunks of transactions are checked in
+    // parallel. The first invalid transaction is then checked again on this
+    // thread, so the same error is reported whatever the chunks' timing.
+    std::atomic<size_t> first_invalid{block.vtx.size()};
+    const size_t num_chunks{(block.vtx.size() - 1 + CHECKBLOCK_CHUNK_SIZE - 1) /
+                            CHECKBLOCK_CHUNK_SIZE};
+    GetValidationThreadPool().ParallelFor(num_chunks, [&](size_t chunk) {
+        const size_t begin{1 + chunk * CHECKBLOCK_CHUNK_SIZE};
+        const size_t end{
+            std::min(begin + CHECKBLOCK_CHUNK_SIZE, block.vtx.size())};
+        TxValidationState chunk_state;
+        for (size_t i = begin; i < end && i < first_invalid.load(); i++) {
+            if (!CheckRegularTransaction(*block.vtx[i], chunk_state)) {
+                size_t prev{first_invalid.load()};
+                while (i < prev &&
+                       !first_invalid.compare_exchange_weak(prev, i)) {
+                }
+                return;
+            }
         }
+    });
+    if (first_invalid < block.vtx.size()) {
+        auto *tx = block.vtx[first_invalid].get();
+        const bool valid{CheckRegularTransaction(*tx, tx_state)};
+        assert(!valid);
+        return state.Invalid(
+            BlockValidationResult::BLOCK_CONSENSUS, tx_state.GetRejectReason(),
+            strprintf("Transaction check failed (txid %s) %s",
+                      tx->GetId().ToString(), tx_state.GetDebugMessage()));
     }
 
     if (validationOptions.shouldValidatePoW() &&
@@ -4286,16 +4900,60 @@ bool CheckBlock(const CBlock &block, BlockValidationState &state,
     return true;
 }
 
+/**
+ * Check the PoW of headers on the PoW check queue, in groups of
+ * SCRYPT_MULTI_MAX_LANES so that each check can hash them in SIMD lanes.
+ */
+static bool RunPowChecks(const std::vector<CBlockHeader> &headers,
+                         const Consensus::Params &consensusParams,
+                         bool fail_fast) {
+    CCheckQueueControl<CPowCheck> control(&powcheckqueue);
+    std::vector<CPowCheck> vChecks;
+    for (size_t i = 0; i < headers.size(); i += SCRYPT_MULTI_MAX_LANES) {
+        const auto end = headers.begin() +
+                         std::min(headers.size(), i + SCRYPT_MULTI_MAX_LANES);
+        vChecks.emplace_back(
+            std::vector<CBlockHeader>(headers.begin() + i, end),
+            consensusParams, fail_fast);
+    }
+    control.Add(std::move(vChecks));
+    size_t nSkippedChecks = 0;
+    if (!control.Wait(&nSkippedChecks)) {
+        LogPrint(BCLog::VALIDATION,
+                 "PoW check failed, skipped %u batches of headers\n",
+                 nSkippedChecks);
+        return false;
+    }
+    return true;
+}
+
 bool HasValidProofOfWork(const std::vector<CBlockHeader> &headers,
                          const Consensus::Params &consensusParams) {
+    static metrics::Histogram &pow_time{metrics::GetHistogram(
+        "checkpow", "Time spent checking the PoW", {"source", "headers"})};
+    metrics::ScopedTimer timer{pow_time};
+
     // Validate PoW in parallel. On Dogecoin, the PoW is very expensive.
-    CCheckQueueControl<CPowCheck> control(&powcheckqueue);
-    std::vector<CPowCheck> vChecks;
+    // Headers whose PoW is already in the PoW cache only need the cheap checks,
+    // so they are left out of the batches to keep the SIMD lanes busy.
+    std::vector<CBlockHeader> uncached;
+    uncached.reserve(headers.size());
     for (const CBlockHeader &header : headers) {
-        vChecks.emplace_back(header, consensusParams);
+        if (!IsPowCached(GetPowHeader(header).GetHash(), header.nBits)) {
+            uncached.push_back(header);
+        } else if (!CheckCachedAuxProofOfWork(header, consensusParams)) {
+            return false;
+        }
     }
-    control.Add(std::move(vChecks));
-    return control.Wait();
+
+    return RunPowChecks(uncached, consensusParams, /*fail_fast=*/true);
+}
+
+void PreverifyProofOfWork(const std::vector<CBlockHeader> &headers,
+                          const Consensus::Params &consensusParams) {
+    // Invalid headers are simply not cached, and get rejected when the block
+    // is actually processed.
+    RunPowChecks(headers, consensusParams, /*fail_fast=*/false);
 }
 
 arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader> &headers) {
@@ -4884,7 +5542,11 @@ bool Chainstate::AcceptBlock(const std::shared_ptr<const CBlock> &pblock,
         GetMainSignals().NewPoWValidBlock(pindex, pblock);
     }
 
-    // Write block to history file
+    // Write block to history file. This is still done under cs_main: the
+    // position comes from the block file info, which the flush and prune
+    // logic also work on, and the block has to be on disk before
+    // ReceivedBlockTransactions marks it as having data since any thread may
+    // then read it back.
     if (fNewBlock) {
         *fNewBlock = true;
     }
@@ -4913,8 +5575,24 @@ bool ChainstateManager::ProcessNewBlock(
     const std::shared_ptr<const CBlock> &block, bool force_processing,
     bool min_pow_checked, bool *new_block,
     avalanche::Processor *const avalanche) {
-    AssertLockNotHeld(cs_main);
+    if (!AcceptNewBlock(block, force_processing, min_pow_checked, new_block)) {
+        return false;
+    }
 
+    // Only used to report errors, not invalidity - ignore it
+    BlockValidationState state;
+    if (!ActiveChainstate().ActivateBestChain(state, block, avalanche)) {
+        return error("%s: ActivateBestChain failed (%s)", __func__,
+                     state.ToString());
+    }
+
+    return true;
+}
+
+bool ChainstateManager::AcceptNewBlock(
+    const std::shared_ptr<const CBlock> &block, bool force_processing,
+    bool min_pow_checked, bool *new_block) {
+    AssertLockNotHeld(cs_main);
     {
         if (new_block) {
             *new_block = false;
@@ -4922,12 +5600,6 @@ bool ChainstateManager::ProcessNewBlock(
 
         BlockValidationState state;
 
-        // CheckBlock() does not support multi-threaded block validation
-        // because CBlock::fChecked can cause data race.
-        // Therefore, the following critical section must include the
-        // CheckBlock() call as well.
-        LOCK(cs_main);
-
         // Skipping AcceptBlock() for CheckBlock() failures means that we will
         // never mark a block as invalid if CheckBlock() fails.  This is
         // protective against consensus failure if there are any unknown form
@@ -4936,9 +5608,14 @@ bool ChainstateManager::ProcessNewBlock(
         // https://lists.linuxfoundation.org/pipermail/bitcoin-dev/2019-February/016697.html.
         // Because CheckBlock() is not very expensive, the anti-DoS benefits of
         // caching failure (of a definitely-invalid block) are not substantial.
+        // The checks are context free, including the (aux)PoW and the merkle
+        // root, so they run before taking cs_main and the blocks submitted
+        // from several threads are checked in parallel. CBlock::fChecked is
+        // atomic so checking the same block concurrently is safe.
         bool ret = CheckBlock(*block, state, this->GetConsensus(),
                               BlockValidationOptions(this->GetConfig()));
         if (ret) {
+            LOCK(cs_main);
             // Store to disk
             ret = ActiveChainstate().AcceptBlock(block, state, force_processing,
                                                  nullptr, new_block,
@@ -4954,13 +5631,6 @@ bool ChainstateManager::ProcessNewBlock(
 
     NotifyHeaderTip(ActiveChainstate());
 
-    // Only used to report errors, not invalidity - ignore it
-    BlockValidationState state;
-    if (!ActiveChainstate().ActivateBestChain(state, block, avalanche)) {
-        return error("%s: ActivateBestChain failed (%s)", __func__,
-                     state.ToString());
-    }
-
     return true;
 }
 
@@ -5062,6 +5732,9 @@ bool Chainstate::LoadChainTip() {
     }
     m_chain.SetTip(*pindex);
     PruneBlockIndexCandidates();
+    if (this == &m_chainman.ActiveChainstate()) {
+        m_chainman.PublishActiveChainSnapshot();
+    }
 
     tip = m_chain.Tip();
     LogPrintf(
@@ -5720,6 +6393,7 @@ void Chainstate::LoadExternalBlockFile(
             // Remove former limit.
             blkdat.SetLimit();
             unsigned int nSize = 0;
+            bool compressed = false;
             try {
                 // Locate a header.
                 uint8_t buf[CMessageHeader::MESSAGE_START_SIZE];
@@ -5731,9 +6405,11 @@ void Chainstate::LoadExternalBlockFile(
                     continue;
                 }
 
-                // Read size.
+                // Read size, which flags the blocks stored compressed.
                 blkdat >> nSize;
-                if (nSize < 80) {
+                compressed = (nSize & node::BLOCK_COMPRESSED_FLAG) != 0;
+                nSize &= ~node::BLOCK_COMPRESSED_FLAG;
+                if ((!compressed && nSize < 80) || nSize > MAX_SIZE) {
                     continue;
                 }
             } catch (const std::exception &) {
@@ -5750,7 +6426,19 @@ void Chainstate::LoadExternalBlockFile(
                 }
                 blkdat.SetLimit(nBlockPos + nSize);
                 CBlockHeader header;
-                blkdat >> header;
+                // A compressed block is read and decompressed whole.
+                std::vector<uint8_t> block_data;
+                if (compressed) {
+                    std::vector<uint8_t> stored(nSize);
+                    blkdat >> Span{stored};
+                    if (!node::DecompressBlock(stored, block_data)) {
+                        throw std::ios_base::failure(
+                            "unable to decompress block");
+                    }
+                    SpanReader{SER_DISK, CLIENT_VERSION, block_data} >> header;
+                } else {
+                    blkdat >> header;
+                }
                 const BlockHash hash{header.GetHash()};
                 // Skip the rest of this block (this may read from disk
                 // into memory); position to the marker before the next block,
@@ -5786,10 +6474,15 @@ void Chainstate::LoadExternalBlockFile(
                     if (!pindex || !pindex->nStatus.hasData()) {
                         // This block can be processed immediately; rewind to
                         // its start, read and deserialize it.
-                        blkdat.SetPos(nBlockPos);
                         pblock = std::make_shared<CBlock>();
-                        blkdat >> *pblock;
-                        nRewind = blkdat.GetPos();
+                        if (compressed) {
+                            SpanReader{SER_DISK, CLIENT_VERSION, block_data} >>
+                                *pblock;
+                        } else {
+                            blkdat.SetPos(nBlockPos);
+                            blkdat >> *pblock;
+                            nRewind = blkdat.GetPos();
+                        }
 
                         BlockValidationState state;
                         if (AcceptBlock(pblock, state, true, dbp, nullptr,
@@ -5841,39 +6534,8 @@ void Chainstate::LoadExternalBlockFile(
                     continue;
                 }
 
-                // Recursively process earlier encountered successors of this
-                // block
-                std::deque<BlockHash> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    BlockHash head = queue.front();
-                    queue.pop_front();
-                    auto range = blocks_with_unknown_parent->equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<BlockHash, FlatFilePos>::iterator it =
-                            range.first;
-                        std::shared_ptr<CBlock> pblockrecursive =
-                            std::make_shared<CBlock>();
-                        if (m_blockman.ReadBlockFromDisk(*pblockrecursive,
-                                                         it->second)) {
-                            LogPrint(
-                                BCLog::REINDEX,
-                                "%s: Processing out of order child %s of %s\n",
-                                __func__, pblockrecursive->GetHash().ToString(),
-                                head.ToString());
-                            LOCK(cs_main);
-                            BlockValidationState dummy;
-                            if (AcceptBlock(pblockrecursive, dummy, true,
-                                            &it->second, nullptr, true)) {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        blocks_with_unknown_parent->erase(it);
-                        NotifyHeaderTip(*this);
-                    }
-                }
+                LoadBlocksWithKnownParent(hash, *blocks_with_unknown_parent,
+                                          nLoaded);
             } catch (const std::exception &e) {
                 // Historical bugs added extra data to the block files that does
                 // not deserialize cleanly. Commonly this data is between
@@ -5908,6 +6570,100 @@ void Chainstate::LoadExternalBlockFile(
               GetTimeMillis() - nStart);
 }
 
+void Chainstate::LoadExternalBlocks(
+    const std::vector<node::ReindexBlock> &blocks,
+    std::multimap<BlockHash, FlatFilePos> &blocks_with_unknown_parent,
+    avalanche::Processor *const avalanche) {
+    AssertLockNotHeld(m_chainstate_mutex);
+
+    int64_t nStart = GetTimeMillis();
+    const BlockHash &genesis_hash{
+        m_chainman.GetParams().GetConsensus().hashGenesisBlock};
+
+    int nLoaded = 0;
+    for (const auto &[pblock, pos] : blocks) {
+        if (ShutdownRequested()) {
+            return;
+        }
+
+        const BlockHash hash{pblock->GetHash()};
+        {
+            LOCK(cs_main);
+            // detect out of order blocks, and store them for later
+            if (hash != genesis_hash &&
+                !m_blockman.LookupBlockIndex(pblock->hashPrevBlock)) {
+                LogPrint(BCLog::REINDEX,
+                         "%s: Out of order block %s, parent %s not known\n",
+                         __func__, hash.ToString(),
+                         pblock->hashPrevBlock.ToString());
+                blocks_with_unknown_parent.emplace(pblock->hashPrevBlock, pos);
+                continue;
+            }
+
+            // process in case the block isn't known yet
+            const CBlockIndex *pindex = m_blockman.LookupBlockIndex(hash);
+            if (!pindex || !pindex->nStatus.hasData()) {
+                BlockValidationState state;
+                if (AcceptBlock(pblock, state, true, &pos, nullptr, true)) {
+                    nLoaded++;
+                }
+                if (state.IsError()) {
+                    break;
+                }
+            }
+        }
+
+        // Activate the genesis block so normal node progress can continue
+        if (hash == genesis_hash) {
+            BlockValidationState state;
+            if (!ActivateBestChain(state, nullptr, avalanche)) {
+                break;
+            }
+        }
+
+        NotifyHeaderTip(*this);
+        LoadBlocksWithKnownParent(hash, blocks_with_unknown_parent, nLoaded);
+    }
+
+    LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded,
+              GetTimeMillis() - nStart);
+}
+
+void Chainstate::LoadBlocksWithKnownParent(
+    const BlockHash &hash,
+    std::multimap<BlockHash, FlatFilePos> &blocks_with_unknown_parent,
+    int &nLoaded) {
+    // Recursively process earlier encountered successors of this block
+    std::deque<BlockHash> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        BlockHash head = queue.front();
+        queue.pop_front();
+        auto range = blocks_with_unknown_parent.equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<BlockHash, FlatFilePos>::iterator it = range.first;
+            std::shared_ptr<CBlock> pblockrecursive =
+                std::make_shared<CBlock>();
+            if (m_blockman.ReadBlockFromDisk(*pblockrecursive, it->second)) {
+                LogPrint(BCLog::REINDEX,
+                         "%s: Processing out of order child %s of %s\n",
+                         __func__, pblockrecursive->GetHash().ToString(),
+                         head.ToString());
+                LOCK(cs_main);
+                BlockValidationState dummy;
+                if (AcceptBlock(pblockrecursive, dummy, true, &it->second,
+                                nullptr, true)) {
+                    nLoaded++;
+                    queue.push_back(pblockrecursive->GetHash());
+                }
+            }
+            range.first++;
+            blocks_with_unknown_parent.erase(it);
+            NotifyHeaderTip(*this);
+        }
+    }
+}
+
 void Chainstate::CheckBlockIndex() {
     if (!m_chainman.ShouldCheckBlockIndex()) {
         return;
@@ -6268,6 +7024,7 @@ bool Chainstate::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size) {
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
     m_coinsdb_cache_size_bytes = coinsdb_size;
+    m_coins_prefetcher.Stop();
     CoinsDB().ResizeCache(coinsdb_size);
 
     LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n", this->ToString(),
@@ -6503,6 +7260,7 @@ bool ChainstateManager::ActivateSnapshot(AutoFile &coins_file,
         assert(chaintip_loaded);
 
         m_active_chainstate = m_snapshot_chainstate.get();
+        PublishActiveChainSnapshot();
 
         LogPrintf("[snapshot] successfully activated snapshot %s\n",
                   base_blockhash.ToString());
@@ -6573,11 +7331,31 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     const AssumeutxoData &au_data = *maybe_au_data;
 
+    // As above, okay to immediately release cs_main here since no other context
+    // knows about the snapshot_chainstate.
+    CCoinsViewDB *snapshot_coinsdb =
+        WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
+
     COutPoint outpoint;
     Coin coin;
     const uint64_t coins_count = metadata.m_coins_count;
     uint64_t coins_left = metadata.m_coins_count;
 
+    // The snapshots are dumped from a database cursor, so the coins normally
+    // come in the order of the database. They are then written straight to it
+    // rather than through the cache, which LevelDB ingests much faster. Coins
+    // out of order are loaded through the cache.
+    std::vector<std::pair<COutPoint, Coin>> sorted_coins;
+    std::optional<COutPoint> last_outpoint;
+    bool sorted{true};
+    const auto write_sorted_coins = [&]() {
+        if (!snapshot_coinsdb->BulkWrite(sorted_coins)) {
+            return false;
+        }
+        sorted_coins.clear();
+        return true;
+    };
+
     LogPrintf("[snapshot] loading coins from snapshot %s\n",
               base_blockhash.ToString());
     int64_t coins_processed{0};
@@ -6601,8 +7379,20 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
                 coins_count - coins_left);
             return false;
         }
-        coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint),
-                                              std::move(coin));
+        if (sorted && last_outpoint &&
+            !CCoinsViewDB::KeyLess(*last_outpoint, outpoint)) {
+            LogPrintf("[snapshot] coins out of order after deserializing %d "
+                      "coins, loading the remaining ones through the cache\n",
+                      coins_count - coins_left);
+            sorted = false;
+        }
+        last_outpoint = outpoint;
+        if (sorted) {
+            sorted_coins.emplace_back(std::move(outpoint), std::move(coin));
+        } else {
+            coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint),
+                                                  std::move(coin));
+        }
 
         --coins_left;
         ++coins_processed;
@@ -6624,6 +7414,11 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
                 return false;
             }
 
+            if (!write_sorted_coins()) {
+                LogPrintf("[snapshot] failed to write coins\n");
+                return false;
+            }
+
             const auto snapshot_cache_state = WITH_LOCK(
                 ::cs_main, return snapshot_chainstate.GetCoinsCacheSizeState());
 
@@ -6648,6 +7443,11 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     // method.
     coins_cache.SetBestBlock(base_blockhash);
 
+    if (!write_sorted_coins()) {
+        LogPrintf("[snapshot] failed to write coins\n");
+        return false;
+    }
+
     bool out_of_coins{false};
     try {
         coins_file >> outpoint;
@@ -6671,11 +7471,6 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     assert(coins_cache.GetBestBlock() == base_blockhash);
 
-    // As above, okay to immediately release cs_main here since no other context
-    // knows about the snapshot_chainstate.
-    CCoinsViewDB *snapshot_coinsdb =
-        WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
-
     std::optional<CCoinsStats> maybe_stats;
 
     try {
@@ -6811,6 +7606,7 @@ SnapshotCompletionResult ChainstateManager::MaybeCompleteSnapshotValidation(
                   "and stopping node\n");
 
         m_active_chainstate = m_ibd_chainstate.get();
+        PublishActiveChainSnapshot();
         m_snapshot_chainstate->m_disabled = true;
         assert(!this->IsUsable(m_snapshot_chainstate.get()));
         assert(this->IsUsable(m_ibd_chainstate.get()));
@@ -6956,6 +7752,7 @@ void ChainstateManager::ResetChainstates() {
     m_ibd_chainstate.reset();
     m_snapshot_chainstate.reset();
     m_active_chainstate = nullptr;
+    PublishActiveChainSnapshot();
 }
 
 /**
@@ -6986,6 +7783,47 @@ ChainstateManager::ChainstateManager(
     : m_options{Flatten(std::move(options))},
       m_blockman{std::move(blockman_options)} {}
 
+ChainstateManager::~ChainstateManager() {
+    ActiveChainSnapshot *snapshot = m_active_chain_snapshot.exchange(nullptr);
+    RCUPtr<ActiveChainSnapshot>::acquire(snapshot);
+}
+
+ActiveChainSnapshot::ActiveChainSnapshot(const CChain *chain,
+                                         const ActiveChainSnapshot *previous)
+    : m_tip(chain ? chain->Tip() : nullptr) {
+    const int num_heights{Height() + 1};
+    m_chunks.reserve((num_heights + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    for (int begin = 0; begin < num_heights; begin += CHUNK_SIZE) {
+        const int end{std::min(begin + CHUNK_SIZE, num_heights)};
+        // A complete chunk whose last entry is the same in both chains has
+        // the same ancestors too.
+        const size_t i{m_chunks.size()};
+        if (previous && end == begin + CHUNK_SIZE &&
+            (*previous)[end - 1] == (*chain)[end - 1]) {
+            m_chunks.push_back(previous->m_chunks[i]);
+            continue;
+        }
+        auto chunk = std::make_shared<Chunk>();
+        for (int height = begin; height < end; ++height) {
+            (*chunk)[height - begin] = (*chain)[height];
+        }
+        m_chunks.push_back(std::move(chunk));
+    }
+}
+
+void ChainstateManager::PublishActiveChainSnapshot() {
+    AssertLockHeld(::cs_main);
+    const CChain *chain =
+        m_active_chainstate ? &m_active_chainstate->m_chain : nullptr;
+    ActiveChainSnapshot *snapshot =
+        RCUPtr<ActiveChainSnapshot>::make(chain,
+                                          m_active_chain_snapshot.load())
+            .release();
+    // The previous snapshot is freed once no reader can still be using it.
+    snapshot = m_active_chain_snapshot.exchange(snapshot);
+    RCUPtr<ActiveChainSnapshot>::acquire(snapshot);
+}
+
 bool ChainstateManager::DetectSnapshotChainstate(CTxMemPool *mempool) {
     assert(!m_snapshot_chainstate);
     std::optional<fs::path> path = node::FindSnapshotChainstateDir();
@@ -7026,6 +7864,7 @@ util::Result<void> Chainstate::InvalidateCoinsDBOnDisk() {
     fs::path snapshot_datadir = *storage_path_maybe;
 
     // Coins views no longer usable.
+    m_coins_prefetcher.Stop();
     m_coins_views.reset();
 
     auto invalid_path = snapshot_datadir + "_INVALID";
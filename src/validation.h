@@ -23,11 +23,13 @@
 #include <deploymentstatus.h>
 #include <disconnectresult.h>
 #include <flatfile.h>
+#include <inputfetcher.h>
 #include <kernel/chainparams.h>
 #include <kernel/chainstatemanager_opts.h>
 #include <kernel/cs_main.h>
 #include <node/blockstorage.h>
 #include <policy/packages.h>
+#include <rcu.h>
 #include <script/script_error.h>
 #include <script/script_metrics.h>
 #include <shutdown.h>
@@ -40,6 +42,7 @@
 #include <util/result.h>
 #include <util/translation.h>
 
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <map>
@@ -60,6 +63,7 @@ class CScriptCheck;
 class CTxMemPool;
 class CTxUndo;
 class DisconnectedBlockTransactions;
+class ValidationThreadPool;
 
 struct ChainTxData;
 struct FlatFilePos;
@@ -83,6 +87,8 @@ class Processor;
 static const int MAX_SCRIPTCHECK_THREADS = 15;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Default for -checkqueueworkstealing */
+static const bool DEFAULT_CHECKQUEUE_WORK_STEALING = false;
 
 static const bool DEFAULT_PEERBLOOMFILTERS = true;
 
@@ -155,16 +161,23 @@ public:
 };
 
 /**
- * Run instances of script checking worker threads
+ * Run the validation worker threads, shared by the script and proof of work
+ * checks. If work_stealing is set, the workers steal chunks of checks from a
+ * lock-free deque rather than sharing a locked queue.
  */
-void StartScriptCheckWorkerThreads(int threads_num);
-void StartPowCheckWorkerThreads(int threads_num);
+void StartValidationWorkerThreads(
+    int threads_num, bool work_stealing = DEFAULT_CHECKQUEUE_WORK_STEALING);
 
 /**
- * Stop all of the script checking worker threads
+ * Stop all of the validation worker threads
  */
-void StopScriptCheckWorkerThreads();
-void StopPowCheckWorkerThreads();
+void StopValidationWorkerThreads();
+
+/**
+ * The thread pool running the validation checks, which also accepts lower
+ * priority background tasks.
+ */
+ValidationThreadPool &GetValidationThreadPool();
 
 Amount GetBlockSubsidy(int nHeight, const Consensus::Params &consensusParams,
                        uint256 prevHash);
@@ -379,6 +392,32 @@ ProcessNewPackage(Chainstate &active_chainstate, CTxMemPool &pool,
                   const Package &txns, bool test_accept)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Verify the input scripts of transactions about to be submitted to the
+ * mempool, in parallel on the validation thread pool and without holding
+ * cs_main. The outcome is not returned: the signatures verified here are
+ * stored in the signature cache, so that the acceptance of the transactions
+ * that follows does not verify them again.
+ *
+ * The spent coins are looked up in one view of the chainstate and the
+ * mempool, which also includes the outputs of the preceding transactions.
+ * The transactions spending missing coins are skipped.
+ */
+void PrecheckTransactionScripts(Chainstate &active_chainstate,
+                                const CTxMemPool &pool,
+                                const std::vector<CTransactionRef> &txs)
+    EXCLUSIVE_LOCKS_REQUIRED(!cs_main);
+
+/**
+ * Same as PrecheckTransactionScripts, for callers already holding the locks,
+ * such as the mempool update after a reorg. The checks still run in parallel,
+ * they do not need the locks.
+ */
+void PrecheckTransactionScriptsLocked(Chainstate &active_chainstate,
+                                      const CTxMemPool &pool,
+                                      const std::vector<CTransactionRef> &txs)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs);
+
 /**
  * Simple class for regulating resource usage during CheckInputScripts (and
  * CScriptCheck), atomic so as to be compatible with parallel validation.
@@ -605,6 +644,16 @@ bool TestBlockValidity(
 bool HasValidProofOfWork(const std::vector<CBlockHeader> &headers,
                          const Consensus::Params &consensusParams);
 
+/**
+ * Compute the PoW of headers on the PoW check queue workers and store those
+ * that are valid in the PoW cache, so that the blocks they belong to can later
+ * be checked without hashing. The headers are expected to be missing from the
+ * cache: the callers look them up with IsPowCached() as they collect them, so
+ * that each lookup is counted once in the cache stats.
+ */
+void PreverifyProofOfWork(const std::vector<CBlockHeader> &headers,
+                          const Consensus::Params &consensusParams);
+
 /** Return the sum of the work on a given set of headers */
 arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader> &headers);
 
@@ -734,6 +783,10 @@ protected:
     //! `m_chain`.
     std::unique_ptr<CoinsViews> m_coins_views;
 
+    //! Reads ahead the coins spent by the blocks about to be connected. It
+    //! must be stopped before the coins views go away.
+    CoinsPrefetcher m_coins_prefetcher;
+
     //! This toggle exists for use when doing background validation for UTXO
     //! snapshots.
     //!
@@ -858,7 +911,10 @@ public:
     }
 
     //! Destructs all objects related to accessing the UTXO set.
-    void ResetCoinsViews() { m_coins_views.reset(); }
+    void ResetCoinsViews() {
+        m_coins_prefetcher.Stop();
+        m_coins_views.reset();
+    }
 
     //! Does this chainstate have a UTXO set attached?
     bool HasCoinsViews() const { return (bool)m_coins_views; }
@@ -912,6 +968,19 @@ public:
         EXCLUSIVE_LOCKS_REQUIRED(!m_chainstate_mutex,
                                  !cs_avalancheFinalizedBlockIndex);
 
+    /**
+     * Import the blocks of a block file already read, in order, by
+     * BlockManager::ReadBlockFileForReindex(). This is the -reindex
+     * counterpart of LoadExternalBlockFile(), used when the block files are
+     * read and checked ahead on other threads.
+     */
+    void LoadExternalBlocks(
+        const std::vector<node::ReindexBlock> &blocks,
+        std::multimap<BlockHash, FlatFilePos> &blocks_with_unknown_parent,
+        avalanche::Processor *const avalanche = nullptr)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_chainstate_mutex,
+                                 !cs_avalancheFinalizedBlockIndex);
+
     /**
      * Update the on-disk chain state.
      * The caches and indexes are flushed depending on the mode we're called
@@ -929,8 +998,8 @@ public:
     //! Unconditionally flush all changes to disk.
     void ForceFlushStateToDisk();
 
-    //! Prune blockfiles from the disk if necessary and then flush chainstate
-    //! changes if we pruned.
+    //! Prune blockfiles, and undo files with -pruneundo, from the disk if
+    //! necessary and then flush chainstate changes if we pruned.
     void PruneAndFlush();
 
     /**
@@ -977,10 +1046,17 @@ public:
                                      const CBlockIndex *pindex,
                                      CCoinsViewCache &view)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /**
+     * allow_skip_checked_scripts lets a block whose scripts already passed
+     * with the same flags skip them. Only reconnecting a block to the active
+     * chain may do so, callers that verify the block (VerifyDB,
+     * TestBlockValidity) must leave it unset.
+     */
     bool ConnectBlock(const CBlock &block, BlockValidationState &state,
                       CBlockIndex *pindex, CCoinsViewCache &view,
                       BlockValidationOptions options,
-                      Amount *blockFees = nullptr, bool fJustCheck = false)
+                      Amount *blockFees = nullptr, bool fJustCheck = false,
+                      bool allow_skip_checked_scripts = false)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Apply the effects of a block disconnection on the UTXO set.
@@ -988,6 +1064,21 @@ public:
                        DisconnectedBlockTransactions *disconnectpool)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
 
+    /**
+     * Verify the input scripts of the first blocks of a competing chain
+     * ending at fork_tip, against the UTXO set at the fork point, and store
+     * the valid ones in the script and signature caches. If the chain is
+     * activated later, connecting these blocks mostly hits the caches.
+     *
+     * Nothing is recorded for the invalid scripts, they are rejected when the
+     * blocks are connected. Only cs_main is taken briefly, to look the coins
+     * up and to update the script cache.
+     *
+     * @returns the number of transactions whose scripts were cached.
+     */
+    int SpeculativelyCheckFork(const CBlockIndex *fork_tip)
+        EXCLUSIVE_LOCKS_REQUIRED(!cs_main);
+
     // Manual block validity manipulation:
     /**
      * Mark a block as precious and reorganize.
@@ -1107,12 +1198,38 @@ public:
     }
 
 private:
+    //! The last competing tip that SpeculativelyCheckFork() was scheduled for.
+    const CBlockIndex *m_speculative_fork_tip GUARDED_BY(::cs_main){nullptr};
+
+    /**
+     * Schedule SpeculativelyCheckFork() on the validation thread pool for the
+     * most-work competing tip, if it has at least as much work as the active
+     * tip: a parked chain or a tip which arrived after the active one.
+     */
+    void ScheduleSpeculativeForkCheck() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Accept the blocks read earlier whose parent was unknown, now that the
+     * block with this hash is, and recursively their successors.
+     */
+    void LoadBlocksWithKnownParent(
+        const BlockHash &hash,
+        std::multimap<BlockHash, FlatFilePos> &blocks_with_unknown_parent,
+        int &nLoaded) EXCLUSIVE_LOCKS_REQUIRED(!cs_main);
+
     bool ActivateBestChainStep(
         BlockValidationState &state, CBlockIndex *pindexMostWork,
         const std::shared_ptr<const CBlock> &pblock, bool &fInvalidFound,
         const avalanche::Processor *const avalanche = nullptr)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs,
                                  !cs_avalancheFinalizedBlockIndex);
+    /**
+     * Start reading ahead the coins spent by the blocks following pindex on
+     * the way to pindexMostWork.
+     */
+    void PrefetchBlockInputs(const CBlockIndex *pindex,
+                             const CBlockIndex *pindexMostWork)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool ConnectTip(BlockValidationState &state,
                     BlockPolicyValidationState &blockPolicyState,
                     CBlockIndex *pindexNew,
@@ -1219,6 +1336,74 @@ enum class SnapshotCompletionResult {
  *    IBD process is happening in the background while use of the
  *    active (snapshot) chainstate allows the rest of the system to function.
  */
+/**
+ * An immutable view of the active chain, published by the ChainstateManager
+ * every time the tip changes so that readers don't need to take cs_main.
+ *
+ * Only the fields of the block index entries that never change once they are
+ * inserted (height, hash, header data, pprev and pskip) can be accessed
+ * without cs_main through the snapshot.
+ *
+ * The snapshot indexes the entries of the chain by height, so that looking up
+ * an ancestor on the chain doesn't walk the skip list.
+ */
+class ActiveChainSnapshot {
+public:
+    //! The number of heights in each chunk of the height index.
+    static constexpr int CHUNK_SIZE{4096};
+    using Chunk = std::array<const CBlockIndex *, CHUNK_SIZE>;
+
+private:
+    const CBlockIndex *m_tip;
+    /**
+     * The entries of the chain by height, CHUNK_SIZE heights per chunk. The
+     * complete chunks which didn't change since the previous snapshot are
+     * shared with it, so publishing a snapshot for a new tip only copies the
+     * last chunk.
+     */
+    std::vector<std::shared_ptr<const Chunk>> m_chunks;
+
+    IMPLEMENT_RCU_REFCOUNT(uint64_t);
+
+public:
+    /**
+     * Snapshot the chain, or an empty chain if chain is nullptr, sharing the
+     * chunks that are unchanged with the previous snapshot if there is one.
+     */
+    ActiveChainSnapshot(const CChain *chain,
+                        const ActiveChainSnapshot *previous);
+
+    /** Returns the tip of the chain, or nullptr if there is none. */
+    const CBlockIndex *Tip() const { return m_tip; }
+
+    /** Returns the height of the tip, or -1 if there is no tip. */
+    int Height() const { return m_tip ? m_tip->nHeight : -1; }
+
+    /**
+     * Returns the index entry at a particular height in this chain, or
+     * nullptr if no such height exists.
+     */
+    const CBlockIndex *operator[](int nHeight) const {
+        if (nHeight < 0 || nHeight > Height()) {
+            return nullptr;
+        }
+        return (*m_chunks[nHeight / CHUNK_SIZE])[nHeight % CHUNK_SIZE];
+    }
+
+    /** Efficiently check whether a block is present in this chain. */
+    bool Contains(const CBlockIndex *pindex) const {
+        return pindex && (*this)[pindex->nHeight] == pindex;
+    }
+
+    /**
+     * Find the successor of a block in this chain, or nullptr if the given
+     * index is not found or is the tip.
+     */
+    const CBlockIndex *Next(const CBlockIndex *pindex) const {
+        return Contains(pindex) ? (*this)[pindex->nHeight + 1] : nullptr;
+    }
+};
+
 class ChainstateManager {
 private:
     //! The chainstate used under normal operation (i.e. "regular" IBD) or, if
@@ -1263,6 +1448,13 @@ private:
     CBlockIndex *m_best_invalid GUARDED_BY(::cs_main){nullptr};
     CBlockIndex *m_best_parked GUARDED_BY(::cs_main){nullptr};
 
+    //! The latest snapshot of the active chain, owned by this pointer. It is
+    //! replaced under cs_main and read under an RCULock.
+    std::atomic<ActiveChainSnapshot *> m_active_chain_snapshot{nullptr};
+
+    //! Replace the active chain snapshot with the current active chain.
+    void PublishActiveChainSnapshot() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     //! Internal helper for ActivateSnapshot().
     [[nodiscard]] bool
     PopulateAndValidateSnapshot(Chainstate &snapshot_chainstate,
@@ -1310,6 +1502,7 @@ public:
 
     explicit ChainstateManager(Options options,
                                node::BlockManager::Options blockman_options);
+    ~ChainstateManager();
 
     const Config &GetConfig() const { return m_options.config; }
 
@@ -1439,6 +1632,15 @@ public:
         return ActiveChain().Tip();
     }
 
+    //! The most-work chain as of the last tip update, for readers which don't
+    //! want to take cs_main. It may lag behind ActiveChain() while validation
+    //! is in progress.
+    RCUPtr<const ActiveChainSnapshot> GetActiveChainSnapshot() const {
+        RCULock lock;
+        return RCUPtr<const ActiveChainSnapshot>::copy(
+            m_active_chain_snapshot.load());
+    }
+
     node::BlockMap &BlockIndex() EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
         return m_blockman.m_block_index;
@@ -1489,6 +1691,17 @@ public:
                          avalanche::Processor *const avalanche = nullptr)
         LOCKS_EXCLUDED(cs_main);
 
+    /**
+     * The first half of ProcessNewBlock(): check the block and store it to
+     * disk, without connecting it. ActivateBestChain() must be called
+     * afterwards, which can be done from another thread.
+     *
+     * @returns     If the block was accepted, independently of block validity
+     */
+    bool AcceptNewBlock(const std::shared_ptr<const CBlock> &block,
+                        bool force_processing, bool min_pow_checked,
+                        bool *new_block) LOCKS_EXCLUDED(cs_main);
+
     /**
      * Process incoming block headers.
      *
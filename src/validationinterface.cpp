@@ -12,11 +12,20 @@
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <scheduler.h>
+#include <util/metrics.h>
 
+#include <algorithm>
+#include <cassert>
+#include <deque>
 #include <future>
+#include <limits>
+#include <list>
+#include <optional>
+#include <string>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 const std::string RemovalReasonToString(const MemPoolRemovalReason &r) noexcept;
 
@@ -28,39 +37,242 @@ const std::string RemovalReasonToString(const MemPoolRemovalReason &r) noexcept;
  * registered, and a std::list is used to store the callbacks that are
  * currently registered as well as any callbacks that are just unregistered
  * and about to be deleted when they are done executing.
+ *
+ * The background events are appended to a queue shared by all the
+ * subscribers, which each get them in order from their own position in the
+ * queue. The subscribers are served concurrently by the scheduler threads, so
+ * a slow subscriber only delays itself. The events are dropped from the queue
+ * once every subscriber got them. A function queued with
+ * CallFunctionInValidationInterfaceQueue acts as a barrier: it runs once all
+ * the subscribers got the events before it, and none gets the events after it
+ * until it returns.
  */
 class MainSignalsImpl {
 private:
     Mutex m_mutex;
     //! List entries consist of a callback pointer and reference count. The
-    //! count is equal to the number of current executions of that entry, plus 1
-    //! if it's registered. It cannot be 0 because that would imply it is
-    //! unregistered and also not being executed (so shouldn't exist).
+    //! count is equal to the number of current executions of that entry,
+    //! including the scheduled deliveries, plus 1 if it's registered. It cannot
+    //! be 0 because that would imply it is unregistered and also not being
+    //! executed (so shouldn't exist).
     struct ListEntry {
         std::shared_ptr<CValidationInterface> callbacks;
         int count = 1;
+        bool registered = true;
+        //! Sequence number of the next queued event to deliver
+        uint64_t next_event = 0;
+        //! Whether a task delivering the queued events is scheduled
+        bool scheduled = false;
+        std::string name;
+        size_t max_pending = 0;
+        uint64_t delivered = 0;
+        metrics::Histogram *callback_time = nullptr;
     };
     std::list<ListEntry> m_list GUARDED_BY(m_mutex);
     std::unordered_map<CValidationInterface *, std::list<ListEntry>::iterator>
         m_map GUARDED_BY(m_mutex);
 
-public:
-    // We are not allowed to assume the scheduler only runs in one thread,
-    // but must ensure all callbacks happen in-order, so we end up creating
-    // our own queue here :(
-    SingleThreadedSchedulerClient m_schedulerClient;
+    struct QueuedEvent {
+        //! Delivered to each subscriber, null for a barrier or a connected
+        //! block
+        std::function<void(CValidationInterface &)> event;
+        //! The consecutive connected blocks are delivered all at once
+        std::optional<ConnectedBlock> connected;
+        std::function<void()> barrier;
+        //! Logs the event when it is first delivered
+        std::function<void()> log;
+    };
+    //! The events not yet delivered to all the subscribers, starting with the
+    //! sequence number m_queue_begin
+    std::deque<QueuedEvent> m_queue GUARDED_BY(m_mutex);
+    uint64_t m_queue_begin GUARDED_BY(m_mutex) = 0;
+    bool m_barrier_scheduled GUARDED_BY(m_mutex) = false;
+
+    CScheduler &m_scheduler;
+
+    uint64_t QueueEnd() const EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return m_queue_begin + m_queue.size();
+    }
+
+    /**
+     * The sequence number of the first event not delivered to all the
+     * registered subscribers. No subscriber is past the first barrier.
+     */
+    uint64_t GetSlowestEvent() const EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        if (!m_map.empty()) {
+            uint64_t slowest = std::numeric_limits<uint64_t>::max();
+            for (const auto &entry : m_map) {
+                slowest = std::min(slowest, entry.second->next_event);
+            }
+            return slowest;
+        }
+        uint64_t slowest = m_queue_begin;
+        while (slowest < QueueEnd() &&
+               !m_queue[slowest - m_queue_begin].barrier) {
+            ++slowest;
+        }
+        return slowest;
+    }
 
+    /**
+     * Drop the events delivered to all the subscribers, and schedule the
+     * barrier once they all reached it.
+     */
+    void UpdateQueue() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        const uint64_t slowest = GetSlowestEvent();
+        while (m_queue_begin < slowest) {
+            LogFirstDelivery(m_queue.front());
+            m_queue.pop_front();
+            ++m_queue_begin;
+        }
+        if (!m_queue.empty() && m_queue.front().barrier &&
+            !m_barrier_scheduled) {
+            m_barrier_scheduled = true;
+            m_scheduler.scheduleConcurrent(
+                [this, seq = m_queue_begin] { RunBarrier(seq); },
+                std::chrono::steady_clock::now());
+        }
+    }
+
+    static void LogFirstDelivery(QueuedEvent &queued) {
+        if (queued.log) {
+            queued.log();
+            queued.log = nullptr;
+        }
+    }
+
+    /** Schedule the delivery of the queued events to the subscriber. */
+    void MaybeSchedule(std::list<ListEntry>::iterator it)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        if (it->scheduled || !HasNextEvent(*it)) {
+            return;
+        }
+        it->scheduled = true;
+        // The entry is not deleted until the task is done
+        ++it->count;
+        m_scheduler.scheduleConcurrent([this, it] { DeliverNextEvent(it); },
+                                       std::chrono::steady_clock::now());
+    }
+
+    /** Whether the subscriber has an event to get before the next barrier. */
+    bool HasNextEvent(const ListEntry &entry) const
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return entry.registered && entry.next_event < QueueEnd() &&
+               !m_queue[entry.next_event - m_queue_begin].barrier;
+    }
+
+    /**
+     * Get the next event of the subscriber, which must have one, as a function
+     * to call unlocked. It includes all the following connected blocks, if it
+     * is one. Returns the number of events.
+     */
+    size_t GetNextEvent(const ListEntry &entry,
+                        std::function<void(CValidationInterface &)> &event)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        QueuedEvent &queued = m_queue[entry.next_event - m_queue_begin];
+        LogFirstDelivery(queued);
+        if (!queued.connected) {
+            event = queued.event;
+            return 1;
+        }
+
+        std::vector<ConnectedBlock> blocks;
+        for (uint64_t seq = entry.next_event; seq < QueueEnd(); ++seq) {
+            QueuedEvent &next = m_queue[seq - m_queue_begin];
+            if (!next.connected) {
+                break;
+            }
+            LogFirstDelivery(next);
+            blocks.push_back(*next.connected);
+        }
+        const size_t count = blocks.size();
+        event = [blocks = std::move(blocks)](CValidationInterface &callbacks) {
+            callbacks.BlocksConnected(blocks);
+        };
+        return count;
+    }
+
+    /**
+     * Deliver the next queued event to the subscriber, if it is still
+     * registered, then reschedule for the following one.
+     */
+    void DeliverNextEvent(std::list<ListEntry>::iterator it)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        WAIT_LOCK(m_mutex, lock);
+        // Another thread might have emptied the queue with
+        // FlushBackgroundCallbacks in the meantime.
+        if (HasNextEvent(*it)) {
+            std::function<void(CValidationInterface &)> event;
+            const size_t count = GetNextEvent(*it, event);
+            const auto callbacks = it->callbacks;
+            {
+                REVERSE_LOCK(lock);
+                metrics::ScopedTimer timer{*it->callback_time};
+                event(*callbacks);
+            }
+            it->next_event += count;
+            it->delivered += count;
+            UpdateQueue();
+        }
+        it->scheduled = false;
+        if (!--it->count) {
+            m_list.erase(it);
+            return;
+        }
+        MaybeSchedule(it);
+    }
+
+    void RunBarrier(uint64_t seq) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        WAIT_LOCK(m_mutex, lock);
+        if (m_queue_begin != seq) {
+            // Already run by FlushBackgroundCallbacks
+            return;
+        }
+        const auto barrier = m_queue.front().barrier;
+        {
+            REVERSE_LOCK(lock);
+            barrier();
+        }
+        m_barrier_scheduled = false;
+        m_queue.pop_front();
+        ++m_queue_begin;
+        for (const auto &entry : m_map) {
+            entry.second->next_event =
+                std::max(entry.second->next_event, m_queue_begin);
+            MaybeSchedule(entry.second);
+        }
+        UpdateQueue();
+    }
+
+    void Unregister(std::list<ListEntry>::iterator it)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        it->registered = false;
+        if (!--it->count) {
+            m_list.erase(it);
+        }
+    }
+
+public:
     explicit MainSignalsImpl(CScheduler &scheduler LIFETIMEBOUND)
-        : m_schedulerClient(scheduler) {}
+        : m_scheduler(scheduler) {}
 
     void Register(std::shared_ptr<CValidationInterface> callbacks)
         EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
         LOCK(m_mutex);
+        const uint64_t next_event = GetSlowestEvent();
         auto inserted = m_map.emplace(callbacks.get(), m_list.end());
         if (inserted.second) {
-            inserted.first->second = m_list.emplace(m_list.end());
+            auto it = m_list.emplace(m_list.end());
+            it->next_event = next_event;
+            it->name = callbacks->GetSubscriberName();
+            it->callback_time = &metrics::GetHistogram(
+                "validationinterface_callback",
+                "Time spent in the background validation callbacks",
+                {"subscriber", it->name});
+            inserted.first->second = it;
         }
         inserted.first->second->callbacks = std::move(callbacks);
+        MaybeSchedule(inserted.first->second);
     }
 
     void Unregister(CValidationInterface *callbacks)
@@ -68,10 +280,10 @@ public:
         LOCK(m_mutex);
         auto it = m_map.find(callbacks);
         if (it != m_map.end()) {
-            if (!--it->second->count) {
-                m_list.erase(it->second);
-            }
+            Unregister(it->second);
             m_map.erase(it);
+            // The subscriber might have been the last one before a barrier
+            UpdateQueue();
         }
     }
 
@@ -82,17 +294,20 @@ public:
     void Clear() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
         LOCK(m_mutex);
         for (const auto &entry : m_map) {
-            if (!--entry.second->count) {
-                m_list.erase(entry.second);
-            }
+            Unregister(entry.second);
         }
         m_map.clear();
+        UpdateQueue();
     }
 
     template <typename F>
     void Iterate(F &&f) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
         WAIT_LOCK(m_mutex, lock);
         for (auto it = m_list.begin(); it != m_list.end();) {
+            if (!it->registered) {
+                ++it;
+                continue;
+            }
             ++it->count;
             {
                 REVERSE_LOCK(lock);
@@ -101,6 +316,99 @@ public:
             it = --it->count ? std::next(it) : m_list.erase(it);
         }
     }
+
+    /** Queue an event for all the registered subscribers. */
+    void Enqueue(std::function<void(CValidationInterface &)> event,
+                 std::function<void()> log) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        Enqueue({std::move(event), std::nullopt, nullptr, std::move(log)});
+    }
+    void Enqueue(ConnectedBlock connected, std::function<void()> log)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        Enqueue({nullptr, std::move(connected), nullptr, std::move(log)});
+    }
+    void Enqueue(QueuedEvent queued) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        LOCK(m_mutex);
+        m_queue.push_back(std::move(queued));
+        for (const auto &entry : m_map) {
+            ListEntry &subscriber = *entry.second;
+            subscriber.max_pending = std::max<size_t>(
+                subscriber.max_pending, QueueEnd() - subscriber.next_event);
+            MaybeSchedule(entry.second);
+        }
+        UpdateQueue();
+    }
+
+    void EnqueueBarrier(std::function<void()> func)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        LOCK(m_mutex);
+        m_queue.push_back({nullptr, std::nullopt, std::move(func), nullptr});
+        UpdateQueue();
+    }
+
+    /**
+     * Deliver all the queued events on the calling thread, blocking until the
+     * queue is empty. Must be called after the CScheduler has no remaining
+     * processing threads!
+     */
+    void EmptyQueue() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        assert(!m_scheduler.AreThreadsServicingQueue());
+        WAIT_LOCK(m_mutex, lock);
+        while (!m_queue.empty()) {
+            if (m_queue.front().barrier) {
+                const auto barrier = m_queue.front().barrier;
+                {
+                    REVERSE_LOCK(lock);
+                    barrier();
+                }
+                m_queue.pop_front();
+                ++m_queue_begin;
+                for (const auto &entry : m_map) {
+                    entry.second->next_event =
+                        std::max(entry.second->next_event, m_queue_begin);
+                }
+                m_barrier_scheduled = false;
+                continue;
+            }
+
+            // Deliver the events up to the next barrier to each subscriber in
+            // turn, the list entries are kept alive by their count.
+            for (auto it = m_list.begin(); it != m_list.end();) {
+                ++it->count;
+                while (HasNextEvent(*it)) {
+                    std::function<void(CValidationInterface &)> event;
+                    const size_t count = GetNextEvent(*it, event);
+                    const auto callbacks = it->callbacks;
+                    {
+                        REVERSE_LOCK(lock);
+                        event(*callbacks);
+                    }
+                    it->next_event += count;
+                    it->delivered += count;
+                }
+                it = --it->count ? std::next(it) : m_list.erase(it);
+            }
+            UpdateQueue();
+        }
+    }
+
+    size_t CallbacksPending() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        LOCK(m_mutex);
+        return m_queue.size();
+    }
+
+    std::vector<SubscriberQueueStats> GetSubscriberQueueStats()
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        LOCK(m_mutex);
+        std::vector<SubscriberQueueStats> stats;
+        for (const ListEntry &entry : m_list) {
+            if (entry.registered) {
+                stats.push_back({entry.name,
+                                 size_t(QueueEnd() - entry.next_event),
+                                 entry.max_pending, entry.delivered});
+            }
+        }
+        return stats;
+    }
 };
 
 static CMainSignals g_signals;
@@ -116,7 +424,7 @@ void CMainSignals::UnregisterBackgroundSignalScheduler() {
 
 void CMainSignals::FlushBackgroundCallbacks() {
     if (m_internals) {
-        m_internals->m_schedulerClient.EmptyQueue();
+        m_internals->EmptyQueue();
     }
 }
 
@@ -124,7 +432,14 @@ size_t CMainSignals::CallbacksPending() {
     if (!m_internals) {
         return 0;
     }
-    return m_internals->m_schedulerClient.CallbacksPending();
+    return m_internals->CallbacksPending();
+}
+
+std::vector<SubscriberQueueStats> CMainSignals::GetSubscriberQueueStats() {
+    if (!m_internals) {
+        return {};
+    }
+    return m_internals->GetSubscriberQueueStats();
 }
 
 CMainSignals &GetMainSignals() {
@@ -164,7 +479,7 @@ void UnregisterAllValidationInterfaces() {
 }
 
 void CallFunctionInValidationInterfaceQueue(std::function<void()> func) {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    g_signals.m_internals->EnqueueBarrier(std::move(func));
 }
 
 void SyncWithValidationInterfaceQueue() {
@@ -183,9 +498,8 @@ void SyncWithValidationInterfaceQueue() {
     do {                                                                       \
         auto local_name = (name);                                              \
         LOG_EVENT("Enqueuing " fmt, local_name, __VA_ARGS__);                  \
-        m_internals->m_schedulerClient.AddToProcessQueue([=] {                 \
+        m_internals->Enqueue(event, [=] {                                      \
             LOG_EVENT(fmt, local_name, __VA_ARGS__);                           \
-            event();                                                           \
         });                                                                    \
     } while (0)
 
@@ -199,10 +513,9 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew,
     // for the caller to invoke this signal in the same critical section where
     // the chain is updated
 
-    auto event = [pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
-        });
+    auto event = [pindexNew, pindexFork,
+                  fInitialDownload](CValidationInterface &callbacks) {
+        callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     };
     ENQUEUE_AND_LOG_EVENT(
         event, "%s: new block hash=%s fork block hash=%s (in IBD=%s)", __func__,
@@ -215,11 +528,9 @@ void CMainSignals::TransactionAddedToMempool(
     const CTransactionRef &tx,
     std::shared_ptr<const std::vector<Coin>> spent_coins,
     uint64_t mempool_sequence) {
-    auto event = [tx, spent_coins, mempool_sequence, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.TransactionAddedToMempool(tx, spent_coins,
-                                                mempool_sequence);
-        });
+    auto event = [tx, spent_coins,
+                  mempool_sequence](CValidationInterface &callbacks) {
+        callbacks.TransactionAddedToMempool(tx, spent_coins, mempool_sequence);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s", __func__,
                           tx->GetHash().ToString());
@@ -228,11 +539,9 @@ void CMainSignals::TransactionAddedToMempool(
 void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef &tx,
                                                  MemPoolRemovalReason reason,
                                                  uint64_t mempool_sequence) {
-    auto event = [tx, reason, mempool_sequence, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.TransactionRemovedFromMempool(tx, reason,
-                                                    mempool_sequence);
-        });
+    auto event = [tx, reason,
+                  mempool_sequence](CValidationInterface &callbacks) {
+        callbacks.TransactionRemovedFromMempool(tx, reason, mempool_sequence);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s reason=%s", __func__,
                           tx->GetHash().ToString(),
@@ -241,31 +550,24 @@ void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef &tx,
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock,
                                   const CBlockIndex *pindex) {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.BlockConnected(pblock, pindex);
-        });
-    };
+    // Delivered with BlocksConnected, along with the next connected blocks
+    const ConnectedBlock event{pblock, pindex};
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
                           pblock->GetHash().ToString(), pindex->nHeight);
 }
 
 void CMainSignals::BlockDisconnected(
     const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex) {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.BlockDisconnected(pblock, pindex);
-        });
+    auto event = [pblock, pindex](CValidationInterface &callbacks) {
+        callbacks.BlockDisconnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           pblock->GetHash().ToString());
 }
 
 void CMainSignals::ChainStateFlushed(const CBlockLocator &locator) {
-    auto event = [locator, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.ChainStateFlushed(locator);
-        });
+    auto event = [locator](CValidationInterface &callbacks) {
+        callbacks.ChainStateFlushed(locator);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           locator.IsNull() ? "null"
@@ -290,10 +592,8 @@ void CMainSignals::NewPoWValidBlock(
 }
 
 void CMainSignals::BlockFinalized(const CBlockIndex *pindex) {
-    auto event = [pindex, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.BlockFinalized(pindex);
-        });
+    auto event = [pindex](CValidationInterface &callbacks) {
+        callbacks.BlockFinalized(pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           pindex ? pindex->GetBlockHash().ToString() : "null");
@@ -301,10 +601,8 @@ void CMainSignals::BlockFinalized(const CBlockIndex *pindex) {
 
 void CMainSignals::BlockInvalidated(
     const CBlockIndex *pindex, const std::shared_ptr<const CBlock> &block) {
-    auto event = [pindex, block, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.BlockInvalidated(pindex, block);
-        });
+    auto event = [pindex, block](CValidationInterface &callbacks) {
+        callbacks.BlockInvalidated(pindex, block);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           block ? block->GetHash().ToString() : "null");
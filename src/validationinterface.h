@@ -10,8 +10,12 @@
 #include <primitives/transaction.h> // CTransaction(Ref)
 #include <sync.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 class BlockValidationState;
 class CBlock;
@@ -46,6 +50,7 @@ void UnregisterSharedValidationInterface(
 /**
  * Pushes a function to callback onto the notification queue, guaranteeing any
  * callbacks generated prior to now are finished when the function is called.
+ * The callbacks generated after it wait for the function to return.
  *
  * Be very careful blocking on func to be called if any locks are held -
  * validation interface clients may not be able to make progress as they often
@@ -64,6 +69,22 @@ void CallFunctionInValidationInterfaceQueue(std::function<void()> func);
  */
 void SyncWithValidationInterfaceQueue() LOCKS_EXCLUDED(cs_main);
 
+/** A block connected to the active chain, as notified to the subscribers. */
+struct ConnectedBlock {
+    std::shared_ptr<const CBlock> block;
+    const CBlockIndex *pindex;
+};
+
+/** The state of the background events queue of a subscriber. */
+struct SubscriberQueueStats {
+    std::string name;
+    //! The events queued and not yet delivered
+    size_t pending;
+    //! The most events that were pending at the same time
+    size_t max_pending;
+    uint64_t delivered;
+};
+
 /**
  * Implement this to subscribe to events generated in validation
  *
@@ -77,7 +98,8 @@ void SyncWithValidationInterfaceQueue() LOCKS_EXCLUDED(cs_main);
  * UpdatedBlockTip() callback may depend on an operation performed in
  * the BlockConnected() callback without worrying about explicit
  * synchronization. No ordering should be assumed across
- * ValidationInterface() subscribers.
+ * ValidationInterface() subscribers: the background callbacks of the different
+ * subscribers run concurrently.
  */
 class CValidationInterface {
 protected:
@@ -152,6 +174,19 @@ protected:
      */
     virtual void BlockConnected(const std::shared_ptr<const CBlock> &block,
                                 const CBlockIndex *pindex) {}
+    /**
+     * Notifies listeners of several blocks being connected, in chain order.
+     * The BlockConnected notifications queued one after the other, e.g. during
+     * IBD, are delivered with this instead, so the listeners can write them in
+     * a single batch. By default, BlockConnected() is called for each block.
+     *
+     * Called on a background thread.
+     */
+    virtual void BlocksConnected(const std::vector<ConnectedBlock> &blocks) {
+        for (const ConnectedBlock &connected : blocks) {
+            BlockConnected(connected.block, connected.pindex);
+        }
+    }
     /**
      * Notifies listeners of a block being disconnected
      *
@@ -195,7 +230,11 @@ protected:
     virtual void BlockInvalidated(const CBlockIndex *pindex,
                                   const std::shared_ptr<const CBlock> &block){};
 
+    /** Identifies the subscriber in the queue stats and metrics. */
+    virtual std::string GetSubscriberName() const { return "unnamed"; }
+
     friend class CMainSignals;
+    friend class MainSignalsImpl;
     friend class ValidationInterfaceTest;
 };
 
@@ -225,7 +264,9 @@ public:
     /** Call any remaining callbacks on the calling thread */
     void FlushBackgroundCallbacks();
 
+    /** The number of background events not delivered to all subscribers. */
     size_t CallbacksPending();
+    std::vector<SubscriberQueueStats> GetSubscriberQueueStats();
 
     void UpdatedBlockTip(const CBlockIndex *, const CBlockIndex *,
                          bool fInitialDownload);
@@ -0,0 +1,151 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <validationthreadpool.h>
+
+#include <tinyformat.h>
+#include <util/threadnames.h>
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+
+ValidationThreadPool::~ValidationThreadPool() {
+    assert(m_threads.empty());
+}
+
+void ValidationThreadPool::AddWorkSource(Priority priority,
+                                         WorkSource source) {
+    assert(m_threads.empty());
+    m_sources.emplace_back(priority, std::move(source));
+    std::stable_sort(
+        m_sources.begin(), m_sources.end(),
+        [](const auto &a, const auto &b) { return a.first < b.first; });
+}
+
+void ValidationThreadPool::Submit(std::function<void()> task) {
+    if (Size() == 0) {
+        task();
+        return;
+    }
+    {
+        LOCK(m_mutex);
+        m_tasks.push_back(std::move(task));
+        ++m_epoch;
+    }
+    m_cv.notify_one();
+}
+
+void ValidationThreadPool::ParallelFor(
+    size_t count, const std::function<void(size_t)> &job) {
+    // Shared with the helping tasks, which may only get to run once all the
+    // calls are done, and then just return.
+    struct State {
+        Mutex mutex;
+        std::condition_variable cv;
+        size_t next GUARDED_BY(mutex){0};
+        int running GUARDED_BY(mutex){0};
+    };
+    const auto state{std::make_shared<State>()};
+    const auto run{[state, count, &job]() {
+        while (true) {
+            size_t i;
+            {
+                LOCK(state->mutex);
+                if (state->next >= count) {
+                    return;
+                }
+                i = state->next++;
+                ++state->running;
+            }
+            job(i);
+            LOCK(state->mutex);
+            --state->running;
+            state->cv.notify_all();
+        }
+    }};
+
+    const size_t helpers{std::min<size_t>(Size(), count > 0 ? count - 1 : 0)};
+    for (size_t n = 0; n < helpers; ++n) {
+        Submit(run);
+    }
+    run();
+
+    WAIT_LOCK(state->mutex, lock);
+    while (state->running > 0) {
+        state->cv.wait(lock);
+    }
+}
+
+void ValidationThreadPool::Notify() {
+    {
+        // Increment under the lock so a worker can't miss the wake up between
+        // checking the epoch and going to sleep.
+        LOCK(m_mutex);
+        ++m_epoch;
+    }
+    m_cv.notify_all();
+}
+
+bool ValidationThreadPool::RunOnce() {
+    for (const auto &[priority, source] : m_sources) {
+        if (source()) {
+            return true;
+        }
+    }
+
+    std::function<void()> task;
+    {
+        LOCK(m_mutex);
+        if (m_tasks.empty()) {
+            return false;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+    }
+    task();
+    return true;
+}
+
+void ValidationThreadPool::Loop() {
+    while (true) {
+        const uint64_t epoch = m_epoch.load();
+        if (WITH_LOCK(m_mutex, return m_request_stop)) {
+            return;
+        }
+        if (RunOnce()) {
+            continue;
+        }
+
+        WAIT_LOCK(m_mutex, lock);
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return m_request_stop || m_epoch.load() != epoch;
+        });
+    }
+}
+
+void ValidationThreadPool::Start(int threads_num) {
+    assert(m_threads.empty());
+    m_threads_num = threads_num;
+    for (int n = 0; n < threads_num; ++n) {
+        m_threads.emplace_back([this, n]() {
+            util::ThreadRename(strprintf("valcheck.%i", n));
+            Loop();
+        });
+    }
+}
+
+void ValidationThreadPool::Stop() {
+    m_threads_num = 0;
+    WITH_LOCK(m_mutex, m_request_stop = true);
+    m_cv.notify_all();
+    for (std::thread &t : m_threads) {
+        t.join();
+    }
+    m_threads.clear();
+    m_sources.clear();
+    LOCK(m_mutex);
+    m_tasks.clear();
+    m_request_stop = false;
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_VALIDATIONTHREADPOOL_H
+#define BITCOIN_VALIDATIONTHREADPOOL_H
+
+#include <sync.h>
+#include <threadsafety.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * A pool of worker threads shared by all the validation work: the block input
+ * reads, the script and proof of work check queues, and lower priority
+ * background tasks.
+ *
+ * Work is provided by work sources, which are polled in priority order each
+ * time a worker looks for something to do, so a worker always helps the most
+ * urgent job and no dedicated thread sits idle while another job could use
+ * it. Background tasks submitted to the pool only run when no work source has
+ * anything to do.
+ *
+ * Work sources must be added before the pool is started, and are removed when
+ * it is stopped. They must call Notify() whenever they get new work, so that
+ * sleeping workers wake up.
+ */
+class ValidationThreadPool {
+public:
+    //! The priority of a work source, lower values are served first.
+    enum class Priority : uint8_t {
+        INPUT_FETCH = 0,
+        SCRIPT_CHECK = 1,
+        POW_CHECK = 2,
+    };
+
+    /**
+     * Try to run one unit of work, returning whether some work was found.
+     * It must not block waiting for new work.
+     */
+    using WorkSource = std::function<bool()>;
+
+    ValidationThreadPool() = default;
+    ValidationThreadPool(const ValidationThreadPool &) = delete;
+    ValidationThreadPool &operator=(const ValidationThreadPool &) = delete;
+    ~ValidationThreadPool();
+
+    /** Add a work source. Only allowed while the pool is stopped. */
+    void AddWorkSource(Priority priority, WorkSource source);
+
+    /**
+     * Submit a background task, to be run when there is no higher priority
+     * work. If the pool has no thread, the task is run synchronously.
+     */
+    void Submit(std::function<void()> task) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Call job(i) for each i below count, on the calling thread helped by the
+     * idle workers, and return once all the calls are done. The calls are
+     * done in no particular order.
+     */
+    void ParallelFor(size_t count, const std::function<void(size_t)> &job)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Wake the workers up after new work became available. */
+    void Notify() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Start the worker threads. */
+    void Start(int threads_num) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Stop and join the worker threads, then drop the work sources and any
+     * pending background task.
+     */
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** The number of worker threads currently running. */
+    int Size() const { return m_threads_num.load(std::memory_order_relaxed); }
+
+private:
+    Mutex m_mutex;
+
+    //! Workers block on this when there is no work.
+    std::condition_variable m_cv;
+
+    //! The work sources, sorted by priority. Not modified while running.
+    std::vector<std::pair<Priority, WorkSource>> m_sources;
+
+    //! The pending background tasks.
+    std::deque<std::function<void()>> m_tasks GUARDED_BY(m_mutex);
+
+    //! Incremented every time new work is notified, so a worker can detect
+    //! work that arrived while it was looking for some.
+    std::atomic<uint64_t> m_epoch{0};
+
+    bool m_request_stop GUARDED_BY(m_mutex){false};
+
+    std::vector<std::thread> m_threads;
+    std::atomic<int> m_threads_num{0};
+
+    /** Run one unit of the highest priority work available, if any. */
+    bool RunOnce() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+#endif // BITCOIN_VALIDATIONTHREADPOOL_H
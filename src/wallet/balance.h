@@ -0,0 +1,80 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_BALANCE_H
+#define BITCOIN_WALLET_BALANCE_H
+
+#include <consensus/amount.h>
+#include <primitives/txid.h>
+
+#include <array>
+#include <map>
+#include <set>
+
+struct Balance {
+    //! Trusted, at depth=GetBalance.min_depth or more
+    Amount m_mine_trusted{Amount::zero()};
+    //! Untrusted, but in mempool (pending)
+    Amount m_mine_untrusted_pending{Amount::zero()};
+    //! Immature coinbases in the main chain
+    Amount m_mine_immature{Amount::zero()};
+    Amount m_watchonly_trusted{Amount::zero()};
+    Amount m_watchonly_untrusted_pending{Amount::zero()};
+    Amount m_watchonly_immature{Amount::zero()};
+
+    Balance &operator+=(const Balance &other) {
+        m_mine_trusted += other.m_mine_trusted;
+        m_mine_untrusted_pending += other.m_mine_untrusted_pending;
+        m_mine_immature += other.m_mine_immature;
+        m_watchonly_trusted += other.m_watchonly_trusted;
+        m_watchonly_untrusted_pending += other.m_watchonly_untrusted_pending;
+        m_watchonly_immature += other.m_watchonly_immature;
+        return *this;
+    }
+
+    Balance &operator-=(const Balance &other) {
+        m_mine_trusted -= other.m_mine_trusted;
+        m_mine_untrusted_pending -= other.m_mine_untrusted_pending;
+        m_mine_immature -= other.m_mine_immature;
+        m_watchonly_trusted -= other.m_watchonly_trusted;
+        m_watchonly_untrusted_pending -= other.m_watchonly_untrusted_pending;
+        m_watchonly_immature -= other.m_watchonly_immature;
+        return *this;
+    }
+};
+
+/**
+ * The wallet balance at min_depth 0, kept up to date as the wallet txs change
+ * instead of being summed over all of them on each query. It is indexed by
+ * avoid_reuse, see GetBalance.
+ *
+ * The contribution of each tx is accounted for again only if it may have
+ * changed: the txs are marked dirty along with their cached amounts, and the
+ * contribution of the unconfirmed txs and the immature coinbases, which
+ * depends on the chain tip and the mempool, is recomputed on every query.
+ * Confirmed txs being trusted at any depth, the contribution of the others
+ * only changes when their cached amounts do, or on reorgs which mark
+ * everything dirty.
+ */
+struct BalanceLedger {
+    std::array<Balance, 2> totals;
+    std::map<TxId, std::array<Balance, 2>> contributions;
+    //! Txs whose contribution depends on the chain tip or the mempool
+    std::set<TxId> volatile_txs;
+    std::set<TxId> dirty_txs;
+    bool all_dirty{true};
+
+    void MarkDirty(const TxId &txid) {
+        if (!all_dirty) {
+            dirty_txs.insert(txid);
+        }
+    }
+
+    void MarkAllDirty() {
+        all_dirty = true;
+        dirty_txs.clear();
+    }
+};
+
+#endif // BITCOIN_WALLET_BALANCE_H
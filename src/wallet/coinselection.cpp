@@ -11,7 +11,7 @@
 #include <util/insert.h>
 #include <util/moneystr.h>
 
-#include <optional>
+#include <algorithm>
 
 // Descending order comparator
 struct {
@@ -58,7 +58,8 @@ static const size_t TOTAL_TRIES = 100000;
  *
  * @param utxo_pool The set of UTXOs that we are choosing from. These UTXOs will
  *     be sorted in descending order by effective value and the CInputCoins'
- *     values are their effective values.
+ *     values are their effective values. The ones exceeding the upper bound
+ *     of the range on their own are removed.
  * @param target_value This is the value that we want to select.
  *     It is the lower bound of the range.
  * @param cost_of_change This is the cost of creating and spending a change
@@ -76,11 +77,25 @@ bool SelectCoinsBnB(std::vector<OutputGroup> &utxo_pool,
                     const Amount not_input_fees) {
     out_set.clear();
     Amount curr_value = Amount::zero();
+    Amount actual_target = not_input_fees + target_value;
+
+    // Sort the utxo_pool, unless it comes sorted already
+    if (!std::is_sorted(utxo_pool.begin(), utxo_pool.end(), descending)) {
+        std::sort(utxo_pool.begin(), utxo_pool.end(), descending);
+    }
+
+    // The utxos worth more than the upper bound of the range can't be part of
+    // any solution, don't spend tries on them
+    utxo_pool.erase(utxo_pool.begin(),
+                    std::find_if(utxo_pool.begin(), utxo_pool.end(),
+                                 [&](const OutputGroup &utxo) {
+                                     return utxo.effective_value <=
+                                            actual_target + cost_of_change;
+                                 }));
 
     // select the utxo at this index
     std::vector<bool> curr_selection;
     curr_selection.reserve(utxo_pool.size());
-    Amount actual_target = not_input_fees + target_value;
 
     // Calculate curr_available_value
     Amount curr_available_value = Amount::zero();
@@ -94,9 +109,6 @@ bool SelectCoinsBnB(std::vector<OutputGroup> &utxo_pool,
         return false;
     }
 
-    // Sort the utxo_pool
-    std::sort(utxo_pool.begin(), utxo_pool.end(), descending);
-
     Amount curr_waste = Amount::zero();
     std::vector<bool> best_selection;
     Amount best_waste = MAX_MONEY;
@@ -211,11 +223,11 @@ bool SelectCoinsBnB(std::vector<OutputGroup> &utxo_pool,
     return true;
 }
 
-static void ApproximateBestSubset(const std::vector<OutputGroup> &groups,
-                                  const Amount &nTotalLower,
-                                  const Amount &nTargetValue,
-                                  std::vector<char> &vfBest, Amount &nBest,
-                                  int iterations = 1000) {
+static void
+ApproximateBestSubset(const std::vector<const OutputGroup *> &groups,
+                      const Amount &nTotalLower, const Amount &nTargetValue,
+                      std::vector<char> &vfBest, Amount &nBest,
+                      int iterations = 1000) {
     std::vector<char> vfIncluded;
 
     vfBest.assign(groups.size(), true);
@@ -235,7 +247,7 @@ static void ApproximateBestSubset(const std::vector<OutputGroup> &groups,
                 // We do not use a constant random sequence, because there may
                 // be some privacy improvement by making the selection random.
                 if (nPass == 0 ? insecure_rand.randbool() : !vfIncluded[i]) {
-                    nTotal += groups[i].m_value;
+                    nTotal += groups[i]->m_value;
                     vfIncluded[i] = true;
                     if (nTotal >= nTargetValue) {
                         fReachedTarget = true;
@@ -244,7 +256,7 @@ static void ApproximateBestSubset(const std::vector<OutputGroup> &groups,
                             vfBest = vfIncluded;
                         }
 
-                        nTotal -= groups[i].m_value;
+                        nTotal -= groups[i]->m_value;
                         vfIncluded[i] = false;
                     }
                 }
@@ -258,9 +270,10 @@ bool KnapsackSolver(const Amount nTargetValue, std::vector<OutputGroup> &groups,
     setCoinsRet.clear();
     nValueRet = Amount::zero();
 
-    // List of values less than target
-    std::optional<OutputGroup> lowest_larger;
-    std::vector<OutputGroup> applicable_groups;
+    // List of values less than target. The groups are referred to rather than
+    // copied, as there can be a lot of them.
+    const OutputGroup *lowest_larger{nullptr};
+    std::vector<const OutputGroup *> applicable_groups;
     Amount nTotalLower = Amount::zero();
 
     Shuffle(groups.begin(), groups.end(), FastRandomContext());
@@ -271,17 +284,17 @@ bool KnapsackSolver(const Amount nTargetValue, std::vector<OutputGroup> &groups,
             nValueRet += group.m_value;
             return true;
         } else if (group.m_value < nTargetValue + MIN_CHANGE) {
-            applicable_groups.push_back(group);
+            applicable_groups.push_back(&group);
             nTotalLower += group.m_value;
         } else if (!lowest_larger || group.m_value < lowest_larger->m_value) {
-            lowest_larger = group;
+            lowest_larger = &group;
         }
     }
 
     if (nTotalLower == nTargetValue) {
-        for (const auto &group : applicable_groups) {
-            util::insert(setCoinsRet, group.m_outputs);
-            nValueRet += group.m_value;
+        for (const OutputGroup *group : applicable_groups) {
+            util::insert(setCoinsRet, group->m_outputs);
+            nValueRet += group->m_value;
         }
         return true;
     }
@@ -296,7 +309,10 @@ bool KnapsackSolver(const Amount nTargetValue, std::vector<OutputGroup> &groups,
     }
 
     // Solve subset sum by stochastic approximation
-    std::sort(applicable_groups.begin(), applicable_groups.end(), descending);
+    std::sort(applicable_groups.begin(), applicable_groups.end(),
+              [](const OutputGroup *a, const OutputGroup *b) {
+                  return descending(*a, *b);
+              });
     std::vector<char> vfBest;
     Amount nBest;
 
@@ -318,8 +334,8 @@ bool KnapsackSolver(const Amount nTargetValue, std::vector<OutputGroup> &groups,
     } else {
         for (size_t i = 0; i < applicable_groups.size(); i++) {
             if (vfBest[i]) {
-                util::insert(setCoinsRet, applicable_groups[i].m_outputs);
-                nValueRet += applicable_groups[i].m_value;
+                util::insert(setCoinsRet, applicable_groups[i]->m_outputs);
+                nValueRet += applicable_groups[i]->m_value;
             }
         }
 
@@ -332,7 +348,7 @@ bool KnapsackSolver(const Amount nTargetValue, std::vector<OutputGroup> &groups,
                     /* Continued */
                     LogPrintToBeContinued(
                         BCLog::SELECTCOINS, "%s ",
-                        FormatMoney(applicable_groups[i].m_value));
+                        FormatMoney(applicable_groups[i]->m_value));
                 }
             }
             LogPrint(BCLog::SELECTCOINS, "total %s\n", FormatMoney(nBest));
@@ -161,6 +161,35 @@ public:
     /** Make a DatabaseBatch connected to this database */
     virtual std::unique_ptr<DatabaseBatch>
     MakeBatch(bool flush_on_close = true) = 0;
+
+    /**
+     * Let the database coalesce the following writes into fewer transactions,
+     * until the matching EndWriteGroup. See DatabaseWriteGroup.
+     */
+    virtual void BeginWriteGroup() {}
+    virtual void EndWriteGroup() {}
+};
+
+/**
+ * RAII class grouping the writes of an operation writing many records, like
+ * a keypool top up or a rescan, so that the database doesn't sync each of them
+ * to disk on its own. The writes are durable once the group is destroyed.
+ *
+ * The writes of other users of the database while a group is alive are
+ * coalesced too, so groups should be kept short lived.
+ */
+class DatabaseWriteGroup {
+    WalletDatabase &m_database;
+
+public:
+    explicit DatabaseWriteGroup(WalletDatabase &database)
+        : m_database(database) {
+        m_database.BeginWriteGroup();
+    }
+    ~DatabaseWriteGroup() { m_database.EndWriteGroup(); }
+
+    DatabaseWriteGroup(const DatabaseWriteGroup &) = delete;
+    DatabaseWriteGroup &operator=(const DatabaseWriteGroup &) = delete;
 };
 
 /** RAII class that provides access to a DummyDatabase. Never fails. */
@@ -224,6 +253,10 @@ struct DatabaseOptions {
     uint64_t create_flags = 0;
     SecureString create_passphrase;
     bool verify = true;
+    //! Write-ahead logging for the SQLite databases, which syncs to disk less
+    bool use_wal = false;
+    //! Disable the syncs to disk of the SQLite databases. Unsafe.
+    bool use_unsafe_sync = false;
 };
 
 enum class DatabaseStatus {
@@ -158,7 +158,7 @@ void StartWallets(CScheduler &scheduler, const ArgsManager &args) {
                 MaybeCompactWalletDB();
                 return true;
             },
-            std::chrono::milliseconds{500});
+            std::chrono::milliseconds{500}, CScheduler::Priority::LOW);
     }
     scheduler.scheduleEvery(
         [] {
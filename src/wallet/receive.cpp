@@ -381,31 +381,91 @@ bool CachedTxIsTrusted(const CWallet &wallet, const CWalletTx &wtx) {
     return CachedTxIsTrusted(wallet, wtx, trusted_parents);
 }
 
-Balance GetBalance(const CWallet &wallet, const int min_depth,
-                   bool avoid_reuse) {
+static Balance GetTxBalance(const CWallet &wallet, const CWalletTx &wtx,
+                            const int min_depth, bool avoid_reuse,
+                            std::set<TxId> &trusted_parents)
+    EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet) {
     Balance ret;
     isminefilter reuse_filter = avoid_reuse ? ISMINE_NO : ISMINE_USED;
-    LOCK(wallet.cs_wallet);
+    const bool is_trusted{CachedTxIsTrusted(wallet, wtx, trusted_parents)};
+    const int tx_depth{wallet.GetTxDepthInMainChain(wtx)};
+    const Amount tx_credit_mine{CachedTxGetAvailableCredit(
+        wallet, wtx, /*fUseCache=*/true, ISMINE_SPENDABLE | reuse_filter)};
+    const Amount tx_credit_watchonly{CachedTxGetAvailableCredit(
+        wallet, wtx, /*fUseCache=*/true, ISMINE_WATCH_ONLY | reuse_filter)};
+    if (is_trusted && tx_depth >= min_depth) {
+        ret.m_mine_trusted += tx_credit_mine;
+        ret.m_watchonly_trusted += tx_credit_watchonly;
+    }
+    if (!is_trusted && tx_depth == 0 && wtx.InMempool()) {
+        ret.m_mine_untrusted_pending += tx_credit_mine;
+        ret.m_watchonly_untrusted_pending += tx_credit_watchonly;
+    }
+    ret.m_mine_immature += CachedTxGetImmatureCredit(wallet, wtx);
+    ret.m_watchonly_immature += CachedTxGetImmatureWatchOnlyCredit(wallet, wtx);
+    return ret;
+}
+
+/** Account again for the txs of the ledger which may have changed. */
+static void UpdateBalanceLedger(const CWallet &wallet)
+    EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet) {
+    BalanceLedger &ledger = wallet.m_balance_ledger;
+
+    std::set<TxId> txids;
+    if (ledger.all_dirty) {
+        ledger = BalanceLedger{};
+        ledger.all_dirty = false;
+        for (const auto &entry : wallet.mapWallet) {
+            txids.insert(txids.end(), entry.first);
+        }
+    } else {
+        txids.swap(ledger.dirty_txs);
+        txids.insert(ledger.volatile_txs.begin(), ledger.volatile_txs.end());
+    }
+
     std::set<TxId> trusted_parents;
-    for (const auto &entry : wallet.mapWallet) {
-        const CWalletTx &wtx = entry.second;
-        const bool is_trusted{CachedTxIsTrusted(wallet, wtx, trusted_parents)};
-        const int tx_depth{wallet.GetTxDepthInMainChain(wtx)};
-        const Amount tx_credit_mine{CachedTxGetAvailableCredit(
-            wallet, wtx, /*fUseCache=*/true, ISMINE_SPENDABLE | reuse_filter)};
-        const Amount tx_credit_watchonly{CachedTxGetAvailableCredit(
-            wallet, wtx, /*fUseCache=*/true, ISMINE_WATCH_ONLY | reuse_filter)};
-        if (is_trusted && tx_depth >= min_depth) {
-            ret.m_mine_trusted += tx_credit_mine;
-            ret.m_watchonly_trusted += tx_credit_watchonly;
+    for (const TxId &txid : txids) {
+        auto it = ledger.contributions.find(txid);
+        if (it != ledger.contributions.end()) {
+            for (size_t i = 0; i < ledger.totals.size(); ++i) {
+                ledger.totals[i] -= it->second[i];
+            }
+            ledger.contributions.erase(it);
+        }
+        ledger.volatile_txs.erase(txid);
+
+        const CWalletTx *wtx = wallet.GetWalletTx(txid);
+        if (!wtx) {
+            continue;
+        }
+        std::array<Balance, 2> contribution;
+        for (size_t i = 0; i < contribution.size(); ++i) {
+            contribution[i] =
+                GetTxBalance(wallet, *wtx, /*min_depth=*/0,
+                             /*avoid_reuse=*/i != 0, trusted_parents);
+            ledger.totals[i] += contribution[i];
         }
-        if (!is_trusted && tx_depth == 0 && wtx.InMempool()) {
-            ret.m_mine_untrusted_pending += tx_credit_mine;
-            ret.m_watchonly_untrusted_pending += tx_credit_watchonly;
+        ledger.contributions.emplace(txid, contribution);
+        if (wallet.GetTxDepthInMainChain(*wtx) == 0 ||
+            wallet.IsTxImmatureCoinBase(*wtx)) {
+            ledger.volatile_txs.insert(txid);
         }
-        ret.m_mine_immature += CachedTxGetImmatureCredit(wallet, wtx);
-        ret.m_watchonly_immature +=
-            CachedTxGetImmatureWatchOnlyCredit(wallet, wtx);
+    }
+}
+
+Balance GetBalance(const CWallet &wallet, const int min_depth,
+                   bool avoid_reuse) {
+    LOCK(wallet.cs_wallet);
+    if (min_depth == 0) {
+        UpdateBalanceLedger(wallet);
+        return wallet.m_balance_ledger.totals[avoid_reuse];
+    }
+
+    Balance ret;
+    std::set<TxId> trusted_parents;
+    for (const auto &entry : wallet.mapWallet) {
+        ret += GetTxBalance(wallet, entry.second, min_depth, avoid_reuse,
+                            trusted_parents);
     }
     return ret;
 }
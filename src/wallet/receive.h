@@ -6,6 +6,7 @@
 #define BITCOIN_WALLET_RECEIVE_H
 
 #include <consensus/amount.h>
+#include <wallet/balance.h>
 #include <wallet/ismine.h>
 #include <wallet/transaction.h>
 #include <wallet/wallet.h>
@@ -66,18 +67,6 @@ bool CachedTxIsTrusted(const CWallet &wallet, const CWalletTx &wtx,
     EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet);
 bool CachedTxIsTrusted(const CWallet &wallet, const CWalletTx &wtx);
 
-struct Balance {
-    //! Trusted, at depth=GetBalance.min_depth or more
-    Amount m_mine_trusted{Amount::zero()};
-    //! Untrusted, but in mempool (pending)
-    Amount m_mine_untrusted_pending{Amount::zero()};
-    //! Immature coinbases in the main chain
-    Amount m_mine_immature{Amount::zero()};
-    Amount m_watchonly_trusted{Amount::zero()};
-    Amount m_watchonly_untrusted_pending{Amount::zero()};
-    Amount m_watchonly_immature{Amount::zero()};
-};
-
 Balance GetBalance(const CWallet &wallet, int min_depth = 0,
                    bool avoid_reuse = true);
 
@@ -1891,6 +1891,7 @@ RPCHelpMan importmulti() {
 
                 const int64_t minimumTimestamp = 1;
 
+                DatabaseWriteGroup write_group(pwallet->GetDatabase());
                 for (const UniValue &data : requests.getValues()) {
                     const int64_t timestamp = std::max(
                         GetImportTimestamp(data, now), minimumTimestamp);
@@ -16,10 +16,15 @@
 #include <util/translation.h>
 #include <wallet/scriptpubkeyman.h>
 
+#include <algorithm>
+
 //! Value for the first BIP 32 hardened derivation. Can be used as a bit mask
 //! and as a value. See BIP 32 for more details.
 const uint32_t BIP32_HARDENED_KEY_LIMIT = 0x80000000;
 
+//! Below this many indexes to derive, TopUp doesn't spawn threads
+static constexpr int32_t TOPUP_PARALLEL_MIN_INDEXES{256};
+
 bool LegacyScriptPubKeyMan::GetNewDestination(const OutputType type,
                                               CTxDestination &dest,
                                               std::string &error) {
@@ -573,6 +578,7 @@ TransactionError
 LegacyScriptPubKeyMan::FillPSBT(PartiallySignedTransaction &psbtx,
                                 SigHashType sighash_type, bool sign,
                                 bool bip32derivs) const {
+    const PrecomputedTransactionData txdata(*psbtx.tx);
     for (size_t i = 0; i < psbtx.tx->vin.size(); ++i) {
         PSBTInput &input = psbtx.inputs.at(i);
 
@@ -593,7 +599,8 @@ LegacyScriptPubKeyMan::FillPSBT(PartiallySignedTransaction &psbtx,
         SignatureData sigdata;
         input.FillSignatureData(sigdata);
         SignPSBTInput(HidingSigningProvider(this, !sign, !bip32derivs), psbtx,
-                      i, sighash_type);
+                      i, sighash_type, /*out_sigdata=*/nullptr,
+                      /*use_dummy=*/false, &txdata);
     }
 
     // Fill in the bip32 keypaths and redeemscripts for the outputs so that
@@ -1253,6 +1260,7 @@ bool LegacyScriptPubKeyMan::TopUp(unsigned int kpSize) {
             missingInternal = 0;
         }
         bool internal = false;
+        DatabaseWriteGroup write_group(m_storage.GetDatabase());
         WalletBatch batch(m_storage.GetDatabase());
         for (int64_t i = missingInternal + missingExternal; i--;) {
             if (i < missingInternal) {
@@ -1798,6 +1806,16 @@ std::map<CKeyID, CKey> DescriptorScriptPubKeyMan::GetKeys() const {
     return m_map_keys;
 }
 
+namespace {
+/** The scripts and keys of a descriptor index, as derived by TopUp. */
+struct ExpandedIndex {
+    bool success{false};
+    std::vector<CScript> scripts;
+    FlatSigningProvider out_keys;
+    DescriptorCache temp_cache;
+};
+} // namespace
+
 bool DescriptorScriptPubKeyMan::TopUp(unsigned int size) {
     LOCK(cs_desc_man);
     unsigned int target_size;
@@ -1824,20 +1842,47 @@ bool DescriptorScriptPubKeyMan::TopUp(unsigned int size) {
     FlatSigningProvider provider;
     provider.keys = GetKeys();
 
+    DatabaseWriteGroup write_group(m_storage.GetDatabase());
     WalletBatch batch(m_storage.GetDatabase());
     uint256 id = GetID();
-    for (int32_t i = m_max_cached_index + 1; i < new_range_end; ++i) {
-        FlatSigningProvider out_keys;
-        std::vector<CScript> scripts_temp;
-        DescriptorCache temp_cache;
+    const Descriptor &descriptor = *m_wallet_descriptor.descriptor;
+    const DescriptorCache &cache = m_wallet_descriptor.cache;
+    auto expand = [&](int32_t i, ExpandedIndex &expanded) {
         // Maybe we have a cached xpub and we can expand from the cache first
-        if (!m_wallet_descriptor.descriptor->ExpandFromCache(
-                i, m_wallet_descriptor.cache, scripts_temp, out_keys)) {
-            if (!m_wallet_descriptor.descriptor->Expand(
-                    i, provider, scripts_temp, out_keys, &temp_cache)) {
-                return false;
-            }
+        expanded.success =
+            descriptor.ExpandFromCache(i, cache, expanded.scripts,
+                                       expanded.out_keys) ||
+            descriptor.Expand(i, provider, expanded.scripts,
+                              expanded.out_keys, &expanded.temp_cache);
+    };
+
+    // The first index is expanded on its own: once its parent xpubs are
+    // cached, the other indexes only need a non-hardened derivation from them,
+    // so they are expanded in parallel and then added in order.
+    const int32_t first_index{m_max_cached_index + 1};
+    std::vector<ExpandedIndex> expanded_indexes;
+    for (int32_t i = first_index; i < new_range_end; ++i) {
+        if (i == first_index + 1 &&
+            new_range_end - i >= TOPUP_PARALLEL_MIN_INDEXES) {
+            expanded_indexes.resize(new_range_end - i);
+            ForEachInParallel(expanded_indexes.size(),
+                              TOPUP_PARALLEL_MIN_INDEXES, [&](size_t pos) {
+                                  expand(i + pos, expanded_indexes[pos]);
+                              });
+        }
+        ExpandedIndex single;
+        if (expanded_indexes.empty()) {
+            expand(i, single);
+        }
+        const ExpandedIndex &expanded =
+            expanded_indexes.empty() ? single
+                                     : expanded_indexes[i - first_index - 1];
+        if (!expanded.success) {
+            return false;
         }
+        const std::vector<CScript> &scripts_temp = expanded.scripts;
+        const FlatSigningProvider &out_keys = expanded.out_keys;
+        const DescriptorCache &temp_cache = expanded.temp_cache;
         // Add all of the scriptPubKeys to the scriptPubKey set
         for (const CScript &script : scripts_temp) {
             m_map_script_pub_keys[script] = i;
@@ -2188,6 +2233,7 @@ TransactionError
 DescriptorScriptPubKeyMan::FillPSBT(PartiallySignedTransaction &psbtx,
                                     SigHashType sighash_type, bool sign,
                                     bool bip32derivs) const {
+    const PrecomputedTransactionData txdata(*psbtx.tx);
     for (size_t i = 0; i < psbtx.tx->vin.size(); ++i) {
         PSBTInput &input = psbtx.inputs.at(i);
 
@@ -2232,7 +2278,8 @@ DescriptorScriptPubKeyMan::FillPSBT(PartiallySignedTransaction &psbtx,
         }
 
         SignPSBTInput(HidingSigningProvider(keys.get(), !sign, !bip32derivs),
-                      psbtx, i, sighash_type);
+                      psbtx, i, sighash_type, /*out_sigdata=*/nullptr,
+                      /*use_dummy=*/false, &txdata);
     }
 
     // Fill in the bip32 keypaths and redeemscripts for the outputs so that
@@ -2372,6 +2419,23 @@ const std::vector<CScript> DescriptorScriptPubKeyMan::GetScriptPubKeys() const {
     return script_pub_keys;
 }
 
+std::vector<CScript>
+DescriptorScriptPubKeyMan::GetScriptPubKeys(int32_t minimum_index) const {
+    LOCK(cs_desc_man);
+    std::vector<CScript> script_pub_keys;
+    for (const auto &[script_pub_key, index] : m_map_script_pub_keys) {
+        if (index >= minimum_index) {
+            script_pub_keys.push_back(script_pub_key);
+        }
+    }
+    return script_pub_keys;
+}
+
+int32_t DescriptorScriptPubKeyMan::GetEndRange() const {
+    LOCK(cs_desc_man);
+    return m_max_cached_index + 1;
+}
+
 void DescriptorScriptPubKeyMan::UpdateWalletDescriptor(
     WalletDescriptor &descriptor) {
     LOCK(cs_desc_man);
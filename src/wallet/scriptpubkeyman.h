@@ -784,6 +784,10 @@ public:
     const WalletDescriptor GetWalletDescriptor() const
         EXCLUSIVE_LOCKS_REQUIRED(cs_desc_man);
     const std::vector<CScript> GetScriptPubKeys() const;
+    //! The scripts derived from the given index of the descriptor onwards
+    std::vector<CScript> GetScriptPubKeys(int32_t minimum_index) const;
+    //! One past the last index the scripts are derived for
+    int32_t GetEndRange() const;
 };
 
 #endif // BITCOIN_WALLET_SCRIPTPUBKEYMAN_H
@@ -19,6 +19,8 @@
 #include <wallet/transaction.h>
 #include <wallet/wallet.h>
 
+#include <algorithm>
+
 using interfaces::FoundBlock;
 
 static const size_t OUTPUT_GROUP_MAX_ENTRIES = 10;
@@ -70,6 +72,41 @@ int64_t CalculateMaximumSignedTxSize(const CTransaction &tx,
     return CalculateMaximumSignedTxSize(tx, wallet, txouts, use_max_sig);
 }
 
+/** Look again at the outputs of the txs of the index which may have changed. */
+static void UpdateUnspentIndex(const CWallet &wallet)
+    EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet) {
+    UnspentIndex &index = wallet.m_unspent_index;
+
+    std::set<TxId> txids;
+    if (index.all_dirty) {
+        index = UnspentIndex{};
+        index.all_dirty = false;
+        for (const auto &entry : wallet.mapWallet) {
+            txids.insert(txids.end(), entry.first);
+        }
+    } else {
+        txids.swap(index.dirty_txs);
+    }
+
+    for (const TxId &txid : txids) {
+        index.outputs.erase(txid);
+        const CWalletTx *wtx = wallet.GetWalletTx(txid);
+        if (!wtx) {
+            continue;
+        }
+        std::set<uint32_t> unspent;
+        for (uint32_t i = 0; i < wtx->tx->vout.size(); i++) {
+            if (wallet.IsMine(wtx->tx->vout[i]) != ISMINE_NO &&
+                !wallet.IsSpent(COutPoint(txid, i))) {
+                unspent.insert(unspent.end(), i);
+            }
+        }
+        if (!unspent.empty()) {
+            index.outputs.emplace(txid, std::move(unspent));
+        }
+    }
+}
+
 void AvailableCoins(const CWallet &wallet, std::vector<COutput> &vCoins,
                     const CCoinControl *coinControl,
                     const Amount nMinimumAmount, const Amount nMaximumAmount,
@@ -93,10 +130,16 @@ void AvailableCoins(const CWallet &wallet, std::vector<COutput> &vCoins,
     const bool only_safe = {coinControl ? !coinControl->m_include_unsafe_inputs
                                         : true};
 
+    UpdateUnspentIndex(wallet);
+
     std::set<TxId> trusted_parents;
-    for (const auto &entry : wallet.mapWallet) {
-        const TxId &wtxid = entry.first;
-        const CWalletTx &wtx = entry.second;
+    for (const auto &[wtxid, unspent_outputs] :
+         wallet.m_unspent_index.outputs) {
+        const CWalletTx *pwtx = wallet.GetWalletTx(wtxid);
+        if (!pwtx) {
+            continue;
+        }
+        const CWalletTx &wtx = *pwtx;
 
         if (wallet.IsTxImmatureCoinBase(wtx)) {
             continue;
@@ -144,10 +187,10 @@ void AvailableCoins(const CWallet &wallet, std::vector<COutput> &vCoins,
             continue;
         }
 
-        for (uint32_t i = 0; i < wtx.tx->vout.size(); i++) {
+        for (const uint32_t i : unspent_outputs) {
             // Only consider selected coins if add_inputs is false
             if (coinControl && !coinControl->m_add_inputs &&
-                !coinControl->IsSelected(COutPoint(entry.first, i))) {
+                !coinControl->IsSelected(COutPoint(wtxid, i))) {
                 continue;
             }
 
@@ -332,7 +375,7 @@ GroupOutputs(const CWallet &wallet, const std::vector<COutput> &outputs,
             }
             if (group.m_outputs.size() > 0 &&
                 group.EligibleForSpending(filter)) {
-                groups_out.push_back(group);
+                groups_out.push_back(std::move(group));
             }
         }
         return groups_out;
@@ -421,7 +464,7 @@ GroupOutputs(const CWallet &wallet, const std::vector<COutput> &outputs,
 
 bool SelectCoinsMinConf(const CWallet &wallet, const Amount nTargetValue,
                         const CoinEligibilityFilter &eligibility_filter,
-                        std::vector<COutput> coins,
+                        const std::vector<COutput> &coins,
                         std::set<CInputCoin> &setCoinsRet, Amount &nValueRet,
                         const CoinSelectionParams &coin_selection_params,
                         bool &bnb_used) {
@@ -546,6 +589,16 @@ bool SelectCoins(const CWallet &wallet,
         }
     }
 
+    if (!coin_control.m_avoid_partial_spends) {
+        // Sort the coins once by decreasing value, so that the groups of the
+        // attempts below are already sorted for BnB in most cases.
+        std::sort(vCoins.begin(), vCoins.end(),
+                  [](const COutput &a, const COutput &b) {
+                      return a.tx->tx->vout[a.i].nValue >
+                             b.tx->tx->vout[b.i].nValue;
+                  });
+    }
+
     // form groups from remaining coins; note that preset coins will not
     // automatically have their associated (same address) coins included
     if (coin_control.m_avoid_partial_spends &&
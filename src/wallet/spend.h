@@ -140,7 +140,7 @@ GroupOutputs(const CWallet &wallet, const std::vector<COutput> &outputs,
  */
 bool SelectCoinsMinConf(const CWallet &wallet, const Amount nTargetValue,
                         const CoinEligibilityFilter &eligibility_filter,
-                        std::vector<COutput> coins,
+                        const std::vector<COutput> &coins,
                         std::set<CInputCoin> &setCoinsRet, Amount &nValueRet,
                         const CoinSelectionParams &coin_selection_params,
                         bool &bnb_used);
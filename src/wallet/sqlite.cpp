@@ -30,9 +30,11 @@ static void ErrorLogCallback(void *arg, int code, const char *msg) {
 }
 
 SQLiteDatabase::SQLiteDatabase(const fs::path &dir_path,
-                               const fs::path &file_path, bool mock)
+                               const fs::path &file_path,
+                               const DatabaseOptions &options, bool mock)
     : WalletDatabase(), m_mock(mock), m_dir_path(fs::PathToString(dir_path)),
-      m_file_path(fs::PathToString(file_path)) {
+      m_file_path(fs::PathToString(file_path)), m_use_wal(options.use_wal),
+      m_use_unsafe_sync(options.use_unsafe_sync) {
     {
         LOCK(g_sqlite_mutex);
         LogPrintf("Using SQLite Version %s\n", SQLiteDatabaseVersion());
@@ -234,6 +236,30 @@ void SQLiteDatabase::Open() {
                       sqlite3_errstr(ret)));
     }
 
+    if (m_use_wal) {
+        // Only the write-ahead log is synced on commit. With the exclusive
+        // locking mode, no shared memory file is needed.
+        ret = sqlite3_exec(m_db, "PRAGMA journal_mode = WAL", nullptr, nullptr,
+                           nullptr);
+        if (ret != SQLITE_OK) {
+            throw std::runtime_error(strprintf(
+                "SQLiteDatabase: Failed to enable write-ahead logging: %s\n",
+                sqlite3_errstr(ret)));
+        }
+    }
+
+    if (m_use_unsafe_sync) {
+        LogPrintf("WARNING SQLite is configured to not wait for data to be "
+                  "flushed to disk. Data loss and corruption may occur.\n");
+        ret = sqlite3_exec(m_db, "PRAGMA synchronous = OFF", nullptr, nullptr,
+                           nullptr);
+        if (ret != SQLITE_OK) {
+            throw std::runtime_error(strprintf(
+                "SQLiteDatabase: Failed to set synchronous mode to OFF: %s\n",
+                sqlite3_errstr(ret)));
+        }
+    }
+
     // Make the table for our key-value pairs
     // First check that the main table exists
     sqlite3_stmt *check_main_stmt{nullptr};
@@ -316,6 +342,7 @@ bool SQLiteDatabase::Backup(const std::string &dest) const {
 }
 
 void SQLiteDatabase::Close() {
+    WITH_LOCK(m_write_group_mutex, CommitWriteGroup());
     int res = sqlite3_close(m_db);
     if (res != SQLITE_OK) {
         throw std::runtime_error(
@@ -330,6 +357,70 @@ std::unique_ptr<DatabaseBatch> SQLiteDatabase::MakeBatch(bool flush_on_close) {
     return std::make_unique<SQLiteBatch>(*this);
 }
 
+void SQLiteDatabase::BeginWriteGroup() {
+    LOCK(m_write_group_mutex);
+    ++m_write_group_depth;
+}
+
+void SQLiteDatabase::EndWriteGroup() {
+    LOCK(m_write_group_mutex);
+    assert(m_write_group_depth > 0);
+    if (--m_write_group_depth == 0) {
+        CommitWriteGroup();
+    }
+}
+
+void SQLiteDatabase::BeforeWrite() {
+    LOCK(m_write_group_mutex);
+    // The writes done in a transaction opened with TxnBegin are left to it
+    if (m_write_group_depth == 0 || m_write_group_txn || !m_db ||
+        sqlite3_get_autocommit(m_db) == 0) {
+        return;
+    }
+    int res =
+        sqlite3_exec(m_db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+    if (res != SQLITE_OK) {
+        // The write is done on its own
+        LogPrintf("SQLiteDatabase: Failed to begin the write group "
+                  "transaction: %s\n",
+                  sqlite3_errstr(res));
+        return;
+    }
+    m_write_group_txn = true;
+    m_write_group_writes = 0;
+}
+
+void SQLiteDatabase::AfterWrite() {
+    LOCK(m_write_group_mutex);
+    if (m_write_group_txn && ++m_write_group_writes >= MAX_WRITE_GROUP_WRITES) {
+        CommitWriteGroup();
+    }
+}
+
+void SQLiteDatabase::FlushWriteGroup() {
+    LOCK(m_write_group_mutex);
+    CommitWriteGroup();
+}
+
+void SQLiteDatabase::CommitWriteGroup() {
+    AssertLockHeld(m_write_group_mutex);
+    if (!m_write_group_txn) {
+        return;
+    }
+    m_write_group_txn = false;
+    int res =
+        sqlite3_exec(m_db, "COMMIT TRANSACTION", nullptr, nullptr, nullptr);
+    if (res != SQLITE_OK) {
+        LogPrintf("SQLiteDatabase: Failed to commit the write group "
+                  "transaction: %s\n",
+                  sqlite3_errstr(res));
+        if (sqlite3_get_autocommit(m_db) == 0) {
+            sqlite3_exec(m_db, "ROLLBACK TRANSACTION", nullptr, nullptr,
+                         nullptr);
+        }
+    }
+}
+
 SQLiteBatch::SQLiteBatch(SQLiteDatabase &database) : m_database(database) {
     // Make sure we have a db handle
     assert(m_database.m_db);
@@ -338,9 +429,9 @@ SQLiteBatch::SQLiteBatch(SQLiteDatabase &database) : m_database(database) {
 }
 
 void SQLiteBatch::Close() {
-    // If m_db is in a transaction (i.e. not in autocommit mode), then abort the
-    // transaction in progress
-    if (m_database.m_db && sqlite3_get_autocommit(m_database.m_db) == 0) {
+    // If this batch opened a transaction, then abort the transaction in
+    // progress. The one of a write group is left alone.
+    if (m_database.m_db && m_txn) {
         if (TxnAbort()) {
             LogPrintf("SQLiteBatch: Batch closed unexpectedly without the "
                       "transaction being explicitly committed or aborted\n");
@@ -459,7 +550,9 @@ bool SQLiteBatch::WriteKey(CDataStream &&key, CDataStream &&value,
     }
 
     // Execute
+    m_database.BeforeWrite();
     res = sqlite3_step(stmt);
+    m_database.AfterWrite();
     sqlite3_clear_bindings(stmt);
     sqlite3_reset(stmt);
     if (res != SQLITE_DONE) {
@@ -487,7 +580,9 @@ bool SQLiteBatch::EraseKey(CDataStream &&key) {
     }
 
     // Execute
+    m_database.BeforeWrite();
     res = sqlite3_step(m_delete_stmt);
+    m_database.AfterWrite();
     sqlite3_clear_bindings(m_delete_stmt);
     sqlite3_reset(m_delete_stmt);
     if (res != SQLITE_DONE) {
@@ -564,37 +659,48 @@ void SQLiteBatch::CloseCursor() {
 }
 
 bool SQLiteBatch::TxnBegin() {
-    if (!m_database.m_db || sqlite3_get_autocommit(m_database.m_db) == 0) {
+    if (!m_database.m_db) {
+        return false;
+    }
+    // The pending writes of a write group don't belong to this transaction
+    m_database.FlushWriteGroup();
+    if (sqlite3_get_autocommit(m_database.m_db) == 0) {
         return false;
     }
     int res = sqlite3_exec(m_database.m_db, "BEGIN TRANSACTION", nullptr,
                            nullptr, nullptr);
     if (res != SQLITE_OK) {
         LogPrintf("SQLiteBatch: Failed to begin the transaction\n");
+    } else {
+        m_txn = true;
     }
     return res == SQLITE_OK;
 }
 
 bool SQLiteBatch::TxnCommit() {
-    if (!m_database.m_db || sqlite3_get_autocommit(m_database.m_db) != 0) {
+    if (!m_database.m_db || !m_txn) {
         return false;
     }
     int res = sqlite3_exec(m_database.m_db, "COMMIT TRANSACTION", nullptr,
                            nullptr, nullptr);
     if (res != SQLITE_OK) {
         LogPrintf("SQLiteBatch: Failed to commit the transaction\n");
+    } else {
+        m_txn = false;
     }
     return res == SQLITE_OK;
 }
 
 bool SQLiteBatch::TxnAbort() {
-    if (!m_database.m_db || sqlite3_get_autocommit(m_database.m_db) != 0) {
+    if (!m_database.m_db || !m_txn) {
         return false;
     }
     int res = sqlite3_exec(m_database.m_db, "ROLLBACK TRANSACTION", nullptr,
                            nullptr, nullptr);
     if (res != SQLITE_OK) {
         LogPrintf("SQLiteBatch: Failed to abort the transaction\n");
+    } else {
+        m_txn = false;
     }
     return res == SQLITE_OK;
 }
@@ -608,7 +714,7 @@ MakeSQLiteDatabase(const fs::path &path, const DatabaseOptions &options,
                    DatabaseStatus &status, bilingual_str &error) {
     const fs::path file = path / DATABASE_FILENAME;
     try {
-        auto db = std::make_unique<SQLiteDatabase>(path, file);
+        auto db = std::make_unique<SQLiteDatabase>(path, file, options);
         if (options.verify && !db->Verify(error)) {
             status = DatabaseStatus::FAILED_VERIFY;
             return nullptr;
@@ -5,6 +5,8 @@
 #ifndef BITCOIN_WALLET_SQLITE_H
 #define BITCOIN_WALLET_SQLITE_H
 
+#include <sync.h>
+#include <threadsafety.h>
 #include <wallet/db.h>
 
 #include <sqlite3.h>
@@ -18,6 +20,8 @@ private:
     SQLiteDatabase &m_database;
 
     bool m_cursor_init = false;
+    //! Whether this batch opened a transaction with TxnBegin
+    bool m_txn = false;
 
     sqlite3_stmt *m_read_stmt{nullptr};
     sqlite3_stmt *m_insert_stmt{nullptr};
@@ -60,14 +64,30 @@ private:
 
     const std::string m_file_path;
 
+    const bool m_use_wal;
+    const bool m_use_unsafe_sync;
+
+    Mutex m_write_group_mutex;
+    //! How many write groups are alive, see DatabaseWriteGroup
+    int m_write_group_depth GUARDED_BY(m_write_group_mutex){0};
+    //! Whether the writes of the groups are pending in an open transaction
+    bool m_write_group_txn GUARDED_BY(m_write_group_mutex){false};
+    //! How many writes are pending in that transaction
+    int m_write_group_writes GUARDED_BY(m_write_group_mutex){0};
+
     void Cleanup() noexcept;
 
+    void CommitWriteGroup() EXCLUSIVE_LOCKS_REQUIRED(m_write_group_mutex);
+
 public:
+    //! Writes after which the pending writes of a group are committed anyway
+    static constexpr int MAX_WRITE_GROUP_WRITES{1000};
+
     SQLiteDatabase() = delete;
 
     /** Create DB handle to real database */
     SQLiteDatabase(const fs::path &dir_path, const fs::path &file_path,
-                   bool mock = false);
+                   const DatabaseOptions &options, bool mock = false);
 
     ~SQLiteDatabase();
 
@@ -94,8 +114,8 @@ public:
      *
      * SQLite always flushes everything to the database file after each
      * transaction (each Read/Write/Erase that we do is its own transaction
-     * unless we called TxnBegin) so there is no need to have Flush or Periodic
-     * Flush.
+     * unless we called TxnBegin or a write group is alive) so there is no need
+     * to have Flush or Periodic Flush.
      *
      * There is no DB env to reload, so ReloadDbEnv has nothing to do
      */
@@ -111,6 +131,22 @@ public:
     std::unique_ptr<DatabaseBatch>
     MakeBatch(bool flush_on_close = true) override;
 
+    void BeginWriteGroup() override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_write_group_mutex);
+    void EndWriteGroup() override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_write_group_mutex);
+
+    /**
+     * Called by the batches around each of their writes. While a write group
+     * is alive, the writes are done in a transaction committed at the end of
+     * the group, or after MAX_WRITE_GROUP_WRITES of them.
+     */
+    void BeforeWrite() EXCLUSIVE_LOCKS_REQUIRED(!m_write_group_mutex);
+    void AfterWrite() EXCLUSIVE_LOCKS_REQUIRED(!m_write_group_mutex);
+
+    /** Commit the pending writes of the groups, before a TxnBegin. */
+    void FlushWriteGroup() EXCLUSIVE_LOCKS_REQUIRED(!m_write_group_mutex);
+
     sqlite3 *m_db{nullptr};
 };
 
@@ -4,6 +4,7 @@
 
 #include <chainparams.h>
 #include <key.h>
+#include <script/descriptor.h>
 #include <script/standard.h>
 #include <test/util/setup_common.h>
 #include <wallet/scriptpubkeyman.h>
@@ -11,6 +12,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+
 BOOST_FIXTURE_TEST_SUITE(scriptpubkeyman_tests, BasicTestingSetup)
 
 // Test LegacyScriptPubKeyMan::CanProvide behavior, making sure it returns true
@@ -38,4 +41,43 @@ BOOST_AUTO_TEST_CASE(CanProvide) {
     BOOST_CHECK(keyman.CanProvide(p2sh_script, data));
 }
 
+// Test that the keys DescriptorScriptPubKeyMan::TopUp derives in parallel are
+// the ones of their index.
+BOOST_AUTO_TEST_CASE(DescriptorTopUp) {
+    CWallet wallet(m_node.chain.get(), "", CreateDummyWalletDatabase());
+
+    FlatSigningProvider keys;
+    std::string error;
+    std::shared_ptr<Descriptor> desc =
+        Parse("pkh([ffffffff/13']"
+              "dgub8onvpqfirXo6x1VfyK8fFFc3giBinw5ggDAFcsvBoEtwP3pcHMM1eKrDqfh6"
+              "KZWhRQSkEDG38ogimxJpDjULZQy8qoFWjKfncYaPesrSURc/1/2/*)",
+              keys, error);
+    BOOST_REQUIRE(desc);
+    WalletDescriptor w_desc(desc, 0, 0, 0, 0);
+    DescriptorScriptPubKeyMan keyman(wallet, w_desc);
+
+    const int32_t size{1000};
+    BOOST_CHECK(keyman.TopUp(size));
+    BOOST_CHECK_EQUAL(keyman.GetEndRange(), size);
+    const std::vector<CScript> scripts{keyman.GetScriptPubKeys()};
+    BOOST_CHECK_EQUAL(scripts.size(), size);
+
+    for (int32_t i = 0; i < size; ++i) {
+        std::vector<CScript> expected;
+        FlatSigningProvider out_keys;
+        BOOST_REQUIRE(desc->Expand(i, keys, expected, out_keys));
+        BOOST_REQUIRE_EQUAL(expected.size(), 1U);
+        // The script is mapped to index i: it is in the scripts from i on,
+        // but not in those from i + 1 on.
+        const std::vector<CScript> from_i{keyman.GetScriptPubKeys(i)};
+        const std::vector<CScript> after_i{keyman.GetScriptPubKeys(i + 1)};
+        BOOST_CHECK_EQUAL(from_i.size(), size - i);
+        BOOST_CHECK(std::count(from_i.begin(), from_i.end(), expected[0]) ==
+                    1);
+        BOOST_CHECK(std::count(after_i.begin(), after_i.end(), expected[0]) ==
+                    0);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -687,6 +687,76 @@ BOOST_FIXTURE_TEST_CASE(ListCoinsTest, ListCoinsTestingSetup) {
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2U);
 }
 
+static void CheckBalanceEqual(const Balance &a, const Balance &b) {
+    BOOST_CHECK_EQUAL(a.m_mine_trusted, b.m_mine_trusted);
+    BOOST_CHECK_EQUAL(a.m_mine_untrusted_pending, b.m_mine_untrusted_pending);
+    BOOST_CHECK_EQUAL(a.m_mine_immature, b.m_mine_immature);
+    BOOST_CHECK_EQUAL(a.m_watchonly_trusted, b.m_watchonly_trusted);
+    BOOST_CHECK_EQUAL(a.m_watchonly_untrusted_pending,
+                      b.m_watchonly_untrusted_pending);
+    BOOST_CHECK_EQUAL(a.m_watchonly_immature, b.m_watchonly_immature);
+}
+
+BOOST_FIXTURE_TEST_CASE(BalanceLedgerTest, ListCoinsTestingSetup) {
+    // All the wallet txs are confirmed, so the balance at min_depth 0, kept by
+    // the ledger, is the same as the one at min_depth 1, which is summed over
+    // all the txs on each call.
+    const Balance initial_balance = GetBalance(*wallet);
+    BOOST_CHECK_EQUAL(initial_balance.m_mine_trusted, 50 * COIN);
+    CheckBalanceEqual(initial_balance, GetBalance(*wallet, /*min_depth=*/1));
+
+    // The spent coinbase is marked dirty, the new tx is accounted for and a
+    // coinbase matures with the new block.
+    AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN,
+                     false /* subtract fee */});
+    const Balance balance = GetBalance(*wallet);
+    CheckBalanceEqual(balance, GetBalance(*wallet, /*min_depth=*/1));
+    BOOST_CHECK(balance.m_mine_trusted > initial_balance.m_mine_trusted);
+    BOOST_CHECK(balance.m_mine_immature < initial_balance.m_mine_immature);
+
+    // Marking all the txs dirty accounts for all of them again, to the same
+    // result.
+    wallet->MarkDirty();
+    CheckBalanceEqual(GetBalance(*wallet), balance);
+}
+
+BOOST_FIXTURE_TEST_CASE(UnspentIndexTest, ListCoinsTestingSetup) {
+    auto available_outpoints = [&] {
+        LOCK(wallet->cs_wallet);
+        std::vector<COutput> available;
+        AvailableCoins(*wallet, available);
+        std::vector<COutPoint> outpoints;
+        for (const COutput &out : available) {
+            outpoints.emplace_back(out.tx->GetId(), out.i);
+        }
+        return outpoints;
+    };
+
+    const std::vector<COutPoint> initial_outpoints = available_outpoints();
+    BOOST_CHECK_EQUAL(initial_outpoints.size(), 1U);
+
+    // The spent coinbase leaves the index, the change output enters it
+    const TxId txid = AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN,
+                                       false /* subtract fee */})
+                          .GetId();
+    const std::vector<COutPoint> outpoints = available_outpoints();
+    BOOST_CHECK(std::find(outpoints.begin(), outpoints.end(),
+                          initial_outpoints[0]) == outpoints.end());
+    BOOST_CHECK(std::any_of(
+        outpoints.begin(), outpoints.end(),
+        [&](const COutPoint &outpoint) { return outpoint.GetTxId() == txid; }));
+    {
+        LOCK(wallet->cs_wallet);
+        BOOST_CHECK_EQUAL(wallet->m_unspent_index.outputs.count(
+                              initial_outpoints[0].GetTxId()),
+                          0U);
+    }
+
+    // Rebuilding the index gives the same coins
+    wallet->MarkDirty();
+    BOOST_CHECK(available_outpoints() == outpoints);
+}
+
 BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup) {
     std::shared_ptr<CWallet> wallet = std::make_shared<CWallet>(
         m_node.chain.get(), "", CreateDummyWalletDatabase());
@@ -215,6 +215,15 @@ public:
     }
 
     template <typename Stream> void Unserialize(Stream &s) {
+        s >> tx;
+        UnserializeMetadata(s);
+    }
+
+    /**
+     * Unserialize what follows the transaction, for when it was read on its
+     * own beforehand.
+     */
+    template <typename Stream> void UnserializeMetadata(Stream &s) {
         Init();
 
         //! Used to be vMerkleBranch
@@ -224,7 +233,7 @@ public:
         //! Used to be fSpent
         bool dummy_bool;
         int serializedIndex;
-        s >> tx >> m_confirm.hashBlock >> dummy_vector1 >> serializedIndex >>
+        s >> m_confirm.hashBlock >> dummy_vector1 >> serializedIndex >>
             dummy_vector2 >> mapValue >> vOrderForm >> fTimeReceivedIsTxTime >>
             nTimeReceived >> fFromMe >> dummy_bool;
 
@@ -0,0 +1,42 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_UNSPENTINDEX_H
+#define BITCOIN_WALLET_UNSPENTINDEX_H
+
+#include <primitives/txid.h>
+
+#include <cstdint>
+#include <map>
+#include <set>
+
+/**
+ * The outputs of the wallet txs which are mine and unspent, by txid and
+ * output index, so that AvailableCoins scales with the number of unspent
+ * outputs instead of the size of the wallet history.
+ *
+ * The outputs of a tx are looked at again when it is marked dirty, which
+ * happens whenever it is added or updated, and whenever a tx spending it is
+ * added, abandoned or conflicted. An output can only become unspent again
+ * through the latter, so the index may hold outputs which were spent since,
+ * but none of the unspent ones is missing.
+ */
+struct UnspentIndex {
+    std::map<TxId, std::set<uint32_t>> outputs;
+    std::set<TxId> dirty_txs;
+    bool all_dirty{true};
+
+    void MarkDirty(const TxId &txid) {
+        if (!all_dirty) {
+            dirty_txs.insert(txid);
+        }
+    }
+
+    void MarkAllDirty() {
+        all_dirty = true;
+        dirty_txs.clear();
+    }
+};
+
+#endif // BITCOIN_WALLET_UNSPENTINDEX_H
@@ -12,6 +12,7 @@
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <crypto/siphash.h>
 #include <interfaces/wallet.h>
 #include <key.h>
 #include <key_io.h>
@@ -37,6 +38,9 @@
 #include <wallet/coincontrol.h>
 #include <wallet/fees.h>
 
+#include <deque>
+#include <future>
+#include <unordered_set>
 #include <variant>
 
 using interfaces::FoundBlock;
@@ -896,6 +900,8 @@ void CWallet::MarkDirty() {
     for (std::pair<const TxId, CWalletTx> &item : mapWallet) {
         item.second.MarkDirty();
     }
+    m_balance_ledger.MarkAllDirty();
+    m_unspent_index.MarkAllDirty();
 }
 
 void CWallet::SetSpentKeyState(WalletBatch &batch, const TxId &txid,
@@ -1014,6 +1020,7 @@ CWalletTx *CWallet::AddToWallet(CTransactionRef tx,
 
     // Break debit/credit balance caches:
     wtx.MarkDirty();
+    MarkTxDirty(txid);
 
     // Notify UI of new or updated transaction.
     NotifyTransactionChanged(this, txid, fInsertedNew ? CT_NEW : CT_UPDATED);
@@ -1158,11 +1165,17 @@ bool CWallet::TransactionCanBeAbandoned(const TxId &txid) const {
            !wtx->InMempool();
 }
 
+void CWallet::MarkTxDirty(const TxId &txid) {
+    m_balance_ledger.MarkDirty(txid);
+    m_unspent_index.MarkDirty(txid);
+}
+
 void CWallet::MarkInputsDirty(const CTransactionRef &tx) {
     for (const CTxIn &txin : tx->vin) {
         auto it = mapWallet.find(txin.prevout.GetTxId());
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            MarkTxDirty(it->first);
         }
     }
 }
@@ -1203,6 +1216,7 @@ bool CWallet::AbandonTransaction(const TxId &txid) {
             assert(!wtx.InMempool());
             wtx.setAbandoned();
             wtx.MarkDirty();
+            MarkTxDirty(wtx.GetId());
             batch.WriteTx(wtx);
             NotifyTransactionChanged(this, wtx.GetId(), CT_UPDATED);
             // Iterate over all its outputs, and mark transactions in the wallet
@@ -1264,6 +1278,7 @@ void CWallet::MarkConflicted(const BlockHash &hashBlock, int conflicting_height,
             wtx.m_confirm.block_height = conflicting_height;
             wtx.setConflicted();
             wtx.MarkDirty();
+            MarkTxDirty(wtx.GetId());
             batch.WriteTx(wtx);
             // Iterate over all its outputs, and mark transactions in the wallet
             // that spend them conflicted too.
@@ -1376,6 +1391,8 @@ void CWallet::blockDisconnected(const CBlock &block, int height) {
     // abandontransaction call.
     m_last_block_processed_height = height - 1;
     m_last_block_processed = block.hashPrevBlock;
+    // The depth of the conflicted txs changes too
+    m_balance_ledger.MarkAllDirty();
     for (const CTransactionRef &ptx : block.vtx) {
         SyncTransaction(ptx,
                         {CWalletTx::Status::UNCONFIRMED, /* block_height */ 0,
@@ -1683,6 +1700,175 @@ int64_t CWallet::RescanFromTime(int64_t startTime,
     return startTime;
 }
 
+namespace {
+//! How many blocks are read ahead of the one being rescanned
+static constexpr size_t RESCAN_PREFETCH_BLOCKS{16};
+
+/**
+ * Tell which blocks and txs may involve a descriptor wallet, from the scripts
+ * its descriptors derived.
+ *
+ * Blocks are checked against their BIP 158 basic filter if the index is
+ * enabled, which also covers the txs spending the wallet outputs. Tx outputs
+ * are checked against salted 64-bit hashes of the scripts, so that false
+ * positives are negligible and only cost the full IsMine checks.
+ */
+class FastWalletRescanFilter {
+public:
+    FastWalletRescanFilter(const CWallet &wallet, bool use_block_filters)
+        : m_wallet(wallet), m_use_block_filters(use_block_filters) {
+        // Only descriptor wallets are supported, their scripts are known in
+        // advance.
+        for (ScriptPubKeyMan *spkm : m_wallet.GetAllScriptPubKeyMans()) {
+            auto desc_spkm{dynamic_cast<DescriptorScriptPubKeyMan *>(spkm)};
+            assert(desc_spkm != nullptr);
+            AddScriptPubKeys(*desc_spkm, 0);
+            m_last_range_ends.emplace(desc_spkm->GetID(),
+                                      desc_spkm->GetEndRange());
+        }
+    }
+
+    /** Add the scripts derived since the last call, e.g. by a keypool top up */
+    void UpdateIfNeeded() {
+        for (auto &[desc_spkm_id, last_range_end] : m_last_range_ends) {
+            auto desc_spkm{dynamic_cast<DescriptorScriptPubKeyMan *>(
+                m_wallet.GetScriptPubKeyMan(desc_spkm_id))};
+            assert(desc_spkm != nullptr);
+            const int32_t current_range_end{desc_spkm->GetEndRange()};
+            if (current_range_end > last_range_end) {
+                AddScriptPubKeys(*desc_spkm, last_range_end);
+                last_range_end = current_range_end;
+            }
+        }
+    }
+
+    bool UsesBlockFilters() const { return m_use_block_filters; }
+
+    /**
+     * Whether the block may have txs involving the wallet, or std::nullopt if
+     * its filter isn't available.
+     */
+    std::optional<bool> MatchesBlock(const BlockHash &block_hash) const {
+        if (!m_use_block_filters) {
+            return std::nullopt;
+        }
+        return m_wallet.chain().blockFilterMatchesAny(
+            BlockFilterType::BASIC, block_hash, m_filter_set);
+    }
+
+    /** Whether any output of the tx may pay to the wallet. */
+    bool MaybeMatchesOutputs(const CTransaction &tx) const {
+        return std::any_of(
+            tx.vout.begin(), tx.vout.end(), [&](const CTxOut &txout) {
+                return m_script_hashes.count(Hash(txout.scriptPubKey)) != 0;
+            });
+    }
+
+private:
+    uint64_t Hash(const CScript &script) const {
+        return CSipHasher(m_k0, m_k1)
+            .Write(script.data(), script.size())
+            .Finalize();
+    }
+
+    void AddScriptPubKeys(const DescriptorScriptPubKeyMan &desc_spkm,
+                          int32_t last_range_end) {
+        for (const CScript &script :
+             desc_spkm.GetScriptPubKeys(last_range_end)) {
+            m_script_hashes.insert(Hash(script));
+            if (m_use_block_filters) {
+                m_filter_set.emplace(script.begin(), script.end());
+            }
+        }
+    }
+
+    const CWallet &m_wallet;
+    const bool m_use_block_filters;
+    //! Map of the descriptors to one past the last index of their scripts
+    //! added to the filter
+    std::map<uint256, int32_t> m_last_range_ends;
+    GCSFilter::ElementSet m_filter_set;
+    const uint64_t m_k0{GetRand<uint64_t>()};
+    const uint64_t m_k1{GetRand<uint64_t>()};
+    std::unordered_set<uint64_t> m_script_hashes;
+};
+
+/**
+ * Read the blocks following the one being rescanned in the background, so
+ * that the rescan doesn't wait for the disk and the header checks on every
+ * block. The blocks the filter rules out are not read.
+ */
+class RescanBlockPrefetcher {
+public:
+    RescanBlockPrefetcher(interfaces::Chain &chain,
+                          const FastWalletRescanFilter *filter)
+        : m_chain(chain), m_filter(filter) {}
+
+    /**
+     * Start reading the blocks after the given one on the active chain, up
+     * to max_height.
+     */
+    void Prefetch(const BlockHash &block_hash, int block_height,
+                  std::optional<int> max_height) {
+        BlockHash hash{block_hash};
+        int height{block_height};
+        if (!m_pending.empty()) {
+            hash = m_pending.back().hash;
+            height = m_pending.back().height;
+        }
+        if (m_pending.size() >= RESCAN_PREFETCH_BLOCKS ||
+            (max_height && height >= *max_height)) {
+            return;
+        }
+        size_t count{RESCAN_PREFETCH_BLOCKS - m_pending.size()};
+        if (max_height) {
+            count = std::min<size_t>(count, *max_height - height);
+        }
+        for (const BlockHash &next_block_hash :
+             m_chain.findNextBlocks(hash, count)) {
+            hash = next_block_hash;
+            ++height;
+            Entry &entry{m_pending.emplace_back(Entry{hash, height, {}})};
+            if (m_filter && m_filter->MatchesBlock(hash) == false) {
+                continue;
+            }
+            entry.block = std::async(
+                std::launch::async, [&chain = m_chain, hash = hash] {
+                    CBlock block;
+                    chain.findBlock(hash, FoundBlock().data(block));
+                    return block;
+                });
+        }
+    }
+
+    /** Get the block, reading it now if it wasn't prefetched. */
+    CBlock Get(const BlockHash &block_hash, int block_height) {
+        while (!m_pending.empty() && m_pending.front().height <= block_height) {
+            Entry entry{std::move(m_pending.front())};
+            m_pending.pop_front();
+            if (entry.hash == block_hash && entry.block.valid()) {
+                return entry.block.get();
+            }
+        }
+        CBlock block;
+        m_chain.findBlock(block_hash, FoundBlock().data(block));
+        return block;
+    }
+
+private:
+    struct Entry {
+        BlockHash hash;
+        int height;
+        //! Not valid if the block was filtered out
+        std::future<CBlock> block;
+    };
+
+    interfaces::Chain &m_chain;
+    const FastWalletRescanFilter *m_filter;
+    std::deque<Entry> m_pending;
+};
+} // namespace
+
 /**
  * Scan the block chain (starting in start_block) for transactions from or to
  * us. If fUpdate is true, found transactions that already exist in the wallet
@@ -1716,8 +1902,23 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
     BlockHash block_hash = start_block;
     ScanResult result;
 
-    WalletLogPrintf("Rescan started from block %s...\n",
-                    start_block.ToString());
+    // The txs which can't involve a descriptor wallet are skipped, and so are
+    // the blocks if their filters are available.
+    std::unique_ptr<FastWalletRescanFilter> fast_rescan_filter;
+    if (IsWalletFlagSet(WALLET_FLAG_DESCRIPTORS)) {
+        fast_rescan_filter = std::make_unique<FastWalletRescanFilter>(
+            *this, chain().hasBlockFilterIndex(BlockFilterType::BASIC));
+    }
+    RescanBlockPrefetcher prefetcher(chain(), fast_rescan_filter.get());
+
+    const char *scan_mode = "inspecting all txs";
+    if (fast_rescan_filter) {
+        scan_mode = fast_rescan_filter->UsesBlockFilters()
+                        ? "using block filters"
+                        : "prefiltering txs";
+    }
+    WalletLogPrintf("Rescan started from block %s... (%s)\n",
+                    start_block.ToString(), scan_mode);
 
     fAbortRescan = false;
     // Show rescan progress in GUI as dialog or on splashscreen, if -rescan on
@@ -1755,9 +1956,20 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
                             block_height, progress_current);
         }
 
-        // Read block data
+        // The blocks the filter rules out don't need to be read
+        bool fetch_block = true;
+        if (fast_rescan_filter) {
+            fast_rescan_filter->UpdateIfNeeded();
+            fetch_block =
+                fast_rescan_filter->MatchesBlock(block_hash) != false;
+        }
+
+        // Read block data, while the next blocks are read in the background
+        prefetcher.Prefetch(block_hash, block_height, max_height);
         CBlock block;
-        chain().findBlock(block_hash, FoundBlock().data(block));
+        if (fetch_block) {
+            block = prefetcher.Get(block_hash, block_height);
+        }
 
         // Find next block separately from reading data above, because reading
         // is slow and there might be a reorg while it is read.
@@ -1771,8 +1983,14 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
                                              .inActiveChain(next_block)
                                              .hash(next_block_hash)));
 
-        if (!block.IsNull()) {
+        if (!fetch_block) {
+            // None of the wallet scripts are in the block
+            result.last_scanned_block = block_hash;
+            result.last_scanned_height = block_height;
+        } else if (!block.IsNull()) {
             LOCK(cs_wallet);
+            // Coalesce the writes of the block's txs
+            DatabaseWriteGroup write_group(GetDatabase());
             if (!block_still_active) {
                 // Abort scan if current block is no longer active, to prevent
                 // marking transactions as coming from the wrong block.
@@ -1780,15 +1998,35 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
                 result.status = ScanResult::FAILURE;
                 break;
             }
+            // Whether the tx may be one of ours, for the full checks of
+            // AddToWalletIfInvolvingMe.
+            auto maybe_involves_me = [&](const CTransaction &tx)
+                                         EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) {
+                if (!fast_rescan_filter || mapWallet.count(tx.GetId())) {
+                    return true;
+                }
+                for (const CTxIn &txin : tx.vin) {
+                    // Spending our coins, or conflicting with our txs
+                    if (mapWallet.count(txin.prevout.GetTxId()) ||
+                        mapTxSpends.count(txin.prevout)) {
+                        return true;
+                    }
+                }
+                return fast_rescan_filter->MaybeMatchesOutputs(tx);
+            };
             for (size_t posInBlock = 0; posInBlock < block.vtx.size();
                  ++posInBlock) {
-                CWalletTx::Confirmation confirm(CWalletTx::Status::CONFIRMED,
-                                                block_height, block_hash,
-                                                posInBlock);
+                if (!maybe_involves_me(*block.vtx[posInBlock])) {
+                    continue;
+                }
                 SyncTransaction(block.vtx[posInBlock],
                                 {CWalletTx::Status::CONFIRMED, block_height,
                                  block_hash, int(posInBlock)},
                                 fUpdate);
+                if (fast_rescan_filter) {
+                    // The keypool may have been topped up
+                    fast_rescan_filter->UpdateIfNeeded();
+                }
             }
             // scan succeeded, record block as most recent successfully
             // scanned
@@ -2149,6 +2387,7 @@ void CWallet::CommitTransaction(
     for (const CTxIn &txin : tx->vin) {
         CWalletTx &coin = mapWallet.at(txin.prevout.GetTxId());
         coin.MarkDirty();
+        MarkTxDirty(coin.GetId());
         NotifyTransactionChanged(this, coin.GetId(), CT_UPDATED);
     }
 
@@ -2393,6 +2632,7 @@ void CWallet::MarkDestinationsDirty(
             if (ExtractDestination(wtx.tx->vout[i].scriptPubKey, dst) &&
                 destinations.count(dst)) {
                 wtx.MarkDirty();
+                MarkTxDirty(wtx.GetId());
                 break;
             }
         }
@@ -2548,12 +2788,18 @@ void CWallet::GetKeyBirthTimes(std::map<CKeyID, int64_t> &mapKeyBirth) const {
     }
 
     // Extract block timestamps for those keys.
+    std::vector<int64_t> block_times(mapKeyFirstBlock.size());
+    std::vector<std::pair<BlockHash, FoundBlock>> blocks;
+    blocks.reserve(mapKeyFirstBlock.size());
+    for (const auto &entry : mapKeyFirstBlock) {
+        blocks.emplace_back(entry.second->hashBlock,
+                            FoundBlock().time(block_times[blocks.size()]));
+    }
+    CHECK_NONFATAL(chain().findBlocks(blocks) == blocks.size());
+    size_t i{0};
     for (const auto &entry : mapKeyFirstBlock) {
-        int64_t block_time;
-        CHECK_NONFATAL(chain().findBlock(entry.second->hashBlock,
-                                         FoundBlock().time(block_time)));
         // block times can be 2h off
-        mapKeyBirth[entry.first] = block_time - TIMESTAMP_WINDOW;
+        mapKeyBirth[entry.first] = block_times[i++] - TIMESTAMP_WINDOW;
     }
 }
 
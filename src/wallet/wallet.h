@@ -22,11 +22,13 @@
 #include <util/translation.h>
 #include <util/ui_change_type.h>
 #include <validationinterface.h>
+#include <wallet/balance.h>
 #include <wallet/coinselection.h>
 #include <wallet/crypter.h>
 #include <wallet/rpcwallet.h>
 #include <wallet/scriptpubkeyman.h>
 #include <wallet/transaction.h>
+#include <wallet/unspentindex.h>
 #include <wallet/walletdb.h>
 #include <wallet/walletutil.h>
 
@@ -315,6 +317,12 @@ private:
     void MarkConflicted(const BlockHash &hashBlock, int conflicting_height,
                         const TxId &txid);
 
+    /**
+     * Have the balance ledger and the unspent index account for a transaction
+     * again, along with its cached amounts
+     */
+    void MarkTxDirty(const TxId &txid) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /**
      * Mark a transaction's inputs dirty, thus forcing the outputs to be
      * recomputed
@@ -426,6 +434,11 @@ public:
 
     std::map<TxId, CWalletTx> mapWallet GUARDED_BY(cs_wallet);
 
+    //! The balance at min_depth 0, updated by GetBalance
+    mutable BalanceLedger m_balance_ledger GUARDED_BY(cs_wallet);
+    //! The unspent outputs of mapWallet, updated by AvailableCoins
+    mutable UnspentIndex m_unspent_index GUARDED_BY(cs_wallet);
+
     typedef std::multimap<int64_t, CWalletTx *> TxItems;
     TxItems wtxOrdered;
 
@@ -11,6 +11,7 @@
 #include <key_io.h>
 #include <protocol.h>
 #include <serialize.h>
+#include <streams.h>
 #include <sync.h>
 #include <util/bip32.h>
 #include <util/fs.h>
@@ -18,6 +19,7 @@
 #include <util/translation.h>
 #include <wallet/bdb.h>
 #include <wallet/wallet.h>
+#include <wallet/walletutil.h>
 
 #include <atomic>
 
@@ -300,10 +302,15 @@ public:
     CWalletScanState() {}
 };
 
+/**
+ * Unserialize a Key-Value pair and load it into the wallet. The transaction of
+ * a TX record can be passed as read_tx if it was already read from ssValue.
+ */
 static bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey,
                          CDataStream &ssValue, CWalletScanState &wss,
                          std::string &strType, std::string &strErr,
-                         const KeyFilterFn &filter_fn = nullptr)
+                         const KeyFilterFn &filter_fn = nullptr,
+                         const CTransactionRef &read_tx = nullptr)
     EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet) {
     try {
         // Unserialize
@@ -337,7 +344,12 @@ static bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey,
             // callback fills with transaction metadata.
             auto fill_wtx = [&](CWalletTx &wtx, bool new_tx) {
                 assert(new_tx);
-                ssValue >> wtx;
+                if (read_tx) {
+                    wtx.SetTx(read_tx);
+                    wtx.UnserializeMetadata(ssValue);
+                } else {
+                    ssValue >> wtx;
+                }
                 if (wtx.GetId() != txid) {
                     return false;
                 }
@@ -766,6 +778,43 @@ bool ReadKeyValue(CWallet *pwallet, CDataStream &ssKey, CDataStream &ssValue,
                         filter_fn);
 }
 
+namespace {
+/**
+ * A TX record read from the database. LoadWallet reads them in batches, so the
+ * transactions, which are most of the work of loading them, can be read in
+ * parallel before the records are loaded in order.
+ */
+struct TxRecord {
+    CDataStream key{SER_DISK, CLIENT_VERSION};
+    CDataStream value{SER_DISK, CLIENT_VERSION};
+    CTransactionRef tx;
+};
+} // namespace
+
+//! How many TX records LoadWallet reads before loading them
+static constexpr size_t LOAD_TX_BATCH_SIZE{10000};
+//! How many TX records a thread reads the transaction of, at least
+static constexpr size_t LOAD_TX_MIN_PER_THREAD{500};
+
+/**
+ * Read the transaction at the start of each record value. The records whose
+ * transaction can't be read are left as is, for ReadKeyValue to report it.
+ */
+static void ReadTxs(std::vector<TxRecord> &records) {
+    ForEachInParallel(
+        records.size(), LOAD_TX_MIN_PER_THREAD, [&](size_t i) {
+            TxRecord &record = records[i];
+            try {
+                SpanReader reader{SER_DISK, CLIENT_VERSION,
+                                  MakeUCharSpan(record.value)};
+                reader >> record.tx;
+                record.value.ignore(record.value.size() - reader.size());
+            } catch (const std::exception &) {
+                record.tx = nullptr;
+            }
+        });
+}
+
 bool WalletBatch::IsKeyType(const std::string &strType) {
     return (strType == DBKeys::KEY || strType == DBKeys::MASTER_KEY ||
             strType == DBKeys::CRYPTED_KEY);
@@ -792,25 +841,13 @@ DBErrors WalletBatch::LoadWallet(CWallet *pwallet) {
             return DBErrors::CORRUPT;
         }
 
-        while (true) {
-            // Read next record
-            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-            CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-            bool complete;
-            bool ret = m_batch->ReadAtCursor(ssKey, ssValue, complete);
-            if (complete) {
-                break;
-            }
-            if (!ret) {
-                m_batch->CloseCursor();
-                pwallet->WalletLogPrintf(
-                    "Error reading next record from wallet database\n");
-                return DBErrors::CORRUPT;
-            }
-
+        auto load_record = [&](CDataStream &ssKey, CDataStream &ssValue,
+                               const CTransactionRef &read_tx)
+            EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet) {
             // Try to be tolerant of single corrupt records:
             std::string strType, strErr;
-            if (!ReadKeyValue(pwallet, ssKey, ssValue, wss, strType, strErr)) {
+            if (!ReadKeyValue(pwallet, ssKey, ssValue, wss, strType, strErr,
+                              nullptr, read_tx)) {
                 // losing keys is considered a catastrophic error, anything else
                 // we assume the user can live with:
                 if (IsKeyType(strType) || strType == DBKeys::DEFAULTKEY) {
@@ -833,7 +870,53 @@ DBErrors WalletBatch::LoadWallet(CWallet *pwallet) {
             if (!strErr.empty()) {
                 pwallet->WalletLogPrintf("%s\n", strErr);
             }
+        };
+
+        std::vector<TxRecord> tx_records;
+        auto load_tx_records = [&]()
+            EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet) {
+            ReadTxs(tx_records);
+            for (TxRecord &record : tx_records) {
+                load_record(record.key, record.value, record.tx);
+            }
+            tx_records.clear();
+        };
+
+        while (true) {
+            // Read next record
+            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+            CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+            bool complete;
+            bool ret = m_batch->ReadAtCursor(ssKey, ssValue, complete);
+            if (complete) {
+                break;
+            }
+            if (!ret) {
+                m_batch->CloseCursor();
+                pwallet->WalletLogPrintf(
+                    "Error reading next record from wallet database\n");
+                return DBErrors::CORRUPT;
+            }
+
+            std::string record_type;
+            try {
+                CDataStream{ssKey} >> record_type;
+            } catch (const std::exception &) {
+                // Let ReadKeyValue report it
+            }
+            if (record_type == DBKeys::TX) {
+                tx_records.push_back(
+                    {std::move(ssKey), std::move(ssValue), nullptr});
+                if (tx_records.size() >= LOAD_TX_BATCH_SIZE) {
+                    load_tx_records();
+                }
+                continue;
+            }
+            // Keep loading the records in the database order
+            load_tx_records();
+            load_record(ssKey, ssValue, nullptr);
         }
+        load_tx_records();
     } catch (...) {
         result = DBErrors::CORRUPT;
     }
@@ -7,8 +7,11 @@
 #include <common/args.h>
 #include <logging.h>
 
+#include <algorithm>
 #include <exception>
 #include <fstream>
+#include <future>
+#include <thread>
 
 fs::path GetWalletDir() {
     fs::path path;
@@ -119,3 +122,25 @@ std::vector<fs::path> ListWalletDir() {
 
     return paths;
 }
+
+void ForEachInParallel(size_t count, size_t min_per_thread,
+                       const std::function<void(size_t)> &job) {
+    const size_t num_threads{
+        std::clamp<size_t>(std::thread::hardware_concurrency(), 1,
+                           count / std::max<size_t>(min_per_thread, 1) + 1)};
+    const size_t chunk_size{(count + num_threads - 1) / num_threads};
+    auto run_chunk = [&](size_t begin) {
+        const size_t end{std::min(begin + chunk_size, count)};
+        for (size_t i = begin; i < end; ++i) {
+            job(i);
+        }
+    };
+    std::vector<std::future<void>> futures;
+    for (size_t begin = chunk_size; begin < count; begin += chunk_size) {
+        futures.push_back(std::async(std::launch::async, run_chunk, begin));
+    }
+    run_chunk(0);
+    for (auto &future : futures) {
+        future.get();
+    }
+}
@@ -8,6 +8,8 @@
 #include <script/descriptor.h>
 #include <util/fs.h>
 
+#include <cstddef>
+#include <functional>
 #include <vector>
 
 /** (client) version numbers for particular wallet features */
@@ -76,6 +78,14 @@ fs::path GetWalletDir();
 //! Get wallets in wallet directory.
 std::vector<fs::path> ListWalletDir();
 
+/**
+ * Run job(i) for each i in [0, count), splitting them in contiguous chunks of
+ * at least min_per_thread across threads. The calling thread takes the first
+ * chunk. Exceptions thrown by the jobs are rethrown once all chunks are done.
+ */
+void ForEachInParallel(size_t count, size_t min_per_thread,
+                       const std::function<void(size_t)> &job);
+
 /** Descriptor with some wallet metadata */
 class WalletDescriptor {
 public:
@@ -0,0 +1,170 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WORKSTEALINGDEQUE_H
+#define BITCOIN_WORKSTEALINGDEQUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Lock-free single-producer, multi-consumer work-stealing deque.
+ *
+ * This is the Chase-Lev deque, using the memory orderings from Lê, Pop, Cohen
+ * and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory
+ * Models" (PPoPP 2013).
+ *
+ * A single owner thread pushes and pops elements at the bottom of the deque,
+ * while any number of thief threads may concurrently steal elements from the
+ * top. Neither end takes a lock; the owner and the thieves only contend on a
+ * compare-and-swap when racing for the last element.
+ *
+ * The element type must be trivially copyable (typically a pointer to the
+ * actual work item). The ring buffer grows as needed; retired buffers are kept
+ * alive until the deque is destroyed since a thief may still be reading from
+ * them, which bounds the overhead to the size of the largest buffer.
+ */
+template <typename T> class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "WorkStealingDeque elements must be trivially copyable");
+
+private:
+    class Ring {
+    private:
+        const int64_t m_capacity;
+        const int64_t m_mask;
+        std::unique_ptr<std::atomic<T>[]> m_items;
+
+    public:
+        explicit Ring(int64_t capacity)
+            : m_capacity(capacity), m_mask(capacity - 1),
+              m_items(std::make_unique<std::atomic<T>[]>(capacity)) {
+            // The index wrapping relies on the capacity being a power of 2.
+            assert(capacity > 0 && (capacity & m_mask) == 0);
+        }
+
+        int64_t Capacity() const { return m_capacity; }
+
+        void Store(int64_t i, T x) {
+            m_items[i & m_mask].store(x, std::memory_order_relaxed);
+        }
+
+        T Load(int64_t i) const {
+            return m_items[i & m_mask].load(std::memory_order_relaxed);
+        }
+
+        std::unique_ptr<Ring> Grow(int64_t bottom, int64_t top) const {
+            auto ring = std::make_unique<Ring>(2 * m_capacity);
+            for (int64_t i = top; i < bottom; ++i) {
+                ring->Store(i, Load(i));
+            }
+            return ring;
+        }
+    };
+
+    //! Index of the next element to be stolen.
+    std::atomic<int64_t> m_top{0};
+
+    //! Index one past the last element pushed by the owner.
+    std::atomic<int64_t> m_bottom{0};
+
+    //! The ring buffer currently in use.
+    std::atomic<Ring *> m_ring;
+
+    //! All the ring buffers ever allocated, only accessed by the owner.
+    std::vector<std::unique_ptr<Ring>> m_rings;
+
+public:
+    explicit WorkStealingDeque(int64_t initial_capacity = 64) {
+        m_rings.push_back(std::make_unique<Ring>(initial_capacity));
+        m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    /** Push an element at the bottom of the deque. Owner thread only. */
+    void Push(T x) {
+        const int64_t b = m_bottom.load(std::memory_order_relaxed);
+        const int64_t t = m_top.load(std::memory_order_acquire);
+        Ring *ring = m_ring.load(std::memory_order_relaxed);
+        if (b - t > ring->Capacity() - 1) {
+            m_rings.push_back(ring->Grow(b, t));
+            ring = m_rings.back().get();
+            m_ring.store(ring, std::memory_order_release);
+        }
+        ring->Store(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Pop the element at the bottom of the deque, if any. Owner thread only.
+     */
+    std::optional<T> Pop() {
+        const int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Ring *ring = m_ring.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // The deque was empty.
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        T x = ring->Load(b);
+        if (t == b) {
+            // This is the last element, race against the thieves for it.
+            const bool won = m_top.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst,
+                std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            if (!won) {
+                return std::nullopt;
+            }
+        }
+        return x;
+    }
+
+    /**
+     * Steal the element at the top of the deque. Can be called from any
+     * thread. This can fail spuriously when racing with another thief or with
+     * the owner, in which case the caller may retry.
+     */
+    std::optional<T> Steal() {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return std::nullopt;
+        }
+
+        T x = m_ring.load(std::memory_order_acquire)->Load(t);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                           std::memory_order_relaxed)) {
+            return std::nullopt;
+        }
+        return x;
+    }
+
+    /**
+     * Whether the deque looks empty. This is only a snapshot and the result
+     * can be stale by the time it is used, unless the caller synchronizes with
+     * the owner by other means.
+     */
+    bool Empty() const {
+        const int64_t b = m_bottom.load(std::memory_order_acquire);
+        const int64_t t = m_top.load(std::memory_order_acquire);
+        return b <= t;
+    }
+};
+
+#endif // BITCOIN_WORKSTEALINGDEQUE_H
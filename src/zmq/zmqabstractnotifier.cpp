@@ -40,3 +40,7 @@ bool CZMQAbstractNotifier::NotifyTransactionRemoval(
     const CTransaction & /*transaction*/, uint64_t mempool_sequence) {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyBlockTemplate(const CBlock & /*block*/) {
+    return true;
+}
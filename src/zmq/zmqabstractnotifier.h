@@ -5,10 +5,14 @@
 #ifndef BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 #define BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 
+#include <zmq/zmqpublisher.h>
+
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <string>
 
+class CBlock;
 class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
@@ -19,6 +23,7 @@ using CZMQNotifierFactory =
 class CZMQAbstractNotifier {
 public:
     static const int DEFAULT_ZMQ_SNDHWM{1000};
+    static const int DEFAULT_ZMQ_BATCH{1};
 
     CZMQAbstractNotifier()
         : psocket(nullptr),
@@ -42,6 +47,14 @@ public:
             outbound_message_high_water_mark = sndhwm;
         }
     }
+    size_t GetMaxBatchSize() const { return max_batch_size; }
+    void SetMaxBatchSize(const int batch) {
+        if (batch >= 1) {
+            max_batch_size = batch;
+        }
+    }
+    void SetPublisher(CZMQPublisher *p) { publisher = p; }
+    const CZMQPublishStats &GetStats() const { return stats; }
 
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
@@ -60,12 +73,19 @@ public:
                                           uint64_t mempool_sequence);
     // Notifies of transactions added to mempool or appearing in blocks
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    // Notifies of every new block template, see node::BlockTemplateBuilder
+    virtual bool NotifyBlockTemplate(const CBlock &block);
 
 protected:
     void *psocket;
     std::string type;
     std::string address;
     int outbound_message_high_water_mark; // aka SNDHWM
+    //! How many messages can be published at once, see CZMQPublisher
+    size_t max_batch_size{DEFAULT_ZMQ_BATCH};
+    //! Sends the messages, owned by the notification interface
+    CZMQPublisher *publisher{nullptr};
+    CZMQPublishStats stats;
 };
 
 #endif // BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
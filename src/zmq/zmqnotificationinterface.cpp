@@ -12,7 +12,10 @@
 #include <logging.h>
 #include <primitives/block.h>
 
-CZMQNotificationInterface::CZMQNotificationInterface() : pcontext(nullptr) {}
+#include <algorithm>
+
+CZMQNotificationInterface::CZMQNotificationInterface(size_t max_queue_size)
+    : pcontext(nullptr), publisher(max_queue_size) {}
 
 CZMQNotificationInterface::~CZMQNotificationInterface() {
     Shutdown();
@@ -28,19 +31,22 @@ CZMQNotificationInterface::GetActiveNotifiers() const {
 }
 
 std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(
-    std::function<bool(CBlock &, const CBlockIndex &)> get_block_by_index) {
+    std::function<bool(std::vector<uint8_t> &, const CBlockIndex &)>
+        get_raw_block_by_index) {
     std::map<std::string, CZMQNotifierFactory> factories;
     factories["pubhashblock"] =
         CZMQAbstractNotifier::Create<CZMQPublishHashBlockNotifier>;
     factories["pubhashtx"] =
         CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubrawblock"] =
-        [&get_block_by_index]() -> std::unique_ptr<CZMQAbstractNotifier> {
+        [&get_raw_block_by_index]() -> std::unique_ptr<CZMQAbstractNotifier> {
         return std::make_unique<CZMQPublishRawBlockNotifier>(
-            get_block_by_index);
+            get_raw_block_by_index);
     };
     factories["pubrawtx"] =
         CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    factories["pubrawblocktemplate"] =
+        CZMQAbstractNotifier::Create<CZMQPublishRawBlockTemplateNotifier>;
     factories["pubsequence"] =
         CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
 
@@ -55,13 +61,20 @@ std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(
             notifier->SetOutboundMessageHighWaterMark(
                 static_cast<int>(gArgs.GetIntArg(
                     arg + "hwm", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM)));
+            notifier->SetMaxBatchSize(static_cast<int>(gArgs.GetIntArg(
+                arg + "batch", CZMQAbstractNotifier::DEFAULT_ZMQ_BATCH)));
             notifiers.push_back(std::move(notifier));
         }
     }
 
     if (!notifiers.empty()) {
         std::unique_ptr<CZMQNotificationInterface> notificationInterface(
-            new CZMQNotificationInterface());
+            new CZMQNotificationInterface(std::max<int64_t>(
+                1, gArgs.GetIntArg("-zmqqueuesize",
+                                   CZMQPublisher::DEFAULT_ZMQ_QUEUE_SIZE))));
+        for (auto &notifier : notifiers) {
+            notifier->SetPublisher(&notificationInterface->publisher);
+        }
         notificationInterface->notifiers = std::move(notifiers);
 
         if (notificationInterface->Initialize()) {
@@ -99,6 +112,7 @@ bool CZMQNotificationInterface::Initialize() {
         }
     }
 
+    publisher.Start();
     return true;
 }
 
@@ -106,6 +120,8 @@ bool CZMQNotificationInterface::Initialize() {
 void CZMQNotificationInterface::Shutdown() {
     LogPrint(BCLog::ZMQ, "zmq: Shutdown notification interface\n");
     if (pcontext) {
+        // Send what is queued before the sockets get closed
+        publisher.Stop();
         for (auto &notifier : notifiers) {
             LogPrint(BCLog::ZMQ, "zmq: Shutdown notifier %s at %s\n",
                      notifier->GetType(), notifier->GetAddress());
@@ -210,4 +226,11 @@ void CZMQNotificationInterface::BlockDisconnected(
         });
 }
 
+void CZMQNotificationInterface::BlockTemplateUpdated(const CBlock &block) {
+    TryForEachAndRemoveFailed(notifiers,
+                              [&block](CZMQAbstractNotifier *notifier) {
+                                  return notifier->NotifyBlockTemplate(block);
+                              });
+}
+
 std::unique_ptr<CZMQNotificationInterface> g_zmq_notification_interface;
@@ -6,11 +6,15 @@
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
 #include <validationinterface.h>
+#include <zmq/zmqpublisher.h>
 
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <memory>
+#include <vector>
 
+class CBlock;
 class CBlockIndex;
 class CZMQAbstractNotifier;
 
@@ -20,8 +24,16 @@ public:
 
     std::list<const CZMQAbstractNotifier *> GetActiveNotifiers() const;
 
+    /**
+     * Publish a new block template. It must be called from the scheduler
+     * thread, like the validation interface callbacks, as the ZMQ sockets are
+     * not thread safe.
+     */
+    void BlockTemplateUpdated(const CBlock &block);
+
     static std::unique_ptr<CZMQNotificationInterface> Create(
-        std::function<bool(CBlock &, const CBlockIndex &)> get_block_by_index);
+        std::function<bool(std::vector<uint8_t> &, const CBlockIndex &)>
+            get_raw_block_by_index);
 
 protected:
     bool Initialize();
@@ -41,11 +53,13 @@ protected:
     void UpdatedBlockTip(const CBlockIndex *pindexNew,
                          const CBlockIndex *pindexFork,
                          bool fInitialDownload) override;
+    std::string GetSubscriberName() const override { return "zmq"; }
 
 private:
-    CZMQNotificationInterface();
+    explicit CZMQNotificationInterface(size_t max_queue_size);
 
     void *pcontext;
+    CZMQPublisher publisher;
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
 };
 
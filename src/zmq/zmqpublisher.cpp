@@ -0,0 +1,144 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <zmq/zmqpublisher.h>
+
+#include <crypto/common.h>
+#include <util/thread.h>
+#include <zmq/zmqutil.h>
+
+#include <zmq.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+// Send the parts of a multipart message
+static bool
+SendMultipart(void *sock,
+              const std::vector<std::pair<const void *, size_t>> &parts) {
+    for (size_t i = 0; i < parts.size(); ++i) {
+        zmq_msg_t msg;
+
+        int rc = zmq_msg_init_size(&msg, parts[i].second);
+        if (rc != 0) {
+            zmqError("Unable to initialize ZMQ msg");
+            return false;
+        }
+
+        void *buf = zmq_msg_data(&msg);
+        memcpy(buf, parts[i].first, parts[i].second);
+
+        rc = zmq_msg_send(&msg, sock, i + 1 < parts.size() ? ZMQ_SNDMORE : 0);
+        if (rc == -1) {
+            zmqError("Unable to send ZMQ msg");
+            zmq_msg_close(&msg);
+            return false;
+        }
+
+        zmq_msg_close(&msg);
+    }
+    return true;
+}
+
+CZMQPublisher::CZMQPublisher(size_t max_queue_size)
+    : m_max_queue_size(std::max<size_t>(1, max_queue_size)) {}
+
+CZMQPublisher::~CZMQPublisher() {
+    Stop();
+}
+
+void CZMQPublisher::Start() {
+    LOCK(m_mutex);
+    assert(!m_running);
+    m_running = true;
+    m_request_stop = false;
+    m_thread = std::thread(&util::TraceThread, "zmqpub",
+                           [this] { ThreadPublish(); });
+}
+
+void CZMQPublisher::Stop() {
+    WITH_LOCK(m_mutex, m_request_stop = true);
+    m_work_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    LOCK(m_mutex);
+    // Nothing is left unless the thread was never started
+    m_queue.clear();
+}
+
+bool CZMQPublisher::Push(Message message) {
+    {
+        LOCK(m_mutex);
+        if (m_queue.size() >= m_max_queue_size) {
+            ++message.stats->dropped;
+            return false;
+        }
+        message.queued_time = SteadyClock::now();
+        m_queue.push_back(std::move(message));
+    }
+    m_work_cv.notify_one();
+    return true;
+}
+
+void CZMQPublisher::Flush() {
+    WAIT_LOCK(m_mutex, lock);
+    m_idle_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return !m_running || (m_queue.empty() && !m_sending);
+    });
+}
+
+void CZMQPublisher::ThreadPublish() {
+    std::vector<Message> batch;
+    std::vector<std::pair<const void *, size_t>> parts;
+    uint8_t msgseq[sizeof(uint32_t)];
+    while (true) {
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_sending = false;
+            if (m_queue.empty()) {
+                m_idle_cv.notify_all();
+            }
+            m_work_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                return m_request_stop || !m_queue.empty();
+            });
+            if (m_queue.empty()) {
+                // Only stop once everything is sent
+                m_running = false;
+                m_idle_cv.notify_all();
+                return;
+            }
+
+            // Take the messages of the same notifier that are next in line
+            batch.clear();
+            do {
+                batch.push_back(std::move(m_queue.front()));
+                m_queue.pop_front();
+            } while (batch.size() < batch.front().max_batch &&
+                     !m_queue.empty() &&
+                     m_queue.front().stats == batch.front().stats);
+            m_sending = true;
+        }
+
+        const Message &first = batch.front();
+        parts.clear();
+        parts.emplace_back(first.command, strlen(first.command));
+        for (const Message &message : batch) {
+            parts.emplace_back(message.body->data(), message.body->size());
+        }
+        // A LE 4-byte sequence number, the one of the first body
+        WriteLE32(msgseq, first.sequence);
+        parts.emplace_back(msgseq, sizeof(msgseq));
+
+        if (!SendMultipart(first.socket, parts)) {
+            first.stats->dropped += batch.size();
+            continue;
+        }
+        first.stats->sent += batch.size();
+        first.stats->lag_us = Ticks<std::chrono::microseconds>(
+            SteadyClock::now() - first.queued_time);
+    }
+}
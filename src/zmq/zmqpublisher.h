@@ -0,0 +1,106 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_ZMQ_ZMQPUBLISHER_H
+#define BITCOIN_ZMQ_ZMQPUBLISHER_H
+
+#include <sync.h>
+#include <threadsafety.h>
+#include <util/time.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/** The body of a ZMQ message, shared by the notifiers publishing it. */
+using ZMQPayload = std::shared_ptr<const std::vector<uint8_t>>;
+
+/** Counters of the messages published by a ZMQ notifier. */
+struct CZMQPublishStats {
+    //! Messages handed to the socket
+    std::atomic<uint64_t> sent{0};
+    //! Messages dropped because the publisher queue was full
+    std::atomic<uint64_t> dropped{0};
+    //! How long the last sent message waited in the queue, in microseconds
+    std::atomic<int64_t> lag_us{0};
+};
+
+/**
+ * Send the ZMQ messages from a dedicated thread, so that slow subscribers or
+ * large messages don't hold up the validation interface callbacks.
+ *
+ * The queue is bounded: once it is full, new messages are dropped and counted
+ * as such. Their sequence number is used up anyway, so that subscribers can
+ * tell messages were lost.
+ *
+ * When several messages of a notifier which allows it are waiting in a row,
+ * they are sent as a single multipart message: the topic, then the body of
+ * each message, then the sequence number of the first one.
+ */
+class CZMQPublisher {
+public:
+    static constexpr size_t DEFAULT_ZMQ_QUEUE_SIZE{10000};
+
+    struct Message {
+        //! The PUB socket to send the message to
+        void *socket;
+        //! The topic, which must outlive the message
+        const char *command;
+        ZMQPayload body;
+        uint32_t sequence;
+        //! How many messages of the notifier can be sent at once
+        size_t max_batch;
+        //! The counters of the notifier, which also identify it
+        CZMQPublishStats *stats;
+        SteadyClock::time_point queued_time{};
+    };
+
+    explicit CZMQPublisher(size_t max_queue_size = DEFAULT_ZMQ_QUEUE_SIZE);
+    CZMQPublisher(const CZMQPublisher &) = delete;
+    CZMQPublisher &operator=(const CZMQPublisher &) = delete;
+    ~CZMQPublisher();
+
+    void Start() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Send the queued messages, then stop the thread. */
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Queue a message. Returns false if it was dropped. */
+    bool Push(Message message) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Wait until all the queued messages are sent, e.g. before closing a
+     * socket they use.
+     */
+    void Flush() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    size_t QueueSize() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        return WITH_LOCK(m_mutex, return m_queue.size());
+    }
+
+private:
+    void ThreadPublish() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    const size_t m_max_queue_size;
+
+    mutable Mutex m_mutex;
+    //! Signaled when messages are queued, or the thread must stop
+    std::condition_variable m_work_cv;
+    //! Signaled when the thread is done with the messages it took
+    std::condition_variable m_idle_cv;
+    std::deque<Message> m_queue GUARDED_BY(m_mutex);
+    //! Whether the thread is sending some messages out of the queue
+    bool m_sending GUARDED_BY(m_mutex){false};
+    bool m_running GUARDED_BY(m_mutex){false};
+    bool m_request_stop GUARDED_BY(m_mutex){false};
+
+    std::thread m_thread;
+};
+
+#endif // BITCOIN_ZMQ_ZMQPUBLISHER_H
@@ -18,11 +18,12 @@
 
 #include <zmq.h>
 
-#include <cstdarg>
 #include <cstddef>
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 static std::multimap<std::string, CZMQAbstractPublishNotifier *>
     mapPublishNotifiers;
@@ -31,47 +32,33 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX = "hashtx";
 static const char *MSG_RAWBLOCK = "rawblock";
 static const char *MSG_RAWTX = "rawtx";
+static const char *MSG_RAWBLOCKTEMPLATE = "rawblocktemplate";
 static const char *MSG_SEQUENCE = "sequence";
 
-// Internal function to send multipart message
-static int zmq_send_multipart(void *sock, const void *data, size_t size, ...) {
-    va_list args;
-    va_start(args, size);
-
-    while (1) {
-        zmq_msg_t msg;
-
-        int rc = zmq_msg_init_size(&msg, size);
-        if (rc != 0) {
-            zmqError("Unable to initialize ZMQ msg");
-            va_end(args);
-            return -1;
+namespace {
+/**
+ * The body of the last object published, shared by the notifiers which
+ * publish it to several addresses, so that it is only serialized once. Only
+ * used from the validation interface callbacks.
+ */
+template <typename Id> class LastPayload {
+private:
+    Id m_id;
+    ZMQPayload m_payload;
+
+public:
+    template <typename Make> ZMQPayload Get(const Id &id, const Make &make) {
+        if (!m_payload || m_id != id) {
+            m_id = id;
+            m_payload = make();
         }
-
-        void *buf = zmq_msg_data(&msg);
-        memcpy(buf, data, size);
-
-        data = va_arg(args, const void *);
-
-        rc = zmq_msg_send(&msg, sock, data ? ZMQ_SNDMORE : 0);
-        if (rc == -1) {
-            zmqError("Unable to send ZMQ msg");
-            zmq_msg_close(&msg);
-            va_end(args);
-            return -1;
-        }
-
-        zmq_msg_close(&msg);
-
-        if (!data) {
-            break;
-        }
-
-        size = va_arg(args, size_t);
+        return m_payload;
     }
-    va_end(args);
-    return 0;
-}
+};
+
+LastPayload<TxId> g_last_raw_tx;
+LastPayload<BlockHash> g_last_raw_block;
+} // namespace
 
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext) {
     assert(!psocket);
@@ -139,6 +126,11 @@ void CZMQAbstractPublishNotifier::Shutdown() {
         return;
     }
 
+    // The queued messages may still use the socket
+    if (publisher) {
+        publisher->Flush();
+    }
+
     int count = mapPublishNotifiers.count(address);
 
     // remove this notifier from the list of publishers using this address
@@ -165,25 +157,29 @@ void CZMQAbstractPublishNotifier::Shutdown() {
 }
 
 bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command,
-                                                 const void *data,
-                                                 size_t size) {
+                                                 ZMQPayload data) {
     assert(psocket);
-
-    /* send three parts, command & data & a LE 4byte sequence number */
-    uint8_t msgseq[sizeof(uint32_t)];
-    WriteLE32(msgseq, nSequence);
-    int rc = zmq_send_multipart(psocket, command, strlen(command), data, size,
-                                msgseq, (size_t)sizeof(uint32_t), nullptr);
-    if (rc == -1) {
-        return false;
-    }
-
-    /* increment memory only sequence number after sending */
-    nSequence++;
-
+    assert(publisher);
+
+    /* the sequence number is used up even if the message gets dropped, so
+       that subscribers can tell */
+    publisher->Push({.socket = psocket,
+                     .command = command,
+                     .body = std::move(data),
+                     .sequence = nSequence++,
+                     .max_batch = max_batch_size,
+                     .stats = &stats});
     return true;
 }
 
+bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command,
+                                                 const void *data,
+                                                 size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    return SendZmqMessage(command, std::make_shared<const std::vector<uint8_t>>(
+                                       bytes, bytes + size));
+}
+
 bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex) {
     BlockHash hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashblock %s to %s\n", hash.GetHex(),
@@ -211,16 +207,21 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex) {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s to %s\n",
              pindex->GetBlockHash().GetHex(), this->address);
 
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    CBlock block;
-    if (!m_get_block_by_index(block, *pindex)) {
+    // The block as stored is also its serialization for the wire.
+    ZMQPayload block = g_last_raw_block.Get(
+        pindex->GetBlockHash(), [&]() -> ZMQPayload {
+            auto raw_block = std::make_shared<std::vector<uint8_t>>();
+            if (!m_get_raw_block_by_index(*raw_block, *pindex)) {
+                return nullptr;
+            }
+            return raw_block;
+        });
+    if (!block) {
         zmqError("Can't read block from disk");
         return false;
     }
 
-    ss << block;
-
-    return SendZmqMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendZmqMessage(MSG_RAWBLOCK, std::move(block));
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(
@@ -228,9 +229,24 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(
     TxId txid = transaction.GetId();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtx %s to %s\n", txid.GetHex(),
              this->address);
+    return SendZmqMessage(
+        MSG_RAWTX, g_last_raw_tx.Get(txid, [&]() -> ZMQPayload {
+            auto raw_tx = std::make_shared<std::vector<uint8_t>>();
+            CVectorWriter ss(SER_NETWORK,
+                             PROTOCOL_VERSION | RPCSerializationFlags(),
+                             *raw_tx, 0);
+            ss << transaction;
+            return raw_tx;
+        }));
+}
+
+bool CZMQPublishRawBlockTemplateNotifier::NotifyBlockTemplate(
+    const CBlock &block) {
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawblocktemplate on top of %s to %s\n",
+             block.hashPrevBlock.GetHex(), this->address);
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ss << transaction;
-    return SendZmqMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    ss << block;
+    return SendZmqMessage(MSG_RAWBLOCKTEMPLATE, &(*ss.begin()), ss.size());
 }
 
 // TODO: Dedup this code to take label char, log string
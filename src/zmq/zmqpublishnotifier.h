@@ -6,10 +6,12 @@
 #define BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
 
 #include <zmq/zmqabstractnotifier.h>
+#include <zmq/zmqpublisher.h>
 
+#include <cstdint>
 #include <functional>
+#include <vector>
 
-class CBlock;
 class CBlockIndex;
 
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier {
@@ -18,12 +20,13 @@ private:
     uint32_t nSequence{0U};
 
 public:
-    /* send zmq multipart message
+    /* queue zmq multipart message
        parts:
           * command
           * data
           * message sequence number
     */
+    bool SendZmqMessage(const char *command, ZMQPayload data);
     bool SendZmqMessage(const char *command, const void *data, size_t size);
 
     bool Initialize(void *pcontext) override;
@@ -42,13 +45,14 @@ public:
 
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier {
 private:
-    const std::function<bool(CBlock &, const CBlockIndex &)>
-        m_get_block_by_index;
+    const std::function<bool(std::vector<uint8_t> &, const CBlockIndex &)>
+        m_get_raw_block_by_index;
 
 public:
     CZMQPublishRawBlockNotifier(
-        std::function<bool(CBlock &, const CBlockIndex &)> get_block_by_index)
-        : m_get_block_by_index{std::move(get_block_by_index)} {}
+        std::function<bool(std::vector<uint8_t> &, const CBlockIndex &)>
+            get_raw_block_by_index)
+        : m_get_raw_block_by_index{std::move(get_raw_block_by_index)} {}
     bool NotifyBlock(const CBlockIndex *pindex) override;
 };
 
@@ -57,6 +61,12 @@ public:
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
+class CZMQPublishRawBlockTemplateNotifier
+    : public CZMQAbstractPublishNotifier {
+public:
+    bool NotifyBlockTemplate(const CBlock &block) override;
+};
+
 class CZMQPublishSequenceNotifier : public CZMQAbstractPublishNotifier {
 public:
     bool NotifyBlockConnect(const CBlockIndex *pindex) override;
@@ -32,6 +32,17 @@ static RPCHelpMan getzmqnotifications() {
                       "Address of the publisher"},
                      {RPCResult::Type::NUM, "hwm",
                       "Outbound message high water mark"},
+                     {RPCResult::Type::NUM, "batch",
+                      "Maximum number of notifications sent in a single "
+                      "message"},
+                     {RPCResult::Type::NUM, "sent",
+                      "Number of notifications sent"},
+                     {RPCResult::Type::NUM, "dropped",
+                      "Number of notifications dropped because the queue of "
+                      "the publisher was full"},
+                     {RPCResult::Type::NUM, "lag",
+                      "How long the last notification sent waited in the "
+                      "queue, in microseconds"},
                  }},
             }},
         RPCExamples{HelpExampleCli("getzmqnotifications", "") +
@@ -46,6 +57,11 @@ static RPCHelpMan getzmqnotifications() {
                     obj.pushKV("type", n->GetType());
                     obj.pushKV("address", n->GetAddress());
                     obj.pushKV("hwm", n->GetOutboundMessageHighWaterMark());
+                    obj.pushKV("batch", uint64_t(n->GetMaxBatchSize()));
+                    const CZMQPublishStats &stats = n->GetStats();
+                    obj.pushKV("sent", stats.sent.load());
+                    obj.pushKV("dropped", stats.dropped.load());
+                    obj.pushKV("lag", stats.lag_us.load());
                     result.push_back(obj);
                 }
             }
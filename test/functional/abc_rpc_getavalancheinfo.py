@@ -53,8 +53,27 @@ class GetAvalancheInfoTest(BitcoinTestFramework):
 
         privkey, proof = gen_proof(self, node, expiry=2000000000)
 
+        def get_avalancheinfo():
+            # The polling statistics depend on timing, only check they are
+            # reported.
+            info = node.getavalancheinfo()
+            assert_equal(
+                sorted(info.pop("polling").keys()),
+                [
+                    "average_response_time",
+                    "inflight_polls",
+                    "max_polls_per_tick",
+                    "pending_items",
+                    "polls_sent",
+                    "polls_timed_out",
+                    "query_timeout",
+                    "responses_received",
+                ],
+            )
+            return info
+
         def assert_avalancheinfo(expected):
-            assert_equal(node.getavalancheinfo(), expected)
+            assert_equal(get_avalancheinfo(), expected)
 
         coinbase_amount = Decimal("25000000.00")
 
@@ -240,7 +259,7 @@ class GetAvalancheInfoTest(BitcoinTestFramework):
         self.log.info("Mine a block to trigger proof validation, check it is immature")
         self.generate(node, 1, sync_fun=self.no_op)
         self.wait_until(
-            lambda: node.getavalancheinfo()
+            lambda: get_avalancheinfo()
             == {
                 "ready_to_poll": False,
                 "local": {
@@ -275,7 +294,7 @@ class GetAvalancheInfoTest(BitcoinTestFramework):
         )
         self.generate(node, 1, sync_fun=self.no_op)
         self.wait_until(
-            lambda: node.getavalancheinfo()
+            lambda: get_avalancheinfo()
             == {
                 "ready_to_poll": False,
                 "local": {
@@ -308,7 +327,7 @@ class GetAvalancheInfoTest(BitcoinTestFramework):
         self.log.info("Mine another block to mature the local proof")
         self.generate(node, 1, sync_fun=self.no_op)
         self.wait_until(
-            lambda: node.getavalancheinfo()
+            lambda: get_avalancheinfo()
             == {
                 "ready_to_poll": False,
                 "local": {
@@ -383,7 +402,7 @@ class GetAvalancheInfoTest(BitcoinTestFramework):
         n.send_avaproof(immature_proof)
 
         self.wait_until(
-            lambda: node.getavalancheinfo()
+            lambda: get_avalancheinfo()
             == {
                 "ready_to_poll": True,
                 "local": {
@@ -421,7 +440,7 @@ class GetAvalancheInfoTest(BitcoinTestFramework):
             n.wait_for_disconnect()
 
         self.wait_until(
-            lambda: node.getavalancheinfo()
+            lambda: get_avalancheinfo()
             == {
                 "ready_to_poll": True,
                 "local": {
@@ -602,7 +621,7 @@ class GetAvalancheInfoTest(BitcoinTestFramework):
         node.mockscheduler(AVALANCHE_CLEANUP_INTERVAL)
 
         self.wait_until(
-            lambda: node.getavalancheinfo()
+            lambda: get_avalancheinfo()
             == {
                 "ready_to_poll": False,
                 "local": {
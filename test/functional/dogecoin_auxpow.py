@@ -7,7 +7,7 @@ Test whether Dogecoin auxpow blocks are accepted.
 
 import time
 
-from test_framework.address import P2SH_OP_TRUE
+from test_framework.address import ADDRESS_ECREG_P2SH_OP_TRUE, P2SH_OP_TRUE
 from test_framework.blocktools import (
     VERSION_CHAIN_ID_BITS,
     create_block,
@@ -25,7 +25,7 @@ from test_framework.messages import (
 )
 from test_framework.script import CScript
 from test_framework.test_framework import BitcoinTestFramework
-from test_framework.util import assert_equal
+from test_framework.util import assert_equal, assert_raises_rpc_error
 
 
 class DogecoinAuxpowTest(BitcoinTestFramework):
@@ -221,6 +221,57 @@ class DogecoinAuxpowTest(BitcoinTestFramework):
         assert_equal(node.submitblock(block2.serialize().hex()), None)
         assert_equal(node.getbestblockhash(), block2.hash)
 
+        self.log.info("Merge-mine a block with createauxblock/submitauxblock")
+        aux_block = node.createauxblock(ADDRESS_ECREG_P2SH_OP_TRUE)
+        assert_equal(aux_block["chainid"], 0x62)
+        assert_equal(aux_block["previousblockhash"], block2.hash)
+        assert_equal(aux_block["height"], 3)
+        # The template is reused while neither the tip nor the mempool change
+        assert_equal(node.createauxblock(ADDRESS_ECREG_P2SH_OP_TRUE), aux_block)
+
+        auxpow = CAuxPow()
+        coinbase_script = CScript(
+            MERGE_MINE_PREFIX
+            + bytes.fromhex(aux_block["hash"])
+            + b"\x01\0\0\0\xff\xff\xff\xff"
+        )
+        auxpow.coinbaseTx.vin = [CTxIn(COutPoint(), coinbase_script)]
+        auxpow.coinbaseTx.rehash()
+        auxpow.parentBlock.hashMerkleRoot = auxpow.coinbaseTx.sha256
+        target = uint256_from_compact(int(aux_block["bits"], 16))
+        auxpow.parentBlock.rehashPow()
+        while auxpow.parentBlock.powHash > target:
+            auxpow.parentBlock.nNonce += 1
+            auxpow.parentBlock.rehashPow()
+
+        assert_raises_rpc_error(
+            -22,
+            "AuxPow decode failed",
+            node.submitauxblock,
+            aux_block["hash"],
+            "00",
+        )
+        assert_equal(
+            node.submitauxblock(aux_block["hash"], auxpow.serialize().hex()), True
+        )
+        assert_equal(node.getbestblockhash(), aux_block["hash"])
+        assert_equal(
+            node.submitauxblock(aux_block["hash"], auxpow.serialize().hex()), False
+        )
+
+        # Blocks built on a previous tip are forgotten
+        assert_equal(
+            node.createauxblock(ADDRESS_ECREG_P2SH_OP_TRUE)["previousblockhash"],
+            aux_block["hash"],
+        )
+        assert_raises_rpc_error(
+            -8,
+            "Block hash unknown or stale",
+            node.submitauxblock,
+            aux_block["hash"],
+            auxpow.serialize().hex(),
+        )
+
 
 if __name__ == "__main__":
     DogecoinAuxpowTest().main()
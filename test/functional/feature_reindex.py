@@ -7,6 +7,7 @@
 - Stop the node and restart it with -reindex. Verify that the node has reindexed up to block 3.
 - Stop the node and restart it with -reindex-chainstate. Verify that the node has reindexed up to block 3.
 - Verify that out-of-order blocks are correctly processed, see LoadExternalBlockFile()
+  and LoadExternalBlocks(), with and without reading the block files ahead.
 """
 
 import os
@@ -68,18 +69,25 @@ class ReindexTest(BitcoinTestFramework):
             bf.write(b[b3_start:b4_start])
             bf.write(b[b2_start:b3_start])
 
-        # The reindexing code should detect and accommodate out of order blocks.
-        with self.nodes[0].assert_debug_log(
-            [
-                "LoadExternalBlockFile: Out of order block",
-                "LoadExternalBlockFile: Processing out of order child",
-            ]
-        ):
-            extra_args = [["-reindex"]]
-            self.start_nodes(extra_args)
-
-        # All blocks should be accepted and processed.
-        assert_equal(self.nodes[0].getblockcount(), 12)
+        # The reindexing code should detect and accommodate out of order blocks,
+        # whether the block files are read ahead or not.
+        for read_ahead, func in [
+            (2, "LoadExternalBlocks"),
+            (0, "LoadExternalBlockFile"),
+        ]:
+            with self.nodes[0].assert_debug_log(
+                [
+                    f"{func}: Out of order block",
+                    "LoadBlocksWithKnownParent: Processing out of order child",
+                ]
+            ):
+                extra_args = [["-reindex", f"-reindexreadahead={read_ahead}"]]
+                self.start_nodes(extra_args)
+
+            # All blocks should be accepted and processed.
+            assert_equal(self.nodes[0].getblockcount(), 12)
+            self.stop_nodes()
+        self.start_nodes()
 
     def run_test(self):
         self.reindex(False)
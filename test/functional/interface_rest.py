@@ -12,7 +12,7 @@ from io import BytesIO
 from struct import pack, unpack
 
 from test_framework.blocktools import COINBASE_MATURITY
-from test_framework.messages import BLOCK_HEADER_SIZE
+from test_framework.messages import BLOCK_HEADER_SIZE, XEC
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
     assert_equal,
@@ -213,6 +213,79 @@ class RESTTest(BitcoinTestFramework):
         json_obj = self.test_rest_request(f"/getutxos/checkmempool/{txid}-{n}")
         assert_equal(len(json_obj["utxos"]), 1)
 
+        self.log.info("Test the /getutxosbatch URI")
+
+        def getutxos_batch(outpoints, checkmempool=False, status=200):
+            bin_request = bytes([checkmempool, len(outpoints)])
+            for txid_, n_ in outpoints:
+                bin_request += bytes.fromhex(txid_)[::-1] + pack("<I", n_)
+            return self.test_rest_request(
+                "/getutxosbatch",
+                http_method="POST",
+                req_type=ReqType.BIN,
+                body=bin_request,
+                status=status,
+                ret_type=RetType.BYTES if status == 200 else RetType.OBJ,
+            )
+
+        def parse_utxos_batch(bin_response, num_outpoints):
+            output = BytesIO(bin_response)
+            (chain_height,) = unpack("<i", output.read(4))
+            tip_hash = output.read(32)[::-1].hex()
+            coins = []
+            for _ in range(num_outpoints):
+                (hit,) = unpack("<?", output.read(1))
+                coin = None
+                if hit:
+                    _, height, value, script_size = unpack("<IIqB", output.read(17))
+                    coin = (height, value, output.read(script_size).hex())
+                coins.append(coin)
+            assert_equal(output.read(), b"")
+            return chain_height, tip_hash, coins
+
+        # Check the order and the values against the /getutxos results
+        outpoints = [(txid, n), spent, (txid, n + 100), (txid, n)]
+        chain_height, tip_hash, coins = parse_utxos_batch(
+            getutxos_batch(outpoints), len(outpoints)
+        )
+        assert_equal(chain_height, self.nodes[0].getblockcount())
+        assert_equal(tip_hash, self.nodes[0].getbestblockhash())
+        utxo = self.test_rest_request(f"/getutxos/{txid}-{n}")["utxos"][0]
+        expected = (
+            utxo["height"],
+            int(utxo["value"] * XEC),
+            utxo["scriptPubKey"]["hex"],
+        )
+        assert_equal(coins, [expected, None, None, expected])
+
+        # The mempool is only checked when asked to
+        txid_mempool = self.nodes[0].sendtoaddress(
+            self.nodes[1].getnewaddress(), 100000
+        )
+        spent_mempool = self.test_rest_request(f"/tx/{txid_mempool}")["vin"][0]
+        spent_mempool = (spent_mempool["txid"], spent_mempool["vout"])
+        for checkmempool in (False, True):
+            _, _, coins = parse_utxos_batch(
+                getutxos_batch(
+                    [(txid_mempool, 0), spent_mempool], checkmempool=checkmempool
+                ),
+                2,
+            )
+            assert_equal(
+                [coin is not None for coin in coins], [checkmempool, not checkmempool]
+            )
+        self.generate(self.nodes[0], 1)
+
+        getutxos_batch([], status=400)
+        self.test_rest_request(
+            "/getutxosbatch",
+            http_method="POST",
+            req_type=ReqType.JSON,
+            body="",
+            status=404,
+            ret_type=RetType.OBJ,
+        )
+
         # Do some invalid requests
         self.test_rest_request(
             "/getutxos",
@@ -388,6 +461,55 @@ class RESTTest(BitcoinTestFramework):
         # Now we should have 5 header objects
         assert_equal(len(json_obj), 5)
 
+        self.log.info("Test the /blocks URI")
+
+        def split_sized(data):
+            items = []
+            while data:
+                size = int.from_bytes(data[:4], "little")
+                items.append(data[4 : 4 + size])
+                data = data[4 + size :]
+            return items
+
+        tip_height = self.nodes[0].getblockcount()
+        # The range is clamped to the tip
+        blocks = split_sized(
+            self.test_rest_request(
+                f"/blocks/{tip_height - 2}/10",
+                req_type=ReqType.BIN,
+                ret_type=RetType.BYTES,
+            )
+        )
+        assert_equal(len(blocks), 3)
+        for height, block in enumerate(blocks, tip_height - 2):
+            blockhash = self.nodes[0].getblockhash(height)
+            assert_equal(block.hex(), self.nodes[0].getblock(blockhash, 0))
+
+        # With the undo data, which is empty for the genesis block
+        items = split_sized(
+            self.test_rest_request(
+                "/blocks/undo/0/3", req_type=ReqType.BIN, ret_type=RetType.BYTES
+            )
+        )
+        assert_equal(len(items), 6)
+        for height in range(3):
+            blockhash = self.nodes[0].getblockhash(height)
+            assert_equal(items[2 * height].hex(), self.nodes[0].getblock(blockhash, 0))
+        assert_equal(items[1], b"")
+        # Only the coinbase transactions, so no spent coin
+        assert_equal(items[3], b"\x00")
+        assert_equal(items[5], b"\x00")
+
+        # Check invalid /blocks requests
+        self.test_rest_request(
+            f"/blocks/{tip_height + 1}/1", req_type=ReqType.BIN, status=404
+        )
+        self.test_rest_request("/blocks/0/0", req_type=ReqType.BIN, status=400)
+        self.test_rest_request("/blocks/0/1001", req_type=ReqType.BIN, status=400)
+        self.test_rest_request("/blocks/-1/1", req_type=ReqType.BIN, status=400)
+        self.test_rest_request("/blocks/0", req_type=ReqType.BIN, status=400)
+        self.test_rest_request("/blocks/0/1", status=404)
+
         self.log.info("Test tx inclusion in the /mempool and /block URIs")
 
         # Make 3 tx and mine them on node 1
@@ -433,6 +555,32 @@ class RESTTest(BitcoinTestFramework):
         json_obj = self.test_rest_request("/chaininfo")
         assert_equal(json_obj["bestblockhash"], bb_hash)
 
+        self.log.info("Test the /blocktemplate URI")
+
+        txid = self.nodes[0].sendtoaddress(not_related_address, 1000)
+        template_hex = self.test_rest_request(
+            "/blocktemplate", req_type=ReqType.HEX, ret_type=RetType.BYTES
+        )
+        template_bin = self.test_rest_request(
+            "/blocktemplate", req_type=ReqType.BIN, ret_type=RetType.BYTES
+        )
+        assert_equal(bytes.fromhex(template_hex.decode().strip()), template_bin)
+        # The previous block hash follows the 4 bytes of version
+        assert_equal(template_bin[4:36][::-1].hex(), bb_hash)
+        # The transaction is serialized as in the P2P protocol
+        assert bytes.fromhex(self.nodes[0].getrawtransaction(txid)) in template_bin
+
+        # Same encoding as getblocktemplate, save for the current time
+        rpc_template = bytes.fromhex(
+            self.nodes[0].getblocktemplate({"format": "hex"})
+        )
+        assert_equal(rpc_template[:36], template_bin[:36])
+        assert_equal(rpc_template[40:], template_bin[40:])
+
+        self.test_rest_request(
+            "/blocktemplate", req_type=ReqType.JSON, status=404, ret_type=RetType.OBJ
+        )
+
 
 if __name__ == "__main__":
     RESTTest().main()
@@ -0,0 +1,95 @@
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the RPC server listening on a unix domain socket."""
+
+import http.client
+import json
+import os
+import socket
+import stat
+import tempfile
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, get_auth_cookie, str_to_b64str
+
+
+class UnixHTTPConnection(http.client.HTTPConnection):
+    def __init__(self, path):
+        super().__init__("localhost")
+        self.path = path
+
+    def connect(self):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(self.path)
+
+
+class RPCUnixSocketTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.supports_cli = False
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_platform_not_linux()
+
+    def setup_network(self):
+        # The test datadir is too deep for the 108 bytes of a socket path
+        self.socket_dir = tempfile.mkdtemp()
+        self.socket_path = os.path.join(self.socket_dir, "rpc.sock")
+        self.extra_args = [[f"-rpcunixsocket={self.socket_path}"]]
+        super().setup_network()
+
+    def call(self, headers):
+        conn = UnixHTTPConnection(self.socket_path)
+        conn.request("POST", "/", '{"method": "getblockcount"}', headers)
+        resp = conn.getresponse()
+        body = resp.read()
+        conn.close()
+        return resp.status, body
+
+    def run_test(self):
+        node = self.nodes[0]
+
+        self.log.info("The socket is only accessible to the node's user")
+        mode = os.stat(self.socket_path).st_mode
+        assert stat.S_ISSOCK(mode)
+        assert_equal(stat.S_IMODE(mode), 0o600)
+
+        self.log.info("Authenticated requests are served")
+        user, password = get_auth_cookie(node.datadir, self.chain)
+        headers = {"Authorization": f"Basic {str_to_b64str(f'{user}:{password}')}"}
+        status, body = self.call(headers)
+        assert_equal(status, 200)
+        assert_equal(json.loads(body)["result"], node.getblockcount())
+
+        self.log.info("Requests are authenticated as over TCP")
+        status, _ = self.call({})
+        assert_equal(status, 401)
+        wrong = {"Authorization": f"Basic {str_to_b64str(f'{user}:wrong')}"}
+        status, _ = self.call(wrong)
+        assert_equal(status, 401)
+
+        self.log.info("The socket is removed when the node stops")
+        self.stop_node(0)
+        assert not os.path.exists(self.socket_path)
+
+        self.log.info("A stale socket is replaced on restart")
+        stale = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        stale.bind(self.socket_path)
+        stale.close()
+        self.start_node(0)
+        status, _ = self.call(headers)
+        assert_equal(status, 200)
+
+        self.log.info("Other files are never removed")
+        self.stop_node(0)
+        with open(self.socket_path, "w", encoding="utf8") as f:
+            f.write("not a socket")
+        self.start_node(0)
+        with open(self.socket_path, encoding="utf8") as f:
+            assert_equal(f.read(), "not a socket")
+        os.remove(self.socket_path)
+
+
+if __name__ == "__main__":
+    RPCUnixSocketTest().main()
@@ -33,22 +33,28 @@ class ZMQSubscriber:
         self.sequence = None
         self.socket = socket
         self.topic = topic
+        # bodies of a batch which are not consumed yet
+        self.pending = []
 
         self.socket.setsockopt(zmq.SUBSCRIBE, self.topic)
 
     # Receive message from publisher and verify that topic and sequence match
     def _receive_from_publisher_and_check(self):
-        topic, body, seq = self.socket.recv_multipart()
-        # Topic should match the subscriber topic.
-        assert_equal(topic, self.topic)
-        # Sequence should be incremental.
-        received_seq = struct.unpack("<I", seq)[-1]
-        if self.sequence is None:
-            self.sequence = received_seq
-        else:
-            assert_equal(received_seq, self.sequence)
-        self.sequence += 1
-        return body
+        if not self.pending:
+            # A batch holds several bodies, numbered from the sequence number
+            topic, *bodies, seq = self.socket.recv_multipart()
+            # Topic should match the subscriber topic.
+            assert_equal(topic, self.topic)
+            assert len(bodies) > 0
+            # Sequence should be incremental.
+            received_seq = struct.unpack("<I", seq)[-1]
+            if self.sequence is None:
+                self.sequence = received_seq
+            else:
+                assert_equal(received_seq, self.sequence)
+            self.sequence += len(bodies)
+            self.pending = bodies
+        return self.pending.pop(0)
 
     def receive(self):
         return self._receive_from_publisher_and_check()
@@ -111,6 +117,8 @@ class ZMQTest(BitcoinTestFramework):
             self.test_mempool_sync()
             self.test_reorg()
             self.test_multiple_interfaces()
+            self.test_batch()
+            self.test_block_template()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -118,7 +126,9 @@ class ZMQTest(BitcoinTestFramework):
 
     # Restart node with the specified zmq notifications enabled, subscribe to
     # all of them and return the corresponding ZMQSubscriber objects.
-    def setup_zmq_test(self, services, *, recv_timeout=60, sync_blocks=True):
+    def setup_zmq_test(
+        self, services, *, recv_timeout=60, sync_blocks=True, extra_args=None
+    ):
         subscribers = []
         for topic, address in services:
             socket = self.ctx.socket(zmq.SUB)
@@ -126,7 +136,8 @@ class ZMQTest(BitcoinTestFramework):
 
         self.restart_node(
             0,
-            [f"-zmqpub{topic}={address}" for topic, address in services],
+            [f"-zmqpub{topic}={address}" for topic, address in services]
+            + (extra_args or []),
         )
 
         for i, sub in enumerate(subscribers):
@@ -231,13 +242,19 @@ class ZMQTest(BitcoinTestFramework):
             assert_equal(payment_txid, txid.hex())
 
         self.log.info("Test the getzmqnotifications RPC")
+        notifications = self.nodes[0].getzmqnotifications()
+        for notification in notifications:
+            # All the notifications received above were counted
+            assert notification.pop("sent") > 0
+            assert_equal(notification.pop("dropped"), 0)
+            assert notification.pop("lag") >= 0
         assert_equal(
-            self.nodes[0].getzmqnotifications(),
+            notifications,
             [
-                {"type": "pubhashblock", "address": address, "hwm": 1000},
-                {"type": "pubhashtx", "address": address, "hwm": 1000},
-                {"type": "pubrawblock", "address": address, "hwm": 1000},
-                {"type": "pubrawtx", "address": address, "hwm": 1000},
+                {"type": "pubhashblock", "address": address, "hwm": 1000, "batch": 1},
+                {"type": "pubhashtx", "address": address, "hwm": 1000, "batch": 1},
+                {"type": "pubrawblock", "address": address, "hwm": 1000, "batch": 1},
+                {"type": "pubrawtx", "address": address, "hwm": 1000, "batch": 1},
             ],
         )
 
@@ -701,6 +718,66 @@ class ZMQTest(BitcoinTestFramework):
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[0].receive().hex())
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[1].receive().hex())
 
+    def test_batch(self):
+        self.log.info("Testing the batched notifications")
+        [hashtx, rawtx] = self.setup_zmq_test(
+            [
+                ("hashtx", "tcp://127.0.0.1:28337"),
+                ("rawtx", "tcp://127.0.0.1:28337"),
+            ],
+            sync_blocks=False,
+            extra_args=["-zmqpubhashtxbatch=10", "-zmqpubrawtxbatch=10"],
+        )
+
+        # However they are grouped, all the notifications are received in order
+        num_blocks = 20
+        genhashes = self.generatetoaddress(
+            self.nodes[0], num_blocks, ADDRESS_ECREG_UNSPENDABLE, sync_fun=self.no_op
+        )
+        for blockhash in genhashes:
+            coinbase = self.nodes[0].getblock(blockhash, 2)["tx"][0]
+            assert_equal(hashtx.receive().hex(), coinbase["txid"])
+            assert_equal(rawtx.receive().hex(), coinbase["hex"])
+
+        for notification in self.nodes[0].getzmqnotifications():
+            assert_equal(notification["batch"], 10)
+            assert_equal(notification["dropped"], 0)
+            assert notification["sent"] >= num_blocks
+
+    def test_block_template(self):
+        self.log.info("Testing the block template notifications")
+        address = "tcp://127.0.0.1:28336"
+        socket = self.ctx.socket(zmq.SUB)
+        socket.set(zmq.RCVTIMEO, 60000)
+        subscriber = ZMQSubscriber(socket, b"rawblocktemplate")
+        self.restart_node(
+            0,
+            [
+                f"-zmqpubrawblocktemplate={address}",
+                "-blocktemplaterefresh=100",
+            ],
+        )
+        socket.connect(address)
+
+        def receive_template_on_top_of(prev_hash):
+            # Templates for previous tips may still be in flight, the
+            # subscriber connects asynchronously and can miss the first ones.
+            while True:
+                # The previous block hash follows the 4 bytes of version.
+                body = subscriber.receive()
+                if body[4:36][::-1].hex() == prev_hash:
+                    return body
+
+        for _ in range(2):
+            tip = self.generatetoaddress(
+                self.nodes[0], 1, ADDRESS_ECREG_UNSPENDABLE, sync_fun=self.no_op
+            )[0]
+            template = receive_template_on_top_of(tip)
+            # It matches the template handed out by getblocktemplate
+            gbt = self.nodes[0].getblocktemplate()
+            assert_equal(gbt["previousblockhash"], tip)
+            assert_equal(struct.unpack("<i", template[:4])[0], gbt["version"])
+
 
 if __name__ == "__main__":
     ZMQTest().main()
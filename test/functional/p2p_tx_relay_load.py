@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Generate a transaction relay load and measure how the nodes keep up.
+
+Streams of transactions are sent over P2P to node0 and relayed to node1,
+which announces them to a listening peer. The shapes mimic the mempool
+traffic: independent payments, chains of unconfirmed transactions, a fan-out
+from a single parent, large consolidations and orphans arriving before their
+parents.
+
+For each stream this reports the acceptance throughput of node0, the latency
+from the submission to node0 until the announcement by node1, and the CPU time
+used per transaction. With the default sizes this runs as a quick check that
+all the transactions are accepted and relayed; use --txs to benchmark.
+"""
+
+import os
+import time
+
+from test_framework.blocktools import COINBASE_MATURITY
+from test_framework.messages import MSG_TX, msg_tx
+from test_framework.p2p import P2PInterface, p2p_lock
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+# Satoshis per byte, a bit above the default minimum relay fee
+FEE_PER_BYTE = 300
+# Outputs of a funding transaction
+MAX_FUNDING_OUTPUTS = 500
+CHAIN_LENGTH = 25
+CONSOLIDATION_INPUTS = 100
+# Children of the fan-out parent funded by each of its inputs
+FANOUT_PER_INPUT = 100
+
+
+def estimate_size(num_inputs, num_outputs):
+    # Anyone-can-spend P2SH inputs and outputs
+    return 10 + 43 * num_inputs + 32 * num_outputs
+
+
+def median(values):
+    values = sorted(values)
+    return values[len(values) // 2] if values else 0
+
+
+class TxAnnouncementListener(P2PInterface):
+    """Records when each transaction is first announced."""
+
+    def __init__(self):
+        super().__init__()
+        self.announced = {}
+
+    def on_inv(self, message):
+        now = time.monotonic()
+        for inv in message.inv:
+            if inv.type == MSG_TX:
+                self.announced.setdefault(inv.hash, now)
+
+    def announcement_times(self):
+        with p2p_lock:
+            return dict(self.announced)
+
+
+class TxRelayLoadTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        parser.add_argument(
+            "--txs",
+            dest="txs",
+            type=int,
+            default=100,
+            help="Number of transactions per stream (default: %(default)s)",
+        )
+        parser.add_argument(
+            "--streams",
+            dest="streams",
+            default="independent,chains,fanout,consolidation,orphans",
+            help="Comma separated streams to run (default: %(default)s)",
+        )
+
+    def set_test_params(self):
+        self.num_nodes = 2
+        # Relay without the trickle delays so the latency is the processing
+        # time, and keep the transactions from expiring out of the mempool.
+        self.extra_args = [
+            ["-whitelist=noban@127.0.0.1", "-persistmempool=0"],
+        ] * self.num_nodes
+
+    def setup_network(self):
+        self.setup_nodes()
+        # node0 only sees node1 as an inbound peer, which it relays to
+        # immediately thanks to the whitelist.
+        self.connect_nodes(1, 0)
+
+    def cpu_time(self, node):
+        """The CPU time used by the node process, in seconds, if known."""
+        try:
+            with open(f"/proc/{node.process.pid}/stat", encoding="utf8") as f:
+                fields = f.read().rsplit(")", 1)[1].split()
+        except OSError:
+            return None
+        # utime and stime, the fields 14 and 15 counting from the pid
+        return (int(fields[11]) + int(fields[12])) / os.sysconf("SC_CLK_TCK")
+
+    def tx_handler_cpu_time(self, node):
+        """The CPU time spent processing the tx messages, in microseconds."""
+        process_time = node.getnettotals()["processtime_per_msg"]
+        return process_time.get("tx", {"cputime": 0})["cputime"]
+
+    def fund(self, num_utxos):
+        """Split mature coins into num_utxos confirmed outputs."""
+        num_funding = -(-num_utxos // MAX_FUNDING_OUTPUTS)
+        self.generate(self.wallet, COINBASE_MATURITY + num_funding)
+
+        utxos = []
+        while len(utxos) < num_utxos:
+            num_outputs = min(MAX_FUNDING_OUTPUTS, num_utxos - len(utxos))
+            tx = self.wallet.send_self_transfer_multi(
+                from_node=self.nodes[0],
+                utxos_to_spend=[self.wallet.get_utxo(confirmed_only=True)],
+                num_outputs=num_outputs,
+                fee_per_output=FEE_PER_BYTE * estimate_size(1, num_outputs)
+                // num_outputs
+                + 1,
+            )
+            utxos += tx["new_utxos"]
+        self.generate(self.nodes[0], 1)
+        return utxos
+
+    def create_multi(self, utxos, num_outputs):
+        size = estimate_size(len(utxos), num_outputs)
+        return self.wallet.create_self_transfer_multi(
+            utxos_to_spend=utxos,
+            num_outputs=num_outputs,
+            fee_per_output=FEE_PER_BYTE * size // num_outputs + 1,
+        )
+
+    def independent_stream(self, utxos):
+        return [self.wallet.create_self_transfer(utxo_to_spend=u) for u in utxos]
+
+    def chains_stream(self, utxos):
+        txs = []
+        for u in utxos:
+            txs += self.wallet.create_self_transfer_chain(
+                chain_length=CHAIN_LENGTH, utxo_to_spend=u
+            )
+        return txs
+
+    def fanout_stream(self, utxos):
+        parent = self.create_multi(utxos, self.options.txs - 1)
+        return [parent] + [
+            self.wallet.create_self_transfer(utxo_to_spend=u)
+            for u in parent["new_utxos"]
+        ]
+
+    def consolidation_stream(self, utxos):
+        return [
+            self.create_multi(utxos[i : i + CONSOLIDATION_INPUTS], 1)
+            for i in range(0, len(utxos), CONSOLIDATION_INPUTS)
+        ]
+
+    def orphans_stream(self, utxos):
+        txs = []
+        for u in utxos:
+            parent, child = self.wallet.create_self_transfer_chain(
+                chain_length=2, utxo_to_spend=u
+            )
+            txs += [child, parent]
+        return txs
+
+    def run_stream(self, name, txs):
+        node0, node1 = self.nodes
+        txids = {int(tx["txid"], 16) for tx in txs}
+        assert_equal(len(txids), len(txs))
+        num_inputs = sum(len(tx["tx"].vin) for tx in txs)
+        total_size = sum(len(tx["hex"]) // 2 for tx in txs)
+
+        sender = node0.add_p2p_connection(P2PInterface())
+        listener = node1.add_p2p_connection(TxAnnouncementListener())
+        msgs = [msg_tx(tx["tx"]) for tx in txs]
+        handler_cpu_before = self.tx_handler_cpu_time(node0)
+        cpu_before = [self.cpu_time(node) for node in self.nodes]
+
+        sent = {}
+        start = time.monotonic()
+        for msg, tx in zip(msgs, txs):
+            sender.send_message(msg)
+            sent[int(tx["txid"], 16)] = time.monotonic()
+        self.wait_until(
+            lambda: node0.getmempoolinfo()["size"] == len(txs), timeout=300
+        )
+        accepted = time.monotonic()
+        self.wait_until(
+            lambda: txids <= listener.announcement_times().keys(), timeout=300
+        )
+
+        cpu_after = [self.cpu_time(node) for node in self.nodes]
+        handler_cpu = self.tx_handler_cpu_time(node0) - handler_cpu_before
+        latencies = [
+            t - sent[txid]
+            for txid, t in listener.announcement_times().items()
+            if txid in txids
+        ]
+
+        elapsed = accepted - start
+        self.log.info(
+            f"{name}: {len(txs)} txs, {num_inputs} inputs, {total_size} bytes, "
+            f"accepted in {elapsed:.3f}s ({len(txs) / elapsed:.1f} tx/s, "
+            f"{num_inputs / elapsed:.1f} inputs/s)"
+        )
+        self.log.info(
+            f"{name}: relay latency median {median(latencies) * 1000:.1f}ms, "
+            f"max {max(latencies) * 1000:.1f}ms"
+        )
+        cpu_report = (
+            f"{name}: tx message handling {handler_cpu / len(txs):.0f}us "
+            "cpu/tx on node0"
+        )
+        if None not in cpu_before + cpu_after:
+            for i in range(self.num_nodes):
+                cpu = (cpu_after[i] - cpu_before[i]) * 1e6 / len(txs)
+                cpu_report += f", node{i} process {cpu:.0f}us cpu/tx"
+        self.log.info(cpu_report)
+
+        self.sync_mempools()
+        self.generate(node0, 1)
+        assert_equal(node1.getmempoolinfo()["size"], 0)
+        for node in self.nodes:
+            node.disconnect_p2ps()
+
+    def run_test(self):
+        self.wallet = MiniWallet(self.nodes[0])
+        num_txs = self.options.txs
+        streams = {
+            "independent": (self.independent_stream, num_txs),
+            "chains": (self.chains_stream, -(-num_txs // CHAIN_LENGTH)),
+            "fanout": (self.fanout_stream, -(-num_txs // FANOUT_PER_INPUT)),
+            "consolidation": (
+                self.consolidation_stream,
+                max(1, num_txs // 10) * CONSOLIDATION_INPUTS,
+            ),
+            "orphans": (self.orphans_stream, -(-num_txs // 2)),
+        }
+        selected = self.options.streams.split(",")
+        for name in selected:
+            assert name in streams, f"Unknown stream {name}"
+
+        self.log.info("Fund the streams")
+        funding = self.fund(sum(streams[name][1] for name in selected))
+        for name in selected:
+            make_stream, num_utxos = streams[name]
+            utxos, funding = funding[:num_utxos], funding[num_utxos:]
+            self.log.info(f"Run the {name} stream")
+            self.run_stream(name, make_stream(utxos))
+
+
+if __name__ == "__main__":
+    TxRelayLoadTest().main()
@@ -0,0 +1,149 @@
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Time high-level node operations against a stored baseline.
+
+Measures the initial sync of a generated chain containing auxpow blocks,
+serving getheaders for it, mempool acceptance, a reorg and the latency of a
+few cheap RPCs. See test_framework/perf.py for the baseline handling.
+"""
+
+from test_framework.address import P2SH_OP_TRUE
+from test_framework.blocktools import (
+    VERSION_CHAIN_ID_BITS,
+    create_block,
+    create_coinbase,
+)
+from test_framework.messages import (
+    MERGE_MINE_PREFIX,
+    VERSION_AUXPOW_BIT,
+    CAuxPow,
+    COutPoint,
+    CTxIn,
+    msg_getheaders,
+)
+from test_framework.p2p import P2PInterface
+from test_framework.perf import PerfRecorder, add_perf_options
+from test_framework.script import CScript
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+AUXPOW_BLOCKS = 100
+PLAIN_BLOCKS = 250
+MEMPOOL_TXS = 100
+REORG_DEPTH = 20
+GETHEADERS_REQUESTS = 50
+RPC_CALLS = 200
+
+
+class PerfNodeTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.rpc_timeout = 240
+
+    def add_options(self, parser):
+        add_perf_options(parser)
+
+    def setup_network(self):
+        # The second node is only connected for the initial sync measurement
+        self.setup_nodes()
+
+    def mine_auxpow_block(self, node):
+        tip = node.getblockheader(node.getbestblockhash())
+        coinbase_tx = create_coinbase(tip["height"] + 1)
+        coinbase_tx.vout[0].scriptPubKey = P2SH_OP_TRUE
+        coinbase_tx.rehash()
+        block = create_block(int(tip["hash"], 16), coinbase_tx, tip["time"] + 1)
+        block.nVersion = VERSION_CHAIN_ID_BITS | VERSION_AUXPOW_BIT | 5
+        block.rehash()
+
+        block.auxpow = CAuxPow()
+        coinbase_script = CScript(
+            MERGE_MINE_PREFIX
+            + bytes.fromhex(block.hash)
+            + b"\x01\0\0\0\xff\xff\xff\xff"
+        )
+        block.auxpow.coinbaseTx.vin = [CTxIn(COutPoint(), coinbase_script)]
+        block.auxpow.coinbaseTx.rehash()
+        block.auxpow.parentBlock.hashMerkleRoot = block.auxpow.coinbaseTx.sha256
+        block.solve()
+        assert_equal(node.submitblock(block.serialize().hex()), None)
+
+    def run_test(self):
+        perf = PerfRecorder(self)
+        node = self.nodes[0]
+        wallet = MiniWallet(node)
+
+        self.log.info("Build a chain with auxpow blocks")
+        perf.measure(
+            "mine_auxpow_blocks",
+            lambda: self.mine_auxpow_block(node),
+            count=AUXPOW_BLOCKS,
+        )
+        # Recent plain blocks take the node out of IBD so it serves headers
+        self.generate(wallet, PLAIN_BLOCKS, sync_fun=self.no_op)
+        chain_height = AUXPOW_BLOCKS + PLAIN_BLOCKS
+        assert_equal(node.getblockcount(), chain_height)
+
+        self.log.info("Initial sync of the chain by a second node")
+
+        def sync_second_node():
+            self.connect_nodes(1, 0)
+            self.sync_blocks(timeout=240)
+
+        perf.measure("ibd_sync", sync_second_node)
+        self.disconnect_nodes(1, 0)
+
+        self.log.info("Serve getheaders for the whole chain")
+        peer = node.add_p2p_connection(P2PInterface())
+        request = msg_getheaders()
+        request.locator.vHave = [int(node.getblockhash(0), 16)]
+
+        def get_headers():
+            peer.send_and_ping(request)
+            headers = peer.last_message["headers"].headers
+            assert_equal(len(headers), chain_height)
+
+        perf.measure("getheaders", get_headers, count=GETHEADERS_REQUESTS)
+        headers = peer.last_message["headers"].headers
+        assert all(h.auxpow is not None for h in headers[:AUXPOW_BLOCKS])
+        node.disconnect_p2ps()
+
+        self.log.info("Accept transactions to the mempool")
+        txs = [
+            wallet.create_self_transfer(confirmed_only=True)["hex"]
+            for _ in range(MEMPOOL_TXS)
+        ]
+        txs_iter = iter(txs)
+        perf.measure(
+            "mempool_accept",
+            lambda: node.sendrawtransaction(next(txs_iter)),
+            count=MEMPOOL_TXS,
+        )
+        assert_equal(node.getmempoolinfo()["size"], MEMPOOL_TXS)
+        self.generate(wallet, 1, sync_fun=self.no_op)
+        assert_equal(node.getmempoolinfo()["size"], 0)
+
+        self.log.info(f"Reorg {REORG_DEPTH} blocks")
+        fork_hash = node.getblockhash(node.getblockcount() - REORG_DEPTH + 1)
+        tip_hash = node.getbestblockhash()
+        perf.measure("reorg_disconnect", lambda: node.invalidateblock(fork_hash))
+        perf.measure("reorg_connect", lambda: node.reconsiderblock(fork_hash))
+        assert_equal(node.getbestblockhash(), tip_hash)
+
+        self.log.info("RPC latency")
+        perf.measure("rpc_getblockcount", node.getblockcount, count=RPC_CALLS)
+        perf.measure(
+            "rpc_getblockheader",
+            lambda: node.getblockheader(tip_hash),
+            count=RPC_CALLS,
+        )
+        perf.measure("rpc_getmempoolinfo", node.getmempoolinfo, count=RPC_CALLS)
+
+        perf.finish()
+
+
+if __name__ == "__main__":
+    PerfNodeTest().main()
@@ -1,7 +1,7 @@
 # Copyright (c) 2018 The Bitcoin Core developers
 # Distributed under the MIT software license, see the accompanying
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
-"""Test the getblockfilter RPC."""
+"""Test the getblockfilter and scanblockfilters RPCs."""
 
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
@@ -74,6 +74,50 @@ class GetBlockFilterTest(BitcoinTestFramework):
             "unknown",
         )
 
+        self.log.info("Test scanblockfilters")
+        node = self.nodes[0]
+        coinbase_scripts = [
+            node.getblock(block_hash, 2)["tx"][0]["vout"][0]["scriptPubKey"]["hex"]
+            for block_hash in chain1_hashes[1:]
+        ]
+        result = node.scanblockfilters([coinbase_scripts[-1]])
+        assert_equal(result["from_height"], 0)
+        assert_equal(result["to_height"], 4)
+        expected = [
+            {"height": height, "hash": node.getblockhash(height)}
+            for height in range(1, 5)
+            if coinbase_scripts[height - 1] == coinbase_scripts[-1]
+        ]
+        assert_equal(result["relevant_blocks"], expected)
+
+        range_result = node.scanblockfilters([coinbase_scripts[-1]], 2, 3)
+        assert_equal(range_result["from_height"], 2)
+        assert_equal(range_result["to_height"], 3)
+        assert_equal(
+            range_result["relevant_blocks"],
+            [block for block in expected if 2 <= block["height"] <= 3],
+        )
+
+        unknown_script = "76a914" + "00" * 20 + "88ac"
+        assert_equal(node.scanblockfilters([unknown_script])["relevant_blocks"], [])
+        assert_equal(node.scanblockfilters([])["relevant_blocks"], [])
+
+        assert_raises_rpc_error(
+            -8, "Invalid height range", node.scanblockfilters, [], 3, 2
+        )
+        assert_raises_rpc_error(
+            -8, "Invalid height range", node.scanblockfilters, [], 0, 5
+        )
+        assert_raises_rpc_error(
+            -5, "Unknown filtertype", node.scanblockfilters, [], 0, 4, "unknown"
+        )
+        assert_raises_rpc_error(
+            -1,
+            "Index is not enabled for filtertype basic",
+            self.nodes[1].scanblockfilters,
+            [],
+        )
+
 
 if __name__ == "__main__":
     GetBlockFilterTest().main()
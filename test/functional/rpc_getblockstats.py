@@ -157,13 +157,69 @@ class GetblockstatsTest(BitcoinTestFramework):
                     )
                 assert_equal(result[stat], self.expected_stats[i][stat])
 
+        # The range variant returns the same statistics, column by column
+        range_stats = self.nodes[0].getblockstatsrange(
+            start_height=self.start_height, count=self.max_stat_pos + 1
+        )
+        assert_equal(set(range_stats.keys()), set(expected_keys))
+        for stat in expected_keys:
+            assert_equal(
+                range_stats[stat],
+                [self.expected_stats[i][stat] for i in range(self.max_stat_pos + 1)],
+            )
+
+        # The range stops at the tip, and can be restricted to some statistics
+        range_stats = self.nodes[0].getblockstatsrange(
+            start_height=self.start_height + 1, count=1000, stats=["height", "txs"]
+        )
+        assert_equal(
+            range_stats,
+            {
+                "height": [
+                    self.start_height + i for i in range(1, self.max_stat_pos + 1)
+                ],
+                "txs": [
+                    self.expected_stats[i]["txs"]
+                    for i in range(1, self.max_stat_pos + 1)
+                ],
+            },
+        )
+
+        tip = self.start_height + self.max_stat_pos
+        for count in [0, 10001]:
+            assert_raises_rpc_error(
+                -8,
+                "Block count must be between 1 and 10000",
+                self.nodes[0].getblockstatsrange,
+                start_height=0,
+                count=count,
+            )
+        assert_raises_rpc_error(
+            -8,
+            f"Target block height {tip + 1} after current tip {tip}",
+            self.nodes[0].getblockstatsrange,
+            start_height=tip + 1,
+            count=1,
+        )
+        assert_raises_rpc_error(
+            -8,
+            "Invalid selected statistic asdfghjkl",
+            self.nodes[0].getblockstatsrange,
+            start_height=0,
+            count=10,
+            stats=["minfee", "asdfghjkl"],
+        )
+
+        # The statistics are the same without the cache
+        self.restart_node(0, extra_args=["-blockstatscache=0"])
+        assert_equal(self.get_stats(), self.expected_stats)
+
         # Make sure only the selected statistics are included (more than one)
         some_stats = {"minfee", "maxfee"}
         stats = self.nodes[0].getblockstats(hash_or_height=1, stats=list(some_stats))
         assert_equal(set(stats.keys()), some_stats)
 
         # Test invalid parameters raise the proper json exceptions
-        tip = self.start_height + self.max_stat_pos
         assert_raises_rpc_error(
             -8,
             f"Target block height {tip + 1} after current tip {tip}",
@@ -62,6 +62,46 @@ class RpcMiscTest(BitcoinTestFramework):
             -8, "unknown mode foobar", node.getmemoryinfo, mode="foobar"
         )
 
+        self.log.info("test getperfstats")
+        self.generate(node, 1)
+        stats = node.getperfstats()
+        histograms = {
+            (h["name"], h.get("label")): h for h in stats["histograms"]
+        }
+        for phase in ["check", "connect", "verify", "index"]:
+            h = histograms[("connectblock", f"phase={phase}")]
+            assert_greater_than_or_equal(h["count"], 1)
+            assert_greater_than_or_equal(h["max"], h["p99"])
+            assert_greater_than_or_equal(h["p99"], h["p50"])
+        counters = {(c["name"], c.get("label")): c for c in stats["counters"]}
+        assert_greater_than_or_equal(
+            counters[("connectblock_txs", None)]["value"], 1
+        )
+
+        node.syncwithvalidationinterfacequeue()
+        stats = node.getperfstats()
+        peerman = next(
+            q for q in stats["validationqueues"] if q["subscriber"] == "peerman"
+        )
+        assert_equal(peerman["pending"], 0)
+        assert_greater_than_or_equal(peerman["max_pending"], 1)
+        assert_greater_than_or_equal(peerman["delivered"], 1)
+        histograms = {
+            (h["name"], h.get("label")): h for h in stats["histograms"]
+        }
+        h = histograms[("validationinterface_callback", "subscriber=peerman")]
+        assert_equal(h["count"], peerman["delivered"])
+
+        self.log.info("test lock contention profiling")
+        assert_equal(node.getlockcontention()["enabled"], False)
+        node.setlockcontention(True)
+        assert_equal(node.getlockcontention()["enabled"], True)
+        node.setlockcontention(enable=False, reset=True)
+        assert_equal(node.getlockcontention(), {"enabled": False, "locks": []})
+        assert_raises_rpc_error(
+            -8, "sites must not be negative", node.getlockcontention, -1
+        )
+
         self.log.info("test logging rpc and help")
 
         # Test logging RPC returns the expected number of logging categories.
@@ -100,6 +100,10 @@ class NetTest(BitcoinTestFramework):
             timeout=10,
         )
 
+        def pongs_processed(info):
+            pong = info["processtime_per_msg"].get("pong", {"count": 0})
+            return pong["count"]
+
         for peer_before in peer_info_before:
 
             def peer_after():
@@ -119,6 +123,17 @@ class NetTest(BitcoinTestFramework):
                 >= peer_before["bytessent_per_msg"].get("ping", 0) + 32,
                 timeout=10,
             )
+            self.wait_until(
+                lambda: pongs_processed(peer_after())
+                >= pongs_processed(peer_before) + 1,
+                timeout=10,
+            )
+
+        self.wait_until(
+            lambda: pongs_processed(self.nodes[0].getnettotals())
+            >= pongs_processed(net_totals_before) + len(peer_info_before),
+            timeout=10,
+        )
 
     def test_getnetworkinfo(self):
         self.log.info("Test getnetworkinfo")
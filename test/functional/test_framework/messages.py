@@ -1581,6 +1581,23 @@ class msg_sendaddrv2:
         return "msg_sendaddrv2()"
 
 
+class msg_sendauxhdrs:
+    __slots__ = ()
+    msgtype = b"sendauxhdrs"
+
+    def __init__(self):
+        pass
+
+    def deserialize(self, f):
+        pass
+
+    def serialize(self):
+        return b""
+
+    def __repr__(self):
+        return "msg_sendauxhdrs()"
+
+
 class msg_inv:
     __slots__ = ("inv",)
     msgtype = b"inv"
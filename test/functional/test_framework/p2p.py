@@ -66,6 +66,7 @@ from test_framework.messages import (
     msg_ping,
     msg_pong,
     msg_sendaddrv2,
+    msg_sendauxhdrs,
     msg_sendcmpct,
     msg_sendheaders,
     msg_tcpavaresponse,
@@ -135,6 +136,7 @@ MESSAGEMAP = {
     b"ping": msg_ping,
     b"pong": msg_pong,
     b"sendaddrv2": msg_sendaddrv2,
+    b"sendauxhdrs": msg_sendauxhdrs,
     b"sendcmpct": msg_sendcmpct,
     b"sendheaders": msg_sendheaders,
     b"tx": msg_tx,
@@ -536,6 +538,9 @@ class P2PInterface(P2PConnection):
     def on_sendaddrv2(self, message):
         pass
 
+    def on_sendauxhdrs(self, message):
+        pass
+
     def on_sendcmpct(self, message):
         pass
 
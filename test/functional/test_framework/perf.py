@@ -0,0 +1,123 @@
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Utilities for the perf_ functional tests.
+
+A perf test records the wall clock time of a few high-level node operations
+and compares them with a stored baseline. The tests are not part of the
+default test_runner.py run; use test_runner.py --perf to run them.
+
+Baselines are plain json files mapping a measurement name to a duration in
+seconds. They depend on the machine, so they are not shipped with the tests:
+    test_runner.py --perf --writeperfbaseline --perfbaseline=perf.json
+records a baseline and
+    test_runner.py --perf --perfbaseline=perf.json
+fails any measurement that got slower than the baseline by more than the
+tolerance factor.
+"""
+
+import json
+import os
+import sys
+import time
+
+DEFAULT_PERF_TOLERANCE = 1.5
+
+
+def add_perf_options(parser):
+    """Add the baseline options, to be called from the test add_options()"""
+    parser.add_argument(
+        "--perfbaseline",
+        dest="perfbaseline",
+        default=None,
+        help="json file with the baseline durations to compare against",
+    )
+    parser.add_argument(
+        "--writeperfbaseline",
+        dest="writeperfbaseline",
+        default=False,
+        action="store_true",
+        help="store the measured durations in the --perfbaseline file",
+    )
+    parser.add_argument(
+        "--perftolerance",
+        dest="perftolerance",
+        default=DEFAULT_PERF_TOLERANCE,
+        type=float,
+        help=(
+            "fail a measurement taking more than this factor times its "
+            f"baseline (default: {DEFAULT_PERF_TOLERANCE})"
+        ),
+    )
+
+
+class PerfRecorder:
+    """Times operations for a test and checks them against the baseline."""
+
+    def __init__(self, test):
+        self._test = test
+        self._options = test.options
+        self.results = {}
+
+    def measure(self, name, func, count=1):
+        """Run func count times and record the total duration under name."""
+        start = time.perf_counter()
+        for _ in range(count):
+            func()
+        elapsed = time.perf_counter() - start
+        self.record(name, elapsed, count)
+        return elapsed
+
+    def record(self, name, elapsed, count=1):
+        assert name not in self.results, f"duplicate measurement {name}"
+        self.results[name] = elapsed
+        self._test.log.info(
+            f"perf {name}: {elapsed:.3f}s"
+            + (f" ({elapsed / count * 1000:.3f}ms each)" if count > 1 else "")
+        )
+
+    def finish(self):
+        """Save the results in the test directory and check the baseline"""
+        results_file = os.path.join(self._options.tmpdir, "perf_results.json")
+        with open(results_file, "w", encoding="utf8") as f:
+            json.dump(self.results, f, indent=4, sort_keys=True)
+
+        if self._options.perfbaseline is not None:
+            self._check_baseline(self._options.perfbaseline)
+
+    def _check_baseline(self, path):
+        log = self._test.log
+        # A single baseline file is shared by all the perf tests, entries are
+        # keyed by the test script name.
+        script = os.path.basename(sys.argv[0])
+        baselines = {}
+        if os.path.exists(path):
+            with open(path, encoding="utf8") as f:
+                baselines = json.load(f)
+
+        if self._options.writeperfbaseline:
+            baselines[script] = self.results
+            with open(path, "w", encoding="utf8") as f:
+                json.dump(baselines, f, indent=4, sort_keys=True)
+            log.info(f"Wrote the perf baseline to {path}")
+            return
+
+        baseline = baselines.get(script, {})
+        tolerance = self._options.perftolerance
+        regressions = []
+        for name, elapsed in sorted(self.results.items()):
+            if name not in baseline:
+                log.warning(f"perf {name}: no baseline")
+                continue
+            ratio = elapsed / baseline[name] if baseline[name] > 0 else 1
+            log.info(
+                f"perf {name}: {elapsed:.3f}s vs {baseline[name]:.3f}s "
+                f"baseline ({ratio:.2f}x)"
+            )
+            if ratio > tolerance:
+                regressions.append(name)
+
+        assert not regressions, (
+            f"Performance regression in {', '.join(regressions)} "
+            f"(tolerance {tolerance}x)"
+        )
@@ -290,6 +290,14 @@ def main():
     parser.add_argument(
         "--help", "-h", "-?", action="store_true", help="print help text and exit"
     )
+    parser.add_argument(
+        "--perf",
+        action="store_true",
+        help=(
+            "run the perf_ tests, one at a time, instead of the functional"
+            " tests. They are never part of the default run."
+        ),
+    )
     parser.add_argument(
         "--jobs",
         "-j",
@@ -409,11 +417,18 @@ def main():
 
         # do not cut off explicitly specified tests
         cutoff = sys.maxsize
+    elif args.perf:
+        test_list = [t for t in all_tests if t.startswith("perf_")]
+        cutoff = sys.maxsize
     else:
-        # Run base tests only
-        test_list = all_tests
+        # Run base tests only, the perf tests are timing sensitive and opt-in
+        test_list = [t for t in all_tests if not t.startswith("perf_")]
         cutoff = sys.maxsize if args.extended else args.cutoff
 
+    if args.perf:
+        # Parallel jobs would skew the measurements
+        args.jobs = 1
+
     # Remove the test cases that the user has explicitly asked to exclude.
     if args.exclude:
         exclude_tests = [
@@ -842,7 +857,7 @@ def check_script_prefixes(all_scripts):
     LEEWAY = 0
 
     good_prefixes_re = re.compile(
-        "(abc_)?(example|feature|interface|mempool|mining|p2p|rpc|wallet|tool|chronik|dogecoin)_"
+        "(abc_)?(example|feature|interface|mempool|mining|p2p|rpc|wallet|tool|chronik|dogecoin|perf)_"
     )
     bad_script_names = [
         script for script in all_scripts if good_prefixes_re.match(script) is None
@@ -0,0 +1,70 @@
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test that the rescan of descriptor wallets, which skips the blocks and txs
+not involving the wallet scripts, finds all the wallet txs, including those
+paying to the keys only derived during the rescan."""
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+KEYPOOL_SIZE = 10
+NUM_BLOCKS = 6
+
+
+class WalletFastRescanTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.extra_args = [[f"-keypool={KEYPOOL_SIZE}", "-blockfilterindex=1"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def get_wallet_txids(self, wallet_name):
+        w = self.nodes[0].get_wallet_rpc(wallet_name)
+        return sorted(tx["txid"] for tx in w.listtransactions("*", 1000000))
+
+    def run_test(self):
+        node = self.nodes[0]
+        miniwallet = MiniWallet(node)
+
+        self.log.info("Create a descriptor wallet and back it up")
+        backup_path = os.path.join(node.datadir, "wallet.bak")
+        node.createwallet(wallet_name="topup_test", descriptors=True)
+        w = node.get_wallet_rpc("topup_test")
+        w.backupwallet(backup_path)
+
+        self.log.info("Send to the last key of each keypool top up")
+        for _ in range(NUM_BLOCKS):
+            for _ in range(KEYPOOL_SIZE - 1):
+                w.getnewaddress()
+            spk = bytes.fromhex(w.getaddressinfo(w.getnewaddress())["scriptPubKey"])
+            miniwallet.send_to(from_node=node, scriptPubKey=spk, amount=10000)
+            # A tx not involving the wallet in the same block
+            miniwallet.send_self_transfer(from_node=node)
+            self.generate(node, 1)
+            # And a block not involving the wallet at all
+            miniwallet.send_self_transfer(from_node=node)
+            self.generate(node, 1)
+        txids = self.get_wallet_txids("topup_test")
+        assert_equal(len(txids), NUM_BLOCKS)
+
+        self.log.info("Restore the backup using the block filters")
+        self.wait_until(
+            lambda: node.getindexinfo()["basic block filter index"]["synced"]
+        )
+        with node.assert_debug_log(["(using block filters)"]):
+            node.restorewallet("rescan_fast", backup_path)
+        assert_equal(self.get_wallet_txids("rescan_fast"), txids)
+
+        self.log.info("Restore the backup prefiltering the txs")
+        self.restart_node(0, [f"-keypool={KEYPOOL_SIZE}", "-blockfilterindex=0"])
+        with node.assert_debug_log(["(prefiltering txs)"]):
+            node.restorewallet("rescan_prefilter", backup_path)
+        assert_equal(self.get_wallet_txids("rescan_prefilter"), txids)
+
+
+if __name__ == "__main__":
+    WalletFastRescanTest().main()